@@ -0,0 +1,121 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <chrono>
+#include <benchmark/benchmark.h>
+#include <fc/io/json.hpp>
+#include <evt/chain/execution_context_mock.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/chain/contracts/evt_contract_abi.hpp>
+
+/*
+ * Benchmarks for the serialization of action args by the abi of evt contract
+ */
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+namespace {
+
+const char* tfjson = R"=====(
+{
+  "from": "EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK",
+  "to": "EVT6Qz3wuRjyN6gaU3P3XRxpz5kuZERyH8brHGAHiyKnZz5VPYRjV",
+  "number": "12.00000 S#1",
+  "memo": "test"
+}
+)=====";
+
+const char* nfjson = R"=====(
+{
+  "name": "EVT",
+  "sym_name": "EVT",
+  "sym": "5,S#1",
+  "creator": "EVT6Qz3wuRjyN6gaU3P3XRxpz5kuZERyH8brHGAHiyKnZz5VPYRjV",
+  "issue": {
+    "name": "issue",
+    "threshold": 1,
+    "authorizers": [{
+        "ref": "[A] EVT6Qz3wuRjyN6gaU3P3XRxpz5kuZERyH8brHGAHiyKnZz5VPYRjV",
+        "weight": 1
+      }
+    ]
+  },
+  "transfer": {
+    "name": "transfer",
+    "threshold": 1,
+    "authorizers": [{
+        "ref": "[G] .OWNER",
+        "weight": 1
+      }
+    ]
+  },
+  "manage": {
+    "name": "manage",
+    "threshold": 1,
+    "authorizers": [{
+        "ref": "[A] EVT6Qz3wuRjyN6gaU3P3XRxpz5kuZERyH8brHGAHiyKnZz5VPYRjV",
+        "weight": 1
+      }
+    ]
+  },
+  "total_supply": "100000.00000 S#1"
+}
+)=====";
+
+auto&
+abi_exec_ctx() {
+    static auto exec_ctx = evt_execution_context_mock();
+    return exec_ctx;
+}
+
+auto&
+evt_abi() {
+    static auto abi = abi_serializer(evt_contract_abi(), std::chrono::hours(1));
+    return abi;
+}
+
+// range arg selects the action: 0 for transferft and 1 for newfungible
+auto
+get_action_args(int64_t which) {
+    auto act  = which == 0 ? N(transferft) : N(newfungible);
+    auto json = which == 0 ? tfjson : nfjson;
+    return std::make_pair(abi_exec_ctx().get_acttype_name(act), fc::json::from_string(json));
+}
+
+}  // namespace
+
+static void
+BM_ABI_variant_to_binary(benchmark::State& state) {
+    auto& abi         = evt_abi();
+    auto [type, args] = get_action_args(state.range(0));
+
+    auto bytes = size_t(0);
+    for(auto _ : state) {
+        auto bin = abi.variant_to_binary(type, args, abi_exec_ctx());
+        bytes += bin.size();
+        benchmark::DoNotOptimize(bin);
+    }
+    state.SetLabel(type);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_ABI_variant_to_binary)->DenseRange(0, 1);
+
+static void
+BM_ABI_binary_to_variant(benchmark::State& state) {
+    auto& abi         = evt_abi();
+    auto [type, args] = get_action_args(state.range(0));
+    auto bin          = abi.variant_to_binary(type, args, abi_exec_ctx());
+
+    for(auto _ : state) {
+        auto var = abi.binary_to_variant(type, bin, abi_exec_ctx());
+        benchmark::DoNotOptimize(var);
+    }
+    state.SetLabel(type);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * bin.size());
+}
+BENCHMARK(BM_ABI_binary_to_variant)->DenseRange(0, 1);
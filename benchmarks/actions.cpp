@@ -4,7 +4,11 @@
  */
 
 #include <benchmark/benchmark.h>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <new>
+#include <evt/chain/pool_allocator.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/transaction_context.hpp>
 #include <evt/chain/execution_context_mock.hpp>
@@ -19,6 +23,28 @@
 using namespace evt::chain;
 using namespace evt::chain::contracts;
 
+// counts heap allocations made in this process, used to report allocations per transaction
+static std::atomic<uint64_t> allocs_num;
+
+void*
+operator new(size_t size) {
+    allocs_num.fetch_add(1, std::memory_order_relaxed);
+    if(auto p = malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept {
+    free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
 static std::unique_ptr<evt::testing::tester>
 create_tester() {
     using namespace evt::testing;
@@ -631,6 +657,7 @@ BM_Action_transferft(benchmark::State& state) {
     tf.from   = evt::testing::tester::get_public_key("evt");
     tf.number = asset::from_string(string("0.00001 S#") + std::to_string(nf.sym.id()));
 
+    auto total_allocs = (uint64_t)0;
     for(auto _ : state) {
         state.PauseTiming();
 
@@ -638,7 +665,9 @@ BM_Action_transferft(benchmark::State& state) {
 
         auto tfact    = action(N128(.fungible), (name128)std::to_string(nf.sym.id()), tf);
         auto trx_meta = get_trx_meta(*tester->control, tfact, auths);
-        auto trx_ctx  = get_trx_ctx(*tester->control, trx_meta);
+
+        auto allocs  = allocs_num.load();
+        auto trx_ctx = get_trx_ctx(*tester->control, trx_meta);
 
         trx_ctx.init_for_implicit_trx();
 
@@ -646,11 +675,40 @@ BM_Action_transferft(benchmark::State& state) {
 
         trx_ctx.exec();
         trx_ctx.squash();
+
+        state.PauseTiming();
+        total_allocs += allocs_num.load() - allocs;
+        state.ResumeTiming();
     }
     state.SetItemsProcessed(state.iterations());
+    state.counters["allocs_per_trx"] = benchmark::Counter((double)total_allocs / state.iterations());
 }
 BENCHMARK(BM_Action_transferft);
 
+// allocating of trace for each transaction, plain shared pointer versus the pooled one
+static void
+BM_Trace_make_shared(benchmark::State& state) {
+    for(auto _ : state) {
+        auto trace = std::make_shared<transaction_trace>();
+        trace->action_traces.emplace_back();
+        benchmark::DoNotOptimize(trace);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trace_make_shared);
+
+static void
+BM_Trace_pooled(benchmark::State& state) {
+    auto alloc = pool_allocator<transaction_trace>(std::make_shared<block_pool>(16));
+    for(auto _ : state) {
+        auto trace = std::allocate_shared<transaction_trace>(alloc);
+        trace->action_traces.emplace_back();
+        benchmark::DoNotOptimize(trace);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trace_pooled);
+
 static void
 BM_Action_evt2pevt(benchmark::State& state) {
     auto tester = create_tester();
@@ -1229,3 +1287,32 @@ BM_Action_trx_sig_digest(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 BENCHMARK(BM_Action_trx_sig_digest)->Range(1, 8 << 10);
+
+static void
+BM_Action_ptrx_sig_digest(benchmark::State& state) {
+    auto tester = create_tester();
+
+    auto newdomain_var = fc::json::from_string(ndjson);
+    auto newdom        = newdomain_var.as<newdomain>();
+    newdom.creator     = evt::testing::tester::get_public_key("evt");
+
+    newdom.issue.authorizers[0].ref.set_account(evt::testing::tester::get_public_key("evt"));
+    newdom.manage.authorizers[0].ref.set_account(evt::testing::tester::get_public_key("evt"));
+    newdom.transfer.authorizers[0].ref.set_account(evt::testing::tester::get_public_key("evt"));
+
+    auto trx = signed_transaction();
+    for(int i = 0; i < state.range(0); i++) {
+        newdom.name = get_nonce_name("");
+        trx.actions.push_back(action(newdom.name, N128(.create), newdom));
+    }
+
+    auto ptrx     = packed_transaction(trx);
+    auto chain_id = tester->control->get_chain_id();
+
+    for(auto _ : state) {
+        auto digest = ptrx.sig_digest(chain_id);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Action_ptrx_sig_digest)->Range(1, 8 << 10);
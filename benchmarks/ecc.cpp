@@ -6,6 +6,8 @@
 #include <chrono>
 #include <limits>
 #include <random>
+#include <string>
+#include <vector>
 #include <benchmark/benchmark.h>
 #include <fc/crypto/public_key.hpp>
 #include <fc/crypto/private_key.hpp>
@@ -68,3 +70,44 @@ BM_ECC_VerifySignature(benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 BENCHMARK(BM_ECC_VerifySignature);
+
+static void
+BM_ECC_Recover(benchmark::State& state) {
+    auto pkey   = ecc::private_key::generate();
+    auto pubkey = pkey.get_public_key();
+
+    // signatures are prepared before so threads only measure recovery
+    // keys are recovered by ecc directly, crypto::public_key would hit its recovery cache
+    auto digests = std::vector<sha256>();
+    auto sigs    = std::vector<ecc::compact_signature>();
+    for(auto i = 0; i < 64; i++) {
+        digests.emplace_back(sha256::hash(std::to_string(i)));
+        sigs.emplace_back(pkey.sign_compact(digests.back()));
+    }
+
+    auto i = 0u;
+    for(auto _ : state) {
+        auto pubkey2 = ecc::public_key(sigs[i], digests[i]);
+        auto r = (pubkey2 == pubkey);
+        benchmark::DoNotOptimize(r);
+        i = (i + 1) % sigs.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ECC_Recover)->ThreadRange(1, 8)->UseRealTime();
+
+static void
+BM_ECC_RecoverCached(benchmark::State& state) {
+    auto pkey   = private_key::generate();
+    auto digest = sha256::hash(std::string("cached"));
+    auto sig    = pkey.sign(digest);
+    auto pubkey = public_key(sig, digest);
+
+    for(auto _ : state) {
+        auto pubkey2 = public_key(sig, digest);
+        auto r = (pubkey2 == pubkey);
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ECC_RecoverCached)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,99 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <string.h>
+#include <benchmark/benchmark.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <evt/chain/contracts/base42.hpp>
+#include <evt/chain/contracts/evt_link.hpp>
+
+/*
+ * Benchmarks for the base42 codec of EVT-Link, compared with the former one based on boost::multiprecision
+ */
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+namespace {
+
+namespace bmp = boost::multiprecision;
+
+using bigint_segs = bmp::number<bmp::cpp_int_backend<536, 536, bmp::unsigned_magnitude, bmp::checked, void>>;
+using bigint_sigs = bmp::number<bmp::cpp_int_backend<1560, 1560, bmp::unsigned_magnitude, bmp::checked, void>>;
+
+const char* kAlphabets = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ$+-/:*";
+
+// everiPay link of one signature, segments part and signatures part
+const char* kSegs = "03XBY4E/KTS:PNHVA3JP9QG258F08JHYOYR5SLJGN0EA-C3J6S:2G:T1SX7WA14KH9ETLZ97TUX9R9JJA6+06$E/";
+const char* kSigs = "PYNX-/152P4CTC:WKXLK$/7G-K:89+::2K4C-KZ2**HI-P8CYJ**XGFO1K5:$E*SOY8MFYWMNHP*BHX2U8$$FTFI81YDP1HT";
+
+template<typename T>
+bytes
+decode_bigint(const std::string& nums) {
+    auto num = T{0};
+    auto pz  = nums.find_first_not_of('0');
+    for(auto i = pz; i < nums.size(); i++) {
+        num *= 42;
+        num += (strchr(kAlphabets, nums[i]) - kAlphabets);
+    }
+
+    auto b = bytes(pz, 0);
+    bmp::export_bits(num, std::back_inserter(b), 8);
+    return b;
+}
+
+const std::string&
+link_part(int i) {
+    static const std::string parts[] = { kSegs, kSigs };
+    return parts[i];
+}
+
+}  // namespace
+
+static void
+BM_EvtLink_decode(benchmark::State& state) {
+    auto& str = link_part(state.range(0));
+
+    for(auto _ : state) {
+        auto b = base42_decode(str.data(), str.data() + str.size(), 195);
+        benchmark::DoNotOptimize(b);
+    }
+}
+BENCHMARK(BM_EvtLink_decode)->DenseRange(0, 1);
+
+static void
+BM_EvtLink_decode_bigint(benchmark::State& state) {
+    auto& str = link_part(state.range(0));
+
+    for(auto _ : state) {
+        auto b = state.range(0) == 0 ? decode_bigint<bigint_segs>(str) : decode_bigint<bigint_sigs>(str);
+        benchmark::DoNotOptimize(b);
+    }
+}
+BENCHMARK(BM_EvtLink_decode_bigint)->DenseRange(0, 1);
+
+static void
+BM_EvtLink_encode(benchmark::State& state) {
+    auto& str = link_part(state.range(0));
+    auto  b   = base42_decode(str.data(), str.data() + str.size(), 195);
+
+    for(auto _ : state) {
+        auto s = std::string();
+        base42_encode(b.data(), b.data() + b.size(), s);
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(BM_EvtLink_encode)->DenseRange(0, 1);
+
+static void
+BM_EvtLink_parse(benchmark::State& state) {
+    auto str = std::string(kSegs) + "_" + kSigs;
+
+    for(auto _ : state) {
+        auto link = evt_link::parse_from_evtli(str);
+        benchmark::DoNotOptimize(link);
+    }
+}
+BENCHMARK(BM_EvtLink_parse);
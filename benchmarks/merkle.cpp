@@ -0,0 +1,54 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <boost/asio/thread_pool.hpp>
+#include <benchmark/benchmark.h>
+#include <evt/chain/merkle.hpp>
+
+/*
+ * Benchmarks for the merkle root of transactions in one block
+ */
+
+using namespace evt::chain;
+
+static std::vector<digest_type>
+get_digests(size_t n) {
+    auto dre     = std::default_random_engine(std::chrono::system_clock::now().time_since_epoch().count());
+    auto digests = std::vector<digest_type>();
+    digests.reserve(n);
+
+    for(auto i = 0u; i < n; i++) {
+        digests.emplace_back(digest_type::hash((uint64_t)dre()));
+    }
+    return digests;
+}
+
+static void
+BM_Merkle(benchmark::State& state) {
+    auto digests = get_digests(state.range(0));
+    for(auto _ : state) {
+        auto root = merkle(digests);
+        benchmark::DoNotOptimize(root);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Merkle)->Range(1, 8 << 10);
+
+// second arg is the number of threads in pool
+static void
+BM_Merkle_pool(benchmark::State& state) {
+    auto digests = get_digests(state.range(0));
+    auto pool    = boost::asio::thread_pool(state.range(1));
+    for(auto _ : state) {
+        auto root = merkle(digests, &pool);
+        benchmark::DoNotOptimize(root);
+    }
+    pool.join();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Merkle_pool)->Ranges({{8 << 4, 8 << 10}, {2, 8}})->UseRealTime();
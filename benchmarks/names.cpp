@@ -0,0 +1,58 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <evt/chain/name.hpp>
+#include <evt/chain/name128.hpp>
+
+/*
+ * Benchmarks for the conversions between names and strings
+ */
+
+using namespace evt::chain;
+
+static const char* names128[] = { "evt", "domain-name", "fungible-token-1", "EVERITOKEN-Long-Name1" };
+
+static void
+BM_Name128_FromString(benchmark::State& state) {
+    auto str = std::string(names128[state.range(0)]);
+
+    for(auto _ : state) {
+        auto n = name128(str);
+        benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK(BM_Name128_FromString)->DenseRange(0, 3);
+
+static void
+BM_Name128_ToString(benchmark::State& state) {
+    auto n = name128(names128[state.range(0)]);
+
+    for(auto _ : state) {
+        auto str = n.to_string();
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(BM_Name128_ToString)->DenseRange(0, 3);
+
+static void
+BM_Name_FromString(benchmark::State& state) {
+    for(auto _ : state) {
+        auto n = name("transferft");
+        benchmark::DoNotOptimize(n);
+    }
+}
+BENCHMARK(BM_Name_FromString);
+
+static void
+BM_Name_ToString(benchmark::State& state) {
+    auto n = name("transferft");
+
+    for(auto _ : state) {
+        auto str = n.to_string();
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(BM_Name_ToString);
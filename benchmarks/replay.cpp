@@ -0,0 +1,221 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+#include <evt/chain/block_log.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/genesis_state.hpp>
+#include <evt/chain/snapshot.hpp>
+
+/*
+ * Replays a range of blocks recorded in a real block log through controller and reports
+ * the throughput and the time of each phase as json, so results of releases can be diffed.
+ *
+ * Chain is started from the snapshot taken right before the range, or from genesis of the block log.
+ * Source block log is only read, all the state is written into the work dir.
+ */
+
+using namespace evt::chain;
+namespace bpo = boost::program_options;
+
+namespace {
+
+struct replay_options {
+    fc::path                   blocks_dir;
+    std::optional<fc::path>    snapshot;
+    fc::path                   work_dir;
+    uint32_t                   end_num    = 0;
+    uint32_t                   warmup     = 0;
+    validation_mode            mode       = validation_mode::FULL;
+    std::vector<account_name>  trusted_producers;
+    uint16_t                   threads    = config::default_controller_thread_pool_size;
+    uint64_t                   state_size = config::default_state_size;
+    std::string                label;
+    std::optional<fc::path>    output;
+};
+
+uint64_t
+now_us() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+fc::variant
+run(const replay_options& opts) {
+    if(fc::exists(opts.work_dir)) {
+        fc::remove_all(opts.work_dir);
+    }
+    fc::create_directories(opts.work_dir);
+
+    auto source = block_log(opts.blocks_dir);
+    auto head   = source.read_head();
+    EVT_ASSERT(head, block_log_exception, "Block log in '${d}' is empty", ("d", opts.blocks_dir));
+
+    auto cfg                  = controller::config();
+    cfg.blocks_dir            = opts.work_dir / "blocks";
+    cfg.state_dir             = opts.work_dir / "state";
+    cfg.db_config.db_path     = opts.work_dir / "tokendb";
+    cfg.state_size            = opts.state_size;
+    cfg.thread_pool_size      = opts.threads;
+    cfg.block_validation_mode = opts.mode;
+    cfg.trusted_producers.insert(opts.trusted_producers.cbegin(), opts.trusted_producers.cend());
+
+    auto infile = std::ifstream();
+    auto reader = std::shared_ptr<istream_snapshot_reader>();
+    if(opts.snapshot) {
+        infile.open(opts.snapshot->generic_string(), std::ios::in | std::ios::binary);
+        EVT_ASSERT(infile, snapshot_exception, "Cannot open snapshot '${f}'", ("f", *opts.snapshot));
+        reader = std::make_shared<istream_snapshot_reader>(infile);
+        reader->validate();
+        reader->read_section<genesis_state>([&](auto& section) {
+            section.read_row(cfg.genesis);
+        });
+    }
+    else {
+        cfg.genesis = block_log::extract_genesis_state(opts.blocks_dir);
+    }
+
+    auto chain = controller(cfg);
+    chain.add_indices();
+    chain.startup(reader);
+    infile.close();
+
+    auto start_num = chain.head_block_num() + 1;
+    auto end_num   = opts.end_num ? opts.end_num : head->block_num();
+    EVT_ASSERT(start_num + opts.warmup <= end_num, block_validate_exception,
+        "Nothing to replay, chain starts from ${s} with ${w} warmup blocks but range ends at ${e}", ("s", start_num)("w", opts.warmup)("e", end_num));
+
+    auto timings = controller::phase_timings();
+    auto read_us = uint64_t(0);
+    auto trxs    = uint64_t(0);
+    auto begin   = uint64_t(0);
+
+    for(auto num = start_num; num <= end_num; num++) {
+        if(num == start_num + opts.warmup) {
+            chain.set_phase_timings(&timings);
+            begin = now_us();
+        }
+        auto measured = num >= start_num + opts.warmup;
+
+        auto t = now_us();
+        auto b = source.read_block_by_num(num);
+        EVT_ASSERT(b, block_log_exception, "Block ${n} is not found in block log", ("n", num));
+        if(measured) {
+            read_us += now_us() - t;
+            trxs    += b->transactions.size();
+        }
+
+        chain.push_block(b);
+    }
+    auto elapsed = now_us() - begin;
+    chain.set_phase_timings(nullptr);
+
+    auto blocks = end_num - start_num - opts.warmup + 1;
+    auto secs   = std::max(elapsed, uint64_t(1)) / 1'000'000.0;
+    auto phases = read_us + timings.unpack_us + timings.recover_us + timings.auth_us + timings.apply_us
+                + timings.finalize_us + timings.commit_us + timings.tokendb_commit_us;
+
+    auto mode = (opts.mode == validation_mode::FULL) ? "full" : "light";
+    return fc::mutable_variant_object()
+        ("label", opts.label)
+        ("start_block", start_num + opts.warmup)
+        ("end_block", end_num)
+        ("validation_mode", mode)
+        ("threads", opts.threads)
+        ("blocks", blocks)
+        ("trxs", trxs)
+        ("elapsed_ms", elapsed / 1000)
+        ("blocks_per_sec", (uint64_t)(blocks / secs))
+        ("trxs_per_sec", (uint64_t)(trxs / secs))
+        ("phases_us", fc::mutable_variant_object()
+            ("read", read_us)
+            ("unpack", timings.unpack_us)
+            ("recover", timings.recover_us)
+            ("auth", timings.auth_us)
+            ("apply", timings.apply_us)
+            ("finalize", timings.finalize_us)
+            ("commit", timings.commit_us)
+            ("tokendb_commit", timings.tokendb_commit_us)
+            ("other", elapsed > phases ? elapsed - phases : 0)
+        );
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    auto opts  = replay_options();
+    auto desc  = bpo::options_description("Options");
+    auto mode  = std::string();
+    auto trust = std::vector<std::string>();
+
+    desc.add_options()
+        ("help,h", "Print this help message and exit")
+        ("blocks-dir", bpo::value<std::string>()->required(), "Directory of the recorded block log")
+        ("snapshot", bpo::value<std::string>(), "Snapshot taken right before the first block to replay, chain starts from genesis without it")
+        ("end-block", bpo::value<uint32_t>(&opts.end_num)->default_value(0), "Last block to replay, 0 for the head of block log")
+        ("warmup-blocks", bpo::value<uint32_t>(&opts.warmup)->default_value(0), "Blocks replayed at first and not measured")
+        ("validation-mode", bpo::value<std::string>(&mode)->default_value("full"), "Block validation mode, 'full' or 'light'")
+        ("trusted-producer", bpo::value<std::vector<std::string>>(&trust)->composing(), "Producer whose blocks are trusted in 'light' mode")
+        ("threads", bpo::value<uint16_t>(&opts.threads)->default_value(config::default_controller_thread_pool_size), "Number of threads of controller thread pool")
+        ("state-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024 * 1024)), "Size of chain state in MiB")
+        ("work-dir", bpo::value<std::string>()->default_value("/tmp/evt_replay_bench"), "Directory for the state of replaying, it's cleared at first")
+        ("label", bpo::value<std::string>(&opts.label)->default_value(""), "Label written into results, like the version being measured")
+        ("output", bpo::value<std::string>(), "File to write results into, stdout is used without it")
+        ;
+
+    try {
+        auto vm = bpo::variables_map();
+        bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+        if(vm.count("help")) {
+            std::cout << desc << std::endl;
+            return 0;
+        }
+        bpo::notify(vm);
+
+        EVT_ASSERT(mode == "full" || mode == "light", plugin_config_exception, "Not valid validation mode: ${m}", ("m", mode));
+        opts.mode       = (mode == "full") ? validation_mode::FULL : validation_mode::LIGHT;
+        opts.blocks_dir = vm.at("blocks-dir").as<std::string>();
+        opts.work_dir   = vm.at("work-dir").as<std::string>();
+        opts.state_size = vm.at("state-size-mb").as<uint64_t>() * 1024 * 1024;
+        if(vm.count("snapshot")) {
+            opts.snapshot = fc::path(vm.at("snapshot").as<std::string>());
+        }
+        if(vm.count("output")) {
+            opts.output = fc::path(vm.at("output").as<std::string>());
+        }
+        for(auto& p : trust) {
+            opts.trusted_producers.emplace_back(p);
+        }
+
+        fc::logger::get().set_log_level(fc::log_level(fc::log_level::warn));
+
+        auto results = fc::json::to_pretty_string(run(opts));
+        if(opts.output) {
+            auto f = std::ofstream(opts.output->generic_string());
+            f << results << std::endl;
+        }
+        else {
+            std::cout << results << std::endl;
+        }
+    }
+    catch(const bpo::error& e) {
+        std::cerr << e.what() << "\n\n" << desc << std::endl;
+        return 1;
+    }
+    catch(const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <random>
+#include <chrono>
+#include <limits>
+#include <benchmark/benchmark.h>
+#include <openssl/ripemd.h>
+#include <fc/crypto/ripemd160.hpp>
+
+/*
+ * Benchmarks for ripemd160 of short inputs, same sizes as checksums of keys (33 + 2 bytes of prefix)
+ * and of addresses (28 bytes)
+ */
+
+static std::string
+make_buf(size_t size) {
+    auto buf = std::string();
+
+    auto dre  = std::default_random_engine(std::chrono::system_clock::now().time_since_epoch().count());
+    auto dist = std::uniform_int_distribution<int>(0, std::numeric_limits<char>::max());
+
+    for(auto i = 0u; i < size; i++) {
+        buf.push_back((char)dist(dre));
+    }
+    return buf;
+}
+
+static void
+BM_RIPEMD160_FC(benchmark::State& state) {
+    auto buf = make_buf(state.range(0));
+    for(auto _ : state) {
+        auto h = fc::ripemd160::hash(buf.data(), buf.size());
+        benchmark::DoNotOptimize(h);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RIPEMD160_FC)->Arg(28)->Arg(35)->Arg(256);
+
+static void
+BM_RIPEMD160_OPENSSL(benchmark::State& state) {
+    auto buf = make_buf(state.range(0));
+    for(auto _ : state) {
+        unsigned char h[RIPEMD160_DIGEST_LENGTH];
+        RIPEMD160((const unsigned char*)buf.data(), buf.size(), h);
+        benchmark::DoNotOptimize(h);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RIPEMD160_OPENSSL)->Arg(28)->Arg(35)->Arg(256);
@@ -0,0 +1,372 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/transaction_context.hpp>
+#include <evt/chain/execution_context_mock.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+
+/*
+ * Benchmarks for actions and queries on top of large states, to see how they degrade as state grows.
+ * Tokens and fungible balances are populated through the sst ingestion path before the chain is started.
+ *
+ * Scales are set by `EVT_BENCH_STATE_ROWS` as a comma separated list and default to 1M rows,
+ * e.g. EVT_BENCH_STATE_ROWS=1000000,10000000,100000000. Each scale is populated once and shared by all the
+ * benchmarks of it, larger ones need tens of GBs disk space and take long to populate.
+ */
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+using evt::testing::tester;
+
+namespace {
+
+// only the profiles which support ingestion, memory profile doesn't
+const storage_profile kScaleProfiles[] = { storage_profile::disk, storage_profile::hybrid };
+const char*           kScaleProfileNames[] = { "disk", "memory", "hybrid" };
+
+constexpr auto kStateSymbolId = (symbol_id_type)8888;
+constexpr auto kGetTokensTake = 10;
+
+std::vector<int64_t>
+state_rows() {
+    auto env = getenv("EVT_BENCH_STATE_ROWS");
+    if(env == nullptr) {
+        return { 1'000'000 };
+    }
+
+    auto list  = std::string(env);
+    auto parts = std::vector<std::string>();
+    boost::split(parts, list, boost::is_any_of(","));
+
+    auto rows = std::vector<int64_t>();
+    for(auto& p : parts) {
+        boost::trim(p);
+        if(!p.empty()) {
+            rows.emplace_back(std::stoll(p));
+        }
+    }
+    return rows;
+}
+
+address
+make_addr(int64_t i) {
+    // generated ones are too slow for hundreds of millions, so generic addresses are used
+    return address(N(bench), name128::from_number(i), 0);
+}
+
+permission_def
+make_permission(const char* name, const authorizer_ref& ref) {
+    auto p      = permission_def();
+    p.name      = name;
+    p.threshold = 1;
+    p.authorizers.emplace_back(ref, 1);
+    return p;
+}
+
+// chain started on top of populated token database, kept until the benchmarks of another scale run
+class scaled_state {
+public:
+    static scaled_state&
+    get(storage_profile profile, int64_t rows) {
+        static auto s = scaled_state();
+        if(!s.tester_ || s.profile_ != profile || s.rows_ != rows) {
+            s.tester_.reset();
+            s.profile_ = profile;
+            s.rows_    = rows;
+            s.start();
+        }
+        return s;
+    }
+
+public:
+    controller& control() { return *tester_->control; }
+    int64_t     rows() const { return rows_; }
+    int64_t     next_token() { return rows_ + issued_++; }
+
+private:
+    void
+    start() {
+        fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+        auto dir = fc::path("/tmp/evt_benchmarks_state");
+        if(fc::exists(dir)) {
+            fc::remove_all(dir);
+        }
+        fc::create_directories(dir);
+
+        auto cfg = controller::config();
+
+        cfg.blocks_dir            = dir / "blocks";
+        cfg.state_dir             = dir / "state";
+        cfg.db_config.db_path     = dir / "tokendb";
+        cfg.db_config.profile     = profile_;
+        cfg.state_size            = 1024 * 1024 * 8;
+        cfg.reversible_cache_size = 1024 * 1024 * 8;
+        cfg.contracts_console     = false;
+        cfg.charge_free_mode      = true;
+        cfg.loadtest_mode         = true;
+
+        cfg.genesis.initial_timestamp = fc::time_point::from_iso_string("2020-01-01T00:00:00.000");
+        cfg.genesis.initial_key       = tester::get_public_key("evt");
+
+        populate(cfg.db_config);
+
+        tester_ = std::make_unique<tester>(cfg);
+        tester_->block_signing_private_keys.insert(std::make_pair(cfg.genesis.initial_key, tester::get_private_key("evt")));
+
+        // domain and fungible of the populated rows, they're not ingested so that chain creates them as usual
+        auto key   = tester::get_public_key("evt");
+        auto auths = std::vector<name>{ N(evt) };
+        auto owner = authorizer_ref();
+        auto acc   = authorizer_ref();
+        owner.set_owner();
+        acc.set_account(key);
+
+        auto nd     = newdomain();
+        nd.name     = N128(bench);
+        nd.creator  = key;
+        nd.issue    = make_permission("issue", acc);
+        nd.transfer = make_permission("transfer", owner);
+        nd.manage   = make_permission("manage", acc);
+        tester_->push_action(action(nd.name, N128(.create), nd), auths, address());
+
+        auto sym        = symbol(5, kStateSymbolId);
+        auto nf         = newfungible();
+        nf.name         = "BENCH";
+        nf.sym_name     = "BENCH";
+        nf.sym          = sym;
+        nf.creator      = key;
+        nf.issue        = make_permission("issue", acc);
+        nf.manage       = make_permission("manage", acc);
+        nf.total_supply = asset(asset::max_amount, sym);
+        tester_->push_action(action(N128(.fungible), name128::from_number(sym.id()), nf), auths, address());
+
+        auto isf    = issuefungible();
+        isf.address = address(key);
+        isf.number  = asset(asset::max_amount / 2, sym);
+        tester_->push_action(action(N128(.fungible), name128::from_number(sym.id()), isf), auths, address());
+
+        tester_->produce_block();
+        issued_ = 0;
+    }
+
+    // `rows_` tokens owned by evt in domain `bench` and the same number of balances of the bench symbol
+    void
+    populate(const token_database::config& db_config) {
+        auto db = token_database(db_config);
+        db.open();
+
+        auto key     = tester::get_public_key("evt");
+        auto balance = make_db_value(asset(100'000, symbol(5, kStateSymbolId)));
+        auto ingest  = db.new_ingester();
+        for(auto i = (int64_t)0; i < rows_; i++) {
+            auto name  = name128::from_number(i);
+            auto token = make_db_value(token_def(N128(bench), name, { address(key) }));
+            ingest->put_token(token_type::token, N128(bench), name, token.as_string_view());
+            ingest->put_asset(make_addr(i), kStateSymbolId, balance.as_string_view());
+        }
+        ingest->finish();
+        ingest.reset();
+
+        db.close(false);
+    }
+
+private:
+    storage_profile         profile_ = storage_profile::disk;
+    int64_t                 rows_    = 0;
+    int64_t                 issued_  = 0;
+    std::unique_ptr<tester> tester_;
+};
+
+auto&
+get_exec_ctx() {
+    static auto exec_ctx = evt_execution_context_mock();
+    return exec_ctx;
+}
+
+transaction_metadata_ptr
+get_trx_meta(controller& control, const action& act) {
+    auto signed_trx = signed_transaction();
+    signed_trx.actions.emplace_back(act);
+    signed_trx.sign(tester::get_private_key(N(evt)), control.get_chain_id());
+
+    return std::make_shared<transaction_metadata>(signed_trx);
+}
+
+// latencies of each operation in microseconds, reported as p50 and p99 counters
+class latency_recorder {
+public:
+    latency_recorder(benchmark::State& state)
+        : state_(state) {
+        samples_.reserve(std::min<int64_t>(state.max_iterations, 1 << 20));
+    }
+
+    template<typename Func>
+    void
+    record(Func&& func) {
+        auto begin = std::chrono::steady_clock::now();
+        func();
+        samples_.emplace_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+
+    void
+    report() {
+        if(samples_.empty()) {
+            return;
+        }
+        state_.counters["p50_us"] = percentile(0.50);
+        state_.counters["p99_us"] = percentile(0.99);
+    }
+
+private:
+    double
+    percentile(double p) {
+        auto n = (size_t)(p * (samples_.size() - 1));
+        std::nth_element(samples_.begin(), samples_.begin() + n, samples_.end());
+        return samples_[n];
+    }
+
+private:
+    benchmark::State&   state_;
+    std::vector<double> samples_;
+};
+
+// runs the action of each iteration in its own transaction on top of the pending block
+template<typename MakeAction>
+void
+run_action(benchmark::State& state, scaled_state& s, MakeAction&& make_action) {
+    auto latency = latency_recorder(state);
+    for(auto _ : state) {
+        state.PauseTiming();
+
+        auto trx_meta = get_trx_meta(s.control(), make_action());
+        auto trx_ctx  = transaction_context(s.control(), get_exec_ctx(), trx_meta);
+
+        trx_ctx.init_for_implicit_trx();
+
+        state.ResumeTiming();
+
+        latency.record([&] {
+            trx_ctx.exec();
+            trx_ctx.squash();
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report();
+}
+
+void
+BM_State_transferft(benchmark::State& state, storage_profile profile, int64_t rows) {
+    auto& s   = scaled_state::get(profile, rows);
+    auto  rnd = std::mt19937_64(42);
+
+    auto tf   = transferft();
+    tf.from   = tester::get_public_key("evt");
+    tf.number = asset(1, symbol(5, kStateSymbolId));
+
+    // credits to the existing balances spread over the whole state
+    run_action(state, s, [&] {
+        tf.to = make_addr(rnd() % s.rows());
+        return action(N128(.fungible), name128::from_number(kStateSymbolId), tf);
+    });
+}
+
+void
+BM_State_issuetoken(benchmark::State& state, storage_profile profile, int64_t rows) {
+    auto& s = scaled_state::get(profile, rows);
+
+    auto it   = issuetoken();
+    it.domain = N128(bench);
+    it.owner  = { address(tester::get_public_key("evt")) };
+
+    // new tokens are inserted after the populated ones
+    run_action(state, s, [&] {
+        it.names.clear();
+        it.names.emplace_back(name128::from_number(s.next_token()));
+        return action(it.domain, N128(.issue), it);
+    });
+}
+
+void
+BM_State_transfer(benchmark::State& state, storage_profile profile, int64_t rows) {
+    auto& s   = scaled_state::get(profile, rows);
+    auto  rnd = std::mt19937_64(42);
+
+    auto tt   = transfer();
+    tt.domain = N128(bench);
+    tt.to     = { address(tester::get_public_key("evt")) };
+
+    run_action(state, s, [&] {
+        tt.name = name128::from_number(rnd() % s.rows());
+        return action(tt.domain, tt.name, tt);
+    });
+}
+
+// same as `get_tokens` of evt_plugin: one page of tokens from a random offset of domain, converted into variants
+void
+BM_State_get_tokens(benchmark::State& state, storage_profile profile, int64_t rows) {
+    auto& s   = scaled_state::get(profile, rows);
+    auto& db  = s.control().token_db();
+    auto  rnd = std::mt19937_64(42);
+
+    auto latency = latency_recorder(state);
+    for(auto _ : state) {
+        auto skip = (int)(rnd() % (uint64_t)std::min<int64_t>(s.rows() - kGetTokensTake, std::numeric_limits<int>::max()));
+        latency.record([&] {
+            auto vars = fc::variants();
+            auto n    = 0;
+            db.read_tokens_range(token_type::token, N128(bench), skip, [&](auto& key, auto&& value) {
+                auto token = token_def();
+                extract_db_value(value, token);
+
+                auto var = fc::variant();
+                fc::to_variant(token, var);
+                vars.emplace_back(std::move(var));
+                return ++n < kGetTokensTake;
+            });
+            benchmark::DoNotOptimize(vars);
+        });
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report();
+}
+
+// registered scale by scale, so each populated state is shared by all the benchmarks of it
+int
+register_state_benchmarks() {
+    using bench_func = void (*)(benchmark::State&, storage_profile, int64_t);
+
+    const std::pair<const char*, bench_func> benches[] = {
+        { "BM_State_transferft", &BM_State_transferft },
+        { "BM_State_issuetoken", &BM_State_issuetoken },
+        { "BM_State_transfer", &BM_State_transfer },
+        { "BM_State_get_tokens", &BM_State_get_tokens }
+    };
+
+    for(auto rows : state_rows()) {
+        for(auto profile : kScaleProfiles) {
+            for(auto& b : benches) {
+                auto name = std::string(b.first) + "/" + kScaleProfileNames[(int)profile] + "/" + std::to_string(rows);
+                benchmark::RegisterBenchmark(name.c_str(), b.second, profile, rows)->Unit(benchmark::kMicrosecond);
+            }
+        }
+    }
+    return 0;
+}
+
+auto registered = register_state_benchmarks();
+
+}  // namespace
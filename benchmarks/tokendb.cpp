@@ -0,0 +1,454 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <evt/chain/arena.hpp>
+#include <evt/chain/asset.hpp>
+#include <evt/chain/snapshot.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_cache.hpp>
+#include <evt/chain/token_database_snapshot.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+
+/*
+ * Benchmarks for token database: allocations of savepoint data, reads and writes of
+ * tokens and assets on each storage profile, cache, savepoints and snapshots
+ */
+
+using namespace evt::chain;
+using namespace evt::chain::contracts;
+
+struct record_key {
+    name128 prefix;
+    name128 key;
+};
+
+// baseline: one malloc for each action record, all freed when savepoint is popped
+static void
+BM_Savepoint_malloc(benchmark::State& state) {
+    auto records = std::vector<void*>();
+    records.reserve(state.range(0));
+
+    for(auto _ : state) {
+        for(int i = 0; i < state.range(0); i++) {
+            auto r = (record_key*)malloc(sizeof(record_key));
+            r->key = name128::from_number(i);
+            records.emplace_back(r);
+        }
+        for(auto r : records) {
+            free(r);
+        }
+        records.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Savepoint_malloc)->Range(8, 8 << 10);
+
+// records allocated from one pooled arena, released at once
+static void
+BM_Savepoint_arena(benchmark::State& state) {
+    auto pool = arena_pool(4);
+
+    for(auto _ : state) {
+        auto mem = pool.acquire();
+        for(int i = 0; i < state.range(0); i++) {
+            auto r = mem->create<record_key>();
+            r->key = name128::from_number(i);
+            benchmark::DoNotOptimize(r);
+        }
+        pool.release(mem);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Savepoint_arena)->Range(8, 8 << 10);
+
+// full cycle of one block: add savepoint, write tokens and assets, then persist it
+static void
+BM_Savepoint_tokendb(benchmark::State& state) {
+    fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+    auto dir = fc::path("/tmp/evt_benchmarks_tokendb");
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto addr  = evt::testing::tester::get_public_key(N(bench));
+    auto value = make_db_value(asset::from_string("1.00000 S#1"));
+    auto seq   = (int64_t)0;
+
+    for(auto _ : state) {
+        tokendb.add_savepoint(++seq);
+        for(int i = 0; i < state.range(0); i++) {
+            tokendb.put_token(token_type::token, action_op::put, N128(bench), name128::from_number(i), value.as_string_view());
+            tokendb.put_asset(addr, i, value.as_string_view());
+            tokendb.put_asset(addr, i, value.as_string_view());
+        }
+        tokendb.pop_savepoints(seq + 1);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    tokendb.close(false);
+}
+BENCHMARK(BM_Savepoint_tokendb)->Range(8, 2 << 10);
+
+namespace {
+
+// profile is passed as the first argument of benchmarks
+const char* kProfileNames[] = { "disk", "memory", "hybrid" };
+
+// rows put in database before the read benchmarks
+constexpr int kPopulatedRows = 64 << 10;
+
+std::unique_ptr<token_database>
+open_db(storage_profile profile, size_t cache_size = 0) {
+    fc::logger::get().set_log_level(fc::log_level(fc::log_level::error));
+
+    auto dir = fc::path("/tmp/evt_benchmarks_tokendb") / kProfileNames[(int)profile];
+    if(fc::exists(dir)) {
+        fc::remove_all(dir);
+    }
+    fc::create_directories(dir);
+
+    auto cfg    = token_database::config();
+    cfg.db_path = dir;
+    cfg.profile = profile;
+    if(cache_size > 0) {
+        cfg.object_cache_size = cache_size;
+    }
+
+    auto db = std::make_unique<token_database>(cfg);
+    db->open();
+    return db;
+}
+
+db_value
+make_token(int i) {
+    auto addr = evt::testing::tester::get_public_key(N(bench));
+    return make_db_value(token_def(N128(bench), name128::from_number(i), { addr }));
+}
+
+address
+make_addr(int i) {
+    // generated ones are different in each run, so generic addresses are used
+    return address(N(bench), name128::from_number(i), 0);
+}
+
+// puts `n` tokens in domain `bench` and `n` assets of symbol 1, then commits them
+void
+populate(token_database& db, int n) {
+    auto value = make_db_value(asset::from_string("1.00000 S#1"));
+
+    // it's called on the databases without savepoints
+    db.add_savepoint(1);
+    for(int i = 0; i < n; i++) {
+        db.put_token(token_type::token, action_op::add, N128(bench), name128::from_number(i), make_token(i).as_string_view());
+        db.put_asset(make_addr(i), 1, value.as_string_view());
+    }
+    db.pop_savepoints(2);
+}
+
+void
+set_label(benchmark::State& state) {
+    state.SetLabel(kProfileNames[state.range(0)]);
+}
+
+// all the profiles with the second argument ranged
+void
+profiles_args(benchmark::internal::Benchmark* b, std::initializer_list<int> args) {
+    for(auto p = 0; p < 3; p++) {
+        for(auto a : args) {
+            b->Args({ p, a });
+        }
+    }
+}
+
+}  // namespace
+
+static void
+BM_TokenDB_put_token(benchmark::State& state) {
+    auto db  = open_db((storage_profile)state.range(0));
+    auto seq = (int64_t)0;
+    auto n   = (int)state.range(1);
+
+    auto values = std::vector<db_value>();
+    for(int i = 0; i < n; i++) {
+        values.emplace_back(make_token(i));
+    }
+
+    for(auto _ : state) {
+        db->add_savepoint(++seq);
+        for(int i = 0; i < n; i++) {
+            db->put_token(token_type::token, action_op::put, N128(bench), name128::from_number(i), values[i].as_string_view());
+        }
+        db->pop_savepoints(seq + 1);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_put_token)->Apply([](auto b) { profiles_args(b, { 64, 1 << 10 }); });
+
+static void
+BM_TokenDB_read_token(benchmark::State& state) {
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto rnd = std::mt19937(42);
+    auto out = std::string();
+    for(auto _ : state) {
+        auto i = (int)(rnd() % kPopulatedRows);
+        db->read_token(token_type::token, N128(bench), name128::from_number(i), out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_read_token)->DenseRange(0, 2);
+
+// half of the keys looked up don't exist
+static void
+BM_TokenDB_exists_token(benchmark::State& state) {
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto rnd = std::mt19937(42);
+    for(auto _ : state) {
+        auto i = (int)(rnd() % (kPopulatedRows * 2));
+        benchmark::DoNotOptimize(db->exists_token(token_type::token, N128(bench), name128::from_number(i)));
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_exists_token)->DenseRange(0, 2);
+
+// scans `range(1)` rows from random offsets of domain
+static void
+BM_TokenDB_read_tokens_range(benchmark::State& state) {
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto rnd  = std::mt19937(42);
+    auto rows = (int)state.range(1);
+    for(auto _ : state) {
+        auto skip = (int)(rnd() % (kPopulatedRows - rows));
+        auto n    = 0;
+        db->read_tokens_range(token_type::token, N128(bench), skip, [&](auto& key, auto&& value) {
+            benchmark::DoNotOptimize(value);
+            return ++n < rows;
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_read_tokens_range)->Apply([](auto b) { profiles_args(b, { 16, 256 }); });
+
+static void
+BM_TokenDB_put_asset(benchmark::State& state) {
+    auto db  = open_db((storage_profile)state.range(0));
+    auto seq = (int64_t)0;
+    auto n   = (int)state.range(1);
+
+    auto value = make_db_value(asset::from_string("1.00000 S#1"));
+    auto addrs = std::vector<address>();
+    for(int i = 0; i < n; i++) {
+        addrs.emplace_back(make_addr(i));
+    }
+
+    for(auto _ : state) {
+        db->add_savepoint(++seq);
+        for(int i = 0; i < n; i++) {
+            db->put_asset(addrs[i], 1, value.as_string_view());
+        }
+        db->pop_savepoints(seq + 1);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_put_asset)->Apply([](auto b) { profiles_args(b, { 64, 1 << 10 }); });
+
+static void
+BM_TokenDB_read_asset(benchmark::State& state) {
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto addrs = std::vector<address>();
+    for(int i = 0; i < kPopulatedRows; i++) {
+        addrs.emplace_back(make_addr(i));
+    }
+
+    auto rnd = std::mt19937(42);
+    auto out = std::string();
+    for(auto _ : state) {
+        db->read_asset(addrs[rnd() % kPopulatedRows], 1, out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_read_asset)->DenseRange(0, 2);
+
+// reads through token_database_cache, `range(1)` percent of the reads go to a hot set which fits in cache
+// and the others go to the cold keys evicting each other, actual ratio is reported in `hit_ratio`
+static void
+BM_TokenDB_cache_read(benchmark::State& state) {
+    constexpr int kHotKeys = 1 << 10;
+
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto cache = token_database_cache(*db, make_token(0).size() * kHotKeys * 5 / 4);
+    auto rnd   = std::mt19937(42);
+    auto pct   = (uint32_t)state.range(1);
+
+    auto hits = uint64_t(0), misses = uint64_t(0);
+    auto read_counters = [&] {
+        auto  v = db->metrics()->to_variant();
+        auto& c = v["types"]["token"];
+        hits    = c["cache_hits"].as_uint64();
+        misses  = c["cache_misses"].as_uint64();
+    };
+    read_counters();
+    auto hits0 = hits, misses0 = misses;
+
+    for(auto _ : state) {
+        auto i = (rnd() % 100 < pct) ? (int)(rnd() % kHotKeys) : (int)(kHotKeys + rnd() % (kPopulatedRows - kHotKeys));
+        benchmark::DoNotOptimize(cache.read_token<token_def>(token_type::token, N128(bench), name128::from_number(i)));
+    }
+    state.SetItemsProcessed(state.iterations());
+    set_label(state);
+
+    read_counters();
+    auto total = (hits - hits0) + (misses - misses0);
+    state.counters["hit_ratio"] = total ? (double)(hits - hits0) / total : 0;
+}
+BENCHMARK(BM_TokenDB_cache_read)->Apply([](auto b) { profiles_args(b, { 0, 50, 90, 99, 100 }); });
+
+// keeps `range(1)` savepoints outstanding like reversible blocks, one is added and the oldest one is popped each time
+static void
+BM_TokenDB_savepoint_pop(benchmark::State& state) {
+    auto db    = open_db(storage_profile::disk);
+    auto depth = (int)state.range(0);
+    auto value = make_token(0);
+    auto seq   = (int64_t)0;
+
+    for(auto _ : state) {
+        db->add_savepoint(++seq);
+        for(int i = 0; i < 64; i++) {
+            db->put_token(token_type::token, action_op::put, N128(bench), name128::from_number(i), value.as_string_view());
+        }
+        if(seq > depth) {
+            db->pop_savepoints(seq - depth + 1);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_savepoint_pop)->Arg(1)->Arg(16)->Arg(256);
+
+// squashes trx savepoints into the block one on top of `range(0)` outstanding ones
+static void
+BM_TokenDB_savepoint_squash(benchmark::State& state) {
+    auto db    = open_db(storage_profile::disk);
+    auto depth = (int)state.range(0);
+    auto value = make_token(0);
+    auto seq   = (int64_t)0;
+
+    for(int i = 0; i < depth; i++) {
+        db->add_savepoint(++seq);
+    }
+    for(auto _ : state) {
+        db->add_savepoint(++seq);
+        for(int i = 0; i < 64; i++) {
+            db->put_token(token_type::token, action_op::put, N128(bench), name128::from_number(i), value.as_string_view());
+        }
+        db->squash();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_savepoint_squash)->Arg(1)->Arg(16)->Arg(256);
+
+// rolls back one savepoint of 64 writes on top of `range(0)` outstanding ones
+static void
+BM_TokenDB_savepoint_rollback(benchmark::State& state) {
+    auto db    = open_db(storage_profile::disk);
+    auto depth = (int)state.range(0);
+    auto value = make_token(0);
+    auto seq   = (int64_t)0;
+
+    populate(*db, 64);
+    for(int i = 0; i < depth; i++) {
+        db->add_savepoint(++seq);
+    }
+    for(auto _ : state) {
+        db->add_savepoint(++seq);
+        for(int i = 0; i < 64; i++) {
+            db->put_token(token_type::token, action_op::put, N128(bench), name128::from_number(i), value.as_string_view());
+        }
+        db->rollback_to_latest_savepoint();
+        seq--;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TokenDB_savepoint_rollback)->Arg(1)->Arg(16)->Arg(256);
+
+static void
+BM_TokenDB_snapshot_write(benchmark::State& state) {
+    auto db = open_db((storage_profile)state.range(0));
+    populate(*db, kPopulatedRows);
+
+    auto bytes = int64_t(0);
+    for(auto _ : state) {
+        auto ss = std::stringstream();
+        auto writer = std::make_shared<ostream_snapshot_writer>(ss);
+        token_database_snapshot::add_to_snapshot(writer, *db);
+        writer->finalize();
+        bytes += ss.tellp();
+    }
+    state.SetItemsProcessed(state.iterations() * kPopulatedRows * 2);
+    state.SetBytesProcessed(bytes);
+    set_label(state);
+}
+BENCHMARK(BM_TokenDB_snapshot_write)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// ingesting is only measured in disk profile, memory profile doesn't support it
+static void
+BM_TokenDB_snapshot_read(benchmark::State& state) {
+    auto profile = (storage_profile)state.range(0);
+    auto ingest  = state.range(1) != 0 && profile != storage_profile::memory;
+
+    auto data = std::string();
+    {
+        auto db = open_db(profile);
+        populate(*db, kPopulatedRows);
+
+        auto ss = std::stringstream();
+        auto writer = std::make_shared<ostream_snapshot_writer>(ss);
+        token_database_snapshot::add_to_snapshot(writer, *db);
+        writer->finalize();
+        data = ss.str();
+    }
+
+    auto db = open_db(profile);
+    for(auto _ : state) {
+        auto ss     = std::stringstream(data);
+        auto reader = std::make_shared<istream_snapshot_reader>(ss);
+        token_database_snapshot::read_from_snapshot(reader, *db, ingest);
+    }
+    state.SetItemsProcessed(state.iterations() * kPopulatedRows * 2);
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.SetLabel(std::string(kProfileNames[state.range(0)]) + (ingest ? "/ingest" : ""));
+}
+BENCHMARK(BM_TokenDB_snapshot_read)->Apply([](auto b) { profiles_args(b, { 0, 1 }); })->Unit(benchmark::kMillisecond);
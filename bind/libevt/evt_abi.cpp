@@ -10,6 +10,10 @@
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
 
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
 #include <evt/chain/execution_context_mock.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
@@ -44,25 +48,87 @@ extract_data<bytes>(evt_data_t* data, bytes& val) {
     return EVT_OK; 
 } 
 
+// only read after created, so it's safe to be used by multiple threads
 struct abi_context {
     std::unique_ptr<abi_serializer>             abi;
     std::unique_ptr<evt_execution_context_mock> exec_ctx;
+    bool                                        shared = false;
 };
 
-extern "C" {
+namespace internal {
 
-void*
-evt_abi() {
+abi_context*
+new_abi_context() {
     auto abic      = new abi_context();
     abic->abi      = std::make_unique<abi_serializer>(evt::chain::contracts::evt_contract_abi(), std::chrono::hours(1));
     abic->exec_ctx = std::make_unique<evt_execution_context_mock>();
 
+    return abic;
+}
+
+// packs the json of action into `ds`
+int
+pack_action_json(const abi_context& abic, const char* action, const char* json, fc::datastream<char*>& ds) {
+    auto type = abic.exec_ctx->get_acttype_name(action);
+    if(type.empty()) {
+        return EVT_INVALID_ACTION;
+    }
+
+    auto doc = ::rapidjson::Document();
+    doc.Parse(json);
+    if(doc.HasParseError() || !doc.IsObject()) {
+        return EVT_INVALID_JSON;
+    }
+    try {
+        abic.abi->json_to_binary(type, doc, ds, *abic.exec_ctx);
+    }
+    catch(fc::out_of_range_exception&) {
+        return EVT_BUFFER_TOO_SMALL;
+    }
+    CATCH_AND_RETURN(EVT_INTERNAL_ERROR)
+
+    return EVT_OK;
+}
+
+// size of the binary of action when the buffer provided is too small, action is packed again into temporary buffer
+int
+packed_action_size(const abi_context& abic, const char* action, const char* json, size_t& sz) {
+    thread_local auto temp = bytes(1024 * 1024);
+
+    auto ds = fc::datastream<char*>(temp.data(), temp.size());
+    auto r  = pack_action_json(abic, action, json, ds);
+    if(r == EVT_OK) {
+        sz = ds.tellp();
+    }
+    return r;
+}
+
+}  // namespace internal
+
+extern "C" {
+
+void*
+evt_abi() {
+    return (void*)internal::new_abi_context();
+}
+
+void*
+evt_abi_shared() {
+    static auto abic = [] {
+        auto abic    = internal::new_abi_context();
+        abic->shared = true;
+        return abic;
+    }();
     return (void*)abic;
 }
 
 void
 evt_free_abi(void* abi) {
-    delete (abi_context*)abi;
+    auto abic = (abi_context*)abi;
+    if(abic != nullptr && abic->shared) {
+        return;
+    }
+    delete abic;
 }
 
 int
@@ -139,6 +205,127 @@ evt_abi_bin_to_json(void* evt_abi, const char* action, evt_bin_t* bin, char** js
     return EVT_OK;
 }
 
+int
+evt_abi_json_to_bin_buf(void* evt_abi, const char* action, const char* json, char* buf, size_t* sz /* in-out */) {
+    if(evt_abi == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(action == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(json == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(sz == nullptr || (buf == nullptr && *sz > 0)) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    auto& abic = *(abi_context*)evt_abi;
+    auto  ds   = fc::datastream<char*>(buf, *sz);
+
+    auto r = internal::pack_action_json(abic, action, json, ds);
+    if(r == EVT_BUFFER_TOO_SMALL) {
+        auto nsz = size_t(0);
+        if((r = internal::packed_action_size(abic, action, json, nsz)) != EVT_OK) {
+            return r;
+        }
+        *sz = nsz;
+        return EVT_BUFFER_TOO_SMALL;
+    }
+    if(r == EVT_OK) {
+        *sz = ds.tellp();
+    }
+    return r;
+}
+
+int
+evt_abi_bin_to_json_buf(void* evt_abi, const char* action, const char* bin, size_t bin_sz, char* json, size_t* sz /* in-out */) {
+    if(evt_abi == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(action == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(bin == nullptr || bin_sz == 0) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(sz == nullptr || (json == nullptr && *sz > 0)) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    auto& abic = *(abi_context*)evt_abi;
+    auto  type = abic.exec_ctx->get_acttype_name(action);
+    if(type.empty()) {
+        return EVT_INVALID_ACTION;
+    }
+
+    thread_local auto buffer = ::rapidjson::StringBuffer();
+    buffer.Clear();
+    try {
+        auto writer = abi_serializer::json_writer(buffer);
+        auto ds     = fc::datastream<const char*>(bin, bin_sz);
+        abic.abi->binary_to_json(type, ds, writer, *abic.exec_ctx);
+        if(ds.remaining() > 0) {
+            return EVT_INVALID_BINARY;
+        }
+    }
+    CATCH_AND_RETURN(EVT_INVALID_BINARY)
+
+    auto nsz = buffer.GetSize() + 1;  // add '\0'
+    if(nsz > *sz) {
+        *sz = nsz;
+        return EVT_BUFFER_TOO_SMALL;
+    }
+    memcpy(json, buffer.GetString(), buffer.GetSize());
+    json[buffer.GetSize()] = '\0';
+    *sz = nsz;
+
+    return EVT_OK;
+}
+
+int
+evt_abi_json_to_bin_batch(void* evt_abi, size_t n, const char** actions, const char** jsons, char* buf, size_t* sz /* in-out */, size_t* offsets /* out */) {
+    if(evt_abi == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(actions == nullptr || jsons == nullptr || offsets == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(sz == nullptr || (buf == nullptr && *sz > 0)) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    for(auto i = 0u; i < n; i++) {
+        if(actions[i] == nullptr || jsons[i] == nullptr) {
+            return EVT_INVALID_ARGUMENT;
+        }
+    }
+    auto& abic = *(abi_context*)evt_abi;
+    auto  ds   = fc::datastream<char*>(buf, *sz);
+
+    offsets[0] = 0;
+    for(auto i = 0u; i < n; i++) {
+        auto r = internal::pack_action_json(abic, actions[i], jsons[i], ds);
+        if(r == EVT_BUFFER_TOO_SMALL) {
+            // the rest are only measured to know the total size needed
+            auto total = offsets[i];
+            for(auto j = i; j < n; j++) {
+                auto asz = size_t(0);
+                if((r = internal::packed_action_size(abic, actions[j], jsons[j], asz)) != EVT_OK) {
+                    return r;
+                }
+                total += asz;
+            }
+            *sz = total;
+            return EVT_BUFFER_TOO_SMALL;
+        }
+        if(r != EVT_OK) {
+            return r;
+        }
+        offsets[i + 1] = ds.tellp();
+    }
+    *sz = offsets[n];
+
+    return EVT_OK;
+}
+
 int
 evt_trx_json_to_digest(void* evt_abi, const char* json,  evt_chain_id_t* chain_id, evt_checksum_t** digest /* out */) {
     if(evt_abi == nullptr) {
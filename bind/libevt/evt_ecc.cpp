@@ -7,7 +7,13 @@
 #include "evt_impl.hpp"
 
 #include <string.h>
+#include <algorithm>
+#include <future>
 #include <limits>
+#include <thread>
+#include <vector>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <fc/crypto/private_key.hpp>
 #include <fc/crypto/public_key.hpp>
 #include <fc/crypto/signature.hpp>
@@ -18,6 +24,47 @@ using fc::crypto::private_key;
 using fc::crypto::public_key;
 using fc::crypto::signature;
 
+namespace internal {
+
+// items handled by each task of the pool
+constexpr size_t kItemsPerTask = 32;
+
+boost::asio::thread_pool&
+ecc_pool() {
+    static auto pool = boost::asio::thread_pool(std::max(std::thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+// calls `fn(i)` for all i in [0, n), splits them into the tasks of pool when there are enough items
+template <typename Fn>
+void
+parallel_for(size_t n, Fn&& fn) {
+    auto run = [&fn](size_t begin, size_t end) {
+        for(auto i = begin; i < end; i++) {
+            fn(i);
+        }
+    };
+    if(n < 2 * kItemsPerTask) {
+        run(0, n);
+        return;
+    }
+
+    auto tasks = std::vector<std::future<void>>();
+    for(auto i = kItemsPerTask; i < n; i += kItemsPerTask) {
+        auto task = std::packaged_task<void()>([&run, i, n] {
+            run(i, std::min(i + kItemsPerTask, n));
+        });
+        tasks.emplace_back(task.get_future());
+        boost::asio::post(ecc_pool(), std::move(task));
+    }
+    run(0, kItemsPerTask);
+    for(auto& t : tasks) {
+        t.get();
+    }
+}
+
+}  // namespace internal
+
 extern "C" {
 
 int
@@ -41,6 +88,27 @@ evt_generate_new_pair(evt_public_key_t** pub_key /* out */, evt_private_key_t**
     return EVT_OK;
 }
 
+int
+evt_generate_new_pairs(size_t n, evt_public_key_t** pub_keys /* out */, evt_private_key_t** priv_keys /* out */) {
+    if(pub_keys == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(priv_keys == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+
+    try {
+        auto keys = private_key::generate_batch(n);
+        for(auto i = 0u; i < n; i++) {
+            pub_keys[i]  = get_evt_data(keys[i].second);
+            priv_keys[i] = get_evt_data(keys[i].first);
+        }
+    }
+    CATCH_AND_RETURN(EVT_INTERNAL_ERROR)
+
+    return EVT_OK;
+}
+
 int
 evt_get_public_key(evt_private_key_t* priv_key, evt_public_key_t** pub_key /* out */) {
     if(priv_key == nullptr) {
@@ -138,6 +206,92 @@ evt_hash(const char* buf, size_t sz, evt_checksum_t** hash /* out */) {
     return EVT_OK;
 }
 
+int
+evt_sign_hashes(size_t n, evt_private_key_t** priv_keys, evt_checksum_t** hashes, evt_signature_t** signs /* out */) {
+    if(priv_keys == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(hashes == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(signs == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+
+    auto results = std::vector<int>(n);
+    internal::parallel_for(n, [&](size_t i) {
+        signs[i]   = nullptr;
+        results[i] = evt_sign_hash(priv_keys[i], hashes[i], &signs[i]);
+    });
+
+    auto it = std::find_if(results.cbegin(), results.cend(), [](auto r) { return r != EVT_OK; });
+    if(it != results.cend()) {
+        for(auto i = 0u; i < n; i++) {
+            if(signs[i] != nullptr) {
+                evt_free(signs[i]);
+                signs[i] = nullptr;
+            }
+        }
+        return *it;
+    }
+    return EVT_OK;
+}
+
+int
+evt_recover_many(size_t n, evt_signature_t** signs, evt_checksum_t** hashes, evt_public_key_t** pub_keys /* out */, int* results /* out */) {
+    if(signs == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(hashes == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(pub_keys == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+
+    auto rs = std::vector<int>(n);
+    internal::parallel_for(n, [&](size_t i) {
+        pub_keys[i] = nullptr;
+        rs[i]       = evt_recover(signs[i], hashes[i], &pub_keys[i]);
+    });
+
+    if(results != nullptr) {
+        std::copy(rs.cbegin(), rs.cend(), results);
+    }
+    auto it = std::find_if(rs.cbegin(), rs.cend(), [](auto r) { return r != EVT_OK; });
+    return it != rs.cend() ? *it : EVT_OK;
+}
+
+int
+evt_hash_many(size_t n, const char** bufs, const size_t* sizes, evt_checksum_t** hashes /* out */) {
+    if(bufs == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(sizes == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    if(hashes == nullptr) {
+        return EVT_INVALID_ARGUMENT;
+    }
+    for(auto i = 0u; i < n; i++) {
+        if(bufs[i] == nullptr || sizes[i] == 0 || sizes[i] >= std::numeric_limits<uint32_t>::max()) {
+            return EVT_INVALID_ARGUMENT;
+        }
+    }
+
+    try {
+        auto sz = std::vector<uint32_t>(sizes, sizes + n);
+        auto hs = std::vector<sha256>(n);
+        sha256::hash_many(bufs, sz.data(), n, hs.data());
+        for(auto i = 0u; i < n; i++) {
+            hashes[i] = get_evt_data(hs[i]);
+        }
+    }
+    CATCH_AND_RETURN(EVT_INTERNAL_ERROR)
+
+    return EVT_OK;
+}
+
 int
 evt_public_key_string(evt_public_key_t* pub_key, char** str /* out */) {
     if(pub_key == nullptr) {
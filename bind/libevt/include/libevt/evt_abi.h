@@ -15,11 +15,25 @@ typedef evt_data_t evt_bin_t;
 typedef evt_data_t evt_chain_id_t;
 typedef evt_data_t evt_block_id_t;
 
+// abi handles are thread-safe and can be shared by threads
 void* evt_abi();
+// process-wide abi created once, `evt_free_abi` doesn't free it
+void* evt_abi_shared();
 void  evt_free_abi(void* abi);
 
 int evt_abi_json_to_bin(void* evt_abi, const char* action, const char* json, evt_bin_t** bin /* out */);
 int evt_abi_bin_to_json(void* evt_abi, const char* action, evt_bin_t* bin, char** json /* out */);
+
+// conversions into the buffers provided by caller, nothing needs to be freed
+// `sz` is the capacity of `buf` as input and the size written as output
+// returns EVT_BUFFER_TOO_SMALL with the size needed in `sz` if `buf` is too small
+int evt_abi_json_to_bin_buf(void* evt_abi, const char* action, const char* json, char* buf, size_t* sz /* in-out */);
+// json is terminated by '\0', which is counted in `sz`
+int evt_abi_bin_to_json_buf(void* evt_abi, const char* action, const char* bin, size_t bin_sz, char* json, size_t* sz /* in-out */);
+// converts `n` actions in one call, binaries are written one by one into `buf`,
+// binary of i-th action is in [offsets[i], offsets[i + 1]) and `offsets` has n + 1 elements
+int evt_abi_json_to_bin_batch(void* evt_abi, size_t n, const char** actions, const char** jsons, char* buf, size_t* sz /* in-out */, size_t* offsets /* out */);
+
 int evt_trx_json_to_digest(void* evt_abi, const char* json, evt_chain_id_t* chain_id, evt_checksum_t** digest /* out */);
 int evt_chain_id_from_string(const char* str, evt_chain_id_t** chain_id /* out */);
 int evt_block_id_from_string(const char* str, evt_block_id_t** block_id /* out */);
@@ -15,11 +15,21 @@ typedef evt_data_t evt_signature_t;
 typedef evt_data_t evt_checksum_t;
 
 int evt_generate_new_pair(evt_public_key_t** pub_key /* out */, evt_private_key_t** priv_key /* out */);
+// fills n pairs into the arrays, keys generated together are related and should only be used by one owner
+int evt_generate_new_pairs(size_t n, evt_public_key_t** pub_keys /* out */, evt_private_key_t** priv_keys /* out */);
 int evt_get_public_key(evt_private_key_t* priv_key, evt_public_key_t** pub_key /* out */);
 int evt_sign_hash(evt_private_key_t* priv_key, evt_checksum_t* hash, evt_signature_t** sign /* out */);
 int evt_recover(evt_signature_t* sign, evt_checksum_t* hash, evt_public_key_t** pub_key /* out */);
 int evt_hash(const char* buf, size_t sz, evt_checksum_t** hash /* out */);
 
+// batch operations running on the internal thread pool, i-th output is of i-th inputs
+// signs[i] is the signature of hashes[i] by priv_keys[i], no signature is left if any of them fails
+int evt_sign_hashes(size_t n, evt_private_key_t** priv_keys, evt_checksum_t** hashes, evt_signature_t** signs /* out */);
+// failed items are left as null and their error codes are set in `results` if provided,
+// returns the error code of the first failed item
+int evt_recover_many(size_t n, evt_signature_t** signs, evt_checksum_t** hashes, evt_public_key_t** pub_keys /* out */, int* results /* out */);
+int evt_hash_many(size_t n, const char** bufs, const size_t* sizes, evt_checksum_t** hashes /* out */);
+
 int evt_public_key_string(evt_public_key_t* pub_key, char** str /* out */);
 int evt_private_key_string(evt_private_key_t* priv_key, char** str /* out */);
 int evt_signature_string(evt_signature_t* sign, char** str /* out */);
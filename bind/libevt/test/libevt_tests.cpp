@@ -208,6 +208,92 @@ TEST_CASE("evtecc") {
     evt_free(pubkey3);
 }
 
+TEST_CASE("evtecc_pairs") {
+    const size_t n = 5;
+
+    evt_public_key_t*  pubkeys[n]  = {};
+    evt_private_key_t* privkeys[n] = {};
+    auto r1 = evt_generate_new_pairs(n, pubkeys, privkeys);
+    REQUIRE(r1 == EVT_OK);
+
+    for(auto i = 0u; i < n; i++) {
+        REQUIRE(pubkeys[i] != nullptr);
+        REQUIRE(privkeys[i] != nullptr);
+
+        evt_public_key_t* pubkey = nullptr;
+        auto r2 = evt_get_public_key(privkeys[i], &pubkey);
+        REQUIRE(r2 == EVT_OK);
+        CHECK(evt_equals(pubkeys[i], pubkey) == EVT_OK);
+        if(i > 0) {
+            CHECK(evt_equals(privkeys[i - 1], privkeys[i]) != EVT_OK);
+        }
+
+        evt_free(pubkey);
+    }
+
+    for(auto i = 0u; i < n; i++) {
+        evt_free(pubkeys[i]);
+        evt_free(privkeys[i]);
+    }
+}
+
+TEST_CASE("evtecc_batch") {
+    const size_t n = 100;
+
+    evt_public_key_t*  pubkeys[n]  = {};
+    evt_private_key_t* privkeys[n] = {};
+    REQUIRE(evt_generate_new_pairs(n, pubkeys, privkeys) == EVT_OK);
+
+    const char* bufs[n];
+    size_t      sizes[n];
+    for(auto i = 0u; i < n; i++) {
+        bufs[i]  = (const char*)privkeys[i]->buf;
+        sizes[i] = privkeys[i]->sz;
+    }
+
+    evt_checksum_t* hashes[n] = {};
+    REQUIRE(evt_hash_many(n, bufs, sizes, hashes) == EVT_OK);
+    for(auto i = 0u; i < n; i++) {
+        evt_checksum_t* hash = nullptr;
+        REQUIRE(evt_hash(bufs[i], sizes[i], &hash) == EVT_OK);
+        CHECK(evt_equals(hashes[i], hash) == EVT_OK);
+        evt_free(hash);
+    }
+
+    evt_signature_t* signs[n] = {};
+    REQUIRE(evt_sign_hashes(n, privkeys, hashes, signs) == EVT_OK);
+
+    evt_public_key_t* recovered[n] = {};
+    int               results[n]   = {};
+    REQUIRE(evt_recover_many(n, signs, hashes, recovered, results) == EVT_OK);
+    for(auto i = 0u; i < n; i++) {
+        CHECK(results[i] == EVT_OK);
+        REQUIRE(recovered[i] != nullptr);
+        CHECK(evt_equals(pubkeys[i], recovered[i]) == EVT_OK);
+        evt_free(recovered[i]);
+    }
+
+    // one invalid signature doesn't fail the others
+    auto invalid = signs[1];
+    signs[1] = hashes[1];
+    CHECK(evt_recover_many(n, signs, hashes, recovered, results) == EVT_INVALID_SIGNATURE);
+    CHECK(results[1] == EVT_INVALID_SIGNATURE);
+    CHECK(recovered[1] == nullptr);
+    CHECK(results[0] == EVT_OK);
+    CHECK(evt_equals(pubkeys[0], recovered[0]) == EVT_OK);
+    signs[1] = invalid;
+
+    for(auto i = 0u; i < n; i++) {
+        evt_free(pubkeys[i]);
+        evt_free(privkeys[i]);
+        evt_free(hashes[i]);
+        evt_free(signs[i]);
+        if(recovered[i] != nullptr) {
+            evt_free(recovered[i]);
+        }
+    }
+}
+
 TEST_CASE("evtabi") {
     auto abi = evt_abi();
     REQUIRE(abi != nullptr);
@@ -269,6 +355,47 @@ TEST_CASE("evtabi") {
     CHECK(j1restore[sz] == '\0');
     CHECK(j1restore[sz-1] == '}');
 
+    // into the buffers provided
+    char   buf[1024];
+    size_t bsz = 16;
+    auto   r12 = evt_abi_json_to_bin_buf(abi, "newdomain", j1, buf, &bsz);
+    REQUIRE(r12 == EVT_BUFFER_TOO_SMALL);
+    REQUIRE(bsz == bin->sz);
+
+    bsz = sizeof(buf);
+    auto r13 = evt_abi_json_to_bin_buf(abi, "newdomain", j1, buf, &bsz);
+    REQUIRE(r13 == EVT_OK);
+    REQUIRE(bsz == bin->sz);
+    CHECK(memcmp(buf, bin->buf, bsz) == 0);
+
+    char   jbuf[4096];
+    size_t jsz = sizeof(jbuf);
+    auto   r14 = evt_abi_bin_to_json_buf(abi, "newdomain", buf, bsz, jbuf, &jsz);
+    REQUIRE(r14 == EVT_OK);
+    CHECK(jsz == sz + 1);
+    CHECK(strcmp(jbuf, j1restore) == 0);
+
+    const char* actions[] = { "newdomain", "newdomain" };
+    const char* jsons[]   = { j1, j1 };
+    size_t      offsets[3];
+    bsz = bin->sz;
+    auto r15 = evt_abi_json_to_bin_batch(abi, 2, actions, jsons, buf, &bsz, offsets);
+    REQUIRE(r15 == EVT_BUFFER_TOO_SMALL);
+    REQUIRE(bsz == bin->sz * 2);
+
+    bsz = sizeof(buf);
+    auto r16 = evt_abi_json_to_bin_batch(abi, 2, actions, jsons, buf, &bsz, offsets);
+    REQUIRE(r16 == EVT_OK);
+    REQUIRE(bsz == bin->sz * 2);
+    CHECK(offsets[1] == bin->sz);
+    CHECK(memcmp(buf + offsets[1], bin->buf, bin->sz) == 0);
+
+    auto shared = evt_abi_shared();
+    REQUIRE(shared == evt_abi_shared());
+    evt_free_abi(shared);
+    bsz = sizeof(buf);
+    REQUIRE(evt_abi_json_to_bin_buf(shared, "newdomain", j1, buf, &bsz) == EVT_OK);
+
     auto j2 = R"(
     {
         "expiration": "2018-05-20T12:25:51",
@@ -1,6 +1,19 @@
+import threading
+
 from . import evt_exception, libevt
 from .evt_data import EvtData
 
+# buffers reused by the conversions of each thread, grown when too small
+_buffers = threading.local()
+
+
+def _buffer(evt, name, sz):
+    buf = getattr(_buffers, name, None)
+    if buf is None or len(buf) < sz:
+        buf = evt.ffi.new('char[]', max(sz, 4096))
+        setattr(_buffers, name, buf)
+    return buf
+
 
 def version():
     return libevt.init_lib()
@@ -31,6 +44,59 @@ def bin_to_json(action, bin):
     return json
 
 
+def json_to_bin_bytes(action, json):
+    evt = libevt.check_lib_init()
+    action_c = bytes(action, encoding='utf-8')
+    json_c = bytes(json, encoding='utf-8')
+    sz_c = evt.ffi.new('size_t*')
+    while True:
+        buf = _buffer(evt, 'bin', sz_c[0])
+        sz_c[0] = len(buf)
+        ret = evt.lib.evt_abi_json_to_bin_buf(
+            evt.abi, action_c, json_c, buf, sz_c)
+        if ret != evt_exception.EVTErrCode.EVT_BUFFER_TOO_SMALL:
+            break
+    evt_exception.evt_exception_raiser(ret)
+    return bytes(evt.ffi.buffer(buf, sz_c[0]))
+
+
+def bin_bytes_to_json(action, bin):
+    evt = libevt.check_lib_init()
+    action_c = bytes(action, encoding='utf-8')
+    sz_c = evt.ffi.new('size_t*')
+    while True:
+        buf = _buffer(evt, 'json', sz_c[0])
+        sz_c[0] = len(buf)
+        ret = evt.lib.evt_abi_bin_to_json_buf(
+            evt.abi, action_c, bin, len(bin), buf, sz_c)
+        if ret != evt_exception.EVTErrCode.EVT_BUFFER_TOO_SMALL:
+            break
+    evt_exception.evt_exception_raiser(ret)
+    return evt.ffi.string(buf, sz_c[0] - 1).decode('utf-8')
+
+
+def json_to_bin_batch(actions):
+    """Converts a list of (action, json) in one call, returns the list of binaries in bytes"""
+    evt = libevt.check_lib_init()
+    n = len(actions)
+    actions_c = [evt.ffi.new('char[]', bytes(a, encoding='utf-8')) for a, _ in actions]
+    jsons_c = [evt.ffi.new('char[]', bytes(j, encoding='utf-8')) for _, j in actions]
+    actions_arr = evt.ffi.new('const char*[]', actions_c)
+    jsons_arr = evt.ffi.new('const char*[]', jsons_c)
+    offsets_c = evt.ffi.new('size_t[]', n + 1)
+    sz_c = evt.ffi.new('size_t*')
+    while True:
+        buf = _buffer(evt, 'bin', sz_c[0])
+        sz_c[0] = len(buf)
+        ret = evt.lib.evt_abi_json_to_bin_batch(
+            evt.abi, n, actions_arr, jsons_arr, buf, sz_c, offsets_c)
+        if ret != evt_exception.EVTErrCode.EVT_BUFFER_TOO_SMALL:
+            break
+    evt_exception.evt_exception_raiser(ret)
+    data = evt.ffi.buffer(buf, sz_c[0])
+    return [bytes(data[offsets_c[i]:offsets_c[i + 1]]) for i in range(n)]
+
+
 def trx_json_to_digest(json, chain_id):
     evt = libevt.check_lib_init()
     json_c = bytes(json, encoding='utf-8')
@@ -35,6 +35,18 @@ class PublicKey(EvtData):
         evt_exception.evt_exception_raiser(ret)
         return PublicKey(public_key_c[0])
 
+    @staticmethod
+    def recover_many(signs, hashes):
+        """Recovers the keys of signatures in one call, None is returned for the ones failed"""
+        evt = libevt.check_lib_init()
+        n = len(signs)
+        signs_c = evt.ffi.new('evt_signature_t*[]', [s.data for s in signs])
+        hashes_c = evt.ffi.new('evt_checksum_t*[]', [h.data for h in hashes])
+        public_keys_c = evt.ffi.new('evt_public_key_t*[]', n)
+        results_c = evt.ffi.new('int[]', n)
+        evt.lib.evt_recover_many(n, signs_c, hashes_c, public_keys_c, results_c)
+        return [PublicKey(public_keys_c[i]) if results_c[i] == evt_exception.EVTErrCode.EVT_OK else None for i in range(n)]
+
 
 class PrivateKey(EvtData):
     def __init__(self, data):
@@ -119,6 +131,30 @@ class Checksum(EvtData):
         return Checksum(evt_hash[0])
 
 
+def sign_hashes(private_keys, hashes):
+    """Signs hashes[i] by private_keys[i] in one call"""
+    evt = libevt.check_lib_init()
+    n = len(hashes)
+    private_keys_c = evt.ffi.new('evt_private_key_t*[]', [k.data for k in private_keys])
+    hashes_c = evt.ffi.new('evt_checksum_t*[]', [h.data for h in hashes])
+    signs_c = evt.ffi.new('evt_signature_t*[]', n)
+    ret = evt.lib.evt_sign_hashes(n, private_keys_c, hashes_c, signs_c)
+    evt_exception.evt_exception_raiser(ret)
+    return [Signature(signs_c[i]) for i in range(n)]
+
+
+def hash_many(strs):
+    evt = libevt.check_lib_init()
+    n = len(strs)
+    strs_c = [bytes(s, encoding='utf-8') for s in strs]
+    bufs_c = evt.ffi.new('const char*[]', strs_c)
+    sizes_c = evt.ffi.new('size_t[]', [len(s) for s in strs_c])
+    hashes_c = evt.ffi.new('evt_checksum_t*[]', n)
+    ret = evt.lib.evt_hash_many(n, bufs_c, sizes_c, hashes_c)
+    evt_exception.evt_exception_raiser(ret)
+    return [Checksum(hashes_c[i]) for i in range(n)]
+
+
 def generate_new_pair():
     evt = libevt.check_lib_init()
     public_key_c = evt.ffi.new('evt_public_key_t**')
@@ -126,3 +162,12 @@ def generate_new_pair():
     ret = evt.lib.evt_generate_new_pair(public_key_c, private_key_c)
     evt_exception.evt_exception_raiser(ret)
     return PublicKey(public_key_c[0]), PrivateKey(private_key_c[0])
+
+
+def generate_new_pairs(n):
+    evt = libevt.check_lib_init()
+    public_keys_c = evt.ffi.new('evt_public_key_t*[]', n)
+    private_keys_c = evt.ffi.new('evt_private_key_t*[]', n)
+    ret = evt.lib.evt_generate_new_pairs(n, public_keys_c, private_keys_c)
+    evt_exception.evt_exception_raiser(ret)
+    return [(PublicKey(public_keys_c[i]), PrivateKey(private_keys_c[i])) for i in range(n)]
@@ -1,5 +1,3 @@
-from io import StringIO
-
 from . import evt_exception, libevt
 
 
@@ -13,7 +11,4 @@ class EvtData:
         evt_exception.evt_exception_raiser(ret)
 
     def to_hex_string(self):
-        hstr = StringIO()
-        for i in range(self.data.sz):
-            hstr.write(self.data.buf[i].hex())
-        return hstr.getvalue()
+        return bytes(self.evt.ffi.buffer(self.data.buf, self.data.sz)).hex()
@@ -42,6 +42,7 @@ def init_evt_lib():
             #define EVT_SIZE_NOT_EQUALS         -11
             #define EVT_DATA_NOT_EQUALS         -12
             #define EVT_INVALID_LINK            -13
+            #define EVT_BUFFER_TOO_SMALL        -14
 
             int evt_free(void*);
             int evt_equals(evt_data_t* rhs, evt_data_t* lhs);
@@ -61,18 +62,26 @@ def init_evt_lib():
 
 
             void* evt_abi();
+            void* evt_abi_shared();
             void evt_free_abi(void* abi);
             int evt_abi_json_to_bin(void* evt_abi, const char* action, const char* json, evt_bin_t** bin /* out */);
             int evt_abi_bin_to_json(void* evt_abi, const char* action, evt_bin_t* bin, char** json /* out */);
+            int evt_abi_json_to_bin_buf(void* evt_abi, const char* action, const char* json, char* buf, size_t* sz /* in-out */);
+            int evt_abi_bin_to_json_buf(void* evt_abi, const char* action, const char* bin, size_t bin_sz, char* json, size_t* sz /* in-out */);
+            int evt_abi_json_to_bin_batch(void* evt_abi, size_t n, const char** actions, const char** jsons, char* buf, size_t* sz /* in-out */, size_t* offsets /* out */);
             int evt_trx_json_to_digest(void* evt_abi, const char* json, evt_chain_id_t* chain_id, evt_checksum_t** digest /* out */);
             int evt_chain_id_from_string(const char* str, evt_chain_id_t** chain_id /* out */);
 
 
             int evt_generate_new_pair(evt_public_key_t** pub_key /* out */, evt_private_key_t** priv_key /* out */);
+            int evt_generate_new_pairs(size_t n, evt_public_key_t** pub_keys /* out */, evt_private_key_t** priv_keys /* out */);
             int evt_get_public_key(evt_private_key_t* priv_key, evt_public_key_t** pub_key /* out */);
             int evt_sign_hash(evt_private_key_t* priv_key, evt_checksum_t* hash, evt_signature_t** sign /* out */);
             int evt_recover(evt_signature_t* sign, evt_checksum_t* hash, evt_public_key_t** pub_key /* out */);
             int evt_hash(const char* buf, size_t sz, evt_checksum_t** hash /* out */);
+            int evt_sign_hashes(size_t n, evt_private_key_t** priv_keys, evt_checksum_t** hashes, evt_signature_t** signs /* out */);
+            int evt_recover_many(size_t n, evt_signature_t** signs, evt_checksum_t** hashes, evt_public_key_t** pub_keys /* out */, int* results /* out */);
+            int evt_hash_many(size_t n, const char** bufs, const size_t* sizes, evt_checksum_t** hashes /* out */);
 
             int evt_public_key_string(evt_public_key_t* pub_key, char** str /* out */);
             int evt_private_key_string(evt_private_key_t* priv_key, char** str /* out */);
@@ -126,7 +135,7 @@ def init_evt_lib():
     else:
         LibEVT.lib = LibEVT.ffi.dlopen('libevt' + ext)
 
-    LibEVT.abi = LibEVT.lib.evt_abi()
+    LibEVT.abi = LibEVT.lib.evt_abi_shared()
 
 
 def init_lib():
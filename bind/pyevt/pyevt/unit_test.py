@@ -38,6 +38,12 @@ class TestPyEVT(unittest.TestCase):
         pub_key_string3 = pub_key3.to_string()
         self.assertTrue(pub_key_string3 == pub_key_string)
 
+        hashes = hash_many(['hello world', 'hello'])
+        self.assertEqual(check_sum.to_string(), hashes[0].to_string())
+        signs = sign_hashes([priv_key, priv_key], hashes)
+        pub_keys = PublicKey.recover_many(signs, hashes)
+        self.assertEqual([pub_key_string, pub_key_string], [k.to_string() for k in pub_keys])
+
     def test_evtabi(self):
         j = r'''
         {
@@ -89,6 +95,12 @@ class TestPyEVT(unittest.TestCase):
         '''
         bin = json_to_bin('newdomain', j)
         json = bin_to_json('newdomain', bin)
+
+        bin_bytes = json_to_bin_bytes('newdomain', j)
+        self.assertEqual(bin.to_hex_string(), bin_bytes.hex())
+        self.assertEqual(json, bin_bytes_to_json('newdomain', bin_bytes))
+        self.assertEqual([bin_bytes, bin_bytes], json_to_bin_batch(
+            [('newdomain', j), ('newdomain', j)]))
         chain_id = ChainId.from_string(
             'bb248d6319e51ad38502cc8ef8fe607eb5ad2cd0be2bdc0e6e30a506761b8636')
         digest = abi.trx_json_to_digest(j2, chain_id)
@@ -0,0 +1,66 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/action_costs.hpp>
+#include <fc/variant_object.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+double
+moving_average(double avg, uint64_t count, double v) {
+    // plain average until there are enough samples
+    auto n = std::min<uint64_t>(count, action_cost_table::kDecay);
+    return avg + (v - avg) / n;
+}
+
+}  // namespace internal
+
+void
+action_cost_table::add(const action_trace& trace, bool failed) {
+    using namespace internal;
+
+    auto& e  = actions_[trace.act.name];
+    auto  us = (uint64_t)std::max<int64_t>(trace.elapsed.count(), 0);
+
+    e.count++;
+    e.failed    += failed;
+    e.sum_us    += us;
+    e.db_reads  += trace.db_reads;
+    e.db_writes += trace.db_writes;
+    e.latency.add(us);
+
+    e.avg_us        = moving_average(e.avg_us, e.count, us);
+    e.avg_db_reads  = moving_average(e.avg_db_reads, e.count, trace.db_reads);
+    e.avg_db_writes = moving_average(e.avg_db_writes, e.count, trace.db_writes);
+}
+
+const action_cost_table::entry*
+action_cost_table::find(action_name act) const {
+    auto it = actions_.find(act);
+    return it != actions_.cend() ? &it->second : nullptr;
+}
+
+fc::variant
+action_cost_table::to_variant() const {
+    auto actions = fc::mutable_variant_object();
+    for(auto& it : actions_) {
+        auto& e = it.second;
+        actions(it.first.to_string(), fc::mutable_variant_object()
+            ("count", e.count)
+            ("failed", e.failed)
+            ("total_us", e.sum_us)
+            ("recent_avg_us", e.avg_us)
+            ("max_us", e.latency.max_us)
+            ("db_reads", e.db_reads)
+            ("db_writes", e.db_writes)
+            ("recent_avg_db_reads", e.avg_db_reads)
+            ("recent_avg_db_writes", e.avg_db_writes)
+            ("buckets", std::vector<uint64_t>(e.latency.buckets.cbegin(), e.latency.buckets.cend())));
+    }
+    return actions;
+}
+
+}}  // namespace evt::chain
@@ -5,6 +5,7 @@
 #include <evt/chain/address.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <fc/crypto/base58.hpp>
+#include <fc/crypto/base58_cache.hpp>
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/io/datastream.hpp>
 
@@ -42,6 +43,33 @@ address::to_bytes(char* buf, size_t sz) const {
     memcpy(buf, cache_.data(), cache_.size());
 }
 
+address
+address::from_bytes(const char* buf, size_t sz) {
+    EVT_ASSERT(sz == sizeof(fc::ecc::public_key_shim), address_type_exception, "Size of address bytes is not valid");
+
+    // compressed public keys always start with 0x02 or 0x03
+    // while the first byte of generated ones is the lowest byte of the prefix, which is 0 for names within 11 chars
+    if(buf[0] == 0x02 || buf[0] == 0x03) {
+        auto data = fc::ecc::public_key_data();
+        memcpy(data.data(), buf, data.size());
+        return address(public_key_type(fc::ecc::public_key_shim(data)));
+    }
+
+    if(std::all_of(buf, buf + sz, [](char c) { return c == 0; })) {
+        return address();
+    }
+
+    auto prefix = name();
+    auto key    = name128();
+    auto nonce  = uint32_t();
+
+    auto ds = fc::datastream<const char*>(buf, sz);
+    fc::raw::unpack(ds, prefix);
+    fc::raw::unpack(ds, key);
+    fc::raw::unpack(ds, nonce);
+    return address(prefix, key, nonce);
+}
+
 std::string
 address::to_string() const {
     using namespace internal;
@@ -54,24 +82,28 @@ address::to_string() const {
         return (std::string)this->get_public_key();
     }
     case generated_t: {
-        auto str = std::string();
-        str.reserve(53);
-
-        str.append("EVT0");
-
         auto gen = gen_wrapper();
         gen.prefix = this->get_prefix().value;
         gen.key = this->get_key().value;
         gen.nonce = this->get_nonce();
-        gen.checksum = gen.calculate_checksum();
 
-        auto hash = fc::to_base58((char*)&gen, sizeof(gen));
-        EVT_ASSERT(hash.size() <= 53 - 4, address_type_exception, "Invalid generated values for address");
+        // checksum is left empty in the key of cache
+        return fc::base58_cache<gen_wrapper>::get(gen, [gen]() mutable {
+            auto str = std::string();
+            str.reserve(53);
+
+            str.append("EVT0");
+
+            gen.checksum = gen.calculate_checksum();
+
+            auto hash = fc::to_base58((char*)&gen, sizeof(gen));
+            EVT_ASSERT(hash.size() <= 53 - 4, address_type_exception, "Invalid generated values for address");
 
-        str.append(53 - 4 - hash.size(), '0');
-        str.append(std::move(hash));
+            str.append(53 - 4 - hash.size(), '0');
+            str.append(std::move(hash));
 
-        return str;
+            return str;
+        });
     }
     default: {
         EVT_ASSERT(false, address_type_exception, "Not valid address type: ${type}", ("type",type()));
@@ -9,6 +9,7 @@
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/transaction_context.hpp>
 #include <evt/chain/global_property_object.hpp>
+#include <evt/chain/token_database_metrics.hpp>
 #include <evt/chain/contracts/evt_contract.hpp>
 
 namespace evt { namespace chain {
@@ -52,7 +53,13 @@ apply_context::exec_one(action_trace& trace) {
             if(act.index_ == exec_ctx.index_of<contracts::paybonus>()) {
                 goto next;
             }
+
+            // accesses of token database are counted into this action
+            auto scope = token_database_metrics::action_scope(token_db.metrics(), act.name);
             exec_ctx.invoke<apply_action, void>(act.index_, *this);
+
+            trace.db_reads  = scope.reads();
+            trace.db_writes = scope.writes();
         }
         FC_RETHROW_EXCEPTIONS(warn, "pending console output: ${console}", ("console", fmt::to_string(_pending_console_output)));
     }
@@ -0,0 +1,107 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/block_bus.hpp>
+#include <fc/log/logger.hpp>
+
+namespace evt { namespace chain {
+
+block_bus::block_bus(size_t max_size)
+    : max_size_(std::max<size_t>(max_size, 1))
+    , delivering_(0)
+    , done_(false)
+    , thread_([this] { run(); }) {}
+
+block_bus::~block_bus() {
+    stop();
+}
+
+void
+block_bus::subscribe(subscriber_type subscriber) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    subscribers_.emplace_back(std::move(subscriber));
+}
+
+void
+block_bus::publish(block_batch_ptr batch) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    not_full_.wait(lock, [this] { return batches_.size() < max_size_ || done_; });
+    if(done_) {
+        return;
+    }
+    batches_.emplace_back(std::move(batch));
+    not_empty_.notify_one();
+}
+
+void
+block_bus::flush() {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    not_full_.wait(lock, [this] { return (batches_.empty() && delivering_ == 0) || done_; });
+}
+
+void
+block_bus::stop() {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        if(done_) {
+            return;
+        }
+        done_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    thread_.join();
+}
+
+size_t
+block_bus::size() const {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    return batches_.size();
+}
+
+void
+block_bus::run() {
+    while(true) {
+        auto batches     = std::deque<block_batch_ptr>();
+        auto subscribers = std::vector<subscriber_type>();
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            not_empty_.wait(lock, [this] { return !batches_.empty() || done_; });
+            if(batches_.empty() && done_) {
+                return;
+            }
+            batches     = std::move(batches_);
+            subscribers = subscribers_;
+            delivering_ = batches.size();
+            batches_.clear();
+        }
+        // publisher can go on while the batches taken are delivered
+        not_full_.notify_all();
+
+        for(auto& b : batches) {
+            for(auto& s : subscribers) {
+                try {
+                    s(b);
+                }
+                catch(fc::exception& e) {
+                    wlog("${details}", ("details", e.to_detail_string()));
+                }
+                catch(std::exception& e) {
+                    wlog("${details}", ("details", e.what()));
+                }
+                catch(...) {
+                    wlog("block bus subscriber threw exception");
+                }
+            }
+        }
+
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            delivering_ = 0;
+        }
+        not_full_.notify_all();
+    }
+}
+
+}}  // namespace evt::chain
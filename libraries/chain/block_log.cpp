@@ -3,8 +3,20 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain/block_log.hpp>
+#include <evt/chain/block_log_segments.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fc/io/raw.hpp>
 
 #define LOG_READ (std::ios::in | std::ios::binary)
@@ -23,6 +35,29 @@ const uint32_t block_log::min_supported_version = 1;
 const uint32_t block_log::max_supported_version = 2;
 
 namespace detail {
+
+static void
+sync_file(const fc::path& file) {
+    auto fd = ::open(file.generic_string().c_str(), O_RDONLY);
+    EVT_ASSERT(fd >= 0, block_log_exception, "Cannot open '${f}' to sync it", ("f", file));
+#if defined(__APPLE__)
+    auto r = ::fsync(fd);
+#else
+    auto r = ::fdatasync(fd);
+#endif
+    ::close(fd);
+    EVT_ASSERT(r == 0, block_log_exception, "Cannot sync '${f}'", ("f", file));
+}
+
+// read-only maps of both files for looking blocks up by number from many threads
+// one map covers the blocks indexed when it was made, new blocks make it remapped
+struct mapped_log {
+    boost::iostreams::mapped_file_source blocks;
+    boost::iostreams::mapped_file_source index;
+    uint32_t                             first_block_num = 0;
+    uint32_t                             end_block_num   = 0;
+};
+
 class block_log_impl {
 public:
     signed_block_ptr head;
@@ -37,6 +72,324 @@ public:
     uint32_t         version                      = 0;
     uint32_t         first_block_num              = 0;
 
+    std::atomic<uint32_t>             head_num{0};
+    std::shared_ptr<const mapped_log> mapped;
+    std::mutex                        mapped_mutex;
+
+    block_log::config                   cfg;
+    std::unique_ptr<block_log_segments> segments;
+
+    // blocks waiting for the writer thread when appending asynchronously, only writer pops them
+    struct pending_block {
+        signed_block_ptr                      block;
+        std::vector<char>                     data;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    std::deque<pending_block> pending;
+    std::mutex                pending_mutex;
+    std::condition_variable   pending_cv;  // notifies writer
+    std::condition_variable   written_cv;  // notified by writer
+    std::thread               writer;
+    bool                      stopping = false;
+    bool                      draining = false;
+    std::exception_ptr        writer_error;
+
+    std::atomic<uint32_t>                        durable_num{0};
+    std::function<void(uint32_t, uint64_t)>      on_durable;
+
+    uint64_t
+    write_block(const signed_block& b, const std::vector<char>& data) {
+        check_block_write();
+        check_index_write();
+
+        uint64_t pos = block_stream.tellp();
+        EVT_ASSERT((size_t)index_stream.tellp() == sizeof(uint64_t) * (b.block_num() - first_block_num),
+                   block_log_append_fail,
+                   "Append to index file occuring at wrong position.",
+                   ("position", (uint64_t)index_stream.tellp())("expected", (b.block_num() - first_block_num) * sizeof(uint64_t)));
+        block_stream.write(data.data(), data.size());
+        block_stream.write((char*)&pos, sizeof(pos));
+        index_stream.write((char*)&pos, sizeof(pos));
+        return pos;
+    }
+
+    // called after blocks up to `block_num` are written
+    void
+    on_written(uint32_t block_num, uint64_t pos) {
+        block_stream.flush();
+        index_stream.flush();
+        if(cfg.sync_data) {
+            sync_file(block_file);
+            sync_file(index_file);
+        }
+
+        head_num.store(block_num, std::memory_order_release);
+        durable_num.store(block_num, std::memory_order_release);
+        if(on_durable) {
+            on_durable(block_num, pos);
+        }
+
+        // block log keeps at least one segment of blocks, so recent ones are never compressed
+        if(cfg.segment_blocks > 0 && block_num - first_block_num + 1 >= 2 * cfg.segment_blocks) {
+            move_to_segment();
+        }
+    }
+
+    void
+    enqueue(const signed_block_ptr& b) {
+        auto data = fc::raw::pack(*b);
+
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        // appending waits once writer falls too much behind
+        written_cv.wait(lock, [this] { return pending.size() < std::max(cfg.max_pending_blocks, 1u) || writer_error; });
+        if(writer_error) {
+            std::rethrow_exception(writer_error);
+        }
+        pending.emplace_back(pending_block { b, std::move(data), std::chrono::steady_clock::now() });
+        pending_cv.notify_one();
+    }
+
+    const pending_block*
+    find_pending_locked(uint32_t block_num) const {
+        if(pending.empty()) {
+            return nullptr;
+        }
+        auto first = pending.front().block->block_num();
+        if(block_num < first || block_num - first >= pending.size()) {
+            return nullptr;
+        }
+        return &pending[block_num - first];
+    }
+
+    signed_block_ptr
+    find_pending(uint32_t block_num) {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        auto p = find_pending_locked(block_num);
+        return p ? p->block : nullptr;
+    }
+
+    // packed data is copied because the pending block is gone once it's written
+    block_log::packed_block
+    find_pending_packed(uint32_t block_num) {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        auto p = find_pending_locked(block_num);
+        if(!p) {
+            return block_log::packed_block();
+        }
+        auto data = std::make_shared<const std::vector<char>>(p->data);
+        return block_log::packed_block { std::string_view(data->data(), data->size()), data };
+    }
+
+    void
+    write_loop() {
+        auto batch = std::vector<const pending_block*>();
+        while(true) {
+            batch.clear();
+            {
+                std::unique_lock<std::mutex> lock(pending_mutex);
+                pending_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+                if(pending.empty()) {
+                    return;
+                }
+
+                // waits a little for more blocks, they are written and synced together
+                auto deadline = pending.front().time + std::chrono::milliseconds(cfg.batch_ms);
+                pending_cv.wait_until(lock, deadline, [this] {
+                    return stopping || draining || pending.size() >= cfg.batch_blocks;
+                });
+
+                auto n = std::min<size_t>(pending.size(), std::max(cfg.batch_blocks, 1u));
+                for(auto i = 0u; i < n; i++) {
+                    batch.emplace_back(&pending[i]);
+                }
+            }
+
+            try {
+                auto pos = uint64_t();
+                for(auto p : batch) {
+                    pos = write_block(*p->block, p->data);
+                }
+                on_written(batch.back()->block->block_num(), pos);
+            }
+            catch(...) {
+                elog("Failed to write blocks into block log, appending is stopped");
+                std::lock_guard<std::mutex> lock(pending_mutex);
+                writer_error = std::current_exception();
+                written_cv.notify_all();
+                return;
+            }
+
+            // blocks are popped after head is updated, so readers never miss them
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending.erase(pending.begin(), pending.begin() + batch.size());
+            written_cv.notify_all();
+        }
+    }
+
+    void
+    start_writer() {
+        stopping = false;
+        writer   = std::thread([this] { write_loop(); });
+    }
+
+    void
+    stop_writer() {
+        if(!writer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            stopping = true;
+        }
+        pending_cv.notify_one();
+        writer.join();
+    }
+
+    // waits for all the pending blocks written, streams can be used after it
+    void
+    drain() {
+        if(!writer.joinable()) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        draining = true;
+        pending_cv.notify_one();
+        written_cv.wait(lock, [this] { return pending.empty() || writer_error; });
+        draining = false;
+        if(writer_error) {
+            std::rethrow_exception(writer_error);
+        }
+    }
+
+    inline void
+    set_head(const signed_block_ptr& b) {
+        head    = b;
+        head_id = b ? b->id() : block_id_type();
+        head_num.store(b ? b->block_num() : 0, std::memory_order_release);
+    }
+
+    std::shared_ptr<const mapped_log>
+    get_mapped(uint32_t block_num) {
+        std::lock_guard<std::mutex> lock(mapped_mutex);
+        if(!mapped || block_num >= mapped->end_block_num) {
+            remap();
+        }
+        return mapped;
+    }
+
+    // index is mapped before blocks, every block indexed is in the blocks map then
+    // both files are flushed after each appending
+    void
+    remap() {
+        auto m = std::make_shared<mapped_log>();
+        m->first_block_num = first_block_num;
+        m->end_block_num   = first_block_num;
+
+        auto index_size = fc::file_size(index_file) / sizeof(uint64_t) * sizeof(uint64_t);
+        if(index_size > 0) {
+            m->index.open(index_file.generic_string(), index_size);
+            m->blocks.open(block_file.generic_string());
+            m->end_block_num += index_size / sizeof(uint64_t);
+        }
+        mapped = std::move(m);
+    }
+
+    void
+    unmap() {
+        std::lock_guard<std::mutex> lock(mapped_mutex);
+        mapped.reset();
+    }
+
+    // moves the oldest segment of blocks into segment file and writes main file again without them
+    // blocks are copied as they are, only their positions are changed
+    void
+    move_to_segment() {
+        auto m        = get_mapped(head_num);
+        auto first    = first_block_num;
+        auto last     = head_num.load();
+        auto kept     = first + cfg.segment_blocks;
+        auto get_pos  = [&m](uint32_t num) {
+            uint64_t pos;
+            memcpy(&pos, m->index.data() + sizeof(uint64_t) * (num - m->first_block_num), sizeof(pos));
+            return pos;
+        };
+        // each block is followed by its position
+        auto get_end = [&](uint32_t num) {
+            return (num < last ? get_pos(num + 1) : m->blocks.size()) - sizeof(uint64_t);
+        };
+
+        ilog("Moving blocks [${f}, ${l}) of block log into segment", ("f", first)("l", kept));
+
+        auto blocks = std::vector<std::string_view>();
+        blocks.reserve(cfg.segment_blocks);
+        for(auto i = first; i < kept; i++) {
+            blocks.emplace_back(m->blocks.data() + get_pos(i), get_end(i) - get_pos(i));
+        }
+        segments->add_segment(first, blocks);
+
+        auto block_tmp = fc::path(block_file.generic_string() + ".tmp");
+        auto index_tmp = fc::path(index_file.generic_string() + ".tmp");
+
+        auto bout = std::ofstream();
+        auto iout = std::ofstream();
+        bout.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        iout.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        bout.open(block_tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        iout.open(index_tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        // always written as a partial log, genesis and the totem are copied from the old one
+        auto new_version = block_log::max_supported_version;
+        auto gs_pos      = version > 1 ? sizeof(uint32_t) * 2 : sizeof(uint32_t);
+        bout.write((char*)&new_version, sizeof(new_version));
+        bout.write((char*)&kept, sizeof(kept));
+        bout.write(m->blocks.data() + gs_pos, get_pos(first) - gs_pos);
+        if(version == 1) {
+            auto totem = block_log::npos;
+            bout.write((char*)&totem, sizeof(totem));
+        }
+
+        for(auto i = kept; i <= last; i++) {
+            uint64_t pos = bout.tellp();
+            bout.write(m->blocks.data() + get_pos(i), get_end(i) - get_pos(i));
+            bout.write((char*)&pos, sizeof(pos));
+            iout.write((char*)&pos, sizeof(pos));
+        }
+        bout.close();
+        iout.close();
+        m.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mapped_mutex);
+
+            block_stream.close();
+            index_stream.close();
+            fc::rename(block_tmp, block_file);
+            fc::rename(index_tmp, index_file);
+            block_stream.open(block_file.generic_string().c_str(), LOG_WRITE);
+            index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+            block_write = true;
+            index_write = true;
+
+            version         = new_version;
+            first_block_num = kept;
+            mapped.reset();
+        }
+
+        prune_segments();
+    }
+
+    void
+    prune_segments() {
+        if(cfg.max_segments > 0) {
+            segments->prune(cfg.max_segments);
+        }
+        if(cfg.max_segments_size > 0) {
+            segments->prune_size(cfg.max_segments_size);
+        }
+    }
+
     inline void
     check_block_read() {
         if(block_write) {
@@ -78,11 +431,17 @@ public:
 };
 }  // namespace detail
 
-block_log::block_log(const fc::path& data_dir)
+block_log::block_log(const fc::path& data_dir, const config& cfg)
     : my(new detail::block_log_impl()) {
+    my->cfg = cfg;
     my->block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
     my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
     open(data_dir);
+
+    my->durable_num = my->head_num.load();
+    if(cfg.async_append) {
+        my->start_writer();
+    }
 }
 
 block_log::block_log(block_log&& other) {
@@ -91,13 +450,18 @@ block_log::block_log(block_log&& other) {
 
 block_log::~block_log() {
     if(my) {
-        flush();
+        try {
+            flush();
+        }
+        FC_LOG_AND_DROP();
+        my->stop_writer();
         my.reset();
     }
 }
 
 void
 block_log::open(const fc::path& data_dir) {
+    my->unmap();
     if(my->block_stream.is_open())
         my->block_stream.close();
     if(my->index_stream.is_open())
@@ -108,6 +472,14 @@ block_log::open(const fc::path& data_dir) {
     my->block_file = data_dir / "blocks.log";
     my->index_file = data_dir / "blocks.index";
 
+    // existed segments are still read when segments are disabled now
+    my->segments.reset();
+    if(my->cfg.segment_blocks > 0 || fc::is_directory(data_dir / "segments")) {
+        my->segments = std::make_unique<block_log_segments>(data_dir / "segments");
+        // limits may be lowered since last run
+        my->prune_segments();
+    }
+
     //ilog("Opening block log at ${path}", ("path", my->block_file.generic_string()));
     my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
     my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
@@ -156,8 +528,7 @@ block_log::open(const fc::path& data_dir) {
             my->first_block_num = 1;
         }
 
-        my->head    = read_head();
-        my->head_id = my->head->id();
+        my->set_head(read_head());
 
         if(index_size) {
             my->check_block_read();
@@ -200,22 +571,24 @@ block_log::append(const signed_block_ptr& b) {
     try {
         EVT_ASSERT(my->genesis_written_to_block_log, block_log_append_fail, "Cannot append to block log until the genesis is first written");
 
-        my->check_block_write();
-        my->check_index_write();
+        if(my->writer.joinable()) {
+            auto expected = my->head ? my->head->block_num() + 1 : my->first_block_num;
+            EVT_ASSERT(b->block_num() == expected, block_log_append_fail, "Append to block log with wrong block",
+                       ("block_num", b->block_num())("expected", expected));
+
+            // readers find it in pending blocks until it's written
+            my->enqueue(b);
+            my->head    = b;
+            my->head_id = b->id();
+            return npos;
+        }
 
-        uint64_t pos = my->block_stream.tellp();
-        EVT_ASSERT((size_t)my->index_stream.tellp() == sizeof(uint64_t) * (b->block_num() - my->first_block_num),
-                   block_log_append_fail,
-                   "Append to index file occuring at wrong position.",
-                   ("position", (uint64_t)my->index_stream.tellp())("expected", (b->block_num() - my->first_block_num) * sizeof(uint64_t)));
         auto data = fc::raw::pack(*b);
-        my->block_stream.write(data.data(), data.size());
-        my->block_stream.write((char*)&pos, sizeof(pos));
-        my->index_stream.write((char*)&pos, sizeof(pos));
+        auto pos  = my->write_block(*b, data);
+
         my->head    = b;
         my->head_id = b->id();
-
-        flush();
+        my->on_written(b->block_num(), pos);
 
         return pos;
     }
@@ -224,12 +597,27 @@ block_log::append(const signed_block_ptr& b) {
 
 void
 block_log::flush() {
+    my->drain();
     my->block_stream.flush();
     my->index_stream.flush();
 }
 
+uint32_t
+block_log::durable_block_num() const {
+    return my->durable_num.load(std::memory_order_acquire);
+}
+
+void
+block_log::set_on_durable(std::function<void(uint32_t, uint64_t)> func) {
+    my->drain();
+    my->on_durable = std::move(func);
+}
+
 void
 block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, uint32_t first_block_num) {
+    my->drain();
+    my->unmap();
+    my->set_head(nullptr);
     if(my->block_stream.is_open())
         my->block_stream.close();
     if(my->index_stream.is_open())
@@ -237,6 +625,9 @@ block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, u
 
     fc::remove_all(my->block_file);
     fc::remove_all(my->index_file);
+    if(my->segments) {
+        my->segments->clear();
+    }
 
     my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
     my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
@@ -255,8 +646,12 @@ block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, u
     auto totem = npos;
     my->block_stream.write((char*)&totem, sizeof(totem));
 
+    // written here even when appending asynchronously, streams are reopened below
     if(first_block) {
-        append(first_block);
+        auto data = fc::raw::pack(*first_block);
+        auto pos  = my->write_block(*first_block, data);
+        my->set_head(first_block);
+        my->on_written(first_block->block_num(), pos);
     }
 
     auto pos = my->block_stream.tellp();
@@ -277,6 +672,7 @@ block_log::reset(const genesis_state& gs, const signed_block_ptr& first_block, u
 
 std::pair<signed_block_ptr, uint64_t>
 block_log::read_block(uint64_t pos) const {
+    my->drain();
     my->check_block_read();
 
     my->block_stream.seekg(pos);
@@ -287,34 +683,123 @@ block_log::read_block(uint64_t pos) const {
     return result;
 }
 
+// blocks are looked up through the maps instead of the streams
+// so it's safe to call from many threads, concurrently with appending
 signed_block_ptr
 block_log::read_block_by_num(uint32_t block_num) const {
     try {
         signed_block_ptr b;
-        uint64_t         pos = get_block_pos(block_num);
-        if(pos != npos) {
-            b = read_block(pos).first;
-            EVT_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
-                       "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
+        if(block_num > my->head_num.load(std::memory_order_acquire)) {
+            // head is updated before blocks are popped, check it again if it's not pending
+            if((b = my->find_pending(block_num))) {
+                return b;
+            }
+            if(block_num > my->head_num.load(std::memory_order_acquire)) {
+                return b;
+            }
         }
+
+        // first block num is taken from the map, main file is written again when blocks are moved into segment
+        auto m = my->get_mapped(block_num);
+        if(block_num < m->first_block_num) {
+            return my->segments ? my->segments->read_block_by_num(block_num) : b;
+        }
+        if(block_num >= m->end_block_num) {
+            return b;
+        }
+
+        uint64_t pos;
+        memcpy(&pos, m->index.data() + sizeof(uint64_t) * (block_num - m->first_block_num), sizeof(pos));
+        EVT_ASSERT(pos < m->blocks.size(), block_log_exception,
+                   "Position of block is out of block log.", ("pos", pos)("size", m->blocks.size()));
+
+        auto ds = fc::datastream<const char*>(m->blocks.data() + pos, m->blocks.size() - pos);
+        b = std::make_shared<signed_block>();
+        fc::raw::unpack(ds, *b);
+        EVT_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
+                   "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
         return b;
     }
     FC_LOG_AND_RETHROW()
 }
 
+block_log::packed_block
+block_log::packed_block::from_block(const signed_block& b) {
+    auto data = std::make_shared<const std::vector<char>>(fc::raw::pack(b));
+    return packed_block { std::string_view(data->data(), data->size()), data };
+}
+
+block_log::packed_block
+block_log::read_packed_block_by_num(uint32_t block_num) const {
+    try {
+        if(block_num > my->head_num.load(std::memory_order_acquire)) {
+            if(auto p = my->find_pending_packed(block_num)) {
+                return p;
+            }
+            if(block_num > my->head_num.load(std::memory_order_acquire)) {
+                return packed_block();
+            }
+        }
+
+        auto m = my->get_mapped(block_num);
+        if(block_num < m->first_block_num) {
+            // blocks in segments are decompressed in chunks, they're only packed again
+            auto b = my->segments ? my->segments->read_block_by_num(block_num) : signed_block_ptr();
+            return b ? packed_block::from_block(*b) : packed_block();
+        }
+        if(block_num >= m->end_block_num) {
+            return packed_block();
+        }
+
+        auto get_pos = [&m](uint32_t num) {
+            uint64_t pos;
+            memcpy(&pos, m->index.data() + sizeof(uint64_t) * (num - m->first_block_num), sizeof(pos));
+            return pos;
+        };
+        auto pos = get_pos(block_num);
+        EVT_ASSERT(pos < m->blocks.size(), block_log_exception,
+                   "Position of block is out of block log.", ("pos", pos)("size", m->blocks.size()));
+
+        // each block is followed by its position, so it ends where the next one starts less 8 bytes
+        // the last block in map has no next one indexed, its size is only known after unpacking it
+        auto size = uint64_t(0);
+        if(block_num + 1 < m->end_block_num) {
+            size = get_pos(block_num + 1) - sizeof(uint64_t) - pos;
+        }
+        else {
+            auto ds = fc::datastream<const char*>(m->blocks.data() + pos, m->blocks.size() - pos);
+            auto b  = signed_block();
+            fc::raw::unpack(ds, b);
+            size = ds.tellp();
+        }
+        EVT_ASSERT(pos + size <= m->blocks.size(), block_log_exception,
+                   "Block is out of block log.", ("pos", pos)("size", size));
+
+        return packed_block { std::string_view(m->blocks.data() + pos, size), m };
+    }
+    FC_LOG_AND_RETHROW()
+}
+
 uint64_t
 block_log::get_block_pos(uint32_t block_num) const {
-    my->check_index_read();
-    if(!(my->head && block_num <= block_header::num_from_id(my->head_id) && block_num >= my->first_block_num))
+    if(block_num > my->head_num.load(std::memory_order_acquire)) {
+        return npos;
+    }
+
+    // blocks in segments have no position
+    auto m = my->get_mapped(block_num);
+    if(block_num < m->first_block_num || block_num >= m->end_block_num) {
         return npos;
-    my->index_stream.seekg(sizeof(uint64_t) * (block_num - my->first_block_num));
+    }
+
     uint64_t pos;
-    my->index_stream.read((char*)&pos, sizeof(pos));
+    memcpy(&pos, m->index.data() + sizeof(uint64_t) * (block_num - m->first_block_num), sizeof(pos));
     return pos;
 }
 
 signed_block_ptr
 block_log::read_head() const {
+    my->drain();
     my->check_block_read();
 
     uint64_t pos;
@@ -344,20 +829,27 @@ block_log::first_block_num() const {
     return my->first_block_num;
 }
 
+uint32_t
+block_log::earliest_block_num() const {
+    if(my->segments) {
+        if(auto first = my->segments->first_block_num(); first > 0) {
+            return first;
+        }
+    }
+    // it's changed by the writing thread when blocks are moved into segment
+    std::lock_guard<std::mutex> lock(my->mapped_mutex);
+    return my->first_block_num;
+}
+
 void
 block_log::construct_index() {
     ilog("Reconstructing Block Log Index...");
+    my->unmap();
     my->index_stream.close();
     fc::remove_all(my->index_file);
-    my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-    my->index_write = true;
 
-    uint64_t end_pos;
     my->check_block_read();
 
-    my->block_stream.seekg(-sizeof(uint64_t), std::ios::end);
-    my->block_stream.read((char*)&end_pos, sizeof(end_pos));
-
     uint64_t pos = 0;
     if(my->version == 1) {
         pos = 4;  // Skip version which should have already been checked.
@@ -375,19 +867,80 @@ block_log::construct_index() {
         uint64_t totem;
         my->block_stream.read((char*)&totem, sizeof(totem));
     }
-
-    while(pos < end_pos) {
-        signed_block tmp;
-        fc::raw::unpack(my->block_stream, tmp);
-        
-        my->block_stream.read((char*)&pos, sizeof(pos));
-        if(tmp.block_num() % 1000 == 0) {
-            ilog2_("Block log index reconstructed for block {:n}", tmp.block_num());
+    uint64_t first_pos = my->block_stream.tellg();
+
+    // blocks are found by walking back through the positions following each of them, without unpacking
+    // the walk is only 8 bytes read per block from the mapped file, so it's not split into threads
+    auto positions = std::vector<uint64_t>();
+    auto log_size  = fc::file_size(my->block_file);
+    if(log_size > first_pos) {
+        auto log = boost::iostreams::mapped_file_source(my->block_file.generic_string());
+        auto end = (uint64_t)log.size();
+        while(end > first_pos) {
+            EVT_ASSERT(end >= first_pos + sizeof(uint64_t), block_log_exception,
+                       "Block log is malformed, size of block before position ${end} is wrong", ("end", end));
+            memcpy(&pos, log.data() + end - sizeof(uint64_t), sizeof(pos));
+            EVT_ASSERT(pos >= first_pos && pos < end - sizeof(uint64_t), block_log_exception,
+                       "Block log is malformed, wrong position ${pos} of block ending at ${end}", ("pos", pos)("end", end));
+            positions.emplace_back(pos);
+            end = pos;
         }
-        my->index_stream.write((char*)&pos, sizeof(pos));
+        std::reverse(positions.begin(), positions.end());
     }
+
+    my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
+    my->index_write = true;
+    my->index_stream.write((char*)positions.data(), positions.size() * sizeof(uint64_t));
+    my->index_stream.flush();
+
+    ilog("Block log index reconstructed for ${n} blocks", ("n", positions.size()));
 }  // construct_index
 
+// number of blocks from the beginning of old log which can be trusted, see `repair_log`
+// the last block in old index is never trusted, because where it ends is unknown without unpacking it
+static uint64_t
+find_trusted_blocks(const fc::path& backup_dir, uint64_t first_pos, uint64_t end_pos) {
+    auto index_file = backup_dir / "blocks.index";
+    if(!fc::is_regular_file(index_file)) {
+        return 0;
+    }
+    auto index_size = fc::file_size(index_file) / sizeof(uint64_t);
+    if(index_size < 2) {
+        return 0;
+    }
+
+    try {
+        auto log   = boost::iostreams::mapped_file_source((backup_dir / "blocks.log").generic_string());
+        auto index = boost::iostreams::mapped_file_source(index_file.generic_string(), index_size * sizeof(uint64_t));
+        auto get   = [](const char* data, uint64_t pos) {
+            uint64_t v;
+            memcpy(&v, data + pos, sizeof(v));
+            return v;
+        };
+
+        if(get(index.data(), 0) != first_pos) {
+            return 0;
+        }
+
+        auto n = 0ul;
+        for(; n < index_size - 1; n++) {
+            auto pos  = get(index.data(), n * sizeof(uint64_t));
+            auto next = get(index.data(), (n + 1) * sizeof(uint64_t));
+            if(next <= pos + sizeof(uint64_t) || next > std::min<uint64_t>(end_pos, log.size())) {
+                break;
+            }
+            if(get(log.data(), next - sizeof(uint64_t)) != pos) {
+                break;
+            }
+        }
+        return n;
+    }
+    catch(...) {
+        // falls back to check all the blocks
+        return 0;
+    }
+}
+
 fc::path
 block_log::repair_log(const fc::path& data_dir, uint32_t truncate_at_block) {
     ilog("Recovering Block Log...");
@@ -415,6 +968,11 @@ block_log::repair_log(const fc::path& data_dir, uint32_t truncate_at_block) {
     fc::create_directories(blocks_dir);
     auto block_log_path = blocks_dir / "blocks.log";
 
+    // segments are not repaired, move them back instead of copying
+    if(fc::is_directory(backup_dir / "segments")) {
+        fc::rename(backup_dir / "segments", blocks_dir / "segments");
+    }
+
     ilog("Reconstructing '${new_block_log}' from backed up block log", ("new_block_log", block_log_path));
 
     std::fstream old_block_stream;
@@ -468,6 +1026,34 @@ block_log::repair_log(const fc::path& data_dir, uint32_t truncate_at_block) {
     block_id_type previous;
 
     uint64_t pos = old_block_stream.tellg();
+
+    // fast path for the usual case of only the tail damaged: blocks whose positions in the old index
+    // match their trailing positions are copied as they are, only the blocks after them are checked
+    auto trusted = find_trusted_blocks(backup_dir, pos, end_pos);
+    if(truncate_at_block > 0) {
+        trusted = std::min<uint64_t>(trusted, truncate_at_block > first_block_num ? truncate_at_block - first_block_num : 0);
+    }
+    if(trusted > 0 && (uint64_t)new_block_stream.tellp() == pos) {
+        auto log   = boost::iostreams::mapped_file_source((backup_dir / "blocks.log").generic_string());
+        auto index = boost::iostreams::mapped_file_source((backup_dir / "blocks.index").generic_string(), (trusted + 1) * sizeof(uint64_t));
+
+        uint64_t last_pos, end;
+        memcpy(&last_pos, index.data() + (trusted - 1) * sizeof(uint64_t), sizeof(last_pos));
+        memcpy(&end, index.data() + trusted * sizeof(uint64_t), sizeof(end));
+
+        auto ds   = fc::datastream<const char*>(log.data() + last_pos, end - last_pos);
+        auto last = signed_block();
+        fc::raw::unpack(ds, last);
+
+        new_block_stream.write(log.data() + pos, end - pos);
+        old_block_stream.seekg(end);
+
+        previous  = last.id();
+        block_num = last.block_num();
+        pos       = end;
+        ilog("Copied ${n} blocks up to block ${num} without checking them", ("n", trusted)("num", block_num));
+    }
+
     while(pos < end_pos) {
         signed_block tmp;
 
@@ -0,0 +1,369 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/block_log_segments.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/zstd_dictionary.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fmt/format.h>
+#include <zstd.h>
+#include <fc/io/raw.hpp>
+
+namespace evt { namespace chain {
+
+namespace detail {
+
+namespace internal {
+
+constexpr uint32_t kSegmentMagic   = 0x47455345;  // "ESEG"
+constexpr uint32_t kSegmentVersion = 2;  // chunks of version 1 are compressed without dictionary
+constexpr uint32_t kChunkBlocks    = 256;
+constexpr int      kZstdLevel      = 3;
+constexpr size_t   kCachedChunks   = 4;
+
+struct segment_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t first_block_num;
+    uint32_t blocks_num;
+    uint32_t chunk_blocks;
+};
+
+template<typename T>
+T
+read_pod(const char* data) {
+    T v;
+    memcpy(&v, data, sizeof(T));
+    return v;
+}
+
+template<typename T>
+void
+write_pod(std::ofstream& out, const T& v) {
+    out.write((const char*)&v, sizeof(T));
+}
+
+struct segment {
+    fc::path                             file;
+    boost::iostreams::mapped_file_source data;
+    segment_header                       header;
+    uint64_t                             index_pos;
+
+    uint32_t end_block_num() const { return header.first_block_num + header.blocks_num; }
+    uint32_t chunks_num() const { return (header.blocks_num + header.chunk_blocks - 1) / header.chunk_blocks; }
+
+    uint64_t
+    chunk_pos(uint32_t chunk) const {
+        return read_pod<uint64_t>(data.data() + index_pos + sizeof(uint64_t) * chunk);
+    }
+
+    uint32_t
+    block_offset(uint32_t i) const {
+        auto pos = index_pos + sizeof(uint64_t) * (chunks_num() + 1) + sizeof(uint32_t) * i;
+        return read_pod<uint32_t>(data.data() + pos);
+    }
+};
+
+using segment_ptr = std::shared_ptr<const segment>;
+using chunk_ptr   = std::shared_ptr<const std::string>;
+
+segment_ptr
+open_segment(const fc::path& file) {
+    auto seg  = std::make_shared<segment>();
+    seg->file = file;
+    seg->data.open(file.generic_string());
+
+    auto sz = seg->data.size();
+    EVT_ASSERT(sz >= sizeof(segment_header) + sizeof(uint64_t), block_log_exception,
+        "Segment file '${f}' is too small", ("f", file));
+
+    seg->header = read_pod<segment_header>(seg->data.data());
+    EVT_ASSERT(seg->header.magic == kSegmentMagic && seg->header.version >= 1 && seg->header.version <= kSegmentVersion, block_log_exception,
+        "Segment file '${f}' is not supported, version: ${v}", ("f", file)("v", seg->header.version));
+    EVT_ASSERT(seg->header.blocks_num > 0 && seg->header.chunk_blocks > 0, block_log_exception,
+        "Segment file '${f}' is empty", ("f", file));
+
+    seg->index_pos  = read_pod<uint64_t>(seg->data.data() + sz - sizeof(uint64_t));
+    auto index_size = sizeof(uint64_t) * (seg->chunks_num() + 1) + sizeof(uint32_t) * seg->header.blocks_num;
+    EVT_ASSERT(seg->index_pos + index_size + sizeof(uint64_t) == sz, block_log_exception,
+        "Index of segment file '${f}' is malformed", ("f", file));
+
+    return seg;
+}
+
+chunk_ptr
+decompress_chunk(const segment& seg, uint32_t chunk) {
+    auto begin = seg.chunk_pos(chunk);
+    auto end   = seg.chunk_pos(chunk + 1);
+    EVT_ASSERT(sizeof(segment_header) <= begin && begin <= end && end <= seg.index_pos, block_log_exception,
+        "Chunk ${c} of segment file '${f}' is malformed", ("c", chunk)("f", seg.file));
+
+    auto src = seg.data.data() + begin;
+    auto sz  = ZSTD_getFrameContentSize(src, end - begin);
+    EVT_ASSERT(sz != ZSTD_CONTENTSIZE_ERROR && sz != ZSTD_CONTENTSIZE_UNKNOWN, block_log_exception,
+        "Chunk ${c} of segment file '${f}' is malformed", ("c", chunk)("f", seg.file));
+
+    auto out = std::make_shared<std::string>(sz, '\0');
+    if(seg.header.version == 1) {
+        auto r = ZSTD_decompress(out->data(), out->size(), src, end - begin);
+        EVT_ASSERT(!ZSTD_isError(r) && r == sz, block_log_exception,
+            "Cannot decompress chunk ${c} of segment file '${f}': ${e}",
+            ("c", chunk)("f", seg.file)("e", ZSTD_isError(r) ? ZSTD_getErrorName(r) : "size mismatch"));
+    }
+    else {
+        auto err = zstd_dict_decompress(src, end - begin, out->data(), out->size());
+        EVT_ASSERT(err == nullptr, block_log_exception,
+            "Cannot decompress chunk ${c} of segment file '${f}': ${e}", ("c", chunk)("f", seg.file)("e", err));
+    }
+
+    return out;
+}
+
+}  // namespace internal
+
+using namespace internal;
+
+class block_log_segments_impl {
+public:
+    struct cached_chunk {
+        segment_ptr                    seg;
+        uint32_t                       chunk = 0;
+        std::shared_future<chunk_ptr>  data;
+    };
+
+public:
+    // should hold the mutex
+    std::shared_future<chunk_ptr>
+    get_chunk(const segment_ptr& seg, uint32_t chunk, std::launch policy, std::vector<std::shared_future<chunk_ptr>>& evicted) {
+        for(auto& c : cache) {
+            if(c.seg == seg && c.chunk == chunk) {
+                return c.data;
+            }
+        }
+
+        // futures of async tasks block when destroyed, they are evicted out of the lock
+        auto& c = cache[next_cache++ % cache.size()];
+        evicted.emplace_back(std::move(c.data));
+
+        c.seg   = seg;
+        c.chunk = chunk;
+        c.data  = std::async(policy, [seg, chunk] { return decompress_chunk(*seg, chunk); }).share();
+        return c.data;
+    }
+
+    // should hold the mutex
+    segment_ptr
+    find_segment(uint32_t block_num) const {
+        auto it = std::upper_bound(segments.cbegin(), segments.cend(), block_num, [](auto num, auto& s) {
+            return num < s->header.first_block_num;
+        });
+        if(it == segments.cbegin()) {
+            return nullptr;
+        }
+        --it;
+        if(block_num >= (*it)->end_block_num()) {
+            return nullptr;
+        }
+        return *it;
+    }
+
+public:
+    fc::path                 dir;
+    std::vector<segment_ptr> segments;  // in order of first block num
+
+    std::array<cached_chunk, kCachedChunks> cache;
+    size_t                                  next_cache = 0;
+
+    mutable std::mutex mutex;
+};
+
+}  // namespace detail
+
+block_log_segments::block_log_segments(const fc::path& dir)
+    : my(new detail::block_log_segments_impl()) {
+    using namespace detail::internal;
+
+    my->dir = dir;
+    if(!fc::is_directory(dir)) {
+        fc::create_directories(dir);
+    }
+
+    for(auto it = fc::directory_iterator(dir); it != fc::directory_iterator(); ++it) {
+        auto file = *it;
+        if(file.extension().generic_string() != ".seg") {
+            continue;
+        }
+        my->segments.emplace_back(open_segment(file));
+    }
+    std::sort(my->segments.begin(), my->segments.end(), [](auto& a, auto& b) {
+        return a->header.first_block_num < b->header.first_block_num;
+    });
+    for(auto i = 1u; i < my->segments.size(); i++) {
+        EVT_ASSERT(my->segments[i - 1]->end_block_num() <= my->segments[i]->header.first_block_num, block_log_exception,
+            "Segment files '${a}' and '${b}' are overlapped", ("a", my->segments[i - 1]->file)("b", my->segments[i]->file));
+    }
+}
+
+block_log_segments::~block_log_segments() = default;
+
+void
+block_log_segments::add_segment(uint32_t first_block_num, const std::vector<std::string_view>& blocks) {
+    using namespace detail::internal;
+
+    EVT_ASSERT(!blocks.empty(), block_log_exception, "Segment cannot be empty");
+
+    auto name = fmt::format("blocks-{:010}.seg", first_block_num);
+    auto file = my->dir / name;
+    auto tmp  = my->dir / (name + ".tmp");
+
+    auto out = std::ofstream();
+    out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    out.open(tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    auto header = segment_header { kSegmentMagic, kSegmentVersion, first_block_num, (uint32_t)blocks.size(), kChunkBlocks };
+    write_pod(out, header);
+
+    auto chunk_pos = std::vector<uint64_t>();
+    auto offsets   = std::vector<uint32_t>();
+    auto buf       = std::string();
+    offsets.reserve(blocks.size());
+
+    for(auto i = 0u; i < blocks.size(); i += kChunkBlocks) {
+        buf.clear();
+        for(auto j = i; j < std::min<size_t>(i + kChunkBlocks, blocks.size()); j++) {
+            offsets.emplace_back((uint32_t)buf.size());
+            buf.append(blocks[j]);
+        }
+        EVT_ASSERT(buf.size() <= std::numeric_limits<uint32_t>::max(), block_log_exception, "Chunk of segment is too big");
+
+        auto cbuf = zstd_dict_compress(buf.data(), buf.size(), kZstdLevel);
+        chunk_pos.emplace_back((uint64_t)out.tellp());
+        out.write(cbuf.data(), cbuf.size());
+    }
+
+    uint64_t index_pos = out.tellp();
+    chunk_pos.emplace_back(index_pos);
+    out.write((const char*)chunk_pos.data(), chunk_pos.size() * sizeof(uint64_t));
+    out.write((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+    write_pod(out, index_pos);
+    out.close();
+
+    fc::rename(tmp, file);
+    auto seg = open_segment(file);
+
+    std::lock_guard<std::mutex> lock(my->mutex);
+    auto it = std::lower_bound(my->segments.begin(), my->segments.end(), first_block_num, [](auto& s, auto num) {
+        return s->header.first_block_num < num;
+    });
+    if(it != my->segments.end() && (*it)->header.first_block_num == first_block_num) {
+        // left by one interrupted moving of blocks, the file is already replaced
+        *it = std::move(seg);
+    }
+    else {
+        my->segments.insert(it, std::move(seg));
+    }
+}
+
+void
+block_log_segments::prune(uint32_t max_segments) {
+    std::lock_guard<std::mutex> lock(my->mutex);
+    while(my->segments.size() > max_segments) {
+        // readers holding the segment still have it mapped
+        ilog("Removing block log segment: ${f}", ("f", my->segments.front()->file));
+        fc::remove(my->segments.front()->file);
+        my->segments.erase(my->segments.begin());
+    }
+}
+
+void
+block_log_segments::prune_size(uint64_t max_size) {
+    std::lock_guard<std::mutex> lock(my->mutex);
+    auto total = uint64_t(0);
+    for(auto& seg : my->segments) {
+        total += seg->data.size();
+    }
+    while(!my->segments.empty() && total > max_size) {
+        ilog("Removing block log segment: ${f}", ("f", my->segments.front()->file));
+        total -= my->segments.front()->data.size();
+        fc::remove(my->segments.front()->file);
+        my->segments.erase(my->segments.begin());
+    }
+}
+
+void
+block_log_segments::clear() {
+    prune(0);
+}
+
+signed_block_ptr
+block_log_segments::read_block_by_num(uint32_t block_num) const {
+    using namespace detail::internal;
+
+    auto evicted = std::vector<std::shared_future<chunk_ptr>>();
+    auto seg     = segment_ptr();
+    auto data    = std::shared_future<chunk_ptr>();
+    {
+        std::lock_guard<std::mutex> lock(my->mutex);
+
+        seg = my->find_segment(block_num);
+        if(!seg) {
+            return nullptr;
+        }
+
+        auto i     = block_num - seg->header.first_block_num;
+        auto chunk = i / seg->header.chunk_blocks;
+
+        // deferred one is decompressed by the first reader waiting for it
+        data = my->get_chunk(seg, chunk, std::launch::deferred, evicted);
+        if(i % seg->header.chunk_blocks == 0 && chunk + 1 < seg->chunks_num()) {
+            my->get_chunk(seg, chunk + 1, std::launch::async, evicted);
+        }
+    }
+
+    auto& buf    = *data.get();
+    auto  i      = block_num - seg->header.first_block_num;
+    auto  offset = seg->block_offset(i);
+    EVT_ASSERT(offset < buf.size(), block_log_exception,
+        "Block ${n} in segment file '${f}' is malformed", ("n", block_num)("f", seg->file));
+
+    auto ds = fc::datastream<const char*>(buf.data() + offset, buf.size() - offset);
+    auto b  = std::make_shared<signed_block>();
+    fc::raw::unpack(ds, *b);
+    EVT_ASSERT(b->block_num() == block_num, block_log_exception,
+        "Wrong block was read from segment file '${f}'", ("f", seg->file)("returned", b->block_num())("expected", block_num));
+
+    return b;
+}
+
+uint32_t
+block_log_segments::first_block_num() const {
+    std::lock_guard<std::mutex> lock(my->mutex);
+    return my->segments.empty() ? 0 : my->segments.front()->header.first_block_num;
+}
+
+uint32_t
+block_log_segments::end_block_num() const {
+    std::lock_guard<std::mutex> lock(my->mutex);
+    return my->segments.empty() ? 0 : my->segments.back()->end_block_num();
+}
+
+uint64_t
+block_log_segments::size() const {
+    std::lock_guard<std::mutex> lock(my->mutex);
+    auto total = uint64_t(0);
+    for(auto& seg : my->segments) {
+        total += seg->data.size();
+    }
+    return total;
+}
+
+}}  // namespace evt::chain
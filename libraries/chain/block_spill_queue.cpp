@@ -0,0 +1,143 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/block_spill_queue.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain {
+
+block_spill_queue::block_spill_queue(const fc::path& file)
+    : file_(file) {
+    if(!fc::exists(file_.parent_path())) {
+        fc::create_directories(file_.parent_path());
+    }
+    if(!fc::exists(file_)) {
+        auto f = std::ofstream(file_.generic_string(), std::ios::out | std::ios::binary);
+        EVT_ASSERT(f, misc_exception, "Cannot create spill file '${f}'", ("f", file_));
+    }
+    fs_.open(file_.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+    EVT_ASSERT(fs_, misc_exception, "Cannot open spill file '${f}'", ("f", file_));
+
+    // counts the records left last time, the incomplete one at the end is dropped
+    auto total = fc::file_size(file_);
+    auto pos   = uint64_t(0);
+    while(pos + sizeof(uint32_t) <= total) {
+        auto sz = uint32_t(0);
+        fs_.seekg(pos);
+        fs_.read((char*)&sz, sizeof(sz));
+        if(pos + sizeof(sz) + sz > total) {
+            break;
+        }
+        pos += sizeof(sz) + sz;
+        size_++;
+    }
+    if(pos < total) {
+        wlog("Drop incomplete record at the end of spill file '${f}'", ("f", file_));
+        fs_.close();
+        fc::resize_file(file_, pos);
+        fs_.open(file_.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+    }
+    if(size_ > 0) {
+        ilog("${n} blocks are left in spill file '${f}'", ("n", size_)("f", file_));
+    }
+}
+
+void
+block_spill_queue::push(const block_state_ptr& block, bool irreversible, std::deque<transaction_trace_ptr>& traces) {
+    auto pack = [&](auto& ds) {
+        fc::raw::pack(ds, *block);
+        fc::raw::pack(ds, irreversible);
+        fc::raw::pack(ds, fc::unsigned_int((uint32_t)traces.size()));
+        for(auto& t : traces) {
+            fc::raw::pack(ds, *t);
+        }
+    };
+
+    auto ss = fc::datastream<size_t>();
+    pack(ss);
+
+    auto data = std::vector<char>(ss.tellp());
+    auto ds   = fc::datastream<char*>(data.data(), data.size());
+    pack(ds);
+    traces.clear();
+
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+    auto sz   = (uint32_t)data.size();
+    fs_.seekp(0, std::ios::end);
+    fs_.write((char*)&sz, sizeof(sz));
+    fs_.write(data.data(), data.size());
+    fs_.flush();
+    EVT_ASSERT(fs_, misc_exception, "Write spill file '${f}' failed", ("f", file_));
+
+    size_++;
+}
+
+size_t
+block_spill_queue::read(size_t max_items, std::vector<item>& items) {
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+
+    auto n    = size_t(0);
+    auto data = std::vector<char>();
+    while(n < max_items && read_ < size_) {
+        auto sz = uint32_t(0);
+        fs_.seekg(read_pos_);
+        fs_.read((char*)&sz, sizeof(sz));
+        data.resize(sz);
+        fs_.read(data.data(), sz);
+        EVT_ASSERT(fs_, misc_exception, "Read spill file '${f}' failed", ("f", file_));
+
+        auto ds = fc::datastream<const char*>(data.data(), data.size());
+        auto it = item();
+        it.block = std::make_shared<block_state>();
+        fc::raw::unpack(ds, *it.block);
+        fc::raw::unpack(ds, it.irreversible);
+
+        auto num = fc::unsigned_int();
+        fc::raw::unpack(ds, num);
+        it.traces.reserve(num.value);
+        for(auto i = 0u; i < num.value; i++) {
+            auto t = std::make_shared<transaction_trace>();
+            fc::raw::unpack(ds, *t);
+            it.traces.emplace_back(std::move(t));
+        }
+        items.emplace_back(std::move(it));
+
+        read_pos_ += sizeof(sz) + sz;
+        read_++;
+        n++;
+    }
+    return n;
+}
+
+void
+block_spill_queue::release(size_t n) {
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+    EVT_ASSERT(n <= read_, misc_exception, "Cannot release the records not read from spill file");
+
+    size_ -= n;
+    read_ -= n;
+    if(size_ == 0) {
+        reset();
+    }
+}
+
+size_t
+block_spill_queue::size() const {
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+    return size_;
+}
+
+void
+block_spill_queue::reset() {
+    // all the records are released, file is started over
+    fs_.close();
+    fc::resize_file(file_, 0);
+    fs_.open(file_.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+    EVT_ASSERT(fs_, misc_exception, "Cannot open spill file '${f}'", ("f", file_));
+    read_pos_ = 0;
+}
+
+}}  // namespace evt::chain
@@ -3,10 +3,21 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain/block_state.hpp>
+#include <evt/chain/config.hpp>
 #include <evt/chain/exceptions.hpp>
 
 namespace evt { namespace chain {
 
+namespace internal {
+
+pool_allocator<block_state>&
+get_block_state_allocator() {
+    static auto allocator = pool_allocator<block_state>(std::make_shared<block_pool>(config::default_block_state_pool_size));
+    return allocator;
+}
+
+}  // namespace internal
+
 block_state::block_state(const block_header_state& prev, block_timestamp_type when)
     : block_header_state(prev.generate_next(when))
     , block(std::make_shared<signed_block>()) {
@@ -7,6 +7,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/io/varint.hpp>
+#include <rapidjson/error/en.h>
 
 #include <evt/chain/chain_config.hpp>
 #include <evt/chain/transaction.hpp>
@@ -64,6 +65,63 @@ pack_unpack() {
         });
 }
 
+// packs plain built-in types from json without an intermediate variant
+// returns false for the inputs which need the conversions of variant
+template <typename T>
+abi_serializer::json_pack_function
+json_pack() {
+    return [](const abi_serializer::json_value& v, fc::datastream<char*>& ds) -> bool {
+        if constexpr(std::is_same_v<T, string>) {
+            if(!v.IsString()) {
+                return false;
+            }
+            fc::raw::pack(ds, fc::unsigned_int(v.GetStringLength()));
+            ds.write(v.GetString(), v.GetStringLength());
+        }
+        else if constexpr(std::is_same_v<T, name> || std::is_same_v<T, name128>) {
+            if(!v.IsString()) {
+                return false;
+            }
+            fc::raw::pack(ds, T(v.GetString()));
+        }
+        else {
+            if(v.IsUint64()) {
+                fc::raw::pack(ds, (T)v.GetUint64());
+            }
+            else if(v.IsInt64()) {
+                fc::raw::pack(ds, (T)v.GetInt64());
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    };
+}
+
+// writes plain built-in types to json without an intermediate variant
+template <typename T>
+abi_serializer::json_function
+json_unpack() {
+    return [](fc::datastream<const char*>& stream, abi_serializer::json_writer& writer) {
+        T temp;
+        fc::raw::unpack(stream, temp);
+        if constexpr(std::is_same_v<T, string>) {
+            writer.String(temp.c_str(), temp.size());
+        }
+        else if constexpr(std::is_same_v<T, name> || std::is_same_v<T, name128>) {
+            auto str = temp.to_string();
+            writer.String(str.c_str(), str.size());
+        }
+        else if constexpr(std::is_signed_v<T>) {
+            writer.Int64(temp);
+        }
+        else {
+            writer.Uint64(temp);
+        }
+    };
+}
+
 abi_serializer::abi_serializer(const abi_def& abi, const std::chrono::microseconds max_serialization_time_)
     : max_serialization_time_(max_serialization_time_) {
     configure_built_in_types();
@@ -74,6 +132,9 @@ void
 abi_serializer::add_specialized_unpack_pack(const string& name,
                                             std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack) {
     built_in_types_[name] = std::move(unpack_pack);
+    built_in_json_.erase(name);
+    built_in_json_pack_.erase(name);
+    compile_plans();
 }
 
 void
@@ -120,11 +181,39 @@ abi_serializer::configure_built_in_types() {
     built_in_types_.emplace("producer_schedule", pack_unpack<producer_schedule_type>());
     built_in_types_.emplace("extensions", pack_unpack<extensions_type>());
     built_in_types_.emplace("evt_link", pack_unpack<evt_link>());
-    
+
+    built_in_json_.emplace("string", json_unpack<string>());
+    built_in_json_.emplace("name", json_unpack<name>());
+    built_in_json_.emplace("name128", json_unpack<name128>());
+    built_in_json_.emplace("bool", json_unpack<uint8_t>());
+    built_in_json_.emplace("int8", json_unpack<int8_t>());
+    built_in_json_.emplace("uint8", json_unpack<uint8_t>());
+    built_in_json_.emplace("int16", json_unpack<int16_t>());
+    built_in_json_.emplace("uint16", json_unpack<uint16_t>());
+    built_in_json_.emplace("int32", json_unpack<int32_t>());
+    built_in_json_.emplace("uint32", json_unpack<uint32_t>());
+    built_in_json_.emplace("int64", json_unpack<int64_t>());
+    built_in_json_.emplace("uint64", json_unpack<uint64_t>());
+
+    built_in_json_pack_.emplace("string", json_pack<string>());
+    built_in_json_pack_.emplace("name", json_pack<name>());
+    built_in_json_pack_.emplace("name128", json_pack<name128>());
+    built_in_json_pack_.emplace("int8", json_pack<int8_t>());
+    built_in_json_pack_.emplace("uint8", json_pack<uint8_t>());
+    built_in_json_pack_.emplace("int16", json_pack<int16_t>());
+    built_in_json_pack_.emplace("uint16", json_pack<uint16_t>());
+    built_in_json_pack_.emplace("int32", json_pack<int32_t>());
+    built_in_json_pack_.emplace("uint32", json_pack<uint32_t>());
+    built_in_json_pack_.emplace("int64", json_pack<int64_t>());
+    built_in_json_pack_.emplace("uint64", json_pack<uint64_t>());
+
+    compile_plans();
 }
 
 void
 abi_serializer::set_abi(const abi_def& abi) {
+    plans_.index.clear();
+    plans_.storage.clear();
     typedefs_.clear();
     structs_.clear();
     variants_.clear();
@@ -154,6 +243,7 @@ abi_serializer::set_abi(const abi_def& abi) {
     EVT_ASSERT(enums_.size() == abi.enums.size(), duplicate_abi_enum_def_exception, "duplicate enum definition detected");
 
     validate();
+    compile_plans();
 }
 
 bool
@@ -323,16 +413,126 @@ abi_serializer::resolve_type(const type_name& type) const {
 }
 
 void
-abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const char*>& stream,
+abi_serializer::compile_plans() {
+    plans_.index.clear();
+    plans_.storage.clear();
+
+    for(auto& it : built_in_types_) {
+        compile_plan(it.first, plans_);
+    }
+    for(auto& it : typedefs_) {
+        compile_plan(it.first, plans_);
+    }
+    for(auto& it : structs_) {
+        compile_plan(it.first, plans_);
+    }
+    for(auto& it : variants_) {
+        compile_plan(it.first, plans_);
+    }
+    for(auto& it : enums_) {
+        compile_plan(it.first, plans_);
+    }
+}
+
+// plans not found in `plans_` are compiled into `plans`
+// resolving order is the same as the one used by packing and unpacking before
+const abi_serializer::type_plan*
+abi_serializer::compile_plan(const type_name& type, type_plans& plans) const {
+    auto it = plans_.index.find(type);
+    if(it != plans_.index.cend()) {
+        return it->second;
+    }
+    it = plans.index.find(type);
+    if(it != plans.index.cend()) {
+        return it->second;
+    }
+
+    auto rtype = resolve_type(type);
+    if(rtype != type) {
+        auto p = compile_plan(rtype, plans);
+        plans.index.emplace(type, p);
+        return p;
+    }
+
+    // register before compiling the nested types, so that recursive types end here
+    auto& p = plans.storage.emplace_back();
+    plans.index.emplace(type, &p);
+    p.name = type;
+
+    auto ftype = fundamental_type(type);
+    auto btype = built_in_types_.find(ftype);
+    if(btype != built_in_types_.cend()) {
+        p.kind             = type_plan::kBuiltin;
+        p.builtin          = &btype->second;
+        p.builtin_array    = is_array(type);
+        p.builtin_optional = is_optional(type);
+        if(!p.builtin_array && !p.builtin_optional) {
+            auto jtype = built_in_json_.find(ftype);
+            if(jtype != built_in_json_.cend()) {
+                p.json = jtype->second;
+            }
+            auto ptype = built_in_json_pack_.find(ftype);
+            if(ptype != built_in_json_pack_.cend()) {
+                p.json_pack = ptype->second;
+            }
+        }
+    }
+    else if(is_array(type)) {
+        p.kind    = type_plan::kArray;
+        p.element = compile_plan(ftype, plans);
+    }
+    else if(is_optional(type)) {
+        p.kind    = type_plan::kOptional;
+        p.element = compile_plan(ftype, plans);
+    }
+    else if(auto v_itr = variants_.find(type); v_itr != variants_.cend()) {
+        p.kind        = type_plan::kVariant;
+        p.variant_itr = v_itr;
+        for(auto& field : v_itr->second.fields) {
+            p.fields.emplace_back(type_plan::field_plan{ compile_plan(field.type, plans), is_optional(field.type) });
+        }
+    }
+    else if(auto e_itr = enums_.find(type); e_itr != enums_.cend()) {
+        p.kind     = type_plan::kEnum;
+        p.enum_itr = e_itr;
+        p.element  = compile_plan(e_itr->second.integer, plans);
+    }
+    else if(auto s_itr = structs_.find(type); s_itr != structs_.cend()) {
+        p.kind       = type_plan::kStruct;
+        p.struct_itr = s_itr;
+        p.action     = (type == "action");
+        if(s_itr->second.base != type_name()) {
+            p.base = compile_plan(resolve_type(s_itr->second.base), plans);
+        }
+        for(auto& field : s_itr->second.fields) {
+            p.fields.emplace_back(type_plan::field_plan{ compile_plan(field.type, plans), is_optional(field.type), fc::intern_key(field.name) });
+        }
+    }
+    return &p;
+}
+
+const abi_serializer::type_plan&
+abi_serializer::find_plan(const type_name& type, std::optional<type_plans>& plans) const {
+    auto it = plans_.index.find(type);
+    if(it != plans_.index.cend()) {
+        return *it->second;
+    }
+    // types like `T[]?` which are not used by abi itself
+    plans.emplace();
+    return *compile_plan(type, *plans);
+}
+
+void
+abi_serializer::_binary_to_variant(const type_plan& plan, fc::datastream<const char*>& stream,
                                    fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx) const {
-    auto h     = ctx.enter_scope();
-    auto s_itr = structs_.find(type);
-    EVT_ASSERT(s_itr != structs_.end(), invalid_type_inside_abi, "Unknown type ${type}", ("type", ctx.maybe_shorten(type)));
+    auto h = ctx.enter_scope();
+    EVT_ASSERT(plan.kind == type_plan::kStruct, invalid_type_inside_abi, "Unknown type ${type}", ("type", ctx.maybe_shorten(plan.name)));
 
+    auto& s_itr = plan.struct_itr;
     ctx.hint_struct_type_if_in_array(s_itr);
     const auto& st = s_itr->second;
-    if(st.base != type_name()) {
-        _binary_to_variant(resolve_type(st.base), stream, obj, ctx);
+    if(plan.base) {
+        _binary_to_variant(*plan.base, stream, obj, ctx);
     }
 
     for(auto i = 0u; i < st.fields.size(); ++i) {
@@ -342,27 +542,24 @@ abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const c
                       ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()));
         }
         auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
-        obj(field.name, _binary_to_variant(resolve_type(field.type), stream, ctx));
+        obj(plan.fields[i].name, _binary_to_variant(*plan.fields[i].plan, stream, ctx));
     }
 }
 
 fc::variant
-abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const char*>& stream,
+abi_serializer::_binary_to_variant(const type_plan& plan, fc::datastream<const char*>& stream,
                                    impl::binary_to_variant_context& ctx) const {
-    auto h     = ctx.enter_scope();
-    auto rtype = resolve_type(type);
-    auto ftype = fundamental_type(rtype);
-    auto btype = built_in_types_.find(ftype);
+    auto h = ctx.enter_scope();
 
-    if(btype != built_in_types_.end()) {
+    switch(plan.kind) {
+    case type_plan::kBuiltin: {
         try {
-            return btype->second.first(stream, is_array(rtype), is_optional(rtype));
+            return plan.builtin->first(stream, plan.builtin_array, plan.builtin_optional);
         }
         EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack ${class} type '${type}' while processing '${p}'",
-                               ("class", is_array(rtype) ? "array of built-in" : is_optional(rtype) ? "optional of built-in" : "built-in")("type", ftype)("p", ctx.get_path_string()))
+                               ("class", plan.builtin_array ? "array of built-in" : plan.builtin_optional ? "optional of built-in" : "built-in")("type", fundamental_type(plan.name))("p", ctx.get_path_string()))
     }
-
-    if(is_array(rtype)) {
+    case type_plan::kArray: {
         ctx.hint_array_type_if_in_array();
 
         auto size = fc::unsigned_int();
@@ -375,7 +572,7 @@ abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const c
         auto h1   = ctx.push_to_path(impl::array_index_path_item{});
         for(decltype(size.value) i = 0; i < size; ++i) {
             ctx.set_array_index_of_path_back(i);
-            auto v = _binary_to_variant(ftype, stream, ctx);
+            auto v = _binary_to_variant(*plan.element, stream, ctx);
             // QUESTION: Is it actually desired behavior to require the returned variant to not be null?
             //           This would disallow arrays of optionals in general (though if all optionals in the array were present it would be allowed).
             //           Is there any scenario in which the returned variant would be null other than in the case of an empty optional?
@@ -388,16 +585,16 @@ abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const c
         
         return fc::variant(std::move(vars));
     }
-    else if(is_optional(rtype)) {
+    case type_plan::kOptional: {
         char flag;
         try {
             fc::raw::unpack(stream, flag);
         }
         EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack presence flag of optional '${p}'", ("p", ctx.get_path_string()))
-        return flag ? _binary_to_variant(ftype, stream, ctx) : fc::variant();
+        return flag ? _binary_to_variant(*plan.element, stream, ctx) : fc::variant();
     }
-    else if(is_variant(rtype)) {
-        auto v_itr = variants_.find(rtype);
+    case type_plan::kVariant: {
+        auto& v_itr = plan.variant_itr;
         ctx.hint_variant_type_if_in_array(v_itr);
 
         auto i = fc::unsigned_int();
@@ -413,28 +610,39 @@ abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const c
         auto h1 = ctx.push_to_path(impl::variant_path_item{.parent_itr = v_itr, .index = i});
 
         vo["type"] = vt.fields[i].name;
-        vo["data"] = _binary_to_variant(vt.fields[i].type, stream, ctx);
+        vo["data"] = _binary_to_variant(*plan.fields[i].plan, stream, ctx);
 
         return fc::variant(std::move(vo));
     }
-    else if(is_enum(rtype)) {
-        auto e_itr = enums_.find(rtype);
+    case type_plan::kEnum: {
+        auto& e_itr = plan.enum_itr;
         ctx.hint_enum_type_if_in_array(e_itr);
 
         auto& et = e_itr->second;
-        auto  ev = _binary_to_variant(et.integer, stream, ctx);
+        auto  ev = _binary_to_variant(*plan.element, stream, ctx);
         // we assume the enum is start at 0 and each item is increased by 1
         EVT_ASSERT2(ev.as_uint64() < et.fields.size(), unpack_exception, "Value of enum '{}' is not valid", ctx.get_path_string());
 
         return fc::variant(et.fields[ev.as_uint64()]);
     }
+    default: {
+        break;
+    }
+    }  // switch
 
     auto mvo = fc::mutable_variant_object();
-    _binary_to_variant(rtype, stream, mvo, ctx);
+    _binary_to_variant(plan, stream, mvo, ctx);
     
     return fc::variant(std::move(mvo));
 }
 
+fc::variant
+abi_serializer::_binary_to_variant(const type_name& type, fc::datastream<const char*>& stream,
+                                   impl::binary_to_variant_context& ctx) const {
+    auto plans = std::optional<type_plans>();
+    return _binary_to_variant(find_plan(type, plans), stream, ctx);
+}
+
 fc::variant
 abi_serializer::_binary_to_variant(const type_name& type, const bytes& binary, impl::binary_to_variant_context& ctx) const {
     auto h   = ctx.enter_scope();
@@ -460,17 +668,522 @@ abi_serializer::binary_to_variant(const type_name& type, fc::datastream<const ch
     return _binary_to_variant(type, binary, ctx);
 }
 
+namespace internal {
+
+// same output as the rapidjson generator of fc::json
 void
-abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const {
+write_variant(abi_serializer::json_writer& writer, const fc::variant& v) {
+    switch(v.get_type()) {
+    case fc::variant::null_type: {
+        writer.Null();
+        break;
+    }
+    case fc::variant::int64_type: {
+        writer.Int64(v.as_int64());
+        break;
+    }
+    case fc::variant::uint64_type: {
+        writer.Uint64(v.as_uint64());
+        break;
+    }
+    case fc::variant::double_type: {
+        writer.Double(v.as_double());
+        break;
+    }
+    case fc::variant::bool_type: {
+        writer.Bool(v.as_bool());
+        break;
+    }
+    case fc::variant::string_type: {
+        auto& str = v.get_string();
+        writer.String(str.c_str(), str.size());
+        break;
+    }
+    case fc::variant::blob_type: {
+        auto& blob = v.get_blob();
+        writer.String(blob.data.data(), blob.data.size());
+        break;
+    }
+    case fc::variant::array_type: {
+        writer.StartArray();
+        for(auto& a : v.get_array()) {
+            write_variant(writer, a);
+        }
+        writer.EndArray();
+        break;
+    }
+    case fc::variant::object_type: {
+        writer.StartObject();
+        for(auto& it : v.get_object()) {
+            auto& key = it.key();
+            writer.Key(key.c_str(), key.size());
+            write_variant(writer, it.value());
+        }
+        writer.EndObject();
+        break;
+    }
+    default: {
+        EVT_THROW2(unpack_exception, "Unsupported variant type: {}", (int)v.get_type());
+    }
+    }  // switch
+}
+
+}  // namespace internal
+
+void
+abi_serializer::_binary_to_json_fields(const type_plan& plan, fc::datastream<const char*>& stream,
+                                       json_writer& writer, impl::binary_to_variant_context& ctx) const {
+    auto h = ctx.enter_scope();
+    EVT_ASSERT(plan.kind == type_plan::kStruct, invalid_type_inside_abi, "Unknown type ${type}", ("type", ctx.maybe_shorten(plan.name)));
+
+    auto& s_itr = plan.struct_itr;
+    ctx.hint_struct_type_if_in_array(s_itr);
+    const auto& st = s_itr->second;
+    if(plan.base) {
+        _binary_to_json_fields(*plan.base, stream, writer, ctx);
+    }
+
+    for(auto i = 0u; i < st.fields.size(); ++i) {
+        const auto& field = st.fields[i];
+        if(!stream.remaining()) {
+            EVT_THROW(unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                      ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()));
+        }
+        auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
+        writer.Key(field.name.c_str(), field.name.size());
+        _binary_to_json(*plan.fields[i].plan, stream, writer, ctx);
+    }
+}
+
+// follows `_binary_to_variant`, returns whether null is written
+bool
+abi_serializer::_binary_to_json(const type_plan& plan, fc::datastream<const char*>& stream,
+                                json_writer& writer, impl::binary_to_variant_context& ctx) const {
+    auto h = ctx.enter_scope();
+
+    switch(plan.kind) {
+    case type_plan::kBuiltin: {
+        try {
+            if(plan.json) {
+                plan.json(stream, writer);
+                return false;
+            }
+            auto v = plan.builtin->first(stream, plan.builtin_array, plan.builtin_optional);
+            internal::write_variant(writer, v);
+            return v.is_null();
+        }
+        EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack ${class} type '${type}' while processing '${p}'",
+                               ("class", plan.builtin_array ? "array of built-in" : plan.builtin_optional ? "optional of built-in" : "built-in")("type", fundamental_type(plan.name))("p", ctx.get_path_string()))
+    }
+    case type_plan::kArray: {
+        ctx.hint_array_type_if_in_array();
+
+        auto size = fc::unsigned_int();
+        try {
+            fc::raw::unpack(stream, size);
+        }
+        EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack size of array '${p}'", ("p", ctx.get_path_string()))
+
+        writer.StartArray();
+        auto h1 = ctx.push_to_path(impl::array_index_path_item{});
+        for(decltype(size.value) i = 0; i < size; ++i) {
+            ctx.set_array_index_of_path_back(i);
+            auto null = _binary_to_json(*plan.element, stream, writer, ctx);
+            EVT_ASSERT(!null, unpack_exception, "Invalid packed array '${p}'", ("p", ctx.get_path_string()));
+        }
+        writer.EndArray();
+        return false;
+    }
+    case type_plan::kOptional: {
+        char flag;
+        try {
+            fc::raw::unpack(stream, flag);
+        }
+        EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack presence flag of optional '${p}'", ("p", ctx.get_path_string()))
+        if(flag) {
+            return _binary_to_json(*plan.element, stream, writer, ctx);
+        }
+        writer.Null();
+        return true;
+    }
+    case type_plan::kVariant: {
+        auto& v_itr = plan.variant_itr;
+        ctx.hint_variant_type_if_in_array(v_itr);
+
+        auto i = fc::unsigned_int();
+        try {
+            fc::raw::unpack(stream, i);
+        }
+        EVT_RETHROW_EXCEPTIONS(unpack_exception, "Unable to unpack index of variant '${p}'", ("p", ctx.get_path_string()));
+
+        auto& vt = v_itr->second;
+        EVT_ASSERT2((uint32_t)i < vt.fields.size(), unpack_exception, "Index of variant '{}' if not valid", ctx.get_path_string());
+
+        auto h1 = ctx.push_to_path(impl::variant_path_item{.parent_itr = v_itr, .index = i});
+
+        auto& tname = vt.fields[i].name;
+        writer.StartObject();
+        writer.Key("type", 4);
+        writer.String(tname.c_str(), tname.size());
+        writer.Key("data", 4);
+        _binary_to_json(*plan.fields[i].plan, stream, writer, ctx);
+        writer.EndObject();
+        return false;
+    }
+    case type_plan::kEnum: {
+        auto& e_itr = plan.enum_itr;
+        ctx.hint_enum_type_if_in_array(e_itr);
+
+        auto& et = e_itr->second;
+        auto  ev = _binary_to_variant(*plan.element, stream, ctx);
+        // we assume the enum is start at 0 and each item is increased by 1
+        EVT_ASSERT2(ev.as_uint64() < et.fields.size(), unpack_exception, "Value of enum '{}' is not valid", ctx.get_path_string());
+
+        auto& str = et.fields[ev.as_uint64()];
+        writer.String(str.c_str(), str.size());
+        return false;
+    }
+    default: {
+        break;
+    }
+    }  // switch
+
+    writer.StartObject();
+    _binary_to_json_fields(plan, stream, writer, ctx);
+    writer.EndObject();
+    return false;
+}
+
+void
+abi_serializer::binary_to_json(const type_name& type, fc::datastream<const char*>& binary, json_writer& writer,
+                               const execution_context& exec_ctx, bool short_path) const {
+    auto ctx = impl::binary_to_variant_context(*this, exec_ctx, type);
+    ctx.short_path = short_path;
+
+    auto plans = std::optional<type_plans>();
+    _binary_to_json(find_plan(type, plans), binary, writer, ctx);
+}
+
+string
+abi_serializer::binary_to_json(const type_name& type, const bytes& binary, const execution_context& exec_ctx, bool short_path) const {
+    auto buffer = ::rapidjson::StringBuffer();
+    auto writer = json_writer(buffer);
+    auto ds     = fc::datastream<const char*>(binary.data(), binary.size());
+
+    binary_to_json(type, ds, writer, exec_ctx, short_path);
+    if(ds.remaining() > 0) {
+        EVT_THROW2(unpack_exception, "Binary buffer is not EOF after unpack variable, remaining: {} bytes.", ds.remaining());
+    }
+    return string(buffer.GetString(), buffer.GetSize());
+}
+
+namespace internal {
+
+// same variant as the one parsed by the rapidjson parser of fc::json
+fc::variant
+read_variant(const abi_serializer::json_value& v) {
+    switch(v.GetType()) {
+    case ::rapidjson::kNullType: {
+        return fc::variant();
+    }
+    case ::rapidjson::kFalseType:
+    case ::rapidjson::kTrueType: {
+        return fc::variant(v.GetBool());
+    }
+    case ::rapidjson::kStringType: {
+        return fc::variant(string(v.GetString(), v.GetStringLength()));
+    }
+    case ::rapidjson::kNumberType: {
+        if(v.IsDouble()) {
+            return fc::variant(v.GetDouble());
+        }
+        else if(v.IsUint64()) {
+            return fc::variant(v.GetUint64());
+        }
+        return fc::variant(v.GetInt64());
+    }
+    case ::rapidjson::kArrayType: {
+        auto vars = fc::variants();
+        vars.reserve(v.Size());
+        for(auto& a : v.GetArray()) {
+            vars.emplace_back(read_variant(a));
+        }
+        return fc::variant(std::move(vars));
+    }
+    case ::rapidjson::kObjectType: {
+        auto mvo = fc::mutable_variant_object();
+        for(auto& it : v.GetObject()) {
+            mvo(string(it.name.GetString(), it.name.GetStringLength()), read_variant(it.value));
+        }
+        return fc::variant(std::move(mvo));
+    }
+    default: {
+        EVT_THROW2(pack_exception, "Unsupported json type: {}", (int)v.GetType());
+    }
+    }  // switch
+}
+
+inline const abi_serializer::json_value*
+find_member(const abi_serializer::json_value& v, const string& name) {
+    auto it = v.FindMember(::rapidjson::StringRef(name.c_str(), name.size()));
+    if(it == v.MemberEnd()) {
+        return nullptr;
+    }
+    return &it->value;
+}
+
+}  // namespace internal
+
+// follows `_variant_to_binary`
+void
+abi_serializer::_json_to_binary(const type_plan& plan, const json_value& value, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const {
+    const auto& type = plan.name;
     try {
-        auto h     = ctx.enter_scope();
-        auto rtype = resolve_type(type);
+        auto h = ctx.enter_scope();
 
-        auto btype = built_in_types_.find(fundamental_type(rtype));
-        if(btype != built_in_types_.end()) {
-            btype->second.second(var, ds, is_array(rtype), is_optional(rtype));
+        switch(plan.kind) {
+        case type_plan::kBuiltin: {
+            if(!plan.json_pack || !plan.json_pack(value, ds)) {
+                plan.builtin->second(internal::read_variant(value), ds, plan.builtin_array, plan.builtin_optional);
+            }
+            break;
         }
-        else if(is_array(rtype)) {
+        case type_plan::kArray: {
+            ctx.hint_array_type_if_in_array();
+            EVT_ASSERT2(value.IsArray(), pack_exception, "Expect array while processing '{}'", ctx.get_path_string());
+            fc::raw::pack(ds, (fc::unsigned_int)value.Size());
+
+            auto h1 = ctx.push_to_path(impl::array_index_path_item{});
+
+            int64_t i = 0;
+            for(const auto& v : value.GetArray()) {
+                ctx.set_array_index_of_path_back(i);
+                _json_to_binary(*plan.element, v, ds, ctx);
+                ++i;
+            }
+            break;
+        }
+        case type_plan::kOptional: {
+            char flag = 1;
+            if(value.IsNull()) {
+                flag = 0;
+            }
+            fc::raw::pack(ds, flag);
+            if(flag) {
+                _json_to_binary(*plan.element, value, ds, ctx);
+            }
+            break;
+        }
+        case type_plan::kVariant: {
+            auto& v_itr = plan.variant_itr;
+            ctx.hint_variant_type_if_in_array(v_itr);
+
+            auto& vt = v_itr->second;
+            EVT_ASSERT2(value.IsObject(), pack_exception, "Expect object while processing variant '{}'", ctx.get_path_string());
+
+            auto dtype = internal::find_member(value, "type");
+            auto data  = internal::find_member(value, "data");
+            EVT_ASSERT2(dtype, pack_exception,
+                "Missing field '{}' in input object while processing variant '{}'", "type", ctx.get_path_string());
+            EVT_ASSERT2(dtype->IsString(), pack_exception,
+                "Invalid field '{}' in input object while processing variant '{}', it must be string type", "type", ctx.get_path_string());
+            EVT_ASSERT2(data, pack_exception,
+                "Missing field '{}' in input object while processing variant '{}'", "data", ctx.get_path_string());
+
+            auto index = 0u;
+            for(auto& field : vt.fields) {
+                if(field.name.size() == dtype->GetStringLength() && field.name == dtype->GetString()) {
+                    break;
+                }
+                index++;
+            }
+            EVT_ASSERT2(index < vt.fields.size(), pack_exception, "Invalid 'type' value of variant '{}'", ctx.get_path_string());
+
+            fc::raw::pack(ds, (fc::unsigned_int)index);
+
+            auto h1 = ctx.push_to_path(impl::variant_path_item{.parent_itr = v_itr, .index = index});
+            _json_to_binary(*plan.fields[index].plan, *data, ds, ctx);
+            break;
+        }
+        case type_plan::kEnum: {
+            auto& e_itr = plan.enum_itr;
+            ctx.hint_enum_type_if_in_array(e_itr);
+
+            auto& et = e_itr->second;
+            EVT_ASSERT2(value.IsString(), pack_exception, "Expect string while processing enum '{}'", ctx.get_path_string());
+
+            auto index = 0u;
+            for(auto& field : et.fields) {
+                if(field.size() == value.GetStringLength() && field == value.GetString()) {
+                    break;
+                }
+                index++;
+            }
+            EVT_ASSERT2(index < et.fields.size(), pack_exception, "Invalid value of enum '{}'", ctx.get_path_string());
+
+            _variant_to_binary(*plan.element, fc::variant(index), ds, ctx);
+            break;
+        }
+        case type_plan::kStruct: {
+            auto& s_itr = plan.struct_itr;
+            ctx.hint_struct_type_if_in_array(s_itr);
+
+            auto& st = s_itr->second;
+            if(value.IsObject()) {
+                if(plan.action) {
+                    _json_to_action(plan, value, ds, ctx);
+                    break;
+                }
+                if(plan.base) {
+                    _json_to_binary(*plan.base, value, ds, ctx);
+                }
+                for(uint32_t i = 0; i < st.fields.size(); ++i) {
+                    const auto& field = st.fields[i];
+                    const auto& fplan = plan.fields[i];
+                    if(auto v = internal::find_member(value, field.name)) {
+                        auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
+                        _json_to_binary(*fplan.plan, *v, ds, ctx);
+                    }
+                    else if(fplan.optional) {
+                        auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
+                        _json_to_binary(*fplan.plan, json_value(), ds, ctx);
+                    }
+                    else {
+                        EVT_THROW(pack_exception, "Missing field '${f}' in input object while processing struct '${p}'",
+                                  ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()));
+                    }
+                }
+            }
+            else if(value.IsArray()) {
+                EVT_ASSERT(st.base == type_name(), invalid_type_inside_abi,
+                           "Using input array to specify the fields of the derived struct '${p}'; input arrays are currently only allowed for structs_ without a base",
+                           ("p", ctx.get_path_string()));
+                for(uint32_t i = 0; i < st.fields.size(); ++i) {
+                    const auto& field = st.fields[i];
+                    if(value.Size() > i) {
+                        auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
+                        _json_to_binary(*plan.fields[i].plan, value[i], ds, ctx);
+                    }
+                    else {
+                        EVT_THROW(pack_exception, "Early end to input array specifying the fields of struct '${p}'; require input for field '${f}'",
+                                  ("p", ctx.get_path_string())("f", ctx.maybe_shorten(field.name)));
+                    }
+                }
+            }
+            else {
+                EVT_THROW(pack_exception, "Unexpected input encountered while processing struct '${p}'", ("p", ctx.get_path_string()));
+            }
+            break;
+        }
+        default: {
+            EVT_THROW(invalid_type_inside_abi, "Unknown type ${type}", ("type", ctx.maybe_shorten(type)));
+        }
+        }  // switch
+    }
+    FC_CAPTURE_AND_RETHROW((type))
+}
+
+// follows `abi_from_variant::extract` of action
+void
+abi_serializer::_json_to_action(const type_plan& plan, const json_value& value, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const {
+    auto name   = internal::find_member(value, "name");
+    auto domain = internal::find_member(value, "domain");
+    auto key    = internal::find_member(value, "key");
+    EVT_ASSERT(name, action_type_exception, "Missing name");
+    EVT_ASSERT(domain, action_type_exception, "Missing domain");
+    EVT_ASSERT(key, action_type_exception, "Missing key");
+
+    auto act = action();
+    fc::from_variant(internal::read_variant(*name), act.name);
+    fc::from_variant(internal::read_variant(*domain), act.domain);
+    fc::from_variant(internal::read_variant(*key), act.key);
+
+    auto valid_empty_data = false;
+    if(auto data = internal::find_member(value, "data")) {
+        if(data->IsString()) {
+            fc::from_variant(internal::read_variant(*data), act.data);
+            valid_empty_data = act.data.empty();
+        }
+        else if(data->IsObject()) {
+            auto type = ctx.exec_ctx.get_acttype_name(act.name);
+            if(!type.empty()) {
+                auto _ctx = impl::variant_to_binary_context(ctx, type);
+                _ctx.short_path = true;
+
+                fc::raw::pack(ds, act.name);
+                fc::raw::pack(ds, act.domain);
+                fc::raw::pack(ds, act.key);
+
+                // data is packed in place into the rest of `ds` after the space reserved for its size
+                // then moved to follow the size once it's known, no temporary buffer is needed
+                constexpr auto kMaxSizeBytes = 5u;  // max packed size of unsigned_int
+                EVT_ASSERT(ds.remaining() >= kMaxSizeBytes, pack_exception, "Not enough space to pack action data");
+
+                auto begin = ds.pos() + kMaxSizeBytes;
+                auto ds2   = fc::datastream<char*>(begin, ds.remaining() - kMaxSizeBytes);
+                auto plans = std::optional<type_plans>();
+                _json_to_binary(find_plan(type, plans), *data, ds2, _ctx);
+
+                auto sz = ds2.tellp();
+                fc::raw::pack(ds, fc::unsigned_int((uint32_t)sz));
+                memmove(ds.pos(), begin, sz);
+                ds.skip(sz);
+                return;
+            }
+        }
+    }
+
+    if(!valid_empty_data && act.data.empty()) {
+        auto data = internal::find_member(value, "hex_data");
+        if(data && data->IsString()) {
+            fc::from_variant(internal::read_variant(*data), act.data);
+        }
+    }
+
+    EVT_ASSERT(valid_empty_data || !act.data.empty(), packed_transaction_type_exception,
+               "Failed to deserialize data for ${name}", ("name", act.name));
+    fc::raw::pack(ds, act);
+}
+
+void
+abi_serializer::json_to_binary(const type_name& type, const json_value& value, fc::datastream<char*>& ds,
+                               const execution_context& exec_ctx, bool short_path) const {
+    auto ctx = impl::variant_to_binary_context(*this, exec_ctx, type);
+    ctx.short_path = short_path;
+
+    EVT_ASSERT2(_is_type(type), unknown_abi_type_exception, "Unknown type: {} in ABI", type);
+
+    auto plans = std::optional<type_plans>();
+    _json_to_binary(find_plan(type, plans), value, ds, ctx);
+}
+
+bytes
+abi_serializer::json_to_binary(const type_name& type, const string& json, const execution_context& exec_ctx, bool short_path) const {
+    auto doc = ::rapidjson::Document();
+    doc.Parse(json.c_str(), json.size());
+    EVT_ASSERT2(!doc.HasParseError(), pack_exception, "Unexpected content, err: {}, offset: {}",
+        ::rapidjson::GetParseError_En(doc.GetParseError()), doc.GetErrorOffset());
+
+    auto temp = bytes(1024 * 1024);
+    auto ds   = fc::datastream<char*>(temp.data(), temp.size());
+
+    json_to_binary(type, doc, ds, exec_ctx, short_path);
+    temp.resize(ds.tellp());
+    return temp;
+}
+
+void
+abi_serializer::_variant_to_binary(const type_plan& plan, const fc::variant& var, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const {
+    const auto& type = plan.name;
+    try {
+        auto h = ctx.enter_scope();
+
+        switch(plan.kind) {
+        case type_plan::kBuiltin: {
+            plan.builtin->second(var, ds, plan.builtin_array, plan.builtin_optional);
+            break;
+        }
+        case type_plan::kArray: {
             ctx.hint_array_type_if_in_array();
             auto& vars = var.get_array();
             fc::raw::pack(ds, (fc::unsigned_int)vars.size());
@@ -480,22 +1193,24 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
             int64_t i = 0;
             for(const auto& var : vars) {
                 ctx.set_array_index_of_path_back(i);
-                _variant_to_binary(fundamental_type(rtype), var, ds, ctx);
+                _variant_to_binary(*plan.element, var, ds, ctx);
                 ++i;
             }
+            break;
         }
-        else if(is_optional(rtype)) {
+        case type_plan::kOptional: {
             char flag = 1;
             if(var.is_null()) {
                 flag = 0;
             }
             fc::raw::pack(ds, flag);
             if(flag) {
-                _variant_to_binary(fundamental_type(rtype), var, ds, ctx);
+                _variant_to_binary(*plan.element, var, ds, ctx);
             }
+            break;
         }
-        else if(is_variant(rtype)) {
-            auto v_itr = variants_.find(rtype);
+        case type_plan::kVariant: {
+            auto& v_itr = plan.variant_itr;
             ctx.hint_variant_type_if_in_array(v_itr);
 
             auto& vt = v_itr->second; 
@@ -526,10 +1241,11 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
             fc::raw::pack(ds, (fc::unsigned_int)index);
 
             auto h1 = ctx.push_to_path(impl::variant_path_item{.parent_itr = v_itr, .index = index});
-            _variant_to_binary(vt.fields[index].type, vo["data"], ds, ctx);
+            _variant_to_binary(*plan.fields[index].plan, vo["data"], ds, ctx);
+            break;
         }
-        else if(is_enum(rtype)) {
-            auto e_itr = enums_.find(rtype);
+        case type_plan::kEnum: {
+            auto& e_itr = plan.enum_itr;
             ctx.hint_enum_type_if_in_array(e_itr);
 
             auto& et = e_itr->second;
@@ -544,28 +1260,30 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
             }
             EVT_ASSERT2(index < et.fields.size(), pack_exception, "Invalid value of enum '{}'", ctx.get_path_string());
 
-            _variant_to_binary(et.integer, fc::variant(index), ds, ctx);
+            _variant_to_binary(*plan.element, fc::variant(index), ds, ctx);
+            break;
         }
-        else if(is_struct(rtype)) {
-            auto s_itr = structs_.find(rtype);
+        case type_plan::kStruct: {
+            auto& s_itr = plan.struct_itr;
             ctx.hint_struct_type_if_in_array(s_itr);
 
             auto& st = s_itr->second;
             if(var.is_object()) {
                 const auto& vo = var.get_object();
 
-                if(st.base != type_name()) {
-                    _variant_to_binary(resolve_type(st.base), var, ds, ctx);
+                if(plan.base) {
+                    _variant_to_binary(*plan.base, var, ds, ctx);
                 }
                 for(uint32_t i = 0; i < st.fields.size(); ++i) {
                     const auto& field = st.fields[i];
+                    const auto& fplan = plan.fields[i];
                     if(vo.contains(string(field.name).c_str())) {
                         auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
-                        _variant_to_binary(field.type, vo[field.name], ds, ctx);
+                        _variant_to_binary(*fplan.plan, vo[field.name], ds, ctx);
                     }
-                    else if(is_optional(field.type)) {
+                    else if(fplan.optional) {
                         auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
-                        _variant_to_binary(field.type, fc::variant(), ds, ctx);
+                        _variant_to_binary(*fplan.plan, fc::variant(), ds, ctx);
                     }
                     else {
                         EVT_THROW(pack_exception, "Missing field '${f}' in input object while processing struct '${p}'",
@@ -582,7 +1300,7 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
                     const auto& field = st.fields[i];
                     if(va.size() > i) {
                         auto h1 = ctx.push_to_path(impl::field_path_item{.parent_itr = s_itr, .field_ordinal = i});
-                        _variant_to_binary(field.type, va[i], ds, ctx);
+                        _variant_to_binary(*plan.fields[i].plan, va[i], ds, ctx);
                     }
                     else {
                         EVT_THROW(pack_exception, "Early end to input array specifying the fields of struct '${p}'; require input for field '${f}'",
@@ -593,14 +1311,22 @@ abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var
             else {
                 EVT_THROW(pack_exception, "Unexpected input encountered while processing struct '${p}'", ("p", ctx.get_path_string()));
             }
+            break;
         }
-        else {
+        default: {
             EVT_THROW(invalid_type_inside_abi, "Unknown type ${type}", ("type", ctx.maybe_shorten(type)));
         }
+        }  // switch
     }
     FC_CAPTURE_AND_RETHROW((type)(var))
 }
 
+void
+abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const {
+    auto plans = std::optional<type_plans>();
+    _variant_to_binary(find_plan(type, plans), var, ds, ctx);
+}
+
 bytes
 abi_serializer::_variant_to_binary(const type_name& type, const fc::variant& var, impl::variant_to_binary_context& ctx) const {
     try {
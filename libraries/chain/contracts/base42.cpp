@@ -0,0 +1,133 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/contracts/base42.hpp>
+
+#include <algorithm>
+#include <array>
+
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain { namespace contracts {
+
+namespace internal {
+
+const char kAlphabets[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ$+-/:*";
+
+// limbs are little-endian, 256 bytes are enough for the longest EVT-Link
+const int      kMaxLimbs = 64;
+const int      kChunk    = 5;
+const uint32_t kPowers[] = { 1, 42, 42 * 42, 42 * 42 * 42, 42 * 42 * 42 * 42, 42 * 42 * 42 * 42 * 42 };
+
+using limbs_type = std::array<uint32_t, kMaxLimbs>;
+
+// digit of each character, -1 for the ones not in alphabets
+constexpr auto kDigits = [] {
+    auto t = std::array<int8_t, 256>();
+    for(auto& d : t) {
+        d = -1;
+    }
+    for(auto i = 0; i < 42; i++) {
+        t[(uint8_t)kAlphabets[i]] = i;
+    }
+    return t;
+}();
+
+}  // namespace internal
+
+bytes
+base42_decode(const char* begin, const char* end, size_t max_bytes) {
+    using namespace internal;
+
+    auto p = begin;
+    while(p < end && *p == '0') {
+        p++;
+    }
+    EVT_ASSERT(p < end, evt_link_exception, "Invalid EVT-Link");
+
+    auto zeros     = (size_t)(p - begin);
+    auto max_limbs = std::min<size_t>((max_bytes + 3) / 4, kMaxLimbs);
+    auto limbs     = limbs_type();
+    auto used      = 0u;
+
+    while(p < end) {
+        auto n = std::min<size_t>(kChunk, end - p);
+        auto v = 0u;
+        for(auto i = 0u; i < n; i++, p++) {
+            auto d = kDigits[(uint8_t)*p];
+            EVT_ASSERT(d >= 0, evt_link_exception, "Invalid character in EVT-Link: ${c}", ("c",std::string(1, *p)));
+            v = v * 42 + d;
+        }
+
+        // num = num * 42^n + v
+        auto carry = (uint64_t)v;
+        for(auto i = 0u; i < used; i++) {
+            auto t   = (uint64_t)limbs[i] * kPowers[n] + carry;
+            limbs[i] = (uint32_t)t;
+            carry    = t >> 32;
+        }
+        if(carry > 0) {
+            EVT_ASSERT(used < max_limbs, evt_link_exception, "EVT-Link is too long");
+            limbs[used++] = (uint32_t)carry;
+        }
+    }
+
+    auto top  = limbs[used - 1];
+    auto size = (used - 1) * 4 + (top > 0xffffff ? 4 : top > 0xffff ? 3 : top > 0xff ? 2 : 1);
+    EVT_ASSERT(size <= max_bytes, evt_link_exception, "EVT-Link is too long");
+
+    auto b = bytes(zeros + size);
+    for(auto i = 0u; i < size; i++) {
+        b[zeros + size - 1 - i] = (char)(limbs[i / 4] >> (i % 4 * 8));
+    }
+    return b;
+}
+
+void
+base42_encode(const char* begin, const char* end, std::string& str) {
+    using namespace internal;
+
+    auto p = begin;
+    while(p < end && *p == 0) {
+        str.push_back('0');
+        p++;
+    }
+
+    auto start = str.size();
+    auto size  = (size_t)(end - p);
+    auto used  = (uint32_t)((size + 3) / 4);
+    EVT_ASSERT(used <= kMaxLimbs, evt_link_exception, "EVT-Link is too long");
+
+    auto limbs = limbs_type();
+    for(auto i = 0u; i < size; i++) {
+        limbs[i / 4] |= (uint32_t)(uint8_t)end[-1 - (int)i] << (i % 4 * 8);
+    }
+
+    while(used > 0) {
+        // num, r = num / 42^5, num % 42^5
+        auto r = (uint64_t)0;
+        for(auto i = used; i-- > 0;) {
+            auto t   = (r << 32) | limbs[i];
+            limbs[i] = (uint32_t)(t / kPowers[kChunk]);
+            r        = t % kPowers[kChunk];
+        }
+        while(used > 0 && limbs[used - 1] == 0) {
+            used--;
+        }
+
+        // digits are pushed from the lowest one and padded unless it's the highest chunk
+        auto n = 0;
+        do {
+            str.push_back(kAlphabets[r % 42]);
+            r /= 42;
+            n++;
+        } while(r > 0 || (used > 0 && n < kChunk));
+    }
+    if(str.size() == start) {
+        str.push_back('0');
+    }
+    std::reverse(str.begin() + start, str.end());
+}
+
+}}}  // namespace evt::chain::contracts
@@ -12,11 +12,12 @@ namespace evt { namespace chain { namespace contracts {
 /**
  * Hisotry
  * 4.1.1: Update memo field in everipass v2 and everipay v2 to be optional
+ * 4.2.0: Add batchtransft action
  */
 
 static auto evt_abi_version       = 4;
-static auto evt_abi_minor_version = 1;
-static auto evt_abi_patch_version = 1;
+static auto evt_abi_minor_version = 2;
+static auto evt_abi_patch_version = 0;
 
 version
 evt_contract_abi_version() {
@@ -303,6 +304,21 @@ evt_contract_abi() {
         }
     });
 
+    evt_abi.structs.emplace_back( struct_def {
+        "ft_credit", "", {
+            {"to", "address"},
+            {"number", "asset"}
+        }
+    });
+
+    evt_abi.structs.emplace_back( struct_def {
+        "batchtransft", "", {
+            {"from", "address"},
+            {"credits", "ft_credit[]"},
+            {"memo", "string"}
+        }
+    });
+
     evt_abi.structs.emplace_back( struct_def {
         "recycleft", "", {
             {"address", "address"},
@@ -7,51 +7,28 @@
 #include <string.h>
 #include <algorithm>
 
-#include <boost/multiprecision/cpp_int.hpp>
 #include <boost/endian/conversion.hpp>
 
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/elliptic.hpp>
 #include <evt/chain/exceptions.hpp>
-
-using namespace boost::multiprecision;
-
-// pay: 2(header) + 5(time) + 5(max_pay) + 7(symbol) + 16(link-id)  = 35
-// pass: 2(header) + 5(time) + 22(domain) + 22(token) + 16(link-id) = 67
-// sigs: 65 * 3 = 195
-using bigint_segs = number<cpp_int_backend<536, 536, unsigned_magnitude, checked, void>>;
-using bigint_sigs = number<cpp_int_backend<1560, 1560, unsigned_magnitude, checked, void>>;
+#include <evt/chain/contracts/base42.hpp>
 
 namespace evt { namespace chain { namespace contracts {
 
 namespace internal {
 
-const char* ALPHABETS  = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ$+-/:*";
-const int   MAX_BYTES  = 240;  // 195 / ((42 ^ 2) / 2048)
-const char* URI_SCHEMA = "https://evt.li/";
+// pay: 2(header) + 5(time) + 5(max_pay) + 7(symbol) + 16(link-id)  = 35
+// pass: 2(header) + 5(time) + 22(domain) + 22(token) + 16(link-id) = 67
+// sigs: 65 * 3 = 195
+const int   MAX_SEGS_BYTES = 67;
+const int   MAX_SIGS_BYTES = 195;
+const int   MAX_BYTES      = 240;  // 195 / ((42 ^ 2) / 2048)
+const char* URI_SCHEMA     = "https://evt.li/";
 
-template<typename T>
 bytes
-decode(const std::string& nums, uint pos, uint end) {
-    auto num = T{0};
-    auto pz  = nums.find_first_not_of('0', pos);
-    EVT_ASSERT(pz != string::npos, evt_link_exception, "Invalid EVT-Link");
-
-    for(auto i = pz; i < end; i++) {
-        auto c = strchr(ALPHABETS, nums[i]);
-        FC_ASSERT(c != nullptr, "invalid character in evt-link");
-        num *= 42;
-        num += (c - ALPHABETS);
-    }
-
-    auto b = bytes();
-    b.reserve(MAX_BYTES);
-    for(auto i = 0u; i < (pz - pos); i++) {
-        b.emplace_back(0);
-    }
-    boost::multiprecision::export_bits(num, std::back_inserter(b), 8);
-
-    return b;
+decode(const std::string& nums, size_t pos, size_t end, size_t max_bytes) {
+    return base42_decode(nums.data() + pos, nums.data() + end, max_bytes);
 }
 
 evt_link::segments_type
@@ -157,11 +134,11 @@ evt_link::parse_from_evtli(const std::string& str) {
     auto bsigs = bytes();
 
     if(d == std::string::npos) {
-        bsegs = decode<bigint_segs>(str, start, str.size());
+        bsegs = decode(str, start, str.size(), MAX_SEGS_BYTES);
     }
     else {
-        bsegs = decode<bigint_segs>(str, start, d);
-        bsigs = decode<bigint_sigs>(str, d + 1, str.size());
+        bsegs = decode(str, start, d, MAX_SEGS_BYTES);
+        bsigs = decode(str, d + 1, str.size(), MAX_SIGS_BYTES);
     }
 
     auto link = evt_link();
@@ -264,29 +241,13 @@ write_signatures_bytes(const evt_link& link, Stream& stream) {
     }
 }
 
-template<typename Num>
 void
-encode(const bytes& b, size_t sz, std::string& str) {
-    auto i = 0u;
-    for(i = 0u; i < sz; i++) {
-        if(b[i] == 0) {
-            str.push_back('0');
-        }
-        else {
-            break;
-        }
-    }
-
-    auto num = Num{0};
-    boost::multiprecision::import_bits(num, b.begin() + i, b.begin() + sz, 8);
+encode(const bytes& b, size_t sz, size_t max_bytes, std::string& str) {
+    // leading zeros are encoded separately and not limited
+    auto pz = std::find_if(b.cbegin(), b.cbegin() + sz, [](auto c) { return c != 0; }) - b.cbegin();
+    EVT_ASSERT(sz - pz <= max_bytes, evt_link_exception, "EVT-Link is too long");
 
-    while(num >= 42) {
-        auto r = num % 42;
-        str.push_back(*(ALPHABETS + (int)r));
-        num /= 42;
-    }
-    str.push_back(*(ALPHABETS + (int)num));
-    std::reverse(str.begin() + i, str.end());
+    base42_encode(b.data(), b.data() + sz, str);
 }
 
 }  // namespace internal
@@ -314,7 +275,7 @@ evt_link::to_string(int prefix) const {
 
     auto str1 = string();
     write_segments_bytes(*this, ds);
-    encode<bigint_segs>(temp, ds.tellp(), str1);
+    encode(temp, ds.tellp(), MAX_SEGS_BYTES, str1);
     str.append(str1);
 
     if(!signatures_.empty()) {
@@ -324,23 +285,34 @@ evt_link::to_string(int prefix) const {
         write_signatures_bytes(*this, ds);
 
         auto str2 = string();
-        encode<bigint_sigs>(temp, ds.tellp(), str2);
+        encode(temp, ds.tellp(), MAX_SIGS_BYTES, str2);
         str.append(str2);
     }
 
     return str;
 }
 
-public_keys_set
+const public_keys_set&
 evt_link::restore_keys() const {
+    if(auto k = std::atomic_load(&keys_)) {
+        return *k;
+    }
+
     auto hash = digest();
-    auto keys = public_keys_set();
+    auto keys = std::make_shared<public_keys_set>();
 
-    keys.reserve(signatures_.size());
+    keys->reserve(signatures_.size());
     for(auto& sig : signatures_) {
-        keys.emplace(public_key_type(sig, hash));
+        keys->emplace(public_key_type(sig, hash));
+    }
+
+    // the first one recovered is kept, so references returned are never invalidated by other threads
+    auto expected = std::shared_ptr<const public_keys_set>();
+    auto desired  = std::shared_ptr<const public_keys_set>(std::move(keys));
+    if(!std::atomic_compare_exchange_strong(&keys_, &expected, desired)) {
+        return *expected;
     }
-    return keys;
+    return *desired;
 }
 
 void
@@ -350,21 +322,25 @@ evt_link::add_segment(const segment& seg) {
         // existed, replace old one
         it.first->second = seg;
     }
+    keys_.reset();
 }
 
 void
 evt_link::remove_segment(uint8_t key) {
     segments_.erase(key);
+    keys_.reset();
 }
 
 void
 evt_link::add_signature(const signature_type& sig) {
     signatures_.emplace(sig);
+    keys_.reset();
 }
 
 void
 evt_link::sign(const private_key_type& pkey) {
     signatures_.emplace(pkey.sign(digest()));
+    keys_.reset();
 }
 
 }}}  // namespac evt::chain::contracts
@@ -4,6 +4,14 @@
  */
 #include <evt/chain/controller.hpp>
 
+#include <chrono>
+#include <future>
+#include <set>
+#include <unordered_map>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/noncopyable.hpp>
 #include <chainbase/chainbase.hpp>
 #include <fmt/format.h>
 
@@ -11,12 +19,20 @@
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 
+#include <evt/chain/action_costs.hpp>
 #include <evt/chain/authority_checker.hpp>
+#include <evt/chain/block_bus.hpp>
 #include <evt/chain/block_log.hpp>
+#include <evt/chain/bonus_accruals.hpp>
 #include <evt/chain/charge_manager.hpp>
 #include <evt/chain/chain_snapshot.hpp>
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/fork_database.hpp>
+#include <evt/chain/perf_stats.hpp>
+#include <evt/chain/deadline_timer.hpp>
+#include <evt/chain/replay_prefetcher.hpp>
+#include <evt/chain/read_set_prefetcher.hpp>
+#include <evt/chain/reversible_block_log.hpp>
 #include <evt/chain/snapshot.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/token_database_cache.hpp>
@@ -29,7 +45,9 @@
 #include <evt/chain/block_summary_object.hpp>
 #include <evt/chain/global_property_object.hpp>
 #include <evt/chain/transaction_object.hpp>
+#include <evt/chain/deadline_object.hpp>
 #include <evt/chain/reversible_block_object.hpp>
+#include <evt/chain/state_layout_object.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
 
 namespace evt { namespace chain {
@@ -38,9 +56,31 @@ using controller_index_set = index_set<
    global_property_multi_index,
    dynamic_global_property_multi_index,
    block_summary_multi_index,
-   transaction_multi_index
+   transaction_multi_index,
+   deadline_multi_index
 >;
 
+// adds the time of its lifetime to `us` unless it's null
+class phase_timer : boost::noncopyable {
+public:
+    explicit phase_timer(uint64_t* us) : us_(us) {
+        if(us_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~phase_timer() {
+        if(us_) {
+            using namespace std::chrono;
+            *us_ += duration_cast<microseconds>(steady_clock::now() - start_).count();
+        }
+    }
+
+private:
+    uint64_t*                             us_;
+    std::chrono::steady_clock::time_point start_;
+};
+
 class maybe_session {
 public:
     maybe_session() = default;
@@ -112,6 +152,17 @@ private:
     optional<token_database::session> _token_session;
 };
 
+// keys required by the actions of one transaction for one set of candidate keys
+// it's reused until one of the tokens checked or the producer schedule is changed
+struct required_keys_entry {
+    public_keys_set keys;
+    authority_deps  deps;
+    uint32_t        producers_version;
+};
+
+// cache is cleared when it's full instead of evicting entries one by one, they're cheap to recompute
+const size_t kMaxRequiredKeysCacheSize = 16 * 1024;
+
 struct pending_state {
     pending_state(maybe_session&& s)
         : _db_session(move(s)) {}
@@ -124,6 +175,14 @@ struct pending_state {
     small_vector<action_receipt, 4> _actions;
     controller::block_status        _block_status = controller::block_status::incomplete;
     optional<block_id_type>         _producer_block_id;
+    bonus_accruals                  _bonus_accruals;
+    bonus_accruals                  _charge_accruals;  // only of EVT, credited to `_charge_collector`
+    address                         _charge_collector;
+
+    std::vector<transaction_trace_ptr> _traces;  // only recorded when block bus is enabled
+    std::future<signature_type>        _signature;  // set by sign_block_async
+
+    bool _trx_mroot_checked = false;  // transaction merkle is taken from received block checked by header check
 
     void
     push() {
@@ -134,7 +193,7 @@ struct pending_state {
 struct controller_impl {
     controller&              self;
     chainbase::database      db;
-    chainbase::database      reversible_blocks; ///< a special database to persist blocks that have successfully been applied but are still reversible
+    reversible_block_log     reversible_blocks; ///< a special log to persist blocks that have successfully been applied but are still reversible
     block_log                blog;
     optional<pending_state>  pending;
     block_state_ptr          head;
@@ -151,8 +210,26 @@ struct controller_impl {
     db_read_mode             read_mode = db_read_mode::SPECULATIVE;
     bool                     in_trx_requiring_checks = false; ///< if true, checks that are normally skipped on replay (e.g. auth checks) cannot be skipped
     bool                     trusted_producer_light_validation = false;
+    bool                     trusted_replay = false;
+    prefetched_block         prefetched;  // block being replayed with its transactions prepared by prefetcher
+    std::unique_ptr<read_set_prefetcher> trx_prefetcher;  // only created when `trx_prefetch_ahead` is set
+    std::shared_future<void> snapshot_task;  // writing snapshot on another thread
     uint32_t                 snapshot_head_block = 0;
     abi_serializer           system_api;
+    boost::asio::thread_pool thread_pool;
+    std::unique_ptr<block_bus> bus;
+
+    controller::phase_timings* timings = nullptr;
+    perf_stats                 perf;
+    action_cost_table          action_costs;
+    deadline_timer             trx_timer;
+
+    std::unordered_map<digest_type, required_keys_entry> required_keys_cache;
+
+    uint64_t*
+    timing(uint64_t controller::phase_timings::* phase) {
+        return timings ? &(timings->*phase) : nullptr;
+    }
 
     /**
      *  Transactions that were undone by pop_block or abort_block, transactions
@@ -166,9 +243,7 @@ struct controller_impl {
         auto prev = fork_db.get_block(head->header.previous);
         EVT_ASSERT(prev, block_validate_exception, "attempt to pop beyond last irreversible block");
 
-        if(const auto* b = reversible_blocks.find<reversible_block_object,by_num>(head->block_num)) {
-            reversible_blocks.remove(*b);
-        }
+        reversible_blocks.pop(head->block_num);
 
         if(read_mode == db_read_mode::SPECULATIVE) {
             EVT_ASSERT(head->block, block_validate_exception, "attempting to pop a block that was sparsely loaded from a snapshot");
@@ -187,27 +262,75 @@ struct controller_impl {
              cfg.read_only ? database::read_only : database::read_write,
              cfg.state_size)
         , reversible_blocks(cfg.blocks_dir / config::reversible_blocks_dir_name,
-             cfg.read_only ? database::read_only : database::read_write,
+             cfg.read_only ? reversible_block_log::open_mode::read_only : reversible_block_log::open_mode::read_write,
              cfg.reversible_cache_size)
-        , blog(cfg.blocks_dir)
-        , fork_db(cfg.state_dir)
+        , blog(cfg.blocks_dir, cfg.blog_config)
+        , fork_db(cfg.state_dir, cfg.fork_db_max_size)
         , token_db(cfg.db_config)
-        , token_db_cache(token_db, cfg.db_config.object_cache_size)
+        , token_db_cache(token_db, cfg.db_config.object_cache_size, cfg.db_config.warmup_keys)
         , conf(cfg)
         , chain_id(cfg.genesis.compute_chain_id())
         , exec_ctx(s)
         , read_mode(cfg.read_mode)
-        , system_api(contracts::evt_contract_abi(), cfg.max_serialization_time) {
+        , system_api(contracts::evt_contract_abi(), cfg.max_serialization_time)
+        , thread_pool(cfg.thread_pool_size) {
+
+        if(cfg.block_bus_size > 0) {
+            bus = std::make_unique<block_bus>(cfg.block_bus_size);
+        }
+        if(!cfg.read_only) {
+            import_legacy_reversible_blocks(cfg.blocks_dir / config::reversible_blocks_dir_name);
+        }
 
         fork_db.irreversible.connect([&](auto b) {
             on_irreversible(b);
         });
     }
 
+    // reversible blocks were kept in chainbase by older versions, they're moved into reversible log once
+    void
+    import_legacy_reversible_blocks(const fc::path& dir) {
+        if(!fc::exists(dir / "shared_memory.bin")) {
+            return;
+        }
+        {
+            chainbase::database legacy(dir, database::read_only);
+            legacy.add_index<reversible_block_index>();
+
+            const auto& ubi = legacy.get_index<reversible_block_index, by_num>();
+            if(reversible_blocks.empty()) {
+                for(auto& obj : ubi) {
+                    reversible_blocks.append(obj.blocknum, std::string_view(obj.packedblock.data(), obj.packedblock.size()));
+                }
+            }
+            ilog("Imported ${n} blocks from legacy reversible blocks database", ("n", fmt::format("{:n}", ubi.size())));
+        }
+        reversible_blocks.flush();
+        fc::remove(dir / "shared_memory.bin");
+        fc::remove(dir / "shared_memory.meta");
+    }
+
     ~controller_impl() {
+        if(snapshot_task.valid()) {
+            snapshot_task.wait();
+        }
+        trx_prefetcher.reset();
+        if(bus) {
+            bus->stop();
+        }
+        thread_pool.stop();
+        thread_pool.join();
+
         pending.reset();
         db.flush();
         reversible_blocks.flush();
+
+        try {
+            token_db_cache.save_warm_keys();
+        }
+        catch(const fc::exception& e) {
+            wlog("Cannot save warm keys of token database: ${e}", ("e",e.to_detail_string()));
+        }
     }
 
     /**
@@ -219,6 +342,15 @@ struct controller_impl {
      *  a full audit of its uses needs to be undertaken.
      *
      */
+    void
+    emit_applied_transaction(const transaction_trace_ptr& trace) {
+        // traces in block are batched for block bus, others are from the failed transactions
+        if(bus && pending && trace->receipt.has_value()) {
+            pending->_traces.emplace_back(trace);
+        }
+        emit(self.applied_transaction, trace);
+    }
+
     template <typename Signal, typename Arg>
     void
     emit(const Signal& s, Arg&& a) {
@@ -269,18 +401,30 @@ struct controller_impl {
         }
 
         db.commit(s->block_num);
-        token_db.pop_savepoints(s->block_num);
+        {
+            auto t  = phase_timer(timing(&controller::phase_timings::tokendb_commit_us));
+            auto pm = perf_marker(perf, perf_phase::pop_savepoints);
+            token_db.pop_savepoints(s->block_num);
+        }
+        if(conf.db_config.evtlink_ttl > 0 && !conf.loadtest_mode) {
+            // links are accepted within `evt_link_expired_secs` on both sides of their timestamps
+            // and blocks are at least one interval apart, so the ones paid before are never accepted again
+            auto& gpo    = db.get<global_property_object>();
+            auto  secs   = std::max(conf.db_config.evtlink_ttl, 2 * gpo.configuration.evt_link_expired_secs);
+            auto  blocks = (uint32_t)((uint64_t)secs * 1000 / config::block_interval_ms);
+            if(s->block_num > blocks) {
+                token_db.prune_evtlinks_before(s->block_num - blocks);
+            }
+        }
+        if(s->block_num % config::default_warmup_save_interval == 0) {
+            token_db_cache.save_warm_keys();
+        }
 
         if(append_to_blog) {
             blog.append(s->block);
         }
 
-        const auto& ubi    = reversible_blocks.get_index<reversible_block_index, by_num>();
-        auto        objitr = ubi.begin();
-        while(objitr != ubi.end() && objitr->blocknum <= s->block_num) {
-            reversible_blocks.remove(*objitr);
-            objitr = ubi.begin();
-        }
+        reversible_blocks.prune(s->block_num);
 
         // the "head" block when a snapshot is loaded is virtual and has no block data, all of its effects
         // should already have been loaded from the snapshot so, it cannot be applied
@@ -289,7 +433,7 @@ struct controller_impl {
                 // when applying a snapshot, head may not be present
                 // when not applying a snapshot, make sure this is the next block
                 if(!head || s->block_num == head->block_num + 1) {
-                    apply_block(s->block, controller::block_status::complete);
+                    apply_block(s->block, controller::block_status::complete, s->header_check);
                     head = s;
                 }
                 else {
@@ -303,6 +447,9 @@ struct controller_impl {
                 fork_db.set_validity(head, true);
             }
             emit(self.irreversible_block, s);
+            if(bus) {
+                bus->publish(std::make_shared<block_batch>(block_batch { s, {}, true }));
+            }
         }
     }
 
@@ -316,25 +463,69 @@ struct controller_impl {
         ilog("existing block log, attempting to replay from ${s} to ${n} blocks",
             ("s", fmt::format("{:n}", start_block_num))("n", fmt::format("{:n}", blog_head->block_num())));
 
+        auto trusted_num = (uint32_t)0;
+        if(conf.trusted_replay_until.has_value()) {
+            trusted_num = block_header::num_from_id(*conf.trusted_replay_until);
+            auto tb     = blog.read_block_by_num(trusted_num);
+            EVT_ASSERT(tb && tb->id() == *conf.trusted_replay_until, block_validate_exception,
+                "Trusted replay block: ${id} is not found in block log", ("id", *conf.trusted_replay_until));
+            ilog("blocks until ${n} are trusted when replaying", ("n", fmt::format("{:n}", trusted_num)));
+        }
+        auto reset_trusted_replay = fc::make_scoped_exit([this]() {
+            trusted_replay = false;
+        });
+
+        // blocks are read, unpacked and have keys recovered on other threads ahead of applying them
+        auto prefetcher = std::unique_ptr<replay_prefetcher>();
+        if(conf.replay_prefetch_blocks > 0) {
+            prefetcher = std::make_unique<replay_prefetcher>(blog, head->block_num + 1, conf.replay_prefetch_blocks, thread_pool,
+                chain_id, conf.parallel_recover_sigs, [this, trusted_num](auto num) {
+                    return conf.force_all_checks && num > trusted_num;
+                });
+        }
+        auto read_next = [&] {
+            if(!prefetcher) {
+                return blog.read_block_by_num(head->block_num + 1);
+            }
+            prefetched = prefetcher->next();
+            return prefetched.block;
+        };
+        auto reset_prefetched = fc::make_scoped_exit([this]() {
+            prefetched = prefetched_block();
+        });
+
         auto start = fc::time_point::now();
-        while(auto next = blog.read_block_by_num(head->block_num + 1)) {
+        while(auto next = read_next()) {
+            if(trusted_replay && next->block_num() > trusted_num) {
+                ilog("trusted blocks are replayed, switch back to full validation");
+                trusted_replay = false;
+                // undo sessions are started again if replay optimizations are disabled
+                if(!self.skip_db_sessions(controller::block_status::irreversible)) {
+                    db.set_revision(head->block_num);
+                }
+            }
+            else {
+                trusted_replay = next->block_num() <= trusted_num;
+            }
             replay_push_block(next, controller::block_status::irreversible);
             if(next->block_num() % 500 == 0) {
                 ilog2_("{:n} of {:n}", next->block_num(), blog_head->block_num());
             }
         }
+        prefetcher.reset();
         std::cerr << "\n";
         ilog("${n} blocks replayed", ("n", fmt::format("{:n}", head->block_num - start_block_num)));
+        trusted_replay = false;
 
         // if the irreversible log is played without undo sessions enabled, we need to sync the
         // revision ordinal to the appropriate expected value here.
-        if(self.skip_db_sessions(controller::block_status::irreversible))
+        if(self.skip_db_sessions(controller::block_status::irreversible) || trusted_num >= head->block_num)
             db.set_revision(head->block_num);
 
         int rev = 0;
-        while(auto obj = reversible_blocks.find<reversible_block_object, by_num>(head->block_num + 1)) {
+        while(auto b = reversible_blocks.read_block(head->block_num + 1)) {
             ++rev;
-            replay_push_block(obj->get_block(), controller::block_status::validated);
+            replay_push_block(b, controller::block_status::validated);
         }
 
         ilog("${n} reversible blocks replayed", ("n", fmt::format("{:n}", rev)));
@@ -352,6 +543,9 @@ struct controller_impl {
     void
     init(const snapshot_reader_ptr& snapshot) {
         token_db.open();
+        if(conf.trx_prefetch_ahead > 0) {
+            trx_prefetcher = std::make_unique<read_set_prefetcher>(token_db, conf.trx_prefetch_ahead);
+        }
 
         bool report_integrity_hash = !!snapshot;
         if(snapshot) {
@@ -390,12 +584,10 @@ struct controller_impl {
             }
         }
 
-        const auto& ubi    = reversible_blocks.get_index<reversible_block_index, by_num>();
-        auto        objitr = ubi.rbegin();
-        if(objitr != ubi.rend()) {
-            EVT_ASSERT(objitr->blocknum == head->block_num, fork_database_exception,
+        if(!reversible_blocks.empty()) {
+            EVT_ASSERT(reversible_blocks.end_block_num() - 1 == head->block_num, fork_database_exception,
                        "reversible block database is inconsistent with fork database, replay blockchain",
-                       ("head", head->block_num)("unconfimed", objitr->blocknum));
+                       ("head", head->block_num)("unconfimed", reversible_blocks.end_block_num() - 1));
         }
         else {
             auto end = blog.read_head();
@@ -422,6 +614,12 @@ struct controller_impl {
             token_db.rollback_to_latest_savepoint();
         }
 
+        if(db.get_index<deadline_index>().indices().empty()) {
+            rebuild_deadline_index();
+        }
+        record_state_layout();
+        warm_bonus_holders();
+
         if(report_integrity_hash) {
             const auto hash = calculate_integrity_hash();
             ilog("database initialized with hash: ${hash}", ("hash", hash));
@@ -433,13 +631,44 @@ struct controller_impl {
 
     void
     add_indices() {
-        reversible_blocks.add_index<reversible_block_index>(); 
-
         controller_index_set::add_indices(db);
+        // not in the index set, so it's not a part of snapshots
+        db.add_index<state_layout_index>();
+        check_state_layout();
+    }
+
+    // state written by other versions of layout is refused before any of its indices is used
+    // state existed without the layout object is written before the layout is recorded
+    void
+    check_state_layout() {
+        if(db.find<global_property_object>() == nullptr) {
+            // empty state, layout is recorded once it's initialized
+            return;
+        }
+
+        auto layout  = db.find<state_layout_object>();
+        auto version = layout ? layout->version : 0u;
+        EVT_ASSERT(version == state_layout_object::current_version, state_layout_exception,
+            "Layout version of chain state is ${v}, but the current one is ${c}, "
+            "replay the blockchain with --replay-blockchain or restore the state from a snapshot",
+            ("v", version)("c", state_layout_object::current_version));
+    }
+
+    void
+    record_state_layout() {
+        if(db.find<state_layout_object>() == nullptr) {
+            db.create<state_layout_object>([](auto&) {});
+        }
     }
 
     void
     add_to_snapshot(const snapshot_writer_ptr& snapshot) const {
+        add_chain_state_to_snapshot(snapshot);
+        token_database_snapshot::add_to_snapshot(snapshot, token_db);
+    }
+
+    void
+    add_chain_state_to_snapshot(const snapshot_writer_ptr& snapshot) const {
         snapshot->write_section<chain_snapshot_header>([this](auto& section) {
             section.add_row(chain_snapshot_header(), db);
         });
@@ -461,8 +690,47 @@ struct controller_impl {
                 });
             });
         });
+    }
 
-        token_database_snapshot::add_to_snapshot(snapshot, token_db);
+    // chain state is copied into memory and token database is pinned by a view on calling thread,
+    // then both of them are written into snapshot on another thread while blocks are still applied
+    std::shared_future<void>
+    write_snapshot_async(const snapshot_writer_ptr& snapshot) {
+        EVT_ASSERT(!snapshot_task.valid() || snapshot_task.wait_for(std::chrono::seconds(0)) == std::future_status::ready,
+                   snapshot_exception, "Another snapshot is being written");
+
+        auto chain_state = std::make_shared<buffered_snapshot_writer>();
+        add_chain_state_to_snapshot(chain_state);
+        // all the reads of view including ranges are pinned to its snapshot, so blocks applied meanwhile are never seen
+        auto view = std::shared_ptr<const token_database::read_view>(token_db.new_read_view());
+
+        snapshot_task = std::async(std::launch::async, [snapshot, chain_state, view]() mutable {
+            // view is released once it's done, the task may be kept longer than token database
+            auto release = fc::make_scoped_exit([&] {
+                chain_state.reset();
+                view.reset();
+            });
+            chain_state->write_to(*snapshot);
+            token_database_snapshot::add_to_snapshot(snapshot, *view);
+        }).share();
+        return snapshot_task;
+    }
+
+    std::shared_future<void>
+    write_incremental_snapshot_async(const snapshot_writer_ptr& snapshot, const block_id_type& base_id, std::vector<token_delta>&& deltas) {
+        EVT_ASSERT(!snapshot_task.valid() || snapshot_task.wait_for(std::chrono::seconds(0)) == std::future_status::ready,
+                   snapshot_exception, "Another snapshot is being written");
+
+        // deltas have the latest values already, token database is not read at all
+        auto chain_state = std::make_shared<buffered_snapshot_writer>();
+        add_chain_state_to_snapshot(chain_state);
+
+        snapshot_task = std::async(std::launch::async, [snapshot, chain_state, base_id, deltas = std::move(deltas)]() mutable {
+            chain_state->write_to(*snapshot);
+            chain_state.reset();
+            token_database_snapshot::add_deltas_to_snapshot(snapshot, base_id, deltas);
+        }).share();
+        return snapshot_task;
     }
 
     void
@@ -477,7 +745,7 @@ struct controller_impl {
             block_header_state head_header_state;
             section.read_row(head_header_state, db);
 
-            auto head_state = std::make_shared<block_state>(head_header_state);
+            auto head_state = make_block_state(head_header_state);
             fork_db.set(head_state);
             fork_db.set_validity(head_state, true);
             fork_db.mark_in_current_chain(head_state, true);
@@ -489,6 +757,13 @@ struct controller_impl {
         controller_index_set::walk_indices([this, &snapshot](auto utils) {
             using value_t = typename decltype(utils)::index_t::value_type;
 
+            // snapshots of older versions don't have it, it's rebuilt from token database instead
+            if constexpr(std::is_same_v<value_t, deadline_object>) {
+                if(!snapshot->has_section<value_t>()) {
+                    return;
+                }
+            }
+
             snapshot->read_section<value_t>([this](auto& section) {
                 bool more = !section.empty();
                 while(more) {
@@ -499,10 +774,95 @@ struct controller_impl {
             });
         });
 
-        token_database_snapshot::read_from_snapshot(snapshot, token_db);
+        // plain table files used in memory profile cannot be ingested
+        auto ingest = conf.db_config.snapshot_ingest && conf.db_config.profile != storage_profile::memory;
+        token_database_snapshot::read_from_snapshot(snapshot, token_db, ingest);
         db.set_revision(head->block_num);
     }
 
+    // deadlines of the pending locks, suspends and bonus rounds in token database,
+    // used when state is created before the index exists
+    void
+    rebuild_deadline_index() {
+        using namespace contracts;
+
+        auto n = 0u;
+        token_db.read_tokens_range(token_type::lock, std::nullopt, 0, [&](auto&, auto&& value) {
+            auto lock = lock_def();
+            extract_db_value(value, lock);
+            if(lock.status == lock_status::proposed) {
+                add_deadline(db, deadline_kind::lock_unlock, lock.name, lock.unlock_time);
+                add_deadline(db, deadline_kind::lock_deadline, lock.name, lock.deadline);
+                n++;
+            }
+            return true;
+        });
+        token_db.read_tokens_range(token_type::suspend, std::nullopt, 0, [&](auto&, auto&& value) {
+            auto suspend = suspend_def();
+            extract_db_value(value, suspend);
+            if(suspend.status == suspend_status::proposed) {
+                add_deadline(db, deadline_kind::suspend_expiration, suspend.name, suspend.trx.expiration);
+                n++;
+            }
+            return true;
+        });
+        token_db.read_tokens_range(token_type::psvbonus, std::nullopt, 0, [&](auto& key, auto&& value) {
+            auto k = name128();
+            memcpy(&k, key.data(), sizeof(k));
+            // slim ones are stored in the same type, only the full ones have rounds
+            if((uint64_t)k.value != 0) {
+                return true;
+            }
+            auto pb = passive_bonus();
+            extract_db_value(value, pb);
+            if(pb.round > 0) {
+                auto dkey = name128(((uint128_t)pb.sym_id << 64) | pb.round);
+                add_deadline(db, deadline_kind::bonus_deadline, dkey, time_point_sec(pb.deadline));
+                n++;
+            }
+            return true;
+        });
+
+        if(n > 0) {
+            ilog("deadline index rebuilt with ${n} pending items", ("n", n));
+        }
+    }
+
+    // holders index of the symbols received by passive bonus holders are built at startup,
+    // so distributions don't scan the whole symbol in database when applying
+    void
+    warm_bonus_holders() {
+        using namespace contracts;
+
+        auto syms = std::set<symbol_id_type>();
+        token_db.read_tokens_range(token_type::psvbonus, std::nullopt, 0, [&](auto& key, auto&& value) {
+            auto k = name128();
+            memcpy(&k, key.data(), sizeof(k));
+            // only the full ones have rules
+            if((uint64_t)k.value != 0) {
+                return true;
+            }
+            auto pb = passive_bonus();
+            extract_db_value(value, pb);
+            for(auto& rule : pb.rules) {
+                rule.visit([&](auto& r) {
+                    if(r.receiver.type() == dist_receiver_type::ftholders) {
+                        syms.emplace(r.receiver.template get<dist_stack_receiver>().threshold.symbol_id());
+                    }
+                });
+            }
+            return true;
+        });
+
+        auto n = 0u;
+        for(auto sym_id : syms) {
+            n += token_db.warm_assets_holders(sym_id);
+        }
+        if(!syms.empty()) {
+            ilog("holders index warmed with ${n} holders of ${s} symbols", ("n", n)("s", syms.size()));
+        }
+    }
+
     sha256
     calculate_integrity_hash() const {
         auto enc = sha256::encoder();
@@ -531,7 +891,7 @@ struct controller_impl {
         genheader.block_num             = genheader.header.block_num();
         genheader.block_signing_key     = conf.genesis.initial_key;
         
-        head        = std::make_shared<block_state>(genheader);
+        head        = make_block_state(genheader);
         head->block = std::make_shared<signed_block>(genheader.header);
 
         fork_db.set(head);
@@ -578,23 +938,35 @@ struct controller_impl {
             pending.reset();
         });
 
+        auto block_num = pending->_pending_block_state->block_num;
+        auto pm        = std::optional<perf_marker>(std::in_place, perf, perf_phase::commit_block);
+
         try {
+            if(pending->_signature.valid()) {
+                auto sig = pending->_signature.get();
+                sign_block([&sig](const digest_type&) { return sig; });
+            }
+
             if(add_to_fork_db) {
                 pending->_pending_block_state->validated = true;
-                auto new_bsp = fork_db.add(pending->_pending_block_state, true);
+                auto new_bsp = block_state_ptr();
+                {
+                    auto fm = perf_marker(perf, perf_phase::fork_db);
+                    new_bsp = fork_db.add(pending->_pending_block_state, true);
+                }
                 emit(self.accepted_block_header, pending->_pending_block_state);
                 head = fork_db.head();
                 EVT_ASSERT(new_bsp == head, fork_database_exception, "committed block did not become the new head in fork database");
             }
 
             if(!replaying) {
-                reversible_blocks.create<reversible_block_object>([&](auto& ubo) {
-                    ubo.blocknum = pending->_pending_block_state->block_num;
-                    ubo.set_block(pending->_pending_block_state->block);
-                });
+                reversible_blocks.append(pending->_pending_block_state->block);
             }
 
             emit(self.accepted_block, pending->_pending_block_state);
+            if(bus) {
+                bus->publish(std::make_shared<block_batch>(block_batch { pending->_pending_block_state, std::move(pending->_traces) }));
+            }
         }
         catch (...) {
             // dont bother resetting pending, instead abort the block
@@ -605,6 +977,9 @@ struct controller_impl {
 
         // push the state for pending.
         pending->push();
+
+        pm.reset();
+        perf.commit_block(block_num);
     }
 
     // The returned scoped_exit should not exceed the lifetime of the pending which existed when make_block_restore_point was called.
@@ -667,6 +1042,14 @@ struct controller_impl {
                    ("domain", act.domain)("key", act.key)("name", act.name));
     }
 
+    // the last one is the failed action if transaction fails
+    void
+    record_action_costs(const transaction_trace& trace) {
+        for(auto& at : trace.action_traces) {
+            action_costs.add(at, at.except.has_value());
+        }
+    }
+
     transaction_trace_ptr
     push_suspend_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline) {
         try {
@@ -683,6 +1066,7 @@ struct controller_impl {
                 trx_context.init_for_suspend_trx();
                 trx_context.exec();
                 trx_context.finalize();
+                record_action_costs(*trace);
 
                 auto restore = make_block_restore_point();
 
@@ -693,7 +1077,7 @@ struct controller_impl {
                 fc::move_append(pending->_actions, move(trx_context.executed));
 
                 emit(self.accepted_transaction, trx);
-                emit(self.applied_transaction, trace);
+                emit_applied_transaction(trace);
 
                 trx_context.squash();
                 restore.cancel();
@@ -703,6 +1087,9 @@ struct controller_impl {
                 trace->except     = e;
                 trace->except_ptr = std::current_exception();
                 trace->elapsed    = fc::time_point::now() - trx_context.start;
+                if(!trace->action_traces.empty() && trace->action_traces.back().except) {
+                    record_action_costs(*trace);
+                }
             }
             trx_context.undo();
 
@@ -719,7 +1106,7 @@ struct controller_impl {
                                               transaction_receipt::suspend);
             }
             emit(self.accepted_transaction, trx);
-            emit(self.applied_transaction, trace);
+            emit_applied_transaction(trace);
             return trace;
         }
         FC_CAPTURE_AND_RETHROW()
@@ -742,22 +1129,41 @@ struct controller_impl {
             trx_context.deadline = deadline;
             trace                = trx_context.trace;
 
+            if(trx->timestamps) {
+                trx->timestamps->mark(trx_timestamps::exec_start);
+            }
+
             try {
-                if(trx->implicit) {
-                    trx_context.init_for_implicit_trx();
-                }
-                else {
-                    bool skip_recording = replay_head_time && (time_point(trn.expiration) <= *replay_head_time);
-                    trx_context.init_for_input_trx(skip_recording);
+                {
+                    auto pm = perf_marker(perf, perf_phase::trx_init);
+                    if(trx->implicit) {
+                        trx_context.init_for_implicit_trx();
+                    }
+                    else {
+                        bool skip_recording = replay_head_time && (time_point(trn.expiration) <= *replay_head_time);
+                        trx_context.init_for_input_trx(skip_recording);
+                    }
                 }
 
                 if(!self.skip_auth_check() && !trx->implicit) {
-                    const auto& keys = trx->recover_keys(chain_id);
-                    check_authorization(keys, trn);
+                    auto keys = (const public_keys_set*)nullptr;
+                    {
+                        auto t  = phase_timer(timing(&controller::phase_timings::recover_us));
+                        auto pm = perf_marker(perf, perf_phase::trx_recover);
+                        keys    = &trx->recover_keys(chain_id);
+                    }
+                    auto t  = phase_timer(timing(&controller::phase_timings::auth_us));
+                    auto pm = perf_marker(perf, perf_phase::trx_auth);
+                    check_authorization(*keys, trn);
                 }
 
-                trx_context.exec();
-                trx_context.finalize();  // Automatically rounds up network and CPU usage in trace and bills payers if successful
+                {
+                    auto t  = phase_timer(timing(&controller::phase_timings::apply_us));
+                    auto pm = perf_marker(perf, perf_phase::trx_apply);
+                    trx_context.exec();
+                    trx_context.finalize();  // Automatically rounds up network and CPU usage in trace and bills payers if successful
+                }
+                record_action_costs(*trace);
 
                 auto restore = make_block_restore_point();
 
@@ -781,7 +1187,7 @@ struct controller_impl {
                     emit(self.accepted_transaction, trx);
                 }
 
-                emit(self.applied_transaction, trace);
+                emit_applied_transaction(trace);
 
                 if(read_mode != db_read_mode::SPECULATIVE && pending->_block_status == controller::block_status::incomplete) {
                     //this may happen automatically in destructor, but I prefere make it more explicit
@@ -795,18 +1201,24 @@ struct controller_impl {
                 if(!trx->implicit) {
                     unapplied_transactions.erase(trx->signed_id);
                 }
+                if(trx->timestamps) {
+                    trx->timestamps->mark(trx_timestamps::exec_end);
+                }
                 return trace;
             }
             catch(const fc::exception& e) {
                 trace->except     = e;
                 trace->except_ptr = std::current_exception();
+                if(!trace->action_traces.empty() && trace->action_traces.back().except) {
+                    record_action_costs(*trace);
+                }
             }
             if(!failure_is_subjective(*trace->except)) {
                 unapplied_transactions.erase(trx->signed_id);
             }
 
             emit(self.accepted_transaction, trx);
-            emit(self.applied_transaction, trace);
+            emit_applied_transaction(trace);
 
             return trace;
         }
@@ -817,6 +1229,7 @@ struct controller_impl {
     start_block(block_timestamp_type when, uint16_t confirm_block_count, controller::block_status s, const optional<block_id_type>& producer_block_id) {
         EVT_ASSERT(!pending.has_value(), block_validate_exception, "pending block already exists");
 
+        auto pm = perf_marker(perf, perf_phase::start_block);
         auto guard_pending = fc::make_scoped_exit([this]() {
             pending.reset();
         });
@@ -833,19 +1246,23 @@ struct controller_impl {
 
         pending->_block_status                          = s;
         pending->_producer_block_id                     = producer_block_id;
-        pending->_pending_block_state                   = std::make_shared<block_state>(*head, when);  // promotes pending schedule (if any) to active
+        pending->_pending_block_state                   = make_block_state(*head, when);  // promotes pending schedule (if any) to active
         pending->_pending_block_state->in_current_chain = true;
 
         pending->_pending_block_state->set_confirmed(confirm_block_count);
 
         auto was_pending_promoted = pending->_pending_block_state->maybe_promote_pending();
 
+        // looked up after promoting, the same as paycharge did when it credited the producer directly
+        auto& pbs = pending->_pending_block_state;
+        pending->_charge_collector = address(pbs->get_scheduled_producer(pbs->header.timestamp).block_signing_key);
+
         //modify state in speculative block only if we are speculative reads mode (other wise we need clean state for head or irreversible reads)
         if(read_mode == db_read_mode::SPECULATIVE || pending->_block_status != controller::block_status::incomplete) {
             const auto& gpo = db.get<global_property_object>();
             if(gpo.proposed_schedule_block_num.has_value() &&                                                      // if there is a proposed schedule that was proposed in a block ...
                (*gpo.proposed_schedule_block_num <= pending->_pending_block_state->dpos_irreversible_blocknum) &&  // ... that has now become irreversible ...
-               pending->_pending_block_state->pending_schedule.producers.size() == 0 &&                            // ... and there is room for a new pending schedule ...
+               pending->_pending_block_state->pending_schedule->producers.size() == 0 &&                            // ... and there is room for a new pending schedule ...
                !was_pending_promoted                                                                               // ... and not just because it was promoted to active at the start of this block, then:
             ) {
                 // Promote proposed schedule to pending schedule.
@@ -877,21 +1294,87 @@ struct controller_impl {
     }  /// sign_block
 
     void
-    apply_block(const signed_block_ptr& b, controller::block_status s) {
+    sign_block_async(const std::function<signature_type(const digest_type&)>& signer_callback) {
+        auto p = pending->_pending_block_state;
+        pending->_signature = std::async(std::launch::async, [signer_callback, d = p->sig_digest()] {
+            return signer_callback(d);
+        });
+    }
+
+    // signee and transaction merkle of received block are checked on thread pool, the check is joined at commit
+    void
+    start_header_check(const block_state_ptr& bs) {
+        auto task = std::make_shared<std::packaged_task<void()>>([bs] {
+            bs->verify_signee(bs->signee());
+
+            auto  trx_digests = vector<digest_type>();
+            auto& trxs        = bs->block->transactions;
+            trx_digests.reserve(trxs.size());
+            for(const auto& trx : trxs) {
+                trx_digests.emplace_back(trx.digest());
+            }
+            // it's already on thread pool, so levels are not hashed in parallel
+            EVT_ASSERT(merkle(move(trx_digests)) == bs->header.transaction_mroot, block_validate_exception,
+                "transaction merkle root does not match", ("block_num", bs->block_num));
+        });
+        bs->header_check = task->get_future().share();
+
+        boost::asio::post(thread_pool, [task] {
+            (*task)();
+        });
+    }
+
+    void
+    apply_block(const signed_block_ptr& b, controller::block_status s, const std::shared_future<void>& header_check = std::shared_future<void>()) {
         try {
             try {
                 EVT_ASSERT(b->block_extensions.size() == 0, block_validate_exception, "no supported extensions");
                 auto producer_block_id = b->id();
                 start_block(b->timestamp, b->confirmed, s, producer_block_id);
 
+                // recover keys of all the transactions on thread pool at first
+                // each transaction only waits for its own keys when it's pushed
+                auto recover_keys = !self.skip_auth_check();
+                auto mtrxs        = std::vector<transaction_metadata_ptr>();
+                auto unpack_timer = std::optional<phase_timer>(std::in_place, timing(&controller::phase_timings::unpack_us));
+                if(prefetched.block == b) {
+                    // prepared by replay prefetcher
+                    mtrxs = std::move(prefetched.trxs);
+                    prefetched = prefetched_block();
+                }
+                else {
+                    mtrxs.reserve(b->transactions.size());
+                    for(const auto& receipt : b->transactions) {
+                        if(receipt.type == transaction_receipt::input) {
+                            auto mtrx = std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(receipt.trx));
+                            if(recover_keys) {
+                                transaction_metadata::start_recover_keys(mtrx, thread_pool, chain_id, conf.parallel_recover_sigs);
+                            }
+                            mtrxs.emplace_back(std::move(mtrx));
+                        }
+                    }
+                }
+
+                unpack_timer.reset();
+
+                // read sets of at most `trx_prefetch_ahead` transactions after the one being applied are prefetched
+                auto prefetch_until = (size_t)1;
+                auto prefetch_ahead = [&](size_t i) {
+                    if(!trx_prefetcher) {
+                        return;
+                    }
+                    for(; prefetch_until < mtrxs.size() && prefetch_until <= i + conf.trx_prefetch_ahead; prefetch_until++) {
+                        trx_prefetcher->add(mtrxs[prefetch_until]);
+                    }
+                };
+
                 auto num_pending_receipts = pending->_pending_block_state->block->transactions.size();
+                auto mtrx_it              = mtrxs.cbegin();
                 for(const auto& receipt : b->transactions) {
                     auto trace = transaction_trace_ptr();
                     if(receipt.type == transaction_receipt::input) {
-                        auto& pt    = receipt.trx;
-                        auto  mtrx  = std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(pt));
-                        
-                        trace = push_transaction(mtrx, fc::time_point::maximum());
+                        prefetch_ahead(mtrx_it - mtrxs.cbegin());
+                        trace = push_transaction(*mtrx_it++, fc::time_point::maximum());
                     }
                     else if(receipt.type == transaction_receipt::suspend) {
                         // suspend transaction is executed in its parent transaction
@@ -908,6 +1391,10 @@ struct controller_impl {
                         edump((*trace));
                         throw *trace->except;
                     }
+                    if(trusted_replay) {
+                        num_pending_receipts++;
+                        continue;
+                    }
                     EVT_ASSERT(pending->_pending_block_state->block->transactions.size() > 0,
                                block_validate_exception, "expected a receipt",
                                ("block", *b)("expected_receipt", receipt)
@@ -925,7 +1412,29 @@ struct controller_impl {
                     num_pending_receipts++;
                 }
 
-                finalize_block();
+                if(trusted_replay) {
+                    // merkle roots are taken from the trusted block instead of being calculated
+                    pending->_pending_block_state->header.action_mroot      = b->action_mroot;
+                    pending->_pending_block_state->header.transaction_mroot = b->transaction_mroot;
+                }
+                else if(header_check.valid()) {
+                    // receipts of inputs are made of the same transactions as the ones in block and checked above
+                    // so only the suspend ones executed here are compared, merkle of block is checked by header check
+                    auto& rs = pending->_pending_block_state->block->transactions;
+                    EVT_ASSERT(rs.size() == b->transactions.size(), block_validate_exception, "number of receipts does not match");
+                    for(auto i = 0u; i < rs.size(); i++) {
+                        if(b->transactions[i].type == transaction_receipt::suspend) {
+                            EVT_ASSERT(rs[i].digest() == b->transactions[i].digest(), block_validate_exception, "suspend receipt does not match",
+                                ("producer_receipt", b->transactions[i])("validator_receipt", rs[i]));
+                        }
+                    }
+                    pending->_pending_block_state->header.transaction_mroot = b->transaction_mroot;
+                    pending->_trx_mroot_checked = true;
+                }
+                {
+                    auto t = phase_timer(timing(&controller::phase_timings::finalize_us));
+                    finalize_block();
+                }
 
                 // this implicitly asserts that all header fields (less the signature) are identical
                 EVT_ASSERT(producer_block_id == pending->_pending_block_state->header.id(),
@@ -936,12 +1445,17 @@ struct controller_impl {
                 // in the future we can optimize this by serializing the original and not the copy
 
                 // we can always trust this signature because,
-                //   - prior to apply_block, we call fork_db.add which does a signature check IFF the block is untrusted
+                //   - prior to apply_block, we call fork_db.add which does a signature check IFF the block is untrusted,
+                //     or the check of received block is started on thread pool and joined below before commit
                 //   - OTHERWISE the block is trusted and therefore we trust that the signature is valid
                 // Also, as ::sign_block does not lazily calculate the digest of the block, we can just short-circuit to save cycles
                 pending->_pending_block_state->header.producer_signature = b->producer_signature;
                 static_cast<signed_block_header&>(*pending->_pending_block_state->block) =  pending->_pending_block_state->header;
 
+                auto t = phase_timer(timing(&controller::phase_timings::commit_us));
+                if(header_check.valid()) {
+                    header_check.get();
+                }
                 commit_block(false);
                 return;
             }
@@ -968,7 +1482,12 @@ struct controller_impl {
             EVT_ASSERT(s != controller::block_status::incomplete, block_validate_exception, "invalid block status for a completed block");
             emit(self.pre_accepted_block, b);
 
-            auto new_header_state = fork_db.add(b, false);
+            auto new_header_state = block_state_ptr();
+            {
+                auto pm = perf_marker(perf, perf_phase::fork_db);
+                new_header_state = fork_db.add(b, true /* skip_validate_signee */);
+            }
+            start_header_check(new_header_state);
 
             if(conf.trusted_producers.count(b->producer)) {
                 trusted_producer_light_validation = true;
@@ -978,6 +1497,17 @@ struct controller_impl {
             if(read_mode != db_read_mode::IRREVERSIBLE) {
                 maybe_switch_forks(s);
             }
+
+            // block not applied now is checked before it's kept in fork database
+            if(!new_header_state->in_current_chain) {
+                try {
+                    new_header_state->header_check.get();
+                }
+                catch(const fc::exception&) {
+                    fork_db.set_validity(new_header_state, false);
+                    throw;
+                }
+            }
         }
         FC_LOG_AND_RETHROW()
     }
@@ -994,8 +1524,12 @@ struct controller_impl {
             EVT_ASSERT(s != controller::block_status::incomplete, block_validate_exception, "invalid block status for a completed block");
             emit(self.pre_accepted_block, b);
 
-            const bool skip_validate_signee = !conf.force_all_checks;
-            auto new_header_state = fork_db.add(b, skip_validate_signee);
+            const bool skip_validate_signee = !conf.force_all_checks || trusted_replay;
+            auto new_header_state = block_state_ptr();
+            {
+                auto pm = perf_marker(perf, perf_phase::fork_db);
+                new_header_state = fork_db.add(b, skip_validate_signee);
+            }
 
             emit(self.accepted_block_header, new_header_state);
 
@@ -1017,7 +1551,7 @@ struct controller_impl {
 
         if(new_head->header.previous == head->id) {
             try {
-                apply_block(new_head->block, s);
+                apply_block(new_head->block, s, new_head->header_check);
                 fork_db.mark_in_current_chain(new_head, true);
                 fork_db.set_validity(new_head, true);
                 head = new_head;
@@ -1030,7 +1564,11 @@ struct controller_impl {
         else if(new_head->id != head->id) {
             ilog("switching forks from ${current_head_id} (block number ${current_head_num}) to ${new_head_id} (block number ${new_head_num})",
                  ("current_head_id", head->id)("current_head_num", head->block_num)("new_head_id", new_head->id)("new_head_num", new_head->block_num));
-            auto branches = fork_db.fetch_branch_from(new_head->id, head->id);
+            auto branches = std::pair<branch_type, branch_type>();
+            {
+                auto pm  = perf_marker(perf, perf_phase::fork_db);
+                branches = fork_db.fetch_branch_from(new_head->id, head->id);
+            }
 
             for(auto itr = branches.second.begin(); itr != branches.second.end(); ++itr) {
                 fork_db.mark_in_current_chain(*itr, false);
@@ -1042,7 +1580,7 @@ struct controller_impl {
             for(auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr) {
                 optional<fc::exception> except;
                 try {
-                    apply_block((*ritr)->block,  (*ritr)->validated ? controller::block_status::validated : controller::block_status::complete);
+                    apply_block((*ritr)->block,  (*ritr)->validated ? controller::block_status::validated : controller::block_status::complete, (*ritr)->header_check);
                     head = *ritr;
                     fork_db.mark_in_current_chain(*ritr, true);
                     (*ritr)->validated = true;
@@ -1088,6 +1626,7 @@ struct controller_impl {
                     unapplied_transactions[t->signed_id] = t;
                 }
             }
+            emit(self.aborted_block, pending->_pending_block_state);
             pending.reset();
         }
     }
@@ -1097,15 +1636,25 @@ struct controller_impl {
         return false;
     }
 
-    void
-    set_action_merkle() {
-        vector<digest_type> action_digests;
-        action_digests.reserve(pending->_actions.size());
-        for(const auto& a : pending->_actions) {
-            action_digests.emplace_back(a.digest());
-        }
+    // digests of actions are hashed on thread pool while the rest of block is finalized
+    std::future<vector<digest_type>>
+    start_action_digests() {
+        auto task = std::packaged_task<vector<digest_type>()>([&actions = pending->_actions] {
+            auto action_digests = vector<digest_type>();
+            action_digests.reserve(actions.size());
+            for(const auto& a : actions) {
+                action_digests.emplace_back(a.digest());
+            }
+            return action_digests;
+        });
+        auto f = task.get_future();
+        boost::asio::post(thread_pool, std::move(task));
+        return f;
+    }
 
-        pending->_pending_block_state->header.action_mroot = merkle(move(action_digests));
+    void
+    set_action_merkle(std::future<vector<digest_type>>& action_digests) {
+        pending->_pending_block_state->header.action_mroot = merkle(action_digests.get(), &thread_pool);
     }
 
     void
@@ -1117,15 +1666,69 @@ struct controller_impl {
             trx_digests.emplace_back(trx.digest());
         }
 
-        pending->_pending_block_state->header.transaction_mroot = merkle(move(trx_digests));
+        pending->_pending_block_state->header.transaction_mroot = merkle(move(trx_digests), &thread_pool);
+    }
+
+    void
+    fold_bonus_accruals() {
+        pending->_bonus_accruals.fold([&](auto sym_id, auto amount) {
+            auto addr = address(N(.psvbonus), name128::from_number(sym_id), 0);
+            auto str  = std::string();
+            token_db.read_asset(addr, sym_id, str);
+
+            auto prop = contracts::property();
+            extract_db_value(str, prop);
+
+            prop.amount += amount;
+            auto dv = make_db_value(prop);
+            token_db.put_asset(addr, sym_id, dv.as_string_view());
+        });
+    }
+
+    // collector is created by the first charge of block within paycharge
+    void
+    fold_charge_accruals() {
+        pending->_charge_accruals.fold([&](auto sym_id, auto amount) {
+            auto& addr = pending->_charge_collector;
+            auto  str  = std::string();
+            token_db.read_asset(addr, sym_id, str);
+
+            auto prop = contracts::property();
+            extract_db_value(str, prop);
+
+            prop.amount += amount;
+            auto dv = make_db_value(prop);
+            token_db.put_asset(addr, sym_id, dv.as_string_view());
+        });
     }
 
     void
     finalize_block() {
         EVT_ASSERT(pending.has_value(), block_validate_exception, "it is not valid to finalize when there is no pending block");
+
+        auto pm = perf_marker(perf, perf_phase::finalize_block);
         try {
-            set_action_merkle();
-            set_trx_merkle();
+            auto action_digests = std::future<vector<digest_type>>();
+            if(!trusted_replay) {
+                action_digests = start_action_digests();
+            }
+            // actions are left untouched by folding, so digests are hashed meanwhile
+            auto join_digests = fc::make_scoped_exit([&] {
+                if(action_digests.valid()) {
+                    action_digests.wait();
+                }
+            });
+
+            // collection addresses are created by the first accrual within actions
+            fold_bonus_accruals();
+            fold_charge_accruals();
+
+            if(!trusted_replay) {
+                set_action_merkle(action_digests);
+                if(!pending->_trx_mroot_checked) {
+                    set_trx_merkle();
+                }
+            }
 
             auto p = pending->_pending_block_state;
             p->id  = p->header.id();
@@ -1218,6 +1821,24 @@ controller::token_db_cache() const {
     return my->token_db_cache;
 }
 
+bonus_accruals&
+controller::pending_bonus_accruals() const {
+    EVT_ASSERT(my->pending.has_value(), block_validate_exception, "No pending block");
+    return my->pending->_bonus_accruals;
+}
+
+bonus_accruals&
+controller::pending_charge_accruals() const {
+    EVT_ASSERT(my->pending.has_value(), block_validate_exception, "No pending block");
+    return my->pending->_charge_accruals;
+}
+
+const address&
+controller::pending_charge_collector() const {
+    EVT_ASSERT(my->pending.has_value(), block_validate_exception, "No pending block");
+    return my->pending->_charge_collector;
+}
+
 charge_manager
 controller::get_charge_manager() const {
     return charge_manager(*this, my->exec_ctx);
@@ -1245,6 +1866,11 @@ controller::sign_block(const std::function<signature_type(const digest_type&)>&
     my->sign_block(signer_callback);
 }
 
+void
+controller::sign_block_async(const std::function<signature_type(const digest_type&)>& signer_callback) {
+    my->sign_block_async(signer_callback);
+}
+
 void
 controller::commit_block() {
     validate_db_available_size();
@@ -1408,6 +2034,24 @@ controller::fetch_block_by_number(uint32_t block_num) const {
     FC_CAPTURE_AND_RETHROW((block_num))
 }
 
+block_log::packed_block
+controller::fetch_packed_block_by_number(uint32_t block_num) const {
+    try {
+        auto blk_state = my->fork_db.get_block_in_current_chain_by_num(block_num);
+        if(blk_state && blk_state->block) {
+            return block_log::packed_block::from_block(*blk_state->block);
+        }
+
+        return my->blog.read_packed_block_by_num(block_num);
+    }
+    FC_CAPTURE_AND_RETHROW((block_num))
+}
+
+uint32_t
+controller::earliest_available_block_num() const {
+    return my->blog.earliest_block_num();
+}
+
 block_state_ptr
 controller::fetch_block_state_by_id(block_id_type id) const {
     auto state = my->fork_db.get_block(id);
@@ -1444,18 +2088,12 @@ controller::get_block_id_for_num(uint32_t block_num) const {
 
 evt_link_object
 controller::get_link_obj_for_link_id(const link_id_type& link_id) const {
-    evt_link_object link_obj;
-
-    auto str = std::string();
-    try {
-        my->token_db.read_token(token_type::evtlink, std::nullopt, link_id, str);
-    }
-    catch(token_database_exception&) {
+    // links paid are kept in object cache, which drops them if they're rolled back
+    auto link_obj = my->token_db_cache.read_token<evt_link_object>(token_type::evtlink, std::nullopt, link_id, true);
+    if(link_obj == nullptr) {
         EVT_THROW2(evt_link_existed_exception, "Cannot find EvtLink with id: {}", fc::to_hex((char*)&link_id, sizeof(link_id)));
     }
-
-    extract_db_value(str, link_obj);
-    return link_obj;
+    return *link_obj;
 }
 
 uint32_t
@@ -1480,6 +2118,18 @@ controller::write_snapshot(const snapshot_writer_ptr& snapshot) const {
     return my->add_to_snapshot(snapshot);
 }
 
+std::shared_future<void>
+controller::write_snapshot_async(const snapshot_writer_ptr& snapshot) {
+    EVT_ASSERT(!my->pending.has_value(), block_validate_exception, "cannot take a consistent snapshot with a pending block");
+    return my->write_snapshot_async(snapshot);
+}
+
+std::shared_future<void>
+controller::write_incremental_snapshot_async(const snapshot_writer_ptr& snapshot, const block_id_type& base_id, std::vector<token_delta>&& deltas) {
+    EVT_ASSERT(!my->pending.has_value(), block_validate_exception, "cannot take a consistent snapshot with a pending block");
+    return my->write_incremental_snapshot_async(snapshot, base_id, std::move(deltas));
+}
+
 void
 controller::pop_block() {
     my->pop_block();
@@ -1504,14 +2154,14 @@ controller::set_proposed_producers(vector<producer_key> producers) {
     decltype(sch.producers.cend()) end;
     decltype(end)                  begin;
 
-    if(my->pending->_pending_block_state->pending_schedule.producers.size() == 0) {
-        const auto& active_sch = my->pending->_pending_block_state->active_schedule;
+    if(my->pending->_pending_block_state->pending_schedule->producers.size() == 0) {
+        const auto& active_sch = *my->pending->_pending_block_state->active_schedule;
         begin                  = active_sch.producers.begin();
         end                    = active_sch.producers.end();
         sch.version            = active_sch.version + 1;
     }
     else {
-        const auto& pending_sch = my->pending->_pending_block_state->pending_schedule;
+        const auto& pending_sch = *my->pending->_pending_block_state->pending_schedule;
         begin                   = pending_sch.producers.begin();
         end                     = pending_sch.producers.end();
         sch.version             = pending_sch.version + 1;
@@ -1565,17 +2215,17 @@ controller::set_action_version(name action, int version) {
 const producer_schedule_type&
 controller::active_producers() const {
     if(!(my->pending.has_value())) {
-        return my->head->active_schedule;
+        return *my->head->active_schedule;
     }
-    return my->pending->_pending_block_state->active_schedule;
+    return *my->pending->_pending_block_state->active_schedule;
 }
 
 const producer_schedule_type&
 controller::pending_producers() const {
     if(!(my->pending.has_value())) {
-        return my->head->pending_schedule;
+        return *my->head->pending_schedule;
     }
-    return my->pending->_pending_block_state->pending_schedule;
+    return *my->pending->_pending_block_state->pending_schedule;
 }
 
 optional<producer_schedule_type>
@@ -1595,6 +2245,11 @@ controller::light_validation_allowed(bool replay_opts_disabled_by_policy) const
 
     const auto pb_status = my->pending->_block_status;
 
+    // in a trusted block when replaying, skip regardless of the policies
+    if(my->trusted_replay && pb_status == block_status::irreversible) {
+        return true;
+    }
+
     // in a pending irreversible or previously validated block and we have forcing all checks
     const bool consider_skipping_on_replay = (pb_status == block_status::irreversible || pb_status == block_status::validated) && !replay_opts_disabled_by_policy;
 
@@ -1614,7 +2269,7 @@ bool
 controller::skip_db_sessions(block_status bs) const {
     bool consider_skipping = bs == block_status::irreversible;
     return consider_skipping
-           && !my->conf.disable_replay_opts
+           && (!my->conf.disable_replay_opts || my->trusted_replay)
            && !my->in_trx_requiring_checks;
 }
 
@@ -1668,11 +2323,48 @@ controller::get_genesis_state() const {
     return my->conf.genesis;
 }
 
+boost::asio::thread_pool&
+controller::get_thread_pool() {
+    return my->thread_pool;
+}
+
+block_bus*
+controller::get_block_bus() const {
+    return my->bus.get();
+}
+
+void
+controller::set_phase_timings(phase_timings* timings) {
+    my->timings = timings;
+}
+
+perf_stats&
+controller::get_perf_stats() {
+    return my->perf;
+}
+
+const action_cost_table&
+controller::get_action_costs() const {
+    return my->action_costs;
+}
+
+deadline_timer&
+controller::get_deadline_timer() {
+    return my->trx_timer;
+}
+
 const abi_serializer&
 controller::get_abi_serializer() const {
     return my->system_api;
 }
 
+void
+controller::prefetch_transaction(const transaction_metadata_ptr& trx) {
+    if(my->trx_prefetcher) {
+        my->trx_prefetcher->add(trx);
+    }
+}
+
 unapplied_transactions_type&
 controller::get_unapplied_transactions() const {
     if(my->read_mode != db_read_mode::SPECULATIVE) {
@@ -1730,7 +2422,7 @@ controller::validate_db_available_size() const {
 
 void
 controller::validate_reversible_available_size() const {
-   const auto free = my->reversible_blocks.get_segment_manager()->get_free_memory();
+   const auto free = my->reversible_blocks.free_size();
    const auto guard = my->conf.reversible_guard_size;
    EVT_ASSERT(free >= guard, reversible_guard_exception, "reversible free: ${f}, guard size: ${g}", ("f", free)("g",guard));
 }
@@ -1743,7 +2435,35 @@ controller::is_known_unexpired_transaction(const transaction_id_type& id) const
 public_keys_set
 controller::get_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const {
     const static uint32_t max_authority_depth = my->conf.genesis.initial_configuration.max_authority_depth;
+
+    // result only depends on actions, payer and candidate keys besides the state
+    auto enc = digest_type::encoder();
+    fc::raw::pack(enc, trx.actions);
+    fc::raw::pack(enc, trx.payer);
+    fc::raw::pack(enc, fc::unsigned_int((uint32_t)candidate_keys.size()));
+    for(auto& k : candidate_keys) {
+        fc::raw::pack(enc, k);
+    }
+    auto digest = enc.result();
+
+    auto& cache = my->required_keys_cache;
+    auto  pv    = active_producers().version;
+    if(auto it = cache.find(digest); it != cache.end()) {
+        auto& entry = it->second;
+        auto  valid = entry.producers_version == pv;
+        for(auto i = 0u; valid && i < entry.deps.size(); i++) {
+            auto& d = entry.deps[i];
+            valid = my->token_db.token_version(d.type, d.domain, d.key) == d.version;
+        }
+        if(valid) {
+            return entry.keys;
+        }
+        cache.erase(it);
+    }
+
+    auto deps    = authority_deps();
     auto checker = authority_checker(*this, my->exec_ctx, candidate_keys, max_authority_depth);
+    checker.record_deps(deps);
 
     for(const auto& act : trx.actions) {
         EVT_ASSERT(checker.satisfied(act), unsatisfied_authorization,
@@ -1755,9 +2475,24 @@ controller::get_required_keys(const transaction& trx, const public_keys_set& can
     if(trx.payer.type() == address::public_key_t) {
         keys.emplace(trx.payer.get_public_key());
     }
+
+    if(cache.size() >= kMaxRequiredKeysCacheSize) {
+        cache.clear();
+    }
+    cache.emplace(digest, required_keys_entry { keys, std::move(deps), pv });
     return keys;
 }
 
+std::vector<public_keys_set>
+controller::get_required_keys(const std::vector<transaction>& trxs, const public_keys_set& candidate_keys) const {
+    auto result = std::vector<public_keys_set>();
+    result.reserve(trxs.size());
+    for(auto& trx : trxs) {
+        result.emplace_back(get_required_keys(trx, candidate_keys));
+    }
+    return result;
+}
+
 public_keys_set
 controller::get_suspend_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const {
     const static uint32_t max_authority_depth = my->conf.genesis.initial_configuration.max_authority_depth;
@@ -1791,10 +2526,13 @@ controller::get_suspend_required_keys(const proposal_name& name, const public_ke
 }
 
 uint32_t
-controller::get_charge(transaction&& trx, size_t signautres_num) const {   
-    auto ptrx   = packed_transaction(std::move(trx),  {});
+controller::get_charge(transaction&& trx, size_t signautres_num) const {
+    // same as the unprunable size of uncompressed packed transaction, but without packing it
+    auto size = config::fixed_net_overhead_of_packed_trx + fc::raw::pack_size(trx);
+    EVT_ASSERT(size <= std::numeric_limits<uint32_t>::max(), tx_too_big, "packed_transaction is too big");
+
     auto charge = get_charge_manager();
-    return charge.calculate(ptrx, signautres_num);
+    return charge.calculate(trx, (uint32_t)size, signautres_num);
 }
 
 }}  // namespace evt::chain
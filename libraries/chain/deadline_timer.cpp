@@ -0,0 +1,70 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/deadline_timer.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+std::chrono::system_clock::time_point
+to_system_time(fc::time_point tp) {
+    return std::chrono::system_clock::time_point(std::chrono::microseconds(tp.time_since_epoch().count()));
+}
+
+}  // namespace internal
+
+deadline_timer::deadline_timer()
+    : deadline_(fc::time_point::maximum())
+    , waiting_(fc::time_point::maximum())
+    , stop_(false)
+    , expired_(false) {
+    thread_ = std::thread([this] { run(); });
+}
+
+deadline_timer::~deadline_timer() {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+fc::time_point
+deadline_timer::arm(fc::time_point deadline) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    auto prev = deadline_;
+
+    deadline_ = deadline;
+    expired_.store(false, std::memory_order_relaxed);
+    if(deadline < waiting_) {
+        lock.unlock();
+        cv_.notify_one();
+    }
+    return prev;
+}
+
+void
+deadline_timer::run() {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    while(!stop_) {
+        if(deadline_ == fc::time_point::maximum()) {
+            waiting_ = deadline_;
+            cv_.wait(lock);
+            continue;
+        }
+        if(fc::time_point::now() >= deadline_) {
+            expired_.store(true, std::memory_order_relaxed);
+            // wait for next one
+            waiting_ = fc::time_point::maximum();
+            cv_.wait(lock);
+            continue;
+        }
+        waiting_ = deadline_;
+        cv_.wait_until(lock, internal::to_system_time(deadline_));
+    }
+}
+
+}}  // namespace evt::chain
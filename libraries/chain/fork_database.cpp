@@ -13,6 +13,8 @@
 #include <boost/multi_index_container.hpp>
 #include <fc/io/fstream.hpp>
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace evt { namespace chain {
 using boost::multi_index_container;
@@ -47,11 +49,148 @@ struct fork_database_impl {
     fork_multi_index_type index;
     block_state_ptr       head;
     fc::path              datadir;
+
+    // estimated bytes of each state, `packed` is only set when its block is packed
+    struct usage {
+        size_t            bytes;
+        std::vector<char> packed;
+    };
+
+    std::unordered_map<block_id_type, usage, std::hash<block_id_type>> usages;
+    uint64_t                                                           max_size   = 0;
+    uint64_t                                                           total_size = 0;
+
+    static size_t
+    estimate(const block_state& s) {
+        return sizeof(block_state) + (s.block ? fc::raw::pack_size(*s.block) : 0);
+    }
+
+    void
+    on_insert(const block_state_ptr& s) {
+        auto bytes = estimate(*s);
+        usages[s->id] = usage { bytes, {} };
+        total_size += bytes;
+    }
+
+    void
+    on_erase(const block_id_type& id) {
+        auto it = usages.find(id);
+        if(it != usages.end()) {
+            total_size -= it->second.bytes;
+            usages.erase(it);
+        }
+    }
+
+    // states are replaced instead of changed in place, since the old ones may be read by other threads
+    block_state_ptr
+    copy_state(const block_state& s, signed_block_ptr b) {
+        auto r              = make_block_state(static_cast<const block_header_state&>(s));
+        r->block            = std::move(b);
+        r->validated        = s.validated;
+        r->in_current_chain = s.in_current_chain;
+        r->trxs             = s.trxs;
+        return r;
+    }
+
+    void
+    pack(const block_state_ptr& s) {
+        auto& u = usages[s->id];
+        u.packed = fc::raw::pack(*s->block);
+
+        total_size -= u.bytes;
+        u.bytes = sizeof(block_state) + u.packed.size();
+        total_size += u.bytes;
+
+        index.replace(index.find(s->id), copy_state(*s, nullptr));
+    }
+
+    // unpacks the block if it's packed before
+    block_state_ptr
+    restore(const block_state_ptr& s) {
+        auto it = usages.find(s->id);
+        if(it == usages.end() || it->second.packed.empty()) {
+            return s;
+        }
+
+        auto b = std::make_shared<signed_block>();
+        fc::raw::unpack(it->second.packed, *b);
+
+        auto r = copy_state(*s, std::move(b));
+        index.replace(index.find(s->id), r);
+
+        total_size -= it->second.bytes;
+        it->second = usage { estimate(*r), {} };
+        total_size += it->second.bytes;
+        return r;
+    }
+
+    // removes the state and all the states built on it
+    void
+    erase_branch(const block_id_type& id) {
+        auto remove_queue = vector<block_id_type>{ id };
+
+        for(uint32_t i = 0; i < remove_queue.size(); ++i) {
+            auto itr = index.find(remove_queue[i]);
+            if(itr != index.end()) {
+                index.erase(itr);
+                on_erase(remove_queue[i]);
+            }
+
+            auto& previdx = index.get<by_prev>();
+            auto  previtr = previdx.lower_bound(remove_queue[i]);
+            while(previtr != previdx.end() && (*previtr)->header.previous == remove_queue[i]) {
+                remove_queue.push_back((*previtr)->id);
+                ++previtr;
+            }
+        }
+    }
+
+    void
+    enforce_max_size() {
+        if(max_size == 0 || total_size <= max_size) {
+            return;
+        }
+
+        // branch of head and current chain may be applied soon, they're kept as they are
+        auto live = std::unordered_set<block_id_type, std::hash<block_id_type>>();
+        for(auto it = index.find(head->id); it != index.end(); it = index.find((*it)->header.previous)) {
+            live.emplace((*it)->id);
+        }
+
+        auto dead = vector<block_state_ptr>();
+        for(auto& s : index.get<by_block_num>()) {
+            if(!s->in_current_chain && live.find(s->id) == live.end()) {
+                dead.emplace_back(s);
+            }
+        }
+
+        // blocks not validated are packed at first, oldest ones first
+        for(auto& s : dead) {
+            if(total_size <= max_size) {
+                return;
+            }
+            if(!s->validated && s->block) {
+                pack(s);
+            }
+        }
+
+        for(auto& s : dead) {
+            if(total_size <= max_size) {
+                return;
+            }
+            if(index.find(s->id) != index.end()) {
+                wlog("fork database is over ${m} bytes, remove dead branch from block ${n} (${id})",
+                    ("m", max_size)("n", s->block_num)("id", s->id));
+                erase_branch(s->id);
+            }
+        }
+    }
 };
 
-fork_database::fork_database(const fc::path& data_dir)
+fork_database::fork_database(const fc::path& data_dir, uint64_t max_size)
     : my(new fork_database_impl()) {
-    my->datadir = data_dir;
+    my->datadir  = data_dir;
+    my->max_size = max_size;
 
     if(!fc::is_directory(my->datadir))
         fc::create_directories(my->datadir);
@@ -67,7 +206,7 @@ fork_database::fork_database(const fc::path& data_dir)
         for(uint32_t i = 0, n = size.value; i < n; ++i) {
             block_state s;
             fc::raw::unpack(ds, s);
-            set(std::make_shared<block_state>(move(s)));
+            set(make_block_state(move(s)));
         }
         block_id_type head_id;
         fc::raw::unpack(ds, head_id);
@@ -89,6 +228,14 @@ fork_database::close() {
     uint32_t num_blocks_in_fork_db = my->index.size();
     fc::raw::pack(out, unsigned_int{num_blocks_in_fork_db});
     for(const auto& s : my->index) {
+        auto it = my->usages.find(s->id);
+        if(it != my->usages.end() && !it->second.packed.empty()) {
+            // block is packed, write the state with block unpacked
+            auto b = std::make_shared<signed_block>();
+            fc::raw::unpack(it->second.packed, *b);
+            fc::raw::pack(out, *my->copy_state(*s, std::move(b)));
+            continue;
+        }
         fc::raw::pack(out, *s);
     }
     if(my->head)
@@ -107,6 +254,8 @@ fork_database::close() {
     }
 
     my->index.clear();
+    my->usages.clear();
+    my->total_size = 0;
 }
 
 fork_database::~fork_database() {
@@ -121,6 +270,7 @@ fork_database::set(block_state_ptr s) {
     // EVT_ASSERT( s->block_num == s->header.block_num() );
 
     EVT_ASSERT(result.second, fork_database_exception, "unable to insert block state, duplicate state detected");
+    my->on_insert(s);
     if(!my->head) {
         my->head = s;
     }
@@ -142,6 +292,7 @@ fork_database::add(const block_state_ptr& n, bool skip_validate_previous) {
 
     auto inserted = my->index.insert(n);
     EVT_ASSERT(inserted.second, fork_database_exception, "duplicate block added?");
+    my->on_insert(n);
 
     my->head = *my->index.get<by_lib_block_num>().begin();
 
@@ -151,6 +302,7 @@ fork_database::add(const block_state_ptr& n, bool skip_validate_previous) {
     if(oldest->block_num < lib) {
         prune(oldest);
     }
+    my->enforce_max_size();
 
     return n;
 }
@@ -167,7 +319,7 @@ fork_database::add(signed_block_ptr b, bool skip_validate_signee) {
     auto prior = by_id_idx.find(b->previous);
     EVT_ASSERT(prior != by_id_idx.end(), unlinkable_block_exception, "unlinkable block", ("id", b->id())("previous", b->previous));
 
-    auto result = std::make_shared<block_state>(**prior, move(b), skip_validate_signee);
+    auto result = make_block_state(**prior, move(b), skip_validate_signee);
     EVT_ASSERT(result, fork_database_exception , "fail to add new block state");
     return add(result, true);
 }
@@ -219,20 +371,7 @@ fork_database::fetch_branch_from(const block_id_type& first, const block_id_type
 /// remove all of the invalid forks built of this id including this id
 void
 fork_database::remove(const block_id_type& id) {
-    vector<block_id_type> remove_queue{id};
-
-    for(uint32_t i = 0; i < remove_queue.size(); ++i) {
-        auto itr = my->index.find(remove_queue[i]);
-        if(itr != my->index.end())
-            my->index.erase(itr);
-
-        auto& previdx = my->index.get<by_prev>();
-        auto  previtr = previdx.lower_bound(remove_queue[i]);
-        while(previtr != previdx.end() && (*previtr)->header.previous == remove_queue[i]) {
-            remove_queue.push_back((*previtr)->id);
-            ++previtr;
-        }
-    }
+    my->erase_branch(id);
     // wdump((my->index.size()));
     my->head = *my->index.get<by_lib_block_num>().begin();
 }
@@ -276,8 +415,9 @@ fork_database::prune(const block_state_ptr& h) {
 
     auto itr = my->index.find(h->id);
     if(itr != my->index.end()) {
-        irreversible(*itr);
+        irreversible(my->restore(*itr));
         my->index.erase(itr);
+        my->on_erase(h->id);
     }
 
     auto& numidx = my->index.get<by_block_num>();
@@ -294,10 +434,15 @@ block_state_ptr
 fork_database::get_block(const block_id_type& id) const {
     auto itr = my->index.find(id);
     if(itr != my->index.end())
-        return *itr;
+        return my->restore(*itr);
     return block_state_ptr();
 }
 
+uint64_t
+fork_database::size() const {
+    return my->total_size;
+}
+
 block_state_ptr
 fork_database::get_block_in_current_chain_by_num(uint32_t n) const {
     const auto& numidx = my->index.get<by_block_num>();
@@ -320,7 +465,7 @@ fork_database::add(const header_confirmation& c) {
     b->add_confirmation(c);
 
     if(b->bft_irreversible_blocknum < b->block_num
-       && b->confirmations.size() >= ((b->active_schedule.producers.size() * 2) / 3 + 1)) {
+       && b->confirmations.size() >= ((b->active_schedule->producers.size() * 2) / 3 + 1)) {
         set_bft_irreversible(c.block_id);
     }
 }
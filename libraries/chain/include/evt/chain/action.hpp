@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <any>
+#include <memory>
 #include <type_traits>
 #include <evt/chain/types.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -24,39 +25,12 @@ public:
 public:
     action() : index_(-1) {}
 
-    // don't copy cache_ when in copy ctor.
-    action(const action& lhs)
-        : name(lhs.name)
-        , domain(lhs.domain)
-        , key(lhs.key)
-        , data(lhs.data)
-        , index_(lhs.index_)
-        , cache_() {}
-
+    // decoded data is immutable and shared between the copies, so traces don't unpack it again
+    action(const action& lhs) = default;
     action(action&& lhs) noexcept = default;
 
-    action& operator=(const action& lhs) {
-        if(this != &lhs) { // self-assignment check expected
-            name   = lhs.name;
-            domain = lhs.domain;
-            key    = lhs.key;
-            data   = lhs.data;
-            index_ = lhs.index_;
-        }
-        return *this;
-    }
-
-    action& operator=(action&& lhs) noexcept {
-        if(this != &lhs) { // self-assignment check expected
-            name   = lhs.name;
-            domain = lhs.domain;
-            key    = lhs.key;
-            data   = lhs.data;
-            index_ = lhs.index_;
-            cache_ = std::move(lhs.cache_);
-        }
-        return *this;
-    }
+    action& operator=(const action& lhs) = default;
+    action& operator=(action&& lhs) noexcept = default;
 
 public:
     template<typename T>
@@ -66,7 +40,7 @@ public:
         , key(key)
         , data(fc::raw::pack(value))
         , index_(-1)
-        , cache_(std::make_any<T>(value)) {}
+        , cache_(std::make_shared<const std::any>(std::in_place_type<T>, value)) {}
 
     action(const action_name name, const domain_name& domain, const domain_key& key, const bytes& data)
         : name(name)
@@ -79,7 +53,7 @@ public:
     void
     set_data(const T& value) {
         data   = fc::raw::pack(value);
-        cache_ = std::make_any<T>(value);
+        cache_ = std::make_shared<const std::any>(std::in_place_type<T>, value);
     }
 
     void
@@ -87,23 +61,24 @@ public:
         index_ = index;
     }
 
-    // if T is a reference, will return the reference to the internal cache value
-    // Otherwise if T is a value type, will return new copy. 
+    // data is unpacked at most once for one action and its copies
+    // if T is a const reference, will return the reference to the internal cache value
+    // Otherwise if T is a value type, will return new copy.
     template <typename T>
     T
     data_as() const {
-        if(!cache_.has_value()) {
+        if(!cache_) {
             using raw_type = std::remove_const_t<std::remove_reference_t<T>>;
             EVT_ASSERT(name == raw_type::get_action_name(), action_type_exception, "action name is not consistent with action struct");
-            cache_ = std::make_any<raw_type>(fc::raw::unpack<raw_type>(data));
+            cache_ = std::make_shared<const std::any>(std::in_place_type<raw_type>, fc::raw::unpack<raw_type>(data));
         }
         // no need to check name here, `any_cast` will throws exception if types don't match
-        return std::any_cast<T>(cache_);
+        return std::any_cast<T>(*cache_);
     }
 
 private:
-    mutable int      index_;
-    mutable std::any cache_;
+    mutable int                              index_;
+    mutable std::shared_ptr<const std::any> cache_;
 
 private:
     friend class apply_context;
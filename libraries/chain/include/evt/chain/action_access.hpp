@@ -0,0 +1,211 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <fc/io/raw.hpp>
+#include <evt/chain/action.hpp>
+#include <evt/chain/address.hpp>
+#include <evt/chain/asset.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Keys of token database which one action reads and writes, declared from the action data only.
+ *  Each action type in the action list of execution context has one `action_access` declaration,
+ *  the default one treats the action as updating the token of (domain, key) declared by it.
+ */
+class access_builder {
+public:
+    enum key_tag : char {
+        kAsset  = 'a',  // asset of one address
+        kSymbol = 's',  // all the assets of one symbol
+        kToken  = 't',  // (domain, key)
+        kDomain = 'd',  // whole domain
+        kGlobal = 'g'   // whole database
+    };
+
+public:
+    access_builder(std::vector<std::string>& reads, std::vector<std::string>& writes)
+        : reads_(reads), writes_(writes) {}
+
+public:
+    template<typename ... ARGS>
+    static std::string
+    make_key(key_tag tag, const ARGS& ... args) {
+        auto key    = std::string(1, (char)tag);
+        auto append = [&key](auto& v) {
+            auto data = fc::raw::pack(v);
+            key.append(data.data(), data.size());
+        };
+        (append(args), ...);
+        return key;
+    }
+
+public:
+    void
+    asset(const address& addr, symbol_id_type sym_id) {
+        writes_.emplace_back(make_key(kAsset, addr, sym_id));
+        // readers of one symbol-wide key conflict with whoever writes it, see everipay
+        reads_.emplace_back(make_key(kSymbol, sym_id));
+    }
+
+    void
+    fungible(const action& act) {
+        // fungible itself is only read by the actions moving assets
+        reads_.emplace_back(make_key(kToken, act.domain, act.key));
+    }
+
+    void
+    generic(const domain_name& domain, const domain_key& key) {
+        writes_.emplace_back(make_key(kToken, domain, key));
+        if(key.reserved()) {
+            // reserved keys (.create, .issue, .update...) update the domain itself
+            writes_.emplace_back(make_key(kDomain, domain));
+        }
+        else {
+            reads_.emplace_back(make_key(kDomain, domain));
+        }
+    }
+
+    void
+    symbol(symbol_id_type sym_id) {
+        writes_.emplace_back(make_key(kSymbol, sym_id));
+    }
+
+    void
+    global() {
+        writes_.emplace_back(make_key(kGlobal));
+    }
+
+private:
+    std::vector<std::string>& reads_;
+    std::vector<std::string>& writes_;
+};
+
+namespace internal {
+
+inline address
+get_fungible_access_address(symbol_id_type sym_id) {
+    return address(N(.fungible), name128::from_number(sym_id), 0);
+}
+
+}  // namespace internal
+
+// data is unpacked without touching the cache of action
+// because the current version of action is not known here
+template<uint64_t N>
+struct action_access {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        builder.generic(act.domain, act.key);
+    }
+};
+
+template<>
+struct action_access<N(transferft)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto tfact = fc::raw::unpack<T>(act.data);
+        builder.fungible(act);
+        builder.asset(tfact.from, tfact.number.sym().id());
+        builder.asset(tfact.to, tfact.number.sym().id());
+    }
+};
+
+template<>
+struct action_access<N(batchtransft)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto btact = fc::raw::unpack<T>(act.data);
+        builder.fungible(act);
+        for(auto& c : btact.credits) {
+            builder.asset(btact.from, c.number.sym().id());
+            builder.asset(c.to, c.number.sym().id());
+        }
+    }
+};
+
+template<>
+struct action_access<N(evt2pevt)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto epact = fc::raw::unpack<T>(act.data);
+        builder.fungible(act);
+        builder.asset(epact.from, epact.number.sym().id());
+        builder.asset(epact.to, pevt_sym().id());
+    }
+};
+
+template<>
+struct action_access<N(recycleft)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto rfact  = fc::raw::unpack<T>(act.data);
+        auto sym_id = rfact.number.sym().id();
+        builder.fungible(act);
+        builder.asset(rfact.address, sym_id);
+        builder.asset(internal::get_fungible_access_address(sym_id), sym_id);
+    }
+};
+
+template<>
+struct action_access<N(destroyft)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto dfact = fc::raw::unpack<T>(act.data);
+        builder.fungible(act);
+        builder.asset(dfact.address, dfact.number.sym().id());
+        builder.asset(address(), dfact.number.sym().id());
+    }
+};
+
+template<>
+struct action_access<N(issuefungible)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        auto ifact  = fc::raw::unpack<T>(act.data);
+        auto sym_id = ifact.number.sym().id();
+        builder.fungible(act);
+        builder.asset(ifact.address, sym_id);
+        builder.asset(internal::get_fungible_access_address(sym_id), sym_id);
+    }
+};
+
+template<>
+struct action_access<N(everipay)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        // payer is only known after the signatures of link are recovered,
+        // so everipay writes all the assets of its symbol and the link itself
+        // both versions of everipay start with the same fields
+        auto epact = fc::raw::unpack<T>(act.data);
+        builder.fungible(act);
+        builder.symbol(epact.number.sym().id());
+        builder.asset(epact.payee, epact.number.sym().id());
+        builder.generic(N128(.evtlink), epact.link.get_link_id());
+    }
+};
+
+template<>
+struct action_access<N(everipass)> {
+    template<typename T>
+    static void
+    invoke(const action& act, access_builder& builder) {
+        // token passed is inside the link, cannot tell it without checking the link
+        builder.global();
+    }
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,50 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <fc/variant.hpp>
+#include <evt/chain/trace.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Rolling costs of each action type, collected from the traces of executed transactions.
+ *  Besides totals since startup, a moving average weights the recent executions, so it follows
+ *  the changes of database size and load. Only used from main thread.
+ */
+class action_cost_table : boost::noncopyable {
+public:
+    using histogram = token_database_metrics::histogram;
+
+    // weight of the latest execution in the moving averages is 1 / kDecay
+    static constexpr int kDecay = 64;
+
+    struct entry {
+        uint64_t  count         = 0;
+        uint64_t  failed        = 0;
+        uint64_t  sum_us        = 0;
+        double    avg_us        = 0;  // moving average
+        uint64_t  db_reads      = 0;
+        uint64_t  db_writes     = 0;
+        double    avg_db_reads  = 0;
+        double    avg_db_writes = 0;
+        histogram latency;
+    };
+
+public:
+    void add(const action_trace& trace, bool failed = false);
+
+    // nullptr if the action is never executed
+    const entry* find(action_name act) const;
+
+    fc::variant to_variant() const;
+
+private:
+    std::unordered_map<action_name, entry> actions_;
+};
+
+}}  // namespace evt::chain
@@ -78,6 +78,8 @@ public:
 public:
     constexpr size_t get_bytes_size() const { return sizeof(fc::ecc::public_key_shim); }
     void to_bytes(char* buf, size_t sz) const;
+    // reverse of `to_bytes`, like the address part of the keys of assets in token database
+    static address from_bytes(const char* buf, size_t sz);
 
     std::string to_string() const;
 
@@ -0,0 +1,193 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+*/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace chain {
+
+// bump allocator for the short-lived data which are released together
+// nothing is freed individually, memory is only returned when arena is reset or destroyed
+class arena : boost::noncopyable {
+public:
+    static constexpr size_t kDefaultSlabSize = 4 * 1024;
+
+private:
+    struct slab {
+        char*  data;
+        size_t size;
+    };
+
+public:
+    arena(size_t slab_size = kDefaultSlabSize)
+        : slab_size_(slab_size)
+        , ptr_(0)
+        , end_(0) {}
+
+    ~arena() { release(); }
+
+public:
+    void*
+    allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        auto p = align_up(ptr_, align);
+        if(p + size > end_ || ptr_ == 0) {
+            return allocate_slow(size, align);
+        }
+        ptr_ = p + size;
+        return (void*)p;
+    }
+
+    template<typename T, typename ... ARGS>
+    T*
+    create(ARGS&&... args) {
+        return new(allocate(sizeof(T), alignof(T))) T(std::forward<ARGS>(args)...);
+    }
+
+    std::string_view
+    copy(const std::string_view& str) {
+        if(str.empty()) {
+            return std::string_view();
+        }
+        auto p = (char*)allocate(str.size(), 1);
+        memcpy(p, str.data(), str.size());
+        return std::string_view(p, str.size());
+    }
+
+    // releases all the slabs except the current one which is kept for reusing
+    void
+    reset() {
+        if(slabs_.empty()) {
+            return;
+        }
+        auto cur = slabs_.back();
+        slabs_.pop_back();
+        release();
+
+        if(cur.size == slab_size_) {
+            slabs_.emplace_back(cur);
+            ptr_ = (uintptr_t)cur.data;
+            end_ = ptr_ + cur.size;
+        }
+        else {
+            free(cur.data);
+        }
+    }
+
+    // takes over all the slabs of `rhs`, `rhs` becomes empty after that
+    // current slab of this arena is kept for later allocations
+    void
+    merge(arena& rhs) {
+        if(rhs.slabs_.empty()) {
+            return;
+        }
+        slabs_.insert(slabs_.begin(), rhs.slabs_.cbegin(), rhs.slabs_.cend());
+        if(ptr_ == 0) {
+            ptr_ = rhs.ptr_;
+            end_ = rhs.end_;
+        }
+
+        rhs.slabs_.clear();
+        rhs.ptr_ = 0;
+        rhs.end_ = 0;
+    }
+
+    size_t slabs_size() const { return slabs_.size(); }
+
+private:
+    static uintptr_t
+    align_up(uintptr_t p, size_t align) {
+        return (p + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    void*
+    allocate_slow(size_t size, size_t align) {
+        // large allocation gets its own slab and keeps current one untouched
+        if(size + align > slab_size_ / 4 && ptr_ != 0) {
+            auto data = (char*)malloc(size + align);
+            if(data == nullptr) {
+                throw std::bad_alloc();
+            }
+            slabs_.insert(slabs_.begin(), slab { data, size + align });
+            return (void*)align_up((uintptr_t)data, align);
+        }
+
+        auto sz   = std::max(slab_size_, size + align);
+        auto data = (char*)malloc(sz);
+        if(data == nullptr) {
+            throw std::bad_alloc();
+        }
+        slabs_.emplace_back(slab { data, sz });
+
+        ptr_ = (uintptr_t)data;
+        end_ = ptr_ + sz;
+
+        auto p = align_up(ptr_, align);
+        ptr_ = p + size;
+        return (void*)p;
+    }
+
+    void
+    release() {
+        for(auto& s : slabs_) {
+            free(s.data);
+        }
+        slabs_.clear();
+        ptr_ = 0;
+        end_ = 0;
+    }
+
+private:
+    size_t            slab_size_;
+    uintptr_t         ptr_;
+    uintptr_t         end_;
+    std::vector<slab> slabs_;
+};
+
+// keeps the released arenas for reusing, so no slabs are allocated in steady state
+class arena_pool : boost::noncopyable {
+public:
+    arena_pool(size_t max_size)
+        : max_size_(max_size) {}
+
+    ~arena_pool() {
+        for(auto a : free_) {
+            delete a;
+        }
+    }
+
+public:
+    arena*
+    acquire() {
+        if(free_.empty()) {
+            return new arena();
+        }
+        auto a = free_.back();
+        free_.pop_back();
+        return a;
+    }
+
+    void
+    release(arena* a) {
+        if(free_.size() >= max_size_) {
+            delete a;
+            return;
+        }
+        a->reset();
+        free_.emplace_back(a);
+    }
+
+private:
+    size_t              max_size_;
+    std::vector<arena*> free_;
+};
+
+}}  // namespace evt::chain
@@ -243,3 +243,5 @@ struct formatter<evt::chain::asset> {
 
 FC_REFLECT(evt::chain::symbol, (value_));
 FC_REFLECT(evt::chain::asset, (amount_)(sym_));
+FC_REFLECT_TRIVIALLY_PACKABLE(evt::chain::symbol);
+FC_REFLECT_TRIVIALLY_PACKABLE(evt::chain::asset);
@@ -4,11 +4,15 @@
  */
 #pragma once
 #include <functional>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <fc/scoped_exit.hpp>
 
 #include <boost/dynamic_bitset.hpp>
-#include <boost/range/algorithm/find.hpp>
 
 #include <evt/chain/controller.hpp>
 #include <evt/chain/config.hpp>
@@ -33,6 +37,14 @@ enum toke_type { kNFT = 0, kFT };
 template<uint64_t>
 struct check_authority {};
 
+// permissions of fungible without metas and other fields, cached next to the fungible
+struct fungible_header {
+    symbol         sym;
+    permission_def issue;
+    permission_def transfer;
+    permission_def manage;
+};
+
 #define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)       \
     try {                                                                    \
         using vtype = typename decltype(VPTR)::element_type;                 \
@@ -44,6 +56,15 @@ struct check_authority {};
 
 }  // namespace internal
 
+// token read by checker with its version at that time, results of checker stay valid until one of them is changed
+struct authority_dep {
+    token_type              type;
+    std::optional<name128>  domain;
+    name128                 key;
+    uint32_t                version;
+};
+using authority_deps = std::vector<authority_dep>;
+
 /**
  * @brief This class determines whether a set of signing keys are sufficient to satisfy an authority or not
  *
@@ -62,6 +83,18 @@ private:
     token_database_cache&           tokendb_cache_;
     boost::dynamic_bitset<uint64_t> used_keys_;
 
+    // results of checks within the lifetime of checker, signing keys and state are the same for all of them
+    struct memo_entry {
+        bool                            result;
+        boost::dynamic_bitset<uint64_t> used_keys;  // keys marked while checking
+    };
+    using permission_memo_key = std::tuple<int, int, uint128_t>;  // token type, permission, domain or sym id
+
+    std::unordered_map<group_name, memo_entry> group_memo_;
+    std::map<permission_memo_key, memo_entry>  permission_memo_;
+
+    authority_deps* deps_ = nullptr;
+
 public:
     struct weight_tally_visitor {
     public:
@@ -84,7 +117,8 @@ public:
 
         uint32_t
         operator()(const public_key_type& key, const weight_type weight) {
-            auto itr = boost::find(checker_->signing_keys_, key);
+            // signing keys are sorted, large groups would be quadratic with linear search
+            auto itr = checker_->signing_keys_.find(key);
             if(itr != checker_->signing_keys_.end()) {
                 checker_->used_keys_[itr - checker_->signing_keys_.begin()] = true;
                 total_weight_ += weight;
@@ -114,11 +148,20 @@ public:
         , used_keys_(signing_keys.size(), false) {}
 
 private:
+    void
+    record_dep(token_type type, const std::optional<name128>& domain, const name128& key) {
+        if(deps_ != nullptr) {
+            deps_->emplace_back(authority_dep { type, domain, key, control_.token_db().token_version(type, domain, key) });
+        }
+    }
+
     template<int Permission>
     void
     get_domain_permission(const domain_name& domain_name, std::function<void(const permission_def&)>&& cb) {
         using namespace internal;
 
+        record_dep(token_type::domain, std::nullopt, domain_name);
+
         auto domain = make_empty_cache_ptr<domain_def>();
         READ_DB_TOKEN(token_type::domain, std::nullopt, domain_name, domain, unknown_domain_exception, "Cannot find domain: {}", domain_name);
 
@@ -138,8 +181,17 @@ private:
     get_fungible_permission(const symbol_id_type sym_id, std::function<void(const permission_def&)>&& cb) {
         using namespace internal;
 
-        auto fungible = make_empty_cache_ptr<fungible_def>();
-        READ_DB_TOKEN(token_type::fungible, std::nullopt, sym_id, fungible, unknown_fungible_exception, "Cannot find fungible with symbol id: {}", sym_id);
+        record_dep(token_type::fungible, std::nullopt, sym_id);
+
+        auto fungible = make_empty_cache_ptr<fungible_header>();
+        try {
+            fungible = tokendb_cache_.template read_derived<fungible_def, fungible_header>(token_type::fungible, std::nullopt, sym_id, [](auto& fd) {
+                return fungible_header { fd.sym, fd.issue, fd.transfer, fd.manage };
+            });
+        }
+        catch(token_database_exception&) {
+            EVT_THROW2(unknown_fungible_exception, "Cannot find fungible with symbol id: {}", sym_id);
+        }
 
         if constexpr(Permission == kIssue) {
             cb(fungible->issue);
@@ -154,6 +206,8 @@ private:
 
     void
     get_group(const group_name& name, std::function<void(const group_def&)>&& cb) {
+        record_dep(token_type::group, std::nullopt, name);
+
         auto group = make_empty_cache_ptr<group_def>();
         READ_DB_TOKEN(token_type::group, std::nullopt, name, group, unknown_group_exception, "Cannot find group: {}", name);
 
@@ -162,6 +216,8 @@ private:
 
     void
     get_nft_owners(const domain_name& domain, const name128& name, std::function<void(const address_list&)>&& cb) {
+        record_dep(token_type::token, domain, name);
+
         auto token = make_empty_cache_ptr<token_def>();
         READ_DB_TOKEN(token_type::token, domain, name, token, unknown_token_exception, "Cannot find token: {} in {}", name, domain);
 
@@ -179,6 +235,8 @@ private:
 
     void
     get_suspend(const proposal_name& proposal, std::function<void(const suspend_def&)>&& cb) {
+        record_dep(token_type::suspend, std::nullopt, proposal);
+
         auto suspend = make_empty_cache_ptr<suspend_def>();
         READ_DB_TOKEN(token_type::suspend, std::nullopt, proposal, suspend, unknown_suspend_exception, "Cannot find suspend proposal: {}", proposal);
 
@@ -198,41 +256,83 @@ private:
     } 
 
 private:
+    template<typename Map, typename Key>
+    std::optional<bool>
+    memo_find(Map& memo, const Key& key) {
+        auto it = memo.find(key);
+        if(it == memo.end()) {
+            return std::nullopt;
+        }
+        used_keys_ |= it->second.used_keys;
+        return it->second.result;
+    }
+
+    template<typename Map, typename Key, typename Func>
+    bool
+    memoize(Map& memo, const Key& key, Func&& func) {
+        if(auto r = memo_find(memo, key)) {
+            return *r;
+        }
+
+        // check with empty used keys to find out the ones used by this check only
+        auto prev = boost::dynamic_bitset<uint64_t>(signing_keys_.size(), false);
+        used_keys_.swap(prev);
+        auto restore = fc::make_scoped_exit([&] { used_keys_ |= prev; });
+
+        auto result = func();
+        memo.emplace(key, memo_entry { result, used_keys_ });
+        return result;
+    }
+
+    // result of permission with owner refers to the token or address in action, cannot be reused
+    static bool
+    has_owner_ref(const permission_def& permission) {
+        for(auto& aw : permission.authorizers) {
+            if(aw.ref.type() == authorizer_ref::owner_t) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // children of one node are stored contiguously in group, so they are scanned in place
+    // and only non-leaf children are recursed into, visiting order is the same as `group::visit_node`
     bool
     satisfied_node(const group& group, const group::node& node, uint32_t depth) {
         FC_ASSERT(depth < max_recursion_depth_);
         FC_ASSERT(!node.is_leaf());
+        FC_ASSERT(node.index + node.size <= group.nodes_.size());
+
         auto vistor = weight_tally_visitor(this);
-        group.visit_node(node, [&](const auto& n) {
-            FC_ASSERT(!n.is_root());
-            if(n.is_leaf()) {
-                vistor(group.get_leaf_key(n), n.weight);
+        auto begin  = group.nodes_.data() + node.index;
+        auto end    = begin + node.size;
+        for(auto n = begin; n != end; n++) {
+            FC_ASSERT(!n->is_root());
+            if(n->is_leaf()) {
+                FC_ASSERT(n->index < group.keys_.size());
+                vistor(group.keys_[n->index], n->weight);
             }
-            else {
-                if(satisfied_node(group, n, depth + 1)) {
-                    vistor.add_weight(n.weight);
-                }
+            else if(satisfied_node(group, *n, depth + 1)) {
+                vistor.add_weight(n->weight);
             }
             if(vistor.total_weight() >= node.threshold) {
-                return false;  // no need to visit more nodes
+                return true;  // no need to visit more nodes
             }
-            return true;
-        });
-        if(vistor.total_weight() >= node.threshold) {
-            return true;
         }
         return false;
     }
 
     bool
     satisfied_group(const group_name& name) {
-        bool result = false;
-        get_group(name, [&](const auto& group) {
-            if(satisfied_node(group, group.root(), 0)) {
-                result = true;
-            }
+        return memoize(group_memo_, name, [&] {
+            bool result = false;
+            get_group(name, [&](const auto& group) {
+                if(satisfied_node(group, group.root(), 0)) {
+                    result = true;
+                }
+            });
+            return result;
         });
-        return result;
     }
 
     template<int Token>
@@ -315,9 +415,18 @@ private:
     satisfied_domain_permission(const action& action) {
         using namespace internal;
 
+        auto key = permission_memo_key((int)kNFT, Permission, (uint128_t)action.domain);
+        if(auto r = memo_find(permission_memo_, key)) {
+            return *r;
+        }
+
         bool result = false;
         get_domain_permission<Permission>(action.domain, [&](const auto& permission) {
-            result = satisfied_permission<kNFT>(permission, action);
+            if(has_owner_ref(permission)) {
+                result = satisfied_permission<kNFT>(permission, action);
+                return;
+            }
+            result = memoize(permission_memo_, key, [&] { return satisfied_permission<kNFT>(permission, action); });
         });
         return result;
     }
@@ -327,9 +436,18 @@ private:
     satisfied_fungible_permission(const symbol_id_type sym_id, const action& action) {
         using namespace internal;
 
+        auto key = permission_memo_key((int)kFT, Permission, (uint128_t)sym_id);
+        if(auto r = memo_find(permission_memo_, key)) {
+            return *r;
+        }
+
         bool result = false;
         get_fungible_permission<Permission>(sym_id, [&](const auto& permission) {
-            result = satisfied_permission<kFT>(permission, action);
+            if(has_owner_ref(permission)) {
+                result = satisfied_permission<kFT>(permission, action);
+                return;
+            }
+            result = memoize(permission_memo_, key, [&] { return satisfied_permission<kFT>(permission, action); });
         });
         return result;
     }
@@ -359,6 +477,10 @@ public:
     bool
     all_keys_used() const { return used_keys_.all(); }
 
+    // tokens read by the following checks are appended to `deps`, producer schedule is not recorded
+    void
+    record_deps(authority_deps& deps) { deps_ = &deps; }
+
     public_keys_set
     used_keys() const {
         auto range = utilities::filter_data_by_marker(signing_keys_, used_keys_, true);
@@ -523,6 +645,15 @@ struct check_authority<N(transferft)> {
     }
 };
 
+template<>
+struct check_authority<N(batchtransft)> {
+    template <typename Type>
+    static bool
+    invoke(const action& act, authority_checker* checker) {
+        return checker->satisfied_fungible_permission<kTransfer>(get_symbol_id(act.key), act);
+    }
+};
+
 template<>
 struct check_authority<N(recycleft)> {
     template <typename Type>
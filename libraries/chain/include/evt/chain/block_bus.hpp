@@ -0,0 +1,66 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/trace.hpp>
+
+namespace evt { namespace chain {
+
+// one block and the traces of all the transactions applied in it
+struct block_batch {
+    block_state_ptr                    block;
+    std::vector<transaction_trace_ptr> traces;
+    bool                               irreversible = false;
+};
+using block_batch_ptr = std::shared_ptr<const block_batch>;
+
+/**
+ *  Hands the batches of blocks to the subscribers on its own thread, so that the work of observers
+ *  is kept away from the thread applying blocks. Batches are delivered in the order they are published.
+ *  Publisher is blocked when `max_size` batches are waiting.
+ */
+class block_bus : boost::noncopyable {
+public:
+    using subscriber_type = std::function<void(const block_batch_ptr&)>;
+
+public:
+    block_bus(size_t max_size);
+    ~block_bus();
+
+public:
+    void subscribe(subscriber_type subscriber);
+    void publish(block_batch_ptr batch);
+
+    // waits until all the published batches are delivered
+    void flush();
+    void stop();
+
+    size_t size() const;
+
+private:
+    void run();
+
+private:
+    size_t max_size_;
+
+    mutable std::mutex           mutex_;
+    std::condition_variable      not_empty_;
+    std::condition_variable      not_full_;
+    std::deque<block_batch_ptr>  batches_;
+    std::vector<subscriber_type> subscribers_;
+    size_t                       delivering_;
+    bool                         done_;
+
+    std::thread thread_;
+};
+
+}}  // namespace evt::chain
@@ -21,8 +21,8 @@ struct block_header_state {
     uint32_t                         bft_irreversible_blocknum  = 0;
     uint32_t                         pending_schedule_lib_num   = 0;  /// last irr block num
     digest_type                      pending_schedule_hash;
-    producer_schedule_type           pending_schedule;
-    producer_schedule_type           active_schedule;
+    immutable_schedule               pending_schedule;  // shared with the previous state unless it's changed
+    immutable_schedule               active_schedule;
     incremental_merkle               blockroot_merkle;
     flat_map<account_name, uint32_t> producer_to_last_produced;
     flat_map<account_name, uint32_t> producer_to_last_implied_irb;
@@ -40,7 +40,7 @@ struct block_header_state {
 
     bool
     has_pending_producers() const {
-        return pending_schedule.producers.size();
+        return pending_schedule->producers.size();
     }
 
     uint32_t calc_dpos_last_irreversible() const;
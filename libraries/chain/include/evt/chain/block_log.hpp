@@ -3,6 +3,9 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <functional>
+#include <memory>
+#include <string_view>
 #include <fc/filesystem.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/genesis_state.hpp>
@@ -36,20 +39,57 @@ class block_log_impl;
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * When segments are enabled, once the main file holds two segments of blocks, the older one is moved
+    * into a compressed segment file, see block_log_segments, and the main file is written again as a
+    * partial log starting after it. Blocks in segments are still read by block number.
+    * Oldest segments are removed by the number of segments or their size, which leaves only a window
+    * of recent blocks on the nodes which don't serve the whole history.
     */
 
 class block_log {
 public:
-    block_log(const fc::path& data_dir);
+    // packed bytes of one block, `owner` keeps them alive, which is the memory map of block log
+    // or a packed copy for the blocks not in the main file
+    struct packed_block {
+        std::string_view            data;
+        std::shared_ptr<const void> owner;
+
+        explicit operator bool() const { return !data.empty(); }
+
+        static packed_block from_block(const signed_block& b);
+    };
+
+    struct config {
+        uint32_t segment_blocks    = 0;  // number of blocks in one segment, 0 keeps all the blocks in main file
+        uint32_t max_segments      = 0;  // oldest segments over this number are removed, 0 keeps all of them
+        uint64_t max_segments_size = 0;  // oldest segments are removed once segments take more bytes, 0 for no limit
+
+        // blocks are written by another thread, in batches of at most `batch_blocks` blocks
+        // and each block waits at most `batch_ms` for its batch
+        bool     async_append       = false;
+        uint32_t batch_blocks       = 64;
+        uint32_t batch_ms           = 100;
+        uint32_t max_pending_blocks = 1024;  // appending waits when this number of blocks are not written yet
+        bool     sync_data          = false;  // syncs files after each batch, or each block when not async
+    };
+
+public:
+    block_log(const fc::path& data_dir, const config& cfg = config());
     block_log(block_log&& other);
     ~block_log();
 
+    // returns npos when appending asynchronously, position is reported by `on_durable` then
     uint64_t append(const signed_block_ptr& b);
+    // waits for the pending blocks written as well
     void     flush();
     void     reset(const genesis_state& gs, const signed_block_ptr& genesis_block, uint32_t first_block_num = 1);
 
     std::pair<signed_block_ptr, uint64_t> read_block(uint64_t file_pos) const;
+    // reads from memory maps of both files, can be called from other threads than the appending one
     signed_block_ptr                      read_block_by_num(uint32_t block_num) const;
+    // same as above but the block is not unpacked, empty one is returned if block doesn't exist
+    packed_block                          read_packed_block_by_num(uint32_t block_num) const;
     signed_block_ptr
     read_block_by_id(const block_id_type& id) const {
         return read_block_by_num(block_header::num_from_id(id));
@@ -62,6 +102,13 @@ public:
     signed_block_ptr        read_head() const;
     const signed_block_ptr& head() const;
     uint32_t                first_block_num() const;
+    // first block which can be read, older ones are in removed segments or not in block log at all
+    uint32_t                earliest_block_num() const;
+
+    // last block written, and synced if `sync_data` is set
+    uint32_t durable_block_num() const;
+    // called by the writing thread with the number and position of last block written
+    void     set_on_durable(std::function<void(uint32_t, uint64_t)> func);
 
     static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
@@ -80,3 +127,5 @@ private:
 };
 
 }}  // namespace evt::chain
+
+FC_REFLECT(evt::chain::block_log::config, (segment_blocks)(max_segments)(max_segments_size)(async_append)(batch_blocks)(batch_ms)(max_pending_blocks)(sync_data));
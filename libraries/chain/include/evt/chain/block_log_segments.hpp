@@ -0,0 +1,59 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <string_view>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block.hpp>
+
+namespace evt { namespace chain {
+
+namespace detail {
+class block_log_segments_impl;
+}
+
+/* Oldest blocks of block log are moved into segment files, each one holds a fixed number of
+    * blocks. Blocks of one segment are compressed by zstd in chunks, which are decompressed
+    * independently, followed by an index of chunks and blocks. Chunks are compressed with the
+    * dictionary of `zstd_dictionary.hpp` since version 2 of segment.
+    *
+    * +--------+---------+---------+-----+--------------+-----------------+-----------+
+    * | Header | Chunk 1 | Chunk 2 | ... | Pos of Chunk | Offset of Block | Pos of    |
+    * |        |         |         |     | 1...N, End   | in Chunk 1...M  | the Index |
+    * +--------+---------+---------+-----+--------------+-----------------+-----------+
+    *
+    * Segments can be moved away or deleted, blocks in them are only needed for replaying from
+    * the beginning and serving the old blocks.
+    */
+class block_log_segments : boost::noncopyable {
+public:
+    block_log_segments(const fc::path& dir);
+    ~block_log_segments();
+
+public:
+    // blocks are the packed ones, in order and starting with `first_block_num`
+    void add_segment(uint32_t first_block_num, const std::vector<std::string_view>& blocks);
+    // removes the oldest segments until at most `max_segments` left
+    void prune(uint32_t max_segments);
+    // removes the oldest segments until they take at most `max_size` bytes
+    void prune_size(uint64_t max_size);
+    void clear();
+
+    // safe to call from many threads, returns nullptr if block is not in any segments
+    // reading the first block of one chunk starts decompressing the next chunk on another thread
+    signed_block_ptr read_block_by_num(uint32_t block_num) const;
+
+    // range of blocks in segments, both are 0 if there are no segments
+    uint32_t first_block_num() const;
+    uint32_t end_block_num() const;
+    // total bytes of segment files
+    uint64_t size() const;
+
+private:
+    std::unique_ptr<detail::block_log_segments_impl> my;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,62 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/trace.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Append-only file of blocks and the traces queued before them, used by the plugins consuming blocks
+ *  when their memory queues are full, so the chain is never blocked by them.
+ *
+ *  Records are packed as the size followed by the packed block state, irreversible flag and traces.
+ *  They're read in order and only dropped once released, the file is truncated when all of them are
+ *  released. Records left in the file are kept for the next time it's opened.
+ */
+class block_spill_queue : boost::noncopyable {
+public:
+    struct item {
+        block_state_ptr                    block;
+        bool                               irreversible = false;
+        std::vector<transaction_trace_ptr> traces;
+    };
+
+public:
+    block_spill_queue(const fc::path& file);
+
+public:
+    // traces are moved into the record
+    void push(const block_state_ptr& block, bool irreversible, std::deque<transaction_trace_ptr>& traces);
+
+    // reads at most `max_items` records not read yet, returns the number of records read
+    size_t read(size_t max_items, std::vector<item>& items);
+    // drops `n` records which are read
+    void   release(size_t n);
+
+    // number of records not released yet, including the ones read
+    size_t size() const;
+    bool   empty() const { return size() == 0; }
+
+private:
+    void reset();
+
+private:
+    fc::path file_;
+
+    mutable std::mutex mutex_;
+    std::fstream       fs_;
+    uint64_t           read_pos_ = 0;
+    size_t             size_     = 0;
+    size_t             read_     = 0;
+};
+
+}}  // namespace evt::chain
@@ -3,8 +3,10 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <future>
 #include <evt/chain/block.hpp>
 #include <evt/chain/block_header_state.hpp>
+#include <evt/chain/pool_allocator.hpp>
 #include <evt/chain/transaction_metadata.hpp>
 
 namespace evt { namespace chain {
@@ -23,10 +25,25 @@ struct block_state : public block_header_state {
     /// this data is redundant with the data stored in block, but facilitates
     /// recapturing transactions when we pop a block
     vector<transaction_metadata_ptr> trxs;
+
+    /// signee and transaction merkle of block received from network, checked on thread pool
+    /// and joined before the block is committed, it's empty for other blocks
+    std::shared_future<void> header_check;
 };
 
 using block_state_ptr = std::shared_ptr<block_state>;
 
+namespace internal {
+pool_allocator<block_state>& get_block_state_allocator();
+}  // namespace internal
+
+// block states are taken from pool, they're made and freed for each block received
+template<typename ... Args>
+block_state_ptr
+make_block_state(Args&& ... args) {
+    return std::allocate_shared<block_state>(internal::get_block_state_allocator(), std::forward<Args>(args)...);
+}
+
 }}  // namespace evt::chain
 
 FC_REFLECT_DERIVED(evt::chain::block_state, (evt::chain::block_header_state), (block)(validated)(in_current_chain));
@@ -0,0 +1,118 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+*/
+#pragma once
+#include <boost/noncopyable.hpp>
+#include <evt/chain/types.hpp>
+
+namespace evt { namespace chain {
+
+// passive bonuses collected within the pending block, keyed by symbol id
+// they are folded into the collection addresses once the block is finalized,
+// so transfers of one symbol don't all write the same hot address.
+// charges paid to producer are accrued the same way in another instance.
+// each transaction works on its own frame which is merged or dropped the same way as its database sessions
+class bonus_accruals : boost::noncopyable {
+private:
+    using frame = flat_map<symbol_id_type, int64_t>;
+
+public:
+    class session : boost::noncopyable {
+    public:
+        session(session&& s)
+            : accruals_(s.accruals_) {
+            s.accruals_ = nullptr;
+        }
+
+        ~session() { undo(); }
+
+    public:
+        // merges accruals into the outer frame
+        void
+        squash() {
+            if(accruals_) {
+                accruals_->squash();
+                accruals_ = nullptr;
+            }
+        }
+
+        void
+        undo() {
+            if(accruals_) {
+                accruals_->frames_.pop_back();
+                accruals_ = nullptr;
+            }
+        }
+
+    private:
+        session(bonus_accruals& accruals)
+            : accruals_(&accruals) {}
+
+    private:
+        bonus_accruals* accruals_;
+
+    private:
+        friend class bonus_accruals;
+    };
+
+public:
+    bonus_accruals() : frames_(1) {}
+
+public:
+    session
+    new_session() {
+        frames_.emplace_back();
+        return session(*this);
+    }
+
+    void
+    accrue(symbol_id_type sym_id, int64_t amount) {
+        frames_.back()[sym_id] += amount;
+    }
+
+    // total amount not folded yet for the symbol, including the ones from unfinished transactions
+    int64_t
+    pending(symbol_id_type sym_id) const {
+        auto total = (int64_t)0;
+        for(auto& f : frames_) {
+            auto it = f.find(sym_id);
+            if(it != f.cend()) {
+                total += it->second;
+            }
+        }
+        return total;
+    }
+
+    // iterates the accruals of the whole block in order of symbol ids
+    // all the transaction sessions should be finished before
+    template<typename Func>
+    void
+    fold(Func&& func) {
+        assert(frames_.size() == 1);
+        for(auto& it : frames_[0]) {
+            if(it.second != 0) {
+                func(it.first, it.second);
+            }
+        }
+        frames_[0].clear();
+    }
+
+private:
+    void
+    squash() {
+        assert(frames_.size() > 1);
+        auto top = std::move(frames_.back());
+        frames_.pop_back();
+
+        auto& f = frames_.back();
+        for(auto& it : top) {
+            f[it.first] += it.second;
+        }
+    }
+
+private:
+    small_vector<frame, 4> frames_;
+};
+
+}}  // namespace evt::chain
@@ -67,33 +67,38 @@ public:
 
 private:
     uint32_t
-    network(const packed_transaction& ptrx, size_t sig_num) const {
+    network(uint32_t unprunable_size, size_t sig_num) const {
         uint32_t s = 0;
 
-        s += ptrx.get_unprunable_size();
+        s += unprunable_size;
         s += sig_num * sizeof(signature_type);
 
         return s;
     }
 
     uint32_t
-    cpu(const packed_transaction&, size_t sig_num) const {
+    cpu(size_t sig_num) const {
         return sig_num * 60;
     }
 
 public:
     uint32_t
     calculate(const packed_transaction& ptrx, size_t sig_num = 0) const {
+        sig_num = std::max(sig_num, ptrx.get_signatures().size());
+        return calculate(ptrx.get_transaction(), ptrx.get_unprunable_size(), sig_num);
+    }
+
+    // `unprunable_size` is the same as `packed_transaction::get_unprunable_size`
+    // so the charge can be calculated without packing transaction
+    uint32_t
+    calculate(const transaction& trx, uint32_t unprunable_size, size_t sig_num) const {
         using namespace internal;
-        
-        auto& trx = ptrx.get_transaction();
-        EVT_ASSERT(!trx.actions.empty(), tx_no_action, "There's not any actions in this transaction");
 
-        sig_num = std::max(sig_num, ptrx.get_signatures().size());
+        EVT_ASSERT(!trx.actions.empty(), tx_no_action, "There's not any actions in this transaction");
 
         uint32_t ts = 0, s = 0;
-        ts += network(ptrx, sig_num) * config_.base_network_charge_factor;
-        ts += cpu(ptrx, sig_num) * config_.base_cpu_charge_factor;
+        ts += network(unprunable_size, sig_num) * config_.base_network_charge_factor;
+        ts += cpu(sig_num) * config_.base_cpu_charge_factor;
 
         auto pts = ts / trx.actions.size();
         for(auto& act : trx.actions) {
@@ -140,6 +145,18 @@ struct act_charge<N(issuetoken), T> : public base_act_charge {
     }
 };
 
+template<typename T>
+struct act_charge<N(batchtransft), T> : public base_act_charge {
+    static uint32_t
+    cpu(const action& act) {
+        auto& btact = act.data_as<add_clr_t<T>>();
+        if(btact.credits.empty()) {
+            return 15;
+        }
+        return 15 + (btact.credits.size() - 1) * 3;
+    }
+};
+
 template<typename T>
 struct act_charge<N(addmeta), T> : public base_act_charge {
     static uint32_t
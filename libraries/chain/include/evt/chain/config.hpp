@@ -15,10 +15,15 @@ typedef __uint128_t uint128_t;
 
 const static auto default_blocks_dir_name          = "blocks";
 const static auto reversible_blocks_dir_name       = "reversible";
+const static auto reversible_blocks_filename       = "reversible.log";
+const static auto reversible_blocks_index_size     = 64*1024;          /// slots of blocks in reversible log, 9 hours of blocks
 const static auto default_token_database_dir_name  = "tokendb";
 const static auto default_reversible_cache_size    = 340*1024*1024ll;  /// 1MB * 340 blocks based on 21 producer BFT delay
 const static auto default_reversible_guard_size    = 2*1024*1024ll;    /// 1MB * 2 blocks based on 21 producer BFT delay
 const static auto token_database_persisit_filename = "savepoints.log";
+const static auto token_database_derived_filename  = "derived.dat";
+const static auto token_database_warmkeys_filename = "warmkeys.dat";
+const static auto default_warmup_save_interval     = 1200;  /// blocks between two saves of warm keys, 10 minutes
 
 const static auto default_state_dir_name        = "state";
 const static auto forkdb_filename               = "forkdb.dat";
@@ -53,6 +58,11 @@ const static uint32_t default_base_cpu_charge_factor     = 10;
 const static uint32_t default_global_charge_factor       = 10;
 
 const static uint32_t default_abi_serializer_max_time_ms = 50; ///< default deadline for abi serialization methods
+const static uint16_t default_controller_thread_pool_size = 2;
+const static uint32_t default_parallel_recover_min_sigs = 4; ///< signatures of transactions with at least this many ones are recovered by several tasks
+const static uint32_t default_trace_pool_size = 1024; ///< max freed transaction traces kept for reusing
+const static uint32_t default_block_state_pool_size = 1024; ///< max freed block states kept for reusing
+const static uint64_t default_fork_db_max_size = 256 * 1024 * 1024; ///< fork database starts pruning the dead branches over this size
 
 /**
  *  The number of sequential blocks produced by a single producer
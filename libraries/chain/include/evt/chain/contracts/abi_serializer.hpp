@@ -4,10 +4,15 @@
  */
 #pragma once
 #include <chrono>
+#include <deque>
+#include <unordered_map>
 
 #include <boost/noncopyable.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/scoped_exit.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 #include <evt/chain/config.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -63,6 +68,20 @@ struct abi_serializer : boost::noncopyable {
     bytes variant_to_binary(const type_name& type, const fc::variant& var, const execution_context&,  bool short_path = false) const;
     void  variant_to_binary(const type_name& type, const fc::variant& var, fc::datastream<char*>& ds, const execution_context&, bool short_path = false) const;
 
+    using json_writer = ::rapidjson::Writer<::rapidjson::StringBuffer>;
+
+    // writes json directly from the binary, same output as converting the result of `binary_to_variant`
+    // but without building the variants of the whole tree
+    void   binary_to_json(const type_name& type, fc::datastream<const char*>& binary, json_writer& writer, const execution_context&, bool short_path = false) const;
+    string binary_to_json(const type_name& type, const bytes& binary, const execution_context&, bool short_path = false) const;
+
+    using json_value = ::rapidjson::Value;
+
+    // packs json parsed by rapidjson directly, same result as `variant_to_binary` of the parsed variant
+    // except that `action` accepts its data as object the same way `from_variant` does
+    void  json_to_binary(const type_name& type, const json_value& value, fc::datastream<char*>& ds, const execution_context&, bool short_path = false) const;
+    bytes json_to_binary(const type_name& type, const string& json, const execution_context&, bool short_path = false) const;
+
     template <typename T>
     void to_variant(const T& o, fc::variant& vo, const execution_context&) const;
 
@@ -89,21 +108,74 @@ struct abi_serializer : boost::noncopyable {
     typedef std::function<fc::variant(fc::datastream<const char*>&, bool, bool)>        unpack_function;
     typedef std::function<void(const fc::variant&, fc::datastream<char*>&, bool, bool)> pack_function;
 
+    typedef void (*json_function)(fc::datastream<const char*>&, json_writer&);
+    typedef bool (*json_pack_function)(const json_value&, fc::datastream<char*>&);
+
     void add_specialized_unpack_pack(const string& name, std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack);
 
     static const size_t max_recursion_depth = 32;  // arbitrary depth to prevent infinite recursion
 
+private:
+    // type resolved once when abi is set, so that packing and unpacking
+    // don't need to look up typedefs and parse the type names again
+    struct type_plan {
+        enum kind_type { kUnknown = 0, kBuiltin, kArray, kOptional, kVariant, kEnum, kStruct };
+
+        struct field_plan {
+            const type_plan* plan;
+            bool             optional;
+            fc::interned_key name;  // of struct fields
+        };
+
+        kind_type kind = kUnknown;
+        type_name name;
+
+        const pair<unpack_function, pack_function>* builtin   = nullptr;
+        json_function                               json      = nullptr;  // only for plain built-in types
+        json_pack_function                          json_pack = nullptr;  // only for plain built-in types
+        bool builtin_array    = false;
+        bool builtin_optional = false;
+
+        const type_plan* element = nullptr;  // element of array and optional, or integer of enum
+        const type_plan* base    = nullptr;  // base of struct
+        vector<field_plan> fields;           // fields of struct and variant
+        bool               action = false;   // data of action is packed from its own type
+
+        map<type_name, struct_def>::const_iterator  struct_itr;
+        map<type_name, variant_def>::const_iterator variant_itr;
+        map<type_name, enum_def>::const_iterator    enum_itr;
+    };
+
+    // typedefs share the plan of the type they resolve to
+    struct type_plans {
+        std::unordered_map<type_name, const type_plan*> index;
+        std::deque<type_plan>                           storage;
+    };
+
 private:  
     void configure_built_in_types();
 
+    void             compile_plans();
+    const type_plan* compile_plan(const type_name& type, type_plans& plans) const;
+    const type_plan& find_plan(const type_name& type, std::optional<type_plans>& plans) const;
+
     fc::variant _binary_to_variant(const type_name& type, const bytes& binary, impl::binary_to_variant_context& ctx) const;
     fc::variant _binary_to_variant(const type_name& type, fc::datastream<const char*>& binary, impl::binary_to_variant_context& ctx) const;
-    void        _binary_to_variant(const type_name& type, fc::datastream<const char*>& stream,
+    fc::variant _binary_to_variant(const type_plan& plan, fc::datastream<const char*>& binary, impl::binary_to_variant_context& ctx) const;
+    void        _binary_to_variant(const type_plan& plan, fc::datastream<const char*>& stream,
                                    fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx) const;
 
     bytes _variant_to_binary(const type_name& type, const fc::variant& var, impl::variant_to_binary_context& ctx) const;
     void  _variant_to_binary(const type_name& type, const fc::variant& var,
                              fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const;
+    void  _variant_to_binary(const type_plan& plan, const fc::variant& var,
+                             fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const;
+
+    bool _binary_to_json(const type_plan& plan, fc::datastream<const char*>& stream, json_writer& writer, impl::binary_to_variant_context& ctx) const;
+    void _binary_to_json_fields(const type_plan& plan, fc::datastream<const char*>& stream, json_writer& writer, impl::binary_to_variant_context& ctx) const;
+
+    void _json_to_binary(const type_plan& plan, const json_value& value, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const;
+    void _json_to_action(const type_plan& plan, const json_value& value, fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx) const;
 
     bool _is_type(const type_name& type) const;
 
@@ -116,6 +188,10 @@ private:
     std::map<type_name, enum_def>    enums_;
 
     std::map<type_name, pair<unpack_function, pack_function>> built_in_types_;
+    std::map<type_name, json_function>                        built_in_json_;
+    std::map<type_name, json_pack_function>                   built_in_json_pack_;
+
+    type_plans plans_;
 
     std::chrono::microseconds max_serialization_time_;
 
@@ -0,0 +1,23 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <string>
+#include <evt/chain/types.hpp>
+
+namespace evt { namespace chain { namespace contracts {
+
+/**
+ *  Base42 codec used by EVT-Link, the numbers are big-endian bytes where each leading zero byte is
+ *  written as one leading '0' character.
+ *  It works on 32-bit limbs and converts five digits at a time, since 42^5 still fits in one limb.
+ */
+
+// decodes [begin, end) into big-endian bytes, throws when it's longer than `max_bytes`
+bytes base42_decode(const char* begin, const char* end, size_t max_bytes);
+
+// encodes the big-endian bytes in [begin, end) and appends the result into `str`
+void base42_encode(const char* begin, const char* end, std::string& str);
+
+}}}  // namespace evt::chain::contracts
@@ -20,6 +20,8 @@
 #include <fc/crypto/city.hpp>
 
 #include <evt/chain/apply_context.hpp>
+#include <evt/chain/bonus_accruals.hpp>
+#include <evt/chain/deadline_object.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/transaction_context.hpp>
@@ -208,6 +210,12 @@ get_db_prefix<token_def>(const token_def& v) {
         tokendb_cache.put_token(TYPE, action_op::update, get_db_prefix(VALUE), get_db_key(VALUE), VALUE); \
     }
 
+// only writes the meta just appended, `VALUE` keeps its metas as the last field
+#define APPEND_DB_META(TYPE, VALUE)                                                            \
+    {                                                                                          \
+        tokendb_cache.append_token_meta(TYPE, get_db_prefix(VALUE), get_db_key(VALUE), VALUE); \
+    }
+
 #define PUT_DB_TOKEN(TYPE, VALUE)                                                                      \
     {                                                                                                  \
         tokendb_cache.put_token(TYPE, action_op::put, get_db_prefix(VALUE), get_db_key(VALUE), VALUE); \
@@ -247,7 +255,7 @@ get_db_prefix<token_def>(const token_def& v) {
 
 #define READ_DB_ASSET(ADDR, SYM, VALUEREF)                                                              \
     try {                                                                                               \
-        auto str = std::string();                                                                       \
+        auto str = rocksdb::PinnableSlice();                                                            \
         tokendb.read_asset(ADDR, SYM.id(), str);                                                        \
                                                                                                         \
         extract_db_value(str, VALUEREF);                                                                \
@@ -255,11 +263,12 @@ get_db_prefix<token_def>(const token_def& v) {
     catch(token_database_exception&) {                                                                  \
         EVT_THROW2(balance_exception, "There's no balance left in {} with sym id: {}", ADDR, SYM.id()); \
     }                                                                                                   \
-    CHECK_SYM(VALUEREF, SYM);
+    CHECK_SYM(VALUEREF, SYM);                                                                           \
+    fold_charges(context, ADDR, VALUEREF);
 
 #define READ_DB_ASSET_NO_THROW(ADDR, SYM, VALUEREF)                         \
     {                                                                       \
-        auto str = std::string();                                           \
+        auto str = rocksdb::PinnableSlice();                                \
         if(!tokendb.read_asset(ADDR, SYM.id(), str, true /* no throw */)) { \
             VALUEREF = MAKE_PROPERTY(0, SYM);                               \
             context.add_new_ft_holder(                                      \
@@ -268,18 +277,20 @@ get_db_prefix<token_def>(const token_def& v) {
         else {                                                              \
             extract_db_value(str, VALUEREF);                                \
             CHECK_SYM(VALUEREF, SYM);                                       \
+            fold_charges(context, ADDR, VALUEREF);                          \
         }                                                                   \
     }
 
 #define READ_DB_ASSET_NO_THROW_NO_NEW(ADDR, SYM, VALUEREF)                  \
     {                                                                       \
-        auto str = std::string();                                           \
+        auto str = rocksdb::PinnableSlice();                                \
         if(!tokendb.read_asset(ADDR, SYM.id(), str, true /* no throw */)) { \
             VALUEREF = MAKE_PROPERTY(0, SYM);                               \
         }                                                                   \
         else {                                                              \
             extract_db_value(str, VALUEREF);                                \
             CHECK_SYM(VALUEREF, SYM);                                       \
+            fold_charges(context, ADDR, VALUEREF);                          \
         }                                                                   \
     }
 
@@ -287,6 +298,62 @@ get_db_prefix<token_def>(const token_def& v) {
     auto& tokendb = context.token_db;            \
     auto& tokendb_cache = context.token_db_cache;
 
+// charges are accrued within the pending block and credited to the collector when the block is finalized,
+// they're folded here once the balance of collector is read within actions so that it's always up to date
+void
+fold_charges(apply_context& context, const address& addr, property& prop) {
+    if(prop.sym.id() != EVT_SYM_ID || addr != context.control.pending_charge_collector()) {
+        return;
+    }
+
+    auto& accruals = context.control.pending_charge_accruals();
+    auto  amount   = accruals.pending(EVT_SYM_ID);
+    if(amount == 0) {
+        return;
+    }
+
+    prop.amount += amount;
+    accruals.accrue(EVT_SYM_ID, -amount);
+
+    auto dv = make_db_value(prop);
+    context.token_db.put_asset(addr, EVT_SYM_ID, dv.as_string_view());
+}
+
+// folds the pending charges without the balance of collector at hand, used before reading
+// the balances of all the holders of EVT
+void
+fold_all_charges(apply_context& context) {
+    auto& collector = context.control.pending_charge_collector();
+
+    auto str = std::string();
+    if(!context.token_db.read_asset(collector, EVT_SYM_ID, str, true /* no throw */)) {
+        // it's created by the first charge, so there are no pending ones
+        return;
+    }
+    auto prop = property();
+    extract_db_value(str, prop);
+    fold_charges(context, collector, prop);
+}
+
+// only the first charge of block creates the collector address here
+void
+accrue_charge(apply_context& context, int64_t charge) {
+    auto& accruals  = context.control.pending_charge_accruals();
+    auto& collector = context.control.pending_charge_collector();
+
+    if(accruals.pending(EVT_SYM_ID) == 0) {
+        auto str = std::string();
+        if(!context.token_db.read_asset(collector, EVT_SYM_ID, str, true /* no throw */)) {
+            auto prop = MAKE_PROPERTY(0, evt_sym());
+            auto dv   = make_db_value(prop);
+            context.add_new_ft_holder(ft_holder { .addr = collector, .sym_id = EVT_SYM_ID });
+            context.token_db.put_asset(collector, EVT_SYM_ID, dv.as_string_view());
+        }
+    }
+    // charges are taken from payers, so they never overflow as a whole
+    accruals.accrue(EVT_SYM_ID, charge);
+}
+
 } // namespace internal
 
 EVT_ACTION_IMPL_BEGIN(newdomain) {
@@ -353,11 +420,18 @@ EVT_ACTION_IMPL_BEGIN(issuetoken) {
         EVT_ASSERT2(tokendb.exists_token(token_type::domain, std::nullopt, itact.domain), unknown_domain_exception,
             "Cannot find domain: {}.", itact.domain);
 
-        auto check_name = [&](const auto& name) {
-            check_name_reserved(name);
-            EVT_ASSERT2(!tokendb.exists_token(token_type::token, itact.domain, name), token_duplicate_exception,
-                "Token: {} in {} is already exists.", name, itact.domain);
-        };
+        for(auto& n : itact.names) {
+            check_name_reserved(n);
+        }
+
+        // check duplicates within one batched lookup
+        auto olds = small_vector<std::string, 4>();
+        if(tokendb.read_tokens(token_type::token, itact.domain, itact.names, olds, true /* no throw */) > 0) {
+            for(auto i = 0u; i < olds.size(); i++) {
+                EVT_ASSERT2(olds[i].empty(), token_duplicate_exception,
+                    "Token: {} in {} is already exists.", itact.names[i], itact.domain);
+            }
+        }
 
         auto values  = small_vector<db_value, 4>();
         auto data    = small_vector<std::string_view, 4>();
@@ -369,8 +443,6 @@ EVT_ACTION_IMPL_BEGIN(issuetoken) {
         token.owner  = itact.owner;
 
         for(auto& n : itact.names) {
-            check_name(n);
-
             token.name = n;
             values.emplace_back(make_db_value(token));
             data.emplace_back(values.back().as_string_view());
@@ -435,7 +507,7 @@ EVT_ACTION_IMPL_END()
 EVT_ACTION_IMPL_BEGIN(destroytoken) {
     using namespace internal;
 
-    auto dtact = context.act.data_as<ACT>();
+    auto& dtact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(dtact.domain, dtact.name), action_authorize_exception,
             "Invalid authorization fields in action(domain and key).");
@@ -469,7 +541,7 @@ EVT_ACTION_IMPL_END()
 EVT_ACTION_IMPL_BEGIN(newgroup) {
     using namespace internal;
 
-    auto ngact = context.act.data_as<ACT>();
+    auto& ngact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(N128(.group), ngact.name), action_authorize_exception,
             "Invalid authorization fields in action(domain and key).");
@@ -493,7 +565,7 @@ EVT_ACTION_IMPL_END()
 EVT_ACTION_IMPL_BEGIN(updategroup) {
     using namespace internal;
 
-    auto ugact = context.act.data_as<ACT>();
+    auto& ugact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(N128(.group), ugact.name), action_authorize_exception,
             "Invalid authorization fields in action(domain and key).");
@@ -517,7 +589,7 @@ EVT_ACTION_IMPL_END()
 EVT_ACTION_IMPL_BEGIN(updatedomain) {
     using namespace internal;
 
-    auto udact = context.act.data_as<ACT>();
+    auto& udact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(udact.name, N128(.update)), action_authorize_exception,
             "Authorized information does not match");
@@ -627,6 +699,68 @@ calculate_passive_bonus(token_database_cache& tokendb_cache,
     return std::make_pair(amount, 0l);
 }
 
+// bonuses are accrued within the pending block and folded into the collection address when the block is finalized
+// only the first bonus of the symbol creates the collection address here
+void
+accrue_passive_bonus(apply_context& context, const symbol sym, int64_t amount) {
+    using namespace boost::safe_numerics;
+    DECLARE_TOKEN_DB()
+
+    auto& accruals = context.control.pending_bonus_accruals();
+
+    auto addr   = get_psvbonus_address(sym.id(), 0);
+    auto str    = std::string();
+    auto pbonus = property();
+
+    if(!tokendb.read_asset(addr, sym.id(), str, true /* no throw */)) {
+        pbonus = MAKE_PROPERTY(0, sym);
+        context.add_new_ft_holder(ft_holder { .addr = addr, .sym_id = sym.id() });
+        PUT_DB_ASSET(addr, pbonus);
+    }
+    else {
+        extract_db_value(str, pbonus);
+        CHECK_SYM(pbonus, sym);
+    }
+
+    // former accruals are checked already, so only the new one can overflow
+    auto r = checked::add<int64_t>(pbonus.amount + accruals.pending(sym.id()), amount);
+    EVT_ASSERT2(!r.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
+
+    accruals.accrue(sym.id(), amount);
+}
+
+// folds the accrued bonuses of the symbol before reading the collection address
+void
+fold_passive_bonus(apply_context& context, const symbol sym, property& pbonus) {
+    DECLARE_TOKEN_DB()
+
+    auto& accruals = context.control.pending_bonus_accruals();
+    auto  amount   = accruals.pending(sym.id());
+    if(amount == 0) {
+        return;
+    }
+
+    pbonus.amount += amount;
+    accruals.accrue(sym.id(), -amount);
+    PUT_DB_ASSET(get_psvbonus_address(sym.id(), 0), pbonus);
+}
+
+// folds the accrued bonuses of the symbol without the collection address at hand, used before reading
+// the balances of all the holders of the symbol
+void
+fold_all_passive_bonus(apply_context& context, const symbol sym) {
+    DECLARE_TOKEN_DB()
+
+    if(context.control.pending_bonus_accruals().pending(sym.id()) == 0) {
+        return;
+    }
+
+    // collection address is created by the first accrual, so it always exists here
+    auto pbonus = property();
+    READ_DB_ASSET(get_psvbonus_address(sym.id(), 0), sym, pbonus);
+    fold_passive_bonus(context, sym, pbonus);
+}
+
 void
 transfer_fungible(apply_context& context,
                   const address& from,
@@ -640,15 +774,29 @@ transfer_fungible(apply_context& context,
     property pfrom, pto;
 
     auto sym = total.sym();
-    if(sym == pevt_sym()) {
-        // special process the situciation where sym is pevt_sym()
-        // evt2pevt action
-        READ_DB_ASSET(from, evt_sym(), pfrom);
-        READ_DB_ASSET_NO_THROW(to, pevt_sym(), pto);
+    // special process the situciation where sym is pevt_sym()
+    // evt2pevt action
+    auto fsym = (sym == pevt_sym()) ? evt_sym() : sym;
+
+    // read both sides within one batched lookup
+    auto keys = small_vector<asset_key_t, 2>();
+    auto strs = small_vector<std::string, 2>();
+    keys.emplace_back(from, fsym.id());
+    keys.emplace_back(to, sym.id());
+    tokendb.read_assets(keys, strs, true /* no throw */);
+
+    EVT_ASSERT2(!strs[0].empty(), balance_exception, "There's no balance left in {} with sym id: {}", from, fsym.id());
+    extract_db_value(strs[0], pfrom);
+    CHECK_SYM(pfrom, fsym);
+    fold_charges(context, from, pfrom);
+
+    if(strs[1].empty()) {
+        pto = MAKE_PROPERTY(0, sym);
+        context.add_new_ft_holder(ft_holder { .addr = to, .sym_id = sym.id() });
     }
     else {
-        READ_DB_ASSET(from, sym, pfrom);
-        READ_DB_ASSET_NO_THROW(to, sym, pto);
+        extract_db_value(strs[1], pto);
+        CHECK_SYM(pto, sym);
     }
 
     // fast path check
@@ -679,20 +827,88 @@ transfer_fungible(apply_context& context,
 
     // update bonus if needed
     if(bonus_amount > 0) {
-        auto addr = get_psvbonus_address(sym.id(), 0);
+        accrue_passive_bonus(context, sym, bonus_amount);
 
-        property pbonus;
-        READ_DB_ASSET_NO_THROW(addr, sym, pbonus);
+        auto pbact = paybonus {
+            .payer  = from,
+            .amount = asset(bonus_amount, sym)
+        };
+        context.add_generated_action(action(N128(.fungible), name128::from_number(sym.id()), pbact))
+            .set_index(context.exec_ctx.index_of<paybonus>());
+    }
+}
+
+// debits `from` once and credits all the receivers, balances are read within one batched lookup
+void
+transfer_fungible_batch(apply_context&                      context,
+                        const address&                      from,
+                        const small_vector_base<ft_credit>& credits,
+                        const symbol                        sym,
+                        action_name                         act) {
+    using namespace boost::safe_numerics;
+    DECLARE_TOKEN_DB()
+
+    auto keys = small_vector<asset_key_t, 8>();
+    auto strs = small_vector<std::string, 8>();
+    keys.emplace_back(from, sym.id());
+    for(auto& c : credits) {
+        keys.emplace_back(c.to, sym.id());
+    }
+    tokendb.read_assets(keys, strs, true /* no throw */);
 
-        auto r = checked::add<int64_t>(pbonus.amount, bonus_amount);
-        EVT_ASSERT2(!r.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
+    property pfrom;
+    EVT_ASSERT2(!strs[0].empty(), balance_exception, "There's no balance left in {} with sym id: {}", from, sym.id());
+    extract_db_value(strs[0], pfrom);
+    CHECK_SYM(pfrom, sym);
+    fold_charges(context, from, pfrom);
 
-        pbonus.amount += bonus_amount;
-        PUT_DB_ASSET(addr, pbonus);
+    auto pbs = small_vector<property, 8>();
+    for(auto i = 0u; i < credits.size(); i++) {
+        auto& pto = pbs.emplace_back();
+        if(strs[i + 1].empty()) {
+            pto = MAKE_PROPERTY(0, sym);
+            context.add_new_ft_holder(ft_holder { .addr = credits[i].to, .sym_id = sym.id() });
+        }
+        else {
+            extract_db_value(strs[i + 1], pto);
+            CHECK_SYM(pto, sym);
+        }
+    }
+
+    // evt cannot have passive bonus, bonus is calculated for each credit as standalone transfer
+    int64_t total_amount = 0, total_bonus = 0;
+    for(auto i = 0u; i < credits.size(); i++) {
+        int64_t actual_amount = credits[i].number.amount(), bonus_amount = 0;
+        if(sym.id() > PEVT_SYM_ID) {
+            std::tie(actual_amount, bonus_amount) = calculate_passive_bonus(tokendb_cache, sym.id(), actual_amount, act);
+        }
+
+        auto r1 = checked::add<int64_t>(total_amount, actual_amount);
+        auto r2 = checked::add<int64_t>(total_bonus, bonus_amount);
+        auto r3 = checked::add<int64_t>(pbs[i].amount, actual_amount - bonus_amount);
+        EVT_ASSERT(!r1.exception() && !r2.exception() && !r3.exception(), math_overflow_exception, "Opeartions resulted in overflows.");
 
+        total_amount  += actual_amount;
+        total_bonus   += bonus_amount;
+        pbs[i].amount += actual_amount - bonus_amount;
+    }
+
+    EVT_ASSERT2(pfrom.amount >= total_amount, balance_exception,
+        "There's not enough balance({}) within address: {}.", asset(total_amount, sym), from);
+    pfrom.amount -= total_amount;
+
+    for(auto i = 0u; i < credits.size(); i++) {
+        PUT_DB_ASSET(credits[i].to, pbs[i]);
+    }
+    PUT_DB_ASSET(from, pfrom);
+
+    if(total_bonus > 0) {
+        accrue_passive_bonus(context, sym, total_bonus);
+
+        // one aggregated bonus action for the whole batch
         auto pbact = paybonus {
             .payer  = from,
-            .amount = asset(bonus_amount, sym)
+            .amount = asset(total_bonus, sym)
         };
         context.add_generated_action(action(N128(.fungible), name128::from_number(sym.id()), pbact))
             .set_index(context.exec_ctx.index_of<paybonus>());
@@ -783,7 +999,7 @@ EVT_ACTION_IMPL_END()
 EVT_ACTION_IMPL_BEGIN(updfungible) {
     using namespace internal;
 
-    auto ufact = context.act.data_as<ACT>();
+    auto& ufact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(N128(.fungible), name128::from_number(ufact.sym_id)), action_authorize_exception,
             "Invalid authorization fields in action(domain and key).");
@@ -885,6 +1101,45 @@ EVT_ACTION_IMPL_BEGIN(transferft) {
 }
 EVT_ACTION_IMPL_END()
 
+EVT_ACTION_IMPL_BEGIN(batchtransft) {
+    using namespace internal;
+
+    auto& btact = context.act.data_as<add_clr_t<ACT>>();
+
+    try {
+        EVT_ASSERT(!btact.credits.empty(), batch_empty_exception, "Credits cannot be empty");
+
+        auto sym = btact.credits[0].number.sym();
+        EVT_ASSERT(context.has_authorized(N128(.fungible), name128::from_number(sym.id())), action_authorize_exception,
+            "Invalid authorization fields in action(domain and key).");
+        EVT_ASSERT(sym != pevt_sym(), asset_symbol_exception, "Pinned EVT cannot be transfered");
+
+        using addr_bytes = std::array<char, sizeof(fc::ecc::public_key_shim)>;
+
+        auto tos = small_vector<addr_bytes, 8>();
+        tos.reserve(btact.credits.size());
+        for(auto& c : btact.credits) {
+            EVT_ASSERT(c.number.sym() == sym, asset_symbol_exception, "Symbols of credits are not the same");
+            EVT_ASSERT2(c.number.amount() > 0, asset_type_exception, "Amount of credit to {} should be positive", c.to);
+            EVT_ASSERT(btact.from != c.to, fungible_address_exception, "From and to are the same address");
+            check_address_reserved(c.to);
+
+            tos.emplace_back();
+            c.to.to_bytes(tos.back().data(), tos.back().size());
+        }
+
+        // receivers cannot be duplicated within one batch, bytes of addresses are compared after sorting
+        std::sort(tos.begin(), tos.end());
+        if(auto it = std::adjacent_find(tos.begin(), tos.end()); it != tos.end()) {
+            EVT_THROW2(fungible_address_exception, "Duplicate receiver: {} in credits", address::from_bytes(it->data(), it->size()));
+        }
+
+        transfer_fungible_batch(context, btact.from, btact.credits, sym, N(transferft));
+    }
+    EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
+}
+EVT_ACTION_IMPL_END()
+
 EVT_ACTION_IMPL_BEGIN(recycleft) {
     using namespace internal;
 
@@ -1110,7 +1365,7 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
                     "Creator is not involved in fungible: ${name}.", ("name",act.key));
             }
             fungible->metas.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::fungible, *fungible);
+            APPEND_DB_META(token_type::fungible, *fungible);
         }
         else if(act.key == N128(.meta)) {  // domain
             if(amact.key.reserved()) {
@@ -1128,7 +1383,7 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
                 "Creator is not involved in domain: ${name}.", ("name",act.key));
 
             domain->metas.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::domain, *domain);
+            APPEND_DB_META(token_type::domain, *domain);
         }
         else {  // token
             check_meta_key_reserved(amact.key);
@@ -1157,7 +1412,7 @@ EVT_ACTION_IMPL_BEGIN(addmeta) {
                 EVT_ASSERT(involved, meta_involve_exception, "Creator is not involved in token ${domain}-${name}.", ("domain",act.domain)("name",act.key));
             }
             token->metas.emplace_back(meta(amact.key, amact.value, amact.creator));
-            UPD_DB_TOKEN(token_type::token, *token);
+            APPEND_DB_META(token_type::token, *token);
         }
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
@@ -1196,6 +1451,7 @@ EVT_ACTION_IMPL_BEGIN(newsuspend) {
         suspend.trx      = std::move(nsact.trx);
 
         ADD_DB_TOKEN(token_type::suspend, suspend);
+        add_deadline(context.db, deadline_kind::suspend_expiration, suspend.name, suspend.trx.expiration);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1218,7 +1474,8 @@ EVT_ACTION_IMPL_BEGIN(aprvsuspend) {
         EVT_ASSERT(suspend->status == suspend_status::proposed, suspend_status_exception,
             "Suspend transaction is not in 'proposed' status.");
 
-        auto signed_keys = suspend->trx.get_signature_keys(aeact.signatures, context.control.get_chain_id());
+        // only the signatures of this approval are recovered, with the cached digest
+        auto signed_keys = transaction::recover_signature_keys(aeact.signatures, suspend->sig_digest(context.control.get_chain_id()));
         auto required_keys = context.control.get_suspend_required_keys(suspend->trx, signed_keys);
         EVT_ASSERT(signed_keys == required_keys, suspend_not_required_keys_exception,
             "Provided keys are not required in this suspend transaction");
@@ -1256,6 +1513,7 @@ EVT_ACTION_IMPL_BEGIN(cancelsuspend) {
         suspend->status = suspend_status::cancelled;
 
         UPD_DB_TOKEN(token_type::suspend, *suspend);
+        remove_deadline(context.db, deadline_kind::suspend_expiration, suspend->name);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1307,6 +1565,7 @@ EVT_ACTION_IMPL_BEGIN(execsuspend) {
             suspend->status = suspend_status::executed;
         }
         UPD_DB_TOKEN(token_type::suspend, *suspend);
+        remove_deadline(context.db, deadline_kind::suspend_expiration, suspend->name);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1338,14 +1597,9 @@ EVT_ACTION_IMPL_BEGIN(paycharge) {
             PUT_DB_ASSET(pcact.payer, evt);
         }
 
-        auto  pbs  = context.control.pending_block_state();
-        auto& prod = pbs->get_scheduled_producer(pbs->header.timestamp).block_signing_key;
-
-        property bp;
-        READ_DB_ASSET_NO_THROW(address(prod), evt_sym(), bp);
-        // give charge to producer
-        bp.amount += pcact.charge;
-        PUT_DB_ASSET(prod, bp);
+        // give charge to producer, it's credited once the block is finalized
+        // so that transactions don't all write the same balance of producer
+        accrue_charge(context, pcact.charge);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1388,7 +1642,7 @@ EVT_ACTION_IMPL_BEGIN(everipass) {
             }
         }
 
-        auto keys  = link.restore_keys();
+        auto& keys  = link.restore_keys();
         auto token = make_empty_cache_ptr<token_def>();
         READ_DB_TOKEN(token_type::token, d, t, token, unknown_token_exception, "Cannot find token: {} in {}", t, d);
 
@@ -1493,7 +1747,7 @@ EVT_ACTION_IMPL_BEGIN(everipay) {
         ADD_DB_TOKEN(token_type::evtlink, link_obj);
 
         // check signature
-        auto keys = link.restore_keys();
+        auto& keys = link.restore_keys();
         EVT_ASSERT(keys.size() == 1, everipay_exception, "There're more than one signature on everiPay link, which is invalid");
         
         // check payee
@@ -1770,15 +2024,7 @@ EVT_ACTION_IMPL_BEGIN(newlock) {
             switch(la.type()) {
             case asset_type::tokens: {
                 auto& tokens = la.template get<locknft_def>();
-
-                for(auto& tn : tokens.names) {
-                    auto token = make_empty_cache_ptr<token_def>();
-                    READ_DB_TOKEN(token_type::token, tokens.domain, tn, token, unknown_token_exception,
-                        "Cannot find token: {} in {}", tn, tokens.domain);
-                    token->owner = { laddr };
-
-                    UPD_DB_TOKEN(token_type::token, *token);
-                }
+                tokendb_cache.put_token_owners<token_def>(tokens.domain, tokens.names, address_list{ laddr });
                 break;
             }
             case asset_type::fungible: {
@@ -1804,6 +2050,8 @@ EVT_ACTION_IMPL_BEGIN(newlock) {
         lock.failed      = std::move(nlact.failed);
 
         ADD_DB_TOKEN(token_type::lock, lock);
+        add_deadline(context.db, deadline_kind::lock_unlock, lock.name, lock.unlock_time);
+        add_deadline(context.db, deadline_kind::lock_deadline, lock.name, lock.deadline);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -1888,14 +2136,7 @@ EVT_ACTION_IMPL_BEGIN(tryunlock) {
             switch(la.type()) {
             case asset_type::tokens: {
                 auto& tokens = la.template get<locknft_def>();
-
-                for(auto& tn : tokens.names) {
-                    auto token = make_empty_cache_ptr<token_def>();
-                    READ_DB_TOKEN(token_type::token, tokens.domain, tn, token, unknown_token_exception,
-                        "Cannot find token: {} in {}", tn, tokens.domain);
-                    token->owner = *pkeys;
-                    UPD_DB_TOKEN(token_type::token, *token);
-                }
+                tokendb_cache.put_token_owners<token_def>(tokens.domain, tokens.names, address_list(pkeys->cbegin(), pkeys->cend()));
                 break;
             }
             case asset_type::fungible: {
@@ -1910,6 +2151,8 @@ EVT_ACTION_IMPL_BEGIN(tryunlock) {
         }
 
         UPD_DB_TOKEN(token_type::lock, *lock);
+        remove_deadline(context.db, deadline_kind::lock_unlock, lock->name);
+        remove_deadline(context.db, deadline_kind::lock_deadline, lock->name);
     }
     EVT_CAPTURE_AND_RETHROW(tx_apply_exception);
 }
@@ -2151,6 +2394,15 @@ EVT_ACTION_IMPL_BEGIN(setpsvbonus) {
         pb.round = 0;
         ADD_DB_TOKEN(token_type::psvbonus, pb);
 
+        // holders index is a cache of persisted balances, it's built here once instead of in the first distribution
+        for(auto& rule : pb.rules) {
+            rule.visit([&tokendb](auto& r) {
+                if(r.receiver.type() == dist_receiver_type::ftholders) {
+                    tokendb.warm_assets_holders(r.receiver.template get<dist_stack_receiver>().threshold.symbol_id());
+                }
+            });
+        }
+
         // add passive bonus slim for quick read
         auto pbs        = passive_bonus_slim();
         pbs.sym_id      = sym.id();
@@ -2188,16 +2440,18 @@ struct no_hasher {
     }
 };
 
-// it's a very special map that holds the hash value as key
-// so the hasher method simplely return the key directly
-// key is the hash(pubkey) and value is the amount of asset
-using holder_slim_map = google::dense_hash_map<uint32_t, int64_t, no_hasher<uint32_t>>;
+// set of the hash(pubkey) values, the hasher method simplely return the key directly
+using holder_hash_set = google::dense_hash_set<uint32_t, no_hasher<uint32_t>>;
 // map for storing the pubkeys of collision
 using holder_coll_map = std::unordered_map<std::string, int64_t, pubkey_hasher>;
+// key is the hash(pubkey) and value is the amount of asset, only used by dists of the dense layout
+using holder_slim_map = google::dense_hash_map<uint32_t, int64_t, no_hasher<uint32_t>>;
 
-struct holder_dist {
+// holder dist of the dense layout written by the earlier versions, all the holders are kept within it
+// the dists are never written in this layout anymore, they're only read
+struct holder_dist_v0 {
 public:
-    holder_dist() {
+    holder_dist_v0() {
         slim.set_empty_key(0);
     }
 
@@ -2208,26 +2462,138 @@ public:
     int64_t         total;
 };
 
+// holders of one shard stored in columns sorted by hash(pubkey)
+// all the hashes within one shard share the same prefix of `shard_bits` bits
+struct holder_shard {
+    std::vector<uint32_t> hashes;
+    std::vector<int64_t>  amounts;
+    holder_coll_map       coll;
+};
+
+// summary of the holders, shards are stored apart from it
+// so receiving bonus only needs to read the shard where the holder belongs to
+struct holder_dist {
+    symbol_id_type sym_id;
+    uint32_t       shard_bits;
+    int64_t        total;
+};
+
+using holder_shards = std::vector<holder_shard>;
+
+constexpr auto kMaxShardHolders = 4096u;
+constexpr auto kMaxShardBits    = 16u;
+
+uint32_t
+get_holder_shard(uint32_t hash, uint32_t shard_bits) {
+    return shard_bits == 0 ? 0 : (hash >> (32 - shard_bits));
+}
+
 void
-build_holder_dist(const token_database& tokendb, symbol sym, holder_dist& dist) {
+build_holder_dist(const token_database& tokendb, symbol sym, holder_dist& dist, holder_shards& shards) {
+    auto entries = std::vector<std::pair<uint32_t, int64_t>>();
+    auto seen    = holder_hash_set();
+    auto colls   = std::vector<std::tuple<uint32_t, std::string, int64_t>>();
+    seen.set_empty_key(0);
+
     dist.sym_id = sym.id();
-    tokendb.read_assets_range(sym.id(), 0, [&dist](auto& k, auto&& v) {
+    dist.total  = 0;
+    // holders are served from the index in token database, it's always in the same order as database
+    // so the first holder of one hash is always the same one and others go into collision maps
+    tokendb.read_assets_holders(sym.id(), [&](auto& k, auto&& v) {
         property prop;
         extract_db_value(v, prop);
 
-        auto h  = fc::city_hash32(k.data(), k.size());
-        auto it = dist.slim.emplace(h, prop.amount);
-        if(it.second == false) {
+        auto h = fc::city_hash32(k.data(), k.size());
+        if(seen.insert(h).second) {
+            entries.emplace_back(h, prop.amount);
+        }
+        else {
             // meet collision
-            dist.coll.emplace(std::string(k.data(), k.size()), prop.amount);
+            colls.emplace_back(h, std::string(k.data(), k.size()), prop.amount);
         }
         dist.total += prop.amount;
 
         return true;
     });
+
+    dist.shard_bits = 0;
+    while((entries.size() >> dist.shard_bits) > kMaxShardHolders && dist.shard_bits < kMaxShardBits) {
+        dist.shard_bits++;
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    shards.clear();
+    shards.resize(1u << dist.shard_bits);
+    for(auto& e : entries) {
+        auto& shard = shards[get_holder_shard(e.first, dist.shard_bits)];
+        shard.hashes.emplace_back(e.first);
+        shard.amounts.emplace_back(e.second);
+    }
+    for(auto& c : colls) {
+        shards[get_holder_shard(std::get<0>(c), dist.shard_bits)].coll.emplace(std::move(std::get<1>(c)), std::get<2>(c));
+    }
 };
 
-using holder_dists = small_vector<holder_dist, 4>;
+// bonusdists of the sharded layout are stored with this flag in their keys, so the ones stored
+// in the dense layout by earlier versions under the plain keys are still read with their own layout
+constexpr auto kShardedDistFlag = (uint128_t)1 << 63;
+
+// key of bonusdist of the sharded layout in the round
+name128
+get_psvbonus_sharded_dist_db_key(symbol_id_type sym_id, uint32_t round) {
+    uint128_t v = round;
+    v |= kShardedDistFlag;
+    v |= ((uint128_t)sym_id << 64);
+    return v;
+}
+
+// key of one shard of holders for `index`-th holder dist in the round
+// shard part is never zero so it doesn't conflict with the key of bonusdist itself
+name128
+get_psvbonus_dist_shard_db_key(symbol_id_type sym_id, uint32_t round, uint32_t index, uint32_t shard) {
+    assert(index < 256);
+    uint128_t v = round;
+    v |= ((uint128_t)index << 32);
+    v |= ((uint128_t)(shard + 1) << 40);
+    v |= ((uint128_t)sym_id << 64);
+    return v;
+}
+
+// amount of the holder within the `index`-th holder dist in the round, only one shard is read
+std::optional<int64_t>
+find_holder_amount(const token_database& tokendb,
+                   const holder_dist&    dist,
+                   uint32_t              round,
+                   uint32_t              index,
+                   const address&        addr) {
+    char key[sizeof(fc::ecc::public_key_shim)];
+    addr.to_bytes(key, sizeof(key));
+
+    auto h   = fc::city_hash32(key, sizeof(key));
+    auto str = std::string();
+    if(!tokendb.read_token(token_type::psvbonus_dist, std::nullopt,
+        get_psvbonus_dist_shard_db_key(dist.sym_id, round, index, get_holder_shard(h, dist.shard_bits)), str, true /* no throw */)) {
+        return std::nullopt;
+    }
+
+    auto shard = holder_shard();
+    extract_db_value(str, shard);
+
+    auto cit = shard.coll.find(std::string(key, sizeof(key)));
+    if(cit != shard.coll.cend()) {
+        return cit->second;
+    }
+
+    auto it = std::lower_bound(shard.hashes.cbegin(), shard.hashes.cend(), h);
+    if(it == shard.hashes.cend() || *it != h) {
+        return std::nullopt;
+    }
+    return shard.amounts[it - shard.hashes.cbegin()];
+}
+
+using holder_dists    = small_vector<holder_dist, 4>;
+using holder_dists_v0 = small_vector<holder_dist_v0, 4>;
 
 struct bonusdist {
     uint32_t          created_at;    // utc seconds
@@ -2238,6 +2604,56 @@ struct bonusdist {
     optional<address> final_receiver;
 };
 
+// bonusdist of the dense layout, stored under the plain keys
+struct bonusdist_v0 {
+    uint32_t          created_at;
+    uint32_t          created_index;
+    holder_dists_v0   holders;
+    time_point_sec    deadline;
+    optional<address> final_receiver;
+};
+
+// amount of the holder within the `index`-th holder dist in the round, whichever layout the dist is stored in
+std::optional<int64_t>
+find_dist_holder_amount(const token_database& tokendb,
+                        symbol_id_type        sym_id,
+                        uint32_t              round,
+                        uint32_t              index,
+                        const address&        addr) {
+    auto str = std::string();
+    if(tokendb.read_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_sharded_dist_db_key(sym_id, round), str, true /* no throw */)) {
+        auto bd = bonusdist();
+        extract_db_value(str, bd);
+        if(index >= bd.holders.size()) {
+            return std::nullopt;
+        }
+        return find_holder_amount(tokendb, bd.holders[index], round, index, addr);
+    }
+
+    if(!tokendb.read_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(sym_id, round), str, true /* no throw */)) {
+        return std::nullopt;
+    }
+    auto bd = bonusdist_v0();
+    extract_db_value(str, bd);
+    if(index >= bd.holders.size()) {
+        return std::nullopt;
+    }
+
+    char key[sizeof(fc::ecc::public_key_shim)];
+    addr.to_bytes(key, sizeof(key));
+
+    auto& dist = bd.holders[index];
+    auto  cit  = dist.coll.find(std::string(key, sizeof(key)));
+    if(cit != dist.coll.cend()) {
+        return cit->second;
+    }
+    auto it = dist.slim.find(fc::city_hash32(key, sizeof(key)));
+    if(it == dist.slim.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
 name128
 get_psvbonus_dist_db_key(uint64_t sym_id, uint64_t round) {
     uint128_t v = round;
@@ -2250,7 +2666,7 @@ get_psvbonus_dist_db_key(uint64_t sym_id, uint64_t round) {
 EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
     using namespace internal;
 
-    auto spbact = context.act.data_as<ACT>();
+    auto& spbact = context.act.data_as<add_clr_t<ACT>>();
     try {
         EVT_ASSERT(context.has_authorized(N128(.psvbonus), name128::from_number(spbact.sym_id)), action_authorize_exception,
             "Invalid authorization fields in action(domain and key).");
@@ -2265,6 +2681,7 @@ EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
 
         property pbonus;
         READ_DB_ASSET_NO_THROW(get_psvbonus_address(spbact.sym_id, 0), sym, pbonus);
+        fold_passive_bonus(context, sym, pbonus);
         EVT_ASSERT2(pbonus.amount >= pb->dist_threshold.amount(), bonus_unreached_dist_threshold,
             "Distribution threshold: {} is unreached, current: {}", pb->dist_threshold, asset(pbonus.amount, sym));
 
@@ -2292,9 +2709,29 @@ EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
             }  // switch
 
             if(ftrev.has_value()) {
-                auto dist = holder_dist();
-                build_holder_dist(tokendb, ftrev->threshold.sym(), dist);
-                bd.holders.emplace_back(std::move(dist));
+                // balances of collector and collection address are read from database along with all the other holders
+                // so the pending accruals of the holders' symbol are folded first
+                if(ftrev->threshold.sym().id() == EVT_SYM_ID) {
+                    fold_all_charges(context);
+                }
+                else {
+                    fold_all_passive_bonus(context, ftrev->threshold.sym());
+                }
+                auto dist   = holder_dist();
+                auto shards = holder_shards();
+                build_holder_dist(tokendb, ftrev->threshold.sym(), dist, shards);
+
+                // empty shards are not stored
+                for(auto i = 0u; i < shards.size(); i++) {
+                    if(shards[i].hashes.empty() && shards[i].coll.empty()) {
+                        continue;
+                    }
+                    // shards are written without caching, they are only read once for each holder
+                    auto sdbv = make_db_value(shards[i]);
+                    tokendb.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt,
+                        get_psvbonus_dist_shard_db_key(spbact.sym_id, pb->round + 1, bd.holders.size(), i), sdbv.as_string_view());
+                }
+                bd.holders.emplace_back(dist);
             }
         }
 
@@ -2308,7 +2745,11 @@ EVT_ACTION_IMPL_BEGIN(distpsvbonus) {
         UPD_DB_TOKEN(token_type::psvbonus, *pb);
 
         auto dbv = make_db_value(bd);
-        tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_db_key(spbact.sym_id, pb->round), dbv);
+        tokendb_cache.put_token(token_type::psvbonus_dist, action_op::add, std::nullopt, get_psvbonus_sharded_dist_db_key(spbact.sym_id, pb->round), dbv);
+
+        // only the latest round is tracked
+        remove_deadline(context.db, deadline_kind::bonus_deadline, get_psvbonus_db_key(spbact.sym_id, pb->round - 1));
+        add_deadline(context.db, deadline_kind::bonus_deadline, get_psvbonus_db_key(spbact.sym_id, pb->round), time_point_sec(spbact.deadline));
 
         // transfer all the FTs from cllected address to distribute address of current round
         transfer_fungible(context, get_psvbonus_address(spbact.sym_id, 0), get_psvbonus_address(spbact.sym_id, pb->round), asset(pbonus.amount, pbonus.sym), N(distpsvbonus), false /* pay bonus */);
@@ -2319,5 +2760,8 @@ EVT_ACTION_IMPL_END()
 
 }}} // namespace evt::chain::contracts
 
-FC_REFLECT(evt::chain::contracts::internal::holder_dist, (sym_id)(slim)(coll)(total));
+FC_REFLECT(evt::chain::contracts::internal::holder_shard, (hashes)(amounts)(coll));
+FC_REFLECT(evt::chain::contracts::internal::holder_dist, (sym_id)(shard_bits)(total));
 FC_REFLECT(evt::chain::contracts::internal::bonusdist, (created_at)(created_index)(holders)(deadline)(final_receiver));
+FC_REFLECT(evt::chain::contracts::internal::holder_dist_v0, (sym_id)(slim)(coll)(total));
+FC_REFLECT(evt::chain::contracts::internal::bonusdist_v0, (created_at)(created_index)(holders)(deadline)(final_receiver));
@@ -3,6 +3,7 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <memory>
 #include <optional>
 #include <fc/container/flat_fwd.hpp>
 #include <fc/static_variant.hpp>
@@ -69,22 +70,27 @@ public:
     const signatures_type& get_signatures() const { return signatures_; }
 
 public:
-    void set_header(uint16_t header) { header_ = header; }
+    void set_header(uint16_t header) { header_ = header; keys_.reset(); }
     void add_segment(const segment&);
     void remove_segment(uint8_t key);
     void add_signature(const signature_type&);
-    void clear_signatures() { signatures_.clear(); }
+    void clear_signatures() { signatures_.clear(); keys_.reset(); }
     void sign(const private_key_type&);
 
 public:
     fc::sha256 digest() const;
-    public_keys_set restore_keys() const;
+
+    // keys are recovered once and kept until link is changed, copies of link share them
+    // safe to be called from multiple threads on one unchanged link
+    const public_keys_set& restore_keys() const;
 
 private:
     uint16_t        header_;
     segments_type   segments_;
     signatures_type signatures_;
 
+    mutable std::shared_ptr<const public_keys_set> keys_;
+
 private:
     friend struct fc::reflector<evt_link>;
 };
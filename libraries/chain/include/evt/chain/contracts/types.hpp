@@ -173,6 +173,20 @@ struct suspend_def {
     transaction                        trx;
     public_keys_set                    signed_keys;
     signatures_type                    signatures;
+
+public:
+    // digest for recovering approvals, trx is never changed once proposed
+    // so it's only calculated once while suspend stays in cache
+    const digest_type&
+    sig_digest(const chain_id_type& chain_id) const {
+        if(!sig_digest_.has_value()) {
+            sig_digest_ = trx.sig_digest(chain_id);
+        }
+        return *sig_digest_;
+    }
+
+private:
+    mutable std::optional<digest_type> sig_digest_;
 };
 
 enum class asset_type {
@@ -441,6 +455,19 @@ struct transferft {
     EVT_ACTION_VER1(transferft);
 };
 
+struct ft_credit {
+    address_type to;
+    asset        number;
+};
+
+struct batchtransft {
+    address_type               from;
+    small_vector<ft_credit, 4> credits;
+    string                     memo;
+
+    EVT_ACTION_VER1(batchtransft);
+};
+
 struct recycleft {
     address_type address;
     asset        number;
@@ -633,6 +660,7 @@ struct recvpsvbonus {
 }}}  // namespace evt::chain::contracts
 
 FC_REFLECT(evt::chain::contracts::property, (amount)(sym)(created_at)(created_index));
+FC_REFLECT_TRIVIALLY_PACKABLE(evt::chain::contracts::property);
 FC_REFLECT(evt::chain::contracts::token_def, (domain)(name)(owner)(metas));
 FC_REFLECT(evt::chain::contracts::key_weight, (key)(weight));
 FC_REFLECT(evt::chain::contracts::authorizer_weight, (ref)(weight));
@@ -679,6 +707,8 @@ FC_REFLECT(evt::chain::contracts::updfungible, (sym_id)(issue)(manage));
 FC_REFLECT(evt::chain::contracts::updfungible_v2, (sym_id)(issue)(transfer)(manage));
 FC_REFLECT(evt::chain::contracts::issuefungible, (address)(number)(memo));
 FC_REFLECT(evt::chain::contracts::transferft, (from)(to)(number)(memo));
+FC_REFLECT(evt::chain::contracts::ft_credit, (to)(number));
+FC_REFLECT(evt::chain::contracts::batchtransft, (from)(credits)(memo));
 FC_REFLECT(evt::chain::contracts::recycleft, (address)(number)(memo));
 FC_REFLECT(evt::chain::contracts::destroyft, (address)(number)(memo));
 FC_REFLECT(evt::chain::contracts::evt2pevt, (from)(to)(number)(memo));
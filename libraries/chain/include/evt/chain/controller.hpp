@@ -5,8 +5,10 @@
 #pragma once
 #include <chrono>
 #include <functional>
+#include <future>
 #include <map>
 #include <boost/signals2/signal.hpp>
+#include <evt/chain/block_log.hpp>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/token_database.hpp>
@@ -16,15 +18,24 @@ namespace chainbase {
 class database;
 }
 
+namespace boost { namespace asio {
+class thread_pool;
+}}  // namespace boost::asio
+
 namespace evt { namespace chain {
 
 using unapplied_transactions_type = map<transaction_id_type, transaction_metadata_ptr>;
 
 class fork_database;
+class block_bus;
 class apply_context;
 class charge_manager;
 class execution_context;
 class token_database_cache;
+class bonus_accruals;
+class perf_stats;
+class deadline_timer;
+class action_cost_table;
 
 struct controller_impl;
 using boost::signals2::signal;
@@ -65,12 +76,18 @@ public:
         uint64_t state_guard_size       = chain::config::default_state_guard_size;
         uint64_t reversible_cache_size  = chain::config::default_reversible_cache_size;
         uint64_t reversible_guard_size  = chain::config::default_reversible_guard_size;
+        uint64_t fork_db_max_size       = chain::config::default_fork_db_max_size;
         bool     read_only              = false;
         bool     force_all_checks       = false;
         bool     disable_replay_opts    = false;
         bool     loadtest_mode          = false;
         bool     charge_free_mode       = false;
         bool     contracts_console      = false;
+        uint16_t thread_pool_size       = chain::config::default_controller_thread_pool_size;
+        uint32_t parallel_recover_sigs  = chain::config::default_parallel_recover_min_sigs;  // 0 disables parallel recovery
+        uint32_t block_bus_size         = 0;  // 0 disables block bus
+        uint32_t replay_prefetch_blocks = 0;  // blocks read ahead in each stage when replaying, 0 disables prefetching
+        uint32_t trx_prefetch_ahead     = 0;  // transactions whose read sets are prefetched ahead of executing, 0 disables it
 
         std::chrono::microseconds max_serialization_time = std::chrono::milliseconds(chain::config::default_abi_serializer_max_time_ms);
 
@@ -79,7 +96,12 @@ public:
 
         flat_set<account_name> trusted_producers;
 
+        // irreversible blocks up to this one are trusted when replaying: no signature recovery,
+        // no undo sessions and no receipt / merkle verifications
+        optional<block_id_type> trusted_replay_until;
+
         token_database::config db_config;
+        block_log::config      blog_config;
 
         genesis_state genesis;
     };
@@ -91,6 +113,17 @@ public:
         incomplete   = 3, ///< this is an incomplete block (either being produced by a producer or speculatively produced by a node)
     };
 
+    // time spent in the phases of applying blocks and transactions, in microseconds
+    struct phase_timings {
+        uint64_t unpack_us         = 0;  // making metadata of the transactions in blocks
+        uint64_t recover_us        = 0;  // recovering or waiting for signing keys
+        uint64_t auth_us           = 0;
+        uint64_t apply_us          = 0;  // executing transactions
+        uint64_t finalize_us       = 0;  // folding bonuses and calculating merkle roots
+        uint64_t commit_us         = 0;  // adding block into fork database and reversible log
+        uint64_t tokendb_commit_us = 0;  // committing savepoints of irreversible blocks
+    };
+
     explicit controller(const config& cfg);
     ~controller();
 
@@ -116,6 +149,10 @@ public:
      */
     unapplied_transactions_type& get_unapplied_transactions() const;
 
+    // loads the keys which `trx` will read into block cache of token database on another thread, no-op if
+    // `trx_prefetch_ahead` is not set. Transactions in blocks being applied are prefetched internally
+    void prefetch_transaction(const transaction_metadata_ptr& trx);
+
     transaction_trace_ptr push_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline);
     transaction_trace_ptr push_suspend_transaction(const transaction_metadata_ptr& trx, fc::time_point deadline);
 
@@ -124,6 +161,8 @@ public:
 
     void finalize_block();
     void sign_block(const std::function<signature_type(const digest_type&)>& signer_callback);
+    // signer runs on its own thread, commit_block waits for the signature
+    void sign_block_async(const std::function<signature_type(const digest_type&)>& signer_callback);
     void commit_block();
     void pop_block();
 
@@ -133,6 +172,10 @@ public:
     fork_database& fork_db() const;
     token_database& token_db() const;
     token_database_cache& token_db_cache() const;
+    bonus_accruals&       pending_bonus_accruals() const;
+    // charges of the pending block are accrued and credited to the collector, producer of block, once it's finalized
+    bonus_accruals&       pending_charge_accruals() const;
+    const address&        pending_charge_collector() const;
 
     charge_manager get_charge_manager() const;
 
@@ -166,6 +209,10 @@ public:
 
     signed_block_ptr fetch_block_by_number(uint32_t block_num) const;
     signed_block_ptr fetch_block_by_id(block_id_type id) const;
+    // irreversible blocks are not unpacked, they're read from block log as they are
+    block_log::packed_block fetch_packed_block_by_number(uint32_t block_num) const;
+    // blocks before it are pruned from block log
+    uint32_t                earliest_available_block_num() const;
 
     block_state_ptr fetch_block_state_by_number(uint32_t block_num) const;
     block_state_ptr fetch_block_state_by_id(block_id_type id) const;
@@ -176,6 +223,13 @@ public:
 
     fc::sha256 calculate_integrity_hash() const;
     void write_snapshot(const std::shared_ptr<snapshot_writer>& snapshot) const;
+    // returns once the state is pinned, snapshot is written on another thread and is done when the future is ready
+    // snapshot writer is not finalized
+    std::shared_future<void> write_snapshot_async(const std::shared_ptr<snapshot_writer>& snapshot);
+    // same as above but only the rows of token database in `deltas` are written, they're changed since block `base_id`
+    std::shared_future<void> write_incremental_snapshot_async(const std::shared_ptr<snapshot_writer>& snapshot,
+                                                              const block_id_type&                    base_id,
+                                                              std::vector<token_delta>&&              deltas);
 
     bool is_producing_block() const;
 
@@ -206,15 +260,33 @@ public:
     const chain_id_type& get_chain_id() const;
     const genesis_state& get_genesis_state() const;
 
+    // pool for the context-free works like signature recovery
+    boost::asio::thread_pool& get_thread_pool();
+    // returns nullptr if block bus is not enabled
+    block_bus* get_block_bus() const;
+
+    // timings are only collected when it's set, used by benchmarks, nullptr to stop it
+    void set_phase_timings(phase_timings* timings);
+    // always-on counters of the phases, only used from main thread
+    perf_stats& get_perf_stats();
+    // costs of each action type from executed transactions, only used from main thread
+    const action_cost_table& get_action_costs() const;
+    // deadlines of the transactions being executed are armed on it
+    deadline_timer& get_deadline_timer();
+
     signal<void(const signed_block_ptr&)>         pre_accepted_block;
     signal<void(const block_state_ptr&)>          accepted_block_header;
     signal<void(const block_state_ptr&)>          accepted_block;
     signal<void(const block_state_ptr&)>          irreversible_block;
+    // pending block is aborted, its transactions are unapplied
+    signal<void(const block_state_ptr&)>          aborted_block;
     signal<void(const transaction_metadata_ptr&)> accepted_transaction;
     signal<void(const transaction_trace_ptr&)>    applied_transaction;
     signal<void(const int&)>                      bad_alloc;
 
+    // results are cached until the tokens checked are changed, so wallets calling it before every signature are cheap
     public_keys_set get_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const;
+    std::vector<public_keys_set> get_required_keys(const std::vector<transaction>& trxs, const public_keys_set& candidate_keys) const;
     public_keys_set get_suspend_required_keys(const transaction& trx, const public_keys_set& candidate_keys) const;
     public_keys_set get_suspend_required_keys(const proposal_name& name, const public_keys_set& candidate_keys) const;
 
@@ -233,13 +305,21 @@ FC_REFLECT(evt::chain::controller::config,
            (state_dir)
            (state_size)
            (reversible_cache_size)
+           (fork_db_max_size)
            (read_only)
            (force_all_checks)
            (disable_replay_opts)
            (loadtest_mode)
            (charge_free_mode)
            (contracts_console)
+           (thread_pool_size)
+           (parallel_recover_sigs)
+           (block_bus_size)
+           (replay_prefetch_blocks)
+           (trx_prefetch_ahead)
            (trusted_producers)
+           (trusted_replay_until)
            (db_config)
+           (blog_config)
            (genesis)
            );
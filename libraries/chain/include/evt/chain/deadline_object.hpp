@@ -0,0 +1,72 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <evt/chain/types.hpp>
+#include <evt/chain/multi_index_includes.hpp>
+
+namespace evt { namespace chain {
+using boost::multi_index_container;
+using namespace boost::multi_index;
+
+enum class deadline_kind : uint8_t {
+    lock_unlock = 0,  // unlock time of lock proposals
+    lock_deadline,    // deadline of lock proposals
+    suspend_expiration,
+    bonus_deadline    // deadline of the latest round of passive bonus, name is the key of its distribution
+};
+
+/**
+ * Time-ordered index of the pending deadlines kept in token database, like the unlock times of the locks.
+ * Entries are maintained by the actions creating and resolving them, so the ones due within a window
+ * can be found without scanning all the locks or suspends.
+ */
+class deadline_object : public chainbase::object<deadline_object_type, deadline_object> {
+    OBJECT_CTOR(deadline_object)
+
+    id_type        id;
+    time_point_sec due;
+    deadline_kind  kind;
+    name128        name;
+};
+
+struct by_due;
+struct by_name;
+using deadline_multi_index = chainbase::shared_multi_index_container<
+    deadline_object,
+    indexed_by<
+        ordered_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER(deadline_object, deadline_object::id_type, id)>,
+        ordered_unique<
+            tag<by_due>,
+            composite_key<deadline_object, BOOST_MULTI_INDEX_MEMBER(deadline_object, time_point_sec, due),
+                          BOOST_MULTI_INDEX_MEMBER(deadline_object, deadline_kind, kind),
+                          BOOST_MULTI_INDEX_MEMBER(deadline_object, name128, name)>>,
+        ordered_unique<
+            tag<by_name>,
+            composite_key<deadline_object, BOOST_MULTI_INDEX_MEMBER(deadline_object, deadline_kind, kind),
+                          BOOST_MULTI_INDEX_MEMBER(deadline_object, name128, name)>>>>;
+
+typedef chainbase::generic_index<deadline_multi_index> deadline_index;
+
+inline void
+add_deadline(chainbase::database& db, deadline_kind kind, const name128& name, time_point_sec due) {
+    db.create<deadline_object>([&](auto& d) {
+        d.due  = due;
+        d.kind = kind;
+        d.name = name;
+    });
+}
+
+inline void
+remove_deadline(chainbase::database& db, deadline_kind kind, const name128& name) {
+    if(auto d = db.find<deadline_object, by_name>(boost::make_tuple(kind, name))) {
+        db.remove(*d);
+    }
+}
+
+}}  // namespace evt::chain
+
+CHAINBASE_SET_INDEX_TYPE(evt::chain::deadline_object, evt::chain::deadline_multi_index);
+FC_REFLECT_ENUM(evt::chain::deadline_kind, (lock_unlock)(lock_deadline)(suspend_expiration)(bonus_deadline));
+FC_REFLECT(evt::chain::deadline_object, (due)(kind)(name));
@@ -0,0 +1,62 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <boost/noncopyable.hpp>
+#include <fc/time.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Watchdog thread flipping one flag once the armed deadline is passed, so the deadlines of transactions
+ *  are checked by a relaxed load instead of reading clock everytime.
+ *
+ *  Only one deadline is armed at a time, by the thread executing transactions. Watchdog is only woken
+ *  when the new deadline is earlier than the one it's waiting for, otherwise it finds the later one
+ *  after waking up and waits again, so arming the deadlines of one block rarely costs a wake-up.
+ */
+class deadline_timer : boost::noncopyable {
+public:
+    // restores previous deadline when it's destroyed, used by the nested transactions like suspends
+    class scope : boost::noncopyable {
+    public:
+        scope(deadline_timer& timer, fc::time_point deadline)
+            : timer_(timer)
+            , prev_(timer.arm(deadline)) {}
+        ~scope() { timer_.arm(prev_); }
+
+    private:
+        deadline_timer& timer_;
+        fc::time_point  prev_;
+    };
+
+public:
+    deadline_timer();
+    ~deadline_timer();
+
+public:
+    // returns previous deadline, `fc::time_point::maximum()` disarms it
+    fc::time_point arm(fc::time_point deadline);
+
+    // may be set a little later than the deadline, callers check the clock once it's set
+    bool expired() const { return expired_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    fc::time_point          deadline_;
+    fc::time_point          waiting_;  // deadline watchdog is waiting for
+    bool                    stop_;
+    std::atomic<bool>       expired_;
+    std::thread             thread_;
+};
+
+}}  // namespace evt::chain
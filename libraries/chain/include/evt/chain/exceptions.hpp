@@ -115,6 +115,7 @@ namespace evt { namespace chain {
 FC_DECLARE_EXCEPTION( chain_exception, 3000000, "blockchain exception" );
 
 FC_DECLARE_DERIVED_EXCEPTION( database_exception, chain_exception, 3010000, "Database exception" );
+FC_DECLARE_DERIVED_EXCEPTION( state_layout_exception, database_exception, 3010001, "Layout of chain state is not supported" );
 
 FC_DECLARE_DERIVED_EXCEPTION( block_validate_exception,    chain_exception,          3020000, "block validation exception" );
 FC_DECLARE_DERIVED_EXCEPTION( unlinkable_block_exception,  block_validate_exception, 3020001, "Unlinkable block" );
@@ -182,6 +183,7 @@ FC_DECLARE_DERIVED_EXCEPTION( fungible_address_exception,       fungible_excepti
 FC_DECLARE_DERIVED_EXCEPTION( math_overflow_exception,          fungible_exception, 3040407, "Operations resulted in overflow." );
 FC_DECLARE_DERIVED_EXCEPTION( balance_exception,                fungible_exception, 3040408, "Not enough balance left." );
 FC_DECLARE_DERIVED_EXCEPTION( fungible_cannot_update_exception, fungible_exception, 3040409, "Some parts of this FT cannot be updated due to some limitations" );
+FC_DECLARE_DERIVED_EXCEPTION( batch_empty_exception,            fungible_exception, 3040410, "Batch of credits cannot be empty." );
 
 FC_DECLARE_DERIVED_EXCEPTION( suspend_exception,                   action_exception,  3040500, "Suspend exception" );
 FC_DECLARE_DERIVED_EXCEPTION( unknown_suspend_exception,           suspend_exception, 3040501, "Suspend transaction does not exist." );
@@ -367,6 +369,7 @@ FC_DECLARE_DERIVED_EXCEPTION( exceed_evt_link_watch_time_exception, evt_link_plu
 FC_DECLARE_DERIVED_EXCEPTION( resource_exhausted_exception, chain_exception, 3200000, "Resource exhausted exception" );
 FC_DECLARE_DERIVED_EXCEPTION( tx_net_usage_exceeded,        resource_exhausted_exception, 3200001, "Transaction exceeded the current network usage limit imposed on the transaction" );
 FC_DECLARE_DERIVED_EXCEPTION( block_net_usage_exceeded,     resource_exhausted_exception, 3200002, "Transaction network usage is too much for the remaining allowable usage of the current block" );
+FC_DECLARE_DERIVED_EXCEPTION( pending_trxs_exhausted,       resource_exhausted_exception, 3200003, "Too many transactions are pending, try again later" );
 
 FC_DECLARE_DERIVED_EXCEPTION( abi_exception,                        chain_exception, 3210000, "ABI exception" );
 FC_DECLARE_DERIVED_EXCEPTION( abi_not_found_exception,              abi_exception,   3210001, "No ABI found" );
@@ -405,4 +408,15 @@ FC_DECLARE_DERIVED_EXCEPTION( unknown_action_exception, execution_exception, 324
 FC_DECLARE_DERIVED_EXCEPTION( action_index_exception,   execution_exception, 3240002, "Invalid action index exception" );
 FC_DECLARE_DERIVED_EXCEPTION( action_version_exception, execution_exception, 3240003, "Invalid action version exception" );
 
+FC_DECLARE_DERIVED_EXCEPTION( export_plugin_exception, chain_exception,         3250000, "Export plugin exception" );
+FC_DECLARE_DERIVED_EXCEPTION( export_write_exception,  export_plugin_exception, 3250001, "Write export files failed" );
+
+FC_DECLARE_DERIVED_EXCEPTION( state_delta_plugin_exception,      chain_exception,              3260000, "State delta plugin exception" );
+FC_DECLARE_DERIVED_EXCEPTION( state_delta_log_exception,         state_delta_plugin_exception, 3260001, "State delta log is corrupted or not contiguous" );
+FC_DECLARE_DERIVED_EXCEPTION( state_delta_not_existed_exception, state_delta_plugin_exception, 3260002, "State deltas of block are not existed" );
+
+FC_DECLARE_DERIVED_EXCEPTION( history_plugin_exception,        chain_exception,          3270000, "History plugin exception" );
+FC_DECLARE_DERIVED_EXCEPTION( history_db_exception,            history_plugin_exception, 3270001, "Read or write history database failed" );
+FC_DECLARE_DERIVED_EXCEPTION( history_not_supported_exception, history_plugin_exception, 3270002, "Query is not supported by the history backend" );
+
 }} // evt::chain
@@ -145,50 +145,32 @@ public:
         return (int)type_names_[index_of(act)].size();
     }
 
+    // dispatched by a table of invokers built at compile time, indexed by action index and version
+    // so each dispatch is one indirect call to the invoker of that exact action type
     template <template<uint64_t> typename Invoker, typename RType, typename ... Args>
     RType
     invoke(int actindex, Args&&... args) const {
-        using opt_type = std::conditional_t<std::is_void<RType>::value, int, RType>;
-
-        auto fn = [&](auto i) -> std::optional<opt_type> {
-            auto name  = act_names_[i];
-            auto vers  = hana::filter(act_types_,
-                [&](auto& t) { return hana::equal(name, hana::ulong_c<decltype(+t)::type::get_action_name().value>); });
-            auto cver = get_curr_ver(i);
-
-            static_assert(hana::length(vers)() > hana::size_c<0>(), "empty version actions!");
-
-            auto result = std::optional<opt_type>();
-            hana::for_each(vers, [&, cver](auto v) {
-                using ty = typename decltype(+v)::type;
-
-                constexpr auto n = ty::get_action_name().value;
-                if(ty::get_version() == cver) {
-                    if constexpr (std::is_void<RType>::value) {
-                        Invoker<n>::template invoke<ty>(std::forward<Args>(args)...);
-                        result = 1;
-                    }
-                    else {
-                        result = Invoker<n>::template invoke<ty>(std::forward<Args>(args)...);
-                    }
-                }
-            });
+        static constexpr auto table = make_invoke_table<Invoker, RType, Args...>();
 
-            return result;
-        };
+        EVT_ASSERT(actindex >= 0 && actindex < (int)table.size(), action_index_exception, "Invalid action index: ${act}", ("act", actindex));
+        auto ver = get_curr_ver(actindex);
+        EVT_ASSERT(ver >= 1 && ver <= kMaxVersion, action_version_exception, "Invalid version: ${v} of action index: ${act}", ("v", ver)("act", actindex));
+        return table[actindex][ver - 1](std::forward<Args>(args)...);
+    }
 
-        auto range  = hana::make_range(hana::int_c<0>, hana::length(act_names_));
-        auto result = std::optional<opt_type>();
-        hana::for_each(range, [&](auto i) {
-            if(i() == actindex) {
-                result = fn(i);
-            }
+    // current versions of actions are only known with chain, so this one always invokes the first version
+    // it's for the traits which only depend on the common fields of all the versions, like accesses of actions
+    template <template<uint64_t> typename Invoker, typename RType, typename ... Args>
+    static RType
+    invoke_first_version(name act, Args&&... args) {
+        static constexpr auto names = hana::unpack(act_names_, [](auto ...i) {
+            return std::array<uint64_t, sizeof...(i)>{{i...}};
         });
+        static constexpr auto table = make_invoke_table<Invoker, RType, Args...>();
 
-        EVT_ASSERT(result.has_value(), action_index_exception, "Invalid action index: ${act}", ("act", actindex));
-        if constexpr (!std::is_void<RType>::value) {
-            return *result;
-        }
+        auto it = std::lower_bound(names.cbegin(), names.cend(), act.value);
+        EVT_ASSERT(it != names.cend() && *it == act.value, unknown_action_exception, "Unknown action: ${act}", ("act", act));
+        return table[it - names.cbegin()][0](std::forward<Args>(args)...);
     }
 
     template <typename T, typename Func>
@@ -228,6 +210,57 @@ public:
         return acts;
     }
 
+private:
+    template <template<uint64_t> typename Invoker, typename RType, typename T, typename ... Args>
+    static RType
+    invoke_type(Args&&... args) {
+        return Invoker<T::get_action_name().value>::template invoke<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename RType, int I, typename ... Args>
+    static RType
+    invoke_invalid(Args&&...) {
+        EVT_THROW(action_index_exception, "Invalid version of action index: ${act}", ("act", I));
+    }
+
+    // invoker of the version `V` of action at index `I`, or the one throwing if the action doesn't have that version
+    template <template<uint64_t> typename Invoker, typename RType, int I, int V, typename ... Args>
+    static constexpr auto
+    make_invoker() {
+        using fn_type = RType (*)(Args&&...);
+        using name_t  = std::decay_t<decltype(hana::at_c<I>(act_names_))>;
+
+        constexpr auto ty = hana::find_if(act_types_, [](auto& t) {
+            using tt = typename decltype(+t)::type;
+            return hana::bool_c<tt::get_action_name().value == name_t::value && tt::get_version() == V>;
+        });
+        if constexpr(decltype(hana::is_just(ty))::value) {
+            using tt = typename std::decay_t<decltype(*ty)>::type;
+            return (fn_type)&invoke_type<Invoker, RType, tt, Args...>;
+        }
+        else {
+            return (fn_type)&invoke_invalid<RType, I, Args...>;
+        }
+    }
+
+    template <template<uint64_t> typename Invoker, typename RType, int I, typename ... Args>
+    static constexpr auto
+    make_version_invokers() {
+        using fn_type = RType (*)(Args&&...);
+        return hana::unpack(hana::make_range(hana::int_c<1>, hana::int_c<kMaxVersion + 1>), [](auto ...v) {
+            return std::array<fn_type, sizeof...(v)>{{ make_invoker<Invoker, RType, I, decltype(v)::value, Args...>()... }};
+        });
+    }
+
+    template <template<uint64_t> typename Invoker, typename RType, typename ... Args>
+    static constexpr auto
+    make_invoke_table() {
+        using fn_type = RType (*)(Args&&...);
+        return hana::unpack(hana::make_range(hana::int_c<0>, hana::length(act_names_)), [](auto ...i) {
+            return std::array<std::array<fn_type, kMaxVersion>, sizeof...(i)>{{ make_version_invokers<Invoker, RType, decltype(i)::value, Args...>()... }};
+        });
+    }
+
 private:
     int
     get_curr_ver(int index) const {
@@ -238,6 +271,7 @@ private:
 private:
     static constexpr auto act_types_ = hana::make_tuple(hana::type_c<ACTTYPE>...);
     static constexpr auto act_names_ = hana::sort(hana::unique(hana::transform(act_types_, [](auto& a) { return hana::ulong_c<decltype(+a)::type::get_action_name().value>; })));
+    static constexpr int  kMaxVersion = std::max({ (int)ACTTYPE::get_version()... });
 
 private:
     controller&                                                        chain_;
@@ -280,7 +314,8 @@ using evt_execution_context = execution_context_impl<
                                   contracts::tryunlock,
                                   contracts::setpsvbonus,
                                   contracts::setpsvbonus_v2,
-                                  contracts::distpsvbonus
+                                  contracts::distpsvbonus,
+                                  contracts::batchtransft
                               >;
 
 }}  // namespace evt::chain
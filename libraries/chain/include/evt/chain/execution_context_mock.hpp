@@ -240,7 +240,8 @@ using evt_execution_context_mock = execution_context_mock<
                                       contracts::tryunlock,
                                       contracts::setpsvbonus,
                                       contracts::setpsvbonus_v2,
-                                      contracts::distpsvbonus
+                                      contracts::distpsvbonus,
+                                      contracts::batchtransft
                                   >;
 
 }}  // namespace evt::chain
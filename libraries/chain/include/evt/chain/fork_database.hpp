@@ -5,6 +5,7 @@
 #pragma once
 #include <boost/signals2/signal.hpp>
 #include <evt/chain/block_state.hpp>
+#include <evt/chain/config.hpp>
 
 namespace evt { namespace chain {
 
@@ -22,10 +23,14 @@ typedef vector<block_state_ptr> branch_type;
  * database tracks the longest chain and the last irreversible block number. All
  * blocks older than the last irreversible block are freed after emitting the
  * irreversible signal.
+ *
+ * Size of the states is bounded by `max_size` bytes (estimated), once it's over that the blocks of
+ * the states neither validated nor in the branch of head are kept packed, and they're unpacked again
+ * when they're looked up. If it's still over, the oldest dead branches are removed.
  */
 class fork_database {
 public:
-    fork_database(const fc::path& data_dir);
+    fork_database(const fc::path& data_dir, uint64_t max_size = config::default_fork_db_max_size);
     ~fork_database();
 
     void close();
@@ -65,6 +70,9 @@ public:
     void mark_in_current_chain(const block_state_ptr& h, bool in_current_chain);
     void prune(const block_state_ptr& h);
 
+    // estimated bytes of all the states
+    uint64_t size() const;
+
     /**
      * This signal is emited when a block state becomes irreversible, once irreversible
      * it is removed unless it is the head block.
@@ -0,0 +1,87 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <fc/variant.hpp>
+
+namespace evt { namespace chain {
+
+struct block_state;
+
+// live bytes of one subsystem, updated by the owner of the containers when things are added or removed
+// it's safe to be updated from any thread
+class memory_counter : boost::noncopyable {
+public:
+    void
+    add(int64_t bytes) {
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        objects_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void
+    sub(int64_t bytes) {
+        bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        objects_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    int64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+    int64_t objects() const { return objects_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> bytes_   = 0;
+    std::atomic<int64_t> objects_ = 0;
+};
+
+/**
+ *  Opt-in accounting of the memory held by the main containers and caches of the node, by subsystem.
+ *  Subsystems either keep a `memory_counter` updated, or register a probe which estimates its size
+ *  from the structures it already has, so nothing is added to the hot paths when it's disabled.
+ *
+ *  Report also includes resident size of the process and, when the process runs with jemalloc,
+ *  stats of allocator, so the part not attributed to any subsystem can be seen.
+ *  Allocation stacks are sampled by the heap profiling of jemalloc (`MALLOC_CONF=prof:true`),
+ *  `dump_heap_profile` writes the samples into a file which `jeprof` reads.
+ */
+class memory_accounting : boost::noncopyable {
+public:
+    using probe_type = std::function<uint64_t()>;
+
+public:
+    static memory_accounting& instance();
+
+public:
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    // probes are called on the thread taking the report, which is main thread
+    void add_probe(const std::string& subsystem, probe_type probe);
+    void remove_probe(const std::string& subsystem);
+
+    // created on first use and never removed, so the reference can be kept
+    memory_counter& counter(const std::string& subsystem);
+
+    fc::variant report() const;
+
+    // false if heap profiling is not active
+    bool dump_heap_profile(const std::string& file) const;
+
+private:
+    bool enabled_ = false;
+
+    mutable std::mutex                                     mutex_;
+    std::map<std::string, probe_type>                      probes_;
+    std::map<std::string, std::unique_ptr<memory_counter>> counters_;
+};
+
+// estimated bytes of one block state held in memory, the same estimation is used by fork database
+int64_t estimate_block_bytes(const block_state& bs);
+
+}}  // namespace evt::chain
@@ -5,6 +5,10 @@
 #pragma once
 #include <evt/chain/types.hpp>
 
+namespace boost { namespace asio {
+class thread_pool;
+}}  // namespace boost::asio
+
 namespace evt { namespace chain {
 
    digest_type make_canonical_left(const digest_type& val);
@@ -20,7 +24,8 @@ namespace evt { namespace chain {
 
    /**
     *  Calculates the merkle root of a set of digests, if ids is odd it will duplicate the last id.
+    *  Large levels are hashed in parallel when a thread pool is provided.
     */
-   digest_type merkle( vector<digest_type> ids );
+   digest_type merkle( vector<digest_type> ids, boost::asio::thread_pool* pool = nullptr );
 
 } } /// evt::chain
@@ -10,6 +10,7 @@
 #include <vector>
 #include <fmt/format.h>
 #include <fc/reflect/reflect.hpp>
+#include <fc/io/raw_fwd.hpp>
 
 namespace evt { namespace chain {
 using std::string;
@@ -190,3 +191,4 @@ struct formatter<evt::chain::name> {
 }  // namespace fmt
 
 FC_REFLECT(evt::chain::name, (value));
+FC_REFLECT_TRIVIALLY_PACKABLE(evt::chain::name);
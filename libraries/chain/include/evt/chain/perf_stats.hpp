@@ -0,0 +1,138 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+*/
+#pragma once
+#include <array>
+#include <chrono>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/variant.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace evt { namespace chain {
+
+enum class perf_phase {
+    start_block = 0,
+    trx_init,
+    trx_recover,
+    trx_auth,
+    trx_apply,
+    finalize_block,
+    commit_block,
+    pop_savepoints,
+    fork_db,
+    max_value = fork_db
+};
+
+/**
+ *  Always-on time counters of the controller phases, fed by `perf_marker`.
+ *  Time is taken from TSC where it's available, and markers never allocate.
+ *
+ *  Totals of each phase within one block are collected into histograms when the block is committed.
+ *  Phases can be nested, like `pop_savepoints` and `fork_db` within `commit_block`, so they don't sum up.
+ *  Spans of the recent blocks are kept in a preallocated ring when tracing is enabled,
+ *  and can be dumped in Chrome trace format. Only used from main thread.
+ */
+class perf_stats : boost::noncopyable {
+public:
+    using histogram = token_database_metrics::histogram;
+
+    static constexpr int    kPhasesNum     = (int)perf_phase::max_value + 1;
+    static constexpr size_t kSpansPerBlock = 4096;
+
+    struct span {
+        uint64_t   begin;
+        uint64_t   end;
+        perf_phase phase;
+    };
+
+public:
+    perf_stats();
+
+public:
+    static uint64_t
+    ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // keeps the spans of the last `blocks` blocks, 0 disables tracing
+    void set_trace_blocks(uint32_t blocks);
+
+    void
+    add(perf_phase phase, uint64_t begin, uint64_t end) {
+        block_ticks_[(int)phase] += end - begin;
+        block_counts_[(int)phase]++;
+        if(!spans_.empty()) {
+            spans_[spans_next_++ % spans_.size()] = span { begin, end, phase };
+        }
+    }
+
+    // phases since last committed block, including the ones of aborted blocks, are counted into this one
+    void commit_block(uint32_t block_num);
+
+    uint32_t trace_blocks() const { return trace_blocks_; }
+    uint64_t blocks() const { return blocks_num_; }
+
+    const histogram& phase(perf_phase p) const { return phases_[(int)p]; }
+    static const char* phase_name(perf_phase p);
+
+    fc::variant to_variant() const;
+    // trace events of the last `blocks` blocks, which 'chrome://tracing' can load
+    fc::variant chrome_trace(uint32_t blocks) const;
+
+private:
+    double us_per_tick() const;
+
+private:
+    std::array<uint64_t, kPhasesNum>  block_ticks_  = {};
+    std::array<uint32_t, kPhasesNum>  block_counts_ = {};
+    std::array<histogram, kPhasesNum> phases_;
+
+    uint64_t blocks_num_ = 0;
+    uint32_t last_block_ = 0;
+
+    // time base to convert ticks
+    uint64_t                              tick0_;
+    std::chrono::steady_clock::time_point time0_;
+
+    struct block_mark {
+        uint32_t block_num;
+        size_t   spans_end;
+    };
+
+    uint32_t                trace_blocks_ = 0;
+    std::vector<span>       spans_;
+    size_t                  spans_next_ = 0;
+    std::vector<block_mark> marks_;  // ring of the ends of recent blocks
+    size_t                  marks_next_ = 0;
+};
+
+// adds the time of its lifetime to `phase` of stats
+class perf_marker : boost::noncopyable {
+public:
+    perf_marker(perf_stats& stats, perf_phase phase)
+        : stats_(stats)
+        , phase_(phase)
+        , begin_(perf_stats::ticks()) {}
+
+    ~perf_marker() {
+        stats_.add(phase_, begin_, perf_stats::ticks());
+    }
+
+private:
+    perf_stats& stats_;
+    perf_phase  phase_;
+    uint64_t    begin_;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,111 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+*/
+#pragma once
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace chain {
+
+// keeps the freed blocks of one size for reusing
+// blocks can be freed from any thread, since the objects made from them may be shared out
+class block_pool : boost::noncopyable {
+public:
+    block_pool(size_t max_size)
+        : block_size_(0)
+        , max_size_(max_size) {}
+
+    ~block_pool() {
+        for(auto b : free_) {
+            ::operator delete(b);
+        }
+    }
+
+public:
+    void*
+    allocate(size_t size) {
+        {
+            auto lock = std::lock_guard<std::mutex>(mutex_);
+            if(block_size_ == 0) {
+                block_size_ = size;
+            }
+            if(size == block_size_ && !free_.empty()) {
+                auto b = free_.back();
+                free_.pop_back();
+                return b;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void
+    deallocate(void* b, size_t size) {
+        {
+            auto lock = std::lock_guard<std::mutex>(mutex_);
+            if(size == block_size_ && free_.size() < max_size_) {
+                free_.emplace_back(b);
+                return;
+            }
+        }
+        ::operator delete(b);
+    }
+
+    size_t free_size() const { return free_.size(); }
+
+private:
+    std::mutex         mutex_;
+    size_t             block_size_;
+    size_t             max_size_;
+    std::vector<void*> free_;
+};
+
+// allocator over `block_pool` used with `std::allocate_shared`, so that both the object and
+// the control block of shared pointer are taken from pool
+template<typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    template<typename U>
+    friend class pool_allocator;
+
+public:
+    explicit pool_allocator(std::shared_ptr<block_pool> pool)
+        : pool_(std::move(pool)) {}
+
+    template<typename U>
+    pool_allocator(const pool_allocator<U>& rhs)
+        : pool_(rhs.pool_) {}
+
+public:
+    T*
+    allocate(size_t n) {
+        return (T*)pool_->allocate(n * sizeof(T));
+    }
+
+    void
+    deallocate(T* p, size_t n) {
+        pool_->deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool
+    operator==(const pool_allocator<U>& rhs) const {
+        return pool_ == rhs.pool_;
+    }
+
+    template<typename U>
+    bool
+    operator!=(const pool_allocator<U>& rhs) const {
+        return pool_ != rhs.pool_;
+    }
+
+private:
+    std::shared_ptr<block_pool> pool_;
+};
+
+}}  // namespace evt::chain
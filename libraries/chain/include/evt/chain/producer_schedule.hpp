@@ -3,7 +3,9 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <memory>
 #include <chainbase/chainbase.hpp>
+#include <fc/reflect/variant.hpp>
 #include <evt/chain/config.hpp>
 #include <evt/chain/types.hpp>
 
@@ -100,8 +102,73 @@ operator!=(const producer_schedule_type& a, const producer_schedule_type& b) {
     return !(a == b);
 }
 
+/**
+ *  Producer schedule which is never changed once made, block header states share the same one
+ *  until a new schedule is set or promoted, so making the next state doesn't copy the schedules.
+ */
+class immutable_schedule {
+public:
+    immutable_schedule() : schedule_(empty()) {}
+    immutable_schedule(producer_schedule_type schedule)
+        : schedule_(std::make_shared<const producer_schedule_type>(std::move(schedule))) {}
+
+    // moving copies the pointer as well, so it's never null
+    immutable_schedule(const immutable_schedule&) = default;
+    immutable_schedule& operator=(const immutable_schedule&) = default;
+
+public:
+    const producer_schedule_type& get() const { return *schedule_; }
+    const producer_schedule_type& operator*() const { return *schedule_; }
+    const producer_schedule_type* operator->() const { return schedule_.get(); }
+
+    operator const producer_schedule_type&() const { return *schedule_; }
+
+private:
+    static const std::shared_ptr<const producer_schedule_type>&
+    empty() {
+        static const auto e = std::make_shared<const producer_schedule_type>();
+        return e;
+    }
+
+private:
+    std::shared_ptr<const producer_schedule_type> schedule_;
+};
+
 }}  // namespace evt::chain
 
 FC_REFLECT(evt::chain::producer_key, (producer_name)(block_signing_key));
 FC_REFLECT(evt::chain::producer_schedule_type, (version)(producers));
 FC_REFLECT(evt::chain::shared_producer_schedule_type, (version)(producers));
+
+namespace fc {
+
+inline void
+to_variant(const evt::chain::immutable_schedule& s, fc::variant& v) {
+    to_variant(*s, v);
+}
+
+inline void
+from_variant(const fc::variant& v, evt::chain::immutable_schedule& s) {
+    auto schedule = evt::chain::producer_schedule_type();
+    from_variant(v, schedule);
+    s = std::move(schedule);
+}
+
+namespace raw {
+
+template<typename Stream>
+inline void
+pack(Stream& s, const evt::chain::immutable_schedule& sch) {
+    fc::raw::pack(s, *sch);
+}
+
+template<typename Stream>
+inline void
+unpack(Stream& s, evt::chain::immutable_schedule& sch) {
+    auto schedule = evt::chain::producer_schedule_type();
+    fc::raw::unpack(s, schedule);
+    sch = std::move(schedule);
+}
+
+}  // namespace raw
+}  // namespace fc
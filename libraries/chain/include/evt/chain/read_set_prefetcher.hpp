@@ -0,0 +1,55 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <boost/noncopyable.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+
+namespace evt { namespace chain {
+
+class token_database;
+
+/**
+ *  Loads the keys which upcoming transactions will read into block cache of token database on its own
+ *  thread, so the thread executing them finds the values in memory instead of waiting for I/O.
+ *  Read sets are declared by `action_access` from action data, symbol-wide and global keys are skipped.
+ *
+ *  Only block cache is warmed, token_database_cache is only touched by the thread executing transactions.
+ */
+class read_set_prefetcher : boost::noncopyable {
+public:
+    // at most `max_pending` transactions are waiting, the older ones are dropped when it's full
+    read_set_prefetcher(const token_database& db, size_t max_pending);
+    ~read_set_prefetcher();
+
+public:
+    // transactions are only hints, ones failed to be resolved are ignored
+    void add(const transaction_metadata_ptr& trx);
+    void stop();
+
+    uint64_t prefetched_keys() const { return prefetched_keys_; }
+
+private:
+    void run();
+    void prefetch(const transaction& trx);
+
+private:
+    const token_database& db_;
+    size_t                max_pending_;
+
+    std::mutex                           mutex_;
+    std::condition_variable              cond_;
+    std::deque<transaction_metadata_ptr> trxs_;
+    bool                                 stopped_ = false;
+
+    std::atomic<uint64_t> prefetched_keys_ = 0;
+    std::thread           thread_;
+};
+
+}}  // namespace evt::chain
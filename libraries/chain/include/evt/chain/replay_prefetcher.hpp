@@ -0,0 +1,90 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <evt/chain/block.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+
+namespace evt { namespace chain {
+
+class block_log;
+
+// one block read ahead and its input transactions, keys of them are recovered if needed
+struct prefetched_block {
+    signed_block_ptr                      block;
+    std::vector<transaction_metadata_ptr> trxs;
+};
+
+/**
+ *  Reads the blocks of block log ahead of replaying them, in stages running on their own threads:
+ *  the reader thread reads (and decompresses) and unpacks the blocks, the recovering thread recovers
+ *  the signing keys of their transactions on the thread pool. Stages are connected by the queues of
+ *  at most `max_size` blocks, so the thread applying blocks never waits for I/O or deserialization
+ *  as long as it's the slowest stage.
+ */
+class replay_prefetcher : boost::noncopyable {
+public:
+    // tells if the keys of transactions in the block are checked when it's applied
+    using need_keys_func = std::function<bool(uint32_t block_num)>;
+
+public:
+    replay_prefetcher(const block_log& blog, uint32_t start_num, size_t max_size, boost::asio::thread_pool& pool,
+                      const chain_id_type& chain_id, uint32_t parallel_sigs, need_keys_func need_keys);
+    ~replay_prefetcher();
+
+public:
+    // blocks are returned in order, empty one is returned when there are no more blocks
+    // errors of the stages are thrown here after the blocks prefetched before them
+    prefetched_block next();
+    void             stop();
+
+private:
+    class queue {
+    public:
+        queue(size_t max_size) : max_size_(max_size) {}
+
+    public:
+        bool push(prefetched_block&& b);
+        bool pop(prefetched_block& b);
+
+        // no more blocks are pushed, the ones left can still be popped
+        void close(std::exception_ptr error = nullptr);
+        // pushing and popping both fail from now on
+        void abort();
+
+        std::exception_ptr error() const;
+
+    private:
+        size_t max_size_;
+
+        mutable std::mutex           mutex_;
+        std::condition_variable      not_empty_;
+        std::condition_variable      not_full_;
+        std::deque<prefetched_block> blocks_;
+        std::exception_ptr           error_;
+        bool                         closed_  = false;
+        bool                         aborted_ = false;
+    };
+
+private:
+    void read(const block_log& blog, uint32_t start_num);
+    void recover(boost::asio::thread_pool& pool, const chain_id_type& chain_id, uint32_t parallel_sigs, const need_keys_func& need_keys);
+
+private:
+    queue unpacked_;
+    queue recovered_;
+
+    std::thread reader_;
+    std::thread recoverer_;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,70 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <string_view>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block.hpp>
+
+namespace evt { namespace chain {
+
+namespace detail {
+class reversible_block_log_impl;
+}
+
+/* Reversible blocks are kept in one memory mapped file used as a ring buffer, blocks are appended
+    * at the head and dropped from the tail once they become irreversible, which only moves the number
+    * of the first block.
+    *
+    * +--------+--------------------------------------+--------------------------------------+
+    * | Header | Slot of Block (num % index_size) ... | Data ring of packed blocks ...       |
+    * +--------+--------------------------------------+--------------------------------------+
+    *
+    * Slots hold the logical positions of blocks, the logical position only grows and the physical one
+    * is it modulo the size of data ring. One block never wraps around the end of ring, the space left
+    * there is skipped instead.
+    *
+    * The file is marked dirty when opened for writing and clean after it's closed, dirty file is only
+    * opened when it's explicitly allowed, see chain_plugin::recover_reversible_blocks.
+    */
+class reversible_block_log : boost::noncopyable {
+public:
+    enum class open_mode { read_only, read_write };
+
+public:
+    // `data_size` is only used when the file is created or it's opened for writing,
+    // blocks in the file are moved into the new ring if the size is changed
+    reversible_block_log(const fc::path& dir, open_mode mode, uint64_t data_size = 0, bool allow_dirty = false);
+    ~reversible_block_log();
+
+public:
+    // block must be the next one of the last block, or any block when log is empty
+    void append(uint32_t block_num, std::string_view packed_block);
+    void append(const signed_block_ptr& b);
+    // removes the last block if it's `block_num`
+    void pop(uint32_t block_num);
+    // removes all the blocks up to and including `block_num`
+    void prune(uint32_t block_num);
+    void clear();
+    void flush();
+
+    // empty view if block is not in the log
+    std::string_view read_packed_block(uint32_t block_num) const;
+    signed_block_ptr read_block(uint32_t block_num) const;
+
+    bool     empty() const;
+    // range of blocks in log, both are equal if log is empty
+    uint32_t first_block_num() const;
+    uint32_t end_block_num() const;
+    uint64_t free_size() const;
+
+    static bool exists(const fc::path& dir);
+    static fc::path file_path(const fc::path& dir);
+
+private:
+    std::unique_ptr<detail::reversible_block_log_impl> my;
+};
+
+}}  // namespace evt::chain
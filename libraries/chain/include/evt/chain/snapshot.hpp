@@ -4,10 +4,14 @@
  */
 #pragma once
 
+#include <deque>
+#include <future>
 #include <ostream>
 #include <optional>
+#include <sstream>
 #include <evt/chain/database_utils.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <evt/utilities/rate_limiter.hpp>
 #include <fc/variant_object.hpp>
 #include <boost/core/demangle.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -19,8 +23,10 @@ namespace evt { namespace chain {
  * Version 2: Token database upgrades to binary format
  * Version 3: Postgres upgrades to binary format and use zlib compress stream
  * Version 4: Add seq to postgres and execution context to global property object
+ * Version 5: Binary snapshot uses zstd frames for sections and has a directory of sections at the end
  */
-static const uint32_t current_snapshot_version = 4;
+static const uint32_t current_snapshot_version = 5;
+static const uint32_t minimal_snapshot_version = 4;
 
 namespace detail {
 template <typename T>
@@ -463,24 +469,64 @@ private:
     std::vector<section_index> section_indexes;
 };
 
+/**
+ * Rows of one section are split into zstd frames of about `frame_size` bytes, which are compressed
+ * on other threads while the following rows and sections are written. Frames are written in order,
+ * and `finalize` writes the directory of sections after all of them:
+ *
+ * +--------+---------+---------+-----+-----------+-----------+---------+
+ * | Header | Frames  | Frames  | ... | Directory | Pos of    | Magic   |
+ * |        | of Sec1 | of Sec2 |     |           | Directory | Number  |
+ * +--------+---------+---------+-----+-----------+-----------+---------+
+ */
 class ostream_snapshot_writer : public snapshot_writer {
 public:
     explicit ostream_snapshot_writer(std::ostream& snapshot);
+    ~ostream_snapshot_writer();
 
     void write_start_section(const std::string& section_name) override;
     void write_row(const detail::abstract_snapshot_row_writer& row_writer) override;
     void write_end_section() override;
+    // writes the packed rows read by `istream_snapshot_reader::read_raw_section` without decoding them
+    void write_raw_section(const std::string& section_name, const std::string& data, uint64_t row_count);
+    // snapshot is only readable after it's finalized, it's called by destructor if not called before
     void finalize();
+    // throttles the frames written into stream, it should be set before any section is written
+    void set_rate_limiter(std::shared_ptr<utilities::rate_limiter> limiter);
 
     static const uint32_t magic_number = 0x30510550;
+    static const size_t   frame_size   = 4 * 1024 * 1024;
+
+private:
+    struct section_entry {
+        std::string name;
+        uint64_t    pos;
+        uint64_t    size;
+        uint64_t    row_count;
+    };
+
+    struct pending_frame {
+        std::future<std::string> data;
+        size_t                   section;
+    };
+
+private:
+    void submit_frame();
+    void write_frames(size_t max_pending);
 
 private:
     detail::ostream_wrapper                            snapshot;
     std::optional<boost::iostreams::filtering_ostream> row_stream;
 
-    std::streampos          header_pos;
-    std::streampos          section_pos;
-    uint64_t                row_count;
+    std::streampos             header_pos;
+    std::string                frame;  // rows not compressed yet of current section
+    std::deque<pending_frame>  frames;
+    std::vector<section_entry> sections;
+    size_t                     max_frames;
+
+    std::shared_ptr<utilities::rate_limiter> limiter;
+    bool                       in_section;
+    bool                       finalized;
 };
 
 class istream_snapshot_reader : public snapshot_reader {
@@ -505,19 +551,45 @@ public:
     bool eof() override;
     void clear_section() override;
 
+    // reads all the packed rows of section into `data`, returns the number of rows
+    uint64_t read_raw_section(const string& section_name, std::string& data);
+
 private:
     void build_section_indexes() override;
+    void build_section_indexes_v4();
     bool validate_section() const;
 
     std::istream&                                      snapshot;
     std::optional<boost::iostreams::filtering_istream> row_stream;
 
     std::streampos             header_pos;
+    uint32_t                   version;
     uint64_t                   num_rows;
     uint64_t                   cur_row;
     std::vector<section_index> section_indexes;
 };
 
+// keeps the packed rows in memory, they're written into another writer later and maybe on another thread
+class buffered_snapshot_writer : public snapshot_writer {
+public:
+    void write_start_section(const std::string& section_name) override;
+    void write_row(const detail::abstract_snapshot_row_writer& row_writer) override;
+    void write_end_section() override;
+
+    void write_to(snapshot_writer& writer) const;
+
+private:
+    struct section {
+        std::string         name;
+        std::string         data;
+        std::vector<size_t> row_ends;
+    };
+
+private:
+    std::vector<section>               sections;
+    std::optional<std::ostringstream> row_stream;
+};
+
 class integrity_hash_snapshot_writer : public snapshot_writer {
 public:
     explicit integrity_hash_snapshot_writer(fc::sha256::encoder& enc);
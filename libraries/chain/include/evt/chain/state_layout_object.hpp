@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <evt/chain/multi_index_includes.hpp>
+#include <evt/chain/types.hpp>
+
+namespace evt { namespace chain {
+/**
+ *  @brief records the version of the layout of the indices in chain state
+ *  @ingroup object
+ *
+ *  Indices of chain state are found by the names of their objects when the state is opened,
+ *  so changing the container of one index makes the state written before read with the new layout.
+ *  The version is bumped with each of such changes and the state of other versions is refused.
+ *  It's not a part of snapshots, it's created along with the state.
+ */
+class state_layout_object : public chainbase::object<state_layout_object_type, state_layout_object> {
+    OBJECT_CTOR(state_layout_object)
+
+    /**
+     * Version history
+     *   1: hashed `by_trx_id` and non-unique `by_expiration` indices of transaction_object
+     */
+    static constexpr uint32_t current_version = 1;
+
+    id_type  id;
+    uint32_t version = current_version;
+};
+
+using state_layout_multi_index = chainbase::shared_multi_index_container<
+    state_layout_object,
+    indexed_by<
+        ordered_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER(state_layout_object, state_layout_object::id_type, id)>>>;
+
+typedef chainbase::generic_index<state_layout_multi_index> state_layout_index;
+
+}}  // namespace evt::chain
+
+CHAINBASE_SET_INDEX_TYPE(evt::chain::state_layout_object, evt::chain::state_layout_multi_index);
+FC_REFLECT(evt::chain::state_layout_object, (version));
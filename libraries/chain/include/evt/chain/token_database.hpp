@@ -4,13 +4,18 @@
 */
 #pragma once
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/signals2/signal.hpp>
 #include <fc/reflect/reflect.hpp>
+#include <fc/crypto/sha256.hpp>
 #include <fc/filesystem.hpp>
+#include <rocksdb/slice.h>
 #include <evt/chain/types.hpp>
 #include <evt/chain/asset.hpp>
 #include <evt/chain/address.hpp>
@@ -18,7 +23,7 @@
 
 namespace rocksdb {
 class DB;
-class Slice;
+class Snapshot;
 }  // namespace rocksdb
 
 namespace evt { namespace chain {
@@ -27,7 +32,22 @@ using read_value_func = std::function<bool(const std::string_view& key, std::str
 
 enum class storage_profile {
     disk   = 0,
-    memory = 1
+    memory = 1,
+    hybrid = 2   // disk profile with an in-process tier of the frequently written keys
+};
+
+enum class sync_policy {
+    always = 0,  // sync all the writes
+    commit,      // only sync when irreversible savepoints are committed and rollbacks are written
+    none         // never sync, leave it to the OS
+};
+
+// rocksdb options sized from detected cores, memory and disk type for the role of node
+enum class tuning_profile {
+    none = 0,  // rocksdb defaults
+    producer,  // low latency of applying blocks
+    api,       // reads served alongside writes
+    archive    // throughput of replaying and indexing long histories
 };
 
 enum class token_type {
@@ -121,7 +141,27 @@ extract_db_value(const std::string& str, T& v) {
     fc::raw::unpack(ds, v);
 }
 
+// unpacks from the value pinned by database directly, see `read_token` with `PinnableSlice`
+template<typename T>
+void
+extract_db_value(const rocksdb::Slice& slice, T& v) {
+    auto ds = fc::datastream<const char*>(slice.data(), slice.size());
+    fc::raw::unpack(ds, v);
+}
+
+class token_database_impl;
+class token_database_ingester;
+class token_database_metrics;
+
 using token_keys_t = small_vector<name128, 4>;
+using asset_key_t  = std::pair<address, symbol_id_type>;
+
+// one row changed in a savepoint, keys are the ones in database, the same as the ones in snapshots
+struct token_delta {
+    token_type  type;
+    std::string key;
+    std::string value;
+};
 
 class token_database : boost::noncopyable {
 public:
@@ -129,8 +169,46 @@ public:
         storage_profile profile           = storage_profile::disk;
         uint32_t        block_cache_size  = 256 * 1024 * 1024; // 256M
         uint32_t        object_cache_size = 256 * 1024 * 1024; // 256M
+        uint32_t        hot_tier_size     = 128 * 1024 * 1024; // 128M, only used in hybrid profile
         fc::path        db_path           = ::evt::chain::config::default_token_database_dir_name;
         bool            enable_stats      = true;
+        // count accesses by token type and by action with their latencies, it costs a timer for each access
+        bool            metrics           = false;
+        // store hot token types(token, fungible and evtlink) in their own column families
+        // existed database will be migrated once it's opened with this layout
+        bool            separated_layout  = false;
+        // restore from snapshot by ingesting sst files instead of putting rows one by one
+        bool            snapshot_ingest   = false;
+        // without WAL, unflushed writes are lost when crashed and database should be rebuilt by replaying block log
+        bool            disable_wal       = false;
+        sync_policy     sync              = sync_policy::commit;
+        // maintain a running hash over all the rows, updated on each write and restored when rolling back
+        bool            state_hash        = false;
+        // keep a bloom filter of all the evtlinks in memory, lookups of links not paid yet skip rocksdb
+        bool            evtlink_filter    = false;
+        // keep an index from owner addresses to their tokens, it's built once enabled on existed database
+        bool            owner_index       = false;
+        // keep an index from addresses to their balances of all the symbols, it's built once enabled on existed database
+        bool            balance_index     = false;
+        // write derived state (state hash and evtlink filter) on clean close and load it on next open
+        // instead of scanning the whole database, it's only used when database is not changed in between
+        bool            fast_restart      = false;
+        // number of most recently used keys of object cache recorded into a file, which are prefetched
+        // into block cache in background on next open, 0 disables it
+        uint32_t        warmup_keys       = 0;
+        // number of the most frequently read and written keys reported for each token type, 0 disables it
+        // frequencies are estimated by a count-min sketch of fixed memory over a sliding window
+        uint32_t        hot_keys          = 0;
+        uint32_t        hot_keys_window   = 600; // seconds
+        // paid evtlinks older than it are dropped in compactions, they're rejected by their timestamps anyway
+        // it's never less than twice of `evt_link_expired_secs`, 0 keeps all of them
+        uint32_t        evtlink_ttl       = 0;   // seconds
+        // open the database of a primary process in read-only mode, all the writes are rejected
+        // it's a view of the rows committed by primary when it's opened, see `token_database_replica`
+        bool            read_replica      = false;
+        tuning_profile  tuning            = tuning_profile::none;
+        // rocksdb OPTIONS file applied after tuning, empty to not load it
+        fc::path        options_file;
     };
 
     class session {
@@ -178,6 +256,62 @@ public:
         int             _accept;
     };
 
+    // read-only view of the database pinned to the state when it's created
+    // views are immutable and safe to be read concurrently from other threads
+    // token values are served from a rocksdb snapshot, pending asset values are copied from write cache
+    class read_view : boost::noncopyable {
+    public:
+        ~read_view();
+
+    public:
+        int read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw = false) const;
+        int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
+
+        // batched version of read_token & read_asset, values of keys not found are left empty in `outs`
+        int read_tokens(token_type type, const std::optional<name128>& domain, const small_vector_base<name128>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+        int read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+
+        int read_tokens_range(token_type type, const std::optional<name128>& domain, int skip, const read_value_func& func) const;
+        int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+        // seeks to the key right after `after` instead of skipping, for paginating by the last key read
+        int read_tokens_range_after(token_type type, const std::optional<name128>& domain, const name128& after, const read_value_func& func) const;
+        int read_tokens_by_owner(const address& owner, int skip, const read_value_func& func) const;
+        int read_assets_by_address(const address& addr, const read_value_func& func) const;
+
+        std::string get_db_key(token_type type, const std::optional<name128>& domain, const name128& key) const;
+
+    private:
+        read_view(const token_database_impl& db);
+
+    private:
+        const token_database_impl&                   db_;
+        const rocksdb::Snapshot*                     snapshot_;
+        std::unordered_map<std::string, std::string> pending_assets_;
+
+        friend class token_database_impl;
+    };
+
+    // bulk loader which writes sorted rows into sst files and ingests them into database, memtable and WAL are bypassed
+    // rows are invisible until `finish` is called, later put of the same key overrides the former one
+    class ingester : boost::noncopyable {
+    public:
+        ~ingester();
+
+    public:
+        void put_token(token_type type, const std::optional<name128>& domain, const name128& key, const std::string_view& data);
+        void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
+
+        void finish();
+
+    private:
+        ingester(token_database_impl& db);
+
+    private:
+        std::unique_ptr<token_database_ingester> my_;
+
+        friend class token_database_impl;
+    };
+
 public:
     token_database(const config&);
     ~token_database();
@@ -189,6 +323,9 @@ public:
 public:
     void put_token(token_type type, action_op op, const std::optional<name128>& domain, const name128& key, const std::string_view& data);
     void put_tokens(token_type type, action_op op, const std::optional<name128>& domain, token_keys_t&& keys, const small_vector_base<std::string_view>& data);
+    // appends serialized `item` to the vector at `pos` of the existing value which has `size` items, it's one update action.
+    // only the item is written and it's merged into the value by rocksdb, used by the metas at the end of large tokens
+    void append_token(token_type type, const std::optional<name128>& domain, const name128& key, uint32_t pos, uint32_t size, const std::string_view& item);
     void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
 
     int exists_token(token_type type, const std::optional<name128>& domain, const name128& key) const;
@@ -197,17 +334,71 @@ public:
     int read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw = false) const;
     int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
 
+    // values are pinned in block cache, memtable or write cache instead of being copied into string
+    // `out` should be released or reset before database is changed
+    int read_token(token_type type, const std::optional<name128>& domain, const name128& key, rocksdb::PinnableSlice& out, bool no_throw = false) const;
+    int read_asset(const address& addr, const symbol_id_type sym_id, rocksdb::PinnableSlice& out, bool no_throw = false) const;
+
+    // batched version of read_token & read_asset, values of keys not found are left empty in `outs`
+    // returns the number of keys found
+    int read_tokens(token_type type, const std::optional<name128>& domain, const small_vector_base<name128>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+    int read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+
     int read_tokens_range(token_type type, const std::optional<name128>& domain, int skip, const read_value_func& func) const;
+    // seeks to the key right after `after` instead of skipping, for paginating by the last key read
+    int read_tokens_range_after(token_type type, const std::optional<name128>& domain, const name128& after, const read_value_func& func) const;
+    // pending values in write cache are merged while scanning, nothing is written into database
     int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+    // tokens owned by `owner` in any domain, keys passed to `func` are domain followed by name
+    // only available when `owner_index` is enabled
+    int read_tokens_by_owner(const address& owner, int skip, const read_value_func& func) const;
+    // balances of `addr` of all the symbols in the order of symbol ids, keys passed to `func` are the symbol ids
+    // only available when `balance_index` is enabled
+    int read_assets_by_address(const address& addr, const read_value_func& func) const;
+
+    // values are read only to be loaded into block cache, returns the number of keys found
+    // tokens are (prefix, key) where prefix is the domain of tokens or reserved prefix of other types
+    // it's safe to be called from other threads, it never touches the pending values and hot tier
+    size_t prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const;
+
+    // same as `read_assets_range` but served from in-memory holders index instead of scanning database
+    // index of one symbol is built with one full scan at the first time and maintained incrementally after that
+    int read_assets_holders(const symbol_id_type sym_id, const read_value_func& func) const;
+    // builds the holders index of one symbol if it isn't built yet, returns the number of persisted holders
+    // index is only a cache of persisted balances, warming it keeps the full scan out of applying actions
+    size_t warm_assets_holders(const symbol_id_type sym_id) const;
+    // holders of one symbol ordered by amount in descending order, then by key, `skip` holders are skipped
+    // ranks of one symbol are built from the holders index at the first time, so each page costs O((skip + k) log n)
+    int read_assets_top_holders(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+
+public:
+    // should be called from the thread writing database and when there's no pending changes
+    // views should be released before database is closed
+    std::shared_ptr<read_view> new_read_view() const;
+
+    // returns db keys of tokens changed since last call, tracking is started at the first call
+    std::vector<std::string> pop_dirty_keys();
+
+    // version of token which is bumped whenever it's written or rolled back, for caching results derived from tokens
+    // tokens are striped into a fixed table, so unrelated ones may share one version and only cause false mismatches
+    uint32_t token_version(token_type type, const std::optional<name128>& domain, const name128& key) const;
+
+    // only used for restoring database from snapshot when there's no savepoints
+    std::unique_ptr<ingester> new_ingester();
 
 public:
     void add_savepoint(int64_t seq);
     void rollback_to_latest_savepoint();
+    // assets of popped savepoints stay in write cache and are committed in one batch
+    // when next savepoint is added or database is closed, so one LIB advance becomes one write
     void pop_savepoints(int64_t until);
     void pop_back_savepoint();
     void squash();
 
     int64_t latest_savepoint_seq() const;
+    // rows changed since latest savepoint with their current values, each key is reported once
+    // rows are never removed except by rolling back, so there're no deleted ones
+    std::vector<token_delta> latest_savepoint_deltas() const;
 
     session new_savepoint_session(int64_t seq);
     session new_savepoint_session();
@@ -216,6 +407,21 @@ public:
 
 public:
     std::string stats() const;
+    // numeric properties of rocksdb, like sizes of memtables and sst files, by the names without "rocksdb." prefix
+    std::map<std::string, uint64_t> int_stats() const;
+    // returns nullptr if metrics are not enabled
+    token_database_metrics* metrics() const;
+
+    // order-independent hash of all the rows in database, pending assets in write cache are included
+    // it's O(1) when `state_hash` is enabled in config, otherwise the whole database is scanned
+    fc::sha256 state_hash() const;
+    bool state_hash_enabled() const;
+
+    // keys read and written most frequently in recent window for each type, null if `hot_keys` is not enabled
+    fc::variant hot_keys() const;
+
+    // evtlinks paid before `block_num` are dropped by following compactions, only used when `evtlink_ttl` is enabled
+    void prune_evtlinks_before(uint32_t block_num);
 
 private:
     void flush() const;
@@ -224,6 +430,10 @@ private:
 
 private:  // for cache usage
     std::string get_db_key(token_type type, const std::optional<name128>& domain, const name128& key);
+
+    // writes db keys of tokens, most recently used first, into the warm keys file, which is read on next open
+    void persist_warm_keys(const std::vector<std::string>& keys) const;
+
     boost::signals2::signal<void(const rocksdb::Slice&)> rollback_token_value;
     boost::signals2::signal<void(const rocksdb::Slice&)> remove_token_value;
 
@@ -235,4 +445,8 @@ private:
 
 }}  // namespace evt::chain
 
-FC_REFLECT(evt::chain::token_database::config, (profile)(block_cache_size)(object_cache_size)(db_path));
+FC_REFLECT_ENUM(evt::chain::token_type, (asset)(domain)(token)(group)(suspend)(lock)(fungible)(prodvote)(evtlink)(psvbonus)(psvbonus_dist));
+FC_REFLECT(evt::chain::token_delta, (type)(key)(value));
+FC_REFLECT_ENUM(evt::chain::sync_policy, (always)(commit)(none));
+FC_REFLECT_ENUM(evt::chain::tuning_profile, (none)(producer)(api)(archive));
+FC_REFLECT(evt::chain::token_database::config, (profile)(block_cache_size)(object_cache_size)(hot_tier_size)(db_path)(separated_layout)(snapshot_ingest)(disable_wal)(sync)(state_hash));
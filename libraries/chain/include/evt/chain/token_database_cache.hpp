@@ -3,23 +3,35 @@
  *  @copyright defined in evt/LICENSE.txt
 */
 #pragma once
+#include <atomic>
 #include <memory>
+#include <unordered_set>
 #include <boost/type_index.hpp>
 #include <fc/io/datastream.hpp>
 #include <fc/io/raw.hpp>
 #include <rocksdb/cache.h>
 #include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_metrics.hpp>
 
 namespace evt { namespace chain {
 
 class token_database_cache {
 public:
-    token_database_cache(token_database& db, size_t cache_size)
+    // `warmup_keys` most recently read keys can be saved by `save_warm_keys`, 0 disables recording
+    token_database_cache(token_database& db, size_t cache_size, size_t warmup_keys = 0)
         : db_(db)
-        , cache_(rocksdb::NewLRUCache(cache_size)) {
+        , cache_(rocksdb::NewLRUCache(cache_size))
+        , has_derived_(false)
+        , warmup_keys_(warmup_keys)
+        , recent_keys_(warmup_keys * kRecentKeysFactor)
+        , recent_next_(0) {
         watch_db();
     }
 
+private:
+    // ring of recent reads keeps duplicates, so it's larger than the number of keys saved
+    static constexpr size_t kRecentKeysFactor = 4;
+
 private:
     template<typename T>
     struct cache_entry {
@@ -62,6 +74,10 @@ public:
 
         auto k = db_.get_db_key(type, domain, key);
         auto h = cache_->Lookup(k);
+        if(auto m = db_.metrics()) {
+            m->on_cache(type, h != nullptr);
+        }
+        record_key(k);
         if(h != nullptr) {
             auto entry = (cache_entry<T>*)cache_->Value(h);
             EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
@@ -69,16 +85,17 @@ public:
             return std::unique_ptr<T, cache_deleter<T>>(&entry->data, cache_deleter<T>(this, h));
         }
 
-        auto str = std::string();
-        auto r   = db_.read_token(type, domain, key, str, no_throw);
+        // unpacked from the value pinned by database, so a miss doesn't copy it
+        auto v = rocksdb::PinnableSlice();
+        auto r = db_.read_token(type, domain, key, v, no_throw);
         if(no_throw && !r) {
             return nullptr;
         }
 
         auto entry = new cache_entry<T>();
-        extract_db_value(str, entry->data);
+        extract_db_value(v, entry->data);
 
-        auto s = cache_->Insert(k, (void*)entry, str.size(),
+        auto s = cache_->Insert(k, (void*)entry, v.size(),
             [](auto& ck, auto cv) { delete (cache_entry<T>*)cv; }, &h);
         FC_ASSERT(s == rocksdb::Status::OK());
 
@@ -92,6 +109,7 @@ public:
 
         auto k = db_.get_db_key(type, domain, key);
         auto h = cache_->Lookup(k);
+        record_key(k);
         if(h != nullptr) {
             auto entry = (cache_entry<T>*)cache_->Value(h);
             EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
@@ -101,6 +119,33 @@ public:
         return nullptr;
     }
 
+    // compact value `D` derived from token `T` by `derive`, cached next to the token with its own key
+    // it's dropped whenever the token is written, rolled back or removed
+    template<typename T, typename D, typename Func>
+    std::unique_ptr<D, cache_deleter<D>>
+    read_derived(token_type type, const std::optional<name128>& domain, const name128& key, Func&& derive) {
+        static_assert(std::is_class_v<D>, "D should be a class type");
+
+        auto k = derived_key(db_.get_db_key(type, domain, key));
+        auto h = cache_->Lookup(k);
+        if(h != nullptr) {
+            auto entry = (cache_entry<D>*)cache_->Value(h);
+            EVT_ASSERT2(entry->ti == boost::typeindex::type_id<D>(), token_database_cache_exception,
+                "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<D>().pretty_name());
+            return std::unique_ptr<D, cache_deleter<D>>(&entry->data, cache_deleter<D>(this, h));
+        }
+
+        auto entry = std::make_unique<cache_entry<D>>(derive(*read_token<T>(type, domain, key)));
+        has_derived_ = true;
+
+        auto s = cache_->Insert(k, (void*)entry.get(), sizeof(D),
+            [](auto& ck, auto cv) { delete (cache_entry<D>*)cv; }, &h);
+        FC_ASSERT(s == rocksdb::Status::OK());
+
+        auto data = &entry.release()->data;
+        return std::unique_ptr<D, cache_deleter<D>>(data, cache_deleter<D>(this, h));
+    }
+
     template<typename T, bool RtnPTR = false, typename U = std::decay_t<T>>
     std::conditional_t<RtnPTR, std::unique_ptr<U, cache_deleter<U>>, void>
     put_token(token_type type, action_op op, const std::optional<name128>& domain, const name128& key, T&& data)  {
@@ -119,6 +164,9 @@ public:
 
         auto v = make_db_value(data);
         db_.put_token(type, op, domain, key, v.as_string_view());
+        if(has_derived_) {
+            cache_->Erase(derived_key(std::string(k)));
+        }
         
         if(h != nullptr) {
             // if there's already cache item, no need to insert new one
@@ -144,20 +192,313 @@ public:
         }
     }
 
+    // rewrites the owners of many tokens in one batched read and put, `T` is `token_def`.
+    // only the owner field is replaced in serialized values, metas are copied as raw bytes without unpacking
+    template<typename T, typename Owner>
+    void
+    put_token_owners(const name128& domain, const small_vector_base<name128>& names, const Owner& owner) {
+        using entry_t = cache_entry<T>;
+        // domain and name of token are fixed-size and followed by owner
+        constexpr auto kOwnerPos = sizeof(name128) * 2;
+
+        auto olds = small_vector<std::string, 4>();
+        db_.read_tokens(token_type::token, domain, names, olds, true /* no throw */);
+
+        auto packed = fc::raw::pack(owner);
+        auto values = small_vector<std::string, 4>();
+        values.reserve(names.size());
+        for(auto i = 0u; i < names.size(); i++) {
+            auto& old = olds[i];
+            EVT_ASSERT2(!old.empty(), unknown_token_exception, "Cannot find token: {} in {}", names[i], domain);
+
+            auto ds = fc::datastream<const char*>(old.data() + kOwnerPos, old.size() - kOwnerPos);
+            auto o  = Owner();
+            fc::raw::unpack(ds, o);
+
+            values.emplace_back();
+            auto& v = values.back();
+            v.reserve(kOwnerPos + packed.size() + ds.remaining());
+            v.append(old.data(), kOwnerPos);
+            v.append(packed.data(), packed.size());
+            v.append(old.data() + old.size() - ds.remaining(), ds.remaining());
+        }
+
+        // cached ones are updated in place, so pointers held by callers see the new owner
+        for(auto& n : names) {
+            auto k = db_.get_db_key(token_type::token, domain, n);
+            if(auto h = cache_->Lookup(k)) {
+                auto entry = (entry_t*)cache_->Value(h);
+                EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
+                    "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
+                entry->data.owner = owner;
+                cache_->Release(h);
+            }
+            if(has_derived_) {
+                cache_->Erase(derived_key(std::move(k)));
+            }
+        }
+
+        auto data = small_vector<std::string_view, 4>();
+        data.reserve(values.size());
+        for(auto& v : values) {
+            data.emplace_back(v);
+        }
+        db_.put_tokens(token_type::token, action_op::update, domain, token_keys_t(names.cbegin(), names.cend()), data);
+    }
+
+    // writes the meta just appended to `data.metas`, `metas` should be the last serialized field of `T`.
+    // only the new meta is written instead of the whole token, so it stays cheap for the ones with many metas.
+    // like `put_token`, `data` should be the cached one if the token is in cache
+    template<typename T>
+    void
+    append_token_meta(token_type type, const std::optional<name128>& domain, const name128& key, T& data) {
+        using entry_t = cache_entry<T>;
+        assert(!data.metas.empty());
+
+        auto k = db_.get_db_key(type, domain, key);
+        if(auto h = cache_->Lookup(k)) {
+            auto entry = (entry_t*)cache_->Value(h);
+            cache_->Release(h);
+            EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
+                "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
+            EVT_ASSERT2(&entry->data == &data, token_database_cache_exception,
+                "Provided updated data object should be the same as original one in cache");
+        }
+
+        // metas are at the end, so they start at the size of token without them
+        auto pos  = fc::raw::pack_size(data) - fc::raw::pack_size(data.metas);
+        auto item = fc::raw::pack(data.metas.back());
+        db_.append_token(type, domain, key, pos, data.metas.size() - 1, std::string_view(item.data(), item.size()));
+        if(has_derived_) {
+            cache_->Erase(derived_key(std::move(k)));
+        }
+    }
+
+    // charged bytes of the cached tokens, which are the sizes of their serialized values
+    size_t usage() const { return cache_->GetUsage(); }
+
+    // saves the most recently read keys, in the order of last read, into token database
+    // they're prefetched into block cache when database is opened next time
+    void
+    save_warm_keys() const {
+        if(warmup_keys_ == 0) {
+            return;
+        }
+
+        auto seen = std::unordered_set<std::string_view>();
+        auto keys = std::vector<std::string>();
+        auto n    = std::min(recent_next_, recent_keys_.size());
+        for(auto i = 0u; i < n && keys.size() < warmup_keys_; i++) {
+            auto& k = recent_keys_[(recent_next_ - 1 - i) % recent_keys_.size()];
+            if(seen.emplace(k).second) {
+                keys.emplace_back(k);
+            }
+        }
+        db_.persist_warm_keys(keys);
+    }
+
 private:
+    void
+    record_key(const std::string& key) {
+        if(!recent_keys_.empty()) {
+            // strings in ring keep their buffers, so it doesn't allocate after the first round
+            recent_keys_[recent_next_++ % recent_keys_.size()] = key;
+        }
+    }
+
     void
     watch_db() {
         db_.rollback_token_value.connect([this](auto& key) {
             cache_->Erase(key);
+            if(has_derived_) {
+                cache_->Erase(derived_key(key.ToString()));
+            }
         });
         db_.remove_token_value.connect([this](auto& key) {
             cache_->Erase(key);
+            if(has_derived_) {
+                cache_->Erase(derived_key(key.ToString()));
+            }
         });
     }
 
+    // db keys of tokens are fixed-size, so one more byte never collides with them
+    static std::string
+    derived_key(std::string&& key) {
+        key.push_back('\x01');
+        return std::move(key);
+    }
+
 private:
     token_database&                 db_;
     std::shared_ptr<rocksdb::Cache> cache_;
+    bool                            has_derived_;
+
+    size_t                   warmup_keys_;
+    std::vector<std::string> recent_keys_;
+    size_t                   recent_next_;
+};
+
+// cache of token objects shared by the read views of token database
+// it's safe to be used concurrently, cache is sharded to reduce lock contention between readers
+class token_database_view_cache {
+public:
+    using read_view = token_database::read_view;
+
+    token_database_view_cache(size_t cache_size, int num_shard_bits)
+        : cache_(rocksdb::NewLRUCache(cache_size, num_shard_bits))
+        , latest_(nullptr) {}
+
+private:
+    template<typename T>
+    struct cache_entry {
+    public:
+        cache_entry() : ti(boost::typeindex::type_id<T>()) {}
+
+    public:
+        boost::typeindex::type_index ti;
+        T                            data;
+    };
+
+public:
+    template<typename T>
+    struct cache_deleter {
+    public:
+        using entry_t = cache_entry<std::remove_const_t<T>>;
+
+        cache_deleter()
+            : self_(nullptr), handle_(nullptr), entry_(nullptr) {}
+        cache_deleter(token_database_view_cache* self, rocksdb::Cache::Handle* handle)
+            : self_(self), handle_(handle), entry_(nullptr) {}
+        // value is not inserted into cache, deleter owns the entry
+        cache_deleter(entry_t* entry)
+            : self_(nullptr), handle_(nullptr), entry_(entry) {}
+
+    void
+    operator()(T* ptr) {
+        if(entry_ != nullptr) {
+            delete entry_;
+            return;
+        }
+        assert(handle_);
+        self_->cache_->Release(handle_);
+    }
+
+    private:
+        token_database_view_cache* self_;
+        rocksdb::Cache::Handle*    handle_;
+        entry_t*                   entry_;
+    };
+
+public:
+    // drops the values changed since previous view, should be called once new view is published
+    void
+    refresh(const read_view& view, const std::vector<std::string>& dirty_keys) {
+        latest_.store(&view);
+        for(auto& k : dirty_keys) {
+            cache_->Erase(k);
+        }
+    }
+
+    template<typename T>
+    std::unique_ptr<const T, cache_deleter<const T>>
+    read_token(const read_view& view, token_type type, const std::optional<name128>& domain, const name128& key, bool no_throw = false) {
+        static_assert(std::is_class_v<T>, "T should be a class type");
+        using ptr_t = std::unique_ptr<const T, cache_deleter<const T>>;
+
+        auto k = view.get_db_key(type, domain, key);
+        auto h = cache_->Lookup(k);
+        if(h != nullptr) {
+            return from_handle<T>(h);
+        }
+
+        auto str = std::string();
+        auto r   = view.read_token(type, domain, key, str, no_throw);
+        if(no_throw && !r) {
+            return nullptr;
+        }
+        return insert<T>(view, k, str);
+    }
+
+    // batched version of read_token, only the keys missed in cache are read from view in one batch
+    // values not found are null if `no_throw` is set
+    template<typename T>
+    std::vector<std::unique_ptr<const T, cache_deleter<const T>>>
+    read_tokens(const read_view& view, token_type type, const std::optional<name128>& domain, const small_vector_base<name128>& keys, bool no_throw = false) {
+        static_assert(std::is_class_v<T>, "T should be a class type");
+        using ptr_t = std::unique_ptr<const T, cache_deleter<const T>>;
+
+        auto rs      = std::vector<ptr_t>(keys.size());
+        auto misses  = small_vector<name128, 4>();
+        auto indexes = small_vector<size_t, 4>();
+        auto dbkeys  = std::vector<std::string>();
+        for(auto i = 0u; i < keys.size(); i++) {
+            auto k = view.get_db_key(type, domain, keys[i]);
+            auto h = cache_->Lookup(k);
+            if(h != nullptr) {
+                rs[i] = from_handle<T>(h);
+                continue;
+            }
+            misses.emplace_back(keys[i]);
+            indexes.emplace_back(i);
+            dbkeys.emplace_back(std::move(k));
+        }
+
+        if(misses.empty()) {
+            return rs;
+        }
+
+        auto strs = small_vector<std::string, 4>();
+        view.read_tokens(type, domain, misses, strs, no_throw);
+        for(auto i = 0u; i < misses.size(); i++) {
+            if(strs[i].empty()) {
+                continue;
+            }
+            rs[indexes[i]] = insert<T>(view, dbkeys[i], strs[i]);
+        }
+        return rs;
+    }
+
+private:
+    template<typename T>
+    std::unique_ptr<const T, cache_deleter<const T>>
+    from_handle(rocksdb::Cache::Handle* h) {
+        using ptr_t = std::unique_ptr<const T, cache_deleter<const T>>;
+
+        auto entry = (cache_entry<T>*)cache_->Value(h);
+        EVT_ASSERT2(entry->ti == boost::typeindex::type_id<T>(), token_database_cache_exception,
+            "Types are not matched between cache({}) and query({})", entry->ti.pretty_name(), boost::typeindex::type_id<T>().pretty_name());
+        return ptr_t(&entry->data, cache_deleter<const T>(this, h));
+    }
+
+    template<typename T>
+    std::unique_ptr<const T, cache_deleter<const T>>
+    insert(const read_view& view, const std::string& k, const std::string& str) {
+        using ptr_t = std::unique_ptr<const T, cache_deleter<const T>>;
+
+        auto entry = new cache_entry<T>();
+        extract_db_value(str, entry->data);
+
+        // values from stale views are not cached
+        // check again after inserting in case one new view is published concurrently
+        if(latest_.load() != &view) {
+            return ptr_t(&entry->data, cache_deleter<const T>(entry));
+        }
+
+        auto h = (rocksdb::Cache::Handle*)nullptr;
+        auto s = cache_->Insert(k, (void*)entry, str.size(),
+            [](auto& ck, auto cv) { delete (cache_entry<T>*)cv; }, &h);
+        FC_ASSERT(s == rocksdb::Status::OK());
+
+        if(latest_.load() != &view) {
+            cache_->Erase(k);
+        }
+        return ptr_t(&entry->data, cache_deleter<const T>(this, h));
+    }
+
+private:
+    std::shared_ptr<rocksdb::Cache> cache_;
+    std::atomic<const read_view*>   latest_;
 };
 
 template<typename T>
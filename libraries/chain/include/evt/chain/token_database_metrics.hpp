@@ -0,0 +1,222 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+*/
+#pragma once
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <fc/variant_object.hpp>
+#include <evt/chain/types.hpp>
+#include <evt/chain/token_database.hpp>
+
+namespace evt { namespace chain {
+
+// counters of token database accesses, split by token type and by the action which is being applied
+// only updated from the thread writing database
+class token_database_metrics : boost::noncopyable {
+public:
+    enum class op_type {
+        read = 0,
+        write,
+        range,
+        max_value = range
+    };
+
+    // latencies in power-of-two microseconds buckets, the last one collects all the slower ones
+    struct histogram {
+        static constexpr int kBucketsNum = 20;
+
+        std::array<uint64_t, kBucketsNum> buckets = {};
+
+        uint64_t count  = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+
+        void
+        add(uint64_t us) {
+            auto i = 0;
+            while((us >> i) > 0 && i < kBucketsNum - 1) {
+                i++;
+            }
+            buckets[i]++;
+            count++;
+            sum_us += us;
+            max_us = std::max(max_us, us);
+        }
+    };
+
+    struct counters {
+        uint64_t reads        = 0;
+        uint64_t read_misses  = 0;
+        uint64_t read_bytes   = 0;
+        uint64_t writes       = 0;
+        uint64_t write_bytes  = 0;
+        uint64_t range_scans  = 0;
+        uint64_t range_rows   = 0;
+        uint64_t cache_hits   = 0;
+        uint64_t cache_misses = 0;
+
+        std::array<histogram, (int)op_type::max_value + 1> latencies;
+    };
+
+    // sets current action during its lifetime
+    class action_scope : boost::noncopyable {
+    public:
+        action_scope(token_database_metrics* metrics, action_name act)
+            : metrics_(metrics) {
+            if(metrics_) {
+                metrics_->current_ = &metrics_->actions_[act];
+                reads0_  = metrics_->current_->reads;
+                writes0_ = metrics_->current_->writes;
+            }
+        }
+
+        ~action_scope() {
+            if(metrics_) {
+                metrics_->current_ = nullptr;
+            }
+        }
+
+    public:
+        // keys read and written within this scope
+        uint64_t reads() const { return metrics_ ? metrics_->current_->reads - reads0_ : 0; }
+        uint64_t writes() const { return metrics_ ? metrics_->current_->writes - writes0_ : 0; }
+
+    private:
+        token_database_metrics* metrics_;
+        uint64_t                reads0_  = 0;
+        uint64_t                writes0_ = 0;
+    };
+
+    class timer {
+    public:
+        timer() : start_(std::chrono::steady_clock::now()) {}
+
+        uint64_t
+        elapsed_us() const {
+            using namespace std::chrono;
+            return duration_cast<microseconds>(steady_clock::now() - start_).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+    };
+
+public:
+    token_database_metrics() : current_(nullptr) {}
+
+public:
+    void
+    on_read(token_type type, size_t keys, size_t found, size_t bytes, uint64_t us) {
+        update(type, [&](auto& c) {
+            c.reads       += keys;
+            c.read_misses += keys - found;
+            c.read_bytes  += bytes;
+            c.latencies[(int)op_type::read].add(us);
+        });
+    }
+
+    void
+    on_write(token_type type, size_t keys, size_t bytes, uint64_t us) {
+        update(type, [&](auto& c) {
+            c.writes      += keys;
+            c.write_bytes += bytes;
+            c.latencies[(int)op_type::write].add(us);
+        });
+    }
+
+    void
+    on_range(token_type type, size_t rows, uint64_t us) {
+        update(type, [&](auto& c) {
+            c.range_scans += 1;
+            c.range_rows  += rows;
+            c.latencies[(int)op_type::range].add(us);
+        });
+    }
+
+    void
+    on_cache(token_type type, bool hit) {
+        update(type, [&](auto& c) {
+            if(hit) {
+                c.cache_hits++;
+            }
+            else {
+                c.cache_misses++;
+            }
+        });
+    }
+
+    static const char*
+    type_name(token_type type) {
+        static const char* type_names[] = {
+            "asset", "domain", "token", "group", "suspend", "lock",
+            "fungible", "prodvote", "evtlink", "psvbonus", "psvbonus_dist"
+        };
+        static_assert(sizeof(type_names) / sizeof(type_names[0]) == (int)token_type::max_value + 1);
+        return type_names[(int)type];
+    }
+
+    const counters& of_type(token_type type) const { return types_[(int)type]; }
+
+    fc::variant
+    to_variant() const {
+        auto types = fc::mutable_variant_object();
+        for(auto i = 0u; i < types_.size(); i++) {
+            types(type_name((token_type)i), to_variant(types_[i]));
+        }
+
+        auto actions = fc::mutable_variant_object();
+        for(auto& it : actions_) {
+            actions(it.first.to_string(), to_variant(it.second));
+        }
+
+        return fc::mutable_variant_object()
+            ("types", std::move(types))
+            ("actions", std::move(actions));
+    }
+
+private:
+    template<typename Func>
+    void
+    update(token_type type, Func&& func) {
+        func(types_[(int)type]);
+        if(current_) {
+            func(*current_);
+        }
+    }
+
+    static fc::variant
+    to_variant(const histogram& h) {
+        return fc::mutable_variant_object()
+            ("count", h.count)
+            ("avg_us", h.count ? h.sum_us / h.count : 0)
+            ("max_us", h.max_us)
+            ("buckets", std::vector<uint64_t>(h.buckets.cbegin(), h.buckets.cend()));
+    }
+
+    static fc::variant
+    to_variant(const counters& c) {
+        return fc::mutable_variant_object()
+            ("reads", c.reads)
+            ("read_misses", c.read_misses)
+            ("read_bytes", c.read_bytes)
+            ("writes", c.writes)
+            ("write_bytes", c.write_bytes)
+            ("range_scans", c.range_scans)
+            ("range_rows", c.range_rows)
+            ("cache_hits", c.cache_hits)
+            ("cache_misses", c.cache_misses)
+            ("read_latency", to_variant(c.latencies[(int)op_type::read]))
+            ("write_latency", to_variant(c.latencies[(int)op_type::write]))
+            ("range_latency", to_variant(c.latencies[(int)op_type::range]));
+    }
+
+private:
+    std::array<counters, (int)token_type::max_value + 1> types_;
+    std::unordered_map<action_name, counters>             actions_;
+    counters*                                             current_;
+};
+
+}}  // namespace evt::chain
@@ -0,0 +1,47 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <atomic>
+#include <memory>
+#include <boost/noncopyable.hpp>
+#include <evt/chain/token_database.hpp>
+
+namespace evt { namespace chain {
+
+/**
+ *  Read replica of the token database written by another process on the same host or shared storage.
+ *  Database is opened in read-only mode and it's a point-in-time view of the rows committed by primary,
+ *  so catching up opens a new instance and swaps it in. Views pin the instance they're created from,
+ *  the old one is closed once the last view of it is released.
+ *  Rows in write caches of primary, pending assets of reversible blocks, are not visible.
+ */
+class token_database_replica : boost::noncopyable {
+public:
+    using read_view_ptr = std::shared_ptr<const token_database::read_view>;
+
+public:
+    token_database_replica(const token_database::config& config);
+
+public:
+    // reopens database to see the rows committed by primary since last time, called from one thread
+    void catch_up();
+
+    // safe to be called from any thread
+    read_view_ptr new_read_view() const;
+    std::shared_ptr<const token_database> current() const;
+
+    // increased by each catch-up, views are refreshed when it's changed
+    uint32_t generation() const { return generation_; }
+
+private:
+    std::shared_ptr<const token_database> open_instance() const;
+
+private:
+    token_database::config                config_;
+    std::shared_ptr<const token_database> db_;
+    std::atomic<uint32_t>                 generation_;
+};
+
+}}  // namespace evt::chain
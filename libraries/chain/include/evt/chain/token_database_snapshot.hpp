@@ -3,16 +3,32 @@
  *  @copyright defined in evt/LICENSE.txt
 */
 #pragma once
+#include <optional>
+#include <vector>
+#include <fc/crypto/sha256.hpp>
 #include <evt/chain/snapshot.hpp>
+#include <evt/chain/token_database.hpp>
 
 namespace evt { namespace chain {
 
-class token_database;
-
 namespace token_database_snapshot {
 
-void add_to_snapshot(snapshot_writer_ptr snapshot, const token_database& db);
-void read_from_snapshot(snapshot_reader_ptr snapshot, token_database& db);
+// sections are read by `threads` workers from one consistent view of database, 0 means the number of cores
+// each section is checksummed, returns the digest merged from checksums of all the sections
+fc::sha256 add_to_snapshot(snapshot_writer_ptr snapshot, const token_database& db, size_t threads = 0);
+// same as above but reads from the view pinned before, so it can be called from other threads
+fc::sha256 add_to_snapshot(snapshot_writer_ptr snapshot, const token_database::read_view& view, size_t threads = 0);
+// when `ingest` is set, rows are written into sst files and ingested into database at last instead of being put one by one
+void read_from_snapshot(snapshot_reader_ptr snapshot, token_database& db, bool ingest = false);
+
+// incremental snapshot only has the rows changed since the snapshot of block `base_id`, with their latest values
+void add_deltas_to_snapshot(snapshot_writer_ptr snapshot, const block_id_type& base_id, const std::vector<token_delta>& deltas);
+// returns the id of base block when it's an incremental snapshot
+std::optional<block_id_type> read_delta_base(snapshot_reader_ptr snapshot);
+// writes the full snapshot of incremental one: other sections of it are copied, and rows of token database are the ones
+// of base applied with the deltas, `db` is cleared and used to merge them
+void rebase_snapshot(std::shared_ptr<istream_snapshot_reader> base, std::shared_ptr<istream_snapshot_reader> incremental,
+                     std::shared_ptr<ostream_snapshot_writer> snapshot, token_database& db);
 
 }  // namespace token_database_snapshot
 
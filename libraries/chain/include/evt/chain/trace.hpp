@@ -4,12 +4,19 @@
  */
 #pragma once
 
+#include <memory>
 #include <evt/chain/action.hpp>
 #include <evt/chain/action_receipt.hpp>
 #include <evt/chain/block.hpp>
 
 namespace evt { namespace chain {
 
+class execution_context;
+
+namespace contracts {
+struct abi_serializer;
+}  // namespace contracts
+
 struct ft_holder {
 public:
     address        addr;
@@ -32,6 +39,10 @@ struct action_trace {
     fc::microseconds elapsed;
     string           console;
 
+    // keys of token database accessed by this action, only counted when stats of token database are enabled
+    uint32_t db_reads  = 0;
+    uint32_t db_writes = 0;
+
     transaction_id_type  trx_id; ///< the transaction that generated this action
     uint32_t             block_num = 0;
     block_timestamp_type block_time;
@@ -41,6 +52,14 @@ struct action_trace {
 
     small_vector<action, 2>    generated_actions;
     small_vector<ft_holder, 2> new_ft_holders;
+
+public:
+    // json of action data, converted once and shared by all the plugins consuming the trace
+    // it can be called from different threads, it's not cached if conversion fails
+    const std::string& data_json(const contracts::abi_serializer& abi, const execution_context& exec_ctx) const;
+
+private:
+    mutable std::shared_ptr<const std::string> data_json_;
 };
 
 struct transaction_trace;
@@ -63,5 +82,5 @@ struct transaction_trace {
 }}  // namespace evt::chain
 
 FC_REFLECT(evt::chain::ft_holder, (addr)(sym_id));
-FC_REFLECT(evt::chain::action_trace, (receipt)(act)(elapsed)(console)(trx_id)(block_num)(block_time)(producer_block_id)(except)(generated_actions)(new_ft_holders));
+FC_REFLECT(evt::chain::action_trace, (receipt)(act)(elapsed)(console)(db_reads)(db_writes)(trx_id)(block_num)(block_time)(producer_block_id)(except)(generated_actions)(new_ft_holders));
 FC_REFLECT(evt::chain::transaction_trace, (id)(receipt)(elapsed)(is_suspend)(action_traces)(charge)(net_usage)(except));
@@ -68,6 +68,16 @@ struct transaction : public transaction_header {
                                            const chain_id_type&        chain_id,
                                            bool                        allow_duplicate_keys = false) const;
 
+    // recovers keys with the precomputed digest of this transaction
+    static public_keys_set recover_signature_keys(const signatures_base_type& signatures,
+                                                  const digest_type&          digest,
+                                                  bool                        allow_duplicate_keys = false);
+
+    // collects keys recovered from signatures in order, checks for the duplicate ones
+    static public_keys_set make_signature_keys(const public_key_type keys[],
+                                               size_t                n,
+                                               bool                  allow_duplicate_keys = false);
+
     uint32_t
     total_actions() const {
         return actions.size();
@@ -132,7 +142,13 @@ public:
 
     digest_type packed_digest() const;
 
-    transaction_id_type id() const { return unpacked_trx.id(); }
+    // same as the one of transaction, but hashes the packed bytes directly when they are not compressed
+    digest_type     sig_digest(const chain_id_type& chain_id) const;
+    public_keys_set get_signature_keys(const chain_id_type& chain_id, bool allow_duplicate_keys = false) const;
+
+    transaction_id_type id() const { return trx_id; }
+    // digest of the whole packed transaction, including its signatures
+    const digest_type&  signed_id() const { return signed_trx_id; }
     bytes               get_raw_transaction() const;
 
     time_point_sec            expiration() const { return unpacked_trx.expiration; }
@@ -150,6 +166,7 @@ private:
 private:
     void local_unpack_transaction();
     void local_pack_transaction();
+    void local_cache_ids();
 
     friend struct fc::reflector<packed_transaction>;
     friend struct fc::reflector_init_visitor<packed_transaction>;
@@ -159,6 +176,11 @@ private:
 private:
     // cache unpacked trx, for thread safety do not modify after construction
     signed_transaction unpacked_trx;
+
+    // computed once after packing or unpacking, same as above
+    transaction_id_type trx_id;
+    digest_type         signed_trx_id;
+    uint32_t            prunable_size = 0;
 };
 
 using packed_transaction_ptr = std::shared_ptr<packed_transaction>;
@@ -3,6 +3,8 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <evt/chain/bonus_accruals.hpp>
+#include <evt/chain/deadline_timer.hpp>
 #include <evt/chain/execution_context_impl.hpp>
 #include <evt/chain/trace.hpp>
 #include <evt/chain/token_database.hpp>
@@ -41,7 +43,8 @@ private:
     void dispatch_action(action_trace& trace, const action& a);
     void record_transaction(const transaction_id_type& id, fc::time_point_sec expire);
 
-    void check_time() const;
+    // only reads the flag of deadline timer unless `exact` is set
+    void check_time(bool exact = false) const;
     void check_charge();
     void check_paid() const;
     void check_net_usage() const;
@@ -54,6 +57,8 @@ public:
     
     optional<chainbase::database::session> undo_session;
     optional<token_database::session>      undo_token_session;
+    optional<bonus_accruals::session>      undo_bonus_session;
+    optional<bonus_accruals::session>      undo_charge_session;
 
     const transaction_metadata_ptr trx_meta;
     const signed_transaction&      trx;
@@ -72,6 +77,8 @@ public:
 
 private:
     bool is_initialized = false;
+
+    optional<deadline_timer::scope> deadline_scope;
 };
 
 }}  // namespace evt::chain
@@ -3,47 +3,85 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <array>
+#include <future>
 #include <boost/noncopyable.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/trace.hpp>
 #include <evt/chain/transaction.hpp>
 
+namespace boost { namespace asio {
+class thread_pool;
+}}  // namespace boost::asio
+
 namespace evt { namespace chain {
 
+class transaction_metadata;
+using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
+
+// times of the stages one transaction goes through from ingress to irreversibility
+// only the sampled transactions have them, see chain_plugin `trx-latency-sample-rate`
+struct trx_timestamps {
+    enum stage { received = 0, queued, exec_start, exec_end, included, irreversible, stages_num };
+    enum source_type { http = 0, net };
+
+    std::array<fc::time_point, stages_num> points;
+    source_type                            source = http;
+    block_id_type                          block_id;  // block including it, updated on forks
+
+    void mark(stage s) { points[s] = fc::time_point::now(); }
+    bool has(stage s) const { return points[s] != fc::time_point(); }
+};
+
 /**
  *  This data structure should store context-free cached data about a transaction such as
  *  packed/unpacked/compressed and recovered keys
  */
 class transaction_metadata : boost::noncopyable {
+public:
+    using signing_keys_type = pair<chain_id_type, public_keys_set>;
+
 public:
     transaction_id_type                             id;
     transaction_id_type                             signed_id;
     packed_transaction_ptr                          packed_trx;
-    optional<pair<chain_id_type, public_keys_set>>  signing_keys;
+    optional<signing_keys_type>                     signing_keys;
+    std::shared_future<signing_keys_type>           signing_keys_future;  // set by `start_recover_keys`
     bool                                            accepted = false;
     bool                                            implicit = false;
+    std::unique_ptr<trx_timestamps>                 timestamps;  // set only when sampled for latency tracing
 
 public:
     explicit transaction_metadata(const signed_transaction& t, packed_transaction::compression_type c = packed_transaction::none)
-        : id(t.id()), packed_trx(std::make_shared<packed_transaction>(t, c)) {
-        signed_id = digest_type::hash(*packed_trx);
+        : packed_trx(std::make_shared<packed_transaction>(t, c)) {
+        id        = packed_trx->id();
+        signed_id = packed_trx->signed_id();
     }
 
     explicit transaction_metadata(const packed_transaction_ptr& ptrx)
-        : id(ptrx->id()), packed_trx(ptrx) {
-        signed_id = digest_type::hash(*packed_trx);
-    }
+        : id(ptrx->id()), signed_id(ptrx->signed_id()), packed_trx(ptrx) {}
 
 public:
+    // waits for the keys recovered in `start_recover_keys` if it's started, otherwise recovers them inline
+    // errors of recovery are thrown here as well
     const public_keys_set&
     recover_keys(const chain_id_type& chain_id) {
         if(!signing_keys.has_value() || signing_keys->first != chain_id) {  // Unlikely for more than one chain_id to be used in one nodeos instance
-            signing_keys = std::make_pair(chain_id, packed_trx->get_signed_transaction().get_signature_keys(chain_id));
+            if(signing_keys_future.valid()) {
+                auto& keys = signing_keys_future.get();
+                if(keys.first == chain_id) {
+                    signing_keys = keys;
+                    return signing_keys->second;
+                }
+            }
+            signing_keys = std::make_pair(chain_id, packed_trx->get_signature_keys(chain_id));
         }
         return signing_keys->second;
     }
-};
 
-using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
+    // recovers signing keys on `pool` ahead of pushing transaction, should be called before it's shared with other threads
+    // signatures are split into several tasks when there are at least `parallel_sigs` ones, 0 disables it
+    static void start_recover_keys(const transaction_metadata_ptr& mtrx, boost::asio::thread_pool& pool, const chain_id_type& chain_id, uint32_t parallel_sigs = 0);
+};
 
 }}  // namespace evt::chain
@@ -16,6 +16,9 @@ using namespace boost::multi_index;
  * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
  * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
  * expired can be removed from the index.
+ *
+ * Lookups by id are hashed, and expirations are whole seconds, so the expiration index only groups the objects
+ * into buckets of one second, which are swept from the oldest one.
  */
 class transaction_object : public chainbase::object<transaction_object_type, transaction_object> {
     OBJECT_CTOR(transaction_object)
@@ -32,11 +35,8 @@ using transaction_multi_index = chainbase::shared_multi_index_container<
     transaction_object,
     indexed_by<
         ordered_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_object::id_type, id)>,
-        ordered_unique<tag<by_trx_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_id_type, trx_id)>,
-        ordered_unique<
-            tag<by_expiration>,
-            composite_key<transaction_object, BOOST_MULTI_INDEX_MEMBER(transaction_object, time_point_sec, expiration),
-                          BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_object::id_type, id)>>>>;
+        hashed_unique<tag<by_trx_id>, BOOST_MULTI_INDEX_MEMBER(transaction_object, transaction_id_type, trx_id)>,
+        ordered_non_unique<tag<by_expiration>, BOOST_MULTI_INDEX_MEMBER(transaction_object, time_point_sec, expiration)>>>;
 
 typedef chainbase::generic_index<transaction_multi_index> transaction_index;
 
@@ -142,6 +142,8 @@ enum object_type {
     block_summary_object_type,
     transaction_object_type,
     reversible_block_object_type,
+    deadline_object_type,
+    state_layout_object_type,
     OBJECT_TYPE_COUNT  ///< Sentry value which contains the number of different object types
 };
 
@@ -176,5 +178,5 @@ FC_REFLECT_ENUM(
     evt::chain::object_type,
     (null_object_type)(global_property_object_type)(dynamic_global_property_object_type)
     (block_summary_object_type)(transaction_object_type)(reversible_block_object_type)
-    (OBJECT_TYPE_COUNT));
+    (deadline_object_type)(state_layout_object_type)(OBJECT_TYPE_COUNT));
 FC_REFLECT(evt::chain::void_t, );
@@ -0,0 +1,31 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <optional>
+#include <evt/chain/types.hpp>
+
+namespace evt { namespace chain {
+
+/*
+ * zstd compression with the dictionary shipped with the node, it's built from the packed forms of typical
+ * actions so that the small and repetitive payloads (transactions, batches of them and blocks) compress well.
+ *
+ * The dictionary is part of the protocol: data compressed with it can only be decompressed with the same one,
+ * so it must never be changed. A new dictionary should be added as a new compression type instead.
+ */
+
+// level used when callers don't have their own one
+constexpr int def_zstd_dict_level = 3;
+
+bytes zstd_dict_compress(const char* data, size_t size, int level = def_zstd_dict_level);
+
+// content size recorded in frame, nullopt if data is not one zstd frame with the size
+std::optional<size_t> zstd_frame_content_size(const char* data, size_t size);
+
+// decompresses into `out` which should be sized by the content size of frame,
+// returns nullptr if it succeeds and fills `out` exactly, otherwise the error message
+const char* zstd_dict_decompress(const char* data, size_t size, char* out, size_t out_size);
+
+}}  // namespace evt::chain
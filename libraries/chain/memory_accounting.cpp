@@ -0,0 +1,126 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/memory_accounting.hpp>
+#include <fstream>
+#include <unistd.h>
+#include <fc/io/raw.hpp>
+#include <fc/variant_object.hpp>
+#include <evt/chain/block_state.hpp>
+
+// only resolved when the process is linked with jemalloc
+extern "C" int mallctl(const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen) __attribute__((weak));
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+uint64_t
+resident_bytes() {
+    // second field of statm is resident pages
+    auto f     = std::ifstream("/proc/self/statm");
+    auto size  = uint64_t(0);
+    auto pages = uint64_t(0);
+    if(!(f >> size >> pages)) {
+        return 0;
+    }
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+fc::variant
+jemalloc_stats() {
+    // stats are cached by jemalloc until epoch is advanced
+    auto epoch = uint64_t(1);
+    auto sz    = sizeof(epoch);
+    mallctl("epoch", &epoch, &sz, &epoch, sz);
+
+    auto stats = fc::mutable_variant_object();
+    for(auto name : { "allocated", "active", "metadata", "resident", "mapped", "retained" }) {
+        auto v   = size_t(0);
+        auto len = sizeof(v);
+        if(mallctl((std::string("stats.") + name).c_str(), &v, &len, nullptr, 0) == 0) {
+            stats(name, v);
+        }
+    }
+    return stats;
+}
+
+}  // namespace internal
+
+memory_accounting&
+memory_accounting::instance() {
+    static memory_accounting accounting;
+    return accounting;
+}
+
+void
+memory_accounting::add_probe(const std::string& subsystem, probe_type probe) {
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+    probes_[subsystem] = std::move(probe);
+}
+
+void
+memory_accounting::remove_probe(const std::string& subsystem) {
+    auto lock = std::lock_guard<std::mutex>(mutex_);
+    probes_.erase(subsystem);
+}
+
+memory_counter&
+memory_accounting::counter(const std::string& subsystem) {
+    auto  lock = std::lock_guard<std::mutex>(mutex_);
+    auto& c    = counters_[subsystem];
+    if(!c) {
+        c = std::make_unique<memory_counter>();
+    }
+    return *c;
+}
+
+fc::variant
+memory_accounting::report() const {
+    auto subsystems = fc::mutable_variant_object();
+    auto total      = uint64_t(0);
+    {
+        auto lock = std::lock_guard<std::mutex>(mutex_);
+        for(auto& it : probes_) {
+            auto bytes = it.second();
+            subsystems(it.first, fc::mutable_variant_object()("bytes", bytes));
+            total += bytes;
+        }
+        for(auto& it : counters_) {
+            auto bytes = std::max<int64_t>(it.second->bytes(), 0);
+            subsystems(it.first, fc::mutable_variant_object()("bytes", bytes)("objects", it.second->objects()));
+            total += bytes;
+        }
+    }
+
+    auto r = fc::mutable_variant_object()
+        ("subsystems", std::move(subsystems))
+        ("accounted_bytes", total)
+        ("resident_bytes", internal::resident_bytes());
+    if(mallctl) {
+        r("jemalloc", internal::jemalloc_stats());
+    }
+    return r;
+}
+
+bool
+memory_accounting::dump_heap_profile(const std::string& file) const {
+    if(!mallctl) {
+        return false;
+    }
+    auto active = false;
+    auto len    = sizeof(active);
+    if(mallctl("prof.active", &active, &len, nullptr, 0) != 0 || !active) {
+        return false;
+    }
+    auto name = file.c_str();
+    return mallctl("prof.dump", nullptr, nullptr, &name, sizeof(name)) == 0;
+}
+
+int64_t
+estimate_block_bytes(const block_state& bs) {
+    return sizeof(block_state) + (bs.block ? fc::raw::pack_size(*bs.block) : 0);
+}
+
+}}  // namespace evt::chain
@@ -3,6 +3,9 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain/merkle.hpp>
+#include <future>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <fc/io/raw.hpp>
 
 namespace evt { namespace chain {
@@ -39,21 +42,73 @@ is_canonical_right(const digest_type& val) {
     return (val._hash[0] & 0x0000000000000080ULL) != 0;
 }
 
+namespace {
+
+// pairs hashed per call of hash_many, keeps the pointer arrays on stack
+constexpr size_t kPairsPerBatch = 64;
+// levels with more pairs than this are split into tasks of the thread pool
+constexpr size_t kPairsPerTask  = 2048;
+
+// hashes pairs [begin, end) of one level: out[i] = hash(in[2i] | in[2i + 1])
+// inputs are made canonical in place, out may be the same buffer as in
+// because every node is written only after both its children are read
+void
+hash_level(digest_type* in, digest_type* out, size_t begin, size_t end) {
+    const char* data[kPairsPerBatch];
+    uint32_t    sizes[kPairsPerBatch];
+    std::fill(std::begin(sizes), std::end(sizes), 2 * sizeof(digest_type));
+
+    for(auto i = begin; i < end; i += kPairsPerBatch) {
+        auto n = std::min(kPairsPerBatch, end - i);
+        for(auto j = 0u; j < n; j++) {
+            auto l = &in[2 * (i + j)];
+            l[0]._hash[0] &= 0xFFFFFFFFFFFFFF7FULL;
+            l[1]._hash[0] |= 0x0000000000000080ULL;
+            data[j] = (const char*)l;
+        }
+        digest_type::hash_many(data, sizes, n, out + i);
+    }
+}
+
+}  // namespace
+
 digest_type
-merkle(vector<digest_type> ids) {
+merkle(vector<digest_type> ids, boost::asio::thread_pool* pool) {
     if(0 == ids.size()) {
         return digest_type();
     }
 
+    // only used by the levels hashed in parallel, tasks cannot write in place
+    // because their outputs overlap the inputs of other tasks
+    auto next = vector<digest_type>();
+
     while(ids.size() > 1) {
         if(ids.size() % 2)
             ids.push_back(ids.back());
 
-        for(auto i = 0u; i < ids.size() / 2; i++) {
-            ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+        auto n = ids.size() / 2;
+        if(pool == nullptr || n < 2 * kPairsPerTask) {
+            hash_level(ids.data(), ids.data(), 0, n);
+            ids.resize(n);
+            continue;
+        }
+
+        next.resize(n);
+
+        auto tasks = vector<std::future<void>>();
+        for(auto i = kPairsPerTask; i < n; i += kPairsPerTask) {
+            auto task = std::packaged_task<void()>([&ids, &next, i, n] {
+                hash_level(ids.data(), next.data(), i, std::min(i + kPairsPerTask, n));
+            });
+            tasks.emplace_back(task.get_future());
+            boost::asio::post(*pool, std::move(task));
+        }
+        hash_level(ids.data(), next.data(), 0, kPairsPerTask);
+        for(auto& t : tasks) {
+            t.get();
         }
 
-        ids.resize(ids.size() / 2);
+        std::swap(ids, next);
     }
 
     return ids.front();
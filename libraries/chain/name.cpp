@@ -2,6 +2,7 @@
  *  @file
  *  @copyright defined in evt/LICENSE.txt
  */
+#include <array>
 #include <boost/algorithm/string.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/name.hpp>
@@ -10,33 +11,73 @@
 
 namespace evt { namespace chain {
 
+namespace {
+
+constexpr auto kCharmap = ".abcdefghijklmnopqrstuvwxyz12345";
+
+// symbol of each char, -1 for the ones out of charset
+constexpr std::array<int8_t, 256>
+make_symbols() {
+    auto symbols = std::array<int8_t, 256>();
+    for(auto& s : symbols) {
+        s = -1;
+    }
+    for(auto i = 0; i < 32; i++) {
+        symbols[(uint8_t)kCharmap[i]] = i;
+    }
+    return symbols;
+}
+
+constexpr auto kSymbols = make_symbols();
+
+// encodes the name and tells if it's normalized in the same pass
+// normalized names only have chars in charset, 13th char only has 4 bits and names don't end with '.'
+bool
+encode_name(const char* str, size_t len, uint64_t& value) {
+    auto v   = uint64_t(0);
+    auto bad = 0;
+    auto n   = std::min(len, (size_t)12);
+    for(auto i = 0u; i < n; i++) {
+        auto s = kSymbols[(uint8_t)str[i]];
+        bad |= s;
+        v   |= (uint64_t)(s & 0x1f) << (64 - 5 * (i + 1));
+    }
+    if(len == 13) {
+        auto s = kSymbols[(uint8_t)str[12]];
+        bad |= s | (s & 0x10 ? -1 : 0);
+        v   |= s & 0x0f;
+    }
+
+    value = v;
+    return bad >= 0 && (len == 0 || str[len - 1] != '.');
+}
+
+}  // namespace
+
 void
 name::set(const char* str) {
     const auto len = strnlen(str, 14);
     EVT_ASSERT(len <= 13, name_type_exception, "Name is longer than 13 characters (${name}) ", ("name", string(str)));
     EVT_ASSERT(len > 0, name_type_exception, "Name cannot be empty");
-    value = string_to_name(str);
-    EVT_ASSERT(to_string() == string(str), name_type_exception,
+    EVT_ASSERT(encode_name(str, len, value), name_type_exception,
                "Name not properly normalized (name: ${name}, normalized: ${normalized}) ",
-               ("name", string(str))("normalized", to_string()));
+               ("name", string(str))("normalized", name(string_to_name(str)).to_string()));
 }
 
 name::operator string() const {
-    static const char* charmap = ".abcdefghijklmnopqrstuvwxyz12345";
-
-    string str(13, '.');
+    char buf[13];
+    auto len = 0u;
 
     auto tmp = value;
-    str[12] = charmap[tmp & 0x0f];
-    tmp >>= 4;
-
-    for(auto i = 1u; i <= 12; ++i, tmp >>= 5) {
-        char c    = charmap[tmp & 0x1f];
-        str[12-i] = c;
+    for(auto i = 0u; i < 13; ++i) {
+        // the 13th char only has 4 bits
+        auto s = (i == 0) ? (int)tmp & 0x0f : (int)tmp & 0x1f;
+        tmp  >>= (i == 0) ? 4 : 5;
+        buf[12 - i] = kCharmap[s];
+        // trailing '.' are trimmed
+        len = (!len && s) ? 13 - i : len;
     }
-
-    str.erase(str.find_last_not_of('.') + 1);
-    return str;
+    return string(buf, len);
 }
 
 }}  // namespace evt::chain
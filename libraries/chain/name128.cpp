@@ -3,22 +3,72 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain/name128.hpp>
+#include <array>
 #include <boost/algorithm/string.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <fc/variant.hpp>
 
 namespace evt { namespace chain {
 
+namespace {
+
+constexpr auto kCharmap = ".-0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// symbol of each char, -1 for the ones out of charset
+constexpr std::array<int8_t, 256>
+make_symbols() {
+    auto symbols = std::array<int8_t, 256>();
+    for(auto& s : symbols) {
+        s = -1;
+    }
+    for(auto i = 0; i < 64; i++) {
+        symbols[(uint8_t)kCharmap[i]] = i;
+    }
+    return symbols;
+}
+
+constexpr auto kSymbols = make_symbols();
+
+// encodes the name and tells if it's normalized in the same pass
+// normalized names only have chars in charset and don't end with '.'
+bool
+encode_name128(const char* str, size_t len, uint128_t& value) {
+    auto v   = uint128_t(0);
+    auto bad = 0;
+    for(auto i = 0u; i < len; i++) {
+        auto s = kSymbols[(uint8_t)str[i]];
+        bad |= s;
+        v   |= (uint128_t)(s & 0x3f) << (2 + 6 * i);
+    }
+
+    if(len <= 5) {
+        v |= name128::i32;
+    }
+    else if(len <= 10) {
+        v |= name128::i64;
+    }
+    else if(len <= 15) {
+        v |= name128::i96;
+    }
+    else {
+        v |= name128::i128;
+    }
+
+    value = v;
+    return bad >= 0 && (len == 0 || str[len - 1] != '.');
+}
+
+}  // namespace
+
 void
 name128::set(const char* str) {
     const auto len = strnlen(str, 22);
     EVT_ASSERT(len <= 21, name128_type_exception, "Name128 is longer than 21 characters (${name}) ",
                ("name", std::string(str)));
     EVT_ASSERT(len > 0, name128_type_exception, "Name128 cannot be empty");
-    value = string_to_name128(str);
-    EVT_ASSERT(to_string() == std::string(str), name128_type_exception,
+    EVT_ASSERT(encode_name128(str, len, value), name128_type_exception,
                "Name128 not properly normalized (name: ${name}, normalized: ${normalized}) ",
-               ("name", std::string(str))("normalized", to_string()));
+               ("name", std::string(str))("normalized", name128(string_to_name128(str)).to_string()));
 }
 
 void
@@ -26,47 +76,26 @@ name128::set(const std::string& str) {
     const auto len = str.size();
     EVT_ASSERT(len <= 21, name128_type_exception, "Name128 is longer than 21 characters (${name}) ",
                ("name", str));
-    value = string_to_name128(str.c_str());
-    EVT_ASSERT(to_string() == str, name128_type_exception,
+    EVT_ASSERT(encode_name128(str.data(), len, value), name128_type_exception,
                "Name128 not properly normalized (name: ${name}, normalized: ${normalized}) ",
-               ("name", str)("normalized", to_string()));
+               ("name", str)("normalized", name128(string_to_name128(str.c_str())).to_string()));
 }
 
 name128::operator std::string() const {
-    static const char* charmap = ".-0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    // number of chars for each tag
+    constexpr uint32_t stops[] = { 5, 10, 15, 21 };
 
-    auto str = std::string(21, '.');
-    
-    auto stop = 0u;
+    char buf[21];
+    auto stop = stops[(int)value & 0x03];
     auto tmp  = value >> 2;
-    auto tag  = (int)value & 0x03;
-
-    switch(tag) {
-    case i32: {
-        stop = 5;
-        break;
-    }
-    case i64: {
-        stop = 10;
-        break;
-    }
-    case i96: {
-        stop = 15;
-        break;
-    }
-    case i128: {
-        stop = 21;
-        break;
-    }
-    }  // switch
-
+    auto len  = 0u;
     for(auto i = 0u; i < stop; ++i, tmp >>= 6) {
-        auto c = charmap[tmp & 0x3f];
-        str[i] = c;
+        auto s = (int)tmp & 0x3f;
+        buf[i] = kCharmap[s];
+        // trailing '.' are trimmed
+        len = s ? i + 1 : len;
     }
-
-    str.erase(str.find_last_not_of('.', stop) + 1);
-    return str;
+    return std::string(buf, len);
 }
 
 name128
@@ -0,0 +1,126 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/perf_stats.hpp>
+#include <fc/variant_object.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+const char* kPhaseNames[] = {
+    "start_block", "trx_init", "trx_recover", "trx_auth", "trx_apply",
+    "finalize_block", "commit_block", "pop_savepoints", "fork_db"
+};
+static_assert(sizeof(kPhaseNames) / sizeof(kPhaseNames[0]) == perf_stats::kPhasesNum);
+
+fc::variant
+to_variant(const perf_stats::histogram& h) {
+    return fc::mutable_variant_object()
+        ("count", h.count)
+        ("avg_us", h.count ? h.sum_us / h.count : 0)
+        ("max_us", h.max_us)
+        ("buckets", std::vector<uint64_t>(h.buckets.cbegin(), h.buckets.cend()));
+}
+
+}  // namespace internal
+
+perf_stats::perf_stats()
+    : tick0_(ticks())
+    , time0_(std::chrono::steady_clock::now()) {}
+
+const char*
+perf_stats::phase_name(perf_phase p) {
+    return internal::kPhaseNames[(int)p];
+}
+
+void
+perf_stats::set_trace_blocks(uint32_t blocks) {
+    trace_blocks_ = blocks;
+    spans_.clear();
+    spans_.resize(blocks * kSpansPerBlock);
+    spans_next_ = 0;
+    marks_.clear();
+    marks_.resize(blocks);
+    marks_next_ = 0;
+}
+
+double
+perf_stats::us_per_tick() const {
+    using namespace std::chrono;
+
+    auto t = ticks();
+    if(t == tick0_) {
+        return 0;
+    }
+    auto us = duration_cast<microseconds>(steady_clock::now() - time0_).count();
+    return (double)us / (t - tick0_);
+}
+
+void
+perf_stats::commit_block(uint32_t block_num) {
+    auto r = us_per_tick();
+    for(auto i = 0; i < kPhasesNum; i++) {
+        if(block_counts_[i] > 0) {
+            phases_[i].add((uint64_t)(block_ticks_[i] * r));
+        }
+    }
+    blocks_num_++;
+    last_block_ = block_num;
+
+    block_ticks_.fill(0);
+    block_counts_.fill(0);
+
+    if(!marks_.empty()) {
+        marks_[marks_next_++ % marks_.size()] = block_mark { block_num, spans_next_ };
+    }
+}
+
+fc::variant
+perf_stats::to_variant() const {
+    auto phases = fc::mutable_variant_object();
+    for(auto i = 0; i < kPhasesNum; i++) {
+        phases(internal::kPhaseNames[i], internal::to_variant(phases_[i]));
+    }
+
+    return fc::mutable_variant_object()
+        ("blocks", blocks_num_)
+        ("last_block_num", last_block_)
+        ("trace_blocks", trace_blocks_)
+        ("phases", std::move(phases));
+}
+
+fc::variant
+perf_stats::chrome_trace(uint32_t blocks) const {
+    auto events = fc::variants();
+    auto r      = us_per_tick();
+
+    blocks = std::min<size_t>({ blocks, marks_.size(), marks_next_ });
+    // spans older than these are overwritten
+    auto oldest = spans_next_ > spans_.size() ? spans_next_ - spans_.size() : 0;
+
+    for(auto m = marks_next_ - blocks; m < marks_next_; m++) {
+        auto& mark  = marks_[m % marks_.size()];
+        // the one before the oldest kept block is overwritten
+        auto  begin = (m == 0 || marks_next_ - m >= marks_.size()) ? oldest : marks_[(m - 1) % marks_.size()].spans_end;
+
+        for(auto s = std::max(begin, oldest); s < mark.spans_end; s++) {
+            auto& sp = spans_[s % spans_.size()];
+            events.emplace_back(fc::mutable_variant_object()
+                ("name", internal::kPhaseNames[(int)sp.phase])
+                ("ph", "X")
+                ("ts", (sp.begin - tick0_) * r)
+                ("dur", (sp.end - sp.begin) * r)
+                ("pid", 1)
+                ("tid", 1)
+                ("args", fc::mutable_variant_object()("block_num", mark.block_num)));
+        }
+    }
+
+    return fc::mutable_variant_object()
+        ("traceEvents", std::move(events))
+        ("displayTimeUnit", "ms");
+}
+
+}}  // namespace evt::chain
@@ -0,0 +1,139 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/read_set_prefetcher.hpp>
+#include <fc/io/datastream.hpp>
+#include <fc/log/logger.hpp>
+#include <evt/chain/action_access.hpp>
+#include <evt/chain/execution_context_impl.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/utilities/thread_placement.hpp>
+
+namespace evt { namespace chain {
+
+read_set_prefetcher::read_set_prefetcher(const token_database& db, size_t max_pending)
+    : db_(db)
+    , max_pending_(std::max<size_t>(max_pending, 1)) {
+    thread_ = std::thread([this] {
+        evt::utilities::place_current_thread("prefetch");
+        run();
+    });
+}
+
+read_set_prefetcher::~read_set_prefetcher() {
+    stop();
+}
+
+void
+read_set_prefetcher::add(const transaction_metadata_ptr& trx) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    if(stopped_) {
+        return;
+    }
+    if(trxs_.size() >= max_pending_) {
+        // the older ones are likely being executed already
+        trxs_.pop_front();
+    }
+    trxs_.emplace_back(trx);
+    cond_.notify_one();
+}
+
+void
+read_set_prefetcher::stop() {
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        stopped_ = true;
+        trxs_.clear();
+        cond_.notify_all();
+    }
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void
+read_set_prefetcher::run() {
+    while(true) {
+        auto trx = transaction_metadata_ptr();
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            cond_.wait(lock, [this] { return !trxs_.empty() || stopped_; });
+            if(stopped_) {
+                return;
+            }
+            trx = std::move(trxs_.front());
+            trxs_.pop_front();
+        }
+
+        try {
+            prefetch(trx->packed_trx->get_transaction());
+        }
+        catch(const fc::exception& e) {
+            dlog("Cannot prefetch read set of transaction: ${e}", ("e",e.to_string()));
+        }
+        catch(const std::exception& e) {
+            dlog("Cannot prefetch read set of transaction: ${e}", ("e",e.what()));
+        }
+    }
+}
+
+void
+read_set_prefetcher::prefetch(const transaction& trx) {
+    auto reads   = std::vector<std::string>();
+    auto writes  = std::vector<std::string>();
+    auto builder = access_builder(reads, writes);
+
+    // charge is paid from EVT or Pinned EVT of payer
+    builder.asset(trx.payer, evt_sym().id());
+    builder.asset(trx.payer, pevt_sym().id());
+    for(auto& act : trx.actions) {
+        try {
+            evt_execution_context::invoke_first_version<action_access, void>(act.name, act, builder);
+        }
+        catch(...) {
+            // invalid action data, it will fail when executing
+        }
+    }
+
+    // written keys are read before being written
+    auto tokens = std::vector<std::pair<name128, name128>>();
+    auto assets = std::vector<asset_key_t>();
+    auto decode = [&](const std::string& key) {
+        auto ds = fc::datastream<const char*>(key.data() + 1, key.size() - 1);
+        switch(key[0]) {
+        case access_builder::kToken: {
+            auto& t = tokens.emplace_back();
+            fc::raw::unpack(ds, t.first);
+            fc::raw::unpack(ds, t.second);
+            break;
+        }
+        case access_builder::kDomain: {
+            auto& t = tokens.emplace_back();
+            t.first = N128(.domain);
+            fc::raw::unpack(ds, t.second);
+            break;
+        }
+        case access_builder::kAsset: {
+            auto& a = assets.emplace_back();
+            fc::raw::unpack(ds, a.first);
+            fc::raw::unpack(ds, a.second);
+            break;
+        }
+        default: {
+            // whole symbols and database are never loaded
+            break;
+        }
+        }  // switch
+    };
+    for(auto& k : reads) {
+        decode(k);
+    }
+    for(auto& k : writes) {
+        decode(k);
+    }
+
+    prefetched_keys_ += db_.prefetch(tokens, assets);
+}
+
+}}  // namespace evt::chain
@@ -0,0 +1,151 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/replay_prefetcher.hpp>
+#include <fc/log/logger.hpp>
+#include <evt/chain/block_log.hpp>
+
+namespace evt { namespace chain {
+
+bool
+replay_prefetcher::queue::push(prefetched_block&& b) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    not_full_.wait(lock, [this] { return blocks_.size() < max_size_ || aborted_; });
+    if(aborted_) {
+        return false;
+    }
+    blocks_.emplace_back(std::move(b));
+    not_empty_.notify_one();
+    return true;
+}
+
+bool
+replay_prefetcher::queue::pop(prefetched_block& b) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    not_empty_.wait(lock, [this] { return !blocks_.empty() || closed_ || aborted_; });
+    if(blocks_.empty() || aborted_) {
+        return false;
+    }
+    b = std::move(blocks_.front());
+    blocks_.pop_front();
+    not_full_.notify_one();
+    return true;
+}
+
+void
+replay_prefetcher::queue::close(std::exception_ptr error) {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    closed_ = true;
+    error_  = error;
+    not_empty_.notify_all();
+}
+
+void
+replay_prefetcher::queue::abort() {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    aborted_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+std::exception_ptr
+replay_prefetcher::queue::error() const {
+    auto lock = std::unique_lock<std::mutex>(mutex_);
+    return error_;
+}
+
+replay_prefetcher::replay_prefetcher(const block_log& blog, uint32_t start_num, size_t max_size, boost::asio::thread_pool& pool,
+                                     const chain_id_type& chain_id, uint32_t parallel_sigs, need_keys_func need_keys)
+    : unpacked_(std::max<size_t>(max_size, 1))
+    , recovered_(std::max<size_t>(max_size, 1)) {
+    reader_    = std::thread([this, &blog, start_num] { read(blog, start_num); });
+    recoverer_ = std::thread([this, &pool, chain_id, parallel_sigs, need_keys = std::move(need_keys)] {
+        recover(pool, chain_id, parallel_sigs, need_keys);
+    });
+}
+
+replay_prefetcher::~replay_prefetcher() {
+    stop();
+}
+
+prefetched_block
+replay_prefetcher::next() {
+    auto b = prefetched_block();
+    if(!recovered_.pop(b)) {
+        if(auto e = recovered_.error()) {
+            std::rethrow_exception(e);
+        }
+    }
+    return b;
+}
+
+void
+replay_prefetcher::stop() {
+    unpacked_.abort();
+    recovered_.abort();
+    if(reader_.joinable()) {
+        reader_.join();
+    }
+    if(recoverer_.joinable()) {
+        recoverer_.join();
+    }
+}
+
+void
+replay_prefetcher::read(const block_log& blog, uint32_t start_num) {
+    try {
+        for(auto num = start_num; ; num++) {
+            auto b = prefetched_block();
+            b.block = blog.read_block_by_num(num);
+            if(!b.block) {
+                break;
+            }
+            if(!unpacked_.push(std::move(b))) {
+                return;
+            }
+        }
+        unpacked_.close();
+    }
+    catch(...) {
+        elog("Failed to read block from block log when replaying");
+        unpacked_.close(std::current_exception());
+    }
+}
+
+void
+replay_prefetcher::recover(boost::asio::thread_pool& pool, const chain_id_type& chain_id, uint32_t parallel_sigs, const need_keys_func& need_keys) {
+    try {
+        auto b = prefetched_block();
+        while(unpacked_.pop(b)) {
+            auto recover_keys = need_keys(b.block->block_num());
+            b.trxs.reserve(b.block->transactions.size());
+            for(const auto& receipt : b.block->transactions) {
+                if(receipt.type == transaction_receipt::input) {
+                    auto mtrx = std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(receipt.trx));
+                    if(recover_keys) {
+                        transaction_metadata::start_recover_keys(mtrx, pool, chain_id, parallel_sigs);
+                    }
+                    b.trxs.emplace_back(std::move(mtrx));
+                }
+            }
+            // keys are ready before the block is handed over, errors are thrown when they're taken
+            for(auto& mtrx : b.trxs) {
+                if(mtrx->signing_keys_future.valid()) {
+                    mtrx->signing_keys_future.wait();
+                }
+            }
+            if(!recovered_.push(std::move(b))) {
+                return;
+            }
+            b = prefetched_block();
+        }
+        recovered_.close(unpacked_.error());
+    }
+    catch(...) {
+        elog("Failed to prepare block when replaying");
+        recovered_.close(std::current_exception());
+    }
+}
+
+}}  // namespace evt::chain
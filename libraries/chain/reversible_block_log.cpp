@@ -0,0 +1,325 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/reversible_block_log.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fc/interprocess/file_mapping.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+#include <evt/chain/config.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt { namespace chain {
+
+namespace detail {
+
+enum { kMagic = 0x52455642 /* REVB */, kVersion = 1 };
+
+struct log_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t data_size;
+    uint32_t index_size;
+    uint32_t dirty;
+    uint32_t first_num;
+    uint32_t end_num;
+    uint64_t end_pos;  // logical position after the last block
+};
+
+struct log_slot {
+    uint64_t pos;
+    uint32_t size;
+    uint32_t num;
+};
+
+static uint64_t
+file_size_of(uint64_t data_size, uint32_t index_size) {
+    return sizeof(log_header) + sizeof(log_slot) * index_size + data_size;
+}
+
+class reversible_block_log_impl {
+public:
+    using open_mode = reversible_block_log::open_mode;
+
+public:
+    reversible_block_log_impl(const fc::path& path, open_mode mode)
+        : path(path), mode(mode) {}
+
+public:
+    void
+    map() {
+        auto m = (mode == open_mode::read_write) ? fc::read_write : fc::read_only;
+        file   = std::make_unique<fc::file_mapping>(path.generic_string().c_str(), m);
+        region = std::make_unique<fc::mapped_region>(*file, m);
+
+        EVT_ASSERT(region->get_size() >= sizeof(log_header), reversible_blocks_exception,
+            "Reversible block log '${f}' is truncated", ("f", path));
+        auto& h = header();
+        EVT_ASSERT(h.magic == kMagic && h.version == kVersion, reversible_blocks_exception,
+            "Reversible block log '${f}' has unsupported format", ("f", path));
+        EVT_ASSERT(region->get_size() >= file_size_of(h.data_size, h.index_size), reversible_blocks_exception,
+            "Reversible block log '${f}' is truncated", ("f", path));
+    }
+
+    void
+    unmap() {
+        region.reset();
+        file.reset();
+    }
+
+    static void
+    create(const fc::path& file, uint64_t data_size) {
+        EVT_ASSERT(data_size > 0, reversible_blocks_exception, "Size of reversible block log cannot be zero");
+        {
+            auto f = std::ofstream(file.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+            EVT_ASSERT(f, reversible_blocks_exception, "Cannot create reversible block log '${f}'", ("f", file));
+        }
+        fc::resize_file(file, file_size_of(data_size, config::reversible_blocks_index_size));
+
+        auto fm = fc::file_mapping(file.generic_string().c_str(), fc::read_write);
+        auto mr = fc::mapped_region(fm, fc::read_write, 0, sizeof(log_header));
+
+        auto h       = log_header();
+        h.magic      = kMagic;
+        h.version    = kVersion;
+        h.data_size  = data_size;
+        h.index_size = config::reversible_blocks_index_size;
+        memcpy(mr.get_address(), &h, sizeof(h));
+        mr.flush();
+    }
+
+    // blocks are moved into a new file of `data_size` which then replaces the old one
+    void
+    resize(uint64_t data_size) {
+        auto tmp = fc::path(path.generic_string() + ".tmp");
+        create(tmp, data_size);
+        try {
+            auto& h   = header();
+            auto  log = reversible_block_log_impl(tmp, open_mode::read_write);
+            log.map();
+            for(auto num = h.first_num; num < h.end_num; num++) {
+                log.append(num, read(num));
+            }
+            log.region->flush();
+        }
+        catch(...) {
+            fc::remove(tmp);
+            throw;
+        }
+        unmap();
+        fc::rename(tmp, path);
+        map();
+    }
+
+    void
+    set_dirty(bool dirty) {
+        header().dirty = dirty;
+        region->flush();
+    }
+
+    log_header&
+    header() const {
+        return *(log_header*)region->get_address();
+    }
+
+    log_slot&
+    slot(uint32_t num) const {
+        auto slots = (log_slot*)((char*)region->get_address() + sizeof(log_header));
+        return slots[num % header().index_size];
+    }
+
+    char*
+    data() const {
+        return (char*)region->get_address() + sizeof(log_header) + sizeof(log_slot) * header().index_size;
+    }
+
+    bool
+    empty() const {
+        return header().first_num == header().end_num;
+    }
+
+    uint64_t
+    used_size() const {
+        return empty() ? 0 : header().end_pos - slot(header().first_num).pos;
+    }
+
+    void
+    append(uint32_t num, std::string_view packed) {
+        auto& h = header();
+        if(empty()) {
+            h.first_num = h.end_num = num;
+        }
+        else {
+            EVT_ASSERT(num == h.end_num, reversible_blocks_exception,
+                "Block ${n} is not the next one of reversible block log, expects ${e}", ("n", num)("e", h.end_num));
+        }
+        EVT_ASSERT(h.end_num - h.first_num < h.index_size, reversible_guard_exception,
+            "Too many blocks in reversible block log: ${n}", ("n", h.end_num - h.first_num));
+
+        auto pos  = h.end_pos;
+        auto phys = pos % h.data_size;
+        if(phys + packed.size() > h.data_size) {
+            // skips the space left at the end of ring
+            pos += h.data_size - phys;
+        }
+        auto tail = empty() ? pos : slot(h.first_num).pos;
+        EVT_ASSERT(pos + packed.size() - tail <= h.data_size, reversible_guard_exception,
+            "Reversible block log is full, block ${n} of ${s} bytes cannot be added", ("n", num)("s", packed.size()));
+
+        memcpy(data() + pos % h.data_size, packed.data(), packed.size());
+        slot(num) = log_slot { pos, (uint32_t)packed.size(), num };
+
+        // header is updated last so the block is visible only after fully written
+        h.end_pos = pos + packed.size();
+        h.end_num = num + 1;
+    }
+
+    std::string_view
+    read(uint32_t num) const {
+        auto& h = header();
+        if(num < h.first_num || num >= h.end_num) {
+            return std::string_view();
+        }
+        auto& s = slot(num);
+        EVT_ASSERT(s.num == num && s.size <= h.data_size, reversible_blocks_exception,
+            "Slot of block ${n} in reversible block log is corrupted", ("n", num));
+        return std::string_view(data() + s.pos % h.data_size, s.size);
+    }
+
+public:
+    fc::path  path;
+    open_mode mode;
+
+    std::unique_ptr<fc::file_mapping>  file;
+    std::unique_ptr<fc::mapped_region> region;
+};
+
+}  // namespace detail
+
+reversible_block_log::reversible_block_log(const fc::path& dir, open_mode mode, uint64_t data_size, bool allow_dirty)
+    : my(new detail::reversible_block_log_impl(file_path(dir), mode)) {
+    if(!fc::exists(my->path)) {
+        EVT_ASSERT(mode == open_mode::read_write, reversible_blocks_exception,
+            "Reversible block log '${f}' doesn't exist", ("f", my->path));
+        if(!fc::is_directory(dir)) {
+            fc::create_directories(dir);
+        }
+        detail::reversible_block_log_impl::create(my->path, data_size);
+    }
+    my->map();
+
+    EVT_ASSERT(!my->header().dirty || allow_dirty, reversible_blocks_exception,
+        "Reversible block log '${f}' is dirty, it may be corrupted", ("f", my->path));
+    if(mode == open_mode::read_write) {
+        if(data_size > 0 && data_size != my->header().data_size) {
+            ilog("Resizing reversible block log from ${o} to ${n} bytes", ("o", my->header().data_size)("n", data_size));
+            my->resize(data_size);
+        }
+        my->set_dirty(true);
+    }
+}
+
+reversible_block_log::~reversible_block_log() {
+    if(my->region && my->mode == open_mode::read_write) {
+        try {
+            my->set_dirty(false);
+        }
+        FC_LOG_AND_DROP();
+    }
+}
+
+void
+reversible_block_log::append(uint32_t block_num, std::string_view packed_block) {
+    EVT_ASSERT(my->mode == open_mode::read_write, reversible_blocks_exception, "Reversible block log is opened as read-only");
+    my->append(block_num, packed_block);
+}
+
+void
+reversible_block_log::append(const signed_block_ptr& b) {
+    auto data = fc::raw::pack(*b);
+    append(b->block_num(), std::string_view(data.data(), data.size()));
+}
+
+void
+reversible_block_log::pop(uint32_t block_num) {
+    auto& h = my->header();
+    if(!my->empty() && h.end_num - 1 == block_num) {
+        h.end_pos = my->slot(block_num).pos;
+        h.end_num--;
+    }
+}
+
+void
+reversible_block_log::prune(uint32_t block_num) {
+    auto& h = my->header();
+    if(!my->empty() && block_num >= h.first_num) {
+        h.first_num = std::min(block_num + 1, h.end_num);
+    }
+}
+
+void
+reversible_block_log::clear() {
+    my->header().first_num = my->header().end_num;
+}
+
+void
+reversible_block_log::flush() {
+    my->region->flush();
+}
+
+std::string_view
+reversible_block_log::read_packed_block(uint32_t block_num) const {
+    return my->read(block_num);
+}
+
+signed_block_ptr
+reversible_block_log::read_block(uint32_t block_num) const {
+    auto data = my->read(block_num);
+    if(data.empty()) {
+        return signed_block_ptr();
+    }
+    auto ds = fc::datastream<const char*>(data.data(), data.size());
+    auto b  = std::make_shared<signed_block>();
+    fc::raw::unpack(ds, *b);
+    EVT_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
+        "Wrong block was read from reversible block log, expects ${n} but got ${b}", ("n", block_num)("b", b->block_num()));
+    return b;
+}
+
+bool
+reversible_block_log::empty() const {
+    return my->empty();
+}
+
+uint32_t
+reversible_block_log::first_block_num() const {
+    return my->header().first_num;
+}
+
+uint32_t
+reversible_block_log::end_block_num() const {
+    return my->header().end_num;
+}
+
+uint64_t
+reversible_block_log::free_size() const {
+    return my->header().data_size - my->used_size();
+}
+
+bool
+reversible_block_log::exists(const fc::path& dir) {
+    return fc::exists(file_path(dir));
+}
+
+fc::path
+reversible_block_log::file_path(const fc::path& dir) {
+    return dir / config::reversible_blocks_filename;
+}
+
+}}  // namespace evt::chain
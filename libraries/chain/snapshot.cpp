@@ -1,13 +1,111 @@
 #include <evt/chain/snapshot.hpp>
 
+#include <chrono>
+#include <iterator>
+#include <thread>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <zstd.h>
 
 #include <fc/scoped_exit.hpp>
 #include <evt/chain/exceptions.hpp>
 
 namespace evt { namespace chain {
 
+namespace internal {
+
+const int kZstdLevel = 3;
+
+// collects the rows written into current frame
+class frame_sink {
+public:
+    using char_type = char;
+    using category  = boost::iostreams::sink_tag;
+
+public:
+    frame_sink(std::string& frame) : frame_(&frame) {}
+
+public:
+    std::streamsize
+    write(const char* s, std::streamsize n) {
+        frame_->append(s, n);
+        return n;
+    }
+
+private:
+    std::string* frame_;
+};
+
+std::string
+compress_frame(std::string data) {
+    auto out = std::string();
+    out.resize(ZSTD_compressBound(data.size()));
+    auto r = ZSTD_compress(out.data(), out.size(), data.data(), data.size(), kZstdLevel);
+    EVT_ASSERT(!ZSTD_isError(r), snapshot_exception, "Cannot compress section of snapshot: ${e}", ("e", ZSTD_getErrorName(r)));
+    out.resize(r);
+    return out;
+}
+
+// decompresses the frames of one section, which are `size` bytes starting at `pos` of snapshot
+class frames_source {
+public:
+    using char_type = char;
+    using category  = boost::iostreams::source_tag;
+
+private:
+    struct state {
+        ~state() { ZSTD_freeDStream(dstream); }
+
+        std::istream&  snapshot;
+        std::streampos pos;
+        uint64_t       left;
+        ZSTD_DStream*  dstream;
+        std::string    in;
+        ZSTD_inBuffer  in_buf;
+        bool           finished;  // last frame is finished
+    };
+
+public:
+    frames_source(std::istream& snapshot, std::streampos pos, uint64_t size)
+        : state_(new state { snapshot, pos, size, ZSTD_createDStream(), std::string(ZSTD_DStreamInSize(), '\0'), ZSTD_inBuffer { nullptr, 0, 0 }, true }) {
+        EVT_ASSERT(state_->dstream, snapshot_exception, "Cannot create zstd stream");
+        ZSTD_initDStream(state_->dstream);
+    }
+
+public:
+    std::streamsize
+    read(char* s, std::streamsize n) {
+        auto& st  = *state_;
+        auto  out = ZSTD_outBuffer { s, (size_t)n, 0 };
+        while(out.pos < out.size) {
+            if(st.in_buf.pos == st.in_buf.size) {
+                if(st.left == 0) {
+                    EVT_ASSERT(st.finished, snapshot_exception, "Section of snapshot is truncated");
+                    break;
+                }
+                // other sections may be read in between, so always seek to where this section is
+                auto sz = std::min<uint64_t>(st.left, st.in.size());
+                st.snapshot.seekg(st.pos);
+                st.snapshot.read(st.in.data(), sz);
+                EVT_ASSERT((uint64_t)st.snapshot.gcount() == sz, snapshot_exception, "Section of snapshot is truncated");
+                st.pos += sz;
+                st.left -= sz;
+                st.in_buf = ZSTD_inBuffer { st.in.data(), (size_t)sz, 0 };
+            }
+
+            auto r = ZSTD_decompressStream(st.dstream, &out, &st.in_buf);
+            EVT_ASSERT(!ZSTD_isError(r), snapshot_exception, "Cannot decompress section of snapshot: ${e}", ("e", ZSTD_getErrorName(r)));
+            st.finished = (r == 0);
+        }
+        return out.pos > 0 ? (std::streamsize)out.pos : -1;
+    }
+
+private:
+    std::shared_ptr<state> state_;
+};
+
+}  // namespace internal
+
 variant_snapshot_writer::variant_snapshot_writer(fc::mutable_variant_object& snapshot)
     : snapshot(snapshot) {
     snapshot.set("sections", fc::variants());
@@ -150,8 +248,9 @@ variant_snapshot_reader::build_section_indexes() {
 ostream_snapshot_writer::ostream_snapshot_writer(std::ostream& snapshot)
     : snapshot(snapshot)
     , header_pos(snapshot.tellp())
-    , section_pos(-1)
-    , row_count(0) {
+    , max_frames(std::max(std::thread::hardware_concurrency(), 2u))
+    , in_section(false)
+    , finalized(false) {
     // write magic number
     auto totem = magic_number;
     snapshot.write((char*)&totem, sizeof(totem));
@@ -161,43 +260,41 @@ ostream_snapshot_writer::ostream_snapshot_writer(std::ostream& snapshot)
     snapshot.write((char*)&version, sizeof(version));
 }
 
+ostream_snapshot_writer::~ostream_snapshot_writer() {
+    if(!finalized && !in_section) {
+        try {
+            finalize();
+        }
+        FC_LOG_AND_DROP();
+    }
+}
+
 void
 ostream_snapshot_writer::write_start_section(const std::string& section_name) {
-    namespace io = boost::iostreams;
-
-    EVT_ASSERT(section_pos == std::streampos(-1), snapshot_exception, "Attempting to write a new section without closing the previous section");
-    section_pos = snapshot.tellp();
-    row_count   = 0;
-
-    uint64_t placeholder = std::numeric_limits<uint64_t>::max();
-
-    // write a placeholder for the section size
-    snapshot.write((char*)&placeholder, sizeof(placeholder));
-
-    // write placeholder for row count
-    snapshot.write((char*)&placeholder, sizeof(placeholder));
-
-    // write the section name (null terminated)
-    snapshot.write(section_name.data(), section_name.size());
-    snapshot.put('\0');
+    EVT_ASSERT(!in_section, snapshot_exception, "Attempting to write a new section without closing the previous section");
+    in_section = true;
+    sections.emplace_back(section_entry {
+        .name      = section_name,
+        .pos       = std::numeric_limits<uint64_t>::max(),
+        .size      = 0,
+        .row_count = 0
+    });
 
     // setup row stream
     assert(!row_stream.has_value());
     row_stream.emplace();
-    row_stream->push(io::zlib_compressor());
-    row_stream->push(snapshot.inner);
+    row_stream->push(internal::frame_sink(frame));
 }
 
 void
 ostream_snapshot_writer::write_row(const detail::abstract_snapshot_row_writer& row_writer) {
-    try {
-        auto wrapper = detail::ostream_wrapper(*row_stream);
-        row_writer.write(wrapper);
-    }
-    catch(...) {
-        throw;
+    auto wrapper = detail::ostream_wrapper(*row_stream);
+    row_writer.write(wrapper);
+    sections.back().row_count++;
+
+    if(frame.size() >= frame_size) {
+        submit_frame();
     }
-    row_count++;
 }
 
 void
@@ -210,34 +307,98 @@ ostream_snapshot_writer::write_end_section() {
     io::close(*row_stream);
     row_stream.reset();
 
-    // seek to section pos
-    auto restore = snapshot.tellp();
-    uint64_t section_size = restore - section_pos - sizeof(uint64_t);
-    snapshot.seekp(section_pos);
-
-    // write a the section size
-    snapshot.write((char*)&section_size, sizeof(section_size));
+    if(!frame.empty()) {
+        submit_frame();
+    }
+    // frames and sections compressed before are written without waiting for the others
+    write_frames(max_frames);
 
-    // write the row count
-    snapshot.write((char*)&row_count, sizeof(row_count));
-    snapshot.seekp(restore);
+    in_section = false;
+}
 
-    // clear state
-    section_pos = std::streampos(-1);
-    row_count   = 0;
+void
+ostream_snapshot_writer::write_raw_section(const std::string& section_name, const std::string& data, uint64_t row_count) {
+    write_start_section(section_name);
+    for(auto pos = (size_t)0; pos < data.size(); pos += frame_size) {
+        row_stream->write(data.data() + pos, std::min(frame_size, data.size() - pos));
+        boost::iostreams::flush(*row_stream);
+        submit_frame();
+    }
+    sections.back().row_count = row_count;
+    write_end_section();
 }
 
 void
 ostream_snapshot_writer::finalize() {
-    uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+    EVT_ASSERT(!in_section, snapshot_exception, "Attempting to finalize snapshot without closing the last section");
+    if(finalized) {
+        return;
+    }
+    finalized = true;
+    write_frames(0);
+
+    // write directory
+    auto dir_pos = (uint64_t)(snapshot.tellp() - header_pos);
+    auto count   = (uint32_t)sections.size();
+    snapshot.write((char*)&count, sizeof(count));
+    for(auto& s : sections) {
+        // empty sections have no frames
+        auto pos = (s.pos == std::numeric_limits<uint64_t>::max()) ? dir_pos : s.pos;
+        snapshot.write(s.name.data(), s.name.size());
+        snapshot.put('\0');
+        snapshot.write((char*)&pos, sizeof(pos));
+        snapshot.write((char*)&s.size, sizeof(s.size));
+        snapshot.write((char*)&s.row_count, sizeof(s.row_count));
+    }
+
+    // write footer
+    auto totem = magic_number;
+    snapshot.write((char*)&dir_pos, sizeof(dir_pos));
+    snapshot.write((char*)&totem, sizeof(totem));
+}
+
+void
+ostream_snapshot_writer::set_rate_limiter(std::shared_ptr<utilities::rate_limiter> limiter) {
+    this->limiter = std::move(limiter);
+}
+
+void
+ostream_snapshot_writer::submit_frame() {
+    // not too many frames are kept in memory
+    write_frames(max_frames - 1);
+
+    auto data = std::string();
+    data.swap(frame);
+    frames.emplace_back(pending_frame {
+        .data    = std::async(std::launch::async, &internal::compress_frame, std::move(data)),
+        .section = sections.size() - 1
+    });
+}
 
-    // write a placeholder for the section size
-    snapshot.write((char*)&end_marker, sizeof(end_marker));
+void
+ostream_snapshot_writer::write_frames(size_t max_pending) {
+    while(frames.size() > max_pending
+          || (!frames.empty() && frames.front().data.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+        auto f    = std::move(frames.front());
+        auto data = f.data.get();
+        frames.pop_front();
+
+        auto& s = sections[f.section];
+        if(s.pos == std::numeric_limits<uint64_t>::max()) {
+            s.pos = (uint64_t)(snapshot.tellp() - header_pos);
+        }
+        if(limiter) {
+            limiter->request(data.size());
+        }
+        snapshot.write(data.data(), data.size());
+        s.size += data.size();
+    }
 }
 
 istream_snapshot_reader::istream_snapshot_reader(std::istream& snapshot)
     : snapshot(snapshot)
     , header_pos(snapshot.tellg())
+    , version(0)
     , num_rows(0)
     , cur_row(0) {
     build_section_indexes();
@@ -265,11 +426,36 @@ istream_snapshot_reader::validate() const {
         auto                       expected_version = current_snapshot_version;
         decltype(expected_version) actual_version;
         snapshot.read((char*)&actual_version, sizeof(actual_version));
-        EVT_ASSERT(actual_version == expected_version, snapshot_exception,
+        EVT_ASSERT(actual_version >= minimal_snapshot_version && actual_version <= expected_version, snapshot_exception,
                    "Binary snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
                    ("expected", expected_version)("actual", actual_version));
 
-        while(validate_section()) {
+        if(actual_version < 5) {
+            while(validate_section()) {
+            }
+            return;
+        }
+
+        // sections are read from directory, they should be in the snapshot and before the directory
+        auto header_size = (uint64_t)(snapshot.tellg() - header_pos);
+        snapshot.seekg(0, std::ios::end);
+        auto end_pos = (uint64_t)(snapshot.tellg() - header_pos);
+        EVT_ASSERT(end_pos >= header_size + sizeof(uint64_t) + sizeof(uint32_t), snapshot_exception,
+                   "Binary snapshot is truncated");
+
+        uint64_t dir_pos = 0;
+        snapshot.seekg(header_pos + std::streamoff(end_pos - sizeof(uint64_t) - sizeof(uint32_t)));
+        snapshot.read((char*)&dir_pos, sizeof(dir_pos));
+        snapshot.read((char*)&actual_totem, sizeof(actual_totem));
+        EVT_ASSERT(actual_totem == expected_totem, snapshot_exception,
+                   "Binary snapshot has unexpected magic number at the end!");
+        EVT_ASSERT(dir_pos >= header_size && dir_pos < end_pos, snapshot_exception,
+                   "Binary snapshot has invalid position of directory");
+
+        for(auto& si : section_indexes) {
+            auto pos = (uint64_t)(std::streamoff(si.pos) - std::streamoff(header_pos));
+            EVT_ASSERT(pos >= header_size && pos + si.size <= dir_pos, snapshot_exception,
+                       "Section ${n} of binary snapshot is out of range", ("n", si.name));
         }
     }
     catch(const std::exception& e) {
@@ -323,15 +509,20 @@ istream_snapshot_reader::set_section(const string& section_name) {
 
     for(auto& si : section_indexes) {
         if(si.name == section_name) {
-            snapshot.seekg(si.pos);
             cur_row  = 0;
             num_rows = si.row_count;
 
             // setup row stream
             assert(!row_stream.has_value());
             row_stream.emplace();
-            row_stream->push(io::zlib_decompressor());
-            row_stream->push(snapshot);
+            if(version < 5) {
+                snapshot.seekg(si.pos);
+                row_stream->push(io::zlib_decompressor());
+                row_stream->push(snapshot);
+            }
+            else {
+                row_stream->push(internal::frames_source(snapshot, si.pos, si.size));
+            }
 
             return;
         }
@@ -367,6 +558,15 @@ istream_snapshot_reader::eof() {
     return cur_row >= num_rows;
 }
 
+uint64_t
+istream_snapshot_reader::read_raw_section(const string& section_name, std::string& data) {
+    set_section(section_name);
+    auto rows = num_rows;
+    data.assign(std::istreambuf_iterator<char>(*row_stream), std::istreambuf_iterator<char>());
+    clear_section();
+    return rows;
+}
+
 void
 istream_snapshot_reader::clear_section() {
     num_rows = 0;
@@ -376,9 +576,52 @@ istream_snapshot_reader::clear_section() {
 void
 istream_snapshot_reader::build_section_indexes() {
     auto restore_pos = fc::make_scoped_exit([this, pos = snapshot.tellg()]() {
+        snapshot.clear();
         snapshot.seekg(pos);
     });
 
+    snapshot.seekg(header_pos + std::streamoff(sizeof(ostream_snapshot_writer::magic_number)));
+    snapshot.read((char*)&version, sizeof(version));
+    if(!snapshot || version < 5) {
+        // invalid snapshots are reported by `validate`
+        snapshot.clear();
+        build_section_indexes_v4();
+        return;
+    }
+
+    // directory is at the end, no need to scan all the sections
+    auto footer_size = std::streamoff(sizeof(uint64_t) + sizeof(ostream_snapshot_writer::magic_number));
+    snapshot.seekg(-footer_size, std::ios::end);
+    if(!snapshot) {
+        return;
+    }
+    uint64_t dir_pos = 0;
+    snapshot.read((char*)&dir_pos, sizeof(dir_pos));
+    snapshot.seekg(header_pos + std::streamoff(dir_pos));
+
+    uint32_t count = 0;
+    snapshot.read((char*)&count, sizeof(count));
+    for(auto i = 0u; i < count && snapshot; i++) {
+        auto name = std::string();
+        std::getline(snapshot, name, '\0');
+
+        uint64_t pos = 0, size = 0, row_count = 0;
+        snapshot.read((char*)&pos, sizeof(pos));
+        snapshot.read((char*)&size, sizeof(size));
+        snapshot.read((char*)&row_count, sizeof(row_count));
+        EVT_ASSERT(snapshot, snapshot_validation_exception, "Not valid directory of sections");
+
+        section_indexes.emplace_back(section_index {
+            .name      = std::move(name),
+            .pos       = (size_t)(header_pos + std::streamoff(pos)),
+            .row_count = row_count,
+            .size      = (size_t)size
+        });
+    }
+}
+
+void
+istream_snapshot_reader::build_section_indexes_v4() {
     const std::streamoff header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
 
     auto next_section_pos = header_pos + header_size;
@@ -417,6 +660,41 @@ istream_snapshot_reader::build_section_indexes() {
     }
 }
 
+void
+buffered_snapshot_writer::write_start_section(const std::string& section_name) {
+    assert(!row_stream.has_value());
+    sections.emplace_back(section { .name = section_name });
+    row_stream.emplace();
+}
+
+void
+buffered_snapshot_writer::write_row(const detail::abstract_snapshot_row_writer& row_writer) {
+    auto wrapper = detail::ostream_wrapper(*row_stream);
+    row_writer.write(wrapper);
+    sections.back().row_ends.emplace_back((size_t)row_stream->tellp());
+}
+
+void
+buffered_snapshot_writer::write_end_section() {
+    assert(row_stream.has_value());
+    sections.back().data = row_stream->str();
+    row_stream.reset();
+}
+
+void
+buffered_snapshot_writer::write_to(snapshot_writer& writer) const {
+    // rows are packed already, so they're written as raw ones
+    for(auto& s : sections) {
+        writer.write_section(s.name, [&s](auto& section) {
+            auto begin = (size_t)0;
+            for(auto end : s.row_ends) {
+                section.add_row(s.data.data() + begin, end - begin);
+                begin = end;
+            }
+        });
+    }
+}
+
 integrity_hash_snapshot_writer::integrity_hash_snapshot_writer(fc::sha256::encoder& enc)
     : enc(enc) {
 }
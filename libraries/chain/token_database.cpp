@@ -8,18 +8,34 @@
 #define __cpp_lib_string_view
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <fstream>
+#include <map>
+#include <set>
 #include <string_view>
+#include <thread>
 #include <unordered_set>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
 
 #include <rocksdb/db.h>
 #include <rocksdb/cache.h>
+#include <rocksdb/compaction_filter.h>
 #include <rocksdb/options.h>
+#include <rocksdb/rate_limiter.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/memtablerep.h>
+#include <rocksdb/merge_operator.h>
 #include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/utilities/options_util.h>
 
 #include <llvm/ADT/StringSet.h>
 #include <llvm/ADT/StringMap.h>
@@ -28,9 +44,14 @@
 #include <fc/io/datastream.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/container/ring_vector.hpp>
+#include <fc/crypto/city.hpp>
+#include <fc/scoped_exit.hpp>
 
+#include <evt/chain/arena.hpp>
 #include <evt/chain/config.hpp>
+#include <evt/chain/dense_hash.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <evt/chain/token_database_metrics.hpp>
 
 namespace evt { namespace chain {
 
@@ -52,6 +73,27 @@ const char*  kAssetsColumnFamilyName = "Assets";
 const size_t kSymbolIdSize           = sizeof(symbol_id_type);
 const size_t kPublicKeySize          = sizeof(fc::ecc::public_key_shim);
 const size_t kDefaultSavePointsSize  = (4 / 3 * 24 + 1) * 12;
+const size_t kMaxPooledArenasSize    = 64;
+const size_t kIngestFileSize         = 64 * 1024 * 1024;
+const char*  kIngestDirName          = "ingest";
+const uint32_t kHotPromoteHits       = 4;
+const uint32_t kHotDecayInterval     = 64 * 1024;
+const size_t kTokenVersionStripes    = 64 * 1024;
+const size_t kMaxPooledIterators     = 4;  // for each column family
+const size_t kKeyFilterInitialKeys   = 1024 * 1024;
+const size_t kKeyFilterBitsPerKey    = 10;
+const size_t kKeyFilterProbes        = 6;
+
+// column families only used in separated layout for the hot token types
+const char* kTokensColumnFamilyName    = "Tokens";
+const char* kFungiblesColumnFamilyName = "Fungibles";
+const char* kEvtLinksColumnFamilyName  = "EvtLinks";
+
+// column family of owner index, only used when `owner_index` is enabled
+const char* kOwnersColumnFamilyName = "Owners";
+
+// column family of balance index, only used when `balance_index` is enabled
+const char* kBalancesColumnFamilyName = "Balances";
 
 struct db_token_key : boost::noncopyable {
 public:
@@ -127,6 +169,91 @@ name128 action_key_prefixes[] = {
 
 static_assert(sizeof(action_key_prefixes) / sizeof(name128) == (int)token_type::max_value + 1);
 
+// marker stored in default column family once migration into separated layout is finished
+const name128 kLayoutMarkerPrefix = N128(.layout);
+const name128 kLayoutMarkerKey    = N128(.separated);
+
+struct hot_column {
+    token_type  type;
+    const char* name;
+};
+
+hot_column hot_columns[] = {
+    { token_type::token,    kTokensColumnFamilyName    },
+    { token_type::fungible, kFungiblesColumnFamilyName },
+    { token_type::evtlink,  kEvtLinksColumnFamilyName  }
+};
+
+// key in owner index: head of the hash of owner address followed by db key of token, 48 bytes in total
+// hashes may collide, so owners are checked again when tokens are read
+std::string
+db_owner_key(const address& owner, const std::string_view& token_key) {
+    auto packed = fc::raw::pack(owner);
+    auto hash   = fc::sha256::hash(packed.data(), packed.size());
+
+    auto key = std::string(hash.data(), sizeof(name128));
+    key.append(token_key.data(), token_key.size());
+    return key;
+}
+
+// key in balance index: address followed by symbol id, converted from the db key of asset
+// so balances of one address across all the symbols are under one prefix
+std::string
+db_balance_key(const std::string_view& asset_key) {
+    assert(asset_key.size() == kSymbolIdSize + kPublicKeySize);
+
+    auto key = std::string(asset_key.substr(kSymbolIdSize));
+    key.append(asset_key.data(), kSymbolIdSize);
+    return key;
+}
+
+// domain and name of serialized token are fixed-size and followed by owner, empty value has no owners
+small_vector<address, 4>
+extract_token_owners(const std::string_view& value) {
+    auto owners = small_vector<address, 4>();
+    if(!value.empty()) {
+        auto ds = fc::datastream<const char*>(value.data() + sizeof(name128) * 2, value.size() - sizeof(name128) * 2);
+        fc::raw::unpack(ds, owners);
+    }
+    return owners;
+}
+
+// serialized property of asset always starts with its amount
+int64_t
+extract_asset_amount(const std::string_view& value) {
+    auto amount = int64_t(0);
+    if(value.size() >= sizeof(amount)) {
+        memcpy(&amount, value.data(), sizeof(amount));
+    }
+    return amount;
+}
+
+// holders ranked by amount in descending order, ties are in the key order
+struct holder_rank_order {
+    bool
+    operator()(const std::pair<int64_t, std::string>& a, const std::pair<int64_t, std::string>& b) const {
+        if(a.first != b.first) {
+            return a.first > b.first;
+        }
+        return a.second < b.second;
+    }
+};
+
+// infer the token type of one key in default column family by its prefix
+// non-reserved prefix refers to the domain of one token
+std::optional<token_type>
+get_token_type_by_prefix(const name128& prefix) {
+    if(!prefix.reserved()) {
+        return token_type::token;
+    }
+    for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
+        if(action_key_prefixes[i] == prefix) {
+            return (token_type)i;
+        }
+    }
+    return std::nullopt;
+}
+
 using keys_hash_set = llvm::StringSet<llvm::MallocAllocator>;
 
 struct flag {
@@ -175,9 +302,107 @@ public:
     };
 };
 
+// actions of one group stored in a list of cache-line aligned chunks allocated from arena of the group
+// nothing is copied when it grows, and squashing two groups only links their lists
+class rt_actions {
+private:
+    static constexpr size_t kCacheLineSize     = 64;
+    static constexpr size_t kFirstChunkActions = 16;
+    static constexpr size_t kMaxChunkActions   = 112;  // keeps chunks within slabs of arena
+
+    struct chunk {
+        chunk*    next;
+        uint32_t  size;
+        uint32_t  capacity;
+
+        // actions follow the header in the same allocation
+        rt_action* items() { return (rt_action*)(this + 1); }
+    };
+
+public:
+    class iterator {
+    public:
+        iterator(chunk* c, uint32_t i) : c_(c), i_(i) {}
+
+        rt_action& operator*() const { return c_->items()[i_]; }
+        rt_action* operator->() const { return &c_->items()[i_]; }
+
+        iterator&
+        operator++() {
+            if(++i_ >= c_->size) {
+                c_ = c_->next;
+                i_ = 0;
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& rhs) const { return c_ == rhs.c_ && i_ == rhs.i_; }
+        bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+    private:
+        chunk*   c_;
+        uint32_t i_;
+    };
+
+public:
+    void
+    emplace_back(arena& mem, const rt_action& act) {
+        if(tail_ == nullptr || tail_->size >= tail_->capacity) {
+            auto cap = tail_ == nullptr ? kFirstChunkActions : std::min<size_t>(tail_->capacity * 2, kMaxChunkActions);
+            auto c   = (chunk*)mem.allocate(sizeof(chunk) + sizeof(rt_action) * cap, kCacheLineSize);
+            c->next     = nullptr;
+            c->size     = 0;
+            c->capacity = cap;
+
+            if(tail_ == nullptr) {
+                head_ = c;
+            }
+            else {
+                tail_->next = c;
+            }
+            tail_ = c;
+        }
+        new(&tail_->items()[tail_->size++]) rt_action(act);
+        size_++;
+    }
+
+    // moves all the actions of `rhs` to the end, chunks of `rhs` should be kept alive by merging its arena
+    void
+    splice(rt_actions& rhs) {
+        if(rhs.head_ == nullptr) {
+            return;
+        }
+        if(tail_ == nullptr) {
+            head_ = rhs.head_;
+        }
+        else {
+            tail_->next = rhs.head_;
+        }
+        tail_  = rhs.tail_;
+        size_ += rhs.size_;
+
+        rhs.head_ = rhs.tail_ = nullptr;
+        rhs.size_ = 0;
+    }
+
+    iterator begin() const { return iterator(head_, 0); }
+    iterator end() const { return iterator(nullptr, 0); }
+
+    bool   empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+private:
+    chunk* head_ = nullptr;
+    chunk* tail_ = nullptr;
+    size_t size_ = 0;
+};
+
+// group itself and data of its actions are allocated from `mem`
+// which is released at once when the group is freed
 struct rt_group {
-    const void*                rb_snapshot;
-    small_vector<rt_action, 4> actions;
+    const void* rb_snapshot;
+    rt_actions  actions;
+    arena*      mem;
 };
 
 // persistent action
@@ -206,6 +431,52 @@ public:
     };
 };
 
+// sum of the hashes of all the rows modulo 2^256, so rows can be added and removed in any order
+struct hash_accumulator {
+public:
+    void
+    add(const fc::sha256& h) {
+        auto carry = 0u;
+        for(auto i = 0u; i < words.size(); i++) {
+            auto w   = words[i] + h._hash[i];
+            auto c   = (unsigned)(w < words[i]);
+            words[i] = w + carry;
+            carry    = c | (unsigned)(words[i] < w);
+        }
+    }
+
+    void
+    sub(const fc::sha256& h) {
+        auto borrow = 0u;
+        for(auto i = 0u; i < words.size(); i++) {
+            auto w   = words[i] - h._hash[i];
+            auto b   = (unsigned)(w > words[i]);
+            words[i] = w - borrow;
+            borrow   = b | (unsigned)(words[i] > w);
+        }
+    }
+
+    fc::sha256
+    result() const {
+        auto h = fc::sha256();
+        memcpy(h._hash, words.data(), sizeof(h._hash));
+        return h;
+    }
+
+    static fc::sha256
+    hash_row(const std::string_view& key, const std::string_view& value) {
+        auto enc = fc::sha256::encoder();
+        auto sz  = (uint32_t)key.size();
+        enc.write((const char*)&sz, sizeof(sz));
+        enc.write(key.data(), key.size());
+        enc.write(value.data(), value.size());
+        return enc.result();
+    }
+
+public:
+    std::array<uint64_t, 4> words = {};
+};
+
 struct savepoint {
 public:
     savepoint() = default;
@@ -215,6 +486,9 @@ public:
 public:
     int64_t seq;
     sp_node node;
+
+    // state hash before this savepoint, empty if it's not known
+    std::optional<hash_accumulator> state_hash;
 };
 
 struct rt_token_key {
@@ -239,6 +513,28 @@ struct pd_header {
     int dirty_flag;
 };
 
+// derived state is only valid for the database with the same latest sequence and savepoint
+struct ds_header {
+    uint32_t   version;
+    uint64_t   db_seq;
+    int64_t    savepoint_seq;  // -1 if there's no savepoints
+    fc::sha256 checksum;       // hash of the payload following header
+};
+
+struct ds_payload {
+    std::vector<uint64_t> state_hash;   // words of state hash, empty if it's not maintained
+    std::vector<char>     link_filter;  // serialized evtlink filter, empty if it's not enabled
+};
+
+constexpr uint32_t kDerivedStateVersion = 1;
+constexpr uint32_t kWarmupBatchSize     = 256;
+
+// pins value owned by database itself, like the ones in write cache or hot tier, it's valid until database is changed
+void
+pin_value(rocksdb::PinnableSlice& out, const std::string& value) {
+    out.PinSlice(rocksdb::Slice(value), [](void*, void*) {}, nullptr, nullptr);
+}
+
 }  // namespace internal
 
 class write_cache_layer : boost::noncopyable {
@@ -258,25 +554,31 @@ private:
 
     struct data_op {
     public:
-        data_op(data_map_t::iterator& it, std::string&& pv)
-            : it(&(*it)), pv(std::move(pv)) {}
+        data_op(data_map_t::iterator& it, const std::string_view& pv)
+            : it(&(*it)), pv(pv) {}
 
     public:
         data_map_t::value_type* it;
-        std::string             pv;
+        std::string_view        pv;  // previous value, allocated from `mem` of its savepoint
     };
 
     struct data_ops {
         int64_t              seq;
         std::vector<data_op> vec;
+        arena*               mem;
     };
 
 public:
-    write_cache_layer() : ops_(internal::kDefaultSavePointsSize) {}
+    write_cache_layer()
+        : arenas_(internal::kMaxPooledArenasSize)
+        , ops_(internal::kDefaultSavePointsSize) {}
+    ~write_cache_layer() { clear(); }
 
 public:
     void put(const std::string_view& key, const std::string_view& value);
     int read(const std::string_view& key, std::string& value) const;
+    // value in cache without copying, it's valid until cache is changed
+    const std::string* find(const std::string_view& key) const;
     int exists(const std::string_view& key) const;
 
 public:
@@ -292,6 +594,7 @@ public:
 
 private:
     data_map_t                data_;
+    arena_pool                arenas_;
     fc::ring_vector<data_ops> ops_;
 
 private:
@@ -302,15 +605,18 @@ void
 write_cache_layer::put(const std::string_view& key, const std::string_view& value) {
     assert(!ops_.empty());
 
-    auto pair = data_.try_emplace(llvm::StringRef(key.data(), key.size()), 1, std::string(value.data(), value.size()));
+    auto& ops  = ops_.back();
+    auto  pair = data_.try_emplace(llvm::StringRef(key.data(), key.size()), 1, std::string(value.data(), value.size()));
     if(!pair.second) {
-        auto pv = std::move(pair.first->second.value);
-        pair.first->second.used_count += 1;
-        pair.first->second.value       = std::string(value.data(), value.size());
-        ops_.back().vec.emplace_back(data_op(pair.first, std::move(pv)));
+        // keep previous value in arena and reuse the buffer of entry
+        auto& entry = pair.first->second;
+        auto  pv    = ops.mem->copy(entry.value);
+        entry.used_count += 1;
+        entry.value.assign(value.data(), value.size());
+        ops.vec.emplace_back(data_op(pair.first, pv));
         return;
     }
-    ops_.back().vec.emplace_back(data_op(pair.first, std::string()));
+    ops.vec.emplace_back(data_op(pair.first, std::string_view()));
 }
 
 int
@@ -323,6 +629,15 @@ write_cache_layer::read(const std::string_view& key, std::string& value) const {
     return 1;
 }
 
+const std::string*
+write_cache_layer::find(const std::string_view& key) const {
+    auto it = data_.find(llvm::StringRef(key.data(), key.size()));
+    if(it == data_.end()) {
+        return nullptr;
+    }
+    return &it->second.value;
+}
+
 int
 write_cache_layer::exists(const std::string_view& key) const {
     return data_.find(llvm::StringRef(key.data(), key.size())) != data_.end();
@@ -330,7 +645,7 @@ write_cache_layer::exists(const std::string_view& key) const {
 
 void
 write_cache_layer::add_savepoint(int64_t seq) {
-    ops_.push_back(data_ops{ .seq = seq, .vec = {} });
+    ops_.push_back(data_ops{ .seq = seq, .vec = {}, .mem = arenas_.acquire() });
 }
 
 void
@@ -343,9 +658,10 @@ write_cache_layer::rollback_to_latest_savepoint() {
         }
         else {
             assert(!op.it->second.value.empty());
-            op.it->second.value = std::move(op.pv);
+            op.it->second.value.assign(op.pv.data(), op.pv.size());
         }
     }
+    arenas_.release(ops.mem);
     ops_.pop_back();
 }
 
@@ -356,6 +672,8 @@ write_cache_layer::squash() {
     auto& b2 = ops_[ops_.size() - 2];
 
     b2.vec.insert(b2.vec.end(), b1.vec.begin(), b1.vec.end());
+    b2.mem->merge(*b1.mem);
+    arenas_.release(b1.mem);
     ops_.pop_back();
 }
 
@@ -368,11 +686,13 @@ write_cache_layer::pop_front(std::function<void(const llvm::StringRef&, std::str
         }
     }
 
+    arenas_.release(ops_.front().mem);
     ops_.pop_front();
 }
 
 void
 write_cache_layer::pop_back() {
+    arenas_.release(ops_.back().mem);
     ops_.pop_back();
 }
 
@@ -392,6 +712,9 @@ struct wc_entry_pack {
 
 void
 write_cache_layer::clear() {
+    for(auto i = 0; i < ops_.size(); i++) {
+        arenas_.release(ops_[i].mem);
+    }
     data_.clear();
     ops_.clear();
 }
@@ -432,1007 +755,3881 @@ write_cache_layer::load_savepoints(std::istream& is) {
     }
 }
 
-class token_database_impl : boost::noncopyable {
+// tailing iterators see the latest writes once they're re-seeked, so range reads reuse them
+// instead of creating new ones and acquiring superversions each time, it's only used on writing thread
+class iterator_pool : boost::noncopyable {
 public:
-    token_database_impl(token_database& self, const token_database::config& config);
+    struct releaser {
+    public:
+        void
+        operator()(rocksdb::Iterator* it) const {
+            if(pool == nullptr) {
+                delete it;
+                return;
+            }
+            pool->release(handle, it);
+        }
 
-public:
-    void open(int load_persistence = true);
-    void close(int persist = true);
+    public:
+        iterator_pool*                pool;
+        rocksdb::ColumnFamilyHandle*  handle;
+    };
+    using iterator_ptr = std::unique_ptr<rocksdb::Iterator, releaser>;
 
 public:
-    void put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data);
-    void put_tokens(token_type type,
-                    action_op op,
-                    const name128& prefix,
-                    token_keys_t&& keys,
-                    const small_vector_base<std::string_view>& data);
-    void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
-
-    int exists_token(const name128& prefix, const name128& key) const;
-    int exists_asset(const address& addr, const symbol_id_type sym_id) const;
-
-    int read_token(const name128& prefix, const name128& key, std::string& out, bool no_throw = false) const;
-    int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
+    // non-tailing iterators are pinned to the state when they're created, so they're never pooled
+    iterator_ptr
+    acquire(rocksdb::DB* db, const rocksdb::ReadOptions& opts, rocksdb::ColumnFamilyHandle* handle) {
+        if(!opts.tailing || opts.snapshot != nullptr) {
+            return iterator_ptr(db->NewIterator(opts, handle), releaser { nullptr, handle });
+        }
 
-    int read_tokens_range(const name128& prefix, int skip, const read_value_func& func) const;
-    int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+        auto& free = free_[handle];
+        if(free.empty()) {
+            return iterator_ptr(db->NewIterator(opts, handle), releaser { this, handle });
+        }
+        auto it = free.back().release();
+        free.pop_back();
+        return iterator_ptr(it, releaser { this, handle });
+    }
 
-public:
-    void add_savepoint(int64_t seq);
-    void rollback_to_latest_savepoint();
-    void pop_savepoints(int64_t until);
-    void pop_back_savepoint();
-    void squash();
+    // should be called before column families are dropped
+    void clear() { free_.clear(); }
 
-    int64_t latest_savepoint_seq() const;
-    int64_t new_savepoint_session_seq() const;
-    size_t  savepoints_size() const { return savepoints_.size(); }
+private:
+    void
+    release(rocksdb::ColumnFamilyHandle* handle, rocksdb::Iterator* it) {
+        auto& free = free_[handle];
+        if(free.size() >= internal::kMaxPooledIterators || !it->status().ok()) {
+            delete it;
+            return;
+        }
+        free.emplace_back(it);
+    }
 
-    void rollback_rt_group(internal::rt_group*);
-    void rollback_pd_group(internal::pd_group*);
+private:
+    std::unordered_map<rocksdb::ColumnFamilyHandle*, std::vector<std::unique_ptr<rocksdb::Iterator>>> free_;
+};
 
-    int should_record() { return !savepoints_.empty(); }
+namespace internal {
 
-    void record(uint8_t action_type, uint8_t op, uint8_t data_type, void* data);
-    void free_savepoint(internal::savepoint&);
-    void free_all_savepoints();
+// values of one symbol in iterator merged with the pending ones by key order, pending values override the ones in db
+// `pendings` should be sorted by key
+int
+merge_assets_range(rocksdb::Iterator& it,
+                   const symbol_id_type sym_id,
+                   const std::vector<std::pair<std::string_view, const std::string*>>& pendings,
+                   int skip,
+                   const read_value_func& func) {
+    auto key   = rocksdb::Slice((char*)&sym_id, sizeof(sym_id));
+    auto pit   = pendings.cbegin();
+    auto i     = 0;
+    auto count = 0;
 
-    void persist_savepoints() const;
-    void load_savepoints();
-    void persist_savepoints(std::ostream&) const;
-    void load_savepoints(std::istream&);
-    void flush() const;
+    auto next = [&](auto& k, auto&& v) {
+        if(i++ < skip) {
+            return true;
+        }
+        count++;
+        return func(k.substr(sizeof(sym_id)), std::move(v));
+    };
 
-    std::string get_db_path() const { return config_.db_path.to_native_ansi_path(); }
+    it.Seek(key);
+    while(it.Valid() && it.key().starts_with(key)) {
+        auto dk = it.key().ToStringView();
+        while(pit != pendings.cend() && pit->first < dk) {
+            if(!next(pit->first, std::string(*pit->second))) {
+                return count;
+            }
+            pit++;
+        }
+        if(pit != pendings.cend() && pit->first == dk) {
+            if(!next(pit->first, std::string(*pit->second))) {
+                return count;
+            }
+            pit++;
+        }
+        else if(!next(dk, it.value().ToString())) {
+            return count;
+        }
+        it.Next();
+    }
+    for(; pit != pendings.cend(); pit++) {
+        if(!next(pit->first, std::string(*pit->second))) {
+            return count;
+        }
+    }
+    return count;
+}
 
+// key of token or asset, both are shorter than `data`
+struct hot_key {
 public:
-    token_database&        self_;
-    token_database::config config_;
-
-    rocksdb::DB*          db_;
-    rocksdb::ReadOptions  read_opts_;
-    rocksdb::WriteOptions write_opts_;
+    hot_key() : size(0) {}
+    hot_key(const std::string_view& key)
+        : size(key.size()) {
+        assert(key.size() <= sizeof(data));
+        memcpy(data, key.data(), key.size());
+    }
 
-    rocksdb::ColumnFamilyHandle* tokens_handle_;
-    rocksdb::ColumnFamilyHandle* assets_handle_;
+public:
+    std::string_view as_string_view() const { return std::string_view(data, size); }
 
-    write_cache_layer assets_write_cache_;
+    bool
+    operator==(const hot_key& rhs) const {
+        return size == rhs.size && memcmp(data, rhs.data, size) == 0;
+    }
 
-    fc::ring_vector<internal::savepoint> savepoints_;
+public:
+    uint8_t size;
+    char    data[kSymbolIdSize + kPublicKeySize];
 };
 
-token_database_impl::token_database_impl(token_database& self, const token_database::config& config)
-    : self_(self)
-    , config_(config)
-    , db_(nullptr)
-    , read_opts_()
-    , write_opts_()
-    , tokens_handle_(nullptr)
-    , assets_handle_(nullptr)
-    , savepoints_(internal::kDefaultSavePointsSize) {}
-
-void
-token_database_impl::open(int load_persistence) {
-    using namespace rocksdb;
-    using namespace internal;
+struct hot_key_hasher {
+    size_t
+    operator()(const hot_key& key) const {
+        return std::hash<std::string_view>()(key.as_string_view());
+    }
+};
 
-    EVT_ASSERT(db_ == nullptr, token_database_exception, "Token database is already opened");
+// in-process tier of the frequently written keys used in hybrid profile
+// values are written through into rocksdb, so cold keys are always served from block-based tables
+// it's only populated on the write path, reads never change it and can be made from read-only paths
+// writes of each key are counted, the key is promoted with its value once it's written `kHotPromoteHits` times
+// counts are halved every `kHotDecayInterval` writes and keys whose counts drop to zero are demoted
+// rows mostly read during applying, like domains and fungibles, are served by token_database_cache instead
+class hot_tier : boost::noncopyable {
+private:
+    struct entry {
+        uint32_t    hits = 0;
+        bool        hot  = false;
+        std::string value;
+    };
 
-    auto options = Options();
-    options.OptimizeUniversalStyleCompaction();
+public:
+    hot_tier(size_t capacity)
+        : capacity_(capacity)
+        , bytes_(0)
+        , writes_(0) {
+        map_.set_empty_key(hot_key());
+        map_.set_deleted_key(hot_key(std::string_view("\0", 1)));
+    }
 
-    options.create_if_missing               = true;
-    options.compression                     = CompressionType::kLZ4Compression;
-    options.bottommost_compression          = CompressionType::kZSTD;
-    options.allow_concurrent_memtable_write = false;
-    options.prefix_extractor.reset(NewFixedPrefixTransform(sizeof(name128)));
-    options.memtable_factory.reset(NewHashSkipListRepFactory());
-    if(config_.enable_stats) {
-        options.statistics = rocksdb::CreateDBStatistics();
-#if ROCKSDB_MAJOR >= 6
-        options.statistics->set_stats_level(StatsLevel::kExceptTimeForMutex);
-#else
-        options.statistics->stats_level_ = StatsLevel::kExceptTimeForMutex;
-#endif
+public:
+    // returns value if key is hot
+    const std::string*
+    read(const std::string_view& key) const {
+        auto it = map_.find(hot_key(key));
+        if(it == map_.end() || !it->second.hot) {
+            return nullptr;
+        }
+        return &it->second.value;
     }
 
-    auto assets_options = ColumnFamilyOptions(options);
+    int
+    exists(const std::string_view& key) const {
+        auto it = map_.find(hot_key(key));
+        return it != map_.end() && it->second.hot;
+    }
 
-    if(config_.profile == storage_profile::disk) {
-        auto table_opts = BlockBasedTableOptions();
+    // counts the write and keeps value of hot key the same as the one in db
+    // key is promoted with the value if it's written frequently
+    void
+    update(const std::string_view& key, const std::string_view& value) {
+        if(++writes_ >= kHotDecayInterval) {
+            decay();
+        }
 
-        table_opts.index_type     = BlockBasedTableOptions::kHashSearch;
-        table_opts.checksum       = kxxHash64;
-        table_opts.format_version = 4;
-        table_opts.block_cache    = NewLRUCache(config_.block_cache_size);
-        table_opts.filter_policy.reset(NewBloomFilterPolicy(10, false));
+        auto& e = map_[hot_key(key)];
+        e.hits++;
+        if(!e.hot) {
+            if(e.hits < kHotPromoteHits) {
+                return;
+            }
+            e.hot = true;
+        }
+        else {
+            bytes_ -= e.value.size();
+        }
+        e.value.assign(value.data(), value.size());
+        bytes_ += value.size();
 
-        options.table_factory.reset(NewBlockBasedTableFactory(table_opts));
-        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+        while(bytes_ > capacity_) {
+            decay();
+        }
     }
-    else if(config_.profile == storage_profile::memory) {
-        auto tokens_table_options = PlainTableOptions();
-        auto assets_table_options = PlainTableOptions();
-        tokens_table_options.user_key_len = sizeof(name128) + sizeof(name128);
-        assets_table_options.user_key_len = kPublicKeySize + kSymbolIdSize;
 
-        options.table_factory.reset(NewPlainTableFactory(tokens_table_options));
-        assets_options.table_factory.reset(NewPlainTableFactory(assets_table_options));
-        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+    void
+    remove(const std::string_view& key) {
+        auto it = map_.find(hot_key(key));
+        if(it == map_.end()) {
+            return;
+        }
+        if(it->second.hot) {
+            bytes_ -= it->second.value.size();
+        }
+        map_.erase(it);
     }
-    else {
-        EVT_THROW(token_database_exception, "Unknown token database profile");
+
+    void
+    clear() {
+        map_.clear();
+        bytes_ = 0;
+        writes_ = 0;
     }
 
-    read_opts_.total_order_seek     = false;
-    read_opts_.prefix_same_as_start = true;
-    read_opts_.tailing              = true;
+    size_t size() const { return map_.size(); }
+    size_t bytes() const { return bytes_; }
 
-    auto columns = std::vector<ColumnFamilyDescriptor>();
-    auto handles = std::vector<ColumnFamilyHandle*>();
-    columns.emplace_back(kDefaultColumnFamilyName, options);
+private:
+    void
+    decay() {
+        for(auto it = map_.begin(); it != map_.end(); it++) {
+            auto& e = it->second;
+            if((e.hits >>= 1) == 0) {
+                if(e.hot) {
+                    bytes_ -= e.value.size();
+                }
+                map_.erase(it);
+            }
+        }
+        writes_ = 0;
+    }
 
-    if(!fc::exists(config_.db_path)) {
-        auto t = config_.db_path.to_native_ansi_path();
-        // create new database and open
-        fc::create_directories(config_.db_path);
-        
-        auto status  = DB::Open(options, config_.db_path.to_native_ansi_path(), columns, &handles, &db_);
-        if(!status.ok()) {
-            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-        }
+private:
+    size_t capacity_;
+    size_t bytes_;
+    size_t writes_;
+
+    google::dense_hash_map<hot_key, entry, hot_key_hasher> map_;
+};
 
-        assert(handles.size() == 1);
-        tokens_handle_ = handles[0];
+// in-memory bloom filter of all the keys of one token type, used to answer the lookups of missing keys without rocksdb
+// keys are never removed, so rolled back keys are only false positives
+// it grows by appending filters of doubled capacity instead of rebuilding, each key is checked against all of them
+class key_filter : boost::noncopyable {
+private:
+    struct filter {
+        std::vector<uint64_t> bits;
+        size_t                capacity;
+        size_t                size;
+    };
 
-        status = db_->CreateColumnFamily(assets_options, kAssetsColumnFamilyName, &assets_handle_);
-        if(!status.ok()) {
-            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-        }
+public:
+    key_filter() { grow(kKeyFilterInitialKeys); }
 
-        if(load_persistence) {
-            load_savepoints();
+public:
+    void
+    add(const std::string_view& key) {
+        auto& f = filters_.back();
+        if(f.size >= f.capacity) {
+            grow(f.capacity * 2);
         }
-        return;
+        auto& b  = filters_.back();
+        auto  n  = b.bits.size() * 64;
+        auto  h1 = fc::city_hash64(key.data(), key.size());
+        auto  h2 = (h1 >> 33) | (h1 << 31);
+        for(auto i = 0u; i < kKeyFilterProbes; i++) {
+            auto pos = (h1 + i * h2) % n;
+            b.bits[pos / 64] |= (1ull << (pos % 64));
+        }
+        b.size++;
     }
 
-    columns.emplace_back(kAssetsColumnFamilyName, assets_options);
-
-    auto status = DB::Open(options, config_.db_path.to_native_ansi_path(), columns, &handles, &db_);
-    if(!status.ok()) {
-        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    bool
+    may_contain(const std::string_view& key) const {
+        auto h1 = fc::city_hash64(key.data(), key.size());
+        auto h2 = (h1 >> 33) | (h1 << 31);
+        for(auto& f : filters_) {
+            auto n     = f.bits.size() * 64;
+            auto found = true;
+            for(auto i = 0u; i < kKeyFilterProbes && found; i++) {
+                auto pos = (h1 + i * h2) % n;
+                found    = (f.bits[pos / 64] & (1ull << (pos % 64))) != 0;
+            }
+            if(found) {
+                return true;
+            }
+        }
+        return false;
     }
 
-    assert(handles.size() == 2);
-    tokens_handle_ = handles[0];
-    assets_handle_ = handles[1];
-
-    if(load_persistence) {
-        load_savepoints();
+    size_t
+    size() const {
+        auto sz = size_t(0);
+        for(auto& f : filters_) {
+            sz += f.size;
+        }
+        return sz;
     }
-}
 
-void
-token_database_impl::close(int persist) {
-    if(db_) {
-        if(persist) {
-            persist_savepoints();
+    template<typename Stream>
+    void
+    persist(Stream& ds) const {
+        fc::raw::pack(ds, (uint32_t)filters_.size());
+        for(auto& f : filters_) {
+            fc::raw::pack(ds, (uint64_t)f.capacity);
+            fc::raw::pack(ds, (uint64_t)f.size);
+            fc::raw::pack(ds, f.bits);
         }
-        if(!savepoints_.empty()) {
-            free_all_savepoints();
+    }
+
+    void
+    load(fc::datastream<const char*>& ds) {
+        auto n = uint32_t();
+        fc::raw::unpack(ds, n);
+        filters_.clear();
+        filters_.resize(n);
+        for(auto& f : filters_) {
+            auto capacity = uint64_t(), size = uint64_t();
+            fc::raw::unpack(ds, capacity);
+            fc::raw::unpack(ds, size);
+            fc::raw::unpack(ds, f.bits);
+            f.capacity = capacity;
+            f.size     = size;
         }
-        
-        delete tokens_handle_;
-        delete assets_handle_;
-        delete db_;
+        EVT_ASSERT(!filters_.empty(), token_database_exception, "Not valid evtlink filter");
+    }
 
-        db_ = nullptr;
+private:
+    void
+    grow(size_t capacity) {
+        auto& f    = filters_.emplace_back();
+        f.capacity = capacity;
+        f.size     = 0;
+        f.bits.resize((capacity * kKeyFilterBitsPerKey + 63) / 64);
     }
-}
 
-void
-token_database_impl::put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data) {
-    using namespace internal;
+private:
+    std::vector<filter> filters_;
+};
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto status = db_->Put(write_opts_, dbkey.as_slice(), data);
-    if(!status.ok()) {
-        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-    }
-    if(should_record()) {
-        void* data;
+// approximate frequencies of the keys read and written in a sliding window, counted by count-min sketches.
+// window is made of two halves: sketch of the older half is dropped when current half is over,
+// so counts cover between one and two halves. `top_k` heaviest keys of each type are kept as candidates
+class key_heat_tracker : boost::noncopyable {
+private:
+    static constexpr int    kDepth = 4;
+    static constexpr size_t kWidth = 4096;
 
-        // for `token` action, needs to record both prefix and key, prefix refers to the domain
-        // for `non-token` action, prefix is not necessary which can be inferred by the `type`
-        if(type != token_type::token) {
-            assert(prefix == action_key_prefixes[(int)type]);
-            auto data = (rt_token_key*)malloc(sizeof(rt_token_key));
-            data->key = key;
+    struct cell {
+        uint32_t reads  = 0;
+        uint32_t writes = 0;
+    };
 
-            record((int)type, (int)op, (int)kTokenKey, data);
+    using sketch = std::array<std::array<cell, kWidth>, kDepth>;
+
+    struct candidate {
+        std::string key;
+        uint64_t    heat;
+    };
+
+public:
+    struct key_heat {
+        std::string key;
+        uint64_t    reads;
+        uint64_t    writes;
+    };
+
+public:
+    key_heat_tracker(size_t top_k, uint32_t window_secs)
+        : top_k_(top_k)
+        , half_(std::chrono::seconds(std::max(window_secs / 2, 1u)))
+        , current_(std::make_unique<sketch>())
+        , previous_(std::make_unique<sketch>())
+        , rotated_(std::chrono::steady_clock::now()) {}
+
+public:
+    void
+    add(token_type type, const std::string_view& key, bool write) {
+        auto now = std::chrono::steady_clock::now();
+        if(now - rotated_ >= half_) {
+            rotate(now);
         }
-        else {
-            auto data    = (rt_token_fullkey*)malloc(sizeof(rt_token_fullkey));
-            data->prefix = prefix;
-            data->key    = key;
 
-            record((int)type, (int)op, (int)kTokenFullKey, data);
+        auto h = hash(type, key);
+        for(auto i = 0; i < kDepth; i++) {
+            auto& c = (*current_)[i][index(h, i)];
+            (write ? c.writes : c.reads)++;
         }
-    }
-}
 
-void
-token_database_impl::put_tokens(token_type type,
-                                action_op op,
-                                const name128& prefix,
-                                token_keys_t&& keys,
-                                const small_vector_base<std::string_view>& data){
-    using namespace internal;
-    assert(keys.size() == data.size());
+        auto  heat     = estimate(h);
+        auto  heat_sum = heat.reads + heat.writes;
+        auto& cands    = candidates_[(int)type];
 
-    for(auto i = 0u; i < keys.size(); i++) {
-        auto dbkey  = db_token_key(prefix, keys[i]);
-        auto status = db_->Put(write_opts_, dbkey.as_slice(), data[i]);
-        if(!status.ok()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        auto min = cands.end();
+        for(auto it = cands.begin(); it != cands.end(); it++) {
+            if(it->key == key) {
+                it->heat = heat_sum;
+                return;
+            }
+            if(min == cands.end() || it->heat < min->heat) {
+                min = it;
+            }
+        }
+        if(cands.size() < top_k_) {
+            cands.emplace_back(candidate { std::string(key), heat_sum });
+        }
+        else if(min != cands.end() && min->heat < heat_sum) {
+            min->key.assign(key.data(), key.size());
+            min->heat = heat_sum;
         }
     }
-    if(should_record()) {
-        auto data = (rt_token_keys*)malloc(sizeof(rt_token_keys));
-        data->prefix = prefix;
-        new(&data->keys) token_keys_t(std::move(keys));
 
-        record((int)type, (int)op, (int)kTokenKeys, data);
+    // hottest keys of `type` in descending order of accesses
+    std::vector<key_heat>
+    top(token_type type) const {
+        auto rs = std::vector<key_heat>();
+        for(auto& c : candidates_[(int)type]) {
+            auto heat = estimate(hash(type, c.key));
+            heat.key  = c.key;
+            rs.emplace_back(std::move(heat));
+        }
+        std::sort(rs.begin(), rs.end(), [](auto& a, auto& b) {
+            return a.reads + a.writes > b.reads + b.writes;
+        });
+        return rs;
     }
-}
 
-void
-token_database_impl::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
-    using namespace internal;
+private:
+    static uint64_t
+    hash(token_type type, const std::string_view& key) {
+        return fc::city_hash64(key.data(), key.size()) ^ ((uint64_t)type * 0x9e3779b97f4a7c15ull);
+    }
 
-    auto dbkey = db_asset_key(addr, sym_id);
-    if(should_record()) {
-        assets_write_cache_.put(dbkey.as_string_view(), data);
-        return;
+    // rows are indexed by double hashing from the halves of one hash
+    static size_t
+    index(uint64_t h, int row) {
+        return ((uint32_t)h + row * (uint32_t)(h >> 32)) & (kWidth - 1);
     }
-    else {
-        auto status = db_->Put(write_opts_, assets_handle_, dbkey.as_slice(), data);
-        if(!status.ok()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+
+    key_heat
+    estimate(uint64_t h) const {
+        auto heat = key_heat { {}, UINT64_MAX, UINT64_MAX };
+        for(auto i = 0; i < kDepth; i++) {
+            auto  j = index(h, i);
+            auto& c = (*current_)[i][j];
+            auto& p = (*previous_)[i][j];
+            heat.reads  = std::min<uint64_t>(heat.reads, (uint64_t)c.reads + p.reads);
+            heat.writes = std::min<uint64_t>(heat.writes, (uint64_t)c.writes + p.writes);
         }
+        return heat;
     }
-}
 
-int
-token_database_impl::exists_token(const name128& prefix, const name128& key) const {
-    using namespace internal;
+    void
+    rotate(std::chrono::steady_clock::time_point now) {
+        std::swap(current_, previous_);
+        current_->fill({});
+        // two halves are passed without any accesses
+        if(now - rotated_ >= half_ * 2) {
+            previous_->fill({});
+        }
+        rotated_ = now;
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto value  = std::string();
-    auto status = db_->Get(read_opts_, dbkey.as_slice(), &value);
-    return status.ok();
-}
+        for(auto i = 0u; i < candidates_.size(); i++) {
+            auto& cands = candidates_[i];
+            for(auto& c : cands) {
+                auto heat = estimate(hash((token_type)i, c.key));
+                c.heat    = heat.reads + heat.writes;
+            }
+            cands.erase(std::remove_if(cands.begin(), cands.end(), [](auto& c) { return c.heat == 0; }), cands.end());
+        }
+    }
 
-int
-token_database_impl::exists_asset(const address& addr, const symbol_id_type sym_id) const {
-    using namespace internal;
+private:
+    size_t                                top_k_;
+    std::chrono::steady_clock::duration   half_;
+    std::unique_ptr<sketch>               current_;
+    std::unique_ptr<sketch>               previous_;
+    std::chrono::steady_clock::time_point rotated_;
 
-    auto dbkey  = db_asset_key(addr, sym_id);
-    auto value  = std::string();
+    std::array<std::vector<candidate>, (int)token_type::max_value + 1> candidates_;
+};
 
-    if(assets_write_cache_.exists(dbkey.as_string_view())) {
-        return true;
-    }
-    auto status = db_->Get(read_opts_, assets_handle_, dbkey.as_slice(), &value);
-    return status.ok();
-}
+struct hardware_info {
+    uint32_t cores;
+    uint64_t memory;
+    bool     rotational;
+};
 
-int
-token_database_impl::read_token(const name128& prefix, const name128& key, std::string& out, bool no_throw) const {
-    using namespace internal;
+hardware_info
+detect_hardware(const fc::path& db_path) {
+    auto hw = hardware_info();
+    hw.cores      = std::max(std::thread::hardware_concurrency(), 1u);
+    hw.memory     = (uint64_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    hw.rotational = false;
+
+    // database may not be created yet, the nearest existing parent is on the same device
+    auto p = db_path;
+    for(auto i = 0; i < 16 && !p.generic_string().empty() && !fc::exists(p); i++) {
+        p = p.parent_path();
+    }
+    struct stat st;
+    if(::stat(p.generic_string().c_str(), &st) != 0) {
+        return hw;
+    }
 
-    auto dbkey  = db_token_key(prefix, key);
-    auto status = db_->Get(read_opts_, dbkey.as_slice(), &out);
-    if(!status.ok()) {
-        if(!status.IsNotFound()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-        }
-        if(!no_throw) {
-            EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",key)("p",prefix));
+    // device of a partition has no queue, its parent disk has
+    auto dev = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    for(auto f : { "/queue/rotational", "/../queue/rotational" }) {
+        auto in = std::ifstream(dev + f);
+        auto v  = 0;
+        if(in >> v) {
+            hw.rotational = (v == 1);
+            break;
         }
-        return false;
     }
-    return true;
+    return hw;
 }
 
-int
-token_database_impl::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
-    using namespace internal;
+void
+apply_tuning(rocksdb::Options& options, tuning_profile profile, const hardware_info& hw) {
+    constexpr auto kMB = uint64_t(1024 * 1024);
 
-    auto key = db_asset_key(addr, sym_id);
-    if(assets_write_cache_.read(key.as_string_view(), out)) {
-        return true;
+    auto clamp = [](uint64_t v, uint64_t lo, uint64_t hi) {
+        return std::min(std::max(v, lo), hi);
+    };
+
+    switch(profile) {
+    case tuning_profile::none: {
+        return;
+    }
+    case tuning_profile::producer: {
+        // latency of applying blocks comes first: compaction should never stall writes, and short flushes
+        options.max_background_jobs     = (int)clamp(hw.cores / 4, 2, 8);
+        options.write_buffer_size       = clamp(hw.memory / 128, 32 * kMB, 128 * kMB);
+        options.max_write_buffer_number = 4;
+        break;
+    }
+    case tuning_profile::api: {
+        // reads compete with compaction, fewer background jobs and larger memtables to absorb the writes
+        options.max_background_jobs     = (int)clamp(hw.cores / 8, 2, 4);
+        options.write_buffer_size       = clamp(hw.memory / 64, 64 * kMB, 256 * kMB);
+        options.max_write_buffer_number = 3;
+        break;
     }
+    case tuning_profile::archive: {
+        // throughput of replaying long histories
+        options.max_background_jobs              = (int)clamp(hw.cores / 2, 4, 16);
+        options.max_subcompactions               = hw.rotational ? 1 : (uint32_t)clamp(hw.cores / 4, 1, 8);
+        options.write_buffer_size                = clamp(hw.memory / 32, 128 * kMB, 512 * kMB);
+        options.max_write_buffer_number          = 6;
+        options.min_write_buffer_number_to_merge = 2;
+        break;
+    }
+    }  // switch
 
-    auto status = db_->Get(read_opts_, assets_handle_, key.as_slice(), &out);
-    if(!status.ok()) {
-        if(!status.IsNotFound()) {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-        }
-        if(!no_throw) {
-            EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", sym_id, addr);
-        }
-        return false;
+    options.bytes_per_sync = kMB;
+    if(hw.rotational) {
+        // compaction saturates spinning disks easily, limit it so that reads and syncs still get through
+        auto rate = (profile == tuning_profile::archive) ? 96 * kMB : 48 * kMB;
+        options.rate_limiter.reset(rocksdb::NewGenericRateLimiter(rate));
+        options.compaction_readahead_size = 2 * kMB;
     }
-    return true;
 }
 
-int
-token_database_impl::read_tokens_range(const name128& prefix, int skip, const read_value_func& func) const {
-    using namespace internal;
+// db options and the tunables of default column family are taken from the file,
+// the ones deciding the format of data (table, memtable and prefix extractor) are kept
+void
+load_options_file(rocksdb::Options& options, const fc::path& file) {
+    using namespace rocksdb;
 
-    auto it    = db_->NewIterator(read_opts_);
-    auto key   = rocksdb::Slice((char*)&prefix, sizeof(prefix));
-    auto i     = 0;
-    auto count = 0;
-    
-    it->Seek(key);
-    while(it->Valid()) {
-        if(i++ < skip) {
-            it->Next();
-            continue;
-        }
+    auto db_opts = DBOptions();
+    auto cfs     = std::vector<ColumnFamilyDescriptor>();
+    auto status  = LoadOptionsFromFile(file.to_native_ansi_path(), Env::Default(), &db_opts, &cfs, true /* ignore_unknown_options */);
+    EVT_ASSERT(status.ok(), token_database_exception, "Cannot load rocksdb options file: ${f}, ${err}", ("f", file)("err", status.getState()));
 
-        count++;
-        auto value = it->value().ToString();
-        auto key   = it->key();
+    // non-serializable ones are never in the file
+    auto statistics   = options.statistics;
+    auto rate_limiter = options.rate_limiter;
 
-        key.remove_prefix(sizeof(prefix));
-        if(!func(key.ToStringView(), std::move(value))) {
-            delete it;
-            return count;
+    static_cast<DBOptions&>(options) = db_opts;
+    options.create_if_missing        = true;
+    options.statistics               = statistics;
+    options.rate_limiter             = rate_limiter;
+
+    for(auto& cf : cfs) {
+        if(cf.name != kDefaultColumnFamilyName) {
+            continue;
         }
-        it->Next();
+        auto& o = cf.options;
+        options.write_buffer_size                  = o.write_buffer_size;
+        options.max_write_buffer_number            = o.max_write_buffer_number;
+        options.min_write_buffer_number_to_merge   = o.min_write_buffer_number_to_merge;
+        options.target_file_size_base              = o.target_file_size_base;
+        options.max_bytes_for_level_base           = o.max_bytes_for_level_base;
+        options.level0_file_num_compaction_trigger = o.level0_file_num_compaction_trigger;
+        options.level0_slowdown_writes_trigger     = o.level0_slowdown_writes_trigger;
+        options.level0_stop_writes_trigger         = o.level0_stop_writes_trigger;
+        options.compression                        = o.compression;
+        options.bottommost_compression             = o.bottommost_compression;
+        options.compaction_options_universal       = o.compaction_options_universal;
     }
-    delete it;
-    return count;
 }
 
-int
-token_database_impl::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
-    using namespace internal;
+// operand of appending one item to the vector serialized at `pos` of the value, which has `size` items before
+struct append_operand {
+    uint32_t         pos;
+    uint32_t         size;
+    std::string_view item;
 
-    // create snapshot first
-    auto ss = db_->GetSnapshot();
-    
-    // write new values from cache into db
-    for(auto& it : assets_write_cache_.data_) {
-        auto k = rocksdb::Slice(it.first().data(), it.first().size());
-        auto v = rocksdb::Slice(it.second.value.data(), it.second.value.size());
-        db_->Put(write_opts_, assets_handle_, k, v);
+    std::string
+    pack() const {
+        auto str = std::string(sizeof(pos) + sizeof(size) + item.size(), '\0');
+        memcpy(str.data(), &pos, sizeof(pos));
+        memcpy(str.data() + sizeof(pos), &size, sizeof(size));
+        memcpy(str.data() + sizeof(pos) + sizeof(size), item.data(), item.size());
+        return str;
     }
 
-    // scan values
-    auto it    = db_->NewIterator(read_opts_, assets_handle_);
-    auto key   = rocksdb::Slice((char*)&sym_id, sizeof(sym_id));
-    auto count = 0;
-    auto i     = 0;
-    
-    it->Seek(key);
-    while(it->Valid()) {
-        if(i++ < skip) {
-            it->Next();
-            continue;
+    static std::optional<append_operand>
+    unpack(const rocksdb::Slice& s) {
+        auto op = append_operand();
+        if(s.size() < sizeof(op.pos) + sizeof(op.size)) {
+            return std::nullopt;
         }
+        memcpy(&op.pos, s.data(), sizeof(op.pos));
+        memcpy(&op.size, s.data() + sizeof(op.pos), sizeof(op.size));
+        op.item = std::string_view(s.data() + sizeof(op.pos) + sizeof(op.size), s.size() - sizeof(op.pos) - sizeof(op.size));
+        return op;
+    }
+};
 
-        count++;
-        auto value = it->value().ToString();
-        auto key   = it->key();
+// appends the items of operands to the vectors at the tail of the values, like the metas of domains and tokens.
+// only the count of vector is rewritten and other bytes are copied, nothing is unpacked here.
+// mismatched count means the operand is not built from the latest value, which is reported as corruption
+class append_merge_operator : public rocksdb::MergeOperator {
+public:
+    bool
+    FullMergeV2(const MergeOperationInput& in, MergeOperationOutput* out) const override {
+        if(in.existing_value == nullptr) {
+            return false;
+        }
 
-        key.remove_prefix(sizeof(sym_id));
-        if(!func(key.ToStringView(), std::move(value))) {
-            delete it;
-            return count;
+        auto value = std::string(in.existing_value->data(), in.existing_value->size());
+        for(auto& operand : in.operand_list) {
+            auto op = append_operand::unpack(operand);
+            if(!op.has_value() || op->pos >= value.size()) {
+                return false;
+            }
+
+            auto ds   = fc::datastream<const char*>(value.data() + op->pos, value.size() - op->pos);
+            auto size = fc::unsigned_int();
+            try {
+                fc::raw::unpack(ds, size);
+            }
+            catch(...) {
+                return false;
+            }
+            if(size.value != op->size) {
+                return false;
+            }
+
+            auto used = value.size() - op->pos - ds.remaining();
+            auto next = fc::raw::pack(fc::unsigned_int(op->size + 1));
+            value.replace(op->pos, used, next.data(), next.size());
+            value.append(op->item.data(), op->item.size());
         }
-        it->Next();
+
+        out->new_value = std::move(value);
+        return true;
     }
-    delete it;
 
-    // restore values
-    auto snapshot_read_opts_     = read_opts_;
-    snapshot_read_opts_.snapshot = ss;
+    const char* Name() const override { return "evt.append"; }
+};
 
-    auto batch = rocksdb::WriteBatch();
-    for(auto& it : assets_write_cache_.data_) {
-        auto v = std::string();
-        auto k = rocksdb::Slice(it.first().data(), it.first().size());
-        auto s = db_->Get(snapshot_read_opts_, assets_handle_, k, &v);
-        if(s.ok()) {
-            // put value back
-            batch.Put(assets_handle_, k, v);
+// drops evtlinks paid in the blocks before `before`, replays of them are rejected by timestamps long ago
+// it's shared by all the compactions so only atomics are touched
+class evtlink_ttl_filter : public rocksdb::CompactionFilter {
+public:
+    bool
+    Filter(int, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string*, bool*) const override {
+        auto& prefix = action_key_prefixes[(int)token_type::evtlink];
+        if(key.size() != sizeof(name128) * 2 || memcmp(key.data(), &prefix, sizeof(prefix)) != 0) {
+            return false;
         }
-        else if(s.code() == rocksdb::Status::kNotFound) {
-            // remove value
-            batch.Delete(assets_handle_, k);
+
+        // block num is the first field of serialized `evt_link_object`
+        auto block_num = uint32_t(0);
+        if(value.size() < sizeof(block_num)) {
+            return false;
         }
-        else {
-            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", s.getState()));
+        memcpy(&block_num, value.data(), sizeof(block_num));
+        if(block_num >= before.load(std::memory_order_relaxed)) {
+            return false;
         }
+
+        pruned.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
-    auto sync_write_opts = write_opts_;
-    sync_write_opts.sync = true;
-    db_->Write(sync_write_opts, &batch);
 
-    return count;
-}
+    const char* Name() const override { return "evt.evtlink_ttl"; }
 
-void
-token_database_impl::add_savepoint(int64_t seq) {
-    using namespace internal;
+public:
+    std::atomic<uint32_t>         before = 0;
+    mutable std::atomic<uint64_t> pruned = 0;
+};
 
-    if(!savepoints_.empty()) {
-        auto& b = savepoints_.back();
-        if(b.seq >= seq) {
-            EVT_THROW(token_database_seq_not_valid, "Seq is not valid, prev: ${prev}, curr: ${curr}",
-                      ("prev", b.seq)("curr", seq));
-        }
-    }
+}  // namespace internal
 
-    savepoints_.push_back(savepoint(seq, kRuntime));
-    auto rt = new rt_group { .rb_snapshot = (const void*)db_->GetSnapshot(), .actions = {} }; 
-    SETPOINTER(void, savepoints_.back().node.group, rt);
+class token_database_impl : boost::noncopyable {
+public:
+    // holders index: persisted balances of tracked symbols, keyed by address part of asset key
+    // pending balances are still in `assets_write_cache_` and merged while reading
+    using holders_map_t  = std::map<std::string, std::string>;
+    using holders_rank_t = std::set<std::pair<int64_t, std::string>, internal::holder_rank_order>;
 
-    assets_write_cache_.add_savepoint(seq);
-}
+public:
+    token_database_impl(token_database& self, const token_database::config& config);
 
-void
-token_database_impl::free_savepoint(internal::savepoint& sp) {
-    using namespace internal;
+public:
+    void open(int load_persistence = true);
+    void close(int persist = true);
 
-    auto n = sp.node;
+public:
+    void put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data);
+    void put_tokens(token_type type,
+                    action_op op,
+                    const name128& prefix,
+                    token_keys_t&& keys,
+                    const small_vector_base<std::string_view>& data);
+    void append_token(token_type type, const name128& prefix, const name128& key, uint32_t pos, uint32_t size, const std::string_view& item);
+    void put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data);
 
-    switch(n.f.type) {
-    case kRuntime: {
-        auto rt = GETPOINTER(rt_group, n.group);
-        for(auto& act : rt->actions) {
-            switch(act.get_data_type()) {
-            case kTokenKey:
-            case kTokenFullKey:
-            case kAssetKey: {
-                free(GETPOINTER(void, act.data));
-                break;
-            }
-            case kTokenKeys: {
-                auto p = GETPOINTER(rt_token_keys, act.data);
-                //need to call dtor of keys manually
-                p->keys.~token_keys_t();
-                free(p);
-                break;
-            }
-            }  // switch
+    int exists_token(token_type type, const name128& prefix, const name128& key) const;
+    int exists_asset(const address& addr, const symbol_id_type sym_id) const;
+
+    int read_token(token_type type, const name128& prefix, const name128& key, std::string& out, bool no_throw = false) const;
+    int read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw = false) const;
+    int read_token(token_type type, const name128& prefix, const name128& key, rocksdb::PinnableSlice& out, bool no_throw = false) const;
+    int read_asset(const address& addr, const symbol_id_type sym_id, rocksdb::PinnableSlice& out, bool no_throw = false) const;
+
+    int read_tokens(token_type type, const name128& prefix, const small_vector_base<name128>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+    int read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw = false) const;
+
+    int read_tokens_range(token_type type, const name128& prefix, int skip, const read_value_func& func) const;
+    int read_tokens_range_after(token_type type, const name128& prefix, const name128& after, const read_value_func& func) const;
+    int read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+    int read_assets_holders(const symbol_id_type sym_id, const read_value_func& func) const;
+    int read_assets_top_holders(const symbol_id_type sym_id, int skip, const read_value_func& func) const;
+    size_t warm_assets_holders(const symbol_id_type sym_id) const;
+
+    void update_holders_index(const std::string_view& key, const std::string_view& value);
+    void erase_from_holders_index(const std::string_view& key);
+    const holders_map_t& load_holders(const symbol_id_type sym_id) const;
+    holders_map_t pending_holders(const symbol_id_type sym_id) const;
+
+    // moves entries of token `key` in owner index from the owners of `old_value` to the ones of `new_value`
+    void update_owner_index(rocksdb::WriteBatch& batch, const std::string_view& key, const std::string_view& old_value, const std::string_view& new_value);
+    void build_owner_index();
+    int read_tokens_by_owner(const rocksdb::ReadOptions& opts, const address& owner, int skip, const read_value_func& func) const;
+
+    bool indexes_owners(token_type type) const { return owners_handle_ != nullptr && type == token_type::token; }
+
+    void build_balance_index();
+    // symbols of the persisted balances of `addr` in balance index, pending ones should be added by callers
+    void read_balance_symbols(const rocksdb::ReadOptions& opts, const address& addr, std::set<symbol_id_type>& syms) const;
+    int read_assets_by_address(const address& addr, const read_value_func& func) const;
+    size_t prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const;
+
+    fc::sha256 state_hash() const;
+    internal::hash_accumulator full_state_hash() const;
+
+    void
+    replace_state_hash(const std::string_view& key, const std::optional<std::string>& old_value, const std::string_view& value) {
+        using namespace internal;
+        if(old_value.has_value()) {
+            state_hash_->sub(hash_accumulator::hash_row(key, *old_value));
         }
-        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
-        delete rt;
-        break;
-    }
-    case kPersist: {
-        auto pd = GETPOINTER(pd_group, n.group);
-        delete pd;
-        break;
+        state_hash_->add(hash_accumulator::hash_row(key, value));
     }
-    }  // switch
-}
 
-void
-token_database_impl::free_all_savepoints() {
-    while(!savepoints_.empty()) {
-        free_savepoint(savepoints_.front());
-        savepoints_.pop_front();
-    }
-}
+public:
+    void add_savepoint(int64_t seq);
+    void rollback_to_latest_savepoint();
+    void pop_savepoints(int64_t until);
+    void commit_savepoints();
+    void pop_back_savepoint();
+    void squash();
 
-void
-token_database_impl::pop_savepoints(int64_t until) {
-    while(!savepoints_.empty() && savepoints_.front().seq < until) {
-        auto it = std::move(savepoints_.front());
-        savepoints_.pop_front();
-        free_savepoint(it);
+    int64_t latest_savepoint_seq() const;
+    std::vector<token_delta> latest_savepoint_deltas() const;
+    int64_t new_savepoint_session_seq() const;
+    size_t  savepoints_size() const { return savepoints_.size(); }
 
-        // pop write cache and persist into underlying db
-        assert(assets_write_cache_.ops_.front().seq == it.seq);
-        auto batch = rocksdb::WriteBatch();
-        assets_write_cache_.pop_front([&](auto& k, auto&& v) {
-            batch.Put(assets_handle_, rocksdb::Slice(k.data(), k.size()), v);
-        });
-        auto sync_write_opts = write_opts_;
-        sync_write_opts.sync = true;
-        db_->Write(sync_write_opts, &batch);
-    }
-}
+    void rollback_rt_group(internal::rt_group*);
+    void rollback_pd_group(internal::pd_group*);
 
-void
-token_database_impl::pop_back_savepoint() {
-    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+    int should_record() { return !savepoints_.empty(); }
 
-    auto it = std::move(savepoints_.back());
-    savepoints_.pop_back();
-    free_savepoint(it);
+    void record(uint8_t action_type, uint8_t op, uint8_t data_type, void* data);
 
-    assets_write_cache_.pop_back();
-}
+    // data of actions are allocated from arena of latest savepoint
+    template<typename T>
+    T*
+    alloc_record_data() {
+        auto rt = GETPOINTER(internal::rt_group, savepoints_.back().node.group);
+        return (T*)rt->mem->allocate(sizeof(T), alignof(T));
+    }
 
-void
-token_database_impl::squash() {
-    using namespace internal;
-    EVT_ASSERT(savepoints_.size() >= 2, token_database_squash_exception, "Squash needs at least two savepoints.");
-    
-    auto n = savepoints_.back().node;
-    EVT_ASSERT(n.f.type == kRuntime, token_database_squash_exception, "Squash needs two realtime savepoints.");
+    internal::rt_group* new_rt_group();
+    void free_rt_group(internal::rt_group*);
+    void free_savepoint(internal::savepoint&);
+    void free_all_savepoints();
 
-    savepoints_.pop_back();
-    auto n2 = savepoints_.back().node;
-    EVT_ASSERT(n2.f.type == kRuntime, token_database_squash_exception, "Squash needs two realtime savepoints.");
+    void persist_savepoints() const;
+    void load_savepoints();
+    void persist_derived_state() const;
+    bool load_derived_state();
+    void persist_warm_keys(const std::vector<std::string>& keys) const;
+    void start_warmup();
+    void stop_warmup();
+    void persist_savepoints(std::ostream&) const;
+    void load_savepoints(std::istream&);
+    void flush() const;
 
-    auto rt1 = GETPOINTER(rt_group, n.group);
-    auto rt2 = GETPOINTER(rt_group, n2.group);
+    std::string get_db_path() const { return config_.db_path.to_native_ansi_path(); }
 
-    // add all actions from rt1 into end of rt2
-    rt2->actions.insert(rt2->actions.cend(), rt1->actions.cbegin(), rt1->actions.cend());
+    // options for the batches of commits and rollbacks
+    rocksdb::WriteOptions
+    commit_write_opts() const {
+        auto opts = write_opts_;
+        opts.sync = !config_.disable_wal && config_.sync != sync_policy::none;
+        return opts;
+    }
 
-    // just release rt1's snapshot
-    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt1->rb_snapshot);
-    delete rt1;
+    rocksdb::ColumnFamilyHandle* get_handle(token_type type) const { return handles_[(int)type]; }
+    rocksdb::ColumnFamilyHandle* get_handle(int type) const { return handles_[type]; }
 
-    assets_write_cache_.squash();
-}
+    void migrate_to_separated_layout();
 
-int64_t
-token_database_impl::latest_savepoint_seq() const {
-    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
-    return savepoints_.back().seq;
-}
+    std::shared_ptr<token_database::read_view> new_read_view() const;
+    std::vector<std::string> pop_dirty_keys();
 
-int64_t
-token_database_impl::new_savepoint_session_seq() const {
-    int64_t seq = 1;
-    if(!savepoints_.empty()) {
-        seq = savepoints_.back().seq + 1;
+    std::unique_ptr<token_database::ingester> new_ingester();
+
+    uint32_t
+    token_version(const std::string_view& key) const {
+        return token_versions_[std::hash<std::string_view>()(key) % token_versions_.size()];
     }
-    return seq;
-}
 
-void
-token_database_impl::record(uint8_t action_type, uint8_t op, uint8_t data_type, void* data) {
-    using namespace internal;
+    void
+    mark_dirty(const std::string_view& key) {
+        token_versions_[std::hash<std::string_view>()(key) % token_versions_.size()]++;
+        if(track_dirty_) {
+            dirty_keys_.emplace_back(key);
+        }
+    }
 
-    if(!should_record()) {
-        return;
+    void
+    hot_update(const std::string_view& key, const std::string_view& value) {
+        if(hot_) {
+            hot_->update(key, value);
+        }
     }
-    auto n = savepoints_.back().node;
-    assert(n.f.type == kRuntime);
 
-    GETPOINTER(rt_group, n.group)->actions.emplace_back(rt_action(action_type, op, data_type, data));
-}
+    void
+    hot_remove(const std::string_view& key) {
+        if(hot_) {
+            hot_->remove(key);
+        }
+    }
 
-namespace internal {
+    void build_link_filter();
+    void open_replica_handles();
 
-std::string
-get_sp_key(const rt_action& act) {
-    switch(act.get_data_type()) {
-    case kTokenKey: {
-        auto data = GETPOINTER(rt_token_key, act.data);
-        return db_token_key(action_key_prefixes[act.f.type], data->key).as_string();
+    void
+    check_writable() const {
+        EVT_ASSERT(!config_.read_replica, token_database_exception, "Cannot write into read replica of token database");
     }
-    case kTokenFullKey: {
-        auto data = GETPOINTER(rt_token_fullkey, act.data);
-        return db_token_key(data->prefix, data->key).as_string();
+
+    void
+    filter_add(token_type type, const std::string_view& key) {
+        if(link_filter_ && type == token_type::evtlink) {
+            link_filter_->add(key);
+        }
     }
-    case kAssetKey: {
-        auto data = GETPOINTER(rt_asset_key, act.data);
-        return std::string(data->key, sizeof(data->key));
+
+    void
+    track_key(token_type type, const std::string_view& key, bool write) const {
+        if(key_heat_) {
+            key_heat_->add(type, key, write);
+        }
     }
-    case kTokenKeys: {
-        assert(false);
+
+    fc::variant hot_keys() const;
+
+    // false only if key is definitely not in database
+    bool
+    filter_may_contain(token_type type, const std::string_view& key) const {
+        return !link_filter_ || type != token_type::evtlink || link_filter_->may_contain(key);
     }
-    }  // switch
-    return std::string();
-}
 
-}  // namespace internal
+public:
+    token_database&        self_;
+    token_database::config config_;
 
-void
-token_database_impl::rollback_rt_group(internal::rt_group* rt) {
-    using namespace internal;
+    rocksdb::DB*          db_;
+    rocksdb::ReadOptions  read_opts_;
+    rocksdb::WriteOptions write_opts_;
 
-    if(rt->actions.empty()) {
-        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
-        return;
-    }
+    rocksdb::ColumnFamilyHandle* tokens_handle_;
+    rocksdb::ColumnFamilyHandle* assets_handle_;
+    rocksdb::ColumnFamilyHandle* owners_handle_;    // only opened when `owner_index` is enabled
+    rocksdb::ColumnFamilyHandle* balances_handle_;  // only opened when `balance_index` is enabled
 
-    auto snapshot_read_opts_     = read_opts_;
-    snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
+    // handle of column family for each token type
+    // in the unified layout, all the non-asset types share the default one
+    std::array<rocksdb::ColumnFamilyHandle*, (int)token_type::max_value + 1> handles_;
+    std::vector<rocksdb::ColumnFamilyHandle*>                                hot_handles_;
 
-    auto key_set = keys_hash_set();
-    auto batch   = rocksdb::WriteBatch();
-    
-    for(auto it = rt->actions.begin(); it < rt->actions.end(); it++) {
-        auto data = GETPOINTER(void, it->data);
+    write_cache_layer assets_write_cache_;
 
-        auto fn = [&](auto& key, auto type, auto op) {
-            switch(op) {
-            case action_op::add: {
-                assert(key_set.find(key) == key_set.end());
+    fc::ring_vector<internal::savepoint> savepoints_;
+    arena_pool                           arenas_;
 
-                batch.Delete(key);
-                self_.remove_token_value(key);
-            
-                // insert key into key set
-                key_set.insert(key);
-                break;
-            }
-            case action_op::update: {
-                // only update operation need to check if key is already processed
-                if(key_set.find(key) != key_set.end()) {
-                    break;
-                }
-                auto old_value = std::string();
-                auto status    = db_->Get(snapshot_read_opts_, key, &old_value);
-                if(!status.ok()) {
-                    FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                }
-                batch.Put(key, old_value);
-                self_.rollback_token_value(key);
+    mutable std::unordered_map<symbol_id_type, holders_map_t> holders_index_;
+    // persisted holders of symbols ever queried by amount, built from holders index and maintained along with it
+    mutable std::unordered_map<symbol_id_type, holders_rank_t> holders_ranks_;
 
-                // insert key into key set
-                key_set.insert(key);
-                break;
-            }
-            case action_op::put: {
-                // only update operation need to check if key is already processed
-                if(key_set.find(key) != key_set.end()) {
-                    break;
-                }
+    // only created in hybrid profile
+    std::unique_ptr<internal::hot_tier> hot_;
 
-                // Asset type only has put op
-                auto handle    = (type == token_type::asset) ? assets_handle_ : tokens_handle_;
-                auto old_value = std::string();
-                auto status    = db_->Get(snapshot_read_opts_, handle, key, &old_value);
+    // prefetches warm keys recorded by last run into block cache
+    std::thread       warmup_thread_;
+    std::atomic<bool> warmup_stop_ = false;
 
-                // key may not existed in latest snapshot, remove it
-                if(!status.ok()) {
-                    if(status.code() != rocksdb::Status::kNotFound) {
-                        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                    }
-                    batch.Delete(handle, key);
-                    if(handle == tokens_handle_) {
-                        self_.remove_token_value(key);
-                    }
-                }
-                else {
-                    batch.Put(handle, key, old_value);
-                    if(handle == tokens_handle_) {
-                        self_.rollback_token_value(key);
-                    }
-                }
+    // only created when `evtlink_filter` is enabled, most lookups of evtlinks are for the links not paid yet
+    std::unique_ptr<internal::key_filter> link_filter_;
 
-                // insert key into key set
-                key_set.insert(key);
-                break;
-            }
-            }  // switch
-        };
+    // only created when metrics are enabled
+    std::unique_ptr<token_database_metrics> metrics_;
 
-        auto op         = it->get_action_op();
-        auto data_type  = it->get_data_type();
-        auto type       = it->get_token_type();
+    // only created when `hot_keys` is enabled
+    std::unique_ptr<internal::key_heat_tracker> key_heat_;
+
+    // only created when `evtlink_ttl` is enabled, it's referenced by options so it outlives `db_`
+    std::unique_ptr<internal::evtlink_ttl_filter> link_ttl_filter_;
+
+    // write cache of savepoints whose seq is less than it are waiting to be committed
+    int64_t commit_until_;
+
+    // token keys changed since latest read view, only tracked after first view is created
+    bool                     track_dirty_;
+    std::vector<std::string> dirty_keys_;
+
+    // versions of tokens striped by the hash of db keys, bumped whenever the keys are marked dirty
+    std::vector<uint32_t> token_versions_;
+
+    mutable iterator_pool iterators_;
+
+    // only maintained when `state_hash` is enabled, empty means it should be calculated by a full scan
+    mutable std::optional<internal::hash_accumulator> state_hash_;
+};
+
+token_database_impl::token_database_impl(token_database& self, const token_database::config& config)
+    : self_(self)
+    , config_(config)
+    , db_(nullptr)
+    , read_opts_()
+    , write_opts_()
+    , tokens_handle_(nullptr)
+    , assets_handle_(nullptr)
+    , owners_handle_(nullptr)
+    , balances_handle_(nullptr)
+    , handles_()
+    , savepoints_(internal::kDefaultSavePointsSize)
+    , arenas_(internal::kMaxPooledArenasSize)
+    , commit_until_(0)
+    , track_dirty_(false)
+    , token_versions_(internal::kTokenVersionStripes) {}
+
+void
+token_database_impl::open(int load_persistence) {
+    using namespace rocksdb;
+    using namespace internal;
+
+    EVT_ASSERT(db_ == nullptr, token_database_exception, "Token database is already opened");
+
+    auto options = Options();
+    options.OptimizeUniversalStyleCompaction();
+
+    options.create_if_missing               = true;
+    options.compression                     = CompressionType::kLZ4Compression;
+    options.bottommost_compression          = CompressionType::kZSTD;
+    options.allow_concurrent_memtable_write = false;
+    options.prefix_extractor.reset(NewFixedPrefixTransform(sizeof(name128)));
+    options.memtable_factory.reset(NewHashSkipListRepFactory());
+    options.merge_operator = std::make_shared<internal::append_merge_operator>();
+    if(config_.metrics) {
+        metrics_ = std::make_unique<token_database_metrics>();
+    }
+    if(config_.enable_stats) {
+        options.statistics = rocksdb::CreateDBStatistics();
+#if ROCKSDB_MAJOR >= 6
+        options.statistics->set_stats_level(StatsLevel::kExceptTimeForMutex);
+#else
+        options.statistics->stats_level_ = StatsLevel::kExceptTimeForMutex;
+#endif
+    }
+
+    if(config_.tuning != tuning_profile::none) {
+        auto hw = detect_hardware(config_.db_path);
+        apply_tuning(options, config_.tuning, hw);
+        ilog("Token database is tuned for ${p}: ${c} cores, ${m}MB memory, ${d} disk, ${j} background jobs, ${w}MB write buffer",
+            ("p", config_.tuning)("c", hw.cores)("m", hw.memory / (1024 * 1024))("d", hw.rotational ? "rotational" : "solid state")
+            ("j", options.max_background_jobs)("w", options.write_buffer_size / (1024 * 1024)));
+    }
+    if(!config_.options_file.empty()) {
+        load_options_file(options, config_.options_file);
+    }
+
+    auto assets_options = ColumnFamilyOptions(options);
+
+    // options for the hot types in separated layout
+    auto tokens_options    = ColumnFamilyOptions(options);
+    auto fungibles_options = ColumnFamilyOptions(options);
+    auto evtlinks_options  = ColumnFamilyOptions(options);
+
+    // keys of owner index are prefixed by the hash of owner, which has the same size as the domain prefix of tokens
+    auto owners_options = ColumnFamilyOptions(options);
+
+    // keys of balance index are prefixed by address
+    auto balances_options = ColumnFamilyOptions(options);
+    balances_options.prefix_extractor.reset(NewFixedPrefixTransform(kPublicKeySize));
+
+    if(config_.profile == storage_profile::disk || config_.profile == storage_profile::hybrid) {
+        auto table_opts = BlockBasedTableOptions();
+
+        table_opts.index_type     = BlockBasedTableOptions::kHashSearch;
+        table_opts.checksum       = kxxHash64;
+        table_opts.format_version = 4;
+        table_opts.block_cache    = NewLRUCache(config_.block_cache_size);
+        table_opts.filter_policy.reset(NewBloomFilterPolicy(10, false));
+
+        options.table_factory.reset(NewBlockBasedTableFactory(table_opts));
+        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+        owners_options.table_factory   = options.table_factory;
+        balances_options.table_factory = options.table_factory;
+
+        if(config_.separated_layout) {
+            // tokens are scanned by domain frequently, keep the hash index on domain prefix
+            tokens_options.table_factory = options.table_factory;
+
+            // fungibles are small and read by almost every fungible action:
+            // keep index and filter blocks in cache with high priority
+            auto fungibles_table_opts = table_opts;
+            fungibles_table_opts.cache_index_and_filter_blocks                = true;
+            fungibles_table_opts.cache_index_and_filter_blocks_with_high_priority = true;
+            fungibles_table_opts.pin_l0_filter_and_index_blocks_in_cache      = true;
+            fungibles_options.table_factory.reset(NewBlockBasedTableFactory(fungibles_table_opts));
+
+            // evtlinks are write-once and only looked up by whole key,
+            // most lookups are misses so whole-key bloom filters pay off in every level
+            auto evtlinks_table_opts       = table_opts;
+            evtlinks_table_opts.index_type = BlockBasedTableOptions::kBinarySearch;
+            evtlinks_options.table_factory.reset(NewBlockBasedTableFactory(evtlinks_table_opts));
+            evtlinks_options.OptimizeLevelStyleCompaction();
+            evtlinks_options.prefix_extractor.reset();
+            evtlinks_options.memtable_factory.reset(new SkipListFactory());
+        }
+    }
+    else if(config_.profile == storage_profile::memory) {
+        auto tokens_table_options = PlainTableOptions();
+        auto assets_table_options = PlainTableOptions();
+        auto owners_table_options = PlainTableOptions();
+        auto balances_table_options = PlainTableOptions();
+        tokens_table_options.user_key_len   = sizeof(name128) + sizeof(name128);
+        assets_table_options.user_key_len   = kPublicKeySize + kSymbolIdSize;
+        owners_table_options.user_key_len   = sizeof(name128) * 3;
+        balances_table_options.user_key_len = kPublicKeySize + kSymbolIdSize;
+
+        options.table_factory.reset(NewPlainTableFactory(tokens_table_options));
+        assets_options.table_factory.reset(NewPlainTableFactory(assets_table_options));
+        assets_options.prefix_extractor.reset(NewFixedPrefixTransform(kSymbolIdSize));
+        owners_options.table_factory.reset(NewPlainTableFactory(owners_table_options));
+        balances_options.table_factory.reset(NewPlainTableFactory(balances_table_options));
+
+        tokens_options.table_factory    = options.table_factory;
+        fungibles_options.table_factory = options.table_factory;
+        evtlinks_options.table_factory  = options.table_factory;
+    }
+    else {
+        EVT_THROW(token_database_exception, "Unknown token database profile");
+    }
+
+    read_opts_.total_order_seek     = false;
+    read_opts_.prefix_same_as_start = true;
+    // read-only instances never see new writes, tailing iterators are not supported by them
+    read_opts_.tailing              = !config_.read_replica;
+
+    if(config_.profile == storage_profile::hybrid) {
+        hot_ = std::make_unique<hot_tier>(config_.hot_tier_size);
+    }
+    if(config_.hot_keys > 0) {
+        key_heat_ = std::make_unique<key_heat_tracker>(config_.hot_keys, config_.hot_keys_window);
+    }
+
+    write_opts_.disableWAL = config_.disable_wal;
+    write_opts_.sync       = !config_.disable_wal && config_.sync == sync_policy::always;
+
+    if(config_.evtlink_ttl > 0) {
+        // evtlinks are in default column family along with other tokens in unified layout, filter checks prefix of keys
+        link_ttl_filter_ = std::make_unique<evtlink_ttl_filter>();
+        if(config_.separated_layout) {
+            evtlinks_options.compaction_filter = link_ttl_filter_.get();
+        }
+        else {
+            options.compaction_filter = link_ttl_filter_.get();
+        }
+    }
+
+    auto hot_options = std::map<std::string, ColumnFamilyOptions>{
+        { kTokensColumnFamilyName,    tokens_options    },
+        { kFungiblesColumnFamilyName, fungibles_options },
+        { kEvtLinksColumnFamilyName,  evtlinks_options  }
+    };
+
+    auto columns = std::vector<ColumnFamilyDescriptor>();
+    auto handles = std::vector<ColumnFamilyHandle*>();
+    columns.emplace_back(kDefaultColumnFamilyName, options);
+
+    auto is_new = false;
+    if(!fc::exists(config_.db_path)) {
+        EVT_ASSERT(!config_.read_replica, token_database_exception,
+            "Token database: ${p} is not existed, read replica can only be opened on the one created by primary", ("p",config_.db_path));
+        // create new database and open
+        fc::create_directories(config_.db_path);
+        is_new = true;
+    }
+    else {
+        auto names  = std::vector<std::string>();
+        auto status = DB::ListColumnFamilies(DBOptions(options), config_.db_path.to_native_ansi_path(), &names);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+
+        for(auto& n : names) {
+            if(n == kDefaultColumnFamilyName) {
+                continue;
+            }
+            if(n == kAssetsColumnFamilyName) {
+                columns.emplace_back(kAssetsColumnFamilyName, assets_options);
+                continue;
+            }
+            if(n == kOwnersColumnFamilyName) {
+                columns.emplace_back(kOwnersColumnFamilyName, owners_options);
+                continue;
+            }
+            if(n == kBalancesColumnFamilyName) {
+                columns.emplace_back(kBalancesColumnFamilyName, balances_options);
+                continue;
+            }
+            auto it = hot_options.find(n);
+            EVT_ASSERT(it != hot_options.end(), token_database_exception, "Unknown column family: ${n} in token database", ("n",n));
+            EVT_ASSERT(config_.separated_layout, token_database_exception,
+                "Token database is in separated layout, it cannot be opened in unified layout");
+            columns.emplace_back(n, it->second);
+        }
+    }
+
+    // read replica is opened without taking lock of database, wal of primary is replayed into its memtables
+    // it's a point-in-time view, catching up with primary needs reopening it
+    auto status = config_.read_replica
+        ? DB::OpenForReadOnly(options, config_.db_path.to_native_ansi_path(), columns, &handles, &db_)
+        : DB::Open(options, config_.db_path.to_native_ansi_path(), columns, &handles, &db_);
+    if(!status.ok()) {
+        EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+
+    assert(handles.size() == columns.size());
+    tokens_handle_ = handles[0];
+    handles_.fill(tokens_handle_);
+
+    for(auto i = 1u; i < columns.size(); i++) {
+        if(columns[i].name == kAssetsColumnFamilyName) {
+            assets_handle_ = handles[i];
+            continue;
+        }
+        if(columns[i].name == kOwnersColumnFamilyName) {
+            owners_handle_ = handles[i];
+            continue;
+        }
+        if(columns[i].name == kBalancesColumnFamilyName) {
+            balances_handle_ = handles[i];
+            continue;
+        }
+        hot_handles_.emplace_back(handles[i]);
+    }
+
+    if(config_.read_replica) {
+        open_replica_handles();
+        return;
+    }
+
+    if(assets_handle_ == nullptr) {
+        assert(is_new);
+        status = db_->CreateColumnFamily(assets_options, kAssetsColumnFamilyName, &assets_handle_);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+    }
+    handles_[(int)token_type::asset] = assets_handle_;
+
+    if(config_.separated_layout) {
+        for(auto& hc : hot_columns) {
+            auto it = std::find_if(hot_handles_.cbegin(), hot_handles_.cend(), [&](auto h) { return h->GetName() == hc.name; });
+            if(it != hot_handles_.cend()) {
+                handles_[(int)hc.type] = *it;
+                continue;
+            }
+
+            auto handle = (ColumnFamilyHandle*)nullptr;
+            status = db_->CreateColumnFamily(hot_options[hc.name], hc.name, &handle);
+            if(!status.ok()) {
+                EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+            hot_handles_.emplace_back(handle);
+            handles_[(int)hc.type] = handle;
+        }
+
+        if(!is_new) {
+            migrate_to_separated_layout();
+        }
+        else {
+            auto marker = db_token_key(kLayoutMarkerPrefix, kLayoutMarkerKey);
+            db_->Put(write_opts_, tokens_handle_, marker.as_slice(), rocksdb::Slice());
+        }
+    }
+
+    if(config_.owner_index && owners_handle_ == nullptr) {
+        status = db_->CreateColumnFamily(owners_options, kOwnersColumnFamilyName, &owners_handle_);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!is_new) {
+            build_owner_index();
+        }
+    }
+    else if(!config_.owner_index && owners_handle_ != nullptr) {
+        // index turns stale once tokens are written without it, so it's dropped and built again when enabled later
+        status = db_->DropColumnFamily(owners_handle_);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        delete owners_handle_;
+        owners_handle_ = nullptr;
+    }
+
+    if(config_.balance_index && balances_handle_ == nullptr) {
+        status = db_->CreateColumnFamily(balances_options, kBalancesColumnFamilyName, &balances_handle_);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!is_new) {
+            build_balance_index();
+        }
+    }
+    else if(!config_.balance_index && balances_handle_ != nullptr) {
+        // same as owner index, stale index is dropped and built again when enabled later
+        status = db_->DropColumnFamily(balances_handle_);
+        if(!status.ok()) {
+            EVT_THROW(token_database_rocksdb_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        delete balances_handle_;
+        balances_handle_ = nullptr;
+    }
+
+    if(load_persistence) {
+        load_savepoints();
+    }
+
+    // derived state left by last clean close makes the full scans below unnecessary
+    auto derived = config_.fast_restart && load_persistence && load_derived_state();
+    if(config_.state_hash && !state_hash_.has_value()) {
+        state_hash_ = full_state_hash();
+    }
+    if(config_.evtlink_filter && link_filter_ == nullptr) {
+        build_link_filter();
+    }
+    if(derived) {
+        ilog("Loaded derived state of token database");
+    }
+    if(config_.warmup_keys > 0) {
+        start_warmup();
+    }
+}
+
+// primaries create all the column families needed when they're opened, replicas only map them
+void
+token_database_impl::open_replica_handles() {
+    using namespace internal;
+
+    EVT_ASSERT(assets_handle_ != nullptr, token_database_exception, "Token database is not initialized by primary");
+    handles_[(int)token_type::asset] = assets_handle_;
+
+    if(config_.separated_layout) {
+        for(auto& hc : hot_columns) {
+            auto it = std::find_if(hot_handles_.cbegin(), hot_handles_.cend(), [&](auto h) { return h->GetName() == hc.name; });
+            EVT_ASSERT(it != hot_handles_.cend(), token_database_exception,
+                "Token database is not in separated layout, it cannot be opened in separated layout by read replica");
+            handles_[(int)hc.type] = *it;
+        }
+    }
+    else {
+        EVT_ASSERT(hot_handles_.empty(), token_database_exception,
+            "Token database is in separated layout, it cannot be opened in unified layout");
+    }
+    if(config_.owner_index) {
+        EVT_ASSERT(owners_handle_ != nullptr, token_database_exception, "Owner index is not enabled by primary of token database");
+    }
+    if(config_.balance_index) {
+        EVT_ASSERT(balances_handle_ != nullptr, token_database_exception, "Balance index is not enabled by primary of token database");
+    }
+
+    // savepoints and derived state are only persisted by primary on close, so they're not loaded
+    if(config_.state_hash) {
+        state_hash_ = full_state_hash();
+    }
+    if(config_.evtlink_filter) {
+        build_link_filter();
+    }
+}
+
+void
+token_database_impl::build_owner_index() {
+    using namespace internal;
+
+    auto total_opts             = read_opts_;
+    total_opts.total_order_seek = true;
+    total_opts.tailing          = false;
+
+    auto batch = rocksdb::WriteBatch();
+    auto count = 0;
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, get_handle(token_type::token)));
+    for(it->SeekToFirst(); it->Valid(); it->Next()) {
+        // keys of other types and layout marker are all under reserved prefixes
+        auto key    = it->key().ToStringView();
+        auto prefix = name128();
+        memcpy(&prefix, key.data(), sizeof(prefix));
+        if(key.size() != sizeof(name128) * 2 || prefix.reserved()) {
+            continue;
+        }
+
+        update_owner_index(batch, key, std::string_view(), it->value().ToStringView());
+        if(++count % 10'000 == 0) {
+            db_->Write(write_opts_, &batch);
+            batch.Clear();
+        }
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+    db_->Write(write_opts_, &batch);
+
+    ilog("Built owner index of ${n} tokens in token database", ("n",count));
+}
+
+void
+token_database_impl::build_balance_index() {
+    using namespace internal;
+
+    auto total_opts             = read_opts_;
+    total_opts.total_order_seek = true;
+    total_opts.tailing          = false;
+
+    auto batch = rocksdb::WriteBatch();
+    auto count = 0;
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, assets_handle_));
+    for(it->SeekToFirst(); it->Valid(); it->Next()) {
+        batch.Put(balances_handle_, db_balance_key(it->key().ToStringView()), rocksdb::Slice());
+        if(++count % 10'000 == 0) {
+            db_->Write(write_opts_, &batch);
+            batch.Clear();
+        }
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+    db_->Write(write_opts_, &batch);
+    ilog("Built balance index of token database for ${n} balances", ("n", count));
+}
+
+void
+token_database_impl::build_link_filter() {
+    using namespace internal;
+
+    link_filter_ = std::make_unique<key_filter>();
+
+    auto total_opts             = read_opts_;
+    total_opts.total_order_seek = true;
+    total_opts.tailing          = false;
+
+    // keys of evtlinks are only in their own column family in separated layout
+    auto& prefix = action_key_prefixes[(int)token_type::evtlink];
+    auto  start  = rocksdb::Slice((char*)&prefix, sizeof(prefix));
+    auto  it     = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, get_handle(token_type::evtlink)));
+    for(it->Seek(start); it->Valid() && it->key().starts_with(start); it->Next()) {
+        link_filter_->add(it->key().ToStringView());
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+
+    ilog("Loaded ${n} evtlinks into filter of token database", ("n",link_filter_->size()));
+}
+
+void
+token_database_impl::migrate_to_separated_layout() {
+    using namespace internal;
+
+    auto marker = db_token_key(kLayoutMarkerPrefix, kLayoutMarkerKey);
+    auto value  = std::string();
+    if(db_->Get(read_opts_, tokens_handle_, marker.as_slice(), &value).ok()) {
+        // already migrated
+        return;
+    }
+
+    wlog("Migrating token database into separated layout, it may take a while");
+
+    // migration is idempotent: keys are copied before being deleted from default column family
+    // so it's safe to run again if it's interrupted
+    const auto kBatchSize = 10000u;
+
+    auto total_opts             = read_opts_;
+    total_opts.total_order_seek = true;
+    total_opts.tailing          = false;
+
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, tokens_handle_));
+    auto batch = rocksdb::WriteBatch();
+    auto count = 0u;
+
+    auto sync_write_opts = commit_write_opts();
+
+    auto flush_batch = [&] {
+        auto status = db_->Write(sync_write_opts, &batch);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        batch.Clear();
+    };
+
+    for(it->SeekToFirst(); it->Valid(); it->Next()) {
+        auto key = it->key();
+        if(key.size() != sizeof(name128) * 2) {
+            continue;
+        }
+
+        auto prefix = name128();
+        memcpy((void*)&prefix, key.data(), sizeof(name128));
+
+        auto type = get_token_type_by_prefix(prefix);
+        if(!type.has_value() || get_handle(*type) == tokens_handle_) {
+            continue;
+        }
+
+        batch.Put(get_handle(*type), key, it->value());
+        batch.Delete(tokens_handle_, key);
+        if(++count % kBatchSize == 0) {
+            flush_batch();
+        }
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+
+    batch.Put(tokens_handle_, marker.as_slice(), rocksdb::Slice());
+    flush_batch();
+
+    ilog("Migrated ${n} keys into separated layout", ("n",count));
+}
+
+void
+token_database_impl::close(int persist) {
+    if(db_) {
+        stop_warmup();
+
+        // popped savepoints are irreversible and always committed
+        commit_savepoints();
+        commit_until_ = 0;
+
+        if(persist && !config_.read_replica) {
+            persist_savepoints();
+            if(config_.fast_restart) {
+                persist_derived_state();
+            }
+        }
+        if(!savepoints_.empty()) {
+            free_all_savepoints();
+        }
+        holders_index_.clear();
+        holders_ranks_.clear();
+        dirty_keys_.clear();
+        track_dirty_ = false;
+        hot_.reset();
+        link_filter_.reset();
+        key_heat_.reset();
+        
+        iterators_.clear();
+        for(auto h : hot_handles_) {
+            delete h;
+        }
+        hot_handles_.clear();
+
+        delete owners_handle_;
+        owners_handle_ = nullptr;
+        delete balances_handle_;
+        balances_handle_ = nullptr;
+
+        delete tokens_handle_;
+        delete assets_handle_;
+        delete db_;
+
+        db_            = nullptr;
+        tokens_handle_ = nullptr;
+        assets_handle_ = nullptr;
+        handles_.fill(nullptr);
+        link_ttl_filter_.reset();
+    }
+}
+
+void
+token_database_impl::put_token(token_type type, action_op op, const name128& prefix, const name128& key, const std::string_view& data) {
+    using namespace internal;
+    check_writable();
+
+    auto dbkey = db_token_key(prefix, key);
+    auto old   = std::string();
+    if(state_hash_.has_value() || indexes_owners(type)) {
+        auto r = read_token(type, prefix, key, old, true);
+        if(state_hash_.has_value()) {
+            replace_state_hash(dbkey.as_string_view(), r ? std::make_optional(old) : std::nullopt, data);
+        }
+    }
+
+    auto status = db_->Put(write_opts_, get_handle(type), dbkey.as_slice(), data);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+    if(indexes_owners(type)) {
+        auto batch = rocksdb::WriteBatch();
+        update_owner_index(batch, dbkey.as_string_view(), old, data);
+        db_->Write(write_opts_, &batch);
+    }
+    mark_dirty(dbkey.as_string_view());
+    hot_update(dbkey.as_string_view(), data);
+    filter_add(type, dbkey.as_string_view());
+
+    if(should_record()) {
+        void* data;
+
+        // for `token` action, needs to record both prefix and key, prefix refers to the domain
+        // for `non-token` action, prefix is not necessary which can be inferred by the `type`
+        if(type != token_type::token) {
+            assert(prefix == action_key_prefixes[(int)type]);
+            auto data = alloc_record_data<rt_token_key>();
+            data->key = key;
+
+            record((int)type, (int)op, (int)kTokenKey, data);
+        }
+        else {
+            auto data    = alloc_record_data<rt_token_fullkey>();
+            data->prefix = prefix;
+            data->key    = key;
+
+            record((int)type, (int)op, (int)kTokenFullKey, data);
+        }
+    }
+}
+
+void
+token_database_impl::put_tokens(token_type type,
+                                action_op op,
+                                const name128& prefix,
+                                token_keys_t&& keys,
+                                const small_vector_base<std::string_view>& data){
+    using namespace internal;
+    assert(keys.size() == data.size());
+    check_writable();
+
+    // added tokens don't have old owners
+    auto owners = indexes_owners(type);
+    auto batch  = rocksdb::WriteBatch();
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto dbkey = db_token_key(prefix, keys[i]);
+        auto old   = std::string();
+        if(state_hash_.has_value() || (owners && op != action_op::add)) {
+            auto r = read_token(type, prefix, keys[i], old, true);
+            if(state_hash_.has_value()) {
+                replace_state_hash(dbkey.as_string_view(), r ? std::make_optional(old) : std::nullopt, data[i]);
+            }
+        }
+
+        auto status = db_->Put(write_opts_, get_handle(type), dbkey.as_slice(), data[i]);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(owners) {
+            update_owner_index(batch, dbkey.as_string_view(), old, data[i]);
+        }
+        mark_dirty(dbkey.as_string_view());
+        hot_update(dbkey.as_string_view(), data[i]);
+        filter_add(type, dbkey.as_string_view());
+    }
+    if(owners) {
+        db_->Write(write_opts_, &batch);
+    }
+    if(should_record()) {
+        auto data = alloc_record_data<rt_token_keys>();
+        data->prefix = prefix;
+        new(&data->keys) token_keys_t(std::move(keys));
+
+        record((int)type, (int)op, (int)kTokenKeys, data);
+    }
+}
+
+void
+token_database_impl::append_token(token_type type, const name128& prefix, const name128& key, uint32_t pos, uint32_t size, const std::string_view& item) {
+    using namespace internal;
+    check_writable();
+
+    // appended items never change the owners of tokens, so owner index is untouched
+    auto dbkey = db_token_key(prefix, key);
+    auto old   = std::string();
+    if(state_hash_.has_value()) {
+        read_token(type, prefix, key, old);
+    }
+
+    auto operand = append_operand { pos, size, item }.pack();
+    auto status  = db_->Merge(write_opts_, get_handle(type), dbkey.as_slice(), operand);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+    mark_dirty(dbkey.as_string_view());
+
+    if(state_hash_.has_value()) {
+        auto value = std::string();
+        status     = db_->Get(read_opts_, get_handle(type), dbkey.as_slice(), &value);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        replace_state_hash(dbkey.as_string_view(), old, value);
+        hot_update(dbkey.as_string_view(), value);
+    }
+    else {
+        hot_remove(dbkey.as_string_view());
+    }
+
+    if(should_record()) {
+        if(type != token_type::token) {
+            assert(prefix == action_key_prefixes[(int)type]);
+            auto data = alloc_record_data<rt_token_key>();
+            data->key = key;
+
+            record((int)type, (int)action_op::update, (int)kTokenKey, data);
+        }
+        else {
+            auto data    = alloc_record_data<rt_token_fullkey>();
+            data->prefix = prefix;
+            data->key    = key;
+
+            record((int)type, (int)action_op::update, (int)kTokenFullKey, data);
+        }
+    }
+}
+
+void
+token_database_impl::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+    using namespace internal;
+    check_writable();
+
+    auto dbkey = db_asset_key(addr, sym_id);
+    if(state_hash_.has_value()) {
+        auto old = std::string();
+        auto r   = read_asset(addr, sym_id, old, true);
+        replace_state_hash(dbkey.as_string_view(), r ? std::make_optional(std::move(old)) : std::nullopt, data);
+    }
+
+    if(should_record()) {
+        assets_write_cache_.put(dbkey.as_string_view(), data);
+        return;
+    }
+    else {
+        // balance index is only written along with persisted balances, pending ones are rolled back in write cache
+        auto batch = rocksdb::WriteBatch();
+        batch.Put(assets_handle_, dbkey.as_slice(), data);
+        if(balances_handle_ != nullptr) {
+            batch.Put(balances_handle_, db_balance_key(dbkey.as_string_view()), rocksdb::Slice());
+        }
+        auto status = db_->Write(write_opts_, &batch);
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        update_holders_index(dbkey.as_string_view(), data);
+        hot_update(dbkey.as_string_view(), data);
+    }
+}
+
+int
+token_database_impl::exists_token(token_type type, const name128& prefix, const name128& key) const {
+    using namespace internal;
+
+    auto dbkey  = db_token_key(prefix, key);
+    auto value  = std::string();
+    if(!filter_may_contain(type, dbkey.as_string_view())) {
+        return false;
+    }
+    if(hot_ && hot_->exists(dbkey.as_string_view())) {
+        return true;
+    }
+    auto status = db_->Get(read_opts_, get_handle(type), dbkey.as_slice(), &value);
+    return status.ok();
+}
+
+int
+token_database_impl::exists_asset(const address& addr, const symbol_id_type sym_id) const {
+    using namespace internal;
+
+    auto dbkey  = db_asset_key(addr, sym_id);
+    auto value  = std::string();
+
+    if(assets_write_cache_.exists(dbkey.as_string_view())) {
+        return true;
+    }
+    if(hot_ && hot_->exists(dbkey.as_string_view())) {
+        return true;
+    }
+    auto status = db_->Get(read_opts_, assets_handle_, dbkey.as_slice(), &value);
+    return status.ok();
+}
+
+int
+token_database_impl::read_token(token_type type, const name128& prefix, const name128& key, std::string& out, bool no_throw) const {
+    auto v = rocksdb::PinnableSlice();
+    auto r = read_token(type, prefix, key, v, no_throw);
+    if(r) {
+        out.assign(v.data(), v.size());
+    }
+    return r;
+}
+
+int
+token_database_impl::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
+    auto v = rocksdb::PinnableSlice();
+    auto r = read_asset(addr, sym_id, v, no_throw);
+    if(r) {
+        out.assign(v.data(), v.size());
+    }
+    return r;
+}
+
+int
+token_database_impl::read_token(token_type type, const name128& prefix, const name128& key, rocksdb::PinnableSlice& out, bool no_throw) const {
+    using namespace internal;
+
+    out.Reset();
+
+    auto dbkey = db_token_key(prefix, key);
+    if(hot_) {
+        if(auto v = hot_->read(dbkey.as_string_view())) {
+            pin_value(out, *v);
+            return true;
+        }
+    }
+
+    auto status = filter_may_contain(type, dbkey.as_string_view())
+        ? db_->Get(read_opts_, get_handle(type), dbkey.as_slice(), &out)
+        : rocksdb::Status::NotFound();
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",key)("p",prefix));
+        }
+        return false;
+    }
+    return true;
+}
+
+int
+token_database_impl::read_asset(const address& addr, const symbol_id_type sym_id, rocksdb::PinnableSlice& out, bool no_throw) const {
+    using namespace internal;
+
+    out.Reset();
+
+    auto key = db_asset_key(addr, sym_id);
+    if(auto v = assets_write_cache_.find(key.as_string_view())) {
+        pin_value(out, *v);
+        return true;
+    }
+    if(hot_) {
+        if(auto v = hot_->read(key.as_string_view())) {
+            pin_value(out, *v);
+            return true;
+        }
+    }
+
+    auto status = db_->Get(read_opts_, assets_handle_, key.as_slice(), &out);
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", sym_id, addr);
+        }
+        return false;
+    }
+    return true;
+}
+
+int
+token_database_impl::read_tokens(token_type type,
+                                 const name128& prefix,
+                                 const small_vector_base<name128>& keys,
+                                 small_vector_base<std::string>& outs,
+                                 bool no_throw) const {
+    using namespace internal;
+
+    auto dbkeys = std::vector<std::string>();
+    auto slices = std::vector<rocksdb::Slice>();
+    dbkeys.reserve(keys.size());
+    slices.reserve(keys.size());
+
+    for(auto& k : keys) {
+        dbkeys.emplace_back(db_token_key(prefix, k).as_string());
+        slices.emplace_back(dbkeys.back());
+    }
+
+    auto values   = std::vector<std::string>();
+    auto statuses = db_->MultiGet(read_opts_, std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), get_handle(type)), slices, &values);
+    assert(statuses.size() == keys.size());
+
+    auto found = 0;
+    outs.resize(keys.size());
+    for(auto i = 0u; i < statuses.size(); i++) {
+        auto& status = statuses[i];
+        if(!status.ok()) {
+            if(!status.IsNotFound()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+            if(!no_throw) {
+                EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",keys[i])("p",prefix));
+            }
+            outs[i].clear();
+            continue;
+        }
+        outs[i] = std::move(values[i]);
+        found++;
+    }
+    return found;
+}
+
+int
+token_database_impl::read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw) const {
+    using namespace internal;
+
+    outs.resize(keys.size());
+
+    // check write cache first and only query missed keys from db
+    auto found  = 0;
+    auto misses = small_vector<size_t, 4>();
+    auto dbkeys = std::vector<std::string>();
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto key = db_asset_key(keys[i].first, keys[i].second);
+        if(assets_write_cache_.read(key.as_string_view(), outs[i])) {
+            found++;
+            continue;
+        }
+        misses.emplace_back(i);
+        dbkeys.emplace_back(key.as_string());
+    }
+
+    if(misses.empty()) {
+        return found;
+    }
+
+    auto slices = std::vector<rocksdb::Slice>(dbkeys.cbegin(), dbkeys.cend());
+    auto values = std::vector<std::string>();
+
+    auto statuses = db_->MultiGet(read_opts_, std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), assets_handle_), slices, &values);
+    assert(statuses.size() == misses.size());
+
+    for(auto i = 0u; i < statuses.size(); i++) {
+        auto& status = statuses[i];
+        auto  index  = misses[i];
+        if(!status.ok()) {
+            if(!status.IsNotFound()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+            if(!no_throw) {
+                EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", keys[index].second, keys[index].first);
+            }
+            outs[index].clear();
+            continue;
+        }
+        outs[index] = std::move(values[i]);
+        found++;
+    }
+    return found;
+}
+
+int
+token_database_impl::read_tokens_range(token_type type, const name128& prefix, int skip, const read_value_func& func) const {
+    using namespace internal;
+
+    auto it    = iterators_.acquire(db_, read_opts_, get_handle(type));
+    auto key   = rocksdb::Slice((char*)&prefix, sizeof(prefix));
+    auto i     = 0;
+    auto count = 0;
+    
+    it->Seek(key);
+    while(it->Valid()) {
+        if(i++ < skip) {
+            it->Next();
+            continue;
+        }
+
+        count++;
+        auto value = it->value().ToString();
+        auto key   = it->key();
+
+        key.remove_prefix(sizeof(prefix));
+        if(!func(key.ToStringView(), std::move(value))) {
+            return count;
+        }
+        it->Next();
+    }
+    return count;
+}
+
+int
+token_database_impl::read_tokens_range_after(token_type type, const name128& prefix, const name128& after, const read_value_func& func) const {
+    using namespace internal;
+
+    auto it    = iterators_.acquire(db_, read_opts_, get_handle(type));
+    auto dbkey = db_token_key(prefix, after);
+    auto count = 0;
+
+    // seeks to the cursor directly instead of skipping the keys before it
+    it->Seek(dbkey.as_slice());
+    if(it->Valid() && it->key() == dbkey.as_slice()) {
+        it->Next();
+    }
+    while(it->Valid()) {
+        count++;
+        auto value = it->value().ToString();
+        auto key   = it->key();
+
+        key.remove_prefix(sizeof(prefix));
+        if(!func(key.ToStringView(), std::move(value))) {
+            return count;
+        }
+        it->Next();
+    }
+    return count;
+}
+
+int
+token_database_impl::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
+    using namespace internal;
+
+    // pending values in write cache are merged while scanning
+    // instead of being written into db and restored from a snapshot after that
+    auto pendings = std::vector<std::pair<std::string_view, const std::string*>>();
+    for(auto& it : assets_write_cache_.data_) {
+        if(memcmp(it.first().data(), &sym_id, kSymbolIdSize) == 0) {
+            pendings.emplace_back(std::string_view(it.first().data(), it.first().size()), &it.second.value);
+        }
+    }
+    std::sort(pendings.begin(), pendings.end());
+
+    auto it = iterators_.acquire(db_, read_opts_, assets_handle_);
+    return merge_assets_range(*it, sym_id, pendings, skip, func);
+}
+
+void
+token_database_impl::update_owner_index(rocksdb::WriteBatch& batch,
+                                        const std::string_view& key,
+                                        const std::string_view& old_value,
+                                        const std::string_view& new_value) {
+    using namespace internal;
+
+    auto olds = extract_token_owners(old_value);
+    auto news = extract_token_owners(new_value);
+    for(auto& o : olds) {
+        if(std::find(news.cbegin(), news.cend(), o) == news.cend()) {
+            batch.Delete(owners_handle_, db_owner_key(o, key));
+        }
+    }
+    for(auto& n : news) {
+        if(std::find(olds.cbegin(), olds.cend(), n) == olds.cend()) {
+            batch.Put(owners_handle_, db_owner_key(n, key), rocksdb::Slice());
+        }
+    }
+}
+
+int
+token_database_impl::read_tokens_by_owner(const rocksdb::ReadOptions& opts, const address& owner, int skip, const read_value_func& func) const {
+    using namespace internal;
+
+    EVT_ASSERT(owners_handle_ != nullptr, token_database_exception, "Owner index of token database is not enabled");
+
+    auto prefix = db_owner_key(owner, std::string_view());
+    auto it     = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(opts, owners_handle_));
+    auto i      = 0;
+    auto count  = 0;
+
+    for(it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        auto key = it->key();
+        key.remove_prefix(prefix.size());
+
+        // skips the ones of other owners with the same hash
+        auto value  = std::string();
+        auto status = db_->Get(opts, get_handle(token_type::token), key, &value);
+        if(!status.ok()) {
+            if(!status.IsNotFound()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+            continue;
+        }
+        auto owners = extract_token_owners(value);
+        if(std::find(owners.cbegin(), owners.cend(), owner) == owners.cend()) {
+            continue;
+        }
+
+        if(i++ < skip) {
+            continue;
+        }
+        count++;
+        if(!func(key.ToStringView(), std::move(value))) {
+            break;
+        }
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+    return count;
+}
+
+void
+token_database_impl::read_balance_symbols(const rocksdb::ReadOptions& opts, const address& addr, std::set<symbol_id_type>& syms) const {
+    using namespace internal;
+
+    EVT_ASSERT(balances_handle_ != nullptr, token_database_exception, "Balance index of token database is not enabled");
+
+    auto prefix = std::string(kPublicKeySize, '\0');
+    addr.to_bytes(prefix.data(), prefix.size());
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(opts, balances_handle_));
+    for(it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, it->key().data() + kPublicKeySize, kSymbolIdSize);
+        syms.insert(sym_id);
+    }
+    if(!it->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+    }
+}
+
+namespace internal {
+
+// passes the balances of `syms` read by `read` to `func` in the order of symbol ids, keys passed are the symbol ids
+template<typename ReadAssets>
+int
+read_balances_of(const address& addr, const std::set<symbol_id_type>& syms, ReadAssets&& read, const read_value_func& func) {
+    auto keys = small_vector<asset_key_t, 4>();
+    for(auto sym_id : syms) {
+        keys.emplace_back(addr, sym_id);
+    }
+    auto outs = small_vector<std::string, 4>();
+    read(keys, outs);
+
+    auto count = 0;
+    for(auto i = 0u; i < keys.size(); i++) {
+        if(outs[i].empty()) {
+            continue;
+        }
+        count++;
+        if(!func(std::string_view((const char*)&keys[i].second, sizeof(symbol_id_type)), std::move(outs[i]))) {
+            break;
+        }
+    }
+    return count;
+}
+
+// whether db key of asset `key` is the one of `addr`, `addr` is in bytes
+bool
+is_asset_of(const std::string_view& key, const std::string& addr) {
+    return key.size() == kSymbolIdSize + kPublicKeySize && memcmp(key.data() + kSymbolIdSize, addr.data(), kPublicKeySize) == 0;
+}
+
+}  // namespace internal
+
+int
+token_database_impl::read_assets_by_address(const address& addr, const read_value_func& func) const {
+    using namespace internal;
+
+    auto syms = std::set<symbol_id_type>();
+    read_balance_symbols(read_opts_, addr, syms);
+
+    // balances created in pending savepoints are not in index yet
+    auto bytes = std::string(kPublicKeySize, '\0');
+    addr.to_bytes(bytes.data(), bytes.size());
+    for(auto& it : assets_write_cache_.data_) {
+        auto key = std::string_view(it.first().data(), it.first().size());
+        if(is_asset_of(key, bytes)) {
+            auto sym_id = symbol_id_type();
+            memcpy(&sym_id, key.data(), kSymbolIdSize);
+            syms.insert(sym_id);
+        }
+    }
+
+    return read_balances_of(addr, syms, [this](auto& keys, auto& outs) { read_assets(keys, outs, true); }, func);
+}
+
+size_t
+token_database_impl::prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const {
+    using namespace internal;
+
+    auto handles = std::vector<rocksdb::ColumnFamilyHandle*>();
+    auto keys    = std::vector<std::string>();
+    for(auto& t : tokens) {
+        auto type = get_token_type_by_prefix(t.first);
+        if(!type.has_value()) {
+            continue;
+        }
+        handles.emplace_back(get_handle(*type));
+        keys.emplace_back(db_token_key(t.first, t.second).as_string());
+    }
+    for(auto& a : assets) {
+        handles.emplace_back(assets_handle_);
+        keys.emplace_back(db_asset_key(a.first, a.second).as_string());
+    }
+    if(keys.empty()) {
+        return 0;
+    }
+
+    auto opts       = read_opts_;
+    opts.fill_cache = true;
+
+    auto slices = std::vector<rocksdb::Slice>(keys.cbegin(), keys.cend());
+    auto values = std::vector<std::string>();
+    auto status = db_->MultiGet(opts, handles, slices, &values);
+
+    auto found = (size_t)0;
+    for(auto& st : status) {
+        found += st.ok();
+    }
+    return found;
+}
+
+void
+token_database_impl::update_holders_index(const std::string_view& key, const std::string_view& value) {
+    using namespace internal;
+
+    if(holders_index_.empty()) {
+        return;
+    }
+
+    auto sym_id = symbol_id_type();
+    memcpy(&sym_id, key.data(), kSymbolIdSize);
+
+    auto it = holders_index_.find(sym_id);
+    if(it == holders_index_.end()) {
+        return;
+    }
+
+    auto k = std::string(key.substr(kSymbolIdSize));
+    if(auto rit = holders_ranks_.find(sym_id); rit != holders_ranks_.end()) {
+        auto& ranks = rit->second;
+        if(auto hit = it->second.find(k); hit != it->second.end()) {
+            ranks.erase(std::make_pair(extract_asset_amount(hit->second), k));
+        }
+        ranks.emplace(extract_asset_amount(value), k);
+    }
+    it->second.insert_or_assign(std::move(k), std::string(value));
+}
+
+void
+token_database_impl::erase_from_holders_index(const std::string_view& key) {
+    using namespace internal;
+
+    if(holders_index_.empty()) {
+        return;
+    }
+
+    auto sym_id = symbol_id_type();
+    memcpy(&sym_id, key.data(), kSymbolIdSize);
+
+    auto it = holders_index_.find(sym_id);
+    if(it == holders_index_.end()) {
+        return;
+    }
+
+    auto hit = it->second.find(std::string(key.substr(kSymbolIdSize)));
+    if(hit == it->second.end()) {
+        return;
+    }
+    if(auto rit = holders_ranks_.find(sym_id); rit != holders_ranks_.end()) {
+        rit->second.erase(std::make_pair(extract_asset_amount(hit->second), hit->first));
+    }
+    it->second.erase(hit);
+}
+
+// hottest keys of each type with their estimated reads and writes, keys are decoded from db keys
+fc::variant
+token_database_impl::hot_keys() const {
+    using namespace internal;
+
+    if(!key_heat_) {
+        return fc::variant();
+    }
+
+    auto types = fc::mutable_variant_object();
+    for(auto i = 0; i <= (int)token_type::max_value; i++) {
+        auto type = (token_type)i;
+        auto keys = fc::variants();
+        for(auto& h : key_heat_->top(type)) {
+            auto v = fc::mutable_variant_object();
+            if(type == token_type::asset) {
+                auto sym_id = symbol_id_type();
+                memcpy(&sym_id, h.key.data(), kSymbolIdSize);
+                v("sym_id", sym_id)("address", address::from_bytes(h.key.data() + kSymbolIdSize, kPublicKeySize));
+            }
+            else {
+                auto prefix = name128(), key = name128();
+                memcpy(&prefix, h.key.data(), sizeof(name128));
+                memcpy(&key, h.key.data() + sizeof(name128), sizeof(name128));
+                if(type == token_type::token) {
+                    v("domain", prefix);
+                }
+                v("key", key);
+            }
+            v("reads", h.reads)("writes", h.writes);
+            keys.emplace_back(std::move(v));
+        }
+        if(!keys.empty()) {
+            types(token_database_metrics::type_name(type), std::move(keys));
+        }
+    }
+    return fc::mutable_variant_object()
+        ("window_secs", config_.hot_keys_window)
+        ("types", std::move(types));
+}
+
+fc::sha256
+token_database_impl::state_hash() const {
+    if(!state_hash_.has_value()) {
+        auto h = full_state_hash();
+        if(!config_.state_hash) {
+            return h.result();
+        }
+        state_hash_ = h;
+    }
+    return state_hash_->result();
+}
+
+internal::hash_accumulator
+token_database_impl::full_state_hash() const {
+    using namespace internal;
+
+    auto acc = hash_accumulator();
+
+    auto total_opts             = read_opts_;
+    total_opts.total_order_seek = true;
+
+    auto check = [](auto& it) {
+        if(!it->status().ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", it->status().getState()));
+        }
+    };
+
+    // layout marker is not part of the state
+    auto marker  = db_token_key(kLayoutMarkerPrefix, kLayoutMarkerKey);
+    auto scanned = std::vector<rocksdb::ColumnFamilyHandle*>();
+    for(auto h : handles_) {
+        if(h == assets_handle_ || std::find(scanned.cbegin(), scanned.cend(), h) != scanned.cend()) {
+            continue;
+        }
+        scanned.emplace_back(h);
+
+        auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, h));
+        for(it->SeekToFirst(); it->Valid(); it->Next()) {
+            auto key = it->key().ToStringView();
+            if(h == tokens_handle_ && key == marker.as_string_view()) {
+                continue;
+            }
+            acc.add(hash_accumulator::hash_row(key, it->value().ToStringView()));
+        }
+        check(it);
+    }
+
+    // pending values in write cache override the persisted ones
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(total_opts, assets_handle_));
+    for(it->SeekToFirst(); it->Valid(); it->Next()) {
+        auto key = it->key().ToStringView();
+        if(assets_write_cache_.exists(key)) {
+            continue;
+        }
+        acc.add(hash_accumulator::hash_row(key, it->value().ToStringView()));
+    }
+    check(it);
+
+    for(auto& e : assets_write_cache_.data_) {
+        acc.add(hash_accumulator::hash_row(std::string_view(e.first().data(), e.first().size()), e.second.value));
+    }
+    return acc;
+}
+
+const token_database_impl::holders_map_t&
+token_database_impl::load_holders(const symbol_id_type sym_id) const {
+    auto it = holders_index_.find(sym_id);
+    if(it != holders_index_.end()) {
+        return it->second;
+    }
+
+    // build index with persisted values only, pending ones are in write cache
+    auto map = holders_map_t();
+
+    auto iter = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_opts_, assets_handle_));
+    auto key  = rocksdb::Slice((char*)&sym_id, sizeof(sym_id));
+    for(iter->Seek(key); iter->Valid(); iter->Next()) {
+        auto k = iter->key();
+        k.remove_prefix(sizeof(sym_id));
+        map.emplace_hint(map.cend(), k.ToString(), iter->value().ToString());
+    }
+    if(!iter->status().ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", iter->status().getState()));
+    }
+
+    return holders_index_.emplace(sym_id, std::move(map)).first->second;
+}
+
+size_t
+token_database_impl::warm_assets_holders(const symbol_id_type sym_id) const {
+    return load_holders(sym_id).size();
+}
+
+token_database_impl::holders_map_t
+token_database_impl::pending_holders(const symbol_id_type sym_id) const {
+    using namespace internal;
+
+    // collect pending values of this symbol, normally it's far less than the holders
+    auto pendings = holders_map_t();
+    for(auto& e : assets_write_cache_.data_) {
+        auto k = e.first();
+        if(memcmp(k.data(), &sym_id, kSymbolIdSize) != 0) {
+            continue;
+        }
+        pendings.insert_or_assign(k.substr(kSymbolIdSize).str(), e.second.value);
+    }
+    return pendings;
+}
+
+int
+token_database_impl::read_assets_holders(const symbol_id_type sym_id, const read_value_func& func) const {
+    using namespace internal;
+
+    auto& holders  = load_holders(sym_id);
+    auto  pendings = pending_holders(sym_id);
+
+    // merge both in the key order, which is the same order as database
+    auto hit      = holders.cbegin();
+    auto pit      = pendings.cbegin();
+    auto count    = 0;
+
+    while(hit != holders.cend() || pit != pendings.cend()) {
+        auto v = std::string();
+        auto k = std::string_view();
+        if(pit == pendings.cend() || (hit != holders.cend() && hit->first < pit->first)) {
+            k = hit->first;
+            v = hit->second;
+            hit++;
+        }
+        else {
+            if(hit != holders.cend() && hit->first == pit->first) {
+                hit++;
+            }
+            k = pit->first;
+            v = pit->second;
+            pit++;
+        }
+
+        count++;
+        if(!func(k, std::move(v))) {
+            break;
+        }
+    }
+    return count;
+}
+
+int
+token_database_impl::read_assets_top_holders(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
+    using namespace internal;
+
+    auto& holders  = load_holders(sym_id);
+    auto  pendings = pending_holders(sym_id);
+
+    auto rit = holders_ranks_.find(sym_id);
+    if(rit == holders_ranks_.end()) {
+        auto ranks = holders_rank_t();
+        for(auto& h : holders) {
+            ranks.emplace(extract_asset_amount(h.second), h.first);
+        }
+        rit = holders_ranks_.emplace(sym_id, std::move(ranks)).first;
+    }
+
+    // pending values override the persisted ones, so they are ranked separately and merged
+    auto ptops = holders_rank_t();
+    for(auto& p : pendings) {
+        ptops.emplace(extract_asset_amount(p.second), p.first);
+    }
+
+    auto& ranks = rit->second;
+    auto  cmp   = holder_rank_order();
+    auto  hit   = ranks.cbegin();
+    auto  pit   = ptops.cbegin();
+    auto  count = 0;
+
+    while(true) {
+        // persisted ones with pending values are stale
+        while(hit != ranks.cend() && pendings.find(hit->second) != pendings.cend()) {
+            hit++;
+        }
+        if(hit == ranks.cend() && pit == ptops.cend()) {
+            break;
+        }
+
+        auto k = std::string_view();
+        auto v = std::string();
+        if(pit == ptops.cend() || (hit != ranks.cend() && cmp(*hit, *pit))) {
+            k = hit->second;
+            v = holders.at(hit->second);
+            hit++;
+        }
+        else {
+            k = pit->second;
+            v = pendings.at(pit->second);
+            pit++;
+        }
+
+        if(skip > 0) {
+            skip--;
+            continue;
+        }
+
+        count++;
+        if(!func(k, std::move(v))) {
+            break;
+        }
+    }
+    return count;
+}
+
+void
+token_database_impl::add_savepoint(int64_t seq) {
+    using namespace internal;
+    check_writable();
+
+    if(!savepoints_.empty()) {
+        auto& b = savepoints_.back();
+        if(b.seq >= seq) {
+            EVT_THROW(token_database_seq_not_valid, "Seq is not valid, prev: ${prev}, curr: ${curr}",
+                      ("prev", b.seq)("curr", seq));
+        }
+    }
+
+    commit_savepoints();
+
+    savepoints_.push_back(savepoint(seq, kRuntime));
+    auto rt = new_rt_group();
+    SETPOINTER(void, savepoints_.back().node.group, rt);
+    savepoints_.back().state_hash = state_hash_;
+
+    assets_write_cache_.add_savepoint(seq);
+}
+
+internal::rt_group*
+token_database_impl::new_rt_group() {
+    using namespace internal;
+
+    auto mem = arenas_.acquire();
+    return mem->create<rt_group>(rt_group { .rb_snapshot = (const void*)db_->GetSnapshot(), .actions = {}, .mem = mem });
+}
+
+void
+token_database_impl::free_rt_group(internal::rt_group* rt) {
+    using namespace internal;
+
+    auto mem = rt->mem;
+    rt->~rt_group();
+    arenas_.release(mem);
+}
+
+void
+token_database_impl::free_savepoint(internal::savepoint& sp) {
+    using namespace internal;
+
+    auto n = sp.node;
+
+    switch(n.f.type) {
+    case kRuntime: {
+        auto rt = GETPOINTER(rt_group, n.group);
+        for(auto& act : rt->actions) {
+            if(act.get_data_type() == kTokenKeys) {
+                auto p = GETPOINTER(rt_token_keys, act.data);
+                //need to call dtor of keys manually
+                p->keys.~token_keys_t();
+            }
+        }
+        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+        free_rt_group(rt);
+        break;
+    }
+    case kPersist: {
+        auto pd = GETPOINTER(pd_group, n.group);
+        delete pd;
+        break;
+    }
+    }  // switch
+}
+
+void
+token_database_impl::free_all_savepoints() {
+    while(!savepoints_.empty()) {
+        free_savepoint(savepoints_.front());
+        savepoints_.pop_front();
+    }
+}
+
+void
+token_database_impl::pop_savepoints(int64_t until) {
+    while(!savepoints_.empty() && savepoints_.front().seq < until) {
+        auto it = std::move(savepoints_.front());
+        savepoints_.pop_front();
+        free_savepoint(it);
+    }
+    // write cache is popped later in `commit_savepoints`
+    commit_until_ = std::max(commit_until_, until);
+
+    // without savepoints, balances are written into db directly (including by ingester),
+    // so the pending ones in write cache are flushed now or they would shadow the newer values
+    if(savepoints_.empty()) {
+        commit_savepoints();
+    }
+}
+
+void
+token_database_impl::commit_savepoints() {
+    auto& ops = assets_write_cache_.ops_;
+    if(ops.empty() || ops.front().seq >= commit_until_) {
+        return;
+    }
+
+    // pop write cache of all the popped savepoints and persist into underlying db with one batch
+    auto batch = rocksdb::WriteBatch();
+    while(!ops.empty() && ops.front().seq < commit_until_) {
+        assets_write_cache_.pop_front([&](auto& k, auto&& v) {
+            batch.Put(assets_handle_, rocksdb::Slice(k.data(), k.size()), v);
+            if(balances_handle_ != nullptr) {
+                batch.Put(balances_handle_, internal::db_balance_key(std::string_view(k.data(), k.size())), rocksdb::Slice());
+            }
+            update_holders_index(std::string_view(k.data(), k.size()), v);
+            hot_update(std::string_view(k.data(), k.size()), v);
+        });
+    }
+
+    auto status = db_->Write(commit_write_opts(), &batch);
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+void
+token_database_impl::pop_back_savepoint() {
+    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+
+    auto it = std::move(savepoints_.back());
+    savepoints_.pop_back();
+    free_savepoint(it);
+
+    assets_write_cache_.pop_back();
+}
+
+void
+token_database_impl::squash() {
+    using namespace internal;
+    EVT_ASSERT(savepoints_.size() >= 2, token_database_squash_exception, "Squash needs at least two savepoints.");
+    
+    auto n = savepoints_.back().node;
+    EVT_ASSERT(n.f.type == kRuntime, token_database_squash_exception, "Squash needs two realtime savepoints.");
+
+    savepoints_.pop_back();
+    auto n2 = savepoints_.back().node;
+    EVT_ASSERT(n2.f.type == kRuntime, token_database_squash_exception, "Squash needs two realtime savepoints.");
+
+    auto rt1 = GETPOINTER(rt_group, n.group);
+    auto rt2 = GETPOINTER(rt_group, n2.group);
+
+    // link all actions from rt1 into end of rt2, chunks are kept by merging arenas below
+    rt2->actions.splice(rt1->actions);
+
+    // just release rt1's snapshot, data of actions are moved into rt2's arena
+    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt1->rb_snapshot);
+
+    auto mem1 = rt1->mem;
+    rt1->~rt_group();
+    rt2->mem->merge(*mem1);
+    arenas_.release(mem1);
+
+    assets_write_cache_.squash();
+}
+
+int64_t
+token_database_impl::latest_savepoint_seq() const {
+    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+    return savepoints_.back().seq;
+}
+
+std::vector<token_delta>
+token_database_impl::latest_savepoint_deltas() const {
+    using namespace internal;
+    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+
+    auto deltas  = std::vector<token_delta>();
+    auto key_set = keys_hash_set();
+
+    // keys of different types are deduplicated separately
+    auto first_seen = [&](token_type type, const std::string_view& key) {
+        auto k = std::string(1, (char)type);
+        k.append(key);
+        return key_set.insert(k).second;
+    };
+
+    auto add = [&](token_type type, std::string&& key) {
+        if(!first_seen(type, key)) {
+            return;
+        }
+        auto value  = std::string();
+        auto status = db_->Get(read_opts_, get_handle(type), key, &value);
+        if(!status.ok() && !status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        deltas.emplace_back(token_delta { .type = type, .key = std::move(key), .value = std::move(value) });
+    };
+
+    auto& n = savepoints_.back().node;
+    switch(n.f.type) {
+    case kRuntime: {
+        auto rt = GETPOINTER(rt_group, n.group);
+        for(auto& act : rt->actions) {
+            if(act.get_data_type() == kTokenKeys) {
+                auto keys = GETPOINTER(rt_token_keys, act.data);
+                for(auto& k : keys->keys) {
+                    add(act.get_token_type(), db_token_key(keys->prefix, k).as_string());
+                }
+                continue;
+            }
+            add(act.get_token_type(), get_sp_key(act));
+        }
+        break;
+    }
+    case kPersist: {
+        auto pd = GETPOINTER(pd_group, n.group);
+        for(auto& act : pd->actions) {
+            add((token_type)act.type, std::string(act.key));
+        }
+        break;
+    }
+    }  // switch
+
+    // assets of the savepoint are still in write cache
+    auto& ops = assets_write_cache_.ops_;
+    if(!ops.empty() && ops.back().seq == savepoints_.back().seq) {
+        for(auto& op : ops.back().vec) {
+            if(!first_seen(token_type::asset, std::string_view(op.it->first().data(), op.it->first().size()))) {
+                continue;
+            }
+            deltas.emplace_back(token_delta { .type = token_type::asset, .key = op.it->first().str(), .value = op.it->second.value });
+        }
+    }
+    return deltas;
+}
+
+int64_t
+token_database_impl::new_savepoint_session_seq() const {
+    int64_t seq = 1;
+    if(!savepoints_.empty()) {
+        seq = savepoints_.back().seq + 1;
+    }
+    return seq;
+}
+
+void
+token_database_impl::record(uint8_t action_type, uint8_t op, uint8_t data_type, void* data) {
+    using namespace internal;
+
+    if(!should_record()) {
+        return;
+    }
+    auto n = savepoints_.back().node;
+    assert(n.f.type == kRuntime);
+
+    auto rt = GETPOINTER(rt_group, n.group);
+    rt->actions.emplace_back(*rt->mem, rt_action(action_type, op, data_type, data));
+}
+
+namespace internal {
+
+std::string
+get_sp_key(const rt_action& act) {
+    switch(act.get_data_type()) {
+    case kTokenKey: {
+        auto data = GETPOINTER(rt_token_key, act.data);
+        return db_token_key(action_key_prefixes[act.f.type], data->key).as_string();
+    }
+    case kTokenFullKey: {
+        auto data = GETPOINTER(rt_token_fullkey, act.data);
+        return db_token_key(data->prefix, data->key).as_string();
+    }
+    case kAssetKey: {
+        auto data = GETPOINTER(rt_asset_key, act.data);
+        return std::string(data->key, sizeof(data->key));
+    }
+    case kTokenKeys: {
+        assert(false);
+    }
+    }  // switch
+    return std::string();
+}
+
+}  // namespace internal
+
+void
+token_database_impl::rollback_rt_group(internal::rt_group* rt) {
+    using namespace internal;
+
+    if(rt->actions.empty()) {
+        db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+        return;
+    }
+
+    auto snapshot_read_opts_     = read_opts_;
+    snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
+
+    auto key_set = keys_hash_set();
+    auto batch   = rocksdb::WriteBatch();
+    
+    for(auto it = rt->actions.begin(); it != rt->actions.end(); ++it) {
+        auto data = GETPOINTER(void, it->data);
+
+        auto fn = [&](auto& key, auto type, auto op) {
+            hot_remove(key);
+
+            // owner index is moved from the current value back to the old one
+            auto rollback_owners = [&](const std::string_view& old_value) {
+                if(indexes_owners(type)) {
+                    auto cur = std::string();
+                    db_->Get(read_opts_, get_handle(type), key, &cur);
+                    update_owner_index(batch, key, cur, old_value);
+                }
+            };
+
+            switch(op) {
+            case action_op::add: {
+                assert(key_set.find(key) == key_set.end());
+
+                rollback_owners(std::string_view());
+                batch.Delete(get_handle(type), key);
+                self_.remove_token_value(key);
+                mark_dirty(key);
+            
+                // insert key into key set
+                key_set.insert(key);
+                break;
+            }
+            case action_op::update: {
+                // only update operation need to check if key is already processed
+                if(key_set.find(key) != key_set.end()) {
+                    break;
+                }
+                auto old_value = std::string();
+                auto status    = db_->Get(snapshot_read_opts_, get_handle(type), key, &old_value);
+                if(!status.ok()) {
+                    FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                }
+                rollback_owners(old_value);
+                batch.Put(get_handle(type), key, old_value);
+                self_.rollback_token_value(key);
+                mark_dirty(key);
+
+                // insert key into key set
+                key_set.insert(key);
+                break;
+            }
+            case action_op::put: {
+                // only update operation need to check if key is already processed
+                if(key_set.find(key) != key_set.end()) {
+                    break;
+                }
+
+                // Asset type only has put op
+                auto handle    = get_handle(type);
+                auto old_value = std::string();
+                auto status    = db_->Get(snapshot_read_opts_, handle, key, &old_value);
+
+                // key may not existed in latest snapshot, remove it
+                if(!status.ok()) {
+                    if(status.code() != rocksdb::Status::kNotFound) {
+                        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                    }
+                    rollback_owners(std::string_view());
+                    batch.Delete(handle, key);
+                    if(type != token_type::asset) {
+                        self_.remove_token_value(key);
+                        mark_dirty(key);
+                    }
+                }
+                else {
+                    rollback_owners(old_value);
+                    batch.Put(handle, key, old_value);
+                    if(type != token_type::asset) {
+                        self_.rollback_token_value(key);
+                        mark_dirty(key);
+                    }
+                }
+
+                // insert key into key set
+                key_set.insert(key);
+                break;
+            }
+            }  // switch
+        };
+
+        auto op         = it->get_action_op();
+        auto data_type  = it->get_data_type();
+        auto type       = it->get_token_type();
+
+        switch(data_type) {
+        case kTokenKey:
+        case kTokenFullKey:
+        case kAssetKey: {
+            auto key  = get_sp_key(*it);
+            fn(key, type, op);
+            break;
+        }
+        case kTokenKeys: {
+            auto  keys   = (rt_token_keys*)data;
+            auto& prefix = keys->prefix;
+            for(auto& k : keys->keys) {
+                auto key = db_token_key(prefix, k).as_string();
+                fn(key, type, op);
+            }
+
+            //need to call dtor of keys manually
+            keys->keys.~token_keys_t();
+            break;
+        }
+        }  // switch
+    }  // for
+
+    auto sync_write_opts = commit_write_opts();
+    db_->Write(sync_write_opts, &batch);
+
+    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+}
+
+void
+token_database_impl::rollback_pd_group(internal::pd_group* pd) {
+    using namespace internal;
+
+    if(pd->actions.empty()) {
+        return;
+    }
+
+    // keyset is not required here,
+    // because it has done during creating persist savepoint
+    auto batch = rocksdb::WriteBatch();
+    for(auto it = pd->actions.begin(); it < pd->actions.end(); it++) {
+        hot_remove(it->key);
+
+        // values restored may have been read since savepoints were loaded, the same as runtime ones
+        // caches and the results checked against their versions are invalidated
+        if((token_type)it->type != token_type::asset) {
+            auto key = rocksdb::Slice(it->key);
+            if(it->value.empty()) {
+                self_.remove_token_value(key);
+            }
+            else {
+                self_.rollback_token_value(key);
+            }
+            mark_dirty(it->key);
+        }
+        else {
+            // persisted assets are restored into db directly, bypassing the write cache
+            if(it->value.empty()) {
+                erase_from_holders_index(it->key);
+            }
+            else {
+                update_holders_index(it->key, it->value);
+            }
+        }
+
+        if(indexes_owners((token_type)it->type)) {
+            auto cur = std::string();
+            db_->Get(read_opts_, get_handle(it->type), it->key, &cur);
+            update_owner_index(batch, it->key, cur, it->value);
+        }
+
+        switch((action_op)it->op) {
+        case action_op::add: {
+            assert(it->value.empty());
+            batch.Delete(get_handle(it->type), it->key);
+            break;
+        }
+        case action_op::update: {
+            assert(!it->value.empty());
+            batch.Put(get_handle(it->type), it->key, it->value);
+            break;
+        }
+        case action_op::put: {
+            // Asset type only has put op
+            auto handle = get_handle(it->type);
+            if(it->value.empty()) {
+                batch.Delete(handle, it->key);
+            }
+            else {
+                batch.Put(handle, it->key, it->value);
+            }
+            break;
+        }
+        }  // switch
+    }
+
+    auto sync_write_opts = commit_write_opts();
+    db_->Write(sync_write_opts, &batch);
+}
+
+void
+token_database_impl::rollback_to_latest_savepoint() {
+    using namespace internal;
+    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
+
+    auto  seq = savepoints_.back().seq;
+    auto& n   = savepoints_.back().node;
+
+    // persisted savepoints have no state hash, it's calculated again at next query
+    if(config_.state_hash) {
+        state_hash_ = savepoints_.back().state_hash;
+    }
+
+    switch(n.f.type) {
+    case kRuntime: {
+        auto rt = GETPOINTER(rt_group, n.group);
+        rollback_rt_group(rt);
+        free_rt_group(rt);
+
+        break;
+    }
+    case kPersist: {
+        auto pd = GETPOINTER(pd_group, n.group);
+        rollback_pd_group(pd);
+        delete pd;
+
+        break;
+    }
+    }  // switch
+
+    savepoints_.pop_back();
+
+    assert(seq == assets_write_cache_.ops_.back().seq);
+    assets_write_cache_.rollback_to_latest_savepoint();
+}
+
+void
+token_database_impl::persist_savepoints() const {
+    using namespace internal;
+
+    try {
+        auto filename = config_.db_path / config::token_database_persisit_filename;
+        if(fc::exists(filename)) {
+            fc::remove(filename);
+        }
+        auto fs = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(filename.to_native_ansi_path(), (std::ios::out | std::ios::binary));
+
+        auto h = pd_header {
+            .dirty_flag = 1
+        };
+        // set dirty first
+        fc::raw::pack(fs, h);
+
+        persist_savepoints(fs);
+        assets_write_cache_.persist_savepoints(fs);
+
+        // clear dirty
+        fs.seekp(0);
+        h.dirty_flag = 0;
+        fc::raw::pack(fs, h);
+
+        // flush and close
+        fs.flush();
+        fs.close();
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_persist_exception);
+}
+
+void
+token_database_impl::load_savepoints() {
+    auto filename = config_.db_path / config::token_database_persisit_filename;
+    if(!fc::exists(filename)) {
+        wlog("No savepoints log in token database");
+        return;
+    }
+
+    auto fs = std::fstream();
+    fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+    fs.open(filename.to_native_ansi_path(), (std::ios::in | std::ios::binary));
+
+    // delete old savepoints if existed (from snapshot)
+    savepoints_.clear();
+    assets_write_cache_.clear();
+
+    // load
+    load_savepoints(fs);
+    assets_write_cache_.load_savepoints(fs);
+
+    // close
+    fs.close();
+}
+
+void
+token_database_impl::persist_derived_state() const {
+    using namespace internal;
+
+    try {
+        auto payload = ds_payload();
+        if(config_.state_hash && state_hash_.has_value()) {
+            payload.state_hash.assign(state_hash_->words.cbegin(), state_hash_->words.cend());
+        }
+        if(link_filter_) {
+            auto ss = fc::datastream<size_t>();
+            link_filter_->persist(ss);
+
+            payload.link_filter.resize(ss.tellp());
+            auto ds = fc::datastream<char*>(payload.link_filter.data(), payload.link_filter.size());
+            link_filter_->persist(ds);
+        }
+
+        auto data = fc::raw::pack(payload);
+        auto h    = ds_header {
+            .version       = kDerivedStateVersion,
+            .db_seq        = db_->GetLatestSequenceNumber(),
+            .savepoint_seq = savepoints_.empty() ? -1 : savepoints_.back().seq,
+            .checksum      = fc::sha256::hash(data.data(), data.size())
+        };
+
+        auto filename = config_.db_path / config::token_database_derived_filename;
+        auto fs       = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(filename.to_native_ansi_path(), (std::ios::out | std::ios::binary | std::ios::trunc));
+
+        fc::raw::pack(fs, h);
+        fs.write(data.data(), data.size());
+        fs.flush();
+        fs.close();
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_persist_exception);
+}
+
+bool
+token_database_impl::load_derived_state() {
+    using namespace internal;
+
+    auto filename = config_.db_path / config::token_database_derived_filename;
+    if(!fc::exists(filename)) {
+        return false;
+    }
+
+    auto valid = false;
+    try {
+        auto fs = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(filename.to_native_ansi_path(), (std::ios::in | std::ios::binary));
+
+        auto h = ds_header();
+        fc::raw::unpack(fs, h);
+
+        auto sp_seq = savepoints_.empty() ? -1 : savepoints_.back().seq;
+        if(h.version == kDerivedStateVersion && h.db_seq == db_->GetLatestSequenceNumber() && h.savepoint_seq == sp_seq) {
+            auto size = fc::file_size(filename) - fs.tellg();
+            auto data = std::vector<char>(size);
+            fs.read(data.data(), data.size());
+
+            if(fc::sha256::hash(data.data(), data.size()) == h.checksum) {
+                auto payload = fc::raw::unpack<ds_payload>(data);
+                if(config_.state_hash && payload.state_hash.size() == 4) {
+                    auto acc = hash_accumulator();
+                    std::copy(payload.state_hash.cbegin(), payload.state_hash.cend(), acc.words.begin());
+                    state_hash_ = acc;
+                }
+                if(config_.evtlink_filter && !payload.link_filter.empty()) {
+                    auto ds = fc::datastream<const char*>(payload.link_filter.data(), payload.link_filter.size());
+                    link_filter_ = std::make_unique<key_filter>();
+                    link_filter_->load(ds);
+                }
+                valid = true;
+            }
+        }
+        fs.close();
+    }
+    catch(const fc::exception& e) {
+        wlog("Cannot load derived state of token database: ${e}", ("e",e.to_string()));
+    }
+    catch(const std::exception& e) {
+        wlog("Cannot load derived state of token database: ${e}", ("e",e.what()));
+    }
+    if(!valid) {
+        wlog("Derived state of token database is stale or corrupted, rebuild it by scanning database");
+    }
+
+    // it's stale after any writes, removed so a crash later never picks it up
+    fc::remove(filename);
+    return valid;
+}
+
+void
+token_database_impl::persist_warm_keys(const std::vector<std::string>& keys) const {
+    try {
+        // written into a temporary file first, so a crash never leaves a partial one
+        auto filename = config_.db_path / config::token_database_warmkeys_filename;
+        auto tmpname  = fc::path(filename.generic_string() + ".tmp");
+
+        auto fs = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(tmpname.to_native_ansi_path(), (std::ios::out | std::ios::binary | std::ios::trunc));
+        fc::raw::pack(fs, keys);
+        fs.flush();
+        fs.close();
+
+        fc::rename(tmpname, filename);
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_persist_exception);
+}
+
+void
+token_database_impl::start_warmup() {
+    using namespace internal;
+
+    auto filename = config_.db_path / config::token_database_warmkeys_filename;
+    if(!fc::exists(filename)) {
+        return;
+    }
+
+    auto keys = std::vector<std::string>();
+    try {
+        auto fs = std::fstream();
+        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+        fs.open(filename.to_native_ansi_path(), (std::ios::in | std::ios::binary));
+        fc::raw::unpack(fs, keys);
+        fs.close();
+    }
+    catch(const fc::exception& e) {
+        wlog("Cannot load warm keys of token database: ${e}", ("e",e.to_string()));
+        return;
+    }
+    catch(const std::exception& e) {
+        wlog("Cannot load warm keys of token database: ${e}", ("e",e.what()));
+        return;
+    }
+    if(keys.size() > config_.warmup_keys) {
+        keys.resize(config_.warmup_keys);
+    }
+
+    // values are read only to be loaded into block cache, they are not used
+    warmup_stop_   = false;
+    warmup_thread_ = std::thread([this, keys = std::move(keys)] {
+        auto opts       = read_opts_;
+        opts.fill_cache = true;
+
+        auto count = 0u;
+        for(auto i = 0u; i < keys.size() && !warmup_stop_; i += kWarmupBatchSize) {
+            auto handles = std::vector<rocksdb::ColumnFamilyHandle*>();
+            auto slices  = std::vector<rocksdb::Slice>();
+            for(auto j = i; j < std::min<size_t>(keys.size(), i + kWarmupBatchSize); j++) {
+                auto& k = keys[j];
+                if(k.size() < sizeof(name128)) {
+                    continue;
+                }
+                auto prefix = name128();
+                memcpy(&prefix, k.data(), sizeof(prefix));
+                auto type = get_token_type_by_prefix(prefix);
+                if(!type.has_value()) {
+                    continue;
+                }
+                handles.emplace_back(get_handle(*type));
+                slices.emplace_back(k);
+            }
+
+            auto values = std::vector<std::string>();
+            auto status = db_->MultiGet(opts, handles, slices, &values);
+            for(auto& s : status) {
+                count += s.ok();
+            }
+        }
+        ilog("Prefetched ${n} warm keys of token database", ("n",count));
+    });
+}
+
+void
+token_database_impl::stop_warmup() {
+    if(warmup_thread_.joinable()) {
+        warmup_stop_ = true;
+        warmup_thread_.join();
+    }
+}
+
+void
+token_database_impl::persist_savepoints(std::ostream& os) const {
+    using namespace internal;
+
+    auto pds = std::vector<pd_group>();
+
+    for(auto i = 0u; i < savepoints_.size(); i++) {
+        auto& sp = savepoints_[i];
+
+        auto pd = pd_group();
+        pd.seq  = sp.seq;
+
+        auto n = sp.node;
+
+        switch(n.f.type) {
+        case kPersist: {
+            auto pd2 = GETPOINTER(pd_group, n.group);
+            pd.actions.insert(pd.actions.cbegin(), pd2->actions.cbegin(), pd2->actions.cend());
+            
+            break;
+        }
+        case kRuntime: {
+            auto rt = GETPOINTER(rt_group, n.group);
+
+            auto key_set = keys_hash_set();
+
+            auto snapshot_read_opts_     = read_opts_;
+            snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
+
+            for(auto& act : rt->actions) {
+                auto data = GETPOINTER(void, act.data);
+
+                auto fn = [&](const auto& key, auto type, auto op) {
+                    auto value = std::string();
+
+                    switch(op) {
+                    case action_op::add: {
+                        assert(key_set.find(key) == key_set.end());
+
+                        // no need to read value
+                        key_set.insert(key);
+                        break;
+                    }
+                    case action_op::update: {
+                        if(key_set.find(key) != key_set.end()) {
+                            break;
+                        }
+
+                        auto status = db_->Get(snapshot_read_opts_, get_handle(type), key, &value);
+                        if(!status.ok()) {
+                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                        }
+
+                        key_set.insert(key);
+                        break;
+                    }
+                    case action_op::put: {
+                        if(key_set.find(key) != key_set.end()) {
+                            break;
+                        }
+
+                        auto status = db_->Get(snapshot_read_opts_, get_handle(type), key, &value);
+                        
+                        // key may not existed in latest snapshot
+                        if(!status.ok() && status.code() != rocksdb::Status::kNotFound) {
+                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+                        }
+
+                        key_set.insert(key);
+                        break;
+                    }
+                    }  // switch
+
+                    return value;
+                };
+
+                auto op         = act.get_action_op();
+                auto data_type  = act.get_data_type();
+                auto type       = act.get_token_type();
+
+                auto pdact = pd_action();
+                pdact.op   = (int)op;
+                pdact.type = (int)type;
+
+                switch(data_type) {
+                case kTokenKey:
+                case kTokenFullKey:
+                case kAssetKey: {
+                    pdact.key   = get_sp_key(act);
+                    pdact.value = fn(pdact.key, type, op);
+                    pd.actions.emplace_back(std::move(pdact));
+                    break;
+                }
+                case kTokenKeys: {
+                    auto  keys   = (rt_token_keys*)data;
+                    auto& prefix = keys->prefix;
+                    for(auto& k : keys->keys) {
+                        pdact.key   = db_token_key(prefix, k).as_string();
+                        pdact.value = fn(pdact.key, type, op);
+                        pd.actions.emplace_back(pdact);
+                    }
+                    break;
+                }
+                }  // switch
+            }  // for
+            break;
+        }
+        }  // switch
+
+        pds.emplace_back(std::move(pd));
+    }  // for
+
+    fc::raw::pack(os, pds);
+}
+
+void
+token_database_impl::load_savepoints(std::istream& is) {
+    using namespace internal;
+
+    auto h = pd_header();
+    fc::raw::unpack(is, h);
+    EVT_ASSERT(h.dirty_flag == 0, token_database_dirty_flag_exception, "checkpoints log file dirty flag set");
+
+    auto pds = std::vector<pd_group>();
+    fc::raw::unpack(is, pds);
+
+    for(auto& pd : pds) {
+        savepoints_.push_back(savepoint(pd.seq, kPersist));
+
+        auto ppd = new pd_group(pd);
+        SETPOINTER(void, savepoints_.back().node.group, ppd);
+    }
+}
+
+void
+token_database_impl::flush() const {
+    auto status = db_->Flush(rocksdb::FlushOptions());
+    if(!status.ok()) {
+        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+    }
+}
+
+std::shared_ptr<token_database::read_view>
+token_database_impl::new_read_view() const {
+    auto view = std::shared_ptr<token_database::read_view>(new token_database::read_view(*this));
+
+    view->snapshot_ = db_->GetSnapshot();
+    view->pending_assets_.reserve(assets_write_cache_.data_.size());
+    for(auto& it : assets_write_cache_.data_) {
+        view->pending_assets_.emplace(it.first().str(), it.second.value);
+    }
+    return view;
+}
+
+std::vector<std::string>
+token_database_impl::pop_dirty_keys() {
+    auto keys = std::move(dirty_keys_);
+
+    dirty_keys_.clear();
+    track_dirty_ = true;
+
+    return keys;
+}
+
+std::unique_ptr<token_database::ingester>
+token_database_impl::new_ingester() {
+    check_writable();
+    EVT_ASSERT(savepoints_.empty(), token_database_exception, "Cannot ingest rows when there're savepoints");
+    EVT_ASSERT(config_.profile != storage_profile::memory, token_database_exception, "Database in memory profile doesn't support ingesting");
+    return std::unique_ptr<token_database::ingester>(new token_database::ingester(*this));
+}
+
+namespace internal {
+
+// reads of views are all pinned to the snapshot, tailing iterators ignore snapshot and see the latest writes
+// so they're never used by views, they're also kept out of the pool of iterators by having snapshot set
+rocksdb::ReadOptions
+get_view_read_opts(const rocksdb::ReadOptions& opts, const rocksdb::Snapshot* snapshot) {
+    auto read_opts     = opts;
+    read_opts.snapshot = snapshot;
+    read_opts.tailing  = false;
+    return read_opts;
+}
+
+}  // namespace internal
+
+token_database::read_view::read_view(const token_database_impl& db)
+    : db_(db)
+    , snapshot_(nullptr) {}
 
-        switch(data_type) {
-        case kTokenKey:
-        case kTokenFullKey:
-        case kAssetKey: {
-            auto key  = get_sp_key(*it);
-            fn(key, type, op);
-            break;
-        }
-        case kTokenKeys: {
-            auto  keys   = (rt_token_keys*)data;
-            auto& prefix = keys->prefix;
-            for(auto& k : keys->keys) {
-                auto key = db_token_key(prefix, k).as_string();
-                fn(key, type, op);
-            }
+token_database::read_view::~read_view() {
+    if(snapshot_ != nullptr && db_.db_ != nullptr) {
+        db_.db_->ReleaseSnapshot(snapshot_);
+    }
+}
 
-            //need to call dtor of keys manually
-            keys->keys.~token_keys_t();
-            break;
-        }
-        }  // switch
+int
+token_database::read_view::read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw) const {
+    using namespace internal;
 
-        free(data);
-    }  // for
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
 
-    auto sync_write_opts = write_opts_;
-    sync_write_opts.sync = true;
-    db_->Write(sync_write_opts, &batch);
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
 
-    db_->ReleaseSnapshot((const rocksdb::Snapshot*)rt->rb_snapshot);
+    auto dbkey  = db_token_key(prefix, key);
+    auto status = db_.db_->Get(read_opts, db_.get_handle(type), dbkey.as_slice(), &out);
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+        }
+        if(!no_throw) {
+            EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",key)("p",prefix));
+        }
+        return false;
+    }
+    return true;
 }
 
-void
-token_database_impl::rollback_pd_group(internal::pd_group* pd) {
+int
+token_database::read_view::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
     using namespace internal;
 
-    if(pd->actions.empty()) {
-        return;
+    auto key = db_asset_key(addr, sym_id);
+    if(!pending_assets_.empty()) {
+        auto it = pending_assets_.find(key.as_string());
+        if(it != pending_assets_.end()) {
+            out = it->second;
+            return true;
+        }
     }
 
-    // keyset is not required here,
-    // because it has done during creating persist savepoint
-    // cache rollback is also no need here
-    // because cache cannot have persist value objects
-    auto batch = rocksdb::WriteBatch();
-    for(auto it = pd->actions.begin(); it < pd->actions.end(); it++) {
-        switch((action_op)it->op) {
-        case action_op::add: {
-            assert(it->value.empty());
-            batch.Delete(it->key);
-            break;
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto status = db_.db_->Get(read_opts, db_.assets_handle_, key.as_slice(), &out);
+    if(!status.ok()) {
+        if(!status.IsNotFound()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
         }
-        case action_op::update: {
-            assert(!it->value.empty());
-            batch.Put(it->key, it->value);
-            break;
+        if(!no_throw) {
+            EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", sym_id, addr);
         }
-        case action_op::put: {
-            // Asset type only has put op
-            auto handle = (it->type == (int)token_type::asset) ? assets_handle_ : tokens_handle_;
-            if(it->value.empty()) {
-                batch.Delete(handle, it->key);
+        return false;
+    }
+    return true;
+}
+
+int
+token_database::read_view::read_tokens(token_type type,
+                                       const std::optional<name128>& domain,
+                                       const small_vector_base<name128>& keys,
+                                       small_vector_base<std::string>& outs,
+                                       bool no_throw) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto dbkeys = std::vector<std::string>();
+    auto slices = std::vector<rocksdb::Slice>();
+    dbkeys.reserve(keys.size());
+    slices.reserve(keys.size());
+
+    for(auto& k : keys) {
+        dbkeys.emplace_back(db_token_key(prefix, k).as_string());
+        slices.emplace_back(dbkeys.back());
+    }
+
+    auto values   = std::vector<std::string>();
+    auto statuses = db_.db_->MultiGet(read_opts, std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), db_.get_handle(type)), slices, &values);
+    assert(statuses.size() == keys.size());
+
+    auto found = 0;
+    outs.resize(keys.size());
+    for(auto i = 0u; i < statuses.size(); i++) {
+        auto& status = statuses[i];
+        if(!status.ok()) {
+            if(!status.IsNotFound()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
             }
-            else {
-                batch.Put(handle, it->key, it->value);
+            if(!no_throw) {
+                EVT_THROW(unknown_token_database_key, "Cannot find key: ${k} with prefix: ${p}", ("k",keys[i])("p",prefix));
             }
-            break;
+            outs[i].clear();
+            continue;
         }
-        }  // switch
+        outs[i] = std::move(values[i]);
+        found++;
     }
-
-    auto sync_write_opts = write_opts_;
-    sync_write_opts.sync = true;
-    db_->Write(sync_write_opts, &batch);
+    return found;
 }
 
-void
-token_database_impl::rollback_to_latest_savepoint() {
+int
+token_database::read_view::read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw) const {
     using namespace internal;
-    EVT_ASSERT(!savepoints_.empty(), token_database_no_savepoint, "There's no savepoints anymore");
 
-    auto  seq = savepoints_.back().seq;
-    auto& n   = savepoints_.back().node;
+    outs.resize(keys.size());
 
-    switch(n.f.type) {
-    case kRuntime: {
-        auto rt = GETPOINTER(rt_group, n.group);
-        rollback_rt_group(rt);
-        delete rt;
+    // check pending assets first and only query missed keys from db
+    auto found  = 0;
+    auto misses = small_vector<size_t, 4>();
+    auto dbkeys = std::vector<std::string>();
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto key = db_asset_key(keys[i].first, keys[i].second).as_string();
+        if(!pending_assets_.empty()) {
+            auto it = pending_assets_.find(key);
+            if(it != pending_assets_.end()) {
+                outs[i] = it->second;
+                found++;
+                continue;
+            }
+        }
+        misses.emplace_back(i);
+        dbkeys.emplace_back(std::move(key));
+    }
 
-        break;
+    if(misses.empty()) {
+        return found;
     }
-    case kPersist: {
-        auto pd = GETPOINTER(pd_group, n.group);
-        rollback_pd_group(pd);
-        delete pd;
 
-        break;
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto slices   = std::vector<rocksdb::Slice>(dbkeys.cbegin(), dbkeys.cend());
+    auto values   = std::vector<std::string>();
+    auto statuses = db_.db_->MultiGet(read_opts, std::vector<rocksdb::ColumnFamilyHandle*>(slices.size(), db_.assets_handle_), slices, &values);
+    assert(statuses.size() == misses.size());
+
+    for(auto i = 0u; i < statuses.size(); i++) {
+        auto& status = statuses[i];
+        auto  index  = misses[i];
+        if(!status.ok()) {
+            if(!status.IsNotFound()) {
+                FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
+            }
+            if(!no_throw) {
+                EVT_THROW2(unknown_token_database_key, "There's no balance of fungible with sym id: {} in address: {}", keys[index].second, keys[index].first);
+            }
+            outs[index].clear();
+            continue;
+        }
+        outs[index] = std::move(values[i]);
+        found++;
     }
-    }  // switch
+    return found;
+}
 
-    savepoints_.pop_back();
+int
+token_database::read_view::read_tokens_by_owner(const address& owner, int skip, const read_value_func& func) const {
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
 
-    assert(seq == assets_write_cache_.ops_.back().seq);
-    assets_write_cache_.rollback_to_latest_savepoint();
+    return db_.read_tokens_by_owner(read_opts, owner, skip, func);
 }
 
-void
-token_database_impl::persist_savepoints() const {
+int
+token_database::read_view::read_assets_by_address(const address& addr, const read_value_func& func) const {
     using namespace internal;
 
-    try {
-        auto filename = config_.db_path / config::token_database_persisit_filename;
-        if(fc::exists(filename)) {
-            fc::remove(filename);
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto syms = std::set<symbol_id_type>();
+    db_.read_balance_symbols(read_opts, addr, syms);
+
+    auto bytes = std::string(kPublicKeySize, '\0');
+    addr.to_bytes(bytes.data(), bytes.size());
+    for(auto& it : pending_assets_) {
+        if(is_asset_of(it.first, bytes)) {
+            auto sym_id = symbol_id_type();
+            memcpy(&sym_id, it.first.data(), kSymbolIdSize);
+            syms.insert(sym_id);
         }
-        auto fs = std::fstream();
-        fs.exceptions(std::fstream::failbit | std::fstream::badbit);
-        fs.open(filename.to_native_ansi_path(), (std::ios::out | std::ios::binary));
+    }
 
-        auto h = pd_header {
-            .dirty_flag = 1
-        };
-        // set dirty first
-        fc::raw::pack(fs, h);
+    return read_balances_of(addr, syms, [this](auto& keys, auto& outs) { read_assets(keys, outs, true); }, func);
+}
 
-        persist_savepoints(fs);
-        assets_write_cache_.persist_savepoints(fs);
+int
+token_database::read_view::read_tokens_range(token_type type, const std::optional<name128>& domain, int skip, const read_value_func& func) const {
+    using namespace internal;
 
-        // clear dirty
-        fs.seekp(0);
-        h.dirty_flag = 0;
-        fc::raw::pack(fs, h);
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
 
-        // flush and close
-        fs.flush();
-        fs.close();
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_.db_->NewIterator(read_opts, db_.get_handle(type)));
+    auto key   = rocksdb::Slice((char*)&prefix, sizeof(prefix));
+    auto i     = 0;
+    auto count = 0;
+
+    it->Seek(key);
+    while(it->Valid()) {
+        if(i++ < skip) {
+            it->Next();
+            continue;
+        }
+
+        count++;
+        auto value = it->value().ToString();
+        auto key   = it->key();
+
+        key.remove_prefix(sizeof(prefix));
+        if(!func(key.ToStringView(), std::move(value))) {
+            return count;
+        }
+        it->Next();
     }
-    EVT_CAPTURE_AND_RETHROW(token_database_persist_exception);
+    return count;
 }
 
-void
-token_database_impl::load_savepoints() {
-    auto filename = config_.db_path / config::token_database_persisit_filename;
-    if(!fc::exists(filename)) {
-        wlog("No savepoints log in token database");
-        return;
+int
+token_database::read_view::read_tokens_range_after(token_type type, const std::optional<name128>& domain, const name128& after, const read_value_func& func) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto it    = std::unique_ptr<rocksdb::Iterator>(db_.db_->NewIterator(read_opts, db_.get_handle(type)));
+    auto dbkey = db_token_key(prefix, after);
+    auto count = 0;
+
+    it->Seek(dbkey.as_slice());
+    if(it->Valid() && it->key() == dbkey.as_slice()) {
+        it->Next();
     }
+    while(it->Valid()) {
+        count++;
+        auto value = it->value().ToString();
+        auto key   = it->key();
 
-    auto fs = std::fstream();
-    fs.exceptions(std::fstream::failbit | std::fstream::badbit);
-    fs.open(filename.to_native_ansi_path(), (std::ios::in | std::ios::binary));
+        key.remove_prefix(sizeof(prefix));
+        if(!func(key.ToStringView(), std::move(value))) {
+            return count;
+        }
+        it->Next();
+    }
+    return count;
+}
 
-    // delete old savepoints if existed (from snapshot)
-    savepoints_.clear();
-    assets_write_cache_.clear();
+int
+token_database::read_view::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
+    using namespace internal;
 
-    // load
-    load_savepoints(fs);
-    assets_write_cache_.load_savepoints(fs);
+    // pending values of this symbol, merged with values in snapshot by key order
+    auto pendings = std::vector<std::pair<std::string_view, const std::string*>>();
+    for(auto& it : pending_assets_) {
+        if(memcmp(it.first.data(), &sym_id, kSymbolIdSize) == 0) {
+            pendings.emplace_back(it.first, &it.second);
+        }
+    }
+    std::sort(pendings.begin(), pendings.end());
 
-    // close
-    fs.close();
+    auto read_opts = internal::get_view_read_opts(db_.read_opts_, snapshot_);
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_.db_->NewIterator(read_opts, db_.assets_handle_));
+    return merge_assets_range(*it, sym_id, pendings, skip, func);
 }
 
-void
-token_database_impl::persist_savepoints(std::ostream& os) const {
+std::string
+token_database::read_view::get_db_key(token_type type, const std::optional<name128>& domain, const name128& key) const {
     using namespace internal;
 
-    auto pds = std::vector<pd_group>();
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    auto  dkey   = db_token_key(prefix, key);
+    return dkey.as_string();
+}
 
-    for(auto i = 0u; i < savepoints_.size(); i++) {
-        auto& sp = savepoints_[i];
+namespace internal {
 
-        auto pd = pd_group();
-        pd.seq  = sp.seq;
+size_t
+values_size(const small_vector_base<std::string>& values) {
+    auto sz = 0u;
+    for(auto& v : values) {
+        sz += v.size();
+    }
+    return sz;
+}
 
-        auto n = sp.node;
+}  // namespace internal
 
-        switch(n.f.type) {
-        case kPersist: {
-            auto pd2 = GETPOINTER(pd_group, n.group);
-            pd.actions.insert(pd.actions.cbegin(), pd2->actions.cbegin(), pd2->actions.cend());
-            
-            break;
-        }
-        case kRuntime: {
-            auto rt = GETPOINTER(rt_group, n.group);
+// rows of each column family are buffered and written into one sorted sst file once buffer is full
+// files are ingested in the order they are written, so later files override the same keys in former ones
+class token_database_ingester : boost::noncopyable {
+private:
+    struct buffer {
+        std::vector<std::pair<std::string, std::string>> rows;
+        size_t                                           bytes = 0;
+    };
 
-            auto key_set = keys_hash_set();
+public:
+    token_database_ingester(token_database_impl& db)
+        : db_(db)
+        , dir_(db.config_.db_path / internal::kIngestDirName)
+        , files_num_(0) {
+        if(fc::exists(dir_)) {
+            fc::remove_all(dir_);
+        }
+        fc::create_directories(dir_);
+    }
 
-            auto snapshot_read_opts_     = read_opts_;
-            snapshot_read_opts_.snapshot = (const rocksdb::Snapshot*)rt->rb_snapshot;
+    ~token_database_ingester() {
+        try {
+            if(fc::exists(dir_)) {
+                fc::remove_all(dir_);
+            }
+        }
+        catch(...) {}
+    }
 
-            for(auto& act : rt->actions) {
-                auto data = GETPOINTER(void, act.data);
+public:
+    void
+    put(rocksdb::ColumnFamilyHandle* handle, const rocksdb::Slice& key, const std::string_view& value) {
+        auto& buf = buffers_[handle];
+        buf.rows.emplace_back(key.ToString(), std::string(value));
+        buf.bytes += key.size() + value.size();
+
+        if(buf.bytes >= internal::kIngestFileSize) {
+            write_file(handle, buf);
+        }
+    }
 
-                auto fn = [&](const auto& key, auto type, auto op) {
-                    auto value = std::string();
+    void
+    finish() {
+        for(auto& it : buffers_) {
+            write_file(it.first, it.second);
+        }
+        buffers_.clear();
 
-                    switch(op) {
-                    case action_op::add: {
-                        assert(key_set.find(key) == key_set.end());
+        auto opts = rocksdb::IngestExternalFileOptions();
+        opts.move_files           = true;
+        opts.allow_global_seqno   = true;
+        opts.allow_blocking_flush = true;
 
-                        // no need to read value
-                        key_set.insert(key);
-                        break;
-                    }
-                    case action_op::update: {
-                        if(key_set.find(key) != key_set.end()) {
-                            break;
-                        }
+        for(auto& f : files_) {
+            check(db_.db_->IngestExternalFile(f.first, { f.second }, opts));
+        }
+        files_.clear();
 
-                        auto status = db_->Get(snapshot_read_opts_, key, &value);
-                        if(!status.ok()) {
-                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                        }
+        // ingested tokens are not in owner index yet
+        if(db_.owners_handle_ != nullptr) {
+            db_.build_owner_index();
+        }
 
-                        key_set.insert(key);
-                        break;
-                    }
-                    case action_op::put: {
-                        if(key_set.find(key) != key_set.end()) {
-                            break;
-                        }
+        // holders index is built from database lazily again
+        db_.holders_index_.clear();
+        db_.holders_ranks_.clear();
+        if(db_.hot_) {
+            db_.hot_->clear();
+        }
+        if(db_.config_.state_hash) {
+            db_.state_hash_ = db_.full_state_hash();
+        }
+    }
 
-                        auto handle = (type == token_type::asset) ? assets_handle_ : tokens_handle_;
-                        auto status = db_->Get(snapshot_read_opts_, handle, key, &value);
-                        
-                        // key may not existed in latest snapshot
-                        if(!status.ok() && status.code() != rocksdb::Status::kNotFound) {
-                            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-                        }
+    token_database_impl& db() { return db_; }
 
-                        key_set.insert(key);
-                        break;
-                    }
-                    }  // switch
+private:
+    void
+    write_file(rocksdb::ColumnFamilyHandle* handle, buffer& buf) {
+        if(buf.rows.empty()) {
+            return;
+        }
 
-                    return value;
-                };
+        auto cmp = handle->GetComparator();
+        std::stable_sort(buf.rows.begin(), buf.rows.end(), [cmp](auto& lhs, auto& rhs) {
+            return cmp->Compare(lhs.first, rhs.first) < 0;
+        });
 
-                auto op         = act.get_action_op();
-                auto data_type  = act.get_data_type();
-                auto type       = act.get_token_type();
+        auto path   = (dir_ / (std::to_string(files_num_++) + ".sst")).to_native_ansi_path();
+        auto writer = std::make_unique<rocksdb::SstFileWriter>(rocksdb::EnvOptions(), db_.db_->GetOptions(handle), handle);
+        check(writer->Open(path));
+        for(auto i = 0u; i < buf.rows.size(); i++) {
+            // keys should be strictly increasing in one file, only the last one of the same keys is kept
+            if(i + 1 < buf.rows.size() && cmp->Compare(buf.rows[i].first, buf.rows[i + 1].first) == 0) {
+                continue;
+            }
+            check(writer->Put(buf.rows[i].first, buf.rows[i].second));
+        }
+        check(writer->Finish());
 
-                auto pdact = pd_action();
-                pdact.op   = (int)op;
-                pdact.type = (int)type;
+        files_.emplace_back(handle, path);
+        buf.rows.clear();
+        buf.bytes = 0;
+    }
 
-                switch(data_type) {
-                case kTokenKey:
-                case kTokenFullKey:
-                case kAssetKey: {
-                    pdact.key   = get_sp_key(act);
-                    pdact.value = fn(pdact.key, type, op);
-                    pd.actions.emplace_back(std::move(pdact));
-                    break;
-                }
-                case kTokenKeys: {
-                    auto  keys   = (rt_token_keys*)data;
-                    auto& prefix = keys->prefix;
-                    for(auto& k : keys->keys) {
-                        pdact.key   = db_token_key(prefix, k).as_string();
-                        pdact.value = fn(pdact.key, type, op);
-                        pd.actions.emplace_back(pdact);
-                    }
-                    break;
-                }
-                }  // switch
-            }  // for
-            break;
+    static void
+    check(const rocksdb::Status& status) {
+        if(!status.ok()) {
+            FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.ToString()));
         }
-        }  // switch
+    }
 
-        pds.emplace_back(std::move(pd));
-    }  // for
+private:
+    token_database_impl& db_;
+    fc::path             dir_;
+    int                  files_num_;
 
-    fc::raw::pack(os, pds);
-}
+    std::unordered_map<rocksdb::ColumnFamilyHandle*, buffer>          buffers_;
+    std::vector<std::pair<rocksdb::ColumnFamilyHandle*, std::string>> files_;
+};
+
+token_database::ingester::ingester(token_database_impl& db)
+    : my_(std::make_unique<token_database_ingester>(db)) {}
+
+token_database::ingester::~ingester() = default;
 
 void
-token_database_impl::load_savepoints(std::istream& is) {
+token_database::ingester::put_token(token_type type, const std::optional<name128>& domain, const name128& key, const std::string_view& data) {
     using namespace internal;
 
-    auto h = pd_header();
-    fc::raw::unpack(is, h);
-    EVT_ASSERT(h.dirty_flag == 0, token_database_dirty_flag_exception, "checkpoints log file dirty flag set");
-
-    auto pds = std::vector<pd_group>();
-    fc::raw::unpack(is, pds);
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    auto  dbkey  = db_token_key(prefix, key);
+    my_->put(my_->db().get_handle(type), dbkey.as_slice(), data);
+    my_->db().filter_add(type, dbkey.as_string_view());
+}
 
-    for(auto& pd : pds) {
-        savepoints_.push_back(savepoint(pd.seq, kPersist));
+void
+token_database::ingester::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+    using namespace internal;
 
-        auto ppd = new pd_group(pd);
-        SETPOINTER(void, savepoints_.back().node.group, ppd);
+    auto dbkey = db_asset_key(addr, sym_id);
+    my_->put(my_->db().assets_handle_, dbkey.as_slice(), data);
+    if(my_->db().balances_handle_ != nullptr) {
+        my_->put(my_->db().balances_handle_, db_balance_key(dbkey.as_string_view()), std::string_view());
     }
 }
 
 void
-token_database_impl::flush() const {
-    auto status = db_->Flush(rocksdb::FlushOptions());
-    if(!status.ok()) {
-        FC_THROW_EXCEPTION(fc::unrecoverable_exception, "Rocksdb internal error: ${err}", ("err", status.getState()));
-    }
+token_database::ingester::finish() {
+    my_->finish();
 }
 
 token_database::token_database(const config& config)
@@ -1459,7 +4656,31 @@ token_database::put_token(token_type type, action_op op, const std::optional<nam
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    my_->track_key(type, db_token_key(prefix, key).as_string_view(), true);
+    if(!my_->metrics_) {
+        return my_->put_token(type, op, prefix, key, data);
+    }
+
+    auto t = token_database_metrics::timer();
     my_->put_token(type, op, prefix, key, data);
+    my_->metrics_->on_write(type, 1, data.size(), t.elapsed_us());
+}
+
+void
+token_database::append_token(token_type type, const std::optional<name128>& domain, const name128& key, uint32_t pos, uint32_t size, const std::string_view& item) {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    my_->track_key(type, db_token_key(prefix, key).as_string_view(), true);
+    if(!my_->metrics_) {
+        return my_->append_token(type, prefix, key, pos, size, item);
+    }
+
+    auto t = token_database_metrics::timer();
+    my_->append_token(type, prefix, key, pos, size, item);
+    my_->metrics_->on_write(type, 1, item.size(), t.elapsed_us());
 }
 
 void
@@ -1473,12 +4694,34 @@ token_database::put_tokens(token_type type,
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    for(auto& k : keys) {
+        my_->track_key(type, db_token_key(prefix, k).as_string_view(), true);
+    }
+    if(!my_->metrics_) {
+        return my_->put_tokens(type, op, prefix, std::move(keys), data);
+    }
+
+    auto t     = token_database_metrics::timer();
+    auto bytes = 0u;
+    for(auto& d : data) {
+        bytes += d.size();
+    }
     my_->put_tokens(type, op, prefix, std::move(keys), data);
+    my_->metrics_->on_write(type, data.size(), bytes, t.elapsed_us());
 }
 
 void
 token_database::put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+    using namespace internal;
+
+    my_->track_key(token_type::asset, db_asset_key(addr, sym_id).as_string_view(), true);
+    if(!my_->metrics_) {
+        return my_->put_asset(addr, sym_id, data);
+    }
+
+    auto t = token_database_metrics::timer();
     my_->put_asset(addr, sym_id, data);
+    my_->metrics_->on_write(token_type::asset, 1, data.size(), t.elapsed_us());
 }
 
 int
@@ -1488,7 +4731,7 @@ token_database::exists_token(token_type type, const std::optional<name128>& doma
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->exists_token(prefix, key);
+    return my_->exists_token(type, prefix, key);
 }
 
 int
@@ -1498,17 +4741,103 @@ token_database::exists_asset(const address& addr, const symbol_id_type sym_id) c
 
 int
 token_database::read_token(token_type type, const std::optional<name128>& domain, const name128& key, std::string& out, bool no_throw) const {
+    auto v = rocksdb::PinnableSlice();
+    auto r = read_token(type, domain, key, v, no_throw);
+    if(r) {
+        out.assign(v.data(), v.size());
+    }
+    return r;
+}
+
+int
+token_database::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
+    auto v = rocksdb::PinnableSlice();
+    auto r = read_asset(addr, sym_id, v, no_throw);
+    if(r) {
+        out.assign(v.data(), v.size());
+    }
+    return r;
+}
+
+int
+token_database::read_token(token_type type, const std::optional<name128>& domain, const name128& key, rocksdb::PinnableSlice& out, bool no_throw) const {
     using namespace internal;
 
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->read_token(prefix, key, out, no_throw);
+    my_->track_key(type, db_token_key(prefix, key).as_string_view(), false);
+    if(!my_->metrics_) {
+        return my_->read_token(type, prefix, key, out, no_throw);
+    }
+
+    // not found keys throw, so record in the scoped exit
+    auto t  = token_database_metrics::timer();
+    auto r  = 0;
+    auto sg = fc::make_scoped_exit([&] {
+        my_->metrics_->on_read(type, 1, r, r ? out.size() : 0, t.elapsed_us());
+    });
+    r = my_->read_token(type, prefix, key, out, no_throw);
+    return r;
 }
 
 int
-token_database::read_asset(const address& addr, const symbol_id_type sym_id, std::string& out, bool no_throw) const {
-    return my_->read_asset(addr, sym_id, out, no_throw);
+token_database::read_asset(const address& addr, const symbol_id_type sym_id, rocksdb::PinnableSlice& out, bool no_throw) const {
+    using namespace internal;
+
+    my_->track_key(token_type::asset, db_asset_key(addr, sym_id).as_string_view(), false);
+    if(!my_->metrics_) {
+        return my_->read_asset(addr, sym_id, out, no_throw);
+    }
+
+    auto t  = token_database_metrics::timer();
+    auto r  = 0;
+    auto sg = fc::make_scoped_exit([&] {
+        my_->metrics_->on_read(token_type::asset, 1, r, r ? out.size() : 0, t.elapsed_us());
+    });
+    r = my_->read_asset(addr, sym_id, out, no_throw);
+    return r;
+}
+
+int
+token_database::read_tokens(token_type type,
+                            const std::optional<name128>& domain,
+                            const small_vector_base<name128>& keys,
+                            small_vector_base<std::string>& outs,
+                            bool no_throw) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    for(auto& k : keys) {
+        my_->track_key(type, db_token_key(prefix, k).as_string_view(), false);
+    }
+    if(!my_->metrics_) {
+        return my_->read_tokens(type, prefix, keys, outs, no_throw);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_tokens(type, prefix, keys, outs, no_throw);
+    my_->metrics_->on_read(type, keys.size(), r, internal::values_size(outs), t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_assets(const small_vector_base<asset_key_t>& keys, small_vector_base<std::string>& outs, bool no_throw) const {
+    using namespace internal;
+
+    for(auto& k : keys) {
+        my_->track_key(token_type::asset, db_asset_key(k.first, k.second).as_string_view(), false);
+    }
+    if(!my_->metrics_) {
+        return my_->read_assets(keys, outs, no_throw);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_assets(keys, outs, no_throw);
+    my_->metrics_->on_read(token_type::asset, keys.size(), r, internal::values_size(outs), t.elapsed_us());
+    return r;
 }
 
 int
@@ -1518,12 +4847,121 @@ token_database::read_tokens_range(token_type type, const std::optional<name128>&
     assert(type != token_type::asset);
     assert((type == token_type::token) != (!domain.has_value()));
     auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
-    return my_->read_tokens_range(prefix, skip, func);
+    if(!my_->metrics_) {
+        return my_->read_tokens_range(type, prefix, skip, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_tokens_range(type, prefix, skip, func);
+    my_->metrics_->on_range(type, r, t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_tokens_range_after(token_type type, const std::optional<name128>& domain, const name128& after, const read_value_func& func) const {
+    using namespace internal;
+
+    assert(type != token_type::asset);
+    assert((type == token_type::token) != (!domain.has_value()));
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    if(!my_->metrics_) {
+        return my_->read_tokens_range_after(type, prefix, after, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_tokens_range_after(type, prefix, after, func);
+    my_->metrics_->on_range(type, r, t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_tokens_by_owner(const address& owner, int skip, const read_value_func& func) const {
+    if(!my_->metrics_) {
+        return my_->read_tokens_by_owner(my_->read_opts_, owner, skip, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_tokens_by_owner(my_->read_opts_, owner, skip, func);
+    my_->metrics_->on_range(token_type::token, r, t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_assets_by_address(const address& addr, const read_value_func& func) const {
+    if(!my_->metrics_) {
+        return my_->read_assets_by_address(addr, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_assets_by_address(addr, func);
+    my_->metrics_->on_range(token_type::asset, r, t.elapsed_us());
+    return r;
+}
+
+size_t
+token_database::prefetch(const std::vector<std::pair<name128, name128>>& tokens, const std::vector<asset_key_t>& assets) const {
+    return my_->prefetch(tokens, assets);
 }
 
 int
 token_database::read_assets_range(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
-    return my_->read_assets_range(sym_id, skip, func);
+    if(!my_->metrics_) {
+        return my_->read_assets_range(sym_id, skip, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_assets_range(sym_id, skip, func);
+    my_->metrics_->on_range(token_type::asset, r, t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_assets_top_holders(const symbol_id_type sym_id, int skip, const read_value_func& func) const {
+    if(!my_->metrics_) {
+        return my_->read_assets_top_holders(sym_id, skip, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_assets_top_holders(sym_id, skip, func);
+    my_->metrics_->on_range(token_type::asset, r, t.elapsed_us());
+    return r;
+}
+
+int
+token_database::read_assets_holders(const symbol_id_type sym_id, const read_value_func& func) const {
+    if(!my_->metrics_) {
+        return my_->read_assets_holders(sym_id, func);
+    }
+
+    auto t = token_database_metrics::timer();
+    auto r = my_->read_assets_holders(sym_id, func);
+    my_->metrics_->on_range(token_type::asset, r, t.elapsed_us());
+    return r;
+}
+
+size_t
+token_database::warm_assets_holders(const symbol_id_type sym_id) const {
+    return my_->warm_assets_holders(sym_id);
+}
+
+token_database_metrics*
+token_database::metrics() const {
+    return my_->metrics_.get();
+}
+
+fc::sha256
+token_database::state_hash() const {
+    return my_->state_hash();
+}
+
+bool
+token_database::state_hash_enabled() const {
+    return my_->config_.state_hash;
+}
+
+fc::variant
+token_database::hot_keys() const {
+    return my_->hot_keys();
 }
 
 token_database::session
@@ -1574,15 +5012,87 @@ token_database::latest_savepoint_seq() const {
     return my_->latest_savepoint_seq();
 }
 
+std::vector<token_delta>
+token_database::latest_savepoint_deltas() const {
+    return my_->latest_savepoint_deltas();
+}
+
+std::shared_ptr<token_database::read_view>
+token_database::new_read_view() const {
+    return my_->new_read_view();
+}
+
+std::unique_ptr<token_database::ingester>
+token_database::new_ingester() {
+    return my_->new_ingester();
+}
+
+std::vector<std::string>
+token_database::pop_dirty_keys() {
+    return my_->pop_dirty_keys();
+}
+
+uint32_t
+token_database::token_version(token_type type, const std::optional<name128>& domain, const name128& key) const {
+    using namespace internal;
+
+    auto& prefix = domain.has_value() ? *domain : action_key_prefixes[(int)type];
+    auto  dkey   = db_token_key(prefix, key);
+    return my_->token_version(dkey.as_string_view());
+}
+
 std::string
 token_database::stats() const {
     auto s = std::string();
     if(my_->db_->GetProperty(rocksdb::DB::Properties::kStats, &s)) {
+        if(my_->hot_) {
+            s += "\n** Hot Tier **\nkeys: " + std::to_string(my_->hot_->size()) + ", bytes: " + std::to_string(my_->hot_->bytes()) + "\n";
+        }
         return s;
     }
     return "NA";
 }
 
+std::map<std::string, uint64_t>
+token_database::int_stats() const {
+    static const std::string props[] = {
+        rocksdb::DB::Properties::kEstimateNumKeys,
+        rocksdb::DB::Properties::kCurSizeAllMemTables,
+        rocksdb::DB::Properties::kNumImmutableMemTable,
+        rocksdb::DB::Properties::kEstimateTableReadersMem,
+        rocksdb::DB::Properties::kTotalSstFilesSize,
+        rocksdb::DB::Properties::kLiveSstFilesSize,
+        rocksdb::DB::Properties::kEstimatePendingCompactionBytes,
+        rocksdb::DB::Properties::kNumRunningCompactions,
+        rocksdb::DB::Properties::kNumRunningFlushes,
+        rocksdb::DB::Properties::kBlockCacheUsage,
+        rocksdb::DB::Properties::kBlockCachePinnedUsage
+    };
+
+    auto r = std::map<std::string, uint64_t>();
+    for(auto& p : props) {
+        auto v = uint64_t(0);
+        if(my_->db_->GetIntProperty(p, &v)) {
+            r.emplace(p.substr(p.find('.') + 1), v);
+        }
+    }
+    if(my_->hot_) {
+        r.emplace("hot-tier-keys", my_->hot_->size());
+        r.emplace("hot-tier-bytes", my_->hot_->bytes());
+    }
+    if(my_->link_ttl_filter_) {
+        r.emplace("evtlinks-pruned", my_->link_ttl_filter_->pruned.load());
+    }
+    return r;
+}
+
+void
+token_database::prune_evtlinks_before(uint32_t block_num) {
+    if(my_->link_ttl_filter_) {
+        my_->link_ttl_filter_->before.store(block_num, std::memory_order_relaxed);
+    }
+}
+
 void
 token_database::flush() const {
     my_->flush();
@@ -1607,9 +5117,16 @@ token_database::get_db_key(token_type type, const std::optional<name128>& domain
     return dkey.as_string();
 }
 
+void
+token_database::persist_warm_keys(const std::vector<std::string>& keys) const {
+    my_->persist_warm_keys(keys);
+}
+
 }}  // namespace evt::chain
 
 FC_REFLECT(evt::chain::internal::pd_header, (dirty_flag));
+FC_REFLECT(evt::chain::internal::ds_header, (version)(db_seq)(savepoint_seq)(checksum));
+FC_REFLECT(evt::chain::internal::ds_payload, (state_hash)(link_filter));
 FC_REFLECT(evt::chain::internal::pd_action, (op)(type)(key)(value));
 FC_REFLECT(evt::chain::internal::pd_group,  (seq)(actions));
 FC_REFLECT(evt::chain::internal::wc_entry, (k)(v));
@@ -0,0 +1,46 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/token_database_replica.hpp>
+
+namespace evt { namespace chain {
+
+token_database_replica::token_database_replica(const token_database::config& config)
+    : config_(config)
+    , generation_(0) {
+    config_.read_replica = true;
+    db_ = open_instance();
+}
+
+std::shared_ptr<const token_database>
+token_database_replica::open_instance() const {
+    auto db = std::make_shared<token_database>(config_);
+    db->open(false /* load_persistence */);
+    return db;
+}
+
+void
+token_database_replica::catch_up() {
+    // new instance is opened before old one is released, so readers never see a closed database
+    auto db = open_instance();
+    std::atomic_store(&db_, std::move(db));
+    generation_++;
+}
+
+token_database_replica::read_view_ptr
+token_database_replica::new_read_view() const {
+    auto db   = current();
+    auto view = read_view_ptr(db->new_read_view());
+
+    // view shares ownership of the instance, its snapshot is released before database is closed
+    auto holder = std::make_shared<std::pair<std::shared_ptr<const token_database>, read_view_ptr>>(std::move(db), view);
+    return read_view_ptr(holder, view.get());
+}
+
+std::shared_ptr<const token_database>
+token_database_replica::current() const {
+    return std::atomic_load(&db_);
+}
+
+}}  // namespace evt::chain
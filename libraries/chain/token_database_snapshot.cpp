@@ -1,15 +1,36 @@
 #include <evt/chain/token_database_snapshot.hpp>
 
 #include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <fmt/format.h>
 #include <rocksdb/db.h>
+#include <fc/scoped_exit.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <evt/chain/block_state.hpp>
 #include <evt/chain/token_database.hpp>
 
 namespace evt { namespace chain {
 
 namespace internal {
 
+using read_view = token_database::read_view;
+
+// section stores the checksum of each section, in the order they are written
+const char* kChecksumSectionName = ".checksum";
+
+// sections of incremental snapshot: id of base block, and the rows changed since it
+const char* kDeltaBaseSectionName = ".delta-base";
+const char* kDeltaSectionName     = ".delta";
+
 // TODO: Replace with values provided by token database class directly
 const char* section_names[] = {
     ".asset",
@@ -25,30 +46,161 @@ const char* section_names[] = {
     ".psvbonus-dist"
 };
 
+template<typename Stream>
+void
+hash_row(Stream& enc, const std::string_view& key, const std::string& value) {
+    enc.write(key.data(), key.size());
+    fc::raw::pack(enc, value);
+}
+
+// rows of one section, collected by worker threads and written into snapshot in order
+struct section_buffer {
+    struct row {
+        uint8_t     key_size;
+        char        key[sizeof(fc::ecc::public_key_shim)];
+        std::string value;
+    };
+
+    void
+    add(const std::string_view& k, std::string&& v) {
+        assert(k.size() <= sizeof(row::key));
+
+        auto& r    = rows.emplace_back();
+        r.key_size = (uint8_t)k.size();
+        memcpy(r.key, k.data(), k.size());
+        r.value = std::move(v);
+
+        hash_row(enc, k, r.value);
+    }
+
+    std::vector<row>    rows;
+    fc::sha256::encoder enc;
+};
+
+struct section_task {
+    std::string                           name;
+    std::function<void(section_buffer&)> read;
+};
+
+using section_checksums = std::vector<std::pair<std::string, fc::sha256>>;
+
+// reads sections in worker threads, then writes them in the order of tasks from current thread
+// at most `threads * 2` sections are kept in memory
 void
-add_reserved_tokens(snapshot_writer_ptr          writer, 
-                    const token_database&        db, 
+write_sections(snapshot_writer_ptr writer, const std::vector<section_task>& tasks, size_t threads, section_checksums& checksums) {
+    auto buffers = std::vector<std::unique_ptr<section_buffer>>(tasks.size());
+    auto window  = threads * 2;
+    auto next    = (size_t)0;
+    auto written = (size_t)0;
+    auto stop    = false;
+    auto error   = std::exception_ptr();
+    auto mutex   = std::mutex();
+    auto cv      = std::condition_variable();
+
+    auto worker = [&] {
+        while(true) {
+            auto i = (size_t)0;
+            {
+                auto lock = std::unique_lock<std::mutex>(mutex);
+                cv.wait(lock, [&] { return stop || next >= tasks.size() || next < written + window; });
+                if(stop || next >= tasks.size()) {
+                    return;
+                }
+                i = next++;
+            }
+
+            auto buf = std::make_unique<section_buffer>();
+            try {
+                tasks[i].read(*buf);
+            }
+            catch(...) {
+                auto lock = std::unique_lock<std::mutex>(mutex);
+                if(!error) {
+                    error = std::current_exception();
+                }
+                stop = true;
+                cv.notify_all();
+                return;
+            }
+
+            auto lock  = std::unique_lock<std::mutex>(mutex);
+            buffers[i] = std::move(buf);
+            cv.notify_all();
+        }
+    };
+
+    auto workers = std::vector<std::thread>();
+    for(auto i = 0u; i < std::min(threads, tasks.size()); i++) {
+        workers.emplace_back(worker);
+    }
+
+    auto join_workers = fc::make_scoped_exit([&] {
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for(auto& w : workers) {
+            w.join();
+        }
+    });
+
+    for(auto i = 0u; i < tasks.size(); i++) {
+        auto buf = std::unique_ptr<section_buffer>();
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            cv.wait(lock, [&] { return buffers[i] != nullptr || error; });
+            if(error) {
+                break;
+            }
+            buf = std::move(buffers[i]);
+        }
+
+        writer->write_section(tasks[i].name, [&](auto& w) {
+            for(auto& r : buf->rows) {
+                w.add_row(r.key, r.key_size);
+                w.add_row(r.value);
+            }
+        });
+        checksums.emplace_back(tasks[i].name, buf->enc.result());
+
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex);
+            written = i + 1;
+        }
+        cv.notify_all();
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void
+add_reserved_tokens(snapshot_writer_ptr          writer,
+                    const read_view&             view,
+                    size_t                       threads,
                     std::vector<domain_name>&    domains,
-                    std::vector<symbol_id_type>& symbol_ids) {
+                    std::vector<symbol_id_type>& symbol_ids,
+                    section_checksums&           checksums) {
     static_assert(sizeof(section_names) / sizeof(char*) == (int)token_type::max_value + 1);
 
+    auto tasks = std::vector<section_task>();
     for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
         if(i == (int)token_type::asset || i == (int)token_type::token) {
             continue;
         }
-        writer->write_section(section_names[i], [&](auto& w) {
-            db.read_tokens_range((token_type)i, std::nullopt, 0, [&](auto& key, auto&& v) {
+        tasks.emplace_back(section_task { section_names[i], [&view, &domains, &symbol_ids, i](auto& buf) {
+            view.read_tokens_range((token_type)i, std::nullopt, 0, [&](auto& key, auto&& v) {
                 assert(key.size() == sizeof(name128));
 
-                w.add_row(key.data(), key.size());
-                w.add_row(v);
-
                 // we should use memcpy here
                 // it's UB when interpret char* as name128*
                 // because it may not be aligened
                 auto n = name128();
                 memcpy(&n, key.data(), sizeof(name128));
 
+                // only one task touches each of the vectors
                 if(i == (int)token_type::domain) {
                     domains.push_back(n);
                 }
@@ -56,45 +208,134 @@ add_reserved_tokens(snapshot_writer_ptr          writer,
                     symbol_ids.push_back((symbol_id_type)n.value);
                 }
 
+                buf.add(key, std::move(v));
                 return true;
             });
-        });
+        }});
     }
+    write_sections(writer, tasks, threads, checksums);
 }
 
 void
-add_tokens(snapshot_writer_ptr writer, const token_database& db, const std::vector<domain_name> domains) {
-    for(auto& d : domains) {
-        writer->write_section(d.to_string(), [&](auto& w) {
-            db.read_tokens_range(token_type::token, d, 0, [&w](auto& key, auto&& v) {
-                w.add_row(key.data(), key.size());
-                w.add_row(v);
+add_tokens(snapshot_writer_ptr             writer,
+           const read_view&                view,
+           size_t                          threads,
+           const std::vector<domain_name>& domains,
+           section_checksums&              checksums) {
+    auto tasks = std::vector<section_task>();
+    tasks.reserve(domains.size());
 
+    for(auto& d : domains) {
+        tasks.emplace_back(section_task { d.to_string(), [&view, d](auto& buf) {
+            view.read_tokens_range(token_type::token, d, 0, [&buf](auto& key, auto&& v) {
+                buf.add(key, std::move(v));
                 return true;
             });
-        });
+        }});
     }
+    write_sections(writer, tasks, threads, checksums);
 }
 
 void
-add_assets(snapshot_writer_ptr writer, const token_database& db, const std::vector<symbol_id_type>& symbol_ids) {
-    for(auto& id : symbol_ids) {
-        auto sn = fmt::format(".asset-{}", id);
-        writer->write_section(sn, [&](auto& w) {
-            db.read_assets_range(id, 0, [&w](auto& key, auto&& v) {
+add_assets(snapshot_writer_ptr                writer,
+           const read_view&                   view,
+           size_t                             threads,
+           const std::vector<symbol_id_type>& symbol_ids,
+           section_checksums&                 checksums) {
+    auto tasks = std::vector<section_task>();
+    tasks.reserve(symbol_ids.size());
+
+    for(auto id : symbol_ids) {
+        tasks.emplace_back(section_task { fmt::format(".asset-{}", id), [&view, id](auto& buf) {
+            view.read_assets_range(id, 0, [&buf](auto& key, auto&& v) {
                 assert(key.size() == sizeof(fc::ecc::public_key_shim));
-                w.add_row(key.data(), key.size());
-                w.add_row(v);
-
+                buf.add(key, std::move(v));
                 return true;
             });
-        });
+        }});
     }
+    write_sections(writer, tasks, threads, checksums);
+}
+
+fc::sha256
+add_checksums(snapshot_writer_ptr writer, const section_checksums& checksums) {
+    auto enc = fc::sha256::encoder();
+    writer->write_section(kChecksumSectionName, [&](auto& w) {
+        for(auto& c : checksums) {
+            w.add_row(c.first);
+            w.add_row(c.second.data(), c.second.data_size());
+
+            fc::raw::pack(enc, c.first);
+            fc::raw::pack(enc, c.second);
+        }
+    });
+    return enc.result();
+}
+
+using checksums_map = std::map<std::string, fc::sha256>;
+
+// snapshots created by old versions have no checksums, skip validation for them
+checksums_map
+read_checksums(snapshot_reader_ptr reader) {
+    auto checksums = checksums_map();
+    if(!reader->has_section(kChecksumSectionName)) {
+        return checksums;
+    }
+
+    reader->read_section(kChecksumSectionName, [&](auto& r) {
+        while(!r.eof()) {
+            auto name = std::string();
+            auto hash = fc::sha256();
+
+            r.read_row(name);
+            r.read_row(hash.data(), hash.data_size());
+
+            checksums.emplace(std::move(name), hash);
+        }
+    });
+    return checksums;
 }
 
+void
+validate_section(const checksums_map& checksums, const std::string& name, fc::sha256::encoder& enc) {
+    if(checksums.empty()) {
+        return;
+    }
+    auto it = checksums.find(name);
+    EVT_ASSERT2(it != checksums.cend() && it->second == enc.result(), token_database_snapshot_exception,
+        "Checksum of section: {} is not matched", name);
+}
+
+// rows read from snapshot are put into database directly or loaded by ingester
+struct rows_sink {
+    token_database&            db;
+    token_database::ingester*  ingester;
+
+    void
+    put_token(token_type type, const std::optional<name128>& domain, const name128& key, const std::string_view& data) {
+        if(ingester != nullptr) {
+            ingester->put_token(type, domain, key, data);
+        }
+        else {
+            db.put_token(type, action_op::put, domain, key, data);
+        }
+    }
+
+    void
+    put_asset(const address& addr, const symbol_id_type sym_id, const std::string_view& data) {
+        if(ingester != nullptr) {
+            ingester->put_asset(addr, sym_id, data);
+        }
+        else {
+            db.put_asset(addr, sym_id, data);
+        }
+    }
+};
+
 void
 read_reserved_tokens(snapshot_reader_ptr          reader,
-                     token_database&              db,
+                     rows_sink&                   db,
+                     const checksums_map&         checksums,
                      std::vector<domain_name>&    domains,
                      std::vector<symbol_id_type>& symbol_ids) {
     for(auto i = (int)token_type::domain; i <= (int)token_type::max_value; i++) {
@@ -103,14 +344,16 @@ read_reserved_tokens(snapshot_reader_ptr          reader,
         }
 
         reader->read_section(section_names[i], [&](auto& r) {
+            auto enc = fc::sha256::encoder();
             while(!r.eof()) {
                 auto k = uint128_t(0);
                 auto v = std::string();
 
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
+                hash_row(enc, std::string_view((char*)&k, sizeof(k)), v);
 
-                db.put_token((token_type)i, action_op::put, std::nullopt, k, std::string_view(v.data(), v.size()));
+                db.put_token((token_type)i, std::nullopt, k, std::string_view(v.data(), v.size()));
 
                 if(i == (int)token_type::domain) {
                     domains.emplace_back(k);
@@ -119,65 +362,140 @@ read_reserved_tokens(snapshot_reader_ptr          reader,
                     symbol_ids.emplace_back((symbol_id_type)k);
                 }
             }
+            validate_section(checksums, section_names[i], enc);
         });
     }
 }
 
 void
-read_tokens(snapshot_reader_ptr reader, token_database& db, const std::vector<domain_name>& domains) {
+read_tokens(snapshot_reader_ptr reader, rows_sink& db, const checksums_map& checksums, const std::vector<domain_name>& domains) {
     for(auto& d : domains) {
-        reader->read_section(d.to_string(), [&](auto& r) {
+        auto sn = d.to_string();
+        reader->read_section(sn, [&](auto& r) {
+            auto enc = fc::sha256::encoder();
             while(!r.eof()) {
                 auto k = name128();
                 auto v = std::string();
 
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
+                hash_row(enc, std::string_view((char*)&k, sizeof(k)), v);
 
-                db.put_token(token_type::token, action_op::put, d, k, std::string_view(v.data(), v.size()));
+                db.put_token(token_type::token, d, k, std::string_view(v.data(), v.size()));
             }
+            validate_section(checksums, sn, enc);
         });
     }
 }
 
 void
-read_assets(snapshot_reader_ptr reader, token_database& db, const std::vector<symbol_id_type>& symbol_ids) {
+read_assets(snapshot_reader_ptr reader, rows_sink& db, const checksums_map& checksums, const std::vector<symbol_id_type>& symbol_ids) {
     for(auto& id : symbol_ids) {
         auto sn = fmt::format(".asset-{}", id);
         reader->read_section(sn, [&](auto& r) {
+            auto enc = fc::sha256::encoder();
             while(!r.eof()) {
                 auto k = fc::ecc::public_key_shim();
                 auto v = std::string();
 
                 r.read_row((char*)&k, sizeof(k));
                 r.read_row(v);
+                hash_row(enc, std::string_view((char*)&k, sizeof(k)), v);
 
                 auto addr = address(public_key_type(k));
                 db.put_asset(addr, id, std::string_view(v.data(), v.size()));
             }
+            validate_section(checksums, sn, enc);
         });
     }
 }
 
+// keys of deltas are the ones in database, they're decoded and put by the same way as rows of full snapshots
+void
+read_deltas(snapshot_reader_ptr reader, token_database& db, const checksums_map& checksums) {
+    reader->read_section(kDeltaSectionName, [&](auto& r) {
+        auto enc = fc::sha256::encoder();
+        while(!r.eof()) {
+            auto t = uint8_t(0);
+            auto k = std::string();
+            auto v = std::string();
+
+            r.read_row((char*)&t, sizeof(t));
+            r.read_row(k);
+            r.read_row(v);
+            enc.write((char*)&t, sizeof(t));
+            hash_row(enc, k, v);
+
+            EVT_ASSERT2(t <= (uint8_t)token_type::max_value, token_database_snapshot_exception, "Invalid type of delta: {}", (int)t);
+            if(t == (uint8_t)token_type::asset) {
+                EVT_ASSERT2(k.size() == sizeof(symbol_id_type) + sizeof(fc::ecc::public_key_shim), token_database_snapshot_exception,
+                    "Invalid key of asset delta, size: {}", k.size());
+
+                auto sym_id = symbol_id_type();
+                memcpy(&sym_id, k.data(), sizeof(sym_id));
+
+                auto addr = address::from_bytes(k.data() + sizeof(sym_id), k.size() - sizeof(sym_id));
+                db.put_asset(addr, sym_id, v);
+                continue;
+            }
+
+            EVT_ASSERT2(k.size() == sizeof(name128) * 2, token_database_snapshot_exception, "Invalid key of token delta, size: {}", k.size());
+
+            // key is the prefix followed by the key, prefix is domain for tokens
+            auto prefix = name128();
+            auto key    = name128();
+            memcpy(&prefix, k.data(), sizeof(name128));
+            memcpy(&key, k.data() + sizeof(name128), sizeof(name128));
+
+            auto domain = (t == (uint8_t)token_type::token) ? std::make_optional(prefix) : std::nullopt;
+            db.put_token((token_type)t, action_op::put, domain, key, v);
+        }
+        validate_section(checksums, kDeltaSectionName, enc);
+    });
+}
+
+block_id_type
+read_head_block_id(snapshot_reader_ptr reader) {
+    auto bs = block_header_state();
+    reader->read_section<block_state>([&](auto& r) {
+        r.read_row(bs);
+    });
+    return bs.id;
+}
+
 }  // namespace internal
 
-void
-token_database_snapshot::add_to_snapshot(snapshot_writer_ptr writer, const token_database& db) {
+fc::sha256
+token_database_snapshot::add_to_snapshot(snapshot_writer_ptr writer, const token_database& db, size_t threads) {
+    // all the sections are read from the same view
+    auto view = db.new_read_view();
+    return add_to_snapshot(writer, *view, threads);
+}
+
+fc::sha256
+token_database_snapshot::add_to_snapshot(snapshot_writer_ptr writer, const token_database::read_view& view, size_t threads) {
     using namespace internal;
 
     try {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
         auto domains    = std::vector<domain_name>();
         auto symbol_ids = std::vector<symbol_id_type>();
+        auto checksums  = section_checksums();
+
+        add_reserved_tokens(writer, view, threads, domains, symbol_ids, checksums);
+        add_tokens(writer, view, threads, domains, checksums);
+        add_assets(writer, view, threads, symbol_ids, checksums);
 
-        add_reserved_tokens(writer, db, domains, symbol_ids);
-        add_tokens(writer, db, domains);
-        add_assets(writer, db, symbol_ids);
+        return add_checksums(writer, checksums);
     }
     EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
 }
 
 void
-token_database_snapshot::read_from_snapshot(snapshot_reader_ptr reader, token_database& db) {
+token_database_snapshot::read_from_snapshot(snapshot_reader_ptr reader, token_database& db, bool ingest) {
     using namespace internal;
 
     try {
@@ -186,13 +504,94 @@ token_database_snapshot::read_from_snapshot(snapshot_reader_ptr reader, token_da
         db.open(false);
 
         FC_ASSERT(db.savepoints_size() == 0);
+        EVT_ASSERT(!reader->has_section(kDeltaBaseSectionName), token_database_snapshot_exception,
+            "Incremental snapshot should be rebased onto its base snapshot before being read");
 
+        auto checksums  = read_checksums(reader);
         auto domains    = std::vector<domain_name>();
         auto symbol_ids = std::vector<symbol_id_type>();
+        auto ingester   = ingest ? db.new_ingester() : nullptr;
+        auto sink       = rows_sink { db, ingester.get() };
+
+        read_reserved_tokens(reader, sink, checksums, domains, symbol_ids);
+        read_tokens(reader, sink, checksums, domains);
+        read_assets(reader, sink, checksums, symbol_ids);
+
+        // rows are only visible after all the sections are validated
+        if(ingester) {
+            ingester->finish();
+        }
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
+}
+
+void
+token_database_snapshot::add_deltas_to_snapshot(snapshot_writer_ptr writer, const block_id_type& base_id, const std::vector<token_delta>& deltas) {
+    using namespace internal;
+
+    try {
+        writer->write_section(kDeltaBaseSectionName, [&](auto& w) {
+            w.add_row(base_id.data(), base_id.data_size());
+        });
+
+        auto enc = fc::sha256::encoder();
+        writer->write_section(kDeltaSectionName, [&](auto& w) {
+            for(auto& d : deltas) {
+                auto t = (uint8_t)d.type;
+                w.add_row((char*)&t, sizeof(t));
+                w.add_row(d.key);
+                w.add_row(d.value);
+
+                enc.write((char*)&t, sizeof(t));
+                hash_row(enc, d.key, d.value);
+            }
+        });
+        add_checksums(writer, section_checksums { { kDeltaSectionName, enc.result() } });
+    }
+    EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
+}
+
+std::optional<block_id_type>
+token_database_snapshot::read_delta_base(snapshot_reader_ptr reader) {
+    using namespace internal;
+
+    if(!reader->has_section(kDeltaBaseSectionName)) {
+        return std::nullopt;
+    }
+    auto id = block_id_type();
+    reader->read_section(kDeltaBaseSectionName, [&](auto& r) {
+        r.read_row(id.data(), id.data_size());
+    });
+    return id;
+}
+
+void
+token_database_snapshot::rebase_snapshot(std::shared_ptr<istream_snapshot_reader> base,
+                                         std::shared_ptr<istream_snapshot_reader> incremental,
+                                         std::shared_ptr<ostream_snapshot_writer> writer,
+                                         token_database&                          db) {
+    using namespace internal;
+
+    try {
+        auto base_id = read_delta_base(incremental);
+        EVT_ASSERT(!read_delta_base(base), token_database_snapshot_exception, "Base snapshot should be a full one");
+        EVT_ASSERT(base_id.has_value(), token_database_snapshot_exception, "Snapshot to rebase is not an incremental one");
+        EVT_ASSERT2(*base_id == read_head_block_id(base), token_database_snapshot_exception,
+            "Base snapshot is not the one of block: {}", base_id->str());
+
+        // chain state and other sections are copied without decoding rows
+        for(auto& name : incremental->get_section_names("")) {
+            if(name == kDeltaBaseSectionName || name == kDeltaSectionName || name == kChecksumSectionName) {
+                continue;
+            }
+            auto data = std::string();
+            auto rows = incremental->read_raw_section(name, data);
+            writer->write_raw_section(name, data, rows);
+        }
 
-        read_reserved_tokens(reader, db, domains, symbol_ids);
-        read_tokens(reader, db, domains);
-        read_assets(reader, db, symbol_ids);        
+        read_from_snapshot(base, db, true);
+        read_deltas(incremental, db, read_checksums(incremental));
+        add_to_snapshot(writer, db);
     }
     EVT_CAPTURE_AND_RETHROW(token_database_snapshot_exception);
 }
@@ -0,0 +1,27 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/trace.hpp>
+#include <evt/chain/execution_context.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+
+namespace evt { namespace chain {
+
+const std::string&
+action_trace::data_json(const contracts::abi_serializer& abi, const execution_context& exec_ctx) const {
+    auto json = std::atomic_load(&data_json_);
+    if(!json) {
+        auto acttype = exec_ctx.get_acttype_name(act.name);
+        auto j       = std::make_shared<const std::string>(abi.binary_to_json(acttype, act.data, exec_ctx));
+
+        // only the first one is kept if threads convert it at the same time
+        // so the string returned stays valid as long as the trace
+        if(std::atomic_compare_exchange_strong(&data_json_, &json, j)) {
+            json = std::move(j);
+        }
+    }
+    return *json;
+}
+
+}}  // namespace evt::chain
@@ -54,25 +54,37 @@ transaction::get_signature_keys(const signatures_base_type& signatures, const ch
     if(signatures.empty()) {
         return public_keys_set();
     }
+    return recover_signature_keys(signatures, sig_digest(chain_id), allow_duplicate_keys);
+}
 
+public_keys_set
+transaction::recover_signature_keys(const signatures_base_type& signatures, const digest_type& digest,
+                                    bool allow_duplicate_keys) {
     try {
-        auto digest = sig_digest(chain_id);
-
-        auto recovered_pub_keys = public_keys_set();
-        for(auto& sig : signatures) {
-            auto successful_insertion                   = false;
-            std::tie(std::ignore, successful_insertion) = recovered_pub_keys.emplace(sig, digest);
-            EVT_ASSERT(allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
-                       "transaction includes more than one signature signed using the same key associated with public "
-                       "key: ${key}",
-                       ("key", public_key_type(sig, digest)));
-        }
+        // all the signatures are recovered at once so the r1 ones can be batched
+        auto keys = small_vector<public_key_type, 4>(signatures.size());
+        public_key_type::recover_many(signatures.data(), signatures.size(), digest, keys.data());
 
-        return recovered_pub_keys;
+        return make_signature_keys(keys.data(), keys.size(), allow_duplicate_keys);
     }
     FC_CAPTURE_AND_RETHROW()
 }
 
+public_keys_set
+transaction::make_signature_keys(const public_key_type keys[], size_t n, bool allow_duplicate_keys) {
+    auto recovered_pub_keys = public_keys_set();
+    recovered_pub_keys.reserve(n);
+    for(auto i = 0u; i < n; i++) {
+        auto successful_insertion                   = false;
+        std::tie(std::ignore, successful_insertion) = recovered_pub_keys.emplace(keys[i]);
+        EVT_ASSERT(allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
+                   "transaction includes more than one signature signed using the same key associated with public "
+                   "key: ${key}",
+                   ("key", keys[i]));
+    }
+    return recovered_pub_keys;
+}
+
 const signature_type&
 signed_transaction::sign(const private_key_type& key, const chain_id_type& chain_id) {
     signatures.push_back(key.sign(sig_digest(chain_id)));
@@ -111,9 +123,7 @@ packed_transaction::get_unprunable_size() const {
 
 uint32_t
 packed_transaction::get_prunable_size() const {
-    uint64_t size = fc::raw::pack_size(signatures);
-    EVT_ASSERT(size <= std::numeric_limits<uint32_t>::max(), tx_too_big, "packed_transaction is too big");
-    return static_cast<uint32_t>(size);
+    return prunable_size;
 }
 
 digest_type
@@ -129,6 +139,27 @@ packed_transaction::packed_digest() const {
     return enc.result();
 }
 
+digest_type
+packed_transaction::sig_digest(const chain_id_type& chain_id) const {
+    if(compression != none) {
+        return unpacked_trx.sig_digest(chain_id);
+    }
+
+    // packed bytes are exactly the ones packed by `transaction::sig_digest` after chain id
+    digest_type::encoder enc;
+    fc::raw::pack(enc, chain_id);
+    enc.write(packed_trx.data(), packed_trx.size());
+    return enc.result();
+}
+
+public_keys_set
+packed_transaction::get_signature_keys(const chain_id_type& chain_id, bool allow_duplicate_keys) const {
+    if(signatures.empty()) {
+        return public_keys_set();
+    }
+    return transaction::recover_signature_keys(signatures, sig_digest(chain_id), allow_duplicate_keys);
+}
+
 namespace bio = boost::iostreams;
 
 template <size_t Limit>
@@ -213,6 +244,7 @@ packed_transaction::local_unpack_transaction() {
         }
     }
     FC_CAPTURE_AND_RETHROW((compression)(packed_trx))
+    local_cache_ids();
 }
 
 void
@@ -230,6 +262,23 @@ packed_transaction::local_pack_transaction() {
         }
     }
     FC_CAPTURE_AND_RETHROW((compression))
+    local_cache_ids();
+}
+
+void
+packed_transaction::local_cache_ids() {
+    if(compression == none) {
+        // packed bytes are the ones hashed by `transaction::id`
+        trx_id = transaction_id_type::hash(packed_trx.data(), packed_trx.size());
+    }
+    else {
+        trx_id = unpacked_trx.id();
+    }
+    signed_trx_id = digest_type::hash(*this);
+
+    uint64_t size = fc::raw::pack_size(signatures);
+    EVT_ASSERT(size <= std::numeric_limits<uint32_t>::max(), tx_too_big, "packed_transaction is too big");
+    prunable_size = static_cast<uint32_t>(size);
 }
 
 }}  // namespace evt::chain
@@ -9,10 +9,22 @@
 #include <evt/chain/controller.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/global_property_object.hpp>
+#include <evt/chain/pool_allocator.hpp>
 #include <evt/chain/transaction_object.hpp>
 
 namespace evt { namespace chain {
 
+namespace internal {
+
+// traces are shared out to plugins and callers, they are returned to pool when the last owner releases
+auto&
+get_trace_allocator() {
+    static auto allocator = pool_allocator<transaction_trace>(std::make_shared<block_pool>(config::default_trace_pool_size));
+    return allocator;
+}
+
+}  // namespace internal
+
 transaction_context::transaction_context(controller&                    control,
                                          evt_execution_context&         exec_ctx,
                                          const transaction_metadata_ptr trx_meta,
@@ -21,18 +33,23 @@ transaction_context::transaction_context(controller&                    control,
     , exec_ctx(exec_ctx)
     , undo_session()
     , undo_token_session()
+    , undo_bonus_session()
+    , undo_charge_session()
     , trx_meta(trx_meta)
     , trx(trx_meta->packed_trx->get_signed_transaction())
-    , trace(std::make_shared<transaction_trace>())
+    , trace(std::allocate_shared<transaction_trace>(internal::get_trace_allocator()))
     , start(start)
     , net_usage(trace->net_usage) {
     if(!control.skip_db_sessions()) {
         undo_session       = control.db().start_undo_session(true);
         undo_token_session = control.token_db().new_savepoint_session();
+        undo_bonus_session.emplace(control.pending_bonus_accruals().new_session());
+        undo_charge_session.emplace(control.pending_charge_accruals().new_session());
     }
     trace->id = trx_meta->id;
 
     executed.reserve(trx.actions.size() + 1); // one for paycharge action
+    trace->action_traces.reserve(trx.actions.size() + 1);
 
     if(!trx.transaction_extensions.empty()) {
         for(auto& ext : trx.transaction_extensions) {
@@ -51,7 +68,8 @@ transaction_context::init(uint64_t initial_net_usage) {
         act.set_index(exec_ctx.index_of(act.name));
     }
     
-    check_time();    // Fail early if deadline has already been exceeded
+    deadline_scope.emplace(control.get_deadline_timer(), deadline);
+    check_time(true);  // Fail early if deadline has already been exceeded
     if(!control.charge_free_mode()) {
         check_charge();  // Fail early if max charge has already been exceeded
         check_paid();    // Fail early if there's no remaining available EVT & Pinned EVT tokens
@@ -131,6 +149,12 @@ transaction_context::squash() {
     if(undo_token_session) {
         undo_token_session->squash();
     }
+    if(undo_bonus_session) {
+        undo_bonus_session->squash();
+    }
+    if(undo_charge_session) {
+        undo_charge_session->squash();
+    }
 }
 
 void transaction_context::undo() {
@@ -140,10 +164,19 @@ void transaction_context::undo() {
     if(undo_token_session) {
         undo_token_session->undo();
     }
+    if(undo_bonus_session) {
+        undo_bonus_session->undo();
+    }
+    if(undo_charge_session) {
+        undo_charge_session->undo();
+    }
 }
 
 void
-transaction_context::check_time() const {
+transaction_context::check_time(bool exact) const {
+    if(!exact && BOOST_LIKELY(!control.get_deadline_timer().expired())) {
+        return;
+    }
     auto now = fc::time_point::now();
     if(BOOST_UNLIKELY(now > deadline)) {
         EVT_THROW(deadline_exception, "deadline exceeded", ("now", now)("deadline", deadline)("start", start));
@@ -162,7 +195,7 @@ transaction_context::check_charge() {
 
 #define READ_DB_ASSET_NO_THROW(ADDR, SYM_ID, VALUEREF)                     \
     {                                                                      \
-        auto str = std::string();                                          \
+        auto str = rocksdb::PinnableSlice();                               \
         if(!tokendb.read_asset(ADDR, SYM_ID, str, true /* no throw */)) {  \
             VALUEREF = property();                                         \
         }                                                                  \
@@ -228,6 +261,10 @@ transaction_context::check_paid() const {
     }
 
     READ_DB_ASSET_NO_THROW(payer, EVT_SYM_ID, evt);
+    // charges paid to producer within pending block are not credited yet
+    if(payer == control.pending_charge_collector()) {
+        evt.amount += control.pending_charge_accruals().pending(EVT_SYM_ID);
+    }
     if(pevt.amount + evt.amount >= charge) {
         return;
     }
@@ -275,6 +312,8 @@ transaction_context::check_net_usage() const {
 
 void
 transaction_context::dispatch_action(action_trace& trace, const action& act) {
+    check_time();
+
     auto apply = apply_context(control, *this, act);
     apply.exec(trace);
 }
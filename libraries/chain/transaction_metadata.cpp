@@ -0,0 +1,118 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/transaction_metadata.hpp>
+#include <atomic>
+#include <mutex>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+namespace evt { namespace chain {
+
+namespace {
+
+// signatures recovered by each task when the ones of one transaction are split
+constexpr size_t kSigsPerTask = 2;
+
+// shared by the tasks recovering signatures of the same transaction
+// the last finished one merges the keys and fulfills the promise
+struct parallel_recovery {
+    using signing_keys_type = transaction_metadata::signing_keys_type;
+
+    packed_transaction_ptr          ptrx;
+    chain_id_type                   chain_id;
+    digest_type                     digest;
+    std::vector<public_key_type>    keys;
+    std::atomic<size_t>             remaining;
+    std::mutex                      mutex;
+    std::exception_ptr              error;
+    std::promise<signing_keys_type> promise;
+
+    void
+    recover(size_t begin, size_t end) {
+        try {
+            auto& sigs = ptrx->get_signatures();
+            public_key_type::recover_many(sigs.data() + begin, end - begin, digest, keys.data() + begin);
+        }
+        catch(...) {
+            auto lock = std::lock_guard<std::mutex>(mutex);
+            error = std::current_exception();
+        }
+
+        if(remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if(error) {
+            promise.set_exception(error);
+            return;
+        }
+        try {
+            promise.set_value(std::make_pair(chain_id, transaction::make_signature_keys(keys.data(), keys.size())));
+        }
+        catch(...) {
+            promise.set_exception(std::current_exception());
+        }
+    }
+};
+
+void
+start_parallel_recover_keys(transaction_metadata& mtrx, boost::asio::thread_pool& pool, const chain_id_type& chain_id) {
+    auto r      = std::make_shared<parallel_recovery>();
+    auto nsigs  = mtrx.packed_trx->get_signatures().size();
+    auto ntasks = (nsigs + kSigsPerTask - 1) / kSigsPerTask;
+
+    r->ptrx     = mtrx.packed_trx;
+    r->chain_id = chain_id;
+    r->keys.resize(nsigs);
+    r->remaining = ntasks;
+    mtrx.signing_keys_future = r->promise.get_future().share();
+
+    // digest is calculated by the first task, which then posts the other ones
+    boost::asio::post(pool, [r, &pool, nsigs] {
+        try {
+            r->digest = r->ptrx->sig_digest(r->chain_id);
+        }
+        catch(...) {
+            r->promise.set_exception(std::current_exception());
+            return;
+        }
+
+        for(auto i = kSigsPerTask; i < nsigs; i += kSigsPerTask) {
+            boost::asio::post(pool, [r, i, nsigs] {
+                r->recover(i, std::min(i + kSigsPerTask, nsigs));
+            });
+        }
+        r->recover(0, std::min(kSigsPerTask, nsigs));
+    });
+}
+
+}  // namespace
+
+void
+transaction_metadata::start_recover_keys(const transaction_metadata_ptr& mtrx, boost::asio::thread_pool& pool, const chain_id_type& chain_id, uint32_t parallel_sigs) {
+    if(mtrx->signing_keys.has_value() && mtrx->signing_keys->first == chain_id) {
+        return;
+    }
+    if(mtrx->signing_keys_future.valid()) {
+        return;
+    }
+
+    if(parallel_sigs > 0 && mtrx->packed_trx->get_signatures().size() >= std::max<size_t>(parallel_sigs, kSigsPerTask + 1)) {
+        start_parallel_recover_keys(*mtrx, pool, chain_id);
+        return;
+    }
+
+    // only packed transaction is captured, metadata is left untouched by the worker
+    auto ptrx = mtrx->packed_trx;
+    auto task = std::make_shared<std::packaged_task<signing_keys_type()>>([ptrx, chain_id] {
+        return std::make_pair(chain_id, ptrx->get_signature_keys(chain_id));
+    });
+    mtrx->signing_keys_future = task->get_future().share();
+
+    boost::asio::post(pool, [task] {
+        (*task)();
+    });
+}
+
+}}  // namespace evt::chain
@@ -0,0 +1,177 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain/zstd_dictionary.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <zstd.h>
+#include <fc/io/raw.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/transaction.hpp>
+#include <evt/chain/contracts/types.hpp>
+
+namespace evt { namespace chain {
+
+namespace internal {
+
+using namespace contracts;
+
+// Raw content dictionary built from the packed samples below, zstd takes matches from it as if it's
+// the data right before the input. Samples are listed from the least to the most common ones since
+// closer matches are cheaper. Never change them, see the header.
+std::string
+build_dictionary_v1() {
+    // doesn't start with the magic of formatted dictionaries, so it's always loaded as raw content
+    auto dict = std::string("evt-zstd-dictionary-v1");
+
+    auto append = [&](const auto& v) {
+        auto b = fc::raw::pack(v);
+        dict.append(b.data(), b.size());
+    };
+
+    auto key   = public_key_type(std::string("EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV"));
+    auto from  = address(key);
+    auto to    = address(public_key_type(std::string("EVT7edNeLHSdfmhMTUZd3o3pTBoyPRZ4fjrKU74FxJR9NgZgNZK6J")));
+    auto evt   = symbol(5, 1);
+    auto pevt  = symbol(5, 2);
+
+    auto trx = transaction();
+    trx.expiration       = time_point_sec(1'600'000'000);
+    trx.ref_block_num    = 0x1234;
+    trx.ref_block_prefix = 0x12345678;
+    trx.max_charge       = 10'000;
+    trx.payer            = from;
+
+    auto add_action = [&](const domain_name& domain, const domain_key& key, const auto& act) {
+        trx.actions.emplace_back(action(domain, key, act));
+    };
+
+    auto it   = issuetoken();
+    it.domain = N128(domain);
+    it.names  = { N128(t1), N128(t2) };
+    it.owner  = { from };
+    add_action(it.domain, N128(.issue), it);
+
+    auto tt   = transfer();
+    tt.domain = N128(domain);
+    tt.name   = N128(t1);
+    tt.to     = { to };
+    add_action(tt.domain, tt.name, tt);
+
+    auto pc   = paycharge();
+    pc.payer  = from;
+    pc.charge = 1'000;
+    add_action(N128(.charge), N128(.public-key), pc);
+
+    auto ep   = everipay();
+    ep.payee  = to;
+    ep.number = asset(100'000, evt);
+    add_action(N128(.fungible), name128::from_number(evt.id()), ep);
+
+    auto tp   = transferft();
+    tp.from   = from;
+    tp.to     = to;
+    tp.number = asset(100'000, pevt);
+    add_action(N128(.fungible), name128::from_number(pevt.id()), tp);
+
+    auto tf   = transferft();
+    tf.from   = from;
+    tf.to     = to;
+    tf.number = asset(100'000, evt);
+    add_action(N128(.fungible), name128::from_number(evt.id()), tf);
+
+    // single actions first, then the transaction holding all of them
+    for(auto& act : trx.actions) {
+        append(act);
+    }
+    append(trx);
+
+    return dict;
+}
+
+const std::string&
+dictionary() {
+    static auto dict = build_dictionary_v1();
+    return dict;
+}
+
+// digested dictionaries are shared by all threads, contexts are per thread
+ZSTD_CDict*
+get_cdict(int level) {
+    static auto mutex = std::mutex();
+    static auto dicts = std::map<int, std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)>>();
+
+    auto lock = std::lock_guard<std::mutex>(mutex);
+    auto it   = dicts.find(level);
+    if(it == dicts.end()) {
+        auto& dict = dictionary();
+        auto  cd   = ZSTD_createCDict(dict.data(), dict.size(), level);
+        EVT_ASSERT(cd != nullptr, chain_exception, "Cannot create zstd dictionary of level: ${l}", ("l",level));
+        it = dicts.emplace(level, std::unique_ptr<ZSTD_CDict, decltype(&ZSTD_freeCDict)>(cd, &ZSTD_freeCDict)).first;
+    }
+    return it->second.get();
+}
+
+const ZSTD_DDict*
+get_ddict() {
+    static auto dd = [] {
+        auto& dict = dictionary();
+        return std::unique_ptr<ZSTD_DDict, decltype(&ZSTD_freeDDict)>(ZSTD_createDDict(dict.data(), dict.size()), &ZSTD_freeDDict);
+    }();
+    EVT_ASSERT(dd != nullptr, chain_exception, "Cannot create zstd dictionary");
+    return dd.get();
+}
+
+ZSTD_CCtx*
+get_cctx() {
+    thread_local auto ctx = std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    return ctx.get();
+}
+
+ZSTD_DCtx*
+get_dctx() {
+    thread_local auto ctx = std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)>(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    return ctx.get();
+}
+
+}  // namespace internal
+
+bytes
+zstd_dict_compress(const char* data, size_t size, int level) {
+    using namespace internal;
+
+    auto out = bytes(ZSTD_compressBound(size));
+    auto r   = ZSTD_compress_usingCDict(get_cctx(), out.data(), out.size(), data, size, get_cdict(level));
+    EVT_ASSERT(!ZSTD_isError(r), chain_exception, "Cannot compress with zstd dictionary: ${e}", ("e",ZSTD_getErrorName(r)));
+
+    out.resize(r);
+    return out;
+}
+
+std::optional<size_t>
+zstd_frame_content_size(const char* data, size_t size) {
+    auto sz = ZSTD_getFrameContentSize(data, size);
+    if(sz == ZSTD_CONTENTSIZE_ERROR || sz == ZSTD_CONTENTSIZE_UNKNOWN) {
+        return std::nullopt;
+    }
+    return (size_t)sz;
+}
+
+const char*
+zstd_dict_decompress(const char* data, size_t size, char* out, size_t out_size) {
+    using namespace internal;
+
+    auto r = ZSTD_decompress_usingDDict(get_dctx(), out, out_size, data, size, get_ddict());
+    if(ZSTD_isError(r)) {
+        return ZSTD_getErrorName(r);
+    }
+    if(r != out_size) {
+        return "size mismatch";
+    }
+    return nullptr;
+}
+
+}}  // namespace evt::chain
@@ -4,5 +4,7 @@
 namespace fc {
 
 string zlib_compress(const string& in);
+// deflate data in gzip format (RFC 1952), as used by `Content-Encoding: gzip`
+string gzip_compress(const string& in);
 
 }  // namespace fc
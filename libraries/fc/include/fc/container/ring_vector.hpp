@@ -1,17 +1,24 @@
 
 #pragma once
+#include <cassert>
+#include <utility>
+#include <vector>
 
 namespace fc {
 
 template<typename T>
 class ring_vector {
 public:
+    // capacity is rounded up to power of two, so indexes are wrapped by mask
     ring_vector(ssize_t capacity)
         : head_(0)
         , tail_(0)
-        , capacity_(capacity) {
+        , capacity_(1) {
         assert(capacity > 0);
-        buf_.resize(capacity);
+        while(capacity_ < capacity) {
+            capacity_ <<= 1;
+        }
+        buf_.resize(capacity_);
     }
 
 public:
@@ -20,9 +27,7 @@ public:
     push_back(const T& item) {
         buf_[tail_] = item;
 
-        if(++tail_ >= capacity_) {
-            tail_ = 0;
-        }
+        tail_ = (tail_ + 1) & (capacity_ - 1);
         if(head_ == tail_) {
             expand();
         }
@@ -31,19 +36,13 @@ public:
     void
     pop_front() {
         assert(head_ != tail_);
-
-        if(++head_ >= capacity_) {
-            head_ = 0;
-        }
+        head_ = (head_ + 1) & (capacity_ - 1);
     }
 
     void
     pop_back() {
         assert(head_ != tail_);
-
-        if(--tail_ < 0) {
-            tail_ = capacity_ - 1;
-        }
+        tail_ = (tail_ - 1) & (capacity_ - 1);
     }
 
     void
@@ -55,13 +54,13 @@ public:
     T&
     back() {
         assert(head_ != tail_);
-        return buf_[(tail_ + capacity_ - 1) % capacity_];
+        return buf_[(tail_ - 1) & (capacity_ - 1)];
     }
 
     const T&
     back() const {
         assert(head_ != tail_);
-        return buf_[(tail_ + capacity_ - 1) % capacity_];
+        return buf_[(tail_ - 1) & (capacity_ - 1)];
     }
 
     T&
@@ -78,11 +77,7 @@ public:
 
     ssize_t
         size() const {
-        auto length = tail_ - head_;
-        if(length < 0) {
-            length += capacity_;
-        }
-        return length;
+        return (tail_ - head_) & (capacity_ - 1);
     }
 
     bool
@@ -92,21 +87,22 @@ public:
 
     T&
     operator[](size_t index) {
-        return buf_[(head_ + index) % capacity_];
+        return buf_[(head_ + index) & (capacity_ - 1)];
     }
 
     const T&
     operator[](size_t index) const {
-        return buf_[(head_ + index) % capacity_];
+        return buf_[(head_ + index) & (capacity_ - 1)];
     }
 
 private:
+    // it's full when it's called, items are moved into a buffer two times larger
     void
     expand() {
         auto new_vec = std::vector<T>();
         new_vec.resize(capacity_ * 2);
-        for(auto i = 0u; i < capacity_; i++) {
-            new_vec[i] = buf_[(head_ + i) % capacity_];
+        for(auto i = 0; i < capacity_; i++) {
+            new_vec[i] = std::move(buf_[(head_ + i) & (capacity_ - 1)]);
         }
 
         head_      = 0;
@@ -2,6 +2,7 @@
 #include <fc/variant.hpp>
 #include <fc/container/small_vector_fwd.hpp>
 #include <fc/io/raw_fwd.hpp>
+#include <fc/reflect/reflect.hpp>
 
 namespace fc {
 namespace raw {
@@ -11,6 +12,10 @@ inline void
 pack(Stream& s, const small_vector<T, N>& v) {
     FC_ASSERT(v.size() <= MAX_NUM_ARRAY_ELEMENTS);
     fc::raw::pack(s, unsigned_int((uint32_t)v.size()));
+    if constexpr(is_trivially_packable_v<T>) {
+        s.write((const char*)v.data(), v.size() * sizeof(T));
+        return;
+    }
 
     for(auto& e : v) {
         fc::raw::pack(s, e);
@@ -25,6 +30,15 @@ unpack(Stream& s, small_vector<T, N>& v) {
     FC_ASSERT(size.value <= MAX_NUM_ARRAY_ELEMENTS);
 
     v.resize(size.value);
+    if constexpr(is_trivially_packable_v<T>) {
+        s.read((char*)v.data(), v.size() * sizeof(T));
+        if constexpr(fc::has_reflector_init<T>::value) {
+            for(auto& e : v) {
+                e.reflector_init();
+            }
+        }
+        return;
+    }
     for(auto& e : v) {
         fc::raw::unpack(s, e);
     }
@@ -0,0 +1,47 @@
+#pragma once
+#include <string.h>
+#include <array>
+#include <string>
+#include <type_traits>
+#include <fc/crypto/city.hpp>
+
+namespace fc {
+
+/**
+  *  Cache of base58 strings recently rendered from fixed-size values like keys and addresses
+  *
+  *  It's kept per thread and direct-mapped, so no lock is needed and one newly rendered value
+  *  simply replaces the older one sharing its slot.
+  */
+template<typename Key, size_t Size = 1024>
+class base58_cache {
+    static_assert(std::is_trivially_copyable_v<Key>);
+    static_assert((Size & (Size - 1)) == 0, "Size should be power of 2");
+
+private:
+    struct slot {
+        bool        valid = false;
+        Key         key;
+        std::string str;
+    };
+
+public:
+    template<typename Func>
+    static std::string
+    get(const Key& key, Func&& render) {
+        thread_local auto slots = std::array<slot, Size>();
+
+        auto& s = slots[city_hash_size_t((const char*)&key, sizeof(key)) & (Size - 1)];
+        if(s.valid && memcmp(&s.key, &key, sizeof(key)) == 0) {
+            return s.str;
+        }
+
+        s.valid = false;
+        s.str   = render();
+        s.key   = key;
+        s.valid = true;
+        return s.str;
+    }
+};
+
+}  // namespace fc
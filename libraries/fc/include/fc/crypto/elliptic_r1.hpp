@@ -120,6 +120,11 @@ private:
     fc::fwd<detail::private_key_impl, 8> my;
 };
 
+/**
+  *  Recovers the keys of signatures of the same digest in one batch, throws if any of them cannot be recovered
+  */
+void recover_keys(const compact_signature sigs[], size_t n, const fc::sha256& digest, public_key_data keys[]);
+
 /**
   * Shims
   */
@@ -135,8 +140,11 @@ struct signature_shim : public crypto::shim<compact_signature> {
     using public_key_type = public_key_shim;
     using crypto::shim<compact_signature>::shim;
 
+    // r1 signatures are always checked to have low s-values
     public_key_type recover(const sha256& digest, bool check_canonical) const {
-        return public_key_type(public_key(_data, digest, check_canonical).serialize());
+        auto key = public_key_data();
+        recover_keys(&_data, 1, digest, &key);
+        return public_key_type(key);
     }
 };
 
@@ -38,6 +38,10 @@ public:
         return private_key(storage_type(KeyType::generate()));
     }
 
+    // generates k1 keys together with their public keys, see ecc::private_key::generate_batch
+    // for how the keys of one batch are related before using it
+    static std::vector<std::pair<private_key, public_key>> generate_batch(size_t n);
+
     template<typename KeyType = ecc::private_key_shim>
     static private_key regenerate(const typename KeyType::data_type& data) {
         return private_key(storage_type(KeyType(data)));
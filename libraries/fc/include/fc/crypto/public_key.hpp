@@ -25,6 +25,10 @@ public:
     public_key(const signature& c, const sha256& digest, bool check_canonical = true);
 
     public_key& operator=(const public_key&) = default;
+    public_key& operator=(public_key&&)      = default;
+
+    // recovers the keys of signatures of one digest, r1 ones are recovered in one batch
+    static void recover_many(const signature sigs[], size_t n, const sha256& digest, public_key keys[], bool check_canonical = true);
 
     bool valid() const;
 
@@ -44,11 +48,14 @@ private:
     friend bool operator==(const public_key& p1, const public_key& p2);
     friend bool operator!=(const public_key& p1, const public_key& p2);
     friend bool operator<(const public_key& p1, const public_key& p2);
+    friend std::size_t hash_value(const public_key& k);  //not cryptographic; for containers
     
     friend struct reflector<public_key>;
     friend class private_key;
 };  // public_key
 
+size_t hash_value(const public_key& k);
+
 }}  // namespace fc::crypto
 
 namespace fc {
@@ -56,4 +63,14 @@ void to_variant(const crypto::public_key& var, variant& vo);
 void from_variant(const variant& var, crypto::public_key& vo);
 }  // namespace fc
 
+namespace std {
+template <>
+struct hash<fc::crypto::public_key> {
+    std::size_t
+    operator()(const fc::crypto::public_key& k) const {
+        return fc::crypto::hash_value(k);
+    }
+};
+} // std
+
 FC_REFLECT(fc::crypto::public_key, (_storage));
@@ -24,6 +24,9 @@ public:
     static sha256 hash(const string&);
     static sha256 hash(const sha256&);
 
+    // hashes n independent messages into out, short messages are hashed in parallel lanes when cpu supports it
+    static void hash_many(const char* const data[], const uint32_t sizes[], size_t n, sha256 out[]);
+
     template<typename T>
     static sha256 hash(const T& t) {
         sha256::encoder e;
@@ -728,6 +728,10 @@ inline void
 pack(Stream& s, const std::vector<T>& value) {
     FC_ASSERT(value.size() <= MAX_NUM_ARRAY_ELEMENTS);
     fc::raw::pack(s, unsigned_int((uint32_t)value.size()));
+    if constexpr(is_trivially_packable_v<T>) {
+        s.write((const char*)value.data(), value.size() * sizeof(T));
+        return;
+    }
     auto itr = value.begin();
     auto end = value.end();
     while(itr != end) {
@@ -743,6 +747,15 @@ unpack(Stream& s, std::vector<T>& value) {
     fc::raw::unpack(s, size);
     FC_ASSERT(size.value <= MAX_NUM_ARRAY_ELEMENTS);
     value.resize(size.value);
+    if constexpr(is_trivially_packable_v<T>) {
+        s.read((char*)value.data(), value.size() * sizeof(T));
+        if constexpr(fc::has_reflector_init<T>::value) {
+            for(auto& v : value) {
+                v.reflector_init();
+            }
+        }
+        return;
+    }
     auto itr = value.begin();
     auto end = value.end();
     while(itr != end) {
@@ -812,14 +825,27 @@ unpack(Stream& s, std::array<T, S>& value) -> std::enable_if_t<!std::is_triviall
 template<typename Stream, typename T>
 inline void
 pack(Stream& s, const T& v) {
-    fc::raw::detail::if_reflected<typename fc::reflector<T>::is_defined>::pack(s, v);
+    if constexpr(is_trivially_packable_v<T>) {
+        s.write((const char*)&v, sizeof(T));
+    }
+    else {
+        fc::raw::detail::if_reflected<typename fc::reflector<T>::is_defined>::pack(s, v);
+    }
 }
 
 template<typename Stream, typename T>
 inline void
 unpack(Stream& s, T& v) {
     try {
-        fc::raw::detail::if_reflected<typename fc::reflector<T>::is_defined>::unpack(s, v);
+        if constexpr(is_trivially_packable_v<T>) {
+            s.read((char*)&v, sizeof(T));
+            if constexpr(fc::has_reflector_init<T>::value) {
+                v.reflector_init();
+            }
+        }
+        else {
+            fc::raw::detail::if_reflected<typename fc::reflector<T>::is_defined>::unpack(s, v);
+        }
     }
     FC_RETHROW_EXCEPTIONS(warn, "error unpacking ${type}", ("type", fc::get_typename<T>::name()))
 }
@@ -827,9 +853,14 @@ unpack(Stream& s, T& v) {
 template<typename T>
 inline size_t
 pack_size(const T& v) {
-    datastream<size_t> ps;
-    fc::raw::pack(ps, v);
-    return ps.tellp();
+    if constexpr(is_trivially_packable_v<T>) {
+        return sizeof(T);
+    }
+    else {
+        datastream<size_t> ps;
+        fc::raw::pack(ps, v);
+        return ps.tellp();
+    }
 }
 
 template<typename T>
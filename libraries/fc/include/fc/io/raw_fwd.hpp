@@ -4,6 +4,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
@@ -49,6 +50,15 @@ template<typename Storage>
 class fixed_string;
 
 namespace raw {
+
+// reflected types whose packed form is exactly their memory, declared by FC_REFLECT_TRIVIALLY_PACKABLE
+// integers are already packed in host order, so only the layout matters
+template<typename T>
+struct is_trivially_packable : std::false_type {};
+
+template<typename T>
+constexpr bool is_trivially_packable_v = is_trivially_packable<T>::value;
+
 template<typename T>
 inline size_t pack_size(const T& v);
 
@@ -219,3 +229,18 @@ void unpack(Stream& s, boost::multiprecision::number<T>& n);
 
 }  // namespace raw
 }  // namespace fc
+
+/**
+ *  Packs TYPE with one copy of its memory instead of visiting its members.
+ *  All the members of TYPE must be reflected in the order they are declared,
+ *  and each of them must be packed as its memory as well.
+ *  `reflector_init` of TYPE is still called after unpacking, but not the ones of its members.
+ */
+#define FC_REFLECT_TRIVIALLY_PACKABLE(TYPE)                                                    \
+    namespace fc { namespace raw {                                                             \
+    template<>                                                                                 \
+    struct is_trivially_packable<TYPE> : std::true_type {                                      \
+        static_assert(std::is_trivially_copyable_v<TYPE>, #TYPE " is not trivially copyable"); \
+        static_assert(std::has_unique_object_representations_v<TYPE>, #TYPE " has padding");   \
+    };                                                                                         \
+    }}
@@ -39,12 +39,15 @@ public:
         config()
             : format("${timestamp} ${thread_name} ${context} ${file}:${line} ${method} ${level}]  ${message}")
             , stream(console_appender::stream::std_error)
-            , flush(true) {}
+            , flush(true)
+            , async(false) {}
 
         fc::string                     format;
         console_appender::stream::type stream;
         std::vector<level_color>       level_colors;
         bool                           flush;
+        // messages are formatted and written by a background thread
+        bool                           async;
     };
 
     console_appender(const variant& args);
@@ -60,6 +63,10 @@ public:
 
     void configure(const config& cfg);
 
+private:
+    void write(const log_message& m);
+    void run();
+
 private:
     class impl;
     std::unique_ptr<impl> my;
@@ -71,4 +78,4 @@ private:
 FC_REFLECT_ENUM(fc::console_appender::stream::type, (std_out)(std_error));
 FC_REFLECT_ENUM(fc::console_appender::color::type, (red)(green)(brown)(blue)(magenta)(cyan)(white)(console_default));
 FC_REFLECT(fc::console_appender::level_color, (level)(color));
-FC_REFLECT(fc::console_appender::config, (format)(stream)(level_colors)(flush));
+FC_REFLECT(fc::console_appender::config, (format)(stream)(level_colors)(flush)(async));
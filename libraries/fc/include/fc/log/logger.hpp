@@ -24,6 +24,10 @@ class logger {
 public:
     static logger get(const fc::string& name = "default");
 
+    // references used by logging macros, default one is kept aside so no lookup is needed
+    static logger& default_logger();
+    static logger& default_logger(const fc::string& name);
+
     logger();
     logger(const string& name, const logger& parent = nullptr);
     logger(std::nullptr_t);
@@ -101,16 +105,18 @@ private:
         (LOGGER).log(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define dlog(FORMAT, ...)                                                                  \
-    FC_MULTILINE_MACRO_BEGIN                                                               \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::debug))                 \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE(debug, FORMAT, __VA_ARGS__)); \
+#define dlog(FORMAT, ...)                                     \
+    FC_MULTILINE_MACRO_BEGIN                                  \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER);  \
+    if(_lgr.is_enabled(fc::log_level::debug))                 \
+        _lgr.log(FC_LOG_MESSAGE(debug, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define dlog2(FORMAT, ...)                                                                    \
-    FC_MULTILINE_MACRO_BEGIN                                                                  \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::debug))                    \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE2(debug, FORMAT, ##__VA_ARGS__)); \
+#define dlog2(FORMAT, ...)                                       \
+    FC_MULTILINE_MACRO_BEGIN                                     \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER);     \
+    if(_lgr.is_enabled(fc::log_level::debug))                    \
+        _lgr.log(FC_LOG_MESSAGE2(debug, FORMAT, ##__VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
 /**
@@ -123,28 +129,32 @@ private:
         (fc::logger::get("user")).log(FC_LOG_MESSAGE(debug, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define ilog(FORMAT, ...)                                                                 \
-    FC_MULTILINE_MACRO_BEGIN                                                              \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::info))                 \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE(info, FORMAT, __VA_ARGS__)); \
+#define ilog(FORMAT, ...)                                    \
+    FC_MULTILINE_MACRO_BEGIN                                 \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER); \
+    if(_lgr.is_enabled(fc::log_level::info))                 \
+        _lgr.log(FC_LOG_MESSAGE(info, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define ilog2_(FORMAT, ...)                                                                  \
-    FC_MULTILINE_MACRO_BEGIN                                                                 \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::info))                    \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE2(info, FORMAT, ##__VA_ARGS__)); \
+#define ilog2_(FORMAT, ...)                                     \
+    FC_MULTILINE_MACRO_BEGIN                                    \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER);    \
+    if(_lgr.is_enabled(fc::log_level::info))                    \
+        _lgr.log(FC_LOG_MESSAGE2(info, FORMAT, ##__VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define wlog(FORMAT, ...)                                                                 \
-    FC_MULTILINE_MACRO_BEGIN                                                              \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::warn))                 \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE(warn, FORMAT, __VA_ARGS__)); \
+#define wlog(FORMAT, ...)                                    \
+    FC_MULTILINE_MACRO_BEGIN                                 \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER); \
+    if(_lgr.is_enabled(fc::log_level::warn))                 \
+        _lgr.log(FC_LOG_MESSAGE(warn, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
-#define elog(FORMAT, ...)                                                                  \
-    FC_MULTILINE_MACRO_BEGIN                                                               \
-    if((fc::logger::get(DEFAULT_LOGGER)).is_enabled(fc::log_level::error))                 \
-        (fc::logger::get(DEFAULT_LOGGER)).log(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__)); \
+#define elog(FORMAT, ...)                                     \
+    FC_MULTILINE_MACRO_BEGIN                                  \
+    auto& _lgr = fc::logger::default_logger(DEFAULT_LOGGER);  \
+    if(_lgr.is_enabled(fc::log_level::error))                 \
+        _lgr.log(FC_LOG_MESSAGE(error, FORMAT, __VA_ARGS__)); \
     FC_MULTILINE_MACRO_END
 
 #include <boost/preprocessor/seq/for_each.hpp>
@@ -19,20 +19,22 @@ public:
     template<typename Member, class Class, Member(Class::*member)>
     void
     operator()(const char* name) const {
-        this->add(vo, name, (val.*member));
+        // each member has its own instance, so the name is interned only once
+        static const auto key = fc::intern_key(name);
+        this->add(vo, key, (val.*member));
     }
 
 private:
     template<typename M>
     void
-    add(mutable_variant_object& vo, const char* name, const std::optional<M>& v) const {
+    add(mutable_variant_object& vo, interned_key key, const std::optional<M>& v) const {
         if(v.has_value()) {
-            vo(name, *v);
+            vo(key, *v);
         }
     }
 
     template<typename M>
-    void add(mutable_variant_object& vo, const char* name, const M& v) const { vo(name, v); }
+    void add(mutable_variant_object& vo, interned_key key, const M& v) const { vo(key, v); }
 
     mutable_variant_object& vo;
     const T&                val;
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace fc {
+
+/**
+  *  @brief Monotonic arena for the heap nodes of variants (strings, blobs, objects and arrays)
+  *
+  *  Nodes allocated while one scope is active on the thread are never freed one by one,
+  *  the arena releases all of its blocks at once after the scope ends and its last node is destroyed.
+  *  So nodes may outlive the scope and be destroyed from other threads, though long-lived ones
+  *  will keep the whole arena alive.
+  */
+class variant_arena {
+public:
+    class scope {
+    public:
+        scope(bool enabled = true);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        variant_arena* arena_;
+        variant_arena* prev_;
+    };
+
+public:
+    // allocates from the arena of current thread, or from the heap if no scope is active
+    static void* allocate(size_t size);
+    static void  deallocate(void* p);
+
+private:
+    variant_arena();
+    ~variant_arena();
+
+    void* alloc(size_t size);
+    void  release();
+
+private:
+    std::atomic<size_t> refs_;
+    std::vector<char*>  blocks_;
+    char*               cur_;
+    size_t              left_;
+};
+
+}  // namespace fc
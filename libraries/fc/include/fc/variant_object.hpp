@@ -5,6 +5,27 @@
 namespace fc {
 class mutable_variant_object;
 
+/**
+  *  @brief Key of variant objects from the table of interned keys
+  *
+  *  Interned keys are allocated once and never freed, entries of them only refer to the key instead of
+  *  holding a copy. They're for the names known ahead, like fields of reflected types and abi structs,
+  *  never for the keys coming from inputs.
+  */
+class interned_key {
+public:
+    interned_key();
+    explicit interned_key(const string* key) : _key(key) {}
+
+    const string& str() const { return *_key; }
+
+private:
+    const string* _key;
+};
+
+/** @return the interned key of \a key, it's looked up in a global table so it should be kept by callers */
+interned_key intern_key(const string& key);
+
 /**
   *  @ingroup Serializable
   *
@@ -23,12 +44,13 @@ public:
     public:
         entry();
         entry(string k, variant v);
+        entry(interned_key k, variant v);
         entry(entry&& e);
         entry(const entry& e);
         entry& operator=(const entry&);
         entry& operator=(entry&&);
 
-        const string&  key() const;
+        const string&  key() const { return _ikey ? *_ikey : _key; }
         const variant& value() const;
         void           set(variant v);
 
@@ -36,7 +58,7 @@ public:
 
         friend bool
         operator==(const entry& a, const entry& b) {
-            return a._key == b._key && a._value == b._value;
+            return a.key() == b.key() && a._value == b._value;
         }
 
         friend bool
@@ -45,8 +67,9 @@ public:
         }
 
     private:
-        string  _key;
-        variant _value;
+        string        _key;
+        const string* _ikey = nullptr;  // interned key, `_key` is empty then
+        variant       _value;
     };
 
     using entry_vec      = small_vector<entry, 12>;
@@ -159,6 +182,7 @@ public:
 
     /** replaces the value at \a key with \a var or insert's \a key if not found */
     mutable_variant_object& set(string key, variant var);
+    mutable_variant_object& set(interned_key key, variant var);
 
     /**
       *  Convenience method to simplify the manual construction of
@@ -180,6 +204,15 @@ public:
         set(std::move(key), variant(fc::forward<T>(var)));
         return *this;
     }
+
+    mutable_variant_object& operator()(interned_key key, variant var);
+
+    template<typename T>
+    mutable_variant_object&
+    operator()(interned_key key, T&& var) {
+        set(key, variant(fc::forward<T>(var)));
+        return *this;
+    }
     /**
       * Copy a variant_object into this mutable_variant_object.
       */
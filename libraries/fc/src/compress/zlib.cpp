@@ -12,4 +12,26 @@ namespace fc
     free(compressed_message);
     return result;
   }
+
+  string gzip_compress(const string& in)
+  {
+    static const char header[] = { '\x1f', '\x8b', 8 /* deflate */, 0, 0, 0, 0, 0, 0, '\xff' /* unknown os */ };
+
+    size_t compressed_message_length;
+    char* compressed_message = (char*)tdefl_compress_mem_to_heap(in.c_str(), in.size(), &compressed_message_length, TDEFL_DEFAULT_MAX_PROBES);
+
+    string result;
+    result.reserve(sizeof(header) + compressed_message_length + 8);
+    result.append(header, sizeof(header));
+    result.append(compressed_message, compressed_message_length);
+    free(compressed_message);
+
+    // trailer is crc32 and size of the input, both in little endian
+    auto crc  = (uint32_t)mz_crc32(MZ_CRC32_INIT, (const unsigned char*)in.data(), in.size());
+    auto size = (uint32_t)in.size();
+    for( auto v : { crc, size } )
+      for( int i = 0; i < 4; ++i )
+        result.push_back( (char)((v >> (i * 8)) & 0xff) );
+    return result;
+  }
 }
@@ -16,7 +16,7 @@
 
 #include <string>
 #include <vector>
-#include <limits>
+#include <memory>
 #include <algorithm>
 #include <string.h>
 
@@ -24,527 +24,99 @@
 #include <fc/string.hpp>
 #include <fc/exception/exception.hpp>
 
-#include <stdexcept>
-#include <vector>
-#include <openssl/bn.h>
+static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
-/** Errors thrown by the bignum class */
-class bignum_error : public std::runtime_error {
-public:
-    explicit bignum_error(const std::string& str)
-        : std::runtime_error(str) {}
-};
+namespace {
 
-/** RAII encapsulated BN_CTX (OpenSSL bignum context) */
-class CAutoBN_CTX {
-protected:
-    BN_CTX* pctx;
-    BN_CTX* operator=(BN_CTX* pnew) { return pctx = pnew; }
+// 58^5 is the largest power of 58 fitting in 32 bits
+constexpr uint32_t kLimbBase   = 656356768;
+constexpr int      kLimbDigits = 5;
 
-public:
-    CAutoBN_CTX() {
-        pctx = BN_CTX_new();
-        if(pctx == NULL)
-            throw bignum_error("CAutoBN_CTX : BN_CTX_new() returned NULL");
-    }
+// digit of each char, -1 for the ones out of alphabet
+struct digit_table {
+    int8_t digits[256];
 
-    ~CAutoBN_CTX() {
-        if(pctx != NULL)
-            BN_CTX_free(pctx);
+    digit_table() {
+        memset(digits, -1, sizeof(digits));
+        for(auto i = 0; i < 58; i++) {
+            digits[(uint8_t)pszBase58[i]] = i;
+        }
     }
-
-    operator BN_CTX*() { return pctx; }
-    BN_CTX&  operator*() { return *pctx; }
-    BN_CTX** operator&() { return &pctx; }
-    bool     operator!() { return (pctx == NULL); }
 };
 
-/** C++ wrapper for BIGNUM (OpenSSL bignum) */
-class CBigNum {
-    BIGNUM* bn;
+const digit_table base58_digits;
 
+// limbs on the stack for the usual sizes like keys and addresses
+template<typename T, size_t N>
+class limb_buffer {
 public:
-    CBigNum()
-        : bn(BN_new()) {}
-
-    CBigNum(const CBigNum& b)
-        : CBigNum() {
-        if(!BN_copy(bn, b.bn)) {
-            BN_clear_free(bn);
-            throw bignum_error("CBigNum::CBigNum(const CBigNum&) : BN_copy failed");
-        }
-    }
-
-    CBigNum& operator=(const CBigNum& b) {
-        if(!BN_copy(bn, b.bn))
-            throw bignum_error("CBigNum::operator= : BN_copy failed");
-        return (*this);
-    }
-
-    ~CBigNum() {
-        BN_clear_free(bn);
-    }
-
-    //CBigNum(char n) is not portable.  Use 'signed char' or 'unsigned char'.
-    CBigNum(signed char n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(short n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(int n)
-        : CBigNum() {
-        if(n >= 0)
-            setulong(n);
-        else
-            setint64(n);
-    }
-    CBigNum(int64_t n)
-        : CBigNum() { setint64(n); }
-    CBigNum(unsigned char n)
-        : CBigNum() { setulong(n); }
-    CBigNum(unsigned short n)
-        : CBigNum() { setulong(n); }
-    CBigNum(unsigned int n)
-        : CBigNum() { setulong(n); }
-    CBigNum(uint64_t n)
-        : CBigNum() { setuint64(n); }
+    limb_buffer(size_t n)
+        : data_(n <= N ? stack_ : (heap_.reset(new T[n]), heap_.get())) {}
 
-    explicit CBigNum(const std::vector<unsigned char>& vch)
-        : CBigNum() {
-        setvch(vch);
-    }
-
-    void setulong(unsigned long n) {
-        if(!BN_set_word(bn, n))
-            throw bignum_error("CBigNum conversion from unsigned long : BN_set_word failed");
-    }
-
-    unsigned long getulong() const {
-        return BN_get_word(bn);
-    }
-
-    unsigned int getuint() const {
-        return BN_get_word(bn);
-    }
-
-    int getint() const {
-        unsigned long n = BN_get_word(bn);
-        if(!BN_is_negative(bn))
-            return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : n);
-        else
-            return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::min() : -(int)n);
-    }
-
-    void setint64(int64_t n) {
-        unsigned char  pch[sizeof(n) + 6];
-        unsigned char* p         = pch + 4;
-        bool           fNegative = false;
-        if(n < (int64_t)0) {
-            n         = -n;
-            fNegative = true;
-        }
-        bool fLeadingZeroes = true;
-        for(int i = 0; i < 8; i++) {
-            unsigned char c = (n >> 56) & 0xff;
-            n <<= 8;
-            if(fLeadingZeroes) {
-                if(c == 0)
-                    continue;
-                if(c & 0x80)
-                    *p++ = (fNegative ? 0x80 : 0);
-                else if(fNegative)
-                    c |= 0x80;
-                fLeadingZeroes = false;
-            }
-            *p++ = c;
-        }
-        unsigned int nSize = p - (pch + 4);
-        pch[0]             = (nSize >> 24) & 0xff;
-        pch[1]             = (nSize >> 16) & 0xff;
-        pch[2]             = (nSize >> 8) & 0xff;
-        pch[3]             = (nSize)&0xff;
-        BN_mpi2bn(pch, p - pch, bn);
-    }
-
-    void setuint64(uint64_t n) {
-        unsigned char  pch[sizeof(n) + 6];
-        unsigned char* p              = pch + 4;
-        bool           fLeadingZeroes = true;
-        for(int i = 0; i < 8; i++) {
-            unsigned char c = (n >> 56) & 0xff;
-            n <<= 8;
-            if(fLeadingZeroes) {
-                if(c == 0)
-                    continue;
-                if(c & 0x80)
-                    *p++ = 0;
-                fLeadingZeroes = false;
-            }
-            *p++ = c;
-        }
-        unsigned int nSize = p - (pch + 4);
-        pch[0]             = (nSize >> 24) & 0xff;
-        pch[1]             = (nSize >> 16) & 0xff;
-        pch[2]             = (nSize >> 8) & 0xff;
-        pch[3]             = (nSize)&0xff;
-        BN_mpi2bn(pch, p - pch, bn);
-    }
+    T& operator[](size_t i) { return data_[i]; }
 
-    void setvch(const std::vector<unsigned char>& vch) {
-        std::vector<unsigned char> vch2(vch.size() + 4);
-        unsigned int               nSize = vch.size();
-        // BIGNUM's byte stream format expects 4 bytes of
-        // big endian size data info at the front
-        vch2[0] = (nSize >> 24) & 0xff;
-        vch2[1] = (nSize >> 16) & 0xff;
-        vch2[2] = (nSize >> 8) & 0xff;
-        vch2[3] = (nSize >> 0) & 0xff;
-        // swap data to big endian
-        reverse_copy(vch.begin(), vch.end(), vch2.begin() + 4);
-        BN_mpi2bn(&vch2[0], vch2.size(), bn);
-    }
-
-    std::vector<unsigned char> getvch() const {
-        unsigned int nSize = BN_bn2mpi(bn, NULL);
-        if(nSize <= 4)
-            return std::vector<unsigned char>();
-        std::vector<unsigned char> vch(nSize);
-        BN_bn2mpi(bn, &vch[0]);
-        vch.erase(vch.begin(), vch.begin() + 4);
-        reverse(vch.begin(), vch.end());
-        return vch;
-    }
-
-    CBigNum& SetCompact(unsigned int nCompact) {
-        unsigned int               nSize = nCompact >> 24;
-        std::vector<unsigned char> vch(4 + nSize);
-        vch[3] = nSize;
-        if(nSize >= 1)
-            vch[4] = (nCompact >> 16) & 0xff;
-        if(nSize >= 2)
-            vch[5] = (nCompact >> 8) & 0xff;
-        if(nSize >= 3)
-            vch[6] = (nCompact >> 0) & 0xff;
-        BN_mpi2bn(&vch[0], vch.size(), bn);
-        return *this;
-    }
+private:
+    T                    stack_[N];
+    std::unique_ptr<T[]> heap_;
+    T*                   data_;
+};
 
-    unsigned int GetCompact() const {
-        unsigned int               nSize = BN_bn2mpi(bn, NULL);
-        std::vector<unsigned char> vch(nSize);
-        nSize -= 4;
-        BN_bn2mpi(bn, &vch[0]);
-        unsigned int nCompact = nSize << 24;
-        if(nSize >= 1)
-            nCompact |= (vch[4] << 16);
-        if(nSize >= 2)
-            nCompact |= (vch[5] << 8);
-        if(nSize >= 3)
-            nCompact |= (vch[6] << 0);
-        return nCompact;
-    }
+}  // namespace
 
-    void SetHex(const std::string& str) {
-        // skip 0x
-        const char* psz = str.c_str();
-        while(isspace(*psz))
-            psz++;
-        bool fNegative = false;
-        if(*psz == '-') {
-            fNegative = true;
-            psz++;
+// Encode a byte sequence as a base58-encoded string
+// The bytes are converted into little endian limbs of 5 base58 digits each,
+// it's the same as dividing the big number by 58 repeatedly but without any allocations for keys
+inline std::string
+EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
+    // Leading zeroes encoded as base58 zeros
+    auto zeros = 0;
+    while(pbegin != pend && *pbegin == 0) {
+        pbegin++;
+        zeros++;
+    }
+
+    // log(256) / log(58^5) ~= 0.273 limbs for each byte
+    auto size   = (size_t)(pend - pbegin);
+    auto limbs  = limb_buffer<uint32_t, 32>(size * 28 / 100 + 1);
+    auto nlimbs = 0;
+    for(auto p = pbegin; p != pend; p++) {
+        auto carry = (uint64_t)*p;
+        for(auto i = 0; i < nlimbs; i++) {
+            carry   += (uint64_t)limbs[i] << 8;
+            limbs[i] = carry % kLimbBase;
+            carry   /= kLimbBase;
         }
-        if(psz[0] == '0' && tolower(psz[1]) == 'x')
-            psz += 2;
-        while(isspace(*psz))
-            psz++;
-
-        // hex string to bignum
-        static signed char phexdigit[256] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0,
-                                             0, 0, 0, 0, 0, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xa, 0xb,
-                                             0xc, 0xd, 0xe, 0xf, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-        *this = 0;
-        while(isxdigit(*psz)) {
-            *this <<= 4;
-            int n = phexdigit[(unsigned char)*psz++];
-            *this += n;
+        while(carry > 0) {
+            limbs[nlimbs++] = carry % kLimbBase;
+            carry /= kLimbBase;
         }
-        if(fNegative)
-            BN_set_negative(bn, 1);
     }
 
-    std::string ToString(int nBase = 10) const {
-        CAutoBN_CTX pctx;
-        CBigNum     bnBase = nBase;
-        CBigNum     bn0    = 0;
-        std::string str;
-        CBigNum     bn = *this;
-        BN_set_negative(bn.bn, false);
-        CBigNum dv;
-        CBigNum rem;
-        if(BN_cmp(bn.bn, bn0.bn) == 0)
-            return "0";
-        while(BN_cmp(bn.bn, bn0.bn) > 0) {
-            if(!BN_div(dv.bn, rem.bn, bn.bn, bnBase.bn, pctx))
-                throw bignum_error("CBigNum::ToString() : BN_div failed");
-            bn             = dv;
-            unsigned int c = rem.getulong();
-            str += "0123456789abcdef"[c];
-        }
-        if(BN_is_negative(this->bn))
-            str += "-";
-        reverse(str.begin(), str.end());
+    std::string str;
+    // Expected size increase from base58 conversion is approximately 137%
+    // use 138% to be safe
+    str.reserve(zeros + size * 138 / 100 + 1);
+    str.append(zeros, pszBase58[0]);
+    if(nlimbs == 0) {
         return str;
     }
 
-    std::string GetHex() const {
-        return ToString(16);
-    }
-
-    bool operator!() const {
-        return BN_is_zero(bn);
+    char buf[kLimbDigits];
+    // most significant limb is written without its leading zeros
+    auto n = 0;
+    for(auto v = limbs[nlimbs - 1]; v > 0; v /= 58) {
+        buf[n++] = pszBase58[v % 58];
     }
-
-    CBigNum& operator+=(const CBigNum& b) {
-        if(!BN_add(bn, bn, b.bn))
-            throw bignum_error("CBigNum::operator+= : BN_add failed");
-        return *this;
-    }
-
-    CBigNum& operator-=(const CBigNum& b) {
-        if(!BN_sub(bn, bn, b.bn))
-            throw bignum_error("CBigNum::operator-= : BN_sub failed");
-        return *this;
-    }
-
-    CBigNum& operator*=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_mul(bn, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator*= : BN_mul failed");
-        return *this;
-    }
-
-    CBigNum& operator/=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_div(bn, NULL, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator/= : BN_div failed");
-        return *this;
-    }
-
-    CBigNum& operator%=(const CBigNum& b) {
-        CAutoBN_CTX pctx;
-        if(!BN_div(NULL, bn, bn, b.bn, pctx))
-            throw bignum_error("CBigNum::operator%= : BN_div failed");
-        return *this;
+    while(n > 0) {
+        str.push_back(buf[--n]);
     }
-
-    CBigNum& operator<<=(unsigned int shift) {
-        if(!BN_lshift(bn, bn, shift))
-            throw bignum_error("CBigNum:operator<<= : BN_lshift failed");
-        return *this;
-    }
-
-    CBigNum& operator>>=(unsigned int shift) {
-        // Note: BN_rshift segfaults on 64-bit if 2^shift is greater than the number
-        //   if built on ubuntu 9.04 or 9.10, probably depends on version of openssl
-        CBigNum a = 1;
-        a <<= shift;
-        if(BN_cmp(a.bn, bn) > 0) {
-            *this = 0;
-            return *this;
+    for(auto i = nlimbs - 2; i >= 0; i--) {
+        auto v = limbs[i];
+        for(auto j = kLimbDigits - 1; j >= 0; j--, v /= 58) {
+            buf[j] = pszBase58[v % 58];
         }
-
-        if(!BN_rshift(bn, bn, shift))
-            throw bignum_error("CBigNum:operator>>= : BN_rshift failed");
-        return *this;
+        str.append(buf, kLimbDigits);
     }
-
-    CBigNum& operator++() {
-        // prefix operator
-        if(!BN_add(bn, bn, BN_value_one()))
-            throw bignum_error("CBigNum::operator++ : BN_add failed");
-        return *this;
-    }
-
-    const CBigNum operator++(int) {
-        // postfix operator
-        const CBigNum ret = *this;
-        ++(*this);
-        return ret;
-    }
-
-    CBigNum& operator--() {
-        // prefix operator
-        CBigNum r;
-        if(!BN_sub(r.bn, bn, BN_value_one()))
-            throw bignum_error("CBigNum::operator-- : BN_sub failed");
-        *this = r;
-        return *this;
-    }
-
-    const CBigNum operator--(int) {
-        // postfix operator
-        const CBigNum ret = *this;
-        --(*this);
-        return ret;
-    }
-
-    const BIGNUM* to_bignum() const {
-        return bn;
-    }
-    BIGNUM* to_bignum() {
-        return bn;
-    }
-};
-
-inline const CBigNum
-operator+(const CBigNum& a, const CBigNum& b) {
-    CBigNum r;
-    if(!BN_add(r.to_bignum(), a.to_bignum(), b.to_bignum()))
-        throw bignum_error("CBigNum::operator+ : BN_add failed");
-    return r;
-}
-
-inline const CBigNum
-operator-(const CBigNum& a, const CBigNum& b) {
-    CBigNum r;
-    if(!BN_sub(r.to_bignum(), a.to_bignum(), b.to_bignum()))
-        throw bignum_error("CBigNum::operator- : BN_sub failed");
-    return r;
-}
-
-inline const CBigNum
-operator-(const CBigNum& a) {
-    CBigNum r(a);
-    BN_set_negative(r.to_bignum(), !BN_is_negative(r.to_bignum()));
-    return r;
-}
-
-inline const CBigNum operator*(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_mul(r.to_bignum(), a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator* : BN_mul failed");
-    return r;
-}
-
-inline const CBigNum
-operator/(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_div(r.to_bignum(), NULL, a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator/ : BN_div failed");
-    return r;
-}
-
-inline const CBigNum
-operator%(const CBigNum& a, const CBigNum& b) {
-    CAutoBN_CTX pctx;
-    CBigNum     r;
-    if(!BN_mod(r.to_bignum(), a.to_bignum(), b.to_bignum(), pctx))
-        throw bignum_error("CBigNum::operator% : BN_div failed");
-    return r;
-}
-
-inline const CBigNum
-operator<<(const CBigNum& a, unsigned int shift) {
-    CBigNum r;
-    if(!BN_lshift(r.to_bignum(), a.to_bignum(), shift))
-        throw bignum_error("CBigNum:operator<< : BN_lshift failed");
-    return r;
-}
-
-inline const CBigNum
-operator>>(const CBigNum& a, unsigned int shift) {
-    CBigNum r = a;
-    r >>= shift;
-    return r;
-}
-
-inline bool
-operator==(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) == 0);
-}
-
-inline bool
-operator!=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) != 0);
-}
-
-inline bool
-operator<=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) <= 0);
-}
-
-inline bool
-operator>=(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) >= 0);
-}
-
-inline bool
-operator<(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) < 0);
-}
-
-inline bool
-operator>(const CBigNum& a, const CBigNum& b) {
-    return (BN_cmp(a.to_bignum(), b.to_bignum()) > 0);
-}
-
-static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
-// Encode a byte sequence as a base58-encoded string
-inline std::string
-EncodeBase58(const unsigned char* pbegin, const unsigned char* pend) {
-    CAutoBN_CTX pctx;
-    CBigNum     bn58 = 58;
-    CBigNum     bn0  = 0;
-
-    // Convert big endian data to little endian
-    // Extra zero at the end make sure bignum will interpret as a positive number
-    std::vector<unsigned char> vchTmp(pend - pbegin + 1, 0);
-    reverse_copy(pbegin, pend, vchTmp.begin());
-
-    // Convert little endian data to bignum
-    CBigNum bn;
-    bn.setvch(vchTmp);
-
-    // Convert bignum to std::string
-    std::string str;
-    // Expected size increase from base58 conversion is approximately 137%
-    // use 138% to be safe
-    str.reserve((pend - pbegin) * 138 / 100 + 1);
-    CBigNum dv;
-    CBigNum rem;
-    while(bn > bn0) {
-        if(!BN_div(dv.to_bignum(), rem.to_bignum(), bn.to_bignum(), bn58.to_bignum(), pctx))
-            throw bignum_error("EncodeBase58 : BN_div failed");
-        bn             = dv;
-        unsigned int c = rem.getulong();
-        str += pszBase58[c];
-    }
-
-    // Leading zeroes encoded as base58 zeros
-    for(const unsigned char* p = pbegin; p < pend && *p == 0; p++)
-        str += pszBase58[0];
-
-    // Convert little endian std::string to big endian
-    reverse(str.begin(), str.end());
-    //    slog( "Encode '%s'", str.c_str() );
     return str;
 }
 
@@ -558,47 +130,53 @@ EncodeBase58(const std::vector<unsigned char>& vch) {
 // returns true if decoding is succesful
 inline bool
 DecodeBase58(const char* psz, std::vector<unsigned char>& vchRet) {
-    CAutoBN_CTX pctx;
     vchRet.clear();
-    CBigNum bn58 = 58;
-    CBigNum bn   = 0;
-    CBigNum bnChar;
     while(isspace(*psz))
         psz++;
 
-    // Convert big endian string to bignum
+    // Restore leading zeros
+    auto nLeadingZeros = 0;
+    for(const char* p = psz; *p == pszBase58[0]; p++)
+        nLeadingZeros++;
+
+    // Convert big endian string into little endian 32-bits limbs
+    // log(58) / log(2^32) ~= 0.183 limbs for each char
+    auto len    = strlen(psz);
+    auto limbs  = limb_buffer<uint32_t, 16>(len * 19 / 100 + 1);
+    auto nlimbs = 0;
     for(const char* p = psz; *p; p++) {
-        const char* p1 = strchr(pszBase58, *p);
-        if(p1 == NULL) {
+        auto d = base58_digits.digits[(uint8_t)*p];
+        if(d < 0) {
             while(isspace(*p))
                 p++;
             if(*p != '\0') {
-                //slog( "%s  '%c'", pszBase58,*p );
                 return false;
             }
             break;
         }
-        bnChar.setulong(p1 - pszBase58);
-        if(!BN_mul(bn.to_bignum(), bn.to_bignum(), bn58.to_bignum(), pctx))
-            throw bignum_error("DecodeBase58 : BN_mul failed");
-        bn += bnChar;
+        auto carry = (uint64_t)d;
+        for(auto i = 0; i < nlimbs; i++) {
+            carry   += (uint64_t)limbs[i] * 58;
+            limbs[i] = (uint32_t)carry;
+            carry  >>= 32;
+        }
+        if(carry > 0) {
+            limbs[nlimbs++] = (uint32_t)carry;
+        }
     }
 
-    // Get bignum as little endian data
-    std::vector<unsigned char> vchTmp = bn.getvch();
-
-    // Trim off sign byte if present
-    if(vchTmp.size() >= 2 && vchTmp.end()[-1] == 0 && vchTmp.end()[-2] >= 0x80)
-        vchTmp.erase(vchTmp.end() - 1);
-
-    // Restore leading zeros
-    int nLeadingZeros = 0;
-    for(const char* p = psz; *p == pszBase58[0]; p++)
-        nLeadingZeros++;
-    vchRet.assign(nLeadingZeros + vchTmp.size(), 0);
-
-    // Convert little endian data to big endian
-    reverse_copy(vchTmp.begin(), vchTmp.end(), vchRet.end() - vchTmp.size());
+    // Convert little endian limbs to big endian bytes without the leading zeros
+    auto nbytes = nlimbs * 4;
+    if(nlimbs > 0) {
+        for(auto v = limbs[nlimbs - 1]; (v >> 24) == 0; v <<= 8) {
+            nbytes--;
+        }
+    }
+    vchRet.assign(nLeadingZeros + nbytes, 0);
+    auto out = vchRet.end();
+    for(auto i = 0; i < nbytes; i++) {
+        *--out = (unsigned char)(limbs[i / 4] >> (8 * (i % 4)));
+    }
     return true;
 }
 
@@ -613,7 +191,7 @@ namespace fc {
 
 std::string
 to_base58(const char* d, size_t s) {
-    return EncodeBase58((const unsigned char*)d, (const unsigned char*)d + s).c_str();
+    return EncodeBase58((const unsigned char*)d, (const unsigned char*)d + s);
 }
 
 std::string
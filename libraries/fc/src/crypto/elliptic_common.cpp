@@ -220,6 +220,81 @@ private_key::generate() {
     return private_key(k);
 }
 
+namespace detail {
+
+// keys derived from one pair of random base and step
+constexpr size_t kKeysPerBase = 1024;
+
+struct ec_points {
+    ec_points(const EC_GROUP* group, size_t n) : points(n) {
+        for(auto& p : points) {
+            p = EC_POINT_new(group);
+            FC_ASSERT(p);
+        }
+    }
+
+    ~ec_points() {
+        for(auto p : points) {
+            EC_POINT_free(p);
+        }
+    }
+
+    std::vector<EC_POINT*> points;
+};
+
+}  // namespace detail
+
+std::vector<std::pair<private_key_secret, public_key_data>>
+private_key::generate_batch(size_t n) {
+    const ec_group& group = detail::get_curve();
+    bn_ctx          ctx(BN_CTX_new());
+    ssl_bignum      order;
+    FC_ASSERT(EC_GROUP_get_order(group, order, ctx));
+
+    auto keys = std::vector<std::pair<private_key_secret, public_key_data>>();
+    keys.reserve(n);
+
+    auto pts = detail::ec_points(group, std::min(n, detail::kKeysPerBase));
+    auto ec_step = ec_point(EC_POINT_new(group));
+    FC_ASSERT(ec_step);
+
+    ssl_bignum k, step;
+    while(keys.size() < n) {
+        auto m = std::min(n - keys.size(), detail::kKeysPerBase);
+
+        // k[i] = k[0] + i * step, P[i] = P[i - 1] + step * G
+        // only two full multiplications per round, the rest are additions of jacobian points
+        // which are converted to affine ones together, sharing one field inversion
+        do {
+            FC_ASSERT(BN_rand_range(k, order));
+            FC_ASSERT(BN_rand_range(step, order));
+        } while(BN_is_zero(k) || BN_is_zero(step));
+
+        FC_ASSERT(EC_POINT_mul(group, pts.points[0], k, nullptr, nullptr, ctx));
+        FC_ASSERT(EC_POINT_mul(group, ec_step, step, nullptr, nullptr, ctx));
+        for(auto i = 1u; i < m; i++) {
+            FC_ASSERT(EC_POINT_add(group, pts.points[i], pts.points[i - 1], ec_step, ctx));
+        }
+        FC_ASSERT(EC_POINTs_make_affine(group, m, pts.points.data(), ctx));
+
+        for(auto i = 0u; i < m; i++) {
+            // zero key or point at infinity happens with negligible probability, skip it anyway
+            if(BN_is_zero(k) || EC_POINT_is_at_infinity(group, pts.points[i])) {
+                FC_ASSERT(BN_mod_add(k, k, step, order, ctx));
+                continue;
+            }
+
+            auto& key = keys.emplace_back();
+            FC_ASSERT(BN_bn2binpad(k, (unsigned char*)key.first.data(), key.first.data_size()) == (int)key.first.data_size());
+            FC_ASSERT(EC_POINT_point2oct(group, pts.points[i], POINT_CONVERSION_COMPRESSED,
+                (unsigned char*)key.second.data(), key.second.size(), ctx) == key.second.size());
+
+            FC_ASSERT(BN_mod_add(k, k, step, order, ctx));
+        }
+    }
+    return keys;
+}
+
 }  // namespace ecc
 
 void
@@ -1,5 +1,7 @@
 #include <fc/crypto/elliptic_r1.hpp>
 
+#include <vector>
+
 #include <fc/crypto/base58.hpp>
 #include <fc/crypto/openssl.hpp>
 
@@ -204,6 +206,132 @@ err:
     return ret;
 }
 
+namespace {
+
+// curve parameters shared by all the recoveries, the table of generator is precomputed once
+struct r1_curve {
+    r1_curve()
+        : group(EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1)) {
+        bn_ctx ctx(BN_CTX_new());
+        EC_GROUP_precompute_mult(group, ctx);
+        EC_GROUP_get_order(group, order, ctx);
+        EC_GROUP_get_curve_GFp(group, field, nullptr, nullptr, ctx);
+        BN_rshift1(half_order, order);
+    }
+
+    ec_group   group;
+    ssl_bignum order;
+    ssl_bignum half_order;
+    ssl_bignum field;
+};
+
+const r1_curve&
+get_r1_curve() {
+    static r1_curve curve;
+    return curve;
+}
+
+// temporaries of BN_CTX are kept between calls, so each thread has its own
+BN_CTX*
+get_bn_ctx() {
+    thread_local bn_ctx ctx(BN_CTX_new());
+    return ctx;
+}
+
+struct bn_ctx_frame {
+    bn_ctx_frame(BN_CTX* ctx) : ctx(ctx) { BN_CTX_start(ctx); }
+    ~bn_ctx_frame() { BN_CTX_end(ctx); }
+
+    BN_CTX* ctx;
+};
+
+}  // namespace
+
+void
+recover_keys(const compact_signature sigs[], size_t n, const fc::sha256& digest, public_key_data keys[]) {
+    if(n == 0) {
+        return;
+    }
+
+    auto& curve = get_r1_curve();
+    auto  ctx   = get_bn_ctx();
+    auto  frame = bn_ctx_frame(ctx);
+
+    // bignums are all from ctx and released together by the frame
+    auto rs      = std::vector<BIGNUM*>(n);
+    auto ss      = std::vector<BIGNUM*>(n);
+    auto product = std::vector<BIGNUM*>(n);
+    auto recids  = std::vector<int>(n);
+
+    for(auto i = 0u; i < n; i++) {
+        auto& c  = sigs[i];
+        auto  nV = (int)c[0];
+        if(nV < 27 || nV >= 35)
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+        recids[i] = (nV >= 31 ? nV - 4 : nV) - 27;
+
+        rs[i] = BN_CTX_get(ctx);
+        ss[i] = BN_CTX_get(ctx);
+        BN_bin2bn(&c[1], 32, rs[i]);
+        BN_bin2bn(&c[33], 32, ss[i]);
+        if(BN_cmp(ss[i], curve.half_order) > 0)
+            FC_THROW_EXCEPTION(exception, "invalid high s-value encountered in r1 signature");
+        if(BN_is_zero(rs[i]) || BN_cmp(rs[i], curve.order) >= 0)
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+
+        // prefix products of r, all of them are inverted with only one inversion
+        product[i] = BN_CTX_get(ctx);
+        if(i == 0) {
+            BN_copy(product[i], rs[i]);
+        }
+        else {
+            BN_mod_mul(product[i], product[i - 1], rs[i], curve.order, ctx);
+        }
+    }
+
+    auto inv = BN_CTX_get(ctx);
+    auto rr  = BN_CTX_get(ctx);
+    auto e   = BN_CTX_get(ctx);
+    auto x   = BN_CTX_get(ctx);
+    auto sor = BN_CTX_get(ctx);
+    auto eor = BN_CTX_get(ctx);
+    FC_ASSERT(eor != nullptr && BN_mod_inverse(inv, product[n - 1], curve.order, ctx) != nullptr);
+
+    // e = -digest mod n, same for all the signatures
+    BN_bin2bn((const unsigned char*)&digest, sizeof(digest), e);
+    BN_zero(x);
+    BN_mod_sub(e, x, e, curve.order, ctx);
+
+    ec_point R(EC_POINT_new(curve.group));
+    ec_point Q(EC_POINT_new(curve.group));
+    for(auto i = n; i-- > 0;) {
+        // inv is the inverse of r[0] * ... * r[i] here
+        if(i > 0) {
+            BN_mod_mul(rr, inv, product[i - 1], curve.order, ctx);
+            BN_mod_mul(inv, inv, rs[i], curve.order, ctx);
+        }
+        else {
+            BN_copy(rr, inv);
+        }
+
+        BN_copy(x, curve.order);
+        BN_mul_word(x, recids[i] / 2);
+        BN_add(x, x, rs[i]);
+        if(BN_cmp(x, curve.field) >= 0
+           || !EC_POINT_set_compressed_coordinates_GFp(curve.group, R, x, recids[i] % 2, ctx))
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+
+        // Q = (-e / r) * G + (s / r) * R
+        BN_mod_mul(sor, ss[i], rr, curve.order, ctx);
+        BN_mod_mul(eor, e, rr, curve.order, ctx);
+        if(!EC_POINT_mul(curve.group, Q, eor, R, sor, ctx) || EC_POINT_is_at_infinity(curve.group, Q))
+            FC_THROW_EXCEPTION(exception, "unable to reconstruct public key from signature");
+
+        auto size = EC_POINT_point2oct(curve.group, Q, POINT_CONVERSION_COMPRESSED, (unsigned char*)keys[i].data(), keys[i].size(), ctx);
+        FC_ASSERT(size == keys[i].size());
+    }
+}
+
 compact_signature
 signature_from_ecdsa(const EC_KEY* key, const public_key_data& pub_data, fc::ecdsa_sig& sig, const fc::sha256& d) {
     //We can't use ssl_bignum here; _get0() does not transfer ownership to us; _set0() does transfer ownership to fc::ecdsa_sig
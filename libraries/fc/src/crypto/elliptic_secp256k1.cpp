@@ -29,6 +29,24 @@ _get_context() {
     return ctx;
 }
 
+// recovery only needs the verification tables, every thread gets its own copy of them
+// cloned from a shared one, which is much cheaper than building the tables again
+const secp256k1_context_t*
+_get_verify_context() {
+    struct context_holder {
+        context_holder() {
+            static secp256k1_context_t* base = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+            ctx = secp256k1_context_clone(base);
+        }
+        ~context_holder() { secp256k1_context_destroy(ctx); }
+
+        secp256k1_context_t* ctx;
+    };
+
+    thread_local context_holder holder;
+    return holder.ctx;
+}
+
 void
 _init_lib() {
     static const secp256k1_context_t* ctx    = _get_context();
@@ -160,7 +178,7 @@ public_key::public_key(const compact_signature& c, const fc::sha256& digest, boo
     }
 
     unsigned int pk_len;
-    FC_ASSERT(secp256k1_ecdsa_recover_compact(detail::_get_context(), (unsigned char*)digest.data(), (unsigned char*)c.begin() + 1, (unsigned char*)my->_key.begin(), (int*)&pk_len, 1, (*c.begin() - 27) & 3));
+    FC_ASSERT(secp256k1_ecdsa_recover_compact(detail::_get_verify_context(), (unsigned char*)digest.data(), (unsigned char*)c.begin() + 1, (unsigned char*)my->_key.begin(), (int*)&pk_len, 1, (*c.begin() - 27) & 3));
     FC_ASSERT(pk_len == my->_key.size());
 }
 
@@ -17,6 +17,19 @@ private_key::get_public_key() const {
     return public_key(_storage.visit(public_key_visitor()));
 }
 
+std::vector<std::pair<private_key, public_key>>
+private_key::generate_batch(size_t n) {
+    auto batch = ecc::private_key::generate_batch(n);
+
+    auto keys = std::vector<std::pair<private_key, public_key>>();
+    keys.reserve(batch.size());
+    for(auto& it : batch) {
+        keys.emplace_back(private_key(storage_type(ecc::private_key_shim(it.first))),
+                          public_key(ecc::public_key_shim(it.second)));
+    }
+    return keys;
+}
+
 struct sign_visitor : visitor<signature::storage_type> {
     sign_visitor(const sha256& digest, bool require_canonical)
         : _digest(digest)
@@ -1,6 +1,13 @@
 #include <fc/crypto/public_key.hpp>
+#include <fc/crypto/base58_cache.hpp>
 #include <fc/crypto/common.hpp>
+#include <fc/crypto/city.hpp>
 #include <fc/exception/exception.hpp>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace fc { namespace crypto {
 
@@ -18,11 +25,155 @@ struct recovery_visitor : fc::visitor<public_key::storage_type> {
     bool          _check_canonical;
 };
 
+// k1 and r1 share the same layouts of compact signatures and compressed keys
+static_assert(std::is_same_v<ecc::compact_signature, r1::compact_signature>);
+static_assert(std::is_same_v<ecc::public_key_data, r1::public_key_data>);
+
+using compact_signature = ecc::compact_signature;
+using public_key_data   = ecc::public_key_data;
+
+/**
+  *  Keys recovered recently from (digest, signature) pairs, the same signatures are recovered
+  *  again when required keys are checked, when transactions are applied and when blocks are validated
+  *
+  *  It's shared by the whole process, split into shards with their own locks and direct-mapped in each
+  *  shard, so the size is bounded and one newly recovered key simply replaces the older one in its slot.
+  */
+class recovery_cache {
+private:
+    static constexpr size_t kShards        = 16;
+    static constexpr size_t kSlotsPerShard = 2048;
+
+    struct slot {
+        bool              valid     = false;
+        bool              canonical = false;  // checked to be canonical when it was recovered
+        int               which     = 0;      // type of signature
+        sha256            digest;
+        compact_signature sig;
+        public_key_data   key;
+    };
+
+    struct shard {
+        std::mutex                       mutex;
+        std::array<slot, kSlotsPerShard> slots;
+    };
+
+public:
+    static bool
+    get(int which, const sha256& digest, const compact_signature& sig, bool check_canonical, public_key_data& key) {
+        auto  h = hash(which, digest, sig);
+        auto& s = shards()[h % kShards];
+
+        auto lock = std::lock_guard<std::mutex>(s.mutex);
+        auto& sl  = s.slots[(h / kShards) % kSlotsPerShard];
+        if(!sl.valid || sl.which != which || sl.digest != digest || sl.sig != sig) {
+            return false;
+        }
+        if(check_canonical && !sl.canonical) {
+            // recovers again so non-canonical signatures fail the same way
+            return false;
+        }
+        key = sl.key;
+        return true;
+    }
+
+    static void
+    put(int which, const sha256& digest, const compact_signature& sig, bool canonical, const public_key_data& key) {
+        auto  h = hash(which, digest, sig);
+        auto& s = shards()[h % kShards];
+
+        auto lock = std::lock_guard<std::mutex>(s.mutex);
+        auto& sl  = s.slots[(h / kShards) % kSlotsPerShard];
+        sl.valid     = true;
+        sl.canonical = canonical;
+        sl.which     = which;
+        sl.digest    = digest;
+        sl.sig       = sig;
+        sl.key       = key;
+    }
+
+private:
+    static size_t
+    hash(int which, const sha256& digest, const compact_signature& sig) {
+        return city_hash_size_t((const char*)sig.data(), sig.size()) ^ (size_t)digest._hash[0] ^ (size_t)which;
+    }
+
+    static shard*
+    shards() {
+        static auto s = std::make_unique<shard[]>(kShards);
+        return s.get();
+    }
+};
+
+static const compact_signature&
+compact_data(const signature::storage_type& s) {
+    return s.which() == 0 ? s.get<ecc::signature_shim>()._data : s.get<r1::signature_shim>()._data;
+}
+
+static public_key::storage_type
+make_storage(int which, const public_key_data& key) {
+    if(which == 0) {
+        return public_key::storage_type(ecc::public_key_shim(key));
+    }
+    return public_key::storage_type(r1::public_key_shim(key));
+}
+
+static public_key::storage_type
+recover_cached(const signature::storage_type& s, const sha256& digest, bool check_canonical) {
+    auto& sig = compact_data(s);
+    auto  key = public_key_data();
+    if(recovery_cache::get(s.which(), digest, sig, check_canonical, key)) {
+        return make_storage(s.which(), key);
+    }
+
+    // only successful recoveries are stored
+    // r1 signatures are always checked to be canonical when they are recovered
+    auto storage = s.visit(recovery_visitor(digest, check_canonical));
+    key = storage.which() == 0 ? storage.get<ecc::public_key_shim>()._data : storage.get<r1::public_key_shim>()._data;
+    recovery_cache::put(s.which(), digest, sig, check_canonical || s.which() == 1, key);
+    return storage;
+}
+
+void
+public_key::recover_many(const signature sigs[], size_t n, const sha256& digest, public_key keys[], bool check_canonical) {
+    auto batch = std::vector<size_t>();
+    for(auto i = 0u; i < n; i++) {
+        auto& s = sigs[i]._storage;
+        if(s.which() != 1) {
+            keys[i] = public_key(recover_cached(s, digest, check_canonical));
+            continue;
+        }
+
+        auto key = public_key_data();
+        if(recovery_cache::get(1, digest, compact_data(s), true, key)) {
+            keys[i] = public_key(make_storage(1, key));
+            continue;
+        }
+        batch.emplace_back(i);
+    }
+    if(batch.empty()) {
+        return;
+    }
+
+    // r1 recovery is much slower than k1, the ones not cached are recovered together
+    auto bsigs = std::vector<compact_signature>();
+    auto bkeys = std::vector<public_key_data>(batch.size());
+    for(auto i : batch) {
+        bsigs.emplace_back(compact_data(sigs[i]._storage));
+    }
+    r1::recover_keys(bsigs.data(), bsigs.size(), digest, bkeys.data());
+
+    for(auto j = 0u; j < batch.size(); j++) {
+        recovery_cache::put(1, digest, bsigs[j], true, bkeys[j]);
+        keys[batch[j]] = public_key(make_storage(1, bkeys[j]));
+    }
+}
+
 public_key::public_key(const ecc::public_key_shim& ecc_key)
     : _storage(ecc_key) {}
 
 public_key::public_key(const signature& c, const sha256& digest, bool check_canonical)
-    : _storage(c._storage.visit(recovery_visitor(digest, check_canonical))) {}
+    : _storage(recover_cached(c._storage, digest, check_canonical)) {}
 
 static public_key::storage_type
 parse_base58(const std::string& base58str) {
@@ -59,10 +210,13 @@ public_key::valid() const {
 }
 
 public_key::operator std::string() const {
-    auto data_str = _storage.visit(base58str_visitor<storage_type, config::public_key_prefix, 0>());
-
     FC_ASSERT(_storage.which() == 0);
-    return std::string(config::public_key_evt_prefix) + data_str;
+
+    // the same keys are rendered again and again in json of traces and blocks
+    return base58_cache<ecc::public_key_shim::data_type>::get(_storage.get<ecc::public_key_shim>()._data, [this] {
+        auto data_str = _storage.visit(base58str_visitor<storage_type, config::public_key_prefix, 0>());
+        return std::string(config::public_key_evt_prefix) + data_str;
+    });
 }
 
 std::ostream&
@@ -86,6 +240,21 @@ operator<(const public_key& p1, const public_key& p2) {
     return less_comparator<public_key::storage_type>::apply(p1._storage, p2._storage);
 }
 
+struct key_hash_visitor : public fc::visitor<size_t> {
+    template<typename KeyType>
+    size_t operator()(const KeyType& key) const {
+        // keys are compressed points, bytes after the prefix byte are x coordinate which is already uniform
+        auto h = size_t();
+        memcpy(&h, key._data.data() + 1, sizeof(h));
+        return h;
+    }
+};
+
+size_t
+hash_value(const public_key& k) {
+    return k._storage.visit(key_hash_visitor()) ^ k._storage.which();
+}
+
 }}  // namespace fc::crypto
 
 namespace fc {
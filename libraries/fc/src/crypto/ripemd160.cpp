@@ -1,8 +1,8 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/fwd_impl.hpp>
-#include <openssl/sha.h>
-#include <openssl/ripemd.h>
 #include <string.h>
+#include <algorithm>
+#include <utility>
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/crypto/sha512.hpp>
 #include <fc/crypto/sha256.hpp>
@@ -12,6 +12,100 @@
 
 namespace fc {
 
+namespace {
+
+// message word selection and rotations of the left and right lines
+constexpr uint8_t RL[80] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+    3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+    1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+    4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+constexpr uint8_t RR[80] = {
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+    6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+    15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+    8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+    12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+constexpr uint8_t SL[80] = {
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+    7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+    11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+    11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+    9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+constexpr uint8_t SR[80] = {
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+    9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+    9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+    15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+    8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+constexpr uint32_t KL[5] = { 0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E };
+constexpr uint32_t KR[5] = { 0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000 };
+
+inline uint32_t
+rol(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+// boolean function of round j, the right line uses them in reversed order
+template<int j>
+inline uint32_t
+f(uint32_t x, uint32_t y, uint32_t z) {
+    if constexpr(j == 0) return x ^ y ^ z;
+    else if constexpr(j == 1) return (x & y) | (~x & z);
+    else if constexpr(j == 2) return (x | ~y) ^ z;
+    else if constexpr(j == 3) return (x & z) | (y & ~z);
+    else return x ^ (y | ~z);
+}
+
+struct line {
+    uint32_t a, b, c, d, e;
+};
+
+template<int i>
+inline void
+step(line& l, line& r, const uint32_t x[16]) {
+    constexpr auto j = i / 16;
+
+    auto t = rol(l.a + f<j>(l.b, l.c, l.d) + x[RL[i]] + KL[j], SL[i]) + l.e;
+    l = { l.e, t, l.b, rol(l.c, 10), l.d };
+
+    t = rol(r.a + f<4 - j>(r.b, r.c, r.d) + x[RR[i]] + KR[j], SR[i]) + r.e;
+    r = { r.e, t, r.b, rol(r.c, 10), r.d };
+}
+
+template<int... I>
+inline void
+steps(line& l, line& r, const uint32_t x[16], std::integer_sequence<int, I...>) {
+    (step<I>(l, r, x), ...);
+}
+
+// one 64 bytes block, all the 80 steps are unrolled and there is no branch or table lookup depending on the data
+void
+compress(uint32_t h[5], const uint8_t* block) {
+    uint32_t x[16];
+    for(auto i = 0; i < 16; i++) {
+        x[i] = (uint32_t)block[4 * i] | ((uint32_t)block[4 * i + 1] << 8) | ((uint32_t)block[4 * i + 2] << 16) | ((uint32_t)block[4 * i + 3] << 24);
+    }
+
+    auto l = line{ h[0], h[1], h[2], h[3], h[4] };
+    auto r = l;
+    steps(l, r, x, std::make_integer_sequence<int, 80>());
+
+    auto t = h[1] + l.c + r.d;
+    h[1]   = h[2] + l.d + r.e;
+    h[2]   = h[3] + l.e + r.a;
+    h[3]   = h[4] + l.a + r.b;
+    h[4]   = h[0] + l.b + r.c;
+    h[0]   = t;
+}
+
+}  // namespace
+
 ripemd160::ripemd160() {
     memset(_hash, 0, sizeof(_hash));
 }
@@ -35,10 +129,9 @@ ripemd160::data() const {
 }
 
 struct ripemd160::encoder::impl {
-    impl() {
-        memset((char*)&ctx, 0, sizeof(ctx));
-    }
-    RIPEMD160_CTX ctx;
+    uint32_t h[5];
+    uint8_t  buf[64];
+    uint64_t len;
 };
 
 ripemd160::encoder::~encoder() {}
@@ -70,19 +163,52 @@ ripemd160::hash(const string& s) {
 
 void
 ripemd160::encoder::write(const char* d, uint32_t dlen) {
-    RIPEMD160_Update(&my->ctx, d, dlen);
+    auto used = my->len % 64;
+    my->len += dlen;
+
+    if(used > 0) {
+        auto n = std::min<uint64_t>(64 - used, dlen);
+        memcpy(my->buf + used, d, n);
+        if(used + n < 64) {
+            return;
+        }
+        compress(my->h, my->buf);
+        d += n;
+        dlen -= n;
+    }
+    for(; dlen >= 64; d += 64, dlen -= 64) {
+        compress(my->h, (const uint8_t*)d);
+    }
+    memcpy(my->buf, d, dlen);
 }
 
 ripemd160
 ripemd160::encoder::result() {
+    // 0x80, zeros and then the length in bits, ends at a block boundary
+    auto bits = my->len * 8;
+    auto used = my->len % 64;
+
+    uint8_t pad[72] = { 0x80 };
+    auto    n       = (used < 56 ? 56 - used : 120 - used);
+    for(auto i = 0; i < 8; i++) {
+        pad[n + i] = (uint8_t)(bits >> (8 * i));
+    }
+    write((const char*)pad, n + 8);
+
     ripemd160 h;
-    RIPEMD160_Final((uint8_t*)h.data(), &my->ctx);
+    static_assert(sizeof(h._hash) == sizeof(my->h));
+    memcpy(h._hash, my->h, sizeof(h._hash));
     return h;
 }
 
 void
 ripemd160::encoder::reset() {
-    RIPEMD160_Init(&my->ctx);
+    my->h[0] = 0x67452301;
+    my->h[1] = 0xEFCDAB89;
+    my->h[2] = 0x98BADCFE;
+    my->h[3] = 0x10325476;
+    my->h[4] = 0xC3D2E1F0;
+    my->len  = 0;
 }
 
 ripemd160
@@ -2,6 +2,9 @@
 #include <fc/crypto/hmac.hpp>
 #include <fc/fwd_impl.hpp>
 #include <openssl/sha.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include <string.h>
 #include <cmath>
 #include <fc/crypto/sha256.hpp>
@@ -52,9 +55,175 @@ sha256::encoder::encoder() {
 
 sha256
 sha256::hash(const char* d, uint32_t dlen) {
-    encoder e;
-    e.write(d, dlen);
-    return e.result();
+    sha256 h;
+    SHA256((const uint8_t*)d, dlen, (uint8_t*)h.data());
+    return h;
+}
+
+namespace {
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FC_SHA256_AVX2 1
+
+// 8 messages of the same number of blocks are hashed at once, one in each 32-bits lane
+constexpr int kLanes     = 8;
+constexpr int kMaxBlocks = 4;
+
+const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t H256[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+size_t
+padded_blocks(uint32_t size) {
+    // one byte of 0x80 and 8 bytes of length are appended
+    return (size + 9 + 63) / 64;
+}
+
+void
+pad_message(const char* data, uint32_t size, uint8_t* out, size_t blocks) {
+    memset(out, 0, blocks * 64);
+    memcpy(out, data, size);
+    out[size] = 0x80;
+
+    auto bits = (uint64_t)size * 8;
+    for(auto i = 0; i < 8; i++) {
+        out[blocks * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+#define FC_ROTR(x, n)     _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define FC_ADD(a, b)      _mm256_add_epi32(a, b)
+#define FC_XOR3(a, b, c)  _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+
+__attribute__((target("avx2"))) void
+hash_lanes(const uint8_t* msgs[kLanes], size_t blocks, sha256* out[kLanes]) {
+    __m256i state[8];
+    for(auto i = 0; i < 8; i++) {
+        state[i] = _mm256_set1_epi32((int)H256[i]);
+    }
+
+    for(auto b = 0u; b < blocks; b++) {
+        __m256i w[64];
+        for(auto t = 0; t < 16; t++) {
+            uint32_t v[kLanes];
+            for(auto l = 0; l < kLanes; l++) {
+                auto p = msgs[l] + b * 64 + t * 4;
+                v[l]   = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+            }
+            w[t] = _mm256_loadu_si256((const __m256i*)v);
+        }
+        for(auto t = 16; t < 64; t++) {
+            auto s0 = FC_XOR3(FC_ROTR(w[t - 15], 7), FC_ROTR(w[t - 15], 18), _mm256_srli_epi32(w[t - 15], 3));
+            auto s1 = FC_XOR3(FC_ROTR(w[t - 2], 17), FC_ROTR(w[t - 2], 19), _mm256_srli_epi32(w[t - 2], 10));
+            w[t]    = FC_ADD(FC_ADD(w[t - 16], s0), FC_ADD(w[t - 7], s1));
+        }
+
+        auto a = state[0], b_ = state[1], c = state[2], d = state[3];
+        auto e = state[4], f = state[5], g = state[6], h = state[7];
+        for(auto t = 0; t < 64; t++) {
+            auto S1  = FC_XOR3(FC_ROTR(e, 6), FC_ROTR(e, 11), FC_ROTR(e, 25));
+            auto ch  = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            auto t1  = FC_ADD(FC_ADD(FC_ADD(h, S1), FC_ADD(ch, _mm256_set1_epi32((int)K256[t]))), w[t]);
+            auto S0  = FC_XOR3(FC_ROTR(a, 2), FC_ROTR(a, 13), FC_ROTR(a, 22));
+            auto maj = FC_XOR3(_mm256_and_si256(a, b_), _mm256_and_si256(a, c), _mm256_and_si256(b_, c));
+            auto t2  = FC_ADD(S0, maj);
+
+            h  = g;
+            g  = f;
+            f  = e;
+            e  = FC_ADD(d, t1);
+            d  = c;
+            c  = b_;
+            b_ = a;
+            a  = FC_ADD(t1, t2);
+        }
+        state[0] = FC_ADD(state[0], a);
+        state[1] = FC_ADD(state[1], b_);
+        state[2] = FC_ADD(state[2], c);
+        state[3] = FC_ADD(state[3], d);
+        state[4] = FC_ADD(state[4], e);
+        state[5] = FC_ADD(state[5], f);
+        state[6] = FC_ADD(state[6], g);
+        state[7] = FC_ADD(state[7], h);
+    }
+
+    // transpose lanes back and write digests in big endian
+    uint32_t words[8][kLanes];
+    for(auto i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i*)words[i], state[i]);
+    }
+    for(auto l = 0; l < kLanes; l++) {
+        auto p = (uint8_t*)out[l]->data();
+        for(auto i = 0; i < 8; i++) {
+            auto v   = words[i][l];
+            p[i * 4] = (uint8_t)(v >> 24);
+            p[i * 4 + 1] = (uint8_t)(v >> 16);
+            p[i * 4 + 2] = (uint8_t)(v >> 8);
+            p[i * 4 + 3] = (uint8_t)v;
+        }
+    }
+}
+
+#undef FC_ROTR
+#undef FC_ADD
+#undef FC_XOR3
+
+bool
+support_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#endif
+
+}  // namespace
+
+void
+sha256::hash_many(const char* const data[], const uint32_t sizes[], size_t n, sha256 out[]) {
+    auto i = (size_t)0;
+#ifdef FC_SHA256_AVX2
+    if(support_avx2()) {
+        // runs of 8 messages with the same number of blocks go through lanes, like the leaves and nodes of merkle
+        uint8_t        buf[kLanes][kMaxBlocks * 64];
+        const uint8_t* msgs[kLanes];
+        sha256*        outs[kLanes];
+
+        while(i + kLanes <= n) {
+            auto blocks = padded_blocks(sizes[i]);
+            auto same   = blocks <= kMaxBlocks;
+            for(auto l = 1; same && l < kLanes; l++) {
+                same = padded_blocks(sizes[i + l]) == blocks;
+            }
+            if(!same) {
+                out[i] = hash(data[i], sizes[i]);
+                i++;
+                continue;
+            }
+
+            for(auto l = 0; l < kLanes; l++) {
+                pad_message(data[i + l], sizes[i + l], buf[l], blocks);
+                msgs[l] = buf[l];
+                outs[l] = &out[i + l];
+            }
+            hash_lanes(msgs, blocks, outs);
+            i += kLanes;
+        }
+    }
+#endif
+    for(; i < n; i++) {
+        out[i] = hash(data[i], sizes[i]);
+    }
 }
 
 sha256
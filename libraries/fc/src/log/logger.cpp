@@ -111,6 +111,28 @@ logger::get(const fc::string& s) {
     return get_logger_map()[s];
 }
 
+static logger&
+default_logger_slot() {
+    static logger l = logger::get("default");
+    return l;
+}
+
+// called after logging is configured, loggers in the map are all replaced then
+void
+reset_default_logger() {
+    default_logger_slot() = logger::get("default");
+}
+
+logger&
+logger::default_logger() {
+    return default_logger_slot();
+}
+
+logger&
+logger::default_logger(const fc::string& name) {
+    return get_logger_map()[name];
+}
+
 logger
 logger::get_parent() const {
     return my->_parent;
@@ -19,6 +19,7 @@
 namespace fc {
 extern std::unordered_map<std::string, logger>&        get_logger_map();
 extern std::unordered_map<std::string, appender::ptr>& get_appender_map();
+extern void                                            reset_default_logger();
 logger_config&
 logger_config::add_appender(const string& s) {
     appenders.push_back(s);
@@ -62,6 +63,7 @@ configure_logging(const logging_config& cfg) {
                 }
             }
         }
+        reset_default_logger();
 #ifndef FCLITE
         return reg_console_appender || reg_gelf_appender;
 #else
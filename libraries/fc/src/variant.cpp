@@ -5,6 +5,7 @@
 
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
+#include <fc/variant_arena.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/io/json.hpp>
@@ -12,6 +13,32 @@
 #include <fc/crypto/hex.hpp>
 
 namespace fc {
+
+namespace {
+
+// heap nodes of variants go through the arena of current thread if there is one
+template<typename T, typename ... Args>
+T*
+new_node(Args&& ... args) {
+    auto p = variant_arena::allocate(sizeof(T));
+    try {
+        return new (p) T(std::forward<Args>(args)...);
+    }
+    catch(...) {
+        variant_arena::deallocate(p);
+        throw;
+    }
+}
+
+template<typename T>
+void
+delete_node(T* p) {
+    p->~T();
+    variant_arena::deallocate(p);
+}
+
+}  // namespace
+
 /**
   *  The TypeID is stored in the 'last byte' of the variant.
   */
@@ -85,12 +112,12 @@ variant::variant(bool val) {
 }
 
 variant::variant(char* str) {
-    *reinterpret_cast<string**>(this) = new string(str);
+    *reinterpret_cast<string**>(this) = new_node<string>(str);
     set_variant_type(this, string_type);
 }
 
 variant::variant(const char* str) {
-    *reinterpret_cast<string**>(this) = new string(str);
+    *reinterpret_cast<string**>(this) = new_node<string>(str);
     set_variant_type(this, string_type);
 }
 
@@ -101,7 +128,7 @@ variant::variant(wchar_t* str) {
     for(unsigned i = 0; i < len; ++i) {
         buffer[i] = (char)str[i];
     }
-    *reinterpret_cast<string**>(this) = new string(buffer.get(), len);
+    *reinterpret_cast<string**>(this) = new_node<string>(buffer.get(), len);
     set_variant_type(this, string_type);
 }
 
@@ -112,30 +139,30 @@ variant::variant(const wchar_t* str) {
     for(unsigned i = 0; i < len; ++i) {
         buffer[i] = (char)str[i];
     }
-    *reinterpret_cast<string**>(this) = new string(buffer.get(), len);
+    *reinterpret_cast<string**>(this) = new_node<string>(buffer.get(), len);
     set_variant_type(this, string_type);
 }
 
 variant::variant(fc::string val) {
-    *reinterpret_cast<string**>(this) = new string(fc::move(val));
+    *reinterpret_cast<string**>(this) = new_node<string>(fc::move(val));
     set_variant_type(this, string_type);
 }
 variant::variant(blob val) {
-    *reinterpret_cast<blob**>(this) = new blob(fc::move(val));
+    *reinterpret_cast<blob**>(this) = new_node<blob>(fc::move(val));
     set_variant_type(this, blob_type);
 }
 
 variant::variant(variant_object obj) {
-    *reinterpret_cast<variant_object**>(this) = new variant_object(fc::move(obj));
+    *reinterpret_cast<variant_object**>(this) = new_node<variant_object>(fc::move(obj));
     set_variant_type(this, object_type);
 }
 variant::variant(mutable_variant_object obj) {
-    *reinterpret_cast<variant_object**>(this) = new variant_object(fc::move(obj));
+    *reinterpret_cast<variant_object**>(this) = new_node<variant_object>(fc::move(obj));
     set_variant_type(this, object_type);
 }
 
 variant::variant(variants arr) {
-    *reinterpret_cast<variants**>(this) = new variants(fc::move(arr));
+    *reinterpret_cast<variants**>(this) = new_node<variants>(fc::move(arr));
     set_variant_type(this, array_type);
 }
 
@@ -148,16 +175,16 @@ void
 variant::clear() {
     switch(get_type()) {
     case object_type:
-        delete *reinterpret_cast<variant_object**>(this);
+        delete_node(*reinterpret_cast<variant_object**>(this));
         break;
     case array_type:
-        delete *reinterpret_cast<variants**>(this);
+        delete_node(*reinterpret_cast<variants**>(this));
         break;
     case string_type:
-        delete *reinterpret_cast<string**>(this);
+        delete_node(*reinterpret_cast<string**>(this));
         break;
     case blob_type:
-        delete *reinterpret_cast<blob**>(this);
+        delete_node(*reinterpret_cast<blob**>(this));
         break;
     default:
         break;
@@ -168,20 +195,20 @@ variant::clear() {
 variant::variant(const variant& v) {
     switch(v.get_type()) {
     case object_type:
-        *reinterpret_cast<variant_object**>(this) = new variant_object(**reinterpret_cast<const const_variant_object_ptr*>(&v));
+        *reinterpret_cast<variant_object**>(this) = new_node<variant_object>(**reinterpret_cast<const const_variant_object_ptr*>(&v));
         set_variant_type(this, object_type);
         return;
     case array_type:
-        *reinterpret_cast<variants**>(this) = new variants(**reinterpret_cast<const const_variants_ptr*>(&v));
+        *reinterpret_cast<variants**>(this) = new_node<variants>(**reinterpret_cast<const const_variants_ptr*>(&v));
         set_variant_type(this, array_type);
         return;
     case string_type:
-        *reinterpret_cast<string**>(this) = new string(**reinterpret_cast<const const_string_ptr*>(&v));
+        *reinterpret_cast<string**>(this) = new_node<string>(**reinterpret_cast<const const_string_ptr*>(&v));
         set_variant_type(this, string_type);
         return;
     case blob_type:
         *reinterpret_cast<blob**>(this)  =
-        new blob(**reinterpret_cast<const const_blob_ptr*>(&v));
+        new_node<blob>(**reinterpret_cast<const const_blob_ptr*>(&v));
         set_variant_type(this, blob_type);
         return;
     default:
@@ -216,16 +243,16 @@ variant::operator=(const variant& v) {
     clear();
     switch(v.get_type()) {
     case object_type:
-        *reinterpret_cast<variant_object**>(this) = new variant_object((**reinterpret_cast<const const_variant_object_ptr*>(&v)));
+        *reinterpret_cast<variant_object**>(this) = new_node<variant_object>((**reinterpret_cast<const const_variant_object_ptr*>(&v)));
         break;
     case array_type:
-        *reinterpret_cast<variants**>(this) = new variants((**reinterpret_cast<const const_variants_ptr*>(&v)));
+        *reinterpret_cast<variants**>(this) = new_node<variants>((**reinterpret_cast<const const_variants_ptr*>(&v)));
         break;
     case string_type:
-        *reinterpret_cast<string**>(this) = new string((**reinterpret_cast<const const_string_ptr*>(&v)));
+        *reinterpret_cast<string**>(this) = new_node<string>((**reinterpret_cast<const const_string_ptr*>(&v)));
         break;
     case blob_type:
-        *reinterpret_cast<blob**>(this) = new blob((**reinterpret_cast<const const_blob_ptr*>(&v)));
+        *reinterpret_cast<blob**>(this) = new_node<blob>((**reinterpret_cast<const const_blob_ptr*>(&v)));
         break;
     default:
         memcpy(this, &v, sizeof(v));
@@ -0,0 +1,102 @@
+#include <fc/variant_arena.hpp>
+#include <algorithm>
+#include <new>
+
+namespace fc {
+
+namespace {
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+constexpr size_t kBlockSize = 64 * 1024;
+
+// every node is prefixed by the arena it comes from, null for the heap ones
+struct alignas(kAlignment) node_header {
+    variant_arena* arena;
+};
+
+constexpr size_t
+align_up(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+thread_local variant_arena* current_arena = nullptr;
+
+}  // namespace
+
+variant_arena::scope::scope(bool enabled)
+    : arena_(enabled ? new variant_arena() : nullptr)
+    , prev_(current_arena) {
+    if(arena_) {
+        current_arena = arena_;
+    }
+}
+
+variant_arena::scope::~scope() {
+    if(arena_) {
+        current_arena = prev_;
+        arena_->release();
+    }
+}
+
+variant_arena::variant_arena()
+    : refs_(1)
+    , cur_(nullptr)
+    , left_(0) {}
+
+variant_arena::~variant_arena() {
+    for(auto b : blocks_) {
+        delete[] b;
+    }
+}
+
+void*
+variant_arena::allocate(size_t size) {
+    auto total = sizeof(node_header) + align_up(size);
+
+    node_header* h;
+    if(current_arena) {
+        h        = new (current_arena->alloc(total)) node_header;
+        h->arena = current_arena;
+        current_arena->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        h        = new (::operator new(total)) node_header;
+        h->arena = nullptr;
+    }
+    return h + 1;
+}
+
+void
+variant_arena::deallocate(void* p) {
+    auto h = reinterpret_cast<node_header*>(p) - 1;
+    if(h->arena) {
+        h->arena->release();
+    }
+    else {
+        ::operator delete(h);
+    }
+}
+
+// only called from the thread owning the scope, so blocks need no lock
+void*
+variant_arena::alloc(size_t size) {
+    if(size > left_) {
+        auto sz = std::max(size, kBlockSize);
+        blocks_.emplace_back(new char[sz]);
+        cur_  = blocks_.back();
+        left_ = sz;
+    }
+    auto p = cur_;
+    cur_  += size;
+    left_ -= size;
+    return p;
+}
+
+void
+variant_arena::release() {
+    if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+}  // namespace fc
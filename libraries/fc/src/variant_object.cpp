@@ -1,7 +1,38 @@
 #include <fc/variant_object.hpp>
 #include <fc/exception/exception.hpp>
 
+#include <mutex>
+#include <unordered_set>
+
 namespace fc {
+// ---------------------------------------------------------------
+// interned_key
+
+namespace {
+
+struct key_table {
+    std::mutex                      mutex;
+    std::unordered_set<std::string> keys;  // nodes are never moved, so keys can be referred to
+
+    static key_table&
+    instance() {
+        static key_table t;
+        return t;
+    }
+};
+
+}  // namespace
+
+interned_key::interned_key()
+    : _key(intern_key(string())._key) {}
+
+interned_key
+intern_key(const string& key) {
+    auto& t    = key_table::instance();
+    auto  lock = std::lock_guard<std::mutex>(t.mutex);
+    return interned_key(&*t.keys.emplace(key).first);
+}
+
 // ---------------------------------------------------------------
 // entry
 
@@ -11,18 +42,25 @@ variant_object::entry::entry(string k, variant v)
     : _key(fc::move(k))
     , _value(fc::move(v)) {}
 
+variant_object::entry::entry(interned_key k, variant v)
+    : _ikey(&k.str())
+    , _value(fc::move(v)) {}
+
 variant_object::entry::entry(entry&& e)
     : _key(fc::move(e._key))
+    , _ikey(e._ikey)
     , _value(fc::move(e._value)) {}
 
 variant_object::entry::entry(const entry& e)
     : _key(e._key)
+    , _ikey(e._ikey)
     , _value(e._value) {}
 
 variant_object::entry&
 variant_object::entry::operator=(const variant_object::entry& e) {
     if(this != &e) {
         _key   = e._key;
+        _ikey  = e._ikey;
         _value = e._value;
     }
     return *this;
@@ -31,15 +69,11 @@ variant_object::entry::operator=(const variant_object::entry& e) {
 variant_object::entry&
 variant_object::entry::operator=(variant_object::entry&& e) {
     fc_swap(_key, e._key);
+    fc_swap(_ikey, e._ikey);
     fc_swap(_value, e._value);
     return *this;
 }
 
-const string&
-variant_object::entry::key() const {
-    return _key;
-}
-
 const variant&
 variant_object::entry::value() const {
     return _value;
@@ -280,6 +314,18 @@ mutable_variant_object::set(string key, variant var) {
     return *this;
 }
 
+mutable_variant_object&
+mutable_variant_object::set(interned_key key, variant var) {
+    auto itr = find(key.str().c_str());
+    if(itr != end()) {
+        itr->set(fc::move(var));
+    }
+    else {
+        _key_value.push_back(entry(key, fc::move(var)));
+    }
+    return *this;
+}
+
 /** Appends \a key and \a var without checking for duplicates, designed to
   *  simplify construction of dictionaries using (key,val)(key2,val2) syntax
   */
@@ -289,6 +335,12 @@ mutable_variant_object::operator()(string key, variant var) {
     return *this;
 }
 
+mutable_variant_object&
+mutable_variant_object::operator()(interned_key key, variant var) {
+    _key_value.push_back(entry(key, fc::move(var)));
+    return *this;
+}
+
 mutable_variant_object&
 mutable_variant_object::operator()(const variant_object& vo) {
     for(const variant_object::entry& e : vo)
@@ -3,7 +3,10 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <fc/crypto/base58.hpp>
 #include <fc/crypto/public_key.hpp>
+#include <fc/crypto/ripemd160.hpp>
+#include <fc/crypto/sha256.hpp>
 #include <fc/crypto/private_key.hpp>
 #include <fc/crypto/signature.hpp>
 #include <fc/utility.hpp>
@@ -80,5 +83,98 @@ BOOST_AUTO_TEST_CASE(test_k1_recyle) try {
 //    BOOST_CHECK_EQUAL(std::string(pub), std::string(recycled_pub));
 // } FC_LOG_AND_RETHROW();
 
+BOOST_AUTO_TEST_CASE(test_base58) try {
+   BOOST_CHECK_EQUAL(fc::to_base58(nullptr, 0), "");
+   BOOST_CHECK_EQUAL(fc::to_base58("\0\0\x01", 3), "112");
+   BOOST_CHECK_EQUAL(fc::to_base58("hello world", 11), "StV1DL6CwTryKyV");
+   BOOST_CHECK(fc::from_base58(" StV1DL6CwTryKyV ") == std::vector<char>({ 'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd' }));
+   BOOST_CHECK(fc::from_base58("112") == std::vector<char>({ 0, 0, 1 }));
+   BOOST_CHECK_THROW(fc::from_base58("StV1DL6CwTryKyV0"), fc::parse_error_exception);
+
+   for(auto i = 0; i < 16; i++) {
+      auto key = private_key::generate<ecc::private_key_shim>();
+      auto pub = key.get_public_key();
+      // second one comes from cache
+      BOOST_CHECK_EQUAL(std::string(pub), std::string(pub));
+      BOOST_CHECK(public_key(std::string(pub)) == pub);
+   }
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(test_sha256_many) try {
+   auto msgs  = std::vector<std::string>();
+   auto data  = std::vector<const char*>();
+   auto sizes = std::vector<uint32_t>();
+   for(auto i = 0; i < 37; i++) {
+      // runs of same sizes go through lanes, others are hashed one by one
+      msgs.emplace_back(i < 16 ? 64 : i * 7, (char)i);
+   }
+   for(auto& m : msgs) {
+      data.emplace_back(m.data());
+      sizes.emplace_back(m.size());
+   }
+
+   auto out = std::vector<sha256>(msgs.size());
+   sha256::hash_many(data.data(), sizes.data(), msgs.size(), out.data());
+   for(auto i = 0u; i < msgs.size(); i++) {
+      BOOST_CHECK_EQUAL(out[i].str(), sha256::hash(msgs[i]).str());
+   }
+   BOOST_CHECK_EQUAL(sha256::hash("abc", 3).str(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(test_ripemd160) try {
+   BOOST_CHECK_EQUAL(ripemd160::hash("", 0).str(), "9c1185a5c5e9fc54612808977ee8f548b2258d31");
+   BOOST_CHECK_EQUAL(ripemd160::hash("abc", 3).str(), "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc");
+
+   // written in pieces which don't end at the boundaries of blocks
+   auto msg = std::string(1000000, 'a');
+   auto enc = ripemd160::encoder();
+   for(auto i = 0u; i < msg.size(); i += 37) {
+      enc.write(msg.data() + i, std::min<size_t>(37, msg.size() - i));
+   }
+   BOOST_CHECK_EQUAL(enc.result().str(), "52783243c1697bdbe16d37f97f68f08325dc1528");
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(test_recovery_cache) try {
+   auto key     = private_key::generate<ecc::private_key_shim>();
+   auto digest  = sha256::hash(std::string("recover"));
+   auto digest2 = sha256::hash(std::string("recover2"));
+   auto sig     = key.sign(digest);
+
+   // second recovery comes from cache
+   BOOST_CHECK(public_key(sig, digest) == key.get_public_key());
+   BOOST_CHECK(public_key(sig, digest) == key.get_public_key());
+   BOOST_CHECK(public_key(sig, digest, false) == key.get_public_key());
+
+   // the same signature of another digest is another key
+   BOOST_CHECK(public_key(sig, digest2, false) != key.get_public_key());
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(test_recover_many) try {
+   auto digest = sha256::hash(std::string("recover_many"));
+   auto privs  = std::vector<private_key>();
+   auto sigs   = std::vector<signature>();
+   for(auto i = 0; i < 5; i++) {
+      privs.emplace_back(private_key::generate<ecc::private_key_shim>());
+      sigs.emplace_back(privs.back().sign(digest));
+   }
+
+   auto keys = std::vector<public_key>(sigs.size());
+   public_key::recover_many(sigs.data(), sigs.size(), digest, keys.data());
+   for(auto i = 0u; i < sigs.size(); i++) {
+      BOOST_CHECK(keys[i] == privs[i].get_public_key());
+   }
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(test_generate_batch) try {
+   // more than one base and step
+   auto keys = private_key::generate_batch(1100);
+   BOOST_CHECK_EQUAL(keys.size(), 1100u);
+   for(auto i = 0u; i < keys.size(); i++) {
+      BOOST_CHECK(keys[i].second == keys[i].first.get_public_key());
+      if(i > 0) {
+         BOOST_CHECK(keys[i].first != keys[i - 1].first);
+      }
+   }
+} FC_LOG_AND_RETHROW();
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
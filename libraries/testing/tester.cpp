@@ -185,7 +185,7 @@ void
 base_tester::produce_min_num_of_blocks_to_spend_time_wo_inactive_prod(const fc::microseconds target_elapsed_time) {
     fc::microseconds elapsed_time;
     while(elapsed_time < target_elapsed_time) {
-        for(uint32_t i = 0; i < control->head_block_state()->active_schedule.producers.size(); i++) {
+        for(uint32_t i = 0; i < control->head_block_state()->active_schedule->producers.size(); i++) {
             const auto time_to_skip = fc::milliseconds(config::producer_repetitions * config::block_interval_ms);
             produce_block(time_to_skip);
             elapsed_time += time_to_skip;
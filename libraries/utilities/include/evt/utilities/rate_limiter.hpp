@@ -0,0 +1,36 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <boost/noncopyable.hpp>
+
+namespace evt { namespace utilities {
+
+// Token bucket limiting the bytes written per second by background jobs, like `RateLimiter` of rocksdb.
+// It can be shared by several writers, `request` blocks the calling thread until the bytes are granted.
+// Requests larger than the burst are granted at once and the following ones wait for the debt.
+class rate_limiter : boost::noncopyable {
+public:
+    using clock = std::chrono::steady_clock;
+
+public:
+    explicit rate_limiter(uint64_t bytes_per_sec);
+
+public:
+    void request(uint64_t bytes);
+
+    uint64_t bytes_per_sec() const { return rate_; }
+
+private:
+    std::mutex        mutex_;
+    uint64_t          rate_;
+    double            available_;  // negative when it's in debt
+    clock::time_point last_;
+};
+
+} } // evt::utilities
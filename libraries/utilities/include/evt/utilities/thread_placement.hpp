@@ -0,0 +1,34 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/asio/thread_pool.hpp>
+
+namespace evt { namespace utilities {
+
+// Placement of named threads onto cpus, configured once at startup before the threads are spawned.
+// Threads placed on cpus of one NUMA node also prefer the memory of that node, so the caches they fill
+// (chainbase and token database cache by main thread) are allocated locally.
+// It only takes effect on Linux, elsewhere threads are left as they are.
+
+// parses cpu list in the format of `taskset -c`, e.g. "0-3,8"
+std::vector<int> parse_cpu_list(const std::string& list);
+
+void set_thread_placement(const std::string& name, const std::vector<int>& cpus);
+
+// pins calling thread to the cpus configured for `name` if there are, and names the thread
+void place_current_thread(const std::string& name);
+
+// every thread of the pool is placed, `threads` should be the number of threads in pool
+void place_pool_threads(boost::asio::thread_pool& pool, size_t threads, const std::string& name);
+
+// backs the range with transparent huge pages, returns false if kernel refuses it
+bool advise_huge_pages(void* addr, size_t size);
+
+} } // evt::utilities
@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <evt/utilities/rate_limiter.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <fc/exception/exception.hpp>
+
+namespace evt { namespace utilities {
+
+rate_limiter::rate_limiter(uint64_t bytes_per_sec)
+    : rate_(bytes_per_sec)
+    , available_(bytes_per_sec)
+    , last_(clock::now()) {
+    FC_ASSERT(bytes_per_sec > 0, "Rate of limiter should be larger than zero");
+}
+
+void
+rate_limiter::request(uint64_t bytes) {
+    auto wait = std::chrono::duration<double>(0);
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        auto now  = clock::now();
+
+        // burst is capped to one second of the rate
+        available_ = std::min((double)rate_, available_ + std::chrono::duration<double>(now - last_).count() * rate_);
+        available_ -= bytes;
+        last_ = now;
+
+        if(available_ < 0) {
+            wait = std::chrono::duration<double>(-available_ / rate_);
+        }
+    }
+    if(wait.count() > 0) {
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+} } // evt::utilities
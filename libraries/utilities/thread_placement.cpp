@@ -0,0 +1,196 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+
+#include <evt/utilities/thread_placement.hpp>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/filesystem.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace evt { namespace utilities {
+
+namespace internal {
+
+struct placement_registry {
+public:
+    std::mutex                              mutex;
+    std::map<std::string, std::vector<int>> cpus;
+
+public:
+    static placement_registry&
+    instance() {
+        static placement_registry r;
+        return r;
+    }
+};
+
+#if defined(__linux__)
+// NUMA node of cpu read from sysfs, -1 if it's unknown
+int
+cpu_node(int cpu) {
+    namespace bfs = boost::filesystem;
+
+    auto dir = bfs::path("/sys/devices/system/cpu") / ("cpu" + std::to_string(cpu));
+    auto ec  = boost::system::error_code();
+    for(auto it = bfs::directory_iterator(dir, ec); !ec && it != bfs::directory_iterator(); it.increment(ec)) {
+        auto n = it->path().filename().string();
+        if(n.size() > 4 && n.compare(0, 4, "node") == 0 && std::all_of(n.cbegin() + 4, n.cend(), ::isdigit)) {
+            return std::stoi(n.substr(4));
+        }
+    }
+    return -1;
+}
+#endif
+
+}  // namespace internal
+
+std::vector<int>
+parse_cpu_list(const std::string& list) {
+    auto cpus  = std::set<int>();
+    auto parts = std::vector<std::string>();
+    boost::split(parts, list, boost::is_any_of(","));
+
+    for(auto& p : parts) {
+        boost::trim(p);
+        if(p.empty()) {
+            continue;
+        }
+        try {
+            auto dash = p.find('-');
+            if(dash == std::string::npos) {
+                cpus.insert(std::stoi(p));
+                continue;
+            }
+            auto begin = std::stoi(p.substr(0, dash));
+            auto end   = std::stoi(p.substr(dash + 1));
+            FC_ASSERT(begin <= end, "Invalid cpu range: ${r}", ("r",p));
+            for(auto i = begin; i <= end; i++) {
+                cpus.insert(i);
+            }
+        }
+        catch(const std::logic_error&) {
+            FC_THROW_EXCEPTION(fc::parse_error_exception, "Invalid cpu list: ${l}", ("l",list));
+        }
+    }
+    FC_ASSERT(!cpus.empty() && *cpus.begin() >= 0, "Invalid cpu list: ${l}", ("l",list));
+    return std::vector<int>(cpus.cbegin(), cpus.cend());
+}
+
+void
+set_thread_placement(const std::string& name, const std::vector<int>& cpus) {
+    auto& r    = internal::placement_registry::instance();
+    auto  lock = std::unique_lock<std::mutex>(r.mutex);
+    r.cpus[name] = cpus;
+}
+
+void
+place_current_thread(const std::string& name) {
+#if defined(__linux__)
+    // name of main thread is the one of process, leave it
+    if(name != "main") {
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+
+    auto cpus = std::vector<int>();
+    {
+        auto& r    = internal::placement_registry::instance();
+        auto  lock = std::unique_lock<std::mutex>(r.mutex);
+        auto  it   = r.cpus.find(name);
+        if(it == r.cpus.end()) {
+            return;
+        }
+        cpus = it->second;
+    }
+
+    auto set = cpu_set_t();
+    CPU_ZERO(&set);
+    for(auto c : cpus) {
+        CPU_SET(c, &set);
+    }
+    if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        wlog("Cannot pin thread ${n} to cpus: ${c}", ("n",name)("c",cpus));
+        return;
+    }
+
+    auto nodes = std::set<int>();
+    for(auto c : cpus) {
+        nodes.insert(internal::cpu_node(c));
+    }
+    if(nodes.size() == 1 && *nodes.begin() >= 0 && *nodes.begin() < 1024) {
+        auto node = *nodes.begin();
+        auto mask = std::array<unsigned long, 1024 / (8 * sizeof(unsigned long))>();
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        if(syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), 1024 + 1) != 0) {
+            wlog("Cannot prefer memory of NUMA node ${n} for thread ${t}", ("n",node)("t",name));
+        }
+        ilog("Thread ${n} is placed on cpus: ${c} of NUMA node ${d}", ("n",name)("c",cpus)("d",node));
+        return;
+    }
+    ilog("Thread ${n} is placed on cpus: ${c}", ("n",name)("c",cpus));
+#endif
+}
+
+void
+place_pool_threads(boost::asio::thread_pool& pool, size_t threads, const std::string& name) {
+    struct state {
+        std::mutex              mutex;
+        std::condition_variable cond;
+        size_t                  arrived = 0;
+    };
+    auto s = std::make_shared<state>();
+
+    // each task holds its thread until all of them arrive, so every thread takes exactly one
+    for(auto i = 0u; i < threads; i++) {
+        boost::asio::post(pool, [s, threads, name] {
+            place_current_thread(name);
+
+            auto lock = std::unique_lock<std::mutex>(s->mutex);
+            if(++s->arrived == threads) {
+                s->cond.notify_all();
+                return;
+            }
+            s->cond.wait(lock, [&] { return s->arrived == threads; });
+        });
+    }
+
+    auto lock = std::unique_lock<std::mutex>(s->mutex);
+    s->cond.wait(lock, [&] { return s->arrived == threads; });
+}
+
+bool
+advise_huge_pages(void* addr, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    auto page  = (uintptr_t)sysconf(_SC_PAGESIZE);
+    auto begin = ((uintptr_t)addr + page - 1) & ~(page - 1);
+    auto end   = ((uintptr_t)addr + size) & ~(page - 1);
+    if(end <= begin) {
+        return false;
+    }
+    return madvise((void*)begin, end - begin, MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+}
+
+} } // evt::utilities
@@ -0,0 +1,77 @@
+-- shared by the api profiles, each one sets `path` and `body(line)` and requires this
+
+local M = {}
+
+M.header = {
+    ["Content-Type"] = "application/json"
+}
+
+-- targets file has one target each line, like "domain name" for get_token
+function M.readlines(filename)
+    local file = io.open(filename, 'r')
+    if file == nil then
+        error('error while openning file: ' .. filename)
+    end
+    local lines = {}
+    for line in file:lines() do
+        if #line > 0 and line:sub(1, 1) ~= '#' then
+            table.insert(lines, line)
+        end
+    end
+    file:close()
+    if #lines == 0 then
+        error('no targets in file: ' .. filename)
+    end
+    return lines
+end
+
+function M.split(line)
+    local fields = {}
+    for f in line:gmatch("%S+") do
+        table.insert(fields, f)
+    end
+    return fields
+end
+
+-- prints one json line prefixed by RESULT, parsed by api_bench.py
+function M.report(name, summary, latency)
+    local secs = summary.duration / 1000000
+    local errors = summary.errors
+    local fmt = 'RESULT {"endpoint":"%s","requests":%d,"duration_us":%d,"rps":%.1f,"bytes":%d,' ..
+                '"errors":{"connect":%d,"read":%d,"write":%d,"status":%d,"timeout":%d},' ..
+                '"latency_us":{"mean":%.1f,"stdev":%.1f,"p50":%d,"p90":%d,"p99":%d,"p999":%d,"max":%d}}'
+    print(fmt:format(name, summary.requests, summary.duration, summary.requests / secs, summary.bytes,
+                     errors.connect, errors.read, errors.write, errors.status, errors.timeout,
+                     latency.mean, latency.stdev, latency:percentile(50), latency:percentile(90),
+                     latency:percentile(99), latency:percentile(99.9), latency.max))
+end
+
+-- installs the wrk callbacks of a read profile: a random target is picked for each request
+function M.read_profile(name, path, body)
+    local counter = 0
+
+    setup = function(thread)
+        counter = counter + 1
+        thread:set("id", counter)
+    end
+
+    init = function(args)
+        if args[1] == nil then
+            targets = { "" }
+        else
+            targets = M.readlines(args[1])
+        end
+        math.randomseed(os.time() + id)
+    end
+
+    request = function()
+        local line = targets[math.random(#targets)]
+        return wrk.format("POST", path, M.header, body(M.split(line)))
+    end
+
+    done = function(summary, latency, requests)
+        M.report(name, summary, latency)
+    end
+end
+
+return M
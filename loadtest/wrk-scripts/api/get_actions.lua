@@ -0,0 +1,15 @@
+-- /v1/history/get_actions
+-- usage: wrk -s get_actions.lua <url> -- [targets file]
+-- targets: "<domain> [key]" each line, latest 10 actions are taken, node needs history_plugin
+
+local dir = debug.getinfo(1, "S").source:match("^@(.*/)") or "./"
+package.path = dir .. "?.lua;" .. package.path
+
+local common = require("common")
+
+common.read_profile("get_actions", "/v1/history/get_actions", function(f)
+    if f[2] == nil then
+        return ('{"domain":"%s","take":10}'):format(f[1])
+    end
+    return ('{"domain":"%s","key":"%s","take":10}'):format(f[1], f[2])
+end)
@@ -0,0 +1,15 @@
+-- /v1/evt/get_fungible_balance
+-- usage: wrk -s get_fungible_balance.lua <url> -- [targets file]
+-- targets: "<address> [sym_id]" each line, all the balances are returned without sym_id
+
+local dir = debug.getinfo(1, "S").source:match("^@(.*/)") or "./"
+package.path = dir .. "?.lua;" .. package.path
+
+local common = require("common")
+
+common.read_profile("get_fungible_balance", "/v1/evt/get_fungible_balance", function(f)
+    if f[2] == nil then
+        return ('{"address":"%s"}'):format(f[1])
+    end
+    return ('{"address":"%s","sym_id":%s}'):format(f[1], f[2])
+end)
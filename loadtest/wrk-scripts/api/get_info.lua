@@ -0,0 +1,12 @@
+-- /v1/chain/get_info
+-- usage: wrk -s get_info.lua <url> -- [targets file]
+-- no targets needed
+
+local dir = debug.getinfo(1, "S").source:match("^@(.*/)") or "./"
+package.path = dir .. "?.lua;" .. package.path
+
+local common = require("common")
+
+common.read_profile("get_info", "/v1/chain/get_info", function(f)
+    return ""
+end)
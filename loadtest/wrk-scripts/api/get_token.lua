@@ -0,0 +1,12 @@
+-- /v1/evt/get_token
+-- usage: wrk -s get_token.lua <url> -- [targets file]
+-- targets: "<domain> <name>" each line
+
+local dir = debug.getinfo(1, "S").source:match("^@(.*/)") or "./"
+package.path = dir .. "?.lua;" .. package.path
+
+local common = require("common")
+
+common.read_profile("get_token", "/v1/evt/get_token", function(f)
+    return ('{"domain":"%s","name":"%s"}'):format(f[1], f[2])
+end)
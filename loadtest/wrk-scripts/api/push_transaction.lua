@@ -0,0 +1,17 @@
+-- /v1/chain/push_transaction
+-- usage: wrk -s push_transaction.lua <url> -- <traffic folder> <region> [region ...]
+-- pushes the lz4 traffic data generated by loadtest/trafficgen, same as loadtest.lua, one region per thread
+-- trxs should be generated against the same snapshot the node is started from
+
+local dir = debug.getinfo(1, "S").source:match("^@(.*/)") or "./"
+package.path = dir .. "?.lua;" .. package.path
+
+local common = require("common")
+dofile(dir .. "../loadtest.lua")
+
+local loadtest_done = done
+
+done = function(summary, latency, requests)
+    loadtest_done(summary, latency, requests)
+    common.report("push_transaction", summary, latency)
+end
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+
+import json
+import os
+import subprocess
+import time
+
+import click
+import requests
+
+"""
+Runs the wrk profiles in api/ one by one against a node and writes the latency and throughput of each endpoint.
+Node can be started from a pinned snapshot by this script so that results of different runs are comparable.
+"""
+
+read_profiles = ['get_info', 'get_token', 'get_fungible_balance', 'get_actions']
+all_profiles = read_profiles + ['push_transaction']
+
+
+def green(text):
+    return click.style(text, fg='green')
+
+
+def start_node(evtd, snapshot, data_dir, http, extra):
+    if os.path.exists(data_dir):
+        subprocess.run(['rm', '-rf', data_dir], check=True)
+    os.makedirs(data_dir)
+
+    args = [evtd,
+            '--data-dir={}'.format(data_dir),
+            '--snapshot={}'.format(snapshot),
+            '--http-server-address={}'.format(http),
+            '--http-validate-host=false',
+            '--plugin=evt::chain_api_plugin',
+            '--plugin=evt::evt_api_plugin'] + list(extra)
+    log = open(os.path.join(data_dir, 'evtd.log'), 'w')
+    click.echo('Starting evtd from snapshot: {}'.format(green(snapshot)))
+    return subprocess.Popen(args, stdout=log, stderr=subprocess.STDOUT)
+
+
+def wait_ready(url, timeout=600):
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        try:
+            requests.get('{}/v1/chain/get_info'.format(url), timeout=1)
+            return
+        except requests.exceptions.RequestException:
+            time.sleep(1)
+    raise click.ClickException('Node is not ready in {} secs'.format(timeout))
+
+
+def run_wrk(profile, url, threads, connections, duration, args):
+    script = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'api', '{}.lua'.format(profile))
+    cmd = ['wrk', '-t{}'.format(threads), '-c{}'.format(connections), '-d{}s'.format(duration),
+           '--latency', '-s', script, url]
+    if len(args) > 0:
+        cmd += ['--'] + args
+
+    click.echo('Running {}'.format(green(profile)))
+    out = subprocess.run(cmd, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    for line in out.splitlines():
+        if line.startswith('RESULT '):
+            return json.loads(line[len('RESULT '):])
+    raise click.ClickException('No result of {} is found in output of wrk'.format(profile))
+
+
+@click.command()
+@click.option('--url', '-u', default='http://127.0.0.1:8888')
+@click.option('--evtd', type=click.Path(exists=True), help='Starts evtd from snapshot if provided, otherwise node at url is used')
+@click.option('--snapshot', type=click.Path(exists=True), help='Pinned snapshot the node is started from')
+@click.option('--data-dir', default='/tmp/evt_api_bench')
+@click.option('--evtd-arg', multiple=True, help='Extra args of evtd, like the ones of history_plugin for get_actions')
+@click.option('--profile', '-p', type=click.Choice(all_profiles), multiple=True, help='Profiles to run, all the read ones by default')
+@click.option('--targets', type=click.Path(exists=True), help='Folder of targets files, named like get_token.txt')
+@click.option('--traffic', type=click.Path(exists=True), help='Folder of traffic data for push_transaction')
+@click.option('--regions', default='', help='Regions of traffic data separated by comma, one for each wrk thread')
+@click.option('--threads', '-t', default=4)
+@click.option('--connections', '-c', default=64)
+@click.option('--duration', '-d', default=30, help='Seconds for each profile')
+@click.option('--output', '-o', type=click.Path(), default='api_bench.json')
+def bench(url, evtd, snapshot, data_dir, evtd_arg, profile, targets, traffic, regions, threads, connections, duration, output):
+    profiles = list(profile) if len(profile) > 0 else read_profiles
+
+    node = None
+    if evtd is not None:
+        if snapshot is None:
+            raise click.BadParameter('--snapshot is required when --evtd is provided')
+        http = url.split('://')[-1]
+        node = start_node(evtd, snapshot, data_dir, http, evtd_arg)
+
+    try:
+        wait_ready(url)
+        info = requests.get('{}/v1/chain/get_info'.format(url)).json()
+
+        results = []
+        for p in profiles:
+            args = []
+            if p == 'push_transaction':
+                if traffic is None or regions == '':
+                    raise click.BadParameter('--traffic and --regions are required by push_transaction')
+                args = [traffic] + regions.split(',')
+                t = len(args) - 1
+            else:
+                t = threads
+                if p != 'get_info':
+                    if targets is None:
+                        raise click.BadParameter('--targets is required by {}'.format(p))
+                    args = [os.path.join(targets, '{}.txt'.format(p))]
+            r = run_wrk(p, url, t, connections, duration, args)
+            results.append(r)
+            click.echo('  {:.1f} req/s, p50 {} us, p99 {} us, {} non-2xx'.format(
+                r['rps'], r['latency_us']['p50'], r['latency_us']['p99'], r['errors']['status']))
+
+        report = {
+            'url': url,
+            'snapshot': snapshot,
+            'head_block_num': info['head_block_num'],
+            'server_version': info.get('server_version_string', ''),
+            'threads': threads,
+            'connections': connections,
+            'duration_secs': duration,
+            'endpoints': results
+        }
+        with open(output, 'w') as f:
+            json.dump(report, f, indent=2)
+        click.echo('Report is written into {}'.format(green(output)))
+    finally:
+        if node is not None:
+            node.terminate()
+            node.wait()
+
+
+if __name__ == '__main__':
+    bench()
@@ -0,0 +1,269 @@
+import datetime
+import json
+import subprocess
+import time
+
+import click
+import docker
+import requests
+
+import launch_nodes
+
+"""
+Benchmark of a cluster made of producers and relays in docker, simulated latency is added by pumba.
+Load is driven by trafficgen_plugin on one node and following are reported:
+  - block propagation latency, from the first node having the block to each of the others
+  - tps sustained to the last irreversible block
+  - fork rate, blocks of which more than one id are seen as head
+  - cpu of each node
+Nodes are polled by get_info every poll_ms, so latencies are measured at that resolution.
+"""
+
+genesis_pub = 'EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV'
+genesis_priv = '5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3'
+
+
+def is_producer(i, paras):
+    return i < paras['producer_number']
+
+
+# producers are fully connected to each other, each relay connects to two producers and the relay before
+def peers_of(i, paras):
+    p = paras['producer_number']
+    if(is_producer(i, paras)):
+        return [j for j in range(p) if j != i]
+    r = i - p
+    peers = [r % p, (r + 1) % p]
+    if(r > 0):
+        peers.append(i - 1)
+    return list(set(peers))
+
+
+def node_command(i, paras):
+    cmd = launch_nodes.command('evtd.sh')
+    cmd.add_option('--delete-all-blocks')
+    cmd.add_option('--http-validate-host=false')
+    cmd.add_option('--charge-free-mode')
+    cmd.add_option('--plugin=evt::chain_api_plugin')
+    cmd.add_option('--http-server-address=evtd_{}:{}'.format(i, 8888+i))
+
+    if(paras['net'] == 'bnet'):
+        cmd.add_option('--plugin=evt::bnet_plugin')
+        cmd.add_option('--bnet-endpoint=evtd_{}:{}'.format(i, 4321+i))
+        for j in peers_of(i, paras):
+            cmd.add_option('--bnet-connect=evtd_{}:{}'.format(j, 4321+j))
+    else:
+        cmd.add_option('--p2p-listen-endpoint=evtd_{}:{}'.format(i, 9876+i))
+        for j in peers_of(i, paras):
+            cmd.add_option('--p2p-peer-address=evtd_{}:{}'.format(j, 9876+j))
+
+    if(is_producer(i, paras)):
+        cmd.add_option('--enable-stale-production')
+        cmd.add_option('--producer-name={}'.format('evt' if i == 0 else 'evt{}'.format(i)))
+        cmd.add_option('--signature-provider=EVT7vuvMYQwm6WYLoopw6DqhBumM4hC7RA5ufK8WSqU7VQyfmoLwA=KEY:5KZ2HeogGk12U2WwU7djVrfcSami4BRtMyNYA7frfcAnhyAGzKM')
+
+    if(i == paras['traffic_node']):
+        cmd.add_option('--plugin=evt::trafficgen_plugin')
+        cmd.add_option('--traffic-start-num={}'.format(paras['traffic_start_num']))
+        cmd.add_option('--traffic-total={}'.format(paras['traffic_total']))
+        cmd.add_option('--traffic-type={}'.format(paras['traffic_type']))
+        cmd.add_option('--traffic-tps={}'.format(paras['traffic_tps']))
+        cmd.add_option('--traffic-threads={}'.format(paras['traffic_threads']))
+        cmd.add_option('--traffic-from={}'.format(genesis_pub))
+        cmd.add_option('--traffic-from-priv={}'.format(genesis_priv))
+    return cmd
+
+
+def start_nodes(client, paras):
+    try:
+        client.networks.get('evt-net')
+    except docker.errors.NotFound:
+        client.networks.create('evt-net', driver='bridge')
+
+    containers = []
+    for i in range(paras['nodes_number']):
+        cmd = node_command(i, paras)
+        click.echo('start evtd_{} as {}'.format(i, 'producer' if is_producer(i, paras) else 'relay'))
+        container = client.containers.run(image='everitoken/evt:latest',
+                                          name='evtd_{}'.format(i),
+                                          command=cmd.get_arguments(),
+                                          network='evt-net',
+                                          ports={'{}/tcp'.format(8888+i): paras['evtd_port_http']+i},
+                                          detach=True,
+                                          tmpfs={'/opt/evtd/data': 'size='+str(paras['tmpfs_size'])+'M'})
+        containers.append(container)
+    return containers
+
+
+def add_latency(paras):
+    if(paras['latency_ms'] == 0):
+        return []
+    subps = []
+    duration = paras['warmup_secs'] + paras['duration_secs'] + 60
+    for i in range(paras['nodes_number']):
+        cmd = ['pumba', 'netem', '--tc-image', 'gaiadocker/iproute2', '--duration', '{}s'.format(duration),
+               'delay', '--time', str(paras['latency_ms']), '--jitter', str(paras['jitter_ms']), 'evtd_{}'.format(i)]
+        subps.append(subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, shell=False))
+    return subps
+
+
+def url_of(i, paras):
+    return 'http://127.0.0.1:{}'.format(paras['evtd_port_http']+i)
+
+
+def get_info(i, paras):
+    return requests.get('{}/v1/chain/get_info'.format(url_of(i, paras)), timeout=1).json()
+
+
+def get_block(i, num, paras):
+    return requests.post('{}/v1/chain/get_block'.format(url_of(i, paras)), json={'block_num_or_id': num}, timeout=5).json()
+
+
+def block_time(block):
+    ts = block['timestamp']
+    fmt = '%Y-%m-%dT%H:%M:%S.%f' if '.' in ts else '%Y-%m-%dT%H:%M:%S'
+    return datetime.datetime.strptime(ts, fmt).replace(tzinfo=datetime.timezone.utc).timestamp()
+
+
+def cpu_usage(containers):
+    return [c.stats(stream=False)['cpu_stats']['cpu_usage']['total_usage'] for c in containers]
+
+
+def wait_ready(paras):
+    for i in range(paras['nodes_number']):
+        while(True):
+            try:
+                get_info(i, paras)
+                break
+            except requests.exceptions.RequestException:
+                time.sleep(1)
+
+
+class sampler():
+    """polls heads of all the nodes, records when each node first has each block"""
+
+    def __init__(self, paras):
+        self.paras = paras
+        self.seen = [{} for i in range(paras['nodes_number'])]  # block num -> first time
+        self.ids = {}                                             # block num -> ids seen as head
+        self.heads = [0] * paras['nodes_number']
+
+    def poll(self):
+        now = time.time()
+        for i in range(self.paras['nodes_number']):
+            try:
+                info = get_info(i, self.paras)
+            except requests.exceptions.RequestException:
+                continue
+            head = info['head_block_num']
+            self.ids.setdefault(head, set()).add(info['head_block_id'])
+            # blocks skipped between two polls are taken as arrived with the head
+            for num in range(self.heads[i] + 1, head + 1):
+                self.seen[i].setdefault(num, now)
+            self.heads[i] = max(self.heads[i], head)
+
+    def propagation(self, begin, end):
+        lats = []
+        for num in range(begin, end + 1):
+            times = [s[num] for s in self.seen if num in s]
+            if(len(times) < 2):
+                continue
+            first = min(times)
+            lats.extend([(t - first) * 1000 for t in times if t != first])
+        return lats
+
+
+def percentiles(values):
+    if(len(values) == 0):
+        return {}
+    values = sorted(values)
+    def at(p):
+        return round(values[min(len(values) - 1, int(len(values) * p))], 1)
+    return {'count': len(values), 'p50': at(0.5), 'p90': at(0.9), 'p99': at(0.99), 'max': round(values[-1], 1)}
+
+
+def lib_tps(lib0, lib1, paras):
+    trxs = 0
+    for num in range(lib0 + 1, lib1 + 1):
+        trxs += len(get_block(0, num, paras)['transactions'])
+    secs = block_time(get_block(0, lib1, paras)) - block_time(get_block(0, lib0, paras))
+    return trxs, (trxs / secs if secs > 0 else 0)
+
+
+@click.command()
+@click.option('--config', help='the config of benchmark', default='bench.config')
+@click.option('--net', type=click.Choice(['net', 'bnet']), help='overrides the net plugin in config')
+@click.option('--keep/--no-keep', default=False, help='keep the nodes after benchmark')
+def bench(config, net, keep):
+    with open(config, 'r') as f:
+        paras = json.load(f)
+    if(net is not None):
+        paras['net'] = net
+    paras['nodes_number'] = paras['producer_number'] + paras['relay_number']
+    if(paras['traffic_node'] >= paras['nodes_number']):
+        raise click.BadParameter('traffic_node should be less than {}'.format(paras['nodes_number']))
+
+    # traffic starts after the producers schedule is updated and warmup
+    blocks_warmup = paras['warmup_secs'] * 2
+    paras['traffic_start_num'] = blocks_warmup
+
+    client = docker.from_env()
+    launch_nodes.free_container('evtd_', client)
+    containers = start_nodes(client, paras)
+    subps = []
+    try:
+        wait_ready(paras)
+        launch_nodes.update_producers(url_of(0, paras), paras['producer_number'])
+        subps = add_latency(paras)
+
+        s = sampler(paras)
+        while(s.heads[0] < blocks_warmup):
+            s.poll()
+            time.sleep(paras['poll_ms'] / 1000)
+
+        click.echo('warmup is done, benchmarking for {} secs'.format(paras['duration_secs']))
+        lib0 = get_info(0, paras)['last_irreversible_block_num']
+        head0 = max(s.heads)
+        cpu0, t0 = cpu_usage(containers), time.time()
+
+        end = time.time() + paras['duration_secs']
+        while(time.time() < end):
+            s.poll()
+            time.sleep(paras['poll_ms'] / 1000)
+
+        cpu1, t1 = cpu_usage(containers), time.time()
+        lib1 = get_info(0, paras)['last_irreversible_block_num']
+        head1 = min(s.heads)
+
+        trxs, tps = lib_tps(lib0, lib1, paras)
+        nums = [n for n in s.ids if head0 < n <= head1]
+        forks = [n for n in nums if len(s.ids[n]) > 1]
+
+        result = {
+            'net': paras['net'],
+            'producers': paras['producer_number'],
+            'relays': paras['relay_number'],
+            'latency_ms': paras['latency_ms'],
+            'jitter_ms': paras['jitter_ms'],
+            'traffic_tps': paras['traffic_tps'],
+            'blocks': head1 - head0,
+            'irreversible_blocks': lib1 - lib0,
+            'irreversible_trxs': trxs,
+            'lib_tps': round(tps, 1),
+            'propagation_ms': percentiles(s.propagation(head0 + 1, head1)),
+            'fork_rate': round(len(forks) / len(nums), 4) if len(nums) > 0 else 0,
+            'cpu_percent': {'evtd_{}'.format(i): round((cpu1[i] - cpu0[i]) / ((t1 - t0) * 1e9) * 100, 1)
+                            for i in range(paras['nodes_number'])}
+        }
+        click.echo(json.dumps(result, indent=2))
+        with open(paras['output'], 'w') as f:
+            json.dump(result, f, indent=2)
+    finally:
+        for p in subps:
+            p.kill()
+        if(not keep):
+            launch_nodes.free_container('evtd_', client)
+
+
+if __name__ == '__main__':
+    bench()
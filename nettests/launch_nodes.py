@@ -171,9 +171,11 @@ def create(config):
                                                   '/opt/evtd/data': 'size='+str(tmpfs_size)+'M'}
                                               #
                                               )
-    # update producers
-    # producers_json = json.dumps(paras['producers_config'])
-    url = 'http://127.0.0.1:8888'
+    update_producers('http://127.0.0.1:8888', producer_number)
+
+
+# update the producers schedule to evt, evt1 ... by the genesis key
+def update_producers(url, producer_number):
     priv_evt = ecc.PrivateKey.from_string(
             '5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3')
     pub_evt = ecc.PublicKey.from_string(
@@ -203,6 +205,7 @@ def create(config):
     trx.add_sign(priv_evt)
     Api.push_transaction(trx.dumps())
 
+
 # format with the click
 @click.command()
 @click.option('--config', help='the config of nodes', default='launch.config')
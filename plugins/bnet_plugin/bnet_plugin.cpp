@@ -53,6 +53,10 @@
 
 #include <fc/io/json.hpp>
 
+#include <array>
+#include <atomic>
+#include <mutex>
+
 #include <boost/asio.hpp>
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/ip/host_name.hpp>
@@ -187,6 +191,45 @@ using namespace chain::plugin_interface;
 
 class bnet_plugin_impl;
 
+// upper bounds of the buckets of write latency, in milliseconds
+constexpr auto write_latency_buckets = std::array<uint32_t, 7>{1, 5, 10, 50, 100, 500, 1000};
+
+constexpr auto def_max_queued_trxs = 10000;
+
+/**
+ *  Counters of one session, they are updated on the strand of session and read on
+ *  app thread when the status of sessions is queried.
+ */
+struct session_stats {
+    std::atomic<uint32_t> queued_trxs{0};
+    std::atomic<uint64_t> dropped_trxs{0};
+    std::atomic<uint64_t> sent_messages{0};
+    std::atomic<uint64_t> sent_bytes{0};
+    std::atomic<uint32_t> max_write_latency_us{0};
+
+    std::array<std::atomic<uint64_t>, write_latency_buckets.size() + 1> write_latency{};
+
+    std::mutex      mutex;  // guards the peer info below, set once hello is received
+    string          remote;
+    public_key_type remote_peer_id;
+
+    void
+    add_write(uint64_t bytes, const fc::microseconds& latency) {
+        sent_messages++;
+        sent_bytes += bytes;
+
+        auto us = (uint32_t)std::max<int64_t>(latency.count(), 0);
+        auto i  = 0u;
+        while(i < write_latency_buckets.size() && us >= write_latency_buckets[i] * 1000) {
+            i++;
+        }
+        write_latency[i]++;
+        if(us > max_write_latency_us) {
+            max_write_latency_us = us;
+        }
+    }
+};
+
 template <typename Strand>
 void
 verify_strand_in_this_thread(const Strand& strand, const char* func, int line) {
@@ -294,7 +337,11 @@ public:
     string _remote_host;
     string _remote_port;
 
-    vector<char> _out_buffer;
+    vector<char>   _out_buffer;
+    fc::time_point _write_start;
+    session_stats  _stats;
+    uint32_t       _unsent_trxs     = 0;  // entries of _transaction_status not known by peer
+    uint32_t       _max_queued_trxs = def_max_queued_trxs;
     //boost::beast::multi_buffer                                  _in_buffer;
     boost::beast::flat_buffer    _in_buffer;
     flat_set<block_id_type>      _block_header_notices;
@@ -448,16 +495,38 @@ public:
             return;
         }
 
+        if(_unsent_trxs >= _max_queued_trxs) {
+            // peer is slow, the transaction reaches it in block instead
+            _stats.dropped_trxs++;
+            return;
+        }
+
         transaction_status stat;
         stat.received = fc::time_point::now();
         stat.expired  = stat.received + fc::seconds(5);
         stat.id       = t->id;
         stat.trx      = t;
         _transaction_status.insert(stat);
+        update_unsent_trxs(1);
 
         maybe_send_next_message();
     }
 
+    void
+    update_unsent_trxs(int delta) {
+        _unsent_trxs += delta;
+        _stats.queued_trxs = _unsent_trxs;
+    }
+
+    template <typename Index, typename Iterator>
+    void
+    erase_trx_status(Index& idx, Iterator itr) {
+        if(!itr->known_by_peer()) {
+            update_unsent_trxs(-1);
+        }
+        idx.erase(itr);
+    }
+
     /**
          * Remove all transactions that expired from cache prior to now
          */
@@ -467,7 +536,7 @@ public:
         auto  itr = idx.begin();
         auto  now = fc::time_point::now();
         while(itr != idx.end() && itr->expired < now) {
-            idx.erase(itr);
+            erase_trx_status(idx, itr);
             itr = idx.begin();
         }
     }
@@ -563,7 +632,7 @@ public:
             const auto& tid = receipt.trx.id();
             auto itr = _transaction_status.find(tid);
             if(itr != _transaction_status.end()) {
-                _transaction_status.erase(itr);
+                erase_trx_status(_transaction_status, itr);
             }
         }
 
@@ -652,7 +721,8 @@ public:
         try {
             verify_strand_in_this_thread(_strand, __func__, __LINE__);
 
-            _state = sending_state;
+            _state       = sending_state;
+            _write_start = fc::time_point::now();
             _ws->async_write(boost::asio::buffer(_out_buffer),
                              boost::asio::bind_executor(
                                  _strand,
@@ -798,7 +868,7 @@ public:
         auto& idx = _transaction_status.get<by_expired>();
         auto  itr = idx.begin();
         while(itr != idx.end() && itr->expired < fc::time_point::now()) {
-            idx.erase(itr);
+            erase_trx_status(idx, itr);
             itr = idx.begin();
         }
     }
@@ -819,6 +889,7 @@ public:
             idx.modify(start, [&](auto& stat) {
                 stat.mark_known_by_peer();
             });
+            update_unsent_trxs(-1);
 
             // wlog("sending trx ${id}", ("id",start->id) );
             send(ptrx_ptr);
@@ -1093,6 +1164,9 @@ public:
     mark_transaction_known_by_peer(const transaction_id_type& id) {
         auto itr = _transaction_status.find(id);
         if(itr != _transaction_status.end()) {
+            if(!itr->known_by_peer()) {
+                update_unsent_trxs(-1);
+            }
             _transaction_status.modify(itr, [&](auto& stat) {
                 stat.mark_known_by_peer();
             });
@@ -1112,12 +1186,12 @@ public:
 
     void
     on_write(boost::system::error_code ec, std::size_t bytes_transferred) {
-        boost::ignore_unused(bytes_transferred);
         verify_strand_in_this_thread(_strand, __func__, __LINE__);
         if(ec) {
             _ws->next_layer().close();
             return on_fail(ec, "write");
         }
+        _stats.add_write(bytes_transferred, fc::time_point::now() - _write_start);
         _state = idle_state;
         _out_buffer.resize(0);
         maybe_send_next_message();
@@ -1218,6 +1292,7 @@ public:
     uint16_t _bnet_endpoint_port = 4321;
     bool     _request_trx = true;
     bool     _follow_irreversible = false;
+    uint32_t _max_queued_trxs     = def_max_queued_trxs;
 
     std::vector<std::string> _connect_to_peers; /// list of peers to connect to
     std::vector<std::thread> _socket_threads;
@@ -1328,8 +1403,9 @@ public:
             if(!found) {
                 wlog("attempt to connect to ${p}", ("p", peer));
                 auto s             = std::make_shared<session>(*_ioc, shared_from_this());
-                s->_local_peer_id  = _peer_id;
-                _sessions[s.get()] = s;
+                s->_local_peer_id   = _peer_id;
+                s->_max_queued_trxs = _max_queued_trxs;
+                _sessions[s.get()]  = s;
                 s->run(peer);
             }
         }
@@ -1370,7 +1446,8 @@ listener::on_accept(boost::system::error_code ec) {
     }
     if(newsession) {
         _net_plugin->async_add_session(newsession);
-        newsession->_local_peer_id = _net_plugin->_peer_id;
+        newsession->_local_peer_id   = _net_plugin->_peer_id;
+        newsession->_max_queued_trxs = _net_plugin->_max_queued_trxs;
         newsession->run();
     }
     do_accept();
@@ -1391,6 +1468,7 @@ bnet_plugin::set_program_options(options_description& cli, options_description&
         ("bnet-threads", bpo::value<uint32_t>(), "the number of threads to use to process network messages")
         ("bnet-connect", bpo::value<vector<string>>()->composing(), "remote endpoint of other node to connect to; Use multiple bnet-connect options as needed to compose a network")
         ("bnet-no-trx", bpo::bool_switch()->default_value(false), "this peer will request no pending transactions from other nodes")
+        ("bnet-max-queued-trxs", bpo::value<uint32_t>()->default_value(def_max_queued_trxs), "the maximum number of transactions queued for one peer, more are only sent in blocks if peer is slow")
         ("bnet-peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
             "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
             "Available Variables:\n"
@@ -1430,10 +1508,13 @@ bnet_plugin::plugin_initialize(const variables_map& options) {
         }
         if(options.count("bnet-threads")) {
             my->_num_threads = options.at("bnet-threads").as<uint32_t>();
+            EVT_ASSERT(my->_num_threads > 0, plugin_config_exception, "bnet-threads must be greater than 0");
             if(my->_num_threads > 8)
                 my->_num_threads = 8;
         }
-        my->_request_trx = !options.at("bnet-no-trx").as<bool>();
+        my->_request_trx     = !options.at("bnet-no-trx").as<bool>();
+        my->_max_queued_trxs = options.at("bnet-max-queued-trxs").as<uint32_t>();
+        EVT_ASSERT(my->_max_queued_trxs > 0, plugin_config_exception, "bnet-max-queued-trxs must be greater than 0");
     }
     FC_LOG_AND_RETHROW();
 }
@@ -1492,6 +1573,7 @@ bnet_plugin::plugin_startup() {
     for(const auto& peer : my->_connect_to_peers) {
         auto s                 = std::make_shared<session>(ioc, my);
         s->_local_peer_id      = my->_peer_id;
+        s->_max_queued_trxs    = my->_max_queued_trxs;
         my->_sessions[s.get()] = s;
         s->run(peer);
     }
@@ -1529,6 +1611,36 @@ bnet_plugin::plugin_shutdown() {
     // lifetime of _ioc is guarded by shared_ptr of bnet_plugin_impl
 }
 
+vector<bnet_session_status>
+bnet_plugin::sessions() const {
+    verify_strand_in_this_thread(app().get_io_service().get_executor(), __func__, __LINE__);
+
+    auto result = vector<bnet_session_status>();
+    for(const auto& item : my->_sessions) {
+        auto ses = item.second.lock();
+        if(!ses) {
+            continue;
+        }
+        auto& stats = ses->_stats;
+        auto  st    = bnet_session_status();
+        {
+            std::lock_guard<std::mutex> lock(stats.mutex);
+            st.peer           = stats.remote;
+            st.remote_peer_id = stats.remote_peer_id;
+        }
+        st.queued_trxs          = stats.queued_trxs;
+        st.dropped_trxs         = stats.dropped_trxs;
+        st.sent_messages        = stats.sent_messages;
+        st.sent_bytes           = stats.sent_bytes;
+        st.max_write_latency_us = stats.max_write_latency_us;
+        for(auto& n : stats.write_latency) {
+            st.write_latency_ms.emplace_back(n);
+        }
+        result.emplace_back(std::move(st));
+    }
+    return result;
+}
+
 void
 bnet_plugin::handle_sighup() {
     if(fc::get_logger_map().find(logger_name) != fc::get_logger_map().end()) {
@@ -1627,6 +1739,15 @@ session::on(const hello& hi, fc::datastream<const char*>& ds) {
     _remote_peer_id        = hi.peer_id;
     _remote_lib            = hi.last_irr_block_num;
 
+    {
+        auto ec  = boost::system::error_code();
+        auto rep = _ws->lowest_layer().remote_endpoint(ec);
+
+        std::lock_guard<std::mutex> lock(_stats.mutex);
+        _stats.remote         = !_peer.empty() ? _peer : (ec ? "<unknown>" : rep.address().to_string() + ":" + std::to_string(rep.port()));
+        _stats.remote_peer_id = _remote_peer_id;
+    }
+
     for(const auto& id : hi.pending_block_ids) {
         mark_block_status(id, true, false);
     }
@@ -21,6 +21,21 @@ using std::optional;
 using chain::name;
 using chain::uint128_t;
 using chain::transaction_id_type;
+using chain::public_key_type;
+using std::string;
+using std::vector;
+
+struct bnet_session_status {
+    string          peer;  // configured endpoint if connected to, remote endpoint otherwise
+    public_key_type remote_peer_id;
+    uint32_t        queued_trxs   = 0;  // accepted transactions not sent to peer yet
+    uint64_t        dropped_trxs  = 0;  // not queued since the queue was full
+    uint64_t        sent_messages = 0;
+    uint64_t        sent_bytes    = 0;
+    // counts of writes taking less than 1, 5, 10, 50, 100, 500, 1000 ms and the ones taking longer
+    vector<uint64_t> write_latency_ms;
+    uint32_t         max_write_latency_us = 0;
+};
 
 typedef shared_ptr<class bnet_plugin_impl>       bnet_ptr;
 typedef shared_ptr<const class bnet_plugin_impl> bnet_const_ptr;
@@ -39,8 +54,12 @@ public:
     void plugin_shutdown();
     void handle_sighup() override;
 
+    vector<bnet_session_status> sessions() const;
+
 private:
     bnet_ptr my;
 };
 
 }  // namespace evt
+
+FC_REFLECT(evt::bnet_session_status, (peer)(remote_peer_id)(queued_trxs)(dropped_trxs)(sent_messages)(sent_bytes)(write_latency_ms)(max_write_latency_us))
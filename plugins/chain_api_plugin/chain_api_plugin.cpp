@@ -92,10 +92,77 @@ get_json<std::string>(const std::string& value) {
             }                                                                                                       \
     }
 
+// results of irreversible blocks never change, they're cached by http_plugin if its cache is enabled
+#define CALL_IRREVERSIBLE(api_name, api_handle, api_namespace, call_name, http_response_code)                                \
+    {                                                                                                                        \
+        std::string("/v1/" #api_name "/" #call_name),                                                                        \
+            [api_handle, &http = _http_plugin, &db = my->db](string url, string body, url_response_callback cb) mutable {    \
+                try {                                                                                                        \
+                    if(body.empty()) {                                                                                       \
+                        body = "{}";                                                                                         \
+                    }                                                                                                        \
+                    auto result = api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name##_params>()); \
+                    auto json   = fc::json::to_string(result);                                                               \
+                    if(result["block_num"].as_uint64() <= db.last_irreversible_block_num()) {                                \
+                        http.cache_response(url, body, json);                                                                \
+                    }                                                                                                        \
+                    cb(http_response_code, std::move(json));                                                                 \
+                }                                                                                                            \
+                catch(...) {                                                                                                 \
+                    http_plugin::handle_exception(#api_name, #call_name, body, cb);                                          \
+                }                                                                                                            \
+            }                                                                                                                \
+    }
+
+// takes the same params as `call_name` and responds with the packed result of `call_name##_packed`
+#define CALL_PACKED(api_name, api_handle, api_namespace, call_name)                                                          \
+    {                                                                                                                        \
+        std::string("/v1/" #api_name "/" #call_name),                                                                        \
+            [api_handle](string, string body, url_response_callback cb) mutable {                                            \
+                try {                                                                                                        \
+                    if(body.empty()) {                                                                                       \
+                        body = "{}";                                                                                         \
+                    }                                                                                                        \
+                    auto result = api_handle.call_name##_packed(fc::json::from_string(body).as<api_namespace::call_name##_params>()); \
+                    cb(200, std::move(result));                                                                              \
+                }                                                                                                            \
+                catch(...) {                                                                                                 \
+                    http_plugin::handle_exception(#api_name, #call_name, body, cb);                                          \
+                }                                                                                                            \
+            }                                                                                                                \
+    }
+
+// passes the request body to the api without parsing it into variant first
+#define CALL_ASYNC_JSON(api_name, api_handle, api_namespace, call_name, call_result, http_response_code)            \
+    {                                                                                                               \
+        std::string("/v1/" #api_name "/" #call_name),                                                               \
+            [api_handle](string, string body, url_response_callback cb) mutable {                                   \
+                if(body.empty())                                                                                    \
+                    body = "{}";                                                                                    \
+                api_handle.call_name(body,                                                                          \
+                                     [cb, body](const fc::static_variant<fc::exception_ptr, call_result>& result) { \
+                                         if(result.contains<fc::exception_ptr>()) {                                 \
+                                             try {                                                                  \
+                                                 result.get<fc::exception_ptr>()->dynamic_rethrow_exception();      \
+                                             }                                                                      \
+                                             catch(...) {                                                           \
+                                                 http_plugin::handle_exception(#api_name, #call_name, body, cb);    \
+                                             }                                                                      \
+                                         }                                                                          \
+                                         else {                                                                     \
+                                             cb(http_response_code, result.visit(async_result_visitor()));          \
+                                         }                                                                          \
+                                     });                                                                            \
+            }                                                                                                       \
+    }
+
 #define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
+#define CHAIN_RO_CALL_IRREVERSIBLE(call_name, http_response_code) CALL_IRREVERSIBLE(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
+#define CHAIN_RO_CALL_PACKED(call_name) CALL_PACKED(chain, ro_api, chain_apis::read_only, call_name)
 #define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code)
 #define CHAIN_RO_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, ro_api, chain_apis::read_only, call_name, call_result, http_response_code)
 #define CHAIN_RW_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code)
+#define CHAIN_RW_CALL_ASYNC_JSON(call_name, call_result, http_response_code) CALL_ASYNC_JSON(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code)
 
 void
 chain_api_plugin::plugin_startup() {
@@ -107,25 +174,35 @@ chain_api_plugin::plugin_startup() {
     auto& _http_plugin = app().get_plugin<http_plugin>();
     ro_api.set_shorten_abi_errors(!_http_plugin.verbose_errors());
 
-    _http_plugin.add_api({CHAIN_RO_CALL(get_info, 200),
-                          CHAIN_RO_CALL(get_block, 200),
+    // it's served from the info published by chain_plugin, no need to occupy main thread
+    _http_plugin.add_concurrent_api({CHAIN_RO_CALL(get_info, 200)});
+
+    _http_plugin.add_api({CHAIN_RO_CALL_IRREVERSIBLE(get_block, 200),
                           CHAIN_RO_CALL(get_block_header_state, 200),
                           CHAIN_RO_CALL(get_head_block_header_state, 200),
-                          CHAIN_RO_CALL(get_transaction, 200),
+                          CHAIN_RO_CALL_IRREVERSIBLE(get_transaction, 200),
                           CHAIN_RO_CALL(get_trx_id_for_link_id, 200),
                           CHAIN_RO_CALL(abi_json_to_bin, 200),
                           CHAIN_RO_CALL(abi_bin_to_json, 200),
                           CHAIN_RO_CALL(trx_json_to_digest, 200),
                           CHAIN_RO_CALL(get_required_keys, 200),
+                          CHAIN_RO_CALL(get_required_keys_batch, 200),
                           CHAIN_RO_CALL(get_suspend_required_keys, 200),
                           CHAIN_RO_CALL(get_charge, 200),
                           CHAIN_RO_CALL(get_transaction_ids_for_block, 200),
+                          CHAIN_RO_CALL(get_deadlines, 200),
                           CHAIN_RO_CALL(get_abi, 200),
                           CHAIN_RO_CALL(get_actions, 200),
                           CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202),
-                          CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202),
+                          CHAIN_RW_CALL_ASYNC_JSON(push_transaction, chain_apis::read_write::push_transaction_results, 202),
                           CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202)});
-    _http_plugin.add_api({CHAIN_RO_CALL(get_db_info, 200)}, true /* local only API */);
+    _http_plugin.add_api({CHAIN_RO_CALL(get_db_info, 200),
+                          CHAIN_RO_CALL(get_db_metrics, 200),
+                          CHAIN_RO_CALL(get_trx_latency, 200),
+                          CHAIN_RO_CALL(get_action_costs, 200),
+                          CHAIN_RO_CALL(get_memory_usage, 200)}, true /* local only API */);
+    // served instead when client accepts `application/octet-stream`
+    _http_plugin.add_binary_api({CHAIN_RO_CALL_PACKED(get_block)});
 }
 
 void
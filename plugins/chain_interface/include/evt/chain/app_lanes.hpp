@@ -0,0 +1,101 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <utility>
+
+#include <appbase/application.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+
+namespace evt { namespace chain { namespace plugin_interface {
+
+/**
+ *  Lanes of the work posted into the queue of `app()`, each one is mapped into one priority of it.
+ *  Queue always executes the handler with the highest priority first, so the work of block production
+ *  and incoming blocks is never queued behind http handlers or net housekeeping.
+ */
+enum class app_lane {
+    production = 0,  // producer timers
+    blocks,          // incoming and synced blocks
+    net,             // p2p messages
+    http,            // non-concurrent http handlers
+    background,      // periodic housekeeping
+    max_value = background
+};
+
+constexpr int kAppLanesNum = (int)app_lane::max_value + 1;
+
+inline int
+lane_priority(app_lane lane) {
+    switch(lane) {
+    case app_lane::production: return appbase::priority::high + 1;
+    case app_lane::blocks:     return appbase::priority::high;
+    case app_lane::net:        return appbase::priority::medium;
+    case app_lane::http:       return appbase::priority::low;
+    default:                   return appbase::priority::low - 1;
+    }
+}
+
+inline const char*
+lane_name(app_lane lane) {
+    const char* names[] = { "production", "blocks", "net", "http", "background" };
+    static_assert(sizeof(names) / sizeof(names[0]) == kAppLanesNum);
+    return names[(int)lane];
+}
+
+/**
+ *  Counters of one lane, handlers are posted from any thread and executed on main thread.
+ *  Depth is the number of handlers still in queue, and wait is the time between posting and executing.
+ *  Wait histogram is only updated and read on main thread.
+ */
+struct app_lane_stats {
+    using histogram = token_database_metrics::histogram;
+
+    std::atomic<uint64_t> posted   = 0;
+    std::atomic<uint64_t> executed = 0;
+    histogram             wait;
+
+    uint64_t depth() const { return posted - executed; }
+};
+
+inline std::array<app_lane_stats, kAppLanesNum>&
+app_lanes_stats() {
+    static std::array<app_lane_stats, kAppLanesNum> stats;
+    return stats;
+}
+
+inline app_lane_stats&
+lane_stats(app_lane lane) {
+    return app_lanes_stats()[(int)lane];
+}
+
+// posts `f` into the queue of `app()` with the priority of `lane`
+template<typename F>
+void
+post_lane(app_lane lane, F&& f) {
+    using namespace std::chrono;
+
+    auto& s = lane_stats(lane);
+    s.posted++;
+    appbase::app().post(lane_priority(lane), [&s, begin = steady_clock::now(), f = std::forward<F>(f)]() mutable {
+        s.wait.add(duration_cast<microseconds>(steady_clock::now() - begin).count());
+        s.executed++;
+        f();
+    });
+}
+
+// same as `get_priority_queue().wrap()`, used for the handlers of asio timers
+template<typename F>
+auto
+wrap_lane(app_lane lane, F&& f) {
+    return [lane, f = std::forward<F>(f)](auto&&... args) mutable {
+        post_lane(lane, [f, args...]() mutable { f(args...); });
+    };
+}
+
+}}}  // namespace evt::chain::plugin_interface
@@ -3,28 +3,38 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/chain_plugin/trx_latency_tracker.hpp>
 
+#include <deque>
+#include <unordered_map>
 #include <signal.h>
 #include <stdlib.h>
 
 #include <boost/signals2/connection.hpp>
 
 #include <fc/io/json.hpp>
+#include <fc/scoped_exit.hpp>
 #include <fc/variant.hpp>
 
 #include <evt/chain/block_log.hpp>
 #include <evt/chain/config.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/fork_database.hpp>
-#include <evt/chain/reversible_block_object.hpp>
+#include <evt/chain/reversible_block_log.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/snapshot.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+#include <evt/chain/token_database_snapshot.hpp>
+#include <evt/chain/action_costs.hpp>
+#include <evt/chain/memory_accounting.hpp>
+#include <evt/chain/token_database_cache.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
 
 #include <evt/utilities/key_conversion.hpp>
+#include <evt/utilities/thread_placement.hpp>
 
 namespace evt {
 
@@ -124,6 +134,9 @@ operator<<(std::ostream& osm, evt::chain::storage_profile m) {
     else if(m == evt::chain::storage_profile::memory) {
         osm << "memory";
     }
+    else if(m == evt::chain::storage_profile::hybrid) {
+        osm << "hybrid";
+    }
 
     return osm;
 }
@@ -148,6 +161,97 @@ validate(boost::any&                     v,
     else if(s == "memory") {
         v = boost::any(evt::chain::storage_profile::memory);
     }
+    else if(s == "hybrid") {
+        v = boost::any(evt::chain::storage_profile::hybrid);
+    }
+    else {
+        throw validation_error(validation_error::invalid_option_value);
+    }
+}
+
+std::ostream&
+operator<<(std::ostream& osm, evt::chain::sync_policy m) {
+    if(m == evt::chain::sync_policy::always) {
+        osm << "always";
+    }
+    else if(m == evt::chain::sync_policy::commit) {
+        osm << "commit";
+    }
+    else if(m == evt::chain::sync_policy::none) {
+        osm << "none";
+    }
+
+    return osm;
+}
+
+void
+validate(boost::any&                     v,
+         const std::vector<std::string>& values,
+         evt::chain::sync_policy* /* target_type */,
+         int) {
+    using namespace boost::program_options;
+
+    // Make sure no previous assignment to 'v' was made.
+    validators::check_first_occurrence(v);
+
+    // Extract the first string from 'values'. If there is more than
+    // one string, it's an error, and exception will be thrown.
+    std::string const& s = validators::get_single_string(values);
+
+    if(s == "always") {
+        v = boost::any(evt::chain::sync_policy::always);
+    }
+    else if(s == "commit") {
+        v = boost::any(evt::chain::sync_policy::commit);
+    }
+    else if(s == "none") {
+        v = boost::any(evt::chain::sync_policy::none);
+    }
+    else {
+        throw validation_error(validation_error::invalid_option_value);
+    }
+}
+
+std::ostream&
+operator<<(std::ostream& osm, evt::chain::tuning_profile m) {
+    if(m == evt::chain::tuning_profile::none) {
+        osm << "none";
+    }
+    else if(m == evt::chain::tuning_profile::producer) {
+        osm << "producer";
+    }
+    else if(m == evt::chain::tuning_profile::api) {
+        osm << "api";
+    }
+    else if(m == evt::chain::tuning_profile::archive) {
+        osm << "archive";
+    }
+
+    return osm;
+}
+
+void
+validate(boost::any&                     v,
+         const std::vector<std::string>& values,
+         evt::chain::tuning_profile* /* target_type */,
+         int) {
+    using namespace boost::program_options;
+
+    validators::check_first_occurrence(v);
+    std::string const& s = validators::get_single_string(values);
+
+    if(s == "none") {
+        v = boost::any(evt::chain::tuning_profile::none);
+    }
+    else if(s == "producer") {
+        v = boost::any(evt::chain::tuning_profile::producer);
+    }
+    else if(s == "api") {
+        v = boost::any(evt::chain::tuning_profile::api);
+    }
+    else if(s == "archive") {
+        v = boost::any(evt::chain::tuning_profile::archive);
+    }
     else {
         throw validation_error(validation_error::invalid_option_value);
     }
@@ -183,6 +287,18 @@ using fc::json;
     }
 
 class chain_plugin_impl {
+public:
+    using trx_result_type = fc::static_variant<fc::exception_ptr, transaction_trace_ptr>;
+
+    // results are only cached when they don't depend on the pending state:
+    // objective failures, or traces of the transactions included in one block
+    struct cached_trx_result {
+        std::optional<trx_result_type>                           result;
+        block_id_type                                            block_id;
+        fc::time_point                                           expires;
+        std::vector<next_function<chain::transaction_trace_ptr>> waiters;
+    };
+
 public:
     chain_plugin_impl()
         : pre_accepted_block_channel(app().get_channel<channels::pre_accepted_block>())
@@ -207,6 +323,66 @@ public:
     std::optional<chain_id_type>      chain_id;
     std::optional<bfs::path>          snapshot_path;
 
+    // published after head or irreversible block changes, read by http worker threads
+    chain_apis::read_only::info_ptr info;
+
+    // head fields are of fork database which is updated ahead of the signals, but irreversible block is of
+    // the head of controller, which is only moved after the signals. So it's taken from the signaled one if it's ahead
+    void
+    publish_info(uint32_t lib_num = 0, const block_id_type& lib_id = block_id_type()) {
+        auto r = chain_apis::read_only(*chain).get_info({});
+        if(lib_num > r.last_irreversible_block_num) {
+            r.last_irreversible_block_num = lib_num;
+            r.last_irreversible_block_id  = lib_id;
+        }
+        std::atomic_store(&info, std::make_shared<const chain_apis::read_only::get_info_results>(std::move(r)));
+    }
+
+    // results of recent transactions keyed by the signed ids, the ones without result are in flight
+    fc::microseconds                                         trx_result_ttl;
+    std::unordered_map<digest_type, cached_trx_result>       trx_results;
+    std::deque<std::pair<fc::time_point, digest_type>>       trx_results_expiry;
+    // traces applied in pending block, they're cached once the block is accepted and dropped when it's aborted
+    std::unordered_map<digest_type, transaction_trace_ptr>   trx_results_pending;
+    block_id_type                                            trx_results_head;
+
+    // set when `trx-latency-sample-rate` is not zero
+    std::unique_ptr<trx_latency_tracker> latency;
+
+    void
+    add_memory_probes() {
+        auto& accounting = memory_accounting::instance();
+        accounting.add_probe("fork_db", [this] { return chain->fork_db().size(); });
+        accounting.add_probe("chainbase", [this] {
+            auto sm = chain->db().get_segment_manager();
+            return sm->get_size() - sm->get_free_memory();
+        });
+        accounting.add_probe("token_db_cache", [this] { return chain->token_db_cache().usage(); });
+        accounting.add_probe("token_db_rocksdb", [this] {
+            auto stats = chain->token_db().int_stats();
+            return stats["cur-size-all-mem-tables"] + stats["estimate-table-readers-mem"]
+                + stats["block-cache-usage"] + stats["hot-tier-bytes"];
+        });
+        accounting.add_probe("unapplied_trxs", [this] {
+            auto bytes = uint64_t(0);
+            for(auto& it : chain->get_unapplied_transactions()) {
+                bytes += sizeof(transaction_metadata) + it.second->packed_trx->get_unprunable_size() + it.second->packed_trx->get_prunable_size();
+            }
+            return bytes;
+        });
+        accounting.add_probe("trx_results", [this] {
+            return trx_results.size() * (sizeof(digest_type) + sizeof(cached_trx_result));
+        });
+    }
+
+    void
+    remove_memory_probes() {
+        auto& accounting = memory_accounting::instance();
+        for(auto name : { "fork_db", "chainbase", "token_db_cache", "token_db_rocksdb", "unapplied_trxs", "trx_results" }) {
+            accounting.remove_probe(name);
+        }
+    }
+
     // retained references to channels for easy publication
     channels::pre_accepted_block::channel_type&    pre_accepted_block_channel;
     channels::accepted_block_header::channel_type& accepted_block_header_channel;
@@ -231,8 +407,159 @@ public:
     std::optional<scoped_connection> accepted_block_header_connection;
     std::optional<scoped_connection> accepted_block_connection;
     std::optional<scoped_connection> irreversible_block_connection;
+    std::optional<scoped_connection> aborted_block_connection;
     std::optional<scoped_connection> accepted_transaction_connection;
     std::optional<scoped_connection> applied_transaction_connection;
+
+public:
+    // returns true if `next` is answered or will be answered with the result of the same transaction
+    bool
+    try_cached_result(const digest_type& key, const next_function<chain::transaction_trace_ptr>& next) {
+        if(trx_result_ttl.count() == 0) {
+            return false;
+        }
+
+        auto now = fc::time_point::now();
+        while(!trx_results_expiry.empty() && trx_results_expiry.front().first <= now) {
+            // key may be cached again after it's dropped
+            auto it = trx_results.find(trx_results_expiry.front().second);
+            if(it != trx_results.end() && it->second.result.has_value() && it->second.expires <= now) {
+                trx_results.erase(it);
+            }
+            trx_results_expiry.pop_front();
+        }
+
+        auto it = trx_results.find(key);
+        if(it == trx_results.end()) {
+            return false;
+        }
+        if(it->second.result.has_value()) {
+            next(*it->second.result);
+        }
+        else {
+            it->second.waiters.emplace_back(next);
+        }
+        return true;
+    }
+
+    void
+    dispatch_transaction(const transaction_metadata_ptr& trx, bool persist_until_expired, trx_timestamps::source_type source, next_function<chain::transaction_trace_ptr> next) {
+        if(latency) {
+            latency->sample(trx, source);
+        }
+        // keys are recovered on thread pool while the transaction is waiting for main thread
+        transaction_metadata::start_recover_keys(trx, chain->get_thread_pool(), chain->get_chain_id(), chain_config->parallel_recover_sigs);
+        if(trx_result_ttl.count() == 0) {
+            incoming_transaction_async_method(trx, persist_until_expired, std::move(next));
+            return;
+        }
+
+        auto key = trx->signed_id;
+        trx_results[key].waiters.emplace_back(std::move(next));
+        incoming_transaction_async_method(trx, persist_until_expired, [this, key](const trx_result_type& result) {
+            auto it = trx_results.find(key);
+            if(it == trx_results.end()) {
+                return;
+            }
+            auto waiters = std::move(it->second.waiters);
+            if(result.contains<fc::exception_ptr>()) {
+                if(is_objective_failure(*result.get<fc::exception_ptr>())) {
+                    cache_result(it->second, key, result, block_id_type());
+                }
+                else {
+                    trx_results.erase(it);
+                }
+            }
+            else {
+                // applied in pending block, it can still be aborted or forked out
+                trx_results_pending[key] = result.get<transaction_trace_ptr>();
+                trx_results.erase(it);
+            }
+
+            for(auto& w : waiters) {
+                w(result);
+            }
+        });
+    }
+
+    // failures decided by the transaction itself, the same transaction always fails the same way
+    static bool
+    is_objective_failure(const fc::exception& e) {
+        switch(e.code()) {
+        case tx_duplicate::code_value:
+        case expired_tx_exception::code_value:
+        case tx_duplicate_sig::code_value: {
+            return true;
+        }
+        default: {
+            return false;
+        }
+        }  // switch
+    }
+
+    void
+    cache_result(cached_trx_result& r, const digest_type& key, const trx_result_type& result, const block_id_type& block_id) {
+        r.result   = result;
+        r.block_id = block_id;
+        r.expires  = fc::time_point::now() + trx_result_ttl;
+        trx_results_expiry.emplace_back(r.expires, key);
+    }
+
+    // duplicates are decided against the chain as well, the original one may be unapplied or forked out
+    static bool
+    is_duplicate_failure(const cached_trx_result& r) {
+        return r.result->contains<fc::exception_ptr>() && r.result->get<fc::exception_ptr>()->code() == tx_duplicate::code_value;
+    }
+
+    // drops the cached results depending on pending block, or any block when `forked`, the ones in flight are kept
+    void
+    drop_cached_results(bool forked) {
+        for(auto it = trx_results.begin(); it != trx_results.end();) {
+            auto& r = it->second;
+            if(r.result.has_value() && ((forked && r.block_id != block_id_type()) || is_duplicate_failure(r))) {
+                it = trx_results.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+        trx_results_pending.clear();
+    }
+
+    void
+    on_aborted_block_results(const block_state_ptr&) {
+        if(trx_result_ttl.count() == 0) {
+            return;
+        }
+        // traces applied in the aborted block and duplicates made against it are not valid anymore
+        drop_cached_results(false);
+    }
+
+    void
+    on_accepted_block_results(const block_state_ptr& blk) {
+        if(trx_result_ttl.count() == 0) {
+            return;
+        }
+        // blocks which are not built on the last accepted one means forks are switched
+        if(trx_results_head != block_id_type() && blk->header.previous != trx_results_head) {
+            drop_cached_results(true);
+        }
+        trx_results_head = blk->id;
+
+        for(auto& t : blk->trxs) {
+            auto pit = trx_results_pending.find(t->signed_id);
+            if(pit == trx_results_pending.end()) {
+                continue;
+            }
+            // the ones in flight are answered by themselves
+            auto& r = trx_results[t->signed_id];
+            if(r.waiters.empty()) {
+                cache_result(r, t->signed_id, pit->second, blk->id);
+            }
+        }
+        // the rest were applied in pending blocks which are not accepted
+        trx_results_pending.clear();
+    }
 };
 
 chain_plugin::chain_plugin()
@@ -240,6 +567,8 @@ chain_plugin::chain_plugin()
     app().register_config_type<evt::chain::db_read_mode>();
     app().register_config_type<evt::chain::validation_mode>();
     app().register_config_type<evt::chain::storage_profile>();
+    app().register_config_type<evt::chain::sync_policy>();
+    app().register_config_type<evt::chain::tuning_profile>();
 }
 
 chain_plugin::~chain_plugin() {}
@@ -248,20 +577,107 @@ void
 chain_plugin::set_program_options(options_description& cli, options_description& cfg) {
     cfg.add_options()
         ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"), "the location of the blocks directory (absolute path or relative to application data dir)")
+        ("blocks-log-segment-blocks", bpo::value<uint32_t>()->default_value(0),
+            "Number of blocks in one compressed segment of block log, older blocks are moved into segments once block log has two segments of blocks. 0 to disable it")
+        ("blocks-log-max-segments", bpo::value<uint32_t>()->default_value(0),
+            "Oldest segments of block log over this number are removed, blocks in them cannot be served or replayed anymore. 0 to keep all of them")
+        ("blocks-log-max-segments-mb", bpo::value<uint64_t>()->default_value(0),
+            "Oldest segments of block log are removed once segments take more megabytes than this, along with blocks-log-max-segments. 0 for no limit")
+        ("blocks-log-async-append", bpo::bool_switch()->default_value(false),
+            "Write blocks into block log on another thread in batches, recent blocks may be lost on crash and are replayed from peers")
+        ("blocks-log-batch-blocks", bpo::value<uint32_t>()->default_value(64), "Max number of blocks written into block log in one batch")
+        ("blocks-log-batch-ms", bpo::value<uint32_t>()->default_value(100), "Max milliseconds one block waits for its batch before written into block log")
+        ("blocks-log-sync", bpo::bool_switch()->default_value(false), "Sync block log to disk after each batch, or each block when not async")
         ("token-db-dir", bpo::value<bfs::path>()->default_value("tokendb"), "the location of the token database directory (absolute path or relative to application data dir)")
         ("token-db-cache-size-mb", bpo::value<uint32_t>()->default_value(512), "the cache size of token database in MBytes")
         ("token-db-profile", boost::program_options::value<evt::chain::storage_profile>()->default_value(evt::chain::storage_profile::disk),
-            "Token database profile (\"disk\", or \"memory\").\n"
+            "Token database profile (\"disk\", \"memory\" or \"hybrid\").\n"
             "In \"disk\" profile database is optimized for the standard storage devices.\n"
             "In \"memory\" mode database is optimized for the usage in ultra-low latency devices like memory\n"
+            "In \"hybrid\" profile database is the same as \"disk\" one, and frequently written keys are kept in an in-process hot tier\n"
         )
+        ("token-db-hot-tier-size-mb", bpo::value<uint32_t>()->default_value(128), "the size of hot tier of token database in MBytes, only used in \"hybrid\" profile")
+        ("token-db-separated-layout", bpo::bool_switch()->default_value(false),
+            "Store hot token types (token, fungible and evtlink) in their own column families of token database.\n"
+            "Existed token database will be migrated into this layout once, and cannot be opened without this option after that.")
+        ("token-db-disable-wal", bpo::bool_switch()->default_value(false),
+            "Disable the WAL of token database, block log becomes the only recovery source.\n"
+            "Unflushed writes are lost when node is crashed, and token database should be rebuilt by replaying blockchain.")
+        ("token-db-sync", boost::program_options::value<evt::chain::sync_policy>()->default_value(evt::chain::sync_policy::commit),
+            "Fsync policy of token database writes (\"always\", \"commit\" or \"none\").\n"
+            "In \"commit\" policy writes are only synced when irreversible savepoints are committed and rollbacks are written.\n"
+            "It has no effect when WAL is disabled.")
+        ("token-db-tuning", boost::program_options::value<evt::chain::tuning_profile>()->default_value(evt::chain::tuning_profile::none),
+            "Tune background jobs, write buffers and rate limiter of token database by the detected cores, memory and disk type (\"none\", \"producer\", \"api\" or \"archive\").\n"
+            "In \"producer\" profile it's tuned for the latency of applying blocks.\n"
+            "In \"api\" profile it's tuned for serving reads alongside writes.\n"
+            "In \"archive\" profile it's tuned for the throughput of replaying long histories.")
+        ("token-db-options-file", bpo::value<bfs::path>(),
+            "RocksDB OPTIONS file applied to token database after tuning (absolute path or relative to application data dir), "
+            "the options deciding the format of data are not changed")
+        ("token-db-snapshot-ingest", bpo::bool_switch()->default_value(false),
+            "Restore token database from snapshot by writing sst files and ingesting them directly, not supported in \"memory\" profile")
+        ("token-db-state-hash", bpo::bool_switch()->default_value(false),
+            "Maintain a running hash of all the rows in token database, which is updated with each write and reported in get_db_metrics.\n"
+            "It costs one more read for each write.")
+        ("token-db-evtlink-filter", bpo::bool_switch()->default_value(false),
+            "Keep a bloom filter of all the evtlinks of token database in memory, so lookups of links not paid yet skip the database.\n"
+            "It's loaded by scanning all the evtlinks on startup.")
+        ("token-db-owner-index", bpo::bool_switch()->default_value(false),
+            "Keep an index from owners to their tokens in token database, which get_tokens_by_owner is served from.\n"
+            "It's built by scanning all the tokens when it's enabled at first, and dropped when it's disabled.")
+        ("token-db-balance-index", bpo::bool_switch()->default_value(false),
+            "Keep an index from addresses to their balances of all the symbols in token database, which get_fungible_balance without sym_id is served from.\n"
+            "It's built by scanning all the balances when it's enabled at first, and dropped when it's disabled.")
+        ("token-db-fast-restart", bpo::bool_switch()->default_value(false),
+            "Write derived state of token database, the state hash and evtlink filter, on clean shutdown and load it on next startup\n"
+            "instead of scanning the whole database. It's validated against the database and rebuilt when it's stale.")
+        ("token-db-warmup-keys", bpo::value<uint32_t>()->default_value(0),
+            "Number of the most recently read keys of token database cache saved periodically and on shutdown,\n"
+            "they're prefetched into block cache in background on next startup. 0 disables it.")
+        ("token-db-hot-keys", bpo::value<uint32_t>()->default_value(0),
+            "Number of the most frequently read and written keys of each token type reported in get_db_metrics, 0 disables it.\n"
+            "Frequencies are estimated by a count-min sketch of fixed memory.")
+        ("token-db-hot-keys-window", bpo::value<uint32_t>()->default_value(600), "Sliding window of hot keys of token database in seconds")
+        ("token-db-metrics", bpo::bool_switch()->default_value(false),
+            "Count accesses of token database by token type and by action with their latencies, which are reported in get_db_metrics")
+        ("token-db-evtlink-ttl", bpo::value<uint32_t>()->default_value(0),
+            "Seconds after which paid evtlinks are dropped from token database in compactions, 0 keeps all of them.\n"
+            "It's never less than twice of evt_link_expired_secs. Links dropped cannot be looked up by get_trx_id_for_link_id.\n"
+            "It's ignored in loadtest mode and cannot be used with token-db-state-hash.")
         ("checkpoint", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
         ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms), "Override default maximum ABI serialization time allowed in ms")
+        ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
+            "Number of worker threads in controller thread pool, which is used for recovering signatures of transactions")
+        ("chain-parallel-recover-sigs", bpo::value<uint32_t>()->default_value(config::default_parallel_recover_min_sigs),
+            "Signatures of transactions with at least this number of signatures are recovered by several threads in parallel, 0 to disable")
         ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024 * 1024)), "Maximum size (in MiB) of the chain state database")
+        ("chain-state-huge-pages", bpo::bool_switch()->default_value(false),
+            "Advise kernel to back the mapping of chain state database with transparent huge pages, it needs the state dir on a filesystem supporting them (e.g. tmpfs mounted with huge=). "
+            "Explicit huge pages are used by putting the state dir on hugetlbfs.")
+        ("thread-placement", bpo::value<vector<string>>()->composing()->multitoken(),
+            "Pin named threads to cpus as NAME=CPUS, e.g. main=0 net=2-3,6. Names: main, chain, net, http, local-rpc. "
+            "Threads on the cpus of one NUMA node prefer the memory of that node.")
         ("chain-state-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_guard_size / (1024 * 1024)), "Safely shut down node when free space remaining in the chain state database drops below this size (in MiB).")
         ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024 * 1024)), "Maximum size (in MiB) of the reversible blocks database")
+        ("fork-db-max-size-mb", bpo::value<uint64_t>()->default_value(config::default_fork_db_max_size / (1024 * 1024)),
+            "Fork database keeps blocks of dead branches packed and then removes them once it is over this size (in MiB). 0 to disable it")
         ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024 * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
         ("contracts-console", bpo::bool_switch()->default_value(false), "print contract's output to console")
+        ("block-bus-size", bpo::value<uint32_t>()->default_value(0),
+            "Max number of blocks waiting in block bus, which delivers blocks and their transaction traces to the subscribers on its own thread. 0 to disable it")
+        ("replay-prefetch-blocks", bpo::value<uint32_t>()->default_value(64),
+            "Max number of blocks read and prepared ahead in each stage of replaying, blocks are read, unpacked and have keys recovered on other threads. 0 to disable it")
+        ("trx-prefetch-ahead", bpo::value<uint32_t>()->default_value(0),
+            "Max number of upcoming transactions whose read sets are loaded into block cache of token database on another thread before they're executed. 0 to disable it")
+        ("trx-result-cache-ms", bpo::value<uint32_t>()->default_value(5000),
+            "Time in milliseconds to keep the results of the transactions, the duplicates received in this period are answered by the cached result without being processed. Only the results of transactions included in blocks and the failures decided by transactions themselves (duplicate, expired and duplicate signatures) are kept. 0 to disable it")
+        ("trx-latency-sample-rate", bpo::value<uint32_t>()->default_value(0),
+            "Trace one in this number of incoming transactions through the stages from ingress to irreversibility, their latencies are reported in get_trx_latency. 0 to disable it")
+        ("trx-latency-trace-file", bpo::value<bfs::path>(),
+            "File to append the traced transactions as json lines (absolute path or relative to application data dir)")
+        ("memory-accounting", bpo::bool_switch()->default_value(false),
+            "Account the memory held by fork database, caches, chain state and the queues of plugins, which is reported in get_memory_usage")
         ("read-mode", boost::program_options::value<evt::chain::db_read_mode>()->default_value(evt::chain::db_read_mode::SPECULATIVE),
             "Database read mode (\"speculative\", \"head\", or \"read-only\").\n"// or \"irreversible\").\n"
             "In \"speculative\" mode database contains changes done up to the head block plus changes made by transactions not yet included to the blockchain.\n"
@@ -284,6 +700,7 @@ chain_plugin::set_program_options(options_description& cli, options_description&
         ("fix-reversible-blocks", bpo::bool_switch()->default_value(false), "recovers reversible block database if that database is in a bad state")
         ("force-all-checks", bpo::bool_switch()->default_value(false), "do not skip any checks that can be skipped while replaying irreversible blocks")
         ("disable-replay-opts", bpo::bool_switch()->default_value(false), "disable optimizations that specifically target replay")
+        ("trusted-replay-until", bpo::value<string>(), "trust the irreversible blocks up to this block id when replaying: skip signature recovery, undo sessions and receipt checks of them, then switch back to full validation")
         ("loadtest-mode", bpo::bool_switch()->default_value(false), "special for load-testing, skip expiration and reference block checks")
         ("charge-free-mode", bpo::bool_switch()->default_value(false), "do not charge any fees for transactions")
         ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain state database and token database and replay all blocks")
@@ -294,6 +711,8 @@ chain_plugin::set_program_options(options_description& cli, options_description&
         ("export-reversible-blocks", bpo::value<bfs::path>(), "export reversible block database in portable format into specified file and then exit")
         ("trusted-producer", bpo::value<vector<string>>()->composing(), "Indicate a producer whose blocks headers signed by it will be fully validated, but transactions in those validated blocks will be trusted.")
         ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from")
+        ("rebase-snapshot", bpo::value<bfs::path>(), "rebase the incremental snapshot onto the one specified by --snapshot-base, write the full snapshot next to it and exit")
+        ("snapshot-base", bpo::value<bfs::path>(), "Base snapshot which the one of --rebase-snapshot is created from")
         ;
 }
 
@@ -352,6 +771,16 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             throw;
         }
 
+        // main thread is placed first, the caches filled by it are allocated on its node
+        if(options.count("thread-placement")) {
+            for(auto& p : options.at("thread-placement").as<vector<string>>()) {
+                auto eq = p.find('=');
+                EVT_ASSERT(eq != string::npos && eq > 0, plugin_config_exception, "Invalid thread placement: ${p}, should be NAME=CPUS", ("p",p));
+                evt::utilities::set_thread_placement(p.substr(0, eq), evt::utilities::parse_cpu_list(p.substr(eq + 1)));
+            }
+        }
+        evt::utilities::place_current_thread("main");
+
         my->chain_config = controller::config();
 
         LOAD_VALUE_SET(options, "trusted-producer", my->chain_config->trusted_producers);
@@ -393,11 +822,23 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             }
         }
 
+        my->chain_config->thread_pool_size = options.at("chain-threads").as<uint16_t>();
+        EVT_ASSERT(my->chain_config->thread_pool_size > 0, plugin_config_exception,
+            "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size));
+        my->chain_config->parallel_recover_sigs = options.at("chain-parallel-recover-sigs").as<uint32_t>();
+
         if(options.count("abi-serializer-max-time-ms")) {
             my->chain_config->max_serialization_time = std::chrono::milliseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>());
         }
 
         my->chain_config->blocks_dir = my->blocks_dir;
+        my->chain_config->blog_config.segment_blocks    = options.at("blocks-log-segment-blocks").as<uint32_t>();
+        my->chain_config->blog_config.max_segments      = options.at("blocks-log-max-segments").as<uint32_t>();
+        my->chain_config->blog_config.max_segments_size = options.at("blocks-log-max-segments-mb").as<uint64_t>() * 1024 * 1024;
+        my->chain_config->blog_config.async_append      = options.at("blocks-log-async-append").as<bool>();
+        my->chain_config->blog_config.batch_blocks      = options.at("blocks-log-batch-blocks").as<uint32_t>();
+        my->chain_config->blog_config.batch_ms          = options.at("blocks-log-batch-ms").as<uint32_t>();
+        my->chain_config->blog_config.sync_data         = options.at("blocks-log-sync").as<bool>();
         my->chain_config->state_dir  = app().data_dir() / config::default_state_dir_name;
         my->chain_config->read_only  = my->readonly;
 
@@ -413,6 +854,30 @@ chain_plugin::plugin_initialize(const variables_map& options) {
         if(options.count("token-db-profile")) {
             my->chain_config->db_config.profile = options.at("token-db-profile").as<storage_profile>();
         }
+        if(options.count("token-db-hot-tier-size-mb")) {
+            my->chain_config->db_config.hot_tier_size = options.at("token-db-hot-tier-size-mb").as<uint32_t>() * 1024 * 1024;
+        }
+        my->chain_config->db_config.separated_layout = options.at("token-db-separated-layout").as<bool>();
+        my->chain_config->db_config.snapshot_ingest  = options.at("token-db-snapshot-ingest").as<bool>();
+        my->chain_config->db_config.disable_wal      = options.at("token-db-disable-wal").as<bool>();
+        my->chain_config->db_config.sync             = options.at("token-db-sync").as<sync_policy>();
+        my->chain_config->db_config.state_hash       = options.at("token-db-state-hash").as<bool>();
+        my->chain_config->db_config.evtlink_filter   = options.at("token-db-evtlink-filter").as<bool>();
+        my->chain_config->db_config.owner_index      = options.at("token-db-owner-index").as<bool>();
+        my->chain_config->db_config.balance_index    = options.at("token-db-balance-index").as<bool>();
+        my->chain_config->db_config.fast_restart     = options.at("token-db-fast-restart").as<bool>();
+        my->chain_config->db_config.warmup_keys      = options.at("token-db-warmup-keys").as<uint32_t>();
+        my->chain_config->db_config.hot_keys         = options.at("token-db-hot-keys").as<uint32_t>();
+        my->chain_config->db_config.hot_keys_window  = options.at("token-db-hot-keys-window").as<uint32_t>();
+        my->chain_config->db_config.metrics          = options.at("token-db-metrics").as<bool>();
+        my->chain_config->db_config.evtlink_ttl      = options.at("token-db-evtlink-ttl").as<uint32_t>();
+        EVT_ASSERT(my->chain_config->db_config.evtlink_ttl == 0 || !my->chain_config->db_config.state_hash, plugin_config_exception,
+            "token-db-evtlink-ttl cannot be used with token-db-state-hash, rows dropped in compactions are not removed from state hash");
+        my->chain_config->db_config.tuning           = options.at("token-db-tuning").as<tuning_profile>();
+        if(options.count("token-db-options-file")) {
+            auto f = options.at("token-db-options-file").as<bfs::path>();
+            my->chain_config->db_config.options_file = f.is_relative() ? app().data_dir() / f : f;
+        }
 
         if(options.count("chain-state-db-size-mb")) {
             my->chain_config->state_size = options.at("chain-state-db-size-mb").as<uint64_t>() * 1024 * 1024;
@@ -430,11 +895,34 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             my->chain_config->reversible_guard_size = options.at("reversible-blocks-db-guard-size-mb").as<uint64_t>() * 1024 * 1024;
         }
 
+        if(options.count("fork-db-max-size-mb")) {
+            my->chain_config->fork_db_max_size = options.at("fork-db-max-size-mb").as<uint64_t>() * 1024 * 1024;
+        }
+
         my->chain_config->force_all_checks    = options.at("force-all-checks").as<bool>();
         my->chain_config->disable_replay_opts = options.at("disable-replay-opts").as<bool>();
+        if(options.count("trusted-replay-until")) {
+            my->chain_config->trusted_replay_until = fc::variant(options.at("trusted-replay-until").as<string>()).as<block_id_type>();
+        }
         my->chain_config->loadtest_mode       = options.at("loadtest-mode").as<bool>();
         my->chain_config->charge_free_mode    = options.at("charge-free-mode").as<bool>();
         my->chain_config->contracts_console   = options.at("contracts-console").as<bool>();
+        my->chain_config->block_bus_size      = options.at("block-bus-size").as<uint32_t>();
+        my->chain_config->replay_prefetch_blocks = options.at("replay-prefetch-blocks").as<uint32_t>();
+        my->chain_config->trx_prefetch_ahead     = options.at("trx-prefetch-ahead").as<uint32_t>();
+        my->trx_result_ttl                    = fc::milliseconds(options.at("trx-result-cache-ms").as<uint32_t>());
+
+        if(auto rate = options.at("trx-latency-sample-rate").as<uint32_t>(); rate > 0) {
+            auto file = std::optional<fc::path>();
+            if(options.count("trx-latency-trace-file")) {
+                auto f = options.at("trx-latency-trace-file").as<bfs::path>();
+                file   = f.is_relative() ? app().data_dir() / f : f;
+            }
+            my->latency = std::make_unique<trx_latency_tracker>(rate, file);
+        }
+
+        // set before other plugins are initialized, so they know whether to count their queues
+        memory_accounting::instance().set_enabled(options.at("memory-accounting").as<bool>());
 
         if(options.count("extract-genesis-json") || options.at("print-genesis-json").as<bool>()) {
             genesis_state gs;
@@ -465,6 +953,52 @@ chain_plugin::plugin_initialize(const variables_map& options) {
             EVT_THROW(extract_genesis_state_exception, "extracted genesis state from blocks.log");
         }
 
+        if(options.count("rebase-snapshot")) {
+            EVT_ASSERT(options.count("snapshot-base"), plugin_config_exception, "--rebase-snapshot requires --snapshot-base");
+            auto incr_path = options.at("rebase-snapshot").as<bfs::path>();
+            auto base_path = options.at("snapshot-base").as<bfs::path>();
+            for(auto& p : { incr_path, base_path }) {
+                EVT_ASSERT(fc::exists(p), plugin_config_exception, "Cannot rebase snapshot, ${name} does not exist", ("name", p.generic_string()));
+            }
+
+            auto incr_in = std::ifstream(incr_path.generic_string(), (std::ios::in | std::ios::binary));
+            auto base_in = std::ifstream(base_path.generic_string(), (std::ios::in | std::ios::binary));
+            auto incr    = std::make_shared<istream_snapshot_reader>(incr_in);
+            auto base    = std::make_shared<istream_snapshot_reader>(base_in);
+            incr->validate();
+            base->validate();
+
+            // full snapshot is named by its head block, the same as the ones created by producer_plugin
+            auto head = block_header_state();
+            incr->read_section<block_state>([&](auto& section) {
+                section.read_row(head);
+            });
+            auto out_path = incr_path.parent_path() / fc::format_string("snapshot-${id}.bin", fc::mutable_variant_object()("id", head.id));
+            EVT_ASSERT(!fc::exists(out_path), plugin_config_exception, "Snapshot ${name} already exists", ("name", out_path.generic_string()));
+
+            // rows are merged in a temporary token database, which is removed at last
+            auto cfg    = token_database::config();
+            cfg.db_path = app().data_dir() / "rebase-tokendb";
+            if(fc::exists(cfg.db_path)) {
+                fc::remove_all(cfg.db_path);
+            }
+            auto remove_db = fc::make_scoped_exit([&cfg] {
+                fc::remove_all(cfg.db_path);
+            });
+            {
+                auto db = token_database(cfg);
+                db.open();
+
+                auto out    = std::ofstream(out_path.generic_string(), (std::ios::out | std::ios::binary));
+                auto writer = std::make_shared<ostream_snapshot_writer>(out);
+                token_database_snapshot::rebase_snapshot(base, incr, writer, db);
+                writer->finalize();
+            }
+
+            ilog("Saved rebased snapshot to '${path}'", ("path", out_path.generic_string()));
+            EVT_THROW(node_management_success, "rebased incremental snapshot");
+        }
+
         if(options.count("export-reversible-blocks")) {
             auto p = options.at("export-reversible-blocks").as<bfs::path>();
 
@@ -502,10 +1036,8 @@ chain_plugin::plugin_initialize(const variables_map& options) {
                     ilog("Reversible blocks database was not corrupted. Copying from backup to blocks directory.");
                     fc::copy(backup_dir / config::reversible_blocks_dir_name,
                              my->chain_config->blocks_dir / config::reversible_blocks_dir_name);
-                    fc::copy(backup_dir / config::reversible_blocks_dir_name / "shared_memory.bin",
-                             my->chain_config->blocks_dir / config::reversible_blocks_dir_name / "shared_memory.bin");
-                    fc::copy(backup_dir / config::reversible_blocks_dir_name / "shared_memory.meta",
-                             my->chain_config->blocks_dir / config::reversible_blocks_dir_name / "shared_memory.meta");
+                    fc::copy(reversible_block_log::file_path(backup_dir / config::reversible_blocks_dir_name),
+                             reversible_block_log::file_path(my->chain_config->blocks_dir / config::reversible_blocks_dir_name));
                 }
             }
         }
@@ -655,6 +1187,17 @@ chain_plugin::plugin_initialize(const variables_map& options) {
 
         my->chain.emplace(*my->chain_config);
         my->chain_id.emplace(my->chain->get_chain_id());
+        evt::utilities::place_pool_threads(my->chain->get_thread_pool(), my->chain_config->thread_pool_size, "chain");
+
+        if(options.at("chain-state-huge-pages").as<bool>()) {
+            auto sm = my->chain->db().get_segment_manager();
+            if(evt::utilities::advise_huge_pages(sm, sm->get_size())) {
+                ilog("Chain state database is advised to use transparent huge pages");
+            }
+            else {
+                wlog("Kernel refuses huge pages for chain state database, check the filesystem of state dir");
+            }
+        }
 
         // set up method providers
         my->get_block_by_number_provider = app().get_method<methods::get_block_by_number>().register_provider(
@@ -691,14 +1234,41 @@ chain_plugin::plugin_initialize(const variables_map& options) {
 
         my->accepted_block_header_connection = my->chain->accepted_block_header.connect(
             [this](const block_state_ptr& blk) {
+                if(std::atomic_load(&my->info)) {
+                    my->publish_info();
+                }
                 my->accepted_block_header_channel.publish(priority::medium, blk);
             });
 
         my->accepted_block_connection = my->chain->accepted_block.connect([this](const block_state_ptr& blk) {
+            // blocks applied during switching forks are signaled here as well, the last one is the new head
+            if(std::atomic_load(&my->info)) {
+                auto lib = std::max(blk->bft_irreversible_blocknum, blk->dpos_irreversible_blocknum);
+                if(lib > my->chain->last_irreversible_block_num()) {
+                    my->publish_info(lib, my->chain->get_block_id_for_num(lib));
+                }
+                else {
+                    my->publish_info();
+                }
+            }
+            if(my->latency) {
+                my->latency->on_accepted_block(blk);
+            }
+            my->on_accepted_block_results(blk);
             my->accepted_block_channel.publish(priority::high, blk);
         });
 
+        my->aborted_block_connection = my->chain->aborted_block.connect([this](const block_state_ptr& blk) {
+            my->on_aborted_block_results(blk);
+        });
+
         my->irreversible_block_connection = my->chain->irreversible_block.connect([this](const block_state_ptr& blk) {
+            if(std::atomic_load(&my->info)) {
+                my->publish_info(blk->block_num, blk->id);
+            }
+            if(my->latency) {
+                my->latency->on_irreversible_block(blk);
+            }
             my->irreversible_block_channel.publish(priority::low, blk);
         });
 
@@ -747,16 +1317,30 @@ chain_plugin::plugin_startup() {
              ("num", my->chain->head_block_num())("ts", (std::string)my->chain_config->genesis.initial_timestamp));
 
         my->chain_config.reset();
+
+        if(memory_accounting::instance().enabled()) {
+            my->add_memory_probes();
+        }
+
+        // published after replaying, again when all the plugins are started
+        my->publish_info();
+        app().post(priority::low, [this] {
+            my->publish_info();
+        });
     }
     FC_CAPTURE_AND_RETHROW()
 }
 
 void
 chain_plugin::plugin_shutdown() {
+    if(memory_accounting::instance().enabled()) {
+        my->remove_memory_probes();
+    }
     my->pre_accepted_block_connection.reset();
     my->accepted_block_header_connection.reset();
     my->accepted_block_connection.reset();
     my->irreversible_block_connection.reset();
+    my->aborted_block_connection.reset();
     my->accepted_transaction_connection.reset();
     my->applied_transaction_connection.reset();
     my->chain.reset();
@@ -764,7 +1348,7 @@ chain_plugin::plugin_shutdown() {
 
 chain_apis::read_only
 chain_plugin::get_read_only_api() const {
-    return chain_apis::read_only(chain());
+    return chain_apis::read_only(chain(), &my->info, my->latency.get());
 }
 
 chain_apis::read_write
@@ -779,12 +1363,24 @@ chain_plugin::accept_block(const signed_block_ptr& block) {
 
 void
 chain_plugin::accept_transaction(const chain::packed_transaction& trx, next_function<chain::transaction_trace_ptr> next) {
-    my->incoming_transaction_async_method(std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(trx)), false, std::forward<decltype(next)>(next));
+    accept_transaction(std::make_shared<transaction_metadata>(std::make_shared<packed_transaction>(trx)), std::forward<decltype(next)>(next));
 }
 
 void
 chain_plugin::accept_transaction(const chain::transaction_metadata_ptr& trx, next_function<chain::transaction_trace_ptr> next) {
-    my->incoming_transaction_async_method(trx, false, std::forward<decltype(next)>(next));
+    if(my->try_cached_result(trx->signed_id, next)) {
+        return;
+    }
+    my->dispatch_transaction(trx, false, trx_timestamps::net, std::move(next));
+}
+
+void
+chain_plugin::accept_transaction(const chain::packed_transaction_ptr& trx, bool persist_until_expired, next_function<chain::transaction_trace_ptr> next) {
+    // same as the signed id of metadata, check it before metadata is made
+    if(my->try_cached_result(trx->signed_id(), next)) {
+        return;
+    }
+    my->dispatch_transaction(std::make_shared<transaction_metadata>(trx), persist_until_expired, trx_timestamps::http, std::move(next));
 }
 
 bool
@@ -797,20 +1393,16 @@ bool
 chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_size,
                                         optional<fc::path> new_db_dir, uint32_t truncate_at_block) {
     try {
-        chainbase::database reversible(db_dir, database::read_only);  // Test if dirty
+        reversible_block_log reversible(db_dir, reversible_block_log::open_mode::read_only);  // Test if dirty
         // If it reaches here, then the reversible database is not dirty
 
         if(truncate_at_block == 0)
             return false;
 
-        reversible.add_index<reversible_block_index>();
-        const auto& ubi = reversible.get_index<reversible_block_index, by_num>();
-
-        auto itr = ubi.rbegin();
-        if(itr != ubi.rend() && itr->blocknum <= truncate_at_block)
+        if(!reversible.empty() && reversible.end_block_num() - 1 <= truncate_at_block)
             return false;  // Because we are not going to be truncating the reversible database at all.
     }
-    catch(const std::runtime_error&) {
+    catch(const reversible_blocks_exception&) {
     }
     catch(...) {
         throw;
@@ -847,39 +1439,30 @@ chain_plugin::recover_reversible_blocks(const fc::path& db_dir, uint32_t cache_s
 
     ilog("Reconstructing '${reversible_dir}' from backed up reversible directory", ("reversible_dir", reversible_dir));
 
-    chainbase::database old_reversible(backup_dir, database::read_only, 0, true);
-    chainbase::database new_reversible(reversible_dir, database::read_write, cache_size);
-    std::fstream        reversible_blocks;
+    reversible_block_log old_reversible(backup_dir, reversible_block_log::open_mode::read_only, 0, true);
+    reversible_block_log new_reversible(reversible_dir, reversible_block_log::open_mode::read_write, cache_size);
+    std::fstream         reversible_blocks;
     reversible_blocks.open((reversible_dir.parent_path() / std::string("portable-reversible-blocks-").append(now)).generic_string().c_str(),
                            std::ios::out | std::ios::binary);
 
     uint32_t num   = 0;
-    uint32_t start = 0;
-    uint32_t end   = 0;
-    old_reversible.add_index<reversible_block_index>();
-    new_reversible.add_index<reversible_block_index>();
-    const auto& ubi = old_reversible.get_index<reversible_block_index, by_num>();
-    auto        itr = ubi.begin();
-    if(itr != ubi.end()) {
-        start = itr->blocknum;
-        end   = start - 1;
-    }
+    uint32_t start = old_reversible.first_block_num();
+    uint32_t end   = start - 1;
     if(truncate_at_block > 0 && start > truncate_at_block) {
         ilog("Did not recover any reversible blocks since the specified block number to stop at (${stop}) is less than first block in the reversible database (${start}).",
             ("stop", truncate_at_block)("start", start));
         return true;
     }
     try {
-        for(; itr != ubi.end(); ++itr) {
-            EVT_ASSERT(itr->blocknum == end + 1, gap_in_reversible_blocks_db,
+        for(auto n = start; n < old_reversible.end_block_num(); ++n) {
+            auto b = old_reversible.read_block(n);  // unpacking the block acts as additional validation
+            EVT_ASSERT(b, gap_in_reversible_blocks_db,
                        "gap in reversible block database between ${end} and ${blocknum}",
-                       ("end", end)("blocknum", itr->blocknum));
-            reversible_blocks.write(itr->packedblock.data(), itr->packedblock.size());
-            new_reversible.create<reversible_block_object>([&](auto& ubo) {
-                ubo.blocknum = itr->blocknum;
-                ubo.set_block(itr->get_block());  // get_block and set_block rather than copying the packed data acts as additional validation
-            });
-            end = itr->blocknum;
+                       ("end", end)("blocknum", n));
+            auto data = old_reversible.read_packed_block(n);
+            reversible_blocks.write(data.data(), data.size());
+            new_reversible.append(n, data);
+            end = n;
             ++num;
             if(end == truncate_at_block)
                 break;
@@ -909,8 +1492,8 @@ bool
 chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
                                        uint32_t        cache_size,
                                        const fc::path& reversible_blocks_file) {
-    std::fstream        reversible_blocks;
-    chainbase::database new_reversible(reversible_dir, database::read_write, cache_size);
+    std::fstream         reversible_blocks;
+    reversible_block_log new_reversible(reversible_dir, reversible_block_log::open_mode::read_write, cache_size);
     reversible_blocks.open(reversible_blocks_file.generic_string().c_str(), std::ios::in | std::ios::binary);
 
     reversible_blocks.seekg(0, std::ios::end);
@@ -920,12 +1503,11 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
     uint32_t num   = 0;
     uint32_t start = 0;
     uint32_t end   = 0;
-    new_reversible.add_index<reversible_block_index>();
     try {
         while(reversible_blocks.tellg() < end_pos) {
-            signed_block tmp;
-            fc::raw::unpack(reversible_blocks, tmp);
-            num = tmp.block_num();
+            auto tmp = std::make_shared<signed_block>();
+            fc::raw::unpack(reversible_blocks, *tmp);
+            num = tmp->block_num();
 
             if(start == 0) {
                 start = num;
@@ -936,10 +1518,7 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
                            ("end", end)("num", num));
             }
 
-            new_reversible.create<reversible_block_object>([&](auto& ubo) {
-                ubo.blocknum = num;
-                ubo.set_block(std::make_shared<signed_block>(std::move(tmp)));
-            });
+            new_reversible.append(tmp);
             end = num;
         }
     }
@@ -961,30 +1540,22 @@ chain_plugin::import_reversible_blocks(const fc::path& reversible_dir,
 bool
 chain_plugin::export_reversible_blocks(const fc::path& reversible_dir,
                                        const fc::path& reversible_blocks_file) {
-    chainbase::database reversible(reversible_dir, database::read_only, 0, true);
-    std::fstream        reversible_blocks;
+    reversible_block_log reversible(reversible_dir, reversible_block_log::open_mode::read_only, 0, true);
+    std::fstream         reversible_blocks;
     reversible_blocks.open(reversible_blocks_file.generic_string().c_str(), std::ios::out | std::ios::binary);
 
     uint32_t num   = 0;
-    uint32_t start = 0;
-    uint32_t end   = 0;
-    reversible.add_index<reversible_block_index>();
-    const auto& ubi = reversible.get_index<reversible_block_index, by_num>();
-    auto        itr = ubi.begin();
-    if(itr != ubi.end()) {
-        start = itr->blocknum;
-        end   = start - 1;
-    }
+    uint32_t start = reversible.first_block_num();
+    uint32_t end   = start - 1;
     try {
-        for(; itr != ubi.end(); ++itr) {
-            EVT_ASSERT(itr->blocknum == end + 1, gap_in_reversible_blocks_db,
+        for(auto n = start; n < reversible.end_block_num(); ++n) {
+            auto b = reversible.read_block(n);  // Verify that packed block has not been corrupted.
+            EVT_ASSERT(b, gap_in_reversible_blocks_db,
                        "gap in reversible block database between ${end} and ${blocknum}",
-                       ("end", end)("blocknum", itr->blocknum));
-            signed_block                tmp;
-            fc::datastream<const char*> ds(itr->packedblock.data(), itr->packedblock.size());
-            fc::raw::unpack(ds, tmp);  // Verify that packed block has not been corrupted.
-            reversible_blocks.write(itr->packedblock.data(), itr->packedblock.size());
-            end = itr->blocknum;
+                       ("end", end)("blocknum", n));
+            auto data = reversible.read_packed_block(n);
+            reversible_blocks.write(data.data(), data.size());
+            end = n;
             ++num;
         }
     }
@@ -1067,6 +1638,12 @@ get_enabled_plugins() {
 
 read_only::get_info_results
 read_only::get_info(const read_only::get_info_params&) const {
+    if(info) {
+        if(auto i = std::atomic_load(info)) {
+            return *i;
+        }
+    }
+
     auto itoh = [](uint32_t n, size_t hlen = sizeof(uint32_t) << 1) {
         static const char* digits = "0123456789abcdef";
         
@@ -1092,8 +1669,10 @@ read_only::get_info(const read_only::get_info_params&) const {
     };
 }
 
-fc::variant
-read_only::get_block(const read_only::get_block_params& params) const {
+namespace internal {
+
+signed_block_ptr
+fetch_block(const controller& db, const read_only::get_block_params& params) {
     auto block = signed_block_ptr();
     EVT_ASSERT(!params.block_num_or_id.empty() && params.block_num_or_id.size() <= 64,
         chain::block_id_type_exception, "Invalid Block number or ID, must be greater than 0 and less than 64 characters");
@@ -1108,6 +1687,14 @@ read_only::get_block(const read_only::get_block_params& params) const {
     EVT_RETHROW_EXCEPTIONS(chain::block_id_type_exception, "Invalid block ID: ${block_num_or_id}", ("block_num_or_id", params.block_num_or_id))
 
     EVT_ASSERT(block, unknown_block_exception, "Could not find block: ${block}", ("block", params.block_num_or_id));
+    return block;
+}
+
+}  // namespace internal
+
+fc::variant
+read_only::get_block(const read_only::get_block_params& params) const {
+    auto block = internal::fetch_block(db, params);
 
     auto pretty_output = fc::variant();
     db.get_abi_serializer().to_variant(*block, pretty_output, db.get_execution_context());
@@ -1117,6 +1704,13 @@ read_only::get_block(const read_only::get_block_params& params) const {
     return fc::mutable_variant_object(pretty_output.get_object())("id", block->id())("block_num", block->block_num())("ref_block_prefix", ref_block_prefix);
 }
 
+std::string
+read_only::get_block_packed(const read_only::get_block_params& params) const {
+    auto block = internal::fetch_block(db, params);
+    auto data  = fc::raw::pack(*block);
+    return std::string(data.data(), data.size());
+}
+
 fc::variant
 read_only::get_block_header_state(const get_block_header_state_params& params) const {
     block_state_ptr    b;
@@ -1220,35 +1814,39 @@ read_write::push_block(read_write::push_block_params&& params, next_function<rea
     CATCH_AND_CALL(next);
 }
 
+void
+read_write::push_packed_transaction(const packed_transaction_ptr& ptrx, next_function<read_write::push_transaction_results> next) {
+    auto& exec_ctx = db.get_execution_context();
+    app().get_plugin<chain_plugin>().accept_transaction(ptrx, true, [this, next, &exec_ctx](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& result) -> void {
+        if(result.contains<fc::exception_ptr>()) {
+            next(result.get<fc::exception_ptr>());
+        }
+        else {
+            auto trx_trace_ptr = result.get<transaction_trace_ptr>();
+
+            try {
+                auto pretty_output = fc::variant();
+                db.get_abi_serializer().to_variant(*trx_trace_ptr, pretty_output, exec_ctx);
+
+                auto& id = trx_trace_ptr->id;
+                next(read_write::push_transaction_results{id, pretty_output});
+            }
+            CATCH_AND_CALL(next);
+        }
+    });
+}
+
 void
 read_write::push_transaction(const read_write::push_transaction_params& params, next_function<read_write::push_transaction_results> next) {
     try {
         auto  ptrx     = std::make_shared<packed_transaction>();
         auto& exec_ctx = db.get_execution_context();
-        auto  trx_meta = transaction_metadata_ptr();
         try {
             db.get_abi_serializer().from_variant(params, *ptrx, exec_ctx);
-            trx_meta = std::make_shared<transaction_metadata>(ptrx);
         }
         EVT_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
 
-        app().get_method<incoming::methods::transaction_async>()(trx_meta, true, [this, next, &exec_ctx](const fc::static_variant<fc::exception_ptr, transaction_trace_ptr>& result) -> void {
-            if(result.contains<fc::exception_ptr>()) {
-                next(result.get<fc::exception_ptr>());
-            }
-            else {
-                auto trx_trace_ptr = result.get<transaction_trace_ptr>();
-
-                try {
-                    auto pretty_output = fc::variant();
-                    db.get_abi_serializer().to_variant(*trx_trace_ptr, pretty_output, exec_ctx);
-
-                    auto& id = trx_trace_ptr->id;
-                    next(read_write::push_transaction_results{id, pretty_output});
-                }
-                CATCH_AND_CALL(next);
-            }
-        });
+        push_packed_transaction(ptrx, next);
     }
     catch(boost::interprocess::bad_alloc&) {
         chain_plugin::handle_db_exhaustion();
@@ -1259,39 +1857,120 @@ read_write::push_transaction(const read_write::push_transaction_params& params,
     CATCH_AND_CALL(next);
 }
 
-static void
-push_recurse(read_write* rw, int index, const std::shared_ptr<read_write::push_transactions_params>& params, const std::shared_ptr<read_write::push_transactions_results>& results, const next_function<read_write::push_transactions_results>& next) {
-    auto wrapped_next = [=](const fc::static_variant<fc::exception_ptr, read_write::push_transaction_results>& result) {
-        if(result.contains<fc::exception_ptr>()) {
-            const auto& e = result.get<fc::exception_ptr>();
-            results->emplace_back(read_write::push_transaction_results{transaction_id_type(), fc::mutable_variant_object("error", e->to_detail_string())});
-        }
-        else {
-            const auto& r = result.get<read_write::push_transaction_results>();
-            results->emplace_back(r);
-        }
+namespace internal {
 
-        auto next_index = index + 1;
-        if((size_t)next_index < params->size()) {
-            push_recurse(rw, next_index, params, results, next);
-        }
-        else {
-            next(*results);
-        }
+// follows `abi_from_variant::extract` of packed_transaction
+packed_transaction_ptr
+json_to_packed_transaction(const std::string& json, const contracts::abi_serializer& abi, const execution_context& exec_ctx) {
+    auto doc = ::rapidjson::Document();
+    doc.Parse(json.c_str(), json.size());
+    EVT_ASSERT2(!doc.HasParseError() && doc.IsObject(), packed_transaction_type_exception, "Invalid json of packed transaction");
+
+    auto find_member = [&doc](const char* name) -> const contracts::abi_serializer::json_value* {
+        auto it = doc.FindMember(name);
+        return it != doc.MemberEnd() ? &it->value : nullptr;
     };
 
-    rw->push_transaction(params->at(index), wrapped_next);
+    auto sigs = find_member("signatures");
+    auto comp = find_member("compression");
+    EVT_ASSERT(sigs && sigs->IsArray(), packed_transaction_type_exception, "Missing signatures");
+    EVT_ASSERT(comp, packed_transaction_type_exception, "Missing compression");
+
+    auto signatures = signatures_type();
+    for(auto& s : sigs->GetArray()) {
+        EVT_ASSERT(s.IsString(), packed_transaction_type_exception, "Invalid signature");
+        signatures.emplace_back(std::string(s.GetString(), s.GetStringLength()));
+    }
+
+    auto compression = packed_transaction::compression_type();
+    if(comp->IsString()) {
+        fc::from_variant(fc::variant(std::string(comp->GetString(), comp->GetStringLength())), compression);
+    }
+    else {
+        EVT_ASSERT(comp->IsUint(), packed_transaction_type_exception, "Invalid compression");
+        fc::from_variant(fc::variant(comp->GetUint()), compression);
+    }
+
+    auto ptrx = find_member("packed_trx");
+    if(ptrx && ptrx->IsString() && ptrx->GetStringLength() > 0) {
+        auto packed_trx = bytes();
+        fc::from_variant(fc::variant(std::string(ptrx->GetString(), ptrx->GetStringLength())), packed_trx);
+
+        return std::make_shared<packed_transaction>(std::move(packed_trx), std::move(signatures), compression);
+    }
+
+    auto trx = find_member("transaction");
+    EVT_ASSERT(trx, packed_transaction_type_exception, "Missing transaction");
+
+    auto data = bytes(1024 * 1024);
+    auto ds   = fc::datastream<char*>(data.data(), data.size());
+    abi.json_to_binary("transaction", *trx, ds, exec_ctx, true);
+
+    auto strx = signed_transaction();
+    auto rs   = fc::datastream<const char*>(data.data(), ds.tellp());
+    fc::raw::unpack(rs, static_cast<transaction&>(strx));
+    strx.signatures = std::move(signatures);
+
+    return std::make_shared<packed_transaction>(std::move(strx), compression);
+}
+
+}  // namespace internal
+
+void
+read_write::push_transaction(const std::string& json, next_function<read_write::push_transaction_results> next) {
+    try {
+        auto ptrx = packed_transaction_ptr();
+        try {
+            ptrx = internal::json_to_packed_transaction(json, db.get_abi_serializer(), db.get_execution_context());
+        }
+        EVT_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
+
+        push_packed_transaction(ptrx, next);
+    }
+    catch(boost::interprocess::bad_alloc&) {
+        chain_plugin::handle_db_exhaustion();
+    }
+    catch(fc::unrecoverable_exception&) {
+        raise(SIGUSR1);
+    }
+    CATCH_AND_CALL(next);
 }
 
 void
 read_write::push_transactions(const read_write::push_transactions_params& params, next_function<read_write::push_transactions_results> next) {
     try {
         FC_ASSERT(params.size() <= 1000, "Attempt to push too many transactions at once");
-        auto params_copy = std::make_shared<read_write::push_transactions_params>(params.begin(), params.end());
-        auto result      = std::make_shared<read_write::push_transactions_results>();
-        result->reserve(params.size());
+        if(params.empty()) {
+            next(read_write::push_transactions_results());
+            return;
+        }
+
+        // all the transactions are dispatched at once instead of one after the previous one is done,
+        // so their keys are recovered on thread pool in parallel and they're queued together in order.
+        // results are kept in the order of params, callbacks are always invoked on main thread
+        struct batch {
+            read_write::push_transactions_results results;
+            size_t                                pending;
+        };
+        auto b     = std::make_shared<batch>();
+        b->pending = params.size();
+        b->results.resize(params.size());
+
+        for(auto i = 0u; i < params.size(); i++) {
+            push_transaction(params[i], [b, i, next](const fc::static_variant<fc::exception_ptr, read_write::push_transaction_results>& result) {
+                if(result.contains<fc::exception_ptr>()) {
+                    const auto& e = result.get<fc::exception_ptr>();
+                    b->results[i] = read_write::push_transaction_results{transaction_id_type(), fc::mutable_variant_object("error", e->to_detail_string())};
+                }
+                else {
+                    b->results[i] = result.get<read_write::push_transaction_results>();
+                }
 
-        push_recurse(this, 0, params_copy, result, next);
+                if(--b->pending == 0) {
+                    next(b->results);
+                }
+            });
+        }
     }
     CATCH_AND_CALL(next);
 }
@@ -1374,6 +2053,22 @@ read_only::get_required_keys(const get_required_keys_params& params) const {
     return result;
 }
 
+read_only::get_required_keys_batch_result
+read_only::get_required_keys_batch(const get_required_keys_batch_params& params) const {
+    auto trxs = std::vector<transaction>(params.transactions.size());
+    for(auto i = 0u; i < trxs.size(); i++) {
+        try {
+            db.get_abi_serializer().from_variant(params.transactions[i], trxs[i], db.get_execution_context());
+        }
+        EVT_RETHROW_EXCEPTIONS(chain::transaction_type_exception, "Invalid transaction at index: ${i}", ("i",i));
+    }
+
+    auto result          = get_required_keys_batch_result();
+    result.required_keys = db.get_required_keys(trxs, params.available_keys);
+
+    return result;
+}
+
 read_only::get_suspend_required_keys_result
 read_only::get_suspend_required_keys(const get_suspend_required_keys_params& params) const {
     auto result          = get_suspend_required_keys_result();
@@ -1413,6 +2108,28 @@ read_only::get_transaction_ids_for_block(const get_transaction_ids_for_block_par
     return arr;
 }
 
+fc::variant
+read_only::get_deadlines(const get_deadlines_params& params) const {
+    auto limit = params.limit.value_or(1000);
+    FC_ASSERT(limit <= 10000, "Attempt to query too many deadlines at once");
+
+    auto& idx = db.db().get_index<deadline_index, by_due>();
+    auto  it  = idx.lower_bound(boost::make_tuple(params.from.value_or(fc::time_point_sec::min())));
+
+    auto arr = fc::variants();
+    for(; it != idx.end() && it->due <= params.to && arr.size() < limit; it++) {
+        if(params.kind && it->kind != *params.kind) {
+            continue;
+        }
+        arr.emplace_back(fc::mutable_variant_object()
+            ("due", it->due)
+            ("kind", it->kind)
+            ("name", it->name));
+    }
+
+    return arr;
+}
+
 const std::string&
 read_only::get_abi(const get_abi_params&) const {
     static std::string _abi_json;
@@ -1461,10 +2178,55 @@ read_only::get_actions(const get_actions_params&) const {
     }
 }
 
+fc::variant
+read_only::get_trx_latency(const get_trx_latency_params&) const {
+    EVT_ASSERT(latency, plugin_config_exception, "Latency tracing is not enabled, set `trx-latency-sample-rate` to enable it");
+    return latency->to_variant();
+}
+
+fc::variant
+read_only::get_action_costs(const get_action_costs_params&) const {
+    return db.get_action_costs().to_variant();
+}
+
+fc::variant
+read_only::get_memory_usage(const get_memory_usage_params& params) const {
+    auto& accounting = memory_accounting::instance();
+    EVT_ASSERT(accounting.enabled(), plugin_config_exception, "Memory accounting is not enabled, set `memory-accounting` to enable it");
+
+    auto r = fc::mutable_variant_object(accounting.report().get_object());
+    if(params.heap_profile) {
+        auto f = bfs::path(*params.heap_profile);
+        f      = f.is_relative() ? app().data_dir() / f : f;
+        EVT_ASSERT(accounting.dump_heap_profile(f.generic_string()), plugin_config_exception,
+            "Heap profile cannot be dumped, evtd should run with jemalloc and `MALLOC_CONF=prof:true`");
+        r("heap_profile", f.generic_string());
+    }
+    return r;
+}
+
 std::string
 read_only::get_db_info(const get_db_info_params&) const {
     return db.token_db().stats();
 }
 
+fc::variant
+read_only::get_db_metrics(const get_db_metrics_params&) const {
+    auto& tokendb = db.token_db();
+
+    auto info = fc::mutable_variant_object();
+    if(auto m = tokendb.metrics()) {
+        info("metrics", m->to_variant());
+    }
+    if(tokendb.state_hash_enabled()) {
+        info("state_hash", tokendb.state_hash());
+        info("head_block_num", db.head_block_num());
+    }
+    if(auto hk = tokendb.hot_keys(); !hk.is_null()) {
+        info("hot_keys", std::move(hk));
+    }
+    return info;
+}
+
 }  // namespace chain_apis
 }  // namespace evt
@@ -8,6 +8,7 @@
 #include <evt/chain/block.hpp>
 #include <evt/chain/version.hpp>
 #include <evt/chain/controller.hpp>
+#include <evt/chain/deadline_object.hpp>
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/plugin_interface.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
@@ -21,6 +22,8 @@ class variant;
 }
 
 namespace evt {
+class trx_latency_tracker;
+
 using namespace appbase;
 using std::unique_ptr;
 using std::optional;
@@ -48,13 +51,20 @@ template <typename>
 struct resolver_factory;
 
 class read_only {
+public:
+    struct get_info_results;
+    using info_ptr = std::shared_ptr<const get_info_results>;
+
 public:
     const controller& db;
+    const info_ptr*   info = nullptr;
+    const trx_latency_tracker* latency = nullptr;
     bool  shorten_abi_errors = true;
 
 public:
-    read_only(const controller& db)
-        : db(db) {}
+    // `get_info` returns the one published in `info` if it's set, then it can be called from any thread
+    read_only(const controller& db, const info_ptr* info = nullptr, const trx_latency_tracker* latency = nullptr)
+        : db(db), info(info), latency(latency) {}
 
     void set_shorten_abi_errors(bool f) { shorten_abi_errors = f; }
 
@@ -114,6 +124,16 @@ public:
     };
     get_required_keys_result get_required_keys(const get_required_keys_params& params) const;
 
+    // same as `get_required_keys` for many transactions signed by the same available keys
+    struct get_required_keys_batch_params {
+        std::vector<fc::variant> transactions;
+        public_keys_set          available_keys;
+    };
+    struct get_required_keys_batch_result {
+        std::vector<public_keys_set> required_keys;  // in the order of transactions
+    };
+    get_required_keys_batch_result get_required_keys_batch(const get_required_keys_batch_params& params) const;
+
     struct get_suspend_required_keys_params {
         proposal_name             name;
         public_keys_set  available_keys;
@@ -136,6 +156,8 @@ public:
         string block_num_or_id;
     };
     fc::variant get_block(const get_block_params& params) const;
+    // block in fc::raw packed form, no abi conversion is involved
+    std::string get_block_packed(const get_block_params& params) const;
 
     struct get_block_header_state_params {
         string block_num_or_id;
@@ -162,6 +184,15 @@ public:
     };
     fc::variant get_transaction_ids_for_block(const get_transaction_ids_for_block_params& params) const;
 
+    // pending locks, suspends and bonus rounds due within [from, to], ordered by time
+    struct get_deadlines_params {
+        optional<fc::time_point_sec>   from;
+        fc::time_point_sec             to;
+        optional<chain::deadline_kind> kind;
+        optional<uint32_t>             limit;  // 1000 by default
+    };
+    fc::variant get_deadlines(const get_deadlines_params& params) const;
+
     using get_abi_params = empty;
     const std::string& get_abi(const get_abi_params&) const;
 
@@ -170,6 +201,24 @@ public:
 
     using get_db_info_params = empty;
     std::string get_db_info(const get_db_info_params&) const;
+
+    // metrics, state hash and hot keys of token database, each is only present when it's enabled
+    using get_db_metrics_params = empty;
+    fc::variant get_db_metrics(const get_db_metrics_params&) const;
+
+    // histograms of the time between the stages of sampled transactions
+    using get_trx_latency_params = empty;
+    fc::variant get_trx_latency(const get_trx_latency_params&) const;
+
+    // rolling costs of each action type executed by this node
+    using get_action_costs_params = empty;
+    fc::variant get_action_costs(const get_action_costs_params&) const;
+
+    struct get_memory_usage_params {
+        // also dumps the sampled allocation stacks into this file (relative to data dir)
+        std::optional<std::string> heap_profile;
+    };
+    fc::variant get_memory_usage(const get_memory_usage_params& params) const;
 };
 
 class read_write {
@@ -190,11 +239,16 @@ public:
         fc::variant         processed;
     };
     void push_transaction(const push_transaction_params& params, chain::plugin_interface::next_function<push_transaction_results> next);
+    // same as above but packs the transaction from the request body without building variants
+    void push_transaction(const std::string& json, chain::plugin_interface::next_function<push_transaction_results> next);
 
     using push_transactions_params  = vector<push_transaction_params>;
     using push_transactions_results = vector<push_transaction_results>;
     void push_transactions(const push_transactions_params& params, chain::plugin_interface::next_function<push_transactions_results> next);
 
+private:
+    void push_packed_transaction(const chain::packed_transaction_ptr& ptrx, chain::plugin_interface::next_function<push_transaction_results> next);
+
     friend resolver_factory<read_write>;
 };
 }  // namespace chain_apis
@@ -218,6 +272,8 @@ public:
     void accept_block(const chain::signed_block_ptr& block );
     void accept_transaction(const chain::packed_transaction& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
     void accept_transaction(const chain::transaction_metadata_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
+    // duplicates of one transaction which is pushed or processed recently are answered by its result
+    void accept_transaction(const chain::packed_transaction_ptr& trx, bool persist_until_expired, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
 
     bool block_is_on_preferred_chain(const chain::block_id_type& block_id);
 
@@ -254,9 +310,11 @@ FC_REFLECT(evt::chain_apis::read_only::get_info_results,
           (server_version)(chain_id)(evt_api_version)(head_block_num)(last_irreversible_block_num)(last_irreversible_block_id)
           (head_block_id)(head_block_time)(head_block_producer)(enabled_plugins)(server_version_string));
 FC_REFLECT(evt::chain_apis::read_only::get_block_params, (block_num_or_id));
+FC_REFLECT(evt::chain_apis::read_only::get_memory_usage_params, (heap_profile));
 FC_REFLECT(evt::chain_apis::read_only::get_block_header_state_params, (block_num_or_id));
 FC_REFLECT(evt::chain_apis::read_only::get_transaction_params, (block_num)(id));
 FC_REFLECT(evt::chain_apis::read_only::get_trx_id_for_link_id_params, (link_id));
+FC_REFLECT(evt::chain_apis::read_only::get_deadlines_params, (from)(to)(kind)(limit));
 FC_REFLECT(evt::chain_apis::read_only::producer_info, (producer_name));
 FC_REFLECT(evt::chain_apis::read_only::abi_json_to_bin_params, (action)(args));
 FC_REFLECT(evt::chain_apis::read_only::abi_json_to_bin_result, (binargs));
@@ -265,6 +323,8 @@ FC_REFLECT(evt::chain_apis::read_only::abi_bin_to_json_result, (args));
 FC_REFLECT(evt::chain_apis::read_only::trx_json_to_digest_result, (digest)(id));
 FC_REFLECT(evt::chain_apis::read_only::get_required_keys_params, (transaction)(available_keys));
 FC_REFLECT(evt::chain_apis::read_only::get_required_keys_result, (required_keys));
+FC_REFLECT(evt::chain_apis::read_only::get_required_keys_batch_params, (transactions)(available_keys));
+FC_REFLECT(evt::chain_apis::read_only::get_required_keys_batch_result, (required_keys));
 FC_REFLECT(evt::chain_apis::read_only::get_suspend_required_keys_params, (name)(available_keys));
 FC_REFLECT(evt::chain_apis::read_only::get_suspend_required_keys_result, (required_keys));
 FC_REFLECT(evt::chain_apis::read_only::get_charge_params, (transaction)(sigs_num));
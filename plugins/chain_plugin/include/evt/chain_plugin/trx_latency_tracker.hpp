@@ -0,0 +1,70 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <array>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/variant.hpp>
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+
+namespace evt {
+
+/**
+ *  Follows sampled transactions from ingress to irreversibility and collects the time spent
+ *  between the stages in histograms. Time points are carried by `transaction_metadata::timestamps`
+ *  and filled by the plugins and controller along the path.
+ *
+ *  Transactions are tracked by id, so the ones included by blocks from peers are matched as well.
+ *  Fully traced ones are also written as json lines into trace file if it's provided.
+ *  Only used from main thread.
+ */
+class trx_latency_tracker : boost::noncopyable {
+public:
+    using histogram   = chain::token_database_metrics::histogram;
+    using source_type = chain::trx_timestamps::source_type;
+
+    // intervals between the stages, the last one is from received to irreversible
+    enum interval { kQueue = 0, kWait, kExec, kInclude, kIrreversible, kTotal, kIntervalsNum };
+
+public:
+    trx_latency_tracker(uint32_t sample_rate, const std::optional<fc::path>& trace_file);
+
+public:
+    // starts timestamps of `trx` if it's sampled, it should be called before it's shared with other threads
+    void sample(const chain::transaction_metadata_ptr& trx, source_type source);
+
+    void on_accepted_block(const chain::block_state_ptr& bs);
+    void on_irreversible_block(const chain::block_state_ptr& bs);
+
+    fc::variant to_variant() const;
+
+private:
+    void complete(const chain::transaction_metadata_ptr& trx, uint32_t block_num);
+
+private:
+    uint32_t sample_rate_;
+    uint64_t seen_ = 0;
+
+    // sampled ones not irreversible yet
+    std::unordered_map<chain::transaction_id_type, chain::transaction_metadata_ptr> sampled_;
+    std::multimap<fc::time_point_sec, chain::transaction_id_type>                   expiry_;
+    // included ones by block num, waiting for the block being irreversible
+    std::map<uint32_t, std::vector<chain::transaction_metadata_ptr>>                included_;
+
+    std::array<histogram, kIntervalsNum> intervals_;
+
+    uint64_t completed_ = 0;
+    uint64_t dropped_   = 0;
+
+    std::optional<fc::path> trace_file_;
+    std::ofstream           trace_;
+};
+
+}  // namespace evt
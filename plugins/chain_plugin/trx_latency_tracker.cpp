@@ -0,0 +1,167 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/chain_plugin/trx_latency_tracker.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt {
+
+using namespace chain;
+
+namespace internal {
+
+enum { kMaxSampled = 100'000 };
+
+const char* kIntervalNames[] = { "queue", "wait", "exec", "include", "irreversible", "total" };
+const char* kStageNames[]    = { "received", "queued", "exec_start", "exec_end", "included", "irreversible" };
+
+// stages at the two ends of each interval
+const std::pair<trx_timestamps::stage, trx_timestamps::stage> kIntervalStages[] = {
+    { trx_timestamps::received,   trx_timestamps::queued       },
+    { trx_timestamps::queued,     trx_timestamps::exec_start   },
+    { trx_timestamps::exec_start, trx_timestamps::exec_end     },
+    { trx_timestamps::exec_end,   trx_timestamps::included     },
+    { trx_timestamps::included,   trx_timestamps::irreversible },
+    { trx_timestamps::received,   trx_timestamps::irreversible }
+};
+
+fc::variant
+to_variant(const trx_latency_tracker::histogram& h) {
+    return fc::mutable_variant_object()
+        ("count", h.count)
+        ("avg_us", h.count ? h.sum_us / h.count : 0)
+        ("max_us", h.max_us)
+        ("buckets", std::vector<uint64_t>(h.buckets.cbegin(), h.buckets.cend()));
+}
+
+}  // namespace internal
+
+trx_latency_tracker::trx_latency_tracker(uint32_t sample_rate, const std::optional<fc::path>& trace_file)
+    : sample_rate_(std::max<uint32_t>(sample_rate, 1))
+    , trace_file_(trace_file) {
+    if(trace_file_) {
+        trace_.open(trace_file_->generic_string(), std::ios::out | std::ios::app);
+        EVT_ASSERT(trace_, plugin_config_exception, "Cannot open trace file '${f}'", ("f", *trace_file_));
+    }
+}
+
+void
+trx_latency_tracker::sample(const transaction_metadata_ptr& trx, source_type source) {
+    if(seen_++ % sample_rate_ != 0 || trx->timestamps) {
+        return;
+    }
+    if(sampled_.size() >= internal::kMaxSampled) {
+        dropped_++;
+        return;
+    }
+    if(!sampled_.emplace(trx->id, trx).second) {
+        return;
+    }
+
+    trx->timestamps = std::make_unique<trx_timestamps>();
+    trx->timestamps->source = source;
+    trx->timestamps->mark(trx_timestamps::received);
+    expiry_.emplace(trx->packed_trx->expiration(), trx->id);
+}
+
+void
+trx_latency_tracker::on_accepted_block(const block_state_ptr& bs) {
+    if(sampled_.empty()) {
+        return;
+    }
+    for(auto& trx : bs->trxs) {
+        auto it = sampled_.find(trx->id);
+        if(it == sampled_.end()) {
+            continue;
+        }
+        // the one included again after a fork is moved to the new block
+        auto& ts = *it->second->timestamps;
+        ts.mark(trx_timestamps::included);
+        ts.block_id = bs->id;
+        included_[bs->block_num].emplace_back(it->second);
+    }
+}
+
+void
+trx_latency_tracker::on_irreversible_block(const block_state_ptr& bs) {
+    while(!included_.empty() && included_.begin()->first <= bs->block_num) {
+        auto trxs = std::move(included_.begin()->second);
+        auto num  = included_.begin()->first;
+        included_.erase(included_.begin());
+
+        for(auto& trx : trxs) {
+            // ones of the forked out blocks are left for the blocks including them again
+            if(num == bs->block_num && trx->timestamps->block_id == bs->id) {
+                complete(trx, num);
+            }
+        }
+    }
+
+    // ones never included before expired
+    auto now = fc::time_point_sec(bs->header.timestamp.to_time_point());
+    while(!expiry_.empty() && expiry_.begin()->first < now) {
+        if(sampled_.erase(expiry_.begin()->second)) {
+            dropped_++;
+        }
+        expiry_.erase(expiry_.begin());
+    }
+}
+
+void
+trx_latency_tracker::complete(const transaction_metadata_ptr& trx, uint32_t block_num) {
+    using namespace internal;
+
+    auto& ts = *trx->timestamps;
+    ts.mark(trx_timestamps::irreversible);
+
+    for(auto i = 0; i < kIntervalsNum; i++) {
+        auto [from, to] = kIntervalStages[i];
+        if(ts.has(from) && ts.has(to) && ts.points[to] >= ts.points[from]) {
+            intervals_[i].add((ts.points[to] - ts.points[from]).count());
+        }
+    }
+    completed_++;
+
+    if(trace_.is_open()) {
+        auto points = fc::mutable_variant_object();
+        for(auto i = 0; i < trx_timestamps::stages_num; i++) {
+            if(ts.has((trx_timestamps::stage)i)) {
+                points(kStageNames[i], ts.points[i]);
+            }
+        }
+        auto line = fc::mutable_variant_object()
+            ("id", trx->id)
+            ("source", ts.source == trx_timestamps::http ? "http" : "net")
+            ("block_num", block_num)
+            ("stages", std::move(points));
+        trace_ << fc::json::to_string(line) << "\n";
+        trace_.flush();
+    }
+
+    sampled_.erase(trx->id);
+}
+
+fc::variant
+trx_latency_tracker::to_variant() const {
+    using namespace internal;
+
+    auto intervals = fc::mutable_variant_object();
+    for(auto i = 0; i < kIntervalsNum; i++) {
+        intervals(kIntervalNames[i], internal::to_variant(intervals_[i]));
+    }
+
+    return fc::mutable_variant_object()
+        ("sample_rate", sample_rate_)
+        ("seen", seen_)
+        ("pending", sampled_.size())
+        ("completed", completed_)
+        ("dropped", dropped_)
+        ("intervals", std::move(intervals));
+}
+
+}  // namespace evt
@@ -45,6 +45,24 @@ evt_api_plugin::plugin_initialize(const variables_map&) {}
             }                                                                                                                 \
     }
 
+// takes the same params as `call_name` and responds with the packed result of `call_name##_packed`
+#define CALL_PACKED(api_name, api_handle, api_namespace, call_name)                                                           \
+    {                                                                                                                         \
+        std::string("/v1/" #api_name "/" #call_name),                                                                         \
+            [api_handle](string, string body, url_response_callback cb) mutable {                                            \
+                try {                                                                                                         \
+                    if(body.empty())                                                                                          \
+                        body = "{}";                                                                                          \
+                    auto result = api_handle.call_name##_packed(fc::json::from_string(body).as<api_namespace::call_name##_params>()); \
+                    cb(200, std::move(result));                                                                               \
+                }                                                                                                             \
+                catch (...) {                                                                                                 \
+                    http_plugin::handle_exception(#api_name, #call_name, body, cb);                                           \
+                }                                                                                                             \
+            }                                                                                                                 \
+    }
+
+#define EVT_RO_CALL_PACKED(call_name) CALL_PACKED(evt, ro_api, evt_apis::read_only, call_name)
 #define EVT_RO_CALL(call_name, http_response_code) CALL(evt, ro_api, evt_apis::read_only, call_name, http_response_code)
 #define EVT_RW_CALL(call_name, http_response_code) CALL(evt, rw_api, evt_apis::read_write, call_name, http_response_code)
 
@@ -54,15 +72,30 @@ evt_api_plugin::plugin_startup() {
     my.reset(new evt_api_plugin_impl(app().get_plugin<chain_plugin>().chain()));
     auto ro_api = app().get_plugin<evt_plugin>().get_read_only_api();
 
-    app().get_plugin<http_plugin>().add_api({EVT_RO_CALL(get_domain, 200),
-                                             EVT_RO_CALL(get_group, 200),
-                                             EVT_RO_CALL(get_token, 200),
-                                             EVT_RO_CALL(get_tokens, 200),
-                                             EVT_RO_CALL(get_fungible, 200),
-                                             EVT_RO_CALL(get_fungible_balance, 200),
-                                             EVT_RO_CALL(get_fungible_psvbonus, 200),
-                                             EVT_RO_CALL(get_suspend, 200),
-                                             EVT_RO_CALL(get_lock, 200),
+    // these apis are served from the read view of token database, no need to occupy main thread
+    app().get_plugin<http_plugin>().add_concurrent_api({EVT_RO_CALL(get_domain, 200),
+                                                        EVT_RO_CALL(get_group, 200),
+                                                        EVT_RO_CALL(get_token, 200),
+                                                        EVT_RO_CALL(get_tokens, 200),
+                                                        EVT_RO_CALL(get_tokens_by_names, 200),
+                                                        EVT_RO_CALL(get_tokens_by_owner, 200),
+                                                        EVT_RO_CALL(get_fungible, 200),
+                                                        EVT_RO_CALL(get_fungible_balance, 200),
+                                                        EVT_RO_CALL(get_fungible_balances, 200),
+                                                        EVT_RO_CALL(get_fungible_psvbonus, 200),
+                                                        EVT_RO_CALL(get_lock, 200),
+                                                    });
+
+    // served instead when client accepts `application/octet-stream`
+    app().get_plugin<http_plugin>().add_binary_api({EVT_RO_CALL_PACKED(get_domain),
+                                                    EVT_RO_CALL_PACKED(get_group),
+                                                    EVT_RO_CALL_PACKED(get_token),
+                                                    EVT_RO_CALL_PACKED(get_fungible),
+                                                   }, true /* concurrent */);
+
+    // abi serializer is required by `get_suspend` and holders index is not in read view, keep them in main thread
+    app().get_plugin<http_plugin>().add_api({EVT_RO_CALL(get_suspend, 200),
+                                             EVT_RO_CALL(get_fungible_holders, 200),
                                          });
 }
 
@@ -4,15 +4,19 @@
  */
 #include <evt/evt_link_plugin/evt_link_plugin.hpp>
 
+#include <algorithm>
 #include <deque>
+#include <set>
 #include <tuple>
 #include <chrono>
 #include <unordered_map>
 #include <thread>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/city.hpp>
+#include <fc/crypto/hex.hpp>
 
 #include <evt/chain_plugin/chain_plugin.hpp>
 #include <evt/chain/plugin_interface.hpp>
@@ -20,6 +24,7 @@
 #include <evt/chain/types.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
+#include <evt/chain/contracts/types.hpp>
 
 namespace evt {
 
@@ -29,11 +34,20 @@ using evt::chain::bytes;
 using evt::chain::link_id_type;
 using evt::chain::block_state_ptr;
 using evt::chain::transaction_trace_ptr;
+using evt::chain::small_vector;
+using evt::chain::action;
+using evt::chain::address;
 using evt::chain::contracts::evt_link;
 using evt::chain::contracts::everipay;
+using evt::chain::contracts::issuefungible;
+using evt::chain::contracts::transferft;
+using evt::chain::contracts::batchtransft;
+using evt::chain::contracts::recycleft;
+using evt::chain::contracts::destroyft;
+using evt::chain::contracts::evt2pevt;
+using evt::chain::contracts::paybonus;
 
 using boost::asio::steady_timer;
-using steady_timer_ptr = std::shared_ptr<steady_timer>;
 
 struct evt_link_id_hasher {
     size_t
@@ -42,14 +56,58 @@ struct evt_link_id_hasher {
     }
 };
 
+// waiters are expired by one timer ticking over the slots of wheel instead of one timer per request
+// all of them have the same timeout, so the slot is determined by the time they're added only
+class waiter_wheel {
+public:
+    using entry = std::pair<link_id_type, deferred_id>;
+
+public:
+    void
+    reset(size_t slots) {
+        slots_.resize(std::max<size_t>(slots, 2));
+    }
+
+    // entry is expired after `slots - 1` ticks
+    void
+    add(const link_id_type& link_id, deferred_id id) {
+        slots_[(cursor_ + slots_.size() - 1) % slots_.size()].emplace_back(link_id, id);
+        size_++;
+    }
+
+    std::vector<entry>
+    tick() {
+        cursor_ = (cursor_ + 1) % slots_.size();
+
+        auto expired = std::move(slots_[cursor_]);
+        slots_[cursor_].clear();
+        size_ -= expired.size();
+        return expired;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+private:
+    std::vector<std::vector<entry>> slots_;
+    size_t                          cursor_ = 0;
+    size_t                          size_   = 0;
+};
+
 class evt_link_plugin_impl : public std::enable_shared_from_this<evt_link_plugin_impl> {
 public:
-    using deferred_pair = std::pair<deferred_id, steady_timer_ptr>;
-    enum { kDeferredId = 0, kTimer };
+    using deferred_ids  = small_vector<deferred_id, 2>;
+    using websocket_ids = small_vector<websocket_id, 2>;
+
+    // subscriptions of one websocket connection, they're dropped when it's closed
+    struct subscription {
+        std::set<link_id_type> link_ids;
+        std::set<std::string>  addresses;
+    };
 
 public:
     evt_link_plugin_impl(controller& db)
-        : db_(db) {}
+        : db_(db)
+        , timer_(app().get_io_service()) {}
     ~evt_link_plugin_impl();
 
 public:
@@ -57,8 +115,13 @@ public:
     void get_trx_id_for_link_id(const link_id_type& link_id, deferred_id id);
     void add_and_schedule(const link_id_type& link_id, deferred_id id);
 
+    void on_websocket_message(websocket_id id, const std::string& message);
+    void on_websocket_close(websocket_id id);
+
 private:
-    void applied_block(const block_state_ptr& bs);
+    void applied_block(const block_state_ptr& bs, bool irreversible);
+    void schedule_tick();
+    void expire(const std::vector<waiter_wheel::entry>& entries);
 
     template<typename T>
     void response(const link_id_type& link_id, T&& response_fun);
@@ -68,44 +131,269 @@ public:
 
     std::atomic_bool init_{false};
     uint32_t         timeout_;
+    uint32_t         tick_;
+
+    std::unordered_map<link_id_type, deferred_ids, evt_link_id_hasher> link_ids_;
+
+    waiter_wheel             wheel_;
+    steady_timer             timer_;
+    steady_timer::time_point next_tick_;
+    bool                     ticking_ = false;
+
+    uint32_t max_subscriptions_;
 
-    std::unordered_multimap<link_id_type, deferred_pair, evt_link_id_hasher> link_ids_;
+    std::unordered_map<websocket_id, subscription>                      subs_;
+    std::unordered_map<link_id_type, websocket_ids, evt_link_id_hasher> link_subs_;
+    std::unordered_map<std::string, websocket_ids>                      addr_subs_;
 
     std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
 };
 
+namespace internal {
+
+// addresses of the fungible actions whose balances are changed by them
+void
+get_action_addresses(const action& act, small_vector<address, 4>& addrs) {
+    switch(act.name.value) {
+    case N(issuefungible): {
+        addrs.emplace_back(act.data_as<const issuefungible&>().address);
+        break;
+    }
+    case N(transferft): {
+        auto& tf = act.data_as<const transferft&>();
+        addrs.emplace_back(tf.from);
+        addrs.emplace_back(tf.to);
+        break;
+    }
+    case N(batchtransft): {
+        auto& bt = act.data_as<const batchtransft&>();
+        addrs.emplace_back(bt.from);
+        for(auto& c : bt.credits) {
+            addrs.emplace_back(c.to);
+        }
+        break;
+    }
+    case N(recycleft): {
+        addrs.emplace_back(act.data_as<const recycleft&>().address);
+        break;
+    }
+    case N(destroyft): {
+        addrs.emplace_back(act.data_as<const destroyft&>().address);
+        break;
+    }
+    case N(evt2pevt): {
+        auto& ep = act.data_as<const evt2pevt&>();
+        addrs.emplace_back(ep.from);
+        addrs.emplace_back(ep.to);
+        break;
+    }
+    case N(everipay): {
+        addrs.emplace_back(act.data_as<const everipay&>().payee);
+        break;
+    }
+    case N(paybonus): {
+        addrs.emplace_back(act.data_as<const paybonus&>().payer);
+        break;
+    }
+    }  // switch
+}
+
+template<typename Map, typename Key>
 void
-evt_link_plugin_impl::applied_block(const block_state_ptr& bs) {
-    if(link_ids_.empty()) {
+remove_subscriber(Map& subs, const Key& key, websocket_id id) {
+    auto it = subs.find(key);
+    if(it == subs.end()) {
         return;
     }
+    auto& ids = it->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if(ids.empty()) {
+        subs.erase(it);
+    }
+}
+
+}  // namespace internal
 
-    for(auto& trx : bs->trxs) {
-        for(auto& act : trx->packed_trx->get_transaction().actions) {
-            if(act.name != N(everipay)) {
+void
+evt_link_plugin_impl::applied_block(const block_state_ptr& bs, bool irreversible) {
+    auto waiters = !irreversible && !link_ids_.empty();
+    if(!waiters && link_subs_.empty() && addr_subs_.empty()) {
+        return;
+    }
+
+    auto& http = app().get_plugin<http_plugin>();
+    auto  push = [&](const websocket_ids& ids, fc::mutable_variant_object& vo, size_t trx_idx) {
+        vo["block_num"]    = bs->block_num;
+        vo["block_id"]     = bs->id;
+        vo["trx_id"]       = bs->trxs[trx_idx]->id;
+        vo["irreversible"] = irreversible;
+
+        auto json = fc::json::to_string(vo);
+        for(auto id : ids) {
+            http.send_websocket_message(id, json);
+        }
+    };
+
+    // link ids of everipay in block, the data of actions is decoded already when they're applied
+    auto links = small_vector<std::pair<link_id_type, size_t>, 4>();
+    auto addrs = small_vector<address, 4>();
+    for(auto i = 0u; i < bs->trxs.size(); i++) {
+        for(auto& act : bs->trxs[i]->packed_trx->get_transaction().actions) {
+            if(act.name == N(everipay)) {
+                links.emplace_back(act.data_as<const everipay&>().link.get_link_id(), i);
+            }
+            if(addr_subs_.empty() || act.domain != N128(.fungible)) {
                 continue;
             }
 
-            auto& epact = act.data_as<const everipay&>();
+            addrs.clear();
+            internal::get_action_addresses(act, addrs);
+            for(auto& addr : addrs) {
+                auto str = addr.to_string();
+                auto it  = addr_subs_.find(str);
+                if(it == addr_subs_.end()) {
+                    continue;
+                }
+
+                auto vo       = fc::mutable_variant_object();
+                vo["type"]    = "action";
+                vo["address"] = str;
+                vo["name"]    = act.name;
+                vo["domain"]  = act.domain;
+                vo["key"]     = act.key;
+                push(it->second, vo, i);
+            }
+        }
+    }
 
-            response(epact.link.get_link_id(), [&] {
+    for(auto& l : links) {
+        if(waiters) {
+            response(l.first, [&] {
                 auto vo         = fc::mutable_variant_object();
                 vo["block_num"] = bs->block_num;
                 vo["block_id"]  = bs->id;
-                vo["trx_id"]    = trx->id;
+                vo["trx_id"]    = bs->trxs[l.second]->id;
                 vo["err_code"]  = 0;
 
                 return fc::json::to_string(vo);
             });
         }
+
+        auto it = link_subs_.find(l.first);
+        if(it == link_subs_.end()) {
+            continue;
+        }
+
+        auto vo       = fc::mutable_variant_object();
+        vo["type"]    = "everipay";
+        vo["link_id"] = fc::to_hex((char*)&l.first, sizeof(l.first));
+        push(it->second, vo, l.second);
+
+        if(irreversible) {
+            // link is paid only once, nothing will be pushed after it's irreversible
+            for(auto id : it->second) {
+                subs_[id].link_ids.erase(l.first);
+            }
+            link_subs_.erase(it);
+        }
+    }
+}
+
+void
+evt_link_plugin_impl::on_websocket_message(websocket_id id, const std::string& message) {
+    auto reply = fc::mutable_variant_object();
+    try {
+        auto var = fc::json::from_string(message);
+        auto op  = var["op"].as_string();
+        EVT_ASSERT(op == "subscribe" || op == "unsubscribe", chain::evt_link_plugin_exception,
+            "Unknown op: ${op}, only 'subscribe' and 'unsubscribe' are supported", ("op", op));
+
+        auto link_ids = std::vector<link_id_type>();
+        if(var.get_object().contains("link_ids")) {
+            for(auto& v : var["link_ids"].get_array()) {
+                auto b = bytes();
+                fc::from_variant(v, b);
+                if(b.size() != sizeof(link_id_type)) {
+                    EVT_THROW(chain::evt_link_id_exception, "EVT-Link id is not in proper length");
+                }
+
+                auto link_id = link_id_type();
+                memcpy(&link_id, b.data(), sizeof(link_id_type));
+                link_ids.emplace_back(link_id);
+            }
+        }
+
+        auto addrs = std::vector<std::string>();
+        if(var.get_object().contains("addresses")) {
+            for(auto& v : var["addresses"].get_array()) {
+                // normalized so they're matched with the ones in actions
+                addrs.emplace_back(address::from_string(v.as_string()).to_string());
+            }
+        }
+
+        auto& sub = subs_[id];
+        if(op == "subscribe") {
+            EVT_ASSERT(sub.link_ids.size() + sub.addresses.size() + link_ids.size() + addrs.size() <= max_subscriptions_,
+                chain::evt_link_plugin_exception, "Exceed max subscriptions of one connection: ${n}", ("n", max_subscriptions_));
+            for(auto& l : link_ids) {
+                if(sub.link_ids.emplace(l).second) {
+                    link_subs_[l].emplace_back(id);
+                }
+            }
+            for(auto& a : addrs) {
+                if(sub.addresses.emplace(a).second) {
+                    addr_subs_[a].emplace_back(id);
+                }
+            }
+        }
+        else {
+            for(auto& l : link_ids) {
+                if(sub.link_ids.erase(l)) {
+                    internal::remove_subscriber(link_subs_, l, id);
+                }
+            }
+            for(auto& a : addrs) {
+                if(sub.addresses.erase(a)) {
+                    internal::remove_subscriber(addr_subs_, a, id);
+                }
+            }
+        }
+
+        reply["type"]      = op;
+        reply["link_ids"]  = sub.link_ids.size();
+        reply["addresses"] = sub.addresses.size();
+    }
+    catch(const fc::exception& e) {
+        reply["type"]  = "error";
+        reply["error"] = error_results::error_info(e, app().get_plugin<http_plugin>().verbose_errors());
     }
+    catch(const std::exception& e) {
+        reply["type"]  = "error";
+        reply["error"] = e.what();
+    }
+    app().get_plugin<http_plugin>().send_websocket_message(id, fc::json::to_string(reply));
+}
+
+void
+evt_link_plugin_impl::on_websocket_close(websocket_id id) {
+    auto it = subs_.find(id);
+    if(it == subs_.end()) {
+        return;
+    }
+    for(auto& l : it->second.link_ids) {
+        internal::remove_subscriber(link_subs_, l, id);
+    }
+    for(auto& a : it->second.addresses) {
+        internal::remove_subscriber(addr_subs_, a, id);
+    }
+    subs_.erase(it);
 }
 
 template<typename T>
 void
 evt_link_plugin_impl::response(const link_id_type& link_id, T&& response_fun) {
-    auto sz = link_ids_.count(link_id);
-    if(sz == 0) {
+    if(link_ids_.find(link_id) == link_ids_.end()) {
         return;
     }
     auto json = response_fun();
@@ -115,56 +403,87 @@ evt_link_plugin_impl::response(const link_id_type& link_id, T&& response_fun) {
         if(!self) {
             return;
         }
-        auto pair = self->link_ids_.equal_range(link_id);
-        if(pair.first != self->link_ids_.end()) {
-            std::for_each(pair.first, pair.second, [&](auto& it) {
-                app().get_plugin<http_plugin>().set_deferred_response(std::get<kDeferredId>(it.second), 200, json);
-            });
-
-            self->link_ids_.erase(link_id);
+        auto it = self->link_ids_.find(link_id);
+        if(it == self->link_ids_.end()) {
             return;
         }
+        for(auto id : it->second) {
+            app().get_plugin<http_plugin>().set_deferred_response(id, 200, json);
+        }
+        // entries left in wheel are skipped when they're expired
+        self->link_ids_.erase(it);
     });
 }
 
 void
 evt_link_plugin_impl::add_and_schedule(const link_id_type& link_id, deferred_id id) {
-    auto it = link_ids_.emplace(link_id, std::make_pair(id, std::make_shared<steady_timer>(app().get_io_service())));
+    link_ids_[link_id].emplace_back(id);
+    wheel_.add(link_id, id);
+
+    if(!ticking_) {
+        ticking_   = true;
+        next_tick_ = steady_timer::clock_type::now();
+        schedule_tick();
+    }
+}
+
+void
+evt_link_plugin_impl::schedule_tick() {
+    // ticks are scheduled from the last one rather than now to avoid drifting
+    next_tick_ += std::chrono::milliseconds(tick_);
+    timer_.expires_at(next_tick_);
 
-    auto timer = std::get<kTimer>(it->second);
-    timer->expires_from_now(std::chrono::milliseconds(timeout_));
-    
     auto wptr = std::weak_ptr<evt_link_plugin_impl>(shared_from_this());
-    timer->async_wait([wptr, link_id](auto& ec) {
+    timer_.async_wait([wptr](auto& ec) {
         auto self = wptr.lock();
-        if(self && ec != boost::asio::error::operation_aborted) {
-            auto pair = self->link_ids_.equal_range(link_id);
-            if(pair.first == self->link_ids_.end()) {
-                wlog("Cannot find context for id: ${id}", ("id",link_id));
-                return;
-            }
-            
-            auto ids = std::vector<deferred_id>();
-            std::for_each(pair.first, pair.second, [&ids](auto& it) {
-                ids.emplace_back(std::get<kDeferredId>(it.second));
-            });
-
-            self->link_ids_.erase(link_id);
+        if(!self || ec == boost::asio::error::operation_aborted) {
+            return;
+        }
 
-            try {
-                EVT_THROW(chain::exceed_evt_link_watch_time_exception, "Exceed EVT-Link watch time: ${time} ms", ("time",self->timeout_));
-            }
-            catch(...) {
-                http_plugin::handle_exception("evt_link", "get_trx_id_for_link_id", "", [&ids](auto code, auto body) {
-                    for(auto id : ids) {
-                        app().get_plugin<http_plugin>().set_deferred_response(id, code, body);
-                    }
-                });
-            }
+        self->expire(self->wheel_.tick());
+        if(self->wheel_.empty()) {
+            self->ticking_ = false;
+            return;
         }
+        self->schedule_tick();
     });
 }
 
+void
+evt_link_plugin_impl::expire(const std::vector<waiter_wheel::entry>& entries) {
+    auto ids = std::vector<deferred_id>();
+    for(auto& e : entries) {
+        auto it = link_ids_.find(e.first);
+        if(it == link_ids_.end()) {
+            continue;
+        }
+        auto& dids = it->second;
+        auto  dit  = std::find(dids.begin(), dids.end(), e.second);
+        if(dit == dids.end()) {
+            continue;
+        }
+        dids.erase(dit);
+        if(dids.empty()) {
+            link_ids_.erase(it);
+        }
+        ids.emplace_back(e.second);
+    }
+    if(ids.empty()) {
+        return;
+    }
+
+    try {
+        EVT_THROW(chain::exceed_evt_link_watch_time_exception, "Exceed EVT-Link watch time: ${time} ms", ("time",timeout_));
+    }
+    catch(...) {
+        http_plugin::handle_exception("evt_link", "get_trx_id_for_link_id", "", [&ids](auto code, auto body) {
+            for(auto id : ids) {
+                app().get_plugin<http_plugin>().set_deferred_response(id, code, body);
+            }
+        });
+    }
+}
+
 void
 evt_link_plugin_impl::get_trx_id_for_link_id(const link_id_type& link_id, deferred_id id) {
     // try to fetch from chain first
@@ -197,11 +516,17 @@ evt_link_plugin_impl::init() {
     auto& chain      = chain_plug.chain();
 
     accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
-        applied_block(bs);
+        applied_block(bs, false);
+    }));
+
+    irreversible_block_connection_.emplace(chain.irreversible_block.connect([&](const chain::block_state_ptr& bs) {
+        applied_block(bs, true);
     }));
 }
 
-evt_link_plugin_impl::~evt_link_plugin_impl() {}
+evt_link_plugin_impl::~evt_link_plugin_impl() {
+    timer_.cancel();
+}
 
 evt_link_plugin::evt_link_plugin() {}
 evt_link_plugin::~evt_link_plugin() {}
@@ -210,6 +535,7 @@ void
 evt_link_plugin::set_program_options(options_description&, options_description& cfg) {
     cfg.add_options()
         ("evt-link-timeout", bpo::value<uint32_t>()->default_value(5000), "Max time waitting for the deferred request.")
+        ("evt-link-max-subscriptions", bpo::value<uint32_t>()->default_value(1000), "Max number of link ids and addresses subscribed by one websocket connection.")
     ;
 }
 
@@ -217,6 +543,12 @@ void
 evt_link_plugin::plugin_initialize(const variables_map& options) {
     my_ = std::make_shared<evt_link_plugin_impl>(app().get_plugin<chain_plugin>().chain());
     my_->timeout_ = options.at("evt-link-timeout").as<uint32_t>();
+    EVT_ASSERT(my_->timeout_ > 0, chain::plugin_config_exception, "evt-link-timeout should be greater than 0");
+
+    // waiters expire within one tick after timeout
+    my_->tick_ = std::min<uint32_t>(my_->timeout_, 100);
+    my_->wheel_.reset((my_->timeout_ + my_->tick_ - 1) / my_->tick_ + 2);
+    my_->max_subscriptions_ = options.at("evt-link-max-subscriptions").as<uint32_t>();
     my_->init();
 }
 
@@ -246,12 +578,27 @@ evt_link_plugin::plugin_startup() {
         }
     });
 
+    // terminals subscribe link ids and addresses, and notifications are pushed once they're in blocks
+    auto wh       = websocket_handler();
+    wh.on_message = [&](auto id, auto message) {
+        if(my_) {
+            my_->on_websocket_message(id, message);
+        }
+    };
+    wh.on_close = [&](auto id) {
+        if(my_) {
+            my_->on_websocket_close(id);
+        }
+    };
+    app().get_plugin<http_plugin>().add_websocket_handler("/v1/evt_link/subscribe", wh);
+
     my_->init_ = false;
 }
 
 void
 evt_link_plugin::plugin_shutdown() {
     my_->accepted_block_connection_.reset();
+    my_->irreversible_block_connection_.reset();
     my_.reset();
 }
 
@@ -5,7 +5,10 @@
 
 #include <evt/evt_plugin/evt_plugin.hpp>
 
+#include <atomic>
+
 #include <fc/container/flat.hpp>
+#include <fc/crypto/hex.hpp>
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
 
@@ -24,32 +27,80 @@ static appbase::abstract_plugin& _evt_plugin = app().register_plugin<evt_plugin>
 using namespace evt;
 using namespace evt::chain;
 
+using read_view_ptr = std::shared_ptr<const token_database::read_view>;
+
 class evt_plugin_impl {
 public:
-    evt_plugin_impl(controller& db)
-        : db_(db) {}
+    evt_plugin_impl(controller& db, size_t view_cache_size)
+        : db_(db)
+        , view_cache_(view_cache_size, 4 /* num_shard_bits */) {}
+
+public:
+    void init();
+    void refresh_view();
+
+    read_view_ptr get_view() const { return std::atomic_load(&view_); }
 
 public:
     controller& db_;
+
+    // view is refreshed in main thread when block is accepted, and read from http worker threads
+    read_view_ptr                                     view_;
+    mutable token_database_view_cache                 view_cache_;
+    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
 };
 
+void
+evt_plugin_impl::init() {
+    refresh_view();
+    accepted_block_connection_.emplace(db_.accepted_block.connect([this](const auto&) {
+        refresh_view();
+    }));
+}
+
+void
+evt_plugin_impl::refresh_view() {
+    // view is pinned to the state of head block
+    // in irreversible read mode, head block is also the last irreversible block
+    auto dirty_keys = db_.token_db().pop_dirty_keys();
+    auto view       = read_view_ptr(db_.token_db().new_read_view());
+    std::atomic_store(&view_, view);
+    view_cache_.refresh(*view, dirty_keys);
+}
+
 evt_plugin::evt_plugin() {}
 evt_plugin::~evt_plugin() {}
 
-void evt_plugin::set_program_options(options_description& cli, options_description& cfg) {}
+void
+evt_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("evt-view-cache-size", bpo::value<uint32_t>()->default_value(64), "Size(MB) of the object cache shared by the concurrent read apis")
+        ;
+}
 
-void evt_plugin::plugin_initialize(const variables_map& options) {}
+void
+evt_plugin::plugin_initialize(const variables_map& options) {
+    view_cache_size_ = options.at("evt-view-cache-size").as<uint32_t>() * 1024 * 1024;
+}
 
 void
 evt_plugin::plugin_startup() {
-    this->my_.reset(new evt_plugin_impl(app().get_plugin<chain_plugin>().chain()));
+    this->my_.reset(new evt_plugin_impl(app().get_plugin<chain_plugin>().chain(), view_cache_size_));
+    this->my_->init();
 }
 
-void evt_plugin::plugin_shutdown() {}
+void
+evt_plugin::plugin_shutdown() {
+    // views hold the snapshots of token database, release them before database is closed
+    if(my_) {
+        my_->accepted_block_connection_.reset();
+        std::atomic_store(&my_->view_, read_view_ptr());
+    }
+}
 
 evt_apis::read_only
 evt_plugin::get_read_only_api() const {
-    return evt_apis::read_only(my_->db_);
+    return evt_apis::read_only(my_->db_, *my_);
 }
 
 evt_apis::read_write
@@ -59,15 +110,21 @@ evt_plugin::get_read_write_api() {
 
 namespace evt_apis {
 
-#define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)      \
-    try {                                                                   \
-        using vtype = typename decltype(VPTR)::element_type;                \
-        VPTR = tokendb_cache.template read_token<vtype>(TYPE, PREFIX, KEY); \
-    }                                                                       \
-    catch(token_database_exception&) {                                      \
-        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                         \
+#define READ_DB_TOKEN(TYPE, PREFIX, KEY, VPTR, EXCEPTION, FORMAT, ...)                     \
+    try {                                                                                  \
+        using vtype = std::remove_const_t<typename decltype(VPTR)::element_type>;          \
+        VPTR = tokendb_cache.template read_token<vtype>(tokendb, TYPE, PREFIX, KEY);       \
+    }                                                                                      \
+    catch(token_database_exception&) {                                                     \
+        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                                        \
     }
     
+// reads the packed value directly, the view cache is bypassed
+#define READ_DB_TOKEN_PACKED(TYPE, PREFIX, KEY, STR, EXCEPTION, FORMAT, ...) \
+    if(!tokendb.read_token(TYPE, PREFIX, KEY, STR, true /* no throw */)) { \
+        EVT_THROW2(EXCEPTION, FORMAT, __VA_ARGS__);                          \
+    }
+
 #define MAKE_PROPERTY(AMOUNT, SYM) \
     property {                     \
         .amount = AMOUNT,          \
@@ -98,12 +155,32 @@ namespace evt_apis {
         }                                                                   \
     }
 
-#define DECLARE_TOKEN_DB()                     \
-    auto& tokendb = db_.token_db();            \
-    auto& tokendb_cache = db_.token_db_cache();
+#define DECLARE_TOKEN_DB()                                        \
+    auto  view          = impl_.get_view();                       \
+    FC_ASSERT(view != nullptr, "Token database is not available"); \
+    auto& tokendb       = *view;                                  \
+    auto& tokendb_cache = impl_.view_cache_;
+
+template<typename T>
+auto make_empty_view_cache_ptr = [] {
+    return std::unique_ptr<const T, token_database_view_cache::cache_deleter<const T>>(nullptr);
+};
 
 enum psvbonus_type { kPsvBonus = 0, kPsvBonusSlim };
 
+// max number of queries in one call of batch apis
+const size_t kMaxBatchSize = 1000;
+
+fc::variant
+make_batch_result(fc::variant&& var) {
+    return fc::mutable_variant_object("result", std::move(var));
+}
+
+fc::variant
+make_batch_error(const std::string& message) {
+    return fc::mutable_variant_object("error", message);
+}
+
 name128
 get_psvbonus_db_key(symbol_id_type id, uint64_t nonce) {
     uint128_t v = nonce;
@@ -116,7 +193,7 @@ read_only::get_domain(const read_only::get_domain_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var    = variant();
-    auto domain = make_empty_cache_ptr<domain_def>();
+    auto domain = make_empty_view_cache_ptr<domain_def>();
     READ_DB_TOKEN(token_type::domain, std::nullopt, params.name, domain, unknown_domain_exception, "Cannot find domain: {}", params.name);
 
     fc::to_variant(*domain, var);
@@ -126,30 +203,79 @@ read_only::get_domain(const read_only::get_domain_params& params) {
     return mvar;
 }
 
+std::string
+read_only::get_domain_packed(const read_only::get_domain_params& params) {
+    DECLARE_TOKEN_DB();
+
+    auto str = std::string();
+    READ_DB_TOKEN_PACKED(token_type::domain, std::nullopt, params.name, str, unknown_domain_exception, "Cannot find domain: {}", params.name);
+    return str;
+}
+
 fc::variant
 read_only::get_group(const read_only::get_group_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var   = variant();
-    auto group = make_empty_cache_ptr<group_def>();
+    auto group = make_empty_view_cache_ptr<group_def>();
     READ_DB_TOKEN(token_type::group, std::nullopt, params.name, group, unknown_group_exception, "Cannot find group: {}", params.name);
 
     fc::to_variant(*group, var);
     return var;
 }
 
+std::string
+read_only::get_group_packed(const read_only::get_group_params& params) {
+    DECLARE_TOKEN_DB();
+
+    auto str = std::string();
+    READ_DB_TOKEN_PACKED(token_type::group, std::nullopt, params.name, str, unknown_group_exception, "Cannot find group: {}", params.name);
+    return str;
+}
+
 fc::variant
 read_only::get_token(const read_only::get_token_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var   = variant();
-    auto token = make_empty_cache_ptr<token_def>();
+    auto token = make_empty_view_cache_ptr<token_def>();
     READ_DB_TOKEN(token_type::token, params.domain, params.name, token, unknown_token_exception, "Cannot find token: {} in {}", params.name, params.domain);
 
     fc::to_variant(*token, var);
     return var;
 }
 
+std::string
+read_only::get_token_packed(const read_only::get_token_params& params) {
+    DECLARE_TOKEN_DB();
+
+    auto str = std::string();
+    READ_DB_TOKEN_PACKED(token_type::token, params.domain, params.name, str, unknown_token_exception, "Cannot find token: {} in {}", params.name, params.domain);
+    return str;
+}
+
+fc::variant
+read_only::get_tokens_by_names(const get_tokens_by_names_params& params) {
+    FC_ASSERT(params.names.size() <= kMaxBatchSize, "Attempt to query too many tokens at once");
+    DECLARE_TOKEN_DB();
+
+    auto keys   = small_vector<name128, 4>(params.names.cbegin(), params.names.cend());
+    auto tokens = tokendb_cache.template read_tokens<token_def>(tokendb, token_type::token, params.domain, keys, true /* no throw */);
+
+    auto vars = variants();
+    vars.reserve(tokens.size());
+    for(auto i = 0u; i < tokens.size(); i++) {
+        if(tokens[i] == nullptr) {
+            vars.emplace_back(make_batch_error(fmt::format("Cannot find token: {} in {}", params.names[i], params.domain)));
+            continue;
+        }
+        auto var = variant();
+        fc::to_variant(*tokens[i], var);
+        vars.emplace_back(make_batch_result(std::move(var)));
+    }
+    return vars;
+}
+
 fc::variant
 read_only::get_tokens(const get_tokens_params& params) {
     DECLARE_TOKEN_DB();
@@ -164,8 +290,9 @@ read_only::get_tokens(const get_tokens_params& params) {
         EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
     }
 
-    int i = 0;
-    tokendb.read_tokens_range(token_type::token, params.domain, s, [&](auto& key, auto&& value) {
+    int  i    = 0;
+    auto last = std::string();
+    auto func = [&](auto& key, auto&& value) {
         auto var = fc::variant();
 
         token_def token;
@@ -175,11 +302,54 @@ read_only::get_tokens(const get_tokens_params& params) {
         vars.emplace_back(std::move(var));
 
         if(++i == t) {
+            last = fc::to_hex(key.data(), key.size());
             return false;
         }
         return true;
-    });
+    };
+
+    if(!params.cursor.has_value()) {
+        tokendb.read_tokens_range(token_type::token, params.domain, s, func);
+        return vars;
+    }
+
+    // cursor is the hex of the key of last token returned
+    FC_ASSERT(!params.skip.has_value(), "Cannot skip tokens when cursor is used");
+    if(params.cursor->empty()) {
+        tokendb.read_tokens_range(token_type::token, params.domain, 0, func);
+    }
+    else {
+        auto after = name128();
+        EVT_ASSERT(params.cursor->size() == sizeof(after) * 2
+            && fc::from_hex(*params.cursor, (char*)&after, sizeof(after)) == sizeof(after), chain::name_type_exception,
+            "Invalid cursor: ${c}", ("c", *params.cursor));
+        tokendb.read_tokens_range_after(token_type::token, params.domain, after, func);
+    }
+
+    auto mvar = fc::mutable_variant_object();
+    mvar["tokens"] = std::move(vars);
+    mvar["cursor"] = last.empty() ? fc::variant() : fc::variant(last);
+    return mvar;
+}
+
+fc::variant
+read_only::get_tokens_by_owner(const get_tokens_by_owner_params& params) {
+    DECLARE_TOKEN_DB();
+
+    auto s = params.skip.value_or(0);
+    auto t = params.take.value_or(10);
+    EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
+
+    auto vars = fc::variants();
+    tokendb.read_tokens_by_owner(params.owner, s, [&](auto& key, auto&& value) {
+        auto var   = fc::variant();
+        auto token = token_def();
+        extract_db_value(value, token);
 
+        fc::to_variant(token, var);
+        vars.emplace_back(std::move(var));
+        return (int)vars.size() < t;
+    });
     return vars;
 }
 
@@ -188,7 +358,7 @@ read_only::get_fungible(const get_fungible_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var      = variant();
-    auto fungible = make_empty_cache_ptr<fungible_def>();
+    auto fungible = make_empty_view_cache_ptr<fungible_def>();
     READ_DB_TOKEN(token_type::fungible, std::nullopt, params.id, fungible, unknown_fungible_exception, "Cannot find fungible with sym id: {}", params.id);
 
     fc::to_variant(*fungible, var);
@@ -204,13 +374,22 @@ read_only::get_fungible(const get_fungible_params& params) {
     return mvar;
 }
 
+std::string
+read_only::get_fungible_packed(const get_fungible_params& params) {
+    DECLARE_TOKEN_DB();
+
+    auto str = std::string();
+    READ_DB_TOKEN_PACKED(token_type::fungible, std::nullopt, params.id, str, unknown_fungible_exception, "Cannot find fungible with sym id: {}", params.id);
+    return str;
+}
+
 fc::variant
 read_only::get_fungible_balance(const get_fungible_balance_params& params) {
     DECLARE_TOKEN_DB();
 
     auto vars = variants();
     if(params.sym_id.has_value()) {
-        auto fungible = make_empty_cache_ptr<fungible_def>();
+        auto fungible = make_empty_view_cache_ptr<fungible_def>();
         READ_DB_TOKEN(token_type::fungible, std::nullopt, *params.sym_id, fungible,
             unknown_fungible_exception, "Cannot find fungible with sym id: {}", *params.sym_id);
 
@@ -224,14 +403,98 @@ read_only::get_fungible_balance(const get_fungible_balance_params& params) {
         vars.emplace_back(std::move(var));
         return vars;
     }
-    EVT_THROW(unsupported_feature, "Read all the balance of fungibles tokens within one address is not supported in evt_plugin anymore, please refer to the history_plugin");
+
+    // one prefix seek on balance index instead of probing every symbol
+    tokendb.read_assets_by_address(params.address, [&](auto& key, auto&& value) {
+        auto prop = property();
+        extract_db_value(value, prop);
+
+        auto var = variant();
+        fc::to_variant(asset(prop.amount, prop.sym), var);
+        vars.emplace_back(std::move(var));
+        return true;
+    });
+    return vars;
+}
+
+fc::variant
+read_only::get_fungible_balances(const get_fungible_balances_params& params) {
+    FC_ASSERT(params.queries.size() <= kMaxBatchSize, "Attempt to query too many balances at once");
+    DECLARE_TOKEN_DB();
+
+    // fungibles are read once for all the queries of them
+    auto ids = small_vector<name128, 4>();
+    for(auto& q : params.queries) {
+        if(std::find(ids.cbegin(), ids.cend(), name128(q.sym_id)) == ids.cend()) {
+            ids.emplace_back(q.sym_id);
+        }
+    }
+    auto fungibles = tokendb_cache.template read_tokens<fungible_def>(tokendb, token_type::fungible, std::nullopt, ids, true /* no throw */);
+    auto find_sym  = [&](auto sym_id) -> const symbol* {
+        auto i = std::find(ids.cbegin(), ids.cend(), name128(sym_id)) - ids.cbegin();
+        return fungibles[i] ? &fungibles[i]->sym : nullptr;
+    };
+
+    auto keys = small_vector<asset_key_t, 4>();
+    for(auto& q : params.queries) {
+        if(find_sym(q.sym_id) != nullptr) {
+            keys.emplace_back(q.address, q.sym_id);
+        }
+    }
+    auto strs = small_vector<std::string, 4>();
+    tokendb.read_assets(keys, strs, true /* no throw */);
+
+    auto vars = variants();
+    vars.reserve(params.queries.size());
+    auto j = 0u;
+    for(auto& q : params.queries) {
+        auto sym = find_sym(q.sym_id);
+        if(sym == nullptr) {
+            vars.emplace_back(make_batch_error(fmt::format("Cannot find fungible with sym id: {}", q.sym_id)));
+            continue;
+        }
+
+        auto prop = MAKE_PROPERTY(0, *sym);
+        if(!strs[j].empty()) {
+            extract_db_value(strs[j], prop);
+        }
+        j++;
+
+        auto var = variant();
+        fc::to_variant(asset(prop.amount, prop.sym), var);
+        vars.emplace_back(make_batch_result(std::move(var)));
+    }
+    return vars;
+}
+
+fc::variant
+read_only::get_fungible_holders(const get_fungible_holders_params& params) {
+    auto& tokendb = db_.token_db();
+
+    auto s = params.skip.value_or(0);
+    auto t = params.take.value_or(10);
+    EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
+    EVT_ASSERT(tokendb.exists_token(token_type::fungible, std::nullopt, params.sym_id), unknown_fungible_exception,
+        "Cannot find fungible with sym id: ${id}", ("id", params.sym_id));
+
+    auto vars = fc::variants();
+    tokendb.read_assets_top_holders(params.sym_id, s, [&](auto& key, auto&& value) {
+        property prop;
+        extract_db_value(value, prop);
+
+        vars.emplace_back(fc::mutable_variant_object()
+            ("address", address::from_bytes(key.data(), key.size()))
+            ("balance", asset(prop.amount, prop.sym)));
+        return (int)vars.size() < t;
+    });
+    return vars;
 }
 
 fc::variant
 read_only::get_fungible_psvbonus(const get_fungible_psvbonus_params& params) {
     DECLARE_TOKEN_DB();
 
-    auto pb   = make_empty_cache_ptr<passive_bonus>();
+    auto pb   = make_empty_view_cache_ptr<passive_bonus>();
     auto dkey = get_psvbonus_db_key(params.id, kPsvBonus);
     READ_DB_TOKEN(token_type::psvbonus, std::nullopt, dkey, pb, unknown_bonus_exception,
         "Cannot find passive bonus registered for fungible token with sym id: {}.", params.id);
@@ -251,7 +514,7 @@ read_only::get_suspend(const get_suspend_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var     = variant();
-    auto suspend = make_empty_cache_ptr<suspend_def>();
+    auto suspend = make_empty_view_cache_ptr<suspend_def>();
     READ_DB_TOKEN(token_type::suspend, std::nullopt, params.name, suspend, unknown_suspend_exception, "Cannot find suspend proposal: {}", params.name);
 
     db_.get_abi_serializer().to_variant(*suspend, var, db_.get_execution_context());
@@ -263,7 +526,7 @@ read_only::get_lock(const get_lock_params& params) {
     DECLARE_TOKEN_DB();
 
     auto var  = variant();
-    auto lock = make_empty_cache_ptr<lock_def>();
+    auto lock = make_empty_view_cache_ptr<lock_def>();
     READ_DB_TOKEN(token_type::lock, std::nullopt, params.name, lock, unknown_lock_exception, "Cannot find lock proposal: {}", params.name);
 
     fc::to_variant(*lock, var);
@@ -19,45 +19,73 @@ class controller;
 }  // namespace chain
 
 class evt_plugin;
+class evt_plugin_impl;
 
 namespace evt_apis {
 
 using namespace evt::chain;
 using namespace evt::chain::contracts;
 
+// all the apis except `get_suspend` and `get_fungible_holders` are served from the read view of token database
+// and safe to be called concurrently from http worker threads
 class read_only {
 public:
-    read_only(const controller& db)
-        : db_(db) {}
+    read_only(const controller& db, const evt_plugin_impl& impl)
+        : db_(db), impl_(impl) {}
 
 public:
     struct get_domain_params {
         domain_name name;
     };
     fc::variant get_domain(const get_domain_params& params);
+    // `*_packed` apis return the objects in fc::raw packed form as they're stored in token database,
+    // the fields only added into json results (`address`, `current_supply`) are not included
+    std::string get_domain_packed(const get_domain_params& params);
 
     struct get_group_params {
         group_name name;
     };
     fc::variant get_group(const get_group_params& params);
+    std::string get_group_packed(const get_group_params& params);
 
     struct get_token_params {
         domain_name domain;
         token_name  name;
     };
     fc::variant get_token(const get_token_params& params);
+    std::string get_token_packed(const get_token_params& params);
 
+    // when `cursor` is set, even empty for the first page, {"tokens": [...], "cursor": ...} is returned
+    // and the next page starts after the returned cursor, which is null after the last page
     struct get_tokens_params {
-        domain_name        domain;
+        domain_name                domain;
+        std::optional<int>         skip;
+        std::optional<int>         take;
+        std::optional<std::string> cursor;
+    };
+    fc::variant get_tokens(const get_tokens_params& params);
+
+    // batch apis answer all the queries at once, each item of results is either
+    // {"result": ...} or {"error": ...} so that failed ones don't fail the others
+    struct get_tokens_by_names_params {
+        domain_name              domain;
+        std::vector<token_name>  names;
+    };
+    fc::variant get_tokens_by_names(const get_tokens_by_names_params& params);
+
+    // tokens of one owner in all the domains, needs `token-db-owner-index` to be enabled
+    struct get_tokens_by_owner_params {
+        address_type       owner;
         std::optional<int> skip;
         std::optional<int> take;
     };
-    fc::variant get_tokens(const get_tokens_params& params);
+    fc::variant get_tokens_by_owner(const get_tokens_by_owner_params& params);
 
     struct get_fungible_params {
         symbol_id_type id;
     };
     fc::variant get_fungible(const get_fungible_params& params);
+    std::string get_fungible_packed(const get_fungible_params& params);
 
     struct get_fungible_balance_params {
         address_type                  address;
@@ -65,6 +93,23 @@ public:
     };
     fc::variant get_fungible_balance(const get_fungible_balance_params& params);
 
+    struct fungible_balance_query {
+        address_type   address;
+        symbol_id_type sym_id;
+    };
+    struct get_fungible_balances_params {
+        std::vector<fungible_balance_query> queries;
+    };
+    fc::variant get_fungible_balances(const get_fungible_balances_params& params);
+
+    // holders with the largest balances of one fungible, it's served from the holders index in main thread
+    struct get_fungible_holders_params {
+        symbol_id_type     sym_id;
+        std::optional<int> skip;
+        std::optional<int> take;
+    };
+    fc::variant get_fungible_holders(const get_fungible_holders_params& params);
+
     struct get_fungible_psvbonus_params {
         symbol_id_type id;
     };
@@ -79,7 +124,8 @@ public:
     fc::variant get_lock(const get_lock_params& params);
 
 private:
-    const controller& db_;
+    const controller&      db_;
+    const evt_plugin_impl& impl_;
 };
 
 class read_write {};
@@ -104,6 +150,7 @@ public:
 
 private:
     std::unique_ptr<class evt_plugin_impl> my_;
+    size_t                                 view_cache_size_;
 };
 
 }  // namespace evt
@@ -111,8 +158,13 @@ private:
 FC_REFLECT(evt::evt_apis::read_only::get_domain_params, (name));
 FC_REFLECT(evt::evt_apis::read_only::get_group_params, (name));
 FC_REFLECT(evt::evt_apis::read_only::get_token_params, (domain)(name));
-FC_REFLECT(evt::evt_apis::read_only::get_tokens_params, (domain)(skip)(take));
+FC_REFLECT(evt::evt_apis::read_only::get_tokens_params, (domain)(skip)(take)(cursor));
+FC_REFLECT(evt::evt_apis::read_only::get_tokens_by_names_params, (domain)(names));
+FC_REFLECT(evt::evt_apis::read_only::get_tokens_by_owner_params, (owner)(skip)(take));
 FC_REFLECT(evt::evt_apis::read_only::get_fungible_params, (id));
 FC_REFLECT(evt::evt_apis::read_only::get_fungible_balance_params, (address)(sym_id));
+FC_REFLECT(evt::evt_apis::read_only::fungible_balance_query, (address)(sym_id));
+FC_REFLECT(evt::evt_apis::read_only::get_fungible_balances_params, (queries));
+FC_REFLECT(evt::evt_apis::read_only::get_fungible_holders_params, (sym_id)(skip)(take));
 FC_REFLECT(evt::evt_apis::read_only::get_fungible_psvbonus_params, (id));
 FC_REFLECT(evt::evt_apis::read_only::get_suspend_params, (name));
@@ -0,0 +1,136 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/export_plugin/arrow_table_writer.hpp>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+
+#include <fc/log/logger.hpp>
+#include <evt/chain/exceptions.hpp>
+
+namespace evt {
+
+using namespace chain;
+
+namespace internal {
+
+inline void
+check(const arrow::Status& s, const fc::path& file) {
+    EVT_ASSERT(s.ok(), export_write_exception, "Write export file '${f}' failed: ${m}", ("f", file)("m", s.ToString()));
+}
+
+template <typename T>
+inline T
+check(arrow::Result<T>&& r, const fc::path& file) {
+    check(r.status(), file);
+    return std::move(r).ValueOrDie();
+}
+
+template <typename Builder, typename T>
+inline void
+append(arrow::ArrayBuilder& b, T&& v, const fc::path& file) {
+    check(static_cast<Builder&>(b).Append(std::forward<T>(v)), file);
+}
+
+}  // namespace internal
+
+arrow_table_writer::arrow_table_writer(const fc::path& file, const std::shared_ptr<arrow::Schema>& schema, size_t batch_rows)
+    : file_(file)
+    , schema_(schema)
+    , batch_rows_(std::max<size_t>(batch_rows, 1)) {
+    using namespace internal;
+
+    builders_.reserve(schema_->num_fields());
+    for(auto& f : schema_->fields()) {
+        auto b = std::unique_ptr<arrow::ArrayBuilder>();
+        check(arrow::MakeBuilder(arrow::default_memory_pool(), f->type(), &b), file_);
+        builders_.emplace_back(std::move(b));
+    }
+
+    out_    = check(arrow::io::FileOutputStream::Open(file_.generic_string()), file_);
+    writer_ = check(arrow::ipc::MakeFileWriter(out_, schema_), file_);
+}
+
+arrow_table_writer::~arrow_table_writer() {
+    try {
+        close();
+    }
+    FC_LOG_AND_DROP();
+}
+
+arrow_table_writer&
+arrow_table_writer::add(size_t i, uint32_t v) {
+    internal::append<arrow::UInt32Builder>(*builders_[i], v, file_);
+    return *this;
+}
+
+arrow_table_writer&
+arrow_table_writer::add(size_t i, uint64_t v) {
+    internal::append<arrow::UInt64Builder>(*builders_[i], v, file_);
+    return *this;
+}
+
+arrow_table_writer&
+arrow_table_writer::add(size_t i, int64_t v) {
+    internal::append<arrow::Int64Builder>(*builders_[i], v, file_);
+    return *this;
+}
+
+arrow_table_writer&
+arrow_table_writer::add(size_t i, std::string_view v) {
+    internal::append<arrow::StringBuilder>(*builders_[i], arrow::util::string_view(v.data(), v.size()), file_);
+    return *this;
+}
+
+arrow_table_writer&
+arrow_table_writer::add(size_t i, const fc::time_point& v) {
+    internal::append<arrow::TimestampBuilder>(*builders_[i], (int64_t)(v.time_since_epoch().count() / 1000), file_);
+    return *this;
+}
+
+void
+arrow_table_writer::end_row() {
+    if(++rows_ >= batch_rows_) {
+        flush();
+    }
+}
+
+void
+arrow_table_writer::flush() {
+    using namespace internal;
+
+    if(rows_ == 0) {
+        return;
+    }
+
+    auto arrays = std::vector<std::shared_ptr<arrow::Array>>();
+    arrays.reserve(builders_.size());
+    for(auto& b : builders_) {
+        auto& a = arrays.emplace_back();
+        check(b->Finish(&a), file_);
+    }
+
+    auto batch = arrow::RecordBatch::Make(schema_, (int64_t)rows_, std::move(arrays));
+    check(writer_->WriteRecordBatch(*batch), file_);
+    rows_ = 0;
+}
+
+void
+arrow_table_writer::close() {
+    using namespace internal;
+
+    if(closed_) {
+        return;
+    }
+    closed_ = true;
+
+    flush();
+    // writer only writes the footer, the file is closed separately
+    check(writer_->Close(), file_);
+    check(out_->Close(), file_);
+}
+
+}  // namespace evt
@@ -0,0 +1,543 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/export_plugin/export_plugin.hpp>
+
+#include <map>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if __has_include(<condition>)
+#include <condition>
+using std::condition_variable_any;
+#else
+#include <boost/thread/condition.hpp>
+using boost::condition_variable_any;
+#endif
+
+#include <arrow/api.h>
+#include <fmt/format.h>
+
+#include <evt/chain/controller.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/execution_context.hpp>
+#include <evt/chain/plugin_interface.hpp>
+#include <evt/chain/transaction.hpp>
+#include <evt/chain/types.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/utilities/spinlock.hpp>
+
+#include <evt/export_plugin/arrow_table_writer.hpp>
+
+namespace evt {
+
+using namespace chain;
+using namespace chain::contracts;
+
+using evt::utilities::spinlock;
+using evt::utilities::spinlock_guard;
+
+static appbase::abstract_plugin& _export_plugin = app().register_plugin<export_plugin>();
+
+namespace internal {
+
+enum block_cols { kBlockNum = 0, kBlockId, kPrevBlockId, kBlockTs, kTrxMroot, kTrxCount, kProducer };
+enum trx_cols   { kTrxBlockNum = 0, kTrxId, kTrxNum, kTrxTs, kTrxType, kTrxStatus, kActCount, kPayer, kMaxCharge, kElapsed, kCharge };
+enum act_cols   { kActBlockNum = 0, kActTrxId, kSeqNum, kGlobalSeq, kActTs, kActName, kActDomain, kActKey, kActData };
+
+auto
+ts_type() {
+    return arrow::timestamp(arrow::TimeUnit::MILLI);
+}
+
+auto
+blocks_schema() {
+    static auto schema = arrow::schema({
+        arrow::field("block_num", arrow::uint32()),
+        arrow::field("block_id", arrow::utf8()),
+        arrow::field("prev_block_id", arrow::utf8()),
+        arrow::field("timestamp", ts_type()),
+        arrow::field("trx_merkle_root", arrow::utf8()),
+        arrow::field("trx_count", arrow::uint32()),
+        arrow::field("producer", arrow::utf8())
+    });
+    return schema;
+}
+
+auto
+trxs_schema() {
+    static auto schema = arrow::schema({
+        arrow::field("block_num", arrow::uint32()),
+        arrow::field("trx_id", arrow::utf8()),
+        arrow::field("seq_num", arrow::uint32()),
+        arrow::field("timestamp", ts_type()),
+        arrow::field("type", arrow::utf8()),
+        arrow::field("status", arrow::utf8()),
+        arrow::field("action_count", arrow::uint32()),
+        arrow::field("payer", arrow::utf8()),
+        arrow::field("max_charge", arrow::uint32()),
+        arrow::field("elapsed", arrow::int64()),
+        arrow::field("charge", arrow::uint32())
+    });
+    return schema;
+}
+
+auto
+acts_schema() {
+    static auto schema = arrow::schema({
+        arrow::field("block_num", arrow::uint32()),
+        arrow::field("trx_id", arrow::utf8()),
+        arrow::field("seq_num", arrow::uint32()),
+        arrow::field("global_seq", arrow::uint64()),
+        arrow::field("timestamp", ts_type()),
+        arrow::field("name", arrow::utf8()),
+        arrow::field("domain", arrow::utf8()),
+        arrow::field("key", arrow::utf8()),
+        arrow::field("data", arrow::utf8())
+    });
+    return schema;
+}
+
+template <typename Q, typename V>
+inline void
+queueb(Q& bqueue, V&& v, spinlock& lock, condition_variable_any& cv, size_t queue_size) {
+    lock.lock();
+
+    auto sleep_time = 0ul;
+
+    while(bqueue.size() > queue_size) {
+        lock.unlock();
+        cv.notify_one();
+
+        sleep_time += 100;
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+
+        lock.lock();
+    }
+    bqueue.emplace_back(std::forward<V>(v));
+    lock.unlock();
+    cv.notify_one();
+}
+
+template <typename Q, typename V>
+inline void
+queuet(Q& tqueue, V&& v, spinlock& lock, condition_variable_any& cv) {
+    lock.lock();
+    tqueue.emplace_back(std::forward<V>(v));
+    lock.unlock();
+    cv.notify_one();
+}
+
+}  // namespace internal
+
+// tables of blocks in one range, action tables are opened when the action first appears
+struct export_partition {
+    uint32_t first_num = 0;
+    uint32_t end_num   = 0;  // aligned end of range, exclusive
+    fc::path dir;
+
+    std::unique_ptr<arrow_table_writer>                        blocks;
+    std::unique_ptr<arrow_table_writer>                        trxs;
+    std::map<std::string, std::unique_ptr<arrow_table_writer>> acts;
+};
+
+class export_plugin_impl {
+private:
+    using inblock_ptr = std::tuple<block_state_ptr, bool>; // true for irreversible block
+
+    // traces matched to the transactions of accepted block, null if there are no traces
+    struct pending_block {
+        block_id_type                      id;
+        std::vector<transaction_trace_ptr> traces;
+    };
+
+public:
+    export_plugin_impl(const controller& control)
+        : control_(control) {}
+    ~export_plugin_impl();
+
+public:
+    void consume_queues();
+
+    void applied_block(const block_state_ptr&, bool irreversible);
+    void applied_transaction(const transaction_trace_ptr&);
+
+    void process_accepted_block(const block_state_ptr&, std::deque<transaction_trace_ptr>& traces);
+    void process_irreversible_block(const block_state_ptr&);
+
+    void write_block(const block_state_ptr&, const std::vector<transaction_trace_ptr>& traces);
+    void open_partition(uint32_t num);
+    void close_partition();
+
+    void init();
+
+public:
+    const controller& control_;
+
+    bool     configured_ = false;
+    fc::path dir_;
+
+    uint32_t partition_blocks_ = 0;
+    size_t   batch_rows_       = 0;
+    size_t   queue_size_       = 0;
+
+    // next block expected, the ones before it are already exported
+    uint32_t next_num_ = 1;
+
+    std::optional<export_partition>        partition_;
+    std::multimap<uint32_t, pending_block> pending_;
+
+    std::deque<inblock_ptr>           block_state_queue_;
+    std::deque<transaction_trace_ptr> transaction_trace_queue_;
+
+    spinlock               lock_;
+    condition_variable_any cond_;
+
+    std::thread      consume_thread_;
+    std::atomic_bool done_ = false;
+
+    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
+    std::optional<boost::signals2::scoped_connection> applied_transaction_connection_;
+};
+
+void
+export_plugin_impl::applied_block(const block_state_ptr& bsp, bool irreversible) {
+    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, irreversible), lock_, cond_, queue_size_);
+}
+
+void
+export_plugin_impl::applied_transaction(const transaction_trace_ptr& ttp) {
+    if(!ttp->receipt.has_value() || (ttp->receipt->status != transaction_receipt_header::executed &&
+        ttp->receipt->status != transaction_receipt_header::soft_fail)) {
+        return;
+    }
+    evt::internal::queuet(transaction_trace_queue_, ttp, lock_, cond_);
+}
+
+void
+export_plugin_impl::consume_queues() {
+    try {
+        while(true) {
+            lock_.lock();
+            while(block_state_queue_.empty() && !done_) {
+                cond_.wait(lock_);
+            }
+
+            auto bqueue = std::move(block_state_queue_);
+            auto traces = std::move(transaction_trace_queue_);
+            lock_.unlock();
+
+            if(done_ && bqueue.empty()) {
+                break;
+            }
+
+            for(auto& b : bqueue) {
+                if(std::get<1>(b)) {
+                    process_irreversible_block(std::get<0>(b));
+                }
+                else {
+                    process_accepted_block(std::get<0>(b), traces);
+                }
+            }
+
+            if(!traces.empty()) {
+                spinlock_guard lock(lock_);
+                transaction_trace_queue_.insert(transaction_trace_queue_.begin(), traces.begin(), traces.end());
+            }
+        }
+        close_partition();
+        ilog("export_plugin consume thread shutdown gracefully");
+    }
+    catch(fc::exception& e) {
+        elog("FC Exception while exporting block ${e}", ("e", e.to_string()));
+    }
+    catch(std::exception& e) {
+        elog("STD Exception while exporting block ${e}", ("e", e.what()));
+    }
+    catch(...) {
+        elog("Unknown exception while exporting block");
+    }
+}
+
+void
+export_plugin_impl::process_accepted_block(const block_state_ptr& block, std::deque<transaction_trace_ptr>& traces) {
+    if(block->block_num < next_num_) {
+        return;
+    }
+
+    auto pb = pending_block { block->id, {} };
+    pb.traces.reserve(block->block->transactions.size());
+    for(const auto& trx : block->block->transactions) {
+        auto& t = pb.traces.emplace_back();
+        if(trx.status != transaction_receipt_header::executed) {
+            continue;
+        }
+
+        // traces are in the order of transactions, the ones before are of the blocks not accepted
+        auto trx_id = trx.trx.id();
+        while(!traces.empty()) {
+            auto trace = traces.front();
+            traces.pop_front();
+
+            if(trace->id == trx_id) {
+                t = trace;
+                break;
+            }
+        }
+    }
+    pending_.emplace(block->block_num, std::move(pb));
+}
+
+void
+export_plugin_impl::process_irreversible_block(const block_state_ptr& block) {
+    auto num = block->block_num;
+
+    auto traces = std::vector<transaction_trace_ptr>();
+    auto range  = pending_.equal_range(num);
+    for(auto it = range.first; it != range.second; it++) {
+        if(it->second.id == block->id) {
+            traces = std::move(it->second.traces);
+            break;
+        }
+    }
+    // blocks on the forks are dropped once their numbers become irreversible
+    pending_.erase(pending_.begin(), pending_.upper_bound(num));
+
+    if(num < next_num_) {
+        return;
+    }
+    if(num > next_num_) {
+        wlog("Blocks from ${s} to ${e} are not exported, replay the chain to export them", ("s", next_num_)("e", num - 1));
+        close_partition();
+    }
+
+    if(!partition_ || num >= partition_->end_num) {
+        close_partition();
+        open_partition(num);
+    }
+    write_block(block, traces);
+    next_num_ = num + 1;
+}
+
+void
+export_plugin_impl::write_block(const block_state_ptr& block, const std::vector<transaction_trace_ptr>& traces) {
+    using namespace internal;
+
+    auto& p   = *partition_;
+    auto  num = block->block_num;
+    auto  id  = block->id.str();
+    auto  ts  = block->header.timestamp.to_time_point();
+
+    p.blocks->add(kBlockNum, num)
+        .add(kBlockId, id)
+        .add(kPrevBlockId, block->header.previous.str())
+        .add(kBlockTs, ts)
+        .add(kTrxMroot, block->header.transaction_mroot.str())
+        .add(kTrxCount, (uint32_t)block->block->transactions.size())
+        .add(kProducer, (std::string)block->header.producer)
+        .end_row();
+
+    auto& abi      = control_.get_abi_serializer();
+    auto& exec_ctx = control_.get_execution_context();
+
+    auto trx_num = 0u;
+    for(auto& trx : block->block->transactions) {
+        auto& strx   = trx.trx.get_signed_transaction();
+        auto  trx_id = strx.id().str();
+        auto  trace  = traces.empty() ? transaction_trace_ptr() : traces[trx_num];
+
+        p.trxs->add(kTrxBlockNum, num)
+            .add(kTrxId, trx_id)
+            .add(kTrxNum, trx_num)
+            .add(kTrxTs, ts)
+            .add(kTrxType, (std::string)trx.type)
+            .add(kTrxStatus, (std::string)trx.status)
+            .add(kActCount, (uint32_t)strx.actions.size())
+            .add(kPayer, (std::string)strx.payer)
+            .add(kMaxCharge, (uint32_t)strx.max_charge)
+            .add(kElapsed, (int64_t)(trace ? trace->elapsed.count() : 0))
+            .add(kCharge, (uint32_t)(trace ? trace->charge : 0))
+            .end_row();
+
+        if(trace) {
+            auto seq_num = 0u;
+            for(auto& act_trace : trace->action_traces) {
+                auto& act  = act_trace.act;
+                auto  name = act.name.to_string();
+
+                auto it = p.acts.find(name);
+                if(it == p.acts.end()) {
+                    auto dir = p.dir / "actions" / ("name=" + name);
+                    fc::create_directories(dir);
+                    it = p.acts.emplace(name, std::make_unique<arrow_table_writer>(dir / "actions.arrow", acts_schema(), batch_rows_)).first;
+                }
+
+                it->second->add(kActBlockNum, num)
+                    .add(kActTrxId, trx_id)
+                    .add(kSeqNum, seq_num)
+                    .add(kGlobalSeq, (uint64_t)act_trace.receipt.global_sequence)
+                    .add(kActTs, ts)
+                    .add(kActName, name)
+                    .add(kActDomain, act.domain.to_string())
+                    .add(kActKey, act.key.to_string())
+                    .add(kActData, act_trace.data_json(abi, exec_ctx))
+                    .end_row();
+                seq_num++;
+            }
+        }
+        trx_num++;
+    }
+}
+
+void
+export_plugin_impl::open_partition(uint32_t num) {
+    using namespace internal;
+
+    auto& p     = partition_.emplace();
+    p.first_num = num;
+    p.end_num   = (num / partition_blocks_ + 1) * partition_blocks_;
+    p.dir       = dir_ / fmt::format("{:010d}.partial", num);
+
+    if(fc::exists(p.dir)) {
+        fc::remove_all(p.dir);
+    }
+    fc::create_directories(p.dir);
+
+    p.blocks = std::make_unique<arrow_table_writer>(p.dir / "blocks.arrow", blocks_schema(), batch_rows_);
+    p.trxs   = std::make_unique<arrow_table_writer>(p.dir / "transactions.arrow", trxs_schema(), batch_rows_);
+}
+
+void
+export_plugin_impl::close_partition() {
+    if(!partition_) {
+        return;
+    }
+
+    auto& p = *partition_;
+    p.blocks->close();
+    p.trxs->close();
+    for(auto& it : p.acts) {
+        it.second->close();
+    }
+
+    // partition is only visible with its final name after all the files are closed
+    auto last = next_num_ - 1;
+    auto dir  = dir_ / fmt::format("{:010d}-{:010d}", p.first_num, last);
+    fc::rename(p.dir, dir);
+    ilog("Exported blocks from ${s} to ${e} into ${d}", ("s", p.first_num)("e", last)("d", dir));
+
+    partition_.reset();
+}
+
+void
+export_plugin_impl::init() {
+    if(!fc::exists(dir_)) {
+        fc::create_directories(dir_);
+    }
+
+    // finds the last exported block, unfinished partitions left by crash are removed
+    for(auto it = fc::directory_iterator(dir_); it != fc::directory_iterator(); it++) {
+        auto name = it->path().filename().generic_string();
+        if(name.size() == 8 + 10 && name.substr(10) == ".partial") {
+            wlog("Remove unfinished export partition ${d}", ("d", it->path()));
+            fc::remove_all(it->path());
+            continue;
+        }
+        if(name.size() == 21 && name[10] == '-') {
+            auto last = (uint32_t)std::stoul(name.substr(11));
+            next_num_ = std::max(next_num_, last + 1);
+        }
+    }
+    if(next_num_ > 1) {
+        ilog("Blocks up to ${n} are exported already", ("n", next_num_ - 1));
+    }
+
+    auto& chain = app().get_plugin<chain_plugin>().chain();
+
+    accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
+        applied_block(bs, false);
+    }));
+
+    irreversible_block_connection_.emplace(chain.irreversible_block.connect([&](const chain::block_state_ptr& bs) {
+        applied_block(bs, true);
+    }));
+
+    applied_transaction_connection_.emplace(chain.applied_transaction.connect([&](const chain::transaction_trace_ptr& t) {
+        applied_transaction(t);
+    }));
+}
+
+export_plugin_impl::~export_plugin_impl() {
+    if(!configured_) {
+        return;
+    }
+    try {
+        done_ = true;
+        cond_.notify_one();
+
+        consume_thread_.join();
+    }
+    catch(std::exception& e) {
+        elog("Exception on export_plugin shutdown of consume thread: ${e}", ("e", e.what()));
+    }
+}
+
+export_plugin::export_plugin() {}
+
+export_plugin::~export_plugin() {}
+
+void
+export_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("export-dir", bpo::value<bfs::path>(),
+            "Export irreversible blocks, transactions and actions as Arrow IPC files into this directory (absolute path or relative to application data dir)")
+        ("export-partition-blocks", bpo::value<uint32_t>()->default_value(100000), "Number of blocks in one partition of exported files")
+        ("export-batch-rows", bpo::value<uint32_t>()->default_value(65536), "Number of rows in one record batch of exported files")
+        ("export-queue-size", bpo::value<uint32_t>()->default_value(1024), "The queue size between evtd and export plugin thread")
+        ;
+}
+
+void
+export_plugin::plugin_initialize(const variables_map& options) {
+    my_ = std::make_unique<export_plugin_impl>(app().get_plugin<chain_plugin>().chain());
+
+    if(options.count("export-dir")) {
+        ilog("initializing export_plugin");
+        my_->configured_ = true;
+
+        auto dir = options.at("export-dir").as<bfs::path>();
+        my_->dir_ = dir.is_relative() ? app().data_dir() / dir : dir;
+
+        my_->partition_blocks_ = options.at("export-partition-blocks").as<uint32_t>();
+        EVT_ASSERT(my_->partition_blocks_ > 0, plugin_config_exception,
+            "export-partition-blocks ${num} must be greater than 0", ("num", my_->partition_blocks_));
+        my_->batch_rows_ = options.at("export-batch-rows").as<uint32_t>();
+        EVT_ASSERT(my_->batch_rows_ > 0, plugin_config_exception,
+            "export-batch-rows ${num} must be greater than 0", ("num", my_->batch_rows_));
+        my_->queue_size_ = options.at("export-queue-size").as<uint32_t>();
+
+        my_->init();
+        my_->consume_thread_ = std::thread([this] { my_->consume_queues(); });
+    }
+    else {
+        wlog("evt::export_plugin configured, but no --export-dir specified.");
+        wlog("export_plugin disabled.");
+    }
+}
+
+void
+export_plugin::plugin_startup() {}
+
+void
+export_plugin::plugin_shutdown() {
+    my_->accepted_block_connection_.reset();
+    my_->irreversible_block_connection_.reset();
+    my_->applied_transaction_connection_.reset();
+    my_.reset();
+}
+
+}  // namespace evt
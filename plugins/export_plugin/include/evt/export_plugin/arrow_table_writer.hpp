@@ -0,0 +1,61 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+namespace arrow {
+class ArrayBuilder;
+class Schema;
+namespace io {
+class FileOutputStream;
+}  // namespace io
+namespace ipc {
+class RecordBatchWriter;
+}  // namespace ipc
+}  // namespace arrow
+
+namespace evt {
+
+/**
+ *  Writes one table into an Arrow IPC file, rows are appended column by column into builders
+ *  and written as one record batch every `batch_rows` rows.
+ *
+ *  The file is only readable after it's closed, which writes the footer.
+ */
+class arrow_table_writer : boost::noncopyable {
+public:
+    arrow_table_writer(const fc::path& file, const std::shared_ptr<arrow::Schema>& schema, size_t batch_rows);
+    ~arrow_table_writer();
+
+public:
+    // value must match the type of column `i` in schema
+    arrow_table_writer& add(size_t i, uint32_t v);
+    arrow_table_writer& add(size_t i, uint64_t v);
+    arrow_table_writer& add(size_t i, int64_t v);
+    arrow_table_writer& add(size_t i, std::string_view v);
+    arrow_table_writer& add(size_t i, const fc::time_point& v);  // timestamp in milliseconds
+
+    void end_row();
+    void flush();
+    void close();
+
+private:
+    fc::path                                          file_;
+    std::shared_ptr<arrow::Schema>                    schema_;
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders_;
+    std::shared_ptr<arrow::io::FileOutputStream>      out_;
+    std::shared_ptr<arrow::ipc::RecordBatchWriter>    writer_;
+
+    size_t batch_rows_;
+    size_t rows_   = 0;
+    bool   closed_ = false;
+};
+
+}  // namespace evt
@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <memory>
+
+#include <appbase/application.hpp>
+#include <evt/chain_plugin/chain_plugin.hpp>
+
+namespace evt {
+
+/**
+ *  Exports irreversible blocks, transactions and actions into Arrow IPC files for analytics.
+ *
+ *  Each partition covers a range of blocks and is one directory named by the first and last block in it:
+ *
+ *      <export-dir>/<first>-<last>/blocks.arrow
+ *      <export-dir>/<first>-<last>/transactions.arrow
+ *      <export-dir>/<first>-<last>/actions/name=<action>/actions.arrow
+ *
+ *  Partitions are aligned to `export-partition-blocks`, except the ones split by restarts. The one being
+ *  written is named `<first>.partial` and renamed once it's finished.
+ */
+class export_plugin : public plugin<export_plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain_plugin))
+
+    export_plugin();
+    virtual ~export_plugin();
+
+    virtual void set_program_options(options_description& cli, options_description& cfg) override;
+
+    void plugin_initialize(const variables_map& options);
+    void plugin_startup();
+    void plugin_shutdown();
+
+private:
+    std::unique_ptr<class export_plugin_impl> my_;
+};
+
+}  // namespace evt
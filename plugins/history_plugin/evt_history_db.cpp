@@ -0,0 +1,639 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/history_plugin/evt_history_db.hpp>
+
+#include <algorithm>
+#include <boost/endian/conversion.hpp>
+#include <fmt/format.h>
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/write_batch.h>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/execution_context.hpp>
+#include <evt/chain/contracts/abi_serializer.hpp>
+#include <evt/history_plugin/evt_pg_query.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
+
+namespace evt { namespace internal {
+
+struct history_trx {
+    uint32_t              block_num;
+    uint32_t              trx_num;
+    std::vector<uint64_t> actions;  // global sequences
+};
+
+struct history_action {
+    std::string trx_id;
+    std::string name;
+    std::string domain;
+    std::string key;
+    std::string data;
+    std::string timestamp;
+};
+
+}}  // namespace evt::internal
+
+FC_REFLECT(evt::internal::history_trx, (block_num)(trx_num)(actions));
+FC_REFLECT(evt::internal::history_action, (trx_id)(name)(domain)(key)(data)(timestamp));
+
+namespace evt {
+
+using namespace evt::chain;
+
+namespace internal {
+
+const char* kLastBlockKey  = "last_block";
+const int   kBatchedBlocks = 64;
+
+// actions returned by fungible actions query, same as the ones of postgres
+const char* kFungibleActions[] = { "issuefungible", "transferft", "batchtransft", "recycleft", "evt2pevt", "everipay", "paybonus" };
+
+template<typename T>
+void
+append_be(std::string& buf, T v) {
+    v = boost::endian::native_to_big(v);
+    buf.append((const char*)&v, sizeof(v));
+}
+
+void
+append_name(std::string& buf, const name128& n) {
+    auto v = (uint128_t)n;
+    append_be(buf, (uint64_t)(v >> 64));
+    append_be(buf, (uint64_t)v);
+}
+
+template<typename T>
+std::string
+packed(const T& v) {
+    auto data = fc::raw::pack(v);
+    return std::string(data.data(), data.size());
+}
+
+std::string
+trx_id_key(const transaction_id_type& id) {
+    return std::string(id.data(), id.data_size());
+}
+
+std::string
+seq_key(uint64_t seq) {
+    auto key = std::string();
+    append_be(key, seq);
+    return key;
+}
+
+std::string
+domain_prefix(const name128& domain) {
+    auto key = std::string();
+    append_name(key, domain);
+    return key;
+}
+
+std::string
+key_prefix(const name128& domain, const name128& key) {
+    auto k = std::string();
+    append_name(k, domain);
+    append_name(k, key);
+    return k;
+}
+
+std::string
+address_prefix(symbol_id_type sym_id, const std::string& addr) {
+    auto key = std::string();
+    append_be(key, sym_id);
+    key.append(addr);
+    key.push_back('\0');
+    return key;
+}
+
+std::string
+pubkey_prefix(const public_key_type& key) {
+    return packed(key);
+}
+
+void
+assert_ok(const rocksdb::Status& status, const char* what) {
+    EVT_ASSERT(status.ok(), history_db_exception, "${w} failed, detail: ${s}", ("w",what)("s",status.ToString()));
+}
+
+// same fields as the ones postgres plugin writes into `action_addresses`
+std::vector<std::string>
+fungible_addresses(const action& act, const std::string& data) {
+    auto addrs = std::vector<std::string>();
+    switch(act.name.value) {
+    case N(issuefungible):
+    case N(transferft):
+    case N(batchtransft):
+    case N(recycleft):
+    case N(evt2pevt):
+    case N(everipay):
+    case N(paybonus): {
+        break;
+    }
+    default: {
+        return addrs;
+    }
+    }  // switch
+
+    auto var = fc::json::from_string(data);
+    if(!var.is_object()) {
+        return addrs;
+    }
+    auto& v = var.get_object();
+    for(auto f : { "address", "from", "to", "payee", "payer" }) {
+        if(v.contains(f)) {
+            addrs.emplace_back(v[f].as_string());
+        }
+    }
+    if(v.contains("credits")) {
+        for(auto& c : v["credits"].get_array()) {
+            addrs.emplace_back(c["to"].as_string());
+        }
+    }
+    if(v.contains("link") && v["link"].get_object().contains("keys")) {
+        for(auto& k : v["link"]["keys"].get_array()) {
+            addrs.emplace_back(k.as_string());
+        }
+    }
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+    return addrs;
+}
+
+void
+format_action_to(fmt::memory_buffer& buf, const history_action& act) {
+    fmt::format_to(buf,
+        fmt(R"({{"trx_id":"{}","name":"{}","domain":"{}","key":"{}","data":{},"timestamp":"{}"}})"),
+        act.trx_id, act.name, act.domain, act.key, act.data, act.timestamp);
+}
+
+void
+response_ok(int id, const fmt::memory_buffer& buf) {
+    app().get_plugin<http_plugin>().set_deferred_response(id, 200, fmt::to_string(buf));
+}
+
+void
+get_window(const optional<int>& skip, const optional<int>& take, int& s, int& t) {
+    s = 0, t = 10;
+    if(skip.has_value()) {
+        s = std::max(*skip, 0);
+    }
+    if(take.has_value()) {
+        t = *take;
+        EVT_ASSERT(t <= 20, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 20 per query");
+    }
+}
+
+}  // namespace internal
+
+history_db::history_db(chain::controller& chain, const fc::path& dir)
+    : chain_(chain)
+    , dir_(dir)
+    , db_(nullptr)
+    , last_block_num_(0)
+    , done_(false) {}
+
+history_db::~history_db() {
+    close();
+}
+
+void
+history_db::open() {
+    using namespace rocksdb;
+    using namespace internal;
+
+    EVT_ASSERT(db_ == nullptr, history_db_exception, "History database is already opened");
+    if(!fc::exists(dir_)) {
+        fc::create_directories(dir_);
+    }
+
+    auto options = Options();
+    options.OptimizeLevelStyleCompaction();
+    options.create_if_missing              = true;
+    options.create_missing_column_families = true;
+    options.compression                    = CompressionType::kLZ4Compression;
+    options.bottommost_compression         = CompressionType::kZSTD;
+
+    auto cf_options = ColumnFamilyOptions(options);
+    auto columns    = std::vector<ColumnFamilyDescriptor>{
+        ColumnFamilyDescriptor(kDefaultColumnFamilyName, cf_options),
+        ColumnFamilyDescriptor("trxs", cf_options),
+        ColumnFamilyDescriptor("actions", cf_options),
+        ColumnFamilyDescriptor("domain_actions", cf_options),
+        ColumnFamilyDescriptor("key_actions", cf_options),
+        ColumnFamilyDescriptor("address_actions", cf_options),
+        ColumnFamilyDescriptor("key_trxs", cf_options)
+    };
+
+    assert_ok(DB::Open(options, dir_.string(), columns, &handles_, &db_), "Open history database");
+
+    trxs_            = handles_[1];
+    actions_         = handles_[2];
+    domain_actions_  = handles_[3];
+    key_actions_     = handles_[4];
+    address_actions_ = handles_[5];
+    key_trxs_        = handles_[6];
+
+    auto v = read_value(handles_[0], kLastBlockKey);
+    if(v.has_value()) {
+        last_block_num_ = fc::raw::unpack<uint32_t>(v->data(), v->size());
+        ilog("History database is at block: ${n}", ("n",last_block_num_));
+    }
+
+    done_   = false;
+    writer_ = std::thread([this] { write_loop(); });
+}
+
+void
+history_db::close() {
+    if(db_ == nullptr) {
+        return;
+    }
+
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        done_ = true;
+    }
+    cond_.notify_one();
+    writer_.join();
+
+    for(auto h : handles_) {
+        db_->DestroyColumnFamilyHandle(h);
+    }
+    handles_.clear();
+
+    delete db_;
+    db_ = nullptr;
+}
+
+void
+history_db::applied_transaction(const transaction_trace_ptr& trace) {
+    traces_.emplace_back(trace);
+}
+
+void
+history_db::irreversible_block(const block_state_ptr& bsp) {
+    // traces are taken even the block is already written, the ones of next blocks are after them
+    auto pb = pending_block { bsp, {} };
+    pb.traces.reserve(bsp->block->transactions.size());
+
+    for(auto& trx : bsp->block->transactions) {
+        auto& strx = trx.trx.get_signed_transaction();
+        auto  id   = strx.id();
+        auto& tr   = pb.traces.emplace_back();
+
+        if(trx.status != transaction_receipt_header::executed || strx.actions.empty()) {
+            continue;
+        }
+        while(!traces_.empty()) {
+            auto trace = traces_.front();
+            traces_.pop_front();
+
+            if(trace->id == id) {
+                tr = trace;
+                break;
+            }
+        }
+    }
+
+    if(bsp->block_num <= last_block_num_) {
+        return;
+    }
+
+    {
+        auto lock = std::unique_lock<std::mutex>(mutex_);
+        queue_.emplace_back(std::move(pb));
+    }
+    cond_.notify_one();
+}
+
+void
+history_db::write_loop() {
+    using namespace internal;
+
+    auto blocks = std::vector<pending_block>();
+    while(true) {
+        {
+            auto lock = std::unique_lock<std::mutex>(mutex_);
+            cond_.wait(lock, [this] { return done_ || !queue_.empty(); });
+            if(queue_.empty()) {
+                break;
+            }
+
+            // blocks queued meanwhile are written in one batch
+            while(!queue_.empty() && blocks.size() < (size_t)kBatchedBlocks) {
+                blocks.emplace_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        try {
+            auto batch = rocksdb::WriteBatch();
+            for(auto& pb : blocks) {
+                write_block(batch, pb);
+            }
+            batch.Put(handles_[0], kLastBlockKey, packed(blocks.back().block->block_num));
+            assert_ok(db_->Write(rocksdb::WriteOptions(), &batch), "Write history database");
+        }
+        catch(const fc::exception& e) {
+            elog("Write history of blocks ${b} - ${e} failed: ${d}",
+                ("b",blocks.front().block->block_num)("e",blocks.back().block->block_num)("d",e.to_detail_string()));
+        }
+        blocks.clear();
+    }
+}
+
+void
+history_db::write_block(rocksdb::WriteBatch& batch, const pending_block& pb) {
+    using namespace internal;
+
+    auto& abi      = chain_.get_abi_serializer();
+    auto& exec_ctx = chain_.get_execution_context();
+    auto& block    = pb.block;
+    auto  ts       = (std::string)block->header.timestamp.to_time_point();
+
+    for(auto i = 0u; i < block->block->transactions.size(); i++) {
+        auto& strx   = block->block->transactions[i].trx.get_signed_transaction();
+        auto  trx_id = strx.id();
+        auto  ht     = history_trx { block->block_num, i, {} };
+
+        if(pb.traces[i]) {
+            auto str_id = trx_id.str();
+            for(auto& act_trace : pb.traces[i]->action_traces) {
+                auto& act  = act_trace.act;
+                auto  seq  = act_trace.receipt.global_sequence;
+                auto& data = act_trace.data_json(abi, exec_ctx);
+                auto  ha   = history_action { str_id, act.name.to_string(), act.domain.to_string(), act.key.to_string(), data, ts };
+                auto  sk   = seq_key(seq);
+
+                batch.Put(actions_, sk, packed(ha));
+                batch.Put(domain_actions_, domain_prefix(act.domain) + sk, rocksdb::Slice());
+                batch.Put(key_actions_, key_prefix(act.domain, act.key) + sk, rocksdb::Slice());
+
+                auto& sym_id = ha.key;
+                if(act.domain == N128(.fungible) && !sym_id.empty() && std::all_of(sym_id.cbegin(), sym_id.cend(), ::isdigit)) {
+                    for(auto& addr : fungible_addresses(act, data)) {
+                        batch.Put(address_actions_, address_prefix((symbol_id_type)std::stoul(sym_id), addr) + sk, rocksdb::Slice());
+                    }
+                }
+                ht.actions.emplace_back(seq);
+            }
+        }
+        batch.Put(trxs_, trx_id_key(trx_id), packed(ht));
+
+        auto suffix = std::string();
+        append_be(suffix, block->block_num);
+        append_be(suffix, i);
+        for(auto& key : strx.get_signature_keys(chain_.get_chain_id())) {
+            batch.Put(key_trxs_, pubkey_prefix(key) + suffix, trx_id_key(trx_id));
+        }
+    }
+}
+
+std::optional<std::string>
+history_db::read_value(rocksdb::ColumnFamilyHandle* cf, const std::string& key) const {
+    auto value  = std::string();
+    auto status = db_->Get(rocksdb::ReadOptions(), cf, key, &value);
+    if(status.IsNotFound()) {
+        return std::nullopt;
+    }
+    internal::assert_ok(status, "Read history database");
+    return value;
+}
+
+template<typename Func>
+void
+history_db::scan_actions(rocksdb::ColumnFamilyHandle* cf, const std::string& prefix, bool asc, Func&& func) const {
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(rocksdb::ReadOptions(), cf));
+    if(asc) {
+        it->Seek(prefix);
+    }
+    else {
+        // last entry of prefix is the one before the largest suffix
+        it->SeekForPrev(prefix + std::string(sizeof(uint64_t), '\xff'));
+    }
+
+    for(; it->Valid() && it->key().starts_with(prefix); asc ? it->Next() : it->Prev()) {
+        auto key = it->key();
+        auto seq = uint64_t();
+        memcpy(&seq, key.data() + key.size() - sizeof(seq), sizeof(seq));
+        if(!func(boost::endian::big_to_native(seq))) {
+            break;
+        }
+    }
+    internal::assert_ok(it->status(), "Scan history database");
+}
+
+void
+history_db::get_actions_async(int id, const read_only::get_actions_params& params) {
+    using namespace internal;
+
+    int s, t;
+    get_window(params.skip, params.take, s, t);
+
+    auto domain = name128(params.domain);
+    auto prefix = params.key.has_value() ? key_prefix(domain, name128(*params.key)) : domain_prefix(domain);
+    auto cf     = params.key.has_value() ? key_actions_ : domain_actions_;
+    auto asc    = params.dire.has_value() && *params.dire == direction::asc;
+
+    auto names = std::vector<std::string>();
+    for(auto& n : params.names) {
+        names.emplace_back(n.to_string());
+    }
+
+    auto buf = fmt::memory_buffer();
+    auto n   = 0;
+
+    fmt::format_to(buf, "[");
+    if(t > 0) {
+        scan_actions(cf, prefix, asc, [&](auto seq) {
+            auto v = read_value(actions_, seq_key(seq));
+            if(!v.has_value()) {
+                return true;
+            }
+            auto act = fc::raw::unpack<history_action>(v->data(), v->size());
+            if(!names.empty() && std::find(names.cbegin(), names.cend(), act.name) == names.cend()) {
+                return true;
+            }
+            if(s > 0) {
+                s--;
+                return true;
+            }
+            if(n++ > 0) {
+                fmt::format_to(buf, ",");
+            }
+            format_action_to(buf, act);
+            return n < t;
+        });
+    }
+    fmt::format_to(buf, "]");
+
+    response_ok(id, buf);
+}
+
+void
+history_db::get_fungible_actions_async(int id, const read_only::get_fungible_actions_params& params) {
+    using namespace internal;
+
+    int s, t;
+    get_window(params.skip, params.take, s, t);
+
+    // actions of fungible without address filter are the ones in its key of `.fungible` domain,
+    // with address filter they're scanned from address index
+    auto prefix = std::string();
+    auto cf     = (rocksdb::ColumnFamilyHandle*)nullptr;
+    if(params.addr.has_value()) {
+        prefix = address_prefix(params.sym_id, (std::string)*params.addr);
+        cf     = address_actions_;
+    }
+    else {
+        prefix = key_prefix(N128(.fungible), name128(std::to_string(params.sym_id)));
+        cf     = key_actions_;
+    }
+    auto asc = params.dire.has_value() && *params.dire == direction::asc;
+
+    auto buf = fmt::memory_buffer();
+    auto n   = 0;
+
+    fmt::format_to(buf, "[");
+    if(t > 0) {
+        scan_actions(cf, prefix, asc, [&](auto seq) {
+            auto v = read_value(actions_, seq_key(seq));
+            if(!v.has_value()) {
+                return true;
+            }
+            auto act = fc::raw::unpack<history_action>(v->data(), v->size());
+            if(std::find(std::begin(kFungibleActions), std::end(kFungibleActions), act.name) == std::end(kFungibleActions)) {
+                return true;
+            }
+            if(s > 0) {
+                s--;
+                return true;
+            }
+            if(n++ > 0) {
+                fmt::format_to(buf, ",");
+            }
+            format_action_to(buf, act);
+            return n < t;
+        });
+    }
+    fmt::format_to(buf, "]");
+
+    response_ok(id, buf);
+}
+
+void
+history_db::get_transaction_async(int id, const read_only::get_transaction_params& params) {
+    using namespace internal;
+
+    auto v = read_value(trxs_, trx_id_key(params.id));
+    EVT_ASSERT(v.has_value(), chain::unknown_transaction_exception, "Cannot find transaction: ${t}", ("t", params.id));
+
+    auto ht    = fc::raw::unpack<history_trx>(v->data(), v->size());
+    auto block = chain_.fetch_block_by_number(ht.block_num);
+    EVT_ASSERT(block && ht.trx_num < block->transactions.size(), chain::unknown_transaction_exception,
+        "Cannot find transaction: ${t}", ("t", params.id));
+
+    auto buf = fmt::memory_buffer();
+    format_trx_to(buf, block->transactions[ht.trx_num].trx.get_signed_transaction(), ht.block_num, block->id(),
+        chain_.get_abi_serializer(), chain_.get_execution_context());
+
+    response_ok(id, buf);
+}
+
+void
+history_db::get_transactions_async(int id, const read_only::get_transactions_params& params) {
+    using namespace internal;
+
+    int s, t;
+    get_window(params.skip, params.take, s, t);
+
+    auto asc = params.dire.has_value() && *params.dire == direction::asc;
+
+    // position (block num + index in block) and id of transactions signed by any of the keys,
+    // at most `s + t` ones of each key are needed before they're merged
+    using entry = std::pair<std::string, std::string>;
+    auto trxs   = std::vector<entry>();
+
+    auto it = std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(rocksdb::ReadOptions(), key_trxs_));
+    for(auto& key : params.keys) {
+        auto prefix = pubkey_prefix(key);
+        if(asc) {
+            it->Seek(prefix);
+        }
+        else {
+            it->SeekForPrev(prefix + std::string(sizeof(uint32_t) * 2, '\xff'));
+        }
+
+        auto n = 0;
+        for(; it->Valid() && it->key().starts_with(prefix) && n < s + t; asc ? it->Next() : it->Prev(), n++) {
+            auto k = it->key();
+            k.remove_prefix(prefix.size());
+            trxs.emplace_back(k.ToString(), it->value().ToString());
+        }
+        assert_ok(it->status(), "Scan history database");
+    }
+
+    std::sort(trxs.begin(), trxs.end(), [asc](auto& a, auto& b) { return asc ? a < b : b < a; });
+    trxs.erase(std::unique(trxs.begin(), trxs.end()), trxs.end());
+
+    auto& abi      = chain_.get_abi_serializer();
+    auto& exec_ctx = chain_.get_execution_context();
+
+    auto buf   = fmt::memory_buffer();
+    auto found = 0;
+
+    fmt::format_to(buf, "[");
+    for(auto i = (size_t)s; i < trxs.size() && i < (size_t)s + t; i++) {
+        auto& pos       = trxs[i].first;
+        auto  block_num = uint32_t();
+        auto  trx_num   = uint32_t();
+        memcpy(&block_num, pos.data(), sizeof(block_num));
+        memcpy(&trx_num, pos.data() + sizeof(block_num), sizeof(trx_num));
+        block_num = boost::endian::big_to_native(block_num);
+        trx_num   = boost::endian::big_to_native(trx_num);
+
+        auto block = chain_.fetch_block_by_number(block_num);
+        if(!block || trx_num >= block->transactions.size()) {
+            continue;
+        }
+        if(found++ > 0) {
+            fmt::format_to(buf, ",");
+        }
+        format_trx_to(buf, block->transactions[trx_num].trx.get_signed_transaction(), block_num, block->id(), abi, exec_ctx);
+    }
+    fmt::format_to(buf, "]");
+
+    response_ok(id, buf);
+}
+
+void
+history_db::get_transaction_actions_async(int id, const read_only::get_transaction_actions_params& params) {
+    using namespace internal;
+
+    auto v = read_value(trxs_, trx_id_key(params.id));
+    EVT_ASSERT(v.has_value(), chain::unknown_transaction_exception, "Cannot find transaction: ${t}", ("t", params.id));
+
+    auto ht  = fc::raw::unpack<history_trx>(v->data(), v->size());
+    auto buf = fmt::memory_buffer();
+
+    fmt::format_to(buf, "[");
+    for(auto i = 0u; i < ht.actions.size(); i++) {
+        auto av = read_value(actions_, seq_key(ht.actions[i]));
+        EVT_ASSERT(av.has_value(), history_db_exception, "Cannot find action: ${s}", ("s", ht.actions[i]));
+
+        if(i > 0) {
+            fmt::format_to(buf, ",");
+        }
+        format_action_to(buf, fc::raw::unpack<history_action>(av->data(), av->size()));
+    }
+    fmt::format_to(buf, "]");
+
+    response_ok(id, buf);
+}
+
+}  // namespace evt
@@ -6,14 +6,17 @@
 
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
 
+#include <algorithm>
 #include <functional>
 #include <fmt/format.h>
 #include <libpq-fe.h>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
+#include <fc/crypto/hex.hpp>
 #include <fc/io/json.hpp>
 #include <evt/chain/block_header.hpp>
 #include <evt/chain/exceptions.hpp>
+#include <evt/chain/execution_context.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
 #include <evt/http_plugin/http_plugin.hpp>
@@ -56,6 +59,15 @@ format_array_to(fmt::memory_buffer& buf, Iterator begin, Iterator end) {
     fmt::format_to(buf, fmt("}}\t"));
 }
 
+template<typename Iterator>
+std::string
+format_array(Iterator begin, Iterator end) {
+    auto buf = fmt::memory_buffer();
+    format_array_to(buf, begin, end);
+    // without the ending tab
+    return std::string(buf.data(), buf.size() - 1);
+}
+
 enum task_type {
     kGetTokens = 0,
     kGetDomains,
@@ -98,6 +110,46 @@ response_ok<std::string>(int id, const std::string& str) {
     return PG_OK;
 }
 
+// Writes transaction the same as the variant of `abi.to_variant` with block info appended, except that
+// data of actions are written as json from binary directly without building the variants of them
+void
+format_trx_to(fmt::memory_buffer& buf, const signed_transaction& trx, uint32_t block_num, const block_id_type& block_id,
+              const abi_serializer& abi, const execution_context& exec_ctx) {
+    auto mv = fc::mutable_variant_object(fc::variant((const transaction_header&)trx));
+    mv["payer"]                  = trx.payer;
+    mv["transaction_extensions"] = trx.transaction_extensions;
+    mv["signatures"]             = trx.signatures;
+    mv["block_num"]              = block_num;
+    mv["block_id"]               = block_id;
+
+    // actions are appended to the object, so it's written without the ending brace
+    auto header = fc::json::to_string(mv);
+    buf.append(header.data(), header.data() + header.size() - 1);
+
+    fmt::format_to(buf, fmt(R"(,"actions":[)"));
+    for(auto i = 0u; i < trx.actions.size(); i++) {
+        auto& act = trx.actions[i];
+        fmt::format_to(buf, fmt(R"({{"name":"{}","domain":"{}","key":"{}","data":)"),
+            act.name.to_string(), act.domain.to_string(), act.key.to_string());
+
+        auto type = exec_ctx.get_acttype_name(act.name);
+        auto hex  = fc::to_hex(act.data.data(), act.data.size());
+        try {
+            FC_ASSERT(!type.empty());
+            auto data = abi.binary_to_json(type, act.data, exec_ctx, true /* short_path */);
+            fmt::format_to(buf, fmt(R"({},"hex_data":"{}"}})"), data, hex);
+        }
+        catch(...) {
+            // same as the variant, data is left as not serialized if it fails
+            fmt::format_to(buf, fmt(R"("{}"}})"), hex);
+        }
+        if(i < trx.actions.size() - 1) {
+            fmt::format_to(buf, ",");
+        }
+    }
+    fmt::format_to(buf, "]}}");
+}
+
 // This function is used to fix the representation of timestamp returned by postgres
 // Use 'T' as the separate the date and time to follow the ISO 8601 standard
 char*
@@ -113,102 +165,125 @@ fix_pg_timestamp(char* str) {
 }  // namespace internal
 
 int
-pg_query::connect(const std::string& conn) {
-    conn_ = PQconnectdb(conn.c_str());
+pg_query::connect(const std::string& conn, size_t pool_size) {
+    for(auto i = 0u; i < std::max<size_t>(pool_size, 1); i++) {
+        auto c  = std::make_unique<connection>(io_serv_);
+        c->conn = PQconnectdb(conn.c_str());
 
-    auto status = PQstatus(conn_);
-    EVT_ASSERT(status == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
+        auto status = PQstatus(c->conn);
+        EVT_ASSERT(status == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
 
-    socket_ = boost::asio::ip::tcp::socket(io_serv_, boost::asio::ip::tcp::v4(), PQsocket(conn_));
+        c->socket = boost::asio::ip::tcp::socket(io_serv_, boost::asio::ip::tcp::v4(), PQsocket(c->conn));
+        conns_.emplace_back(std::move(c));
+    }
     return PG_OK;
 }
 
 int
 pg_query::close() {
-    FC_ASSERT(conn_);
-    PQfinish(conn_);
-    conn_ = nullptr;
+    FC_ASSERT(!conns_.empty());
+    for(auto& c : conns_) {
+        // socket is owned by the connection
+        c->socket.release();
+        PQfinish(c->conn);
+    }
+    conns_.clear();
 
     return PG_OK;
 }
 
 int
 pg_query::prepare_stmts() {
-    for(auto it : internal::prepare_register::instance().stmts) {
-        auto r = PQprepare(conn_, it.first.c_str(), it.second.c_str(), 0, NULL);
-        EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
-            "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(conn_)));
-        PQclear(r);
+    for(auto& c : conns_) {
+        for(auto it : internal::prepare_register::instance().stmts) {
+            auto r = PQprepare(c->conn, it.first.c_str(), it.second.c_str(), 0, NULL);
+            EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
+                "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(c->conn)));
+            PQclear(r);
+        }
     }
     return PG_OK;
 }
 
 int
 pg_query::begin_poll_read() {
-    socket_.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this));
+    for(auto& c : conns_) {
+        c->socket.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this, std::ref(*c)));
+    }
     return PG_OK;
 }
 
 int
-pg_query::queue(int id, int task, std::string&& stmt) {
-    tasks_.emplace(id, task, std::move(stmt));
-    
-    if(!sending_) {
-        send_once();
+pg_query::queue(int id, int task, const char* plan, std::vector<std::string>&& params) {
+    auto it = std::min_element(conns_.begin(), conns_.end(), [](auto& a, auto& b) {
+        return a->tasks.size() < b->tasks.size();
+    });
+    auto& c = **it;
+    c.tasks.emplace(id, task, plan, std::move(params));
+
+    if(!c.sending) {
+        send_once(c);
     }
     return PG_OK;
 }
 
 int
-pg_query::send_once() {
+pg_query::send_once(connection& c) {
     using namespace internal;
 
-    assert(!tasks_.empty());
-    auto& t = tasks_.front();
+    assert(!c.tasks.empty());
+    auto& t = c.tasks.front();
 
-    auto r = PQsendQuery(conn_, t.stmt.c_str());
+    // parameters are all passed in text format
+    auto values = std::vector<const char*>();
+    values.reserve(t.params.size());
+    for(auto& p : t.params) {
+        values.emplace_back(p.c_str());
+    }
+
+    auto r = PQsendQueryPrepared(c.conn, t.plan, (int)values.size(), values.data(), NULL, NULL, 0);
     if(r == 1) {
-        sending_ = true;
+        c.sending = true;
         return PG_OK;
     }
 
     try {
         EVT_THROW2(chain::postgres_send_exception,
-            "Send '{}' query command failed, try agian later, detail: {}", call_names[t.type], PQerrorMessage(conn_));
+            "Send '{}' query command failed, try agian later, detail: {}", call_names[t.type], PQerrorMessage(c.conn));
     }
     catch(...) {
         app().get_plugin<http_plugin>().handle_async_exception(t.id, "history", call_names[t.type], "");
     }
 
-    tasks_.pop();
-    if(!tasks_.empty()) {
+    c.tasks.pop();
+    if(!c.tasks.empty()) {
         // send next one
-        return send_once();
+        return send_once(c);
     }
     return PG_FAIL;
 }
 
 int
-pg_query::poll_read() {
+pg_query::poll_read(connection& c) {
     using namespace internal;
 
     bool busy = false;
     while(1) {
-        auto r = PQconsumeInput(conn_);
-        EVT_ASSERT(r, chain::postgres_poll_exception, "Poll messages from postgres failed, detail: ${d}", ("d",PQerrorMessage(conn_)));
+        auto r = PQconsumeInput(c.conn);
+        EVT_ASSERT(r, chain::postgres_poll_exception, "Poll messages from postgres failed, detail: ${d}", ("d",PQerrorMessage(c.conn)));
 
-        if(PQisBusy(conn_)) {
+        if(PQisBusy(c.conn)) {
             busy = true;
             break;
         }
 
-        auto re = PQgetResult(conn_);
+        auto re = PQgetResult(c.conn);
         if(re == NULL) {
             break;
         }
 
-        auto t = tasks_.front();
-        tasks_.pop();
+        auto t = std::move(c.tasks.front());
+        c.tasks.pop();
 
         try {
             switch(t.type) {
@@ -265,22 +340,22 @@ pg_query::poll_read() {
         PQclear(re);
     }
 
-    socket_.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this));
+    c.socket.async_wait(boost::asio::ip::tcp::socket::wait_type::wait_read, std::bind(&pg_query::poll_read, this, std::ref(c)));
     if(busy) {
         // still needs wait next data part
         return PG_OK;
     }
-    if(!tasks_.empty()) {
+    if(!c.tasks.empty()) {
         // send next one
-        if(send_once() == PG_FAIL) {
+        if(send_once(c) == PG_FAIL) {
             // no send
-            FC_ASSERT(tasks_.empty(), "Tasks should be empty");
-            sending_ = false;
+            FC_ASSERT(c.tasks.empty(), "Tasks should be empty");
+            c.sending = false;
         }
         // keep sending state
     }
     else {  // tasks is empty
-        sending_ = false;
+        c.sending = false;
     }
     return PG_OK;
 }
@@ -292,25 +367,27 @@ int
 pg_query::get_tokens_async(int id, const read_only::get_tokens_params& params) {
     using namespace internal;
 
-    auto pkeys_buf = fmt::memory_buffer();
-    format_array_to(pkeys_buf, std::begin(params.keys), std::end(params.keys));
+    auto pkeys = format_array(std::begin(params.keys), std::end(params.keys));
 
-    auto stmt = std::string();
+    auto plan   = (const char*)nullptr;
+    auto values = std::vector<std::string>();
     if(params.domain.has_value()) {
-        stmt = fmt::format(fmt("EXECUTE gt_plan ('{}','{}');"), fmt::to_string(pkeys_buf), (std::string)*params.domain);
+        plan   = "gt_plan";
+        values = { pkeys, (std::string)*params.domain };
     }
     else {
-        stmt = fmt::format(fmt("EXECUTE gt_plan2 ('{}');"), fmt::to_string(pkeys_buf));
+        plan   = "gt_plan2";
+        values = { pkeys };
     }
 
-    return queue(id, kGetTokens, std::move(stmt));
+    return queue(id, kGetTokens, plan, std::move(values));
 }
 
 int
 pg_query::get_tokens_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get tokens failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get tokens failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -337,18 +414,16 @@ int
 pg_query::get_domains_async(int id, const read_only::get_params& params) {
     using namespace internal;
 
-    auto pkeys_buf = fmt::memory_buffer();
-    format_array_to(pkeys_buf, std::begin(params.keys), std::end(params.keys));
+    auto pkeys = format_array(std::begin(params.keys), std::end(params.keys));
 
-    auto stmt = fmt::format(fmt("EXECUTE gd_plan ('{}')"), fmt::to_string(pkeys_buf));
-    return queue(id, kGetDomains, std::move(stmt));
+    return queue(id, kGetDomains, "gd_plan", { pkeys });
 }
 
 int
 pg_query::get_domains_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get domains failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get domains failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -370,18 +445,16 @@ int
 pg_query::get_groups_async(int id, const read_only::get_params& params) {
     using namespace internal;
 
-    auto pkeys_buf = fmt::memory_buffer();
-    format_array_to(pkeys_buf, std::begin(params.keys), std::end(params.keys));
+    auto pkeys = format_array(std::begin(params.keys), std::end(params.keys));
 
-    auto stmt = fmt::format(fmt("EXECUTE gg_plan ('{}')"), fmt::to_string(pkeys_buf));
-    return queue(id, kGetGroups, std::move(stmt));
+    return queue(id, kGetGroups, "gg_plan", { pkeys });
 }
 
 int
 pg_query::get_groups_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get groups failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get groups failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -403,18 +476,16 @@ int
 pg_query::get_fungibles_async(int id, const read_only::get_params& params) {
     using namespace internal;
 
-    auto pkeys_buf = fmt::memory_buffer();
-    format_array_to(pkeys_buf, std::begin(params.keys), std::end(params.keys));
+    auto pkeys = format_array(std::begin(params.keys), std::end(params.keys));
 
-    auto stmt = fmt::format(fmt("EXECUTE gf_plan ('{}')"), fmt::to_string(pkeys_buf));
-    return queue(id, kGetFungibles, std::move(stmt));
+    return queue(id, kGetFungibles, "gf_plan", { pkeys });
 }
 
 int
 pg_query::get_fungibles_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungibles failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungibles failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -487,7 +558,8 @@ pg_query::get_actions_async(int id, const read_only::get_actions_params& params)
         EVT_ASSERT(t <= 20, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 20 per query");
     }
 
-    auto stmt = std::string();
+    auto plan   = (const char*)nullptr;
+    auto values = std::vector<std::string>();
 
     int j = 0;
     if(params.dire.has_value() && *params.dire == direction::asc) {
@@ -502,59 +574,63 @@ pg_query::get_actions_async(int id, const read_only::get_actions_params& params)
 
     switch(j) {
     case 0: { // only domain, desc
-        stmt = fmt::format(fmt("EXECUTE ga_plan01 ('{}',{},{});"), (std::string)params.domain, t, s);
+        plan   = "ga_plan01";
+        values = { (std::string)params.domain, std::to_string(t), std::to_string(s) };
         break;
     }
     case 1: { // only domain, asc
-        stmt = fmt::format(fmt("EXECUTE ga_plan02 ('{}',{},{});"), (std::string)params.domain, t, s);
+        plan   = "ga_plan02";
+        values = { (std::string)params.domain, std::to_string(t), std::to_string(s) };
         break;
     }
     case 2: { // domain + key, desc
-        stmt = fmt::format(fmt("EXECUTE ga_plan11 ('{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, t, s);
+        plan   = "ga_plan11";
+        values = { (std::string)params.domain, (std::string)*params.key, std::to_string(t), std::to_string(s) };
         break;
     }
     case 3: { // domain + key, asc
-        stmt = fmt::format(fmt("EXECUTE ga_plan12 ('{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, t, s);
+        plan   = "ga_plan12";
+        values = { (std::string)params.domain, (std::string)*params.key, std::to_string(t), std::to_string(s) };
         break;
     }
     case 4: { // domain + name, desc
-        auto names_buf = fmt::memory_buffer();
-        format_array_to(names_buf, std::begin(params.names), std::end(params.names));
+        auto names = format_array(std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan21 ('{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), t, s);
+        plan   = "ga_plan21";
+        values = { (std::string)params.domain, names, std::to_string(t), std::to_string(s) };
         break;
     }
     case 5: { // domain + name, asc
-        auto names_buf = fmt::memory_buffer();
-        format_array_to(names_buf, std::begin(params.names), std::end(params.names));
+        auto names = format_array(std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan22 ('{}','{}',{},{});"), (std::string)params.domain, fmt::to_string(names_buf), t, s);
+        plan   = "ga_plan22";
+        values = { (std::string)params.domain, names, std::to_string(t), std::to_string(s) };
         break;
     }
     case 6: { // domain + key + name, desc
-        auto names_buf = fmt::memory_buffer();
-        format_array_to(names_buf, std::begin(params.names), std::end(params.names));
+        auto names = format_array(std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan31 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), t, s);
+        plan   = "ga_plan31";
+        values = { (std::string)params.domain, (std::string)*params.key, names, std::to_string(t), std::to_string(s) };
         break;
     }
     case 7: { // domain + key + name, asc
-        auto names_buf = fmt::memory_buffer();
-        format_array_to(names_buf, std::begin(params.names), std::end(params.names));
+        auto names = format_array(std::begin(params.names), std::end(params.names));
 
-        stmt = fmt::format(fmt("EXECUTE ga_plan32 ('{}','{}','{}',{},{});"), (std::string)params.domain, (std::string)*params.key, fmt::to_string(names_buf), t, s);
+        plan   = "ga_plan32";
+        values = { (std::string)params.domain, (std::string)*params.key, names, std::to_string(t), std::to_string(s) };
         break;
     }
     };  // switch
 
-    return queue(id, kGetActions, std::move(stmt));
+    return queue(id, kGetActions, plan, std::move(values));
 }
 
 int
 pg_query::get_actions_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get actions failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
     auto n = PQntuples(r);
     if(n == 0) {
         return response_ok(id, std::string("[]")); // return empty
@@ -588,29 +664,25 @@ auto gfa_plan0 = R"sql(SELECT actions.trx_id, name, domain, key, data, transacti
                        WHERE
                            domain = '.fungible'
                            AND key = $1
-                           AND name = ANY('{{"issuefungible","transferft","recycleft","evt2pevt","everipay","paybonus"}}')
+                           AND name = ANY('{{"issuefungible","transferft","batchtransft","recycleft","evt2pevt","everipay","paybonus"}}')
                        ORDER BY actions.created_at {0}, actions.seq_num {0}
                        LIMIT $2 OFFSET $3
                        )sql";
 
 // with address filter
+// actions of address are found by the narrow index table written along with actions
+// receivers in `credits` of batchtransft have their own rows, so they're found the same as `to` of transferft
 auto gfa_plan1 = R"sql(SELECT actions.trx_id, name, domain, key, data, transactions.timestamp
-                       FROM actions
+                       FROM action_addresses
+                       JOIN actions ON actions.block_num = action_addresses.block_num
+                                   AND actions.trx_id = action_addresses.trx_id
+                                   AND actions.seq_num = action_addresses.seq_num
                        JOIN transactions ON actions.trx_id = transactions.trx_id
                        WHERE
-                           domain = '.fungible'
-                           AND key = $1
-                           AND name = ANY('{{"issuefungible","transferft","recycleft","evt2pevt","everipay","paybonus"}}')
-                           AND (
-                               data->>'address' = $2 OR
-                               data->>'from' = $2 OR
-                               data->>'to' = $2 OR
-                               data->>'payee' = $2 OR
-                               data->'link'->'keys' @> $3 OR
-                               data->>'payer' = $2
-                           )
-                       ORDER BY actions.created_at {0}, actions.seq_num {0}
-                       LIMIT $4 OFFSET $5
+                           action_addresses.address = $2
+                           AND action_addresses.sym_id = $1
+                       ORDER BY action_addresses.global_seq {0}
+                       LIMIT $3 OFFSET $4
                        )sql";
 
 PREPARE_SQL_ONCE(gfa_plan01, fmt::format(gfa_plan0, "DESC"));
@@ -631,7 +703,8 @@ pg_query::get_fungible_actions_async(int id, const read_only::get_fungible_actio
         EVT_ASSERT(t <= 20, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 20 per query");
     }
 
-    auto stmt = std::string();
+    auto plan   = (const char*)nullptr;
+    auto values = std::vector<std::string>();
 
     int j = 0;
     if(params.dire.has_value() && *params.dire == direction::asc) {
@@ -643,31 +716,35 @@ pg_query::get_fungible_actions_async(int id, const read_only::get_fungible_actio
 
     switch(j) {
     case 0: { // only sym id, desc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan01 ('{}',{},{});"), params.sym_id, t, s);
+        plan   = "gfa_plan01";
+        values = { std::to_string(params.sym_id), std::to_string(t), std::to_string(s) };
         break;
     }
     case 1: { // only sym id, asc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan02 ('{}',{},{});"), params.sym_id, t, s);
+        plan   = "gfa_plan02";
+        values = { std::to_string(params.sym_id), std::to_string(t), std::to_string(s) };
         break;
     }
     case 2: { // sym id + address, desc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan11 ('{0}','{1}','\"{1}\"',{2},{3});"), params.sym_id, (std::string)*params.addr, t, s);
+        plan   = "gfa_plan11";
+        values = { std::to_string(params.sym_id), (std::string)*params.addr, std::to_string(t), std::to_string(s) };
         break;
     }
     case 3: { // sym id + address, asc
-        stmt = fmt::format(fmt("EXECUTE gfa_plan12 ('{0}','{1}','\"{1}\"',{2},{3});"), params.sym_id, (std::string)*params.addr, t, s);
+        plan   = "gfa_plan12";
+        values = { std::to_string(params.sym_id), (std::string)*params.addr, std::to_string(t), std::to_string(s) };
         break;
     }
     };  // switch
 
-    return queue(id, kGetFungibleActions, std::move(stmt));
+    return queue(id, kGetFungibleActions, plan, std::move(values));
 }
 
 int
 pg_query::get_fungible_actions_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible actions failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -702,8 +779,7 @@ int
 pg_query::get_fungibles_balance_async(int id, const read_only::get_fungibles_balance_params& params) {
     using namespace internal;
 
-    auto stmt = fmt::format(fmt("EXECUTE gfb_plan('{}');"), (std::string)params.addr);
-    return queue(id, kGetFungiblesBalance, std::move(stmt));
+    return queue(id, kGetFungiblesBalance, "gfb_plan", { (std::string)params.addr });
 }
 
 #define READ_DB_ASSET(ADDR, SYM_ID, VALUEREF)                                                         \
@@ -723,7 +799,7 @@ pg_query::get_fungibles_balance_resume(int id, pg_result const* r) {
     using namespace boost::algorithm;
     using namespace chain;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -759,15 +835,14 @@ int
 pg_query::get_transaction_async(int id, const read_only::get_transaction_params& params) {
     using namespace internal;
 
-    auto stmt = fmt::format(fmt("EXECUTE gtrx_plan('{}');"), (std::string)params.id);
-    return queue(id, kGetTransaction, std::move(stmt));
+    return queue(id, kGetTransaction, "gtrx_plan", { (std::string)params.id });
 }
 
 int
 pg_query::get_transaction_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -787,14 +862,10 @@ pg_query::get_transaction_resume(int id, pg_result const* r) {
         auto& exec_ctx = chain_.get_execution_context();
         for(auto& tx : block->transactions) {
             if(tx.trx.id() == trx_id) {
-                auto var = fc::variant();
-                abi.to_variant(tx.trx, var, exec_ctx);
-
-                auto mv = fc::mutable_variant_object(var);
-                mv["block_num"] = block_num;
-                mv["block_id"]  = block->id();
+                auto builder = fmt::memory_buffer();
+                format_trx_to(builder, tx.trx, block_num, block->id(), abi, exec_ctx);
 
-                return response_ok(id, mv);
+                return response_ok(id, fmt::to_string(builder));
             }
         }
     }    
@@ -817,32 +888,37 @@ pg_query::get_transactions_async(int id, const read_only::get_transactions_param
         EVT_ASSERT(t <= 20, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 20 per query");
     }
 
-    auto keys_buf = fmt::memory_buffer();
-    format_array_to(keys_buf, std::begin(params.keys), std::end(params.keys));
+    auto keys = format_array(std::begin(params.keys), std::end(params.keys));
 
-    auto stmt = std::string();
+    auto plan   = (const char*)nullptr;
+    auto values = std::vector<std::string>();
     if(params.dire.has_value() && *params.dire == direction::asc) {
-        stmt = fmt::format(fmt("EXECUTE gtrxs_plan0('{}',{},{});"), fmt::to_string(keys_buf), t, s);
+        plan   = "gtrxs_plan0";
+        values = { keys, std::to_string(t), std::to_string(s) };
     }
     else {
-        stmt = fmt::format(fmt("EXECUTE gtrxs_plan1('{}',{},{});"), fmt::to_string(keys_buf), t, s);
+        plan   = "gtrxs_plan1";
+        values = { keys, std::to_string(t), std::to_string(s) };
     }
 
-    return queue(id, kGetTransactions, std::move(stmt));
+    return queue(id, kGetTransactions, plan, std::move(values));
 }
 
 int
 pg_query::get_transactions_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
         return response_ok(id, std::string("[]")); // return empty
     }
 
-    auto results = fc::variants();
+    auto builder = fmt::memory_buffer();
+    auto found   = 0;
+
+    fmt::format_to(builder, "[");
     for(int i = 0; i < n; i++) {
         auto trx_id    = transaction_id_type(std::string(PQgetvalue(r, i, 1), PQgetlength(r, i, 1)));
         auto block_num = boost::lexical_cast<uint32_t>(PQgetvalue(r, i, 0));
@@ -856,19 +932,17 @@ pg_query::get_transactions_resume(int id, pg_result const* r) {
         auto& exec_ctx = chain_.get_execution_context();
         for(auto& tx : block->transactions) {
             if(tx.trx.id() == trx_id) {
-                auto var = fc::variant();
-                abi.to_variant(tx.trx, var, exec_ctx);
-
-                auto mv = fc::mutable_variant_object(var);
-                mv["block_num"] = block_num;
-                mv["block_id"]  = block->id();
-
-                results.emplace_back(mv);
+                if(found++ > 0) {
+                    fmt::format_to(builder, ",");
+                }
+                format_trx_to(builder, tx.trx, block_num, block->id(), abi, exec_ctx);
                 break;
             }
         }
-    }    
-    return response_ok(id, results);
+    }
+    fmt::format_to(builder, "]");
+
+    return response_ok(id, fmt::to_string(builder));
 }
 
 PREPARE_SQL_ONCE(gfi_plan, "SELECT sym_id FROM fungibles ORDER BY sym_id ASC LIMIT $1 OFFSET $2;");
@@ -886,15 +960,14 @@ pg_query::get_fungible_ids_async(int id, const read_only::get_fungible_ids_param
         EVT_ASSERT(t <= 100, chain::exceed_query_limit_exception, "Exceed limit of max actions return allowed for each query, limit: 100 per query");
     }
 
-    auto stmt = fmt::format(fmt("EXECUTE gfi_plan({},{});"), t, s);
-    return queue(id, kGetFungibleIds, std::move(stmt));
+    return queue(id, kGetFungibleIds, "gfi_plan", { std::to_string(t), std::to_string(s) });
 }
 
 int
 pg_query::get_fungible_ids_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible ids failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get fungible ids failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -925,15 +998,14 @@ int
 pg_query::get_transaction_actions_async(int id, const read_only::get_transaction_actions_params& params) {
     using namespace internal;
 
-    auto stmt = fmt::format(fmt("EXECUTE gta_plan('{}');"), (std::string)params.id);
-    return queue(id, kGetTransactionActions, std::move(stmt));
+    return queue(id, kGetTransactionActions, "gta_plan", { (std::string)params.id });
 }
 
 int
 pg_query::get_transaction_actions_resume(int id, pg_result const* r) {
     using namespace internal;
 
-    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction actions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_query_exception, "Get transaction actions failed, detail: ${s}", ("s",PQresultErrorMessage(r)));
 
     auto n = PQntuples(r);
     if(n == 0) {
@@ -4,28 +4,90 @@
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
 
+#include <evt/chain/block_bus.hpp>
+#include <evt/chain/exceptions.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/history_plugin/evt_pg_query.hpp>
+#include <evt/history_plugin/evt_history_db.hpp>
 
 namespace evt {
 
+namespace bfs = boost::filesystem;
+
 static appbase::abstract_plugin& _history_plugin = app().register_plugin<history_plugin>();
 
 class history_plugin_impl {
 public:
-    history_plugin_impl()
-        : pg_query_(app().get_io_service(), app().get_plugin<chain_plugin>().chain()) {
-        pg_query_.connect(app().get_plugin<postgres_plugin>().connstr());
-        pg_query_.prepare_stmts();
-        pg_query_.begin_poll_read();
+    history_plugin_impl(uint32_t connections) {
+        pg_query_.emplace(app().get_io_service(), app().get_plugin<chain_plugin>().chain());
+        pg_query_->connect(app().get_plugin<postgres_plugin>().connstr(), connections);
+        pg_query_->prepare_stmts();
+        pg_query_->begin_poll_read();
+    }
+
+    history_plugin_impl(const fc::path& dir) {
+        auto& chain = app().get_plugin<chain_plugin>().chain();
+
+        history_db_ = std::make_shared<history_db>(chain, dir);
+        history_db_->open();
+
+        // traces are matched with the irreversible blocks on the thread of block bus if it's enabled,
+        // history db is only touched by that thread then, same as by the thread applying blocks otherwise
+        bus_ = chain.get_block_bus();
+        if(bus_ != nullptr) {
+            bus_->subscribe([wdb = std::weak_ptr<history_db>(history_db_)](auto& batch) {
+                // bus is never unsubscribed, it may outlive the plugin
+                auto db = wdb.lock();
+                if(!db) {
+                    return;
+                }
+                if(batch->irreversible) {
+                    db->irreversible_block(batch->block);
+                    return;
+                }
+                for(auto& trace : batch->traces) {
+                    db->applied_transaction(trace);
+                }
+            });
+            return;
+        }
+
+        applied_transaction_connection_.emplace(chain.applied_transaction.connect([this](auto& trace) {
+            history_db_->applied_transaction(trace);
+        }));
+        irreversible_block_connection_.emplace(chain.irreversible_block.connect([this](auto& bsp) {
+            history_db_->irreversible_block(bsp);
+        }));
     }
 
     ~history_plugin_impl() {
-        pg_query_.close();
+        if(pg_query_.has_value()) {
+            pg_query_->close();
+        }
+        if(history_db_) {
+            applied_transaction_connection_.reset();
+            irreversible_block_connection_.reset();
+            if(bus_ != nullptr) {
+                // no blocks are applied once plugins are being shut down, so it's drained after this
+                bus_->flush();
+            }
+            history_db_->close();
+        }
     }
 
 public:
-    pg_query pg_query_;
+    pg_query& pg() {
+        EVT_ASSERT(pg_query_.has_value(), chain::history_not_supported_exception, "This query is only supported by postgres history backend");
+        return *pg_query_;
+    }
+
+public:
+    std::optional<pg_query>     pg_query_;
+    std::shared_ptr<history_db> history_db_;
+    chain::block_bus*           bus_ = nullptr;
+
+    std::optional<boost::signals2::scoped_connection> applied_transaction_connection_;
+    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
 };
 
 history_plugin::history_plugin() {}
@@ -33,16 +95,40 @@ history_plugin::~history_plugin() {}
 
 void
 history_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("history-pg-connections", bpo::value<uint32_t>()->default_value(4), "Number of connections to postgres used by history queries")
+        ("history-backend", bpo::value<std::string>()->default_value("postgres"),
+            "Backend of history queries, 'postgres' or 'rocksdb' for the embedded database which doesn't need postgres plugin")
+        ("history-db-dir", bpo::value<bfs::path>()->default_value("history"),
+            "The location of embedded history database (absolute path or relative to application data dir)")
+        ;
 }
 
 void
 history_plugin::plugin_initialize(const variables_map& options) {
+    connections_ = options.at("history-pg-connections").as<uint32_t>();
+    EVT_ASSERT(connections_ > 0, chain::plugin_config_exception, "history-pg-connections must be greater than 0");
+
+    auto backend = options.at("history-backend").as<std::string>();
+    EVT_ASSERT(backend == "postgres" || backend == "rocksdb", chain::plugin_config_exception,
+        "history-backend must be 'postgres' or 'rocksdb'");
+    if(backend == "rocksdb") {
+        auto dir = options.at("history-db-dir").as<bfs::path>();
+        if(dir.is_relative()) {
+            dir = app().data_dir() / dir;
+        }
+        db_dir_ = dir;
+    }
 }
 
 void
 history_plugin::plugin_startup() {
-    if(app().get_plugin<postgres_plugin>().enabled()) {
-        my_.reset(new history_plugin_impl());
+    if(db_dir_.has_value()) {
+        my_.reset(new history_plugin_impl(*db_dir_));
+        ilog("history_plugin uses embedded history database: ${d}", ("d",db_dir_->generic_string()));
+    }
+    else if(app().get_plugin<postgres_plugin>().enabled()) {
+        my_.reset(new history_plugin_impl(connections_));
     }
     else {
         wlog("evt::postgres_plugin configured, but no --postgres-uri specified.");
@@ -52,6 +138,7 @@ history_plugin::plugin_startup() {
 
 void
 history_plugin::plugin_shutdown() {
+    my_.reset();
 }
 
 namespace history_apis {
@@ -60,77 +147,97 @@ void
 read_only::get_tokens_async(int id, const get_tokens_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_tokens_async(id, params);
+    plugin_.my_->pg().get_tokens_async(id, params);
 }
 
 void
 read_only::get_domains_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_domains_async(id, params);
+    plugin_.my_->pg().get_domains_async(id, params);
 }
 
 void
 read_only::get_groups_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_groups_async(id, params);
+    plugin_.my_->pg().get_groups_async(id, params);
 }
 
 void
 read_only::get_fungibles_async(int id, const get_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungibles_async(id, params);
+    plugin_.my_->pg().get_fungibles_async(id, params);
 }
 
 void
 read_only::get_actions_async(int id, const get_actions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_actions_async(id, params);
+    if(plugin_.my_->history_db_) {
+        plugin_.my_->history_db_->get_actions_async(id, params);
+        return;
+    }
+    plugin_.my_->pg().get_actions_async(id, params);
 }
 
 void
 read_only::get_fungible_actions_async(int id, const get_fungible_actions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungible_actions_async(id, params);
+    if(plugin_.my_->history_db_) {
+        plugin_.my_->history_db_->get_fungible_actions_async(id, params);
+        return;
+    }
+    plugin_.my_->pg().get_fungible_actions_async(id, params);
 }
 
 void
 read_only::get_fungibles_balance_async(int id, const get_fungibles_balance_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungibles_balance_async(id, params);
+    plugin_.my_->pg().get_fungibles_balance_async(id, params);
 }
 
 void
 read_only::get_transaction_async(int id, const get_transaction_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transaction_async(id, params);
+    if(plugin_.my_->history_db_) {
+        plugin_.my_->history_db_->get_transaction_async(id, params);
+        return;
+    }
+    plugin_.my_->pg().get_transaction_async(id, params);
 }
 
 void
 read_only::get_transactions_async(int id, const get_transactions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transactions_async(id, params);
+    if(plugin_.my_->history_db_) {
+        plugin_.my_->history_db_->get_transactions_async(id, params);
+        return;
+    }
+    plugin_.my_->pg().get_transactions_async(id, params);
 }
 
 void
 read_only::get_fungible_ids_async(int id, const get_fungible_ids_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_fungible_ids_async(id, params);
+    plugin_.my_->pg().get_fungible_ids_async(id, params);
 }
 
 void
 read_only::get_transaction_actions_async(int id, const get_transaction_actions_params& params) {
     EVT_ASSERT(plugin_.my_, chain::postgres_not_enabled_exception, "Postgres plugin is not enabled.");
 
-    plugin_.my_->pg_query_.get_transaction_actions_async(id, params);
+    if(plugin_.my_->history_db_) {
+        plugin_.my_->history_db_->get_transaction_actions_async(id, params);
+        return;
+    }
+    plugin_.my_->pg().get_transaction_actions_async(id, params);
 }
 
 }}  // namespace evt::history_apis
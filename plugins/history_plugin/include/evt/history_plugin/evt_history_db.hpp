@@ -0,0 +1,109 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fc/filesystem.hpp>
+#include <evt/chain/block_state.hpp>
+#include <evt/chain/trace.hpp>
+#include <evt/history_plugin/history_plugin.hpp>
+
+namespace rocksdb {
+class DB;
+class ColumnFamilyHandle;
+class WriteBatch;
+}  // namespace rocksdb
+
+namespace evt {
+
+namespace chain {
+class controller;
+}  // namespace chain
+
+using namespace evt::history_apis;
+
+/**
+ *  Embedded history backend used instead of postgres, it keeps the irreversible transactions and
+ *  actions in a separated rocksdb with one column family for each index:
+ *
+ *  - trxs:            trx id -> block num, index in block and global sequences of actions
+ *  - actions:         global sequence -> action
+ *  - domain_actions:  domain + global sequence
+ *  - key_actions:     domain + key + global sequence
+ *  - address_actions: address + sym id + global sequence, for the actions of fungibles
+ *  - key_trxs:        signing key + block num + index in block -> trx id
+ *
+ *  Integers in keys are big-endian so the entries of one prefix are in order. Blocks are written
+ *  in batches on its own thread, queries are served by prefix iterators on the calling thread.
+ */
+class history_db : boost::noncopyable {
+private:
+    struct pending_block {
+        chain::block_state_ptr                    block;
+        std::vector<chain::transaction_trace_ptr> traces;
+    };
+
+public:
+    history_db(chain::controller& chain, const fc::path& dir);
+    ~history_db();
+
+public:
+    void open();
+    void close();
+
+    void applied_transaction(const chain::transaction_trace_ptr& trace);
+    void irreversible_block(const chain::block_state_ptr& bsp);
+
+public:
+    // responses are sent before they return, same as the ones of pg_query once resumed
+    void get_actions_async(int id, const read_only::get_actions_params& params);
+    void get_fungible_actions_async(int id, const read_only::get_fungible_actions_params& params);
+    void get_transaction_async(int id, const read_only::get_transaction_params& params);
+    void get_transactions_async(int id, const read_only::get_transactions_params& params);
+    void get_transaction_actions_async(int id, const read_only::get_transaction_actions_params& params);
+
+private:
+    void write_loop();
+    void write_block(rocksdb::WriteBatch& batch, const pending_block& pb);
+
+    // visits global sequences of the entries with `prefix` in `cf`, until `func` returns false
+    template<typename Func>
+    void scan_actions(rocksdb::ColumnFamilyHandle* cf, const std::string& prefix, bool asc, Func&& func) const;
+
+    std::optional<std::string> read_value(rocksdb::ColumnFamilyHandle* cf, const std::string& key) const;
+
+private:
+    chain::controller& chain_;
+    fc::path           dir_;
+
+    rocksdb::DB*                 db_;
+    rocksdb::ColumnFamilyHandle* trxs_;
+    rocksdb::ColumnFamilyHandle* actions_;
+    rocksdb::ColumnFamilyHandle* domain_actions_;
+    rocksdb::ColumnFamilyHandle* key_actions_;
+    rocksdb::ColumnFamilyHandle* address_actions_;
+    rocksdb::ColumnFamilyHandle* key_trxs_;
+    std::vector<rocksdb::ColumnFamilyHandle*> handles_;
+
+    uint32_t last_block_num_;  // last block written in last run
+
+    // traces of applied transactions, the ones of irreversible blocks are taken in order
+    std::deque<chain::transaction_trace_ptr> traces_;
+
+    std::deque<pending_block> queue_;
+    std::mutex                mutex_;
+    std::condition_variable   cond_;
+    bool                      done_;
+    std::thread               writer_;
+};
+
+}  // namespace evt
@@ -3,11 +3,14 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <fmt/format.h>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/contracts/types.hpp>
@@ -20,6 +23,7 @@ namespace evt {
 
 namespace chain {
 class controller;
+class execution_context;
 namespace contracts {
 struct abi_serializer;
 }  // namespace contracts
@@ -28,29 +32,52 @@ struct abi_serializer;
 using namespace evt::chain::contracts;
 using namespace evt::history_apis;
 
+namespace internal {
+
+// also used by the embedded history backend so both of them return the same transactions
+void format_trx_to(fmt::memory_buffer& buf, const chain::signed_transaction& trx, uint32_t block_num, const chain::block_id_type& block_id,
+                   const abi_serializer& abi, const chain::execution_context& exec_ctx);
+
+}  // namespace internal
+
 #define PG_OK   1
 #define PG_FAIL 0
 
 
+// queries are executed as prepared statements with bound parameters over a pool of connections,
+// each connection runs one query at a time and new query goes to the one with fewest queued
 class pg_query : boost::noncopyable {
 private:
     struct task {
     public:
-        task(int id, int type, std::string&& stmt)
-            : id(id), type(type), stmt(std::move(stmt)) {}
+        task(int id, int type, const char* plan, std::vector<std::string>&& params)
+            : id(id), type(type), plan(plan), params(std::move(params)) {}
+
+    public:
+        int                      id;
+        int                      type;
+        const char*              plan;
+        std::vector<std::string> params;
+    };
+
+    struct connection {
+    public:
+        connection(boost::asio::io_context& io_serv)
+            : conn(nullptr), sending(false), socket(io_serv) {}
 
     public:
-        int         id;
-        int         type;
-        std::string stmt;
+        pg_conn*                     conn;
+        bool                         sending;
+        std::queue<task>             tasks;
+        boost::asio::ip::tcp::socket socket;
     };
 
 public:
     pg_query(boost::asio::io_context& io_serv, controller& chain)
-        : conn_(nullptr), sending_(false), io_serv_(io_serv), chain_(chain), socket_(io_serv) {}
+        : io_serv_(io_serv), chain_(chain) {}
 
 public:
-    int connect(const std::string& conn);
+    int connect(const std::string& conn, size_t pool_size = 1);
     int close();
     int prepare_stmts();
     int begin_poll_read();
@@ -90,18 +117,15 @@ public:
     int get_transaction_actions_resume(int id, pg_result const*);
 
 private:
-    int queue(int id, int task, std::string&& stmt);
-    int poll_read();
-    int send_once();
+    int queue(int id, int task, const char* plan, std::vector<std::string>&& params);
+    int poll_read(connection& c);
+    int send_once(connection& c);
 
 private:
-    pg_conn* conn_;
+    std::vector<std::unique_ptr<connection>> conns_;
 
-    bool                         sending_;
-    std::queue<task>             tasks_;
-    boost::asio::io_context&     io_serv_;
-    chain::controller&           chain_;
-    boost::asio::ip::tcp::socket socket_;
+    boost::asio::io_context& io_serv_;
+    chain::controller&       chain_;
 };
 
 }  // namespace evt
\ No newline at end of file
@@ -123,6 +123,8 @@ public:
 
 private:
     std::unique_ptr<class history_plugin_impl> my_;
+    uint32_t                                   connections_;
+    std::optional<fc::path>                    db_dir_;  // only set for the embedded backend
     friend class history_apis::read_only;
 };
 
@@ -4,19 +4,30 @@
  */
 #include <evt/http_plugin/http_plugin.hpp>
 
+#include <algorithm>
+#include <array>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <thread>
 #include <type_traits>
 #include <regex>
+#include <unordered_map>
 
+#include <zstd.h>
+
+#include <fc/compress/zlib.hpp>
 #include <fc/crypto/openssl.hpp>
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/reflect/variant.hpp>
+#include <fc/variant_arena.hpp>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <websocketpp/client.hpp>
 #include <websocketpp/config/asio.hpp>
@@ -24,8 +35,10 @@
 #include <websocketpp/logger/stub.hpp>
 #include <websocketpp/server.hpp>
 
+#include <evt/chain/app_lanes.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/http_plugin/local_endpoint.hpp>
+#include <evt/utilities/thread_placement.hpp>
 
 namespace evt {
 
@@ -49,6 +62,8 @@ using std::set;
 using std::string;
 using std::vector;
 using websocketpp::connection_hdl;
+using evt::chain::plugin_interface::app_lane;
+using evt::chain::plugin_interface::post_lane;
 
 namespace detail {
 
@@ -89,6 +104,90 @@ struct asio_with_stub_log : public websocketpp::config::asio {
     static const long timeout_open_handshake = 0;
 };
 
+// lru cache of responses bounded by their total size, entries are only evicted when it's full
+class response_cache {
+public:
+    void
+    set_capacity(size_t capacity) {
+        capacity_ = capacity;
+    }
+
+    bool
+    enabled() const {
+        return capacity_ > 0;
+    }
+
+    std::shared_ptr<const string>
+    get(const string& url, const string& body) {
+        {
+            auto lock = std::lock_guard<std::mutex>(mutex_);
+            if(urls_.find(url) == urls_.cend()) {
+                return nullptr;
+            }
+        }
+        auto key = make_key(url, body);
+        if(!key.has_value()) {
+            return nullptr;
+        }
+
+        auto lock = std::lock_guard<std::mutex>(mutex_);
+        auto it   = index_.find(*key);
+        if(it == index_.cend()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    void
+    put(const string& url, const string& body, const string& response) {
+        auto key = make_key(url, body);
+        if(!key.has_value() || key->size() + response.size() > capacity_) {
+            return;
+        }
+        auto value = std::make_shared<const string>(response);
+
+        auto lock = std::lock_guard<std::mutex>(mutex_);
+        urls_.emplace(url);
+        if(index_.find(*key) != index_.cend()) {
+            return;
+        }
+        size_ += key->size() + value->size();
+        entries_.emplace_front(*key, std::move(value));
+        index_.emplace(std::move(*key), entries_.begin());
+
+        while(size_ > capacity_) {
+            auto& e = entries_.back();
+            size_ -= e.first.size() + e.second->size();
+            index_.erase(e.first);
+            entries_.pop_back();
+        }
+    }
+
+private:
+    // body is normalized so that the requests only differ in formatting share one entry
+    static optional<string>
+    make_key(const string& url, const string& body) {
+        try {
+            return url + '\n' + fc::json::to_string(fc::json::from_string(body.empty() ? "{}" : body));
+        }
+        catch(...) {
+            return std::nullopt;
+        }
+    }
+
+private:
+    using entry = std::pair<string, std::shared_ptr<const string>>;
+
+    size_t capacity_ = 0;
+    size_t size_     = 0;
+
+    std::mutex                                             mutex_;
+    std::list<entry>                                       entries_;
+    std::unordered_map<string, std::list<entry>::iterator> index_;
+    set<string>                                            urls_;
+};
+
 }  // namespace detail
 
 using http_config  = detail::asio_with_stub_log<websocketpp::transport::asio::endpoint, websocketpp::transport::asio::basic_socket::endpoint>;
@@ -106,6 +205,10 @@ using io_work_t                   = boost::asio::executor_work_guard<boost::asio
 static bool verbose_http_errors = false;
 
 class http_plugin_impl {
+public:
+    enum class content_encoding { identity, gzip, deflate, zstd };
+    enum class content_type { json, binary, text };
+
 public:
     http_plugin_impl() {}
 
@@ -113,6 +216,10 @@ public:
     map<string, url_handler>          url_handlers;
     map<string, url_handler>          url_local_handlers;
     map<string, url_deferred_handler> url_deferred_handlers;
+    map<string, url_handler>          url_concurrent_handlers;
+    map<string, std::pair<url_handler, bool /* concurrent */>> url_binary_handlers;
+    map<string, std::pair<url_handler, bool /* concurrent */>> url_text_handlers;
+    map<string, websocket_handler>    url_websocket_handlers;
     optional<tcp::endpoint>           listen_endpoint;
     string                            access_control_allow_origin;
     string                            access_control_allow_headers;
@@ -134,7 +241,12 @@ public:
     optional<std::thread>                    server_thread;
     std::shared_ptr<boost::asio::io_context> server_ioc;
     optional<io_work_t>                      server_ioc_work;
+    uint16_t                                 thread_pool_size = 2;
+    optional<boost::asio::thread_pool>       thread_pool;
     std::atomic<int64_t>                     bytes_in_flight{0};
+    std::atomic<uint64_t>                    requests_num{0};
+    std::atomic<uint64_t>                    busy_num{0};
+    std::array<std::atomic<uint64_t>, 6>     responses_num = {};  // by the first digit of status code
     int64_t                                  max_bytes_in_flight = 0;
 
     optional<tcp::endpoint> https_listen_endpoint;
@@ -149,6 +261,138 @@ public:
     bool        validate_host;
     set<string> valid_hosts;
     bool        http_no_response;
+    bool        variant_arena;
+    uint32_t    compress_min_size = 0;  // 0 if compression is disabled
+
+    detail::response_cache cache;
+
+    // open websocket connections, sender is bound to the server which accepts the connection
+    struct websocket_conn {
+        const websocket_handler*                 handler;
+        std::function<void(const string&, bool)> send;  // message and whether it's binary
+    };
+    map<websocket_id, websocket_conn>                                  websocket_conns;
+    map<connection_hdl, websocket_id, std::owner_less<connection_hdl>> websocket_ids;
+    websocket_id                                                       next_websocket_id = 0;
+
+    // picks the most preferred one from the encodings accepted in `Accept-Encoding` header
+    static content_encoding
+    accepted_encoding(const string& header) {
+        auto encoding = content_encoding::identity;
+        auto codings  = vector<string>();
+        boost::split(codings, header, boost::is_any_of(","));
+        for(auto& c : codings) {
+            auto params = vector<string>();
+            boost::split(params, c, boost::is_any_of(";"));
+            auto coding = boost::to_lower_copy(boost::trim_copy(params[0]));
+
+            // q=0 means not acceptable
+            auto acceptable = true;
+            for(auto i = 1u; i < params.size(); i++) {
+                auto p = boost::trim_copy(params[i]);
+                if(p.size() > 2 && (p[0] == 'q' || p[0] == 'Q') && p[1] == '=') {
+                    acceptable = std::strtod(p.c_str() + 2, nullptr) > 0;
+                }
+            }
+            if(!acceptable) {
+                continue;
+            }
+
+            if(coding == "zstd") {
+                encoding = content_encoding::zstd;
+            }
+            else if(coding == "gzip" && encoding != content_encoding::zstd) {
+                encoding = content_encoding::gzip;
+            }
+            else if(coding == "deflate" && encoding == content_encoding::identity) {
+                encoding = content_encoding::deflate;
+            }
+        }
+        return encoding;
+    }
+
+    static const char*
+    encoding_name(content_encoding encoding) {
+        switch(encoding) {
+        case content_encoding::gzip:    return "gzip";
+        case content_encoding::deflate: return "deflate";
+        case content_encoding::zstd:    return "zstd";
+        default:                        return "identity";
+        }
+    }
+
+    static string
+    compress(const string& body, content_encoding encoding) {
+        switch(encoding) {
+        case content_encoding::gzip: {
+            return fc::gzip_compress(body);
+        }
+        case content_encoding::deflate: {
+            // `deflate` of http is in zlib format
+            return fc::zlib_compress(body);
+        }
+        case content_encoding::zstd: {
+            auto r = string(ZSTD_compressBound(body.size()), '\0');
+            auto n = ZSTD_compress(r.data(), r.size(), body.data(), body.size(), 1);
+            EVT_ASSERT(!ZSTD_isError(n), chain::http_exception, "Failed to compress response: ${e}", ("e", ZSTD_getErrorName(n)));
+            r.resize(n);
+            return r;
+        }
+        default: {
+            return body;
+        }
+        }  // switch
+    }
+
+    // body is compressed in worker threads if it's large enough, then it's sent in server thread
+    // errors of binary and text handlers are still sent in json
+    template <class T>
+    void
+    send_response(typename websocketpp::server<T>::connection_ptr con, int code, string body, content_encoding encoding,
+                  content_type type = content_type::json) {
+        auto body_size = body.size();
+        bytes_in_flight += body_size;
+
+        auto send = [this, ioc = server_ioc, con, code, body_size, type](string body, content_encoding encoding) {
+            boost::asio::post(*ioc, [this, con, code, body_size, type, body{std::move(body)}, encoding]() mutable {
+                if(code >= 200 && code < 300) {
+                    if(type == content_type::binary) {
+                        con->replace_header("Content-Type", "application/octet-stream");
+                    }
+                    else if(type == content_type::text) {
+                        con->replace_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+                    }
+                }
+                if(!this->http_no_response) {
+                    if(encoding != content_encoding::identity) {
+                        con->append_header("Content-Encoding", encoding_name(encoding));
+                    }
+                    con->set_body(std::move(body));
+                }
+                con->set_status(websocketpp::http::status_code::value(code));
+                con->send_http_response();
+                this->bytes_in_flight -= body_size;
+                this->responses_num[std::clamp(code / 100, 0, 5)].fetch_add(1, std::memory_order_relaxed);
+            });
+        };
+
+        if(encoding == content_encoding::identity || body.size() < compress_min_size || http_no_response) {
+            send(std::move(body), content_encoding::identity);
+            return;
+        }
+        boost::asio::post(*thread_pool, [send, body{std::move(body)}, encoding]() mutable {
+            auto compressed = string();
+            try {
+                compressed = compress(body, encoding);
+            }
+            catch(...) {
+                // sent as it is
+                send(std::move(body), content_encoding::identity);
+                return;
+            }
+            send(std::move(compressed), encoding);
+        });
+    }
 
     bool
     host_port_is_valid(const std::string& header_host_port, const string& endpoint_local_host_port) {
@@ -332,8 +576,15 @@ public:
             }
 
             con->append_header("Content-Type", "application/json");
+            auto encoding = content_encoding::identity;
+            if(compress_min_size > 0) {
+                con->append_header("Vary", "Accept-Encoding");
+                encoding = accepted_encoding(req.get_header("Accept-Encoding"));
+            }
 
+            requests_num.fetch_add(1, std::memory_order_relaxed);
             if(bytes_in_flight > max_bytes_in_flight) {
+                busy_num.fetch_add(1, std::memory_order_relaxed);
                 dlog2("503 - too many bytes in flight: {:n}", bytes_in_flight.load());
                 error_results results{websocketpp::http::status_code::too_many_requests, "Busy", error_results::error_info()};
                 con->set_body(fc::json::to_string(results));
@@ -345,33 +596,60 @@ public:
             auto resource = con->get_uri()->get_resource();
 
             {
-                auto handler_itr = url_handlers.find(resource);
-                if(handler_itr != url_handlers.cend()) {
+                // handlers which can be served concurrently are invoked in worker threads directly
+                // others are invoked in main application thread
+                auto handler    = (const url_handler*)nullptr;
+                auto concurrent = false;
+                auto type       = content_type::json;
+                if(auto it = url_binary_handlers.find(resource); it != url_binary_handlers.cend()
+                    && req.get_header("Accept").find("application/octet-stream") != string::npos) {
+                    handler    = &it->second.first;
+                    concurrent = it->second.second;
+                    type       = content_type::binary;
+                }
+                else if(auto it = url_text_handlers.find(resource); it != url_text_handlers.cend()) {
+                    handler    = &it->second.first;
+                    concurrent = it->second.second;
+                    type       = content_type::text;
+                }
+                else if(auto it = url_handlers.find(resource); it != url_handlers.cend()) {
+                    handler = &it->second;
+                }
+                else if(auto it = url_concurrent_handlers.find(resource); it != url_concurrent_handlers.cend()) {
+                    handler    = &it->second;
+                    concurrent = true;
+                }
+                if(handler != nullptr && type == content_type::json && cache.enabled()) {
+                    if(auto response = cache.get(resource, body)) {
+                        con->defer_http_response();
+                        send_response<T>(con, websocketpp::http::status_code::ok, *response, encoding);
+                        return;
+                    }
+                }
+                if(handler != nullptr) {
                     con->defer_http_response();
                     bytes_in_flight += body.size();
-                    app().post(appbase::priority::low,
-                        [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con] {
-                            this->bytes_in_flight -= body.size();
-                            try {
-                                handler_itr->second(resource, body,
-                                    [this, ioc{std::move(ioc)}, con](auto code, auto response_body) {
-                                        this->bytes_in_flight += response_body.size();
-                                        boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code]() {
-                                            size_t body_size = response_body.size();
-                                            if(!this->http_no_response) {
-                                                con->set_body(std::move(response_body));
-                                            }
-                                            con->set_status(websocketpp::http::status_code::value(code));
-                                            con->send_http_response();
-                                            this->bytes_in_flight -= body_size;
-                                        });
-                                    });
-                            }
-                            catch(...) {
-                                handle_exception<T>(con);
-                                con->send_http_response();
-                            }
-                        });
+                    auto task = [this, handler, resource{std::move(resource)}, body{std::move(body)}, con, encoding, type] {
+                        this->bytes_in_flight -= body.size();
+                        try {
+                            // variants built for this request are released together once they are all gone
+                            auto arena = fc::variant_arena::scope(this->variant_arena);
+                            (*handler)(resource, body,
+                                [this, con, encoding, type](auto code, auto response_body) {
+                                    this->send_response<T>(con, code, std::move(response_body), encoding, type);
+                                });
+                        }
+                        catch(...) {
+                            handle_exception<T>(con);
+                            con->send_http_response();
+                        }
+                    };
+                    if(concurrent) {
+                        boost::asio::post(*thread_pool, std::move(task));
+                    }
+                    else {
+                        post_lane(app_lane::http, std::move(task));
+                    }
                     return;
                 }
             }
@@ -389,7 +667,7 @@ public:
                     });
 
                     bytes_in_flight += body.size();
-                    app().post(appbase::priority::low,
+                    post_lane(app_lane::http,
                         [this, deferred_handler_it, resource{std::move(resource)}, body{std::move(body)}, con, id]() {
                             this->bytes_in_flight -= body.size();
                             try {
@@ -408,18 +686,13 @@ public:
                 auto handler_itr = url_local_handlers.find(resource);
                 if(handler_itr != url_local_handlers.end()) {
                     con->defer_http_response();
-                    app().post(appbase::priority::low,
-                        [this, ioc = this->server_ioc, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con] {
+                    post_lane(app_lane::http,
+                        [this, handler_itr, resource{std::move(resource)}, body{std::move(body)}, con, encoding] {
                             try {
+                                auto arena = fc::variant_arena::scope(this->variant_arena);
                                 handler_itr->second(resource, body,
-                                    [this, ioc{std::move(ioc)}, con](auto code, auto response_body) {
-                                        boost::asio::post(*ioc, [this, response_body{std::move(response_body)}, con, code]() {
-                                            if(!this->http_no_response) {
-                                                con->set_body(std::move(response_body));
-                                            }
-                                            con->set_status(websocketpp::http::status_code::value(code));
-                                            con->send_http_response();
-                                        });
+                                    [this, con, encoding](auto code, auto response_body) {
+                                        this->send_response<T>(con, code, std::move(response_body), encoding);
                                     });
                             }
                             catch(...) {
@@ -491,6 +764,71 @@ public:
         FC_LOG_AND_DROP((id));
     }
 
+    template <class T>
+    void
+    set_websocket_handlers(websocketpp::server<T>& ws) {
+        ws.set_validate_handler([&](connection_hdl hdl) {
+            auto con = ws.get_con_from_hdl(hdl);
+            if(!allow_host<T>(con->get_request(), con)) {
+                return false;
+            }
+            return url_websocket_handlers.find(con->get_resource()) != url_websocket_handlers.end();
+        });
+        ws.set_open_handler([&](connection_hdl hdl) {
+            auto con = ws.get_con_from_hdl(hdl);
+            auto it  = url_websocket_handlers.find(con->get_resource());
+            if(it == url_websocket_handlers.end()) {
+                return;
+            }
+
+            auto id = ++next_websocket_id;
+            websocket_ids[hdl]  = id;
+            websocket_conns[id] = websocket_conn { &it->second, [&ws, hdl](const string& message, bool binary) {
+                auto ec = websocketpp::lib::error_code();
+                ws.send(hdl, message, binary ? websocketpp::frame::opcode::binary : websocketpp::frame::opcode::text, ec);
+                if(ec) {
+                    dlog("Failed to send websocket message: ${e}", ("e", ec.message()));
+                }
+            }};
+            if(it->second.on_open) {
+                it->second.on_open(id);
+            }
+        });
+        ws.set_message_handler([&](connection_hdl hdl, typename websocketpp::server<T>::message_ptr msg) {
+            auto it = websocket_ids.find(hdl);
+            if(it == websocket_ids.end()) {
+                return;
+            }
+            auto& handler = *websocket_conns[it->second].handler;
+            if(handler.on_message) {
+                handler.on_message(it->second, msg->get_payload());
+            }
+        });
+        ws.set_close_handler([&](connection_hdl hdl) {
+            close_websocket(hdl);
+        });
+        ws.set_fail_handler([&](connection_hdl hdl) {
+            close_websocket(hdl);
+        });
+    }
+
+    void
+    close_websocket(connection_hdl hdl) {
+        auto it = websocket_ids.find(hdl);
+        if(it == websocket_ids.end()) {
+            return;
+        }
+        auto id = it->second;
+        websocket_ids.erase(it);
+
+        auto cit     = websocket_conns.find(id);
+        auto handler = cit->second.handler;
+        websocket_conns.erase(cit);
+        if(handler->on_close) {
+            handler->on_close(id);
+        }
+    }
+
     template <class T>
     void
     create_server_for_endpoint(const tcp::endpoint& ep, websocketpp::server<T>& ws) {
@@ -502,6 +840,7 @@ public:
             ws.set_http_handler([&](connection_hdl hdl) {
                 handle_http_request<T>(ws.get_con_from_hdl(hdl));
             });
+            set_websocket_handlers<T>(ws);
         }
         catch(const fc::exception& e) {
             elog("http: ${e}", ("e", e.to_detail_string()));
@@ -563,6 +902,13 @@ http_plugin::set_program_options(options_description&, options_description& cfg)
         ("http-alias", bpo::value<std::vector<string>>()->composing(),
             "Additionaly acceptable values for the \"Host\" header of incoming HTTP requests, can be specified multiple times.  Includes http/s_server_address by default.")
         ("http-no-response", bpo::bool_switch()->default_value(false), "special for load-testing, response all the requests with empty body")
+        ("http-variant-arena", bpo::value<bool>()->default_value(true), "Allocate the variants built while handling one request from one arena which is released at once")
+        ("http-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
+            "Number of worker threads for the APIs which can be served concurrently outside of main application thread")
+        ("http-compress-min-size", bpo::value<uint32_t>()->default_value(1024),
+            "Minimum size in bytes of response bodies to be compressed in the encoding accepted by client (zstd, gzip or deflate), 0 to disable compression")
+        ("http-cache-size-mb", bpo::value<uint32_t>()->default_value(0),
+            "Maximum size in megabytes of the cache of responses to queries of immutable data (e.g. irreversible blocks), 0 to disable the cache")
         ;
 }
 
@@ -649,9 +995,15 @@ http_plugin::plugin_initialize(const variables_map& options) {
         my->max_bytes_in_flight          = options.at("http-max-bytes-in-flight-mb").as<uint32_t>() * 1024 * 1024;
         my->max_deferred_connection_size = options.at("max-deferred-connection-size").as<uint32_t>();
         my->http_no_response             = options.at("http-no-response").as<bool>();
+        my->variant_arena                = options.at("http-variant-arena").as<bool>();
+        my->thread_pool_size             = options.at("http-threads").as<uint16_t>();
+        my->compress_min_size            = options.at("http-compress-min-size").as<uint32_t>();
+        my->cache.set_capacity((size_t)options.at("http-cache-size-mb").as<uint32_t>() * 1024 * 1024);
         verbose_http_errors              = options.at("verbose-http-errors").as<bool>();
 
         FC_ASSERT(my->max_deferred_connection_size < std::numeric_limits<int32_t>::max());
+        EVT_ASSERT(my->thread_pool_size > 0, chain::plugin_config_exception,
+            "http-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
 
         //watch out for the returns above when adding new code here
     }
@@ -663,8 +1015,10 @@ http_plugin::plugin_startup() {
     my->server_ioc = std::make_shared<boost::asio::io_context>();
     my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
     my->server_thread.emplace([ioc = my->server_ioc] {
+        evt::utilities::place_current_thread("http");
         ioc->run();
     });
+    my->thread_pool.emplace(my->thread_pool_size);
 
     if(my->listen_endpoint.has_value()) {
         try {
@@ -778,6 +1132,11 @@ http_plugin::plugin_shutdown() {
     if(my->server_ioc) {
         my->server_ioc->stop();
     }
+    if(my->thread_pool.has_value()) {
+        my->thread_pool->stop();
+        my->thread_pool->join();
+        my->thread_pool.reset();
+    }
     if(my->server_thread.has_value()) {
         my->server_thread->join();
         my->server_thread.reset();
@@ -803,6 +1162,36 @@ http_plugin::add_handler(const string& url, const url_handler& handler, bool loc
     }
 }
 
+void
+http_plugin::add_concurrent_handler(const string& url, const url_handler& handler) {
+    ilog("add concurrent api url: ${c}", ("c", url));
+    my->url_concurrent_handlers.insert(std::make_pair(url, handler));
+}
+
+void
+http_plugin::add_binary_handler(const string& url, const url_handler& handler, bool concurrent) {
+    ilog("add binary api url: ${c}", ("c", url));
+    my->url_binary_handlers.insert(std::make_pair(url, std::make_pair(handler, concurrent)));
+}
+
+http_plugin::metrics_info
+http_plugin::get_metrics() const {
+    auto m = metrics_info();
+    m.requests        = my->requests_num.load(std::memory_order_relaxed);
+    m.busy            = my->busy_num.load(std::memory_order_relaxed);
+    m.bytes_in_flight = my->bytes_in_flight.load(std::memory_order_relaxed);
+    for(auto i = 0u; i < m.responses.size(); i++) {
+        m.responses[i] = my->responses_num[i].load(std::memory_order_relaxed);
+    }
+    return m;
+}
+
+void
+http_plugin::add_text_handler(const string& url, const url_handler& handler, bool concurrent) {
+    ilog("add text api url: ${c}", ("c", url));
+    my->url_text_handlers.insert(std::make_pair(url, std::make_pair(handler, concurrent)));
+}
+
 void
 http_plugin::add_deferred_handler(const string& url, const url_deferred_handler& handler) {
     ilog("add deferred api url: ${c}", ("c", url));
@@ -818,6 +1207,22 @@ http_plugin::set_deferred_response(deferred_id id, int code, const string& body)
     });
 }
 
+void
+http_plugin::add_websocket_handler(const string& url, const websocket_handler& handler) {
+    ilog("add websocket url: ${c}", ("c", url));
+    my->url_websocket_handlers.insert(std::make_pair(url, handler));
+}
+
+void
+http_plugin::send_websocket_message(websocket_id id, const string& message, bool binary) {
+    boost::asio::post(app().get_io_service(), [=]() {
+        auto it = my->websocket_conns.find(id);
+        if(it != my->websocket_conns.end()) {
+            it->second.send(message, binary);
+        }
+    });
+}
+
 void
 http_plugin::handle_exception(const char* api_name, const char* call_name, const string& body, url_response_callback cb) {
     try {
@@ -894,6 +1299,13 @@ http_plugin::is_secure() const {
     return (!my->listen_endpoint.has_value() || my->listen_endpoint->address().is_loopback());
 }
 
+void
+http_plugin::cache_response(const string& url, const string& body, const string& response) {
+    if(my->cache.enabled()) {
+        my->cache.put(url, body, response);
+    }
+}
+
 bool
 http_plugin::verbose_errors() const {
     return verbose_http_errors;
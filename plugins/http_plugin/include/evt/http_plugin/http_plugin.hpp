@@ -3,6 +3,7 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <array>
 #include <appbase/application.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/reflect/reflect.hpp>
@@ -62,6 +63,20 @@ using api_description = std::map<string, url_handler>;
  */
 using async_api_description = std::map<string, url_deferred_handler>;
 
+using websocket_id = uint64_t;
+
+/**
+ * @brief Callbacks of websocket connections accepted on one URL
+ *
+ * They're called from the appbase application io_service thread. Each accepted
+ * connection is given one id, which is used to send messages to it until it's closed.
+ **/
+struct websocket_handler {
+    std::function<void(websocket_id)>         on_open;
+    std::function<void(websocket_id, string)> on_message;
+    std::function<void(websocket_id)>         on_close;
+};
+
 struct http_plugin_defaults {
     //If empty, unix socket support will be completely disabled. If not empty,
     // unix socket support is enabled with the given default path (treated relative
@@ -79,7 +94,8 @@ struct http_plugin_defaults {
  *  called with the response code and body.
  *
  *  The handler will be called from the appbase application io_service
- *  thread.  The callback can be called from any thread and will 
+ *  thread, or from the http worker threads if it's registered as concurrent.
+ *  The callback can be called from any thread and will
  *  automatically propagate the call to the http thread.
  *
  *  The HTTP service will run in its own thread with its own io_service to
@@ -103,6 +119,14 @@ public:
 
     void add_handler(const string& url, const url_handler&, bool local_only = false);
     void add_deferred_handler(const string& url, const url_deferred_handler&);
+    // handler is invoked in http worker threads instead of main application thread
+    // it must be safe to be called concurrently
+    void add_concurrent_handler(const string& url, const url_handler&);
+    // handler is used instead of the one of the same url when client sends `Accept: application/octet-stream`,
+    // successful responses are the packed binary and sent as `application/octet-stream`
+    void add_binary_handler(const string& url, const url_handler&, bool concurrent = false);
+    // successful responses are sent as `text/plain` in the exposition format of prometheus
+    void add_text_handler(const string& url, const url_handler&, bool concurrent = false);
 
     void
     add_api(const api_description& api, bool local_only = false) {
@@ -111,6 +135,20 @@ public:
         }
     }
 
+    void
+    add_concurrent_api(const api_description& api) {
+        for(const auto& call : api) {
+            add_concurrent_handler(call.first, call.second);
+        }
+    }
+
+    void
+    add_binary_api(const api_description& api, bool concurrent = false) {
+        for(const auto& call : api) {
+            add_binary_handler(call.first, call.second, concurrent);
+        }
+    }
+
     void
     add_async_api(const async_api_description& api) {
         for(const auto& call : api) {
@@ -120,6 +158,16 @@ public:
 
     void set_deferred_response(deferred_id id, int code, const string& body);
 
+    // upgrades of http(s) connections to websocket are only accepted on the URLs added here
+    void add_websocket_handler(const string& url, const websocket_handler&);
+    // safe to call from any thread, message is dropped if the connection is closed
+    void send_websocket_message(websocket_id id, const string& message, bool binary = false);
+
+    // caches the json response of `url` to request `body`, later requests of the same url and equivalent body
+    // are answered from cache without invoking the handler. Only responses which never change, like the ones
+    // of irreversible blocks, should be cached. It's no-op if cache is disabled and is safe to call from any thread.
+    void cache_response(const string& url, const string& body, const string& response);
+
     // standard exception handling for api handlers
     static void handle_exception(const char *api_name, const char *call_name, const string& body, url_response_callback cb);
     static void handle_async_exception(deferred_id id, const char *api_name, const char *call_name, const string& body);
@@ -129,6 +177,15 @@ public:
 
     bool verbose_errors() const;
 
+    // counters since startup, safe to read from any thread
+    struct metrics_info {
+        uint64_t                requests        = 0;
+        uint64_t                busy            = 0;  // rejected because of too many bytes in flight
+        int64_t                 bytes_in_flight = 0;
+        std::array<uint64_t, 6> responses       = {};  // by the first digit of status code
+    };
+    metrics_info get_metrics() const;
+
     struct get_supported_apis_result {
         vector<string> apis;
     };
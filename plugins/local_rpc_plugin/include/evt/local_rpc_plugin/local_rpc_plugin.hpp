@@ -0,0 +1,38 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <appbase/application.hpp>
+#include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/evt_plugin/evt_plugin.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
+
+namespace evt {
+using namespace appbase;
+
+/**
+ *  Length-prefixed binary RPC on a local unix socket for the services running along with the node,
+ *  requests and responses are fc::raw packed and multiplexed by request ids, see `local_rpc/protocol.hpp`.
+ *  It saves the HTTP parsing and json conversions of the local http endpoint for the high rate callers.
+ *  Optionally it's also served on a websocket of http_plugin, so remote clients can multiplex many requests
+ *  and subscriptions over one persistent connection.
+ */
+class local_rpc_plugin : public plugin<local_rpc_plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(evt_plugin)(http_plugin))
+
+    local_rpc_plugin();
+    virtual ~local_rpc_plugin();
+
+    virtual void set_program_options(options_description&, options_description&) override;
+
+    void plugin_initialize(const variables_map&);
+    void plugin_startup();
+    void plugin_shutdown();
+
+private:
+    std::shared_ptr<class local_rpc_plugin_impl> my_;
+};
+
+}  // namespace evt
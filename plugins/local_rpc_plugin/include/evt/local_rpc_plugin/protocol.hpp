@@ -0,0 +1,135 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <evt/chain/asset.hpp>
+#include <evt/chain/block.hpp>
+#include <evt/chain/transaction.hpp>
+#include <evt/chain/types.hpp>
+
+namespace evt { namespace local_rpc {
+
+using namespace evt::chain;
+
+/**
+ *  Binary RPC served on the local unix socket of `local_rpc_plugin`.
+ *
+ *  Each frame is a 4-byte little-endian size followed by the fc::raw packed `request` or `response`.
+ *  Requests are answered in the order they finish rather than the order they're sent, clients match
+ *  responses by `id`. Notices of subscribed blocks and transactions use the id of the subscribe request.
+ *
+ *  The same protocol is served on the websocket `/v1/local_rpc/stream` of http_plugin for the remote clients,
+ *  where each binary message carries one packed `request` or `response` without the size.
+ */
+
+struct push_transaction_request {
+    packed_transaction trx;
+};
+
+struct get_token_request {
+    domain_name domain;
+    token_name  name;
+};
+
+struct get_fungible_balance_request {
+    address        addr;
+    symbol_id_type sym_id;
+};
+
+struct subscribe_blocks_request {
+    bool irreversible = false;  // irreversible blocks only, otherwise every accepted block
+};
+
+struct unsubscribe_blocks_request {};
+
+struct subscribe_transactions_request {
+    bool irreversible = false;  // transactions of irreversible blocks only, otherwise of every accepted block
+};
+
+struct unsubscribe_transactions_request {};
+
+using request_body = static_variant<push_transaction_request,
+                                    get_token_request,
+                                    get_fungible_balance_request,
+                                    subscribe_blocks_request,
+                                    unsubscribe_blocks_request,
+                                    subscribe_transactions_request,
+                                    unsubscribe_transactions_request>;
+
+struct request {
+    uint32_t     id;
+    request_body body;
+};
+
+struct error_result {
+    int64_t     code;  // code of fc exception
+    std::string message;
+};
+
+struct push_transaction_result {
+    transaction_id_type trx_id;
+    uint32_t            elapsed;  // in microseconds
+    uint32_t            charge;
+};
+
+struct get_token_result {
+    bytes token;  // packed `token_def` as it's stored in token database
+};
+
+struct get_fungible_balance_result {
+    asset balance;
+};
+
+struct subscribe_blocks_result {};
+
+struct block_notice {
+    uint32_t      block_num;
+    block_id_type block_id;
+    bytes         block;  // packed `signed_block`
+};
+
+struct subscribe_transactions_result {};
+
+// ids of all the transactions in one block
+struct transaction_notice {
+    uint32_t                         block_num;
+    block_id_type                    block_id;
+    std::vector<transaction_id_type> trx_ids;
+};
+
+using response_body = static_variant<error_result,
+                                     push_transaction_result,
+                                     get_token_result,
+                                     get_fungible_balance_result,
+                                     subscribe_blocks_result,
+                                     block_notice,
+                                     subscribe_transactions_result,
+                                     transaction_notice>;
+
+struct response {
+    uint32_t      id;
+    response_body body;
+};
+
+constexpr uint32_t kDefaultMaxFrameSize = 1024 * 1024;
+
+}}  // namespace evt::local_rpc
+
+FC_REFLECT(evt::local_rpc::push_transaction_request, (trx));
+FC_REFLECT(evt::local_rpc::get_token_request, (domain)(name));
+FC_REFLECT(evt::local_rpc::get_fungible_balance_request, (addr)(sym_id));
+FC_REFLECT(evt::local_rpc::subscribe_blocks_request, (irreversible));
+FC_REFLECT_EMPTY(evt::local_rpc::unsubscribe_blocks_request);
+FC_REFLECT(evt::local_rpc::subscribe_transactions_request, (irreversible));
+FC_REFLECT_EMPTY(evt::local_rpc::unsubscribe_transactions_request);
+FC_REFLECT(evt::local_rpc::request, (id)(body));
+FC_REFLECT(evt::local_rpc::error_result, (code)(message));
+FC_REFLECT(evt::local_rpc::push_transaction_result, (trx_id)(elapsed)(charge));
+FC_REFLECT(evt::local_rpc::get_token_result, (token));
+FC_REFLECT(evt::local_rpc::get_fungible_balance_result, (balance));
+FC_REFLECT_EMPTY(evt::local_rpc::subscribe_blocks_result);
+FC_REFLECT(evt::local_rpc::block_notice, (block_num)(block_id)(block));
+FC_REFLECT_EMPTY(evt::local_rpc::subscribe_transactions_result);
+FC_REFLECT(evt::local_rpc::transaction_notice, (block_num)(block_id)(trx_ids));
+FC_REFLECT(evt::local_rpc::response, (id)(body));
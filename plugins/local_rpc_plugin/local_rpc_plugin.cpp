@@ -0,0 +1,633 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/local_rpc_plugin/local_rpc_plugin.hpp>
+#include <evt/local_rpc_plugin/protocol.hpp>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
+
+#include <boost/asio.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <evt/chain/app_lanes.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
+#include <evt/utilities/thread_placement.hpp>
+
+namespace evt {
+
+static appbase::abstract_plugin& _local_rpc_plugin = app().register_plugin<local_rpc_plugin>();
+
+namespace bfs = boost::filesystem;
+namespace asio = boost::asio;
+
+using asio::local::stream_protocol;
+using evt::chain::plugin_interface::app_lane;
+using evt::chain::plugin_interface::post_lane;
+using namespace evt::local_rpc;
+
+using frame_ptr = std::shared_ptr<const std::vector<char>>;
+
+namespace internal {
+
+frame_ptr
+make_frame(const response& resp) {
+    auto size  = (uint32_t)fc::raw::pack_size(resp);
+    auto frame = std::make_shared<std::vector<char>>(sizeof(size) + size);
+
+    auto le = boost::endian::native_to_little(size);
+    memcpy(frame->data(), &le, sizeof(le));
+
+    auto ds = fc::datastream<char*>(frame->data() + sizeof(size), size);
+    fc::raw::pack(ds, resp);
+    return frame;
+}
+
+frame_ptr
+make_error(uint32_t id, const fc::exception& e) {
+    return make_frame(response { id, error_result { e.code(), e.to_string() } });
+}
+
+frame_ptr
+make_error(uint32_t id, const std::exception& e) {
+    return make_frame(response { id, error_result { fc::std_exception_code, e.what() } });
+}
+
+}  // namespace internal
+
+class rpc_session;
+class websocket_session;
+using session_ptr = std::shared_ptr<rpc_session>;
+
+class local_rpc_plugin_impl : public std::enable_shared_from_this<local_rpc_plugin_impl> {
+public:
+    local_rpc_plugin_impl()
+        : websocket_(false)
+        , acceptor_(ioc_)
+        , subscribers_(0)
+        , trx_subscribers_(0) {}
+
+public:
+    void start();
+    void stop();
+
+    void handle_request(const session_ptr& s, request&& req);
+    void close_session(const session_ptr& s);
+
+private:
+    void accept();
+    void add_websocket_handler();
+    void notify_block(const chain::block_state_ptr& bsp, bool irreversible);
+
+public:
+    bfs::path socket_path_;  // empty if unix socket is disabled
+    bool      websocket_;
+    uint32_t  max_frame_size_;
+    size_t    max_queued_bytes_;
+
+    asio::io_context                                                      ioc_;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> work_;
+    std::optional<std::thread>                                            thread_;
+    stream_protocol::acceptor                                             acceptor_;
+
+    // sessions are only touched on the thread of io context
+    std::set<session_ptr>                                      sessions_;
+    std::map<websocket_id, std::shared_ptr<websocket_session>> websockets_;
+    std::atomic<int>                                           subscribers_;      // blocks are not packed at all without subscribers
+    std::atomic<int>                                           trx_subscribers_;  // same for transaction ids
+
+    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
+};
+
+// one connection of clients, either on unix socket or websocket
+class rpc_session : public std::enable_shared_from_this<rpc_session> {
+public:
+    rpc_session(local_rpc_plugin_impl& impl)
+        : impl_(impl)
+        , open_(true) {}
+    virtual ~rpc_session() = default;
+
+public:
+    // frame is the one prefixed with its size
+    virtual void send(const frame_ptr& frame) = 0;
+    virtual void close() = 0;
+
+protected:
+    // returns false if it's closed already
+    bool
+    release() {
+        if(!open_) {
+            return false;
+        }
+        open_ = false;
+        if(subscription_.has_value()) {
+            impl_.subscribers_--;
+            subscription_.reset();
+        }
+        if(trx_subscription_.has_value()) {
+            impl_.trx_subscribers_--;
+            trx_subscription_.reset();
+        }
+        return true;
+    }
+
+public:
+    local_rpc_plugin_impl& impl_;
+    bool                   open_;
+
+    // id of subscribe request and whether only irreversible blocks are subscribed
+    std::optional<std::pair<uint32_t, bool>> subscription_;
+    std::optional<std::pair<uint32_t, bool>> trx_subscription_;
+};
+
+class local_rpc_session : public rpc_session {
+public:
+    local_rpc_session(local_rpc_plugin_impl& impl)
+        : rpc_session(impl)
+        , socket_(impl.ioc_)
+        , size_(0)
+        , queued_(0)
+        , writing_(false) {}
+
+public:
+    void start() { read_header(); }
+
+    void
+    send(const frame_ptr& frame) override {
+        if(!open_) {
+            return;
+        }
+        queued_ += frame->size();
+        if(queued_ > impl_.max_queued_bytes_) {
+            wlog("Close local rpc connection which doesn't read its responses in time");
+            close();
+            return;
+        }
+        queue_.emplace_back(frame);
+        if(!writing_) {
+            write();
+        }
+    }
+
+    void
+    close() override {
+        if(!release()) {
+            return;
+        }
+        auto ec = boost::system::error_code();
+        socket_.close(ec);
+        impl_.close_session(shared_from_this());
+    }
+
+private:
+    std::shared_ptr<local_rpc_session>
+    self() {
+        return std::static_pointer_cast<local_rpc_session>(shared_from_this());
+    }
+
+    void
+    read_header() {
+        asio::async_read(socket_, asio::buffer(&size_, sizeof(size_)), [s = self()](auto& ec, auto) {
+            if(ec) {
+                s->close();
+                return;
+            }
+            auto size = boost::endian::little_to_native(s->size_);
+            if(size == 0 || size > s->impl_.max_frame_size_) {
+                wlog("Close local rpc connection with invalid frame size: ${s}", ("s",size));
+                s->close();
+                return;
+            }
+            s->read_body(size);
+        });
+    }
+
+    void
+    read_body(uint32_t size) {
+        body_.resize(size);
+        asio::async_read(socket_, asio::buffer(body_), [s = self()](auto& ec, auto) {
+            if(ec) {
+                s->close();
+                return;
+            }
+
+            auto req = request();
+            try {
+                fc::raw::unpack(s->body_, req);
+            }
+            catch(...) {
+                wlog("Close local rpc connection with malformed request");
+                s->close();
+                return;
+            }
+            s->impl_.handle_request(s, std::move(req));
+            s->read_header();
+        });
+    }
+
+    void
+    write() {
+        writing_ = true;
+        asio::async_write(socket_, asio::buffer(*queue_.front()), [s = self()](auto& ec, auto) {
+            s->queued_ -= s->queue_.front()->size();
+            s->queue_.pop_front();
+            if(ec) {
+                s->close();
+                return;
+            }
+            if(s->queue_.empty()) {
+                s->writing_ = false;
+                return;
+            }
+            s->write();
+        });
+    }
+
+public:
+    stream_protocol::socket socket_;
+
+    uint32_t          size_;
+    std::vector<char> body_;
+
+    std::deque<frame_ptr> queue_;
+    size_t                queued_;
+    bool                  writing_;
+};
+
+// connection on the websocket of http_plugin, messages are sent and received on main thread by http_plugin
+class websocket_session : public rpc_session {
+public:
+    websocket_session(local_rpc_plugin_impl& impl, websocket_id id)
+        : rpc_session(impl)
+        , id_(id) {}
+
+public:
+    void
+    send(const frame_ptr& frame) override {
+        if(!open_) {
+            return;
+        }
+        // size prefix is not needed by websocket
+        auto msg = std::string(frame->data() + sizeof(uint32_t), frame->size() - sizeof(uint32_t));
+        app().get_plugin<http_plugin>().send_websocket_message(id_, msg, true /* binary */);
+    }
+
+    // called once the websocket is closed by http_plugin, server doesn't close it actively
+    void
+    close() override {
+        if(!release()) {
+            return;
+        }
+        auto self = shared_from_this();
+        impl_.websockets_.erase(id_);
+        impl_.close_session(self);
+    }
+
+public:
+    websocket_id id_;
+};
+
+namespace internal {
+
+struct request_visitor {
+    using result_type = void;
+
+    local_rpc_plugin_impl& impl;
+    const session_ptr&     s;
+    uint32_t               id;
+
+    void
+    operator()(push_transaction_request& r) {
+        auto ptrx = std::make_shared<chain::packed_transaction>(std::move(r.trx));
+        auto ioc  = &impl.ioc_;
+
+        // transactions are accepted on main thread and answered back on the thread of session
+        post_lane(app_lane::http, [ptrx, ioc, s = s, id = id] {
+            auto reply = [ioc, s](frame_ptr frame) {
+                asio::post(*ioc, [s, frame] { s->send(frame); });
+            };
+            try {
+                app().get_plugin<chain_plugin>().accept_transaction(ptrx, true, [reply, id](auto& result) {
+                    if(result.template contains<fc::exception_ptr>()) {
+                        reply(make_error(id, *result.template get<fc::exception_ptr>()));
+                        return;
+                    }
+                    auto& trace = result.template get<chain::transaction_trace_ptr>();
+                    if(trace->except.has_value()) {
+                        reply(make_error(id, *trace->except));
+                        return;
+                    }
+                    reply(make_frame(response { id, push_transaction_result { trace->id, (uint32_t)trace->elapsed.count(), trace->charge } }));
+                });
+            }
+            catch(const fc::exception& e) {
+                reply(make_error(id, e));
+            }
+            catch(const std::exception& e) {
+                reply(make_error(id, e));
+            }
+        });
+    }
+
+    void
+    operator()(get_token_request& r) {
+        // apis of evt_plugin are served from the read view of token database, safe to call them here
+        auto api   = app().get_plugin<evt_plugin>().get_read_only_api();
+        auto token = api.get_token_packed(evt_apis::read_only::get_token_params { r.domain, r.name });
+        s->send(make_frame(response { id, get_token_result { bytes(token.cbegin(), token.cend()) } }));
+    }
+
+    void
+    operator()(get_fungible_balance_request& r) {
+        auto api  = app().get_plugin<evt_plugin>().get_read_only_api();
+        auto vars = api.get_fungible_balance(evt_apis::read_only::get_fungible_balance_params { r.addr, r.sym_id });
+        s->send(make_frame(response { id, get_fungible_balance_result { vars.get_array()[0].as<chain::asset>() } }));
+    }
+
+    void
+    operator()(subscribe_blocks_request& r) {
+        if(!s->subscription_.has_value()) {
+            impl.subscribers_++;
+        }
+        s->subscription_ = std::make_pair(id, r.irreversible);
+        s->send(make_frame(response { id, subscribe_blocks_result() }));
+    }
+
+    void
+    operator()(unsubscribe_blocks_request&) {
+        if(s->subscription_.has_value()) {
+            impl.subscribers_--;
+            s->subscription_.reset();
+        }
+        s->send(make_frame(response { id, subscribe_blocks_result() }));
+    }
+
+    void
+    operator()(subscribe_transactions_request& r) {
+        if(!s->trx_subscription_.has_value()) {
+            impl.trx_subscribers_++;
+        }
+        s->trx_subscription_ = std::make_pair(id, r.irreversible);
+        s->send(make_frame(response { id, subscribe_transactions_result() }));
+    }
+
+    void
+    operator()(unsubscribe_transactions_request&) {
+        if(s->trx_subscription_.has_value()) {
+            impl.trx_subscribers_--;
+            s->trx_subscription_.reset();
+        }
+        s->send(make_frame(response { id, subscribe_transactions_result() }));
+    }
+};
+
+}  // namespace internal
+
+void
+local_rpc_plugin_impl::handle_request(const session_ptr& s, request&& req) {
+    using namespace internal;
+
+    try {
+        auto visitor = request_visitor { *this, s, req.id };
+        req.body.visit(visitor);
+    }
+    catch(const fc::exception& e) {
+        s->send(make_error(req.id, e));
+    }
+    catch(const std::exception& e) {
+        s->send(make_error(req.id, e));
+    }
+}
+
+void
+local_rpc_plugin_impl::close_session(const session_ptr& s) {
+    sessions_.erase(s);
+}
+
+void
+local_rpc_plugin_impl::accept() {
+    auto s = std::make_shared<local_rpc_session>(*this);
+    acceptor_.async_accept(s->socket_, [this, s](auto& ec) {
+        if(ec) {
+            if(ec != asio::error::operation_aborted) {
+                elog("Accept local rpc connection failed: ${e}", ("e",ec.message()));
+                accept();
+            }
+            return;
+        }
+        sessions_.emplace(s);
+        s->start();
+        accept();
+    });
+}
+
+void
+local_rpc_plugin_impl::notify_block(const chain::block_state_ptr& bsp, bool irreversible) {
+    using namespace internal;
+
+    if(subscribers_ == 0 && trx_subscribers_ == 0) {
+        return;
+    }
+
+    // block is packed once on main thread and shared by the subscribers
+    auto notice = std::optional<block_notice>();
+    if(subscribers_ > 0) {
+        notice.emplace(block_notice { bsp->block_num, bsp->id, fc::raw::pack(*bsp->block) });
+    }
+    auto trx_notice = std::optional<transaction_notice>();
+    if(trx_subscribers_ > 0) {
+        trx_notice.emplace(transaction_notice { bsp->block_num, bsp->id, {} });
+        trx_notice->trx_ids.reserve(bsp->block->transactions.size());
+        for(auto& r : bsp->block->transactions) {
+            trx_notice->trx_ids.emplace_back(r.trx.id());
+        }
+    }
+
+    asio::post(ioc_, [this, notice = std::move(notice), trx_notice = std::move(trx_notice), irreversible] {
+        // slow subscribers may be closed while sending
+        auto sessions = sessions_;
+        for(auto& s : sessions) {
+            if(notice.has_value() && s->subscription_.has_value() && s->subscription_->second == irreversible) {
+                s->send(make_frame(response { s->subscription_->first, *notice }));
+            }
+            if(trx_notice.has_value() && s->trx_subscription_.has_value() && s->trx_subscription_->second == irreversible) {
+                s->send(make_frame(response { s->trx_subscription_->first, *trx_notice }));
+            }
+        }
+    });
+}
+
+void
+local_rpc_plugin_impl::add_websocket_handler() {
+    using namespace internal;
+
+    // http_plugin calls them on main thread, sessions are still only touched on the thread of io context
+    auto wh    = websocket_handler();
+    wh.on_open = [this](auto id) {
+        asio::post(ioc_, [this, id] {
+            auto s = std::make_shared<websocket_session>(*this, id);
+            websockets_.emplace(id, s);
+            sessions_.emplace(s);
+        });
+    };
+    wh.on_message = [this](auto id, auto message) {
+        asio::post(ioc_, [this, id, message = std::move(message)] {
+            auto it = websockets_.find(id);
+            if(it == websockets_.end()) {
+                return;
+            }
+            auto s = it->second;
+            if(message.empty() || message.size() > max_frame_size_) {
+                wlog("Ignore websocket rpc message with invalid size: ${s}", ("s",message.size()));
+                return;
+            }
+
+            auto req = request();
+            try {
+                req = fc::raw::unpack<request>(message.data(), message.size());
+            }
+            catch(...) {
+                wlog("Ignore malformed websocket rpc message");
+                return;
+            }
+            handle_request(s, std::move(req));
+        });
+    };
+    wh.on_close = [this](auto id) {
+        asio::post(ioc_, [this, id] {
+            auto it = websockets_.find(id);
+            if(it != websockets_.end()) {
+                it->second->close();
+            }
+        });
+    };
+    app().get_plugin<http_plugin>().add_websocket_handler("/v1/local_rpc/stream", wh);
+}
+
+void
+local_rpc_plugin_impl::start() {
+    if(!socket_path_.empty()) {
+        if(bfs::exists(socket_path_)) {
+            // left by last run
+            bfs::remove(socket_path_);
+        }
+
+        auto ep = stream_protocol::endpoint(socket_path_.string());
+        acceptor_.open(ep.protocol());
+        acceptor_.bind(ep);
+        acceptor_.listen();
+        accept();
+    }
+    if(websocket_) {
+        add_websocket_handler();
+    }
+
+    auto& chain = app().get_plugin<chain_plugin>().chain();
+    accepted_block_connection_.emplace(chain.accepted_block.connect([this](auto& bsp) {
+        notify_block(bsp, false);
+    }));
+    irreversible_block_connection_.emplace(chain.irreversible_block.connect([this](auto& bsp) {
+        notify_block(bsp, true);
+    }));
+
+    work_.emplace(asio::make_work_guard(ioc_));
+    thread_.emplace([this] {
+        evt::utilities::place_current_thread("local-rpc");
+        ioc_.run();
+    });
+    if(!socket_path_.empty()) {
+        ilog("Start local rpc on unix socket: ${p}", ("p",socket_path_.string()));
+    }
+    if(websocket_) {
+        ilog("Start local rpc on websocket: /v1/local_rpc/stream");
+    }
+}
+
+void
+local_rpc_plugin_impl::stop() {
+    accepted_block_connection_.reset();
+    irreversible_block_connection_.reset();
+
+    if(!thread_.has_value()) {
+        return;
+    }
+    asio::post(ioc_, [this] {
+        auto ec = boost::system::error_code();
+        acceptor_.close(ec);
+
+        auto sessions = sessions_;
+        for(auto& s : sessions) {
+            s->close();
+        }
+    });
+    work_.reset();
+    thread_->join();
+    thread_.reset();
+
+    if(!socket_path_.empty()) {
+        auto ec = boost::system::error_code();
+        bfs::remove(socket_path_, ec);
+    }
+}
+
+local_rpc_plugin::local_rpc_plugin() {}
+local_rpc_plugin::~local_rpc_plugin() {}
+
+void
+local_rpc_plugin::set_program_options(options_description& cli, options_description& cfg) {
+    cfg.add_options()
+        ("local-rpc-socket-path", bpo::value<std::string>()->default_value("evtd.rpc.sock"),
+            "The filename (or relative to data-dir) to create a unix socket for binary RPC; set blank to disable.")
+        ("local-rpc-websocket", bpo::bool_switch()->default_value(false),
+            "Also serve the binary RPC on the websocket /v1/local_rpc/stream of http_plugin for remote clients")
+        ("local-rpc-max-frame-size", bpo::value<uint32_t>()->default_value(kDefaultMaxFrameSize),
+            "Maximum size in bytes of one request frame, connections sending larger ones are closed")
+        ("local-rpc-max-queued-mb", bpo::value<uint32_t>()->default_value(64),
+            "Maximum size of responses and notices queued for one connection before it's closed as a slow consumer")
+        ;
+}
+
+void
+local_rpc_plugin::plugin_initialize(const variables_map& options) {
+    auto path      = options.at("local-rpc-socket-path").as<std::string>();
+    auto websocket = options.at("local-rpc-websocket").as<bool>();
+    if(path.empty() && !websocket) {
+        return;
+    }
+
+    my_ = std::make_shared<local_rpc_plugin_impl>();
+
+    my_->socket_path_ = path;
+    if(!path.empty() && my_->socket_path_.is_relative()) {
+        my_->socket_path_ = app().data_dir() / my_->socket_path_;
+    }
+    my_->websocket_ = websocket;
+    my_->max_frame_size_   = options.at("local-rpc-max-frame-size").as<uint32_t>();
+    my_->max_queued_bytes_ = (size_t)options.at("local-rpc-max-queued-mb").as<uint32_t>() * 1024 * 1024;
+    EVT_ASSERT(my_->max_frame_size_ > 0, chain::plugin_config_exception, "local-rpc-max-frame-size must be greater than 0");
+    EVT_ASSERT(my_->max_queued_bytes_ > 0, chain::plugin_config_exception, "local-rpc-max-queued-mb must be greater than 0");
+}
+
+void
+local_rpc_plugin::plugin_startup() {
+    if(my_) {
+        my_->start();
+    }
+}
+
+void
+local_rpc_plugin::plugin_shutdown() {
+    if(my_) {
+        my_->stop();
+    }
+}
+
+}  // namespace evt
@@ -6,7 +6,13 @@
 #include <evt/chain/contracts/types.hpp>
 #include <evt/chain/address.hpp>
 
+#include <future>
 #include <mutex>
+#include <optional>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <fc/io/json.hpp>
 
@@ -19,69 +25,206 @@
 #include <mongocxx/client.hpp>
 #include <mongocxx/instance.hpp>
 #include <mongocxx/database.hpp>
+#include <mongocxx/model/write.hpp>
 
 namespace evt {
 
 using namespace evt::chain::contracts;
 using mongocxx::bulk_write;
 
+// writes interpreted from actions, they own their documents so they can be built on worker threads
+// and appended into the bulk writes later
+struct interpret_writes {
+    std::vector<mongocxx::model::write> domains;
+    std::vector<mongocxx::model::write> tokens;
+    std::vector<mongocxx::model::write> groups;
+    std::vector<mongocxx::model::write> fungibles;
+};
+
 class interpreter_impl {
+public:
+    ~interpreter_impl();
+
 public:
     void initialize_db(const mongocxx::database& db);
+    void set_threads(size_t threads);
     void process_trx(const transaction& trx, write_context& write_ctx);
+    void process_block(const signed_block& block, write_context& write_ctx);
+
+private:
+    void process_action(const chain::action& act, interpret_writes& writes);
+    void append_writes(interpret_writes& writes, write_context& write_ctx);
 
 private:
-    void process_newdomain(const newdomain& nd, write_context& write_ctx);
-    void process_updatedomain(const updatedomain& ud, write_context& write_ctx);
-    void process_issuetoken(const issuetoken& it, write_context& write_ctx);
-    void process_transfer(const transfer& tt, write_context& write_ctx);
-    void process_newgroup(const newgroup& ng, write_context& write_ctx);
-    void process_updategroup(const updategroup& ug, write_context& write_ctx);
-    void process_newfungible(const newfungible& nf, write_context& write_ctx);
-    void process_updfungible(const updfungible& uf, write_context& write_ctx);
-    void process_issuefungible(const issuefungible& ifact, write_context& write_ctx);
-    void process_destroytoken(const destroytoken& dt, write_context& write_ctx);
-    void process_everipass(const everipass& ep, write_context& write_ctx);
-    void process_addmeta(const chain::action& act, write_context& write_ct);
+    void process_newdomain(const newdomain& nd, interpret_writes& writes);
+    void process_updatedomain(const updatedomain& ud, interpret_writes& writes);
+    void process_issuetoken(const issuetoken& it, interpret_writes& writes);
+    void process_transfer(const transfer& tt, interpret_writes& writes);
+    void process_newgroup(const newgroup& ng, interpret_writes& writes);
+    void process_updategroup(const updategroup& ug, interpret_writes& writes);
+    void process_newfungible(const newfungible& nf, interpret_writes& writes);
+    void process_updfungible(const updfungible& uf, interpret_writes& writes);
+    void process_issuefungible(const issuefungible& ifact, interpret_writes& writes);
+    void process_destroytoken(const destroytoken& dt, interpret_writes& writes);
+    void process_everipass(const everipass& ep, interpret_writes& writes);
+    void process_addmeta(const chain::action& act, interpret_writes& writes);
 
 private:
     mongocxx::database db_;
+    size_t             threads_ = 0;
+
+    std::optional<boost::asio::thread_pool> workers_;
 };
 
+interpreter_impl::~interpreter_impl() {
+    if(workers_) {
+        workers_->join();
+    }
+}
+
 void
 interpreter_impl::initialize_db(const mongocxx::database& db) {
     db_ = db;
 }
 
-#define CASE_N_CALL(name, write_ctx)                           \
-    case N(name): {                                            \
-        process_##name(act.data_as<const name&>(), write_ctx); \
-        break;                                                 \
+void
+interpreter_impl::set_threads(size_t threads) {
+    threads_ = threads;
+    if(threads > 0) {
+        workers_.emplace(threads);
+    }
+}
+
+#define CASE_N_CALL(name, writes)                           \
+    case N(name): {                                         \
+        process_##name(act.data_as<const name&>(), writes); \
+        break;                                              \
     }
 
+void
+interpreter_impl::process_action(const chain::action& act, interpret_writes& writes) {
+    switch((uint64_t)act.name) {
+        CASE_N_CALL(newdomain, writes)
+        CASE_N_CALL(updatedomain, writes)
+        CASE_N_CALL(issuetoken, writes)
+        CASE_N_CALL(transfer, writes)
+        CASE_N_CALL(destroytoken, writes)
+        CASE_N_CALL(newgroup, writes)
+        CASE_N_CALL(updategroup, writes)
+        CASE_N_CALL(newfungible, writes)
+        CASE_N_CALL(updfungible, writes)
+        CASE_N_CALL(issuefungible, writes)
+        CASE_N_CALL(everipass, writes)
+
+        case N(addmeta): {
+            process_addmeta(act, writes);
+            break;
+        }
+        default: break;
+    }
+}
+
+void
+interpreter_impl::append_writes(interpret_writes& writes, write_context& write_ctx) {
+    for(auto& w : writes.domains) {
+        write_ctx.get_domains().append(w);
+    }
+    for(auto& w : writes.tokens) {
+        write_ctx.get_tokens().append(w);
+    }
+    for(auto& w : writes.groups) {
+        write_ctx.get_groups().append(w);
+    }
+    for(auto& w : writes.fungibles) {
+        write_ctx.get_fungibles().append(w);
+    }
+}
+
 void
 interpreter_impl::process_trx(const transaction& trx, write_context& write_ctx) {
+    auto writes = interpret_writes();
     for(auto& act : trx.actions) {
-        switch((uint64_t)act.name) {
-            CASE_N_CALL(newdomain, write_ctx)
-            CASE_N_CALL(updatedomain, write_ctx)
-            CASE_N_CALL(issuetoken, write_ctx)
-            CASE_N_CALL(transfer, write_ctx)
-            CASE_N_CALL(destroytoken, write_ctx)
-            CASE_N_CALL(newgroup, write_ctx)
-            CASE_N_CALL(updategroup, write_ctx)
-            CASE_N_CALL(newfungible, write_ctx)
-            CASE_N_CALL(updfungible, write_ctx)
-            CASE_N_CALL(issuefungible, write_ctx)
-            CASE_N_CALL(everipass, write_ctx)
-
-            case N(addmeta): {
-                process_addmeta(act, write_ctx);
-                break;
+        process_action(act, writes);
+    }
+    append_writes(writes, write_ctx);
+}
+
+namespace internal {
+
+// documents of one domain, group or fungible are only updated by the actions of the same shard,
+// tokens are in the shards of their domains
+size_t
+shard_key(const chain::action& act) {
+    if(act.domain == N128(.group) || act.domain == N128(.fungible)) {
+        return std::hash<chain::name128>()(act.key);
+    }
+    return std::hash<chain::name128>()(act.domain);
+}
+
+}  // namespace internal
+
+void
+interpreter_impl::process_block(const signed_block& block, write_context& write_ctx) {
+    // blocks with fewer actions are not worth the tasks
+    constexpr size_t kMinShardedActions = 64;
+
+    auto acts = std::vector<const chain::action*>();
+    for(auto& ptrx : block.transactions) {
+        for(auto& act : ptrx.trx.get_transaction().actions) {
+            acts.emplace_back(&act);
+        }
+    }
+
+    if(!workers_ || acts.size() < kMinShardedActions) {
+        auto writes = interpret_writes();
+        for(auto act : acts) {
+            process_action(*act, writes);
+        }
+        append_writes(writes, write_ctx);
+        return;
+    }
+
+    // actions keep their order in each shard, shards touch disjoint documents
+    auto shards = std::vector<std::vector<const chain::action*>>(threads_);
+    for(auto act : acts) {
+        shards[internal::shard_key(*act) % threads_].emplace_back(act);
+    }
+
+    auto writes = std::vector<interpret_writes>(threads_);
+    auto tasks  = std::vector<std::future<void>>();
+    for(auto i = 0u; i < threads_; i++) {
+        if(shards[i].empty()) {
+            continue;
+        }
+        auto task = std::packaged_task<void()>([this, &shards, &writes, i] {
+            for(auto act : shards[i]) {
+                process_action(*act, writes[i]);
+            }
+        });
+        tasks.emplace_back(task.get_future());
+        boost::asio::post(*workers_, std::move(task));
+    }
+
+    // waits for all the tasks before throwing the first error, they still refer to the locals
+    auto error = std::exception_ptr();
+    for(auto& t : tasks) {
+        try {
+            t.get();
+        }
+        catch(...) {
+            if(!error) {
+                error = std::current_exception();
             }
-            default: break;
         }
     }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+
+    // bulk writes are not thread-safe, they're filled here and committed with the block
+    for(auto& w : writes) {
+        append_writes(w, write_ctx);
+    }
 }
 
 namespace internal {
@@ -129,7 +272,7 @@ find_fungible(const symbol_id_type sym_id) {
 }  // namespace internal
 
 void
-interpreter_impl::process_newdomain(const newdomain& nd, write_context& write_ctx) {
+interpreter_impl::process_newdomain(const newdomain& nd, interpret_writes& writes) {
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
     using namespace mongocxx::model;
@@ -154,11 +297,11 @@ interpreter_impl::process_newdomain(const newdomain& nd, write_context& write_ct
                kvp("manage", bsoncxx::from_json(fc::json::to_string(manage))));
     doc.append(kvp("created_at", b_date{now}));
 
-    write_ctx.get_domains().append(insert_one(doc.view()));
+    writes.domains.emplace_back(insert_one(doc.extract()));
 }
 
 void
-interpreter_impl::process_updatedomain(const updatedomain& ud, write_context& write_ctx) {
+interpreter_impl::process_updatedomain(const updatedomain& ud, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -193,11 +336,11 @@ interpreter_impl::process_updatedomain(const updatedomain& ud, write_context& wr
     update << "updated_at" << b_date{now}
            << close_document;
 
-    write_ctx.get_domains().append(update_one(find_domain((std::string)ud.name).view(), update.view()));
+    writes.domains.emplace_back(update_one(find_domain((std::string)ud.name).extract(), update.extract()));
 }
 
 void
-interpreter_impl::process_issuetoken(const issuetoken& it, write_context& write_ctx) {
+interpreter_impl::process_issuetoken(const issuetoken& it, interpret_writes& writes) {
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
     using namespace mongocxx::model;
@@ -224,12 +367,12 @@ interpreter_impl::process_issuetoken(const issuetoken& it, write_context& write_
                    kvp("owner", owners));
         doc.append(kvp("created_at", b_date{now}));
 
-        write_ctx.get_tokens().append(insert_one(doc.view()));
+        writes.tokens.emplace_back(insert_one(doc.extract()));
     }
 }
 
 void
-interpreter_impl::process_transfer(const transfer& tt, write_context& write_ctx) {
+interpreter_impl::process_transfer(const transfer& tt, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -252,12 +395,12 @@ interpreter_impl::process_transfer(const transfer& tt, write_context& write_ctx)
            << "updated_at" << b_date{now}
            << close_document;
 
-    write_ctx.get_tokens().append(
-        update_one(find_token((std::string)tt.domain, (std::string)tt.name).view(), update.view()));
+    writes.tokens.emplace_back(
+        update_one(find_token((std::string)tt.domain, (std::string)tt.name).extract(), update.extract()));
 }
 
 void
-interpreter_impl::process_destroytoken(const destroytoken& dt, write_context& write_ctx) {
+interpreter_impl::process_destroytoken(const destroytoken& dt, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -278,12 +421,12 @@ interpreter_impl::process_destroytoken(const destroytoken& dt, write_context& wr
            << "updated_at" << b_date{now}
            << close_document;
 
-    write_ctx.get_tokens().append(
-        update_one(find_token((std::string)dt.domain, (std::string)dt.name).view(), update.view()));
+    writes.tokens.emplace_back(
+        update_one(find_token((std::string)dt.domain, (std::string)dt.name).extract(), update.extract()));
 }
 
 void
-interpreter_impl::process_newgroup(const newgroup& ng, write_context& write_ctx) {
+interpreter_impl::process_newgroup(const newgroup& ng, interpret_writes& writes) {
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
     using namespace mongocxx::model;
@@ -303,11 +446,11 @@ interpreter_impl::process_newgroup(const newgroup& ng, write_context& write_ctx)
                kvp("def", bsoncxx::from_json(fc::json::to_string(def))));
     doc.append(kvp("created_at", b_date{now}));
 
-    write_ctx.get_groups().append(insert_one(doc.view()));
+    writes.groups.emplace_back(insert_one(doc.extract()));
 }
 
 void
-interpreter_impl::process_updategroup(const updategroup& ug, write_context& write_ctx) {
+interpreter_impl::process_updategroup(const updategroup& ug, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -327,11 +470,11 @@ interpreter_impl::process_updategroup(const updategroup& ug, write_context& writ
     update << "updated_at" << b_date{now}
            << close_document;
 
-    write_ctx.get_groups().append(update_one(find_group(name).view(), update.view()));
+    writes.groups.emplace_back(update_one(find_group(name).extract(), update.extract()));
 }
 
 void
-interpreter_impl::process_newfungible(const newfungible& nf, write_context& write_ctx) {
+interpreter_impl::process_newfungible(const newfungible& nf, interpret_writes& writes) {
     using namespace evt::chain;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -359,11 +502,11 @@ interpreter_impl::process_newfungible(const newfungible& nf, write_context& writ
                kvp("total_supply", (std::string)nf.total_supply));
     doc.append(kvp("created_at", b_date{now}));
 
-    write_ctx.get_fungibles().append(insert_one(doc.view()));
+    writes.fungibles.emplace_back(insert_one(doc.extract()));
 }
 
 void
-interpreter_impl::process_updfungible(const updfungible& uf, write_context& write_ctx) {
+interpreter_impl::process_updfungible(const updfungible& uf, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -394,11 +537,11 @@ interpreter_impl::process_updfungible(const updfungible& uf, write_context& writ
     update << "updated_at" << b_date{now}
            << close_document;
 
-    write_ctx.get_fungibles().append(update_one(find_fungible(id).view(), update.view()));
+    writes.fungibles.emplace_back(update_one(find_fungible(id).extract(), update.extract()));
 }
 
 void
-interpreter_impl::process_everipass(const everipass& ep, write_context& write_ctx){
+interpreter_impl::process_everipass(const everipass& ep, interpret_writes& writes){
     auto  link  = ep.link;
     auto  flags = link.get_header();
     auto& d     = *link.get_segment(evt_link::domain).strv;
@@ -409,12 +552,12 @@ interpreter_impl::process_everipass(const everipass& ep, write_context& write_ct
         dt.domain = d;
         dt.name   = t;
 
-        process_destroytoken(dt, write_ctx);
+        process_destroytoken(dt, writes);
     }
 }
 
 void
-interpreter_impl::process_addmeta(const chain::action& act, write_context& write_ctx) {
+interpreter_impl::process_addmeta(const chain::action& act, interpret_writes& writes) {
     using namespace internal;
     using namespace bsoncxx::types;
     using namespace bsoncxx::builder;
@@ -423,7 +566,7 @@ interpreter_impl::process_addmeta(const chain::action& act, write_context& write
     using bsoncxx::builder::stream::document;
     using bsoncxx::builder::stream::open_document;
 
-    auto am = act.data_as<const addmeta&>();
+    auto& am = act.data_as<const addmeta&>();
 
     document meta{};
     meta << (std::string)am.key << am.value;
@@ -434,17 +577,17 @@ interpreter_impl::process_addmeta(const chain::action& act, write_context& write
     update << close_document;
 
     if(act.domain == N128(.group)) {
-        write_ctx.get_groups().append(update_one(find_group((std::string)act.key).view(), update.view()));
+        writes.groups.emplace_back(update_one(find_group((std::string)act.key).extract(), update.extract()));
     }
     else if(act.domain == N128(.fungible)) {
         auto id = (uint64_t)std::stoull((std::string)act.key);
-        write_ctx.get_fungibles().append(update_one(find_fungible(id).view(), update.view()));
+        writes.fungibles.emplace_back(update_one(find_fungible(id).extract(), update.extract()));
     }
     else if(act.key == N128(.meta)) {
-        write_ctx.get_domains().append(update_one(find_domain((std::string)act.domain).view(), update.view()));
+        writes.domains.emplace_back(update_one(find_domain((std::string)act.domain).extract(), update.extract()));
     }
     else {
-        write_ctx.get_tokens().append(update_one(find_token((std::string)act.domain, (std::string)act.key).view(), update.view()));
+        writes.tokens.emplace_back(update_one(find_token((std::string)act.domain, (std::string)act.key).extract(), update.extract()));
     }
 }
 
@@ -459,7 +602,7 @@ get_bson_string_value(const bsoncxx::document::view& view, const std::string& ke
 }  // namespace internal
 
 void
-interpreter_impl::process_issuefungible(const issuefungible& ifact, write_context& write_ctx) {
+interpreter_impl::process_issuefungible(const issuefungible& ifact, interpret_writes& writes) {
     return;
 }
 
@@ -470,6 +613,16 @@ evt_interpreter::initialize_db(const mongocxx::database& db) {
     my_->initialize_db(db);
 }
 
+void
+evt_interpreter::set_threads(size_t threads) {
+    my_->set_threads(threads);
+}
+
+void
+evt_interpreter::process_block(const signed_block& block, write_context& write_ctx) {
+    my_->process_block(block, write_ctx);
+}
+
 void
 evt_interpreter::process_trx(const transaction& trx, write_context& write_ctx) {
     my_->process_trx(trx, write_ctx);
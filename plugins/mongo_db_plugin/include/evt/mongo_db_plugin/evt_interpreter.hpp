@@ -6,12 +6,14 @@
 #include <memory>
 #include <functional>
 #include <mongocxx/database.hpp>
+#include <evt/chain/block.hpp>
 #include <evt/chain/trace.hpp>
 #include <evt/mongo_db_plugin/write_context.hpp>
 
 namespace evt {
 
 using evt::chain::transaction;
+using evt::chain::signed_block;
 
 class interpreter_impl;
 using interpreter_impl_ptr = std::shared_ptr<interpreter_impl>;
@@ -22,7 +24,13 @@ public:
 
 public:
     void initialize_db(const mongocxx::database& db);
+
+    // actions of blocks are interpreted on `threads` threads, sharded by their domains, groups or fungibles;
+    // 0 to interpret them on the calling thread
+    void set_threads(size_t threads);
+
     void process_trx(const transaction& trx, write_context& write_ctx);
+    void process_block(const signed_block& block, write_context& write_ctx);
 
 private:
     interpreter_impl_ptr my_;
@@ -33,6 +33,14 @@ public:
     const mongocxx::uri& uri() const;
     bool  enabled() const;
 
+    // blocks since startup, blocks waiting are the difference of them, safe to call from any thread
+    struct queue_metrics {
+        uint64_t queued_blocks    = 0;
+        uint64_t processed_blocks = 0;
+        size_t   queue_size       = 0;  // limit of the queue
+    };
+    queue_metrics get_queue_metrics() const;
+
 private:
     std::unique_ptr<class mongo_db_plugin_impl> my_;
 };
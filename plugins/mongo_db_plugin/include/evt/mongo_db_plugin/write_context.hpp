@@ -5,13 +5,18 @@
 #pragma once
 
 #include <string>
+#include <future>
 #include <memory>
 #include <optional>
+#include <vector>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/scope_exit.hpp>
 #include <bsoncxx/exception/exception.hpp>
 #include <bsoncxx/json.hpp>
 #include <mongocxx/database.hpp>
 #include <mongocxx/bulk_write.hpp>
+#include <mongocxx/write_concern.hpp>
 #include <mongocxx/exception/operation_exception.hpp>
 #include <mongocxx/exception/logic_error.hpp>
 #include <appbase/application.hpp>
@@ -22,49 +27,81 @@ using mongocxx::database;
 using mongocxx::collection;
 using mongocxx::bulk_write;
 
-#define define_collection(n)                                        \
-    collection                 n##_collection;                       \
-    std::optional<bulk_write>  n##_commits;                          \
-                                                                    \
-    auto& get_##n() {                                               \
-        if(!(n##_commits)) {                                        \
-            n##_commits = n##_collection.create_bulk_write(opts_);  \
-        }                                                           \
-        total_++;                                                   \
-        return *n##_commits;                                        \
+// writes of collection whose documents are only inserted can be unordered
+#define define_collection(n, ordered)                              \
+    collection                 n##_collection;                     \
+    std::optional<bulk_write>  n##_commits;                        \
+                                                                   \
+    auto& get_##n() {                                              \
+        if(!(n##_commits)) {                                       \
+            auto opts = opts_;                                     \
+            opts.ordered(ordered);                                 \
+            n##_commits = n##_collection.create_bulk_write(opts);  \
+        }                                                          \
+        total_++;                                                  \
+        return *n##_commits;                                       \
+    }                                                              \
+                                                                   \
+    void commit_##n() {                                            \
+        if(n##_commits.has_value()) {                              \
+            BOOST_SCOPE_EXIT_ALL(&) {                              \
+                n##_commits.reset();                               \
+            };                                                     \
+            try {                                                  \
+                n##_commits->execute();                            \
+            }                                                      \
+            catch(...) {                                           \
+                handle_mongo_exception(#n);                        \
+            }                                                      \
+        }                                                          \
     }
 
-#define commit_collection(n)            \
-    if(n##_commits.has_value()) {       \
-        BOOST_SCOPE_EXIT_ALL(&) {       \
-            n##_commits.reset();        \
-        };                              \
-        try {                           \
-            n##_commits->execute();     \
-        }                               \
-        catch(...) {                    \
-            handle_mongo_exception(#n); \
-        }                               \
-    }
+#define commit_collection(n) \
+    run(futures, [this] { commit_##n(); });
 
 class write_context {
 public:
-    write_context() {
-        opts_.ordered(true);
+    write_context() = default;
+    ~write_context() {
+        if(writers_) {
+            writers_->join();
+        }
     }
 
 public:
-    define_collection(blocks);
-    define_collection(trxs);
-    define_collection(actions);
-    define_collection(domains);
-    define_collection(tokens);
-    define_collection(groups);
-    define_collection(fungibles);
+    define_collection(blocks, true);
+    define_collection(trxs, true);
+    define_collection(actions, false);
+    define_collection(domains, true);
+    define_collection(tokens, true);
+    define_collection(groups, true);
+    define_collection(fungibles, true);
 
 public:
+    // collections are committed concurrently on `threads` threads, then each collection needs
+    // to be from its own client since clients are not thread-safe
+    void
+    set_writer_threads(size_t threads) {
+        if(threads > 0) {
+            writers_.emplace(threads);
+        }
+    }
+
+    // relaxed writes are not acknowledged, it only takes effect on the writes created after
+    void
+    set_relaxed(bool relaxed) {
+        opts_ = mongocxx::options::bulk_write();
+        if(relaxed) {
+            auto wc = mongocxx::write_concern();
+            wc.acknowledge_level(mongocxx::write_concern::level::k_unacknowledged);
+            opts_.write_concern(std::move(wc));
+        }
+    }
+
     void
     execute() {
+        auto futures = std::vector<std::future<void>>();
+
         commit_collection(blocks);
         commit_collection(trxs);
         commit_collection(actions);
@@ -73,6 +110,9 @@ public:
         commit_collection(groups);
         commit_collection(fungibles);
 
+        for(auto& f : futures) {
+            f.get();
+        }
         total_ = 0;
     }
 
@@ -82,6 +122,18 @@ public:
     }
 
 private:
+    template<typename F>
+    void
+    run(std::vector<std::future<void>>& futures, F&& f) {
+        if(!writers_) {
+            f();
+            return;
+        }
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+        futures.emplace_back(task->get_future());
+        boost::asio::post(*writers_, [task] { (*task)(); });
+    }
+
     void
     handle_mongo_exception(std::string desc) {
         bool shutdown = true;
@@ -135,8 +187,9 @@ private:
     }
 
 private:
-    mongocxx::options::bulk_write opts_;
-    size_t                        total_;
+    mongocxx::options::bulk_write            opts_;
+    size_t                                   total_ = 0;
+    std::optional<boost::asio::thread_pool> writers_;
 };
 
 }  // namespace evt
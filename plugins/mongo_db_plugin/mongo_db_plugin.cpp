@@ -6,8 +6,10 @@
 #include <evt/mongo_db_plugin/evt_interpreter.hpp>
 #include <evt/mongo_db_plugin/write_context.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <queue>
+#include <vector>
 #include <tuple>
 #include <thread>
 
@@ -19,6 +21,8 @@ using std::condition_variable_any;
 using boost::condition_variable_any;
 #endif
 
+#include <evt/chain/block_spill_queue.hpp>
+#include <evt/chain/memory_accounting.hpp>
 #include <evt/chain/config.hpp>
 #include <evt/chain/genesis_state.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -73,6 +77,9 @@ public:
 public:
     void consume_queues();
 
+    void queue_block(const block_state_ptr&, bool irreversible);
+    bool has_blocks() const { return !block_state_queue.empty() || (spill && !spill->empty()); }
+
     void applied_block(const block_state_ptr&);
     void applied_irreversible_block(const block_state_ptr&);
     void applied_transaction(const transaction_trace_ptr&);
@@ -106,12 +113,28 @@ public:
 
     evt_interpreter    interpreter;
 
-    size_t processed  = 0;
-    size_t queue_size = 0;
+    size_t processed           = 0;
+    size_t queue_size          = 0;
+    size_t bulk_size           = 0;
+    size_t writer_threads      = 0;
+    size_t interpreter_threads = 0;
+    bool   relaxed_sync        = false;
+
+    // blocks queued and processed since startup, read by metrics from other threads
+    std::atomic<uint64_t> queued_blocks{0};
+    std::atomic<uint64_t> processed_blocks{0};
+
+    // bytes of the blocks in memory, set when memory accounting is enabled
+    memory_counter* mem_blocks = nullptr;
+
+    std::vector<mongocxx::client> writer_conns;
 
     std::deque<inblock_ptr>           block_state_queue;
     std::deque<transaction_trace_ptr> transaction_trace_queue;
 
+    // blocks go into spill file instead of blocking the chain when queue is full
+    std::optional<block_spill_queue> spill;
+
     spinlock                    lock_;
     condition_variable_any      cond_;
     std::thread                 consume_thread_;
@@ -165,14 +188,32 @@ queuet(Q& tqueue, V&& v, spinlock& lock, condition_variable_any& cv) {
     cv.notify_one();
 }
 
+void
+mongo_db_plugin_impl::queue_block(const block_state_ptr& bsp, bool irreversible) {
+    queued_blocks.fetch_add(1, std::memory_order_relaxed);
+    if(spill) {
+        spinlock_guard lock(lock_);
+        // once blocks are spilled, the following ones are spilled as well until the file is drained to keep them in order
+        if(!spill->empty() || block_state_queue.size() > queue_size) {
+            spill->push(bsp, irreversible, transaction_trace_queue);
+            cond_.notify_one();
+            return;
+        }
+    }
+    if(mem_blocks) {
+        mem_blocks->add(estimate_block_bytes(*bsp));
+    }
+    queueb(block_state_queue, std::make_tuple(bsp, irreversible), lock_, cond_, queue_size);
+}
+
 void
 mongo_db_plugin_impl::applied_irreversible_block(const block_state_ptr& bsp) {
-    queueb(block_state_queue, std::make_tuple(bsp, true), lock_, cond_, queue_size);
+    queue_block(bsp, true);
 }
 
 void
 mongo_db_plugin_impl::applied_block(const block_state_ptr& bsp) {
-    queueb(block_state_queue, std::make_tuple(bsp, false), lock_, cond_, queue_size);
+    queue_block(bsp, false);
 }
 
 void
@@ -185,14 +226,33 @@ mongo_db_plugin_impl::consume_queues() {
     try {
         while(true) {
             lock_.lock();
-            while(block_state_queue.empty() && !done_) {
+            while(!has_blocks() && !done_) {
                 cond_.wait(lock_);
             }
 
             auto bqueue = std::move(block_state_queue);
             auto traces = std::move(transaction_trace_queue);
 
-            lock_.unlock();
+            if(bqueue.empty() && spill && !spill->empty()) {
+                // spilled blocks are after the ones in queue, and the traces of them are in file
+                transaction_trace_queue = std::move(traces);
+                traces.clear();
+                lock_.unlock();
+
+                auto items = std::vector<block_spill_queue::item>();
+                spill->read(std::max<size_t>(queue_size, 1), items);
+                for(auto& it : items) {
+                    if(mem_blocks) {
+                        mem_blocks->add(estimate_block_bytes(*it.block));
+                    }
+                    bqueue.emplace_back(it.block, it.irreversible);
+                    traces.insert(traces.end(), it.traces.begin(), it.traces.end());
+                }
+                spill->release(items.size());
+            }
+            else {
+                lock_.unlock();
+            }
 
             const int BlockPtr       = 0;
             const int IsIrreversible = 1;
@@ -206,6 +266,12 @@ mongo_db_plugin_impl::consume_queues() {
                 break;
             }
 
+            // writes are not acknowledged while catching up with blocks produced long before
+            if(relaxed_sync && !bqueue.empty()) {
+                auto ts = (fc::time_point)std::get<BlockPtr>(bqueue.back())->header.timestamp;
+                write_ctx_.set_relaxed(fc::time_point::now() - ts > fc::minutes(1));
+            }
+
             // process block states
             while(true) {
                 if(bqueue.empty()) {
@@ -220,11 +286,15 @@ mongo_db_plugin_impl::consume_queues() {
                     process_block(*(std::get<BlockPtr>(b)->block), traces, write_ctx_);
                 }
 
-                if(write_ctx_.total() >= queue_size * 2) {
+                if(write_ctx_.total() >= bulk_size) {
                     write_ctx_.execute();
                 }
 
+                if(mem_blocks) {
+                    mem_blocks->sub(estimate_block_bytes(*std::get<BlockPtr>(b)));
+                }
                 bqueue.pop_front();
+                processed_blocks.fetch_add(1, std::memory_order_relaxed);
             }
             if(write_ctx_.total() > 0) {
                 write_ctx_.execute();
@@ -260,8 +330,7 @@ add_data(bsoncxx::builder::basic::document& act_doc,
         auto& abis    = evt_abi;
         auto  acttype = exec_ctx.get_acttype_name(act.name);
 
-        auto v    = abis.binary_to_variant(acttype, act.data, exec_ctx);
-        auto json = fc::json::to_string(v);
+        auto json = abis.binary_to_json(acttype, act.data, exec_ctx);
         try {
             const auto& value = bsoncxx::from_json(json);
             act_doc.append(kvp("data", value));
@@ -333,11 +402,7 @@ void
 mongo_db_plugin_impl::process_block(const signed_block& block, std::deque<transaction_trace_ptr>& traces, write_context& write_ctx) {
     try {
         _process_block(block, traces, write_ctx);
-
-        for(auto& ptrx : block.transactions) {
-            auto trx = ptrx.trx.get_transaction();
-            interpreter.process_trx(trx, write_ctx);
-        }
+        interpreter.process_block(block, write_ctx);
     }
     catch(fc::exception& e) {
         elog("FC Exception while processing block ${e}", ("e", e.to_string()));
@@ -648,16 +713,31 @@ mongo_db_plugin_impl::init() {
         fungibles.create_index(bsoncxx::from_json(R"xxx({ "sym_id" : 1 })xxx"));
     }
 
-    write_ctx_.blocks_collection    = mongo_db[blocks_col];
-    write_ctx_.trxs_collection      = mongo_db[trxs_col];
-    write_ctx_.actions_collection   = mongo_db[actions_col];
-    write_ctx_.domains_collection   = mongo_db[domains_col];
-    write_ctx_.tokens_collection    = mongo_db[tokens_col];
-    write_ctx_.groups_collection    = mongo_db[groups_col];
-    write_ctx_.fungibles_collection = mongo_db[fungibles_col];
+    // each collection is written by its own client when they're committed concurrently
+    auto db = [this](int i) {
+        if(writer_threads == 0) {
+            return mongo_db;
+        }
+        if(writer_conns.empty()) {
+            for(auto j = 0; j < 7; j++) {
+                writer_conns.emplace_back(mongo_uri);
+            }
+        }
+        return writer_conns[i][mongo_db.name()];
+    };
+
+    write_ctx_.set_writer_threads(writer_threads);
+    write_ctx_.blocks_collection    = db(0)[blocks_col];
+    write_ctx_.trxs_collection      = db(1)[trxs_col];
+    write_ctx_.actions_collection   = db(2)[actions_col];
+    write_ctx_.domains_collection   = db(3)[domains_col];
+    write_ctx_.tokens_collection    = db(4)[tokens_col];
+    write_ctx_.groups_collection    = db(5)[groups_col];
+    write_ctx_.fungibles_collection = db(6)[fungibles_col];
 
     // initilize evt interpreter
     interpreter.initialize_db(mongo_db);
+    interpreter.set_threads(interpreter_threads);
 
     auto& chain_plug = app().get_plugin<chain_plugin>();
     auto& chain      = chain_plug.chain();
@@ -726,10 +806,24 @@ mongo_db_plugin::enabled() const {
     return my_->configured;
 }
 
+mongo_db_plugin::queue_metrics
+mongo_db_plugin::get_queue_metrics() const {
+    auto m = queue_metrics();
+    m.queued_blocks    = my_->queued_blocks.load(std::memory_order_relaxed);
+    m.processed_blocks = my_->processed_blocks.load(std::memory_order_relaxed);
+    m.queue_size       = my_->queue_size;
+    return m;
+}
+
 void
 mongo_db_plugin::set_program_options(options_description& cli, options_description& cfg) {
     cfg.add_options()
         ("mongodb-queue-size,q", bpo::value<uint>()->default_value(5120), "The queue size between evtd and MongoDB plugin thread.")
+        ("mongodb-bulk-size", bpo::value<uint>()->default_value(10240), "The max number of writes in bulk writes, which may span multiple blocks.")
+        ("mongodb-writer-threads", bpo::value<uint>()->default_value(0), "The number of threads committing bulk writes of collections concurrently, 0 to commit them on the consume thread.")
+        ("mongodb-interpreter-threads", bpo::value<uint>()->default_value(0), "The number of threads interpreting actions of blocks into domains, tokens, groups and fungibles, 0 to interpret them on the consume thread.")
+        ("mongodb-spill", bpo::value<bool>()->default_value(true), "Spill blocks into a file in data dir when the queue is full instead of blocking the chain until it's consumed.")
+        ("mongodb-relaxed-sync", bpo::bool_switch()->default_value(false), "Write without acknowledgement while syncing blocks produced more than one minute ago, errors of writes are not reported then.")
         ("mongodb-uri,m", bpo::value<std::string>(), "MongoDB URI connection string, see: https://docs.mongodb.com/master/reference/connection-string/."
                                                      " If not specified then plugin is disabled. Default database 'EVT' is used if not specified in URI.")
         ;
@@ -760,6 +854,14 @@ mongo_db_plugin::plugin_initialize(const variables_map& options) {
             auto size       = options.at("mongodb-queue-size").as<uint>();
             my_->queue_size = size;
         }
+        if(memory_accounting::instance().enabled()) {
+            my_->mem_blocks = &memory_accounting::instance().counter("mongodb_queue");
+        }
+        my_->bulk_size           = options.at("mongodb-bulk-size").as<uint>();
+        my_->writer_threads      = options.at("mongodb-writer-threads").as<uint>();
+        my_->interpreter_threads = options.at("mongodb-interpreter-threads").as<uint>();
+        my_->relaxed_sync        = options.at("mongodb-relaxed-sync").as<bool>();
+        EVT_ASSERT(my_->bulk_size > 0, chain::plugin_config_exception, "mongodb-bulk-size must be greater than 0");
 
         std::string uri_str = options.at("mongodb-uri").as<std::string>();
         ilog("connecting to ${u}", ("u", uri_str));
@@ -778,6 +880,14 @@ mongo_db_plugin::plugin_initialize(const variables_map& options) {
             my_->wipe_database();
         }
 
+        auto spill_file = app().data_dir() / "mongodb-spill.dat";
+        if(my_->wipe_database_on_startup) {
+            fc::remove(spill_file);
+        }
+        if(options.at("mongodb-spill").as<bool>()) {
+            my_->spill.emplace(spill_file);
+        }
+
         my_->init();
 
         my_->consume_thread_ = std::thread([this] { my_->consume_queues(); });
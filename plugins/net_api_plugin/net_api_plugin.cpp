@@ -5,6 +5,7 @@
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/transaction.hpp>
 #include <evt/net_api_plugin/net_api_plugin.hpp>
+#include <evt/bnet_plugin/bnet_plugin.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
@@ -81,9 +82,21 @@ net_api_plugin::plugin_startup() {
              INVOKE_R_R(net_mgr, status, std::string), 201),
         CALL(net, net_mgr, connections,
              INVOKE_R_V(net_mgr, connections), 201),
+        CALL(net, net_mgr, stats,
+             INVOKE_R_V(net_mgr, stats), 201),
         //   CALL(net, net_mgr, open,
         //        INVOKE_V_R(net_mgr, open, std::string), 200),
     });
+
+    // bnet is optional, its sessions are listed only if it's enabled as well
+    auto bnet_mgr = app().find_plugin<bnet_plugin>();
+    if(bnet_mgr != nullptr && bnet_mgr->get_state() != abstract_plugin::registered) {
+        auto& bnet = *bnet_mgr;
+        app().get_plugin<http_plugin>().add_api({
+            CALL(net, bnet, bnet_sessions,
+                 INVOKE_R_V(bnet, sessions), 201),
+        });
+    }
 }
 
 void
@@ -17,6 +17,26 @@ struct connection_status {
     handshake_message last_handshake;
 };
 
+// counters of one connection since it's created, latencies are counted in the buckets of
+// less than 1, 5, 10, 50, 100, 500, 1000 ms and the one of longer latencies
+struct connection_stats {
+    string                     peer;
+    bool                       connected            = false;
+    uint64_t                   bytes_in             = 0;
+    uint64_t                   bytes_out            = 0;
+    std::map<string, uint64_t> messages_in;   // by type of message
+    std::map<string, uint64_t> messages_out;
+    uint32_t                   write_queue_size     = 0;  // bytes waiting to be written
+    uint32_t                   max_write_queue_size = 0;
+    uint64_t                   sync_blocks_in       = 0;
+    uint64_t                   sync_blocks_out      = 0;
+    int64_t                    sync_chunk_time_us   = 0;  // average time this peer serves one sync chunk to us
+    vector<uint64_t>           write_latency_ms;
+    int64_t                    max_write_latency_us = 0;
+    vector<uint64_t>           rtt_ms;  // round-trip time measured by time messages
+    int64_t                    last_rtt_us          = 0;
+};
+
 class net_plugin : public appbase::plugin<net_plugin> {
 public:
     net_plugin();
@@ -36,6 +56,7 @@ public:
     string                      disconnect(const string& endpoint);
     optional<connection_status> status(const string& endpoint) const;
     vector<connection_status>   connections() const;
+    vector<connection_stats>    stats() const;
 
     size_t num_peers() const;
 
@@ -46,3 +67,5 @@ private:
 }  // namespace evt
 
 FC_REFLECT(evt::connection_status, (peer)(connecting)(syncing)(last_handshake))
+FC_REFLECT(evt::connection_stats, (peer)(connected)(bytes_in)(bytes_out)(messages_in)(messages_out)(write_queue_size)(max_write_queue_size)
+           (sync_blocks_in)(sync_blocks_out)(sync_chunk_time_us)(write_latency_ms)(max_write_latency_us)(rtt_ms)(last_rtt_us))
@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <chrono>
+#include <fc/bloom_filter.hpp>
 #include <evt/chain/block.hpp>
 #include <evt/chain/types.hpp>
 
@@ -161,6 +162,98 @@ struct sync_request_message {
     uint32_t end_block;
 };
 
+enum class trx_batch_compression : uint8_t {
+    none = 0,
+    zstd,
+    zstd_dict  // with the dictionary of node, see `evt/chain/zstd_dictionary.hpp`
+};
+
+/**
+ * Transactions relayed together in one message, `data` is the packed vector
+ * of packed_transaction and is compressed as a whole if `compression` is set.
+ * Only sent to the peers of protocol version proto_trx_batch or later.
+ */
+struct transaction_batch_message {
+    uint8_t compression = (uint8_t)trx_batch_compression::none;
+    bytes   data;
+};
+
+/**
+ * Block relayed with the short ids of its transactions instead of themselves,
+ * receivers rebuild it from the transactions already relayed to them and
+ * request the missing ones by compact_block_request_message.
+ * Only sent to the peers of protocol version proto_compact_block or later.
+ */
+struct compact_block_receipt : transaction_receipt_header {
+    uint64_t                     short_id = 0;  // first 8 bytes of transaction id
+    optional<packed_transaction> trx;           // prefilled if it's never relayed, i.e. suspend transactions
+};
+
+struct compact_block_message {
+    signed_block_header           header;
+    vector<compact_block_receipt> receipts;
+    extensions_type               block_extensions;
+};
+
+struct compact_block_request_message {
+    block_id_type    id;
+    vector<uint32_t> indexes;  // indexes of receipts whose transactions are missing
+};
+
+struct compact_block_response_message {
+    block_id_type              id;
+    vector<packed_transaction> trxs;  // in the order of indexes requested, empty if block is unknown
+};
+
+/**
+ * Bloom filter of the ids of transactions the peer has seen lately, they're not
+ * relayed to it. Only sent to the peers of protocol version proto_trx_filter or later.
+ */
+struct transaction_filter_message {
+    fc::bloom_filter filter;
+};
+
+/**
+ * Full snapshot a peer serves for warp sync, it's split into chunks of `chunk_size`
+ * bytes and is identified by the digest of the packed manifest, which is what
+ * producers publish and joining nodes are configured with.
+ */
+struct snapshot_manifest {
+    uint32_t           head_block_num = 0;
+    block_id_type      head_block_id;
+    uint64_t           size       = 0;
+    uint32_t           chunk_size = 0;
+    vector<fc::sha256> chunk_digests;
+};
+
+/**
+ * Snapshots newer than the head of the peer, sent once after handshake.
+ * Only sent to the peers of protocol version proto_snapshot_sync or later.
+ */
+struct snapshot_list_message {
+    vector<snapshot_manifest> snapshots;
+};
+
+struct snapshot_chunk_request_message {
+    fc::sha256 digest;  // of manifest
+    uint32_t   index = 0;
+};
+
+struct snapshot_chunk_message {
+    fc::sha256 digest;
+    uint32_t   index = 0;
+    bytes      data;  // empty if the snapshot is not served anymore
+};
+
+/**
+ * First block the peer keeps in block log, the older ones are pruned or it's started from
+ * a snapshot, so they cannot be synced from it. Sent after handshake and in reply to the
+ * sync requests before it. Only sent to the peers of protocol version proto_block_range or later.
+ */
+struct block_range_message {
+    uint32_t first_block_num = 0;
+};
+
 using net_message = static_variant<handshake_message,
                                    chain_size_message,
                                    go_away_message,
@@ -168,8 +261,17 @@ using net_message = static_variant<handshake_message,
                                    notice_message,
                                    request_message,
                                    sync_request_message,
-                                   signed_block,         // which = 7
-                                   packed_transaction>;  // which = 8
+                                   signed_block,                     // which = 7
+                                   packed_transaction,               // which = 8
+                                   transaction_batch_message,        // which = 9
+                                   compact_block_message,            // which = 10
+                                   compact_block_request_message,    // which = 11
+                                   compact_block_response_message,   // which = 12
+                                   transaction_filter_message,       // which = 13
+                                   snapshot_list_message,            // which = 14
+                                   snapshot_chunk_request_message,   // which = 15
+                                   snapshot_chunk_message,           // which = 16
+                                   block_range_message>;             // which = 17
 
 }  // namespace evt
 
@@ -183,6 +285,17 @@ FC_REFLECT(evt::time_message, (org)(rec)(xmt)(dst));
 FC_REFLECT(evt::notice_message, (known_trx)(known_blocks));
 FC_REFLECT(evt::request_message, (req_trx)(req_blocks));
 FC_REFLECT(evt::sync_request_message, (start_block)(end_block));
+FC_REFLECT(evt::transaction_batch_message, (compression)(data));
+FC_REFLECT_DERIVED(evt::compact_block_receipt, (evt::chain::transaction_receipt_header), (short_id)(trx));
+FC_REFLECT(evt::compact_block_message, (header)(receipts)(block_extensions));
+FC_REFLECT(evt::compact_block_request_message, (id)(indexes));
+FC_REFLECT(evt::compact_block_response_message, (id)(trxs));
+FC_REFLECT(evt::transaction_filter_message, (filter));
+FC_REFLECT(evt::snapshot_manifest, (head_block_num)(head_block_id)(size)(chunk_size)(chunk_digests));
+FC_REFLECT(evt::snapshot_list_message, (snapshots));
+FC_REFLECT(evt::snapshot_chunk_request_message, (digest)(index));
+FC_REFLECT(evt::snapshot_chunk_message, (digest)(index)(data));
+FC_REFLECT(evt::block_range_message, (first_block_num));
 
 /**
  *
@@ -5,11 +5,22 @@
 #include <evt/net_plugin/net_plugin.hpp>
 #include <evt/net_plugin/protocol.hpp>
 
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+#include <boost/filesystem.hpp>
+
 #include <boost/asio/read.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <zstd.h>
 
 #include <fc/network/message_buffer.hpp>
 #include <fc/network/ip.hpp>
@@ -24,11 +35,19 @@
 #include <evt/chain/controller.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/block.hpp>
+#include <evt/chain/merkle.hpp>
 #include <evt/chain/plugin_interface.hpp>
+#include <evt/chain/app_lanes.hpp>
+#include <evt/chain/zstd_dictionary.hpp>
 #include <evt/chain/multi_index_includes.hpp>
+#include <evt/chain/pool_allocator.hpp>
+#include <evt/chain/memory_accounting.hpp>
 #include <evt/producer_plugin/producer_plugin.hpp>
+#include <evt/utilities/thread_placement.hpp>
 
 using namespace evt::chain::plugin_interface::compat;
+using evt::chain::plugin_interface::app_lane;
+using evt::chain::plugin_interface::post_lane;
 
 namespace fc {
 extern std::unordered_map<std::string, logger>& get_logger_map();
@@ -47,11 +66,17 @@ using boost::multi_index_container;
 using fc::time_point;
 using fc::time_point_sec;
 using evt::chain::transaction_id_type;
+using evt::chain::memory_accounting;
+
+namespace bfs = boost::filesystem;
 
 class connection;
 
 class sync_manager;
+class rolling_trx_filter;
+class trx_prefilter;
 class dispatch_manager;
+class snapshot_sync_manager;
 
 using connection_ptr  = std::shared_ptr<connection>;
 using connection_wptr = std::weak_ptr<connection>;
@@ -59,15 +84,25 @@ using connection_wptr = std::weak_ptr<connection>;
 using socket_ptr = std::shared_ptr<tcp::socket>;
 using io_work_t  = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
 
+// message decoded on the strand of its connection, then handled on app thread
+struct decoded_message {
+    net_message   msg;
+    block_id_type blk_id;  // id and number are only set for blocks, hashed along with decoding
+    uint32_t      blk_num = 0;
+};
+
 struct node_transaction_state {
     transaction_id_type           id;
     time_point_sec                expires;         /// time after which this may be purged.
     uint32_t                      block_num = 0;   /// block transaction was included in
     std::shared_ptr<vector<char>> serialized_txn;  /// the received raw bundle
+
+    uint64_t short_id() const { return id._hash[0]; }  /// used by compact blocks
 };
 
 struct by_expiry;
 struct by_block_num;
+struct by_short_id;
 
 struct sha256_less {
     bool operator()(const sha256& lhs, const sha256& rhs) const {
@@ -93,9 +128,21 @@ typedef multi_index_container<
             tag<by_block_num>,
             member<node_transaction_state,
                    uint32_t,
-                   &node_transaction_state::block_num>>>>
+                   &node_transaction_state::block_num>>,
+        ordered_non_unique<
+            tag<by_short_id>,
+            const_mem_fun<node_transaction_state,
+                          uint64_t,
+                          &node_transaction_state::short_id>>>>
     node_transaction_index;
 
+// compact block received whose missing transactions are requested from the peer
+struct pending_compact_block {
+    block_id_type    id;
+    signed_block_ptr block;
+    vector<uint32_t> missing;
+};
+
 class net_plugin_impl {
 public:
     unique_ptr<tcp::acceptor> acceptor;
@@ -124,8 +171,9 @@ public:
 
     std::set<connection_ptr>     connections;
     bool                         done = false;
-    unique_ptr<sync_manager>     sync_master;
-    unique_ptr<dispatch_manager> dispatcher;
+    unique_ptr<sync_manager>          sync_master;
+    unique_ptr<dispatch_manager>      dispatcher;
+    unique_ptr<snapshot_sync_manager> snapshot_sync;
 
     unique_ptr<boost::asio::steady_timer> connector_check;
     unique_ptr<boost::asio::steady_timer> transaction_check;
@@ -155,7 +203,25 @@ public:
 
     channels::transaction_ack::channel_type::handle incoming_transaction_ack_subscription;
 
-    optional<std::thread>                    server_thread;
+    boost::asio::steady_timer::duration   trx_batch_period;    // zero disables batching
+    uint32_t                              trx_batch_size     = 0;
+    bool                                  trx_batch_compress = false;
+    unique_ptr<boost::asio::steady_timer> trx_batch_timer;
+    bool                                  trx_batch_timer_running = false;
+
+    bool     use_compact_blocks   = false;
+    uint32_t relay_next_producers = 0;  // connections of these upcoming producers get new blocks first
+
+    unique_ptr<rolling_trx_filter>        seen_trxs;  // accepted and relayed, sent to peers periodically
+    uint64_t                              seen_trxs_sent = 0;  // inserted count of seen_trxs when it was sent last time
+    boost::asio::steady_timer::duration   trx_filter_period;   // zero disables exchanging filters
+    unique_ptr<boost::asio::steady_timer> trx_filter_timer;
+    unique_ptr<boost::asio::steady_timer> snapshot_timer;
+
+    unique_ptr<trx_prefilter> prefilter;  // null if relayed transactions are not prefiltered
+
+    uint16_t                                 thread_pool_size = 0;  // net-threads
+    std::vector<std::thread>                 server_threads;
     std::shared_ptr<boost::asio::io_context> server_ioc;
     optional<io_work_t>                      server_ioc_work;
 
@@ -165,15 +231,23 @@ public:
     void start_listen_loop();
     void start_read_message(const connection_ptr& c);
 
-    /** \brief Process the next message from the pending message buffer
+    /** \brief Decode the messages read into the pending message buffer
+     *
+     * Runs on the strand of connection, each complete message in the
+     * pending_message_buffer is unpacked into `msgs`. Returns the error
+     * met by decoding, the messages before it are still returned.
+     */
+    string decode_messages(const connection_ptr& conn, std::size_t bytes_transferred, vector<decoded_message>& msgs);
+    // false if the relayed transaction is dropped by prefilter, runs on the strand of connection
+    bool prefilter_trx(const connection_ptr& conn, const packed_transaction& trx);
+    void forget_prefiltered(const transaction_id_type& id);
+
+    /** \brief Process the next message decoded from pending message buffer
      *
-     * Process the next message from the pending_message_buffer.
-     * message_length is the already determined length of the data
-     * part of the message that will handle the message.
      * Returns true is successful. Returns false if an error was
-     * encountered unpacking or processing the message.
+     * encountered processing the message.
      */
-    bool process_next_message(const connection_ptr& conn, uint32_t message_length);
+    bool process_next_message(const connection_ptr& conn, decoded_message& m);
 
     void   close(const connection_ptr& c);
     size_t count_open_sockets() const;
@@ -182,6 +256,7 @@ public:
     void send_transaction_to_all(const std::shared_ptr<std::vector<char>>& send_buffer, VerifierFunc verify);
 
     void accepted_block(const block_state_ptr&);
+    void irreversible_block(const block_state_ptr&);
     void transaction_ack(const std::pair<fc::exception_ptr, transaction_metadata_ptr>&);
 
     bool is_valid(const handshake_message& msg);
@@ -211,9 +286,26 @@ public:
     void handle_message(const connection_ptr& c, const signed_block_ptr& msg);
     void handle_message(const connection_ptr& c, const packed_transaction& msg) = delete;  // packed_transaction_ptr overload used instead
     void handle_message(const connection_ptr& c, const packed_transaction_ptr& msg);
+    // batches are expanded when decoded, this is only reached if one is visited directly
+    void handle_message(const connection_ptr& c, const transaction_batch_message& msg);
+    void handle_message(const connection_ptr& c, const compact_block_message& msg);
+    void handle_message(const connection_ptr& c, const compact_block_request_message& msg);
+    void handle_message(const connection_ptr& c, const compact_block_response_message& msg);
+    void handle_message(const connection_ptr& c, const transaction_filter_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_list_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_chunk_request_message& msg);
+    void handle_message(const connection_ptr& c, const snapshot_chunk_message& msg);
+    void handle_message(const connection_ptr& c, const block_range_message& msg);
+
+    // block is checked against the transaction merkle root of its header before it's applied
+    void accept_compact_block(const connection_ptr& c, const pending_compact_block& pending);
+    void request_full_block(const connection_ptr& c, const block_id_type& id);
 
     void start_conn_timer(boost::asio::steady_timer::duration du, std::weak_ptr<connection> from_connection);
     void start_txn_timer();
+    void start_trx_batch_timer();
+    void start_trx_filter_timer();
+    void start_snapshot_timer();
     void start_monitors();
 
     void expire_txns();
@@ -306,10 +398,36 @@ constexpr auto                              def_conn_retry_wait          = 30;
 constexpr auto                              def_txn_expire_wait          = std::chrono::seconds(3);
 constexpr auto                              def_resp_expected_wait       = std::chrono::seconds(5);
 constexpr auto                              def_sync_fetch_span          = 100;
+constexpr auto                              def_sync_max_peers           = 4;
+constexpr auto                              def_sync_chunks_per_peer     = 2;    // outstanding chunks of one peer, if it pipelines requests
+constexpr auto                              def_sync_window_factor       = 2;    // blocks requested ahead are at most span * peers * factor
+constexpr auto                              def_sync_slow_factor         = 3;    // peer is slow if it's this times slower than the fastest
+constexpr auto                              def_sync_rebalance_ms        = 500;
+constexpr auto                              def_trx_filter_size          = 10000;  // ids kept in one generation of filter
+constexpr auto                              def_trx_filter_fpp           = 0.001;
+constexpr auto                              def_trx_filter_max_hashes    = 128;
+constexpr auto                              def_trx_filter_ms            = 1000;
+constexpr auto                              def_trx_prefilter_size       = 100000;  // ids of recent transactions kept by prefilter
+constexpr auto                              def_net_threads              = 2;
+constexpr auto                              def_trx_batch_ms             = 5;
+constexpr auto                              def_trx_batch_size           = 64;
+constexpr auto                              def_trx_batch_max_bytes      = 1024 * 1024;
+constexpr auto                              def_trx_batch_compress_min   = 1024;  // smaller batches are not compressed
+constexpr auto                              def_trx_batch_compress_level = 1;
+constexpr auto                              def_snapshot_chunk_size      = 1024 * 1024;
+constexpr auto                              def_snapshot_chunks_per_peer = 4;   // outstanding chunk requests to one peer
+constexpr auto                              def_snapshot_advertised      = 2;   // newest snapshots listed to one peer
+constexpr auto                              def_snapshot_tick            = std::chrono::seconds(5);
+constexpr auto                              def_snapshot_refresh_ticks   = 12;  // snapshots dir is scanned every minute
+constexpr auto                              def_snapshot_chunk_timeout   = fc::seconds(30);
 
 constexpr auto     message_header_size = 4;
 constexpr uint32_t signed_block_which = 7;        // see protocol net_message
 constexpr uint32_t packed_transaction_which = 8;  // see protocol net_message
+constexpr uint32_t transaction_batch_which = 9;   // see protocol net_message
+constexpr uint32_t compact_block_which = 10;      // see protocol net_message
+constexpr uint32_t compact_block_response_which = 12;  // see protocol net_message
+constexpr uint32_t transaction_filter_which = 13;  // see protocol net_message
 
 /**
  *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -331,28 +449,310 @@ constexpr uint16_t net_version_range = 106;
  */
 constexpr uint16_t proto_base          = 0;
 constexpr uint16_t proto_explicit_sync = 1;
+constexpr uint16_t proto_trx_batch     = 2;  // transaction_batch_message is understood
+constexpr uint16_t proto_compact_block = 3;  // compact_block_message is understood
+constexpr uint16_t proto_pipelined_sync = 4;  // sync requests are queued instead of replacing the current one
+constexpr uint16_t proto_trx_filter     = 5;  // transaction_filter_message is understood
+constexpr uint16_t proto_snapshot_sync  = 6;  // snapshots are served for warp sync
+constexpr uint16_t proto_block_range    = 7;  // block_range_message is understood
+constexpr uint16_t proto_trx_batch_dict = 8;  // transaction batches can be compressed with zstd dictionary
+
+constexpr uint16_t net_version = proto_trx_batch_dict;
+
+/**
+ *  Objects of the frequent messages and the send buffers are made and freed for each message
+ *  relayed, they're reused from pools instead. Buffers larger than max_pooled_buffer_size,
+ *  i.e. the ones of blocks, are not kept.
+ */
+constexpr auto max_pooled_objects     = 4 * 1024;
+constexpr auto max_pooled_buffers     = 4 * 1024;
+constexpr auto max_pooled_buffer_size = 64 * 1024;
+
+class send_buffer_pool : public std::enable_shared_from_this<send_buffer_pool> {
+public:
+    send_buffer_pool()
+        : ctrl_pool_(std::make_shared<block_pool>(max_pooled_buffers)) {}
+
+    ~send_buffer_pool() {
+        for(auto b : free_) {
+            delete b;
+        }
+    }
+
+public:
+    std::shared_ptr<vector<char>>
+    acquire(size_t size) {
+        auto b = (vector<char>*)nullptr;
+        {
+            auto lock = std::lock_guard<std::mutex>(mutex_);
+            if(!free_.empty()) {
+                b = free_.back();
+                free_.pop_back();
+            }
+        }
+        if(!b) {
+            b = new vector<char>();
+        }
+        b->resize(size);
 
-constexpr uint16_t net_version = proto_explicit_sync;
+        // deleter keeps pool alive, buffers can be freed after net_plugin on write completions
+        auto self = shared_from_this();
+        return std::shared_ptr<vector<char>>(b, [self](vector<char>* b) { self->release(b); }, pool_allocator<char>(ctrl_pool_));
+    }
 
-struct transaction_state {
-    transaction_id_type id;
-    uint32_t            block_num = 0;  ///< the block number the transaction was included in
-    time_point_sec      expires;
+private:
+    void
+    release(vector<char>* b) {
+        if(b->capacity() <= max_pooled_buffer_size) {
+            auto lock = std::lock_guard<std::mutex>(mutex_);
+            if(free_.size() < max_pooled_buffers) {
+                free_.emplace_back(b);
+                return;
+            }
+        }
+        delete b;
+    }
+
+private:
+    std::mutex                  mutex_;
+    vector<vector<char>*>       free_;
+    std::shared_ptr<block_pool> ctrl_pool_;  // control blocks of shared pointers
 };
 
-typedef multi_index_container<
-    transaction_state,
-    indexed_by<
-        ordered_unique<tag<by_id>, member<transaction_state, transaction_id_type, &transaction_state::id>, sha256_less>,
-        ordered_non_unique<tag<by_expiry>, member<transaction_state, fc::time_point_sec, &transaction_state::expires>>,
-        ordered_non_unique<
-            tag<by_block_num>,
-            member<transaction_state,
-                   uint32_t,
-                   &transaction_state::block_num>>>
+static std::shared_ptr<vector<char>>
+make_send_buffer(size_t size) {
+    static auto pool = std::make_shared<send_buffer_pool>();
+    return pool->acquire(size);
+}
+
+template<typename T>
+static pool_allocator<T>&
+get_message_allocator() {
+    static auto allocator = pool_allocator<T>(std::make_shared<block_pool>(max_pooled_objects));
+    return allocator;
+}
+
+template<typename T, typename... Args>
+static std::shared_ptr<T>
+make_message(Args&&... args) {
+    return std::allocate_shared<T>(get_message_allocator<T>(), std::forward<Args>(args)...);
+}
+
+/**
+ *  Ids of transactions kept in two generations of bloom filters, the older one is dropped once
+ *  the newer is full. At least `capacity` latest ids are remembered with bounded memory, the
+ *  filters are only allocated on the first insertion.
+ */
+class rolling_trx_filter {
+public:
+    explicit rolling_trx_filter(uint32_t capacity)
+        : capacity_(capacity) {}
+
+public:
+    void
+    insert(const transaction_id_type& id) {
+        if(!current_ || current_.element_count() >= capacity_) {
+            previous_ = std::move(current_);
+            current_  = make_filter();
+        }
+        current_.insert(id.data(), id.data_size());
+        inserted_++;
+    }
+
+    bool
+    contains(const transaction_id_type& id) const {
+        return (!!current_ && current_.contains(id.data(), id.data_size()))
+            || (!!previous_ && previous_.contains(id.data(), id.data_size()));
+    }
+
+    // union of both generations
+    fc::bloom_filter
+    snapshot() const {
+        auto f = current_;
+        if(!!previous_) {
+            f |= previous_;
+        }
+        return f;
+    }
 
-    >
-    transaction_state_index;
+    void
+    clear() {
+        current_  = fc::bloom_filter();
+        previous_ = fc::bloom_filter();
+    }
+
+    uint64_t inserted() const { return inserted_; }
+
+private:
+    fc::bloom_filter
+    make_filter() const {
+        auto p = fc::bloom_parameters();
+        p.projected_element_count    = capacity_;
+        p.false_positive_probability = def_trx_filter_fpp;
+        p.compute_optimal_parameters();
+        return fc::bloom_filter(p);
+    }
+
+private:
+    uint32_t         capacity_;
+    uint64_t         inserted_ = 0;
+    fc::bloom_filter current_;
+    fc::bloom_filter previous_;
+};
+
+// filters of peers are checked before used, lookups index the table by the table size
+static bool
+valid_trx_filter(const fc::bloom_filter& f) {
+    return f.table_size_ > 0 && !f.salt_.empty() && f.salt_.size() <= def_trx_filter_max_hashes
+        && f.raw_table_size_ == f.bit_table_.size() && f.table_size_ <= f.raw_table_size_ * fc::bits_per_char;
+}
+
+/**
+ *  Cheap checks of relayed transactions done on the strand of connection before they are posted
+ *  to the app thread. Only the transactions the chain would surely reject are dropped: the state
+ *  used here is either copied from the chain when blocks are applied or only grows, it's unknown
+ *  state which lets the transaction pass.
+ */
+class trx_prefilter {
+public:
+    trx_prefilter()
+        : ref_blocks_(new std::atomic<uint64_t>[ref_blocks_size]) {
+        for(auto i = 0u; i < ref_blocks_size; i++) {
+            ref_blocks_[i] = 0;
+        }
+    }
+
+public:
+    // called on app thread, the limits of global config are copied as well
+    void
+    accepted_block(const controller& cc, const block_state_ptr& b) {
+        auto& conf = cc.get_global_properties().configuration;
+        head_num_          = b->block_num;
+        max_trx_lifetime_  = conf.max_transaction_lifetime;
+        max_trx_net_usage_ = conf.max_transaction_net_usage;
+    }
+
+    // irreversible blocks are the only ones whose ids never change
+    void
+    irreversible_block(const block_state_ptr& b) {
+        ref_blocks_[(uint16_t)b->block_num] = ((uint64_t)b->block_num << 32) | (uint32_t)b->id._hash[1];
+    }
+
+    // returns the reason if the transaction should be dropped, the id is remembered if it passes
+    const char*
+    check(const packed_transaction& ptrx) {
+        auto& trx = ptrx.get_transaction();
+        auto  now = fc::time_point::now();
+
+        if(trx.actions.empty()) {
+            return "no actions";
+        }
+        if(fc::time_point(trx.expiration) < now) {
+            return "expired";
+        }
+        // pending block time may be one block interval ahead
+        if(fc::time_point(trx.expiration) > now + fc::seconds(max_trx_lifetime_) + fc::microseconds(config::block_interval_us)) {
+            return "expiration too far";
+        }
+        if(ptrx.get_unprunable_size() + ptrx.get_prunable_size() > max_trx_net_usage_) {
+            return "too large";
+        }
+        if(!check_tapos(trx)) {
+            return "reference block mismatch";
+        }
+        if(trx.payer.type() == address::reserved_t) {
+            return "reserved payer";
+        }
+
+        auto& sigs = ptrx.get_signatures();
+        if(trx.payer.type() == address::public_key_t && sigs.empty()) {
+            return "payer not signed";
+        }
+        if(sigs.size() > 1) {
+            auto sorted = small_vector<const signature_type*, 4>();
+            for(auto& s : sigs) {
+                sorted.push_back(&s);
+            }
+            std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return *a < *b; });
+            for(auto i = 1u; i < sorted.size(); i++) {
+                if(*sorted[i] == *sorted[i - 1]) {
+                    return "duplicate signatures";
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire(now);
+        if(!trxs_.emplace(recent_trx{ptrx.id(), ptrx.expiration()}).second) {
+            return "duplicate";
+        }
+        return nullptr;
+    }
+
+    // remembers the transaction sent from here so that ones relayed back are dropped
+    void
+    insert(const transaction_id_type& id, fc::time_point_sec expires) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trxs_.emplace(recent_trx{id, expires});
+    }
+
+    // transaction passed but dropped later without being checked by chain, lets it pass next time
+    void
+    forget(const transaction_id_type& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trxs_.erase(id);
+    }
+
+private:
+    struct recent_trx {
+        transaction_id_type id;
+        fc::time_point_sec  expires;
+    };
+
+    using recent_trx_index = multi_index_container<
+        recent_trx,
+        indexed_by<
+            ordered_unique<
+                tag<by_id>,
+                member<recent_trx, transaction_id_type, &recent_trx::id>,
+                sha256_less>,
+            ordered_non_unique<
+                tag<by_expiry>,
+                member<recent_trx, fc::time_point_sec, &recent_trx::expires>>>>;
+
+    enum { ref_blocks_size = 0x10000 };
+
+private:
+    bool
+    check_tapos(const transaction& trx) const {
+        auto ref = ref_blocks_[trx.ref_block_num].load();
+        auto num = (uint32_t)(ref >> 32);
+        // unknown, or block of the same slot may be replaced by a newer one in chain
+        if(num == 0 || head_num_ >= num + ref_blocks_size) {
+            return true;
+        }
+        return (uint32_t)ref == trx.ref_block_prefix;
+    }
+
+    // expired ones are removed, as well as the earliest expiring ones if there are too many
+    void
+    expire(const fc::time_point& now) {
+        auto& idx = trxs_.get<by_expiry>();
+        idx.erase(idx.begin(), idx.upper_bound(fc::time_point_sec(now)));
+        while(trxs_.size() >= def_trx_prefilter_size) {
+            idx.erase(idx.begin());
+        }
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> ref_blocks_;  // (block_num << 32) | ref_block_prefix of irreversible blocks
+    std::atomic<uint32_t>                    head_num_{0};
+    std::atomic<uint32_t>                    max_trx_lifetime_{config::default_max_trx_lifetime};
+    std::atomic<uint32_t>                    max_trx_net_usage_{config::default_max_transaction_net_usage};
+
+    std::mutex       mutex_;
+    recent_trx_index trxs_;
+};
 
 /**
     *
@@ -376,9 +776,6 @@ struct update_block_num {
     void operator()(node_transaction_state& nts) {
         nts.block_num = new_bnum;
     }
-    void operator()(transaction_state& ts) {
-        ts.block_num = new_bnum;
-    }
 };
 
 /**
@@ -482,6 +879,39 @@ private:
 
 };  // queued_buffer
 
+// counts of latencies in the buckets of less than 1, 5, 10, 50, 100, 500, 1000 ms and longer
+struct latency_histogram {
+    static constexpr auto bounds_ms = std::array<int64_t, 7>{1, 5, 10, 50, 100, 500, 1000};
+
+    std::array<uint64_t, bounds_ms.size() + 1> counts{};
+    fc::microseconds                           last;
+    fc::microseconds                           max;
+
+    void
+    add(const fc::microseconds& latency) {
+        auto i = 0u;
+        while(i < bounds_ms.size() && latency.count() >= bounds_ms[i] * 1000) {
+            i++;
+        }
+        counts[i]++;
+        last = latency;
+        max  = std::max(max, latency);
+    }
+};
+
+// counters of connection kept for net_plugin::stats, all are updated on app thread
+struct connection_counters {
+    uint64_t          bytes_in             = 0;
+    uint64_t          bytes_out            = 0;
+    vector<uint64_t>  msgs_in              = vector<uint64_t>(net_message::count());  // by which of net_message
+    vector<uint64_t>  msgs_out             = vector<uint64_t>(net_message::count());
+    uint32_t          max_write_queue_size = 0;
+    uint64_t          sync_blocks_in       = 0;
+    uint64_t          sync_blocks_out      = 0;
+    latency_histogram write_latency;
+    latency_histogram rtt;
+};
+
 class connection : public std::enable_shared_from_this<connection> {
 public:
     explicit connection(string endpoint);
@@ -491,11 +921,17 @@ public:
     void initialize();
 
     peer_block_state_index                   blk_state;
-    transaction_state_index                  trx_state;
+    rolling_trx_filter                       known_trxs;  // relayed to or received from this peer
+    optional<fc::bloom_filter>               peer_trxs;   // seen by this peer, see transaction_filter_message
+    uint32_t                                 peer_first_block = 1;  // blocks before it are not kept by this peer
     optional<sync_state>                     peer_requested;  // this peer is requesting info from us
+    std::deque<sync_state>                   peer_requested_next;  // pipelined requests served after peer_requested
     std::shared_ptr<boost::asio::io_context> server_ioc; // keep ioc alive
     socket_ptr                               socket;
+    boost::asio::io_context::strand          strand;  // completions of socket and timers are serialized on it
 
+    // only touched by decoding on the strand once read, and by closing on app thread
+    std::mutex                      read_mutex;
     fc::message_buffer<1024 * 1024> pending_message_buffer;
     std::optional<std::size_t>      outstanding_read_bytes;
 
@@ -504,6 +940,8 @@ public:
     uint32_t                              reads_in_flight      = 0;
     uint32_t                              trx_in_progress_size = 0;
     fc::sha256                            node_id;
+    vector<std::shared_ptr<vector<char>>> trx_batch;  // send buffers of transactions to be relayed in one batch
+    size_t                                trx_batch_bytes      = 0;
     handshake_message                     last_handshake_recv;
     handshake_message                     last_handshake_sent;
     int16_t                               sent_handshake_count = 0;
@@ -517,6 +955,10 @@ public:
     block_id_type                         fork_head;
     uint32_t                              fork_head_num = 0;
     optional<request_message>             last_req;
+    fc::microseconds                      sync_chunk_time;  // average time of serving one sync chunk to us, zero if unknown
+    fc::microseconds                      smoothed_rtt;     // moving average of rtt measured by time messages, zero if unknown
+    optional<pending_compact_block>       compact_block;
+    connection_counters                   counters;
 
     connection_status get_status() const {
         connection_status stat;
@@ -582,9 +1024,12 @@ public:
 
     void enqueue(const net_message& msg, bool trigger_send = true);
     void enqueue_block(const signed_block_ptr& sb, bool trigger_send = true, bool to_sync_queue = false);
+    void enqueue_block(const block_log::packed_block& pb, bool trigger_send = true, bool to_sync_queue = false);
     void enqueue_buffer(const std::shared_ptr<std::vector<char>>& send_buffer,
                         bool trigger_send, int priority, go_away_reason close_after_send,
                         bool to_sync_queue = false);
+    void add_to_trx_batch(const std::shared_ptr<std::vector<char>>& trx_buffer);
+    void flush_trx_batch();
     void cancel_sync(go_away_reason);
     void flush_queues();
     bool enqueue_sync_block();
@@ -645,10 +1090,10 @@ struct msg_handler : public fc::visitor<void> {
     }
 
     void operator()(signed_block&& msg) const {
-        impl.handle_message(c, std::make_shared<signed_block>(std::move(msg)));
+        impl.handle_message(c, make_message<signed_block>(std::move(msg)));
     }
     void operator()(packed_transaction&& msg) const {
-        impl.handle_message(c, std::make_shared<packed_transaction>(std::move(msg)));
+        impl.handle_message(c, make_message<packed_transaction>(std::move(msg)));
     }
 
     template<typename T>
@@ -665,19 +1110,44 @@ private:
         in_sync
     };
 
-    uint32_t       sync_known_lib_num;
-    uint32_t       sync_last_requested_num;
-    uint32_t       sync_next_expected_num;
-    uint32_t       sync_req_span;
-    connection_ptr source;
-    stages         state;
+    // range of blocks requested from one peer, the ones before start are already received
+    struct sync_chunk {
+        uint32_t       end = 0;
+        connection_ptr source;  // empty if the chunk is to be requested again
+        time_point     requested;
+    };
+
+    struct buffered_block {
+        connection_ptr   source;
+        signed_block_ptr block;
+    };
+
+    uint32_t sync_known_lib_num;
+    uint32_t sync_last_requested_num;
+    uint32_t sync_next_expected_num;
+    uint32_t sync_req_span;
+    uint32_t sync_max_peers;
+    stages   state;
+
+    // every block in [sync_next_expected_num, sync_last_requested_num] is either in a chunk or buffered
+    std::map<uint32_t, sync_chunk>     sync_chunks;    // by the next block to receive of chunk
+    std::map<uint32_t, buffered_block> sync_buffered;  // received ahead of sync_next_expected_num
+    bool                               apply_posted = false;
 
     chain_plugin* chain_plug = nullptr;
 
     constexpr auto stage_str(stages s);
 
+    connection_ptr select_source(const connection_ptr& conn, uint32_t start, uint32_t end);
+    size_t         count_chunks(const connection_ptr& c) const;
+    bool           release_chunks(const connection_ptr& c);
+    void           reset_chunks();
+    void           rebalance();
+    bool           recv_chunk_block(const connection_ptr& c, uint32_t blk_num);
+    void           apply_buffered();
+
 public:
-    explicit sync_manager(uint32_t span);
+    sync_manager(uint32_t span, uint32_t max_peers);
     void set_state(stages s);
     bool sync_required();
     void send_handshakes();
@@ -689,8 +1159,11 @@ public:
     void verify_catchup(const connection_ptr& c, uint32_t num, const block_id_type& id);
     void rejected_block(const connection_ptr& c, uint32_t blk_num);
     void recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num);
+    // returns true if the block is taken to be applied later, or dropped
+    bool buffer_block(const connection_ptr& c, const signed_block_ptr& b, uint32_t blk_num);
     void recv_handshake(const connection_ptr& c, const handshake_message& msg);
     void recv_notice(const connection_ptr& c, const notice_message& msg);
+    void recv_block_range(const connection_ptr& c);
 };
 
 class dispatch_manager {
@@ -703,6 +1176,10 @@ public:
     void bcast_block(const block_state_ptr& bs);
     void rejected_block(const block_id_type& id);
 
+    // connections to relay the block to, the ones of next producers go first, then the other producers and relays,
+    // each group is ordered by rtt
+    vector<connection_ptr> relay_order(const block_state_ptr& bs, const std::set<connection_ptr>& skips);
+
     void recv_block(const connection_ptr& conn, const block_id_type& msg, uint32_t bnum);
     void expire_blocks(uint32_t bnum);
     void recv_transaction(const connection_ptr& conn, const transaction_id_type& id);
@@ -711,14 +1188,78 @@ public:
     void retry_fetch(const connection_ptr& conn);
 };
 
+/**
+ *  Warp sync: the full snapshots in snapshots dir are served to the peers behind them, and a node
+ *  configured with the digest of a snapshot manifest fetches its chunks from all the peers serving it.
+ *  Every chunk is verified against the manifest. Block sync is held until the snapshot is complete,
+ *  then the node quits to be restarted from it.
+ */
+class snapshot_sync_manager {
+private:
+    struct served_snapshot {
+        bfs::path         path;
+        uint64_t          size  = 0;  // along with mtime, to tell if the file is changed since it's hashed
+        std::time_t       mtime = 0;
+        fc::sha256        digest;
+        snapshot_manifest manifest;
+    };
+
+    enum chunk_states {
+        missing,
+        requested,
+        received
+    };
+
+    struct fetch_chunk {
+        chunk_states   state = missing;
+        connection_ptr source;
+        time_point     requested;
+    };
+
+    bfs::path               snapshots_dir;
+    bool                    serving = false;
+    vector<served_snapshot> served;  // newest first
+    bool                    refresh_running = false;
+    uint32_t                ticks           = 0;
+
+    optional<fc::sha256>               target;  // digest of the manifest to fetch
+    optional<snapshot_manifest>        manifest;
+    bfs::path                          fetch_path;
+    std::fstream                       fetch_file;
+    vector<fetch_chunk>                chunks;
+    uint32_t                           received_count = 0;
+    std::map<connection_ptr, uint32_t> sources;  // with the number of outstanding requests
+
+    bool start_fetch(const snapshot_manifest& m);
+    void request_chunks();
+    void release_chunk(uint32_t index);
+    void finish_fetch();
+    void refresh_served();
+
+public:
+    snapshot_sync_manager(const bfs::path& dir, bool serve, const optional<fc::sha256>& digest);
+
+    // held block sync until the snapshot is fetched
+    bool fetching() const { return target.has_value(); }
+
+    void start();
+    void tick();
+    void send_list(const connection_ptr& c, const handshake_message& msg);
+    void recv_list(const connection_ptr& c, const snapshot_list_message& msg);
+    void recv_request(const connection_ptr& c, const snapshot_chunk_request_message& msg);
+    void recv_chunk(const connection_ptr& c, const snapshot_chunk_message& msg);
+    void close(const connection_ptr& c);
+};
+
 //---------------------------------------------------------------------------
 
 connection::connection(string endpoint)
     : blk_state()
-    , trx_state()
+    , known_trxs(def_trx_filter_size)
     , peer_requested()
     , server_ioc(my_impl->server_ioc)
     , socket(std::make_shared<tcp::socket>(std::ref(*my_impl->server_ioc)))
+    , strand(*my_impl->server_ioc)
     , node_id()
     , last_handshake_recv()
     , last_handshake_sent()
@@ -739,10 +1280,11 @@ connection::connection(string endpoint)
 
 connection::connection(socket_ptr s)
     : blk_state()
-    , trx_state()
+    , known_trxs(def_trx_filter_size)
     , peer_requested()
     , server_ioc(my_impl->server_ioc)
     , socket(s)
+    , strand(*my_impl->server_ioc)
     , node_id()
     , last_handshake_recv()
     , last_handshake_sent()
@@ -784,13 +1326,17 @@ connection::current() {
 void
 connection::reset() {
     peer_requested.reset();
+    peer_requested_next.clear();
     blk_state.clear();
-    trx_state.clear();
+    known_trxs.clear();
+    peer_trxs.reset();
 }
 
 void
 connection::flush_queues() {
     buffer_queue.clear_write_queue();
+    trx_batch.clear();
+    trx_batch_bytes = 0;
 }
 
 void
@@ -804,6 +1350,7 @@ connection::close() {
     flush_queues();
     connecting = false;
     syncing    = false;
+    compact_block.reset();
     if(last_req) {
         my_impl->dispatcher->retry_fetch(shared_from_this());
     }
@@ -811,12 +1358,19 @@ connection::close() {
     sent_handshake_count = 0;
     last_handshake_recv  = handshake_message();
     last_handshake_sent  = handshake_message();
+    peer_first_block     = 1;
+    smoothed_rtt         = fc::microseconds();
     my_impl->sync_master->reset_lib_num(shared_from_this());
+    my_impl->snapshot_sync->close(shared_from_this());
     fc_dlog(logger, "canceling wait on ${p}", ("p", peer_name()));
     cancel_wait();
     if(read_delay_timer)
         read_delay_timer->cancel();
-    pending_message_buffer.reset();
+    {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        pending_message_buffer.reset();
+        outstanding_read_bytes.reset();
+    }
 }
 
 void
@@ -963,6 +1517,7 @@ connection::queue_write(const std::shared_ptr<vector<char>>& buff,
         my_impl->close(shared_from_this());
         return;
     }
+    counters.max_write_queue_size = std::max(counters.max_write_queue_size, buffer_queue.write_queue_size());
     if(buffer_queue.is_out_queue_empty() && trigger_send) {
         do_queue_write(priority);
     }
@@ -980,15 +1535,28 @@ connection::do_queue_write(int priority) {
     }
     std::vector<boost::asio::const_buffer> bufs;
     buffer_queue.fill_out_buffer(bufs);
+    for(auto& b : bufs) {
+        // which of net_message follows the header, it fits in one byte of unsigned_int
+        auto which = (uint8_t)boost::asio::buffer_cast<const char*>(b)[message_header_size];
+        if(which < counters.msgs_out.size()) {
+            counters.msgs_out[which]++;
+        }
+    }
 
-    boost::asio::async_write(*socket, bufs, [c, priority](boost::system::error_code ec, std::size_t w) {
-        app().post(priority, [c, priority, ec, w]() {
+    auto start = fc::time_point::now();
+    boost::asio::async_write(*socket, bufs, boost::asio::bind_executor(strand, [c, priority, start](boost::system::error_code ec, std::size_t w) {
+        auto latency = fc::time_point::now() - start;
+        app().post(priority, [c, priority, ec, w, latency]() {
             try {
                 auto conn = c.lock();
                 if(!conn)
                     return;
 
                 conn->buffer_queue.out_callback(ec, w);
+                conn->counters.bytes_out += w;
+                if(!ec) {
+                    conn->counters.write_latency.add(latency);
+                }
 
                 if(ec) {
                     string pname = conn ? conn->peer_name() : "no connection name";
@@ -1021,7 +1589,7 @@ connection::do_queue_write(int priority) {
                 fc_elog(logger, "Exception in do_queue_write to ${p}", ("p", pname));
             }
         });
-    });
+    }));
 }
 
 void
@@ -1051,12 +1619,17 @@ connection::enqueue_sync_block() {
     bool     trigger_send = num == peer_requested->start_block;
     if(num == peer_requested->end_block) {
         peer_requested.reset();
+        if(!peer_requested_next.empty()) {
+            peer_requested = peer_requested_next.front();
+            peer_requested_next.pop_front();
+        }
     }
     try {
-        controller&      cc = my_impl->chain_plug->chain();
-        signed_block_ptr sb = cc.fetch_block_by_number(num);
-        if(sb) {
-            enqueue_block(sb, trigger_send, true);
+        controller& cc = my_impl->chain_plug->chain();
+        auto        pb = cc.fetch_packed_block_by_number(num);
+        if(pb) {
+            enqueue_block(pb, trigger_send, true);
+            counters.sync_blocks_out++;
             return true;
         }
     }
@@ -1080,7 +1653,7 @@ connection::enqueue(const net_message& m, bool trigger_send) {
     static_assert(header_size == message_header_size, "invalid message_header_size");
     const size_t buffer_size = header_size + payload_size;
 
-    auto                  send_buffer = std::make_shared<vector<char>>(buffer_size);
+    auto                  send_buffer = make_send_buffer(buffer_size);
     fc::datastream<char*> ds(send_buffer->data(), buffer_size);
     ds.write(header, header_size);
     fc::raw::pack(ds, m);
@@ -1100,7 +1673,7 @@ create_send_buffer(uint32_t which, const T& v) {
     static_assert(header_size == message_header_size, "invalid message_header_size");
     const size_t buffer_size = header_size + payload_size;
 
-    auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+    auto send_buffer = make_send_buffer(buffer_size);
     fc::datastream<char*> ds(send_buffer->data(), buffer_size);
     ds.write(header, header_size);
     fc::raw::pack(ds, unsigned_int(which));
@@ -1116,6 +1689,26 @@ create_send_buffer(const signed_block_ptr& sb) {
     return create_send_buffer(signed_block_which, *sb);
 }
 
+static std::shared_ptr<std::vector<char>>
+create_send_buffer(const block_log::packed_block& pb) {
+    // packed block is framed as it is, same as packing signed_block into net_message
+    const uint32_t which_size   = fc::raw::pack_size(unsigned_int(signed_block_which));
+    const uint32_t payload_size = which_size + pb.data.size();
+
+    const char* const header     = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+    constexpr size_t header_size = sizeof(payload_size);
+    static_assert(header_size == message_header_size, "invalid message_header_size");
+    const size_t buffer_size = header_size + payload_size;
+
+    auto send_buffer = make_send_buffer(buffer_size);
+    fc::datastream<char*> ds(send_buffer->data(), buffer_size);
+    ds.write(header, header_size);
+    fc::raw::pack(ds, unsigned_int(signed_block_which));
+    ds.write(pb.data.data(), pb.data.size());
+
+    return send_buffer;
+}
+
 static std::shared_ptr<std::vector<char>>
 create_send_buffer(const packed_transaction& trx) {
     // this implementation is to avoid copy of packed_transaction to net_message
@@ -1123,11 +1716,164 @@ create_send_buffer(const packed_transaction& trx) {
     return create_send_buffer(packed_transaction_which, trx);
 }
 
+// offset of packed transaction in its send buffer
+static uint32_t
+trx_buffer_offset() {
+    return message_header_size + fc::raw::pack_size(unsigned_int(packed_transaction_which));
+}
+
+static packed_transaction
+unpack_trx_buffer(const vector<char>& trx_buffer) {
+    const auto trx_offset = trx_buffer_offset();
+
+    auto ds  = fc::datastream<const char*>(trx_buffer.data() + trx_offset, trx_buffer.size() - trx_offset);
+    auto trx = packed_transaction();
+    fc::raw::unpack(ds, trx);
+    return trx;
+}
+
+static std::shared_ptr<std::vector<char>>
+create_compact_block_buffer(const signed_block& b) {
+    auto msg   = compact_block_message();
+    msg.header = b;
+    msg.receipts.reserve(b.transactions.size());
+    for(auto& r : b.transactions) {
+        auto cr   = compact_block_receipt();
+        cr.status = r.status;
+        cr.type   = r.type;
+        if(r.type == transaction_receipt::input) {
+            cr.short_id = r.trx.id()._hash[0];
+        }
+        else {
+            cr.trx = r.trx;
+        }
+        msg.receipts.emplace_back(std::move(cr));
+    }
+    msg.block_extensions = b.block_extensions;
+    return create_send_buffer(compact_block_which, msg);
+}
+
+static std::shared_ptr<std::vector<char>>
+create_trx_batch_buffer(const vector<std::shared_ptr<vector<char>>>& trx_buffers, bool compress, bool dict) {
+    // send buffers of packed_transaction are stripped of header and which, the rest are
+    // concatenated after the count, same as packing vector<packed_transaction>
+    const auto trx_offset = trx_buffer_offset();
+
+    auto size = fc::raw::pack_size(unsigned_int(trx_buffers.size()));
+    for(auto& b : trx_buffers) {
+        size += b->size() - trx_offset;
+    }
+
+    auto msg = transaction_batch_message();
+    msg.data.resize(size);
+    auto ds = fc::datastream<char*>(msg.data.data(), msg.data.size());
+    fc::raw::pack(ds, unsigned_int(trx_buffers.size()));
+    for(auto& b : trx_buffers) {
+        ds.write(b->data() + trx_offset, b->size() - trx_offset);
+    }
+
+    if(compress && dict) {
+        // dictionary makes even the small batches worth compressing
+        auto cdata = zstd_dict_compress(msg.data.data(), size, def_trx_batch_compress_level);
+        if(cdata.size() < size) {
+            msg.data        = std::move(cdata);
+            msg.compression = (uint8_t)trx_batch_compression::zstd_dict;
+        }
+    }
+    else if(compress && size >= def_trx_batch_compress_min) {
+        auto cdata = bytes(ZSTD_compressBound(size));
+        auto r     = ZSTD_compress(cdata.data(), cdata.size(), msg.data.data(), size, def_trx_batch_compress_level);
+        if(!ZSTD_isError(r) && r < size) {
+            cdata.resize(r);
+            msg.data        = std::move(cdata);
+            msg.compression = (uint8_t)trx_batch_compression::zstd;
+        }
+    }
+    return create_send_buffer(transaction_batch_which, msg);
+}
+
+static vector<packed_transaction>
+unpack_trx_batch(const transaction_batch_message& msg) {
+    auto trxs = vector<packed_transaction>();
+    switch((trx_batch_compression)msg.compression) {
+    case trx_batch_compression::none: {
+        auto ds = fc::datastream<const char*>(msg.data.data(), msg.data.size());
+        fc::raw::unpack(ds, trxs);
+        break;
+    }
+    case trx_batch_compression::zstd: {
+        // bounded the same as the length of one message
+        auto sz = ZSTD_getFrameContentSize(msg.data.data(), msg.data.size());
+        EVT_ASSERT(sz != ZSTD_CONTENTSIZE_ERROR && sz != ZSTD_CONTENTSIZE_UNKNOWN && sz <= def_send_buffer_size * 2, plugin_exception,
+            "Invalid content size of compressed transaction batch");
+
+        auto data = bytes(sz);
+        auto r    = ZSTD_decompress(data.data(), data.size(), msg.data.data(), msg.data.size());
+        EVT_ASSERT(!ZSTD_isError(r) && r == sz, plugin_exception,
+            "Failed to decompress transaction batch: ${e}", ("e", ZSTD_isError(r) ? ZSTD_getErrorName(r) : "size mismatch"));
+
+        auto ds = fc::datastream<const char*>(data.data(), data.size());
+        fc::raw::unpack(ds, trxs);
+        break;
+    }
+    case trx_batch_compression::zstd_dict: {
+        auto sz = zstd_frame_content_size(msg.data.data(), msg.data.size());
+        EVT_ASSERT(sz.has_value() && *sz <= def_send_buffer_size * 2, plugin_exception,
+            "Invalid content size of compressed transaction batch");
+
+        auto data = bytes(*sz);
+        auto err  = zstd_dict_decompress(msg.data.data(), msg.data.size(), data.data(), data.size());
+        EVT_ASSERT(err == nullptr, plugin_exception, "Failed to decompress transaction batch: ${e}", ("e", err));
+
+        auto ds = fc::datastream<const char*>(data.data(), data.size());
+        fc::raw::unpack(ds, trxs);
+        break;
+    }
+    default: {
+        EVT_THROW(plugin_exception, "Unknown compression of transaction batch: ${c}", ("c", msg.compression));
+    }
+    }  // switch
+    return trxs;
+}
+
+void
+connection::add_to_trx_batch(const std::shared_ptr<std::vector<char>>& trx_buffer) {
+    trx_batch.emplace_back(trx_buffer);
+    trx_batch_bytes += trx_buffer->size();
+    if(trx_batch.size() >= my_impl->trx_batch_size || trx_batch_bytes >= def_trx_batch_max_bytes) {
+        flush_trx_batch();
+    }
+    else {
+        my_impl->start_trx_batch_timer();
+    }
+}
+
+void
+connection::flush_trx_batch() {
+    if(trx_batch.empty()) {
+        return;
+    }
+    if(trx_batch.size() == 1) {
+        // not worth a batch, original buffer is sent instead
+        enqueue_buffer(trx_batch.front(), true, priority::low, no_reason);
+    }
+    else {
+        enqueue_buffer(create_trx_batch_buffer(trx_batch, my_impl->trx_batch_compress, protocol_version >= proto_trx_batch_dict), true, priority::low, no_reason);
+    }
+    trx_batch.clear();
+    trx_batch_bytes = 0;
+}
+
 void
 connection::enqueue_block(const signed_block_ptr& sb, bool trigger_send, bool to_sync_queue) {
     enqueue_buffer(create_send_buffer(sb), trigger_send, priority::low, no_reason, to_sync_queue);
 }
 
+void
+connection::enqueue_block(const block_log::packed_block& pb, bool trigger_send, bool to_sync_queue) {
+    enqueue_buffer(create_send_buffer(pb), trigger_send, priority::low, no_reason, to_sync_queue);
+}
+
 void
 connection::enqueue_buffer(const std::shared_ptr<std::vector<char>>& send_buffer,
                            bool trigger_send, int priority, go_away_reason close_after_send,
@@ -1161,7 +1907,7 @@ void
 connection::sync_wait() {
     response_expected->expires_from_now(my_impl->resp_expected_period);
     connection_wptr c(shared_from_this());
-    response_expected->async_wait([c](boost::system::error_code ec) {
+    response_expected->async_wait(boost::asio::bind_executor(strand, [c](boost::system::error_code ec) {
         app().post(priority::low, [c, ec]() {
             connection_ptr conn = c.lock();
             if(!conn) {
@@ -1171,14 +1917,14 @@ connection::sync_wait() {
 
             conn->sync_timeout(ec);
         });
-    });
+    }));
 }
 
 void
 connection::fetch_wait() {
     response_expected->expires_from_now(my_impl->resp_expected_period);
     connection_wptr c(shared_from_this());
-    response_expected->async_wait([c](boost::system::error_code ec) {
+    response_expected->async_wait(boost::asio::bind_executor(strand, [c](boost::system::error_code ec) {
         app().post(priority::low, [c, ec]() {
             connection_ptr conn = c.lock();
             if(!conn) {
@@ -1188,7 +1934,7 @@ connection::fetch_wait() {
 
             conn->fetch_timeout(ec);
         });
-    });
+    }));
 }
 
 void
@@ -1253,12 +1999,12 @@ connection::peer_has_block(const block_id_type& blkid) {
 
 //-----------------------------------------------------------
 
-sync_manager::sync_manager(uint32_t req_span)
+sync_manager::sync_manager(uint32_t req_span, uint32_t max_peers)
     : sync_known_lib_num(0)
     , sync_last_requested_num(0)
     , sync_next_expected_num(1)
     , sync_req_span(req_span)
-    , source()
+    , sync_max_peers(max_peers)
     , state(in_sync) {
     chain_plug = app().find_plugin<chain_plugin>();
     EVT_ASSERT(chain_plug, chain::missing_chain_plugin_exception, "");
@@ -1301,15 +2047,14 @@ sync_manager::is_active(const connection_ptr& c) {
 void
 sync_manager::reset_lib_num(const connection_ptr& c) {
     if(state == in_sync) {
-        source.reset();
+        reset_chunks();
     }
     if(c->current()) {
         if(c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num) {
             sync_known_lib_num = c->last_handshake_recv.last_irreversible_block_num;
         }
     }
-    else if(c == source) {
-        sync_last_requested_num = 0;
+    else if(release_chunks(c)) {
         request_next_chunk();
     }
 }
@@ -1322,89 +2067,220 @@ sync_manager::sync_required() {
     return (sync_last_requested_num < sync_known_lib_num || chain_plug->chain().fork_db_head_block_num() < sync_last_requested_num);
 }
 
+size_t
+sync_manager::count_chunks(const connection_ptr& c) const {
+    return std::count_if(sync_chunks.begin(), sync_chunks.end(), [&c](auto& it) { return it.second.source == c; });
+}
+
+bool
+sync_manager::release_chunks(const connection_ptr& c) {
+    auto released = false;
+    for(auto& it : sync_chunks) {
+        if(it.second.source == c) {
+            it.second.source.reset();
+            released = true;
+        }
+    }
+    return released;
+}
+
 void
-sync_manager::request_next_chunk(const connection_ptr& conn) {
-    uint32_t head_block = chain_plug->chain().fork_db_head_block_num();
+sync_manager::reset_chunks() {
+    sync_chunks.clear();
+    sync_buffered.clear();
+}
 
-    if(head_block < sync_last_requested_num && source && source->current()) {
-        fc_ilog(logger, "ignoring request, head is ${h} last req = ${r} source is ${p}",
-                ("h", head_block)("r", sync_last_requested_num)("p", source->peer_name()));
-        return;
+connection_ptr
+sync_manager::select_source(const connection_ptr& conn, uint32_t start, uint32_t end) {
+    auto sources = std::set<connection_ptr>();
+    for(auto& it : sync_chunks) {
+        if(it.second.source) {
+            sources.insert(it.second.source);
+        }
     }
 
     /* ----------
      * next chunk provider selection criteria
-     * a provider is supplied and able to be used, use it.
-     * otherwise select the next available from the list, round-robin style.
+     * current peers having the chunk are scored by their outstanding chunks and the average time
+     * they took for one, peers never used are tried first. the supplied provider wins the ties.
      */
+    auto best       = connection_ptr();
+    auto best_score = int64_t(0);
+    for(auto& c : my_impl->connections) {
+        if(!c->current() || c->last_handshake_recv.last_irreversible_block_num < end || c->peer_first_block > start) {
+            continue;
+        }
+        auto n          = count_chunks(c);
+        auto max_chunks = size_t(c->protocol_version >= proto_pipelined_sync ? def_sync_chunks_per_peer : 1);
+        if(n >= max_chunks) {
+            continue;
+        }
+        if(n == 0 && sources.size() >= sync_max_peers) {
+            continue;
+        }
+        auto score = (int64_t)(n + 1) * std::max<int64_t>(c->sync_chunk_time.count(), 1);
+        if(!best || score < best_score || (score == best_score && c == conn)) {
+            best       = c;
+            best_score = score;
+        }
+    }
+    return best;
+}
 
-    if(conn && conn->current()) {
-        source = conn;
+void
+sync_manager::rebalance() {
+    if(sync_chunks.size() < 2) {
+        return;
     }
-    else {
-        if(my_impl->connections.size() == 1) {
-            if(!source) {
-                source = *my_impl->connections.begin();
-            }
+    // all the other chunks wait for the first one, it's moved away from a source much slower than the others
+    auto& first = sync_chunks.begin()->second;
+    if(!first.source) {
+        return;
+    }
+    auto fastest = fc::microseconds();
+    for(auto& c : my_impl->connections) {
+        if(c != first.source && c->current() && c->sync_chunk_time.count() > 0 && (fastest.count() == 0 || c->sync_chunk_time < fastest)) {
+            fastest = c->sync_chunk_time;
         }
-        else {
-            // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
-            // do we remember the previous source?
-            if(source) {
-                //try to find it in the list
-                cptr = my_impl->connections.find(source);
-                cend = cptr;
-                if(cptr == my_impl->connections.end()) {
-                    //not there - must have been closed! cend is now connections.end, so just flatten the ring.
-                    source.reset();
-                    cptr = my_impl->connections.begin();
-                }
-                else {
-                    //was found - advance the start to the next. cend is the old source.
-                    if(++cptr == my_impl->connections.end() && cend != my_impl->connections.end()) {
-                        cptr = my_impl->connections.begin();
-                    }
-                }
-            }
+    }
+    auto elapsed = time_point::now() - first.requested;
+    if(fastest.count() == 0 || elapsed < fc::milliseconds(def_sync_rebalance_ms) || elapsed.count() < fastest.count() * def_sync_slow_factor) {
+        return;
+    }
 
-            //scan the list of peers looking for another able to provide sync blocks.
-            auto cstart_it = cptr;
-            do {
-                //select the first one which is current and break out.
-                if((*cptr)->current()) {
-                    source = *cptr;
-                    break;
-                }
-                if(++cptr == my_impl->connections.end())
-                    cptr = my_impl->connections.begin();
-            } while(cptr != cstart_it);
-            // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
+    auto slow = first.source;
+    fc_ilog(logger, "moving sync chunks away from slow peer ${p}, chunk is waited for ${t}ms",
+            ("p", slow->peer_name())("t", elapsed.count() / 1000));
+    slow->sync_chunk_time = std::max(slow->sync_chunk_time, elapsed);
+    slow->cancel_sync(benign_other);
+    release_chunks(slow);
+}
+
+void
+sync_manager::request_next_chunk(const connection_ptr& conn) {
+    for(auto& it : sync_chunks) {
+        if(it.second.source && !it.second.source->current()) {
+            it.second.source.reset();
+        }
+    }
+    rebalance();
+
+    if(sync_last_requested_num + 1 < sync_next_expected_num) {
+        sync_last_requested_num = sync_next_expected_num - 1;
+    }
+
+    // released chunks are requested again first, from where they were left
+    auto now = time_point::now();
+    for(auto& it : sync_chunks) {
+        auto& chunk = it.second;
+        if(chunk.source) {
+            continue;
+        }
+        auto c = select_source(conn, it.first, chunk.end);
+        if(!c) {
+            break;
+        }
+        fc_ilog(logger, "requesting range ${s} to ${e} again, from ${n}",
+                ("n", c->peer_name())("s", it.first)("e", chunk.end));
+        chunk.source    = c;
+        chunk.requested = now;
+        c->request_sync_blocks(it.first, chunk.end);
+    }
+
+    const auto window = sync_req_span * sync_max_peers * def_sync_window_factor;
+    while(sync_last_requested_num < sync_known_lib_num && sync_last_requested_num + 1 - sync_next_expected_num < window) {
+        uint32_t start = sync_last_requested_num + 1;
+        uint32_t end   = std::min(start + sync_req_span - 1, sync_known_lib_num);
+
+        auto c = select_source(conn, start, end);
+        if(!c) {
+            break;
         }
+        fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
+                ("n", c->peer_name())("s", start)("e", end));
+        sync_chunks[start]      = sync_chunk{end, c, now};
+        sync_last_requested_num = end;
+        c->request_sync_blocks(start, end);
     }
 
     // verify there is an available source
-    if(!source || !source->current()) {
+    auto requested = std::any_of(sync_chunks.begin(), sync_chunks.end(), [](auto& it) { return (bool)it.second.source; });
+    auto complete  = sync_chunks.empty() && sync_last_requested_num >= sync_known_lib_num;
+    if(!requested && !complete) {
         fc_elog(logger, "Unable to continue syncing at this time");
         sync_known_lib_num      = chain_plug->chain().last_irreversible_block_num();
         sync_last_requested_num = 0;
+        reset_chunks();
         set_state(in_sync);  // probably not, but we can't do anything else
-        return;
     }
+}
 
-    if(sync_last_requested_num != sync_known_lib_num) {
-        uint32_t start = sync_next_expected_num;
-        uint32_t end   = start + sync_req_span - 1;
-        if(end > sync_known_lib_num)
-            end = sync_known_lib_num;
-        if(end > 0 && end >= start) {
-            fc_ilog(logger, "requesting range ${s} to ${e}, from ${n}",
-                    ("n", source->peer_name())("s", start)("e", end));
-            source->request_sync_blocks(start, end);
-            sync_last_requested_num = end;
+bool
+sync_manager::recv_chunk_block(const connection_ptr& c, uint32_t blk_num) {
+    // peers send blocks of chunks in order, so the block is always the start of its chunk
+    auto it = sync_chunks.find(blk_num);
+    if(it == sync_chunks.end() || it->second.source != c) {
+        return false;
+    }
+    if(blk_num < it->second.end) {
+        auto node  = sync_chunks.extract(it);
+        node.key() = blk_num + 1;
+        sync_chunks.insert(std::move(node));
+        c->sync_wait();
+        return true;
+    }
+
+    auto elapsed = time_point::now() - it->second.requested;
+    if(c->sync_chunk_time.count() == 0) {
+        c->sync_chunk_time = elapsed;
+    }
+    else {
+        c->sync_chunk_time = fc::microseconds((c->sync_chunk_time.count() * 3 + elapsed.count()) / 4);
+    }
+    sync_chunks.erase(it);
+
+    request_next_chunk(c);
+    if(count_chunks(c) > 0) {
+        c->sync_wait();
+    }
+    return true;
+}
+
+bool
+sync_manager::buffer_block(const connection_ptr& c, const signed_block_ptr& b, uint32_t blk_num) {
+    if(state != lib_catchup || blk_num <= sync_next_expected_num) {
+        return false;
+    }
+    if(!recv_chunk_block(c, blk_num)) {
+        if(blk_num <= sync_last_requested_num) {
+            // chunk was moved to another peer, the block is still on its way
+            fc_dlog(logger, "dropping block ${n} of sync chunk not requested from ${p}", ("n", blk_num)("p", c->peer_name()));
+            return true;
         }
+        return false;
     }
+    sync_buffered[blk_num] = buffered_block{c, b};
+    return true;
+}
+
+void
+sync_manager::apply_buffered() {
+    sync_buffered.erase(sync_buffered.begin(), sync_buffered.lower_bound(sync_next_expected_num));
+    if(apply_posted || sync_buffered.empty() || sync_buffered.begin()->first != sync_next_expected_num) {
+        return;
+    }
+    // one block is applied each time, so the other messages are not starved
+    apply_posted = true;
+    post_lane(app_lane::blocks, [this]() {
+        apply_posted = false;
+        auto it = sync_buffered.find(sync_next_expected_num);
+        if(it == sync_buffered.end()) {
+            return;
+        }
+        auto b = std::move(it->second);
+        sync_buffered.erase(it);
+        my_impl->handle_message(b.source, b.block);
+    });
 }
 
 void
@@ -1418,6 +2294,9 @@ sync_manager::send_handshakes() {
 
 void
 sync_manager::start_sync(const connection_ptr& c, uint32_t target) {
+    if(my_impl->snapshot_sync->fetching()) {
+        return;
+    }
     if(target > sync_known_lib_num) {
         sync_known_lib_num = target;
     }
@@ -1432,7 +2311,9 @@ sync_manager::start_sync(const connection_ptr& c, uint32_t target) {
 
     if(state == in_sync) {
         set_state(lib_catchup);
-        sync_next_expected_num = chain_plug->chain().last_irreversible_block_num() + 1;
+        sync_next_expected_num  = chain_plug->chain().last_irreversible_block_num() + 1;
+        sync_last_requested_num = sync_next_expected_num - 1;
+        reset_chunks();
     }
 
     fc_ilog(logger, "Catching up with chain, our last req is ${cc}, theirs is ${t} peer ${p}",
@@ -1446,9 +2327,10 @@ sync_manager::reassign_fetch(const connection_ptr& c, go_away_reason reason) {
     fc_ilog(logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
             ("cc", sync_last_requested_num)("ne", sync_next_expected_num)("p", c->peer_name()));
 
-    if(c == source) {
+    if(count_chunks(c) > 0) {
         c->cancel_sync(reason);
-        sync_last_requested_num = 0;
+        c->sync_chunk_time = std::max(c->sync_chunk_time, fc::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(my_impl->resp_expected_period).count()));
+        release_chunks(c);
         request_next_chunk();
     }
 }
@@ -1528,8 +2410,22 @@ sync_manager::recv_handshake(const connection_ptr& c, const handshake_message& m
     fc_elog(logger, "sync check failed to resolve status");
 }
 
+void
+sync_manager::recv_block_range(const connection_ptr& c) {
+    auto pruned = std::any_of(sync_chunks.begin(), sync_chunks.end(), [&](auto& it) {
+        return it.second.source == c && it.first < c->peer_first_block;
+    });
+    if(pruned) {
+        fc_ilog(logger, "blocks requested from ${p} are pruned, requesting them from other peers", ("p", c->peer_name()));
+        reassign_fetch(c, benign_other);
+    }
+}
+
 void
 sync_manager::verify_catchup(const connection_ptr& c, uint32_t num, const block_id_type& id) {
+    if(my_impl->snapshot_sync->fetching()) {
+        return;
+    }
     request_message req;
     req.req_blocks.mode = catch_up;
     for(const auto& cc : my_impl->connections) {
@@ -1583,7 +2479,7 @@ sync_manager::rejected_block(const connection_ptr& c, uint32_t blk_num) {
     if(state != in_sync) {
         fc_ilog(logger, "block ${bn} not accepted from ${p}", ("bn", blk_num)("p", c->peer_name()));
         sync_last_requested_num = 0;
-        source.reset();
+        reset_chunks();
         my_impl->close(c);
         set_state(in_sync);
         send_handshakes();
@@ -1593,6 +2489,11 @@ void
 sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num) {
     fc_dlog(logger, "got block ${bn} from ${p}", ("bn", blk_num)("p", c->peer_name()));
     if(state == lib_catchup) {
+        if(blk_num < sync_next_expected_num) {
+            // sent by the peer a chunk was moved away from
+            fc_dlog(logger, "ignoring block ${bn} already applied", ("bn", blk_num));
+            return;
+        }
         if(blk_num != sync_next_expected_num) {
             fc_ilog(logger, "expected block ${ne} but got ${bn}", ("ne", sync_next_expected_num)("bn", blk_num));
             my_impl->close(c);
@@ -1603,7 +2504,7 @@ sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, u
     if(state == head_catchup) {
         fc_dlog(logger, "sync_manager in head_catchup state");
         set_state(in_sync);
-        source.reset();
+        reset_chunks();
 
         block_id_type null_id;
         for(const auto& cp : my_impl->connections) {
@@ -1627,14 +2528,16 @@ sync_manager::recv_block(const connection_ptr& c, const block_id_type& blk_id, u
         if(blk_num == sync_known_lib_num) {
             fc_dlog(logger, "All caught up with last known last irreversible block resending handshake");
             set_state(in_sync);
+            reset_chunks();
             send_handshakes();
         }
-        else if(blk_num == sync_last_requested_num) {
-            request_next_chunk();
-        }
         else {
-            fc_dlog(logger, "calling sync_wait on connection ${p}", ("p", c->peer_name()));
-            c->sync_wait();
+            // buffered blocks are recorded when received, the wait canceled by applying them is restarted
+            if(!recv_chunk_block(c, blk_num) && count_chunks(c) > 0) {
+                fc_dlog(logger, "calling sync_wait on connection ${p}", ("p", c->peer_name()));
+                c->sync_wait();
+            }
+            apply_buffered();
         }
     }
 }
@@ -1653,16 +2556,25 @@ dispatch_manager::bcast_block(const block_state_ptr& bs) {
     auto bnum    = bs->block_num;
     auto pbstate = peer_block_state{bs->id, bnum};
 
+    // blocks without transactions gain nothing from being compact
+    auto compact = my_impl->use_compact_blocks && !bs->block->transactions.empty();
+
     std::shared_ptr<std::vector<char>> send_buffer;
-    for(auto& cp : my_impl->connections) {
-        if(skips.find(cp) != skips.end() || !cp->current()) {
-            continue;
-        }
+    std::shared_ptr<std::vector<char>> compact_buffer;
+    for(auto& cp : relay_order(bs, skips)) {
         bool has_block = cp->last_handshake_recv.last_irreversible_block_num >= bnum;
         if(!has_block) {
             if(!cp->add_peer_block(pbstate)) {
                 continue;
             }
+            if(compact && cp->protocol_version >= proto_compact_block) {
+                if(!compact_buffer) {
+                    compact_buffer = create_compact_block_buffer(*bs->block);
+                }
+                fc_dlog(logger, "bcast compact block ${b} to ${p}", ("b", bnum)("p", cp->peer_name()));
+                cp->enqueue_buffer(compact_buffer, true, priority::high, no_reason);
+                continue;
+            }
             if(!send_buffer) {
                 send_buffer = create_send_buffer(bs->block);
             }
@@ -1672,6 +2584,65 @@ dispatch_manager::bcast_block(const block_state_ptr& bs) {
     }
 }
 
+vector<connection_ptr>
+dispatch_manager::relay_order(const block_state_ptr& bs, const std::set<connection_ptr>& skips) {
+    auto conns = vector<connection_ptr>();
+    conns.reserve(my_impl->connections.size());
+    for(auto& cp : my_impl->connections) {
+        if(skips.find(cp) == skips.end() && cp->current()) {
+            conns.emplace_back(cp);
+        }
+    }
+    if(my_impl->relay_next_producers == 0 || conns.size() < 2) {
+        return conns;
+    }
+
+    // producers are told by the keys in their handshakes, which are their signing keys
+    // when they're configured as peer keys
+    auto& producers = bs->active_schedule->producers;
+    if(producers.empty()) {
+        return conns;
+    }
+    auto next = small_vector<account_name, 4>();
+    auto slot = bs->header.timestamp.slot;
+    auto max  = std::min<size_t>(my_impl->relay_next_producers, producers.size() - 1);
+    for(auto i = 1u; next.size() < max && i <= producers.size() * config::producer_repetitions; i++) {
+        auto& p = bs->get_scheduled_producer(block_timestamp_type(slot + i)).producer_name;
+        if(p != bs->header.producer && std::find(next.cbegin(), next.cend(), p) == next.cend()) {
+            next.emplace_back(p);
+        }
+    }
+
+    auto rank = [&](const connection_ptr& c) -> uint32_t {
+        auto& key = c->last_handshake_recv.key;
+        for(auto& p : producers) {
+            if(p.block_signing_key != key) {
+                continue;
+            }
+            auto it = std::find(next.cbegin(), next.cend(), p.producer_name);
+            return it != next.cend() ? (uint32_t)(it - next.cbegin()) : (uint32_t)next.size();
+        }
+        return (uint32_t)next.size() + 1;  // relay
+    };
+
+    auto ranked = vector<std::tuple<uint32_t, int64_t, connection_ptr>>();
+    ranked.reserve(conns.size());
+    for(auto& c : conns) {
+        // unknown rtt goes last in its group
+        auto rtt = c->smoothed_rtt.count() > 0 ? c->smoothed_rtt.count() : std::numeric_limits<int64_t>::max();
+        ranked.emplace_back(rank(c), rtt, c);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](auto& a, auto& b) {
+        return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+    });
+
+    conns.clear();
+    for(auto& r : ranked) {
+        conns.emplace_back(std::move(std::get<2>(r)));
+    }
+    return conns;
+}
+
 void
 dispatch_manager::recv_block(const connection_ptr& c, const block_id_type& id, uint32_t bnum) {
     received_blocks.insert(std::make_pair(id, c));
@@ -1727,18 +2698,21 @@ dispatch_manager::bcast_transaction(const transaction_metadata_ptr& ptrx) {
 
     node_transaction_state nts = {id, trx_expiration, 0, buff};
     my_impl->local_txns.insert(std::move(nts));
+    my_impl->seen_trxs->insert(id);
+    if(my_impl->prefilter) {
+        my_impl->prefilter->insert(id, trx_expiration);
+    }
 
-    my_impl->send_transaction_to_all(buff, [&id, &skips, trx_expiration](const connection_ptr& c) -> bool {
+    my_impl->send_transaction_to_all(buff, [&id, &skips](const connection_ptr& c) -> bool {
         if(skips.find(c) != skips.end() || c->syncing) {
             return false;
         }
-        const auto& bs      = c->trx_state.find(id);
-        bool        unknown = bs == c->trx_state.end();
-        if(unknown) {
-            c->trx_state.insert(transaction_state({id, 0, trx_expiration}));
-            fc_dlog(logger, "sending trx to ${n}", ("n", c->peer_name()));
+        if(c->known_trxs.contains(id) || (c->peer_trxs.has_value() && c->peer_trxs->contains(id.data(), id.data_size()))) {
+            return false;
         }
-        return unknown;
+        c->known_trxs.insert(id);
+        fc_dlog(logger, "sending trx to ${n}", ("n", c->peer_name()));
+        return true;
     });
 }
 
@@ -1829,36 +2803,365 @@ dispatch_manager::retry_fetch(const connection_ptr& c) {
     else if(c->last_req->req_blocks.mode == normal && !c->last_req->req_blocks.ids.empty()) {
         bid = c->last_req->req_blocks.ids.back();
     }
-    else {
-        fc_wlog(logger, "no retry, block mpde = ${b} trx mode = ${t}",
-                ("b", modes_str(c->last_req->req_blocks.mode))("t", modes_str(c->last_req->req_trx.mode)));
+    else {
+        fc_wlog(logger, "no retry, block mpde = ${b} trx mode = ${t}",
+                ("b", modes_str(c->last_req->req_blocks.mode))("t", modes_str(c->last_req->req_trx.mode)));
+        return;
+    }
+    for(auto& conn : my_impl->connections) {
+        if(conn == c || conn->last_req) {
+            continue;
+        }
+        bool sendit = false;
+        if(is_txn) {
+            sendit = conn->known_trxs.contains(tid);
+        }
+        else {
+            sendit = conn->peer_has_block(bid);
+        }
+        if(sendit) {
+            conn->enqueue(*c->last_req);
+            conn->fetch_wait();
+            conn->last_req = c->last_req;
+            return;
+        }
+    }
+
+    // at this point no other peer has it, re-request or do nothing?
+    if(c->connected()) {
+        c->enqueue(*c->last_req);
+        c->fetch_wait();
+    }
+}
+
+//------------------------------------------------------------------------
+
+snapshot_sync_manager::snapshot_sync_manager(const bfs::path& dir, bool serve, const optional<fc::sha256>& digest)
+    : snapshots_dir(dir)
+    , serving(serve)
+    , target(digest) {}
+
+void
+snapshot_sync_manager::start() {
+    refresh_served();
+    if(target.has_value()) {
+        fc_ilog(logger, "Block sync is held until the snapshot of manifest ${d} is fetched", ("d", *target));
+    }
+}
+
+void
+snapshot_sync_manager::tick() {
+    if(++ticks % def_snapshot_refresh_ticks == 0) {
+        refresh_served();
+    }
+    if(!target.has_value()) {
+        return;
+    }
+    if(!manifest.has_value()) {
+        fc_ilog(logger, "No peer serves the snapshot of manifest ${d} yet", ("d", *target));
+        return;
+    }
+
+    auto now = time_point::now();
+    for(auto i = 0u; i < chunks.size(); i++) {
+        if(chunks[i].state == requested && now - chunks[i].requested > def_snapshot_chunk_timeout) {
+            fc_wlog(logger, "Snapshot chunk ${i} requested from ${p} is timed out", ("i", i)("p", chunks[i].source->peer_name()));
+            release_chunk(i);
+        }
+    }
+    fc_ilog(logger, "Fetched ${r} of ${n} chunks of snapshot from ${s} peers", ("r", received_count)("n", chunks.size())("s", sources.size()));
+    request_chunks();
+}
+
+void
+snapshot_sync_manager::refresh_served() {
+    if(!serving || refresh_running || !fc::is_directory(snapshots_dir)) {
+        return;
+    }
+    refresh_running = true;
+
+    // files are hashed on net threads, the ones not changed since last scan are reused
+    boost::asio::post(*my_impl->server_ioc, [this, dir = snapshots_dir, current = served]() {
+        auto result = vector<served_snapshot>();
+        auto buf    = std::vector<char>(def_snapshot_chunk_size);
+        auto it     = bfs::directory_iterator();
+        try {
+            it = bfs::directory_iterator(dir);
+        }
+        catch(...) {
+            fc_wlog(logger, "Cannot scan snapshots dir ${d}", ("d", dir.generic_string()));
+        }
+        for(; it != bfs::directory_iterator(); ++it) {
+            // only full snapshots named by their head blocks are served
+            auto name = it->path().filename().generic_string();
+            if(!bfs::is_regular_file(it->path()) || name.size() != 77 || name.compare(0, 9, "snapshot-") != 0 || name.compare(73, 4, ".bin") != 0) {
+                continue;
+            }
+            try {
+                auto ss  = served_snapshot();
+                ss.path  = it->path();
+                ss.size  = bfs::file_size(ss.path);
+                ss.mtime = bfs::last_write_time(ss.path);
+
+                auto cit = std::find_if(current.begin(), current.end(), [&](auto& s) {
+                    return s.path == ss.path && s.size == ss.size && s.mtime == ss.mtime;
+                });
+                if(cit != current.end()) {
+                    result.emplace_back(*cit);
+                    continue;
+                }
+
+                auto& m          = ss.manifest;
+                m.head_block_id  = block_id_type(name.substr(9, 64));
+                m.head_block_num = block_header::num_from_id(m.head_block_id);
+                m.size           = ss.size;
+                m.chunk_size     = def_snapshot_chunk_size;
+
+                auto in = std::ifstream(ss.path.generic_string(), std::ios::in | std::ios::binary);
+                in.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+                for(auto left = ss.size; left > 0;) {
+                    auto n = (size_t)std::min<uint64_t>(left, def_snapshot_chunk_size);
+                    in.read(buf.data(), n);
+                    m.chunk_digests.emplace_back(fc::sha256::hash(buf.data(), n));
+                    left -= n;
+                }
+                ss.digest = fc::sha256::hash(m);
+                result.emplace_back(std::move(ss));
+            }
+            catch(...) {
+                fc_wlog(logger, "Cannot serve snapshot ${p}", ("p", it->path().generic_string()));
+            }
+        }
+        std::sort(result.begin(), result.end(), [](auto& l, auto& r) {
+            return l.manifest.head_block_num > r.manifest.head_block_num;
+        });
+
+        app().post(priority::low, [this, result = std::move(result)]() mutable {
+            refresh_running = false;
+            if(my_impl->done) {
+                return;
+            }
+            for(auto& s : result) {
+                auto it = std::find_if(served.begin(), served.end(), [&](auto& ss) { return ss.digest == s.digest; });
+                if(it == served.end()) {
+                    fc_ilog(logger, "Serving snapshot of block #${n} ${id}, manifest digest: ${d}",
+                            ("n", s.manifest.head_block_num)("id", s.manifest.head_block_id)("d", s.digest));
+                }
+            }
+            served = std::move(result);
+        });
+    });
+}
+
+void
+snapshot_sync_manager::send_list(const connection_ptr& c, const handshake_message& msg) {
+    if(!serving || c->protocol_version < proto_snapshot_sync || msg.generation != 1) {
+        return;
+    }
+
+    auto list = snapshot_list_message();
+    for(auto& s : served) {
+        if(list.snapshots.size() == def_snapshot_advertised) {
+            break;
+        }
+        if(s.manifest.head_block_num > msg.head_num) {
+            list.snapshots.emplace_back(s.manifest);
+        }
+    }
+    if(!list.snapshots.empty()) {
+        c->enqueue(list);
+    }
+}
+
+void
+snapshot_sync_manager::recv_list(const connection_ptr& c, const snapshot_list_message& msg) {
+    if(!target.has_value()) {
+        return;
+    }
+    for(auto& m : msg.snapshots) {
+        if(fc::sha256::hash(m) != *target) {
+            continue;
+        }
+        if(!manifest.has_value() && !start_fetch(m)) {
+            return;
+        }
+        if(sources.emplace(c, 0).second) {
+            peer_ilog(c, "serves the snapshot to fetch");
+        }
+        request_chunks();
+        return;
+    }
+}
+
+bool
+snapshot_sync_manager::start_fetch(const snapshot_manifest& m) {
+    if(m.head_block_num <= my_impl->chain_plug->chain().fork_db_head_block_num()) {
+        fc_ilog(logger, "Head block is already beyond the snapshot of block #${n}, give up warp sync", ("n", m.head_block_num));
+        target.reset();
+        my_impl->sync_master->send_handshakes();
+        return false;
+    }
+    if(m.chunk_size == 0 || m.chunk_size > def_send_buffer_size
+            || m.chunk_digests.size() != (m.size + m.chunk_size - 1) / m.chunk_size) {
+        fc_elog(logger, "Manifest of snapshot is invalid, it cannot be fetched");
+        return false;
+    }
+
+    if(!fc::exists(snapshots_dir)) {
+        fc::create_directories(snapshots_dir);
+    }
+    fetch_path = snapshots_dir / fc::format_string("snapshot-${id}.bin.part", fc::mutable_variant_object()("id", m.head_block_id));
+    std::ofstream(fetch_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    bfs::resize_file(fetch_path, m.size);
+    fetch_file.exceptions(std::fstream::failbit | std::fstream::badbit);
+    fetch_file.open(fetch_path.generic_string(), std::ios::in | std::ios::out | std::ios::binary);
+
+    manifest = m;
+    chunks.resize(m.chunk_digests.size());
+    received_count = 0;
+    fc_ilog(logger, "Fetching snapshot of block #${n} ${id} in ${c} chunks", ("n", m.head_block_num)("id", m.head_block_id)("c", chunks.size()));
+
+    if(chunks.empty()) {
+        finish_fetch();
+        return false;
+    }
+    return true;
+}
+
+void
+snapshot_sync_manager::request_chunks() {
+    if(!manifest.has_value()) {
+        return;
+    }
+
+    // each peer has at most def_snapshot_chunks_per_peer requests, faster peers get more chunks as they free them sooner
+    auto next = 0u;
+    for(auto& [c, n] : sources) {
+        while(n < def_snapshot_chunks_per_peer) {
+            while(next < chunks.size() && chunks[next].state != missing) {
+                next++;
+            }
+            if(next == chunks.size()) {
+                return;
+            }
+            auto& ch     = chunks[next];
+            ch.state     = requested;
+            ch.source    = c;
+            ch.requested = time_point::now();
+            n++;
+            c->enqueue(snapshot_chunk_request_message{*target, next});
+        }
+    }
+}
+
+void
+snapshot_sync_manager::release_chunk(uint32_t index) {
+    auto& ch = chunks[index];
+    auto  it = sources.find(ch.source);
+    if(it != sources.end() && it->second > 0) {
+        it->second--;
+    }
+    ch.state = missing;
+    ch.source.reset();
+}
+
+void
+snapshot_sync_manager::recv_request(const connection_ptr& c, const snapshot_chunk_request_message& msg) {
+    auto it = std::find_if(served.begin(), served.end(), [&](auto& s) { return s.digest == msg.digest; });
+    if(it == served.end() || msg.index >= it->manifest.chunk_digests.size()) {
+        c->enqueue(snapshot_chunk_message{msg.digest, msg.index, bytes()});
+        return;
+    }
+
+    auto offset = (uint64_t)msg.index * it->manifest.chunk_size;
+    auto size   = (size_t)std::min<uint64_t>(it->manifest.chunk_size, it->manifest.size - offset);
+
+    // chunk is read on net threads, it's checked by receiver against the manifest
+    boost::asio::post(*my_impl->server_ioc, [wc = connection_wptr(c), path = it->path, offset, size, msg]() {
+        auto reply = snapshot_chunk_message{msg.digest, msg.index, bytes(size)};
+        try {
+            auto in = std::ifstream(path.generic_string(), std::ios::in | std::ios::binary);
+            in.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            in.seekg(offset);
+            in.read(reply.data.data(), size);
+        }
+        catch(...) {
+            reply.data.clear();
+        }
+        app().post(priority::low, [wc, reply = std::move(reply)]() {
+            auto c = wc.lock();
+            if(c && c->connected()) {
+                c->enqueue(reply);
+            }
+        });
+    });
+}
+
+void
+snapshot_sync_manager::recv_chunk(const connection_ptr& c, const snapshot_chunk_message& msg) {
+    if(!manifest.has_value() || msg.digest != *target || msg.index >= chunks.size()) {
+        return;
+    }
+    if(chunks[msg.index].state != requested || chunks[msg.index].source != c) {
+        // late reply of a chunk requested from another peer since
+        return;
+    }
+    release_chunk(msg.index);
+
+    if(msg.data.empty()) {
+        peer_wlog(c, "doesn't serve the snapshot anymore");
+        close(c);
+        return;
+    }
+
+    auto offset = (uint64_t)msg.index * manifest->chunk_size;
+    auto size   = std::min<uint64_t>(manifest->chunk_size, manifest->size - offset);
+    if(msg.data.size() != size || fc::sha256::hash(msg.data.data(), msg.data.size()) != manifest->chunk_digests[msg.index]) {
+        peer_elog(c, "sent invalid snapshot chunk, closing connection");
+        my_impl->close(c);
         return;
     }
-    for(auto& conn : my_impl->connections) {
-        if(conn == c || conn->last_req) {
-            continue;
-        }
-        bool sendit = false;
-        if(is_txn) {
-            auto trx = conn->trx_state.get<by_id>().find(tid);
-            sendit   = trx != conn->trx_state.end();
-        }
-        else {
-            sendit = conn->peer_has_block(bid);
-        }
-        if(sendit) {
-            conn->enqueue(*c->last_req);
-            conn->fetch_wait();
-            conn->last_req = c->last_req;
-            return;
-        }
+
+    fetch_file.seekp(offset);
+    fetch_file.write(msg.data.data(), msg.data.size());
+    chunks[msg.index].state = received;
+    if(++received_count == chunks.size()) {
+        finish_fetch();
+        return;
     }
+    request_chunks();
+}
 
-    // at this point no other peer has it, re-request or do nothing?
-    if(c->connected()) {
-        c->enqueue(*c->last_req);
-        c->fetch_wait();
+void
+snapshot_sync_manager::finish_fetch() {
+    fetch_file.close();
+    auto path = fetch_path;
+    path.replace_extension();  // drops .part
+    bfs::rename(fetch_path, path);
+
+    fc_ilog(logger, "Snapshot of block #${n} is fetched to ${p}", ("n", manifest->head_block_num)("p", path.generic_string()));
+    fc_ilog(logger, "Restart with --delete-all-blocks --snapshot ${p} --token-db-snapshot-ingest to restore from it and sync the rest blocks",
+            ("p", path.generic_string()));
+
+    target.reset();
+    manifest.reset();
+    chunks.clear();
+    sources.clear();
+    app().quit();
+}
+
+void
+snapshot_sync_manager::close(const connection_ptr& c) {
+    if(sources.erase(c) == 0) {
+        return;
+    }
+    for(auto i = 0u; i < chunks.size(); i++) {
+        if(chunks[i].state == requested && chunks[i].source == c) {
+            chunks[i].state = missing;
+            chunks[i].source.reset();
+        }
     }
+    request_chunks();
 }
 
 //------------------------------------------------------------------------
@@ -1919,7 +3222,7 @@ net_plugin_impl::connect(const connection_ptr& c, tcp::resolver::iterator endpoi
     ++endpoint_itr;
     c->connecting             = true;
     connection_wptr weak_conn = c;
-    c->socket->async_connect(current_endpoint, [weak_conn, endpoint_itr, this](const boost::system::error_code& err) {
+    c->socket->async_connect(current_endpoint, boost::asio::bind_executor(c->strand, [weak_conn, endpoint_itr, this](const boost::system::error_code& err) {
         app().post(priority::low, [weak_conn, endpoint_itr, this, err]() {
             auto c = weak_conn.lock();
             if(!c)
@@ -1941,7 +3244,7 @@ net_plugin_impl::connect(const connection_ptr& c, tcp::resolver::iterator endpoi
                 }
             }
         });
-    });
+    }));
 }
 
 bool
@@ -2091,63 +3394,39 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
         ++conn->reads_in_flight;
         boost::asio::async_read(*conn->socket,
             conn->pending_message_buffer.get_buffer_sequence_for_boost_async_read(), completion_handler,
-            [this, weak_conn](boost::system::error_code ec, std::size_t bytes_transferred) {
-                app().post(priority::medium, [this,weak_conn, ec, bytes_transferred]() {
+            boost::asio::bind_executor(conn->strand, [this, weak_conn](boost::system::error_code ec, std::size_t bytes_transferred) {
+                auto conn = weak_conn.lock();
+                if(!conn) {
+                    return;
+                }
+
+                // messages are decoded here, app thread only handles them
+                auto msgs  = vector<decoded_message>();
+                auto error = string();
+                if(!ec) {
+                    error = decode_messages(conn, bytes_transferred, msgs);
+                }
+
+                post_lane(app_lane::net, [this, weak_conn, ec, bytes_transferred, msgs = std::move(msgs), error = std::move(error)]() mutable {
                     auto conn = weak_conn.lock();
                     if(!conn) {
                         return;
                     }
 
                     --conn->reads_in_flight;
-                    conn->outstanding_read_bytes.reset();
+                    conn->counters.bytes_in += bytes_transferred;
 
                     try {
-                        if(!ec) {
-                            if(bytes_transferred > conn->pending_message_buffer.bytes_to_write()) {
-                                fc_elog(logger, "async_read_some callback: bytes_transfered = ${bt}, buffer.bytes_to_write = ${btw}",
-                                     ("bt", bytes_transferred)("btw", conn->pending_message_buffer.bytes_to_write()));
-                            }
-                            EVT_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
-                            conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
-                            while(conn->pending_message_buffer.bytes_to_read() > 0) {
-                                uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
-
-                                if(bytes_in_buffer < message_header_size) {
-                                    conn->outstanding_read_bytes.emplace(message_header_size - bytes_in_buffer);
-                                    break;
-                                }
-                                else {
-                                    uint32_t message_length;
-                                    auto     index = conn->pending_message_buffer.read_index();
-                                    conn->pending_message_buffer.peek(&message_length, sizeof(message_length), index);
-                                    if(message_length > def_send_buffer_size * 2 || message_length == 0) {
-                                        boost::system::error_code ec;
-                                        fc_elog(logger, "incoming message length unexpected (${i}), from ${p}",
-                                             ("i", message_length)("p", boost::lexical_cast<std::string>(conn->socket->remote_endpoint(ec))));
-                                        close(conn);
-                                        return;
-                                    }
-
-                                    auto total_message_bytes = message_length + message_header_size;
-
-                                    if(bytes_in_buffer >= total_message_bytes) {
-                                        conn->pending_message_buffer.advance_read_ptr(message_header_size);
-                                        if(!process_next_message(conn, message_length)) {
-                                            return;
-                                        }
-                                    }
-                                    else {
-                                        auto outstanding_message_bytes = total_message_bytes - bytes_in_buffer;
-                                        auto available_buffer_bytes    = conn->pending_message_buffer.bytes_to_write();
-                                        if(outstanding_message_bytes > available_buffer_bytes) {
-                                            conn->pending_message_buffer.add_space(outstanding_message_bytes - available_buffer_bytes);
-                                        }
-
-                                        conn->outstanding_read_bytes.emplace(outstanding_message_bytes);
-                                        break;
-                                    }
-                                }
+                        for(auto& m : msgs) {
+                            if(!process_next_message(conn, m)) {
+                                return;
                             }
+                        }
+                        if(!error.empty()) {
+                            fc_elog(logger, "Error decoding messages from ${p}: ${e}", ("p", conn->peer_name())("e", error));
+                            close(conn);
+                        }
+                        else if(!ec) {
                             start_read_message(conn);
                         }
                         else {
@@ -2177,7 +3456,7 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
                         close(conn);
                     }
                 });
-        });
+        }));
     }
     catch(...) {
         string pname = conn ? conn->peer_name() : "no connection name";
@@ -2186,39 +3465,130 @@ net_plugin_impl::start_read_message(const connection_ptr& conn) {
     }
 }
 
+string
+net_plugin_impl::decode_messages(const connection_ptr& conn, std::size_t bytes_transferred, vector<decoded_message>& msgs) {
+    std::lock_guard<std::mutex> lock(conn->read_mutex);
+    try {
+        conn->outstanding_read_bytes.reset();
+
+        if(bytes_transferred > conn->pending_message_buffer.bytes_to_write()) {
+            fc_elog(logger, "async_read_some callback: bytes_transfered = ${bt}, buffer.bytes_to_write = ${btw}",
+                 ("bt", bytes_transferred)("btw", conn->pending_message_buffer.bytes_to_write()));
+        }
+        EVT_ASSERT(bytes_transferred <= conn->pending_message_buffer.bytes_to_write(), plugin_exception, "");
+        conn->pending_message_buffer.advance_write_ptr(bytes_transferred);
+        while(conn->pending_message_buffer.bytes_to_read() > 0) {
+            uint32_t bytes_in_buffer = conn->pending_message_buffer.bytes_to_read();
+
+            if(bytes_in_buffer < message_header_size) {
+                conn->outstanding_read_bytes.emplace(message_header_size - bytes_in_buffer);
+                break;
+            }
+
+            uint32_t message_length;
+            auto     index = conn->pending_message_buffer.read_index();
+            conn->pending_message_buffer.peek(&message_length, sizeof(message_length), index);
+            if(message_length > def_send_buffer_size * 2 || message_length == 0) {
+                return "incoming message length unexpected (" + std::to_string(message_length) + ")";
+            }
+
+            auto total_message_bytes = message_length + message_header_size;
+
+            if(bytes_in_buffer >= total_message_bytes) {
+                conn->pending_message_buffer.advance_read_ptr(message_header_size);
+
+                auto m  = decoded_message();
+                auto ds = conn->pending_message_buffer.create_datastream();
+                fc::raw::unpack(ds, m.msg);
+                if(m.msg.contains<signed_block>()) {
+                    const auto& b = m.msg.get<signed_block>();
+                    m.blk_id      = b.id();
+                    m.blk_num     = b.block_num();
+                }
+                else if(m.msg.contains<transaction_batch_message>()) {
+                    // expanded here so that decompressing and unpacking stay off the app thread
+                    for(auto& trx : unpack_trx_batch(m.msg.get<transaction_batch_message>())) {
+                        if(!prefilter_trx(conn, trx)) {
+                            continue;
+                        }
+                        auto tm = decoded_message();
+                        tm.msg  = net_message(std::move(trx));
+                        msgs.emplace_back(std::move(tm));
+                    }
+                    continue;
+                }
+                else if(m.msg.contains<packed_transaction>()) {
+                    if(!prefilter_trx(conn, m.msg.get<packed_transaction>())) {
+                        continue;
+                    }
+                }
+                msgs.emplace_back(std::move(m));
+            }
+            else {
+                auto outstanding_message_bytes = total_message_bytes - bytes_in_buffer;
+                auto available_buffer_bytes    = conn->pending_message_buffer.bytes_to_write();
+                if(outstanding_message_bytes > available_buffer_bytes) {
+                    conn->pending_message_buffer.add_space(outstanding_message_bytes - available_buffer_bytes);
+                }
+
+                conn->outstanding_read_bytes.emplace(outstanding_message_bytes);
+                break;
+            }
+        }
+    }
+    catch(const fc::exception& e) {
+        return e.to_detail_string();
+    }
+    catch(const std::exception& e) {
+        return e.what();
+    }
+    catch(...) {
+        return "unknown exception";
+    }
+    return string();
+}
+
+bool
+net_plugin_impl::prefilter_trx(const connection_ptr& conn, const packed_transaction& trx) {
+    if(!prefilter) {
+        return true;
+    }
+    if(auto why = prefilter->check(trx)) {
+        peer_dlog(conn, "dropped relayed transaction ${id}: ${why}", ("id", trx.id())("why", why));
+        return false;
+    }
+    return true;
+}
+
+void
+net_plugin_impl::forget_prefiltered(const transaction_id_type& id) {
+    if(prefilter) {
+        prefilter->forget(id);
+    }
+}
+
 bool
-net_plugin_impl::process_next_message(const connection_ptr& conn, uint32_t message_length) {
+net_plugin_impl::process_next_message(const connection_ptr& conn, decoded_message& m) {
+    conn->counters.msgs_in[m.msg.which()]++;
     try {
-        // if next message is a block we already have, exit early
-        auto peek_ds = conn->pending_message_buffer.create_peek_datastream();
-        unsigned_int which{};
-        fc::raw::unpack(peek_ds, which);
-        if(which == signed_block_which) {
-            block_header bh;
-            fc::raw::unpack(peek_ds, bh);
-
-            controller&   cc      = chain_plug->chain();
-            block_id_type blk_id  = bh.id();
-            uint32_t      blk_num = bh.block_num();
-            if(cc.fetch_block_by_id(blk_id)) {
-                sync_master->recv_block(conn, blk_id, blk_num);
-                conn->pending_message_buffer.advance_read_ptr(message_length);
+        // if next message is a block we already have, skip it
+        if(m.msg.contains<signed_block>()) {
+            controller& cc = chain_plug->chain();
+            if(cc.fetch_block_by_id(m.blk_id)) {
+                sync_master->recv_block(conn, m.blk_id, m.blk_num);
                 return true;
             }
         }
 
-        auto ds = conn->pending_message_buffer.create_datastream();
-        net_message msg;
-        fc::raw::unpack(ds, msg);
-        msg_handler m(*this, conn);
-        if(msg.contains<signed_block>()) {
-            m(std::move(msg.get<signed_block>()));
+        msg_handler h(*this, conn);
+        if(m.msg.contains<signed_block>()) {
+            h(std::move(m.msg.get<signed_block>()));
         }
-        else if(msg.contains<packed_transaction>()) {
-            m(std::move(msg.get<packed_transaction>()));
+        else if(m.msg.contains<packed_transaction>()) {
+            h(std::move(m.msg.get<packed_transaction>()));
         }
         else {
-            msg.visit(m);
+            m.msg.visit(h);
         }
     }
     catch(const fc::exception& e) {
@@ -2242,9 +3612,15 @@ net_plugin_impl::count_open_sockets() const {
 template<typename VerifierFunc>
 void
 net_plugin_impl::send_transaction_to_all(const std::shared_ptr<std::vector<char>>& send_buffer, VerifierFunc verify) {
+    auto batch = trx_batch_period.count() > 0;
     for(auto& c : connections) {
         if(c->current() && verify(c)) {
-            c->enqueue_buffer(send_buffer, true, priority::low, no_reason);
+            if(batch && c->protocol_version >= proto_trx_batch) {
+                c->add_to_trx_batch(send_buffer);
+            }
+            else {
+                c->enqueue_buffer(send_buffer, true, priority::low, no_reason);
+            }
         }
     }
 }
@@ -2386,6 +3762,13 @@ net_plugin_impl::handle_message(const connection_ptr& c, const handshake_message
 
     c->last_handshake_recv = msg;
     c->_logger_variant.reset();
+    snapshot_sync->send_list(c, msg);
+    if(msg.generation == 1 && c->protocol_version >= proto_block_range) {
+        auto first = chain_plug->chain().earliest_available_block_num();
+        if(first > 1) {
+            c->enqueue(block_range_message{first});
+        }
+    }
     sync_master->recv_handshake(c, msg);
 }
 
@@ -2428,6 +3811,13 @@ net_plugin_impl::handle_message(const connection_ptr& c, const time_message& msg
     }
 
     c->offset = (double(c->rec - c->org) + double(msg.xmt - c->dst)) / 2;
+    // time spent on the peer is excluded from the round trip
+    auto rtt = (msg.dst - msg.org) - (msg.xmt - msg.rec);
+    if(rtt >= 0) {
+        auto us = fc::microseconds(rtt / 1000);
+        c->counters.rtt.add(us);
+        c->smoothed_rtt = c->smoothed_rtt.count() == 0 ? us : fc::microseconds((c->smoothed_rtt.count() * 7 + us.count()) / 8);
+    }
     double NsecPerUsec{1000};
 
     if(logger.is_enabled(fc::log_level::all))
@@ -2540,16 +3930,198 @@ net_plugin_impl::handle_message(const connection_ptr& c, const request_message&
 
 void
 net_plugin_impl::handle_message(const connection_ptr& c, const sync_request_message& msg) {
+    if(msg.end_block != 0) {
+        // blocks are not half served, the peer requests the whole range from others
+        auto first = chain_plug->chain().earliest_available_block_num();
+        if(msg.start_block < first) {
+            peer_wlog(c, "requested blocks ${s} to ${e} are pruned, the first one kept is ${f}",
+                      ("s", msg.start_block)("e", msg.end_block)("f", first));
+            if(c->protocol_version >= proto_block_range) {
+                c->enqueue(block_range_message{first});
+            }
+            return;
+        }
+    }
     if(msg.end_block == 0) {
         c->peer_requested.reset();
+        c->peer_requested_next.clear();
         c->flush_queues();
     }
+    else if(c->peer_requested.has_value() && c->protocol_version >= proto_pipelined_sync) {
+        c->peer_requested_next.emplace_back(msg.start_block, msg.end_block, msg.start_block - 1);
+    }
     else {
         c->peer_requested = sync_state(msg.start_block, msg.end_block, msg.start_block - 1);
         c->enqueue_sync_block();
     }
 }
 
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const transaction_batch_message& msg) {
+    peer_ilog(c, "received transaction_batch_message");
+    for(auto& trx : unpack_trx_batch(msg)) {
+        handle_message(c, make_message<packed_transaction>(std::move(trx)));
+    }
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const transaction_filter_message& msg) {
+    if(!valid_trx_filter(msg.filter)) {
+        peer_elog(c, "Invalid transaction_filter_message, closing connection");
+        close(c);
+        return;
+    }
+    peer_dlog(c, "received transaction filter of ${n} bytes", ("n", msg.filter.bit_table_.size()));
+    c->peer_trxs = msg.filter;
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_list_message& msg) {
+    peer_dlog(c, "received snapshot_list_message of ${n} snapshots", ("n", msg.snapshots.size()));
+    snapshot_sync->recv_list(c, msg);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_chunk_request_message& msg) {
+    snapshot_sync->recv_request(c, msg);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const snapshot_chunk_message& msg) {
+    snapshot_sync->recv_chunk(c, msg);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const block_range_message& msg) {
+    peer_dlog(c, "received block_range_message, first block is ${f}", ("f", msg.first_block_num));
+    c->peer_first_block = msg.first_block_num;
+    sync_master->recv_block_range(c);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const compact_block_message& msg) {
+    auto blk_id  = msg.header.id();
+    auto blk_num = msg.header.block_num();
+    peer_ilog(c, "received compact_block_message : #${n} with ${t} transactions", ("n", blk_num)("t", msg.receipts.size()));
+
+    controller& cc = chain_plug->chain();
+    if(cc.fetch_block_by_id(blk_id)) {
+        c->cancel_wait();
+        sync_master->recv_block(c, blk_id, blk_num);
+        return;
+    }
+
+    auto pending  = pending_compact_block();
+    pending.id    = blk_id;
+    pending.block = make_message<signed_block>(msg.header);
+    pending.block->block_extensions = msg.block_extensions;
+    pending.block->transactions.resize(msg.receipts.size());
+
+    auto& idx = local_txns.get<by_short_id>();
+    for(auto i = 0u; i < msg.receipts.size(); i++) {
+        auto& cr = msg.receipts[i];
+        auto& r  = pending.block->transactions[i];
+        r.status = cr.status;
+        r.type   = cr.type;
+        if(cr.trx.has_value()) {
+            r.trx = *cr.trx;
+            continue;
+        }
+        // ambiguous short ids are treated as missing
+        auto range = idx.equal_range(cr.short_id);
+        if(range.first != range.second && std::next(range.first) == range.second && range.first->serialized_txn) {
+            r.trx = unpack_trx_buffer(*range.first->serialized_txn);
+        }
+        else {
+            pending.missing.emplace_back(i);
+        }
+    }
+
+    if(pending.missing.empty()) {
+        accept_compact_block(c, pending);
+        return;
+    }
+    if(c->compact_block.has_value()) {
+        peer_wlog(c, "compact block ${id} is replaced before its transactions are received", ("id", c->compact_block->id));
+    }
+    peer_dlog(c, "requesting ${m} missing transactions of compact block #${n}", ("m", pending.missing.size())("n", blk_num));
+
+    auto req    = compact_block_request_message();
+    req.id      = blk_id;
+    req.indexes = pending.missing;
+    c->compact_block.emplace(std::move(pending));
+    c->enqueue(req);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const compact_block_request_message& msg) {
+    auto resp = compact_block_response_message();
+    resp.id   = msg.id;
+
+    controller& cc = chain_plug->chain();
+    if(auto b = cc.fetch_block_by_id(msg.id)) {
+        resp.trxs.reserve(msg.indexes.size());
+        for(auto i : msg.indexes) {
+            if(i >= b->transactions.size()) {
+                peer_elog(c, "Invalid compact_block_request_message, index ${i} is out of range", ("i", i));
+                resp.trxs.clear();
+                break;
+            }
+            resp.trxs.emplace_back(b->transactions[i].trx);
+        }
+    }
+    else {
+        peer_ilog(c, "requested compact block ${id} is unknown", ("id", msg.id));
+    }
+    c->enqueue_buffer(create_send_buffer(compact_block_response_which, resp), true, priority::high, no_reason);
+}
+
+void
+net_plugin_impl::handle_message(const connection_ptr& c, const compact_block_response_message& msg) {
+    if(!c->compact_block.has_value() || c->compact_block->id != msg.id) {
+        peer_wlog(c, "received transactions of unexpected compact block ${id}", ("id", msg.id));
+        return;
+    }
+
+    auto pending = std::move(*c->compact_block);
+    c->compact_block.reset();
+
+    if(msg.trxs.size() != pending.missing.size()) {
+        peer_wlog(c, "peer cannot provide transactions of compact block ${id}", ("id", msg.id));
+        request_full_block(c, msg.id);
+        return;
+    }
+    for(auto i = 0u; i < msg.trxs.size(); i++) {
+        pending.block->transactions[pending.missing[i]].trx = msg.trxs[i];
+    }
+    accept_compact_block(c, pending);
+}
+
+void
+net_plugin_impl::accept_compact_block(const connection_ptr& c, const pending_compact_block& pending) {
+    auto digests = vector<digest_type>();
+    digests.reserve(pending.block->transactions.size());
+    for(auto& r : pending.block->transactions) {
+        digests.emplace_back(r.digest());
+    }
+    if(merkle(std::move(digests)) != pending.block->transaction_mroot) {
+        // short ids are matched to wrong transactions
+        peer_wlog(c, "rebuilt compact block ${id} mismatches its transactions", ("id", pending.id));
+        request_full_block(c, pending.id);
+        return;
+    }
+    handle_message(c, pending.block);
+}
+
+void
+net_plugin_impl::request_full_block(const connection_ptr& c, const block_id_type& id) {
+    auto req = request_message();
+    req.req_blocks.mode = normal;
+    req.req_blocks.ids.emplace_back(id);
+    req.req_trx.mode = none;
+    c->enqueue(req);
+}
+
 size_t
 calc_trx_size(const packed_transaction_ptr& trx) {
     // transaction is stored packed and unpacked, double packed_size and size of signed as an approximation of use
@@ -2563,10 +4135,12 @@ net_plugin_impl::handle_message(const connection_ptr& c, const packed_transactio
     controller& cc = my_impl->chain_plug->chain();
     if(cc.get_read_mode() == evt::db_read_mode::READ_ONLY) {
         fc_dlog(logger, "got a txn in read-only mode - dropping");
+        forget_prefiltered(trx->id());
         return;
     }
     if(sync_master->is_active(c)) {
         fc_dlog(logger, "got a txn during sync - dropping");
+        forget_prefiltered(trx->id());
         return;
     }
 
@@ -2578,6 +4152,7 @@ net_plugin_impl::handle_message(const connection_ptr& c, const packed_transactio
         return;
     }
     dispatcher->recv_transaction(c, tid);
+    c->known_trxs.insert(tid);
     c->trx_in_progress_size += calc_trx_size(ptrx->packed_trx);
     chain_plug->accept_transaction(ptrx, [c, this, ptrx](const static_variant<fc::exception_ptr, transaction_trace_ptr>& result) {
         c->trx_in_progress_size -= calc_trx_size(ptrx->packed_trx);
@@ -2618,6 +4193,15 @@ net_plugin_impl::handle_message(const connection_ptr& c, const signed_block_ptr&
         fc_elog(logger, "Caught an unknown exception trying to recall blockID");
     }
 
+    if(sync_master->is_active(c)) {
+        c->counters.sync_blocks_in++;
+    }
+
+    // blocks of sync chunks received ahead are applied once the ones before them are
+    if(sync_master->buffer_block(c, msg, blk_num)) {
+        return;
+    }
+
     dispatcher->recv_block(c, blk_id, blk_num);
     fc::microseconds age(fc::time_point::now() - msg->timestamp);
     peer_ilog(c, "received signed_block : #${n} block age in secs = ${age}",
@@ -2659,10 +4243,6 @@ net_plugin_impl::handle_message(const connection_ptr& c, const signed_block_ptr&
             if(ltx != local_txns.end()) {
                 local_txns.modify(ltx, ubn);
             }
-            auto ctx = c->trx_state.get<by_id>().find(id);
-            if(ctx != c->trx_state.end()) {
-                c->trx_state.modify(ctx, ubn);
-            }
         }
         sync_master->recv_block(c, blk_id, blk_num);
     }
@@ -2692,8 +4272,7 @@ void
 net_plugin_impl::start_txn_timer() {
     transaction_check->expires_from_now(txn_exp_period);
     transaction_check->async_wait([this](boost::system::error_code ec) {
-        int lower_than_low = priority::low - 1;
-        app().post(lower_than_low, [this, ec]() {
+        post_lane(app_lane::background, [this, ec]() {
             if(!ec) {
                 expire_txns();
             }
@@ -2705,6 +4284,67 @@ net_plugin_impl::start_txn_timer() {
     });
 }
 
+void
+net_plugin_impl::start_trx_batch_timer() {
+    if(trx_batch_timer_running) {
+        return;
+    }
+    trx_batch_timer_running = true;
+    trx_batch_timer->expires_from_now(trx_batch_period);
+    trx_batch_timer->async_wait([this](boost::system::error_code ec) {
+        app().post(priority::low, [this]() {
+            trx_batch_timer_running = false;
+            if(done) {
+                return;
+            }
+            for(auto& c : connections) {
+                c->flush_trx_batch();
+            }
+        });
+    });
+}
+
+void
+net_plugin_impl::start_trx_filter_timer() {
+    trx_filter_timer->expires_from_now(trx_filter_period);
+    trx_filter_timer->async_wait([this](boost::system::error_code ec) {
+        app().post(priority::low, [this, ec]() {
+            if(done) {
+                return;
+            }
+            start_trx_filter_timer();
+            if(ec || seen_trxs->inserted() == seen_trxs_sent) {
+                return;
+            }
+            seen_trxs_sent = seen_trxs->inserted();
+
+            auto buff = std::shared_ptr<std::vector<char>>();
+            for(auto& c : connections) {
+                if(c->current() && c->protocol_version >= proto_trx_filter) {
+                    if(!buff) {
+                        buff = create_send_buffer(transaction_filter_which, transaction_filter_message{seen_trxs->snapshot()});
+                    }
+                    c->enqueue_buffer(buff, true, priority::low, no_reason);
+                }
+            }
+        });
+    });
+}
+
+void
+net_plugin_impl::start_snapshot_timer() {
+    snapshot_timer->expires_from_now(def_snapshot_tick);
+    snapshot_timer->async_wait([this](boost::system::error_code ec) {
+        app().post(priority::low, [this, ec]() {
+            if(done || ec) {
+                return;
+            }
+            start_snapshot_timer();
+            snapshot_sync->tick();
+        });
+    });
+}
+
 void
 net_plugin_impl::ticker() {
     keepalive_timer->expires_from_now(keepalive_interval);
@@ -2744,10 +4384,6 @@ net_plugin_impl::expire_txns() {
     uint32_t    lib = cc.last_irreversible_block_num();
     dispatcher->expire_blocks(lib);
     for(auto& c : connections) {
-        auto& stale_txn = c->trx_state.get<by_block_num>();
-        stale_txn.erase(stale_txn.lower_bound(1), stale_txn.upper_bound(lib));
-        auto& stale_txn_e = c->trx_state.get<by_expiry>();
-        stale_txn_e.erase(stale_txn_e.lower_bound(time_point_sec()), stale_txn_e.upper_bound(time_point::now()));
         auto& stale_blk = c->blk_state.get<by_block_num>();
         stale_blk.erase(stale_blk.lower_bound(1), stale_blk.upper_bound(lib));
     }
@@ -2811,9 +4447,17 @@ net_plugin_impl::close(const connection_ptr& c) {
 void
 net_plugin_impl::accepted_block(const block_state_ptr& block) {
     fc_dlog(logger, "signaled, id = ${id}", ("id", block->id));
+    if(prefilter) {
+        prefilter->accepted_block(chain_plug->chain(), block);
+    }
     dispatcher->bcast_block(block);
 }
 
+void
+net_plugin_impl::irreversible_block(const block_state_ptr& block) {
+    prefilter->irreversible_block(block);
+}
+
 void
 net_plugin_impl::transaction_ack(const std::pair<fc::exception_ptr, transaction_metadata_ptr>& results) {
     const auto& id = results.second->id;
@@ -2976,7 +4620,22 @@ net_plugin::set_program_options(options_description& /*cli*/, options_descriptio
         ("max-cleanup-time-msec", bpo::value<int>()->default_value(10), "max connection cleanup time per cleanup call in millisec")
         ("network-version-match", bpo::value<bool>()->default_value(false), "True to require exact match of peer network version.")
         ("sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+        ("sync-max-peers", bpo::value<uint32_t>()->default_value(def_sync_max_peers), "Maximum number of peers blocks are retrieved from in parallel during synchronization")
         ("use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable expirimental socket read watermark optimization")
+        ("net-threads", bpo::value<uint16_t>()->default_value(def_net_threads), "Number of threads doing socket I/O and decoding messages of connections")
+        ("p2p-trx-batch-ms", bpo::value<uint32_t>()->default_value(def_trx_batch_ms), "Milliseconds relayed transactions are collected into one batch for each peer, use 0 to send them one by one")
+        ("p2p-trx-batch-size", bpo::value<uint32_t>()->default_value(def_trx_batch_size), "Maximum number of transactions in one batch, the batch is sent once it's full")
+        ("p2p-trx-batch-compress", bpo::value<bool>()->default_value(true), "True to compress transaction batches with zstd")
+        ("p2p-compact-blocks", bpo::value<bool>()->default_value(true), "True to relay blocks to capable peers with the short ids of their transactions instead of the transactions")
+        ("p2p-relay-next-producers", bpo::value<uint32_t>()->default_value(2),
+            "Number of upcoming producers whose connections get new blocks first, then the other producers and relays by round trip time; 0 to relay in connection order")
+        ("p2p-trx-filter-ms", bpo::value<uint32_t>()->default_value(def_trx_filter_ms), "Milliseconds between sending the bloom filter of transactions seen lately to peers, use 0 to disable")
+        ("p2p-trx-prefilter", bpo::value<bool>()->default_value(true), "Drop relayed transactions surely rejected by chain, such as expired or duplicate ones, before they are passed to chain")
+        ("p2p-snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
+            "The location of the snapshots served to peers and fetched from them (absolute path or relative to application data dir)")
+        ("p2p-serve-snapshots", bpo::value<bool>()->default_value(true), "True to serve the full snapshots in p2p-snapshots-dir to the peers behind them for warp sync")
+        ("warp-sync-snapshot", bpo::value<string>(),
+            "Digest of the manifest of a snapshot published by producers, the snapshot is fetched from peers before syncing blocks and the node quits to be restarted from it")
         ("peer-log-format", bpo::value<string>()->default_value("[\"${_name}\" ${_ip}:${_port}]"),
             "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
             "Available Variables:\n"
@@ -3004,9 +4663,22 @@ net_plugin::plugin_initialize(const variables_map& options) {
 
         my->network_version_match = options.at("network-version-match").as<bool>();
 
-        my->sync_master.reset(new sync_manager(options.at("sync-fetch-span").as<uint32_t>()));
+        auto sync_max_peers = options.at("sync-max-peers").as<uint32_t>();
+        EVT_ASSERT(sync_max_peers > 0, plugin_config_exception,
+                   "sync-max-peers ${num} must be greater than 0", ("num", sync_max_peers));
+        my->sync_master.reset(new sync_manager(options.at("sync-fetch-span").as<uint32_t>(), sync_max_peers));
         my->dispatcher.reset(new dispatch_manager);
 
+        auto snapshots_dir = options.at("p2p-snapshots-dir").as<bfs::path>();
+        if(snapshots_dir.is_relative()) {
+            snapshots_dir = app().data_dir() / snapshots_dir;
+        }
+        auto warp_digest = optional<fc::sha256>();
+        if(options.count("warp-sync-snapshot")) {
+            warp_digest = fc::sha256(options.at("warp-sync-snapshot").as<string>());
+        }
+        my->snapshot_sync.reset(new snapshot_sync_manager(snapshots_dir, options.at("p2p-serve-snapshots").as<bool>(), warp_digest));
+
         my->connector_period     = std::chrono::seconds(options.at("connection-cleanup-period").as<int>());
         my->max_cleanup_time_ms  = options.at("max-cleanup-time-msec").as<int>();
         my->txn_exp_period       = def_txn_expire_wait;
@@ -3018,6 +4690,23 @@ net_plugin::plugin_initialize(const variables_map& options) {
 
         my->use_socket_read_watermark = options.at("use-socket-read-watermark").as<bool>();
 
+        my->thread_pool_size = options.at("net-threads").as<uint16_t>();
+        EVT_ASSERT(my->thread_pool_size > 0, plugin_config_exception,
+                   "net-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+
+        my->trx_batch_period   = std::chrono::milliseconds(options.at("p2p-trx-batch-ms").as<uint32_t>());
+        my->trx_batch_size     = options.at("p2p-trx-batch-size").as<uint32_t>();
+        my->trx_batch_compress = options.at("p2p-trx-batch-compress").as<bool>();
+        my->use_compact_blocks = options.at("p2p-compact-blocks").as<bool>();
+        my->relay_next_producers = options.at("p2p-relay-next-producers").as<uint32_t>();
+        my->trx_filter_period  = std::chrono::milliseconds(options.at("p2p-trx-filter-ms").as<uint32_t>());
+        my->seen_trxs          = std::make_unique<rolling_trx_filter>(def_trx_filter_size);
+        if(options.at("p2p-trx-prefilter").as<bool>()) {
+            my->prefilter = std::make_unique<trx_prefilter>();
+        }
+        EVT_ASSERT(my->trx_batch_size > 0, plugin_config_exception,
+                   "p2p-trx-batch-size ${num} must be greater than 0", ("num", my->trx_batch_size));
+
         if(options.count("p2p-listen-endpoint") && options.at("p2p-listen-endpoint").as<string>().length()) {
             my->p2p_address = options.at("p2p-listen-endpoint").as<string>();
         }
@@ -3081,9 +4770,12 @@ net_plugin::plugin_startup() {
 
     my->server_ioc = std::make_shared<boost::asio::io_context>();
     my->server_ioc_work.emplace(boost::asio::make_work_guard(*my->server_ioc));
-    my->server_thread.emplace([ioc = my->server_ioc] {
-        ioc->run();
-    });
+    for(auto i = 0u; i < my->thread_pool_size; i++) {
+        my->server_threads.emplace_back([ioc = my->server_ioc] {
+            evt::utilities::place_current_thread("net");
+            ioc->run();
+        });
+    }
 
     my->resolver = std::make_shared<tcp::resolver>(std::ref(*my->server_ioc));
     if(my->p2p_address.size() > 0) {
@@ -3114,6 +4806,14 @@ net_plugin::plugin_startup() {
     }
 
     my->keepalive_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
+    my->trx_batch_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
+    my->trx_filter_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
+    if(my->trx_filter_period.count() > 0) {
+        my->start_trx_filter_timer();
+    }
+    my->snapshot_timer.reset(new boost::asio::steady_timer(*my->server_ioc));
+    my->snapshot_sync->start();
+    my->start_snapshot_timer();
     my->ticker();
 
     if(my->acceptor) {
@@ -3134,6 +4834,9 @@ net_plugin::plugin_startup() {
     chain::controller& cc = my->chain_plug->chain();
     {
         cc.accepted_block.connect(boost::bind(&net_plugin_impl::accepted_block, my.get(), _1));
+        if(my->prefilter) {
+            cc.irreversible_block.connect(boost::bind(&net_plugin_impl::irreversible_block, my.get(), _1));
+        }
     }
 
     my->incoming_transaction_ack_subscription = app().get_channel<channels::transaction_ack>().subscribe(boost::bind(&net_plugin_impl::transaction_ack, my.get(), _1));
@@ -3145,6 +4848,17 @@ net_plugin::plugin_startup() {
 
     my->start_monitors();
 
+    if(memory_accounting::instance().enabled()) {
+        // buffers of connections are only touched on main thread
+        memory_accounting::instance().add_probe("net_buffers", [this] {
+            auto bytes = uint64_t(0);
+            for(auto& c : my->connections) {
+                bytes += c->buffer_queue.write_queue_size() + c->pending_message_buffer.total_bytes();
+            }
+            return bytes;
+        });
+    }
+
     for(auto seed_node : my->supplied_peers) {
         connect(seed_node);
     }
@@ -3162,6 +4876,7 @@ void
 net_plugin::plugin_shutdown() {
     try {
         fc_ilog(logger, "shutdown..");
+        memory_accounting::instance().remove_probe("net_buffers");
         if(my->server_ioc_work.has_value()) {
             my->server_ioc_work->reset();
         }
@@ -3174,6 +4889,15 @@ net_plugin::plugin_shutdown() {
         if(my->keepalive_timer) {
             my->keepalive_timer->cancel();
         }
+        if(my->trx_batch_timer) {
+            my->trx_batch_timer->cancel();
+        }
+        if(my->trx_filter_timer) {
+            my->trx_filter_timer->cancel();
+        }
+        if(my->snapshot_timer) {
+            my->snapshot_timer->cancel();
+        }
 
         my->done = true;
         if(my->acceptor) {
@@ -3191,10 +4915,10 @@ net_plugin::plugin_shutdown() {
         if(my->server_ioc) {
             my->server_ioc->stop();
         }
-        if(my->server_thread.has_value()) {
-            my->server_thread->join();
-            my->server_thread.reset();
+        for(auto& t : my->server_threads) {
+            t.join();
         }
+        my->server_threads.clear();
         fc_ilog(logger, "exit shutdown");
     }
     FC_CAPTURE_AND_RETHROW()
@@ -3251,6 +4975,62 @@ net_plugin::connections() const {
     }
     return result;
 }
+struct message_name_visitor : public fc::visitor<string> {
+    template<typename T>
+    string
+    operator()(const T&) const {
+        return fc::get_typename<T>::name();
+    }
+};
+
+vector<connection_stats>
+net_plugin::stats() const {
+    static auto names = [] {
+        auto n   = vector<string>();
+        auto msg = net_message();
+        for(auto i = 0u; i < net_message::count(); i++) {
+            msg.set_which(i);
+            n.emplace_back(msg.visit(message_name_visitor()));
+        }
+        return n;
+    }();
+
+    auto histogram = [](const latency_histogram& h) {
+        return vector<uint64_t>(h.counts.begin(), h.counts.end());
+    };
+
+    vector<connection_stats> result;
+    result.reserve(my->connections.size());
+    for(const auto& c : my->connections) {
+        auto& cs = c->counters;
+        auto  st = connection_stats();
+
+        st.peer                 = c->peer_name();
+        st.connected            = c->connected();
+        st.bytes_in             = cs.bytes_in;
+        st.bytes_out            = cs.bytes_out;
+        st.write_queue_size     = c->buffer_queue.write_queue_size();
+        st.max_write_queue_size = cs.max_write_queue_size;
+        st.sync_blocks_in       = cs.sync_blocks_in;
+        st.sync_blocks_out      = cs.sync_blocks_out;
+        st.sync_chunk_time_us   = c->sync_chunk_time.count();
+        st.write_latency_ms     = histogram(cs.write_latency);
+        st.max_write_latency_us = cs.write_latency.max.count();
+        st.rtt_ms               = histogram(cs.rtt);
+        st.last_rtt_us          = cs.rtt.last.count();
+        for(auto i = 0u; i < names.size(); i++) {
+            if(cs.msgs_in[i] > 0) {
+                st.messages_in[names[i]] = cs.msgs_in[i];
+            }
+            if(cs.msgs_out[i] > 0) {
+                st.messages_out[names[i]] = cs.msgs_out[i];
+            }
+        }
+        result.emplace_back(std::move(st));
+    }
+    return result;
+}
+
 connection_ptr
 net_plugin_impl::find_connection(const string& host) const {
     for(const auto& c : connections)
@@ -6,8 +6,11 @@
 
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
 
+#include <algorithm>
+#include <cctype>
 #include <fmt/format.h>
 #include <libpq-fe.h>
+#include <boost/algorithm/string/replace.hpp>
 #include <boost/lexical_cast.hpp>
 #include <fc/io/json.hpp>
 #include <evt/chain/block_header.hpp>
@@ -27,8 +30,9 @@ namespace evt {
  * - 1.3.0  add `ft_holders` table
  * - 1.3.1  add serveral indexes for better query performance
  * - 1.4.0  update `fungibles` to support transfer permission
+ * - 1.5.0  add `action_addresses` table
  */
-static auto pg_version = "1.4.0";
+static auto pg_version = "1.5.0";
 
 namespace internal {
 
@@ -121,13 +125,6 @@ auto create_trxs_table = R"sql(CREATE TABLE IF NOT EXISTS public.transactions
                                CREATE INDEX IF NOT EXISTS transactions_block_num_index
                                    ON public.transactions USING btree
                                    (block_num)
-                                   TABLESPACE pg_default;
-                               CREATE INDEX IF NOT EXISTS transactions_timestamp_index
-                                   ON transactions USING btree
-                                   (timestamp)
-                                   TABLESPACE pg_default;
-                               CREATE INDEX IF NOT EXISTS transactions_keys_index
-                                   ON public.transactions USING GIN (keys array_ops)
                                    TABLESPACE pg_default;)sql";
 
 auto create_actions_table = R"sql(CREATE TABLE IF NOT EXISTS public.actions
@@ -146,23 +143,22 @@ auto create_actions_table = R"sql(CREATE TABLE IF NOT EXISTS public.actions
                                   WITH (
                                       OIDS = FALSE
                                   )
-                                  TABLESPACE pg_default;
-                                  CREATE INDEX IF NOT EXISTS actions_trx_id_index
-                                      ON public.actions USING btree
-                                      (trx_id)
-                                      TABLESPACE pg_default;
-                                  CREATE INDEX IF NOT EXISTS actions_global_seq_index
-                                      ON public.actions USING btree
-                                      (global_seq)
-                                      TABLESPACE pg_default;
-                                  CREATE INDEX IF NOT EXISTS actions_data_index
-                                      ON public.actions USING gin
-                                      (data jsonb_path_ops)
-                                      TABLESPACE pg_default;
-                                  CREATE INDEX IF NOT EXISTS actions_filter_index
-                                      ON public.actions USING btree
-                                      (domain, key, name)
-                                      TABLESPACE pg_default;)sql";
+                                  TABLESPACE pg_default;)sql";
+
+// narrow index of fungible actions by the addresses involved, one row for each address of action
+auto create_action_addresses_table = R"sql(CREATE TABLE IF NOT EXISTS public.action_addresses
+                                           (
+                                               address    character(53)  NOT NULL,
+                                               sym_id     bigint         NOT NULL,
+                                               block_num  integer        NOT NULL,
+                                               trx_id     character(64)  NOT NULL,
+                                               seq_num    integer        NOT NULL,
+                                               global_seq bigint         NOT NULL
+                                           )
+                                           WITH (
+                                               OIDS = FALSE
+                                           )
+                                           TABLESPACE pg_default;)sql";
 
 auto create_metas_table = R"sql(CREATE SEQUENCE IF NOT EXISTS metas_id_seq;
                                 CREATE TABLE IF NOT EXISTS metas
@@ -214,11 +210,7 @@ auto create_tokens_table = R"sql(CREATE TABLE IF NOT EXISTS public.tokens
                                  WITH (
                                      OIDS = FALSE
                                  )
-                                 TABLESPACE pg_default;
-                                 CREATE INDEX IF NOT EXISTS tokens_owner_index
-                                     ON public.tokens USING gin
-                                     (owner array_ops)
-                                     TABLESPACE pg_default;)sql";
+                                 TABLESPACE pg_default;)sql";
 
 auto create_groups_table = R"sql(CREATE TABLE IF NOT EXISTS public.groups
                                  (
@@ -277,22 +269,58 @@ auto create_ft_holders_table = R"sql(CREATE TABLE IF NOT EXISTS public.ft_holder
                                      TABLESPACE pg_default;)sql";
 
 
+// secondary indexes which are not used by plugin itself, they're created after tables and before partitions
+// normally. In bulk load mode they're deferred until loading is finished and then built concurrently.
+struct index {
+    const char* table;
+    const char* name;
+    const char* def;
+};
+
+index deferred_indexes[] = {
+    { "transactions",     "transactions_timestamp_index", "btree (timestamp)"                   },
+    { "transactions",     "transactions_keys_index",      "gin (keys array_ops)"                },
+    { "actions",          "actions_trx_id_index",         "btree (trx_id)"                      },
+    { "actions",          "actions_global_seq_index",     "btree (global_seq)"                  },
+    { "actions",          "actions_data_index",           "gin (data jsonb_path_ops)"           },
+    { "actions",          "actions_filter_index",         "btree (domain, key, name)"           },
+    { "action_addresses", "action_addresses_index",       "btree (address, sym_id, global_seq)" },
+    { "tokens",           "tokens_owner_index",           "gin (owner array_ops)"               }
+};
+
+// rows of frequent changes are staged in them, then applied at once when trx context is committed
+auto create_stage_tables = R"sql(CREATE TEMP TABLE IF NOT EXISTS token_owners_stage
+                                 (
+                                     id    character varying(42) NOT NULL,
+                                     seq   integer               NOT NULL,
+                                     owner character(53)[]       NOT NULL
+                                 )
+                                 ON COMMIT DELETE ROWS;
+                                 CREATE TEMP TABLE IF NOT EXISTS ft_holders_stage
+                                 (
+                                     address character(53) NOT NULL,
+                                     seq     integer       NOT NULL,
+                                     sym_id  bigint        NOT NULL
+                                 )
+                                 ON COMMIT DELETE ROWS;)sql";
+
 struct table {
     std::string name;
     bool        partitioned;
 };
 
 table tables[] = {
-    { "stats",        false },
-    { "blocks",       true  },
-    { "transactions", true  },
-    { "metas",        false },
-    { "actions",      true  },
-    { "domains",      false },
-    { "tokens",       false },
-    { "groups",       false },
-    { "fungibles",    false },
-    { "ft_holders",   false }
+    { "stats",            false },
+    { "blocks",           true  },
+    { "transactions",     true  },
+    { "metas",            false },
+    { "actions",          true  },
+    { "action_addresses", true  },
+    { "domains",          false },
+    { "tokens",           false },
+    { "groups",           false },
+    { "fungibles",        false },
+    { "ft_holders",       false }
 };
 
 template<typename Iterator>
@@ -342,18 +370,58 @@ pg::connect(const std::string& conn) {
     auto status = PQstatus(conn_);
     EVT_ASSERT(status == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
 
+    connstr_ = conn;
     return PG_OK;
 }
 
 int
 pg::close() {
     FC_ASSERT(conn_);
+    for(auto& c : commit_conns_) {
+        if(c != nullptr) {
+            PQfinish(c);
+            c = nullptr;
+        }
+    }
+    if(maintain_conn_ != nullptr) {
+        PQfinish(maintain_conn_);
+        maintain_conn_ = nullptr;
+    }
     PQfinish(conn_);
     conn_ = nullptr;
 
     return PG_OK;
 }
 
+int
+pg::open_commit_conns() {
+    FC_ASSERT(conn_);
+    for(auto& c : commit_conns_) {
+        if(c != nullptr) {
+            continue;
+        }
+        c = PQconnectdb(connstr_.c_str());
+        EVT_ASSERT(PQstatus(c) == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
+    }
+    // trx contexts are executed in statements prepared on their connection
+    prepare_stmts(commit_conns_[kTrxCtxConn]);
+    return PG_OK;
+}
+
+int
+pg::open_maintain_conn() {
+    FC_ASSERT(conn_);
+    if(maintain_conn_ != nullptr) {
+        return PG_OK;
+    }
+    maintain_conn_ = PQconnectdb(connstr_.c_str());
+    EVT_ASSERT(PQstatus(maintain_conn_) == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
+
+    // DDL gives up instead of waiting in the lock queue ahead of the copies, it's retried in next round
+    exec(maintain_conn_, "SET lock_timeout = '1s';");
+    return PG_OK;
+}
+
 int
 pg::init_pathman() {
     auto sql = R"sql(CREATE EXTENSION IF NOT EXISTS pg_pathman;)sql";
@@ -380,6 +448,96 @@ pg::create_partitions(const std::string& table, const std::string& relation, uin
     return PG_OK;
 }
 
+namespace internal {
+
+struct partition_range {
+    std::string name;
+    int64_t     min;
+    int64_t     max;
+};
+
+// range partitions of table ordered by their lower bounds
+std::vector<partition_range>
+get_partition_ranges(pg_conn* conn, const std::string& table) {
+    auto stmt = fmt::format(R"sql(SELECT partition, range_min::bigint, range_max::bigint
+                                  FROM pathman_partition_list
+                                  WHERE parent = '{}'::regclass
+                                  ORDER BY range_min::bigint;)sql", table);
+
+    auto r = PQexec(conn, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Get partitions failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+
+    auto parts = std::vector<partition_range>();
+    for(auto i = 0; i < PQntuples(r); i++) {
+        parts.emplace_back(partition_range { PQgetvalue(r, i, 0), std::stoll(PQgetvalue(r, i, 1)), std::stoll(PQgetvalue(r, i, 2)) });
+    }
+    PQclear(r);
+    return parts;
+}
+
+}  // namespace internal
+
+int64_t
+pg::extend_partitions(const std::string& table, int64_t block_num) {
+    using namespace internal;
+    FC_ASSERT(maintain_conn_);
+
+    auto parts = get_partition_ranges(maintain_conn_, table);
+    if(parts.empty()) {
+        return -1;
+    }
+
+    // partitions appended have the same interval of the last one
+    auto max = parts.back().max;
+    while(max <= block_num) {
+        auto stmt = fmt::format("SELECT append_range_partition('{}'::regclass);", table);
+        auto r    = PQexec(maintain_conn_, stmt.c_str());
+        EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Append partition failed, detail: ${s}", ("s",PQerrorMessage(maintain_conn_)));
+        PQclear(r);
+
+        max += parts.back().max - parts.back().min;
+    }
+    return max;
+}
+
+int
+pg::detach_partitions(const std::string& table, int64_t block_num, const std::string& schema) {
+    using namespace internal;
+    FC_ASSERT(maintain_conn_);
+
+    if(!schema.empty()) {
+        exec(maintain_conn_, fmt::format("CREATE SCHEMA IF NOT EXISTS {};", schema));
+    }
+    for(auto& p : get_partition_ranges(maintain_conn_, table)) {
+        if(p.max > block_num) {
+            break;
+        }
+        auto stmt = fmt::format("SELECT detach_range_partition('{}'::regclass);", p.name);
+        auto r    = PQexec(maintain_conn_, stmt.c_str());
+        EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Detach partition failed, detail: ${s}", ("s",PQerrorMessage(maintain_conn_)));
+        PQclear(r);
+
+        if(!schema.empty()) {
+            exec(maintain_conn_, fmt::format("ALTER TABLE {} SET SCHEMA {};", p.name, schema));
+        }
+    }
+    return PG_OK;
+}
+
+int
+pg::analyze_partition(const std::string& table, int64_t block_num) {
+    using namespace internal;
+    FC_ASSERT(maintain_conn_);
+
+    for(auto& p : get_partition_ranges(maintain_conn_, table)) {
+        if(p.min <= block_num && block_num < p.max) {
+            exec(maintain_conn_, fmt::format("ANALYZE {};", p.name));
+            break;
+        }
+    }
+    return PG_OK;
+}
+
 int
 pg::drop_partitions(const std::string& table) {
     auto sql = R"sql(SELECT drop_partitions('{}'::regclass);)sql";
@@ -522,7 +680,7 @@ pg::drop_all_sequences() {
 }
 
 int
-pg::prepare_tables() {
+pg::prepare_tables(bool bulk_load) {
     using namespace internal;
 
     const char* stmts[] = {
@@ -531,6 +689,7 @@ pg::prepare_tables() {
         create_trxs_table,
         create_metas_table,
         create_actions_table,
+        create_action_addresses_table,
         create_domains_table,
         create_tokens_table,
         create_groups_table,
@@ -544,6 +703,97 @@ pg::prepare_tables() {
 
         PQclear(r);
     }
+
+    if(!bulk_load) {
+        // there are no partitions yet, they copy the indexes of parent when created
+        create_indexes(conn_, false /* concurrently */, false /* partitions */);
+        return PG_OK;
+    }
+    // large tables are not written into WAL until loading is finished, partitions created later follow them
+    for(auto& t : tables) {
+        if(t.partitioned) {
+            exec(conn_, fmt::format("ALTER TABLE {} SET UNLOGGED;", t.name));
+        }
+    }
+    return PG_OK;
+}
+
+int
+pg::exec(pg_conn* conn, const std::string& stmt) {
+    auto r = PQexec(conn, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
+        "Execute sql failed, sql: ${s}, detail: ${d}", ("s",stmt)("d",PQerrorMessage(conn)));
+    PQclear(r);
+    return PG_OK;
+}
+
+std::vector<std::string>
+pg::get_partitions(pg_conn* conn, const std::string& table) {
+    auto stmt = fmt::format("SELECT partition FROM pathman_partition_list WHERE parent = '{}'::regclass;", table);
+
+    auto r = PQexec(conn, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_TUPLES_OK, chain::postgres_exec_exception, "Get partitions failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+
+    auto parts = std::vector<std::string>();
+    for(auto i = 0; i < PQntuples(r); i++) {
+        parts.emplace_back(PQgetvalue(r, i, 0));
+    }
+    PQclear(r);
+    return parts;
+}
+
+int
+pg::create_indexes(pg_conn* conn, bool concurrently, bool partitions) {
+    using namespace internal;
+
+    for(auto& idx : deferred_indexes) {
+        auto rels = std::vector<std::string>();
+        if(partitions && std::any_of(std::begin(tables), std::end(tables), [&](auto& t) { return t.partitioned && t.name == idx.table; })) {
+            rels = get_partitions(conn, idx.table);
+        }
+        rels.emplace_back(idx.table);
+
+        for(auto& rel : rels) {
+            // indexes of partitions are named after partitions
+            auto name = (rel == idx.table) ? std::string(idx.name) : fmt::format("{}_{}", boost::replace_all_copy(rel, ".", "_"), idx.name);
+            exec(conn, fmt::format("CREATE INDEX {} IF NOT EXISTS {} ON {} USING {} TABLESPACE pg_default;",
+                concurrently ? "CONCURRENTLY" : "", name, rel, idx.def));
+        }
+    }
+    return PG_OK;
+}
+
+int
+pg::is_bulk_load() const {
+    auto v = std::string();
+    return read_stat("bulk_load", v) && v == "1";
+}
+
+int
+pg::finish_bulk_load() {
+    using namespace internal;
+
+    // it takes long, so it uses its own connection and indexes are built without blocking writes
+    auto conn = PQconnectdb(connstr_.c_str());
+    EVT_ASSERT(PQstatus(conn) == CONNECTION_OK, chain::postgres_connection_exception, "Connect failed");
+    try {
+        for(auto& t : tables) {
+            if(!t.partitioned) {
+                continue;
+            }
+            for(auto& p : get_partitions(conn, t.name)) {
+                exec(conn, fmt::format("ALTER TABLE {} SET LOGGED;", p));
+            }
+            exec(conn, fmt::format("ALTER TABLE {} SET LOGGED;", t.name));
+        }
+        create_indexes(conn, true /* concurrently */, true /* partitions */);
+        exec(conn, "UPDATE stats SET value = '0' WHERE key = 'bulk_load';");
+    }
+    catch(...) {
+        PQfinish(conn);
+        throw;
+    }
+    PQfinish(conn);
     return PG_OK;
 }
 
@@ -552,21 +802,34 @@ pg::prepare_stmts() {
     if(prepared_stmts_) {
         return PG_OK;
     }
+    prepare_stmts(conn_);
+    prepared_stmts_ = 1;
+    return PG_OK;
+}
+
+int
+pg::prepare_stmts(pg_conn* conn) {
+    // stage tables are per session and referenced by prepared statements
+    auto r = PQexec(conn, internal::create_stage_tables);
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
+        "Create stage tables failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+    PQclear(r);
+
     for(auto it : internal::prepare_register::instance().stmts) {
-        auto r = PQprepare(conn_, it.first.c_str(), it.second.c_str(), 0, NULL);
+        auto r = PQprepare(conn, it.first.c_str(), it.second.c_str(), 0, NULL);
         EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception,
-            "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(conn_)));
+            "Prepare sql failed, sql: ${s}, detail: ${d}", ("s",it.second)("d",PQerrorMessage(conn)));
         PQclear(r);
     }
-    prepared_stmts_ = 1;
     return PG_OK;
 }
 
 int
-pg::prepare_stats() {
+pg::prepare_stats(bool bulk_load) {
     auto tctx = new_trx_context();
     add_stat(tctx, "version", pg_version);
     add_stat(tctx, "last_sync_block_id", "");
+    add_stat(tctx, "bulk_load", bulk_load ? "1" : "0");
 
     tctx.commit();
     return PG_OK;
@@ -603,36 +866,70 @@ pg::new_copy_context() {
 }
 
 int
-pg::block_copy_to(const std::string& table, const std::string& data) {
+pg::copy_start(pg_conn* conn, const std::string& table, std::string_view data) {
     auto stmt = fmt::format("COPY {} FROM STDIN;", table);
 
-    auto r = PQexec(conn_, stmt.c_str());
-    EVT_ASSERT(PQresultStatus(r) == PGRES_COPY_IN, chain::postgres_exec_exception, "Not expected COPY response, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto r = PQexec(conn, stmt.c_str());
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COPY_IN, chain::postgres_exec_exception, "Not expected COPY response, detail: ${s}", ("s",PQerrorMessage(conn)));
     PQclear(r);
 
-    auto nr = PQputCopyData(conn_, data.data(), (int)data.size());
-    EVT_ASSERT(nr == 1, chain::postgres_exec_exception, "Put data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto nr = PQputCopyData(conn, data.data(), (int)data.size());
+    EVT_ASSERT(nr == 1, chain::postgres_exec_exception, "Put data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+
+    auto nr2 = PQputCopyEnd(conn, NULL);
+    EVT_ASSERT(nr2 == 1, chain::postgres_exec_exception, "Close data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn)));
 
-    auto nr2 = PQputCopyEnd(conn_, NULL);
-    EVT_ASSERT(nr2 == 1, chain::postgres_exec_exception, "Close data into COPY stream failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    return PG_OK;
+}
 
-    auto r2 = PQgetResult(conn_);
-    EVT_ASSERT(PQresultStatus(r2) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Execute COPY command failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
-    PQclear(r2);
+int
+pg::copy_finish(pg_conn* conn) {
+    auto r = PQgetResult(conn);
+    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Execute COPY command failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+    PQclear(r);
 
+    // consume the terminating null result
+    while((r = PQgetResult(conn)) != nullptr) {
+        PQclear(r);
+    }
     return PG_OK;
 }
 
 void
 pg::commit_copy_context(copy_context& cctx) {
-    if(cctx.blocks_copy_.size() > 0) {
-        block_copy_to("blocks", fmt::to_string(cctx.blocks_copy_));
+    struct copy {
+        const char*               table;
+        const fmt::memory_buffer& data;
+        int                       conn;
+    };
+    auto copies = {
+        copy { "blocks",           cctx.blocks_copy_,    kBlocksConn    },
+        copy { "transactions",     cctx.trxs_copy_,      kTrxsConn      },
+        copy { "actions",          cctx.actions_copy_,   kActionsConn   },
+        copy { "action_addresses", cctx.addresses_copy_, kAddressesConn }
+    };
+
+    if(commit_conns_[kBlocksConn] == nullptr) {
+        // only one connection, copies are executed one by one
+        for(auto& c : copies) {
+            if(c.data.size() > 0) {
+                copy_start(conn_, c.table, std::string_view(c.data.data(), c.data.size()));
+                copy_finish(conn_);
+            }
+        }
+        return;
     }
-    if(cctx.trxs_copy_.size() > 0) {
-        block_copy_to("transactions", fmt::to_string(cctx.trxs_copy_));
+
+    // all the copies are sent before waiting for any of them, so server executes them concurrently
+    for(auto& c : copies) {
+        if(c.data.size() > 0) {
+            copy_start(commit_conn(c.conn), c.table, std::string_view(c.data.data(), c.data.size()));
+        }
     }
-    if(cctx.actions_copy_.size() > 0) {
-        block_copy_to("actions", fmt::to_string(cctx.actions_copy_));
+    for(auto& c : copies) {
+        if(c.data.size() > 0) {
+            copy_finish(commit_conn(c.conn));
+        }
     }
 }
 
@@ -641,19 +938,45 @@ pg::new_trx_context() {
     return trx_context(*this);
 }
 
+PREPARE_SQL_ONCE(sto_plan, "UPDATE tokens SET owner = s.owner FROM (SELECT DISTINCT ON (id) id, owner FROM token_owners_stage ORDER BY id, seq DESC) s WHERE tokens.id = s.id;");
+PREPARE_SQL_ONCE(sfh_plan, "INSERT INTO ft_holders SELECT address, array_agg(sym_id ORDER BY seq), now() FROM ft_holders_stage GROUP BY address "
+                           "ON CONFLICT (address) DO UPDATE SET sym_ids = ft_holders.sym_ids || excluded.sym_ids;");
+
 void
 pg::commit_trx_context(trx_context& tctx) {
-    if(tctx.trx_buf_.size() == 0) {
+    if(tctx.trx_buf_.size() == 0 && tctx.tokens_copy_.size() == 0
+        && tctx.owners_copy_.size() == 0 && tctx.holders_copy_.size() == 0) {
         return;
     }
 
-    auto stmts = fmt::to_string(tctx.trx_buf_);
-
-    auto r = PQexec(conn_, stmts.c_str());
-    auto s = PQresultStatus(r);
-    EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Commit transactions failed, detail: ${s}", ("s",PQerrorMessage(conn_)));
+    auto conn = commit_conn(kTrxCtxConn);
+    auto exec = [conn](const char* stmts) {
+        auto r = PQexec(conn, stmts);
+        EVT_ASSERT(PQresultStatus(r) == PGRES_COMMAND_OK, chain::postgres_exec_exception, "Commit transactions failed, detail: ${s}", ("s",PQerrorMessage(conn)));
+        PQclear(r);
+    };
+    auto copy = [this, conn](const char* table, const fmt::memory_buffer& data) {
+        copy_start(conn, table, std::string_view(data.data(), data.size()));
+        copy_finish(conn);
+    };
 
-    PQclear(r);
+    exec("BEGIN;");
+    // new tokens go first, they may be transferred or have metas added in the same context
+    if(tctx.tokens_copy_.size() > 0) {
+        copy("tokens", tctx.tokens_copy_);
+    }
+    if(tctx.owners_copy_.size() > 0) {
+        copy("token_owners_stage", tctx.owners_copy_);
+        exec("EXECUTE sto_plan;");
+    }
+    if(tctx.holders_copy_.size() > 0) {
+        copy("ft_holders_stage", tctx.holders_copy_);
+        exec("EXECUTE sfh_plan;");
+    }
+    if(tctx.trx_buf_.size() > 0) {
+        exec(fmt::to_string(tctx.trx_buf_).c_str());
+    }
+    exec("COMMIT;");
 }
 
 int
@@ -728,9 +1051,8 @@ int
 pg::add_action(add_context& actx, const act_trace_t& act_trace, const std::string& trx_id, int seq_num) {
     using namespace internal;
 
-    auto& act     = act_trace.act;
-    auto  acttype = actx.exec_ctx.get_acttype_name(act.name);
-    auto  data    = actx.abi.binary_to_variant(acttype, act.data, actx.exec_ctx);
+    auto& act  = act_trace.act;
+    auto& data = act_trace.data_json(actx.abi, actx.exec_ctx);
 
     fmt::format_to(actx.cctx.actions_copy_,
         fmt("{}\t{:d}\t{}\t{:d}\t{:d}\t{}\t{}\t{}\t{}\tnow\n"),
@@ -742,12 +1064,73 @@ pg::add_action(add_context& actx, const act_trace_t& act_trace, const std::strin
         act.name.to_string(),
         act.domain.to_string(),
         act.key.to_string(),
-        escape_string<true>(fc::json::to_string(data))
+        escape_string<true>(data)
         );
 
+    if(act.domain == N128(.fungible)) {
+        add_action_addresses(actx, act_trace, data, trx_id, seq_num);
+    }
     return PG_OK;
 }
 
+void
+pg::add_action_addresses(add_context& actx, const act_trace_t& act_trace, const std::string& data, const std::string& trx_id, int seq_num) {
+    auto& act = act_trace.act;
+    switch(act.name.value) {
+    case N(issuefungible):
+    case N(transferft):
+    case N(batchtransft):
+    case N(recycleft):
+    case N(evt2pevt):
+    case N(everipay):
+    case N(paybonus): {
+        break;
+    }
+    default: {
+        return;
+    }
+    }  // switch
+
+    auto sym_id = act.key.to_string();
+    if(sym_id.empty() || !std::all_of(sym_id.cbegin(), sym_id.cend(), ::isdigit)) {
+        return;
+    }
+
+    // same fields as the ones history queries used to filter actions by
+    auto addrs = std::vector<std::string>();
+    auto var   = fc::json::from_string(data);
+    auto& v    = var.get_object();
+    for(auto f : { "address", "from", "to", "payee", "payer" }) {
+        if(v.contains(f)) {
+            addrs.emplace_back(v[f].as_string());
+        }
+    }
+    if(v.contains("credits")) {
+        for(auto& c : v["credits"].get_array()) {
+            addrs.emplace_back(c["to"].as_string());
+        }
+    }
+    if(v.contains("link") && v["link"].get_object().contains("keys")) {
+        for(auto& k : v["link"]["keys"].get_array()) {
+            addrs.emplace_back(k.as_string());
+        }
+    }
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+
+    for(auto& addr : addrs) {
+        fmt::format_to(actx.cctx.addresses_copy_,
+            fmt("{}\t{}\t{:d}\t{}\t{:d}\t{:d}\n"),
+            addr,
+            sym_id,
+            actx.block_num,
+            trx_id,
+            seq_num,
+            act_trace.receipt.global_sequence
+            );
+    }
+}
+
 PREPARE_SQL_ONCE(glb_plan, "SELECT block_id FROM blocks ORDER BY block_num DESC LIMIT 1;");
 
 int
@@ -886,8 +1269,6 @@ pg::upd_domain(trx_context& tctx, const updatedomain& ud) {
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(it_plan, "INSERT INTO tokens VALUES($1, $2, $3, $4, '{}', $5, now());");
-
 int
 pg::add_tokens(trx_context& tctx, const issuetoken& it) {
     // cache owners
@@ -904,8 +1285,8 @@ pg::add_tokens(trx_context& tctx, const issuetoken& it) {
     auto owners = fmt::to_string(owners_buf);
     auto domain = (std::string)it.domain;
     for(auto& name : it.names) {
-        fmt::format_to(tctx.trx_buf_,
-            fmt("EXECUTE it_plan('{0}:{1}','{0}','{1}','{2}','{3}');\n"),
+        fmt::format_to(tctx.tokens_copy_,
+            fmt("{0}:{1}\t{0}\t{1}\t{2}\t{{}}\t{3}\tnow\n"),
             domain,
             (std::string)name,
             owners,
@@ -915,33 +1296,27 @@ pg::add_tokens(trx_context& tctx, const issuetoken& it) {
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(tf_plan, "UPDATE tokens SET owner = $1 WHERE id = $2;");
-
+// only the last owner staged of one token is applied
 int
 pg::upd_token(trx_context& tctx, const transfer& tf) {
     using namespace internal;
 
-    auto owners_buf = fmt::memory_buffer();
-    format_array_to(owners_buf, std::begin(tf.to), std::end(tf.to));
-
-    fmt::format_to(tctx.trx_buf_,
-        fmt("EXECUTE tf_plan('{2}','{0}:{1}');"),
-        (std::string)tf.domain,
-        (std::string)tf.name,
-        fmt::to_string(owners_buf)
-        );
+    fmt::format_to(tctx.owners_copy_, fmt("{}:{}\t{:d}\t"), (std::string)tf.domain, (std::string)tf.name, tctx.stage_seq_++);
+    // array is ended with a tab
+    format_array_to(tctx.owners_copy_, std::begin(tf.to), std::end(tf.to));
+    tctx.owners_copy_.resize(tctx.owners_copy_.size() - 1);
+    fmt::format_to(tctx.owners_copy_, fmt("\n"));
 
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(dt_plan, "UPDATE tokens SET owner = '{\"EVT00000000000000000000000000000000000000000000000000\"}' WHERE id = $1;");
-
 int
 pg::del_token(trx_context& tctx, const destroytoken& dt) {
-    fmt::format_to(tctx.trx_buf_,
-        fmt("EXECUTE dt_plan('{0}:{1}');"),
+    fmt::format_to(tctx.owners_copy_,
+        fmt("{}:{}\t{:d}\t{{\"EVT00000000000000000000000000000000000000000000000000\"}}\n"),
         (std::string)dt.domain,
-        (std::string)dt.name
+        (std::string)dt.name,
+        tctx.stage_seq_++
         );
 
     return PG_OK;
@@ -1098,12 +1473,10 @@ pg::add_meta(trx_context& tctx, const action_t& act) {
     return PG_OK;
 }
 
-PREPARE_SQL_ONCE(afh_plan, "INSERT INTO ft_holders VALUES($1, $2, now()) ON CONFLICT (address) DO UPDATE SET sym_ids = array_append(ft_holders.sym_ids, excluded.sym_ids[1]);");
-
 int
 pg::add_ft_holders(trx_context& tctx, const ft_holders_t& holders) {
     for(auto& holder : holders) {
-        fmt::format_to(tctx.trx_buf_, fmt("EXECUTE afh_plan('{}','{{{}}}');"), holder.addr, (int64_t)holder.sym_id);
+        fmt::format_to(tctx.holders_copy_, fmt("{}\t{:d}\t{:d}\n"), holder.addr, tctx.stage_seq_++, (int64_t)holder.sym_id);
     }
     return PG_OK;
 }
@@ -21,10 +21,20 @@ public:
         db_.commit_copy_context(*this);
     }
 
+    // appends the rows of `cctx` after the ones of this context
+    void
+    append(const copy_context& cctx) {
+        blocks_copy_.append(cctx.blocks_copy_.data(), cctx.blocks_copy_.data() + cctx.blocks_copy_.size());
+        trxs_copy_.append(cctx.trxs_copy_.data(), cctx.trxs_copy_.data() + cctx.trxs_copy_.size());
+        actions_copy_.append(cctx.actions_copy_.data(), cctx.actions_copy_.data() + cctx.actions_copy_.size());
+        addresses_copy_.append(cctx.addresses_copy_.data(), cctx.addresses_copy_.data() + cctx.addresses_copy_.size());
+    }
+
 private:
     fmt::memory_buffer blocks_copy_;
     fmt::memory_buffer trxs_copy_;
     fmt::memory_buffer actions_copy_;
+    fmt::memory_buffer addresses_copy_;
 
 private:
     pg& db_;
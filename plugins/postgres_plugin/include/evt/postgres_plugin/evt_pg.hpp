@@ -3,11 +3,13 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <array>
 #include <functional>
 #include <istream>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <evt/chain/block_state.hpp>
 #include <evt/chain/execution_context.hpp>
@@ -68,11 +70,26 @@ public:
     int connect(const std::string& conn);
     int close();
 
+    // opens the connections used to commit contexts, so that the copies of different tables
+    // are executed concurrently and commits don't occupy the main connection used by queries
+    int open_commit_conns();
+
+    // opens the connection used by maintenance of partitions, DDL there doesn't stall the copies of ingestion
+    int open_maintain_conn();
+
 public:
     int init_pathman();
     int create_partitions(const std::string& table, const std::string& relation, uint interval, uint part_nums);
     int drop_partitions(const std::string& table);
 
+    // partitions below are maintained on the maintenance connection, tables not partitioned are skipped
+    // appends partitions until the last one covers `block_num`, returns the upper bound of last partition, -1 if not partitioned
+    int64_t extend_partitions(const std::string& table, int64_t block_num);
+    // detaches the partitions entirely below `block_num` and moves them into `schema` if it's not empty
+    int detach_partitions(const std::string& table, int64_t block_num, const std::string& schema);
+    // refreshes planner statistics of the partition having `block_num`, which are stale while it's being filled
+    int analyze_partition(const std::string& table, int64_t block_num);
+
 public:
     int create_db(const std::string& db);
     int drop_db(const std::string& db);
@@ -83,9 +100,15 @@ public:
     int drop_sequence(const std::string& seq);
     int drop_all_tables();
     int drop_all_sequences();
-    int prepare_tables();
+    // in bulk load mode large tables are unlogged and secondary indexes are not created
+    int prepare_tables(bool bulk_load = false);
     int prepare_stmts();
-    int prepare_stats();
+    int prepare_stats(bool bulk_load = false);
+
+public:
+    int is_bulk_load() const;
+    // makes tables logged and builds the deferred indexes, it blocks until all done
+    int finish_bulk_load();
 
 public:
     int backup(const std::shared_ptr<chain::snapshot_writer>& snapshot) const;
@@ -137,12 +160,29 @@ public:
     int add_ft_holders(trx_context&, const ft_holders_t&);
 
 private:
-    int block_copy_to(const std::string& table, const std::string& data);
+    static void add_action_addresses(add_context&, const act_trace_t&, const std::string& data, const std::string& trx_id, int seq_num);
+
+    int prepare_stmts(pg_conn* conn);
+    int create_indexes(pg_conn* conn, bool concurrently, bool partitions);
+
+    static int exec(pg_conn* conn, const std::string& stmt);
+    static std::vector<std::string> get_partitions(pg_conn* conn, const std::string& table);
+
+    int copy_start(pg_conn* conn, const std::string& table, std::string_view data);
+    int copy_finish(pg_conn* conn);
+
+    pg_conn* commit_conn(int i) const { return commit_conns_[i] != nullptr ? commit_conns_[i] : conn_; }
 
 private:
+    enum { kBlocksConn = 0, kTrxsConn, kActionsConn, kAddressesConn, kTrxCtxConn, kCommitConnsNum };
+
     pg_conn*    conn_;
+    pg_conn*    maintain_conn_ = nullptr;
+    std::string connstr_;
     std::string last_sync_block_id_;
     int         prepared_stmts_;
+
+    std::array<pg_conn*, kCommitConnsNum> commit_conns_ = {};
 };
 
 }  // namespace evt
@@ -34,6 +34,14 @@ public:
     bool enabled() const;
     const std::string& connstr() const;
 
+    // blocks since startup, blocks waiting are the difference of them, safe to call from any thread
+    struct queue_metrics {
+        uint64_t queued_blocks    = 0;
+        uint64_t processed_blocks = 0;
+        size_t   queue_size       = 0;  // limit of the queue
+    };
+    queue_metrics get_queue_metrics() const;
+
 public:
     void read_from_snapshot(const std::shared_ptr<chain::snapshot_reader>& snapshot);
     void write_snapshot(const std::shared_ptr<chain::snapshot_writer>& snapshot) const;
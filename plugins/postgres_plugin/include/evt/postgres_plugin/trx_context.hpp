@@ -27,6 +27,12 @@ public:
 private:
     fmt::memory_buffer trx_buf_;
 
+    // rows staged by COPY and applied in set-based statements when committed
+    fmt::memory_buffer tokens_copy_;
+    fmt::memory_buffer owners_copy_;
+    fmt::memory_buffer holders_copy_;
+    int                stage_seq_ = 0;
+
 private:
     pg&              db_;
     std::string_view trx_id_;
@@ -4,12 +4,17 @@
  */
 #include <evt/postgres_plugin/postgres_plugin.hpp>
 
+#include <algorithm>
+#include <condition_variable>
 #include <functional>
+#include <future>
+#include <limits>
 #include <queue>
 #include <optional>
 #include <tuple>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 #if __has_include(<condition>)
 #include <condition>
@@ -24,6 +29,11 @@ using boost::condition_variable_any;
 #include <fc/time.hpp>
 #include <fmt/format.h>
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <evt/chain/block_spill_queue.hpp>
+#include <evt/chain/memory_accounting.hpp>
 #include <evt/chain/config.hpp>
 #include <evt/chain/controller.hpp>
 #include <evt/chain/exceptions.hpp>
@@ -55,6 +65,19 @@ using evt::utilities::spinlock_guard;
 
 static appbase::abstract_plugin& _postgres_plugin = app().register_plugin<postgres_plugin>();
 
+// block and its transactions matched with their traces, which are converted into rows in worker threads
+struct block_rows {
+    struct trx_rows {
+        const transaction_receipt* receipt;
+        transaction_trace_ptr      trace;  // null if there are no action traces
+        int                        elapsed;
+        int                        charge;
+    };
+
+    block_state_ptr       block;
+    std::vector<trx_rows> trxs;
+};
+
 class postgres_plugin_impl {
 private:
     using inblock_ptr = std::tuple<block_state_ptr, bool>; // true for irreversible block
@@ -67,22 +90,29 @@ public:
 
 public:
     void consume_queues();
+    void wait_commit();
+
+    void queue_block(const block_state_ptr&, bool irreversible);
+    bool has_blocks() const { return !block_state_queue_.empty() || (spill_ && !spill_->empty()); }
 
     void applied_block(const block_state_ptr&);
     void applied_irreversible_block(const block_state_ptr&);
     void applied_transaction(const transaction_trace_ptr&);
 
-    void process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
-    void _process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
-    void process_irreversible_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx);
+    void process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx);
+    void _process_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx);
+    void process_irreversible_block(const block_state_ptr, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx);
     
     void process_action(const action&, trx_context& tctx);
+    void convert_rows(const block_rows& rows, copy_context& cctx);
 
     void verify_last_block(const std::string& prev_block_id);
     void verify_no_blocks();
 
     void init(bool init_db);
     void wipe_database();
+    void finish_bulk_load();
+    void maintain_partitions();
 
 public:
     pg          db_;
@@ -95,12 +125,39 @@ public:
     uint32_t last_sync_block_num_ = 0;
     uint32_t part_limit_ = 0, part_num_ = 0;
 
+    // partitions are appended ahead of head block by the maintenance thread, the ones behind it
+    // more than `part_retain_` partitions are detached into archive schema, 0 to keep all
+    uint32_t    part_ahead_  = 2;
+    uint32_t    part_retain_ = 0;
+    std::string part_archive_schema_;
+    uint32_t    maintain_interval_ = 60;  // in seconds, of detaching partitions and refreshing statistics
+
+    std::thread             maintain_thread_;
+    std::atomic<uint32_t>   head_block_num_ = 0;
+    std::mutex              maintain_mutex_;
+    std::condition_variable maintain_cond_;
+
+    // loads in bulk mode until synced within this number of blocks of now, 0 if disabled
+    uint32_t    bulk_load_blocks_ = 0;
+    bool        bulk_loading_     = false;
+    std::thread bulk_finish_thread_;
+
     size_t processed_  = 0;
     size_t queue_size_ = 0;
 
+    // blocks queued and processed since startup, read by metrics from other threads
+    std::atomic<uint64_t> queued_blocks_    = 0;
+    std::atomic<uint64_t> processed_blocks_ = 0;
+
+    // bytes of the blocks in memory, set when memory accounting is enabled
+    memory_counter* mem_blocks_ = nullptr;
+
     std::deque<inblock_ptr>           block_state_queue_;
     std::deque<transaction_trace_ptr> transaction_trace_queue_;
 
+    // blocks go into spill file instead of blocking the chain when queue is full
+    std::optional<block_spill_queue> spill_;
+
     spinlock               lock_;
     condition_variable_any cond_;
 
@@ -110,6 +167,12 @@ public:
     std::thread      consume_thread_;
     std::atomic_bool done_ = false;
 
+    uint16_t                                 thread_pool_size_ = 2;
+    std::optional<boost::asio::thread_pool>  thread_pool_;
+
+    // commit of last batch, which is in flight while next batch is being processed
+    std::future<void> commit_;
+
     std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
     std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
     std::optional<boost::signals2::scoped_connection> applied_transaction_connection_;
@@ -149,14 +212,33 @@ queuet(Q& tqueue, V&& v, spinlock& lock, condition_variable_any& cv) {
 
 }  // namespace internal
 
+void
+postgres_plugin_impl::queue_block(const block_state_ptr& bsp, bool irreversible) {
+    queued_blocks_.fetch_add(1, std::memory_order_relaxed);
+    if(spill_) {
+        spinlock_guard lock(lock_);
+        // once blocks are spilled, the following ones are spilled as well until the file is drained to keep them in order
+        // traces queued are spilled along with the block, they're all before the ones of next block
+        if(!spill_->empty() || block_state_queue_.size() > queue_size_) {
+            spill_->push(bsp, irreversible, transaction_trace_queue_);
+            cond_.notify_one();
+            return;
+        }
+    }
+    if(mem_blocks_) {
+        mem_blocks_->add(estimate_block_bytes(*bsp));
+    }
+    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, irreversible), lock_, cond_, queue_size_);
+}
+
 void
 postgres_plugin_impl::applied_irreversible_block(const block_state_ptr& bsp) {
-    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, true), lock_, cond_, queue_size_);
+    queue_block(bsp, true);
 }
 
 void
 postgres_plugin_impl::applied_block(const block_state_ptr& bsp) {
-    evt::internal::queueb(block_state_queue_, std::make_tuple(bsp, false), lock_, cond_, queue_size_);
+    queue_block(bsp, false);
 }
 
 void
@@ -168,6 +250,13 @@ postgres_plugin_impl::applied_transaction(const transaction_trace_ptr& ttp) {
     evt::internal::queuet(transaction_trace_queue_, ttp, lock_, cond_);
 }
 
+void
+postgres_plugin_impl::wait_commit() {
+    if(commit_.valid()) {
+        commit_.get();
+    }
+}
+
 void
 postgres_plugin_impl::consume_queues() {
     using namespace evt::internal;
@@ -175,7 +264,13 @@ postgres_plugin_impl::consume_queues() {
     try {
         while(true) {
             lock_.lock();
-            while(block_state_queue_.empty() && !done_) {
+            if(!has_blocks() && !done_ && commit_.valid()) {
+                // nothing to process, finish the commit in flight before going idle
+                lock_.unlock();
+                wait_commit();
+                lock_.lock();
+            }
+            while(!has_blocks() && !done_) {
                 consuming_ = false;
                 ss_cond_.notify_all();
                 cond_.wait(lock_);
@@ -185,7 +280,26 @@ postgres_plugin_impl::consume_queues() {
             auto traces = std::move(transaction_trace_queue_);
 
             consuming_ = true;
-            lock_.unlock();
+            if(bqueue.empty() && spill_ && !spill_->empty()) {
+                // spilled blocks are after the ones in queue, and the traces of them are in file
+                transaction_trace_queue_ = std::move(traces);
+                traces.clear();
+                lock_.unlock();
+
+                auto items = std::vector<block_spill_queue::item>();
+                spill_->read(std::max<size_t>(queue_size_, 1), items);
+                for(auto& it : items) {
+                    if(mem_blocks_) {
+                        mem_blocks_->add(estimate_block_bytes(*it.block));
+                    }
+                    bqueue.emplace_back(it.block, it.irreversible);
+                    traces.insert(traces.end(), it.traces.begin(), it.traces.end());
+                }
+                spill_->release(items.size());
+            }
+            else {
+                lock_.unlock();
+            }
 
             const int BlockPtr       = 0;
             const int IsIrreversible = 1;
@@ -199,8 +313,9 @@ postgres_plugin_impl::consume_queues() {
                 break;
             }
 
-            auto cctx = db_.new_copy_context();
-            auto tctx = db_.new_trx_context();
+            auto cctx = std::make_shared<copy_context>(db_);
+            auto tctx = std::make_shared<trx_context>(db_);
+            auto rows = std::vector<block_rows>();
             auto back = std::get<BlockPtr>(bqueue.back()); 
             // process block states
             while(true) {
@@ -210,25 +325,60 @@ postgres_plugin_impl::consume_queues() {
 
                 auto& b = bqueue.front();
                 if(std::get<IsIrreversible>(b)) {
-                    process_irreversible_block(std::get<BlockPtr>(b), traces, cctx, tctx);
+                    process_irreversible_block(std::get<BlockPtr>(b), traces, rows, *tctx);
                 }
                 else {
-                    process_block(std::get<BlockPtr>(b), traces, cctx, tctx);
+                    process_block(std::get<BlockPtr>(b), traces, rows, *tctx);
                 }
 
+                if(mem_blocks_) {
+                    mem_blocks_->sub(estimate_block_bytes(*std::get<BlockPtr>(b)));
+                }
                 bqueue.pop_front();
+                processed_blocks_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // blocks are converted concurrently and then appended in order
+            auto parts = std::vector<std::future<std::unique_ptr<copy_context>>>();
+            parts.reserve(rows.size());
+            for(auto& r : rows) {
+                auto task = std::make_shared<std::packaged_task<std::unique_ptr<copy_context>()>>([this, &r] {
+                    auto part = std::make_unique<copy_context>(db_);
+                    convert_rows(r, *part);
+                    return part;
+                });
+                parts.emplace_back(task->get_future());
+                boost::asio::post(*thread_pool_, [task] { (*task)(); });
+            }
+            for(auto& p : parts) {
+                cctx->append(*p.get());
             }
             // update last sync block in postgres
-            db_.upd_stat(tctx, "last_sync_block_id", back->id.str());
+            db_.upd_stat(*tctx, "last_sync_block_id", back->id.str());
+            if(maintain_thread_.joinable()) {
+                head_block_num_ = back->block_num;
+                maintain_cond_.notify_one();
+            }
 
-            cctx.commit();
-            tctx.commit();
+            if(bulk_loading_ && (bulk_load_blocks_ == 0
+                || fc::time_point::now() - back->header.timestamp.to_time_point() <= fc::milliseconds((int64_t)bulk_load_blocks_ * config::block_interval_ms))) {
+                finish_bulk_load();
+            }
+
+            // commits use their own connections, the next batch is processed while this one is being committed
+            // trx context is committed after the copies because it updates the copied rows
+            wait_commit();
+            commit_ = std::async(std::launch::async, [cctx, tctx] {
+                cctx->commit();
+                tctx->commit();
+            });
 
             if(!traces.empty()) {
                 spinlock_guard lock(lock_);
                 transaction_trace_queue_.insert(transaction_trace_queue_.begin(), traces.begin(), traces.end());
             }
         }
+        wait_commit();
         ilog("postgres_plugin consume thread shutdown gracefully");
     }
     catch(fc::exception& e) {
@@ -261,12 +411,12 @@ postgres_plugin_impl::verify_no_blocks() {
 }
 
 void
-postgres_plugin_impl::process_irreversible_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx) {
+postgres_plugin_impl::process_irreversible_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx) {
     try {
         if(block->block_num == 1) {
             // genesis block will not trigger on_block event
             // add it manually
-            _process_block(block, traces, cctx, tctx);
+            _process_block(block, traces, rows, tctx);
         }
         db_.set_block_irreversible(tctx, block->id);
     }
@@ -282,9 +432,9 @@ postgres_plugin_impl::process_irreversible_block(const block_state_ptr block, st
 }
 
 void
-postgres_plugin_impl::process_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx) {
+postgres_plugin_impl::process_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx) {
     try {
-        _process_block(block, traces, cctx, tctx);
+        _process_block(block, traces, rows, tctx);
     }
     catch(postgres_sync_exception&) {
         throw;
@@ -339,10 +489,10 @@ postgres_plugin_impl::process_action(const action& act, trx_context& tctx) {
     case N(updfungible): {
         auto ver = exec_ctx_.get_current_version(N(updfungible));
         if(ver == 1) {
-            db_.upd_fungible(tctx, act.data_as<updfungible>());
+            db_.upd_fungible(tctx, act.data_as<const updfungible&>());
         }
         else if(ver == 2) {
-            db_.upd_fungible(tctx, act.data_as<updfungible_v2>());
+            db_.upd_fungible(tctx, act.data_as<const updfungible_v2&>());
         }
         break;
     }
@@ -371,7 +521,7 @@ postgres_plugin_impl::process_action(const action& act, trx_context& tctx) {
 }
 
 void
-postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, copy_context& cctx, trx_context& tctx) {
+postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<transaction_trace_ptr>& traces, std::vector<block_rows>& rows, trx_context& tctx) {
     using namespace evt::internal;
 
     auto id = block->id.str();
@@ -392,21 +542,16 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
         }
     }
 
-    auto actx      = add_context(cctx, control_.get_chain_id(), control_.get_abi_serializer(), control_.get_execution_context());
-    actx.block_id  = id;
-    actx.block_num = (int)block->block_num;
-    actx.ts        = (std::string)block->header.timestamp.to_time_point();
-
-    db_.add_block(actx, block);
+    auto br  = block_rows();
+    br.block = block;
+    br.trxs.reserve(block->block->transactions.size());
 
-    // transactions
-    auto trx_num = 0;
+    // transactions, rows of them are converted later, only the state changes are processed here in order
     for(const auto& trx : block->block->transactions) {
         auto& strx       = trx.trx.get_signed_transaction();
         auto  trx_id     = strx.id();
         auto  str_trx_id = strx.id().str();
-        auto  elapsed    = 0;
-        auto  charge     = 0;
+        auto& tr         = br.trxs.emplace_back(block_rows::trx_rows { &trx, nullptr, 0, 0 });
 
         if(trx.status == transaction_receipt_header::executed && !strx.actions.empty()) {
             auto it = traces.begin();
@@ -415,37 +560,72 @@ postgres_plugin_impl::_process_block(const block_state_ptr block, std::deque<tra
                 traces.pop_front();
 
                 if(trace->id == trx_id) {
-                    elapsed = (int)trace->elapsed.count();
-                    charge  = (int)trace->charge;
+                    tr.elapsed = (int)trace->elapsed.count();
+                    tr.charge  = (int)trace->charge;
 
                     if(trace->action_traces.empty()) {
                         break;
                     }
 
+                    tr.trace = trace;
                     tctx.set_trx_id(str_trx_id);
 
-                    auto act_num = 0;
                     for(auto& act_trace : trace->action_traces) {
-                        db_.add_action(actx, act_trace, str_trx_id, act_num);
                         process_action(act_trace.act, tctx);
                         if(!act_trace.new_ft_holders.empty()) {
                             db_.add_ft_holders(tctx, act_trace.new_ft_holders);
                         }
-                        act_num++;
                     }
                     break;
                 }
                 it++;
             }
         }
-
-        db_.add_trx(actx, trx, strx, trx_num, elapsed, charge);
-        ++trx_num;
     }
 
+    rows.emplace_back(std::move(br));
     ++processed_;
 }
 
+void
+postgres_plugin_impl::convert_rows(const block_rows& rows, copy_context& cctx) {
+    auto& block = rows.block;
+    try {
+        auto id = block->id.str();
+
+        auto actx      = add_context(cctx, control_.get_chain_id(), control_.get_abi_serializer(), control_.get_execution_context());
+        actx.block_id  = id;
+        actx.block_num = (int)block->block_num;
+        actx.ts        = (std::string)block->header.timestamp.to_time_point();
+
+        pg::add_block(actx, block);
+
+        auto trx_num = 0;
+        for(auto& trx : rows.trxs) {
+            auto& strx = trx.receipt->trx.get_signed_transaction();
+            if(trx.trace != nullptr) {
+                auto str_trx_id = strx.id().str();
+                auto act_num    = 0;
+                for(auto& act_trace : trx.trace->action_traces) {
+                    pg::add_action(actx, act_trace, str_trx_id, act_num);
+                    act_num++;
+                }
+            }
+            pg::add_trx(actx, *trx.receipt, strx, trx_num, trx.elapsed, trx.charge);
+            ++trx_num;
+        }
+    }
+    catch(fc::exception& e) {
+        elog("Exception while converting block ${e}", ("e", e.to_string()));
+    }
+    catch(std::exception& e) {
+        elog("Exception while converting block ${e}", ("e", e.what()));
+    }
+    catch(...) {
+        elog("Unknown exception while converting block");
+    }
+}
+
 void
 postgres_plugin_impl::wipe_database() {
     ilog("wipe database");
@@ -453,6 +633,86 @@ postgres_plugin_impl::wipe_database() {
     db_.drop_all_sequences();
 }
 
+void
+postgres_plugin_impl::finish_bulk_load() {
+    ilog("Synced near head block, finishing bulk load of postgres database");
+    bulk_loading_ = false;
+
+    // indexes are built concurrently while syncing continues in normal mode
+    bulk_finish_thread_ = std::thread([this] {
+        try {
+            db_.finish_bulk_load();
+            ilog("Bulk load of postgres database is finished");
+        }
+        catch(fc::exception& e) {
+            elog("Exception while finishing bulk load ${e}", ("e", e.to_string()));
+        }
+        catch(std::exception& e) {
+            elog("Exception while finishing bulk load ${e}", ("e", e.what()));
+        }
+        catch(...) {
+            elog("Unknown exception while finishing bulk load");
+        }
+    });
+}
+
+void
+postgres_plugin_impl::maintain_partitions() {
+    constexpr auto kWakeInterval = std::chrono::seconds(10);
+
+    const char* parted_tables[] = { "public.blocks", "public.transactions", "public.actions", "public.action_addresses" };
+
+    // partitions are only checked once head block gets within the look-ahead window of the last one
+    auto next_extend   = int64_t(0);
+    auto last_maintain = std::chrono::steady_clock::now();
+    auto head          = (int64_t)head_block_num_.load();
+    while(!done_) {
+        {
+            auto lock = std::unique_lock<std::mutex>(maintain_mutex_);
+            maintain_cond_.wait_for(lock, kWakeInterval, [&] { return done_ || head_block_num_ != head; });
+        }
+        if(done_) {
+            break;
+        }
+
+        head = (int64_t)head_block_num_.load();
+
+        auto window = (int64_t)part_ahead_ * part_limit_;
+        auto now    = std::chrono::steady_clock::now();
+        auto due    = now - last_maintain >= std::chrono::seconds(maintain_interval_);
+        if(head < next_extend && !due) {
+            continue;
+        }
+
+        try {
+            auto bound = std::numeric_limits<int64_t>::max();
+            for(auto t : parted_tables) {
+                auto max = db_.extend_partitions(t, head + window);
+                if(max >= 0) {
+                    bound = std::min(bound, max);
+                }
+            }
+            next_extend = (bound == std::numeric_limits<int64_t>::max()) ? bound : bound - window;
+
+            if(due) {
+                last_maintain = now;
+                for(auto t : parted_tables) {
+                    if(part_retain_ > 0 && head > (int64_t)part_retain_ * part_limit_) {
+                        db_.detach_partitions(t, head - (int64_t)part_retain_ * part_limit_, part_archive_schema_);
+                    }
+                    db_.analyze_partition(t, head);
+                }
+            }
+        }
+        catch(fc::exception& e) {
+            wlog("Exception while maintaining partitions, will retry: ${e}", ("e", e.to_string()));
+        }
+        catch(std::exception& e) {
+            wlog("Exception while maintaining partitions, will retry: ${e}", ("e", e.what()));
+        }
+    }
+}
+
 void
 postgres_plugin_impl::init(bool init_db) {
     if(!init_db) {
@@ -462,6 +722,8 @@ postgres_plugin_impl::init(bool init_db) {
             db_.check_last_sync_block();
 
             last_sync_block_num_ = block_header::num_from_id(block_id_type(db_.last_sync_block_id()));
+            // continues the unfinished bulk load
+            bulk_loading_ = db_.is_bulk_load();
         }
         EVT_RETHROW_EXCEPTIONS(evt::postgres_plugin_exception,
             "Check integrity of postgres database failed, please use --clear-postgres to clear database");
@@ -485,14 +747,17 @@ postgres_plugin_impl::init(bool init_db) {
     if(init_db) {
         db_.init_pathman();
 
-        db_.prepare_tables();
+        bulk_loading_ = bulk_load_blocks_ > 0;
+
+        db_.prepare_tables(bulk_loading_);
         db_.prepare_stmts();
-        db_.prepare_stats();
+        db_.prepare_stats(bulk_loading_);
         
         if(part_limit_ != 0) {
             db_.create_partitions("public.blocks", "block_num", part_limit_, part_num_);
             db_.create_partitions("public.transactions", "block_num", part_limit_, part_num_);
             db_.create_partitions("public.actions", "block_num", part_limit_, part_num_);
+            db_.create_partitions("public.action_addresses", "block_num", part_limit_, part_num_);
         }
 
         // HACK: Add EVT and PEVT manually
@@ -520,6 +785,18 @@ postgres_plugin_impl::~postgres_plugin_impl() {
         cond_.notify_one();
 
         consume_thread_.join();
+        thread_pool_->join();
+        if(maintain_thread_.joinable()) {
+            {
+                auto lock = std::unique_lock<std::mutex>(maintain_mutex_);
+            }
+            maintain_cond_.notify_one();
+            maintain_thread_.join();
+        }
+        if(bulk_finish_thread_.joinable()) {
+            ilog("Waiting for indexes of postgres database being built");
+            bulk_finish_thread_.join();
+        }
         db_.close();
     }
     catch(std::exception& e) {
@@ -541,6 +818,15 @@ postgres_plugin::connstr() const {
     return my_->connstr_;
 }
 
+postgres_plugin::queue_metrics
+postgres_plugin::get_queue_metrics() const {
+    auto m = queue_metrics();
+    m.queued_blocks    = my_->queued_blocks_.load(std::memory_order_relaxed);
+    m.processed_blocks = my_->processed_blocks_.load(std::memory_order_relaxed);
+    m.queue_size       = my_->queue_size_;
+    return m;
+}
+
 void
 postgres_plugin::read_from_snapshot(const std::shared_ptr<chain::snapshot_reader>& snapshot) {
     my_->db_.restore(snapshot);
@@ -549,7 +835,7 @@ postgres_plugin::read_from_snapshot(const std::shared_ptr<chain::snapshot_reader
 void
 postgres_plugin::write_snapshot(const std::shared_ptr<chain::snapshot_writer>& snapshot) const {
     my_->lock_.lock();
-    while(my_->consuming_ || !my_->block_state_queue_.empty()) {
+    while(my_->consuming_ || my_->has_blocks()) {
         my_->ss_cond_.wait(my_->lock_);
     }
     my_->lock_.unlock();
@@ -566,6 +852,19 @@ postgres_plugin::set_program_options(options_description& cli, options_descripti
         ("clear-postgres", bpo::bool_switch()->default_value(false), "clear postgres database, use --delete-all-blocks option will force set this option")
         ("postgres-partition-limit", bpo::value<uint>()->default_value(30000000), "The partition limit")
         ("postgres-partition-num", bpo::value<uint>()->default_value(10), "The number of partitions")
+        ("postgres-partition-ahead", bpo::value<uint>()->default_value(2),
+            "The number of partitions kept created ahead of head block by the maintenance thread, so that ingestion never waits for creating them")
+        ("postgres-partition-retain", bpo::value<uint>()->default_value(0),
+            "The number of partitions kept behind head block, older ones are detached from the tables, 0 to keep all")
+        ("postgres-partition-archive-schema", bpo::value<std::string>()->default_value("archive"),
+            "The schema detached partitions are moved into, empty to leave them in place")
+        ("postgres-maintain-interval", bpo::value<uint32_t>()->default_value(60),
+            "The interval in seconds of detaching old partitions and refreshing statistics of the partitions being filled")
+        ("postgres-bulk-load", bpo::value<uint32_t>()->default_value(0),
+            "Load a new database in bulk mode: large tables are unlogged and secondary indexes are deferred until synced within this number of blocks of now, 0 to disable")
+        ("postgres-threads", bpo::value<uint16_t>()->default_value(2), "Number of worker threads converting blocks, transactions and actions into rows")
+        ("postgres-spill", bpo::value<bool>()->default_value(true),
+            "Spill blocks into a file in data dir when the queue is full instead of blocking the chain until it's consumed")
         ;
 }
 
@@ -601,10 +900,23 @@ postgres_plugin::plugin_initialize(const variables_map& options) {
         if(options.count("postgres-partition-num")) {
             my_->part_num_ = options.at("postgres-partition-num").as<uint>();
         }
+        my_->part_ahead_          = options.at("postgres-partition-ahead").as<uint>();
+        my_->part_retain_         = options.at("postgres-partition-retain").as<uint>();
+        my_->part_archive_schema_ = options.at("postgres-partition-archive-schema").as<std::string>();
+        my_->maintain_interval_   = options.at("postgres-maintain-interval").as<uint32_t>();
 
         if(options.count("postgres-queue-size")) {
             my_->queue_size_ = options.at("postgres-queue-size").as<uint>();
         }
+        if(memory_accounting::instance().enabled()) {
+            my_->mem_blocks_ = &memory_accounting::instance().counter("postgres_queue");
+        }
+
+        my_->bulk_load_blocks_ = options.at("postgres-bulk-load").as<uint32_t>();
+        my_->thread_pool_size_ = options.at("postgres-threads").as<uint16_t>();
+        EVT_ASSERT(my_->thread_pool_size_ > 0, plugin_config_exception,
+            "postgres-threads ${num} must be greater than 0", ("num", my_->thread_pool_size_));
+        my_->thread_pool_.emplace(my_->thread_pool_size_);
 
         auto uri = options.at("postgres-uri").as<std::string>();
         ilog("connecting to ${u}", ("u", uri));
@@ -616,6 +928,14 @@ postgres_plugin::plugin_initialize(const variables_map& options) {
             my_->wipe_database();
         }
 
+        auto spill_file = app().data_dir() / "postgres-spill.dat";
+        if(delete_state) {
+            fc::remove(spill_file);
+        }
+        if(options.at("postgres-spill").as<bool>()) {
+            my_->spill_.emplace(spill_file);
+        }
+
         if(options.count("snapshot")) {
             auto snapshot_path = options.at("snapshot").as<bfs::path>();
             EVT_ASSERT(fc::exists(snapshot_path), plugin_config_exception,
@@ -639,6 +959,13 @@ postgres_plugin::plugin_initialize(const variables_map& options) {
         }
 
         my_->init(delete_state);
+        my_->db_.open_commit_conns();
+
+        if(my_->part_limit_ != 0) {
+            my_->db_.open_maintain_conn();
+            my_->head_block_num_  = my_->last_sync_block_num_;
+            my_->maintain_thread_ = std::thread([this] { my_->maintain_partitions(); });
+        }
 
         my_->consume_thread_ = std::thread([this] { my_->consume_queues(); });
     }
@@ -42,6 +42,34 @@ using namespace evt;
             }                                                                       \
     }
 
+#define CALL_ASYNC(api_name, api_handle, call_name, in_param, call_result, http_response_code)                     \
+    {                                                                                                           \
+        std::string("/v1/" #api_name "/" #call_name),                                                           \
+            [&api_handle](string, string body, url_response_callback cb) mutable {                              \
+                try {                                                                                           \
+                    if(body.empty())                                                                            \
+                        body = "{}";                                                                            \
+                    api_handle.call_name(fc::json::from_string(body).as<in_param>(),                            \
+                        [cb, body](const fc::static_variant<fc::exception_ptr, call_result>& result) {          \
+                            if(result.contains<fc::exception_ptr>()) {                                          \
+                                try {                                                                           \
+                                    result.get<fc::exception_ptr>()->dynamic_rethrow_exception();               \
+                                }                                                                               \
+                                catch(...) {                                                                    \
+                                    http_plugin::handle_exception(#api_name, #call_name, body, cb);             \
+                                }                                                                               \
+                            }                                                                                   \
+                            else {                                                                              \
+                                cb(http_response_code, fc::json::to_string(result.get<call_result>()));         \
+                            }                                                                                   \
+                        });                                                                                     \
+                }                                                                                               \
+                catch(...) {                                                                                    \
+                    http_plugin::handle_exception(#api_name, #call_name, body, cb);                             \
+                }                                                                                               \
+            }                                                                                                   \
+    }
+
 #define INVOKE_R_R(api_handle, call_name, in_param) \
     auto result = api_handle.call_name(fc::json::from_string(body).as<in_param>());
 
@@ -84,8 +112,10 @@ producer_api_plugin::plugin_startup() {
              INVOKE_V_R(producer, update_runtime_options, producer_plugin::runtime_options), 201),
         CALL(producer, producer, get_integrity_hash,
              INVOKE_R_V(producer, get_integrity_hash), 201),
-        CALL(producer, producer, create_snapshot,
-             INVOKE_R_R(producer, create_snapshot, producer_plugin::create_snapshot_options), 201)},
+        CALL(producer, producer, perf_stats,
+             INVOKE_R_R(producer, perf_stats, producer_plugin::perf_stats_params), 201),
+        CALL_ASYNC(producer, producer, create_snapshot, producer_plugin::create_snapshot_options,
+                   producer_plugin::snapshot_information, 201)},
         true /* local only API */);
 }
 
@@ -98,6 +128,7 @@ producer_api_plugin::plugin_initialize(const variables_map& options) {}
 #undef INVOKE_V_R
 #undef INVOKE_V_R_R
 #undef INVOKE_V_V
+#undef CALL_ASYNC
 #undef CALL
 
 }  // namespace evt
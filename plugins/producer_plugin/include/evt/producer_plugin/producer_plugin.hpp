@@ -38,10 +38,31 @@ public:
         std::string          snapshot_name;
         size_t               snapshot_size;
         bool                 postgres;
+
+        std::optional<chain::block_id_type> base_block_id;
     };
 
     struct create_snapshot_options {
         bool postgres = false;
+
+        // incremental snapshot is created when it's set, deltas are from state_delta_plugin
+        std::optional<chain::block_id_type> base_block_id;
+    };
+
+    // counters since startup
+    struct metrics_info {
+        uint64_t trxs_received   = 0;
+        uint64_t trxs_rejected   = 0;  // pending queue is full
+        uint64_t trxs_retried    = 0;  // didn't fit in the block and queued again
+        uint64_t trxs_failed     = 0;
+        uint64_t blocks_produced = 0;
+        uint64_t pending_trxs    = 0;
+        uint64_t persistent_trxs = 0;
+    };
+
+    struct perf_stats_params {
+        // also dumps the phases of the recent blocks in chrome trace format
+        optional<uint32_t> trace_blocks;
     };
 
     producer_plugin();
@@ -65,7 +86,12 @@ public:
     runtime_options get_runtime_options() const;
 
     integrity_hash_information get_integrity_hash() const;
-    snapshot_information create_snapshot(const create_snapshot_options& options) const;
+    // only called from main thread
+    metrics_info get_metrics() const;
+    // histograms of the controller phases per block
+    fc::variant perf_stats(const perf_stats_params& params) const;
+    // snapshot is written on another thread, `next` is called on main thread once it's finished
+    void create_snapshot(const create_snapshot_options& options, chain::plugin_interface::next_function<snapshot_information> next) const;
 
     signal<void(const chain::producer_confirmation&)> confirmed_block;
 
@@ -77,5 +103,6 @@ private:
 
 FC_REFLECT(evt::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us));
 FC_REFLECT(evt::producer_plugin::integrity_hash_information, (head_block_num)(head_block_id)(head_block_time)(integrity_hash));
-FC_REFLECT(evt::producer_plugin::snapshot_information, (head_block_num)(head_block_id)(head_block_time)(snapshot_name)(snapshot_size)(postgres));
-FC_REFLECT(evt::producer_plugin::create_snapshot_options, (postgres));
+FC_REFLECT(evt::producer_plugin::snapshot_information, (head_block_num)(head_block_id)(head_block_time)(snapshot_name)(snapshot_size)(postgres)(base_block_id));
+FC_REFLECT(evt::producer_plugin::create_snapshot_options, (postgres)(base_block_id));
+FC_REFLECT(evt::producer_plugin::perf_stats_params, (trace_blocks));
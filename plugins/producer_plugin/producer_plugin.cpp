@@ -5,8 +5,13 @@
 #include <evt/producer_plugin/producer_plugin.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <thread>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/asio.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/function_output_iterator.hpp>
@@ -18,12 +23,18 @@
 #include <boost/signals2/connection.hpp>
 
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <evt/chain/global_property_object.hpp>
+#include <evt/chain/perf_stats.hpp>
 #include <evt/chain/plugin_interface.hpp>
+#include <evt/chain/app_lanes.hpp>
 #include <evt/chain/snapshot.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/state_delta_plugin/state_delta_plugin.hpp>
+#include <evt/utilities/rate_limiter.hpp>
 
 #ifdef POSTGRES_SUPPORT
 #include <evt/postgres_plugin/postgres_plugin.hpp>
@@ -62,6 +73,9 @@ static appbase::abstract_plugin& _producer_plugin = app().register_plugin<produc
 using namespace evt::chain;
 using namespace evt::chain::plugin_interface;
 
+constexpr auto def_max_pending_trxs           = 100000;
+constexpr auto def_max_pending_trxs_per_payer = 1000;
+
 namespace {
 bool
 failure_is_subjective(const fc::exception& e, bool deadline_is_subjective) {
@@ -84,6 +98,158 @@ using transaction_id_with_expiry_index = multi_index_container<
         hashed_unique<tag<by_id>, BOOST_MULTI_INDEX_MEMBER(transaction_id_with_expiry, transaction_id_type, trx_id)>,
         ordered_non_unique<tag<by_expiry>, BOOST_MULTI_INDEX_MEMBER(transaction_id_with_expiry, fc::time_point, expiry)>>>;
 
+/**
+ *  Incoming transactions waiting for a pending block, or retried after they couldn't fit in one.
+ *  Payers take turns so that a payer flooding the node doesn't delay the others, transactions of
+ *  one payer keep their order. Admission is bounded both per payer and in total, transactions
+ *  beyond the bounds are rejected instead of being queued.
+ */
+class pending_transaction_queue {
+public:
+    using entry = std::tuple<transaction_metadata_ptr, bool, next_function<transaction_trace_ptr>>;
+
+public:
+    pending_transaction_queue(size_t max_size, size_t max_per_payer)
+        : max_size_(max_size), max_per_payer_(max_per_payer) {}
+
+public:
+    // `force` skips the bounds, used for the transactions accepted before
+    bool
+    push(entry&& e, bool force = false) {
+        if(!force && size_ >= max_size_) {
+            return false;
+        }
+        auto key = fc::raw::pack(std::get<0>(e)->packed_trx->get_transaction().payer);
+        auto it  = payers_.find(key);
+        if(it == payers_.end()) {
+            it = payers_.emplace(key, deque<entry>()).first;
+            turns_.emplace_back(std::move(key));
+        }
+        else if(!force && it->second.size() >= max_per_payer_) {
+            return false;
+        }
+        it->second.emplace_back(std::move(e));
+        size_++;
+        return true;
+    }
+
+    // next transaction to be popped, null if empty
+    const entry*
+    front() const {
+        return turns_.empty() ? nullptr : &payers_.find(turns_.front())->second.front();
+    }
+
+    // takes the next transaction of the payer whose turn it is
+    bool
+    pop(entry& e) {
+        if(turns_.empty()) {
+            return false;
+        }
+        auto key = std::move(turns_.front());
+        turns_.pop_front();
+
+        auto it = payers_.find(key);
+        e = std::move(it->second.front());
+        it->second.pop_front();
+        size_--;
+        if(it->second.empty()) {
+            payers_.erase(it);
+        }
+        else {
+            turns_.emplace_back(std::move(key));
+        }
+        return true;
+    }
+
+    size_t size() const { return size_; }
+    bool   empty() const { return size_ == 0; }
+
+private:
+    using payer_key = vector<char>;  // packed payer address
+
+    size_t max_size_;
+    size_t max_per_payer_;
+    size_t size_ = 0;
+
+    std::map<payer_key, deque<entry>> payers_;
+    deque<payer_key>                  turns_;  // payers having transactions queued, in the order of their turns
+};
+
+/**
+ *  Predicts the execution time of transactions from the times of their actions, learned from
+ *  the traces of the transactions applied. Each action keeps the moving average of its time and
+ *  of the deviation from it, prediction adds two deviations to stay on the safe side. Time spent
+ *  outside of the actions of transaction, like checking authorities and paying the charge, is
+ *  learned as the overhead of one transaction. Actions never seen are predicted as free, they're
+ *  learned by executing them once.
+ */
+class action_cost_model {
+public:
+    // seeds the cost of an action, from benchmarks for example
+    void
+    set(action_name name, int64_t us) {
+        costs_[name] = cost{us, 0};
+    }
+
+    void
+    observe(const transaction_trace& trace) {
+        auto& traces = trace.action_traces;
+        auto  total  = int64_t(0);
+        for(auto i = 0u; i < traces.size();) {
+            // generated actions follow the one generating them, they're counted as part of it
+            auto& t   = traces[i];
+            auto  num = 1 + t.generated_actions.size();
+            auto  us  = int64_t(0);
+            for(auto j = i; j < i + num && j < traces.size(); j++) {
+                us += traces[j].elapsed.count();
+            }
+            if(t.act.name != contracts::paycharge::get_action_name()) {
+                update(costs_[t.act.name], us);
+                total += us;
+            }
+            i += num;
+        }
+        update(overhead_, std::max<int64_t>(trace.elapsed.count() - total, 0));
+    }
+
+    fc::microseconds
+    predict(const transaction& trx) const {
+        auto us = estimate(overhead_);
+        for(auto& act : trx.actions) {
+            auto it = costs_.find(act.name);
+            if(it != costs_.end()) {
+                us += estimate(it->second);
+            }
+        }
+        return fc::microseconds(us);
+    }
+
+private:
+    struct cost {
+        int64_t avg = -1;  // negative if never observed
+        int64_t dev = 0;
+    };
+
+    static void
+    update(cost& c, int64_t us) {
+        if(c.avg < 0) {
+            c.avg = us;
+            return;
+        }
+        c.dev = (c.dev * 7 + std::abs(us - c.avg)) / 8;
+        c.avg = (c.avg * 7 + us) / 8;
+    }
+
+    static int64_t
+    estimate(const cost& c) {
+        return c.avg < 0 ? 0 : c.avg + c.dev * 2;
+    }
+
+private:
+    std::map<action_name, cost> costs_;
+    cost                        overhead_;
+};
+
 enum class pending_block_mode {
     producing,
     speculating
@@ -123,6 +289,8 @@ public:
     boost::program_options::variables_map _options;
     bool                                  _production_enabled    = false;
     bool                                  _pause_production      = false;
+    bool                                  _pre_execute_block     = false;
+    bool                                  _pre_executing         = false;  // pending block is for the next slot of ours
     uint32_t                              _production_skip_flags = 0;  //evt::chain::skip_nothing;
 
     using signature_provider_type = std::function<chain::signature_type(chain::digest_type)>;
@@ -159,6 +327,7 @@ public:
 
     optional<scoped_connection> _accepted_block_connection;
     optional<scoped_connection> _irreversible_block_connection;
+    optional<scoped_connection> _applied_transaction_connection;
 
     /*
        * HACK ALERT
@@ -174,6 +343,33 @@ public:
 
     // path to write the snapshots to
     bfs::path _snapshots_dir;
+    // snapshot is finished on this thread after chain state is pinned
+    std::thread       _snapshot_thread;
+    std::atomic<bool> _snapshot_running{false};
+    // scheduled snapshots, disabled when both intervals are zero
+    uint32_t                                 _snapshot_interval_blocks = 0;
+    fc::microseconds                         _snapshot_interval_time;
+    uint32_t                                 _snapshot_retention = 0;  // number of scheduled ones kept, zero keeps all
+    fc::time_point                           _last_snapshot_time;
+    std::shared_ptr<utilities::rate_limiter> _snapshot_limiter;  // shared by all the snapshots written
+
+    void create_snapshot(const producer_plugin::create_snapshot_options& options, bool scheduled, next_function<producer_plugin::snapshot_information> next);
+    void schedule_snapshot(const block_state_ptr& bsp);
+    void remove_old_snapshots();
+
+    // unapplied transactions sorted out off the block-start path for the blocks from `timestamp`
+    struct unapplied_maintenance {
+        block_timestamp_type             timestamp;
+        vector<transaction_metadata_ptr> expired;  // dropped when block starts
+        vector<transaction_metadata_ptr> retry;    // in the order of expiration
+    };
+    std::future<unapplied_maintenance> _maintenance;
+    // transactions of the blocks aborted after the maintenance is prepared, they're not in it
+    vector<transaction_metadata_ptr> _aborted_trxs;
+
+    void                            prepare_maintenance();
+    optional<unapplied_maintenance> take_maintenance(block_timestamp_type timestamp);
+    void                            abort_pending_block();
 
     void
     on_block(const block_state_ptr& bsp) {
@@ -184,11 +380,11 @@ public:
         if(bsp->block_num <= _last_signed_block_num)
             return;
 
-        const auto& active_producer_to_signing_key = bsp->active_schedule.producers;
+        const auto& active_producer_to_signing_key = bsp->active_schedule->producers;
 
         flat_set<account_name> active_producers;
-        active_producers.reserve(bsp->active_schedule.producers.size());
-        for(const auto& p : bsp->active_schedule.producers) {
+        active_producers.reserve(bsp->active_schedule->producers.size());
+        for(const auto& p : bsp->active_schedule->producers) {
             active_producers.insert(p.producer_name);
         }
 
@@ -223,15 +419,15 @@ public:
         auto new_bs                         = bsp -> generate_next(new_block_header.timestamp);
 
         // for newly installed producers we can set their watermarks to the block they became active
-        if(new_bs.maybe_promote_pending() && bsp->active_schedule.version != new_bs.active_schedule.version) {
+        if(new_bs.maybe_promote_pending() && bsp->active_schedule->version != new_bs.active_schedule->version) {
             flat_set<account_name> new_producers;
-            new_producers.reserve(new_bs.active_schedule.producers.size());
-            for(const auto& p : new_bs.active_schedule.producers) {
+            new_producers.reserve(new_bs.active_schedule->producers.size());
+            for(const auto& p : new_bs.active_schedule->producers) {
                 if(_producers.count(p.producer_name) > 0)
                     new_producers.insert(p.producer_name);
             }
 
-            for(const auto& p : bsp->active_schedule.producers) {
+            for(const auto& p : bsp->active_schedule->producers) {
                 new_producers.erase(p.producer_name);
             }
 
@@ -305,7 +501,7 @@ public:
         }
 
         // abort the pending block
-        chain.abort_block();
+        abort_pending_block();
 
         // exceptions throw out, make sure we restart our loop
         auto ensure = fc::make_scoped_exit([this]() {
@@ -353,13 +549,23 @@ public:
         }
     }
     
-    std::deque<std::tuple<transaction_metadata_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
+    pending_transaction_queue _pending_incoming_transactions{def_max_pending_trxs, def_max_pending_trxs_per_payer};
+
+    producer_plugin::metrics_info _metrics;
+    action_cost_model         _action_costs;
 
     void
     on_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
         chain::controller& chain = chain_plug->chain();
         const auto&        cfg   = chain.get_global_properties().configuration;
 
+        // retried ones keep the time they're queued first
+        if(trx->timestamps && !trx->timestamps->has(trx_timestamps::queued)) {
+            trx->timestamps->mark(trx_timestamps::queued);
+        }
+        // warm up its keys while it's waiting in the queue
+        chain.prefetch_transaction(trx);
+
         app().get_io_service().post([self = this, trx, persist_until_expired, next]() {
             self->process_incoming_transaction_async(trx, persist_until_expired, next);
         });
@@ -368,8 +574,15 @@ public:
     void
     process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
         chain::controller& chain = chain_plug->chain();
+        _metrics.trxs_received++;
         if(!chain.pending_block_state()) {
-            _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+            if(!_pending_incoming_transactions.push(std::make_tuple(trx, persist_until_expired, next))) {
+                _metrics.trxs_rejected++;
+                auto e = std::static_pointer_cast<fc::exception>(std::make_shared<pending_trxs_exhausted>(
+                    FC_LOG_MESSAGE(error, "too many pending transactions, rejecting ${id}", ("id", trx->id))));
+                next(e);
+                _transaction_ack_channel.publish(priority::low, std::pair<fc::exception_ptr, transaction_metadata_ptr>(e, trx));
+            }
             return;
         }
 
@@ -421,11 +634,21 @@ public:
             deadline               = block_deadline;
         }
 
+        // the one predicted not to fit is not started, it would only be aborted at deadline
+        if(_pending_block_mode == pending_block_mode::producing && fc::time_point::now() + predict_time(trx) > block_deadline) {
+            fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} is PREDICTED NOT TO FIT, tx: ${txid} RETRYING ",
+                    ("block_num", chain.head_block_num() + 1)("prod", chain.pending_block_state()->header.producer)("txid", trx->id));
+            _pending_incoming_transactions.push(std::make_tuple(trx, persist_until_expired, next), true);
+            _metrics.trxs_retried++;
+            return;
+        }
+
         try {
             auto trace = chain.push_transaction(trx, deadline);
             if(trace->except) {
                 if(failure_is_subjective(*trace->except, deadline_is_subjective)) {
-                    _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+                    _pending_incoming_transactions.push(std::make_tuple(trx, persist_until_expired, next), true);
+                    _metrics.trxs_retried++;
                     if(_pending_block_mode == pending_block_mode::producing) {
                         fc_dlog(_trx_trace_log, "[TRX_TRACE] Block ${block_num} for producer ${prod} COULD NOT FIT, tx: ${txid} RETRYING ",
                                 ("block_num", chain.head_block_num() + 1)("prod", chain.pending_block_state()->header.producer)("txid", trx->id));
@@ -437,6 +660,7 @@ public:
                 }
                 else {
                     auto e_ptr = trace->except->dynamic_copy_exception();
+                    _metrics.trxs_failed++;
                     send_response(e_ptr);
                 }
             }
@@ -458,6 +682,18 @@ public:
         CATCH_AND_CALL(send_response);
     }
 
+    fc::microseconds
+    predict_time(const transaction_metadata_ptr& trx) const {
+        return _action_costs.predict(trx->packed_trx->get_transaction());
+    }
+
+    void
+    on_applied_transaction(const transaction_trace_ptr& trace) {
+        if(!trace->except && !trace->action_traces.empty()) {
+            _action_costs.observe(*trace);
+        }
+    }
+
     fc::microseconds
     get_irreversible_block_age() {
         auto now = fc::time_point::now();
@@ -526,8 +762,18 @@ producer_plugin::set_program_options(
             [this](bool e) { my->_production_enabled = e; }), "Enable block production, even if the chain is stale.")
         ("pause-on-startup,x", boost::program_options::bool_switch()->notifier(
             [this](bool p) { my->_pause_production = p; }), "Start this node in a state where production is paused")
+        ("pre-execute-block", boost::program_options::bool_switch()->notifier(
+            [this](bool p) { my->_pre_execute_block = p; }), "Build the speculative block for the next slot when it's ours, and keep it to produce if head is not changed when slot begins")
         ("max-transaction-time", bpo::value<int32_t>()->default_value(30),
             "Limits the maximum time (in milliseconds) that is allowed a pushed transaction's code to execute before being considered invalid")
+        ("max-pending-transactions", bpo::value<uint32_t>()->default_value(def_max_pending_trxs),
+            "Limits the maximum number of incoming transactions queued while waiting for a pending block, more are rejected")
+        ("max-pending-transactions-per-payer", bpo::value<uint32_t>()->default_value(def_max_pending_trxs_per_payer),
+            "Limits the maximum number of incoming transactions of one payer queued while waiting for a pending block")
+        ("action-cost", bpo::value<vector<string>>()->composing(),
+            "Initial execution time of one action in the form of <action name>=<microseconds>, e.g. the result of benchmarks, it's adjusted by the actions applied later")
+        ("perf-trace-blocks", bpo::value<uint32_t>()->default_value(0),
+            "Number of recent blocks whose controller phases are kept for the Chrome trace of /v1/producer/perf_stats, 0 to disable it")
         ("max-irreversible-block-age", bpo::value<int32_t>()->default_value(-1),
             "Limits the maximum age (in seconds) of the DPOS Irreversible Block for a chain this node will produce blocks on (use negative value to indicate unlimited)")
         ("producer-name,p", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -550,6 +796,14 @@ producer_plugin::set_program_options(
             "offset of last block producing time in microseconds. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
             "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("snapshot-interval-blocks", bpo::value<uint32_t>()->default_value(0),
+            "create snapshot in background when the number of accepted block is a multiple of it, 0 to disable")
+         ("snapshot-interval-seconds", bpo::value<uint32_t>()->default_value(0),
+            "create snapshot in background once this many seconds of block time passed since the last scheduled one, 0 to disable")
+         ("snapshot-retention", bpo::value<uint32_t>()->default_value(0),
+            "number of the latest scheduled snapshots kept in snapshots directory, 0 to keep all")
+         ("snapshot-write-rate-limit-mb", bpo::value<uint32_t>()->default_value(0),
+            "maximum MB per second written by snapshots, both scheduled and the requested ones, 0 for unlimited")
          ;
     config_file_options.add(producer_options); 
 }
@@ -677,6 +931,19 @@ producer_plugin::plugin_initialize(const boost::program_options::variables_map&
 
         my->_max_transaction_time_ms = options.at("max-transaction-time").as<int32_t>();
 
+        my->_pending_incoming_transactions = pending_transaction_queue(options.at("max-pending-transactions").as<uint32_t>(),
+                                                                       options.at("max-pending-transactions-per-payer").as<uint32_t>());
+
+        my->chain_plug->chain().get_perf_stats().set_trace_blocks(options.at("perf-trace-blocks").as<uint32_t>());
+
+        if(options.count("action-cost")) {
+            for(auto& c : options.at("action-cost").as<vector<string>>()) {
+                auto pos = c.find('=');
+                EVT_ASSERT(pos != string::npos, plugin_config_exception, "Invalid action-cost: ${c}", ("c", c));
+                my->_action_costs.set(action_name(c.substr(0, pos)), std::stoll(c.substr(pos + 1)));
+            }
+        }
+
         my->_max_irreversible_block_age_us = fc::seconds(options.at("max-irreversible-block-age").as<int32_t>());
 
         if(options.count("snapshots-dir")) {
@@ -695,6 +962,13 @@ producer_plugin::plugin_initialize(const boost::program_options::variables_map&
                        "No such directory '${dir}'", ("dir", my->_snapshots_dir.generic_string()));
         }
 
+        my->_snapshot_interval_blocks = options.at("snapshot-interval-blocks").as<uint32_t>();
+        my->_snapshot_interval_time   = fc::seconds(options.at("snapshot-interval-seconds").as<uint32_t>());
+        my->_snapshot_retention       = options.at("snapshot-retention").as<uint32_t>();
+        if(auto mb = options.at("snapshot-write-rate-limit-mb").as<uint32_t>(); mb > 0) {
+            my->_snapshot_limiter = std::make_shared<utilities::rate_limiter>((uint64_t)mb * 1024 * 1024);
+        }
+
         my->_incoming_block_subscription = app().get_channel<incoming::channels::block>().subscribe([this](const signed_block_ptr& block) {
             try {
                 my->on_incoming_block(block);
@@ -733,8 +1007,12 @@ producer_plugin::plugin_startup() {
         EVT_ASSERT(my->_producers.empty() || chain.get_validation_mode() == chain::validation_mode::FULL, plugin_config_exception,
             "node cannot have any producer-name configured because block production is not safe when validation_mode is not \"full\"");
 
-        my->_accepted_block_connection.emplace(chain.accepted_block.connect([this](const auto& bsp) { my->on_block(bsp); }));
+        my->_accepted_block_connection.emplace(chain.accepted_block.connect([this](const auto& bsp) {
+            my->on_block(bsp);
+            my->schedule_snapshot(bsp);
+        }));
         my->_irreversible_block_connection.emplace(chain.irreversible_block.connect([this](const auto& bsp) { my->on_irreversible_block(bsp->block); }));
+        my->_applied_transaction_connection.emplace(chain.applied_transaction.connect([this](const auto& trace) { my->on_applied_transaction(trace); }));
 
         const auto lib_num = chain.last_irreversible_block_num();
         const auto lib     = chain.fetch_block_by_number(lib_num);
@@ -772,8 +1050,13 @@ producer_plugin::plugin_shutdown() {
         edump((e.to_detail_string()));
     }
 
+    if(my->_snapshot_thread.joinable()) {
+        my->_snapshot_thread.join();
+    }
+
     my->_accepted_block_connection.reset();
     my->_irreversible_block_connection.reset();
+    my->_applied_transaction_connection.reset();
 }
 
 void
@@ -799,8 +1082,7 @@ producer_plugin::resume() {
     // re-evaluate that now
     //
     if(my->_pending_block_mode == pending_block_mode::speculating) {
-        chain::controller& chain = my->chain_plug->chain();
-        chain.abort_block();
+        my->abort_pending_block();
         my->schedule_production_loop();
     }
 }
@@ -832,8 +1114,7 @@ producer_plugin::update_runtime_options(const runtime_options& options) {
     }
 
     if(check_speculating && my->_pending_block_mode == pending_block_mode::speculating) {
-        chain::controller& chain = my->chain_plug->chain();
-        chain.abort_block();
+        my->abort_pending_block();
         my->schedule_production_loop();
     }
 }
@@ -848,6 +1129,26 @@ producer_plugin::get_runtime_options() const {
     };
 }
 
+producer_plugin::metrics_info
+producer_plugin::get_metrics() const {
+    auto m = my->_metrics;
+    m.pending_trxs    = my->_pending_incoming_transactions.size();
+    m.persistent_trxs = my->_persistent_transactions.size();
+    return m;
+}
+
+fc::variant
+producer_plugin::perf_stats(const perf_stats_params& params) const {
+    auto& stats  = my->chain_plug->chain().get_perf_stats();
+    auto  result = fc::mutable_variant_object(stats.to_variant().get_object());
+
+    if(params.trace_blocks.has_value()) {
+        EVT_ASSERT(stats.trace_blocks() > 0, plugin_config_exception, "Tracing of phases is disabled, enable it by --perf-trace-blocks");
+        result("trace", stats.chrome_trace(*params.trace_blocks));
+    }
+    return result;
+}
+
 producer_plugin::integrity_hash_information
 producer_plugin::get_integrity_hash() const {
     chain::controller& chain = my->chain_plug->chain();
@@ -858,7 +1159,7 @@ producer_plugin::get_integrity_hash() const {
 
     if(chain.pending_block_state()) {
         // abort the pending block
-        chain.abort_block();
+        my->abort_pending_block();
     }
     else {
         reschedule.cancel();
@@ -867,68 +1168,195 @@ producer_plugin::get_integrity_hash() const {
     return {chain.head_block_num(), chain.head_block_id(), chain.head_block_time(), chain.calculate_integrity_hash()};
 }
 
-producer_plugin::snapshot_information
-producer_plugin::create_snapshot(const create_snapshot_options& options) const {
-    chain::controller& chain = my->chain_plug->chain();
+void
+producer_plugin::create_snapshot(const create_snapshot_options& options, next_function<snapshot_information> next) const {
+    my->create_snapshot(options, false, next);
+}
 
-    auto reschedule = fc::make_scoped_exit([this]() {
-        my->schedule_production_loop();
-    });
+void
+producer_plugin_impl::create_snapshot(const producer_plugin::create_snapshot_options& options, bool scheduled, next_function<producer_plugin::snapshot_information> next) {
+    chain::controller& chain = chain_plug->chain();
 
-    if(chain.pending_block_state()) {
-        // abort the pending block
-        chain.abort_block();
-    }
-    else {
-        reschedule.cancel();
-    }
+    try {
+        EVT_ASSERT(!_snapshot_running, snapshot_exception, "Another snapshot is being created");
+
+        auto reschedule = fc::make_scoped_exit([this]() {
+            schedule_production_loop();
+        });
 
-    auto head_id       = chain.head_block_id();
-    auto snapshot_path = (my->_snapshots_dir / fc::format_string("snapshot-${id}.bin", fc::mutable_variant_object()("id", head_id))).generic_string();
+        if(chain.pending_block_state()) {
+            // abort the pending block
+            abort_pending_block();
+        }
+        else {
+            reschedule.cancel();
+        }
 
-    EVT_ASSERT(!fc::is_regular_file(snapshot_path), snapshot_exists_exception,
-               "snapshot named ${name} already exists", ("name", snapshot_path));
+        auto head_id       = chain.head_block_id();
+        // scheduled ones are named differently so that only they're removed by retention
+        auto snapshot_name = options.base_block_id.has_value() ? "snapshot-${id}-incremental.bin"
+                                                               : (scheduled ? "snapshot-${id}-scheduled.bin" : "snapshot-${id}.bin");
+        auto snapshot_path = (_snapshots_dir / fc::format_string(snapshot_name, fc::mutable_variant_object()("id", head_id))).generic_string();
 
-    auto snap_out = std::ofstream(snapshot_path, (std::ios::out | std::ios::binary));
-    auto writer   = std::make_shared<ostream_snapshot_writer>(snap_out);
+        EVT_ASSERT(!fc::is_regular_file(snapshot_path), snapshot_exists_exception,
+                   "snapshot named ${name} already exists", ("name", snapshot_path));
 
-    bool postgres = false;
+        auto snap_out = std::make_shared<std::ofstream>(snapshot_path, (std::ios::out | std::ios::binary));
+        auto writer   = std::make_shared<ostream_snapshot_writer>(*snap_out);
+        auto info     = producer_plugin::snapshot_information { chain.head_block_num(), head_id, chain.head_block_time(), snapshot_path, 0, false, options.base_block_id };
+        if(_snapshot_limiter) {
+            writer->set_rate_limiter(_snapshot_limiter);
+        }
 
-    chain.write_snapshot(writer);
-    if(options.postgres) {
-#ifdef POSTGRES_SUPPORT
-        if(app().find_plugin("evt::postgres_plugin") == nullptr) {
-            wlog("Cannot find postgres plugin, don't write postgres into snapshot");
+        // state is pinned here, blocks are produced and applied again once this returns
+        auto task = std::shared_future<void>();
+        if(options.base_block_id.has_value()) {
+            auto sdp = app().find_plugin<state_delta_plugin>();
+            EVT_ASSERT(sdp != nullptr && sdp->get_state() == abstract_plugin::started, snapshot_exception,
+                       "state_delta_plugin should be enabled to create incremental snapshots");
+            task = chain.write_incremental_snapshot_async(writer, *options.base_block_id, sdp->deltas_since(*options.base_block_id));
         }
         else {
-            auto& pp = app().get_plugin<postgres_plugin>();
-            if(!pp.enabled()) {
-                wlog("Postgres plugin is not enabled, don't write postgres into snapshot");
-            }
-            else {
-                pp.write_snapshot(writer);
-                postgres = true;
-            }
+            task = chain.write_snapshot_async(writer);
+        }
+
+        if(_snapshot_thread.joinable()) {
+            _snapshot_thread.join();
         }
+        _snapshot_running = true;
+        _snapshot_thread  = std::thread([this, task, snap_out, writer, info, options, scheduled, next]() mutable {
+            auto done = fc::make_scoped_exit([this] {
+                _snapshot_running = false;
+            });
+            try {
+                task.get();
+                if(options.postgres) {
+#ifdef POSTGRES_SUPPORT
+                    if(app().find_plugin("evt::postgres_plugin") == nullptr) {
+                        wlog("Cannot find postgres plugin, don't write postgres into snapshot");
+                    }
+                    else {
+                        auto& pp = app().get_plugin<postgres_plugin>();
+                        if(!pp.enabled()) {
+                            wlog("Postgres plugin is not enabled, don't write postgres into snapshot");
+                        }
+                        else {
+                            pp.write_snapshot(writer);
+                            info.postgres = true;
+                        }
+                    }
 #else
-        wlog("Postgres support is not enabled, don't write postgres into snapshot");
+                    wlog("Postgres support is not enabled, don't write postgres into snapshot");
 #endif
+                }
+
+                writer->finalize();
+                writer.reset();
+
+                info.snapshot_size = (size_t)snap_out->tellp();
+                snap_out->flush();
+                snap_out->close();
+
+                app().post(priority::low, [this, scheduled, next, info] {
+                    if(scheduled) {
+                        remove_old_snapshots();
+                    }
+                    next(info);
+                });
+            }
+            catch(...) {
+                auto post_next = [&next](const fc::exception_ptr& e) {
+                    app().post(priority::low, [next, e] {
+                        next(e);
+                    });
+                };
+                try {
+                    throw;
+                }
+                CATCH_AND_CALL(post_next);
+            }
+        });
+    }
+    CATCH_AND_CALL(next);
+}
+
+void
+producer_plugin_impl::schedule_snapshot(const block_state_ptr& bsp) {
+    if(_snapshot_interval_blocks == 0 && _snapshot_interval_time.count() == 0) {
+        return;
+    }
+
+    auto now = bsp->header.timestamp.to_time_point();
+    if(_last_snapshot_time == fc::time_point()) {
+        // time interval is counted from the first block seen
+        _last_snapshot_time = now;
+    }
+
+    auto due = (_snapshot_interval_blocks > 0 && bsp->block_num % _snapshot_interval_blocks == 0)
+               || (_snapshot_interval_time.count() > 0 && now - _last_snapshot_time >= _snapshot_interval_time);
+    if(!due) {
+        return;
+    }
+    if(_snapshot_running) {
+        wlog("Skip scheduled snapshot at block ${n}: last one is still being written", ("n", bsp->block_num));
+        return;
     }
+    _last_snapshot_time = now;
+
+    // block is still being applied or produced here, snapshot is started once it's done
+    app().post(priority::low, [this] {
+        if(_snapshot_running) {
+            return;
+        }
+        create_snapshot(producer_plugin::create_snapshot_options(), true, [](const auto& result) {
+            if(result.template contains<fc::exception_ptr>()) {
+                elog("Failed to create scheduled snapshot: ${e}", ("e", result.template get<fc::exception_ptr>()->to_detail_string()));
+                return;
+            }
+            auto& info = result.template get<producer_plugin::snapshot_information>();
+            ilog("Scheduled snapshot ${name} is created at block ${n}, size: ${s}",
+                 ("name", info.snapshot_name)("n", info.head_block_num)("s", info.snapshot_size));
+        });
+    });
+}
 
-    writer->finalize();
+void
+producer_plugin_impl::remove_old_snapshots() {
+    if(_snapshot_retention == 0) {
+        return;
+    }
 
-    auto sz = (size_t)snap_out.tellp(); 
-    snap_out.flush();
-    snap_out.close();
+    auto files = std::vector<bfs::path>();
+    for(auto it = bfs::directory_iterator(_snapshots_dir); it != bfs::directory_iterator(); ++it) {
+        auto name = it->path().filename().string();
+        if(bfs::is_regular_file(it->path()) && boost::starts_with(name, "snapshot-") && boost::ends_with(name, "-scheduled.bin")) {
+            files.emplace_back(it->path());
+        }
+    }
+    if(files.size() <= _snapshot_retention) {
+        return;
+    }
 
-    return {chain.head_block_num(), head_id, chain.head_block_time(), snapshot_path, sz, postgres};
+    // oldest ones first
+    std::sort(files.begin(), files.end(), [](auto& a, auto& b) {
+        return bfs::last_write_time(a) < bfs::last_write_time(b);
+    });
+    for(auto i = 0u; i < files.size() - _snapshot_retention; i++) {
+        auto ec = boost::system::error_code();
+        bfs::remove(files[i], ec);
+        if(ec) {
+            wlog("Cannot remove old snapshot ${f}: ${e}", ("f", files[i].generic_string())("e", ec.message()));
+            continue;
+        }
+        ilog("Removed old snapshot ${f}", ("f", files[i].generic_string()));
+    }
 }
 
 optional<fc::time_point>
 producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
     chain::controller& chain           = chain_plug->chain();
     const auto&        hbs             = chain.head_block_state();
-    const auto&        active_schedule = hbs->active_schedule.producers;
+    const auto&        active_schedule = hbs->active_schedule->producers;
 
     const auto& pbs = chain.pending_block_state();
     const auto& pbt = pbs->header.timestamp;
@@ -1027,9 +1455,10 @@ producer_plugin_impl::start_block() {
     //Schedule for the next second's tick regardless of chain state
     // If we would wait less than 50ms (1/10 of block_interval), wait for the whole block interval.
     const fc::time_point now = fc::time_point::now();
-    const fc::time_point block_time = calculate_pending_block_time();
+    fc::time_point block_time = calculate_pending_block_time();
 
     _pending_block_mode = pending_block_mode::producing;
+    _pre_executing      = false;
 
     // Not our turn
     const auto& scheduled_producer     = hbs->get_scheduled_producer(block_time);
@@ -1074,12 +1503,24 @@ producer_plugin_impl::start_block() {
         if(head_block_age > fc::seconds(5)) {
             return start_block_result::waiting;
         }
+
+        // next slot is ours, speculate on it so that transactions executed now are kept
+        // if previous block is not received before our slot begins
+        if(_pre_execute_block && !production_disabled_by_policy()) {
+            auto  next_time     = block_timestamp_type(block_time).next();
+            auto& next_producer = hbs->get_scheduled_producer(next_time);
+            if(_producers.count(next_producer.producer_name) && _signature_providers.count(next_producer.block_signing_key)) {
+                block_time             = next_time.to_time_point();
+                currrent_watermark_itr = _producer_watermarks.find(next_producer.producer_name);
+                _pre_executing         = true;
+            }
+        }
     }
 
     try {
         uint16_t blocks_to_confirm = 0;
 
-        if(_pending_block_mode == pending_block_mode::producing) {
+        if(_pending_block_mode == pending_block_mode::producing || _pre_executing) {
             // determine how many blocks this producer can confirm
             // 1) if it is not a producer from this node, assume no confirmations (we will discard this block anyway)
             // 2) if it is a producer on this node that has never produced, the conservative approach is to assume no
@@ -1094,8 +1535,16 @@ producer_plugin_impl::start_block() {
             }
         }
 
-        chain.abort_block();
-        chain.start_block(block_time, blocks_to_confirm);
+        // reuse the pre-executed block if nothing changes since it was started
+        auto& pre = chain.pending_block_state();
+        if(_pre_execute_block && pre && pre->header.previous == hbs->id
+            && pre->header.timestamp == block_timestamp_type(block_time) && pre->header.confirmed == blocks_to_confirm) {
+            fc_dlog(_log, "Reuse pending block #${num} which is pre-executed", ("num", pre->block_num));
+        }
+        else {
+            abort_pending_block();
+            chain.start_block(block_time, blocks_to_confirm);
+        }
     }
     FC_LOG_AND_DROP();
 
@@ -1180,28 +1629,50 @@ producer_plugin_impl::start_block() {
                         }
                     };
 
-                    auto itr = unapplied_trxs.begin();
-                    while(itr != unapplied_trxs.end()) {
-                        auto itr_next = itr;  // save off next since itr may be invalidated by loop
-                        ++itr_next;
+                    // retried in the order of expiration so the ones about to expire get in first,
+                    // chain.push_transaction can modify unapplied_trxs, so they are erased by id
+                    auto trxs = vector<transaction_metadata_ptr>();
+                    if(auto m = take_maintenance(pbs->header.timestamp)) {
+                        for(const auto& trx : m->expired) {
+                            unapplied_trxs.erase(trx->signed_id);
+                        }
+                        trxs = std::move(m->retry);
+                    }
+                    else {
+                        trxs.reserve(unapplied_trxs_size);
+                        for(const auto& t : unapplied_trxs) {
+                            trxs.emplace_back(t.second);
+                        }
+                        std::stable_sort(trxs.begin(), trxs.end(), [](const auto& a, const auto& b) {
+                            return a->packed_trx->expiration() < b->packed_trx->expiration();
+                        });
+                    }
 
+                    for(const auto& trx : trxs) {
                         if(preprocess_deadline <= fc::time_point::now()) {
                             exhausted = true;
                         }
                         if(exhausted) {
                             break;
                         }
-                        const auto& trx      = itr->second;
-                        auto        category = calculate_transaction_category(trx);
+                        // prepared ones may be applied or dropped since
+                        if(unapplied_trxs.find(trx->signed_id) == unapplied_trxs.end()) {
+                            continue;
+                        }
+                        auto category = calculate_transaction_category(trx);
                         if(category == tx_category::EXPIRED || (category == tx_category::UNEXPIRED_UNPERSISTED && _producers.empty())) {
                             if(!_producers.empty()) {
                                 fc_dlog(_trx_trace_log, "[TRX_TRACE] Node with producers configured is dropping an EXPIRED transaction that was PREVIOUSLY ACCEPTED : ${txid}",
                                         ("txid", trx->id));
                             }
-                            itr = unapplied_trxs.erase(itr);  // unapplied_trxs map has not been modified, so simply erase and continue
+                            unapplied_trxs.erase(trx->signed_id);
                             continue;
                         }
                         else if(category == tx_category::PERSISTED || (category == tx_category::UNEXPIRED_UNPERSISTED && _pending_block_mode == pending_block_mode::producing)) {
+                            // smaller ones after it may still fit
+                            if(fc::time_point::now() + predict_time(trx) >= preprocess_deadline) {
+                                continue;
+                            }
                             ++num_processed;
 
                             try {
@@ -1235,8 +1706,6 @@ producer_plugin_impl::start_block() {
                             }
                             FC_LOG_AND_DROP();
                         }
-
-                        itr = itr_next;
                     }
 
                     fc_dlog(_log, "Processed ${m} of ${n} previously applied transactions, Applied ${applied}, Failed/Dropped ${failed}",
@@ -1270,10 +1739,12 @@ producer_plugin_impl::start_block() {
                 // attempt to apply any pending incoming transactions
                 if(!_pending_incoming_transactions.empty()) {
                     fc_dlog(_log, "Processing ${n} pending transactions", ("n", _pending_incoming_transactions.size()));
+                    auto e = pending_transaction_queue::entry();
                     while(orig_pending_txn_size && _pending_incoming_transactions.size()) {
-                        if (preprocess_deadline <= fc::time_point::now()) return start_block_result::exhausted;
-                        auto e = _pending_incoming_transactions.front();
-                        _pending_incoming_transactions.pop_front();
+                        // stops once the next transaction is not likely to finish before deadline
+                        auto& next_trx = std::get<0>(*_pending_incoming_transactions.front());
+                        if(fc::time_point::now() + predict_time(next_trx) >= preprocess_deadline) return start_block_result::exhausted;
+                        _pending_incoming_transactions.pop(e);
                         --orig_pending_txn_size;
                         process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
                     }
@@ -1294,6 +1765,92 @@ producer_plugin_impl::start_block() {
     return start_block_result::failed;
 }
 
+void
+producer_plugin_impl::prepare_maintenance() {
+    chain::controller& chain = chain_plug->chain();
+    const auto& pbs = chain.pending_block_state();
+    if(!pbs) {
+        return;
+    }
+
+    // expired persisted and blacklisted transactions are evicted here so few are left for block start
+    auto& persisted_by_expiry = _persistent_transactions.get<by_expiry>();
+    while(!persisted_by_expiry.empty() && persisted_by_expiry.begin()->expiry <= pbs->header.timestamp.to_time_point()) {
+        persisted_by_expiry.erase(persisted_by_expiry.begin());
+    }
+    auto& blacklist_by_expiry = _blacklisted_transactions.get<by_expiry>();
+    auto  now                 = fc::time_point::now();
+    while(!blacklist_by_expiry.empty() && blacklist_by_expiry.begin()->expiry <= now) {
+        blacklist_by_expiry.erase(blacklist_by_expiry.begin());
+    }
+
+    auto& unapplied_trxs = chain.get_unapplied_transactions();
+    if(unapplied_trxs.empty() || (_producers.empty() && _persistent_transactions.empty())) {
+        return;
+    }
+
+    auto trxs = vector<transaction_metadata_ptr>();
+    trxs.reserve(unapplied_trxs.size());
+    for(const auto& t : unapplied_trxs) {
+        trxs.emplace_back(t.second);
+    }
+    _aborted_trxs.clear();
+
+    // previous one is waited here if it's not taken
+    _maintenance = std::async(std::launch::async, [trxs = std::move(trxs), next = pbs->header.timestamp.next()]() mutable {
+        auto m      = unapplied_maintenance();
+        m.timestamp = next;
+
+        auto it = std::stable_partition(trxs.begin(), trxs.end(), [&](const auto& trx) {
+            return trx->packed_trx->expiration() < next.to_time_point();
+        });
+        m.expired.assign(std::make_move_iterator(trxs.begin()), std::make_move_iterator(it));
+        m.retry.assign(std::make_move_iterator(it), std::make_move_iterator(trxs.end()));
+        std::stable_sort(m.retry.begin(), m.retry.end(), [](const auto& a, const auto& b) {
+            return a->packed_trx->expiration() < b->packed_trx->expiration();
+        });
+        return m;
+    });
+}
+
+optional<producer_plugin_impl::unapplied_maintenance>
+producer_plugin_impl::take_maintenance(block_timestamp_type timestamp) {
+    if(!_maintenance.valid() || _maintenance.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return optional<unapplied_maintenance>();
+    }
+
+    auto m       = _maintenance.get();
+    auto aborted = std::move(_aborted_trxs);
+    _aborted_trxs.clear();
+    if(m.timestamp > timestamp) {
+        return optional<unapplied_maintenance>();
+    }
+
+    std::stable_sort(aborted.begin(), aborted.end(), [](const auto& a, const auto& b) {
+        return a->packed_trx->expiration() < b->packed_trx->expiration();
+    });
+    auto retry = vector<transaction_metadata_ptr>();
+    retry.reserve(m.retry.size() + aborted.size());
+    std::merge(std::make_move_iterator(m.retry.begin()), std::make_move_iterator(m.retry.end()),
+               std::make_move_iterator(aborted.begin()), std::make_move_iterator(aborted.end()),
+               std::back_inserter(retry), [](const auto& a, const auto& b) {
+        return a->packed_trx->expiration() < b->packed_trx->expiration();
+    });
+    m.retry = std::move(retry);
+    return m;
+}
+
+void
+producer_plugin_impl::abort_pending_block() {
+    chain::controller& chain = chain_plug->chain();
+    const auto& pbs = chain.pending_block_state();
+    if(pbs && _maintenance.valid()) {
+        // they're put back into unapplied transactions
+        _aborted_trxs.insert(_aborted_trxs.end(), pbs->trxs.begin(), pbs->trxs.end());
+    }
+    chain.abort_block();
+}
+
 void
 producer_plugin_impl::schedule_production_loop() {
     chain::controller& chain = chain_plug->chain();
@@ -1302,12 +1859,21 @@ producer_plugin_impl::schedule_production_loop() {
 
     auto result = start_block();
 
+    if(chain.pending_block_state()) {
+        // prepared for the next block once the pending one is done with
+        app().post(priority::low, [weak_this] {
+            if(auto self = weak_this.lock()) {
+                self->prepare_maintenance();
+            }
+        });
+    }
+
     if(result == start_block_result::failed) {
         elog("Failed to start a pending block, will try again later");
         _timer.expires_from_now(boost::posix_time::microseconds(config::block_interval_us / 10));
 
         // we failed to start a block, so try again later?
-        _timer.async_wait(app().get_priority_queue().wrap(priority::high,
+        _timer.async_wait(wrap_lane(app_lane::production,
             [weak_this, cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
             auto self = weak_this.lock();
             if(self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
@@ -1350,7 +1916,7 @@ producer_plugin_impl::schedule_production_loop() {
             }
         }
 
-        _timer.async_wait(app().get_priority_queue().wrap(priority::high,
+        _timer.async_wait(wrap_lane(app_lane::production,
             [&chain, weak_this, cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
             auto self = weak_this.lock();
             if(self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
@@ -1365,7 +1931,13 @@ producer_plugin_impl::schedule_production_loop() {
         fc_dlog(_log, "Specualtive Block Created; Scheduling Speculative/Production Change");
         EVT_ASSERT(chain.pending_block_state(), missing_pending_block_state, "speculating without pending_block_state");
         const auto& pbs = chain.pending_block_state();
-        schedule_delayed_production_loop(weak_this, pbs->header.timestamp);
+        if(_pre_executing) {
+            // wake up when our slot begins, which is the end of the slot before it
+            schedule_delayed_production_loop(weak_this, block_timestamp_type(pbs->header.timestamp.slot - 1));
+        }
+        else {
+            schedule_delayed_production_loop(weak_this, pbs->header.timestamp);
+        }
     }
     else {
         fc_dlog(_log, "Speculative Block Created");
@@ -1394,7 +1966,7 @@ producer_plugin_impl::schedule_delayed_production_loop(const std::weak_ptr<produ
         fc_dlog(_log, "Scheduling Speculative/Production Change at ${time}", ("time", wake_up_time));
         static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
         _timer.expires_at(epoch + boost::posix_time::microseconds(wake_up_time->time_since_epoch().count()));
-        _timer.async_wait(app().get_priority_queue().wrap(priority::high, [weak_this, cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
+        _timer.async_wait(wrap_lane(app_lane::production, [weak_this, cid = ++_timer_corelation_id](const boost::system::error_code& ec) {
             auto self = weak_this.lock();
             if(self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
                 self->schedule_production_loop();
@@ -1433,8 +2005,7 @@ producer_plugin_impl::maybe_produce_block() {
     }
 
     fc_dlog(_log, "Aborting block due to produce_block error");
-    chain::controller& chain = chain_plug->chain();
-    chain.abort_block();
+    abort_pending_block();
     return false;
 }
 
@@ -1470,16 +2041,19 @@ producer_plugin_impl::produce_block() {
 
     //idump( (fc::time_point::now() - chain.pending_block_time()) );
     chain.finalize_block();
-    chain.sign_block([&](const digest_type& d) {
+    chain.sign_block_async([provider = signature_provider_itr->second](const digest_type& d) {
         auto debug_logger = maybe_make_debug_time_logger();
-        return signature_provider_itr->second(d);
+        return provider(d);
     });
+    // work for the next block overlaps with signing, which can be remote
+    prepare_maintenance();
     chain.commit_block();
     auto hbt [[maybe_unused]] = chain.head_block_time();
     //idump((fc::time_point::now() - hbt));
 
     block_state_ptr new_bs = chain.head_block_state();
     _producer_watermarks[new_bs->header.producer] = chain.head_block_num();
+    _metrics.blocks_produced++;
 
     ilog("Produced block ${id}... #${n} @ ${t} signed by ${p} [trxs: ${count}, lib: ${lib}, confirmed: ${confs}]",
          ("p", new_bs->header.producer)
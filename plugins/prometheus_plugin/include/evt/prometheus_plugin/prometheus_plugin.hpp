@@ -0,0 +1,39 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <appbase/application.hpp>
+#include <evt/chain_plugin/chain_plugin.hpp>
+#include <evt/http_plugin/http_plugin.hpp>
+
+namespace evt {
+
+using namespace appbase;
+
+/**
+ *  Exposes the counters and histograms of the other plugins in the text format of prometheus.
+ *  Metrics are only collected when the endpoint is scraped, from the counters the plugins already keep,
+ *  so there is nothing added to the hot paths.
+ */
+class prometheus_plugin : public plugin<prometheus_plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(http_plugin))
+
+    prometheus_plugin();
+    virtual ~prometheus_plugin();
+
+    virtual void set_program_options(options_description& cli, options_description& cfg) override;
+
+    void plugin_initialize(const variables_map& options);
+    void plugin_startup();
+    void plugin_shutdown();
+
+    // metrics in the text exposition format
+    std::string collect() const;
+
+private:
+    std::unique_ptr<class prometheus_plugin_impl> my_;
+};
+
+}  // namespace evt
@@ -0,0 +1,345 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/prometheus_plugin/prometheus_plugin.hpp>
+
+#include <sstream>
+
+#include <evt/chain/app_lanes.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/perf_stats.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+#include <evt/net_plugin/net_plugin.hpp>
+#include <evt/producer_plugin/producer_plugin.hpp>
+#ifdef MONGODB_SUPPORT
+#include <evt/mongo_db_plugin/mongo_db_plugin.hpp>
+#endif
+#ifdef POSTGRES_SUPPORT
+#include <evt/postgres_plugin/postgres_plugin.hpp>
+#endif
+
+namespace evt {
+
+static appbase::abstract_plugin& _prometheus_plugin = app().register_plugin<prometheus_plugin>();
+
+using namespace evt::chain;
+
+namespace internal {
+
+using histogram = token_database_metrics::histogram;
+
+// writes metrics in the text exposition format, all the names are prefixed by `evt_`
+class metrics_writer {
+public:
+    void
+    type(const char* name, const char* type) {
+        out_ << "# TYPE evt_" << name << " " << type << "\n";
+    }
+
+    template<typename T>
+    void
+    sample(const char* name, const std::string& labels, T value) {
+        out_ << "evt_" << name;
+        if(!labels.empty()) {
+            out_ << "{" << labels << "}";
+        }
+        out_ << " " << value << "\n";
+    }
+
+    template<typename T>
+    void
+    gauge(const char* name, T value) {
+        type(name, "gauge");
+        sample(name, "", value);
+    }
+
+    template<typename T>
+    void
+    counter(const char* name, T value) {
+        type(name, "counter");
+        sample(name, "", value);
+    }
+
+    // buckets of power-of-two microseconds are converted into cumulative ones in seconds
+    void
+    histogram_samples(const char* name, const std::string& labels, const histogram& h) {
+        auto prefix = labels.empty() ? std::string() : labels + ",";
+        auto bucket = std::string(name) + "_bucket";
+        auto total  = uint64_t(0);
+        for(auto i = 0; i < histogram::kBucketsNum - 1; i++) {
+            total += h.buckets[i];
+            out_ << "evt_" << bucket << "{" << prefix << "le=\"" << (double)(1ul << i) / 1'000'000 << "\"} " << total << "\n";
+        }
+        out_ << "evt_" << bucket << "{" << prefix << "le=\"+Inf\"} " << h.count << "\n";
+        sample((std::string(name) + "_sum").c_str(), labels, (double)h.sum_us / 1'000'000);
+        sample((std::string(name) + "_count").c_str(), labels, h.count);
+    }
+
+    std::string str() const { return out_.str(); }
+
+private:
+    std::ostringstream out_;
+};
+
+std::string
+label(const char* key, const std::string& value) {
+    return std::string(key) + "=\"" + value + "\"";
+}
+
+void
+write_chain(metrics_writer& w, controller& chain) {
+    w.gauge("head_block_num", chain.head_block_num());
+    w.gauge("last_irreversible_block_num", chain.last_irreversible_block_num());
+    w.gauge("fork_db_head_block_num", chain.fork_db_head_block_num());
+    w.gauge("unapplied_transactions", chain.get_unapplied_transactions().size());
+
+    auto& perf = chain.get_perf_stats();
+    w.counter("controller_blocks_total", perf.blocks());
+    w.type("controller_phase_seconds", "histogram");
+    for(auto i = 0; i < perf_stats::kPhasesNum; i++) {
+        auto phase = (perf_phase)i;
+        w.histogram_samples("controller_phase_seconds", label("phase", perf_stats::phase_name(phase)), perf.phase(phase));
+    }
+}
+
+void
+write_token_db(metrics_writer& w, controller& chain) {
+    auto& tokendb = chain.token_db();
+
+    w.type("tokendb_property", "gauge");
+    for(auto& it : tokendb.int_stats()) {
+        w.sample("tokendb_property", label("name", it.first), it.second);
+    }
+
+    auto metrics = tokendb.metrics();
+    if(metrics == nullptr) {
+        return;
+    }
+
+    // types without any accesses are omitted
+    auto types = std::vector<std::pair<std::string, const token_database_metrics::counters*>>();
+    for(auto i = 0; i <= (int)token_type::max_value; i++) {
+        auto& c = metrics->of_type((token_type)i);
+        if(c.reads + c.writes + c.range_scans + c.cache_hits + c.cache_misses > 0) {
+            types.emplace_back(label("type", token_database_metrics::type_name((token_type)i)), &c);
+        }
+    }
+
+#define EVT_TOKENDB_COUNTER(field)                                      \
+    w.type("tokendb_" #field "_total", "counter");                      \
+    for(auto& t : types) {                                              \
+        w.sample("tokendb_" #field "_total", t.first, t.second->field); \
+    }
+
+    EVT_TOKENDB_COUNTER(reads);
+    EVT_TOKENDB_COUNTER(read_misses);
+    EVT_TOKENDB_COUNTER(read_bytes);
+    EVT_TOKENDB_COUNTER(writes);
+    EVT_TOKENDB_COUNTER(write_bytes);
+    EVT_TOKENDB_COUNTER(range_scans);
+    EVT_TOKENDB_COUNTER(range_rows);
+    EVT_TOKENDB_COUNTER(cache_hits);
+    EVT_TOKENDB_COUNTER(cache_misses);
+
+#undef EVT_TOKENDB_COUNTER
+
+    const char* op_names[] = { "read", "write", "range" };
+    w.type("tokendb_latency_seconds", "histogram");
+    for(auto& t : types) {
+        for(auto i = 0; i <= (int)token_database_metrics::op_type::max_value; i++) {
+            w.histogram_samples("tokendb_latency_seconds", t.first + "," + label("op", op_names[i]), t.second->latencies[i]);
+        }
+    }
+}
+
+void
+write_producer(metrics_writer& w, const producer_plugin& producer) {
+    auto m = producer.get_metrics();
+    w.counter("producer_trxs_received_total", m.trxs_received);
+    w.counter("producer_trxs_rejected_total", m.trxs_rejected);
+    w.counter("producer_trxs_retried_total", m.trxs_retried);
+    w.counter("producer_trxs_failed_total", m.trxs_failed);
+    w.counter("producer_blocks_produced_total", m.blocks_produced);
+    w.gauge("producer_pending_trxs", m.pending_trxs);
+    w.gauge("producer_persistent_trxs", m.persistent_trxs);
+}
+
+void
+write_net(metrics_writer& w, const net_plugin& net) {
+    auto stats = net.stats();
+
+    auto connected = 0u;
+    for(auto& s : stats) {
+        connected += s.connected;
+    }
+    w.gauge("net_connections", stats.size());
+    w.gauge("net_connected_peers", connected);
+
+    w.type("net_bytes_in_total", "counter");
+    for(auto& s : stats) {
+        w.sample("net_bytes_in_total", label("peer", s.peer), s.bytes_in);
+    }
+    w.type("net_bytes_out_total", "counter");
+    for(auto& s : stats) {
+        w.sample("net_bytes_out_total", label("peer", s.peer), s.bytes_out);
+    }
+    w.type("net_messages_in_total", "counter");
+    for(auto& s : stats) {
+        for(auto& it : s.messages_in) {
+            w.sample("net_messages_in_total", label("peer", s.peer) + "," + label("type", it.first), it.second);
+        }
+    }
+    w.type("net_messages_out_total", "counter");
+    for(auto& s : stats) {
+        for(auto& it : s.messages_out) {
+            w.sample("net_messages_out_total", label("peer", s.peer) + "," + label("type", it.first), it.second);
+        }
+    }
+    w.type("net_write_queue_bytes", "gauge");
+    for(auto& s : stats) {
+        w.sample("net_write_queue_bytes", label("peer", s.peer), s.write_queue_size);
+    }
+}
+
+void
+write_http(metrics_writer& w, const http_plugin& http) {
+    auto m = http.get_metrics();
+    w.counter("http_requests_total", m.requests);
+    w.counter("http_busy_total", m.busy);
+    w.gauge("http_bytes_in_flight", m.bytes_in_flight);
+
+    w.type("http_responses_total", "counter");
+    for(auto i = 1u; i < m.responses.size(); i++) {
+        w.sample("http_responses_total", label("code", std::to_string(i) + "xx"), m.responses[i]);
+    }
+}
+
+void
+write_lanes(metrics_writer& w) {
+    using namespace evt::chain::plugin_interface;
+
+    w.type("app_lane_posted_total", "counter");
+    for(auto i = 0; i < kAppLanesNum; i++) {
+        w.sample("app_lane_posted_total", label("lane", lane_name((app_lane)i)), lane_stats((app_lane)i).posted.load());
+    }
+    w.type("app_lane_depth", "gauge");
+    for(auto i = 0; i < kAppLanesNum; i++) {
+        w.sample("app_lane_depth", label("lane", lane_name((app_lane)i)), lane_stats((app_lane)i).depth());
+    }
+    w.type("app_lane_wait_seconds", "histogram");
+    for(auto i = 0; i < kAppLanesNum; i++) {
+        w.histogram_samples("app_lane_wait_seconds", label("lane", lane_name((app_lane)i)), lane_stats((app_lane)i).wait);
+    }
+}
+
+template<typename Metrics>
+void
+write_queue(metrics_writer& w, const char* name, const Metrics& m) {
+    // drain rate is `rate(evt_queue_processed_blocks_total[1m])`
+    auto l = label("queue", name);
+    w.sample("queue_queued_blocks_total", l, m.queued_blocks);
+    w.sample("queue_processed_blocks_total", l, m.processed_blocks);
+    w.sample("queue_waiting_blocks", l, m.queued_blocks - m.processed_blocks);
+    w.sample("queue_size", l, m.queue_size);
+}
+
+template<typename Plugin>
+const Plugin*
+started_plugin() {
+    auto p = app().find_plugin<Plugin>();
+    if(p == nullptr || p->get_state() != abstract_plugin::started) {
+        return nullptr;
+    }
+    return p;
+}
+
+}  // namespace internal
+
+class prometheus_plugin_impl {
+public:
+    std::string collect() const;
+
+public:
+    std::string url;
+};
+
+std::string
+prometheus_plugin_impl::collect() const {
+    using namespace internal;
+
+    auto  w     = metrics_writer();
+    auto& chain = app().get_plugin<chain_plugin>().chain();
+
+    write_chain(w, chain);
+    write_token_db(w, chain);
+    write_lanes(w);
+    write_http(w, app().get_plugin<http_plugin>());
+
+    if(auto producer = started_plugin<producer_plugin>()) {
+        write_producer(w, *producer);
+    }
+    if(auto net = started_plugin<net_plugin>()) {
+        write_net(w, *net);
+    }
+
+    w.type("queue_queued_blocks_total", "counter");
+    w.type("queue_processed_blocks_total", "counter");
+    w.type("queue_waiting_blocks", "gauge");
+    w.type("queue_size", "gauge");
+#ifdef MONGODB_SUPPORT
+    if(auto mongo = started_plugin<mongo_db_plugin>(); mongo && mongo->enabled()) {
+        write_queue(w, "mongodb", mongo->get_queue_metrics());
+    }
+#endif
+#ifdef POSTGRES_SUPPORT
+    if(auto pg = started_plugin<postgres_plugin>(); pg && pg->enabled()) {
+        write_queue(w, "postgres", pg->get_queue_metrics());
+    }
+#endif
+
+    return w.str();
+}
+
+prometheus_plugin::prometheus_plugin() {}
+prometheus_plugin::~prometheus_plugin() {}
+
+void
+prometheus_plugin::set_program_options(options_description&, options_description& cfg) {
+    cfg.add_options()
+        ("prometheus-url", bpo::value<std::string>()->default_value("/metrics"), "Url of the endpoint prometheus scrapes metrics from")
+    ;
+}
+
+void
+prometheus_plugin::plugin_initialize(const variables_map& options) {
+    my_ = std::make_unique<prometheus_plugin_impl>();
+
+    my_->url = options.at("prometheus-url").as<std::string>();
+    EVT_ASSERT(!my_->url.empty() && my_->url[0] == '/', plugin_config_exception, "Not valid prometheus url: ${u}", ("u", my_->url));
+}
+
+void
+prometheus_plugin::plugin_startup() {
+    // most of the counters are only updated on main thread, so it's not a concurrent handler
+    app().get_plugin<http_plugin>().add_text_handler(my_->url, [this](string, string, url_response_callback cb) {
+        try {
+            cb(200, my_->collect());
+        }
+        catch(...) {
+            http_plugin::handle_exception("prometheus", "metrics", "", cb);
+        }
+    });
+}
+
+void
+prometheus_plugin::plugin_shutdown() {}
+
+std::string
+prometheus_plugin::collect() const {
+    return my_->collect();
+}
+
+}  // namespace evt
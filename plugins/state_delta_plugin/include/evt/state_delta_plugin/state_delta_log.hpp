@@ -0,0 +1,55 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <fstream>
+#include <optional>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <evt/chain/types.hpp>
+#include <evt/chain/token_database.hpp>
+
+namespace evt {
+
+struct state_delta_entry {
+    uint32_t                        block_num;
+    chain::block_id_type            block_id;
+    std::vector<chain::token_delta> deltas;
+};
+
+/**
+ *  Append-only log of state deltas, blocks in it are contiguous.
+ *  `deltas.log` has the packed entries and `deltas.index` has the offset of each one in uint64.
+ *  Entry is written into log before index, so one partially written is truncated when it's opened.
+ */
+class state_delta_log {
+public:
+    state_delta_log(const boost::filesystem::path& dir);
+    ~state_delta_log();
+
+public:
+    void append(const state_delta_entry& entry);
+    std::optional<state_delta_entry> read(uint32_t block_num);
+
+    bool     empty() const { return count_ == 0; }
+    uint32_t first_block() const { return first_; }
+    uint32_t last_block() const { return first_ + count_ - 1; }
+
+private:
+    void recover();
+    uint64_t read_offset(uint32_t i);
+
+private:
+    boost::filesystem::path log_path_;
+    boost::filesystem::path index_path_;
+    std::fstream            log_;
+    std::fstream            index_;
+
+    uint32_t first_ = 0;
+    uint32_t count_ = 0;
+};
+
+}  // namespace evt
+
+FC_REFLECT(evt::state_delta_entry, (block_num)(block_id)(deltas));
@@ -0,0 +1,42 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#pragma once
+#include <evt/http_plugin/http_plugin.hpp>
+#include <evt/chain_plugin/chain_plugin.hpp>
+
+#include <appbase/application.hpp>
+#include <evt/chain/controller.hpp>
+
+namespace evt {
+using evt::chain::controller;
+using namespace appbase;
+
+/**
+ *  Records the rows of token database changed by each irreversible block into an append-only log,
+ *  consumers apply them directly instead of interpreting the actions again.
+ *  Deltas are served by `/v1/state_delta/get_deltas` and streamed by websocket `/v1/state_delta/stream`.
+ */
+class state_delta_plugin : public plugin<state_delta_plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES((chain_plugin)(http_plugin))
+
+    state_delta_plugin();
+    virtual ~state_delta_plugin();
+
+    virtual void set_program_options(options_description&, options_description&) override;
+
+    void plugin_initialize(const variables_map&);
+    void plugin_startup();
+    void plugin_shutdown();
+
+    // rows changed after block `base_id` till head with their latest values, used by incremental snapshots
+    // base block should be in log or still reversible
+    std::vector<chain::token_delta> deltas_since(const chain::block_id_type& base_id);
+
+private:
+    std::shared_ptr<class state_delta_plugin_impl> my_;
+};
+
+}  // namespace evt
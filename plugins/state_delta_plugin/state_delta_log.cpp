@@ -0,0 +1,128 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/state_delta_plugin/state_delta_log.hpp>
+
+#include <fc/io/raw.hpp>
+#include <evt/chain/exceptions.hpp>
+
+#define LOG_RW (std::ios::in | std::ios::out | std::ios::binary)
+
+namespace evt {
+
+namespace bfs = boost::filesystem;
+
+namespace internal {
+
+void
+open_stream(std::fstream& fs, const bfs::path& path) {
+    if(!bfs::exists(path)) {
+        std::ofstream(path.generic_string(), std::ios::out | std::ios::binary);
+    }
+    fs.exceptions(std::fstream::failbit | std::fstream::badbit);
+    fs.open(path.generic_string(), LOG_RW);
+}
+
+}  // namespace internal
+
+state_delta_log::state_delta_log(const bfs::path& dir)
+    : log_path_(dir / "deltas.log")
+    , index_path_(dir / "deltas.index") {
+    if(!bfs::exists(dir)) {
+        bfs::create_directories(dir);
+    }
+    internal::open_stream(log_, log_path_);
+    internal::open_stream(index_, index_path_);
+    recover();
+}
+
+state_delta_log::~state_delta_log() {}
+
+uint64_t
+state_delta_log::read_offset(uint32_t i) {
+    auto offset = uint64_t();
+    index_.seekg((uint64_t)i * sizeof(offset));
+    index_.read((char*)&offset, sizeof(offset));
+    return offset;
+}
+
+void
+state_delta_log::recover() {
+    // drops the entries not completely written in last run
+    auto log_size = bfs::file_size(log_path_);
+    auto n        = (uint32_t)(bfs::file_size(index_path_) / sizeof(uint64_t));
+    auto end      = uint64_t(0);
+    while(n > 0) {
+        auto offset = read_offset(n - 1);
+        auto size   = uint32_t(0);
+        if(offset + sizeof(size) <= log_size) {
+            log_.seekg(offset);
+            log_.read((char*)&size, sizeof(size));
+            if(offset + sizeof(size) + size <= log_size) {
+                end = offset + sizeof(size) + size;
+                break;
+            }
+        }
+        n--;
+    }
+
+    if(end != log_size || n * sizeof(uint64_t) != bfs::file_size(index_path_)) {
+        wlog("Truncate state delta log to ${n} blocks", ("n", n));
+        log_.close();
+        index_.close();
+        bfs::resize_file(log_path_, end);
+        bfs::resize_file(index_path_, n * sizeof(uint64_t));
+        internal::open_stream(log_, log_path_);
+        internal::open_stream(index_, index_path_);
+    }
+
+    count_ = n;
+    if(count_ > 0) {
+        EVT_ASSERT(read_offset(0) == 0, chain::state_delta_log_exception, "First entry of state delta log should be at offset 0");
+        // block num is the first field of entry
+        log_.seekg(sizeof(uint32_t));
+        log_.read((char*)&first_, sizeof(first_));
+    }
+}
+
+void
+state_delta_log::append(const state_delta_entry& entry) {
+    EVT_ASSERT(empty() || entry.block_num == last_block() + 1, chain::state_delta_log_exception,
+        "Block ${n} is not next to the last one in state delta log: ${l}", ("n", entry.block_num)("l", last_block()));
+
+    auto data = fc::raw::pack(entry);
+    auto size = (uint32_t)data.size();
+
+    log_.seekp(0, std::ios::end);
+    auto offset = (uint64_t)log_.tellp();
+    log_.write((char*)&size, sizeof(size));
+    log_.write(data.data(), data.size());
+    log_.flush();
+
+    index_.seekp(0, std::ios::end);
+    index_.write((char*)&offset, sizeof(offset));
+    index_.flush();
+
+    if(empty()) {
+        first_ = entry.block_num;
+    }
+    count_++;
+}
+
+std::optional<state_delta_entry>
+state_delta_log::read(uint32_t block_num) {
+    if(empty() || block_num < first_block() || block_num > last_block()) {
+        return std::nullopt;
+    }
+
+    auto size = uint32_t(0);
+    log_.seekg(read_offset(block_num - first_));
+    log_.read((char*)&size, sizeof(size));
+
+    auto data = std::vector<char>(size);
+    log_.read(data.data(), size);
+    return fc::raw::unpack<state_delta_entry>(data);
+}
+
+}  // namespace evt
@@ -0,0 +1,392 @@
+/**
+ *  @file
+ *  @copyright defined in evt/LICENSE.txt
+ */
+#include <evt/state_delta_plugin/state_delta_plugin.hpp>
+#include <evt/state_delta_plugin/state_delta_log.hpp>
+
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/crypto/hex.hpp>
+
+#include <evt/chain/exceptions.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+
+namespace evt { namespace internal {
+
+// deltas of reversible block, captured when it's accepted
+struct pending_block {
+    chain::block_id_type            block_id;
+    std::vector<chain::token_delta> deltas;
+};
+
+}}  // namespace evt::internal
+
+FC_REFLECT(evt::internal::pending_block, (block_id)(deltas));
+
+namespace evt {
+
+static appbase::abstract_plugin& _state_delta_plugin = app().register_plugin<state_delta_plugin>();
+
+namespace bfs = boost::filesystem;
+
+using evt::chain::block_state_ptr;
+using evt::chain::block_id_type;
+using evt::chain::token_delta;
+
+class state_delta_plugin_impl : public std::enable_shared_from_this<state_delta_plugin_impl> {
+public:
+    using pending_block = internal::pending_block;
+
+public:
+    state_delta_plugin_impl(controller& db, const bfs::path& dir)
+        : db_(db)
+        , dir_(dir)
+        , log_(dir) {}
+
+public:
+    void init();
+    void close();
+
+    fc::variant get_deltas(uint32_t block_num);
+    std::vector<token_delta> deltas_since(const block_id_type& base_id);
+
+    void on_websocket_message(websocket_id id, const std::string& message);
+    void on_websocket_close(websocket_id id);
+
+private:
+    void accepted_block(const block_state_ptr& bs);
+    void irreversible_block(const block_state_ptr& bs);
+
+    void load_pending();
+    void save_pending();
+    void stream(websocket_id id);
+
+    fc::variant entry_to_variant(const state_delta_entry& entry);
+
+public:
+    controller&     db_;
+    bfs::path       dir_;
+    state_delta_log log_;
+    uint32_t        batch_;
+
+    std::map<uint32_t, pending_block> pending_;
+
+    // next block to send of each subscriber, the ones behind the log are caught up in batches
+    std::unordered_map<websocket_id, uint32_t> subs_;
+
+    std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
+    std::optional<boost::signals2::scoped_connection> irreversible_block_connection_;
+};
+
+void
+state_delta_plugin_impl::accepted_block(const block_state_ptr& bs) {
+    // savepoint of block is still the latest one when it's accepted
+    auto& tokendb = db_.token_db();
+    if(tokendb.savepoints_size() == 0 || tokendb.latest_savepoint_seq() != bs->block_num) {
+        wlog("No savepoint of block ${n} in token database, its deltas are not recorded", ("n", bs->block_num));
+        return;
+    }
+
+    // blocks of the old branch are replaced after switching forks
+    pending_.erase(pending_.lower_bound(bs->block_num), pending_.end());
+    pending_.emplace(bs->block_num, pending_block { bs->id, tokendb.latest_savepoint_deltas() });
+}
+
+void
+state_delta_plugin_impl::irreversible_block(const block_state_ptr& bs) {
+    auto it = pending_.find(bs->block_num);
+    if(it == pending_.end() || it->second.block_id != bs->id) {
+        if(log_.empty() || bs->block_num > log_.last_block()) {
+            elog("Deltas of irreversible block ${n} are missing, state delta log stops at block ${l}",
+                ("n", bs->block_num)("l", log_.empty() ? 0 : log_.last_block()));
+        }
+        return;
+    }
+
+    if(log_.empty() || bs->block_num == log_.last_block() + 1) {
+        auto entry = state_delta_entry { bs->block_num, bs->id, std::move(it->second.deltas) };
+        log_.append(entry);
+
+        // pushes to the subscribers which are caught up already
+        auto json = std::string();
+        for(auto& sub : subs_) {
+            if(sub.second != bs->block_num) {
+                continue;
+            }
+            if(json.empty()) {
+                json = fc::json::to_string(entry_to_variant(entry));
+            }
+            app().get_plugin<http_plugin>().send_websocket_message(sub.first, json);
+            sub.second++;
+        }
+    }
+    else if(bs->block_num > log_.last_block()) {
+        elog("State delta log is not contiguous, block ${n} is after ${l}", ("n", bs->block_num)("l", log_.last_block()));
+    }
+    pending_.erase(pending_.begin(), ++it);
+}
+
+fc::variant
+state_delta_plugin_impl::entry_to_variant(const state_delta_entry& entry) {
+    auto deltas = fc::variants();
+    deltas.reserve(entry.deltas.size());
+    for(auto& d : entry.deltas) {
+        auto vo     = fc::mutable_variant_object();
+        vo["type"]  = chain::token_database_metrics::type_name(d.type);
+        vo["key"]   = fc::to_hex(d.key.data(), d.key.size());
+        vo["value"] = fc::to_hex(d.value.data(), d.value.size());
+        deltas.emplace_back(std::move(vo));
+    }
+
+    auto vo         = fc::mutable_variant_object();
+    vo["block_num"] = entry.block_num;
+    vo["block_id"]  = entry.block_id;
+    vo["deltas"]    = std::move(deltas);
+    return vo;
+}
+
+fc::variant
+state_delta_plugin_impl::get_deltas(uint32_t block_num) {
+    auto entry = log_.read(block_num);
+    EVT_ASSERT(entry.has_value(), chain::state_delta_not_existed_exception, "Deltas of block ${n} are not in log", ("n", block_num));
+    return entry_to_variant(*entry);
+}
+
+std::vector<token_delta>
+state_delta_plugin_impl::deltas_since(const block_id_type& base_id) {
+    auto base_num = chain::block_header::num_from_id(base_id);
+    auto base     = log_.read(base_num);
+    auto it       = pending_.find(base_num);
+    EVT_ASSERT((base.has_value() && base->block_id == base_id) || (it != pending_.end() && it->second.block_id == base_id),
+        chain::state_delta_not_existed_exception, "Base block ${id} is not in state delta log", ("id", base_id));
+
+    // later deltas of the same key replace the former ones
+    auto deltas = std::vector<token_delta>();
+    auto index  = std::unordered_map<std::string, size_t>();
+    auto merge  = [&](const std::vector<token_delta>& ds) {
+        for(auto& d : ds) {
+            auto k = std::string(1, (char)d.type);
+            k.append(d.key);
+
+            auto r = index.emplace(std::move(k), deltas.size());
+            if(r.second) {
+                deltas.emplace_back(d);
+            }
+            else {
+                deltas[r.first->second].value = d.value;
+            }
+        }
+    };
+
+    auto next = base_num + 1;
+    for(; !log_.empty() && next <= log_.last_block(); next++) {
+        merge(log_.read(next)->deltas);
+    }
+    for(auto pit = pending_.upper_bound(base_num); pit != pending_.end(); pit++) {
+        if(pit->first < next) {
+            continue;
+        }
+        EVT_ASSERT(pit->first == next, chain::state_delta_log_exception, "Deltas of block ${n} are missing", ("n", next));
+        merge(pit->second.deltas);
+        next++;
+    }
+    EVT_ASSERT(next == db_.head_block_num() + 1, chain::state_delta_log_exception,
+        "Deltas are only recorded till block ${n}, head is ${h}", ("n", next - 1)("h", db_.head_block_num()));
+    return deltas;
+}
+
+void
+state_delta_plugin_impl::stream(websocket_id id) {
+    auto it = subs_.find(id);
+    if(it == subs_.end()) {
+        return;
+    }
+
+    auto& http = app().get_plugin<http_plugin>();
+    for(auto i = 0u; i < batch_ && !log_.empty() && it->second <= log_.last_block(); i++) {
+        auto entry = log_.read(it->second);
+        http.send_websocket_message(id, fc::json::to_string(entry_to_variant(*entry)));
+        it->second++;
+    }
+
+    if(!log_.empty() && it->second <= log_.last_block()) {
+        // the rest are sent later so that blocks are not blocked by one subscriber far behind
+        auto wptr = std::weak_ptr<state_delta_plugin_impl>(shared_from_this());
+        app().post(priority::low, [wptr, id] {
+            if(auto self = wptr.lock()) {
+                self->stream(id);
+            }
+        });
+    }
+}
+
+void
+state_delta_plugin_impl::on_websocket_message(websocket_id id, const std::string& message) {
+    auto reply = fc::mutable_variant_object();
+    try {
+        auto var = fc::json::from_string(message);
+        auto op  = var["op"].as_string();
+        EVT_ASSERT(op == "subscribe" || op == "unsubscribe", chain::state_delta_plugin_exception,
+            "Unknown op: ${op}, only 'subscribe' and 'unsubscribe' are supported", ("op", op));
+
+        if(op == "subscribe") {
+            auto start = var["start_block"].as<uint32_t>();
+            EVT_ASSERT(!log_.empty() && start >= log_.first_block() && start <= log_.last_block() + 1,
+                chain::state_delta_not_existed_exception, "Start block ${n} is not in state delta log", ("n", start));
+
+            subs_[id]            = start;
+            reply["first_block"] = log_.first_block();
+            reply["last_block"]  = log_.last_block();
+        }
+        else {
+            subs_.erase(id);
+        }
+        reply["type"] = op;
+    }
+    catch(const fc::exception& e) {
+        reply["type"]  = "error";
+        reply["error"] = error_results::error_info(e, app().get_plugin<http_plugin>().verbose_errors());
+    }
+    catch(const std::exception& e) {
+        reply["type"]  = "error";
+        reply["error"] = e.what();
+    }
+    app().get_plugin<http_plugin>().send_websocket_message(id, fc::json::to_string(reply));
+
+    if(reply["type"].as_string() == "subscribe") {
+        stream(id);
+    }
+}
+
+void
+state_delta_plugin_impl::on_websocket_close(websocket_id id) {
+    subs_.erase(id);
+}
+
+void
+state_delta_plugin_impl::load_pending() {
+    // deltas of reversible blocks are saved at shutdown, they cannot be captured again after restart
+    auto path = dir_ / "pending.bin";
+    if(!bfs::exists(path)) {
+        return;
+    }
+
+    try {
+        auto fs   = std::ifstream(path.generic_string(), std::ios::in | std::ios::binary);
+        auto data = std::vector<char>(bfs::file_size(path));
+        fs.read(data.data(), data.size());
+
+        auto blocks = fc::raw::unpack<std::vector<std::pair<uint32_t, pending_block>>>(data);
+        for(auto& b : blocks) {
+            pending_.emplace(b.first, std::move(b.second));
+        }
+    }
+    catch(const fc::exception& e) {
+        elog("Load pending state deltas failed: ${e}", ("e", e.to_detail_string()));
+    }
+    bfs::remove(path);
+}
+
+void
+state_delta_plugin_impl::save_pending() {
+    if(pending_.empty()) {
+        return;
+    }
+    auto blocks = std::vector<std::pair<uint32_t, pending_block>>(pending_.begin(), pending_.end());
+    auto data   = fc::raw::pack(blocks);
+    auto fs     = std::ofstream((dir_ / "pending.bin").generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    fs.write(data.data(), data.size());
+}
+
+void
+state_delta_plugin_impl::init() {
+    load_pending();
+
+    auto& chain = app().get_plugin<chain_plugin>().chain();
+    accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
+        accepted_block(bs);
+    }));
+    irreversible_block_connection_.emplace(chain.irreversible_block.connect([&](const chain::block_state_ptr& bs) {
+        irreversible_block(bs);
+    }));
+}
+
+void
+state_delta_plugin_impl::close() {
+    accepted_block_connection_.reset();
+    irreversible_block_connection_.reset();
+    save_pending();
+}
+
+state_delta_plugin::state_delta_plugin() {}
+state_delta_plugin::~state_delta_plugin() {}
+
+void
+state_delta_plugin::set_program_options(options_description&, options_description& cfg) {
+    cfg.add_options()
+        ("state-delta-dir", bpo::value<bfs::path>()->default_value("state-deltas"), "The location of the state delta log (absolute path or relative to application data dir)")
+        ("state-delta-stream-batch", bpo::value<uint32_t>()->default_value(100), "Max number of blocks sent to one websocket subscriber at a time when it's catching up.")
+    ;
+}
+
+void
+state_delta_plugin::plugin_initialize(const variables_map& options) {
+    auto dir = options.at("state-delta-dir").as<bfs::path>();
+    if(dir.is_relative()) {
+        dir = app().data_dir() / dir;
+    }
+
+    my_ = std::make_shared<state_delta_plugin_impl>(app().get_plugin<chain_plugin>().chain(), dir);
+    my_->batch_ = options.at("state-delta-stream-batch").as<uint32_t>();
+    EVT_ASSERT(my_->batch_ > 0, chain::plugin_config_exception, "state-delta-stream-batch should be greater than 0");
+    my_->init();
+}
+
+void
+state_delta_plugin::plugin_startup() {
+    ilog("starting state_delta_plugin");
+
+    app().get_plugin<http_plugin>().add_handler("/v1/state_delta/get_deltas", [&](auto, auto body, auto cb) {
+        try {
+            auto var = fc::json::from_string(body);
+            cb(200, fc::json::to_string(my_->get_deltas(var["block_num"].as<uint32_t>())));
+        }
+        catch(...) {
+            http_plugin::handle_exception("state_delta", "get_deltas", body, cb);
+        }
+    });
+
+    // consumers subscribe from one block and deltas are pushed in order, including the ones irreversible later
+    auto wh       = websocket_handler();
+    wh.on_message = [&](auto id, auto message) {
+        if(my_) {
+            my_->on_websocket_message(id, message);
+        }
+    };
+    wh.on_close = [&](auto id) {
+        if(my_) {
+            my_->on_websocket_close(id);
+        }
+    };
+    app().get_plugin<http_plugin>().add_websocket_handler("/v1/state_delta/stream", wh);
+}
+
+std::vector<chain::token_delta>
+state_delta_plugin::deltas_since(const chain::block_id_type& base_id) {
+    return my_->deltas_since(base_id);
+}
+
+void
+state_delta_plugin::plugin_shutdown() {
+    my_->close();
+    my_.reset();
+}
+
+}  // namespace evt
@@ -5,7 +5,17 @@
 #include <evt/trafficgen_plugin/trafficgen_plugin.hpp>
 
 #include <signal.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <boost/algorithm/string.hpp>
 #include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <evt/chain/exceptions.hpp>
 #include <evt/chain/transaction.hpp>
@@ -27,39 +37,134 @@ using evt::chain::address;
 using evt::chain::action;
 using evt::chain::block_id_type;
 using evt::chain::block_state_ptr;
+using evt::chain::chain_id_type;
 using evt::chain::packed_transaction_ptr;
 using evt::chain::private_key_type;
+using evt::chain::transaction_id_type;
 using evt::chain::transaction_metadata;
+using boost::asio::steady_timer;
+
+namespace internal {
+
+enum traffic_kind { kTransferft = 0, kEveripay, kIssuetoken, kNewsuspend, kTransfer, kKindsNum };
+
+const char* kKindNames[] = { "transferft", "everipay", "issuetoken", "newsuspend", "transfer" };
+
+enum {
+    kTrxsPerTask  = 256,
+    kTickMs       = 10,
+    kReportBlocks = 10,
+    kMaxNftTokens = 200'000
+};
+
+// parses mix like 'transferft:70,everipay:10', kinds not listed have zero weight
+std::array<uint32_t, kKindsNum>
+parse_mix(const std::string& str) {
+    auto mix   = std::array<uint32_t, kKindsNum>{};
+    auto parts = std::vector<std::string>();
+    boost::split(parts, str, boost::is_any_of(","));
+    for(auto& p : parts) {
+        auto kv = std::vector<std::string>();
+        boost::split(kv, p, boost::is_any_of(":"));
+        EVT_ASSERT(kv.size() <= 2, chain::plugin_config_exception, "Not valid item: '${p}' in --traffic-mix option", ("p",p));
+
+        auto name = boost::trim_copy(kv[0]);
+        auto it   = std::find(std::begin(kKindNames), std::end(kKindNames), name);
+        EVT_ASSERT(it != std::end(kKindNames), chain::plugin_config_exception, "Not valid action type: '${n}' in --traffic-mix option", ("n",name));
+
+        auto weight = 1u;
+        if(kv.size() == 2) {
+            try {
+                weight = std::stoul(kv[1]);
+            }
+            catch(...) {
+                EVT_THROW(chain::plugin_config_exception, "Not valid weight: '${w}' in --traffic-mix option", ("w",kv[1]));
+            }
+        }
+        mix[it - std::begin(kKindNames)] = weight;
+    }
+    return mix;
+}
+
+}  // namespace internal
 
 class trafficgen_plugin_impl : public std::enable_shared_from_this<trafficgen_plugin_impl> {
 public:
     trafficgen_plugin_impl(controller& db)
-        : db_(db) {}
+        : db_(db)
+        , timer_(app().get_io_service()) {}
 
 public:
     void init();
+    void stop();
+
+    void set_mix(const std::array<uint32_t, internal::kKindsNum>& mix);
 
 private:
     int  pre_nft_setup(const block_id_type& id);
-    void pre_ft_generate(const block_id_type& id);
-    void pre_nft_generate(const block_id_type& id);
     void applied_block(const block_state_ptr& bs);
-    void push_once(int index);
+    void push_once(const packed_transaction_ptr& ptrx);
     void push_trx(const action& act, const block_id_type& id);
 
+    // generation runs on pool threads, trxs in [begin, end) are appended to ready queue
+    void generate(size_t begin, size_t end, const block_id_type& id);
+    void generate_all(const block_id_type& id);
+    void refill(const block_id_type& id);
+
+    void start_rate();
+    void schedule_tick();
+    void tick();
+
+    void record_block(const block_state_ptr& bs);
+    void report(bool final);
+
+    // kind of trx `seq` and its index among the trxs of the same kind
+    std::pair<int, size_t> kind_of(size_t seq) const;
+
 public:
     controller& db_;
 
     uint32_t start_num_  = 0;
     size_t   total_num_  = 0;
+    uint32_t tps_        = 0;
+    uint32_t threads_    = 4;
+    bool     started_    = false;
     bool     pushed_     = false;
+    bool     setup_      = false;
 
     address          from_addr_;
     private_key_type from_priv_;
+    chain_id_type    chain_id_;
+
+    // weights of kinds, `prefix_` are the cumulative ones
+    std::array<uint32_t, internal::kKindsNum> mix_{};
+    std::array<uint32_t, internal::kKindsNum> prefix_{};
+    uint32_t                                  mix_total_ = 0;
+    // keeps names and link ids of this run unique to the previous ones
+    uint64_t                                  seed_      = 0;
+
+    std::unique_ptr<boost::asio::thread_pool> pool_;
 
-    std::string type_;
+    std::mutex                         ready_mutex_;
+    std::deque<packed_transaction_ptr> ready_;
+    std::atomic<size_t>                gen_failed_ = 0;
 
-    std::vector<packed_transaction_ptr> packed_trxs_;
+    // below are only accessed on app io_service
+    size_t scheduled_ = 0;
+    size_t submitted_ = 0;
+    size_t included_  = 0;
+    size_t failed_    = 0;
+
+    steady_timer             timer_;
+    steady_timer::time_point next_tick_;
+    fc::time_point           start_time_;
+
+    std::unordered_map<transaction_id_type, fc::time_point> inflight_;
+
+    // latencies in ms of the trxs included since last report
+    std::vector<int64_t> latencies_;
+    uint32_t             report_blocks_   = 0;
+    fc::time_point       report_time_;
 
     std::optional<boost::signals2::scoped_connection> accepted_block_connection_;
 };
@@ -69,11 +174,64 @@ trafficgen_plugin_impl::init() {
     auto& chain_plug = app().get_plugin<chain_plugin>();
     auto& chain      = chain_plug.chain();
 
+    chain_id_ = chain.get_chain_id();
+    seed_     = fc::time_point::now().time_since_epoch().count();
+    pool_     = std::make_unique<boost::asio::thread_pool>(threads_);
+
     accepted_block_connection_.emplace(chain.accepted_block.connect([&](const chain::block_state_ptr& bs) {
         applied_block(bs);
     }));
 }
 
+void
+trafficgen_plugin_impl::stop() {
+    accepted_block_connection_.reset();
+    timer_.cancel();
+    if(pool_) {
+        pool_->stop();
+        pool_->join();
+    }
+    if(started_) {
+        report(true);
+    }
+}
+
+void
+trafficgen_plugin_impl::set_mix(const std::array<uint32_t, internal::kKindsNum>& mix) {
+    using namespace internal;
+
+    mix_       = mix;
+    mix_total_ = 0;
+    for(auto i = 0; i < kKindsNum; i++) {
+        prefix_[i] = mix_total_;
+        mix_total_ += mix_[i];
+    }
+    EVT_ASSERT(mix_total_ > 0, chain::plugin_config_exception, "At least one action type should have non-zero weight");
+
+    // nft transfers consume the tokens issued in setup, each can only be transferred once
+    if(mix_[kTransfer] > 0) {
+        auto rem = total_num_ % mix_total_;
+        auto n   = total_num_ / mix_total_ * mix_[kTransfer] + std::min<size_t>(rem > prefix_[kTransfer] ? rem - prefix_[kTransfer] : 0, mix_[kTransfer]);
+        EVT_ASSERT(n <= kMaxNftTokens, chain::plugin_config_exception, "Total number of nft transfers cannot be large than 200'000");
+    }
+}
+
+std::pair<int, size_t>
+trafficgen_plugin_impl::kind_of(size_t seq) const {
+    using namespace internal;
+
+    // kinds are interleaved by their weights, so no shared counters are needed among the threads
+    auto round = seq / mix_total_;
+    auto off   = (uint32_t)(seq % mix_total_);
+    for(int i = kKindsNum - 1; i >= 0; i--) {
+        if(mix_[i] > 0 && off >= prefix_[i]) {
+            return std::make_pair(i, round * mix_[i] + (off - prefix_[i]));
+        }
+    }
+    assert(false);
+    return std::make_pair(0, 0);
+}
+
 void
 trafficgen_plugin_impl::push_trx(const action& act, const block_id_type& id) {
     using namespace evt::chain;
@@ -87,7 +245,7 @@ trafficgen_plugin_impl::push_trx(const action& act, const block_id_type& id) {
     trx.payer = from_addr_;
     trx.max_charge = 10000;
 
-    trx.sign(from_priv_, db_.get_chain_id());
+    trx.sign(from_priv_, chain_id_);
 
     auto ptrx = std::make_shared<packed_transaction>(trx);
     app().get_method<chain::plugin_interface::incoming::methods::transaction_async>()(std::make_shared<transaction_metadata>(ptrx), true, [](const auto& result) -> void {
@@ -162,115 +320,316 @@ trafficgen_plugin_impl::pre_nft_setup(const block_id_type& id) {
 }
 
 void
-trafficgen_plugin_impl::pre_ft_generate(const block_id_type& id) {
+trafficgen_plugin_impl::generate(size_t begin, size_t end, const block_id_type& id) {
     using namespace evt::chain;
     using namespace evt::chain::contracts;
+    using namespace internal;
 
-    ilog("Generating ft ptrxs...");
-
-    packed_trxs_.reserve(total_num_);
-
-    auto tt   = transferft();
-    tt.from   = from_addr_;
-    tt.number = asset(10, evt_sym());
-    tt.memo   = "FROM THE NEW WORLD";
-
-    auto ttact = action(N128(.fungible), N128(1), tt);
+    // receivers are throwaway keys, they can share one batch
+    auto keys = private_key_type::generate_batch(end - begin);
+    auto trxs = std::vector<packed_transaction_ptr>();
+    trxs.reserve(end - begin);
 
     auto now = fc::time_point::now();
-    for(auto i = 0u; i < total_num_; i++) {
-        auto priv = private_key_type::generate();
-        auto pub  = priv.get_public_key();
-
-        tt.to = pub;
-        ttact.set_data(tt);
-
+    auto mk  = [&](auto&& act) {
         auto trx = signed_transaction();
         trx.set_reference_block(id);
-        trx.actions.emplace_back(ttact);
+        trx.actions.emplace_back(std::move(act));
         trx.expiration = now + fc::minutes(10);
         trx.payer = from_addr_;
         trx.max_charge = 10000;
-        trx.sign(from_priv_, db_.get_chain_id());
+        return trx;
+    };
+
+    for(auto i = begin; i < end; i++) {
+        auto& pub = keys[i - begin].second;
+        auto [kind, index] = kind_of(i);
 
-        packed_trxs_.emplace_back(std::make_shared<packed_transaction>(trx));
+        auto trx = signed_transaction();
+        switch(kind) {
+        case kTransferft: {
+            auto tt   = transferft();
+            tt.from   = from_addr_;
+            tt.to     = pub;
+            tt.number = asset(10, evt_sym());
+            tt.memo   = "FROM THE NEW WORLD";
+
+            trx = mk(action(N128(.fungible), N128(1), tt));
+            break;
+        }
+        case kEveripay: {
+            auto link = evt_link();
+            link.set_header(evt_link::version1 | evt_link::everiPay);
+            link.add_segment(evt_link::segment(evt_link::timestamp, now.sec_since_epoch()));
+            link.add_segment(evt_link::segment(evt_link::max_pay, 100));
+            link.add_segment(evt_link::segment(evt_link::symbol_id, evt_sym().id()));
+
+            auto lid = ((link_id_type)seed_ << 64) | i;
+            link.add_segment(evt_link::segment(evt_link::link_id, std::string((char*)&lid, sizeof(lid))));
+            link.sign(from_priv_);
+
+            auto ep   = everipay();
+            ep.link   = std::move(link);
+            ep.payee  = pub;
+            ep.number = asset(10, evt_sym());
+
+            trx = mk(action(N128(.fungible), N128(1), ep));
+            break;
+        }
+        case kIssuetoken: {
+            auto it   = issuetoken();
+            it.domain = "tttesttt";
+            it.owner.emplace_back(pub);
+            it.names.emplace_back(name128::from_number(seed_ + i));
+
+            trx = mk(action(N128(tttesttt), N128(.issue), it));
+            break;
+        }
+        case kNewsuspend: {
+            auto tt   = transferft();
+            tt.from   = from_addr_;
+            tt.to     = pub;
+            tt.number = asset(10, evt_sym());
+            tt.memo   = "FROM THE SUSPENDED WORLD";
+
+            auto ns     = newsuspend();
+            ns.name     = name128::from_number(seed_ + i);
+            ns.proposer = from_addr_.get_public_key();
+            ns.trx      = mk(action(N128(.fungible), N128(1), tt));
+
+            trx = mk(action(N128(.suspend), ns.name, ns));
+            break;
+        }
+        case kTransfer: {
+            auto tt   = transfer();
+            tt.domain = "tttesttt";
+            tt.name   = name128::from_number(index);
+            tt.memo   = "FROM THE NEW WORLD";
+            tt.to.emplace_back(pub);
+
+            trx = mk(action(N128(tttesttt), tt.name, tt));
+            break;
+        }
+        }  // switch
+
+        trx.sign(from_priv_, chain_id_);
+        trxs.emplace_back(std::make_shared<packed_transaction>(trx));
     }
 
-    ilog("Generating ft ptrxs... Done");
+    auto lock = std::lock_guard<std::mutex>(ready_mutex_);
+    std::move(trxs.begin(), trxs.end(), std::back_inserter(ready_));
 }
 
 void
-trafficgen_plugin_impl::pre_nft_generate(const block_id_type& id) {
-    using namespace evt::chain;
-    using namespace evt::chain::contracts;
+trafficgen_plugin_impl::generate_all(const block_id_type& id) {
+    ilog("Generating ${n} ptrxs with ${t} threads...", ("n",total_num_)("t",threads_));
+
+    auto futures = std::vector<std::future<void>>();
+    for(auto i = size_t(0); i < total_num_; i += internal::kTrxsPerTask) {
+        auto end  = std::min(i + internal::kTrxsPerTask, total_num_);
+        auto task = std::packaged_task<void()>([this, i, end, id] { generate(i, end, id); });
+        futures.emplace_back(task.get_future());
+        boost::asio::post(*pool_, std::move(task));
+    }
+    // all the tasks are joined before rethrowing the first error
+    auto ex = std::exception_ptr();
+    for(auto& f : futures) {
+        try {
+            f.get();
+        }
+        catch(...) {
+            if(!ex) {
+                ex = std::current_exception();
+            }
+        }
+    }
+    if(ex) {
+        std::rethrow_exception(ex);
+    }
+    scheduled_ = total_num_;
 
-    ilog("Generating nft ptrxs...");
+    ilog("Generating ptrxs... Done");
+}
 
-    packed_trxs_.reserve(total_num_);
+void
+trafficgen_plugin_impl::refill(const block_id_type& id) {
+    // keeps about two seconds of trxs generated ahead of pushing
+    auto target = std::max<size_t>((size_t)tps_ * 2, internal::kTrxsPerTask);
+    while(scheduled_ < total_num_ && scheduled_ - submitted_ < target) {
+        auto begin = scheduled_;
+        auto end   = std::min(begin + internal::kTrxsPerTask, total_num_);
+        scheduled_ = end;
+
+        auto wptr = std::weak_ptr<trafficgen_plugin_impl>(shared_from_this());
+        boost::asio::post(*pool_, [wptr, begin, end, id] {
+            auto self = wptr.lock();
+            if(!self) {
+                return;
+            }
+            try {
+                self->generate(begin, end, id);
+            }
+            catch(fc::exception& e) {
+                wlog("Generate ptrxs from ${b} to ${e} failed: ${ex}", ("b",begin)("e",end)("ex",e.to_detail_string()));
+                self->gen_failed_ += end - begin;
+            }
+        });
+    }
+}
 
-    auto tt   = transfer();
-    tt.domain = "tttesttt";
-    tt.memo   = "FROM THE NEW WORLD";
+void
+trafficgen_plugin_impl::start_rate() {
+    ilog("Starting traffic of ${n} trxs at ${r} tps with ${t} threads", ("n",total_num_)("r",tps_)("t",threads_));
 
-    auto ttact = action(N128(tttesttt), N128(0), tt);
+    start_time_  = fc::time_point::now();
+    report_time_ = start_time_;
+    next_tick_   = steady_timer::clock_type::now();
+    schedule_tick();
+}
 
-    auto now = fc::time_point::now();
-    for(auto i = 0u; i < total_num_; i++) {
-        auto priv = private_key_type::generate();
-        auto pub  = priv.get_public_key();
+void
+trafficgen_plugin_impl::schedule_tick() {
+    // ticks are scheduled from the last one rather than now to avoid drifting
+    next_tick_ += std::chrono::milliseconds(internal::kTickMs);
+    timer_.expires_at(next_tick_);
+
+    auto wptr = std::weak_ptr<trafficgen_plugin_impl>(shared_from_this());
+    timer_.async_wait([wptr](auto& ec) {
+        auto self = wptr.lock();
+        if(!self || ec == boost::asio::error::operation_aborted) {
+            return;
+        }
+        self->tick();
+    });
+}
 
-        tt.name = name128::from_number(i);
-        tt.to.emplace_back(pub);
-        ttact.set_data(tt);
-        ttact.key = name128::from_number(i);
+void
+trafficgen_plugin_impl::tick() {
+    // open-loop: trxs due by now are pushed regardless of the ones not confirmed yet
+    auto elapsed = (fc::time_point::now() - start_time_).count();
+    auto due     = std::min<size_t>((size_t)(elapsed * tps_ / 1'000'000), total_num_);
+
+    auto ptrxs = std::vector<packed_transaction_ptr>();
+    if(due > submitted_) {
+        auto lock = std::lock_guard<std::mutex>(ready_mutex_);
+        auto n    = std::min(due - submitted_, ready_.size());
+        ptrxs.assign(std::make_move_iterator(ready_.begin()), std::make_move_iterator(ready_.begin() + n));
+        ready_.erase(ready_.begin(), ready_.begin() + n);
+    }
+    for(auto& ptrx : ptrxs) {
+        push_once(ptrx);
+    }
 
-        auto trx = signed_transaction();
-        trx.set_reference_block(id);
-        trx.actions.emplace_back(ttact);
-        trx.expiration = now + fc::minutes(10);
-        trx.payer = from_addr_;
-        trx.max_charge = 10000;
-        trx.sign(from_priv_, db_.get_chain_id());
+    refill(db_.head_block_id());
+    if(submitted_ + gen_failed_ < total_num_) {
+        schedule_tick();
+    }
+}
+
+void
+trafficgen_plugin_impl::record_block(const block_state_ptr& bs) {
+    auto now = fc::time_point::now();
+    for(auto& trx : bs->trxs) {
+        auto it = inflight_.find(trx->id);
+        if(it == inflight_.end()) {
+            continue;
+        }
+        latencies_.emplace_back((now - it->second).count() / 1000);
+        inflight_.erase(it);
+        included_++;
+    }
 
-        packed_trxs_.emplace_back(std::make_shared<packed_transaction>(trx));
+    if(++report_blocks_ >= internal::kReportBlocks) {
+        report(false);
+    }
+}
+
+void
+trafficgen_plugin_impl::report(bool final) {
+    auto now     = fc::time_point::now();
+    auto secs    = std::max((now - report_time_).count() / 1'000'000.0, 1e-3);
+    auto n       = latencies_.size();
+    auto pct     = [&](auto p) { return n == 0 ? 0 : latencies_[std::min(n - 1, n * p / 100)]; };
+
+    std::sort(latencies_.begin(), latencies_.end());
+    auto sum = int64_t(0);
+    for(auto l : latencies_) {
+        sum += l;
     }
 
-    ilog("Generating nft ptrxs... Done");
+    ilog("Traffic${f}: submitted: ${s}, included: ${i}, failed: ${fl}, pending: ${p}, included tps: ${tps}, "
+         "latency(ms) avg: ${a}, p50: ${p50}, p99: ${p99}, max: ${m}",
+         ("f",final ? " (final)" : "")("s",submitted_)("i",included_)("fl",failed_ + gen_failed_)("p",inflight_.size())
+         ("tps",(int64_t)(n / secs))("a",n == 0 ? 0 : sum / (int64_t)n)("p50",pct(50))("p99",pct(99))("m",n == 0 ? 0 : latencies_.back()));
+
+    latencies_.clear();
+    report_blocks_ = 0;
+    report_time_   = now;
 }
 
 void
 trafficgen_plugin_impl::applied_block(const block_state_ptr& bs) {
-    if(bs->block_num >= start_num_) {
-        if(packed_trxs_.empty()) {
-            if(type_ == "ft") {
-                pre_ft_generate(bs->id);
-            }
-            else if(type_ == "nft") {
-                if(pre_nft_setup(bs->id)) {
-                    pre_nft_generate(bs->id);
-                }
+    if(started_) {
+        record_block(bs);
+    }
+    if(bs->block_num < start_num_ || pushed_) {
+        return;
+    }
+
+    using namespace internal;
+    if(!setup_) {
+        if(mix_[kTransfer] > 0 || mix_[kIssuetoken] > 0) {
+            if(!pre_nft_setup(bs->id)) {
+                return;
             }
         }
-        else {
-            auto now = fc::time_point::now();
-            if(!pushed_ && std::abs((db_.head_block_time() - now).to_seconds()) < 1) {
-                const auto& exec = app().get_io_service().get_executor();
-                for(auto i = 0u; i < total_num_; i++) {
-                    boost::asio::post(exec, std::bind(&trafficgen_plugin_impl::push_once, this, (int)i));
-                }
-                pushed_ = true;
-            }
+        setup_ = true;
+        // waits for the setup trxs being included
+        return;
+    }
+
+    auto now = fc::time_point::now();
+    if(std::abs((db_.head_block_time() - now).to_seconds()) >= 1) {
+        return;
+    }
+
+    pushed_  = true;
+    started_ = true;
+    if(tps_ == 0) {
+        // burst: all the trxs are generated ahead and pushed at once
+        generate_all(bs->id);
+
+        start_time_  = now;
+        report_time_ = now;
+
+        auto lock = std::lock_guard<std::mutex>(ready_mutex_);
+        const auto& exec = app().get_io_service().get_executor();
+        for(auto& ptrx : ready_) {
+            boost::asio::post(exec, std::bind(&trafficgen_plugin_impl::push_once, this, ptrx));
         }
+        ready_.clear();
+        return;
     }
+
+    refill(bs->id);
+    start_rate();
 }
 
 void
-trafficgen_plugin_impl::push_once(int index) {
+trafficgen_plugin_impl::push_once(const packed_transaction_ptr& ptrx) {
+    auto id = ptrx->id();
     try {
-        auto ptrx = packed_trxs_[index];
-        app().get_method<chain::plugin_interface::incoming::methods::transaction_async>()(std::make_shared<transaction_metadata>(ptrx), true, [index](const auto& result) -> void {
+        inflight_.emplace(id, fc::time_point::now());
+        submitted_++;
+
+        auto wptr = std::weak_ptr<trafficgen_plugin_impl>(shared_from_this());
+        app().get_method<chain::plugin_interface::incoming::methods::transaction_async>()(std::make_shared<transaction_metadata>(ptrx), true, [wptr, id](const auto& result) -> void {
             if(result.template contains<fc::exception_ptr>()) {
-                wlog("Push failed at index: ${i}, e: ${e}", ("i",index)("e",*result.template get<fc::exception_ptr>()));
+                wlog("Push failed for trx: ${id}, e: ${e}", ("id",id)("e",*result.template get<fc::exception_ptr>()));
+                if(auto self = wptr.lock()) {
+                    self->inflight_.erase(id);
+                    self->failed_++;
+                }
             }
         });
     }
@@ -281,7 +640,9 @@ trafficgen_plugin_impl::push_once(int index) {
         raise(SIGUSR1);
     }
     catch(...) {
-        wlog("Push failed at index: ${i}", ("i",index));
+        wlog("Push failed for trx: ${id}", ("id",id));
+        inflight_.erase(id);
+        failed_++;
     }
 }
 
@@ -292,28 +653,48 @@ trafficgen_plugin::set_program_options(options_description&, options_description
         ("traffic-total", bpo::value<size_t>()->default_value(0), "Total transactions to be generated")
         ("traffic-from", bpo::value<std::string>(), "Address of sender when generating")
         ("traffic-from-priv", bpo::value<std::string>(), "Private key of sender when generating")
-        ("traffic-type", bpo::value<std::string>()->default_value("ft"), "Type of transactions, can be 'nft' or 'ft'")
+        ("traffic-type", bpo::value<std::string>()->default_value("ft"), "Type of transactions, can be 'nft', 'ft' or 'mix'")
+        ("traffic-mix", bpo::value<std::string>()->default_value("transferft:70,everipay:10,issuetoken:10,newsuspend:10"),
+            "Weights of action types when --traffic-type is 'mix', types can be 'transferft', 'everipay', 'issuetoken', 'newsuspend' and 'transfer'")
+        ("traffic-tps", bpo::value<uint32_t>()->default_value(0), "Target rate of pushing transactions, 0 means pushing all of them at once")
+        ("traffic-threads", bpo::value<uint32_t>()->default_value(4), "Number of threads for generating and signing transactions")
     ;
 }
 
 void
 trafficgen_plugin::plugin_initialize(const variables_map& options) {
+    using namespace internal;
+
     my_ = std::make_shared<trafficgen_plugin_impl>(app().get_plugin<chain_plugin>().chain());
     my_->start_num_ = options.at("traffic-start-num").as<uint32_t>();
     my_->total_num_ = options.at("traffic-total").as<size_t>();
+    my_->tps_       = options.at("traffic-tps").as<uint32_t>();
+    my_->threads_   = options.at("traffic-threads").as<uint32_t>();
 
-    EVT_ASSERT(my_->total_num_ <= 200'000, chain::plugin_config_exception, "Total number of generating transactions cannot be large than 200'000");
+    // only burst mode holds all the trxs in memory
+    EVT_ASSERT(my_->tps_ > 0 || my_->total_num_ <= 200'000, chain::plugin_config_exception, "Total number of generating transactions cannot be large than 200'000");
+    EVT_ASSERT(my_->threads_ > 0 && my_->threads_ <= 64, chain::plugin_config_exception, "--traffic-threads should be in range [1, 64]");
+
+    auto type = options.at("traffic-type").as<std::string>();
+    auto mix  = std::array<uint32_t, kKindsNum>{};
+    if(type == "ft") {
+        mix[kTransferft] = 1;
+    }
+    else if(type == "nft") {
+        mix[kTransfer] = 1;
+    }
+    else if(type == "mix") {
+        mix = parse_mix(options.at("traffic-mix").as<std::string>());
+    }
+    else {
+        EVT_THROW(chain::plugin_config_exception, "Not valid value for --traffic-type option");
+    }
+    my_->set_mix(mix);
 
     if(options.count("traffic-from") && options.count("traffic-from-priv")) {
         my_->from_addr_ = address(options.at("traffic-from").as<std::string>());
         my_->from_priv_ = private_key_type(options.at("traffic-from-priv").as<std::string>());
-        my_->init(); 
-    }
-
-    if(options.count("traffic-type")) {
-        auto type = options.at("traffic-type").as<std::string>();
-        EVT_ASSERT(type == "ft" || type == "nft", chain::plugin_config_exception, "Not valid value for --traffic-type option");
-        my_->type_ = type;
+        my_->init();
     }
 }
 
@@ -324,7 +705,7 @@ trafficgen_plugin::plugin_startup() {
 
 void
 trafficgen_plugin::plugin_shutdown() {
-    my_->accepted_block_connection_.reset();
+    my_->stop();
     my_.reset();
 }
 
@@ -181,6 +181,10 @@ public:
       */
     std::optional<signature_type> try_sign_digest(const digest_type digest, const public_key_type public_key) override;
 
+    /* Keys are decrypted when the wallet is unlocked, signing only reads them
+      */
+    bool can_sign_concurrently() const override { return true; }
+
     std::shared_ptr<detail::soft_wallet_impl> my;
     void                                      encrypt_keys();
 };
@@ -3,6 +3,9 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 #pragma once
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include <evt/chain/transaction.hpp>
 #include <evt/chain/types.hpp>
@@ -101,6 +104,27 @@ public:
     /** Returns a signature given the digest and public_key, if this wallet can sign via that public key
        */
     virtual std::optional<signature_type> try_sign_digest(const digest_type digest, const public_key_type public_key) = 0;
+
+    /** Returns true if \c try_sign_digest can be called from several threads at the same time
+       *
+       * Wallets backed by devices sign one digest at a time, they are only used by one thread.
+       */
+    virtual bool can_sign_concurrently() const { return false; }
+
+    /** Returns the signatures of a batch of digests given with their public keys, in the same order
+       *
+       * Signatures are empty for the keys this wallet doesn't have. Wallets backed by devices override it
+       * to spread the digests over several sessions of device.
+       */
+    virtual std::vector<std::optional<signature_type>>
+    try_sign_digests(const std::vector<std::pair<digest_type, public_key_type>>& digests) {
+        auto sigs = std::vector<std::optional<signature_type>>();
+        sigs.reserve(digests.size());
+        for(auto& d : digests) {
+            sigs.emplace_back(try_sign_digest(d.first, d.second));
+        }
+        return sigs;
+    }
 };
 
 }}  // namespace evt::wallet
\ No newline at end of file
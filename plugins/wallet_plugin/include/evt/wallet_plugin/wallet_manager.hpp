@@ -4,9 +4,11 @@
  */
 #pragma once
 #include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <chrono>
+#include <unordered_map>
 #include <evt/chain/transaction.hpp>
 #include <evt/wallet_plugin/wallet_api.hpp>
 
@@ -66,6 +68,30 @@ public:
     /// @throws fc::exception if corresponding private keys not found in unlocked wallets
     chain::signature_type sign_digest(const chain::digest_type& digest, const public_key_type& key);
 
+    /// Sign a batch of digests, each one with its own public key.
+    /// Digests of the same wallet are passed to it in one batch, so wallets backed by devices can sign them
+    /// with several sessions, and they're split over the signing threads for the wallets which can sign concurrently.
+    /// @param digests the digests to sign.
+    /// @param keys the public keys to sign each digest with, in the same order as digests
+    /// @return signatures over the digests, in the same order
+    /// @throws fc::exception if corresponding private keys not found in unlocked wallets
+    std::vector<chain::signature_type> sign_digests(const std::vector<chain::digest_type>& digests, const std::vector<public_key_type>& keys);
+
+    /// Sign a batch of transactions, each one with its own public keys.
+    /// Keys are looked up in the unlocked wallets once for the whole batch and transactions are signed
+    /// by the signing threads when all the wallets used can sign concurrently.
+    /// @param txns the transactions to sign.
+    /// @param keys the public keys to sign each transaction with, in the same order as txns
+    /// @param id the chain_id to sign transactions with.
+    /// @return txns signed, in the same order
+    /// @throws fc::exception if corresponding private keys not found in unlocked wallets
+    std::vector<chain::signed_transaction> sign_transactions(const std::vector<chain::signed_transaction>& txns,
+                                                             const std::vector<flat_set<public_key_type>>& keys,
+                                                             const chain::chain_id_type& id);
+
+    /// Set the number of threads signing batches of transactions, 0 signs them on the calling thread.
+    void set_signing_threads(uint16_t threads);
+
     /// Create a new wallet.
     /// A new wallet is created in file dir/{name}.wallet see set_dir.
     /// The new wallet is unlocked after creation.
@@ -141,9 +167,19 @@ private:
     /// Calls lock_all() if timeout has passed.
     void check_timeout();
 
+    /// Adds the keys of an unlocked wallet into key index, keys already indexed keep their wallets.
+    void index_keys(wallet_api* wallet);
+
+    /// Removes the keys of wallet from key index, the ones also held by other unlocked wallets are pointed to them.
+    void unindex_keys(wallet_api* wallet);
+
+    /// @return the unlocked wallet holding key, nullptr if there is none
+    wallet_api* find_key_wallet(const public_key_type& key);
+
 private:
     using timepoint_t = std::chrono::time_point<std::chrono::system_clock>;
     std::map<std::string, std::unique_ptr<wallet_api>> wallets;
+    std::unordered_map<public_key_type, wallet_api*>   key_index;  ///< public keys of unlocked wallets to the wallets
 
     std::chrono::seconds    timeout      = std::chrono::seconds::max();  ///< how long to wait before calling lock_all()
     mutable timepoint_t     timeout_time = timepoint_t::max();           ///< when to call lock_all()
@@ -151,6 +187,7 @@ private:
     boost::filesystem::path lock_path    = dir / "wallet.lock";
     
     std::unique_ptr<boost::interprocess::file_lock> wallet_dir_lock;
+    std::unique_ptr<boost::asio::thread_pool>       signing_pool;
 
     void start_lock_watch(std::shared_ptr<boost::asio::deadline_timer> t);
     void initialize_lock();
@@ -210,11 +210,15 @@ struct se_wallet_impl {
         long derSize           = CFDataGetLength(signature);
         d2i_ECDSA_SIG(&sig.obj, &der_bytes, derSize);
 
-        public_key_data   kd;
+        // public key data is taken from the key in map, which saves a query of keychain for every digest
+        char                  pub_key_shim_data[64];
+        fc::datastream<char*> eds(pub_key_shim_data, sizeof(pub_key_shim_data));
+        fc::raw::pack(eds, it->first);
+        public_key_data* kd = (public_key_data*)(pub_key_shim_data + 1);
+
         compact_signature compact_sig;
         try {
-            kd          = get_public_key_data(it->second);
-            compact_sig = signature_from_ecdsa(key, kd, sig, d);
+            compact_sig = signature_from_ecdsa(key, *kd, sig, d);
         }
         catch(chain::wallet_exception&) {
             CFRelease(signature);
@@ -2,8 +2,11 @@
  *  @file
  *  @copyright defined in evt/LICENSE.txt
  */
+#include <algorithm>
+#include <future>
 #include <fc/crypto/sha256.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/post.hpp>
 #include <appbase/application.hpp>
 #include <evt/chain/exceptions.hpp>
 #include <evt/wallet_plugin/wallet_manager.hpp>
@@ -39,6 +42,9 @@ wallet_manager::wallet_manager() {
 }
 
 wallet_manager::~wallet_manager() {
+    if(signing_pool) {
+        signing_pool->join();
+    }
     //not really required, but may spook users
     if(wallet_dir_lock) {
         boost::filesystem::remove(lock_path);
@@ -65,6 +71,58 @@ wallet_manager::check_timeout() {
     }
 }
 
+void
+wallet_manager::index_keys(wallet_api* wallet) {
+    for(auto& pk : wallet->list_public_keys()) {
+        key_index.emplace(pk, wallet);
+    }
+}
+
+void
+wallet_manager::unindex_keys(wallet_api* wallet) {
+    auto removed = std::vector<public_key_type>();
+    for(auto it = key_index.begin(); it != key_index.end();) {
+        if(it->second == wallet) {
+            removed.emplace_back(it->first);
+            it = key_index.erase(it);
+            continue;
+        }
+        it++;
+    }
+    if(removed.empty()) {
+        return;
+    }
+
+    // keys may be imported into several wallets
+    for(const auto& i : wallets) {
+        if(i.second.get() == wallet || i.second->is_locked()) {
+            continue;
+        }
+        auto keys = i.second->list_public_keys();
+        for(auto& pk : removed) {
+            if(keys.find(pk) != keys.end()) {
+                key_index.emplace(pk, i.second.get());
+            }
+        }
+    }
+}
+
+wallet_api*
+wallet_manager::find_key_wallet(const public_key_type& key) {
+    auto it = key_index.find(key);
+    if(it == key_index.end()) {
+        return nullptr;
+    }
+    if(!it->second->is_locked()) {
+        return it->second;
+    }
+
+    // device wallets can lock by themselves when their sessions are lost
+    unindex_keys(it->second);
+    it = key_index.find(key);
+    return it != key_index.end() ? it->second : nullptr;
+}
+
 std::string
 wallet_manager::create(const std::string& name) {
     check_timeout();
@@ -94,8 +152,10 @@ wallet_manager::create(const std::string& name) {
     // This can happen if the wallet file is removed while evtd is running.
     auto it = wallets.find(name);
     if(it != wallets.end()) {
+        unindex_keys(it->second.get());
         wallets.erase(it);
     }
+    index_keys(wallet.get());
     wallets.emplace(name, std::move(wallet));
 
     return password;
@@ -119,6 +179,7 @@ wallet_manager::open(const std::string& name) {
     // This can happen if the wallet file is added while evtd is running.
     auto it = wallets.find(name);
     if(it != wallets.end()) {
+        unindex_keys(it->second.get());
         wallets.erase(it);
     }
     wallets.emplace(name, std::move(wallet));
@@ -156,15 +217,25 @@ flat_set<public_key_type>
 wallet_manager::get_public_keys() {
     check_timeout();
     EVT_ASSERT(!wallets.empty(), wallet_not_available_exception, "You don't have any wallet!");
-    flat_set<public_key_type> result;
-    bool                      is_all_wallet_locked = true;
+    bool is_all_wallet_locked = true;
     for(const auto& i : wallets) {
-        if(!i.second->is_locked()) {
-            result.merge(i.second->list_public_keys());
+        if(i.second->is_locked()) {
+            // device wallets can lock by themselves, drop their keys from index
+            unindex_keys(i.second.get());
         }
         is_all_wallet_locked &= i.second->is_locked();
     }
     EVT_ASSERT(!is_all_wallet_locked, wallet_locked_exception, "You don't have any unlocked wallet!");
+
+    auto keys = std::vector<public_key_type>();
+    keys.reserve(key_index.size());
+    for(auto& k : key_index) {
+        keys.emplace_back(k.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    auto result = flat_set<public_key_type>();
+    result.insert(boost::container::ordered_unique_range, keys.cbegin(), keys.cend());
     return result;
 }
 
@@ -196,6 +267,7 @@ wallet_manager::lock_all() {
             i.second->lock();
         }
     }
+    key_index.clear();
 }
 
 void
@@ -209,6 +281,7 @@ wallet_manager::lock(const std::string& name) {
         return;
     }
     w->lock();
+    unindex_keys(w.get());
 }
 
 void
@@ -223,6 +296,7 @@ wallet_manager::unlock(const std::string& name, const std::string& password) {
         return;
     }
     w->unlock(password);
+    index_keys(w.get());
 }
 
 void
@@ -235,7 +309,9 @@ wallet_manager::import_key(const std::string& name, const std::string& wif_key)
     if(w->is_locked()) {
         EVT_THROW(chain::wallet_locked_exception, "Wallet is locked: ${w}", ("w", name));
     }
-    w->import_key(wif_key);
+    if(w->import_key(wif_key)) {
+        key_index.emplace(private_key_type(wif_key).get_public_key(), w.get());
+    }
 }
 
 void
@@ -249,7 +325,20 @@ wallet_manager::remove_key(const std::string& name, const std::string& password,
         EVT_THROW(chain::wallet_locked_exception, "Wallet is locked: ${w}", ("w", name));
     }
     w->check_password(password); //throws if bad password
-    w->remove_key(key);
+    if(w->remove_key(key)) {
+        auto pk = public_key_type(key);
+        auto it = key_index.find(pk);
+        if(it != key_index.end() && it->second == w.get()) {
+            key_index.erase(it);
+            // it may still be held by other unlocked wallets
+            for(const auto& i : wallets) {
+                if(!i.second->is_locked() && i.second->list_public_keys().count(pk)) {
+                    key_index.emplace(pk, i.second.get());
+                    break;
+                }
+            }
+        }
+    }
 }
 
 string
@@ -264,7 +353,9 @@ wallet_manager::create_key(const std::string& name, const std::string& key_type)
     }
 
     string upper_key_type = boost::to_upper_copy<std::string>(key_type);
-    return w->create_key(upper_key_type);
+    auto   key            = w->create_key(upper_key_type);
+    key_index.emplace(public_key_type(key), w.get());
+    return key;
 }
 
 chain::signed_transaction
@@ -272,24 +363,203 @@ wallet_manager::sign_transaction(const chain::signed_transaction& txn, const fla
     check_timeout();
     chain::signed_transaction stxn(txn);
 
+    auto digest = stxn.sig_digest(id);
     for(const auto& pk : keys) {
-        bool found = false;
-        for(const auto& i : wallets) {
-            if(!i.second->is_locked()) {
-                auto sig = i.second->try_sign_digest(stxn.sig_digest(id), pk);
-                if(sig.has_value()) {
-                    stxn.signatures.push_back(*sig);
-                    found = true;
-                    break;  // inner for
+        auto wallet = find_key_wallet(pk);
+        auto sig    = wallet ? wallet->try_sign_digest(digest, pk) : std::nullopt;
+        if(!sig.has_value()) {
+            EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+        }
+        stxn.signatures.push_back(*sig);
+    }
+
+    return stxn;
+}
+
+std::vector<chain::signed_transaction>
+wallet_manager::sign_transactions(const std::vector<chain::signed_transaction>& txns,
+                                  const std::vector<flat_set<public_key_type>>& keys,
+                                  const chain::chain_id_type& id) {
+    // transactions signed by each task of signing pool
+    constexpr size_t kTxnsPerTask = 64;
+
+    check_timeout();
+    EVT_ASSERT(txns.size() == keys.size(), wallet_exception,
+        "Number of key sets: ${k} doesn't match number of transactions: ${t}", ("k", keys.size())("t", txns.size()));
+
+    // wallets are resolved here, signing threads only read them
+    auto key_wallets = std::unordered_map<public_key_type, wallet_api*>();
+    auto concurrent  = true;
+    for(const auto& ks : keys) {
+        for(const auto& pk : ks) {
+            auto& wallet = key_wallets[pk];
+            if(wallet == nullptr) {
+                wallet = find_key_wallet(pk);
+                if(wallet == nullptr) {
+                    EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
                 }
             }
+            concurrent = concurrent && wallet->can_sign_concurrently();
         }
-        if(!found) {
-            EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+    }
+
+    auto stxns = txns;
+    auto sign  = [&](size_t begin, size_t end) {
+        for(auto i = begin; i < end; i++) {
+            auto digest = stxns[i].sig_digest(id);
+            for(const auto& pk : keys[i]) {
+                auto sig = key_wallets.find(pk)->second->try_sign_digest(digest, pk);
+                if(!sig.has_value()) {
+                    EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", pk));
+                }
+                stxns[i].signatures.push_back(*sig);
+            }
+        }
+    };
+
+    if(!concurrent) {
+        // devices get all their digests in one batch
+        auto digests = std::vector<chain::digest_type>();
+        auto dkeys   = std::vector<public_key_type>();
+        for(auto i = 0u; i < stxns.size(); i++) {
+            auto digest = stxns[i].sig_digest(id);
+            for(const auto& pk : keys[i]) {
+                digests.emplace_back(digest);
+                dkeys.emplace_back(pk);
+            }
+        }
+
+        auto sigs = sign_digests(digests, dkeys);
+        auto it   = sigs.begin();
+        for(auto i = 0u; i < stxns.size(); i++) {
+            for(auto j = 0u; j < keys[i].size(); j++) {
+                stxns[i].signatures.push_back(std::move(*it++));
+            }
         }
+        return stxns;
+    }
+    if(!signing_pool || stxns.size() <= kTxnsPerTask) {
+        sign(0, stxns.size());
+        return stxns;
     }
 
-    return stxn;
+    auto tasks = std::vector<std::future<void>>();
+    for(auto i = 0u; i < stxns.size(); i += kTxnsPerTask) {
+        auto task = std::packaged_task<void()>([&sign, i, n = stxns.size()] {
+            sign(i, std::min(i + kTxnsPerTask, n));
+        });
+        tasks.emplace_back(task.get_future());
+        boost::asio::post(*signing_pool, std::move(task));
+    }
+    // waits for all the tasks before throwing the first error, they still refer to the locals
+    auto error = std::exception_ptr();
+    for(auto& t : tasks) {
+        try {
+            t.get();
+        }
+        catch(...) {
+            if(!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+    return stxns;
+}
+
+std::vector<chain::signature_type>
+wallet_manager::sign_digests(const std::vector<chain::digest_type>& digests, const std::vector<public_key_type>& keys) {
+    // digests signed by each task of signing pool
+    constexpr size_t kDigestsPerTask = 64;
+
+    check_timeout();
+    EVT_ASSERT(digests.size() == keys.size(), wallet_exception,
+        "Number of keys: ${k} doesn't match number of digests: ${d}", ("k", keys.size())("d", digests.size()));
+
+    // indexes of the digests of each wallet
+    auto batches = flat_map<wallet_api*, std::vector<size_t>>();
+    for(auto i = 0u; i < keys.size(); i++) {
+        auto wallet = find_key_wallet(keys[i]);
+        if(wallet == nullptr) {
+            EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", keys[i]));
+        }
+        batches[wallet].emplace_back(i);
+    }
+
+    auto sigs = std::vector<chain::signature_type>(digests.size());
+    auto sign = [&](wallet_api* wallet, const std::vector<size_t>& idxs, size_t begin, size_t end) {
+        auto ds = std::vector<std::pair<chain::digest_type, public_key_type>>();
+        ds.reserve(end - begin);
+        for(auto i = begin; i < end; i++) {
+            ds.emplace_back(digests[idxs[i]], keys[idxs[i]]);
+        }
+
+        auto rs = wallet->try_sign_digests(ds);
+        for(auto i = begin; i < end; i++) {
+            auto& sig = rs[i - begin];
+            if(!sig.has_value()) {
+                EVT_THROW(chain::wallet_missing_pub_key_exception, "Public key not found in unlocked wallets ${k}", ("k", keys[idxs[i]]));
+            }
+            sigs[idxs[i]] = std::move(*sig);
+        }
+    };
+
+    auto tasks = std::vector<std::future<void>>();
+    for(auto& b : batches) {
+        auto  wallet = b.first;
+        auto& idxs   = b.second;
+        if(!signing_pool || !wallet->can_sign_concurrently() || idxs.size() <= kDigestsPerTask) {
+            continue;
+        }
+        for(auto i = 0u; i < idxs.size(); i += kDigestsPerTask) {
+            auto task = std::packaged_task<void()>([&sign, wallet, &idxs, i] {
+                sign(wallet, idxs, i, std::min(i + kDigestsPerTask, idxs.size()));
+            });
+            tasks.emplace_back(task.get_future());
+            boost::asio::post(*signing_pool, std::move(task));
+        }
+    }
+
+    // the batches not split are signed on this thread while the tasks are running,
+    // all the tasks are waited before throwing the first error, they still refer to the locals
+    auto error = std::exception_ptr();
+    try {
+        for(auto& b : batches) {
+            if(!signing_pool || !b.first->can_sign_concurrently() || b.second.size() <= kDigestsPerTask) {
+                sign(b.first, b.second, 0, b.second.size());
+            }
+        }
+    }
+    catch(...) {
+        error = std::current_exception();
+    }
+    for(auto& t : tasks) {
+        try {
+            t.get();
+        }
+        catch(...) {
+            if(!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+    return sigs;
+}
+
+void
+wallet_manager::set_signing_threads(uint16_t threads) {
+    if(signing_pool) {
+        signing_pool->join();
+        signing_pool.reset();
+    }
+    if(threads > 0) {
+        signing_pool = std::make_unique<boost::asio::thread_pool>(threads);
+    }
 }
 
 chain::signature_type
@@ -297,12 +567,11 @@ wallet_manager::sign_digest(const chain::digest_type& digest, const public_key_t
     check_timeout();
 
     try {
-        for(const auto& i : wallets) {
-            if(!i.second->is_locked()) {
-                auto sig = i.second->try_sign_digest(digest, key);
-                if(sig.has_value()) {
-                    return *sig;
-                }
+        auto wallet = find_key_wallet(key);
+        if(wallet != nullptr) {
+            auto sig = wallet->try_sign_digest(digest, key);
+            if(sig.has_value()) {
+                return *sig;
             }
         }
     }
@@ -316,6 +585,9 @@ wallet_manager::own_and_use_wallet(const string& name, std::unique_ptr<wallet_ap
     if(wallets.find(name) != wallets.end()) {
         EVT_THROW(wallet_exception, "Tried to use wallet name that already exists.");
     }
+    if(!wallet->is_locked()) {
+        index_keys(wallet.get());
+    }
     wallets.emplace(name, std::move(wallet));
 }
 
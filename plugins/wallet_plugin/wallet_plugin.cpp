@@ -36,8 +36,11 @@ wallet_plugin::set_program_options(options_description& cli, options_description
             "Timeout for unlocked wallet in seconds (default 900 (15 minutes)). "
             "Wallets will automatically lock after specified number of seconds of inactivity. "
             "Activity is defined as any wallet command e.g. list-wallets.")
+        ("wallet-signing-threads", bpo::value<uint16_t>()->default_value(2),
+            "Number of threads signing the transactions of one sign_transactions request, 0 to sign them on the main thread")
         ("yubihsm-url", bpo::value<string>()->value_name("URL"), "Override default URL of http://localhost:12345 for connecting to yubihsm-connector")
         ("yubihsm-authkey", bpo::value<uint16_t>()->value_name("key_num"), "Enables YubiHSM support using given Authkey")
+        ("yubihsm-sessions", bpo::value<uint16_t>()->default_value(1), "Number of YubiHSM sessions signing the digests of one batch at the same time, at most 16")
         ;
 }
 
@@ -65,13 +68,16 @@ wallet_plugin::plugin_initialize(const variables_map& options) {
             std::chrono::seconds t(timeout);
             wallet_manager_ptr->set_timeout(t);
         }
+        wallet_manager_ptr->set_signing_threads(options.at("wallet-signing-threads").as<uint16_t>());
         if(options.count("yubihsm-authkey")) {
             uint16_t key                = options.at("yubihsm-authkey").as<uint16_t>();
             string   connector_endpoint = "http://localhost:12345";
             if(options.count("yubihsm-url"))
                 connector_endpoint = options.at("yubihsm-url").as<string>();
+            auto sessions = options.at("yubihsm-sessions").as<uint16_t>();
+            EVT_ASSERT(sessions > 0 && sessions <= 16, chain::plugin_config_exception, "Number of YubiHSM sessions should be in [1, 16]");
             try {
-                wallet_manager_ptr->own_and_use_wallet("YubiHSM", make_unique<yubihsm_wallet>(connector_endpoint, key));
+                wallet_manager_ptr->own_and_use_wallet("YubiHSM", make_unique<yubihsm_wallet>(connector_endpoint, key, sessions));
             }
             FC_LOG_AND_RETHROW()
         }
@@ -17,6 +17,7 @@
 #include <boost/dll/runtime_symbol_info.hpp>
 
 #include <dlfcn.h>
+#include <future>
 
 namespace evt { namespace wallet {
 
@@ -89,9 +90,16 @@ struct yubihsm_api {
 struct yubihsm_wallet_impl {
     using key_map_type = map<public_key_type, uint16_t>;
 
-    yubihsm_wallet_impl(const string& ep, const uint16_t ak)
+    // every session has its own connector, so the sessions can be used by different threads at the same time
+    struct hsm_session {
+        yh_connector* connector = nullptr;
+        yh_session*   session   = nullptr;
+    };
+
+    yubihsm_wallet_impl(const string& ep, const uint16_t ak, const uint16_t sc)
         : endpoint(ep)
-        , authkey(ak) {
+        , authkey(ak)
+        , session_count(std::max<uint16_t>(sc, 1)) {
         yh_rc rc;
         if((rc = api.init()))
             FC_THROW("yubihsm init failure: ${c}", ("c", api.strerror(rc)));
@@ -107,7 +115,7 @@ struct yubihsm_wallet_impl {
 
     bool
     is_locked() const {
-        return !connector;
+        return sessions.empty();
     }
 
     key_map_type::iterator
@@ -115,7 +123,7 @@ struct yubihsm_wallet_impl {
         yh_rc   rc;
         size_t  blob_sz = 128;
         uint8_t blob[blob_sz];
-        if((rc = api.util_get_pubkey(session, key_id, blob, &blob_sz, nullptr)))
+        if((rc = api.util_get_pubkey(sessions.front().session, key_id, blob, &blob_sz, nullptr)))
             FC_THROW_EXCEPTION(chain::wallet_exception, "yh_util_get_pubkey failed: ${m}", ("m", api.strerror(rc)));
         if(blob_sz != 64)
             FC_THROW_EXCEPTION(chain::wallet_exception, "unexpected pubkey size from yh_util_get_pubkey");
@@ -134,19 +142,30 @@ struct yubihsm_wallet_impl {
     }
 
     void
-    unlock(const string& password) {
+    open_session(const string& password) {
         yh_rc   rc;
         uint8_t context[YH_CONTEXT_LEN] = {0};
 
+        auto& s = sessions.emplace_back();
+        if((rc = api.init_connector(endpoint.c_str(), &s.connector)))
+            FC_THROW_EXCEPTION(chain::wallet_exception, "Failled to initialize yubihsm connector URL: ${c}", ("c", api.strerror(rc)));
+        if((rc = api.connect_best(&s.connector, 1, NULL)))
+            FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to connect to YubiHSM connector: ${m}", ("m", api.strerror(rc)));
+        if((rc = api.create_session_derived(s.connector, authkey, (const uint8_t*)password.data(), password.size(), false, context, sizeof(context), &s.session)))
+            FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to create YubiHSM session: ${m}", ("m", api.strerror(rc)));
+        if((rc = api.authenticate_session(s.session, context, sizeof(context))))
+            FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to authenticate YubiHSM session: ${m}", ("m", api.strerror(rc)));
+    }
+
+    void
+    unlock(const string& password) {
+        yh_rc rc;
+
         try {
-            if((rc = api.init_connector(endpoint.c_str(), &connector)))
-                FC_THROW_EXCEPTION(chain::wallet_exception, "Failled to initialize yubihsm connector URL: ${c}", ("c", api.strerror(rc)));
-            if((rc = api.connect_best(&connector, 1, NULL)))
-                FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to connect to YubiHSM connector: ${m}", ("m", api.strerror(rc)));
-            if((rc = api.create_session_derived(connector, authkey, (const uint8_t*)password.data(), password.size(), false, context, sizeof(context), &session)))
-                FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to create YubiHSM session: ${m}", ("m", api.strerror(rc)));
-            if((rc = api.authenticate_session(session, context, sizeof(context))))
-                FC_THROW_EXCEPTION(chain::wallet_exception, "Failed to authenticate YubiHSM session: ${m}", ("m", api.strerror(rc)));
+            for(auto i = 0u; i < session_count; i++) {
+                open_session(password);
+            }
+            auto session = sessions.front().session;
 
             yh_object_descriptor authkey_desc;
             if((rc = api.util_get_object_info(session, authkey, YH_AUTHKEY, &authkey_desc)))
@@ -178,16 +197,17 @@ struct yubihsm_wallet_impl {
 
     void
     lock() {
-        if(session) {
-            api.util_close_session(session);
-            api.destroy_session(&session);
+        for(auto& s : sessions) {
+            if(s.session) {
+                api.util_close_session(s.session);
+                api.destroy_session(&s.session);
+            }
+            if(s.connector)
+                api.disconnect(s.connector);
+            //it would seem like this would leak-- there is no destroy() call for it. But I clearly can't reuse connectors
+            // as that fails with a "Unable to find a suitable connector"
         }
-        session = nullptr;
-        if(connector)
-            api.disconnect(connector);
-        //it would seem like this would leak-- there is no destroy() call for it. But I clearly can't reuse connectors
-        // as that fails with a "Unable to find a suitable connector"
-        connector = nullptr;
+        sessions.clear();
 
         _keys.clear();
         keepalive_timer.cancel();
@@ -197,30 +217,29 @@ struct yubihsm_wallet_impl {
     prime_keepalive_timer() {
         keepalive_timer.expires_at(std::chrono::steady_clock::now() + std::chrono::seconds(20));
         keepalive_timer.async_wait([this](auto ec) {
-            if(ec || !session)
+            if(ec || sessions.empty())
                 return;
 
-            uint8_t data, resp;
-            yh_cmd  resp_cmd;
-            size_t  resp_sz = 1;
-            if(api.send_secure_msg(session, YHC_ECHO, &data, 1, &resp_cmd, &resp, &resp_sz))
-                lock();
-            else
-                prime_keepalive_timer();
+            for(auto& s : sessions) {
+                uint8_t data, resp;
+                yh_cmd  resp_cmd;
+                size_t  resp_sz = 1;
+                if(api.send_secure_msg(s.session, YHC_ECHO, &data, 1, &resp_cmd, &resp, &resp_sz)) {
+                    lock();
+                    return;
+                }
+            }
+            prime_keepalive_timer();
         });
     }
 
-    std::optional<signature_type>
-    try_sign_digest(const digest_type d, const public_key_type public_key) {
-        auto it = _keys.find(public_key);
-        if(it == _keys.end())
-            return std::optional<signature_type>{};
-
+    // doesn't lock the wallet when fails, so the sessions can sign at the same time
+    signature_type
+    sign_digest(yh_session* session, const digest_type& d, key_map_type::const_iterator it) const {
         size_t  der_sig_sz = 128;
         uint8_t der_sig[der_sig_sz];
         yh_rc   rc;
         if((rc = api.util_sign_ecdsa(session, it->second, (uint8_t*)d.data(), d.data_size(), der_sig, &der_sig_sz))) {
-            lock();
             FC_THROW_EXCEPTION(chain::wallet_exception, "yh_util_sign_ecdsa failed: ${m}", ("m", api.strerror(rc)));
         }
 
@@ -249,6 +268,70 @@ struct yubihsm_wallet_impl {
         return final_signature;
     }
 
+    std::optional<signature_type>
+    try_sign_digest(const digest_type d, const public_key_type public_key) {
+        auto it = _keys.find(public_key);
+        if(it == _keys.end())
+            return std::optional<signature_type>{};
+
+        try {
+            return sign_digest(sessions.front().session, d, it);
+        }
+        catch(chain::wallet_exception& e) {
+            lock();
+            throw;
+        }
+    }
+
+    std::vector<std::optional<signature_type>>
+    try_sign_digests(const std::vector<std::pair<digest_type, public_key_type>>& digests) {
+        auto sigs = std::vector<std::optional<signature_type>>(digests.size());
+        if(sessions.empty() || digests.empty()) {
+            return sigs;
+        }
+
+        // digests are split into continuous ranges, each session signs one of them in its own thread
+        auto sign = [&](yh_session* session, size_t begin, size_t end) {
+            for(auto i = begin; i < end; i++) {
+                auto it = _keys.find(digests[i].second);
+                if(it != _keys.end()) {
+                    sigs[i] = sign_digest(session, digests[i].first, it);
+                }
+            }
+        };
+
+        auto n     = digests.size();
+        auto per   = (n + sessions.size() - 1) / sessions.size();
+        auto tasks = std::vector<std::future<void>>();
+        for(auto s = 1u; s < sessions.size() && s * per < n; s++) {
+            tasks.emplace_back(std::async(std::launch::async, sign, sessions[s].session, s * per, std::min((s + 1) * per, n)));
+        }
+
+        // waits for all the sessions before locking the wallet if any of them fails
+        auto error = std::exception_ptr();
+        try {
+            sign(sessions.front().session, 0, std::min(per, n));
+        }
+        catch(...) {
+            error = std::current_exception();
+        }
+        for(auto& t : tasks) {
+            try {
+                t.get();
+            }
+            catch(...) {
+                if(!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if(error) {
+            lock();
+            std::rethrow_exception(error);
+        }
+        return sigs;
+    }
+
     public_key_type
     create() {
         if(!api.check_capability(&authkey_caps, "asymmetric_gen"))
@@ -261,7 +344,7 @@ struct yubihsm_wallet_impl {
             FC_THROW_EXCEPTION(chain::wallet_exception, "Cannot create caps mask");
 
         try {
-            if((rc = api.util_generate_key_ec(session, &new_key_id, "evtwd created key", authkey_domains, &creation_caps, YH_ALGO_EC_P256)))
+            if((rc = api.util_generate_key_ec(sessions.front().session, &new_key_id, "evtwd created key", authkey_domains, &creation_caps, YH_ALGO_EC_P256)))
                 FC_THROW_EXCEPTION(chain::wallet_exception, "yh_util_generate_key_ec failed: ${m}", ("m", api.strerror(rc)));
             return populate_key_map_with_keyid(new_key_id)->first;
         }
@@ -271,10 +354,10 @@ struct yubihsm_wallet_impl {
         }
     }
 
-    yh_connector* connector = nullptr;
-    yh_session*   session   = nullptr;
-    string        endpoint;
-    uint16_t      authkey;
+    std::vector<hsm_session> sessions;
+    string                   endpoint;
+    uint16_t                 authkey;
+    uint16_t                 session_count;
 
     map<public_key_type, uint16_t> _keys;
 
@@ -289,8 +372,8 @@ struct yubihsm_wallet_impl {
 
 }  // namespace detail
 
-yubihsm_wallet::yubihsm_wallet(const string& connector, const uint16_t authkey)
-    : my(new detail::yubihsm_wallet_impl(connector, authkey)) {
+yubihsm_wallet::yubihsm_wallet(const string& connector, const uint16_t authkey, const uint16_t sessions)
+    : my(new detail::yubihsm_wallet_impl(connector, authkey, sessions)) {
 }
 
 yubihsm_wallet::~yubihsm_wallet() {
@@ -356,4 +439,9 @@ yubihsm_wallet::try_sign_digest(const digest_type digest, const public_key_type
     return my->try_sign_digest(digest, public_key);
 }
 
+std::vector<std::optional<signature_type>>
+yubihsm_wallet::try_sign_digests(const std::vector<std::pair<digest_type, public_key_type>>& digests) {
+    return my->try_sign_digests(digests);
+}
+
 }}  // namespace evt::wallet
\ No newline at end of file
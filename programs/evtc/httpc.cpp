@@ -12,13 +12,17 @@
 
 #include <iostream>
 #include <istream>
+#include <map>
+#include <memory>
 #include <ostream>
 #include <regex>
+#include <sstream>
 #include <string>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
@@ -32,9 +36,26 @@ using boost::asio::ip::tcp;
 namespace evt { namespace client { namespace http {
 
 namespace detail {
+
+// connection kept alive between the calls to the same server
+struct http_connection {
+    std::unique_ptr<boost::asio::ssl::context>                   ssl_context;
+    std::unique_ptr<boost::asio::ssl::stream<tcp::socket>>       ssl_socket;
+    std::unique_ptr<tcp::socket>                                 tcp_socket;
+    std::unique_ptr<boost::asio::local::stream_protocol::socket> unix_socket;
+
+    bool
+    is_open() const {
+        return ssl_socket || tcp_socket || unix_socket;
+    }
+};
+
 class http_context_impl {
 public:
     boost::asio::io_service ios;
+
+    // keyed by scheme, server, port and if verifies the certificate
+    std::map<std::string, http_connection> connections;
 };
 
 void
@@ -61,9 +82,9 @@ do_connect(tcp::socket& sock, const resolved_url& url) {
 
 template <class T>
 std::string
-do_txrx(T& socket, boost::asio::streambuf& request_buff, unsigned int& status_code) {
+do_txrx(T& socket, const std::string& request, unsigned int& status_code, bool& keep_alive) {
     // Send the request.
-    boost::asio::write(socket, request_buff);
+    boost::asio::write(socket, boost::asio::buffer(request));
 
     // Read the response status line. The response streambuf will automatically
     // grow to accommodate the entire line. The growth may be limited by passing
@@ -80,6 +101,9 @@ do_txrx(T& socket, boost::asio::streambuf& request_buff, unsigned int& status_co
     std::getline(response_stream, status_message);
     FC_ASSERT(!(!response_stream || http_version.substr(0, 5) != "HTTP/"), "Invalid Response");
 
+    // HTTP/1.1 keeps the connection by default while HTTP/1.0 doesn't
+    keep_alive = (http_version != "HTTP/1.0");
+
     // Read the response headers, which are terminated by a blank line.
     boost::asio::read_until(socket, response, "\r\n\r\n");
 
@@ -87,10 +111,15 @@ do_txrx(T& socket, boost::asio::streambuf& request_buff, unsigned int& status_co
     std::string header;
     int         response_content_length = -1;
     std::regex  clregex(R"xx(^Content-Length:\s+(\d+))xx", std::regex_constants::icase);
+    std::regex  connregex(R"xx(^Connection:\s+(\S+))xx", std::regex_constants::icase);
     while(std::getline(response_stream, header) && header != "\r") {
         std::smatch match;
-        if(std::regex_search(header, match, clregex))
+        if(std::regex_search(header, match, clregex)) {
             response_content_length = std::stoi(match[1]);
+        }
+        else if(std::regex_search(header, match, connregex)) {
+            keep_alive = boost::iequals(match.str(1), "keep-alive");
+        }
     }
     FC_ASSERT(response_content_length >= 0, "Invalid Content-Length response, header: ${h}", ("h",header));
 
@@ -106,6 +135,70 @@ do_txrx(T& socket, boost::asio::streambuf& request_buff, unsigned int& status_co
     return re.str();
 }
 
+namespace detail {
+
+std::string
+connection_key(const connection_param& cp) {
+    const auto& url = cp.url;
+    return url.scheme + "://" + url.server + ":" + url.port + (cp.verify_cert ? "" : "?noverify");
+}
+
+void
+open_connection(http_connection& conn, const connection_param& cp) {
+    const auto& url = cp.url;
+    auto&       ios = cp.context->ios;
+
+    if(url.scheme == "unix") {
+        conn.unix_socket = std::make_unique<boost::asio::local::stream_protocol::socket>(ios);
+        conn.unix_socket->connect(boost::asio::local::stream_protocol::endpoint(url.server));
+    }
+    else if(url.scheme == "http") {
+        conn.tcp_socket = std::make_unique<tcp::socket>(ios);
+        do_connect(*conn.tcp_socket, url);
+    }
+    else {  //https
+        conn.ssl_context = std::make_unique<boost::asio::ssl::context>(boost::asio::ssl::context::sslv23_client);
+        fc::add_platform_root_cas_to_context(*conn.ssl_context);
+
+        conn.ssl_socket = std::make_unique<boost::asio::ssl::stream<tcp::socket>>(ios, *conn.ssl_context);
+        SSL_set_tlsext_host_name(conn.ssl_socket->native_handle(), url.server.c_str());
+        if(cp.verify_cert) {
+            conn.ssl_socket->set_verify_mode(boost::asio::ssl::verify_peer);
+            conn.ssl_socket->set_verify_callback(boost::asio::ssl::rfc2818_verification(url.server));
+        }
+        do_connect(conn.ssl_socket->next_layer(), url);
+        conn.ssl_socket->handshake(boost::asio::ssl::stream_base::client);
+    }
+}
+
+void
+close_connection(http_connection& conn) {
+    if(conn.ssl_socket) {
+        //try and do a clean shutdown; but swallow if this fails (other side could have already gave TCP the ax)
+        try {conn.ssl_socket->shutdown();} catch(...) {}
+    }
+    // stream needs to be destroyed before its ssl context
+    conn.ssl_socket.reset();
+    conn.ssl_context.reset();
+    conn.tcp_socket.reset();
+    conn.unix_socket.reset();
+}
+
+std::string
+txrx(http_connection& conn, const std::string& request, unsigned int& status_code, bool& keep_alive) {
+    if(conn.unix_socket) {
+        return do_txrx(*conn.unix_socket, request, status_code, keep_alive);
+    }
+    else if(conn.tcp_socket) {
+        return do_txrx(*conn.tcp_socket, request, status_code, keep_alive);
+    }
+    else {
+        return do_txrx(*conn.ssl_socket, request, status_code, keep_alive);
+    }
+}
+
+}  // namespace detail
+
 parsed_url
 parse_url(const string& server_url) {
     parsed_url res;
@@ -199,15 +292,14 @@ do_http_call(const connection_param& cp,
 
     const auto& url = cp.url;
 
-    boost::asio::streambuf request;
-    std::ostream           request_stream(&request);
+    std::ostringstream request_stream;
 
     auto host_header_value = format_host_header(url);
-    request_stream << "POST " << url.path << " HTTP/1.0\r\n";
+    request_stream << "POST " << url.path << " HTTP/1.1\r\n";
     request_stream << "Host: " << host_header_value << "\r\n";
     request_stream << "Content-Length: " << postjson.size() << "\r\n";
     request_stream << "Accept: */*\r\n";
-    request_stream << "Connection: close\r\n";
+    request_stream << "Connection: keep-alive\r\n";
     // append more customized headers
     std::vector<string>::iterator itr;
     for(itr = cp.headers.begin(); itr != cp.headers.end(); itr++) {
@@ -216,12 +308,11 @@ do_http_call(const connection_param& cp,
     request_stream << "\r\n";
     request_stream << postjson;
 
+    auto request = request_stream.str();
     if(print_request) {
-        string s(request.size(), '\0');
-        buffer_copy(boost::asio::buffer(s), request.data());
         std::cerr << "REQUEST:" << std::endl
                   << "---------------------" << std::endl
-                  << s << std::endl
+                  << request << std::endl
                   << "---------------------" << std::endl;
     }
 
@@ -229,31 +320,32 @@ do_http_call(const connection_param& cp,
     std::string  re;
 
     try {
-        if(url.scheme == "unix") {
-            boost::asio::local::stream_protocol::socket unix_socket(cp.context->ios);
-            unix_socket.connect(boost::asio::local::stream_protocol::endpoint(url.server));
-            re = do_txrx(unix_socket, request, status_code);
+        auto& conn       = cp.context->connections[detail::connection_key(cp)];
+        auto  reused     = conn.is_open();
+        auto  keep_alive = false;
+        try {
+            if(!reused) {
+                detail::open_connection(conn, cp);
+            }
+            try {
+                re = detail::txrx(conn, request, status_code, keep_alive);
+            }
+            catch(boost::system::system_error&) {
+                if(!reused) {
+                    throw;
+                }
+                // server may have closed the idle connection, retry once with a new one
+                detail::close_connection(conn);
+                detail::open_connection(conn, cp);
+                re = detail::txrx(conn, request, status_code, keep_alive);
+            }
         }
-        else if(url.scheme == "http") {
-            tcp::socket socket(cp.context->ios);
-            do_connect(socket, url);
-            re = do_txrx(socket, request, status_code);
+        catch(...) {
+            detail::close_connection(conn);
+            throw;
         }
-        else {  //https
-            boost::asio::ssl::context ssl_context(boost::asio::ssl::context::sslv23_client);
-            fc::add_platform_root_cas_to_context(ssl_context);
-
-            boost::asio::ssl::stream<boost::asio::ip::tcp::socket> socket(cp.context->ios, ssl_context);
-            SSL_set_tlsext_host_name(socket.native_handle(), url.server.c_str());
-            if(cp.verify_cert) {
-                socket.set_verify_mode(boost::asio::ssl::verify_peer);
-                socket.set_verify_callback(boost::asio::ssl::rfc2818_verification(url.server));
-            }
-            do_connect(socket.next_layer(), url);
-            socket.handshake(boost::asio::ssl::stream_base::client);
-            re = do_txrx(socket, request, status_code);
-            //try and do a clean shutdown; but swallow if this fails (other side could have already gave TCP the ax)
-            try {socket.shutdown();} catch(...) {}
+        if(!keep_alive) {
+            detail::close_connection(conn);
         }
     }
     catch(chain::invalid_http_request& e) {
@@ -102,6 +102,7 @@ fc::variant do_http_call(
 const std::string chain_func_base             = "/v1/chain";
 const std::string get_info_func               = chain_func_base + "/get_info";
 const std::string get_db_info_func            = chain_func_base + "/get_db_info";
+const std::string get_db_metrics_func         = chain_func_base + "/get_db_metrics";
 const std::string push_txn_func               = chain_func_base + "/push_transaction";
 const std::string push_txns_func              = chain_func_base + "/push_transactions";
 const std::string json_to_bin_func            = chain_func_base + "/abi_json_to_bin";
@@ -135,6 +136,7 @@ const std::string wallet_import_key    = wallet_func_base + "/import_key";
 const std::string wallet_remove_key    = wallet_func_base + "/remove_key";
 const std::string wallet_create_key    = wallet_func_base + "/create_key";
 const std::string wallet_sign_trx      = wallet_func_base + "/sign_transaction";
+const std::string wallet_sign_trxs     = wallet_func_base + "/sign_transactions";
 
 const std::string evt_func_base              = "/v1/evt";
 const std::string get_domain_func            = evt_func_base + "/get_domain";
@@ -3,10 +3,15 @@
  *  @copyright defined in evt/LICENSE.txt
  */
 
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <regex>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -27,6 +32,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/trim.hpp>
 
 #pragma pop_macro("N")
 
@@ -478,6 +484,282 @@ send_transaction(signed_transaction& trx, packed_transaction::compression_type c
     std::cout << fc::json::to_pretty_string(push_transaction(trx, compression)) << std::endl;
 }
 
+// runs `worker` on `n` threads and waits for all of them
+template <typename Worker>
+void
+run_workers(size_t n, Worker&& worker) {
+    auto workers = std::vector<std::thread>();
+    workers.reserve(n);
+    for(auto i = 0u; i < n; i++) {
+        workers.emplace_back(worker);
+    }
+    for(auto& w : workers) {
+        w.join();
+    }
+}
+
+// pushes transactions in JSON, one per line, with `concurrency` requests in flight
+// lines can be either signed transactions or packed ones, like the ones built by `batch`
+// results are printed in the same order, one per line
+void
+push_bulk_transactions(const std::string& file, uint32_t concurrency) {
+    FC_ASSERT(concurrency > 0, "Concurrency cannot be zero");
+
+    auto lines = std::vector<std::string>();
+    auto read  = [&lines](std::istream& is) {
+        auto line = std::string();
+        while(std::getline(is, line)) {
+            boost::trim(line);
+            if(!line.empty()) {
+                lines.emplace_back(std::move(line));
+            }
+        }
+    };
+    if(file == "-") {
+        read(std::cin);
+    }
+    else {
+        auto fs = std::ifstream(file);
+        FC_ASSERT(fs, "Cannot open transactions file: ${f}", ("f", file));
+        read(fs);
+    }
+
+    // url is resolved once, each worker has its own context and keeps its connection alive
+    auto rurl    = resolve_url(context, parse_url(url) + push_txn_func);
+    auto results = std::vector<fc::variant>(lines.size());
+    auto next    = std::atomic<size_t>(0);
+    auto failed  = std::atomic<size_t>(0);
+
+    run_workers(std::min<size_t>(concurrency, lines.size()), [&] {
+        auto ctx = create_http_context();
+        auto cp  = connection_param(ctx, rurl, !no_verify, headers);
+        for(auto i = next++; i < lines.size(); i = next++) {
+            try {
+                auto var = fc::json::from_string(lines[i]);
+                if(!var.get_object().contains("packed_trx")) {
+                    var = fc::variant(packed_transaction(var.as<signed_transaction>(), packed_transaction::none));
+                }
+                results[i] = do_http_call(cp, var);
+            }
+            catch(const fc::exception& e) {
+                results[i] = fc::mutable_variant_object("error", e.to_string());
+                failed++;
+            }
+            catch(const std::exception& e) {
+                results[i] = fc::mutable_variant_object("error", e.what());
+                failed++;
+            }
+        }
+    });
+
+    for(auto& r : results) {
+        std::cout << fc::json::to_string(r) << std::endl;
+    }
+    std::cerr << localized("Pushed ${n} transactions, ${f} failed", ("n", lines.size())("f", failed.load())) << std::endl;
+}
+
+// splits one line of CSV, fields can be quoted and the quotes inside are doubled
+std::vector<std::string>
+split_csv_line(const std::string& line) {
+    auto fields = std::vector<std::string>();
+    auto field  = std::string();
+    auto quoted = false;
+    for(auto i = 0u; i < line.size(); i++) {
+        auto c = line[i];
+        if(quoted) {
+            if(c != '"') {
+                field.push_back(c);
+            }
+            else if(i + 1 < line.size() && line[i + 1] == '"') {
+                field.push_back('"');
+                i++;
+            }
+            else {
+                quoted = false;
+            }
+        }
+        else if(c == '"') {
+            quoted = true;
+        }
+        else if(c == ',') {
+            fields.emplace_back(std::move(field));
+            field.clear();
+        }
+        else if(c != '\r') {
+            field.push_back(c);
+        }
+    }
+    FC_ASSERT(!quoted, "Unterminated quote in CSV line: ${l}", ("l", line));
+    fields.emplace_back(std::move(field));
+    return fields;
+}
+
+// replaces the `${column}` placeholders in all the strings of template with the fields of row
+fc::variant
+fill_template(const fc::variant& tmpl, const std::map<std::string, size_t>& columns, const std::vector<std::string>& row) {
+    if(tmpl.is_string()) {
+        auto& str = tmpl.get_string();
+        auto  re  = std::string();
+        auto  pos = size_t(0);
+        while(true) {
+            auto b = str.find("${", pos);
+            if(b == std::string::npos) {
+                re.append(str, pos, std::string::npos);
+                break;
+            }
+            auto e = str.find('}', b);
+            FC_ASSERT(e != std::string::npos, "Unterminated placeholder in template string: ${s}", ("s", str));
+
+            auto it = columns.find(str.substr(b + 2, e - b - 2));
+            FC_ASSERT(it != columns.end(), "Column '${c}' in template is not found in CSV", ("c", str.substr(b + 2, e - b - 2)));
+            re.append(str, pos, b - pos).append(row[it->second]);
+            pos = e + 1;
+        }
+        return fc::variant(std::move(re));
+    }
+    else if(tmpl.is_object()) {
+        auto obj = fc::mutable_variant_object();
+        for(auto& kv : tmpl.get_object()) {
+            obj(kv.key(), fill_template(kv.value(), columns, row));
+        }
+        return fc::variant(std::move(obj));
+    }
+    else if(tmpl.is_array()) {
+        auto arr = fc::variants();
+        arr.reserve(tmpl.size());
+        for(auto& v : tmpl.get_array()) {
+            arr.emplace_back(fill_template(v, columns, row));
+        }
+        return fc::variant(std::move(arr));
+    }
+    return tmpl;
+}
+
+// builds one transaction for each row of CSV from the template and writes the packed ones, one per line
+// chain info and ABI are fetched once, signs with the private keys locally or with the wallet keys in one call
+void
+build_batch_transactions(const std::string&              template_file,
+                         const std::string&              csv_file,
+                         const std::string&              output_file,
+                         const std::vector<std::string>& private_keys,
+                         const std::vector<std::string>& sign_keys,
+                         uint32_t                        threads) {
+    FC_ASSERT(threads > 0, "Number of threads cannot be zero");
+    FC_ASSERT(private_keys.empty() || sign_keys.empty(), "Transactions can be signed either by private keys or by wallet, not both");
+
+    auto tmpl = fc::json::from_file(template_file);
+    FC_ASSERT(tmpl.is_object() && tmpl.get_object().contains("actions"), "Template should be an object with actions");
+
+    auto fs = std::ifstream(csv_file);
+    FC_ASSERT(fs, "Cannot open CSV file: ${f}", ("f", csv_file));
+
+    auto line = std::string();
+    FC_ASSERT(std::getline(fs, line), "CSV file is empty, expects the header of columns");
+
+    auto columns = std::map<std::string, size_t>();
+    auto header  = split_csv_line(line);
+    for(auto i = 0u; i < header.size(); i++) {
+        columns.emplace(boost::trim_copy(header[i]), i);
+    }
+
+    auto rows = std::vector<std::vector<std::string>>();
+    while(std::getline(fs, line)) {
+        if(boost::trim_copy(line).empty()) {
+            continue;
+        }
+        auto& row = rows.emplace_back(split_csv_line(line));
+        FC_ASSERT(row.size() == header.size(), "Row ${r} has ${n} fields but there are ${c} columns",
+            ("r", rows.size())("n", row.size())("c", header.size()));
+    }
+
+    auto pkeys = std::vector<private_key_type>();
+    for(auto& k : private_keys) {
+        auto key = utilities::wif_to_key(k);
+        FC_ASSERT(key.has_value(), "Invalid private key");
+        pkeys.emplace_back(fc::crypto::private_key::regenerate(*key));
+    }
+
+    // chain state and ABI are shared by all the transactions
+    auto info     = get_info();
+    auto exec_ctx = evt_execution_context_mock();
+    set_execution_context(exec_ctx);
+    auto abi = abi_serializer(evt_contract_abi(), std::chrono::hours(1));
+
+    auto base       = signed_transaction();
+    base.expiration = info.head_block_time + tx_expiration;
+    base.max_charge = max_charge;
+    base.set_reference_block(info.last_irreversible_block_id);
+    if(!payer.empty()) {
+        base.payer = get_address(payer);
+    }
+
+    auto trxs      = std::vector<signed_transaction>(rows.size());
+    auto next      = std::atomic<size_t>(0);
+    auto error     = std::exception_ptr();
+    auto error_row = size_t(0);
+    auto mutex     = std::mutex();
+
+    run_workers(std::min<size_t>(threads, rows.size()), [&] {
+        for(auto i = next++; i < rows.size(); i = next++) {
+            try {
+                auto  var = fill_template(tmpl, columns, rows[i]);
+                auto& obj = var.get_object();
+                auto& trx = trxs[i];
+
+                trx = base;
+                if(obj.contains("payer")) {
+                    trx.payer = obj["payer"].as<address>();
+                }
+                FC_ASSERT(!payer.empty() || obj.contains("payer"), "Payer is not provided in template nor by option");
+                if(obj.contains("max_charge")) {
+                    trx.max_charge = obj["max_charge"].as<uint32_t>();
+                }
+                for(auto& act : obj["actions"].get_array()) {
+                    auto name = act["name"].as_string();
+                    auto type = exec_ctx.get_acttype_name((action_name)name);
+                    auto data = abi.variant_to_binary(type, act["data"], exec_ctx);
+                    trx.actions.emplace_back((action_name)name, (domain_name)act["domain"].as_string(), (domain_key)act["key"].as_string(), data);
+                }
+                for(auto& k : pkeys) {
+                    trx.sign(k, info.chain_id);
+                }
+            }
+            catch(...) {
+                auto lock = std::lock_guard<std::mutex>(mutex);
+                if(!error || i < error_row) {
+                    error     = std::current_exception();
+                    error_row = i;
+                }
+                next = rows.size();
+            }
+        }
+    });
+    if(error) {
+        std::cerr << localized("Failed to build the transaction of row ${r}", ("r", error_row + 1)) << std::endl;
+        std::rethrow_exception(error);
+    }
+
+    if(!sign_keys.empty()) {
+        auto keys = flat_set<public_key_type>();
+        for(auto& k : sign_keys) {
+            keys.emplace(get_public_key(k));
+        }
+        // all the transactions are signed by one call to wallet
+        auto sign_args = fc::variants{fc::variant(trxs), fc::variant(std::vector<flat_set<public_key_type>>(trxs.size(), keys)), fc::variant(info.chain_id)};
+        trxs = call(wallet_url, wallet_sign_trxs, sign_args).as<std::vector<signed_transaction>>();
+    }
+
+    auto out = std::ofstream(output_file, std::ios::out | std::ios::trunc);
+    FC_ASSERT(out, "Cannot open output file: ${f}", ("f", output_file));
+    for(auto& trx : trxs) {
+        out << fc::json::to_string(packed_transaction(trx, packed_transaction::none)) << "\n";
+    }
+    out.flush();
+    FC_ASSERT(out, "Write output file: ${f} failed", ("f", output_file));
+
+    std::cerr << localized("Built ${n} transactions into ${f}", ("n", trxs.size())("f", output_file)) << std::endl;
+}
+
 bool
 local_port_used() {
     using namespace boost::asio;
@@ -1744,12 +2026,24 @@ main(int argc, char** argv) {
     create->require_subcommand();
 
     // create key
-    auto create_key = create->add_subcommand("key", localized("Create a new keypair and print the public and private keys"))->callback([](){
-        auto pk    = private_key_type::generate();
-        auto privs = string(pk);
-        auto pubs  = string(pk.get_public_key());
-        std::cout << localized("Private key: ${key}", ("key", privs)) << std::endl;
-        std::cout << localized("Public key: ${key}",  ("key", pubs))  << std::endl;
+    uint32_t key_count = 1;
+
+    auto create_key = create->add_subcommand("key", localized("Create a new keypair and print the public and private keys"));
+    create_key->add_option("-n,--count", key_count, localized("Number of keypairs to create, keys created together are related and must have one owner"), true);
+    create_key->callback([&key_count] {
+        auto print = [](const auto& priv, const auto& pub) {
+            std::cout << localized("Private key: ${key}", ("key", string(priv))) << std::endl;
+            std::cout << localized("Public key: ${key}",  ("key", string(pub)))  << std::endl;
+        };
+
+        if(key_count <= 1) {
+            auto pk = private_key_type::generate();
+            print(pk, pk.get_public_key());
+            return;
+        }
+        for(auto& it : private_key_type::generate_batch(key_count)) {
+            print(it.first, it.second);
+        }
     });
 
     // Get subcommand
@@ -1766,6 +2060,11 @@ main(int argc, char** argv) {
         std::cout << call(get_db_info_func, fc::variant(), true).get_string() << std::endl;
     });
 
+    // get db metrics
+    get->add_subcommand("dbmetrics", localized("Get current metrics of underlying token database"))->callback([] {
+        std::cout << fc::json::to_pretty_string(call(get_db_metrics_func, fc::variant(), true)) << std::endl;
+    });
+
     // get actions
     get->add_subcommand("actions", localized("Get current actions"))->callback([] {
         std::cout << fc::json::to_pretty_string(call(get_evt_actions, fc::variant())) << std::endl;
@@ -2118,6 +2417,38 @@ main(int argc, char** argv) {
         }
     });
 
+    // batch subcommand
+    string         batch_template;
+    string         batch_csv;
+    string         batch_output;
+    vector<string> batch_private_keys;
+    vector<string> batch_sign_keys;
+    uint32_t       batch_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    auto batch = app.add_subcommand("batch", localized("Build and sign transactions from a template and a CSV of parameters"));
+    batch->add_option("template", batch_template, localized("The JSON file of transaction template, '${column}' in its strings are replaced by the fields of CSV"))->required();
+    batch->add_option("csv", batch_csv, localized("The CSV file of parameters, first line is the names of columns"))->required();
+    batch->add_option("output", batch_output, localized("The file to write the packed transactions to, one per line"))->required();
+    batch->add_option("-k,--private-key", batch_private_keys, localized("The private key to sign the transactions locally, repeat it to sign with multiple keys"));
+    batch->add_option("-s,--sign-key", batch_sign_keys, localized("The public key or key reference in wallet to sign the transactions, repeat it to sign with multiple keys"));
+    batch->add_option("-j,--threads", batch_threads, localized("Number of threads building the transactions"), true);
+    batch->add_option("-p,--payer", payer, localized("Payer address of the transactions if not provided by template"));
+    batch->add_option("-c,--max-charge", max_charge, localized("Max charge of the transactions if not provided by template"), true);
+
+    CLI::callback_t parse_batch_expiration = [](CLI::results_t res) -> bool {
+        if(res.size() == 0) {
+            return false;
+        }
+
+        tx_expiration = parse_time_span_str(res[0]);
+        return true;
+    };
+    batch->add_option("-x,--expiration", parse_batch_expiration, localized("Set the time string('1s','2m','3h','4d') before the transactions expire, defaults to 30s"));
+
+    batch->callback([&] {
+        build_batch_transactions(batch_template, batch_csv, batch_output, batch_private_keys, batch_sign_keys, batch_threads);
+    });
+
     // Push subcommand
     auto push = app.add_subcommand("push", localized("Push arbitrary transactions to the blockchain"));
     push->require_subcommand();
@@ -2156,6 +2487,15 @@ main(int argc, char** argv) {
         std::cout << fc::json::to_pretty_string(trxs_result) << std::endl;
     });
 
+    string   bulk_file;
+    uint32_t bulk_concurrency = 16;
+    auto     bulkSubcommand   = push->add_subcommand("bulk", localized("Push JSON transactions, signed or packed ones, from a file or stdin, one transaction per line"));
+    bulkSubcommand->add_option("file", bulk_file, localized("The file containing the transactions to push, '-' to read from stdin"))->required();
+    bulkSubcommand->add_option("-j,--concurrency", bulk_concurrency, localized("Number of requests in flight at the same time"), true);
+    bulkSubcommand->callback([&] {
+        push_bulk_transactions(bulk_file, bulk_concurrency);
+    });
+
     try {
         app.parse(argc, argv);
     }
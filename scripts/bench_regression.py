@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+
+import json
+import re
+import subprocess
+import sys
+import tempfile
+
+import click
+
+
+def green(text):
+    return click.style(text, fg='green')
+
+
+def red(text):
+    return click.style(text, fg='red')
+
+
+def load_suite(suite):
+    with open(suite, 'r') as f:
+        return json.load(f)
+
+
+def run_suite(bench, suite):
+    names = [b['name'] for b in suite['benchmarks']]
+    filter = '^({})$'.format('|'.join(re.escape(n) for n in names))
+
+    with tempfile.NamedTemporaryFile(suffix='.json') as out:
+        args = [bench,
+                '--benchmark_filter={}'.format(filter),
+                '--benchmark_min_time={}'.format(suite.get('min_time', 1.0)),
+                '--benchmark_repetitions={}'.format(suite.get('repetitions', 1)),
+                '--benchmark_report_aggregates_only=true',
+                '--benchmark_out_format=json',
+                '--benchmark_out={}'.format(out.name)]
+        click.echo('Running {} benchmarks of suite'.format(green(len(names))))
+        subprocess.run(args, check=True)
+
+        with open(out.name, 'r') as f:
+            return json.load(f)
+
+
+# ns of one time unit in google benchmark results
+time_units = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+
+def throughputs(results):
+    """
+    Throughput of each benchmark by name, uses the median when there are repetitions.
+    Items per second is used if the benchmark reports it, otherwise iterations per second.
+    """
+    r = {}
+    for b in results['benchmarks']:
+        if b.get('run_type') == 'aggregate' and b.get('aggregate_name') != 'median':
+            continue
+        name = b.get('run_name', re.sub('_median$', '', b['name']))
+        if 'items_per_second' in b:
+            r[name] = b['items_per_second']
+        else:
+            r[name] = 1e9 / (b['real_time'] * time_units[b.get('time_unit', 'ns')])
+    return r
+
+
+@click.group('cli')
+def cli():
+    pass
+
+
+@cli.command()
+@click.option('--bench', '-b', type=click.Path(exists=True), required=True, help='Path of evt_benchmarks')
+@click.option('--suite', '-s', type=click.Path(exists=True), required=True)
+@click.option('--baseline', '-o', type=click.Path(), required=True, help='File to write the baseline into')
+def record(bench, suite, baseline):
+    results = run_suite(bench, load_suite(suite))
+    with open(baseline, 'w') as f:
+        json.dump(results, f, indent=2)
+    click.echo('Baseline is written into {}'.format(green(baseline)))
+
+
+@cli.command()
+@click.option('--bench', '-b', type=click.Path(exists=True), help='Path of evt_benchmarks, not needed with --results')
+@click.option('--suite', '-s', type=click.Path(exists=True), required=True)
+@click.option('--baseline', '-l', type=click.Path(), required=True)
+@click.option('--results', '-r', type=click.Path(exists=True), help='Compare existing results instead of running the suite')
+@click.option('--output', '-o', type=click.Path(), help='File to write the results of this run into')
+@click.option('--threshold', '-t', type=float, help='Overrides the thresholds in suite, 0.1 for 10% slower')
+def compare(bench, suite, baseline, results, output, threshold):
+    try:
+        with open(baseline, 'r') as f:
+            base = throughputs(json.load(f))
+    except FileNotFoundError:
+        click.echo(red('Baseline {} is not found, record one by "record" command first'.format(baseline)))
+        sys.exit(2)
+
+    s = load_suite(suite)
+    if results is not None:
+        with open(results, 'r') as f:
+            current = json.load(f)
+    else:
+        if bench is None:
+            click.echo(red('Either --bench or --results should be provided'))
+            sys.exit(2)
+        current = run_suite(bench, s)
+    if output is not None:
+        with open(output, 'w') as f:
+            json.dump(current, f, indent=2)
+    curr = throughputs(current)
+
+    failed = 0
+    click.echo('{:<48}{:>16}{:>16}{:>10}'.format('benchmark', 'baseline/s', 'current/s', 'change'))
+    for b in s['benchmarks']:
+        name = b['name']
+        limit = threshold if threshold is not None else b.get('threshold', s.get('threshold', 0.1))
+
+        if name not in curr:
+            click.echo('{:<48}{}'.format(name, red('not run')))
+            failed += 1
+            continue
+        if name not in base:
+            click.echo('{:<48}{:>16}{:>16.0f}'.format(name, 'n/a', curr[name]))
+            continue
+
+        change = curr[name] / base[name] - 1
+        text = '{:>+9.1f}%'.format(change * 100)
+        if change < -limit:
+            text = red(text)
+            failed += 1
+        else:
+            text = green(text)
+        click.echo('{:<48}{:>16.0f}{:>16.0f}{}'.format(name, base[name], curr[name], text))
+
+    if failed > 0:
+        click.echo(red('{} benchmarks regressed or not run'.format(failed)))
+        sys.exit(1)
+    click.echo(green('No regression'))
+
+
+if __name__ == '__main__':
+    cli()
@@ -144,7 +144,7 @@ def get_action_from_abi_json(action, abi_json, domain=None, key=None):
     libevt.init_lib()
     abi_dict = json.loads(abi_json)
     try:
-        _bin = abi.json_to_bin(action, abi_json).to_hex_string()
+        _bin = abi.json_to_bin_bytes(action, abi_json).hex()
     except:
         raise Exception('Invalid abi json', action, abi_json)
 
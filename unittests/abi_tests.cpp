@@ -11,6 +11,7 @@
 #include <fc/variant.hpp>
 
 #include <evt/chain/execution_context_impl.hpp>
+#include <evt/chain/trace.hpp>
 #include <evt/chain/contracts/abi_serializer.hpp>
 #include <evt/chain/contracts/evt_contract_abi.hpp>
 #include <evt/chain/contracts/types.hpp>
@@ -164,6 +165,109 @@ TEST_CASE_METHOD(abi_test, "optional_abi_test", "[abis]") {
     CHECK(fc::to_hex(bytes2) == fc::to_hex(bytes22));
 }
 
+TEST_CASE_METHOD(abi_test, "typedef_recursive_abi_test", "[abis]") {
+    auto abi = abi_def();
+    abi.types.emplace_back(type_def{"node_name", "string"});
+    abi.types.emplace_back(type_def{"nodes", "node[]"});
+    abi.structs.emplace_back(struct_def{
+        "node", "", {{"name", "node_name"}, {"children", "nodes"}, {"weight", "uint32?"}}});
+
+    auto abis = abi_serializer(abi, std::chrono::hours(1));
+
+    auto json = R"( { "name": "root", "children": [ { "name": "a", "children": [] }, { "name": "b", "children": [], "weight": 2 } ] } )";
+    auto var  = fc::json::from_string(json);
+
+    auto var2 = verify_byte_round_trip_conversion(abis, "node", var);
+    CHECK(var2["children"].get_array().size() == 2);
+    CHECK(var2["children"].get_array()[0]["weight"].is_null());
+    CHECK(var2["children"].get_array()[1]["weight"].as_uint64() == 2);
+
+    // typedef and array of struct resolve to the same plans
+    auto bytes1 = abis.variant_to_binary("nodes", var["children"], get_exec_ctx());
+    auto bytes2 = abis.variant_to_binary("node[]", var["children"], get_exec_ctx());
+    CHECK(fc::to_hex(bytes1) == fc::to_hex(bytes2));
+
+    CHECK_THROWS_AS(abis.variant_to_binary("leaf", var, get_exec_ctx()), unknown_abi_type_exception);
+}
+
+TEST_CASE_METHOD(abi_test, "binary_to_json_abi_test", "[abis]") {
+    auto abi = abi_def();
+    abi.types.emplace_back(type_def{"nodes", "node[]"});
+    abi.enums.emplace_back(enum_def{"color", "uint8", {"red", "green"}});
+    abi.structs.emplace_back(struct_def{
+        "base", "", {{"id", "uint64"}, {"owner", "name"}}});
+    abi.structs.emplace_back(struct_def{
+        "node", "base", {{"name", "string"}, {"color", "color"}, {"keys", "public_key[]"}, {"weight", "int32?"}, {"children", "nodes"}}});
+
+    auto abis = abi_serializer(abi, std::chrono::hours(1));
+
+    auto json = R"( { "id": 18446744073709551615, "owner": "evt", "name": "ro\"ot", "color": "green", "keys": [], "children": [
+        { "id": 1, "owner": "a", "name": "", "color": "red", "keys": ["EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK"], "weight": -2, "children": [] } ] } )";
+    auto var   = fc::json::from_string(json);
+    auto bytes = abis.variant_to_binary("node", var, get_exec_ctx());
+
+    auto str = abis.binary_to_json("node", bytes, get_exec_ctx());
+    CHECK(str == fc::json::to_string(abis.binary_to_variant("node", bytes, get_exec_ctx())));
+
+    bytes.emplace_back(0);
+    CHECK_THROWS_AS(abis.binary_to_json("node", bytes, get_exec_ctx()), unpack_exception);
+}
+
+TEST_CASE_METHOD(abi_test, "json_to_binary_abi_test", "[abis]") {
+    auto& abis = get_evt_abi();
+
+    auto json = R"( {
+        "name": "cookie",
+        "creator": "EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK",
+        "issue": { "name": "issue", "threshold": 1, "authorizers": [ { "ref": "[A] EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK", "weight": 1 } ] },
+        "transfer": { "name": "transfer", "threshold": 1, "authorizers": [ { "ref": "[G] .OWNER", "weight": 1 } ] },
+        "manage": { "name": "manage", "threshold": 1, "authorizers": [ { "ref": "[A] EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK", "weight": 1 } ] }
+    } )";
+
+    auto bytes = abis.variant_to_binary("newdomain", fc::json::from_string(json), get_exec_ctx());
+    CHECK(fc::to_hex(abis.json_to_binary("newdomain", json, get_exec_ctx())) == fc::to_hex(bytes));
+
+    // data of action can be object
+    auto act_json = std::string(R"( { "name": "newdomain", "domain": "cookie", "key": ".create", "data": )") + json + " }";
+    auto act_bytes = abis.json_to_binary("action", act_json, get_exec_ctx());
+
+    auto act = fc::raw::unpack<action>(act_bytes);
+    CHECK(act.name == N(newdomain));
+    CHECK(fc::to_hex(act.data) == fc::to_hex(bytes));
+    // data is packed in place, nothing is left after it
+    CHECK(fc::to_hex(fc::raw::pack(act)) == fc::to_hex(act_bytes));
+
+    CHECK_THROWS_AS(abis.json_to_binary("newdomain", "{ \"name\": ", get_exec_ctx()), pack_exception);
+    CHECK_THROWS_AS(abis.json_to_binary("newdomain", "{ \"name\": \"cookie\" }", get_exec_ctx()), pack_exception);
+}
+
+TEST_CASE_METHOD(abi_test, "trace_data_json_test", "[abis]") {
+    auto& abis = get_evt_abi();
+
+    auto json = R"( {
+        "name": "cookie",
+        "creator": "EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK",
+        "issue": { "name": "issue", "threshold": 1, "authorizers": [ { "ref": "[A] EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK", "weight": 1 } ] },
+        "transfer": { "name": "transfer", "threshold": 1, "authorizers": [ { "ref": "[G] .OWNER", "weight": 1 } ] },
+        "manage": { "name": "manage", "threshold": 1, "authorizers": [ { "ref": "[A] EVT546WaW3zFAxEEEkYKjDiMvg3CHRjmWX2XdNxEhi69RpdKuQRSK", "weight": 1 } ] }
+    } )";
+
+    auto trace     = action_trace();
+    trace.act.name = N(newdomain);
+    trace.act.data = abis.variant_to_binary("newdomain", fc::json::from_string(json), get_exec_ctx());
+
+    auto& data = trace.data_json(abis, get_exec_ctx());
+    CHECK(data == fc::json::to_string(abis.binary_to_variant("newdomain", trace.act.data, get_exec_ctx())));
+
+    // converted only once, copies of trace share it
+    auto copy = trace;
+    CHECK(&copy.data_json(abis, get_exec_ctx()) == &data);
+
+    auto bad     = action_trace();
+    bad.act.name = N(newdomain);
+    CHECK_THROWS(bad.data_json(abis, get_exec_ctx()));
+}
+
 TEST_CASE_METHOD(abi_test, "newdomain_abi_test", "[abis]") {
     auto& abis = get_evt_abi();
 
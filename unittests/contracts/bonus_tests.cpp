@@ -224,6 +224,14 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_fees_test", "[contracts]") {
     // fees: 0.15 * 1000 = 15, actual: 1000
     my_tester->push_action(action(N128(.fungible), actkey, tf), key_seeds, payer);
 
+    {
+        // bonus is accrued and only folded into collection address when block is finalized
+        property bonus;
+        READ_DB_ASSET(bonus_addr, get_sym(), bonus);
+        CHECK(bonus.amount == 0);
+    }
+    my_tester->produce_block();
+
     {
         property bonus, to, from;
         READ_DB_ASSET(bonus_addr, get_sym(), bonus);
@@ -241,6 +249,7 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_fees_test", "[contracts]") {
     tf.number = asset(1'00000, get_sym());
     // fees: 0.15 * 1'00000 = '15000, actual: '15010
     my_tester->push_action(action(N128(.fungible), actkey, tf), key_seeds, payer);
+    my_tester->produce_block();
 
     {
         property bonus, to, from;
@@ -259,6 +268,7 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_fees_test", "[contracts]") {
     tf.number = asset(2'00000, get_sym());
     // fees: 0.15 * 2'00000 = '30000, actual: '20000
     my_tester->push_action(action(N128(.fungible), actkey, tf), key_seeds, payer);
+    my_tester->produce_block();
 
     {
         property bonus, to, from;
@@ -300,6 +310,7 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_fees_test", "[contracts]") {
     ep.number = asset(1'00000, get_sym());
     // fees: 0.15 * 1'00000 = '15000, actual: '15010
     my_tester->push_action(action(N128(.fungible), actkey, ep), key_seeds, payer);
+    my_tester->produce_block();
 
     {
         property bonus, to, from;
@@ -374,6 +385,14 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_test", "[contracts]") {
         CHECK(bonus.amount == 1000 + 15010 + 20000 + 15010 + 20000 * 300);
     }
 
+    // charge of it is accrued to producer within the same block as the dist below
+    auto tfe   = transferft();
+    tfe.from   = payer;
+    tfe.to     = poorer;
+    tfe.number = asset(1'00000, evt_sym());
+    my_tester->push_action(action(N128(.fungible), name128::from_number(EVT_SYM_ID), tfe), key_seeds, payer);
+    CHECK(my_tester->control->pending_charge_accruals().pending(EVT_SYM_ID) > 0);
+
     my_tester->push_action(action(N128(.psvbonus), actkey, dpb), keyseeds, payer);
 
     {
@@ -388,10 +407,48 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_test", "[contracts]") {
         CHECK(bonus.amount == 1000 + 15010 + 20000 + 15010 + 20000 * 300);
     }
 
-    CHECK(tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 1)));
+    // dists of the sharded layout are stored with the flag of it in their keys
+    CHECK(!tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 1)));
+    CHECK(tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 1 | (1ul << 63))));
+    // holders of the first ftholders rule are stored in one shard apart from the dist
+    CHECK(tokendb.exists_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 1 | (1ul << 40))));
 
     my_tester->produce_block();
 
+    {
+        // charges only move EVT from payers to producer, so the total of EVT holders in the dist
+        // is the same as the one after all the charges of block are credited
+        auto total = (int64_t)0;
+        tokendb.read_assets_holders(EVT_SYM_ID, [&](auto& k, auto&& v) {
+            property prop;
+            extract_db_value(v, prop);
+            total += prop.amount;
+            return true;
+        });
+
+        auto str = std::string();
+        tokendb.read_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(get_sym_id(), 1 | (1ul << 63)), str);
+
+        // created_at, created_index, then summary of the first holder dist, which is of EVT
+        auto ds            = fc::datastream<const char*>(str.data(), str.size());
+        auto created_at    = uint32_t();
+        auto created_index = uint32_t();
+        auto size          = fc::unsigned_int();
+        auto dist_sym_id   = symbol_id_type();
+        auto shard_bits    = uint32_t();
+        auto dist_total    = int64_t();
+        fc::raw::unpack(ds, created_at);
+        fc::raw::unpack(ds, created_index);
+        fc::raw::unpack(ds, size);
+        fc::raw::unpack(ds, dist_sym_id);
+        fc::raw::unpack(ds, shard_bits);
+        fc::raw::unpack(ds, dist_total);
+
+        CHECK(size.value == 2);
+        CHECK(dist_sym_id == EVT_SYM_ID);
+        CHECK(dist_total == total);
+    }
+
     auto pb = passive_bonus();
     READ_TOKEN2(token, N128(.psvbonus), get_psvbonus_db_key(get_sym_id(), kPsvBonus), pb);
 
@@ -407,4 +464,102 @@ TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_test", "[contracts]") {
     CHECK(pb.methods.size() == pb2->methods.size());
     CHECK(pb.round == pb2->round);
     CHECK(pb.deadline == pb2->deadline);
-}
\ No newline at end of file
+}
+TEST_CASE_METHOD(contracts_test, "passive_bonus_dist_pending_test", "[contracts]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    // fungible whose holders' rule is of the fungible with passive bonus above
+    auto bsym    = symbol(5, get_sym_id(10));
+    auto bactkey = name128::from_number(bsym.id());
+
+    auto var = fc::json::from_string(R"=====(
+    {
+      "name": "PSVDIST",
+      "sym_name": "PSVDIST",
+      "sym": "5,S#13",
+      "creator": "EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV",
+      "issue" : { "name" : "issue", "threshold" : 1, "authorizers": [] },
+      "manage": { "name": "manage", "threshold": 1, "authorizers": [] },
+      "total_supply":"10000.00000 S#13"
+    }
+    )=====");
+
+    auto newfg    = var.as<newfungible>();
+    newfg.creator = key;
+    newfg.issue.authorizers.emplace_back(authorizer_weight(authorizer_ref(key), 1));
+    newfg.manage.authorizers.emplace_back(authorizer_weight(authorizer_ref(key), 1));
+
+    auto fungible_payer = address(N(.domain), ".fungible", 0);
+    my_tester->add_money(fungible_payer, asset(10'000'000, evt_sym()));
+    my_tester->push_action(action(N128(.fungible), bactkey, newfg), key_seeds, fungible_payer);
+
+    auto issfg    = issuefungible();
+    issfg.address = key;
+    issfg.number  = asset(5000'00000, bsym);
+    my_tester->push_action(action(N128(.fungible), bactkey, issfg), key_seeds, payer);
+
+    auto rule     = dist_rpercent_rule();
+    rule.receiver = dist_stack_receiver(asset(0, get_sym()));
+    rule.percent  = percent_type("1");
+
+    auto spb           = setpsvbonus();
+    spb.sym            = bsym;
+    spb.rate           = percent_type("0.15");
+    spb.base_charge    = asset(0, bsym);
+    spb.dist_threshold = asset(1'00000, bsym);
+    spb.rules.emplace_back(rule);
+    spb.methods.emplace_back(passive_method{name("transferft"), passive_method_type::outside_amount});
+    my_tester->push_action(action(N128(.bonus), bactkey, spb), key_seeds, payer);
+
+    // bonus: 0.15 * 10 = 1.5 and reaches the dist threshold
+    auto tfb   = transferft();
+    tfb.from   = key;
+    tfb.to     = tester::get_public_key(N(to3));
+    tfb.number = asset(10'00000, bsym);
+    my_tester->push_action(action(N128(.fungible), bactkey, tfb), key_seeds, payer);
+    my_tester->produce_block();
+
+    // bonus of the holders' symbol is accrued within the same block as the dist below
+    auto tf   = transferft();
+    tf.from   = key;
+    tf.to     = tester::get_public_key(N(to3));
+    tf.number = asset(2'00000, get_sym());
+    my_tester->push_action(action(N128(.fungible), name128::from_number(get_sym_id()), tf), key_seeds, payer);
+    CHECK(my_tester->control->pending_bonus_accruals().pending(get_sym_id()) > 0);
+
+    auto dpb     = distpsvbonus();
+    dpb.sym_id   = bsym.id();
+    dpb.deadline = my_tester->control->head_block_time();
+    my_tester->push_action(action(N128(.psvbonus), bactkey, dpb), key_seeds, payer);
+    my_tester->produce_block();
+
+    // accruals are folded when block is finalized, so holders after it are the ones of the dist
+    auto total = (int64_t)0;
+    tokendb.read_assets_holders(get_sym_id(), [&](auto& k, auto&& v) {
+        property prop;
+        extract_db_value(v, prop);
+        total += prop.amount;
+        return true;
+    });
+
+    auto str = std::string();
+    tokendb.read_token(token_type::psvbonus_dist, std::nullopt, get_psvbonus_db_key(bsym.id(), 1 | (1ul << 63)), str);
+
+    auto ds            = fc::datastream<const char*>(str.data(), str.size());
+    auto created_at    = uint32_t();
+    auto created_index = uint32_t();
+    auto size          = fc::unsigned_int();
+    auto dist_sym_id   = symbol_id_type();
+    auto shard_bits    = uint32_t();
+    auto dist_total    = int64_t();
+    fc::raw::unpack(ds, created_at);
+    fc::raw::unpack(ds, created_index);
+    fc::raw::unpack(ds, size);
+    fc::raw::unpack(ds, dist_sym_id);
+    fc::raw::unpack(ds, shard_bits);
+    fc::raw::unpack(ds, dist_total);
+
+    CHECK(size.value == 1);
+    CHECK(dist_sym_id == get_sym_id());
+    CHECK(dist_total == total);
+}
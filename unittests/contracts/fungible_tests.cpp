@@ -620,3 +620,57 @@ TEST_CASE_METHOD(contracts_test, "group_addr_test", "[contracts]") {
     // enough authorizers
     CHECK_NOTHROW(my_tester->push_action(action(".fungible", "1", tf), { N(gkey1), N(gkey2), N(gkey3), N(payer) }, payer));
 }
+
+TEST_CASE_METHOD(contracts_test, "batchtransft_test", "[contracts]") {
+    auto sym = symbol(5, get_sym_id());
+    auto to1 = address(tester::get_public_key(N(bto1)));
+    auto to2 = address(tester::get_public_key(N(bto2)));
+
+    auto bt = batchtransft();
+    bt.from = key;
+    bt.memo = "memo";
+
+    auto push = [&](auto& act) {
+        my_tester->push_action(action(N128(.fungible), name128::from_number(get_sym_id()), act), key_seeds, payer);
+    };
+
+    // empty credits
+    CHECK_THROWS_AS(push(bt), batch_empty_exception);
+
+    // duplicate receivers
+    bt.credits.emplace_back(ft_credit { to1, asset(1'00000, sym) });
+    bt.credits.emplace_back(ft_credit { to1, asset(2'00000, sym) });
+    CHECK_THROWS_AS(push(bt), fungible_address_exception);
+
+    // mixed symbols
+    bt.credits[1] = ft_credit { to2, asset(2'00000, evt_sym()) };
+    CHECK_THROWS_AS(push(bt), asset_symbol_exception);
+
+    // reserved and self receivers
+    bt.credits[1] = ft_credit { address(), asset(2'00000, sym) };
+    CHECK_THROWS_AS(push(bt), address_reserved_exception);
+    bt.credits[1] = ft_credit { key, asset(2'00000, sym) };
+    CHECK_THROWS_AS(push(bt), fungible_address_exception);
+
+    // more than balance
+    bt.credits[1] = ft_credit { to2, asset(asset::max_amount, sym) };
+    CHECK_THROWS_AS(push(bt), balance_exception);
+
+    auto& tokendb = my_tester->control->token_db();
+
+    property from_before;
+    READ_DB_ASSET(key, sym, from_before);
+
+    bt.credits[1] = ft_credit { to2, asset(2'00000, sym) };
+    CHECK_NOTHROW(push(bt));
+
+    property from_after, ast1, ast2;
+    READ_DB_ASSET(key, sym, from_after);
+    READ_DB_ASSET(to1, sym, ast1);
+    READ_DB_ASSET(to2, sym, ast2);
+    CHECK(3'00000 == from_before.amount - from_after.amount);
+    CHECK(1'00000 == ast1.amount);
+    CHECK(2'00000 == ast2.amount);
+
+    my_tester->produce_blocks();
+}
@@ -0,0 +1,222 @@
+#include <catch/catch.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <evt/chain/bonus_accruals.hpp>
+#include <evt/chain/controller.hpp>
+#include <evt/chain/deadline_timer.hpp>
+#include <evt/chain/state_layout_object.hpp>
+#include <evt/chain/token_database.hpp>
+#include <evt/chain/transaction_context.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+#include <evt/chain/contracts/types.hpp>
+#include <evt/testing/tester.hpp>
+
+using namespace evt;
+using namespace chain;
+using namespace contracts;
+using namespace testing;
+
+namespace {
+
+int64_t
+evt_balance(tester& t, const address& addr) {
+    auto str = std::string();
+    if(!t.control->token_db().read_asset(addr, EVT_SYM_ID, str, true /* no throw */)) {
+        return 0;
+    }
+    auto prop = property();
+    extract_db_value(str, prop);
+    return prop.amount;
+}
+
+transaction_trace_ptr
+transfer_evt(tester& t, const address& from, const address& to, int64_t amount, name auth) {
+    auto tf   = transferft();
+    tf.from   = from;
+    tf.to     = to;
+    tf.number = asset(amount, evt_sym());
+    tf.memo   = "charge";
+    return t.push_action(action(".fungible", "1", tf), { auth }, from);
+}
+
+action
+transfer_evt_action(const address& from, const address& to, int64_t amount) {
+    auto tf   = transferft();
+    tf.from   = from;
+    tf.to     = to;
+    tf.number = asset(amount, evt_sym());
+    tf.memo   = "deadline";
+    return action(".fungible", "1", tf);
+}
+
+bool
+wait_expired(const deadline_timer& timer) {
+    for(auto i = 0; i < 200 && !timer.expired(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return timer.expired();
+}
+
+}  // namespace
+
+TEST_CASE("state_layout_test", "[controller]") {
+    auto t = tester();
+    t.produce_block();
+
+    auto& db = t.control->db();
+    REQUIRE(db.find<state_layout_object>() != nullptr);
+    CHECK(db.find<state_layout_object>()->version == state_layout_object::current_version);
+
+    // state written before the layout is recorded is refused
+    t.control->abort_block();
+    db.remove(*db.find<state_layout_object>());
+    t.close();
+    CHECK_THROWS_AS(t.open(nullptr), state_layout_exception);
+}
+
+TEST_CASE("charge_accruals_test", "[controller]") {
+    auto t     = tester();
+    auto prod  = address(tester::get_public_key("evt"));
+    auto payer = address(tester::get_public_key(N(payer)));
+    auto to    = address(tester::get_public_key(N(to)));
+    t.add_money(payer, asset(1'000'000'00000, evt_sym()));
+    t.produce_block();
+
+    auto before = evt_balance(t, prod);
+    auto sum    = int64_t(0);
+    for(int i = 0; i < 3; i++) {
+        sum += transfer_evt(t, payer, to, 1'00000, N(payer))->charge;
+    }
+    CHECK(sum > 0);
+
+    // charges are only accrued in pending block, producer is credited once it's finalized
+    CHECK(t.control->pending_charge_collector() == prod);
+    CHECK(t.control->pending_charge_accruals().pending(EVT_SYM_ID) == sum);
+    CHECK(evt_balance(t, prod) == before);
+
+    t.produce_block();
+    CHECK(evt_balance(t, prod) == before + sum);
+}
+
+TEST_CASE("charge_accruals_collector_pays_test", "[controller]") {
+    auto t     = tester();
+    auto prod  = address(tester::get_public_key("evt"));
+    auto payer = address(tester::get_public_key(N(payer)));
+    auto to    = address(tester::get_public_key(N(to)));
+    t.add_money(payer, asset(1'000'000'00000, evt_sym()));
+    t.produce_block();
+    REQUIRE(evt_balance(t, prod) == 0);
+
+    auto sum = int64_t(0);
+    for(int i = 0; i < 3; i++) {
+        sum += transfer_evt(t, payer, to, 1'00000, N(payer))->charge;
+    }
+    REQUIRE(evt_balance(t, prod) == 0);
+
+    // producer only owns the charges accrued in this block, they're counted when it pays and spends
+    auto amount = sum / 3;
+    auto trace  = transfer_evt(t, prod, to, amount, "evt");
+    CHECK(trace->charge > 0);
+    CHECK(t.control->pending_charge_accruals().pending(EVT_SYM_ID) == trace->charge);
+
+    // the charge producer paid is credited back to itself
+    t.produce_block();
+    CHECK(evt_balance(t, prod) == sum - amount);
+}
+
+TEST_CASE("charge_accruals_undo_test", "[controller]") {
+    auto t     = tester();
+    auto prod  = address(tester::get_public_key("evt"));
+    auto payer = address(tester::get_public_key(N(payer)));
+    auto to    = address(tester::get_public_key(N(to)));
+    t.add_money(payer, asset(1'000'000'00000, evt_sym()));
+    t.produce_block();
+
+    auto charge = transfer_evt(t, payer, to, 1'00000, N(payer))->charge;
+    REQUIRE(t.control->pending_charge_accruals().pending(EVT_SYM_ID) == charge);
+
+    // failed transaction undoes its session of charges
+    CHECK_THROWS_AS(transfer_evt(t, payer, to, asset::max_amount, N(payer)), balance_exception);
+    CHECK(t.control->pending_charge_accruals().pending(EVT_SYM_ID) == charge);
+
+    // charges of the aborted block are dropped along with its transactions
+    t.control->abort_block();
+    t.produce_empty_block();
+    CHECK(evt_balance(t, prod) == 0);
+
+    t.produce_block();
+    CHECK(evt_balance(t, prod) == charge);
+}
+
+TEST_CASE("deadline_timer_scope_test", "[controller]") {
+    deadline_timer timer;
+    CHECK(!timer.expired());
+
+    auto outer = fc::time_point::now() + fc::hours(1);
+    {
+        auto s1 = deadline_timer::scope(timer, outer);
+        {
+            // nested scope, like a suspend executed within a transaction
+            auto s2 = deadline_timer::scope(timer, fc::time_point::now() + fc::milliseconds(10));
+            REQUIRE(wait_expired(timer));
+        }
+        // outer deadline is armed again and not passed yet
+        CHECK(!timer.expired());
+        CHECK(timer.arm(outer) == outer);
+    }
+    CHECK(timer.arm(fc::time_point::maximum()) == fc::time_point::maximum());
+}
+
+TEST_CASE("deadline_expired_init_test", "[controller]") {
+    auto t     = tester();
+    auto payer = address(tester::get_public_key(N(payer)));
+    auto to    = address(tester::get_public_key(N(to)));
+    t.add_money(payer, asset(1'000'000'00000, evt_sym()));
+    t.produce_block();
+
+    auto trx = signed_transaction();
+    trx.actions.emplace_back(transfer_evt_action(payer, to, 1'00000));
+    t.set_transaction_headers(trx, payer);
+    trx.sign(tester::get_private_key(N(payer)), t.control->get_chain_id());
+
+    CHECK_THROWS_AS(t.push_transaction(trx, fc::time_point::now() - fc::milliseconds(1)), deadline_exception);
+    CHECK(evt_balance(t, to) == 0);
+
+    // deadline timer is disarmed after the failed transaction
+    CHECK(!t.control->get_deadline_timer().expired());
+    t.push_transaction(trx);
+    CHECK(evt_balance(t, to) == 1'00000);
+}
+
+TEST_CASE("deadline_within_transaction_test", "[controller]") {
+    auto t     = tester();
+    auto payer = address(tester::get_public_key(N(payer)));
+    auto to    = address(tester::get_public_key(N(to)));
+    t.add_money(payer, asset(1'000'000'00000, evt_sym()));
+    t.produce_block();
+
+    auto trx = signed_transaction();
+    trx.actions.emplace_back(transfer_evt_action(payer, to, 1'00000));
+    trx.actions.emplace_back(transfer_evt_action(payer, to, 2'00000));
+    t.set_transaction_headers(trx, payer);
+    trx.sign(tester::get_private_key(N(payer)), t.control->get_chain_id());
+
+    auto& timer = t.control->get_deadline_timer();
+    auto& exec  = static_cast<evt_execution_context&>(t.control->get_execution_context());
+    auto  mtrx  = std::make_shared<transaction_metadata>(trx, packed_transaction::none);
+    {
+        auto trx_context     = transaction_context(*t.control, exec, mtrx);
+        trx_context.deadline = fc::time_point::now() + fc::milliseconds(100);
+        trx_context.init_for_input_trx(false);
+
+        // deadline passes after the transaction is started and fails it at the next action
+        REQUIRE(wait_expired(timer));
+        CHECK_THROWS_AS(trx_context.exec(), deadline_exception);
+        CHECK(trx_context.trace->action_traces.size() == 1);
+    }
+    // deadline of the destroyed transaction is not armed anymore
+    CHECK(!timer.expired());
+    CHECK(evt_balance(t, to) == 0);
+}
@@ -1,8 +1,10 @@
 #include <sstream>
 
 #include <catch/catch.hpp>
+#include <fmt/format.h>
 #include <fc/filesystem.hpp>
 
+#include <evt/chain/block_state.hpp>
 #include <evt/chain/token_database.hpp>
 #include <evt/chain/token_database_snapshot.hpp>
 #include <evt/chain/contracts/types.hpp>
@@ -89,9 +91,25 @@ TEST_CASE("snapshot_save_test", "[snapshot]") {
     PUT_DB_TOKEN(domain, std::nullopt, d.name, d);
 
     token_database_snapshot::add_to_snapshot(writer, tokendb);
+    writer->finalize();
     token_db_snapshot_ = ss.str();
 }
 
+TEST_CASE("snapshot_parallel_test", "[snapshot]") {
+    auto tokendb = token_database(get_db_config());
+    tokendb.open();
+
+    auto ss1 = std::stringstream();
+    auto ss2 = std::stringstream();
+
+    // sections are written in the same order whatever number of threads is used
+    auto h1 = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss1), tokendb, 1);
+    auto h2 = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss2), tokendb, 4);
+
+    CHECK(h1 == h2);
+    CHECK(ss1.str() == ss2.str());
+}
+
 TEST_CASE("snapshot_load_test", "[snapshot]") {
     auto tokendb = token_database(get_db_config());
     tokendb.open();
@@ -113,3 +131,230 @@ TEST_CASE("snapshot_load_test", "[snapshot]") {
     CHECK(EXISTS_ASSET(addr, 3));
     CHECK(EXISTS_TOKEN(domain, "snapshot-domain"));
 }
+
+TEST_CASE("snapshot_ingest_test", "[snapshot]") {
+    auto tokendb = token_database(get_db_config());
+    tokendb.open();
+
+    auto ss1 = std::stringstream();
+    auto h1  = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss1), tokendb);
+
+    // restore by ingesting sst files, database should be the same as before
+    auto is     = std::stringstream(ss1.str());
+    auto reader = std::make_shared<istream_snapshot_reader>(is);
+    token_database_snapshot::read_from_snapshot(reader, tokendb, true);
+
+    REQUIRE(tokendb.savepoints_size() == 0);
+    CHECK(EXISTS_TOKEN(domain, "snapshot-domain"));
+    CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-1"));
+
+    auto addr = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    CHECK(EXISTS_ASSET(addr, 3));
+
+    auto ss2 = std::stringstream();
+    auto h2  = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss2), tokendb);
+    CHECK(h1 == h2);
+}
+
+TEST_CASE("snapshot_sections_test", "[snapshot]") {
+    auto ss = std::stringstream();
+    {
+        auto writer = ostream_snapshot_writer(ss);
+        for(auto i = 0; i < 3; i++) {
+            writer.write_section(fmt::format("section-{}", i), [&](auto& section) {
+                // the last one is empty
+                for(auto j = 0; j < (i == 2 ? 0 : 10000); j++) {
+                    auto row = fmt::format("{:08}", i * 10000 + j);
+                    section.add_row(row.data(), row.size());
+                }
+            });
+        }
+        writer.finalize();
+    }
+
+    // sections are found from directory and read in any order
+    auto reader = istream_snapshot_reader(ss);
+    reader.validate();
+    CHECK(reader.get_section_names("section-").size() == 3);
+
+    for(auto i : { 1, 0, 2 }) {
+        auto n = 0;
+        reader.read_section(fmt::format("section-{}", i), [&](auto& section) {
+            char row[8];
+            while(!section.empty() && !section.eof()) {
+                section.read_row(row, sizeof(row));
+                CHECK(std::string(row, sizeof(row)) == fmt::format("{:08}", i * 10000 + n));
+                n++;
+            }
+        });
+        CHECK(n == (i == 2 ? 0 : 10000));
+    }
+}
+
+TEST_CASE("snapshot_raw_section_test", "[snapshot]") {
+    auto ss1 = std::stringstream();
+    {
+        auto writer = ostream_snapshot_writer(ss1);
+        writer.write_section("section", [&](auto& section) {
+            for(auto i = 0; i < 1000; i++) {
+                section.add_row(fmt::format("row-{}", i));
+            }
+        });
+        writer.write_section("empty", [&](auto&) {});
+        writer.finalize();
+    }
+
+    // sections copied without decoding are the same as before
+    auto ss2 = std::stringstream();
+    {
+        auto reader = istream_snapshot_reader(ss1);
+        auto writer = ostream_snapshot_writer(ss2);
+        for(auto& name : reader.get_section_names("")) {
+            auto data = std::string();
+            auto rows = reader.read_raw_section(name, data);
+            writer.write_raw_section(name, data, rows);
+        }
+        writer.finalize();
+    }
+
+    auto reader = istream_snapshot_reader(ss2);
+    reader.validate();
+    auto n = 0;
+    reader.read_section("section", [&](auto& section) {
+        while(!section.eof()) {
+            auto row = std::string();
+            section.read_row(row);
+            CHECK(row == fmt::format("row-{}", n));
+            n++;
+        }
+    });
+    CHECK(n == 1000);
+    reader.read_section("empty", [&](auto& section) {
+        CHECK(section.empty());
+    });
+}
+
+TEST_CASE("snapshot_rebase_test", "[snapshot]") {
+    auto make_config = [](auto name) {
+        auto c    = token_database::config();
+        c.db_path = evt_unittests_dir + "/tokendb_tests/" + name;
+        if(fc::exists(c.db_path)) {
+            fc::remove_all(c.db_path);
+        }
+        return c;
+    };
+    auto write_head = [](auto& writer, auto& id) {
+        auto bs = block_header_state();
+        bs.id   = id;
+        writer->template write_section<block_state>([&](auto& section) {
+            section.add_row(bs);
+        });
+    };
+
+    auto tokendb = token_database(make_config("rebase"));
+    tokendb.open();
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-rebase-1), "v1");
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-rebase-2), "v1");
+    // assets are only written for the symbols in fungible section
+    tokendb.put_token(token_type::fungible, action_op::add, std::nullopt, name128(1), "f");
+
+    auto base_id = fc::sha256::hash(std::string("base"));
+    auto head_id = fc::sha256::hash(std::string("head"));
+
+    auto base_ss = std::stringstream();
+    {
+        auto writer = std::make_shared<ostream_snapshot_writer>(base_ss);
+        write_head(writer, base_id);
+        token_database_snapshot::add_to_snapshot(writer, tokendb);
+        writer->finalize();
+    }
+
+    // incremental one only has the rows changed in savepoint
+    tokendb.add_savepoint(1);
+    tokendb.put_token(token_type::domain, action_op::update, std::nullopt, N128(dm-rebase-1), "v2");
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-rebase-3), "v2");
+    auto addr = address(public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX")));
+    tokendb.put_asset(addr, 1, "a");
+
+    auto incr_ss = std::stringstream();
+    {
+        auto writer = std::make_shared<ostream_snapshot_writer>(incr_ss);
+        write_head(writer, head_id);
+        token_database_snapshot::add_deltas_to_snapshot(writer, base_id, tokendb.latest_savepoint_deltas());
+        writer->finalize();
+    }
+
+    auto incr = std::make_shared<istream_snapshot_reader>(incr_ss);
+    auto base = std::make_shared<istream_snapshot_reader>(base_ss);
+    CHECK(token_database_snapshot::read_delta_base(incr) == base_id);
+    CHECK(!token_database_snapshot::read_delta_base(base).has_value());
+    CHECK_THROWS_AS(token_database_snapshot::read_from_snapshot(incr, tokendb), token_database_snapshot_exception);
+
+    auto out_ss = std::stringstream();
+    {
+        auto db = token_database(make_config("rebase-tmp"));
+        db.open();
+
+        auto writer = std::make_shared<ostream_snapshot_writer>(out_ss);
+        token_database_snapshot::rebase_snapshot(base, incr, writer, db);
+        writer->finalize();
+
+        // base should be the snapshot of block incremental one based on
+        auto ss = std::stringstream();
+        CHECK_THROWS_AS(token_database_snapshot::rebase_snapshot(incr, incr, std::make_shared<ostream_snapshot_writer>(ss), db),
+            token_database_snapshot_exception);
+    }
+
+    auto out = std::make_shared<istream_snapshot_reader>(out_ss);
+    out->validate();
+    CHECK(out->has_section<block_state>());
+
+    auto db = token_database(make_config("rebase-out"));
+    db.open();
+    token_database_snapshot::read_from_snapshot(out, db);
+
+    auto str = std::string();
+    CHECK(db.read_token(token_type::domain, std::nullopt, N128(dm-rebase-1), str));
+    CHECK(str == "v2");
+    CHECK(db.read_token(token_type::domain, std::nullopt, N128(dm-rebase-2), str));
+    CHECK(str == "v1");
+    CHECK(db.read_token(token_type::domain, std::nullopt, N128(dm-rebase-3), str));
+    CHECK(str == "v2");
+    CHECK(db.read_asset(addr, 1, str));
+    CHECK(str == "a");
+}
+
+TEST_CASE("snapshot_pinned_view_test", "[snapshot]") {
+    auto c    = token_database::config();
+    c.db_path = evt_unittests_dir + "/tokendb_tests/pinned";
+    if(fc::exists(c.db_path)) {
+        fc::remove_all(c.db_path);
+    }
+
+    auto tokendb = token_database(c);
+    tokendb.open();
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-pinned), "v1");
+    tokendb.put_token(token_type::token, action_op::add, N128(dm-pinned), N128(t1), "v1");
+    tokendb.put_token(token_type::fungible, action_op::add, std::nullopt, name128(1), "f");
+
+    auto addr = address(public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX")));
+    tokendb.put_asset(addr, 1, "a1");
+
+    auto view = tokendb.new_read_view();
+    auto ss1  = std::stringstream();
+    auto h1   = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss1), *view);
+
+    // rows written after the view is created are never seen by the ranges read from it
+    tokendb.add_savepoint(1);
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-pinned-2), "v2");
+    tokendb.put_token(token_type::token, action_op::add, N128(dm-pinned), N128(t2), "v2");
+    tokendb.put_asset(address(public_key_type(std::string("EVT6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV"))), 1, "a2");
+
+    auto ss2 = std::stringstream();
+    auto h2  = token_database_snapshot::add_to_snapshot(std::make_shared<ostream_snapshot_writer>(ss2), *view);
+    CHECK(h1 == h2);
+    CHECK(ss1.str() == ss2.str());
+
+    view.reset();
+    tokendb.rollback_to_latest_savepoint();
+}
@@ -235,3 +235,1098 @@ TEST_CASE_METHOD(tokendb_test, "put_tokens_test", "[tokendb]") {
     CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-1"));
     CHECK(EXISTS_TOKEN2(token, "dm-tkdb-test", "basic-2"));
 }
+
+TEST_CASE_METHOD(tokendb_test, "read_tokens_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    auto tkeys = evt::chain::token_keys_t();
+    tkeys.push_back("basic-1");
+    tkeys.push_back("basic-none");
+    tkeys.push_back("basic-2");
+
+    auto outs = small_vector<std::string, 4>();
+    CHECK_THROWS_AS(tokendb.read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, outs), unknown_token_database_key);
+    CHECK(tokendb.read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, outs, true) == 2);
+    REQUIRE(outs.size() == 3);
+    CHECK(outs[1].empty());
+
+    auto tk = token_def();
+    evt::chain::extract_db_value(outs[0], tk);
+    CHECK(tk.name == "basic-1");
+    evt::chain::extract_db_value(outs[2], tk);
+    CHECK(tk.name == "basic-2");
+
+    // read from both write cache and db
+    auto addr1 = public_key_type(std::string("EVT8MGU4aKiVzqMtWi9zLpu8KuTHZWjQQrX475ycSxEkLd6aBpraX"));
+    auto addr2 = tester::get_public_key(N(read_assets));
+
+    auto akeys = small_vector<evt::chain::asset_key_t, 4>();
+    akeys.emplace_back(addr1, 3);
+    akeys.emplace_back(addr2, 3);
+
+    auto aouts = small_vector<std::string, 4>();
+    CHECK(tokendb.read_assets(akeys, aouts, true) == 1);
+    CHECK(!aouts[0].empty());
+    CHECK(aouts[1].empty());
+
+    my_tester->produce_block();
+    ADD_SAVEPOINT();
+    PUT_ASSET(addr2, 3, asset::from_string("2.00000 S#3"));
+    CHECK(tokendb.read_assets(akeys, aouts) == 2);
+
+    auto as = asset();
+    evt::chain::extract_db_value(aouts[1], as);
+    CHECK(as == asset::from_string("2.00000 S#3"));
+
+    ROLLBACK();
+    CHECK(tokendb.read_assets(akeys, aouts, true) == 1);
+}
+
+TEST_CASE("separated_layout_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_layout_tests";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tk   = token_def();
+    tk.domain = "dm-layout";
+    tk.name   = "t1";
+    tk.owner.emplace_back(tester::get_public_key(N(layout)));
+
+    auto fg = fc::json::from_string(fungible_data).as<fungible_def>();
+
+    // write with unified layout first
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        ADD_TOKEN2(token, tk.domain, tk.name, tk);
+        ADD_TOKEN(fungible, 3, fg);
+        tokendb.close();
+    }
+
+    // open with separated layout, database should be migrated
+    cfg.separated_layout = true;
+    {
+        auto tokendb = token_database(cfg);
+        tokendb.open();
+
+        CHECK(EXISTS_TOKEN2(token, tk.domain, tk.name));
+        CHECK(EXISTS_TOKEN(fungible, 3));
+
+        auto count = tokendb.read_tokens_range(evt::chain::token_type::token, tk.domain, 0, [](auto&, auto&&) { return true; });
+        CHECK(count == 1);
+
+        tokendb.close();
+    }
+
+    // unified layout cannot open separated database anymore
+    cfg.separated_layout = false;
+    {
+        auto tokendb = token_database(cfg);
+        CHECK_THROWS_AS(tokendb.open(), token_database_exception);
+    }
+}
+
+TEST_CASE_METHOD(tokendb_test, "read_assets_holders_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    auto read_all = [&](auto&& reader) {
+        auto vals = std::vector<std::pair<std::string, std::string>>();
+        reader([&](auto& k, auto&& v) {
+            vals.emplace_back(std::string(k), std::move(v));
+            return true;
+        });
+        return vals;
+    };
+    auto by_range   = [&](auto& f) { tokendb.read_assets_range(5, 0, f); };
+    auto by_holders = [&](auto& f) { tokendb.read_assets_holders(5, f); };
+
+    my_tester->produce_block();
+    for(int i = 0; i < 10; i++) {
+        PUT_ASSET(tester::get_public_key(name(("hd" + std::to_string(i)).c_str())), 5, asset(i, symbol(5, 5)));
+    }
+    // build index
+    CHECK(read_all(by_holders) == read_all(by_range));
+
+    ADD_SAVEPOINT();
+    PUT_ASSET(tester::get_public_key(N(hd1)), 5, asset(100, symbol(5, 5)));
+    PUT_ASSET(tester::get_public_key(N(hdnew)), 5, asset(200, symbol(5, 5)));
+
+    auto vals = read_all(by_holders);
+    CHECK(vals.size() == 11);
+    CHECK(vals == read_all(by_range));
+
+    ROLLBACK();
+    vals = read_all(by_holders);
+    CHECK(vals.size() == 10);
+    CHECK(vals == read_all(by_range));
+
+    // values persisted from savepoints are updated into index
+    for(int i = 0; i < 5; i++) {
+        PUT_ASSET(tester::get_public_key(N(hd2)), 5, asset(300 + i, symbol(5, 5)));
+        my_tester->produce_block();
+    }
+    CHECK(read_all(by_holders) == read_all(by_range));
+    // warming a built index doesn't scan again
+    CHECK(tokendb.warm_assets_holders(5) == read_all(by_range).size());
+}
+
+TEST_CASE_METHOD(tokendb_test, "read_assets_top_holders_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    auto read_top = [&](int skip, int take) {
+        auto vals = std::vector<std::pair<address, int64_t>>();
+        tokendb.read_assets_top_holders(6, skip, [&](auto& k, auto&& v) {
+            auto as = asset();
+            evt::chain::extract_db_value(v, as);
+            vals.emplace_back(address::from_bytes(k.data(), k.size()), as.amount());
+            return (int)vals.size() < take;
+        });
+        return vals;
+    };
+
+    my_tester->produce_block();
+    for(int i = 0; i < 10; i++) {
+        PUT_ASSET(tester::get_public_key(name(("tp" + std::to_string(i)).c_str())), 6, asset(i * 10, symbol(5, 6)));
+    }
+    // generated address is also restored from the key
+    PUT_ASSET(address(N(.fungible), name128::from_number(6), 0), 6, asset(45, symbol(5, 6)));
+
+    auto tops = read_top(0, 3);
+    REQUIRE(tops.size() == 3);
+    CHECK(tops[0] == std::make_pair(address(tester::get_public_key(N(tp9))), (int64_t)90));
+    CHECK(tops[1].second == 80);
+    CHECK(tops[2].second == 70);
+
+    tops = read_top(5, 2);
+    REQUIRE(tops.size() == 2);
+    CHECK(tops[0] == std::make_pair(address(N(.fungible), name128::from_number(6), 0), (int64_t)45));
+    CHECK(tops[1].second == 40);
+    CHECK(read_top(0, 100).size() == 11);
+
+    // pending values override the persisted ones
+    ADD_SAVEPOINT();
+    PUT_ASSET(tester::get_public_key(N(tp1)), 6, asset(1000, symbol(5, 6)));
+    PUT_ASSET(tester::get_public_key(N(tp9)), 6, asset(5, symbol(5, 6)));
+
+    tops = read_top(0, 100);
+    REQUIRE(tops.size() == 11);
+    CHECK(tops[0] == std::make_pair(address(tester::get_public_key(N(tp1))), (int64_t)1000));
+    CHECK(tops[1].second == 80);
+    CHECK(tops[9] == std::make_pair(address(tester::get_public_key(N(tp9))), (int64_t)5));
+
+    ROLLBACK();
+    tops = read_top(0, 1);
+    CHECK(tops[0].second == 90);
+
+    // persisted values are updated into ranks
+    PUT_ASSET(tester::get_public_key(N(tp2)), 6, asset(500, symbol(5, 6)));
+    my_tester->produce_block();
+    my_tester->produce_block();
+    tops = read_top(0, 100);
+    REQUIRE(tops.size() == 11);
+    CHECK(tops[0] == std::make_pair(address(tester::get_public_key(N(tp2))), (int64_t)500));
+    CHECK(tops[1].second == 90);
+}
+
+TEST_CASE_METHOD(tokendb_test, "read_view_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    my_tester->produce_block();
+    ADD_SAVEPOINT();
+
+    auto addr = tester::get_public_key(N(read_view));
+    PUT_ASSET(addr, 3, asset::from_string("3.00000 S#3"));
+
+    tokendb.pop_dirty_keys();
+    auto view1 = tokendb.new_read_view();
+
+    auto str = std::string();
+    CHECK(view1->read_asset(addr, 3, str));
+    CHECK(!view1->read_token(evt::chain::token_type::token, "dm-tkdb-test", "view-1", str, true));
+
+    auto tk = token_def();
+    tk.domain = "dm-tkdb-test";
+    tk.name   = "view-1";
+    ADD_TOKEN2(token, tk.domain, tk.name, tk);
+    PUT_ASSET(addr, 3, asset::from_string("4.00000 S#3"));
+
+    // old view is not affected by new changes
+    CHECK(!view1->read_token(evt::chain::token_type::token, "dm-tkdb-test", "view-1", str, true));
+    CHECK(view1->read_asset(addr, 3, str));
+
+    auto as = asset();
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset::from_string("3.00000 S#3"));
+
+    auto keys2 = tokendb.pop_dirty_keys();
+    auto view2 = tokendb.new_read_view();
+    CHECK(view2->read_token(evt::chain::token_type::token, "dm-tkdb-test", "view-1", str));
+    REQUIRE(keys2.size() == 1);
+    CHECK(keys2[0] == view2->get_db_key(evt::chain::token_type::token, tk.domain, tk.name));
+
+    // batched reads are pinned to the view as well
+    auto tkeys = evt::chain::token_keys_t();
+    tkeys.push_back("view-1");
+    tkeys.push_back("view-none");
+
+    auto outs = small_vector<std::string, 4>();
+    CHECK(view1->read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, outs, true) == 0);
+    CHECK_THROWS_AS(view2->read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, outs), unknown_token_database_key);
+    CHECK(view2->read_tokens(evt::chain::token_type::token, "dm-tkdb-test", tkeys, outs, true) == 1);
+    REQUIRE(outs.size() == 2);
+    CHECK(!outs[0].empty());
+    CHECK(outs[1].empty());
+
+    auto akeys = small_vector<evt::chain::asset_key_t, 4>();
+    akeys.emplace_back(addr, 3);
+    akeys.emplace_back(tester::get_public_key(N(read_view2)), 3);
+
+    auto aouts = small_vector<std::string, 4>();
+    CHECK(view1->read_assets(akeys, aouts, true) == 1);
+    evt::chain::extract_db_value(aouts[0], as);
+    CHECK(as == asset::from_string("3.00000 S#3"));
+    CHECK(aouts[1].empty());
+    CHECK(view2->read_assets(akeys, aouts, true) == 1);
+    evt::chain::extract_db_value(aouts[0], as);
+    CHECK(as == asset::from_string("4.00000 S#3"));
+
+    // paginating by the last key gets the same tokens as iterating them all
+    auto all = std::vector<std::string>();
+    view2->read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto& key, auto&&) {
+        all.emplace_back(key);
+        return true;
+    });
+    REQUIRE(all.size() > 1);
+
+    // range reads are pinned to the view too, old view doesn't see the token added after it
+    auto old = 0;
+    view1->read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto&, auto&&) {
+        old++;
+        return true;
+    });
+    CHECK(old + 1 == (int)all.size());
+
+    auto paged = std::vector<std::string>();
+    view2->read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto& key, auto&&) {
+        paged.emplace_back(key);
+        return false;
+    });
+    while(true) {
+        auto after = name128();
+        memcpy(&after, paged.back().data(), sizeof(after));
+        auto n = view2->read_tokens_range_after(evt::chain::token_type::token, "dm-tkdb-test", after, [&](auto& key, auto&&) {
+            paged.emplace_back(key);
+            return false;
+        });
+        if(n == 0) {
+            break;
+        }
+    }
+    CHECK(paged == all);
+
+    // rollback is tracked as well
+    ROLLBACK();
+    auto view3 = tokendb.new_read_view();
+    CHECK(!view3->read_token(evt::chain::token_type::token, "dm-tkdb-test", "view-1", str, true));
+    CHECK(!view3->read_asset(addr, 3, str, true));
+    CHECK(tokendb.pop_dirty_keys().size() == 1);
+}
+
+TEST_CASE_METHOD(tokendb_test, "pinned_read_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    my_tester->produce_block();
+    ADD_SAVEPOINT();
+
+    auto tk = token_def();
+    tk.domain = "dm-tkdb-test";
+    tk.name   = "pinned-1";
+    ADD_TOKEN2(token, tk.domain, tk.name, tk);
+
+    auto addr = tester::get_public_key(N(pinned));
+    PUT_ASSET(addr, 3, asset::from_string("5.00000 S#3"));
+
+    // pinned values are the same as the copied ones
+    auto str = std::string();
+    auto v   = rocksdb::PinnableSlice();
+    CHECK(tokendb.read_token(evt::chain::token_type::token, tk.domain, tk.name, str));
+    CHECK(tokendb.read_token(evt::chain::token_type::token, tk.domain, tk.name, v));
+    CHECK(std::string(v.data(), v.size()) == str);
+
+    auto tk2 = token_def();
+    evt::chain::extract_db_value(v, tk2);
+    CHECK(tk2.name == tk.name);
+
+    // asset is served from write cache
+    CHECK(tokendb.read_asset(addr, 3, v));
+    auto as = asset();
+    evt::chain::extract_db_value(v, as);
+    CHECK(as == asset::from_string("5.00000 S#3"));
+
+    CHECK(!tokendb.read_token(evt::chain::token_type::token, tk.domain, "pinned-none", v, true));
+    CHECK_THROWS_AS(tokendb.read_asset(tester::get_public_key(N(pinned2)), 3, v), unknown_token_database_key);
+
+    ROLLBACK();
+}
+
+TEST_CASE_METHOD(tokendb_test, "range_read_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    my_tester->produce_block();
+    ADD_SAVEPOINT();
+
+    auto addr1 = tester::get_public_key(N(range1));
+    auto addr2 = tester::get_public_key(N(range2));
+    PUT_ASSET(addr1, 5, asset::from_string("1.00000 S#5"));
+    PUT_ASSET(addr2, 5, asset::from_string("2.00000 S#5"));
+
+    // pending assets are merged, and pooled iterators of repeated reads see the same
+    auto read_sum = [&] {
+        auto sum = 0ll;
+        tokendb.read_assets_range(5, 0, [&](auto& key, auto&& value) {
+            auto as = asset();
+            evt::chain::extract_db_value(value, as);
+            sum += as.amount();
+            return true;
+        });
+        return sum;
+    };
+    auto sum = read_sum();
+    CHECK(sum >= 300000);
+    CHECK(read_sum() == sum);
+
+    PUT_ASSET(addr1, 5, asset::from_string("3.00000 S#5"));
+    CHECK(read_sum() == sum + 200000);
+
+    // paginating by the last key gets the same tokens as iterating them all
+    auto all = std::vector<std::string>();
+    tokendb.read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto& key, auto&&) {
+        all.emplace_back(key);
+        return true;
+    });
+    REQUIRE(all.size() > 1);
+
+    auto paged = std::vector<std::string>();
+    tokendb.read_tokens_range(evt::chain::token_type::token, "dm-tkdb-test", 0, [&](auto& key, auto&&) {
+        paged.emplace_back(key);
+        return false;
+    });
+    while(true) {
+        auto after = name128();
+        memcpy(&after, paged.back().data(), sizeof(after));
+        auto n = tokendb.read_tokens_range_after(evt::chain::token_type::token, "dm-tkdb-test", after, [&](auto& key, auto&&) {
+            paged.emplace_back(key);
+            return false;
+        });
+        if(n == 0) {
+            break;
+        }
+    }
+    CHECK(paged == all);
+
+    ROLLBACK();
+}
+
+TEST_CASE_METHOD(tokendb_test, "token_version_test", "[tokendb]") {
+    auto& tokendb = my_tester->control->token_db();
+
+    my_tester->produce_block();
+    ADD_SAVEPOINT();
+
+    auto v1 = tokendb.token_version(evt::chain::token_type::token, "dm-tkdb-test", "version-1");
+
+    auto tk = token_def();
+    tk.domain = "dm-tkdb-test";
+    tk.name   = "version-1";
+    ADD_TOKEN2(token, tk.domain, tk.name, tk);
+
+    auto v2 = tokendb.token_version(evt::chain::token_type::token, "dm-tkdb-test", "version-1");
+    CHECK(v2 != v1);
+    CHECK(tokendb.token_version(evt::chain::token_type::token, "dm-tkdb-test", "version-1") == v2);
+
+    // rollback is a change as well
+    ROLLBACK();
+    CHECK(tokendb.token_version(evt::chain::token_type::token, "dm-tkdb-test", "version-1") != v2);
+}
+
+TEST_CASE("token_version_persisted_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/version_persisted";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    tokendb.add_savepoint(1);
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-version), "v1");
+    tokendb.close();
+
+    // rollback of persisted savepoint is a change as well
+    tokendb.open();
+    REQUIRE(tokendb.savepoints_size() == 1);
+    auto v1 = tokendb.token_version(token_type::domain, std::nullopt, N128(dm-version));
+    tokendb.rollback_to_latest_savepoint();
+    CHECK(!tokendb.exists_token(token_type::domain, std::nullopt, N128(dm-version)));
+    CHECK(tokendb.token_version(token_type::domain, std::nullopt, N128(dm-version)) != v1);
+}
+
+TEST_CASE("holders_index_persisted_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/holders_persisted";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto read_holders = [](auto& tokendb) {
+        auto vals = std::vector<std::pair<std::string, std::string>>();
+        tokendb.read_assets_holders(6, [&](auto& k, auto&& v) {
+            vals.emplace_back(std::string(k), std::move(v));
+            return true;
+        });
+        return vals;
+    };
+
+    auto a = tester::get_public_key(N(hdpsa));
+    auto b = tester::get_public_key(N(hdpsb));
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    tokendb.put_asset(a, 6, evt::chain::make_db_value(asset(1, symbol(5, 6))).as_string_view());
+    auto before = read_holders(tokendb);
+    CHECK(before.size() == 1);
+
+    tokendb.add_savepoint(1);
+    tokendb.put_asset(a, 6, evt::chain::make_db_value(asset(2, symbol(5, 6))).as_string_view());
+    tokendb.put_asset(b, 6, evt::chain::make_db_value(asset(3, symbol(5, 6))).as_string_view());
+    tokendb.close();
+
+    // index built after reopen has the values of persisted savepoint, which are restored by rollback
+    tokendb.open();
+    REQUIRE(tokendb.savepoints_size() == 1);
+    CHECK(read_holders(tokendb).size() == 2);
+    tokendb.rollback_to_latest_savepoint();
+    CHECK(read_holders(tokendb) == before);
+}
+
+TEST_CASE("group_commit_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/group_commit";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto addr = tester::get_public_key(N(group_commit));
+    for(int i = 1; i <= 3; i++) {
+        tokendb.add_savepoint(i);
+        PUT_ASSET(addr, 3, asset(i, symbol(5, 3)));
+    }
+
+    // popped savepoints are not committed yet but still readable
+    tokendb.pop_savepoints(3);
+    CHECK(tokendb.savepoints_size() == 1);
+
+    auto str = std::string();
+    auto as  = asset();
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(3, symbol(5, 3)));
+
+    // rollback of remaining savepoint restores the value of committing one
+    ROLLBACK();
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(2, symbol(5, 3)));
+
+    // committed when next savepoint is added
+    tokendb.add_savepoint(4);
+    PUT_ASSET(addr, 3, asset(4, symbol(5, 3)));
+
+    // popping the last one flushes write cache, so the direct writes after it are never shadowed
+    tokendb.pop_savepoints(5);
+    PUT_ASSET(addr, 3, asset(5, symbol(5, 3)));
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(5, symbol(5, 3)));
+    tokendb.close();
+
+    tokendb.open();
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(5, symbol(5, 3)));
+    CHECK(tokendb.savepoints_size() == 0);
+}
+
+TEST_CASE("savepoint_actions_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/savepoint_actions";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto name_of = [](int i) { return name128::from_number(i); };
+
+    // actions span many chunks, and two groups are squashed into one
+    tokendb.add_savepoint(1);
+    for(int i = 0; i < 500; i++) {
+        tokendb.put_token(token_type::domain, action_op::add, std::nullopt, name_of(i), "v1");
+    }
+    tokendb.add_savepoint(2);
+    for(int i = 0; i < 500; i++) {
+        tokendb.put_token(token_type::domain, action_op::update, std::nullopt, name_of(i), "v2");
+    }
+    for(int i = 500; i < 700; i++) {
+        tokendb.put_token(token_type::domain, action_op::add, std::nullopt, name_of(i), "v2");
+    }
+    tokendb.squash();
+    CHECK(tokendb.savepoints_size() == 1);
+
+    ROLLBACK();
+    for(int i = 0; i < 700; i += 7) {
+        CHECK(!tokendb.exists_token(token_type::domain, std::nullopt, name_of(i)));
+    }
+
+    // ring of savepoints grows beyond its initial capacity during long forks
+    for(int i = 1; i <= 2000; i++) {
+        tokendb.add_savepoint(10 + i);
+        tokendb.put_token(token_type::domain, action_op::put, std::nullopt, name_of(1), std::to_string(i));
+    }
+    CHECK(tokendb.savepoints_size() == 2000);
+    for(int i = 2000; i > 1000; i--) {
+        ROLLBACK();
+    }
+
+    auto str = std::string();
+    CHECK(tokendb.read_token(token_type::domain, std::nullopt, name_of(1), str));
+    CHECK(str == "1000");
+    tokendb.pop_savepoints(10000);
+    CHECK(tokendb.savepoints_size() == 0);
+}
+
+TEST_CASE("hybrid_profile_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/hybrid";
+    cfg.profile = storage_profile::hybrid;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto addr = tester::get_public_key(N(hybrid));
+    PUT_ASSET(addr, 3, asset(1, symbol(5, 3)));
+
+    // reads never populate hot tier
+    auto str = std::string();
+    auto as  = asset();
+    for(int i = 0; i < 8; i++) {
+        CHECK(tokendb.read_asset(addr, 3, str));
+    }
+    CHECK(tokendb.int_stats()["hot-tier-keys"] == 1);
+    CHECK(tokendb.int_stats()["hot-tier-bytes"] == 0);
+
+    // promote the key into hot tier by writes
+    for(int i = 0; i < 4; i++) {
+        PUT_ASSET(addr, 3, asset(1, symbol(5, 3)));
+    }
+    CHECK(tokendb.int_stats()["hot-tier-bytes"] > 0);
+    CHECK(EXISTS_ASSET(addr, 3));
+
+    // values of hot keys are updated by writes, rollbacks and commits
+    tokendb.add_savepoint(1);
+    PUT_ASSET(addr, 3, asset(2, symbol(5, 3)));
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(2, symbol(5, 3)));
+
+    tokendb.pop_savepoints(2);
+    tokendb.add_savepoint(2);
+    PUT_ASSET(addr, 3, asset(3, symbol(5, 3)));
+    ROLLBACK();
+
+    tokendb.read_asset(addr, 3, str);
+    evt::chain::extract_db_value(str, as);
+    CHECK(as == asset(2, symbol(5, 3)));
+}
+
+TEST_CASE("metrics_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/metrics";
+    cfg.metrics = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    REQUIRE(tokendb.metrics() != nullptr);
+
+    auto addr = tester::get_public_key(N(metrics));
+    {
+        auto scope = token_database_metrics::action_scope(tokendb.metrics(), N(transferft));
+        PUT_ASSET(addr, 3, asset(1, symbol(5, 3)));
+
+        auto str = std::string();
+        CHECK(tokendb.read_asset(addr, 3, str));
+        CHECK(!tokendb.read_asset(addr, 4, str, true));
+        CHECK_THROWS_AS(tokendb.read_asset(addr, 5, str), unknown_token_database_key);
+    }
+
+    auto v = tokendb.metrics()->to_variant();
+    auto& a = v["types"]["asset"];
+    CHECK(a["reads"].as_uint64() == 3);
+    CHECK(a["read_misses"].as_uint64() == 2);
+    CHECK(a["writes"].as_uint64() == 1);
+    CHECK(a["read_latency"]["count"].as_uint64() == 3);
+    CHECK(v["actions"]["transferft"]["writes"].as_uint64() == 1);
+}
+
+TEST_CASE("hot_keys_test", "[tokendb]") {
+    auto cfg     = token_database::config();
+    cfg.db_path  = evt_unittests_dir + "/tokendb_tests/hot_keys";
+    cfg.hot_keys = 2;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+
+    auto names = std::vector<name128>{ N128(dm-hot-1), N128(dm-hot-2), N128(dm-hot-3) };
+    auto times = std::vector<int>{ 5, 1, 3 };
+    for(auto i = 0u; i < names.size(); i++) {
+        for(auto j = 0; j < times[i]; j++) {
+            tokendb.put_token(token_type::domain, action_op::put, std::nullopt, names[i], "value");
+        }
+    }
+    auto str = std::string();
+    CHECK(tokendb.read_token(token_type::domain, std::nullopt, names[2], str));
+
+    // only the hottest two are kept, in the order of accesses
+    auto v    = tokendb.hot_keys();
+    auto keys = v["types"]["domain"].get_array();
+    REQUIRE(keys.size() == 2);
+    CHECK(keys[0]["key"].as<name128>() == names[0]);
+    CHECK(keys[0]["writes"].as_uint64() >= 5);
+    CHECK(keys[1]["key"].as<name128>() == names[2]);
+    CHECK(keys[1]["reads"].as_uint64() >= 1);
+    CHECK(v["types"].get_object().find("asset") == v["types"].get_object().end());
+}
+
+TEST_CASE("state_hash_test", "[tokendb]") {
+    auto cfg       = token_database::config();
+    cfg.db_path    = evt_unittests_dir + "/tokendb_tests/state_hash";
+    cfg.state_hash = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    auto addr  = tester::get_public_key(N(state_hash));
+    auto empty = tokendb->state_hash();
+
+    tokendb->put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-state), "v1");
+    tokendb->put_asset(addr, 3, "a1");
+    auto h1 = tokendb->state_hash();
+    CHECK(h1 != empty);
+
+    // rows are restored by rollback and so is the hash
+    tokendb->add_savepoint(1);
+    tokendb->put_token(token_type::domain, action_op::update, std::nullopt, N128(dm-state), "v2");
+    tokendb->put_asset(addr, 3, "a2");
+    tokendb->put_asset(addr, 4, "a3");
+    auto h2 = tokendb->state_hash();
+    CHECK(h2 != h1);
+
+    tokendb->rollback_to_latest_savepoint();
+    CHECK(tokendb->state_hash() == h1);
+
+    // incremental hash is the same as the one calculated by full scan
+    tokendb->add_savepoint(2);
+    tokendb->put_token(token_type::domain, action_op::update, std::nullopt, N128(dm-state), "v2");
+    tokendb->put_asset(addr, 3, "a2");
+    tokendb->put_asset(addr, 4, "a3");
+    CHECK(tokendb->state_hash() == h2);
+    tokendb->pop_savepoints(3);
+    tokendb->close();
+
+    cfg.state_hash = false;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(!tokendb->state_hash_enabled());
+    CHECK(tokendb->state_hash() == h2);
+}
+
+TEST_CASE("evtlink_filter_test", "[tokendb]") {
+    auto cfg           = token_database::config();
+    cfg.db_path        = evt_unittests_dir + "/tokendb_tests/evtlink_filter";
+    cfg.evtlink_filter = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    tokendb->put_token(token_type::evtlink, action_op::add, std::nullopt, N128(link-1), "l1");
+    CHECK(tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-1)));
+    CHECK(!tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-2)));
+
+    auto str = std::string();
+    CHECK(tokendb->read_token(token_type::evtlink, std::nullopt, N128(link-1), str));
+    CHECK(str == "l1");
+    CHECK(!tokendb->read_token(token_type::evtlink, std::nullopt, N128(link-2), str, true));
+    CHECK_THROWS_AS(tokendb->read_token(token_type::evtlink, std::nullopt, N128(link-2), str), unknown_token_database_key);
+
+    // rolled back links are still in filter but not found in database
+    tokendb->add_savepoint(1);
+    tokendb->put_token(token_type::evtlink, action_op::add, std::nullopt, N128(link-2), "l2");
+    CHECK(tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-2)));
+    tokendb->rollback_to_latest_savepoint();
+    CHECK(!tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-2)));
+    tokendb->close();
+
+    // filter is loaded from database when it's opened again
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-1)));
+    CHECK(!tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-3)));
+}
+
+TEST_CASE("fast_restart_test", "[tokendb]") {
+    auto cfg           = token_database::config();
+    cfg.db_path        = evt_unittests_dir + "/tokendb_tests/fast_restart";
+    cfg.state_hash     = true;
+    cfg.evtlink_filter = true;
+    cfg.fast_restart   = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+    auto derived = cfg.db_path / evt::chain::config::token_database_derived_filename;
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    tokendb->put_token(token_type::evtlink, action_op::add, std::nullopt, N128(link-1), "l1");
+    tokendb->put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-fast), "v1");
+    tokendb->add_savepoint(1);
+    tokendb->put_asset(tester::get_public_key(N(fast)), 3, "a1");
+    auto h1 = tokendb->state_hash();
+    tokendb->close();
+    CHECK(fc::exists(derived));
+
+    // derived state is loaded and consumed
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(!fc::exists(derived));
+    CHECK(tokendb->state_hash() == h1);
+    CHECK(tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-1)));
+    CHECK(!tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-2)));
+    tokendb->close();
+    // clean close writes it again
+    REQUIRE(fc::exists(derived));
+
+    // instance without fast restart neither consumes the file nor rewrites it on close,
+    // so it's left stale once database is changed
+    cfg.fast_restart = false;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(fc::exists(derived));
+    tokendb->put_token(token_type::evtlink, action_op::add, std::nullopt, N128(link-2), "l2");
+    auto h2 = tokendb->state_hash();
+    tokendb->close();
+    REQUIRE(fc::exists(derived));
+    CHECK(h2 != h1);
+
+    // stale file is rejected and removed, derived state is rebuilt by scanning database
+    // the stale hash and filter don't have `link-2`, so accepting it would fail the checks below
+    cfg.fast_restart = true;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(!fc::exists(derived));
+    CHECK(tokendb->state_hash() == h2);
+    CHECK(tokendb->exists_token(token_type::evtlink, std::nullopt, N128(link-2)));
+}
+
+TEST_CASE("tuning_profile_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/tuning";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto profiles = std::vector<std::pair<tuning_profile, name128>>{
+        { tuning_profile::producer, N128(producer) },
+        { tuning_profile::api,      N128(api)      },
+        { tuning_profile::archive,  N128(archive)  }
+    };
+    for(auto& [profile, name] : profiles) {
+        cfg.tuning   = profile;
+        auto tokendb = std::make_unique<token_database>(cfg);
+        tokendb->open();
+
+        tokendb->put_token(token_type::domain, action_op::add, std::nullopt, name, "d");
+        CHECK(tokendb->exists_token(token_type::domain, std::nullopt, name));
+        tokendb->close();
+    }
+
+    // options file written by rocksdb itself is loaded
+    auto options_file = fc::path();
+    for(auto it = fc::directory_iterator(cfg.db_path); it != fc::directory_iterator(); it++) {
+        if(it->filename().generic_string().find("OPTIONS-") == 0) {
+            options_file = *it;
+        }
+    }
+    REQUIRE(!options_file.empty());
+
+    cfg.options_file = options_file;
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(tokendb->exists_token(token_type::domain, std::nullopt, N128(api)));
+    tokendb->close();
+
+    cfg.options_file = cfg.db_path / "OPTIONS-not-existed";
+    tokendb = std::make_unique<token_database>(cfg);
+    CHECK_THROWS_AS(tokendb->open(), token_database_exception);
+}
+
+TEST_CASE("owner_index_test", "[tokendb]") {
+    auto cfg        = token_database::config();
+    cfg.db_path     = evt_unittests_dir + "/tokendb_tests/owner_index";
+    cfg.owner_index = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    auto var = fc::json::from_string(token_data);
+    auto a   = var.as<token_def>().owner[0];
+    auto b   = address(N(.lock), N128(owner-test), 0);
+
+    auto put = [&](const name128& name, const address& owner, action_op op) {
+        auto tk   = var.as<token_def>();
+        tk.domain = N128(dm-owner);
+        tk.name   = name;
+        tk.owner  = { owner };
+        tokendb->put_token(token_type::token, op, tk.domain, tk.name, make_db_value(tk).as_string_view());
+    };
+    auto owned = [&](const address& owner) {
+        auto names = std::vector<name128>();
+        tokendb->read_tokens_by_owner(owner, 0, [&](auto& key, auto&& value) {
+            auto tk = token_def();
+            extract_db_value(value, tk);
+            names.emplace_back(tk.name);
+            return true;
+        });
+        return names;
+    };
+
+    put(N128(t1), a, action_op::add);
+    put(N128(t2), a, action_op::add);
+    CHECK(owned(a).size() == 2);
+    CHECK(owned(b).empty());
+
+    // transfers are moved back when rolling back
+    tokendb->add_savepoint(1);
+    put(N128(t1), b, action_op::update);
+    CHECK(owned(a) == std::vector<name128>{ N128(t2) });
+    CHECK(owned(b) == std::vector<name128>{ N128(t1) });
+    tokendb->rollback_to_latest_savepoint();
+    CHECK(owned(a).size() == 2);
+    CHECK(owned(b).empty());
+    tokendb->close();
+
+    // index is dropped when disabled, and built again with the tokens written in the meantime
+    cfg.owner_index = false;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    put(N128(t2), b, action_op::update);
+    CHECK_THROWS_AS(owned(b), token_database_exception);
+    tokendb->close();
+
+    cfg.owner_index = true;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(owned(a) == std::vector<name128>{ N128(t1) });
+    CHECK(owned(b) == std::vector<name128>{ N128(t2) });
+}
+
+TEST_CASE("balance_index_test", "[tokendb]") {
+    auto cfg          = token_database::config();
+    cfg.db_path       = evt_unittests_dir + "/tokendb_tests/balance_index";
+    cfg.balance_index = true;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    auto a = address(tester::get_public_key(N(balancea)));
+    auto b = address(tester::get_public_key(N(balanceb)));
+
+    using balances_t = std::vector<std::pair<symbol_id_type, std::string>>;
+    auto balances = [&](const address& addr) {
+        auto r = balances_t();
+        tokendb->read_assets_by_address(addr, [&](auto& key, auto&& value) {
+            auto sym_id = symbol_id_type();
+            memcpy(&sym_id, key.data(), sizeof(sym_id));
+            r.emplace_back(sym_id, value);
+            return true;
+        });
+        return r;
+    };
+
+    tokendb->put_asset(a, 4, "a4");
+    tokendb->put_asset(a, 1, "a1");
+    tokendb->put_asset(b, 2, "b2");
+    CHECK(balances(a) == balances_t{ { 1, "a1" }, { 4, "a4" } });
+    CHECK(balances(b) == balances_t{ { 2, "b2" } });
+
+    // pending balances are listed, and removed by rollback
+    tokendb->add_savepoint(1);
+    tokendb->put_asset(a, 3, "a3");
+    tokendb->put_asset(a, 4, "a4-2");
+    CHECK(balances(a) == balances_t{ { 1, "a1" }, { 3, "a3" }, { 4, "a4-2" } });
+
+    tokendb->rollback_to_latest_savepoint();
+    CHECK(balances(a) == balances_t{ { 1, "a1" }, { 4, "a4" } });
+
+    // committed balances are moved into index
+    tokendb->add_savepoint(2);
+    tokendb->put_asset(b, 5, "b5");
+    tokendb->pop_savepoints(3);
+    tokendb->add_savepoint(3);
+    tokendb->pop_savepoints(4);
+    CHECK(balances(b) == balances_t{ { 2, "b2" }, { 5, "b5" } });
+
+    // views are pinned to the state when they're created
+    auto view = tokendb->new_read_view();
+    tokendb->put_asset(b, 7, "b7");
+
+    auto in_view = balances_t();
+    view->read_assets_by_address(b, [&](auto& key, auto&& value) {
+        auto sym_id = symbol_id_type();
+        memcpy(&sym_id, key.data(), sizeof(sym_id));
+        in_view.emplace_back(sym_id, value);
+        return true;
+    });
+    CHECK(in_view == balances_t{ { 2, "b2" }, { 5, "b5" } });
+    view.reset();
+    tokendb->close();
+
+    // index is dropped when disabled, and built again with the balances written in the meantime
+    cfg.balance_index = false;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    tokendb->put_asset(b, 6, "b6");
+    CHECK_THROWS_AS(balances(b), token_database_exception);
+    tokendb->close();
+
+    cfg.balance_index = true;
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(balances(a) == balances_t{ { 1, "a1" }, { 4, "a4" } });
+    CHECK(balances(b) == balances_t{ { 2, "b2" }, { 5, "b5" }, { 6, "b6" }, { 7, "b7" } });
+}
+
+TEST_CASE("read_replica_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/read_replica";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-replica-1), "v1");
+
+    auto replica = token_database_replica(cfg);
+    auto str     = std::string();
+    CHECK(replica.current()->read_token(token_type::domain, std::nullopt, N128(dm-replica-1), str, true));
+    CHECK(str == "v1");
+
+    auto db = std::const_pointer_cast<token_database>(replica.current());
+    CHECK_THROWS_AS(db->put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-replica-x), "v"), token_database_exception);
+    CHECK_THROWS_AS(db->add_savepoint(1), token_database_exception);
+    db.reset();
+
+    // rows written by primary are visible after catching up, views created before are pinned to the old instance
+    auto view = replica.new_read_view();
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-replica-2), "v2");
+    CHECK(!replica.current()->read_token(token_type::domain, std::nullopt, N128(dm-replica-2), str, true));
+
+    replica.catch_up();
+    CHECK(replica.generation() == 1);
+    CHECK(replica.current()->read_token(token_type::domain, std::nullopt, N128(dm-replica-2), str, true));
+    CHECK(str == "v2");
+    CHECK(!view->read_token(token_type::domain, std::nullopt, N128(dm-replica-2), str, true));
+    CHECK(view->read_token(token_type::domain, std::nullopt, N128(dm-replica-1), str, true));
+    CHECK(str == "v1");
+}
+
+TEST_CASE("savepoint_deltas_test", "[tokendb]") {
+    auto cfg    = token_database::config();
+    cfg.db_path = evt_unittests_dir + "/tokendb_tests/savepoint_deltas";
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = token_database(cfg);
+    tokendb.open();
+    CHECK_THROWS_AS(tokendb.latest_savepoint_deltas(), token_database_no_savepoint);
+
+    tokendb.add_savepoint(1);
+    tokendb.put_token(token_type::domain, action_op::add, std::nullopt, N128(dm-delta-1), "v1");
+    tokendb.add_savepoint(2);
+    tokendb.put_token(token_type::domain, action_op::update, std::nullopt, N128(dm-delta-1), "v2");
+    tokendb.put_token(token_type::domain, action_op::put, std::nullopt, N128(dm-delta-1), "v3");
+    auto tkeys = token_keys_t();
+    auto data  = small_vector<std::string_view, 4>();
+    tkeys.push_back(N128(t1));
+    tkeys.push_back(N128(t2));
+    data.push_back("t");
+    data.push_back("t");
+    tokendb.put_tokens(token_type::token, action_op::add, N128(dm-delta-1), std::move(tkeys), data);
+    tokendb.put_asset(address(N(.delta), N128(dm-delta-1), 0), 1, "a");
+
+    // each key is reported once with its latest value
+    auto deltas = tokendb.latest_savepoint_deltas();
+    CHECK(deltas.size() == 4);
+    auto types = std::map<token_type, int>();
+    for(auto& d : deltas) {
+        types[d.type]++;
+        if(d.type == token_type::domain) {
+            CHECK(d.value == "v3");
+        }
+        else if(d.type == token_type::token) {
+            CHECK(d.value == "t");
+        }
+        else {
+            CHECK(d.value == "a");
+        }
+    }
+    CHECK(types[token_type::domain] == 1);
+    CHECK(types[token_type::token] == 2);
+    CHECK(types[token_type::asset] == 1);
+
+    ROLLBACK();
+    deltas = tokendb.latest_savepoint_deltas();
+    CHECK(deltas.size() == 1);
+    CHECK(deltas[0].value == "v1");
+    tokendb.pop_savepoints(10);
+}
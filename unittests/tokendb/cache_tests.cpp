@@ -1,5 +1,6 @@
 #include "tokendb_tests.hpp"
 #include <evt/chain/token_database_cache.hpp>
+#include <fc/io/fstream.hpp>
 
 TEST_CASE_METHOD(tokendb_test, "cache_test", "[tokendb]") {
     auto& tokendb = my_tester->control->token_db();
@@ -87,4 +88,148 @@ TEST_CASE_METHOD(tokendb_test, "cache_test", "[tokendb]") {
         CHECK(cache.lookup_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-2") == nullptr);
         CHECK_THROWS_AS(cache.read_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-2") == nullptr, unknown_token_database_key);
     }
+
+    SECTION("derived_test") {
+        struct domain_header {
+            user_id creator;
+        };
+
+        auto s       = tokendb.new_savepoint_session();
+        auto derived = 0;
+        auto derive  = [&](auto& dom) {
+            derived++;
+            return domain_header { dom.creator };
+        };
+
+        auto var = fc::json::from_string(domain_data);
+        auto dom = var.as<domain_def>();
+        cache.put_token(token_type::domain, action_op::put, std::nullopt, "dm-tkdb-cache-3", dom);
+
+        // derived once and served from cache after that
+        auto dh = cache.read_derived<domain_def, domain_header>(token_type::domain, std::nullopt, "dm-tkdb-cache-3", derive);
+        CHECK(dh->creator == dom.creator);
+        dh.reset();
+        cache.read_derived<domain_def, domain_header>(token_type::domain, std::nullopt, "dm-tkdb-cache-3", derive);
+        CHECK(derived == 1);
+
+        // writes of token drop the derived value
+        auto dom2 = cache.lookup_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-3");
+        dom2->creator = public_key_type();
+        cache.put_token(token_type::domain, action_op::put, std::nullopt, "dm-tkdb-cache-3", *dom2);
+        dom2.reset();
+
+        dh = cache.read_derived<domain_def, domain_header>(token_type::domain, std::nullopt, "dm-tkdb-cache-3", derive);
+        CHECK(dh->creator == public_key_type());
+        CHECK(derived == 2);
+        dh.reset();
+
+        // and so do rollbacks
+        s.undo();
+        CHECK_THROWS_AS(cache.read_derived<domain_def, domain_header>(token_type::domain, std::nullopt, "dm-tkdb-cache-3", derive), unknown_token_database_key);
+    }
+
+    SECTION("owners_test") {
+        auto s   = tokendb.new_savepoint_session();
+        auto var = fc::json::from_string(token_data);
+
+        auto names = small_vector<name128, 4>{ "t1", "t2" };
+        for(auto& n : names) {
+            auto tk   = var.as<token_def>();
+            tk.domain = "dm-tkdb-cache-4";
+            tk.name   = n;
+            cache.put_token(token_type::token, action_op::put, tk.domain, tk.name, tk);
+        }
+
+        // t1 is held from cache while owners are rewritten
+        auto tk1   = cache.read_token<token_def>(token_type::token, "dm-tkdb-cache-4", "t1");
+        auto owner = address_list{ address(N(.lock), N128(lock-test), 0) };
+        cache.put_token_owners<token_def>("dm-tkdb-cache-4", names, owner);
+        CHECK(tk1->owner == owner);
+        tk1.reset();
+
+        for(auto& n : names) {
+            auto tk = token_def();
+            READ_TOKEN2(token, "dm-tkdb-cache-4", n, tk);
+            CHECK(tk.name == n);
+            CHECK(tk.owner == owner);
+            CHECK(tk.metas.size() == 1);
+            CHECK(tk.metas[0].key == "key");
+        }
+
+        names.emplace_back("t3");
+        CHECK_THROWS_AS(cache.put_token_owners<token_def>("dm-tkdb-cache-4", names, owner), unknown_token_exception);
+        s.undo();
+    }
+
+    SECTION("append_meta_test") {
+        auto s   = tokendb.new_savepoint_session();
+        auto var = fc::json::from_string(domain_data);
+        auto dom = var.as<domain_def>();
+        cache.put_token(token_type::domain, action_op::put, std::nullopt, "dm-tkdb-cache-5", dom);
+
+        {
+            auto s2 = tokendb.new_savepoint_session();
+
+            // appended ones are merged into the value in database
+            auto dom2    = cache.read_token<domain_def>(token_type::domain, std::nullopt, "dm-tkdb-cache-5");
+            auto creator = dom2->metas[0].creator;
+            for(auto& k : { N128(key2), N128(key3) }) {
+                dom2->metas.emplace_back(meta(k, "value", creator));
+                cache.append_token_meta(token_type::domain, std::nullopt, "dm-tkdb-cache-5", *dom2);
+            }
+
+            auto dom3 = domain_def();
+            READ_TOKEN(domain, "dm-tkdb-cache-5", dom3);
+            CHECK(dom3.metas.size() == 3);
+            CHECK(dom3.metas[2].key == N128(key3));
+            CHECK_EQUAL(*dom2, dom3);
+        }
+
+        // rolled back as other updates
+        auto dom4 = domain_def();
+        READ_TOKEN(domain, "dm-tkdb-cache-5", dom4);
+        CHECK(dom4.metas.size() == 1);
+        CHECK_EQUAL(dom, dom4);
+        s.undo();
+    }
+}
+
+TEST_CASE("warmup_keys_test", "[tokendb]") {
+    auto cfg        = token_database::config();
+    cfg.db_path     = evt_unittests_dir + "/tokendb_tests/warmup_keys";
+    cfg.warmup_keys = 2;
+    if(fc::exists(cfg.db_path)) {
+        fc::remove_all(cfg.db_path);
+    }
+
+    auto tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+
+    auto dom   = fc::json::from_string(domain_data).as<domain_def>();
+    auto names = std::vector<name128>{ "dm-warm-1", "dm-warm-2", "dm-warm-3" };
+    {
+        auto cache = token_database_cache(*tokendb, 1024 * 1024, cfg.warmup_keys);
+        for(auto& n : names) {
+            cache.put_token(token_type::domain, action_op::add, std::nullopt, n, dom);
+        }
+        for(auto& n : { names[0], names[1], names[2], names[0] }) {
+            CHECK(cache.read_token<domain_def>(token_type::domain, std::nullopt, n) != nullptr);
+        }
+        cache.save_warm_keys();
+    }
+
+    // most recently read ones first without duplicates
+    auto str = std::string();
+    fc::read_file_contents(cfg.db_path / evt::chain::config::token_database_warmkeys_filename, str);
+    auto keys = fc::raw::unpack<std::vector<std::string>>(std::vector<char>(str.cbegin(), str.cend()));
+    REQUIRE(keys.size() == 2);
+    CHECK(keys[0] == tokendb->get_db_key(token_type::domain, std::nullopt, names[0]));
+    CHECK(keys[1] == tokendb->get_db_key(token_type::domain, std::nullopt, names[2]));
+    tokendb->close();
+
+    // keys are prefetched in background after opening
+    tokendb = std::make_unique<token_database>(cfg);
+    tokendb->open();
+    CHECK(tokendb->exists_token(token_type::domain, std::nullopt, names[2]));
+    tokendb->close();
 }
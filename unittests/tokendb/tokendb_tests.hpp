@@ -13,6 +13,8 @@
 
 #include <evt/chain/controller.hpp>
 #include <evt/chain/token_database.hpp>
+#include <evt/chain/token_database_metrics.hpp>
+#include <evt/chain/token_database_replica.hpp>
 #include <evt/chain/contracts/types.hpp>
 #include <evt/chain/contracts/evt_link_object.hpp>
 #include <evt/testing/tester.hpp>
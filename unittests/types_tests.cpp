@@ -1,9 +1,19 @@
 #include <catch/catch.hpp>
 
+#include <boost/asio/thread_pool.hpp>
+#include <fc/variant_arena.hpp>
+
+#include <evt/chain/action_access.hpp>
 #include <evt/chain/address.hpp>
+#include <evt/chain/block_bus.hpp>
+#include <evt/chain/execution_context_impl.hpp>
+#include <evt/chain/merkle.hpp>
 #include <evt/chain/types.hpp>
 #include <evt/chain/token_database.hpp>
+#include <evt/chain/transaction_metadata.hpp>
+#include <evt/chain/zstd_dictionary.hpp>
 #include <evt/chain/contracts/authorizer_ref.hpp>
+#include <evt/chain/contracts/base42.hpp>
 #include <evt/chain/contracts/evt_link.hpp>
 #include <evt/chain/contracts/types.hpp>
 
@@ -104,6 +114,35 @@ TEST_CASE("test_link_1", "[types]") {
     CHECK(pkeys.find(public_key_type(std::string("EVT8HdQYD1xfKyD7Hyu2fpBUneamLMBXmP3qsYX6HoTw7yonpjWyC"))) != pkeys.end());
 }
 
+TEST_CASE("test_link_keys_cache", "[types]") {
+    auto link = evt_link();
+    link.set_header(evt_link::version1 | evt_link::everiPay);
+    link.add_segment(evt_link::segment(evt_link::timestamp, 1532465234));
+    link.add_segment(evt_link::segment(evt_link::max_pay, 100));
+
+    auto key1 = private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("link1")));
+    auto key2 = private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("link2")));
+    link.sign(key1);
+
+    // recovered once and shared by copies
+    auto& keys = link.restore_keys();
+    CHECK(keys.size() == 1);
+    CHECK(&link.restore_keys() == &keys);
+
+    auto copy = link;
+    CHECK(&copy.restore_keys() == &keys);
+
+    // changes of link recover keys again
+    copy.sign(key2);
+    CHECK(copy.restore_keys().size() == 2);
+    CHECK(link.restore_keys().size() == 1);
+
+    copy.clear_signatures();
+    copy.sign(key2);
+    CHECK(copy.restore_keys().size() == 1);
+    CHECK(copy.restore_keys().find(key2.get_public_key()) != copy.restore_keys().end());
+}
+
 TEST_CASE("test_link_2", "[types]") {
     auto str = "https://evt.li/04OH4QSYU-9:0ISOMCF2AY*JO/O/7VTMZLC6W*F0NQ831F+60"
                "7/$9/9F/T6HT:FU*W99Q_PWV-SEQQOBAI6AXPY-32ZV:DTQ8BNCA$Z15-OHQ7*9O"
@@ -204,6 +243,67 @@ TEST_CASE("test_link_3", "[types]") {
     CHECK(pkeys.find(public_key_type(std::string("EVT7bUYEdpHiKcKT9Yi794MiwKzx5tGY3cHSh4DoCrL4B2LRjRgnt"))) != pkeys.end());
 }
 
+TEST_CASE("test_base42", "[types]") {
+    auto encode = [](const bytes& b) {
+        auto str = std::string();
+        base42_encode(b.data(), b.data() + b.size(), str);
+        return str;
+    };
+    auto decode = [](const std::string& str, size_t max_bytes) {
+        return base42_decode(str.data(), str.data() + str.size(), max_bytes);
+    };
+
+    // fixed vectors, each leading zero byte is one leading '0'
+    auto vectors = std::vector<std::pair<bytes, std::string>>{
+        { bytes{ 1 }, "1" },
+        { bytes{ 0, 0, 1, 2 }, "0066" },
+        { bytes{ 0, (char)0xff, (char)0xff, (char)0xff, (char)0xff }, "0W$B6U3" },
+        { bytes{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }, "2PE51-XU34RWIP/TZ+MCG7A" }
+    };
+    for(auto& v : vectors) {
+        CHECK(encode(v.first) == v.second);
+        CHECK(decode(v.second, 67) == v.first);
+    }
+
+    // segments are limited to 67 bytes
+    auto segs = bytes(67, (char)0xff);
+    auto str  = std::string("4JWUCXKY*QIL3D5H+FQ54$GHU*81479$XMCYYIRT5-XVIN67WH$-S$W+EJGZ/C51N1Z64G08X/UDG6RP*2LA5X:E4I2YHBU$TIU3");
+    CHECK(encode(segs) == str);
+    CHECK(decode(str, 67) == segs);
+
+    segs.push_back((char)0xff);
+    str = "RANIU06*BV6WK8131X997RY44Z2-TI48CF:89/UXQ4LTR33TFQ*1Y08JQ6AV1J$TIJ898TNBS-4XOKOEEBBJXG*Z*057VDM7TK3IF";
+    CHECK(encode(segs) == str);
+    CHECK_THROWS_AS(decode(str, 67), evt_link_exception);
+
+    // leading zeros are not counted into the limit
+    auto zsegs = bytes(10, 0);
+    zsegs.insert(zsegs.end(), 67, (char)0xff);
+    CHECK(decode(encode(zsegs), 67) == zsegs);
+
+    // signatures are limited to 195 bytes, three signatures of 65 bytes
+    auto sigs = bytes(195, (char)0xff);
+    str = encode(sigs);
+    CHECK(str.size() == 290);
+    CHECK(decode(str, 195) == sigs);
+
+    sigs.push_back((char)0xff);
+    str = encode(sigs);
+    CHECK(str.size() == 291);
+    CHECK_THROWS_AS(decode(str, 195), evt_link_exception);
+
+    // characters not in alphabets
+    CHECK_THROWS_AS(decode("0066a", 67), evt_link_exception);
+    CHECK_THROWS_AS(decode("00_66", 67), evt_link_exception);
+    CHECK_THROWS_AS(decode("000", 67), evt_link_exception);
+
+    auto link = std::string("03XBY4E/KTS:PNHVA3JP9QG258F08JHYOYR5SLJGN0EA-C3J6S:2G:T1SX7WA1"
+                            "4KH9ETLZ97TUX9R9JJA6+06$E/_PYNX-/152P4CTC:WKXLK$/7G-K:89+::2K4"
+                            "C-KZ2**HI-P8CYJ**XGFO1K5:$E*SOY8MFYWMNHP*BHX2U8$$FTFI81YDP1HT");
+    link[10] = '#';
+    CHECK_THROWS_AS(evt_link::parse_from_evtli(link), evt_link_exception);
+}
+
 TEST_CASE("test_name", "[types]") {
     auto CHECK_RESERVED = [](auto& str) {
         auto n = name(str);
@@ -260,6 +360,17 @@ TEST_CASE("test_name128", "[types]") {
     CHECK_N128("1234567890ABCDEF", 16);
     CHECK_N128("1234567890ABCDEFGHIJK", 16);
 
+    // names are checked to be normalized
+    CHECK_THROWS_AS(name128("abc."), name128_type_exception);
+    CHECK_THROWS_AS(name128("abc_d"), name128_type_exception);
+    CHECK_THROWS_AS(name128(std::string("ab\0c", 4)), name128_type_exception);
+    CHECK_N128("a..b", 4);
+    CHECK(name("abc.a").to_string() == "abc.a");
+    CHECK(name("aaaaaaaaaaaao").to_string() == "aaaaaaaaaaaao");
+    CHECK_THROWS_AS(name("aaaaaaaaaaaaz"), name_type_exception);
+    CHECK_THROWS_AS(name("abc."), name_type_exception);
+    CHECK_THROWS_AS(name("abC"), name_type_exception);
+
     auto n1 = name128(N128(12345.67890));
     CHECK((std::string)n1 == "12345.67890");
 
@@ -445,3 +556,310 @@ TEST_CASE("test_reflector_init", "[types]") {
     CHECK(trx2.max_charge == 1000);
     CHECK(trx2.actions.size() == 1);
 }
+
+TEST_CASE("test_packed_transaction_ids", "[types]") {
+    auto strx = signed_transaction();
+    strx.max_charge = 1000;
+    strx.actions.emplace_back(action(".test", ".test", ".test", bytes()));
+
+    auto hash = fc::sha256::hash(std::string("test"));
+    strx.sign(private_key_type(std::string("5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3")), *(chain_id_type*)&hash);
+
+    for(auto c : { packed_transaction::none, packed_transaction::zlib }) {
+        auto ptrx = packed_transaction(strx, c);
+        CHECK(ptrx.id() == strx.id());
+        CHECK(ptrx.signed_id() == digest_type::hash(ptrx));
+        CHECK(ptrx.get_prunable_size() == fc::raw::pack_size(strx.signatures));
+
+        auto ptrx2 = fc::raw::unpack<packed_transaction>(fc::raw::pack(ptrx));
+        CHECK(ptrx2.id() == strx.id());
+        CHECK(ptrx2.signed_id() == ptrx.signed_id());
+    }
+}
+
+TEST_CASE("test_trivially_packable", "[types]") {
+    static_assert(fc::raw::is_trivially_packable_v<asset>);
+    static_assert(fc::raw::is_trivially_packable_v<property>);
+    static_assert(!fc::raw::is_trivially_packable_v<name128>);
+
+    auto prop = property { 1000, symbol(5, 1), 12345, 6 };
+
+    // packed form should be the same as packing its members one by one
+    auto ds = fc::datastream<size_t>();
+    fc::raw::pack(ds, prop.amount);
+    fc::raw::pack(ds, prop.sym);
+    fc::raw::pack(ds, prop.created_at);
+    fc::raw::pack(ds, prop.created_index);
+
+    auto b = fc::raw::pack(prop);
+    CHECK(b.size() == ds.tellp());
+    CHECK(fc::raw::pack_size(prop) == ds.tellp());
+
+    auto prop2 = fc::raw::unpack<property>(b);
+    CHECK(prop2.amount == prop.amount);
+    CHECK(prop2.sym == prop.sym);
+    CHECK(prop2.created_at == prop.created_at);
+    CHECK(prop2.created_index == prop.created_index);
+
+    auto assets = small_vector<asset, 4>{ asset(1, symbol(5, 1)), asset(2, evt_sym()) };
+    auto b2     = fc::raw::pack(assets);
+    CHECK(b2.size() == 1 + 2 * sizeof(asset));
+
+    auto assets2 = fc::raw::unpack<small_vector<asset, 4>>(b2);
+    REQUIRE(assets2.size() == 2);
+    CHECK(assets2[1] == assets[1]);
+
+    // reflector_init of asset is still called
+    auto b3 = fc::raw::pack(asset(1, symbol(5, 1)));
+    memset(b3.data(), 0x7f, sizeof(int64_t));
+    CHECK_THROWS_AS(fc::raw::unpack<asset>(b3), fc::exception);
+}
+
+TEST_CASE("test_start_recover_keys", "[types]") {
+    auto strx = signed_transaction();
+    strx.max_charge = 1000;
+    strx.actions.emplace_back(action(".test", ".test", ".test", bytes()));
+
+    auto hash     = fc::sha256::hash(std::string("test"));
+    auto chain_id = *(chain_id_type*)&hash;
+    auto key      = private_key_type(std::string("5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3"));
+    strx.sign(key, chain_id);
+
+    auto pool = boost::asio::thread_pool(2);
+    auto mtrx = std::make_shared<transaction_metadata>(strx);
+    transaction_metadata::start_recover_keys(mtrx, pool, chain_id);
+    CHECK(mtrx->signing_keys_future.valid());
+
+    auto& keys = mtrx->recover_keys(chain_id);
+    CHECK(keys.size() == 1);
+    CHECK(keys.count(key.get_public_key()) == 1);
+
+    // another chain id is recovered inline
+    auto chain_id2 = chain_id_type(fc::sha256::hash(std::string("test2")));
+    CHECK(mtrx->recover_keys(chain_id2).count(key.get_public_key()) == 0);
+
+    pool.join();
+}
+
+TEST_CASE("test_parallel_recover_keys", "[types]") {
+    auto strx = signed_transaction();
+    strx.max_charge = 1000;
+    strx.actions.emplace_back(action(".test", ".test", ".test", bytes()));
+
+    auto hash     = fc::sha256::hash(std::string("test"));
+    auto chain_id = *(chain_id_type*)&hash;
+    auto keys     = std::vector<private_key_type>();
+    for(auto i = 0; i < 7; i++) {
+        keys.emplace_back(private_key_type::generate());
+        strx.sign(keys.back(), chain_id);
+    }
+
+    auto pool = boost::asio::thread_pool(2);
+    auto mtrx = std::make_shared<transaction_metadata>(strx);
+    transaction_metadata::start_recover_keys(mtrx, pool, chain_id, 4);
+    CHECK(mtrx->signing_keys_future.valid());
+
+    auto& rkeys = mtrx->recover_keys(chain_id);
+    CHECK(rkeys.size() == keys.size());
+    for(auto& k : keys) {
+        CHECK(rkeys.count(k.get_public_key()) == 1);
+    }
+
+    // duplicate signatures fail the same way as recovering them sequentially
+    strx.sign(keys[0], chain_id);
+    auto mtrx2 = std::make_shared<transaction_metadata>(strx);
+    transaction_metadata::start_recover_keys(mtrx2, pool, chain_id, 4);
+    CHECK_THROWS_AS(mtrx2->recover_keys(chain_id), tx_duplicate_sig);
+
+    pool.join();
+}
+
+TEST_CASE("test_action_data_cache", "[types]") {
+    auto tt = transfer { N128(dm), N128(t1), address_list(16), "memo" };
+
+    // unpacked once and shared by the copies
+    auto act = action(N(transfer), N128(dm), N128(t1), fc::raw::pack(tt));
+    auto& d1 = act.data_as<const transfer&>();
+    CHECK(d1.to.size() == 16);
+
+    auto copy = act;
+    CHECK(&copy.data_as<const transfer&>() == &d1);
+
+    auto act2 = action();
+    act2 = act;
+    CHECK(&act2.data_as<const transfer&>() == &d1);
+
+    // new data gets its own cache
+    tt.memo = "memo2";
+    act2.set_data(tt);
+    CHECK(act2.data_as<const transfer&>().memo == "memo2");
+    CHECK(act.data_as<const transfer&>().memo == "memo");
+
+    auto act3 = action(N(transfer), N128(dm), N128(t1), fc::raw::pack(tt));
+    CHECK_THROWS_AS(act3.data_as<const transferft&>(), action_type_exception);
+    CHECK_THROWS_AS(act.data_as<const transferft&>(), std::bad_any_cast);
+}
+
+TEST_CASE("test_action_access", "[types]") {
+    auto from = address(private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("from"))).get_public_key());
+    auto to   = address(private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("to"))).get_public_key());
+    auto sym  = symbol(5, 3);
+
+    auto reads  = std::vector<std::string>();
+    auto writes = std::vector<std::string>();
+    auto access = [&](const action& act) {
+        reads.clear();
+        writes.clear();
+        auto builder = access_builder(reads, writes);
+        evt_execution_context::invoke_first_version<action_access, void>(act.name, act, builder);
+    };
+
+    auto tf = transferft { from, to, asset(100, sym), "" };
+    access(action(N128(.fungible), name128::from_number(3), tf));
+    CHECK(writes == std::vector<std::string> { access_builder::make_key(access_builder::kAsset, from, sym.id()),
+                                               access_builder::make_key(access_builder::kAsset, to, sym.id()) });
+    CHECK(std::find(reads.cbegin(), reads.cend(), access_builder::make_key(access_builder::kToken, N128(.fungible), name128::from_number(3))) != reads.cend());
+
+    // actions without declaration update the token they declare
+    access(action(N128(cookie), N128(t1), transfer()));
+    CHECK(writes == std::vector<std::string> { access_builder::make_key(access_builder::kToken, N128(cookie), N128(t1)) });
+    CHECK(reads == std::vector<std::string> { access_builder::make_key(access_builder::kDomain, N128(cookie)) });
+
+    auto unknown = action(N(unknown), N128(cookie), N128(t1), bytes());
+    CHECK_THROWS_AS(access(unknown), unknown_action_exception);
+}
+
+TEST_CASE("test_block_bus", "[types]") {
+    auto bus = block_bus(2);
+
+    auto nums = std::vector<uint32_t>();
+    auto tid  = std::thread::id();
+    bus.subscribe([&](const auto& batch) {
+        nums.emplace_back(batch->block->block_num);
+        tid = std::this_thread::get_id();
+    });
+
+    for(auto i = 1u; i <= 10; i++) {
+        auto bs       = std::make_shared<block_state>();
+        bs->block_num = i;
+        bus.publish(std::make_shared<block_batch>(block_batch { bs, {} }));
+        CHECK(bus.size() <= 2);
+    }
+    bus.flush();
+
+    CHECK(nums == std::vector<uint32_t> { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 });
+    CHECK(tid != std::this_thread::get_id());
+
+    bus.stop();
+}
+
+TEST_CASE("test_variant_arena", "[types]") {
+    auto var = fc::variant();
+    auto arr = fc::variants();
+    {
+        auto arena = fc::variant_arena::scope();
+
+        auto obj = fc::mutable_variant_object()
+            ("name", "evt")
+            ("list", fc::variants{ "a", "b", fc::variant(fc::variants{ "c" }) });
+        var = fc::variant(obj);
+        arr = var["list"].get_array();
+    }
+
+    // variants from the arena are still valid after the scope ends
+    CHECK(var["name"].as_string() == "evt");
+    REQUIRE(arr.size() == 3);
+    CHECK(arr[2].get_array()[0].as_string() == "c");
+
+    // nodes may be released by other threads
+    auto t = std::thread([arr = std::move(arr)] {
+        CHECK(arr[0].as_string() == "a");
+    });
+    t.join();
+
+    auto copy = var;
+    var.clear();
+    CHECK(copy["list"].get_array()[1].as_string() == "b");
+}
+
+TEST_CASE("test_merkle", "[types]") {
+    // reference implementation, hashes the canonical pairs one by one
+    auto naive = [](auto ids) {
+        while(ids.size() > 1) {
+            if(ids.size() % 2) {
+                ids.push_back(ids.back());
+            }
+            for(auto i = 0u; i < ids.size() / 2; i++) {
+                ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[2 * i + 1]));
+            }
+            ids.resize(ids.size() / 2);
+        }
+        return ids.empty() ? digest_type() : ids.front();
+    };
+
+    auto pool = boost::asio::thread_pool(2);
+    for(auto n : { 0, 1, 2, 3, 7, 8, 9, 65, 4097, 10001 }) {
+        auto ids = std::vector<digest_type>();
+        for(auto i = 0; i < n; i++) {
+            ids.emplace_back(digest_type::hash(i));
+        }
+
+        auto root = naive(ids);
+        CHECK(merkle(ids) == root);
+        CHECK(merkle(ids, &pool) == root);
+    }
+    pool.join();
+}
+
+TEST_CASE("test_packed_sig_digest", "[types]") {
+    auto strx = signed_transaction();
+    strx.max_charge = 1000;
+    strx.actions.emplace_back(action(".test", ".test", ".test", bytes(100, 'a')));
+
+    auto hash     = fc::sha256::hash(std::string("test"));
+    auto chain_id = *(chain_id_type*)&hash;
+    auto key      = private_key_type::generate();
+    strx.sign(key, chain_id);
+
+    auto ptrx  = packed_transaction(strx);
+    auto zptrx = packed_transaction(strx, packed_transaction::zlib);
+    CHECK(ptrx.sig_digest(chain_id) == strx.sig_digest(chain_id));
+    CHECK(zptrx.sig_digest(chain_id) == strx.sig_digest(chain_id));
+
+    auto keys = ptrx.get_signature_keys(chain_id);
+    CHECK(keys.size() == 1);
+    CHECK(keys.count(key.get_public_key()) == 1);
+}
+
+TEST_CASE("test_zstd_dictionary", "[types]") {
+    auto tf   = contracts::transferft();
+    tf.from   = address(private_key_type::generate().get_public_key());
+    tf.to     = address(private_key_type::generate().get_public_key());
+    tf.number = asset(100'000, symbol(5, 1));
+
+    auto strx = signed_transaction();
+    strx.max_charge = 10'000;
+    strx.payer      = tf.from;
+    strx.actions.emplace_back(action(N128(.fungible), name128::from_number(1), tf));
+
+    auto data  = fc::raw::pack((const transaction&)strx);
+    auto cdata = zstd_dict_compress(data.data(), data.size());
+    CHECK(cdata.size() < data.size());
+
+    auto sz = zstd_frame_content_size(cdata.data(), cdata.size());
+    REQUIRE(sz.has_value());
+    CHECK(*sz == data.size());
+
+    auto out = bytes(*sz);
+    CHECK(zstd_dict_decompress(cdata.data(), cdata.size(), out.data(), out.size()) == nullptr);
+    CHECK(out == data);
+
+    // truncated ones are rejected
+    CHECK(zstd_dict_decompress(cdata.data(), cdata.size() - 1, out.data(), out.size()) != nullptr);
+
+    // zstd is only for net batches and block log segments, packed transaction doesn't accept it
+    auto ptrx  = packed_transaction(strx);
+    auto pdata = fc::raw::pack(ptrx);
+    pdata[fc::raw::pack_size(ptrx.signatures)] = 2;
+    CHECK_THROWS_AS(fc::raw::unpack<packed_transaction>(pdata), unknown_transaction_compression);
+}